@@ -0,0 +1,261 @@
+/*!@file
+ * @copyright This code is licensed under the 3-clause BSD license.
+ *   Copyright ETH Zurich, Laboratory of Physical Chemistry, Reiher Group.
+ *   See LICENSE.txt for details.
+ */
+
+#define BOOST_FILESYSTEM_NO_DEPRECATED
+
+#include "boost/filesystem.hpp"
+#include "boost/program_options.hpp"
+
+#include "Molassembler/AtomStereopermutator.h"
+#include "Molassembler/Conformers.h"
+#include "Molassembler/Graph.h"
+#include "Molassembler/IO.h"
+#include "Molassembler/IO/SmilesParser.h"
+#include "Molassembler/Molecule.h"
+#include "Molassembler/Parallel.h"
+#include "Molassembler/StereopermutatorList.h"
+
+#include <sys/resource.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+
+using namespace Scine::Molassembler;
+
+std::ostream& nl(std::ostream& os) {
+  os << '\n';
+  return os;
+}
+
+struct Sample {
+  std::string name;
+  std::string mode;
+  Molecule molecule;
+};
+
+//! Resets the resident set size high-water mark if the kernel allows it
+bool resetHighWaterMark() {
+  std::ofstream clearRefs("/proc/self/clear_refs");
+  if(!clearRefs) {
+    return false;
+  }
+  clearRefs << "5";
+  return static_cast<bool>(clearRefs.flush());
+}
+
+//! Resident set size high-water mark in MiB
+double highWaterMark() {
+  std::ifstream status("/proc/self/status");
+  std::string line;
+  while(std::getline(status, line)) {
+    if(line.compare(0, 6, "VmHWM:") == 0) {
+      return std::stod(line.substr(6)) / 1024;
+    }
+  }
+
+  // Without procfs, fall back to the peak over the process lifetime
+  rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  return static_cast<double>(usage.ru_maxrss) / 1024;
+}
+
+//! Limits the library's parallel loops to a number of threads
+void setThreads(const unsigned threads, const bool pool) {
+  if(pool) {
+    Parallel::setExecutor(Parallel::threads(threads));
+    return;
+  }
+
+  Parallel::setExecutor(Parallel::openMP());
+#ifdef _OPENMP
+  // Equivalent to setting OMP_NUM_THREADS
+  omp_set_num_threads(threads);
+#endif
+}
+
+/* The same molecule with its spatial model kept across conformers and, if it
+ * has atom stereopermutators with multiple stereopermutations, with one of
+ * them unassigned so that the model is regenerated for each conformer
+ */
+std::vector<Sample> modes(const std::string& name, const Molecule& molecule) {
+  std::vector<Sample> samples {{name, "keep", molecule}};
+
+  for(const AtomStereopermutator& permutator : molecule.stereopermutators().atomStereopermutators()) {
+    if(permutator.numAssignments() > 1) {
+      Molecule unassigned = molecule;
+      unassigned.assignStereopermutator(permutator.placement(), boost::none);
+      samples.push_back({name, "regenerate", std::move(unassigned)});
+      break;
+    }
+  }
+
+  return samples;
+}
+
+//! Oligopeptide of phenylalanine residues, one stereocenter per residue
+std::string phenylalanineOligomer(const unsigned residues) {
+  std::string smiles;
+  for(unsigned i = 0; i < residues; ++i) {
+    smiles += "N[C@@H](Cc1ccccc1)C(=O)";
+  }
+  return smiles + "O";
+}
+
+constexpr const char* description =
+  "Measures conformer generation throughput in conformers per second with\n"
+  "increasing numbers of threads, for molecules of several sizes whose\n"
+  "spatial model is either kept across conformers or regenerated for each\n"
+  "conformer. Speedup and parallel efficiency are relative to the smallest\n"
+  "thread count. Also reports the resident set size high-water mark of each\n"
+  "run in MiB.\n";
+
+int main(int argc, char* argv[]) {
+  // Set up option parsing
+  boost::program_options::options_description options_description("Recognized options");
+  options_description.add_options()
+    ("help", "Produce help message")
+    ("n", boost::program_options::value<unsigned>()->default_value(64), "Number of conformers per run")
+    ("t", boost::program_options::value<std::vector<unsigned>>()->multitoken(), "Thread counts, powers of two up to the hardware concurrency if unspecified")
+    ("s", boost::program_options::value<unsigned>()->default_value(1010), "Seed")
+    ("m", boost::program_options::value<std::string>(), "Path to molecule files to benchmark instead of the built-in size classes")
+    ("pool", "Use the library's thread pool executor instead of OpenMP")
+    ("o", boost::program_options::value<std::string>(), "CSV file to write results to")
+  ;
+
+  // Parse
+  boost::program_options::variables_map options_variables_map;
+  boost::program_options::store(
+    boost::program_options::parse_command_line(argc, argv, options_description),
+    options_variables_map
+  );
+  boost::program_options::notify(options_variables_map);
+
+  if(options_variables_map.count("help") > 0) {
+    std::cout << description << nl << options_description << std::endl;
+    return 0;
+  }
+
+  const unsigned numConformers = std::max(1u, options_variables_map["n"].as<unsigned>());
+  const unsigned seed = options_variables_map["s"].as<unsigned>();
+  const bool pool = options_variables_map.count("pool") > 0;
+
+  std::vector<unsigned> threadCounts;
+  if(options_variables_map.count("t") > 0) {
+    threadCounts = options_variables_map["t"].as<std::vector<unsigned>>();
+    std::sort(std::begin(threadCounts), std::end(threadCounts));
+  } else {
+    const unsigned hardware = std::max(std::thread::hardware_concurrency(), 1U);
+    for(unsigned threads = 1; threads < hardware; threads *= 2) {
+      threadCounts.push_back(threads);
+    }
+    threadCounts.push_back(hardware);
+  }
+
+  std::vector<Sample> samples;
+  auto addModes = [&](const std::string& name, const Molecule& molecule) {
+    const auto moleculeModes = modes(name, molecule);
+    std::copy(std::begin(moleculeModes), std::end(moleculeModes), std::back_inserter(samples));
+  };
+  if(options_variables_map.count("m") > 0) {
+    for(
+      const boost::filesystem::path& filePath :
+      boost::filesystem::recursive_directory_iterator(options_variables_map["m"].as<std::string>())
+    ) {
+      if(boost::filesystem::is_regular_file(filePath)) {
+        addModes(filePath.stem().string(), IO::read(filePath.string()));
+      }
+    }
+  } else {
+    const std::vector<std::pair<std::string, std::string>> sizeClasses {
+      {"phe1", phenylalanineOligomer(1)},
+      {"cholesterol", "CC(C)CCC[C@@H](C)[C@H]1CC[C@@H]2[C@@]1(CC[C@H]3[C@H]2CC=C4[C@@]3(CC[C@@H](C4)O)C)C"},
+      {"phe4", phenylalanineOligomer(4)},
+      {"phe8", phenylalanineOligomer(8)}
+    };
+    for(const auto& sizeClass : sizeClasses) {
+      addModes(sizeClass.first, IO::Experimental::parseSmilesSingleMolecule(sizeClass.second));
+    }
+  }
+
+  std::ofstream csvFile;
+  if(options_variables_map.count("o") > 0) {
+    csvFile.open(options_variables_map["o"].as<std::string>());
+    csvFile << "\"Molecule\", \"N\", \"Mode\", \"Threads\", \"Conformers/s\", \"Speedup\", \"Efficiency\", \"Failures\", \"HWM MiB\"" << nl;
+  }
+
+  if(!resetHighWaterMark()) {
+    std::cout << "Cannot reset the memory high-water mark, reporting the process lifetime peak instead" << nl;
+  }
+
+  std::cout << std::setw(14) << "Molecule"
+    << std::setw(6) << "N"
+    << std::setw(12) << "Mode"
+    << std::setw(9) << "Threads"
+    << std::setw(14) << "Conformers/s"
+    << std::setw(10) << "Speedup"
+    << std::setw(12) << "Efficiency"
+    << std::setw(10) << "Failures"
+    << std::setw(10) << "HWM MiB"
+    << nl;
+
+  for(const Sample& sample : samples) {
+    const unsigned N = sample.molecule.graph().N();
+
+    // Warm up caches shared between conformers and runs
+    generateEnsemble(sample.molecule, 1, seed);
+
+    double baseline = 0;
+    for(const unsigned threads : threadCounts) {
+      setThreads(threads, pool);
+      resetHighWaterMark();
+
+      const auto start = std::chrono::steady_clock::now();
+      const auto ensemble = generateEnsemble(sample.molecule, numConformers, seed);
+      const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+      const double memory = highWaterMark();
+      const auto failures = std::count_if(
+        std::begin(ensemble),
+        std::end(ensemble),
+        [](const auto& result) { return !result; }
+      );
+
+      const double throughput = numConformers / seconds;
+      if(baseline == 0) {
+        baseline = throughput / threads;
+      }
+      const double speedup = throughput / (baseline * threadCounts.front());
+      const double efficiency = throughput / (baseline * threads);
+
+      std::cout << std::setw(14) << sample.name
+        << std::setw(6) << N
+        << std::setw(12) << sample.mode
+        << std::setw(9) << threads
+        << std::setw(14) << std::fixed << std::setprecision(2) << throughput
+        << std::setw(10) << speedup
+        << std::setw(12) << efficiency
+        << std::setw(10) << failures
+        << std::setw(10) << std::setprecision(1) << memory
+        << std::defaultfloat << nl;
+
+      if(csvFile.is_open()) {
+        csvFile << "\"" << sample.name << "\", " << N << ", \"" << sample.mode << "\", "
+          << threads << ", " << throughput << ", " << speedup << ", "
+          << efficiency << ", " << failures << ", " << memory << nl;
+      }
+    }
+  }
+
+  return 0;
+}
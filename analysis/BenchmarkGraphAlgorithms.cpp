@@ -6,15 +6,18 @@
 
 #define BOOST_FILESYSTEM_NO_DEPRECATED
 
+// DO NOT CHANGE THIS INCLUDE ORDER (implicit graph needs to go first)
+#include "Molassembler/DistanceGeometry/ImplicitBoundsGraphBoost.h"
+
 #include "boost/filesystem.hpp"
 #include "boost/graph/bellman_ford_shortest_paths.hpp"
+#include "boost/graph/two_bit_color_map.hpp"
 #include "boost/program_options.hpp"
 
 #include "Molassembler/Graph/Gor1.h"
 #include "Molassembler/DistanceGeometry/DistanceBoundsMatrix.h"
 #include "Molassembler/DistanceGeometry/ExplicitBoundsGraph.h"
 #include "Molassembler/DistanceGeometry/Gor1.h"
-#include "Molassembler/DistanceGeometry/ImplicitBoundsGraphBoost.h"
 #include "Molassembler/DistanceGeometry/SpatialModel.h"
 #include "Molassembler/Graph/PrivateGraph.h"
 #include "Molassembler/IO.h"
@@ -83,6 +86,66 @@ struct Gor1Functor {
   }
 };
 
+/* Shortest paths from each left vertex of an unmodified ImplicitBoundsGraph,
+ * timing the shortest paths kernels without distance fixing
+ */
+template<bool relaxRows>
+struct ImplicitPathsFunctor {
+  Eigen::MatrixXd operator() (
+    const Molecule& molecule,
+    DistanceGeometry::SpatialModel::BoundsMatrix boundsMatrix,
+    DistanceGeometry::Partiality /* partiality */
+  ) {
+    using Graph = DistanceGeometry::ImplicitBoundsGraph;
+    using Vertex = Graph::VertexDescriptor;
+
+    const Graph graph {molecule.graph().inner(), std::move(boundsMatrix)};
+    const unsigned N = molecule.graph().N();
+    const unsigned M = 2 * N;
+    std::vector<double> distances(M);
+    std::vector<Vertex> predecessors(M);
+
+    Eigen::MatrixXd upperBounds(N, N);
+    for(unsigned a = 0; a < N; ++a) {
+      boost::two_bit_color_map<> color_map {M};
+
+      if(relaxRows) {
+        boost::gor1_ig_row_shortest_paths(
+          graph,
+          Vertex {Graph::left(a)},
+          predecessors,
+          color_map,
+          distances
+        );
+      } else {
+        auto predecessor_map = boost::make_iterator_property_map(
+          predecessors.begin(),
+          Graph::VertexIndexMap()
+        );
+
+        auto distance_map = boost::make_iterator_property_map(
+          distances.begin(),
+          Graph::VertexIndexMap()
+        );
+
+        boost::gor1_simplified_shortest_paths(
+          graph,
+          Vertex {Graph::left(a)},
+          predecessor_map,
+          color_map,
+          distance_map
+        );
+      }
+
+      for(unsigned b = 0; b < N; ++b) {
+        upperBounds(a, b) = distances.at(Graph::left(b));
+      }
+    }
+
+    return upperBounds;
+  }
+};
+
 struct DBM_FW_Functor {
   Eigen::MatrixXd operator() (
     const Molecule& molecule,
@@ -111,7 +174,9 @@ void writeHeaders(
     "E",
     "Floyd-Warshall & DBM",
     "Gor & ExplicitBoundsGraph",
-    "Gor & ImplicitBoundsGraph"
+    "Gor & ImplicitBoundsGraph",
+    "Gor paths & ImplicitBoundsGraph",
+    "Gor row paths & ImplicitBoundsGraph"
   };
 
   for(unsigned i = 0; i < 2; ++i) {
@@ -130,11 +195,13 @@ void writeHeaders(
 }
 
 
+// Ordered as in algorithmChoices
 enum class Algorithm {
-  All,
+  MatrixFW,
   ImplicitGor,
   ExplicitGor,
-  MatrixFW
+  ImplicitPaths,
+  All
 };
 
 void benchmark(
@@ -216,6 +283,26 @@ void benchmark(
     deviations.push_back(timings.second);
   }
 
+  if(algorithmChoice == Algorithm::All || algorithmChoice == Algorithm::ImplicitPaths) {
+    auto timings = timeFunctor<
+      ImplicitPathsFunctor<false>,
+      nExperiments
+    >(sampleMol, boundsMatrix, partiality);
+
+    names.emplace_back("Paths");
+    times.push_back(timings.first);
+    deviations.push_back(timings.second);
+
+    timings = timeFunctor<
+      ImplicitPathsFunctor<true>,
+      nExperiments
+    >(sampleMol, boundsMatrix, partiality);
+
+    names.emplace_back("Row paths");
+    times.push_back(timings.first);
+    deviations.push_back(timings.second);
+  }
+
   auto smallest = *std::min_element(times.begin(), times.end());
 
   benchmarkFile
@@ -246,7 +333,8 @@ using namespace std::string_literals;
 const std::string algorithmChoices =
   "  0 - Matrix Floyd-Warshall\n"
   "  1 - Gor1 with ImplicitBoundsGraph\n"
-  "  2 - Gor1 with ExplicitBoundsGraph\n";
+  "  2 - Gor1 with ExplicitBoundsGraph\n"
+  "  3 - Gor1 shortest paths kernels only with ImplicitBoundsGraph\n";
 
 const std::string partialityChoices =
   "  0 - Four-Atom Metrization\n"
@@ -290,7 +378,7 @@ int main(int argc, char* argv[]) {
   if(options_variables_map.count("c") > 0) {
     unsigned combination = options_variables_map["c"].as<unsigned>();
 
-    if(combination > 2) {
+    if(combination > 3) {
       std::cout << "Specified algorithm / graph combination is out of bounds. Valid choices are:" << nl
         << algorithmChoices;
       return 0;
@@ -0,0 +1,338 @@
+/*!@file
+ * @copyright This code is licensed under the 3-clause BSD license.
+ *   Copyright ETH Zurich, Laboratory of Physical Chemistry, Reiher Group.
+ *   See LICENSE.txt for details.
+ */
+
+#define BOOST_FILESYSTEM_NO_DEPRECATED
+
+#include "boost/filesystem.hpp"
+#include "boost/program_options.hpp"
+
+#include "Molassembler/Graph.h"
+#include "Molassembler/Graph/GraphAlgorithms.h"
+#include "Molassembler/Graph/PrivateGraph.h"
+#include "Molassembler/IO.h"
+#include "Molassembler/IO/SmilesParser.h"
+#include "Molassembler/Molecule.h"
+#include "Molassembler/Temple/Functional.h"
+#include "Molassembler/Temple/constexpr/Numeric.h"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <random>
+
+using namespace Scine::Molassembler;
+
+std::ostream& nl(std::ostream& os) {
+  os << '\n';
+  return os;
+}
+
+struct Sample {
+  std::string name;
+  PrivateGraph graph;
+};
+
+struct Timing {
+  double average;
+  double sigma;
+};
+
+//! Times a function over repeats, each repeat yielding nanoseconds per operation
+template<typename F>
+Timing timeRepeats(const unsigned repeats, F&& f) {
+  std::vector<double> timings;
+  timings.reserve(repeats);
+  for(unsigned r = 0; r < repeats; ++r) {
+    timings.push_back(f());
+  }
+  const double average = Temple::average(timings);
+  return {average, Temple::stddev(timings, average)};
+}
+
+double nanosecondsSince(const std::chrono::steady_clock::time_point start) {
+  using namespace std::chrono;
+  return duration_cast<nanoseconds>(steady_clock::now() - start).count();
+}
+
+//! Connected, non-bonded vertex pairs whose bonding would close a cycle
+std::vector<std::pair<PrivateGraph::Vertex, PrivateGraph::Vertex>> cycleClosingPairs(
+  const PrivateGraph& graph,
+  const unsigned count,
+  std::mt19937& engine
+) {
+  const PrivateGraph::Vertex N = graph.N();
+  std::uniform_int_distribution<PrivateGraph::Vertex> vertexDistribution(0, N - 1);
+  std::vector<std::pair<PrivateGraph::Vertex, PrivateGraph::Vertex>> pairs;
+  for(unsigned attempt = 0; attempt < 100 * count && pairs.size() < count; ++attempt) {
+    const PrivateGraph::Vertex i = vertexDistribution(engine);
+    const PrivateGraph::Vertex j = vertexDistribution(engine);
+    if(i != j && !graph.edgeOption(i, j)) {
+      pairs.emplace_back(i, j);
+    }
+  }
+  return pairs;
+}
+
+//! Bonds to terminal vertices, i.e. bridges whose removal opens no cycle
+std::vector<std::pair<PrivateGraph::Vertex, PrivateGraph::Vertex>> terminalBonds(const PrivateGraph& graph) {
+  std::vector<std::pair<PrivateGraph::Vertex, PrivateGraph::Vertex>> bonds;
+  for(const PrivateGraph::Edge& edge : graph.edges()) {
+    const PrivateGraph::Vertex a = graph.source(edge);
+    const PrivateGraph::Vertex b = graph.target(edge);
+    if(graph.degree(a) == 1 || graph.degree(b) == 1) {
+      bonds.emplace_back(a, b);
+    }
+  }
+  return bonds;
+}
+
+void benchmark(
+  const Sample& sample,
+  const unsigned repeats,
+  std::mt19937& engine,
+  std::ofstream& csvFile
+) {
+  using namespace std::chrono;
+  const PrivateGraph& original = sample.graph;
+  const PrivateGraph::Vertex N = original.N();
+  const unsigned edits = std::max(1u, std::min<unsigned>(N, 32));
+
+  auto report = [&](const std::string& operation, const Timing& timing) {
+    std::cout << std::setw(16) << sample.name
+      << std::setw(6) << N
+      << std::setw(6) << original.B()
+      << std::setw(28) << operation
+      << std::setw(14) << std::fixed << std::setprecision(0) << timing.average
+      << std::setw(14) << timing.sigma
+      << nl;
+
+    if(csvFile.is_open()) {
+      csvFile << "\"" << sample.name << "\", " << N << ", " << original.B()
+        << ", \"" << operation << "\", "
+        << std::scientific << std::setprecision(6)
+        << timing.average << ", " << timing.sigma << std::defaultfloat << nl;
+    }
+  };
+
+  const auto pairs = cycleClosingPairs(original, edits, engine);
+  const auto bridges = terminalBonds(original);
+
+  // Mutation with full property invalidation: cycle-closing bonds
+  if(!pairs.empty()) {
+    report("addEdge/removeEdge (cycle)", timeRepeats(repeats, [&]() {
+      PrivateGraph graph = original;
+      graph.populateProperties();
+      const auto start = steady_clock::now();
+      for(const auto& pair : pairs) {
+        graph.removeEdge(graph.addEdge(pair.first, pair.second, BondType::Single));
+      }
+      return nanosecondsSince(start) / pairs.size();
+    }));
+
+    // Cycle regeneration after each invalidating edit
+    report("cycles() regeneration", timeRepeats(repeats, [&]() {
+      PrivateGraph graph = original;
+      double time = 0;
+      for(const auto& pair : pairs) {
+        graph.addEdge(pair.first, pair.second, BondType::Single);
+        auto start = steady_clock::now();
+        graph.cycles();
+        time += nanosecondsSince(start);
+        graph.removeEdge(graph.edge(pair.first, pair.second));
+      }
+      return time / pairs.size();
+    }));
+  }
+
+  // Mutation with light property invalidation: bridges to terminal vertices
+  if(!bridges.empty()) {
+    const unsigned bridgeEdits = std::min<unsigned>(bridges.size(), edits);
+    report("removeEdge/addEdge (bridge)", timeRepeats(repeats, [&]() {
+      PrivateGraph graph = original;
+      graph.populateProperties();
+      const auto start = steady_clock::now();
+      for(unsigned i = 0; i < bridgeEdits; ++i) {
+        const auto& bridge = bridges.at(i);
+        const PrivateGraph::Edge edge = graph.edge(bridge.first, bridge.second);
+        const BondType bondType = graph.bondType(edge);
+        graph.removeEdge(edge);
+        graph.addEdge(bridge.first, bridge.second, bondType);
+      }
+      return nanosecondsSince(start) / bridgeEdits;
+    }));
+  }
+
+  // Removal safety queries including generation of the removal safety data
+  report("canRemove (cold)", timeRepeats(repeats, [&]() {
+    PrivateGraph graph = original;
+    const auto start = steady_clock::now();
+    unsigned removable = 0;
+    for(const PrivateGraph::Vertex i : graph.vertices()) {
+      removable += static_cast<unsigned>(graph.canRemove(i));
+    }
+    for(const PrivateGraph::Edge& edge : graph.edges()) {
+      removable += static_cast<unsigned>(graph.canRemove(edge));
+    }
+    const double time = nanosecondsSince(start);
+    if(removable > N + graph.B()) {
+      std::cout << "Impossible removability count" << nl;
+    }
+    return time / (N + graph.B());
+  }));
+
+  report("canRemove (warm)", timeRepeats(repeats, [&]() {
+    PrivateGraph graph = original;
+    graph.populateProperties();
+    const auto start = steady_clock::now();
+    unsigned removable = 0;
+    for(const PrivateGraph::Vertex i : graph.vertices()) {
+      removable += static_cast<unsigned>(graph.canRemove(i));
+    }
+    for(const PrivateGraph::Edge& edge : graph.edges()) {
+      removable += static_cast<unsigned>(graph.canRemove(edge));
+    }
+    const double time = nanosecondsSince(start);
+    if(removable > N + graph.B()) {
+      std::cout << "Impossible removability count" << nl;
+    }
+    return time / (N + graph.B());
+  }));
+
+  // Isomorphism against a randomly permuted copy
+  std::vector<PrivateGraph::Vertex> permutation = Temple::iota<PrivateGraph::Vertex>(N);
+  std::shuffle(std::begin(permutation), std::end(permutation), engine);
+  PrivateGraph permuted = original;
+  permuted.applyPermutation(permutation);
+  report("modularIsomorphism", timeRepeats(repeats, [&]() {
+    const auto start = steady_clock::now();
+    const auto mapping = original.modularIsomorphism(
+      permuted,
+      AtomEnvironmentComponents::ElementTypes | AtomEnvironmentComponents::BondOrders
+    );
+    const double time = nanosecondsSince(start);
+    if(!mapping) {
+      std::cout << "Permuted graph of " << sample.name << " is not isomorphic" << nl;
+    }
+    return time;
+  }));
+
+  // Single-source distances by breadth-first search
+  report("distance (single source)", timeRepeats(repeats, [&]() {
+    const auto start = steady_clock::now();
+    unsigned sum = 0;
+    for(unsigned i = 0; i < edits; ++i) {
+      sum += GraphAlgorithms::distance(i % N, original).back();
+    }
+    const double time = nanosecondsSince(start);
+    if(sum == std::numeric_limits<unsigned>::max()) {
+      std::cout << "Unlikely distance sum" << nl;
+    }
+    return time / edits;
+  }));
+
+  // All-pairs distances matrix generation
+  report("distances() generation", timeRepeats(repeats, [&]() {
+    PrivateGraph graph = original;
+    const auto start = steady_clock::now();
+    graph.distances();
+    return nanosecondsSince(start);
+  }));
+}
+
+//! Oligopeptide of phenylalanine residues as a cyclic, flexible size class
+std::string phenylalanineOligomer(const unsigned residues) {
+  std::string smiles;
+  for(unsigned i = 0; i < residues; ++i) {
+    smiles += "NC(Cc1ccccc1)C(=O)";
+  }
+  return smiles + "O";
+}
+
+constexpr const char* description =
+  "Benchmarks PrivateGraph mutations and queries on molecules of several\n"
+  "size classes, reporting the average and standard deviation of the time\n"
+  "per operation in nanoseconds. Property generation is included in the\n"
+  "cold timings only.\n";
+
+int main(int argc, char* argv[]) {
+  // Set up option parsing
+  boost::program_options::options_description options_description("Recognized options");
+  options_description.add_options()
+    ("help", "Produce help message")
+    ("r", boost::program_options::value<unsigned>()->default_value(20), "Number of repeats per operation")
+    ("s", boost::program_options::value<unsigned>()->default_value(1010), "Seed")
+    ("m", boost::program_options::value<std::string>(), "Path to molecule files to benchmark instead of the built-in size classes")
+    ("o", boost::program_options::value<std::string>(), "CSV file to write results to")
+  ;
+
+  // Parse
+  boost::program_options::variables_map options_variables_map;
+  boost::program_options::store(
+    boost::program_options::parse_command_line(argc, argv, options_description),
+    options_variables_map
+  );
+  boost::program_options::notify(options_variables_map);
+
+  if(options_variables_map.count("help") > 0) {
+    std::cout << description << nl << options_description << std::endl;
+    return 0;
+  }
+
+  const unsigned repeats = std::max(1u, options_variables_map["r"].as<unsigned>());
+  std::mt19937 engine(options_variables_map["s"].as<unsigned>());
+
+  std::vector<Sample> samples;
+  if(options_variables_map.count("m") > 0) {
+    for(
+      const boost::filesystem::path& filePath :
+      boost::filesystem::recursive_directory_iterator(options_variables_map["m"].as<std::string>())
+    ) {
+      if(boost::filesystem::is_regular_file(filePath)) {
+        samples.push_back({
+          filePath.stem().string(),
+          IO::read(filePath.string()).graph().inner()
+        });
+      }
+    }
+  } else {
+    const std::vector<std::pair<std::string, std::string>> sizeClasses {
+      {"caffeine", "Cn1cnc2c1c(=O)n(C)c(=O)n2C"},
+      {"cholesterol", "CC(C)CCCC(C)C1CCC2C1(CCC3C2CC=C4C3(CCC(C4)O)C)C"},
+      {"phe8", phenylalanineOligomer(8)},
+      {"phe32", phenylalanineOligomer(32)},
+      {"phe128", phenylalanineOligomer(128)}
+    };
+    for(const auto& sizeClass : sizeClasses) {
+      samples.push_back({
+        sizeClass.first,
+        IO::Experimental::parseSmilesSingleMolecule(sizeClass.second).graph().inner()
+      });
+    }
+  }
+
+  std::ofstream csvFile;
+  if(options_variables_map.count("o") > 0) {
+    csvFile.open(options_variables_map["o"].as<std::string>());
+    csvFile << "\"Molecule\", \"N\", \"B\", \"Operation\", \"ns/op\", \"sigma\"" << nl;
+  }
+
+  std::cout << std::setw(16) << "Molecule"
+    << std::setw(6) << "N"
+    << std::setw(6) << "B"
+    << std::setw(28) << "Operation"
+    << std::setw(14) << "ns/op"
+    << std::setw(14) << "sigma"
+    << nl;
+
+  for(const Sample& sample : samples) {
+    benchmark(sample, repeats, engine, csvFile);
+  }
+
+  return 0;
+}
@@ -16,7 +16,10 @@
 #include "Molassembler/DistanceGeometry/ConformerGeneration.h"
 
 #include "Molassembler/Temple/Optimization/Lbfgs.h"
+#include "Molassembler/Temple/Optimization/TrustRegion.h"
 
+#include "Molassembler/Cycles.h"
+#include "Molassembler/Graph.h"
 #include "Molassembler/IO.h"
 #include "Molassembler/Temple/Functional.h"
 #include "Molassembler/Temple/constexpr/Numeric.h"
@@ -25,6 +28,7 @@
 
 #include <chrono>
 #include <iomanip>
+#include <map>
 
 using namespace Scine;
 using namespace Molassembler;
@@ -183,9 +187,11 @@ struct OptimizerParameters {
   double c1 = 1e-4;
   double c2 = 0.9;
   double stepLength = 1.0;
+  bool precondition = false;
+  bool trustRegion = false;
 };
 
-template<unsigned dimensionality, typename FloatType, bool SIMD>
+template<unsigned dimensionality, typename FloatType, bool SIMD, int maxAtoms = Eigen::Dynamic>
 boost::optional<unsigned> eigenRefine(
   const Eigen::MatrixXd& squaredBounds,
   const std::vector<DistanceGeometry::ChiralConstraint>& chiralConstraints,
@@ -195,7 +201,7 @@ boost::optional<unsigned> eigenRefine(
 ) {
   unsigned iterationCount = 0;
 
-  using FullRefinementType = DistanceGeometry::EigenRefinementProblem<dimensionality, FloatType, SIMD>;
+  using FullRefinementType = DistanceGeometry::EigenRefinementProblem<dimensionality, FloatType, SIMD, maxAtoms>;
 
   const unsigned N = positions.size() / dimensionality;
   /* Transfer positions into vector form */
@@ -225,6 +231,28 @@ boost::optional<unsigned> eigenRefine(
   optimizer.c1 = optimizerParameters.c1;
   optimizer.c2 = optimizerParameters.c2;
   optimizer.stepLength = optimizerParameters.stepLength;
+  if(optimizerParameters.precondition) {
+    optimizer.preconditioner = DistanceGeometry::Detail::refinementPreconditioner(
+      squaredBounds
+    ).template cast<FloatType>();
+  }
+
+  // Trust region steps evaluate the objective function once per iteration
+  const auto minimize = [&](auto& checker) -> unsigned {
+    if(optimizerParameters.trustRegion) {
+      return Temple::TrustRegionOptimizer<FloatType>::minimize(
+        transformedPositions,
+        refinementFunctor,
+        checker
+      ).iterations;
+    }
+
+    return optimizer.minimize(
+      transformedPositions,
+      refinementFunctor,
+      checker
+    ).iterations;
+  };
 
   /* First stage: Invert all chiral constraints */
   if(initiallyCorrectChiralConstraints < 1) {
@@ -232,12 +260,7 @@ boost::optional<unsigned> eigenRefine(
 
     unsigned iterations;
     try {
-      auto result = optimizer.minimize(
-        transformedPositions,
-        refinementFunctor,
-        inversionChecker
-      );
-      iterations = result.iterations;
+      iterations = minimize(inversionChecker);
     } catch (...) {
       return boost::none;
     }
@@ -260,12 +283,7 @@ boost::optional<unsigned> eigenRefine(
 
   unsigned iterations;
   try {
-    auto result = optimizer.minimize(
-      transformedPositions,
-      refinementFunctor,
-      gradientChecker
-    );
-    iterations = result.iterations;
+    iterations = minimize(gradientChecker);
   } catch (...) {
     return boost::none;
   }
@@ -284,19 +302,44 @@ boost::optional<unsigned> eigenRefine(
 }
 
 
-template<unsigned dimensionality, typename FloatType, bool SIMD>
-struct EigenFunctor final : public TimingFunctor {
+template<
+  unsigned dimensionality,
+  typename FloatType,
+  bool SIMD,
+  bool precondition = false,
+  bool trustRegion = false,
+  bool bucketed = false
+> struct EigenFunctor final : public TimingFunctor {
   boost::optional<unsigned> value(
     const Eigen::MatrixXd& squaredBounds,
     const std::vector<DistanceGeometry::ChiralConstraint>& chiralConstraints,
     const std::vector<DistanceGeometry::DihedralConstraint>& dihedralConstraints,
     const Eigen::MatrixXd& positions
   ) final {
+    OptimizerParameters optimizerParameters;
+    optimizerParameters.precondition = precondition;
+    optimizerParameters.trustRegion = trustRegion;
+    if(bucketed) {
+      return DistanceGeometry::dispatchAtomCount(
+        squaredBounds.cols(),
+        [&](auto maxAtoms) {
+          return eigenRefine<dimensionality, FloatType, SIMD, decltype(maxAtoms)::value>(
+            squaredBounds,
+            chiralConstraints,
+            dihedralConstraints,
+            positions,
+            optimizerParameters
+          );
+        }
+      );
+    }
+
     return eigenRefine<dimensionality, FloatType, SIMD>(
       squaredBounds,
       chiralConstraints,
       dihedralConstraints,
-      positions
+      positions,
+      optimizerParameters
     );
   }
 
@@ -315,6 +358,18 @@ struct EigenFunctor final : public TimingFunctor {
       composite += "0>";
     }
 
+    if(precondition) {
+      composite += " P";
+    }
+
+    if(trustRegion) {
+      composite += " TR";
+    }
+
+    if(bucketed) {
+      composite += " B";
+    }
+
     return composite;
   }
 };
@@ -351,13 +406,45 @@ enum class Algorithm {
   EigenDouble,
   EigenFloat,
   EigenSIMDDouble,
-  EigenSIMDFloat
+  EigenSIMDFloat,
+  EigenDoublePreconditioned,
+  EigenDoubleTrustRegion,
+  EigenDoubleBucketed,
+  EigenSIMDDoubleBucketed
+};
+
+/* Molecule classes by their largest relevant cycle, since refinement of
+ * floppy macrocycles is particularly slow
+ */
+std::string moleculeClass(const Molecule& molecule) {
+  unsigned largestCycle = 0;
+  for(const auto& cycleEdges : molecule.graph().cycles()) {
+    largestCycle = std::max(largestCycle, static_cast<unsigned>(cycleEdges.size()));
+  }
+
+  if(largestCycle == 0) {
+    return "acyclic";
+  }
+
+  if(largestCycle < 12) {
+    return "cyclic";
+  }
+
+  return "macrocyclic";
+}
+
+//! Average iterations of each functor, summed over the molecules of a class
+struct ClassIterations {
+  std::vector<std::string> names;
+  std::vector<double> iterations;
+  unsigned molecules = 0;
 };
 
 void benchmark(
   const boost::filesystem::path& filePath,
   std::ofstream& benchmarkFile,
-  const Algorithm algorithmChoice
+  const Algorithm algorithmChoice,
+  std::map<std::string, ClassIterations>& classIterations
 ) {
   using namespace Molassembler;
 
@@ -382,6 +469,7 @@ void benchmark(
 
   std::cout
     << std::setw(6) << nCount
+    << " " << moleculeClass(molecule) << nl
     << std::setw(10) << "Name"
     << std::setw(10) << "Rel. v"
     << std::setw(14) << "Successes"
@@ -425,8 +513,50 @@ void benchmark(
     );
   }
 
+  if(algorithmChoice == Algorithm::All || algorithmChoice == Algorithm::EigenDoublePreconditioned) {
+    functors.emplace_back(
+      std::make_unique<
+        EigenFunctor<4, double, false, true>
+      >()
+    );
+  }
+
+  if(algorithmChoice == Algorithm::All || algorithmChoice == Algorithm::EigenDoubleTrustRegion) {
+    functors.emplace_back(
+      std::make_unique<
+        EigenFunctor<4, double, false, false, true>
+      >()
+    );
+  }
+
+  if(algorithmChoice == Algorithm::All || algorithmChoice == Algorithm::EigenDoubleBucketed) {
+    functors.emplace_back(
+      std::make_unique<
+        EigenFunctor<4, double, false, false, false, true>
+      >()
+    );
+  }
+
+  if(algorithmChoice == Algorithm::All || algorithmChoice == Algorithm::EigenSIMDDoubleBucketed) {
+    functors.emplace_back(
+      std::make_unique<
+        EigenFunctor<4, double, true, false, false, true>
+      >()
+    );
+  }
+
   auto results = timeFunctors<nExperiments>(molecule, functors);
 
+  ClassIterations& summary = classIterations[moleculeClass(molecule)];
+  if(summary.molecules == 0) {
+    summary.names = Temple::map(functors, [](const auto& functorPtr) { return functorPtr->name(); });
+    summary.iterations.assign(functors.size(), 0.0);
+  }
+  for(unsigned i = 0; i < functors.size(); ++i) {
+    summary.iterations.at(i) += results.at(i).iterationsAverage;
+  }
+  ++summary.molecules;
+
   double smallestAverage = std::min_element(
     results.begin(),
     results.end(),
@@ -475,7 +605,11 @@ const std::string algorithmChoices =
   "  1 - Eigen<dimensionality=4, double, SIMD=false>\n"
   "  2 - Eigen<dimensionality=4, float, SIMD=false>\n"
   "  3 - Eigen<dimensionality=4, double, SIMD=true>\n"
-  "  4 - Eigen<dimensionality=4, float, SIMD=true>\n";
+  "  4 - Eigen<dimensionality=4, float, SIMD=true>\n"
+  "  5 - Eigen<dimensionality=4, double, SIMD=false>, preconditioned\n"
+  "  6 - Eigen<dimensionality=4, double, SIMD=false>, trust region\n"
+  "  7 - Eigen<dimensionality=4, double, SIMD=false>, atom count buckets\n"
+  "  8 - Eigen<dimensionality=4, double, SIMD=true>, atom count buckets\n";
 
 constexpr const char* description =
   "Benchmarks various refinement error functions and optimizer combinations\n"
@@ -523,7 +657,7 @@ int main(int argc, char* argv[]) {
   if(options_variables_map.count("c") > 0) {
     unsigned combination = options_variables_map["c"].as<unsigned>();
 
-    if(combination > 4) {
+    if(combination > 8) {
       std::cout << "Specified algorithm is out of bounds. Valid choices are:" << nl
         << algorithmChoices;
       return 0;
@@ -536,11 +670,24 @@ int main(int argc, char* argv[]) {
   std::ofstream benchmarkFile ("refinement_timings.csv");
   writeHeaders(benchmarkFile);
 
+  std::map<std::string, ClassIterations> classIterations;
   for(
     const boost::filesystem::path& currentFilePath :
     boost::filesystem::recursive_directory_iterator(molPath)
   ) {
-    benchmark(currentFilePath, benchmarkFile, choice);
+    benchmark(currentFilePath, benchmarkFile, choice, classIterations);
+  }
+
+  // Summarize iteration counts per molecule class
+  std::cout << "Average iterations per molecule class" << nl;
+  for(const auto& classSummaryPair : classIterations) {
+    const ClassIterations& summary = classSummaryPair.second;
+    std::cout << classSummaryPair.first << " (" << summary.molecules << " molecules)" << nl;
+    for(unsigned i = 0; i < summary.names.size(); ++i) {
+      std::cout << std::setw(24) << summary.names.at(i)
+        << std::setw(12) << std::fixed << std::setprecision(0)
+        << summary.iterations.at(i) / summary.molecules << nl;
+    }
   }
 
   return 0;
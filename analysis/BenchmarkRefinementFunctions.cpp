@@ -143,7 +143,7 @@ std::vector<FunctorResults> timeFunctors(
 }
 
 template<
-  template<unsigned, typename, bool> class EigenRefinementType,
+  template<unsigned, typename, bool, int> class EigenRefinementType,
   unsigned dimensionality,
   typename FloatType,
   bool SIMD
@@ -156,7 +156,7 @@ double timeFunctionEvaluation(
   std::chrono::time_point<std::chrono::steady_clock>& start,
   std::chrono::time_point<std::chrono::steady_clock>& end
 ) {
-  using NtpRefinementType = EigenRefinementType<dimensionality, FloatType, SIMD>;
+  using NtpRefinementType = EigenRefinementType<dimensionality, FloatType, SIMD, Eigen::Dynamic>;
   using PositionsType = typename NtpRefinementType::VectorType;
 
   Eigen::MatrixXd positionCopy = positions;
@@ -0,0 +1,294 @@
+/*!@file
+ * @copyright This code is licensed under the 3-clause BSD license.
+ *   Copyright ETH Zurich, Laboratory of Physical Chemistry, Reiher Group.
+ *   See LICENSE.txt for details.
+ */
+
+#include "boost/program_options.hpp"
+
+#include "Molassembler/Shapes/ContinuousMeasures.h"
+#include "Molassembler/Shapes/Data.h"
+
+#include "Eigen/Geometry"
+
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <random>
+
+/* Heap accounting: Every allocation is prefixed with its size so that
+ * deallocations can be subtracted from the tally
+ */
+namespace {
+
+std::size_t allocationCount = 0;
+std::size_t allocatedBytes = 0;
+std::size_t grossAllocatedBytes = 0;
+constexpr std::size_t headerSize = alignof(std::max_align_t);
+
+} // namespace
+
+void* operator new(std::size_t size) {
+  auto* raw = static_cast<char*>(std::malloc(size + headerSize));
+  if(raw == nullptr) {
+    throw std::bad_alloc {};
+  }
+  *reinterpret_cast<std::size_t*>(raw) = size;
+  ++allocationCount;
+  allocatedBytes += size;
+  grossAllocatedBytes += size;
+  return raw + headerSize;
+}
+
+void operator delete(void* ptr) noexcept {
+  if(ptr == nullptr) {
+    return;
+  }
+  char* raw = static_cast<char*>(ptr) - headerSize;
+  allocatedBytes -= *reinterpret_cast<std::size_t*>(raw);
+  std::free(raw);
+}
+
+void operator delete(void* ptr, std::size_t /* size */) noexcept {
+  operator delete(ptr);
+}
+
+using namespace Scine::Molassembler;
+using Shapes::Continuous::PositionCollection;
+
+std::ostream& nl(std::ostream& os) {
+  os << '\n';
+  return os;
+}
+
+//! Normalized distorted and rotated shape coordinates with centroid last
+std::vector<PositionCollection> distortedClouds(
+  const Shapes::Shape shape,
+  const unsigned N,
+  const double distortion,
+  std::mt19937& engine
+) {
+  std::normal_distribution<double> normal {0.0, 1.0};
+  const unsigned S = Shapes::size(shape);
+
+  std::vector<PositionCollection> clouds;
+  clouds.reserve(N);
+  for(unsigned n = 0; n < N; ++n) {
+    PositionCollection positions(3, S + 1);
+    positions.block(0, 0, 3, S) = Shapes::coordinates(shape);
+    for(unsigned i = 0; i < S; ++i) {
+      const Eigen::Vector3d direction {normal(engine), normal(engine), normal(engine)};
+      positions.col(i) += distortion * direction.normalized();
+    }
+    positions.col(S) = Eigen::Vector3d::Zero();
+
+    const Eigen::Quaterniond rotation {
+      Eigen::Vector4d {normal(engine), normal(engine), normal(engine), normal(engine)}.normalized()
+    };
+    clouds.push_back(
+      Shapes::Continuous::normalize(rotation.toRotationMatrix() * positions)
+    );
+  }
+  return clouds;
+}
+
+//! Heap-allocation free measure for fixed shape sizes
+double fixedMeasure(const PositionCollection& positions, const Shapes::Shape shape) {
+  namespace Continuous = Shapes::Continuous;
+  switch(Shapes::size(shape)) {
+    case 2: return Continuous::shapeCentroidLast<2>(Continuous::FixedPositionCollection<2> {positions}, shape).measure;
+    case 3: return Continuous::shapeCentroidLast<3>(Continuous::FixedPositionCollection<3> {positions}, shape).measure;
+    case 4: return Continuous::shapeCentroidLast<4>(Continuous::FixedPositionCollection<4> {positions}, shape).measure;
+    case 5: return Continuous::shapeCentroidLast<5>(Continuous::FixedPositionCollection<5> {positions}, shape).measure;
+    case 6: return Continuous::shapeCentroidLast<6>(Continuous::FixedPositionCollection<6> {positions}, shape).measure;
+    case 7: return Continuous::shapeCentroidLast<7>(Continuous::FixedPositionCollection<7> {positions}, shape).measure;
+    case 8: return Continuous::shapeCentroidLast<8>(Continuous::FixedPositionCollection<8> {positions}, shape).measure;
+    case 9: return Continuous::shapeCentroidLast<9>(Continuous::FixedPositionCollection<9> {positions}, shape).measure;
+    case 10: return Continuous::shapeCentroidLast<10>(Continuous::FixedPositionCollection<10> {positions}, shape).measure;
+    case 11: return Continuous::shapeCentroidLast<11>(Continuous::FixedPositionCollection<11> {positions}, shape).measure;
+    case 12: return Continuous::shapeCentroidLast<12>(Continuous::FixedPositionCollection<12> {positions}, shape).measure;
+    default: throw std::logic_error("No fixed size shape measure instantiated");
+  }
+}
+
+using MeasureFunction = std::function<double(const PositionCollection&, Shapes::Shape)>;
+
+template<typename F>
+MeasureFunction measureOf(F&& f) {
+  return [f](const PositionCollection& positions, const Shapes::Shape shape) -> double {
+    return f(positions, shape).measure;
+  };
+}
+
+struct Implementation {
+  std::string name;
+  MeasureFunction function;
+  //! Smallest applicable shape size
+  unsigned minSize;
+};
+
+struct Measurement {
+  double nanoseconds;
+  double allocations;
+  double bytes;
+  double meanError;
+  double maxError;
+};
+
+Measurement measure(
+  const MeasureFunction& function,
+  const Shapes::Shape shape,
+  const std::vector<PositionCollection>& clouds,
+  const std::vector<double>& reference
+) {
+  using namespace std::chrono;
+
+  // Warm up caches that are populated on first use
+  function(clouds.front(), shape);
+
+  std::vector<double> values(clouds.size());
+  const std::size_t countBefore = allocationCount;
+  const std::size_t bytesBefore = grossAllocatedBytes;
+  const auto start = steady_clock::now();
+  for(unsigned i = 0; i < clouds.size(); ++i) {
+    values[i] = function(clouds[i], shape);
+  }
+  const double time = duration_cast<nanoseconds>(steady_clock::now() - start).count();
+  const std::size_t count = allocationCount - countBefore;
+  // Results are freed on return, so net bytes are uninformative
+  const std::size_t bytes = grossAllocatedBytes - bytesBefore;
+
+  Measurement measurement;
+  const double N = clouds.size();
+  measurement.nanoseconds = time / N;
+  measurement.allocations = count / N;
+  measurement.bytes = bytes / N;
+  measurement.meanError = 0;
+  measurement.maxError = 0;
+  for(unsigned i = 0; i < clouds.size(); ++i) {
+    const double error = std::fabs(values[i] - reference[i]);
+    measurement.meanError += error / N;
+    measurement.maxError = std::max(measurement.maxError, error);
+  }
+  return measurement;
+}
+
+constexpr const char* description =
+  "Benchmarks the continuous shape measure implementations on distorted\n"
+  "and randomly rotated coordinates of every shape, reporting time and heap\n"
+  "allocations per call and the deviation from a reference implementation.\n\n"
+  "The faithful paper implementation is the reference for shapes up to the\n"
+  "given size, the exact alternate implementation for larger shapes.\n";
+
+int main(int argc, char* argv[]) {
+  // Set up option parsing
+  boost::program_options::options_description options_description("Recognized options");
+  options_description.add_options()
+    ("help", "Produce help message")
+    ("n", boost::program_options::value<unsigned>()->default_value(20), "Number of distorted coordinates per shape")
+    ("d", boost::program_options::value<double>()->default_value(0.1), "Distortion norm per vertex")
+    ("f", boost::program_options::value<unsigned>()->default_value(6), "Largest shape size for the faithful reference")
+    ("m", boost::program_options::value<unsigned>()->default_value(8), "Largest shape size to benchmark")
+    ("s", boost::program_options::value<unsigned>()->default_value(1010), "Seed")
+    ("o", boost::program_options::value<std::string>(), "CSV file to write results to")
+  ;
+
+  // Parse
+  boost::program_options::variables_map options_variables_map;
+  boost::program_options::store(
+    boost::program_options::parse_command_line(argc, argv, options_description),
+    options_variables_map
+  );
+  boost::program_options::notify(options_variables_map);
+
+  if(options_variables_map.count("help") > 0) {
+    std::cout << description << nl << options_description << std::endl;
+    return 0;
+  }
+
+  const unsigned N = std::max(1u, options_variables_map["n"].as<unsigned>());
+  const double distortion = options_variables_map["d"].as<double>();
+  const unsigned faithfulMaxSize = options_variables_map["f"].as<unsigned>();
+  const unsigned maxSize = options_variables_map["m"].as<unsigned>();
+  std::mt19937 engine(options_variables_map["s"].as<unsigned>());
+
+  std::ofstream csvFile;
+  if(options_variables_map.count("o") > 0) {
+    csvFile.open(options_variables_map["o"].as<std::string>());
+    csvFile << "\"Shape\", \"S\", \"Implementation\", \"ns/call\", \"Allocations/call\", \"Bytes/call\", \"Mean error\", \"Max error\"" << nl;
+  }
+
+  namespace Continuous = Shapes::Continuous;
+  const std::vector<Implementation> implementations {
+    {"Faithful", measureOf(Continuous::shapeFaithfulPaperImplementation), 1},
+    {"Alternate", measureOf(Continuous::shapeAlternateImplementation), 1},
+    {"AlternateCentroidLast", measureOf(Continuous::shapeAlternateImplementationCentroidLast), 1},
+    {"Heuristics", measureOf(Continuous::shapeHeuristics), 4},
+    {"HeuristicsCentroidLast", measureOf(Continuous::shapeHeuristicsCentroidLast), 5},
+    {"FixedCentroidLast", fixedMeasure, 2}
+  };
+
+  std::cout << std::setw(28) << "Shape"
+    << std::setw(4) << "S"
+    << std::setw(24) << "Implementation"
+    << std::setw(14) << "ns/call"
+    << std::setw(10) << "Allocs"
+    << std::setw(10) << "Bytes"
+    << std::setw(12) << "Mean error"
+    << std::setw(12) << "Max error"
+    << nl;
+
+  for(const Shapes::Shape shape : Shapes::allShapes) {
+    const unsigned S = Shapes::size(shape);
+    if(S > maxSize) {
+      continue;
+    }
+
+    const auto clouds = distortedClouds(shape, N, distortion, engine);
+    const bool faithfulReference = S <= faithfulMaxSize;
+    const MeasureFunction& referenceFunction = (
+      faithfulReference
+      ? implementations.at(0).function
+      : implementations.at(1).function
+    );
+    std::vector<double> reference;
+    reference.reserve(N);
+    for(const auto& cloud : clouds) {
+      reference.push_back(referenceFunction(cloud, shape));
+    }
+
+    for(const Implementation& implementation : implementations) {
+      if(
+        S < implementation.minSize
+        || (!faithfulReference && implementation.name == "Faithful")
+      ) {
+        continue;
+      }
+
+      const Measurement m = measure(implementation.function, shape, clouds, reference);
+      std::cout << std::setw(28) << Shapes::name(shape)
+        << std::setw(4) << S
+        << std::setw(24) << implementation.name
+        << std::setw(14) << std::fixed << std::setprecision(0) << m.nanoseconds
+        << std::setw(10) << std::setprecision(1) << m.allocations
+        << std::setw(10) << std::setprecision(0) << m.bytes
+        << std::setw(12) << std::scientific << std::setprecision(2) << m.meanError
+        << std::setw(12) << m.maxError
+        << std::defaultfloat << nl;
+
+      if(csvFile.is_open()) {
+        csvFile << "\"" << Shapes::name(shape) << "\", " << S << ", \""
+          << implementation.name << "\", "
+          << std::scientific << std::setprecision(6)
+          << m.nanoseconds << ", " << m.allocations << ", " << m.bytes << ", "
+          << m.meanError << ", " << m.maxError << std::defaultfloat << nl;
+      }
+    }
+  }
+
+  return 0;
+}
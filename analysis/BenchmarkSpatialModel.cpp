@@ -0,0 +1,147 @@
+/*!@file
+ * @copyright This code is licensed under the 3-clause BSD license.
+ *   Copyright ETH Zurich, Laboratory of Physical Chemistry, Reiher Group.
+ *   See LICENSE.txt for details.
+ */
+
+#define BOOST_FILESYSTEM_NO_DEPRECATED
+
+#include "boost/filesystem.hpp"
+#include "boost/program_options.hpp"
+
+#include "Molassembler/DistanceGeometry/SpatialModel.h"
+#include "Molassembler/DistanceGeometry/ConformerGeneration.h"
+
+#include "Molassembler/IO.h"
+#include "Molassembler/Molecule.h"
+#include "Molassembler/Graph.h"
+#include "Molassembler/Temple/Functional.h"
+#include "Molassembler/Temple/constexpr/Numeric.h"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+using namespace Scine;
+using namespace Molassembler;
+
+std::ostream& nl(std::ostream& os) {
+  os << '\n';
+  return os;
+}
+
+struct ModelTimings {
+  double modelAverage;
+  double modelStddev;
+  double boundsAverage;
+  double boundsStddev;
+};
+
+ModelTimings timeModel(const Molecule& molecule, const unsigned repeats) {
+  using namespace std::chrono;
+
+  std::vector<double> modelTimings;
+  std::vector<double> boundsTimings;
+  modelTimings.reserve(repeats);
+  boundsTimings.reserve(repeats);
+
+  const DistanceGeometry::Configuration configuration {};
+  for(unsigned n = 0; n < repeats; ++n) {
+    auto start = steady_clock::now();
+    DistanceGeometry::SpatialModel spatialModel {molecule, configuration};
+    auto end = steady_clock::now();
+    modelTimings.push_back(duration_cast<microseconds>(end - start).count());
+
+    start = steady_clock::now();
+    const auto boundsList = spatialModel.makePairwiseBounds();
+    end = steady_clock::now();
+    boundsTimings.push_back(duration_cast<microseconds>(end - start).count());
+  }
+
+  ModelTimings timings;
+  timings.modelAverage = Temple::average(modelTimings);
+  timings.modelStddev = Temple::stddev(modelTimings, timings.modelAverage);
+  timings.boundsAverage = Temple::average(boundsTimings);
+  timings.boundsStddev = Temple::stddev(boundsTimings, timings.boundsAverage);
+  return timings;
+}
+
+constexpr const char* description =
+  "Benchmarks SpatialModel construction and pairwise bounds generation for\n"
+  "all MOLFiles in a path, reporting timings by molecule size.\n\n"
+  "Timings are written to spatial_model_timings.csv as well.\n";
+
+int main(int argc, char* argv[]) {
+  // Set up option parsing
+  boost::program_options::options_description options_description("Recognized options");
+  options_description.add_options()
+    ("help", "Produce help message")
+    ("m", boost::program_options::value<std::string>(), "Path to MOLFiles to benchmark")
+    ("r", boost::program_options::value<unsigned>()->default_value(20), "Number of repeats per molecule")
+  ;
+
+  // Parse
+  boost::program_options::variables_map options_variables_map;
+  boost::program_options::store(
+    boost::program_options::parse_command_line(argc, argv, options_description),
+    options_variables_map
+  );
+  boost::program_options::notify(options_variables_map);
+
+  if(options_variables_map.count("help") > 0) {
+    std::cout << description << "\n" << options_description << std::endl;
+    return 0;
+  }
+
+  if(options_variables_map.count("m") == 0) {
+    std::cout << "You have not specified any path to MOLFiles that could be used" << nl;
+    return 0;
+  }
+
+  const std::string molPath = options_variables_map["m"].as<std::string>();
+  const unsigned repeats = std::max(1u, options_variables_map["r"].as<unsigned>());
+
+  std::ofstream benchmarkFile ("spatial_model_timings.csv");
+  benchmarkFile << "\"Name\", \"N\", \"B\", \"Model\", \"Model sigma\", \"Bounds\", \"Bounds sigma\"" << nl;
+
+  std::cout
+    << std::setw(24) << "Name"
+    << std::setw(8) << "N"
+    << std::setw(8) << "B"
+    << std::setw(25) << "Model mu(sigma) / 1e-6s"
+    << std::setw(25) << "Bounds mu(sigma) / 1e-6s"
+    << nl;
+
+  for(
+    const boost::filesystem::path& currentFilePath :
+    boost::filesystem::recursive_directory_iterator(molPath)
+  ) {
+    if(!boost::filesystem::is_regular_file(currentFilePath)) {
+      continue;
+    }
+
+    const Molecule molecule = IO::read(currentFilePath.string());
+    const ModelTimings timings = timeModel(molecule, repeats);
+
+    const std::string modelStr = std::to_string(static_cast<int>(timings.modelAverage)) + "(" + std::to_string(static_cast<int>(timings.modelStddev)) + ")";
+    const std::string boundsStr = std::to_string(static_cast<int>(timings.boundsAverage)) + "(" + std::to_string(static_cast<int>(timings.boundsStddev)) + ")";
+
+    std::cout
+      << std::setw(24) << currentFilePath.stem().string()
+      << std::setw(8) << molecule.graph().N()
+      << std::setw(8) << molecule.graph().B()
+      << std::setw(25) << modelStr
+      << std::setw(25) << boundsStr
+      << nl;
+
+    benchmarkFile << "\"" << currentFilePath.stem().string() << "\", "
+      << molecule.graph().N() << ", " << molecule.graph().B() << ", "
+      << std::scientific << std::setprecision(6)
+      << timings.modelAverage << ", " << timings.modelStddev << ", "
+      << timings.boundsAverage << ", " << timings.boundsStddev << nl;
+  }
+
+  return 0;
+}
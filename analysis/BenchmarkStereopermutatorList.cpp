@@ -0,0 +1,258 @@
+/*!@file
+ * @copyright This code is licensed under the 3-clause BSD license.
+ *   Copyright ETH Zurich, Laboratory of Physical Chemistry, Reiher Group.
+ *   See LICENSE.txt for details.
+ */
+
+#define BOOST_FILESYSTEM_NO_DEPRECATED
+
+#include "boost/filesystem.hpp"
+#include "boost/program_options.hpp"
+
+#include "Molassembler/Graph.h"
+#include "Molassembler/Graph/PrivateGraph.h"
+#include "Molassembler/IO.h"
+#include "Molassembler/IO/SmilesParser.h"
+#include "Molassembler/Molecule.h"
+#include "Molassembler/Molecule/AtomEnvironmentHash.h"
+#include "Molassembler/StereopermutatorList.h"
+#include "Molassembler/Temple/Functional.h"
+#include "Molassembler/Temple/constexpr/Numeric.h"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+
+using namespace Scine::Molassembler;
+
+std::ostream& nl(std::ostream& os) {
+  os << '\n';
+  return os;
+}
+
+struct Sample {
+  std::string name;
+  Molecule molecule;
+};
+
+struct Timing {
+  double average;
+  double sigma;
+};
+
+//! Times a function over repeats, each repeat yielding nanoseconds per operation
+template<typename F>
+Timing timeRepeats(const unsigned repeats, F&& f) {
+  std::vector<double> timings;
+  timings.reserve(repeats);
+  for(unsigned r = 0; r < repeats; ++r) {
+    timings.push_back(f());
+  }
+  const double average = Temple::average(timings);
+  return {average, Temple::stddev(timings, average)};
+}
+
+double nanosecondsSince(const std::chrono::steady_clock::time_point start) {
+  using namespace std::chrono;
+  return duration_cast<nanoseconds>(steady_clock::now() - start).count();
+}
+
+void benchmark(
+  const Sample& sample,
+  const unsigned repeats,
+  std::mt19937& engine,
+  std::ofstream& csvFile
+) {
+  using namespace std::chrono;
+  const Molecule& original = sample.molecule;
+  const StereopermutatorList& stereopermutators = original.stereopermutators();
+  const unsigned N = original.graph().N();
+
+  auto report = [&](const std::string& operation, const Timing& timing) {
+    std::cout << std::setw(16) << sample.name
+      << std::setw(6) << N
+      << std::setw(6) << stereopermutators.A()
+      << std::setw(6) << stereopermutators.B()
+      << std::setw(24) << operation
+      << std::setw(14) << std::fixed << std::setprecision(0) << timing.average
+      << std::setw(14) << timing.sigma
+      << nl;
+
+    if(csvFile.is_open()) {
+      csvFile << "\"" << sample.name << "\", " << N << ", "
+        << stereopermutators.A() << ", " << stereopermutators.B()
+        << ", \"" << operation << "\", "
+        << std::scientific << std::setprecision(6)
+        << timing.average << ", " << timing.sigma << std::defaultfloat << nl;
+    }
+  };
+
+  // Molecule construction including stereopermutator detection
+  report("Molecule(graph)", timeRepeats(repeats, [&]() {
+    const auto start = steady_clock::now();
+    Molecule molecule {original.graph()};
+    const double time = nanosecondsSince(start);
+    if(molecule.graph().N() != N) {
+      std::cout << "Constructed molecule differs in size" << nl;
+    }
+    return time;
+  }));
+
+  // Atom environment hashing, looking up the stereopermutators of each atom
+  report("Hashes::generate", timeRepeats(repeats, [&]() {
+    const auto start = steady_clock::now();
+    const auto hashes = Hashes::generate(
+      original.graph().inner(),
+      stereopermutators,
+      AtomEnvironmentComponents::All
+    );
+    const double time = nanosecondsSince(start);
+    if(hashes.size() != N) {
+      std::cout << "Unexpected number of hashes" << nl;
+    }
+    return time;
+  }));
+
+  // Lookups on every atom and bond, regardless of stereopermutator presence
+  report("option(AtomIndex)", timeRepeats(repeats, [&]() {
+    const auto start = steady_clock::now();
+    unsigned found = 0;
+    for(AtomIndex i = 0; i < N; ++i) {
+      found += static_cast<unsigned>(static_cast<bool>(stereopermutators.option(i)));
+    }
+    const double time = nanosecondsSince(start);
+    if(found != stereopermutators.A()) {
+      std::cout << "Atom stereopermutator lookups inconsistent" << nl;
+    }
+    return time / N;
+  }));
+
+  const unsigned B = original.graph().B();
+  if(B > 0) {
+    report("option(BondIndex)", timeRepeats(repeats, [&]() {
+      const auto start = steady_clock::now();
+      unsigned found = 0;
+      for(const BondIndex& bond : original.graph().bonds()) {
+        found += static_cast<unsigned>(static_cast<bool>(stereopermutators.option(bond)));
+      }
+      const double time = nanosecondsSince(start);
+      if(found != stereopermutators.B()) {
+        std::cout << "Bond stereopermutator lookups inconsistent" << nl;
+      }
+      return time / B;
+    }));
+  }
+
+  // Permutation of the list as in canonicalization
+  std::vector<AtomIndex> permutation = Temple::iota<AtomIndex>(N);
+  std::shuffle(std::begin(permutation), std::end(permutation), engine);
+  report("applyPermutation", timeRepeats(repeats, [&]() {
+    StereopermutatorList copy = stereopermutators;
+    const auto start = steady_clock::now();
+    copy.applyPermutation(permutation);
+    return nanosecondsSince(start);
+  }));
+}
+
+//! Oligopeptide of phenylalanine residues, one stereocenter per residue
+std::string phenylalanineOligomer(const unsigned residues) {
+  std::string smiles;
+  for(unsigned i = 0; i < residues; ++i) {
+    smiles += "N[C@@H](Cc1ccccc1)C(=O)";
+  }
+  return smiles + "O";
+}
+
+//! Chain of trans double bonds, one bond stereopermutator per double bond
+std::string polyene(const unsigned doubleBonds) {
+  std::string smiles = "C";
+  for(unsigned i = 0; i < doubleBonds; ++i) {
+    smiles += "/C=C/";
+  }
+  return smiles + "C";
+}
+
+constexpr const char* description =
+  "Benchmarks molecule construction, atom environment hashing and\n"
+  "stereopermutator lookups on molecules of several size classes, reporting\n"
+  "the average and standard deviation of the time per operation in\n"
+  "nanoseconds. A and B are the numbers of atom and bond stereopermutators.\n";
+
+int main(int argc, char* argv[]) {
+  // Set up option parsing
+  boost::program_options::options_description options_description("Recognized options");
+  options_description.add_options()
+    ("help", "Produce help message")
+    ("r", boost::program_options::value<unsigned>()->default_value(20), "Number of repeats per operation")
+    ("s", boost::program_options::value<unsigned>()->default_value(1010), "Seed")
+    ("m", boost::program_options::value<std::string>(), "Path to molecule files to benchmark instead of the built-in size classes")
+    ("o", boost::program_options::value<std::string>(), "CSV file to write results to")
+  ;
+
+  // Parse
+  boost::program_options::variables_map options_variables_map;
+  boost::program_options::store(
+    boost::program_options::parse_command_line(argc, argv, options_description),
+    options_variables_map
+  );
+  boost::program_options::notify(options_variables_map);
+
+  if(options_variables_map.count("help") > 0) {
+    std::cout << description << nl << options_description << std::endl;
+    return 0;
+  }
+
+  const unsigned repeats = std::max(1u, options_variables_map["r"].as<unsigned>());
+  std::mt19937 engine(options_variables_map["s"].as<unsigned>());
+
+  std::vector<Sample> samples;
+  if(options_variables_map.count("m") > 0) {
+    for(
+      const boost::filesystem::path& filePath :
+      boost::filesystem::recursive_directory_iterator(options_variables_map["m"].as<std::string>())
+    ) {
+      if(boost::filesystem::is_regular_file(filePath)) {
+        samples.push_back({filePath.stem().string(), IO::read(filePath.string())});
+      }
+    }
+  } else {
+    const std::vector<std::pair<std::string, std::string>> sizeClasses {
+      {"cholesterol", "CC(C)CCC[C@@H](C)[C@H]1CC[C@@H]2[C@@]1(CC[C@H]3[C@H]2CC=C4[C@@]3(CC[C@@H](C4)O)C)C"},
+      {"phe8", phenylalanineOligomer(8)},
+      {"phe32", phenylalanineOligomer(32)},
+      {"phe128", phenylalanineOligomer(128)},
+      {"polyene16", polyene(16)},
+      {"polyene64", polyene(64)}
+    };
+    for(const auto& sizeClass : sizeClasses) {
+      samples.push_back({
+        sizeClass.first,
+        IO::Experimental::parseSmilesSingleMolecule(sizeClass.second)
+      });
+    }
+  }
+
+  std::ofstream csvFile;
+  if(options_variables_map.count("o") > 0) {
+    csvFile.open(options_variables_map["o"].as<std::string>());
+    csvFile << "\"Molecule\", \"N\", \"A\", \"B\", \"Operation\", \"ns/op\", \"sigma\"" << nl;
+  }
+
+  std::cout << std::setw(16) << "Molecule"
+    << std::setw(6) << "N"
+    << std::setw(6) << "A"
+    << std::setw(6) << "B"
+    << std::setw(24) << "Operation"
+    << std::setw(14) << "ns/op"
+    << std::setw(14) << "sigma"
+    << nl;
+
+  for(const Sample& sample : samples) {
+    benchmark(sample, repeats, engine, csvFile);
+  }
+
+  return 0;
+}
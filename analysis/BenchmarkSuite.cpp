@@ -0,0 +1,375 @@
+/*!@file
+ * @copyright This code is licensed under the 3-clause BSD license.
+ *   Copyright ETH Zurich, Laboratory of Physical Chemistry, Reiher Group.
+ *   See LICENSE.txt for details.
+ */
+
+#define BOOST_FILESYSTEM_NO_DEPRECATED
+
+#include "boost/filesystem.hpp"
+#include "boost/program_options.hpp"
+#include "nlohmann/json.hpp"
+
+#include "Molassembler/Conformers.h"
+#include "Molassembler/Graph.h"
+#include "Molassembler/Interpret.h"
+#include "Molassembler/IO.h"
+#include "Molassembler/IO/SmilesEmitter.h"
+#include "Molassembler/IO/SmilesParser.h"
+#include "Molassembler/Molecule.h"
+#include "Molassembler/RankingInformation.h"
+#include "Molassembler/Serialization.h"
+#include "Molassembler/Version.h"
+#include "Molassembler/Temple/constexpr/Numeric.h"
+
+#include "Utils/Bonds/BondOrderCollection.h"
+#include "Utils/Geometry/AtomCollection.h"
+#include "Utils/IO/ChemicalFileFormats/ChemicalFileHandler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+
+using namespace Scine::Molassembler;
+
+std::ostream& nl(std::ostream& os) {
+  os << '\n';
+  return os;
+}
+
+struct Sample {
+  std::string bucket;
+  std::string name;
+  std::string path;
+  Molecule molecule;
+};
+
+struct Timing {
+  double average;
+  double sigma;
+  double minimum;
+};
+
+//! Times a function over repeats, each repeat yielding seconds per operation
+template<typename F>
+Timing timeRepeats(const unsigned repeats, F&& f) {
+  std::vector<double> timings;
+  timings.reserve(repeats);
+  for(unsigned r = 0; r < repeats; ++r) {
+    timings.push_back(f(r));
+  }
+  const double average = Temple::average(timings);
+  return {
+    average,
+    Temple::stddev(timings, average),
+    *std::min_element(std::begin(timings), std::end(timings))
+  };
+}
+
+double secondsSince(const std::chrono::steady_clock::time_point start) {
+  using namespace std::chrono;
+  return duration<double>(steady_clock::now() - start).count();
+}
+
+class Benchmarks {
+public:
+  Benchmarks(const unsigned repeats, const unsigned seed) : repeats_(repeats), seed_(seed) {}
+
+  void run(const Sample& sample) {
+    using namespace std::chrono;
+    const Molecule& original = sample.molecule;
+
+    // Interpretation of the file's contents, excluding reading the file
+    const auto readData = Scine::Utils::ChemicalFileHandler::read(sample.path);
+    measure(sample, "interpret", [&](unsigned /* r */) {
+      const auto start = steady_clock::now();
+      if(readData.second.empty()) {
+        Interpret::molecules(readData.first, Interpret::BondDiscretizationOption::RoundToNearest);
+      } else {
+        Interpret::molecules(readData.first, readData.second, Interpret::BondDiscretizationOption::RoundToNearest);
+      }
+      return secondsSince(start);
+    });
+
+    // Substituent ranking of every atom
+    measure(sample, "rank", [&](unsigned /* r */) {
+      const auto start = steady_clock::now();
+      for(AtomIndex i = 0; i < original.graph().N(); ++i) {
+        original.rankPriority(i);
+      }
+      return secondsSince(start);
+    });
+
+    measure(sample, "canonicalize", [&](unsigned /* r */) {
+      Molecule copy = original;
+      const auto start = steady_clock::now();
+      copy.canonicalize();
+      return secondsSince(start);
+    });
+
+    std::string smiles;
+    measure(sample, "emitSmiles", [&](unsigned /* r */) {
+      const auto start = steady_clock::now();
+      smiles = IO::Experimental::emitCanonicalSmiles(original);
+      return secondsSince(start);
+    });
+
+    if(!smiles.empty()) {
+      measure(sample, "parseSmiles", [&](unsigned /* r */) {
+        const auto start = steady_clock::now();
+        IO::Experimental::parseSmiles(smiles);
+        return secondsSince(start);
+      });
+    }
+
+    JsonSerialization::BinaryType cbor;
+    measure(sample, "serialize", [&](unsigned /* r */) {
+      const auto start = steady_clock::now();
+      cbor = JsonSerialization(original).toBinary(JsonSerialization::BinaryFormat::CBOR);
+      return secondsSince(start);
+    });
+
+    measure(sample, "deserialize", [&](unsigned /* r */) {
+      const auto start = steady_clock::now();
+      const Molecule deserialized = JsonSerialization(cbor, JsonSerialization::BinaryFormat::CBOR);
+      return secondsSince(start);
+    });
+
+    // Each repeat generates a conformer with a different seed
+    unsigned failures = 0;
+    measure(sample, "generateConformation", [&](const unsigned r) {
+      const auto start = steady_clock::now();
+      const auto result = generateConformation(original, seed_ + r);
+      const double seconds = secondsSince(start);
+      if(!result) {
+        ++failures;
+      }
+      return seconds;
+    });
+    if(failures > 0) {
+      results_.back()["failures"] = failures;
+      std::cout << "  " << failures << " of " << repeats_ << " conformers failed" << nl;
+    }
+  }
+
+  nlohmann::json results() const {
+    return results_;
+  }
+
+private:
+  //! Times and reports an operation, skipping it if it throws
+  template<typename F>
+  void measure(const Sample& sample, const std::string& operation, F&& f) {
+    Timing timing;
+    try {
+      timing = timeRepeats(repeats_, std::forward<F>(f));
+    } catch(std::exception& e) {
+      std::cout << std::setw(12) << sample.bucket
+        << std::setw(28) << sample.name
+        << std::setw(24) << operation
+        << "  skipped: " << e.what() << nl;
+      return;
+    }
+
+    std::cout << std::setw(12) << sample.bucket
+      << std::setw(28) << sample.name.substr(0, 26)
+      << std::setw(6) << sample.molecule.graph().N()
+      << std::setw(24) << operation
+      << std::setw(14) << std::scientific << std::setprecision(3) << timing.average
+      << std::setw(14) << timing.sigma
+      << std::setw(14) << timing.minimum
+      << std::defaultfloat << nl;
+
+    results_.push_back({
+      {"bucket", sample.bucket},
+      {"molecule", sample.name},
+      {"N", sample.molecule.graph().N()},
+      {"operation", operation},
+      {"seconds", timing.average},
+      {"sigma", timing.sigma},
+      {"minimum", timing.minimum}
+    });
+  }
+
+  unsigned repeats_;
+  unsigned seed_;
+  nlohmann::json results_ = nlohmann::json::array();
+};
+
+/*! Compares minimal timings against those of a baseline run, listing
+ * operations slower than the threshold ratio
+ *
+ * Minimal timings are least affected by other load on the machine.
+ *
+ * @returns The number of regressions
+ */
+unsigned compare(
+  const nlohmann::json& results,
+  const nlohmann::json& baseline,
+  const double threshold
+) {
+  auto key = [](const nlohmann::json& result) -> std::string {
+    return result.at("bucket").get<std::string>() + "/"
+      + result.at("molecule").get<std::string>() + "/"
+      + result.at("operation").get<std::string>();
+  };
+
+  std::map<std::string, double> baselineMinima;
+  for(const auto& result : baseline.at("benchmarks")) {
+    baselineMinima.emplace(key(result), result.at("minimum").get<double>());
+  }
+
+  std::cout << nl << "Comparison against baseline of version "
+    << baseline.at("version").get<std::string>()
+    << ", threshold ratio " << threshold << nl;
+
+  unsigned regressions = 0;
+  for(const auto& result : results) {
+    const std::string name = key(result);
+    const auto findIter = baselineMinima.find(name);
+    if(findIter == std::end(baselineMinima)) {
+      std::cout << std::setw(64) << name << "  not in baseline" << nl;
+      continue;
+    }
+
+    const double ratio = result.at("minimum").get<double>() / findIter->second;
+    const bool regressed = ratio > threshold;
+    if(regressed) {
+      ++regressions;
+    }
+    std::cout << std::setw(64) << name
+      << std::setw(10) << std::fixed << std::setprecision(2) << ratio
+      << std::defaultfloat
+      << (regressed ? "  REGRESSION" : "") << nl;
+  }
+
+  std::cout << regressions << " of " << results.size() << " operations regressed" << nl;
+  return regressions;
+}
+
+constexpr const char* description =
+  "Benchmarks interpretation, ranking, canonicalization, SMILES emission and\n"
+  "parsing, serialization and conformer generation on a versioned corpus of\n"
+  "molecules in size and complexity buckets. Reports the average, standard\n"
+  "deviation and minimum of the time per operation in seconds, optionally as\n"
+  "JSON for comparison across releases.\n\n"
+  "If a baseline JSON file of an earlier run is supplied, exits with failure if\n"
+  "the minimal time of any operation exceeds its baseline by the threshold\n"
+  "ratio. Record baselines and compare on the same machine and build type.\n";
+
+int main(int argc, char* argv[]) {
+  // Set up option parsing
+  boost::program_options::options_description options_description("Recognized options");
+  options_description.add_options()
+    ("help", "Produce help message")
+    ("c", boost::program_options::value<std::string>()->default_value("BenchmarkCorpus.json"), "Corpus file")
+    ("b", boost::program_options::value<std::vector<std::string>>()->multitoken(), "Buckets to benchmark, all if unspecified")
+    ("r", boost::program_options::value<unsigned>()->default_value(10), "Number of repeats per operation")
+    ("s", boost::program_options::value<unsigned>()->default_value(1010), "Seed")
+    ("o", boost::program_options::value<std::string>(), "JSON file to write results to")
+    ("baseline", boost::program_options::value<std::string>(), "JSON file of an earlier run to compare against")
+    ("t", boost::program_options::value<double>()->default_value(1.5), "Threshold ratio of minimal times to baseline minimal times counting as a regression")
+  ;
+
+  // Parse
+  boost::program_options::variables_map options_variables_map;
+  boost::program_options::store(
+    boost::program_options::parse_command_line(argc, argv, options_description),
+    options_variables_map
+  );
+  boost::program_options::notify(options_variables_map);
+
+  if(options_variables_map.count("help") > 0) {
+    std::cout << description << nl << options_description << std::endl;
+    return 0;
+  }
+
+  const unsigned repeats = std::max(1u, options_variables_map["r"].as<unsigned>());
+  const unsigned seed = options_variables_map["s"].as<unsigned>();
+
+  const boost::filesystem::path corpusPath = options_variables_map["c"].as<std::string>();
+  std::ifstream corpusFile(corpusPath.string());
+  if(!corpusFile) {
+    std::cout << "Could not open corpus file " << corpusPath << nl;
+    return 1;
+  }
+  const auto corpus = nlohmann::json::parse(corpusFile);
+
+  nlohmann::json baseline;
+  if(options_variables_map.count("baseline") > 0) {
+    std::ifstream baselineFile(options_variables_map["baseline"].as<std::string>());
+    if(!baselineFile) {
+      std::cout << "Could not open baseline file" << nl;
+      return 1;
+    }
+    baseline = nlohmann::json::parse(baselineFile);
+    if(baseline.at("corpus") != corpus.at("version")) {
+      std::cout << "Baseline was recorded with corpus version " << baseline.at("corpus")
+        << ", but the corpus is version " << corpus.at("version") << nl;
+      return 1;
+    }
+  }
+
+  std::vector<std::string> buckets;
+  if(options_variables_map.count("b") > 0) {
+    buckets = options_variables_map["b"].as<std::vector<std::string>>();
+  }
+
+  // Molecule paths are relative to the corpus file
+  std::vector<Sample> samples;
+  for(const auto& bucket : corpus.at("buckets").items()) {
+    if(
+      !buckets.empty()
+      && std::find(std::begin(buckets), std::end(buckets), bucket.key()) == std::end(buckets)
+    ) {
+      continue;
+    }
+
+    for(const std::string relativePath : bucket.value()) {
+      const auto filePath = corpusPath.parent_path() / relativePath;
+      samples.push_back({
+        bucket.key(),
+        filePath.stem().string(),
+        filePath.string(),
+        IO::read(filePath.string())
+      });
+    }
+  }
+
+  std::cout << std::setw(12) << "Bucket"
+    << std::setw(28) << "Molecule"
+    << std::setw(6) << "N"
+    << std::setw(24) << "Operation"
+    << std::setw(14) << "s/op"
+    << std::setw(14) << "sigma"
+    << std::setw(14) << "min"
+    << nl;
+
+  Benchmarks benchmarks {repeats, seed};
+  for(const Sample& sample : samples) {
+    benchmarks.run(sample);
+  }
+
+  if(options_variables_map.count("o") > 0) {
+    const nlohmann::json json = {
+      {"version", Version::full()},
+      {"corpus", corpus.at("version")},
+      {"repeats", repeats},
+      {"seed", seed},
+      {"benchmarks", benchmarks.results()}
+    };
+    std::ofstream(options_variables_map["o"].as<std::string>()) << json.dump(2) << nl;
+  }
+
+  if(!baseline.is_null()) {
+    const double threshold = options_variables_map["t"].as<double>();
+    if(compare(benchmarks.results(), baseline, threshold) > 0) {
+      return 1;
+    }
+  }
+
+  return 0;
+}
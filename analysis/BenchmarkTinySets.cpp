@@ -0,0 +1,129 @@
+/*!@file
+ * @copyright This code is licensed under the 3-clause BSD license.
+ *   Copyright ETH Zurich, Laboratory of Physical Chemistry, Reiher Group.
+ *   See LICENSE.txt for details.
+ */
+
+#include "boost/program_options.hpp"
+
+#include "Molassembler/Temple/Random.h"
+#include "Molassembler/Temple/TinySet.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <random>
+
+/* Heap accounting: Every allocation is counted so that the allocations per
+ * set can be compared
+ */
+namespace {
+
+std::size_t allocations = 0;
+
+} // namespace
+
+void* operator new(std::size_t size) {
+  void* ptr = std::malloc(size);
+  if(ptr == nullptr) {
+    throw std::bad_alloc {};
+  }
+  ++allocations;
+  return ptr;
+}
+
+void operator delete(void* ptr) noexcept {
+  std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t /* size */) noexcept {
+  std::free(ptr);
+}
+
+using namespace Scine::Molassembler;
+
+std::ostream& nl(std::ostream& os) {
+  os << '\n';
+  return os;
+}
+
+template<typename Set>
+void benchmark(const std::string& name, const std::vector<std::vector<unsigned>>& lists) {
+  using namespace std::chrono;
+
+  const std::size_t allocationsBefore = allocations;
+  unsigned found = 0;
+  const auto start = steady_clock::now();
+  for(const auto& list : lists) {
+    Set set;
+    for(const unsigned value : list) {
+      if(set.count(value) == 0) {
+        set.insert(value);
+      }
+    }
+    for(const unsigned value : list) {
+      found += set.count(value);
+    }
+  }
+  const double time = duration_cast<nanoseconds>(steady_clock::now() - start).count();
+  const std::size_t setAllocations = allocations - allocationsBefore;
+
+  if(found == 0) {
+    std::cout << "No values found in " << name << nl;
+  }
+
+  std::cout << std::setw(28) << name
+    << std::setw(16) << std::fixed << std::setprecision(2) << static_cast<double>(setAllocations) / lists.size()
+    << std::setw(16) << std::setprecision(1) << time / lists.size()
+    << nl;
+}
+
+int main(int argc, char* argv[]) {
+  // Set up option parsing
+  boost::program_options::options_description options_description("Recognized options");
+  options_description.add_options()
+    ("help", "Produce help message")
+    ("s", boost::program_options::value<unsigned>()->default_value(4), "Number of values per set")
+    ("n", boost::program_options::value<unsigned>()->default_value(1000000), "Number of sets to build")
+  ;
+
+  // Parse
+  boost::program_options::variables_map options_variables_map;
+  boost::program_options::store(
+    boost::program_options::parse_command_line(argc, argv, options_description),
+    options_variables_map
+  );
+  boost::program_options::notify(options_variables_map);
+
+  if(options_variables_map.count("help") > 0) {
+    std::cout << "Compares allocations and timings of tiny set variants" << nl
+      << options_description << std::endl;
+    return 0;
+  }
+
+  const unsigned S = options_variables_map["s"].as<unsigned>();
+  const unsigned N = options_variables_map["n"].as<unsigned>();
+
+  std::mt19937 engine(1010);
+  std::vector<std::vector<unsigned>> lists;
+  lists.reserve(N);
+  for(unsigned i = 0; i < N; ++i) {
+    lists.push_back(Temple::Random::getN<unsigned>(0, 2 * S, S, engine));
+  }
+
+  std::cout << std::setw(28) << "Set"
+    << std::setw(16) << "Allocs/set"
+    << std::setw(16) << "Time/set [ns]"
+    << nl;
+
+  benchmark<Temple::TinySet<unsigned>>("TinySet", lists);
+  benchmark<Temple::TinySet<unsigned, 4>>("TinySet<4>", lists);
+  benchmark<Temple::TinySet<unsigned, 8>>("TinySet<8>", lists);
+  benchmark<Temple::TinyUnorderedSet<unsigned>>("TinyUnorderedSet", lists);
+  benchmark<Temple::TinyUnorderedSet<unsigned, 4>>("TinyUnorderedSet<4>", lists);
+  benchmark<Temple::TinyUnorderedSet<unsigned, 8>>("TinyUnorderedSet<8>", lists);
+
+  return 0;
+}
@@ -0,0 +1,156 @@
+/*!@file
+ * @copyright This code is licensed under the 3-clause BSD license.
+ *   Copyright ETH Zurich, Laboratory of Physical Chemistry, Reiher Group.
+ *   See LICENSE.txt for details.
+ */
+
+#include "boost/program_options.hpp"
+
+#include "Molassembler/Temple/BoundedNodeTrie.h"
+#include "Molassembler/Temple/CompactBoundedNodeTrie.h"
+#include "Molassembler/Temple/Random.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <random>
+
+/* Heap accounting: Every allocation is prefixed with its size so that
+ * deallocations can be subtracted from the tally
+ */
+namespace {
+
+std::size_t allocatedBytes = 0;
+constexpr std::size_t headerSize = alignof(std::max_align_t);
+
+} // namespace
+
+void* operator new(std::size_t size) {
+  auto* raw = static_cast<char*>(std::malloc(size + headerSize));
+  if(raw == nullptr) {
+    throw std::bad_alloc {};
+  }
+  *reinterpret_cast<std::size_t*>(raw) = size;
+  allocatedBytes += size;
+  return raw + headerSize;
+}
+
+void operator delete(void* ptr) noexcept {
+  if(ptr == nullptr) {
+    return;
+  }
+  char* raw = static_cast<char*>(ptr) - headerSize;
+  allocatedBytes -= *reinterpret_cast<std::size_t*>(raw);
+  std::free(raw);
+}
+
+void operator delete(void* ptr, std::size_t /* size */) noexcept {
+  operator delete(ptr);
+}
+
+using namespace Scine::Molassembler;
+
+using ChoiceList = std::vector<std::uint8_t>;
+
+std::ostream& nl(std::ostream& os) {
+  os << '\n';
+  return os;
+}
+
+std::vector<ChoiceList> randomLists(const ChoiceList& bounds, const unsigned N, std::mt19937& engine) {
+  std::vector<ChoiceList> lists;
+  lists.reserve(N);
+  for(unsigned i = 0; i < N; ++i) {
+    ChoiceList list;
+    list.reserve(bounds.size());
+    for(const std::uint8_t U : bounds) {
+      list.push_back(Temple::Random::getSingle<unsigned>(0, U - 1, engine));
+    }
+    lists.push_back(std::move(list));
+  }
+  return lists;
+}
+
+template<typename Trie>
+void benchmark(const std::string& name, const ChoiceList& bounds, const std::vector<ChoiceList>& lists) {
+  using namespace std::chrono;
+
+  const std::size_t bytesBefore = allocatedBytes;
+  Trie trie {bounds};
+
+  auto start = steady_clock::now();
+  for(const auto& list : lists) {
+    trie.insert(list);
+  }
+  const double insertTime = duration_cast<nanoseconds>(steady_clock::now() - start).count();
+  const std::size_t bytes = allocatedBytes - bytesBefore;
+
+  unsigned found = 0;
+  start = steady_clock::now();
+  for(const auto& list : lists) {
+    found += static_cast<unsigned>(trie.contains(list));
+  }
+  const double containsTime = duration_cast<nanoseconds>(steady_clock::now() - start).count();
+
+  if(found != lists.size()) {
+    std::cout << "Not all inserted lists were found in " << name << nl;
+  }
+
+  std::cout << std::setw(24) << name
+    << std::setw(12) << trie.size()
+    << std::setw(16) << std::fixed << std::setprecision(1) << static_cast<double>(bytes) / trie.size()
+    << std::setw(16) << insertTime / lists.size()
+    << std::setw(16) << containsTime / lists.size()
+    << nl;
+}
+
+int main(int argc, char* argv[]) {
+  // Set up option parsing
+  boost::program_options::options_description options_description("Recognized options");
+  options_description.add_options()
+    ("help", "Produce help message")
+    ("b", boost::program_options::value<unsigned>()->default_value(15), "Number of levels (bonds)")
+    ("u", boost::program_options::value<unsigned>()->default_value(3), "Number of choices per level")
+    ("n", boost::program_options::value<unsigned>()->default_value(100000), "Number of random entries to insert")
+  ;
+
+  // Parse
+  boost::program_options::variables_map options_variables_map;
+  boost::program_options::store(
+    boost::program_options::parse_command_line(argc, argv, options_description),
+    options_variables_map
+  );
+  boost::program_options::notify(options_variables_map);
+
+  if(options_variables_map.count("help") > 0) {
+    std::cout << "Compares memory per entry and timings of trie variants" << nl
+      << options_description << std::endl;
+    return 0;
+  }
+
+  const unsigned B = options_variables_map["b"].as<unsigned>();
+  const unsigned U = options_variables_map["u"].as<unsigned>();
+  const unsigned N = options_variables_map["n"].as<unsigned>();
+  if(B == 0 || U < 2 || U > 255) {
+    std::cout << "Need at least one level and between 2 and 255 choices" << nl;
+    return 0;
+  }
+
+  const ChoiceList bounds(B, U);
+  std::mt19937 engine(1010);
+  const auto lists = randomLists(bounds, N, engine);
+
+  std::cout << std::setw(24) << "Trie"
+    << std::setw(12) << "Entries"
+    << std::setw(16) << "Bytes/entry"
+    << std::setw(16) << "Insert [ns]"
+    << std::setw(16) << "Contains [ns]"
+    << nl;
+
+  benchmark<Temple::BoundedNodeTrie<std::uint8_t>>("BoundedNodeTrie", bounds, lists);
+  benchmark<Temple::CompactBoundedNodeTrie<std::uint8_t>>("CompactBoundedNodeTrie", bounds, lists);
+
+  return 0;
+}
@@ -0,0 +1,156 @@
+/*!@file
+ * @copyright This code is licensed under the 3-clause BSD license.
+ *   Copyright ETH Zurich, Laboratory of Physical Chemistry, Reiher Group.
+ *   See LICENSE.txt for details.
+ */
+
+#define BOOST_FILESYSTEM_NO_DEPRECATED
+
+#include "boost/filesystem.hpp"
+#include "boost/program_options.hpp"
+#include "nlohmann/json.hpp"
+
+#include "Molassembler/Conformers.h"
+#include "Molassembler/CostModel.h"
+#include "Molassembler/IO.h"
+#include "Molassembler/Molecule.h"
+#include "Molassembler/Parallel.h"
+#include "Molassembler/Version.h"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+using namespace Scine::Molassembler;
+
+std::ostream& nl(std::ostream& os) {
+  os << '\n';
+  return os;
+}
+
+struct Sample {
+  std::string name;
+  CostModel::Observation observation;
+};
+
+constexpr const char* description =
+  "Calibrates a conformer generation cost model on this machine. Generates\n"
+  "conformers for each molecule of the benchmark corpus single-threaded,\n"
+  "fits the logarithm of the time per conformer and the logit of the failure\n"
+  "rate to cheap molecular features, and compares predictions with the\n"
+  "measurements. The model coefficients can be written as JSON.\n";
+
+int main(int argc, char* argv[]) {
+  // Set up option parsing
+  boost::program_options::options_description options_description("Recognized options");
+  options_description.add_options()
+    ("help", "Produce help message")
+    ("c", boost::program_options::value<std::string>()->default_value("BenchmarkCorpus.json"), "Corpus file")
+    ("n", boost::program_options::value<unsigned>()->default_value(20), "Number of conformers per molecule")
+    ("s", boost::program_options::value<unsigned>()->default_value(1010), "Seed")
+    ("o", boost::program_options::value<std::string>(), "JSON file to write model coefficients to")
+  ;
+
+  // Parse
+  boost::program_options::variables_map options_variables_map;
+  boost::program_options::store(
+    boost::program_options::parse_command_line(argc, argv, options_description),
+    options_variables_map
+  );
+  boost::program_options::notify(options_variables_map);
+
+  if(options_variables_map.count("help") > 0) {
+    std::cout << description << nl << options_description << std::endl;
+    return 0;
+  }
+
+  const unsigned numConformers = std::max(1u, options_variables_map["n"].as<unsigned>());
+  const unsigned seed = options_variables_map["s"].as<unsigned>();
+
+  const boost::filesystem::path corpusPath = options_variables_map["c"].as<std::string>();
+  std::ifstream corpusFile(corpusPath.string());
+  if(!corpusFile) {
+    std::cout << "Could not open corpus file " << corpusPath << nl;
+    return 1;
+  }
+  const auto corpus = nlohmann::json::parse(corpusFile);
+
+  // Model times are per conformer on a single thread
+  Parallel::setExecutor(Parallel::serial());
+
+  // Molecule paths are relative to the corpus file
+  std::vector<Sample> samples;
+  for(const auto& bucket : corpus.at("buckets").items()) {
+    for(const std::string relativePath : bucket.value()) {
+      const auto filePath = corpusPath.parent_path() / relativePath;
+      const Molecule molecule = IO::read(filePath.string());
+
+      const auto start = std::chrono::steady_clock::now();
+      const auto ensemble = generateEnsemble(molecule, numConformers, seed);
+      const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+      const auto failures = std::count_if(
+        std::begin(ensemble),
+        std::end(ensemble),
+        [](const auto& result) { return !result; }
+      );
+
+      samples.push_back({
+        filePath.stem().string(),
+        {
+          CostModel::features(molecule),
+          seconds / numConformers,
+          static_cast<double>(failures) / numConformers
+        }
+      });
+    }
+  }
+
+  std::vector<CostModel::Observation> observations;
+  observations.reserve(samples.size());
+  for(const Sample& sample : samples) {
+    observations.push_back(sample.observation);
+  }
+  const CostModel model = CostModel::calibrate(observations);
+
+  std::cout << "Time coefficients: " << model.timeCoefficients().transpose() << nl
+    << "Failure coefficients: " << model.failureCoefficients().transpose() << nl << nl;
+
+  std::cout << std::setw(28) << "Molecule"
+    << std::setw(6) << "N"
+    << std::setw(14) << "s/conformer"
+    << std::setw(14) << "predicted"
+    << std::setw(10) << "failures"
+    << std::setw(11) << "predicted"
+    << nl;
+
+  for(const Sample& sample : samples) {
+    const CostModel::Observation& observation = sample.observation;
+    const CostModel::Estimate estimate = model.predict(observation.features);
+    std::cout << std::setw(28) << sample.name.substr(0, 27)
+      << std::setw(6) << observation.features.atoms
+      << std::setw(14) << std::scientific << std::setprecision(3) << observation.secondsPerConformer
+      << std::setw(14) << estimate.secondsPerConformer
+      << std::setw(10) << std::fixed << std::setprecision(2) << observation.failureRate
+      << std::setw(11) << estimate.failureRate
+      << std::defaultfloat << nl;
+  }
+
+  if(options_variables_map.count("o") > 0) {
+    const Eigen::VectorXd& time = model.timeCoefficients();
+    const Eigen::VectorXd& failure = model.failureCoefficients();
+    const nlohmann::json json = {
+      {"version", Version::full()},
+      {"corpus", corpus.at("version")},
+      {"conformers", numConformers},
+      {"seed", seed},
+      {"time", std::vector<double>(time.data(), time.data() + time.size())},
+      {"failure", std::vector<double>(failure.data(), failure.data() + failure.size())}
+    };
+    std::ofstream(options_variables_map["o"].as<std::string>()) << json.dump(2) << nl;
+  }
+
+  return 0;
+}
@@ -4,7 +4,9 @@
  *   See LICENSE.txt for details.
  *
  * This file reimplements Distance Geometry with more invasive debug structures
- * and data collection.
+ * and data collection. Sampled refinement values, gradient norms and
+ * positions of the library's own refinement are recorded with
+ * DistanceGeometry::Configuration::trajectoryInterval instead.
  */
 
 #define BOOST_FILESYSTEM_NO_DEPRECATED
@@ -497,7 +499,7 @@ MoleculeDGInformation gatherDGInformation(
 
   // Extract gathered data
   MoleculeDGInformation data;
-  data.bounds = spatialModel.makePairwiseBounds();
+  SpatialModel::BoundsMatrix bounds = spatialModel.makePairwiseBounds();
   data.chiralConstraints = spatialModel.getChiralConstraints();
   data.dihedralConstraints = spatialModel.getDihedralConstraints();
   data.rotatableGroups = MoleculeDGInformation::make(data.dihedralConstraints, molecule);
@@ -507,8 +509,8 @@ MoleculeDGInformation gatherDGInformation(
     const AtomIndex N = molecule.graph().N();
     for(AtomIndex i = 0; i < N; ++i) {
       for(AtomIndex j = i + 1; j < N; ++j) {
-        double& lower = data.bounds(j, i);
-        double& upper = data.bounds(i, j);
+        double& lower = bounds(j, i);
+        double& upper = bounds(i, j);
 
         if(lower == 0.0 && upper == 0.0) {
           double vdwLowerBound = (
@@ -523,20 +525,22 @@ MoleculeDGInformation gatherDGInformation(
     }
 
     // Triangle smooth
-    DistanceBoundsMatrix::smooth(data.bounds);
+    DistanceBoundsMatrix::smooth(bounds);
     // Tetrangle smooth
-    unsigned iterations = tetrangleSmooth(data.bounds);
+    unsigned iterations = tetrangleSmooth(bounds);
     std::cout << "Applied " << iterations << " iterations of tetrangle smoothing\n";
   }
 
+  data.bounds = bounds.sparseView();
+
   if(printBounds) {
     const AtomIndex N = molecule.graph().N();
     for(AtomIndex i = 0; i < N; ++i) {
       auto iGraphDistances = distance(i, molecule.graph());
 
       for(AtomIndex j = i + 1; j < N; ++j) {
-        const double lower = data.bounds(j, i);
-        const double upper = data.bounds(i, j);
+        const double lower = bounds(j, i);
+        const double upper = bounds(i, j);
 
         if(lower != 0.0 || upper != 0.0) {
           std::cout << i << " - " << j
@@ -0,0 +1,37 @@
+#
+# This file is licensed under the 3-clause BSD license.
+# Copyright ETH Zurich, Laboratory of Physical Chemistry, Reiher Group.
+# See LICENSE.txt for details.
+#
+
+# Script mode: Writes the binary file INPUT as a byte array definition named
+# NAME, along with its size NAME followed by Size, in the Detail namespace of
+# the molassembler namespace NAMESPACE into the C++ source file OUTPUT
+if(NOT DEFINED INPUT OR NOT DEFINED OUTPUT OR NOT DEFINED NAMESPACE OR NOT DEFINED NAME)
+  message(FATAL_ERROR "EmbedBinary.cmake requires INPUT, OUTPUT, NAMESPACE and NAME")
+endif()
+
+file(READ ${INPUT} _hex HEX)
+string(LENGTH "${_hex}" _hex_length)
+math(EXPR _size "${_hex_length} / 2")
+string(REGEX REPLACE "([0-9a-f][0-9a-f])" "0x\\1," _bytes "${_hex}")
+string(REGEX REPLACE "(0x..,0x..,0x..,0x..,0x..,0x..,0x..,0x..,0x..,0x..,0x..,0x..,)" "\\1\n  " _bytes "${_bytes}")
+
+file(WRITE ${OUTPUT} "// Generated from ${INPUT}, do not edit\n
+#include <cstddef>
+
+namespace Scine {
+namespace Molassembler {
+namespace ${NAMESPACE} {
+namespace Detail {
+
+extern const unsigned char ${NAME}[] = {
+  ${_bytes}
+};
+extern const std::size_t ${NAME}Size = ${_size};
+
+} // namespace Detail
+} // namespace ${NAMESPACE}
+} // namespace Molassembler
+} // namespace Scine
+")
@@ -0,0 +1,171 @@
+/*!@file
+ * @copyright This code is licensed under the 3-clause BSD license.
+ *   Copyright ETH Zurich, Laboratory of Physical Chemistry, Reiher Group.
+ *   See LICENSE.txt for details.
+ */
+#ifndef INCLUDE_MOLASSEMBLER_PYTHON_AWAITABLE_H
+#define INCLUDE_MOLASSEMBLER_PYTHON_AWAITABLE_H
+
+#include "pybind11/pybind11.h"
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+/* Runs operations submitted by asyncio coroutines one at a time in submission
+ * order on a background thread. Each operation parallelizes with the
+ * library's executor just like its blocking counterpart, so running them one
+ * at a time keeps concurrent submissions from oversubscribing the machine.
+ *
+ * The thread is never joined, since the interpreter may exit while it waits
+ * for operations. The runner is leaked for the same reason.
+ */
+class AsyncRunner {
+public:
+  using Job = std::function<void()>;
+
+  static AsyncRunner& instance() {
+    static AsyncRunner* runner = new AsyncRunner;
+    return *runner;
+  }
+
+  void submit(Job job) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      jobs_.push_back(std::move(job));
+    }
+    notEmpty_.notify_one();
+  }
+
+private:
+  AsyncRunner() {
+    std::thread(
+      [this]() {
+        for(;;) {
+          Job job;
+          {
+            std::unique_lock<std::mutex> lock(mutex_);
+            notEmpty_.wait(lock, [this]() { return !jobs_.empty(); });
+            job = std::move(jobs_.front());
+            jobs_.pop_front();
+          }
+          job();
+        }
+      }
+    ).detach();
+  }
+
+  std::mutex mutex_;
+  std::condition_variable notEmpty_;
+  std::deque<Job> jobs_;
+};
+
+/* Python exception equivalent to pybind11's default translation of standard
+ * exceptions
+ */
+inline pybind11::object asyncException(const std::exception_ptr& exception) {
+  pybind11::module builtins = pybind11::module::import("builtins");
+  try {
+    std::rethrow_exception(exception);
+  } catch(pybind11::error_already_set& e) {
+    return e.value();
+  } catch(std::invalid_argument& e) {
+    return builtins.attr("ValueError")(e.what());
+  } catch(std::domain_error& e) {
+    return builtins.attr("ValueError")(e.what());
+  } catch(std::out_of_range& e) {
+    return builtins.attr("IndexError")(e.what());
+  } catch(std::bad_alloc& e) {
+    return builtins.attr("MemoryError")(e.what());
+  } catch(std::exception& e) {
+    return builtins.attr("RuntimeError")(e.what());
+  } catch(...) {
+    return builtins.attr("RuntimeError")("Unknown exception in asynchronous operation");
+  }
+}
+
+/* Submits an operation to the AsyncRunner and returns an asyncio future of
+ * its result in the running event loop.
+ *
+ * Call with the GIL held from a coroutine or callback of a running event loop.
+ * The operation runs without the GIL and must therefore own copies of its
+ * arguments. Its result is converted to Python and the future completed with
+ * it in the event loop's thread, unless the future was cancelled meanwhile.
+ * Python objects the operation depends on, e.g. the instance whose member it
+ * calls, are kept alive by passing them as keepAlive.
+ */
+template<typename Operation>
+pybind11::object submitAsync(
+  Operation operation,
+  pybind11::object keepAlive = pybind11::none()
+) {
+  pybind11::object loop = pybind11::module::import("asyncio").attr("get_running_loop")();
+  pybind11::object future = loop.attr("create_future")();
+
+  /* The job runs and is destroyed without the GIL, so it holds owned
+   * references that it releases with the GIL held
+   */
+  PyObject* loopPtr = loop.release().ptr();
+  PyObject* futurePtr = future.inc_ref().ptr();
+  PyObject* keepAlivePtr = keepAlive.release().ptr();
+
+  AsyncRunner::instance().submit(
+    [operation, loopPtr, futurePtr, keepAlivePtr]() {
+      using Result = decltype(operation());
+      std::unique_ptr<Result> result;
+      std::exception_ptr exception;
+      try {
+        result = std::make_unique<Result>(operation());
+      } catch(...) {
+        exception = std::current_exception();
+      }
+
+      // Nothing can be completed once the interpreter is finalized
+      if(!Py_IsInitialized()) {
+        return;
+      }
+
+      pybind11::gil_scoped_acquire gil;
+      auto loop = pybind11::reinterpret_steal<pybind11::object>(loopPtr);
+      auto future = pybind11::reinterpret_steal<pybind11::object>(futurePtr);
+      auto keepAlive = pybind11::reinterpret_steal<pybind11::object>(keepAlivePtr);
+
+      pybind11::object value;
+      bool failed = static_cast<bool>(exception);
+      if(!failed) {
+        try {
+          value = pybind11::cast(std::move(*result));
+        } catch(...) {
+          exception = std::current_exception();
+          failed = true;
+        }
+      }
+      if(failed) {
+        value = asyncException(exception);
+      }
+
+      pybind11::cpp_function complete {
+        [](pybind11::object completedFuture, pybind11::object completion, bool completionFailed) {
+          if(completedFuture.attr("done")().cast<bool>()) {
+            return;
+          }
+          completedFuture.attr(completionFailed ? "set_exception" : "set_result")(completion);
+        }
+      };
+
+      try {
+        loop.attr("call_soon_threadsafe")(complete, future, value, failed);
+      } catch(pybind11::error_already_set&) {
+        // The event loop was closed, so nobody awaits the future anymore
+      }
+    }
+  );
+
+  return future;
+}
+
+#endif
@@ -0,0 +1,87 @@
+/*!@file
+ * @copyright This code is licensed under the 3-clause BSD license.
+ *   Copyright ETH Zurich, Laboratory of Physical Chemistry, Reiher Group.
+ *   See LICENSE.txt for details.
+ */
+#include "TypeCasters.h"
+#include "pybind11/eigen.h"
+#include "pybind11/stl.h"
+
+#include "Molassembler/ConformerDeduplicator.h"
+#include "Molassembler/Molecule.h"
+
+void init_conformer_deduplicator(pybind11::module& m) {
+  using namespace Scine::Molassembler;
+
+  pybind11::class_<ConformerDeduplicator> deduplicator(
+    m,
+    "ConformerDeduplicator",
+    R"delim(
+      Rejects conformers of a molecule that are near-duplicates of conformers
+      kept earlier
+
+      Conformers are compared by the symmetry-reduced dihedrals of the bonds a
+      :class:`DirectedConformerGenerator` considers and, if an RMSD threshold
+      is set, by their RMSD after optimal superposition.
+
+      >>> butane = io.experimental.from_smiles("CCCC")
+      >>> deduplicator = ConformerDeduplicator(butane)
+      >>> conformer = dg.generate_conformation(butane, 1010)
+      >>> isinstance(conformer, dg.Error)
+      False
+      >>> deduplicator.add(conformer)
+      True
+      >>> deduplicator.add(conformer)
+      False
+      >>> len(deduplicator)
+      1
+    )delim"
+  );
+
+  deduplicator.def(
+    pybind11::init<const Molecule&, double, double>(),
+    pybind11::arg("molecule"),
+    pybind11::arg("dihedral_threshold") = M_PI / 12,
+    pybind11::arg("rmsd_threshold") = 0.0,
+    R"delim(
+      Prepares to deduplicate conformers of a molecule
+
+      :param molecule: Molecule whose conformers are deduplicated
+      :param dihedral_threshold: Maximal difference of each dihedral between
+        duplicates, in radians
+      :param rmsd_threshold: Maximal RMSD after superposition between
+        duplicates, in bohr. If zero, conformers are compared by dihedrals only.
+    )delim"
+  );
+
+  deduplicator.def(
+    "fingerprint",
+    &ConformerDeduplicator::fingerprint,
+    pybind11::arg("positions"),
+    "Symmetry-reduced dihedrals of the considered bonds in a conformer"
+  );
+
+  deduplicator.def(
+    "add",
+    pybind11::overload_cast<const Scine::Utils::PositionCollection&>(
+      &ConformerDeduplicator::add
+    ),
+    pybind11::arg("positions"),
+    "Keeps a conformer unless it is a duplicate of a kept conformer. Returns whether the conformer is kept."
+  );
+
+  deduplicator.def(
+    "add",
+    pybind11::overload_cast<const std::vector<Scine::Utils::PositionCollection>&>(
+      &ConformerDeduplicator::add
+    ),
+    pybind11::arg("ensemble"),
+    R"delim(
+      Keeps each conformer of an ensemble in sequence unless it is a duplicate
+      of a kept conformer. Comparisons are parallelized. Returns the indices of
+      kept conformers of the ensemble.
+    )delim"
+  );
+
+  deduplicator.def("__len__", &ConformerDeduplicator::size, "Number of kept conformers");
+}
@@ -4,6 +4,7 @@
  *   See LICENSE.txt for details.
  */
 #include "TypeCasters.h"
+#include "Awaitable.h"
 #include "pybind11/eigen.h"
 
 #include "Molassembler/Conformers.h"
@@ -11,6 +12,9 @@
 #include "Molassembler/Temple/Functional.h"
 #include "Molassembler/DistanceGeometry/Error.h"
 
+#include <limits>
+#include <memory>
+
 using namespace Scine;
 using namespace Molassembler;
 
@@ -30,6 +34,37 @@ ConformerVariantType variantCast(outcome::result<Utils::PositionCollection> resu
 
 namespace {
 
+/* Owns the contiguous buffers of an ensemble so that numpy arrays can view
+ * them without copying
+ */
+struct EnsembleBuffers {
+  std::vector<double> positions;
+  std::vector<int> errors;
+};
+
+pybind11::tuple ensembleArrays(
+  std::unique_ptr<EnsembleBuffers> buffers,
+  const std::size_t K,
+  const std::size_t N
+) {
+  EnsembleBuffers* raw = buffers.release();
+  pybind11::capsule owner(raw, [](void* p) {
+    delete reinterpret_cast<EnsembleBuffers*>(p);
+  });
+
+  pybind11::array_t<double> positions(
+    std::vector<std::size_t> {K, N, 3},
+    raw->positions.data(),
+    owner
+  );
+  pybind11::array_t<int> errors(
+    std::vector<std::size_t> {K},
+    raw->errors.data(),
+    owner
+  );
+  return pybind11::make_tuple(positions, errors);
+}
+
 void init_partiality(pybind11::module& dg) {
   pybind11::enum_<DistanceGeometry::Partiality>(
     dg,
@@ -37,7 +72,27 @@ void init_partiality(pybind11::module& dg) {
     "Limit triangle inequality bounds smoothing to a subset of all atoms"
   ).value("FourAtom", DistanceGeometry::Partiality::FourAtom, "Resmooth only after each of the first four atom choices")
     .value("TenPercent", DistanceGeometry::Partiality::TenPercent, "Resmooth for the first 10% of all atoms")
-    .value("All", DistanceGeometry::Partiality::All, "Resmooth after each distance choice");
+    .value("All", DistanceGeometry::Partiality::All, "Resmooth after each distance choice")
+    .value("Adaptive", DistanceGeometry::Partiality::Adaptive, "Choose the number of resmoothed atoms from the outcomes of earlier conformers");
+}
+
+void init_refinement_precision(pybind11::module& dg) {
+  pybind11::enum_<DistanceGeometry::RefinementPrecision>(
+    dg,
+    "RefinementPrecision",
+    "Floating point precision of the refinement stages"
+  ).value("Double", DistanceGeometry::RefinementPrecision::Double, "All refinement stages in double precision")
+    .value("Single", DistanceGeometry::RefinementPrecision::Single, "All refinement stages in single precision")
+    .value("Mixed", DistanceGeometry::RefinementPrecision::Mixed, "Refinement in single precision with a final double precision polishing stage");
+}
+
+void init_refinement_optimizer(pybind11::module& dg) {
+  pybind11::enum_<DistanceGeometry::RefinementOptimizer>(
+    dg,
+    "RefinementOptimizer",
+    "Optimizer of the refinement stages"
+  ).value("Lbfgs", DistanceGeometry::RefinementOptimizer::Lbfgs, "Limited-memory BFGS")
+    .value("TrustRegion", DistanceGeometry::RefinementOptimizer::TrustRegion, "Trust region Newton-Raphson with the Hessian of the refinement error function. Time per iteration grows cubically with the number of atoms");
 }
 
 void init_configuration(pybind11::module& dg) {
@@ -71,6 +126,157 @@ void init_configuration(pybind11::module& dg) {
     "Sets the gradient at which a refinement is considered complete. Defaults to 1e-5."
   );
 
+  configuration.def_readwrite(
+    "refinement_precision",
+    &DistanceGeometry::Configuration::refinementPrecision,
+    "Sets the floating point precision of refinement. Defaults to double precision."
+  );
+
+  configuration.def_readwrite(
+    "refinement_optimizer",
+    &DistanceGeometry::Configuration::refinementOptimizer,
+    R"delim(
+      Sets the optimizer of the refinement stages. Trust region refinement
+      uses the exact curvature of the refinement error function, which may
+      reduce iterations for small molecules, but time per iteration grows
+      cubically with the number of atoms. Batched refinement and the refinement history and
+      preconditioning settings require L-BFGS, the default.
+    )delim"
+  );
+
+  configuration.def_readwrite(
+    "distance_term_skin",
+    &DistanceGeometry::Configuration::distanceTermSkin,
+    R"delim(
+      Sets the skin width in angstrom of sparse distance term evaluation in
+      refinement. If positive, only atom pairs near or outside their distance
+      bounds are evaluated until an atom moves by more than half the skin
+      width. Results are identical to dense evaluation. Defaults to zero,
+      which evaluates all atom pairs.
+    )delim"
+  );
+
+  configuration.def_readwrite(
+    "refinement_history_length",
+    &DistanceGeometry::Configuration::refinementHistoryLength,
+    R"delim(
+      Sets the number of gradient and parameter differences the refinement
+      optimizer keeps to approximate the inverse Hessian. Longer histories may
+      need fewer iterations for large systems at the cost of memory and time
+      per iteration. Defaults to 32.
+    )delim"
+  );
+
+  configuration.def_readwrite(
+    "retain_refinement_history",
+    &DistanceGeometry::Configuration::retainRefinementHistory,
+    R"delim(
+      Carry the refinement optimizer's curvature history from each refinement
+      stage to the next. Defaults to false.
+    )delim"
+  );
+
+  configuration.def_readwrite(
+    "precondition_refinement",
+    &DistanceGeometry::Configuration::preconditionRefinement,
+    R"delim(
+      Precondition refinement per atom with the curvature of its distance
+      terms. May reduce refinement iterations for floppy molecules. Defaults
+      to false.
+    )delim"
+  );
+
+  configuration.def_readwrite(
+    "refinement_batch_size",
+    &DistanceGeometry::Configuration::refinementBatchSize,
+    R"delim(
+      Sets the number of conformers refined together in lock-step, sharing
+      passes over the distance bounds. Applies only if no stereopermutators
+      are randomly assigned for each conformer. Defaults to 1, refining each
+      conformer individually.
+    )delim"
+  );
+
+  configuration.def_readwrite(
+    "defer_hydrogens",
+    &DistanceGeometry::Configuration::deferHydrogens,
+    R"delim(
+      Embed and refine the atoms apart from terminal hydrogens first, then
+      place the terminal hydrogens from local geometry and refine all atoms
+      briefly. Hydrogens in chiral or dihedral constraints are not deferred,
+      and none are if any positions are fixed. Defaults to false.
+    )delim"
+  );
+
+  configuration.def_readwrite(
+    "fragment_size",
+    &DistanceGeometry::Configuration::fragmentSize,
+    R"delim(
+      Sets the number of atoms above which molecules are split along bonds
+      outside of cycles into fragments of up to this many atoms. Fragments
+      are embedded one after another and assembled in a final sparse
+      refinement of all atoms. Defaults to zero, which embeds molecules
+      whole.
+    )delim"
+  );
+
+  configuration.def_readwrite(
+    "trajectory_interval",
+    &DistanceGeometry::Configuration::trajectoryInterval,
+    R"delim(
+      Sets the interval in iterations at which refinement steps are recorded
+      into the trajectory of refinement statistics. Steps are recorded only
+      where refinement statistics are collected. Defaults to zero, which
+      disables recording.
+    )delim"
+  );
+
+  configuration.def_readwrite(
+    "trajectory_capacity",
+    &DistanceGeometry::Configuration::trajectoryCapacity,
+    R"delim(
+      Maximum number of recorded refinement steps per conformer. Once full,
+      each recorded step overwrites the oldest one. Defaults to 64.
+    )delim"
+  );
+
+  configuration.def_readwrite(
+    "trajectory_positions",
+    &DistanceGeometry::Configuration::trajectoryPositions,
+    "Record the positions of each recorded refinement step. Defaults to false."
+  );
+
+  configuration.def_readwrite(
+    "chirality_screening_threshold",
+    &DistanceGeometry::Configuration::chiralityScreeningThreshold,
+    R"delim(
+      Minimum proportion of chiral constraints an embedding must have with
+      correct sign, after inversion if more than half are incorrect, to be
+      refined. Values at or below 0.5 disable screening. Defaults to 0.
+    )delim"
+  );
+
+  configuration.def_readwrite(
+    "chirality_probe_iterations",
+    &DistanceGeometry::Configuration::chiralityProbeIterations,
+    R"delim(
+      Number of chirality inversion refinement iterations after which an
+      embedding is discarded if fewer than chirality_probe_threshold of its
+      chiral constraints have correct sign. Zero disables probing and is the
+      default.
+    )delim"
+  );
+
+  configuration.def_readwrite(
+    "chirality_probe_threshold",
+    &DistanceGeometry::Configuration::chiralityProbeThreshold,
+    R"delim(
+      Minimum proportion of chiral constraints with correct sign after
+      chirality_probe_iterations to continue refining an embedding. Defaults
+      to 0.
+    )delim"
+  );
+
   configuration.def_readwrite(
     "spatial_model_loosening",
     &DistanceGeometry::Configuration::spatialModelLoosening,
@@ -97,6 +303,17 @@ void init_configuration(pybind11::module& dg) {
         "partiality",
         "refinement_step_limit",
         "refinement_gradient_target",
+        "refinement_precision",
+        "distance_term_skin",
+        "refinement_history_length",
+        "retain_refinement_history",
+        "refinement_batch_size",
+        "trajectory_interval",
+        "trajectory_capacity",
+        "trajectory_positions",
+        "chirality_screening_threshold",
+        "chirality_probe_iterations",
+        "chirality_probe_threshold",
         "spatial_model_loosening",
         "fixed_positions"
       };
@@ -114,6 +331,142 @@ void init_configuration(pybind11::module& dg) {
   );
 }
 
+void init_refinement_statistics(pybind11::module& dg) {
+  pybind11::class_<DistanceGeometry::RefinementStageStatistics> stage(
+    dg,
+    "RefinementStageStatistics",
+    "Convergence data of a single refinement stage"
+  );
+  stage.def_readonly(
+    "iterations",
+    &DistanceGeometry::RefinementStageStatistics::iterations,
+    "Number of optimizer iterations, including line search steps"
+  );
+  stage.def_readonly(
+    "evaluations",
+    &DistanceGeometry::RefinementStageStatistics::evaluations,
+    "Number of refinement objective function evaluations"
+  );
+  stage.def_readonly(
+    "gradient_norm",
+    &DistanceGeometry::RefinementStageStatistics::gradientNorm,
+    "Norm of the objective function gradient at the end of the stage"
+  );
+  stage.def_readonly(
+    "seconds",
+    &DistanceGeometry::RefinementStageStatistics::seconds,
+    "Wall time spent in the stage in seconds"
+  );
+
+  pybind11::enum_<DistanceGeometry::RefinementStage>(
+    dg,
+    "RefinementStage",
+    "Refinement stages in order of application"
+  ).value("ChiralityInversion", DistanceGeometry::RefinementStage::ChiralityInversion, "Stage with a free fourth spatial dimension to invert chiral constraints")
+    .value("Compression", DistanceGeometry::RefinementStage::Compression, "Stage compressing out the fourth spatial dimension")
+    .value("Dihedral", DistanceGeometry::RefinementStage::Dihedral, "Final stage including dihedral terms")
+    .value("Polish", DistanceGeometry::RefinementStage::Polish, "Double precision polishing stage of mixed precision refinement");
+
+  pybind11::class_<DistanceGeometry::RefinementFrame> frame(
+    dg,
+    "RefinementFrame",
+    "Recorded step of refinement"
+  );
+  frame.def_readonly(
+    "stage",
+    &DistanceGeometry::RefinementFrame::stage,
+    "Stage the step belongs to"
+  );
+  frame.def_readonly(
+    "iteration",
+    &DistanceGeometry::RefinementFrame::iteration,
+    "Iteration within the stage"
+  );
+  frame.def_readonly(
+    "value",
+    &DistanceGeometry::RefinementFrame::value,
+    "Refinement objective function value"
+  );
+  frame.def_readonly(
+    "gradient_norm",
+    &DistanceGeometry::RefinementFrame::gradientNorm,
+    "Norm of the objective function gradient"
+  );
+  frame.def_readonly(
+    "positions",
+    &DistanceGeometry::RefinementFrame::positions,
+    R"delim(
+      Refinement positions in angstrom, four coordinates per atom. Empty
+      unless :attr:`Configuration.trajectory_positions` is set.
+    )delim"
+  );
+
+  pybind11::class_<DistanceGeometry::RefinementTrajectory> trajectory(
+    dg,
+    "RefinementTrajectory",
+    "Ring buffer of the most recently recorded refinement steps"
+  );
+  trajectory.def_property_readonly(
+    "capacity",
+    &DistanceGeometry::RefinementTrajectory::capacity,
+    "Maximum number of kept steps"
+  );
+  trajectory.def_property_readonly(
+    "recorded",
+    &DistanceGeometry::RefinementTrajectory::recorded,
+    "Number of steps recorded overall, including overwritten ones"
+  );
+  trajectory.def_property_readonly(
+    "frames",
+    &DistanceGeometry::RefinementTrajectory::frames,
+    "Kept steps, oldest first"
+  );
+
+  pybind11::class_<DistanceGeometry::RefinementStatistics> statistics(
+    dg,
+    "RefinementStatistics",
+    R"delim(
+      Refinement convergence data of a single conformer. Stages that were not
+      carried out have zero iterations.
+    )delim"
+  );
+  statistics.def_readonly(
+    "chirality_inversion",
+    &DistanceGeometry::RefinementStatistics::chiralityInversion,
+    "Stage with a free fourth spatial dimension to invert chiral constraints"
+  );
+  statistics.def_readonly(
+    "compression",
+    &DistanceGeometry::RefinementStatistics::compression,
+    "Stage compressing out the fourth spatial dimension"
+  );
+  statistics.def_readonly(
+    "dihedral",
+    &DistanceGeometry::RefinementStatistics::dihedral,
+    "Final stage including dihedral terms"
+  );
+  statistics.def_readonly(
+    "polish",
+    &DistanceGeometry::RefinementStatistics::polish,
+    "Double precision polishing stage of mixed precision refinement"
+  );
+  statistics.def_readonly(
+    "inverted",
+    &DistanceGeometry::RefinementStatistics::inverted,
+    "Whether the embedded structure was inverted before refinement"
+  );
+  statistics.def_readonly(
+    "chiral_flips",
+    &DistanceGeometry::RefinementStatistics::chiralFlips,
+    "Number of chiral constraints with wrong sign that refinement had to invert"
+  );
+  statistics.def_readonly(
+    "trajectory",
+    &DistanceGeometry::RefinementStatistics::trajectory,
+    "Recorded refinement steps, see :attr:`Configuration.trajectory_interval`"
+  );
+}
+
 void init_error(pybind11::module& dg) {
   pybind11::enum_<DgError> error(
     dg,
@@ -251,6 +604,22 @@ void init_error(pybind11::module& dg) {
     DgError::UnknownException,
     "Unknown exception occurred. Please report this as an issue to the developers!"
   );
+
+  error.value(
+    "EmbeddingRejected",
+    DgError::EmbeddingRejected,
+    R"delim(
+      An embedding was discarded before completing refinement since its chiral
+      constraints were unlikely to be corrected. Only occurs if chirality
+      screening or probing is enabled in the configuration.
+    )delim"
+  );
+
+  error.value(
+    "Cancelled",
+    DgError::Cancelled,
+    "Generation was cancelled by the configuration's cancellation token"
+  );
 }
 
 } // namespace
@@ -279,7 +648,10 @@ void init_conformers(pybind11::module& m) {
   )delim";
 
   init_partiality(dg);
+  init_refinement_precision(dg);
+  init_refinement_optimizer(dg);
   init_configuration(dg);
+  init_refinement_statistics(dg);
   init_error(dg);
 
   dg.def(
@@ -351,6 +723,7 @@ void init_conformers(pybind11::module& m) {
     pybind11::arg("num_structures"),
     pybind11::arg("seed"),
     pybind11::arg("configuration") = DistanceGeometry::Configuration {},
+    pybind11::call_guard<pybind11::gil_scoped_release>(),
     R"delim(
       Generate a set of 3D positions for a molecule.
 
@@ -386,6 +759,311 @@ void init_conformers(pybind11::module& m) {
     )delim"
   );
 
+  dg.def(
+    "generate_ensemble_async",
+    [](
+      const Molecule& molecule,
+      const unsigned numStructures,
+      const unsigned seed,
+      const DistanceGeometry::Configuration& config
+    ) -> pybind11::object {
+      return submitAsync(
+        [molecule, numStructures, seed, config]() -> std::vector<ConformerVariantType> {
+          return Temple::map(
+            generateEnsemble(molecule, numStructures, seed, config),
+            variantCast
+          );
+        }
+      );
+    },
+    pybind11::arg("molecule"),
+    pybind11::arg("num_structures"),
+    pybind11::arg("seed"),
+    pybind11::arg("configuration") = DistanceGeometry::Configuration {},
+    R"delim(
+      Generate a set of 3D positions for a molecule without blocking an
+      asyncio event loop.
+
+      Equivalent to :meth:`generate_ensemble`, but returns an awaitable
+      future at once. Generation runs on a background thread without the GIL
+      and completes the future in the event loop. Operations submitted this
+      way run one at a time in submission order, each parallelized like its
+      blocking counterpart.
+
+      Must be called from a coroutine or callback of a running event loop.
+
+      :rtype: ``asyncio.Future`` of a heterogeneous list of either a position
+        result or an error
+
+      >>> import asyncio
+      >>> async def main():
+      ...   butane = io.experimental.from_smiles("CCCC")
+      ...   return await generate_ensemble_async(butane, 10, 1010)
+      >>> results = asyncio.run(main())
+      >>> sum([1 if isinstance(r, Error) else 0 for r in results])
+      0
+    )delim"
+  );
+
+  dg.def(
+    "generate_ensemble_with_statistics",
+    [](
+      const Molecule& molecule,
+      const unsigned numStructures,
+      const unsigned seed,
+      const DistanceGeometry::Configuration& config
+    ) -> std::vector<std::pair<ConformerVariantType, DistanceGeometry::RefinementStatistics>> {
+      return Temple::map(
+        generateEnsembleWithStatistics(molecule, numStructures, seed, config),
+        [](auto&& resultStatisticsPair) {
+          return std::make_pair(
+            variantCast(std::move(resultStatisticsPair.first)),
+            resultStatisticsPair.second
+          );
+        }
+      );
+    },
+    pybind11::arg("molecule"),
+    pybind11::arg("num_structures"),
+    pybind11::arg("seed"),
+    pybind11::arg("configuration") = DistanceGeometry::Configuration {},
+    pybind11::call_guard<pybind11::gil_scoped_release>(),
+    R"delim(
+      Generate a set of 3D positions for a molecule along with refinement
+      convergence data for each.
+
+      Identical to :meth:`generate_ensemble`, except that each list element
+      is a pair of the position result or error and the
+      :class:`RefinementStatistics` of its refinement.
+
+      :param molecule: Molecule to generate positions for. May not contain
+        stereopermutators with zero assignments (no feasible stereopermutations).
+      :param num_structures: Number of desired structures to generate
+      :param seed: Seed for the pseudo-random number generator
+      :param configuration: Detailed Distance Geometry settings. Defaults are
+        usually fine.
+    )delim"
+  );
+
+  dg.def(
+    "generate_ensembles",
+    [](
+      const std::vector<Molecule>& molecules,
+      const std::vector<unsigned>& numStructures,
+      const unsigned seed,
+      const DistanceGeometry::Configuration& config
+    ) -> std::vector<std::vector<ConformerVariantType>> {
+      return Temple::map(
+        generateEnsembles(molecules, numStructures, seed, config),
+        [](auto&& moleculeResults) {
+          return Temple::map(moleculeResults, variantCast);
+        }
+      );
+    },
+    pybind11::arg("molecules"),
+    pybind11::arg("num_structures"),
+    pybind11::arg("seed"),
+    pybind11::arg("configuration") = DistanceGeometry::Configuration {},
+    pybind11::call_guard<pybind11::gil_scoped_release>(),
+    R"delim(
+      Generate sets of 3D positions for multiple molecules at once.
+
+      All conformers of all molecules are distributed over the same threads,
+      which keeps threads busy even if each molecule needs only few
+      conformers.
+
+      .. note::
+         This function is parallelized and will utilize ``OMP_NUM_THREADS``
+         threads. The resulting lists are sequenced and reproducible given the
+         same seed.
+
+      :param molecules: Molecules to generate positions for
+      :param num_structures: Number of desired structures for each molecule
+      :param seed: Seed with which to initialize a PRNG with for the conformer
+        generation procedure.
+      :param configuration: Detailed Distance Geometry settings. Defaults are
+        usually fine.
+      :rtype: For each molecule, a heterogeneous list of either a position
+        result or an error explaining why conformer generation failed.
+
+      >>> molecules = [io.experimental.from_smiles(s) for s in ["CCCC", "CO"]]
+      >>> results = generate_ensembles(molecules, [3, 2], 1010)
+      >>> [len(r) for r in results]
+      [3, 2]
+    )delim"
+  );
+
+  dg.def(
+    "generate_fixed_position_ensembles",
+    [](
+      const Molecule& molecule,
+      const std::vector<DistanceGeometry::Configuration::FixedPositions>& fixedPositionSets,
+      const unsigned numStructures,
+      const unsigned seed,
+      const DistanceGeometry::Configuration& config
+    ) -> std::vector<std::vector<ConformerVariantType>> {
+      return Temple::map(
+        generateFixedPositionEnsembles(molecule, fixedPositionSets, numStructures, seed, config),
+        [](auto&& setResults) {
+          return Temple::map(setResults, variantCast);
+        }
+      );
+    },
+    pybind11::arg("molecule"),
+    pybind11::arg("fixed_position_sets"),
+    pybind11::arg("num_structures"),
+    pybind11::arg("seed"),
+    pybind11::arg("configuration") = DistanceGeometry::Configuration {},
+    pybind11::call_guard<pybind11::gil_scoped_release>(),
+    R"delim(
+      Generate sets of 3D positions for a molecule with each of multiple sets
+      of fixed positions.
+
+      The molecule is modeled once and only the information modeled from the
+      fixed positions is replaced for each set. All conformers for all sets
+      are distributed over the same threads.
+
+      :param molecule: Molecule to generate positions for. May not contain
+        stereopermutators with zero assignments (no feasible stereopermutations).
+      :param fixed_position_sets: Lists of pairs of atom indices and their
+        fixed positions in bohr. Each list must fix the same atoms.
+      :param num_structures: Number of desired structures for each set
+      :param seed: Seed with which to initialize a PRNG with for the conformer
+        generation procedure.
+      :param configuration: Detailed Distance Geometry settings. Its fixed
+        positions are replaced by each set.
+      :rtype: For each set of fixed positions, a heterogeneous list of either
+        a position result or an error explaining why conformer generation
+        failed.
+    )delim"
+  );
+
+  dg.def(
+    "generate_ensemble_array",
+    [](
+      const Molecule& molecule,
+      const unsigned numStructures,
+      const unsigned seed,
+      const DistanceGeometry::Configuration& config
+    ) -> pybind11::tuple {
+      const unsigned N = molecule.graph().N();
+      auto buffers = std::make_unique<EnsembleBuffers>();
+      {
+        pybind11::gil_scoped_release release;
+        auto results = generateEnsemble(molecule, numStructures, seed, config);
+        buffers->positions.assign(
+          numStructures * N * 3,
+          std::numeric_limits<double>::quiet_NaN()
+        );
+        buffers->errors.assign(numStructures, 0);
+        for(unsigned i = 0; i < numStructures; ++i) {
+          if(results[i]) {
+            Eigen::Map<Utils::PositionCollection>(
+              buffers->positions.data() + i * N * 3,
+              N,
+              3
+            ) = results[i].value();
+          } else {
+            buffers->errors[i] = results[i].error().value();
+          }
+        }
+      }
+      return ensembleArrays(std::move(buffers), numStructures, N);
+    },
+    pybind11::arg("molecule"),
+    pybind11::arg("num_structures"),
+    pybind11::arg("seed"),
+    pybind11::arg("configuration") = DistanceGeometry::Configuration {},
+    R"delim(
+      Generate a set of 3D positions for a molecule as contiguous arrays.
+
+      Identical to :meth:`generate_ensemble`, except that the results are
+      returned as a pair of numpy arrays sharing a single buffer instead of a
+      list of separately converted objects.
+
+      .. note::
+         This function is parallelized and will utilize ``OMP_NUM_THREADS``
+         threads. The resulting arrays are sequenced and reproducible given the
+         same seed.
+
+      :param molecule: Molecule to generate positions for. May not contain
+        stereopermutators with zero assignments (no feasible stereopermutations).
+      :param num_structures: Number of desired structures to generate
+      :param seed: Seed for the pseudo-random number generator
+      :param configuration: Detailed Distance Geometry settings. Defaults are
+        usually fine.
+      :rtype: Pair of a float array of shape (num_structures, N, 3) with
+        positions in bohr and an integer array of shape (num_structures,).
+        Error codes are zero for successfully generated conformers and the
+        value of the :class:`Error` explaining the failure otherwise. Positions
+        of failed conformers are NaN.
+
+      >>> butane = io.experimental.from_smiles("CCCC")
+      >>> positions, errors = generate_ensemble_array(butane, 10, 1010)
+      >>> positions.shape
+      (10, 14, 3)
+      >>> int((errors == 0).sum())
+      10
+    )delim"
+  );
+
+  dg.def(
+    "generate_successful_ensemble",
+    [](
+      const Molecule& molecule,
+      const unsigned numSuccesses,
+      const unsigned maxAttempts,
+      const unsigned seed,
+      const DistanceGeometry::Configuration& config
+    ) -> boost::variant<std::vector<Utils::PositionCollection>, DgError> {
+      auto result = generateSuccessfulEnsemble(molecule, numSuccesses, maxAttempts, seed, config);
+      if(result) {
+        return std::move(result.value());
+      }
+
+      if(result.error().category().name() != Detail::DGError_category().name()) {
+        throw std::invalid_argument("Error is not of expected category!");
+      }
+
+      return DgError(result.error().value());
+    },
+    pybind11::arg("molecule"),
+    pybind11::arg("num_successes"),
+    pybind11::arg("max_attempts"),
+    pybind11::arg("seed"),
+    pybind11::arg("configuration") = DistanceGeometry::Configuration {},
+    pybind11::call_guard<pybind11::gil_scoped_release>(),
+    R"delim(
+      Generate a target number of successful 3D structures for a molecule.
+
+      Attempts conformer generation until ``num_successes`` attempts have
+      succeeded or ``max_attempts`` attempts have been made. Threads stop
+      making attempts as soon as the target is reached, so there is no need to
+      re-issue ensemble generation for failed conformers.
+
+      .. note::
+         This function is parallelized and will utilize ``OMP_NUM_THREADS``
+         threads. The resulting list is sequenced and reproducible given the
+         same seed.
+
+      :param molecule: Molecule to generate positions for. May not contain
+        stereopermutators with zero assignments (no feasible stereopermutations).
+      :param num_successes: Number of desired successful structures
+      :param max_attempts: Maximum number of conformer generation attempts
+      :param seed: Seed with which to initialize a PRNG with for the conformer
+        generation procedure.
+      :param configuration: Detailed Distance Geometry settings. Defaults are
+        usually fine.
+      :rtype: List of up to ``num_successes`` position matrices, or an error
+        if the molecule has zero-assignment stereopermutators
+
+      >>> butane = io.experimental.from_smiles("CCCC")
+      >>> conformers = generate_successful_ensemble(butane, 5, 20, 1010)
+      >>> len(conformers)
+      5
+    )delim"
+  );
+
   dg.def(
     "generate_random_conformation",
     [](
@@ -441,6 +1119,7 @@ void init_conformers(pybind11::module& m) {
     pybind11::arg("molecule"),
     pybind11::arg("seed"),
     pybind11::arg("configuration") = DistanceGeometry::Configuration {},
+    pybind11::call_guard<pybind11::gil_scoped_release>(),
     R"delim(
       Generate 3D positions for a molecule.
 
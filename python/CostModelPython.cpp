@@ -0,0 +1,112 @@
+/*!@file
+ * @copyright This code is licensed under the 3-clause BSD license.
+ *   Copyright ETH Zurich, Laboratory of Physical Chemistry, Reiher Group.
+ *   See LICENSE.txt for details.
+ */
+#include "TypeCasters.h"
+#include "pybind11/eigen.h"
+
+#include "Molassembler/CostModel.h"
+#include "Molassembler/Molecule.h"
+
+void init_cost_model(pybind11::module& m) {
+  using namespace Scine::Molassembler;
+
+  pybind11::class_<CostModel> costModel(
+    m,
+    "CostModel",
+    R"delim(
+      Predicts the time and failure rate of conformer generation from cheap
+      molecular features. Times depend on the hardware, so models are
+      calibrated from measurements on the machines jobs are scheduled on.
+    )delim"
+  );
+
+  pybind11::class_<CostModel::Features> features(
+    costModel,
+    "Features",
+    "Cheap molecular features"
+  );
+  features.def(pybind11::init<>());
+  features.def_readwrite("atoms", &CostModel::Features::atoms, "Number of atoms");
+  features.def_readwrite("atom_stereopermutators", &CostModel::Features::atomStereopermutators, "Number of atom stereopermutators");
+  features.def_readwrite("bond_stereopermutators", &CostModel::Features::bondStereopermutators, "Number of bond stereopermutators");
+  features.def_readwrite("cycle_families", &CostModel::Features::cycleFamilies, "Number of unique ring families");
+  features.def_readwrite("rotatable_bonds", &CostModel::Features::rotatableBonds, "Number of rotatable bonds");
+  features.def_readwrite("ideal_ensemble_size", &CostModel::Features::idealEnsembleSize, "Number of conformers of a full directed conformer enumeration");
+
+  pybind11::class_<CostModel::Observation> observation(
+    costModel,
+    "Observation",
+    "Measured expense of conformer generation for a molecule"
+  );
+  observation.def(
+    pybind11::init<CostModel::Features, double, double>(),
+    pybind11::arg("features"),
+    pybind11::arg("seconds_per_conformer"),
+    pybind11::arg("failure_rate")
+  );
+  observation.def_readwrite("features", &CostModel::Observation::features);
+  observation.def_readwrite("seconds_per_conformer", &CostModel::Observation::secondsPerConformer, "Mean wall time per generated or failed conformer in seconds");
+  observation.def_readwrite("failure_rate", &CostModel::Observation::failureRate, "Proportion of conformers that failed to generate");
+
+  pybind11::class_<CostModel::Estimate> estimate(
+    costModel,
+    "Estimate",
+    "Predicted expense of conformer generation for a molecule"
+  );
+  estimate.def_readonly("seconds_per_conformer", &CostModel::Estimate::secondsPerConformer, "Expected wall time per generated or failed conformer in seconds");
+  estimate.def_readonly("failure_rate", &CostModel::Estimate::failureRate, "Expected proportion of conformers that fail to generate");
+  estimate.def_readonly("ideal_ensemble_size", &CostModel::Estimate::idealEnsembleSize, "Number of conformers of a full directed conformer enumeration");
+  estimate.def(
+    "ensemble_seconds",
+    &CostModel::Estimate::ensembleSeconds,
+    pybind11::arg("conformers"),
+    "Expected single-threaded time of generating a number of conformers"
+  );
+  estimate.def(
+    "enumeration_seconds",
+    &CostModel::Estimate::enumerationSeconds,
+    "Expected single-threaded time of enumerating all conformers, retrying failures"
+  );
+
+  costModel.def(
+    pybind11::init<Eigen::VectorXd, Eigen::VectorXd>(),
+    pybind11::arg("time_coefficients"),
+    pybind11::arg("failure_coefficients"),
+    "Constructs a model from its coefficients"
+  );
+
+  costModel.def_static(
+    "features",
+    &CostModel::features,
+    pybind11::arg("molecule"),
+    "Calculates the features of a molecule"
+  );
+
+  costModel.def_static(
+    "calibrate",
+    &CostModel::calibrate,
+    pybind11::arg("observations"),
+    "Fits a model to observations by linear least squares"
+  );
+
+  costModel.def(
+    "predict",
+    &CostModel::predict,
+    pybind11::arg("features"),
+    "Predicts the expense of conformer generation from features"
+  );
+
+  costModel.def_property_readonly(
+    "time_coefficients",
+    &CostModel::timeCoefficients,
+    "Coefficients of the logarithm of the time per conformer"
+  );
+
+  costModel.def_property_readonly(
+    "failure_coefficients",
+    &CostModel::failureCoefficients,
+    "Coefficients of the logit of the failure rate per conformer"
+  );
+}
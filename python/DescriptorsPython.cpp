@@ -0,0 +1,53 @@
+/*!@file
+ * @copyright This code is licensed under the 3-clause BSD license.
+ *   Copyright ETH Zurich, Laboratory of Physical Chemistry, Reiher Group.
+ *   See LICENSE.txt for details.
+ */
+#include "TypeCasters.h"
+#include "pybind11/eigen.h"
+
+#include "Molassembler/Descriptors.h"
+#include "Molassembler/Molecule.h"
+
+void init_descriptors(pybind11::module& m) {
+  using namespace Scine::Molassembler;
+
+  m.def(
+    "num_rotatable_bonds",
+    &numRotatableBonds,
+    pybind11::arg("molecule"),
+    R"delim(
+      Calculates the number of freely rotatable bonds in a molecule. Single
+      bonds between non-terminal atoms without an assigned bond
+      stereopermutator contribute a full rotatable bond if not in a cycle and
+      :math:`\max(0, (S - 3) / S)` for the smallest cycle size :math:`S`
+      otherwise. The sum is rounded.
+    )delim"
+  );
+
+  pybind11::class_<DescriptorColumns> columns(
+    m,
+    "DescriptorColumns",
+    "Graph descriptors of many molecules as arrays with an entry per molecule"
+  );
+  columns.def_readonly("atoms", &DescriptorColumns::atoms, "Number of atoms");
+  columns.def_readonly("heavy_atoms", &DescriptorColumns::heavyAtoms, "Number of atoms that are not hydrogen isotopes");
+  columns.def_readonly("bonds", &DescriptorColumns::bonds, "Number of bonds");
+  columns.def_readonly("rotatable_bonds", &DescriptorColumns::rotatableBonds, "Number of rotatable bonds");
+  columns.def_readonly("cycle_families", &DescriptorColumns::cycleFamilies, "Number of unique ring families");
+  columns.def_readonly("molecular_weights", &DescriptorColumns::molecularWeights, "Sum of standard atomic weights");
+
+  m.def(
+    "descriptors",
+    &descriptors,
+    pybind11::arg("molecules"),
+    pybind11::call_guard<pybind11::gil_scoped_release>(),
+    R"delim(
+      Calculates graph descriptors of many molecules in parallel, in a single
+      pass over each molecule's graph
+
+      :param molecules: Molecules to describe
+      :return: Descriptor columns as numpy arrays
+    )delim"
+  );
+}
@@ -4,6 +4,7 @@
  *   See LICENSE.txt for details.
  */
 #include "TypeCasters.h"
+#include "Awaitable.h"
 #include "pybind11/eigen.h"
 #include "pybind11/functional.h"
 
@@ -11,9 +12,17 @@
 #include "Molassembler/DirectedConformerGenerator.h"
 #include "Molassembler/BondStereopermutator.h"
 #include "Molassembler/DistanceGeometry/Error.h"
+#include "Molassembler/Prng.h"
+#include "Molassembler/Serialization.h"
 
 #include "Utils/Geometry/AtomCollection.h"
 
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
 using namespace Scine::Molassembler;
 
 using ConformerVariantType = boost::variant<
@@ -22,6 +31,105 @@ using ConformerVariantType = boost::variant<
 >;
 extern ConformerVariantType variantCast(outcome::result<Scine::Utils::PositionCollection>);
 
+namespace {
+
+/* Enumerates conformers on a worker thread into a bounded queue, from which
+ * Python consumes them at its own pace. Workers never need the GIL.
+ */
+class ConformerStream {
+public:
+  using Item = std::pair<DirectedConformerGenerator::DecisionList, Scine::Utils::PositionCollection>;
+
+  ConformerStream(
+    DirectedConformerGenerator& generator,
+    const unsigned seed,
+    DirectedConformerGenerator::EnumerationSettings settings,
+    const unsigned capacity
+  ) : capacity_(std::max(capacity, 1u)) {
+    // Pushing into the queue is thread-safe
+    settings.concurrentCallback = true;
+    worker_ = std::thread(
+      [this, &generator, seed, settings]() {
+        std::exception_ptr exception;
+        try {
+          generator.enumerate(
+            [this](const DirectedConformerGenerator::DecisionList& decisionList, Scine::Utils::PositionCollection positions) {
+              push(Item {decisionList, std::move(positions)});
+            },
+            seed,
+            settings
+          );
+        } catch(Cancelled&) {
+        } catch(...) {
+          exception = std::current_exception();
+        }
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        exception_ = exception;
+        done_ = true;
+        notEmpty_.notify_all();
+      }
+    );
+  }
+
+  ConformerStream(const ConformerStream& other) = delete;
+  ConformerStream& operator = (const ConformerStream& other) = delete;
+
+  ~ConformerStream() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      cancelled_ = true;
+    }
+    notFull_.notify_all();
+    pybind11::gil_scoped_release release;
+    worker_.join();
+  }
+
+  //! Blocks until a conformer is available or enumeration is complete
+  boost::optional<Item> next() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    notEmpty_.wait(lock, [this]() { return !queue_.empty() || done_; });
+    if(!queue_.empty()) {
+      Item item = std::move(queue_.front());
+      queue_.pop_front();
+      notFull_.notify_one();
+      return item;
+    }
+
+    if(exception_) {
+      std::rethrow_exception(exception_);
+    }
+
+    return boost::none;
+  }
+
+private:
+  //! Thrown from the enumeration callback to stop an abandoned enumeration
+  struct Cancelled {};
+
+  void push(Item item) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    notFull_.wait(lock, [this]() { return queue_.size() < capacity_ || cancelled_; });
+    if(cancelled_) {
+      throw Cancelled {};
+    }
+    queue_.push_back(std::move(item));
+    notEmpty_.notify_one();
+  }
+
+  const unsigned capacity_;
+  std::mutex mutex_;
+  std::condition_variable notEmpty_;
+  std::condition_variable notFull_;
+  std::deque<Item> queue_;
+  bool done_ = false;
+  bool cancelled_ = false;
+  std::exception_ptr exception_;
+  std::thread worker_;
+};
+
+} // namespace
+
 void init_directed_conformer_generator(pybind11::module& m) {
   pybind11::class_<DirectedConformerGenerator> dirConfGen(
     m,
@@ -152,6 +260,38 @@ void init_directed_conformer_generator(pybind11::module& m) {
     )delim"
   );
 
+  dirConfGen.def(
+    "set_decision_costs",
+    pybind11::overload_cast<const std::vector<std::vector<double>>&>(
+      &DirectedConformerGenerator::setDecisionCosts
+    ),
+    pybind11::arg("costs"),
+    R"delim(
+      Generate decision lists best-first by a sum of assignment costs.
+      Subsequent calls to :meth:`generate_decision_list` yield decision lists
+      in order of nondecreasing total cost instead of choosing them randomly.
+
+      :param costs: Costs indexed by bond in :attr:`bond_list`, then by
+        assignment. Lower costs are preferred. An empty list restores random
+        decision list generation.
+    )delim"
+  );
+
+  dirConfGen.def(
+    "set_decision_costs",
+    pybind11::overload_cast<const DirectedConformerGenerator::AssignmentCost&>(
+      &DirectedConformerGenerator::setDecisionCosts
+    ),
+    pybind11::arg("cost"),
+    R"delim(
+      Generate decision lists best-first by a sum of assignment costs.
+
+      :param cost: Callable evaluated once with each bond index in
+        :attr:`bond_list` and each of its assignments, yielding a cost. Lower
+        costs are preferred.
+    )delim"
+  );
+
   dirConfGen.def(
     "insert",
     &DirectedConformerGenerator::insert,
@@ -174,6 +314,63 @@ void init_directed_conformer_generator(pybind11::module& m) {
     )delim"
   );
 
+  dirConfGen.def(
+    "checkpoint",
+    [](const DirectedConformerGenerator& cg, const std::string& filename) {
+      cg.checkpoint(filename);
+    },
+    pybind11::arg("filename"),
+    R"delim(
+      Writes the generator state to a compact binary checkpoint file: the
+      alignment, the relevant bonds, the underlying set of decision lists and
+      the state of ``molassembler``'s global PRNG.
+
+      :param filename: Path of the checkpoint file
+    )delim"
+  );
+
+  dirConfGen.def(
+    "resume",
+    [](DirectedConformerGenerator& cg, const std::string& filename) {
+      cg.resume(filename);
+    },
+    pybind11::arg("filename"),
+    R"delim(
+      Restores the underlying set of decision lists and the state of
+      ``molassembler``'s global PRNG from a checkpoint file written by
+      :meth:`checkpoint` for the same molecule and alignment.
+
+      :param filename: Path of the checkpoint file
+    )delim"
+  );
+
+  dirConfGen.def(
+    "merge",
+    &DirectedConformerGenerator::merge,
+    pybind11::arg("filename"),
+    R"delim(
+      Adds the decision lists of a checkpoint file to the underlying set, e.g.
+      to combine the results of enumerations of separate shards. Returns the
+      number of decision lists that were not yet part of the set.
+
+      :param filename: Path of a checkpoint file written by :meth:`checkpoint`
+    )delim"
+  );
+
+  dirConfGen.def(
+    "shard_range",
+    &DirectedConformerGenerator::shardRange,
+    pybind11::arg("count"),
+    pybind11::arg("index"),
+    R"delim(
+      Half-open range of decision list indices enumerated by a shard. Shards
+      are contiguous, disjoint and cover the decision list space.
+
+      :param count: Number of shards
+      :param index: Index of the shard
+    )delim"
+  );
+
   dirConfGen.def_property_readonly(
     "bond_list",
     &DirectedConformerGenerator::bondList,
@@ -239,6 +436,7 @@ void init_directed_conformer_generator(pybind11::module& m) {
     pybind11::arg("decision_list"),
     pybind11::arg("seed"),
     pybind11::arg("configuration") = DistanceGeometry::Configuration {},
+    pybind11::call_guard<pybind11::gil_scoped_release>(),
     R"delim(
       Try to generate a conformer for a particular decision list.
 
@@ -250,6 +448,79 @@ void init_directed_conformer_generator(pybind11::module& m) {
     )delim"
   );
 
+  dirConfGen.def(
+    "generate_conformation_async",
+    [](
+      pybind11::object self,
+      const DirectedConformerGenerator::DecisionList& decisionList,
+      const unsigned seed,
+      const DistanceGeometry::Configuration& configuration
+    ) -> pybind11::object {
+      const DirectedConformerGenerator* generator = self.cast<const DirectedConformerGenerator*>();
+      return submitAsync(
+        [generator, decisionList, seed, configuration]() -> ConformerVariantType {
+          return variantCast(
+            generator->generateConformation(decisionList, seed, configuration)
+          );
+        },
+        self
+      );
+    },
+    pybind11::arg("decision_list"),
+    pybind11::arg("seed"),
+    pybind11::arg("configuration") = DistanceGeometry::Configuration {},
+    R"delim(
+      Try to generate a conformer for a particular decision list without
+      blocking an asyncio event loop.
+
+      Equivalent to :meth:`generate_conformation`, but returns an awaitable
+      future at once. Generation runs on a background thread without the GIL
+      and completes the future in the event loop. Operations submitted this
+      way run one at a time in submission order. Do not modify the generator
+      until the future is done.
+
+      Must be called from a coroutine or callback of a running event loop.
+
+      :param decision_list: Decision list to use in conformer generation
+      :param seed: Seed to initialize a PRNG with for use in conformer
+        generation.
+      :param configuration: Distance geometry configurations object. Defaults
+        are usually fine.
+      :rtype: ``asyncio.Future`` of either a position result or an error
+    )delim"
+  );
+
+  dirConfGen.def(
+    "generate_conformation_from",
+    [](
+      DirectedConformerGenerator& generator,
+      const Scine::Utils::PositionCollection& reference,
+      const DirectedConformerGenerator::DecisionList& decisionList,
+      const unsigned seed,
+      const DistanceGeometry::Configuration& configuration
+    ) -> ConformerVariantType {
+      return variantCast(
+        generator.generateConformationFrom(reference, decisionList, seed, configuration)
+      );
+    },
+    pybind11::arg("reference"),
+    pybind11::arg("decision_list"),
+    pybind11::arg("seed"),
+    pybind11::arg("configuration") = DistanceGeometry::Configuration {},
+    R"delim(
+      Generate a conformer for a decision list by rigidly rotating a reference
+      structure about the considered bonds and refining the result. Falls back
+      to full conformer generation if the rotated structure clashes or cannot
+      be refined to the decision list.
+
+      :param reference: Positions of a conformer of the molecule in bohr
+      :param decision_list: Decision list to use in conformer generation
+      :param seed: Seed for the full conformer generation fallback
+      :param configuration: Distance geometry configurations object. Defaults
+        are usually fine.
+    )delim"
+  );
+
   dirConfGen.def(
     "conformation_molecule",
     &DirectedConformerGenerator::conformationMolecule,
@@ -323,6 +594,36 @@ void init_directed_conformer_generator(pybind11::module& m) {
     )delim"
   );
 
+  dirConfGen.def(
+    "get_decision_lists",
+    [](
+      const DirectedConformerGenerator& generator,
+      pybind11::array_t<double, pybind11::array::c_style | pybind11::array::forcecast> frames,
+      const BondStereopermutator::FittingMode mode
+    ) {
+      if(frames.ndim() != 3 || frames.shape(2) != 3) {
+        throw std::invalid_argument("Expected an array of shape (frames, atoms, 3)");
+      }
+
+      const Eigen::Map<
+        const Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>
+      > buffer(frames.data(), frames.shape(0), 3 * frames.shape(1));
+      return generator.getDecisionLists(buffer, mode);
+    },
+    pybind11::arg("frames"),
+    pybind11::arg("fitting_mode") = BondStereopermutator::FittingMode::Thresholded,
+    R"delim(
+      Infer decision lists for the relevant bonds from many structures at once
+
+      Yields the same decision list for each frame as
+      :meth:`get_decision_list`. Fitting setup is shared between frames, which
+      are fitted in parallel.
+
+      :param frames: Array of shape (frames, atoms, 3) of positions in bohr
+      :param fitting_mode: Mode altering how decisions are fitted.
+    )delim"
+  );
+
   dirConfGen.def_property_readonly_static(
     "UNKNOWN_DECISION",
     [](pybind11::object /* self */) {
@@ -365,13 +666,48 @@ void init_directed_conformer_generator(pybind11::module& m) {
     "Configuration for conformer generation scheme"
   );
 
+  enumerationSettings.def_readwrite(
+    "concurrent_callback",
+    &DirectedConformerGenerator::EnumerationSettings::concurrentCallback,
+    "Whether the callback may be invoked simultaneously from multiple threads"
+  );
+
+  enumerationSettings.def_readwrite(
+    "ordered_callback",
+    &DirectedConformerGenerator::EnumerationSettings::orderedCallback,
+    "Whether the callback is invoked in an order independent of the number of threads"
+  );
+
+  enumerationSettings.def_readwrite(
+    "skip_contained",
+    &DirectedConformerGenerator::EnumerationSettings::skipContained,
+    "Whether to resume an enumeration, skipping decision lists already in the underlying set"
+  );
+
+  enumerationSettings.def_readwrite(
+    "shard_count",
+    &DirectedConformerGenerator::EnumerationSettings::shardCount,
+    "Number of disjoint shards the decision list space is split into for independent enumerations"
+  );
+
+  enumerationSettings.def_readwrite(
+    "shard_index",
+    &DirectedConformerGenerator::EnumerationSettings::shardIndex,
+    "Index of the shard to enumerate"
+  );
+
   enumerationSettings.def(
     "__repr__",
     [](pybind11::object settings) -> std::string {
       const std::vector<std::string> members {
         "dihedral_retries",
         "fitting",
-        "configuration"
+        "configuration",
+        "concurrent_callback",
+        "ordered_callback",
+        "skip_contained",
+        "shard_count",
+        "shard_index"
       };
 
       std::string repr = "(";
@@ -401,8 +737,9 @@ void init_directed_conformer_generator(pybind11::module& m) {
 
       .. note::
          This function is parallelized and will utilize ``OMP_NUM_THREADS``
-         threads. Callback invocations are unsequenced but the arguments are
-         reproducible.
+         threads. Callback invocations are unsequenced unless
+         ``ordered_callback`` is set in the settings, but the arguments are
+         reproducible independent of the number of threads.
 
       :param callback: Function called with decision list and conformer
         positions for each successfully generated pair.
@@ -412,6 +749,76 @@ void init_directed_conformer_generator(pybind11::module& m) {
     )delim"
   );
 
+  pybind11::class_<ConformerStream> stream(
+    dirConfGen,
+    "ConformerStream",
+    R"delim(
+      Iterator over enumerated conformers
+
+      Yields pairs of decision list and conformer positions. Conformers are
+      generated in the background into a bounded queue. Generation pauses while
+      the queue is full and stops early if the iterator is discarded.
+    )delim"
+  );
+
+  stream.def(
+    "__iter__",
+    [](ConformerStream& s) -> ConformerStream& { return s; }
+  );
+
+  stream.def(
+    "__next__",
+    [](ConformerStream& s) -> ConformerStream::Item {
+      boost::optional<ConformerStream::Item> item;
+      {
+        pybind11::gil_scoped_release release;
+        item = s.next();
+      }
+      if(!item) {
+        throw pybind11::stop_iteration();
+      }
+      return std::move(item.value());
+    }
+  );
+
+  dirConfGen.def(
+    "enumerate_stream",
+    [](
+      DirectedConformerGenerator& generator,
+      const unsigned seed,
+      const DirectedConformerGenerator::EnumerationSettings& settings,
+      const unsigned capacity
+    ) {
+      return std::make_unique<ConformerStream>(generator, seed, settings, capacity);
+    },
+    pybind11::arg("seed"),
+    pybind11::arg("settings") = DirectedConformerGenerator::EnumerationSettings {},
+    pybind11::arg("capacity") = 64,
+    pybind11::keep_alive<0, 1>(),
+    R"delim(
+      Enumerate all conformers of the captured molecule as an iterator
+
+      Identical to :meth:`enumerate`, except that conformers are yielded by
+      an iterator instead of passed to a callback. Worker threads place
+      conformers into a queue of bounded size without acquiring the GIL. The
+      generator must not be used otherwise until the iterator is exhausted or
+      discarded.
+
+      :param seed: Randomness initiator for decision list and conformer
+        generation
+      :param settings: Further parameters for enumeration algorithms.
+        Ordered enumeration is respected.
+      :param capacity: Maximum number of generated conformers held in the
+        queue
+
+      >>> mol = io.experimental.from_smiles("CCCC")
+      >>> generator = DirectedConformerGenerator(mol)
+      >>> conformers = list(generator.enumerate_stream(seed=1010))
+      >>> len(conformers) <= generator.ideal_ensemble_size()
+      True
+    )delim"
+  );
+
   dirConfGen.def(
     "enumerate_random",
     &DirectedConformerGenerator::enumerateRandom,
@@ -438,6 +845,45 @@ void init_directed_conformer_generator(pybind11::module& m) {
     )delim"
   );
 
+  /* Pickling support (allows passing generators between processes). The
+   * molecule is stored in the compact binary format and the set of decision
+   * lists as an in-memory checkpoint. Decision costs are not stored.
+   */
+  dirConfGen.def(
+    pybind11::pickle(
+      [](const DirectedConformerGenerator& generator) {
+        const auto binary = CompactSerialization::serialize(generator.molecule());
+        return pybind11::make_tuple(
+          pybind11::bytes(reinterpret_cast<const char*>(binary.data()), binary.size()),
+          generator.alignment(),
+          generator.bondList(),
+          pybind11::bytes(generator.checkpointBytes())
+        );
+      },
+      [](const pybind11::tuple& state) {
+        if(state.size() != 4) {
+          throw std::runtime_error("Invalid DirectedConformerGenerator state");
+        }
+
+        const std::string binary = state[0].cast<pybind11::bytes>();
+        DirectedConformerGenerator generator {
+          CompactSerialization::deserialize(
+            reinterpret_cast<const std::uint8_t*>(binary.data()),
+            binary.size(),
+            CompactSerialization::Validation::Checksum
+          ),
+          state[1].cast<BondStereopermutator::Alignment>(),
+          state[2].cast<DirectedConformerGenerator::BondList>()
+        };
+
+        // Leave the global PRNG state untouched
+        Random::Engine engine;
+        generator.resumeFromBytes(state[3].cast<pybind11::bytes>(), engine);
+        return generator;
+      }
+    )
+  );
+
   dirConfGen.def(
     "relabeler",
     &DirectedConformerGenerator::relabeler,
@@ -515,9 +961,66 @@ void init_directed_conformer_generator(pybind11::module& m) {
     "Add a particular position to the set to relabel"
   );
 
+  relabeler.def(
+    "add_frames",
+    [
+      DirectedConformerGenerator::Relabeler& relabeler,
+      pybind11::array_t<double, pybind11::array::c_style | pybind11::array::forcecast> frames
+    ) {
+      if(frames.ndim() != 3 || frames.shape(2) != 3) {
+        throw std::invalid_argument("Expected an array of shape (frames, atoms, 3)");
+      }
+
+      const Eigen::Map<
+        const Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>
+      > buffer(frames.data(), frames.shape(0), 3 * frames.shape(1));
+      relabeler.addFrames(buffer);
+    },
+    pybind11::arg("frames"),
+    R"delim(
+      Add many frames to the set to relabel at once
+
+      Dihedrals are calculated in parallel across frames.
+
+      :param frames: Array of shape (frames, atoms, 3) of positions
+    )delim"
+  );
+
+  relabeler.def(
+    "accumulate",
+    &DirectedConformerGenerator::Relabeler::accumulate,
+    pybind11::arg("positions"),
+    R"delim(
+      Add a particular position to the dihedral histograms only
+
+      Memory does not grow with the number of accumulated structures. Bins
+      for accumulated structures are generated with histogram_bins.
+    )delim"
+  );
+
+  relabeler.def(
+    "histogram_bins",
+    &DirectedConformerGenerator::Relabeler::histogramBins,
+    pybind11::arg("delta") = M_PI / 6,
+    R"delim(
+      Generate bins for all accumulated dihedrals
+
+      Yields the same bins as bins would for the same structures.
+
+      :param delta: Maximum dihedral distance between dihedral values to
+        include in the same bin in radians. Must be at least the width of a
+        histogram cell.
+    )delim"
+  );
+
   relabeler.def(
     "bin_indices",
-    &DirectedConformerGenerator::Relabeler::binIndices,
+    pybind11::overload_cast<
+      const std::vector<DirectedConformerGenerator::Relabeler::Intervals>&
+    >(
+      &DirectedConformerGenerator::Relabeler::binIndices,
+      pybind11::const_
+    ),
     pybind11::arg("bins"),
     R"delim(
       Determine relabeling for all added positions
@@ -529,6 +1032,43 @@ void init_directed_conformer_generator(pybind11::module& m) {
     )delim"
   );
 
+  relabeler.def(
+    "bin_indices",
+    [](
+      const DirectedConformerGenerator::Relabeler& relabeler,
+      const std::vector<DirectedConformerGenerator::Relabeler::Intervals>& bins,
+      const std::function<boost::optional<Utils::PositionCollection>()>& reader,
+      const unsigned chunkSize
+    ) {
+      return relabeler.binIndices(
+        bins,
+        [&](Utils::PositionCollection& positions) -> bool {
+          auto frame = reader();
+          if(!frame) {
+            return false;
+          }
+          positions = std::move(frame.value());
+          return true;
+        },
+        chunkSize
+      );
+    },
+    pybind11::arg("bins"),
+    pybind11::arg("reader"),
+    pybind11::arg("chunk_size") = 1024,
+    R"delim(
+      Determine relabeling of a sequence of structures read in chunks
+
+      Frames are read sequentially from the reader in chunks, and each chunk
+      is relabeled in parallel. Use after accumulating the same structures.
+
+      :param bins: Bin intervals for all observed bonds (see histogram_bins)
+      :param reader: Callable returning the next frame's positions, or None
+        if there are no further frames
+      :param chunk_size: Number of frames kept in memory
+    )delim"
+  );
+
   relabeler.def(
     "bin_midpoint_integers",
     &DirectedConformerGenerator::Relabeler::binMidpointIntegers,
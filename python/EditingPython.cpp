@@ -6,6 +6,7 @@
 #include "TypeCasters.h"
 
 #include "Molassembler/Editing.h"
+#include "Molassembler/Graph.h"
 #include "Molassembler/Molecule.h"
 
 void init_editing(pybind11::module& m) {
@@ -23,6 +24,7 @@ void init_editing(pybind11::module& m) {
     &Editing::cleave,
     pybind11::arg("molecule"),
     pybind11::arg("bridge"),
+    pybind11::call_guard<pybind11::gil_scoped_release>(),
     R"delim(
       Cleave a molecule in two along a bridge bond.
 
@@ -50,6 +52,7 @@ void init_editing(pybind11::module& m) {
     pybind11::arg("log_bond"),
     pybind11::arg("first_wedge_atom"),
     pybind11::arg("second_wedge_atom"),
+    pybind11::call_guard<pybind11::gil_scoped_release>(),
     R"delim(
       Insert a molecule into a bond of another molecule. Splits ``log`` at
       ``log_bond``, then inserts ``wedge`` at the split atoms, connecting the
@@ -77,6 +80,7 @@ void init_editing(pybind11::module& m) {
     pybind11::arg("bottom"),
     pybind11::arg("top_overlay_atom"),
     pybind11::arg("bottom_overlay_atom"),
+    pybind11::call_guard<pybind11::gil_scoped_release>(),
     R"delim(
       Fuse two molecules, adding all adjacencies of one Molecule's atoms to
       another
@@ -96,11 +100,12 @@ void init_editing(pybind11::module& m) {
 
   editing.def(
     "substitute",
-    &Editing::substitute,
+    pybind11::overload_cast<const Molecule&, const Molecule&, BondIndex, BondIndex>(&Editing::substitute),
     pybind11::arg("left"),
     pybind11::arg("right"),
     pybind11::arg("left_bridge"),
     pybind11::arg("right_bridge"),
+    pybind11::call_guard<pybind11::gil_scoped_release>(),
     R"delim(
       Connect two molecules by substituting away the lighter side of a pair of
       bonds of separate molecules.
@@ -120,12 +125,13 @@ void init_editing(pybind11::module& m) {
 
   editing.def(
     "connect",
-    &Editing::connect,
+    pybind11::overload_cast<Molecule, const Molecule&, AtomIndex, AtomIndex, BondType>(&Editing::connect),
     pybind11::arg("left"),
     pybind11::arg("right"),
     pybind11::arg("left_atom"),
     pybind11::arg("right_atom"),
     pybind11::arg("bond_type"),
+    pybind11::call_guard<pybind11::gil_scoped_release>(),
     R"delim(
       Connect two molecules by creating a new bond between two atoms from
       separate molecules
@@ -139,6 +145,60 @@ void init_editing(pybind11::module& m) {
     )delim"
   );
 
+  editing.def(
+    "substitute",
+    pybind11::overload_cast<
+      const Molecule&,
+      BondIndex,
+      const std::vector<Molecule>&,
+      const std::vector<BondIndex>&
+    >(&Editing::substitute),
+    pybind11::arg("core"),
+    pybind11::arg("core_bridge"),
+    pybind11::arg("fragments"),
+    pybind11::arg("fragment_bridges"),
+    pybind11::call_guard<pybind11::gil_scoped_release>(),
+    R"delim(
+      Substitutes many fragments onto a core in parallel. The heavier side of
+      the core's bridge is determined only once.
+
+      :param core: The molecule common to all products
+      :param core_bridge: Core's bridge bond from which to substitute the
+        lighter part away
+      :param fragments: The molecules to substitute onto the core
+      :param fragment_bridges: For each fragment, the bridge bond from which
+        to substitute the lighter part away
+      :return: For each fragment, the substitution product
+    )delim"
+  );
+
+  editing.def(
+    "connect",
+    pybind11::overload_cast<
+      const Molecule&,
+      AtomIndex,
+      const std::vector<Molecule>&,
+      const std::vector<AtomIndex>&,
+      BondType
+    >(&Editing::connect),
+    pybind11::arg("core"),
+    pybind11::arg("core_atom"),
+    pybind11::arg("fragments"),
+    pybind11::arg("fragment_atoms"),
+    pybind11::arg("bond_type"),
+    pybind11::call_guard<pybind11::gil_scoped_release>(),
+    R"delim(
+      Connects many fragments to a core in parallel
+
+      :param core: The molecule common to all products
+      :param core_atom: The atom from ``core`` to connect
+      :param fragments: The molecules to connect to the core
+      :param fragment_atoms: For each fragment, the atom to connect
+      :param bond_type: The bond type of the new bonds
+      :return: For each fragment, the connected molecule
+    )delim"
+  );
+
   editing.def(
     "add_ligand",
     &Editing::addLigand,
@@ -146,6 +206,7 @@ void init_editing(pybind11::module& m) {
     pybind11::arg("ligand"),
     pybind11::arg("complexating_atom"),
     pybind11::arg("ligand_binding_atoms"),
+    pybind11::call_guard<pybind11::gil_scoped_release>(),
     R"delim(
       Connect two molecules by connecting multiple atoms from one to a single
       atom of the other via single bonds.
@@ -157,4 +218,117 @@ void init_editing(pybind11::module& m) {
         ``complexating_atom`` to.
     )delim"
   );
+
+  editing.def(
+    "add_ligands",
+    &Editing::addLigands,
+    pybind11::arg("a"),
+    pybind11::arg("ligands"),
+    pybind11::arg("complexating_atom"),
+    pybind11::arg("ligand_binding_atoms"),
+    pybind11::call_guard<pybind11::gil_scoped_release>(),
+    R"delim(
+      Connect many ligands to a single atom of a molecule at once. The shape of
+      the complexating atom is inferred only for its final coordination
+      environment.
+
+      :param a: The molecule the ligands are being connected to
+      :param ligands: The ligand molecules being bound
+      :param complexating_atom: The atom in ``a`` to bind ligands to
+      :param ligand_binding_atoms: For each ligand, the atoms to bind to
+        ``complexating_atom``
+    )delim"
+  );
+
+  pybind11::class_<Editing::Product> product(
+    editing,
+    "Product",
+    R"delim(
+      Deferred product of substituting or connecting a core and a fragment
+      from separate lists of molecules. Products hold only indices into the
+      lists, so that combinatorial enumerations can be filtered on the
+      products' graphs before any stereopermutators are constructed.
+    )delim"
+  );
+
+  pybind11::enum_<Editing::Product::Operation> operation(
+    product,
+    "Operation",
+    "Editing operation combining core and fragment"
+  );
+  operation.value(
+    "Substitute",
+    Editing::Product::Operation::Substitute,
+    "As :meth:`substitute`, from core_bond and fragment_bond"
+  );
+  operation.value(
+    "Connect",
+    Editing::Product::Operation::Connect,
+    "As :meth:`connect`, at core_atom and fragment_atom with bond_type"
+  );
+
+  product.def_static(
+    "substitution",
+    &Editing::Product::substitution,
+    pybind11::arg("core"),
+    pybind11::arg("core_bond"),
+    pybind11::arg("fragment"),
+    pybind11::arg("fragment_bond"),
+    "Deferred substitution of fragments[fragment] onto cores[core]"
+  );
+
+  product.def_static(
+    "connection",
+    &Editing::Product::connection,
+    pybind11::arg("core"),
+    pybind11::arg("core_atom"),
+    pybind11::arg("fragment"),
+    pybind11::arg("fragment_atom"),
+    pybind11::arg("bond_type"),
+    "Deferred connection of fragments[fragment] to cores[core]"
+  );
+
+  product.def(
+    "graph",
+    &Editing::Product::graph,
+    pybind11::arg("cores"),
+    pybind11::arg("fragments"),
+    pybind11::call_guard<pybind11::gil_scoped_release>(),
+    "Graph of the product, constructed without stereopermutators"
+  );
+
+  product.def(
+    "materialize",
+    &Editing::Product::materialize,
+    pybind11::arg("cores"),
+    pybind11::arg("fragments"),
+    pybind11::call_guard<pybind11::gil_scoped_release>(),
+    "Constructs the product molecule"
+  );
+
+  product.def_readonly("operation", &Editing::Product::operation, "Editing operation");
+  product.def_readonly("core", &Editing::Product::core, "Index of the core molecule");
+  product.def_readonly("fragment", &Editing::Product::fragment, "Index of the fragment molecule");
+  product.def_readonly("core_bond", &Editing::Product::coreBond, "Core bond substituted from");
+  product.def_readonly("fragment_bond", &Editing::Product::fragmentBond, "Fragment bond substituted from");
+  product.def_readonly("core_atom", &Editing::Product::coreAtom, "Core atom connected");
+  product.def_readonly("fragment_atom", &Editing::Product::fragmentAtom, "Fragment atom connected");
+  product.def_readonly("bond_type", &Editing::Product::bondType, "Type of the new bond of connections");
+
+  editing.def(
+    "materialize",
+    &Editing::materialize,
+    pybind11::arg("products"),
+    pybind11::arg("cores"),
+    pybind11::arg("fragments"),
+    pybind11::call_guard<pybind11::gil_scoped_release>(),
+    R"delim(
+      Constructs the molecules of many deferred products in parallel
+
+      :param products: Deferred products to construct
+      :param cores: Core molecules indexed by the products
+      :param fragments: Fragment molecules indexed by the products
+      :return: For each product, its molecule
+    )delim"
+  );
 }
@@ -9,6 +9,8 @@
 #include "Molassembler/Cycles.h"
 #include "Molassembler/Graph.h"
 #include "Molassembler/GraphAlgorithms.h"
+#include "Molassembler/Molecule.h"
+#include "Molassembler/Serialization.h"
 #include "Molassembler/Graph/GraphAlgorithms.h"
 
 #include "Utils/Bonds/BondOrderCollection.h"
@@ -417,4 +419,27 @@ void init_graph(pybind11::module& m) {
       Sites consisting of multiple atoms are haptic.
     )delim"
   );
+
+  /* Pickling support in the compact binary format of a molecule with the
+   * graph's constitution
+   */
+  graphClass.def(
+    pybind11::pickle(
+      [](const Graph& graph) {
+        const auto binary = CompactSerialization::serialize(Molecule {graph});
+        return pybind11::bytes(
+          reinterpret_cast<const char*>(binary.data()),
+          binary.size()
+        );
+      },
+      [](const pybind11::bytes& bytes) {
+        const std::string binary = bytes;
+        return CompactSerialization::deserialize(
+          reinterpret_cast<const std::uint8_t*>(binary.data()),
+          binary.size(),
+          CompactSerialization::Validation::Checksum
+        ).graph();
+      }
+    )
+  );
 }
@@ -5,8 +5,10 @@
  */
 #include "TypeCasters.h"
 #include "pybind11/eigen.h"
+#include "pybind11/functional.h"
 
 #include "Molassembler/IO.h"
+#include "Molassembler/IO/SmilesEmitter.h"
 #include "Molassembler/IO/SmilesParser.h"
 #include "Molassembler/Molecule.h"
 
@@ -26,6 +28,7 @@ void init_io(pybind11::module& m) {
     "from_smiles_multiple",
     &IO::Experimental::parseSmiles,
     pybind11::arg("smiles_str"),
+    pybind11::call_guard<pybind11::gil_scoped_release>(),
     R"delim(
       Parse a smiles string containing possibly multiple molecules
 
@@ -56,6 +59,7 @@ void init_io(pybind11::module& m) {
     "from_smiles",
     &IO::Experimental::parseSmilesSingleMolecule,
     pybind11::arg("smiles_str"),
+    pybind11::call_guard<pybind11::gil_scoped_release>(),
     R"delim(
       Parse a smiles string containing only a single molecule
 
@@ -90,6 +94,113 @@ void init_io(pybind11::module& m) {
     )delim"
   );
 
+  experimental.def(
+    "from_smiles_many",
+    &IO::Experimental::parseSmilesSingleMolecules,
+    pybind11::arg("smiles_list"),
+    pybind11::call_guard<pybind11::gil_scoped_release>(),
+    R"delim(
+      Parse many smiles strings each containing only a single molecule in
+      parallel. Equivalent to calling :meth:`from_smiles` on each string.
+
+      :param smiles_list: Smiles strings each containing a single molecule
+      :rtype: List of molecules, in input order
+
+      >>> molecules = from_smiles_many(["C", "CC", "CCC"])
+      >>> [m.graph.N for m in molecules]
+      [5, 8, 11]
+    )delim"
+  );
+
+  experimental.def(
+    "from_smiles_constitution",
+    &IO::Experimental::parseSmilesConstitution,
+    pybind11::arg("smiles_str"),
+    pybind11::call_guard<pybind11::gil_scoped_release>(),
+    R"delim(
+      Parse only the constitution of the molecules in a smiles string
+
+      Skips ranking and stereopermutator instantiation of molecule
+      construction. Stereo markers are accepted, but ignored.
+
+      :param smiles_str: A smiles string containing possibly multiple molecules
+      :rtype: List[scine_molassembler.Graph]
+
+      >>> graphs = from_smiles_constitution("CCO.[NH4+]")
+      >>> [g.N for g in graphs]
+      [9, 5]
+    )delim"
+  );
+
+  pybind11::class_<IO::Experimental::SmilesFileLine> smilesFileLine(
+    experimental,
+    "SmilesFileLine",
+    "Parse result of a line of a SMILES file"
+  );
+  smilesFileLine.def_readonly(
+    "line_number",
+    &IO::Experimental::SmilesFileLine::lineNumber,
+    "One-based line number in the file"
+  );
+  smilesFileLine.def_readonly(
+    "title",
+    &IO::Experimental::SmilesFileLine::title,
+    "Text following the SMILES on the line, e.g. a compound identifier"
+  );
+  smilesFileLine.def_readonly(
+    "molecules",
+    &IO::Experimental::SmilesFileLine::molecules,
+    "Parsed molecules, empty if parsing failed"
+  );
+  smilesFileLine.def_readonly(
+    "error",
+    &IO::Experimental::SmilesFileLine::error,
+    "Parse error message, empty if parsing succeeded"
+  );
+
+  experimental.def(
+    "from_smiles_file",
+    &IO::Experimental::parseSmilesFile,
+    pybind11::arg("filename"),
+    pybind11::arg("callback"),
+    pybind11::arg("lines_per_chunk") = 4096,
+    pybind11::call_guard<pybind11::gil_scoped_release>(),
+    R"delim(
+      Parse a SMILES file line by line in parallel
+
+      Each non-empty line is expected to contain a SMILES string, optionally
+      followed by whitespace and a title. Chunks of lines are parsed in
+      parallel and passed to the callback in file order. Errors parsing a
+      line are reported in the error member of the callback argument.
+
+      :param filename: Path to the SMILES file
+      :param callback: Called with a SmilesFileLine for each non-empty line
+      :param lines_per_chunk: Number of lines parsed in parallel at a time
+    )delim"
+  );
+
+  experimental.def(
+    "emit_canonical_smiles",
+    &IO::Experimental::emitCanonicalSmiles,
+    pybind11::arg("molecule"),
+    pybind11::call_guard<pybind11::gil_scoped_release>(),
+    R"delim(
+      Emit a canonical smiles string for a molecule
+
+      Molecules that compare equal emit identical strings, which makes them
+      suitable as identity keys. Hydrogen atoms bonded to stereocenters and
+      stereogenic double bonds are written explicitly. Charges and shapes of
+      non-stereogenic atoms are not expressed.
+
+      :param molecule: The molecule to write
+      :rtype: str
+
+      >>> ethanol = from_smiles("OCC")
+      >>> emit_canonical_smiles(ethanol) == emit_canonical_smiles(from_smiles("CCO"))
+      True
+    )delim"
+  );
+
   /* Line notations */
   pybind11::class_<IO::LineNotation> lineNotation(
     io,
@@ -109,6 +220,7 @@ void init_io(pybind11::module& m) {
     "from_canonical_smiles",
     &IO::LineNotation::fromCanonicalSMILES,
     pybind11::arg("canonical_smiles"),
+    pybind11::call_guard<pybind11::gil_scoped_release>(),
     "Construct a single :class:`Molecule` from a canonical SMILES string"
   );
 
@@ -116,6 +228,7 @@ void init_io(pybind11::module& m) {
     "from_isomeric_smiles",
     &IO::LineNotation::fromIsomericSMILES,
     pybind11::arg("isomeric_smiles"),
+    pybind11::call_guard<pybind11::gil_scoped_release>(),
     "Construct a single :class:`Molecule` from an isomeric SMILES string"
   );
 
@@ -123,6 +236,7 @@ void init_io(pybind11::module& m) {
     "from_inchi",
     &IO::LineNotation::fromInChI,
     pybind11::arg("inchi"),
+    pybind11::call_guard<pybind11::gil_scoped_release>(),
     "Construct a single :class:`Molecule` from an InChI string"
   );
 
@@ -130,6 +244,7 @@ void init_io(pybind11::module& m) {
     "read",
     &IO::read,
     pybind11::arg("filename"),
+    pybind11::call_guard<pybind11::gil_scoped_release>(),
     R"delim(
       Reads a single :class:`Molecule` from a file. Interprets the file format from its
       extension. Supported formats:
@@ -145,6 +260,7 @@ void init_io(pybind11::module& m) {
     "split",
     &IO::split,
     pybind11::arg("filename"),
+    pybind11::call_guard<pybind11::gil_scoped_release>(),
     R"delim(
       Reads multiple molecules from a file. Interprets the file format from its
       extension just like read(). Note that serializations of molecules contain
@@ -164,6 +280,7 @@ void init_io(pybind11::module& m) {
     pybind11::arg("filename"),
     pybind11::arg("molecule"),
     pybind11::arg("positions"),
+    pybind11::call_guard<pybind11::gil_scoped_release>(),
     R"delim(
       Write a :class:`Molecule` and its positions to a file
 
@@ -179,6 +296,7 @@ void init_io(pybind11::module& m) {
     pybind11::overload_cast<const std::string&, const Molecule&>(&IO::write),
     pybind11::arg("filename"),
     pybind11::arg("molecule"),
+    pybind11::call_guard<pybind11::gil_scoped_release>(),
     R"delim(
       Write a :class:`Molecule` serialization with the endings json/cbor/bson
       or a graph representation with ending dot/svg to a file.
@@ -188,4 +306,45 @@ void init_io(pybind11::module& m) {
       :param molecule: :class:`Molecule` to write to file
     )delim"
   );
+
+  pybind11::class_<IO::XyzTrajectoryReader> xyzTrajectoryReader(
+    io,
+    "XyzTrajectoryReader",
+    R"delim(
+      Streaming reader of multi-frame XYZ files
+
+      Frames are read one at a time into buffers reused across frames.
+      Positions are converted to bohr units.
+    )delim"
+  );
+  xyzTrajectoryReader.def(
+    pybind11::init<std::string>(),
+    pybind11::arg("filename"),
+    "Open a trajectory file"
+  );
+  xyzTrajectoryReader.def(
+    "next",
+    &IO::XyzTrajectoryReader::next,
+    "Read the next frame. Returns whether a frame was read."
+  );
+  xyzTrajectoryReader.def_property_readonly(
+    "elements",
+    &IO::XyzTrajectoryReader::elements,
+    "Element types of the last read frame"
+  );
+  xyzTrajectoryReader.def_property_readonly(
+    "positions",
+    &IO::XyzTrajectoryReader::positions,
+    "Positions of the last read frame in bohr"
+  );
+  xyzTrajectoryReader.def_property_readonly(
+    "comment",
+    &IO::XyzTrajectoryReader::comment,
+    "Comment line of the last read frame"
+  );
+  xyzTrajectoryReader.def_property_readonly(
+    "frames",
+    &IO::XyzTrajectoryReader::frames,
+    "Number of frames read so far"
+  );
 }
@@ -4,9 +4,12 @@
  *   See LICENSE.txt for details.
  */
 #include "TypeCasters.h"
+#include "Awaitable.h"
 
+#include "Molassembler/AngstromPositions.h"
 #include "Molassembler/Interpret.h"
 #include "Molassembler/Molecule.h"
+#include "Molassembler/PeriodicCell.h"
 #include "Molassembler/Graph.h"
 
 #include "Utils/Bonds/BondOrderCollection.h"
@@ -54,6 +57,27 @@ void init_interpret(pybind11::module& m) {
   ).value("Binary", Interpret::BondDiscretizationOption::Binary, "All bond orders >= 0.5 are considered single bonds")
     .value("RoundToNearest", Interpret::BondDiscretizationOption::RoundToNearest, "Round bond orders to nearest integer");
 
+  pybind11::enum_<Interpret::ComponentDeduplicationOption>(
+    interpretSubmodule,
+    "ComponentDeduplication",
+    R"delim(
+      Specifies whether molecules of identical connected components are
+      instantiated independently.
+    )delim"
+  ).value("Off", Interpret::ComponentDeduplicationOption::Off, "Instantiate every component independently")
+    .value("Constitutional", Interpret::ComponentDeduplicationOption::Constitutional, "Components with equal element types, bonds and atom order reuse the rankings of the first such component");
+
+  pybind11::enum_<Interpret::InterpretationTier>(
+    interpretSubmodule,
+    "InterpretationTier",
+    R"delim(
+      Specifies how much of each molecule is interpreted from positions.
+      Lower tiers skip the costlier parts of interpretation.
+    )delim"
+  ).value("Constitution", Interpret::InterpretationTier::Constitution, "Model stereopermutators from the graph alone, ignoring positions")
+    .value("Shapes", Interpret::InterpretationTier::Shapes, "Rank from the graph alone and classify atom shapes from positions, without assigning stereopermutators")
+    .value("Full", Interpret::InterpretationTier::Full, "Interpret all stereopermutators from positions");
+
   pybind11::class_<Interpret::MoleculesResult> interpretResult(
     interpretSubmodule,
     "MoleculesResult",
@@ -85,12 +109,17 @@ void init_interpret(pybind11::module& m) {
       const AtomCollection&,
       const BondOrderCollection&,
       Interpret::BondDiscretizationOption,
-      const boost::optional<double>&
+      const boost::optional<double>&,
+      Interpret::ComponentDeduplicationOption,
+      Interpret::InterpretationTier
     >(&Interpret::molecules),
     pybind11::arg("atom_collection"),
     pybind11::arg("bond_orders"),
     pybind11::arg("discretization"),
     pybind11::arg("stereopermutator_bond_order_threshold") = 1.4,
+    pybind11::arg("deduplication") = Interpret::ComponentDeduplicationOption::Off,
+    pybind11::arg("tier") = Interpret::InterpretationTier::Full,
+    pybind11::call_guard<pybind11::gil_scoped_release>(),
     R"delim(
       Interpret molecules from element types, positional information and bond orders
 
@@ -108,6 +137,9 @@ void init_interpret(pybind11::module& m) {
         instantiation of BondStereopermutators onto edges whose fractional bond
         orders exceed the provided threshold. If ``None``, BondStereopermutators
         are instantiated at all bonds.
+      :param deduplication: Whether components with identical element types,
+        bonds and atom order reuse the rankings of the first such component
+      :param tier: How much of each molecule is interpreted from positions
       :raises ValueError: If the number of particles in the atom collection and
         bond order collections do not match
 
@@ -128,16 +160,65 @@ void init_interpret(pybind11::module& m) {
     )delim"
   );
 
+  interpretSubmodule.def(
+    "molecules_async",
+    [](
+      const AtomCollection& atomCollection,
+      const BondOrderCollection& bondOrders,
+      const Interpret::BondDiscretizationOption discretization,
+      const boost::optional<double>& threshold,
+      const Interpret::ComponentDeduplicationOption deduplication,
+      const Interpret::InterpretationTier tier
+    ) -> pybind11::object {
+      return submitAsync(
+        [=]() {
+          return Interpret::molecules(
+            atomCollection,
+            bondOrders,
+            discretization,
+            threshold,
+            deduplication,
+            tier
+          );
+        }
+      );
+    },
+    pybind11::arg("atom_collection"),
+    pybind11::arg("bond_orders"),
+    pybind11::arg("discretization"),
+    pybind11::arg("stereopermutator_bond_order_threshold") = 1.4,
+    pybind11::arg("deduplication") = Interpret::ComponentDeduplicationOption::Off,
+    pybind11::arg("tier") = Interpret::InterpretationTier::Full,
+    R"delim(
+      Interpret molecules from element types, positional information and bond
+      orders without blocking an asyncio event loop
+
+      Equivalent to :meth:`molecules`, but returns an awaitable future at
+      once. Interpretation runs on a background thread without the GIL and
+      completes the future in the event loop. Operations submitted this way
+      run one at a time in submission order.
+
+      Must be called from a coroutine or callback of a running event loop.
+
+      :rtype: ``asyncio.Future`` of a :class:`MoleculesResult`
+    )delim"
+  );
+
   interpretSubmodule.def(
     "interpret",
     pybind11::overload_cast<
       const AtomCollection&,
       Interpret::BondDiscretizationOption,
-      const boost::optional<double>&
+      const boost::optional<double>&,
+      Interpret::ComponentDeduplicationOption,
+      Interpret::InterpretationTier
     >(&Interpret::molecules),
     pybind11::arg("atom_collection"),
     pybind11::arg("discretization"),
     pybind11::arg("stereopermutator_bond_order_threshold") = 1.4,
+    pybind11::arg("deduplication") = Interpret::ComponentDeduplicationOption::Off,
+    pybind11::arg("tier") = Interpret::InterpretationTier::Full,
+    pybind11::call_guard<pybind11::gil_scoped_release>(),
     R"delim(
       Interpret molecules from element types and positional information. Bond
       orders are calculated with UFF parameters.
@@ -156,6 +237,178 @@ void init_interpret(pybind11::module& m) {
         instantiation of BondStereopermutators onto edges whose fractional bond orders
         exceed the provided threshold. If ``None``, BondStereopermutators are
         instantiated at all bonds.
+      :param deduplication: Whether components with identical element types,
+        bonds and atom order reuse the rankings of the first such component
+      :param tier: How much of each molecule is interpreted from positions
+    )delim"
+  );
+
+  interpretSubmodule.def(
+    "molecules",
+    [](
+      const AtomCollection& atomCollection,
+      const Eigen::Matrix3d& lattice,
+      const BondOrderCollection& bondOrders,
+      const Interpret::BondDiscretizationOption discretization,
+      const boost::optional<double>& threshold,
+      const Interpret::ComponentDeduplicationOption deduplication,
+      const Interpret::InterpretationTier tier
+    ) {
+      return Interpret::molecules(
+        atomCollection.getElements(),
+        AngstromPositions {atomCollection.getPositions()},
+        PeriodicCell {lattice},
+        bondOrders,
+        discretization,
+        threshold,
+        deduplication,
+        tier
+      );
+    },
+    pybind11::arg("atom_collection"),
+    pybind11::arg("lattice"),
+    pybind11::arg("bond_orders"),
+    pybind11::arg("discretization"),
+    pybind11::arg("stereopermutator_bond_order_threshold") = 1.4,
+    pybind11::arg("deduplication") = Interpret::ComponentDeduplicationOption::Off,
+    pybind11::arg("tier") = Interpret::InterpretationTier::Full,
+    pybind11::call_guard<pybind11::gil_scoped_release>(),
+    R"delim(
+      Interpret molecules of a periodic structure from element types, wrapped
+      positional information and bond orders
+
+      Components are found from the discretized bonds regardless of where
+      their atoms are wrapped to, and their positions are unwrapped along their
+      bonds by minimum image. In extended networks, bonds closing cycles
+      through the cell faces remain stretched.
+
+      :param atom_collection: Element types and wrapped positional information
+        in Bohr units
+      :param lattice: Lattice vectors of the periodic cell as rows in Bohr units
+      :param bond_orders: Fractional bond orders
+      :param discretization: How bond fractional orders are to be discretized
+      :param stereopermutator_bond_order_threshold: If specified, limits the
+        instantiation of BondStereopermutators onto edges whose fractional bond
+        orders exceed the provided threshold. If ``None``, BondStereopermutators
+        are instantiated at all bonds.
+      :param deduplication: Whether components with identical element types,
+        bonds and atom order reuse the rankings of the first such component
+      :param tier: How much of each molecule is interpreted from positions
+      :raises ValueError: If the number of particles in the atom collection and
+        bond order collections do not match, or the lattice vectors are
+        linearly dependent
+    )delim"
+  );
+
+  interpretSubmodule.def(
+    "interpret",
+    [](
+      const AtomCollection& atomCollection,
+      const Eigen::Matrix3d& lattice,
+      const Interpret::BondDiscretizationOption discretization,
+      const boost::optional<double>& threshold,
+      const Interpret::ComponentDeduplicationOption deduplication,
+      const Interpret::InterpretationTier tier
+    ) {
+      return Interpret::molecules(
+        atomCollection.getElements(),
+        AngstromPositions {atomCollection.getPositions()},
+        PeriodicCell {lattice},
+        discretization,
+        threshold,
+        deduplication,
+        tier
+      );
+    },
+    pybind11::arg("atom_collection"),
+    pybind11::arg("lattice"),
+    pybind11::arg("discretization"),
+    pybind11::arg("stereopermutator_bond_order_threshold") = 1.4,
+    pybind11::arg("deduplication") = Interpret::ComponentDeduplicationOption::Off,
+    pybind11::arg("tier") = Interpret::InterpretationTier::Full,
+    pybind11::call_guard<pybind11::gil_scoped_release>(),
+    R"delim(
+      Interpret molecules of a periodic structure from element types and
+      wrapped positional information. Bond orders are calculated with UFF
+      parameters between minimum images of atom pairs.
+
+      :param atom_collection: Element types and wrapped positional information
+        in Bohr units
+      :param lattice: Lattice vectors of the periodic cell as rows in Bohr units
+      :param discretization: How bond fractional orders are to be discretized
+      :param stereopermutator_bond_order_threshold: If specified, limits the
+        instantiation of BondStereopermutators onto edges whose fractional bond orders
+        exceed the provided threshold. If ``None``, BondStereopermutators are
+        instantiated at all bonds.
+      :param deduplication: Whether components with identical element types,
+        bonds and atom order reuse the rankings of the first such component
+      :param tier: How much of each molecule is interpreted from positions
+      :raises ValueError: If the lattice vectors are linearly dependent or the
+        cell is too small for minimum image bond perception
+    )delim"
+  );
+
+  pybind11::class_<Interpret::EnsembleResult> ensembleResult(
+    interpretSubmodule,
+    "EnsembleResult",
+    "Result type of an ensemble interpret call."
+  );
+
+  ensembleResult.def_readwrite(
+    "component_map",
+    &Interpret::EnsembleResult::componentMap,
+    "Mapping of atom indices to component indices, shared by all frames"
+  );
+
+  ensembleResult.def_readwrite(
+    "frames",
+    &Interpret::EnsembleResult::frames,
+    R"delim(
+      Molecules of each frame, in component order
+
+      :rtype: ``List`` of ``List`` of :class:`~scine_molassembler.Molecule`
+    )delim"
+  );
+
+  interpretSubmodule.def(
+    "ensemble",
+    [](
+      const AtomCollection& topology,
+      const BondOrderCollection& bondOrders,
+      const std::vector<PositionCollection>& frames,
+      const Interpret::BondDiscretizationOption discretization,
+      const boost::optional<double>& threshold
+    ) {
+      std::vector<AngstromPositions> angstromFrames;
+      angstromFrames.reserve(frames.size());
+      for(const auto& frame : frames) {
+        angstromFrames.emplace_back(frame, LengthUnit::Bohr);
+      }
+      return Interpret::ensemble(topology, bondOrders, angstromFrames, discretization, threshold);
+    },
+    pybind11::arg("topology"),
+    pybind11::arg("bond_orders"),
+    pybind11::arg("frames"),
+    pybind11::arg("discretization") = Interpret::BondDiscretizationOption::Binary,
+    pybind11::arg("stereopermutator_bond_order_threshold") = 1.4,
+    pybind11::call_guard<pybind11::gil_scoped_release>(),
+    R"delim(
+      Interpret an ensemble of conformers sharing a single topology
+
+      Bonds are discretized and components are found once from the topology.
+      The molecules of each frame only fit stereopermutators to the frame's
+      positions, reusing the graph and rankings of the topology's molecules.
+
+      :param topology: Element types and reference positions in Bohr units
+      :param bond_orders: Fractional bond orders of the topology
+      :param frames: Positions of the conformers in Bohr units
+      :param discretization: How bond fractional orders are to be discretized
+      :param stereopermutator_bond_order_threshold: If specified, limits the
+        instantiation of BondStereopermutators onto edges whose fractional bond
+        orders exceed the provided threshold. If ``None``, BondStereopermutators
+        are instantiated at all bonds.
+      :raises ValueError: If the number of particles in the topology, bond
+        orders or any frame do not match
     )delim"
   );
 
@@ -315,6 +568,64 @@ void init_interpret(pybind11::module& m) {
     [](const Interpret::ComponentMap& map) { return map.size(); }
   );
 
+  pybind11::class_<Interpret::ComponentMap::Index> componentMapIndex(
+    componentMap,
+    "Index",
+    R"delim(
+      Precomputed inverse of a component map, transforming indices in either
+      direction in constant time. Later changes to the map it is constructed
+      from are not reflected.
+    )delim"
+  );
+
+  componentMapIndex.def(
+    pybind11::init<const Interpret::ComponentMap&>(),
+    pybind11::arg("component_map")
+  );
+
+  componentMapIndex.def(
+    "apply",
+    &Interpret::ComponentMap::Index::apply,
+    pybind11::arg("index"),
+    "Transforms an original index to its component and index within it"
+  );
+
+  componentMapIndex.def(
+    "invert",
+    &Interpret::ComponentMap::Index::invert,
+    pybind11::arg("pair"),
+    "Transforms a component and index within it to the original index"
+  );
+
+  componentMapIndex.def(
+    "atoms",
+    [](const Interpret::ComponentMap::Index& index, const unsigned component) {
+      const auto range = index.atoms(component);
+      return std::vector<unsigned>(range.begin(), range.end());
+    },
+    pybind11::arg("component"),
+    R"delim(
+      Original indices of a component's atoms, ordered by their index within
+      the component
+
+      >>> m = ComponentMap([0, 1, 1, 0, 1])
+      >>> m.index().atoms(1)
+      [1, 2, 4]
+    )delim"
+  );
+
+  componentMapIndex.def_property_readonly(
+    "components",
+    &Interpret::ComponentMap::Index::components,
+    "Number of components"
+  );
+
+  componentMap.def(
+    "index",
+    &Interpret::ComponentMap::index,
+    "Precomputes the inverse of the map for repeated lookups"
+  );
+
   pybind11::class_<Interpret::GraphsResult> graphsResult(
     interpretSubmodule,
     "GraphsResult",
@@ -350,6 +661,7 @@ void init_interpret(pybind11::module& m) {
     pybind11::arg("atom_collection"),
     pybind11::arg("bond_orders"),
     pybind11::arg("discretization"),
+    pybind11::call_guard<pybind11::gil_scoped_release>(),
     R"delim(
       Interpret graphs from element types, positional information and bond orders
 
@@ -366,6 +678,116 @@ void init_interpret(pybind11::module& m) {
     )delim"
   );
 
+  pybind11::class_<Interpret::TrajectoryInterpreter> trajectoryInterpreter(
+    interpretSubmodule,
+    "TrajectoryInterpreter",
+    R"delim(
+      Interprets molecules in consecutive frames of a trajectory, reusing the
+      molecules of components whose bonding is unchanged
+
+      A pair's discretized bond type and bond stereopermutator candidacy only
+      change if its fractional bond order passes the respective boundary by
+      more than the hysteresis. Only components whose bonding changed are
+      instantiated anew. Components with unchanged bonding are refitted to the
+      new positions if any of their atoms moved further than the refit
+      displacement since they were last fitted. The first frame is interpreted
+      as by :meth:`interpret`.
+    )delim"
+  );
+
+  trajectoryInterpreter.def(
+    pybind11::init<
+      ElementTypeCollection,
+      Interpret::BondDiscretizationOption,
+      const boost::optional<double>&,
+      double,
+      double
+    >(),
+    pybind11::arg("elements"),
+    pybind11::arg("discretization") = Interpret::BondDiscretizationOption::Binary,
+    pybind11::arg("stereopermutator_bond_order_threshold") = 1.4,
+    pybind11::arg("hysteresis") = 0.1,
+    pybind11::arg("refit_displacement") = 0.0,
+    R"delim(
+      Prepare interpretation of a trajectory
+
+      :param elements: Element types of all frames
+      :param discretization: How bond fractional orders are to be discretized
+      :param stereopermutator_bond_order_threshold: If specified, limits the
+        instantiation of BondStereopermutators onto edges whose fractional bond
+        orders exceed the provided threshold. If ``None``, no
+        BondStereopermutators are instantiated.
+      :param hysteresis: Distance past a discretization boundary or the
+        stereopermutator threshold a fractional bond order must reach to
+        change the interpretation of a pair. Must be in [0, 0.5).
+      :param refit_displacement: Largest displacement in Angstrom of any atom
+        of a component with unchanged bonding since it was last fitted up to
+        which its molecule is kept as is
+    )delim"
+  );
+
+  trajectoryInterpreter.def(
+    "__call__",
+    [](
+      Interpret::TrajectoryInterpreter& interpreter,
+      const PositionCollection& positions,
+      const BondOrderCollection& bondOrders
+    ) {
+      return interpreter(AngstromPositions {positions, LengthUnit::Bohr}, bondOrders);
+    },
+    pybind11::arg("positions"),
+    pybind11::arg("bond_orders"),
+    pybind11::return_value_policy::copy,
+    pybind11::call_guard<pybind11::gil_scoped_release>(),
+    R"delim(
+      Interpret the next frame from positions and bond orders
+
+      :param positions: Positions of the frame in Bohr units
+      :param bond_orders: Fractional bond orders of the frame
+      :raises ValueError: If the number of particles in the positions or bond
+        orders do not match the number of elements
+    )delim"
+  );
+
+  trajectoryInterpreter.def(
+    "__call__",
+    [](
+      Interpret::TrajectoryInterpreter& interpreter,
+      const PositionCollection& positions
+    ) {
+      return interpreter(AngstromPositions {positions, LengthUnit::Bohr});
+    },
+    pybind11::arg("positions"),
+    pybind11::return_value_policy::copy,
+    pybind11::call_guard<pybind11::gil_scoped_release>(),
+    R"delim(
+      Interpret the next frame from positions only. Bond orders are calculated
+      with UFF parameters.
+
+      :param positions: Positions of the frame in Bohr units
+      :raises ValueError: If the number of particles in the positions do not
+        match the number of elements
+    )delim"
+  );
+
+  trajectoryInterpreter.def_property_readonly(
+    "rebuilt_components",
+    &Interpret::TrajectoryInterpreter::rebuiltComponents,
+    "Components of the last frame that were instantiated anew"
+  );
+
+  trajectoryInterpreter.def_property_readonly(
+    "refitted_components",
+    &Interpret::TrajectoryInterpreter::refittedComponents,
+    "Components of the last frame with unchanged bonding that were refitted"
+  );
+
+  trajectoryInterpreter.def_property_readonly(
+    "frames",
+    &Interpret::TrajectoryInterpreter::frames,
+    "Number of interpreted frames"
+  );
+
   pybind11::class_<Interpret::FalsePositive> falsePositive(m, "FalsePositive");
   falsePositive.def_readwrite("i", &Interpret::FalsePositive::i);
   falsePositive.def_readwrite("j", &Interpret::FalsePositive::j);
@@ -395,6 +817,7 @@ void init_interpret(pybind11::module& m) {
     &Interpret::uncertainBonds,
     pybind11::arg("atom_collection"),
     pybind11::arg("bond_collection"),
+    pybind11::call_guard<pybind11::gil_scoped_release>(),
     R"delim(
       Lists bonds with uncertain shape classifications at both ends
 
@@ -413,6 +836,7 @@ void init_interpret(pybind11::module& m) {
     &Interpret::badHapticLigandBonds,
     pybind11::arg("atom_collection"),
     pybind11::arg("bond_collection"),
+    pybind11::call_guard<pybind11::gil_scoped_release>(),
     R"delim(
       Suggest false positive haptic ligand bonds
 
@@ -434,11 +858,20 @@ void init_interpret(pybind11::module& m) {
     )delim"
   );
 
+  pybind11::enum_<Interpret::FalsePositiveRemovalOption>(
+    interpretSubmodule,
+    "FalsePositiveRemoval",
+    "Specifies how many false positives are removed per iteration"
+  ).value("Sequential", Interpret::FalsePositiveRemovalOption::Sequential, "Remove only the most likely false positive")
+    .value("Batch", Interpret::FalsePositiveRemovalOption::Batch, "Also remove false positives not within a graph distance of two of an already selected one");
+
   interpretSubmodule.def(
     "remove_false_positives",
     &Interpret::removeFalsePositives,
     pybind11::arg("atoms"),
     pybind11::arg("bonds"),
+    pybind11::arg("removal") = Interpret::FalsePositiveRemovalOption::Sequential,
+    pybind11::call_guard<pybind11::gil_scoped_release>(),
     "Iteratively removes bonds reported by false positive detection functions"
   );
 }
@@ -0,0 +1,130 @@
+/*!@file
+ * @copyright This code is licensed under the 3-clause BSD license.
+ *   Copyright ETH Zurich, Laboratory of Physical Chemistry, Reiher Group.
+ *   See LICENSE.txt for details.
+ */
+#include "TypeCasters.h"
+
+#include "Molassembler/Memory.h"
+#include "Molassembler/Molecule.h"
+
+void init_memory(pybind11::module& m) {
+  using namespace Scine::Molassembler;
+
+  auto memory = m.def_submodule(
+    "memory",
+    "Approximate memory footprints of molecules and conformer generation"
+  );
+
+  pybind11::class_<Memory::MoleculeFootprint> molecule(
+    memory,
+    "MoleculeFootprint",
+    R"delim(
+      Approximate heap memory of a molecule in bytes by constituent
+
+      >>> import scine_molassembler as masm
+      >>> mol = masm.io.experimental.from_smiles("c1ccccc1")
+      >>> masm.memory.footprint(mol).total() > 0
+      True
+    )delim"
+  );
+
+  molecule.def_readonly(
+    "graph",
+    &Memory::MoleculeFootprint::graph,
+    "Atoms, bonds and cached graph properties other than cycle information"
+  );
+
+  molecule.def_readonly(
+    "cycles",
+    &Memory::MoleculeFootprint::cycles,
+    "Cached cycle information of the graph"
+  );
+
+  molecule.def_readonly(
+    "stereopermutators",
+    &Memory::MoleculeFootprint::stereopermutators,
+    "Atom and bond stereopermutators, excluding their ranking information"
+  );
+
+  molecule.def_readonly(
+    "ranking",
+    &Memory::MoleculeFootprint::ranking,
+    "Ranking information of atom stereopermutators and ranking depths of atoms"
+  );
+
+  molecule.def(
+    "total",
+    &Memory::MoleculeFootprint::total,
+    "Sum of all constituents"
+  );
+
+  pybind11::class_<Memory::ConformerJobFootprint> job(
+    memory,
+    "ConformerJobFootprint",
+    "Approximate heap memory of a conformer generation job in bytes"
+  );
+
+  job.def_readonly(
+    "model",
+    &Memory::ConformerJobFootprint::model,
+    "Spatial model shared by all threads"
+  );
+
+  job.def_readonly(
+    "per_thread",
+    &Memory::ConformerJobFootprint::perThread,
+    "Temporary memory of each thread generating conformers"
+  );
+
+  job.def_readonly(
+    "threads",
+    &Memory::ConformerJobFootprint::threads,
+    "Number of threads generating conformers concurrently"
+  );
+
+  job.def_readonly(
+    "results",
+    &Memory::ConformerJobFootprint::results,
+    "Generated conformers held until the job finishes"
+  );
+
+  job.def(
+    "peak",
+    &Memory::ConformerJobFootprint::peak,
+    "Peak heap memory of the entire job"
+  );
+
+  memory.def(
+    "footprint",
+    &Memory::footprint,
+    pybind11::arg("molecule"),
+    R"delim(
+      Approximate heap memory of a molecule
+
+      Cached properties of the graph are only included if they have been
+      generated already.
+    )delim"
+  );
+
+  memory.def(
+    "conformer_job_footprint",
+    &Memory::conformerJobFootprint,
+    pybind11::arg("molecule"),
+    pybind11::arg("num_conformers"),
+    pybind11::arg("configuration") = DistanceGeometry::Configuration {},
+    R"delim(
+      Approximate peak heap memory of a conformer generation job
+
+      Estimates the memory of generating a number of conformers of a molecule
+      with :func:`dg.generate_ensemble` or :func:`dg.generate_random_ensemble`
+      using the current executor. The molecule's own memory is not included.
+
+      >>> import scine_molassembler as masm
+      >>> mol = masm.io.experimental.from_smiles("CC(F)(Cl)Br")
+      >>> job = masm.memory.conformer_job_footprint(mol, 100)
+      >>> job.peak() >= job.model + job.results
+      True
+    )delim"
+  );
+}
@@ -0,0 +1,255 @@
+/*!@file
+ * @copyright This code is licensed under the 3-clause BSD license.
+ *   Copyright ETH Zurich, Laboratory of Physical Chemistry, Reiher Group.
+ *   See LICENSE.txt for details.
+ */
+#include "TypeCasters.h"
+
+#include "Molassembler/Metrics.h"
+
+void init_metrics(pybind11::module& m) {
+  using namespace Scine::Molassembler;
+
+  auto metrics = m.def_submodule(
+    "metrics",
+    "Counters and cumulative timings of library operations"
+  );
+
+  pybind11::class_<Metrics::OperationMetrics> operation(
+    metrics,
+    "OperationMetrics",
+    "Number of times an operation was performed and their total duration"
+  );
+
+  operation.def_readonly(
+    "count",
+    &Metrics::OperationMetrics::count,
+    "Number of operations"
+  );
+
+  operation.def_readonly(
+    "seconds",
+    &Metrics::OperationMetrics::seconds,
+    "Total wall clock time spent in the operations, in seconds"
+  );
+
+  operation.def(
+    "__repr__",
+    [](const Metrics::OperationMetrics& op) {
+      return "OperationMetrics(count=" + std::to_string(op.count)
+        + ", seconds=" + std::to_string(op.seconds) + ")";
+    }
+  );
+
+  pybind11::class_<Metrics::SlowRanking> slowRanking(
+    metrics,
+    "SlowRanking",
+    "A ranking reported by the ranking watchdog"
+  );
+
+  slowRanking.def_readonly(
+    "atom",
+    &Metrics::SlowRanking::atom,
+    "Atom whose substituents were ranked"
+  );
+
+  slowRanking.def_readonly(
+    "seconds",
+    &Metrics::SlowRanking::seconds,
+    "Wall time the ranking had taken when it was reported, in seconds"
+  );
+
+  slowRanking.def_readonly(
+    "depth",
+    &Metrics::SlowRanking::depth,
+    "Depth of the deepest expanded ranking tree vertex"
+  );
+
+  slowRanking.def_readonly(
+    "tree_size",
+    &Metrics::SlowRanking::treeSize,
+    "Number of ranking tree vertices"
+  );
+
+  slowRanking.def_readonly(
+    "sequence_rule",
+    &Metrics::SlowRanking::sequenceRule,
+    "Sequence rule being evaluated, one to five"
+  );
+
+  slowRanking.def_readonly(
+    "finished",
+    &Metrics::SlowRanking::finished,
+    "Whether the ranking had finished when it was reported"
+  );
+
+  slowRanking.def_readonly(
+    "graphviz",
+    &Metrics::SlowRanking::graphviz,
+    "Graphviz representation of the ranking tree if requested, else empty"
+  );
+
+  pybind11::class_<Metrics::RankingWatchdog> watchdog(
+    metrics,
+    "RankingWatchdog",
+    "Settings of the ranking watchdog"
+  );
+
+  watchdog.def(
+    pybind11::init<>(),
+    "Watchdog that is off"
+  );
+
+  watchdog.def(
+    pybind11::init([](double seconds, bool graphviz) {
+      return Metrics::RankingWatchdog {seconds, graphviz};
+    }),
+    pybind11::arg("seconds"),
+    pybind11::arg("graphviz") = false,
+    "Watchdog reporting rankings running longer than a wall time"
+  );
+
+  watchdog.def_readwrite(
+    "seconds",
+    &Metrics::RankingWatchdog::seconds,
+    "Wall time after which a ranking is reported, in seconds. Off if zero"
+  );
+
+  watchdog.def_readwrite(
+    "graphviz",
+    &Metrics::RankingWatchdog::graphviz,
+    "Whether reports include a graphviz representation of the ranking tree"
+  );
+
+  pybind11::class_<Metrics::Snapshot> snapshot(
+    metrics,
+    "Snapshot",
+    R"delim(
+      Tallies of library operations at a point in time
+
+      >>> import scine_molassembler as masm
+      >>> masm.metrics.reset()
+      >>> mol = masm.io.experimental.from_smiles("CC(F)(Cl)Br")
+      >>> snapshot = masm.metrics.snapshot()
+      >>> snapshot.rankings.count > 0
+      True
+    )delim"
+  );
+
+  snapshot.def_readonly(
+    "rankings",
+    &Metrics::Snapshot::rankings,
+    "Substituent rankings of atoms by ranking trees"
+  );
+
+  snapshot.def_readonly(
+    "max_ranking_depth",
+    &Metrics::Snapshot::maxRankingDepth,
+    "Maximal depth of any ranking tree"
+  );
+
+  snapshot.def_readonly(
+    "sequence_rules_reached",
+    &Metrics::Snapshot::sequenceRulesReached,
+    "Number of rankings reaching each sequence rule, indexed by rule minus one"
+  );
+
+  snapshot.def_readonly(
+    "stereodescriptor_rules_skipped",
+    &Metrics::Snapshot::stereodescriptorRulesSkipped,
+    "Number of rankings skipping sequence rules three to five"
+  );
+
+  snapshot.def_readonly(
+    "cycle_recomputations",
+    &Metrics::Snapshot::cycleRecomputations,
+    "Cycle data recomputations of graphs after modification"
+  );
+
+  snapshot.def_readonly(
+    "abstract_permutations",
+    &Metrics::Snapshot::abstractPermutations,
+    "Constructions of abstract atom stereopermutations"
+  );
+
+  snapshot.def_readonly(
+    "feasible_permutations",
+    &Metrics::Snapshot::feasiblePermutations,
+    "Constructions of feasible atom stereopermutations"
+  );
+
+  snapshot.def_readonly(
+    "shape_measures",
+    &Metrics::Snapshot::shapeMeasures,
+    "Continuous shape measure calculations"
+  );
+
+  snapshot.def_readonly(
+    "nauty",
+    &Metrics::Snapshot::nauty,
+    "Graph canonicalizations by nauty"
+  );
+
+  snapshot.def_readonly(
+    "dg_failures",
+    &Metrics::Snapshot::dgFailures,
+    R"delim(
+      Number of conformers by :class:`dg.Error` that conformer
+      generation failed to generate, only listing errors that occurred
+    )delim"
+  );
+
+  snapshot.def_readonly(
+    "infeasible_models",
+    &Metrics::Snapshot::infeasibleModels,
+    R"delim(
+      Number of spatial models shared between conformers that were diagnosed
+      as unable to yield any conformer before generation was attempted
+    )delim"
+  );
+
+  snapshot.def_readonly(
+    "slow_rankings",
+    &Metrics::Snapshot::slowRankings,
+    "Rankings reported by the ranking watchdog, at most the first 64"
+  );
+
+  metrics.def(
+    "snapshot",
+    &Metrics::snapshot,
+    "Reads all tallies"
+  );
+
+  metrics.def(
+    "reset",
+    &Metrics::reset,
+    "Zeroes all tallies and discards ranking watchdog reports"
+  );
+
+  metrics.def(
+    "set_ranking_watchdog",
+    &Metrics::setRankingWatchdog,
+    pybind11::arg("watchdog"),
+    R"delim(
+      Sets the ranking watchdog, which is off by default
+
+      Rankings running longer than the watchdog's wall time are reported in
+      :attr:`Snapshot.slow_rankings` with their ranked atom, tree size and
+      depth and the sequence rule being evaluated.
+
+      >>> import scine_molassembler as masm
+      >>> masm.metrics.reset()
+      >>> masm.metrics.set_ranking_watchdog(masm.metrics.RankingWatchdog(1e-9))
+      >>> mol = masm.io.experimental.from_smiles("CC(F)(Cl)Br")
+      >>> len(masm.metrics.snapshot().slow_rankings) > 0
+      True
+      >>> masm.metrics.set_ranking_watchdog(masm.metrics.RankingWatchdog())
+    )delim"
+  );
+
+  metrics.def(
+    "ranking_watchdog",
+    &Metrics::rankingWatchdog,
+    "Current ranking watchdog settings"
+  );
+}
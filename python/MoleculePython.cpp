@@ -5,6 +5,7 @@
  */
 #include "TypeCasters.h"
 #include "pybind11/operators.h"
+#include "pybind11/numpy.h"
 
 #include "Molassembler/Molecule.h"
 #include "Molassembler/Graph.h"
@@ -144,6 +145,26 @@ void init_molecule(pybind11::module& m) {
     )delim"
   );
 
+  molecule.def_static(
+    "lazy",
+    &Molecule::lazy,
+    pybind11::arg("graph"),
+    R"delim(
+      Initialize a molecule from connectivity alone, deferring ranking and
+      stereopermutator instantiation until stereopermutators are first needed.
+
+      Yields the same molecule as the graph constructor. Fingerprints,
+      canonicalization and comparisons with components excluding shapes and
+      stereopermutations do not need stereopermutators, so molecules can be
+      loaded quickly for constitution-only purposes.
+
+      >>> a = io.experimental.from_smiles("[C@](F)(Cl)(C)[H]")
+      >>> b = Molecule.lazy(a.graph)
+      >>> b == Molecule(a.graph)
+      True
+    )delim"
+  );
+
   molecule.def(
     "hash",
     &Molecule::hash,
@@ -338,10 +359,30 @@ void init_molecule(pybind11::module& m) {
     )delim"
   );
 
+  molecule.def(
+    "begin_edits",
+    &Molecule::beginEdits,
+    R"delim(
+      Defer stereopermutator propagation of graph edits until
+      :meth:`commit_edits`. The vicinity of all edited atoms is then re-ranked
+      once instead of after each edit. Until then, stereopermutators may not
+      reflect the edits.
+
+      >>> m = io.experimental.from_smiles("CC")
+      >>> m.begin_edits()
+      >>> o = m.add_atom(utils.ElementType.O, 0)
+      >>> n = m.add_atom(utils.ElementType.N, 1)
+      >>> m.commit_edits()
+      >>> m.graph.N
+      10
+    )delim"
+  );
+
   molecule.def(
     "canonicalize",
     &Molecule::canonicalize,
     pybind11::arg("components_bitmask") = AtomEnvironmentComponents::All,
+    pybind11::call_guard<pybind11::gil_scoped_release>(),
     R"delim(
       Transform the molecule to a canonical form. Invalidates all atom and bond
       indices.
@@ -386,6 +427,12 @@ void init_molecule(pybind11::module& m) {
     )delim"
   );
 
+  molecule.def(
+    "commit_edits",
+    &Molecule::commitEdits,
+    "Propagate all graph edits made since :meth:`begin_edits`"
+  );
+
   molecule.def(
     "remove_atom",
     &Molecule::removeAtom,
@@ -410,6 +457,25 @@ void init_molecule(pybind11::module& m) {
     )delim"
   );
 
+  molecule.def(
+    "remove_atoms",
+    &Molecule::removeAtoms,
+    pybind11::arg("atoms"),
+    R"delim(
+      Remove several atoms from the graph, including bonds to them, after
+      checking once that the remaining atoms stay connected. Invalidates all
+      atom and bond indices.
+
+      :param atoms: Atoms to remove
+
+      >>> ethane = io.experimental.from_smiles("CC")
+      >>> hydrogens = [a for a in ethane.graph.atoms() if ethane.graph.element_type(a) == utils.ElementType.H]
+      >>> ethane.remove_atoms(hydrogens)
+      >>> ethane.graph.N
+      2
+    )delim"
+  );
+
   molecule.def(
     "remove_bond",
     pybind11::overload_cast<AtomIndex, AtomIndex>(&Molecule::removeBond),
@@ -578,6 +644,7 @@ void init_molecule(pybind11::module& m) {
     &Molecule::canonicalCompare,
     pybind11::arg("other"),
     pybind11::arg("components_bitmask") = AtomEnvironmentComponents::All,
+    pybind11::call_guard<pybind11::gil_scoped_release>(),
     R"delim(
       Modular comparison of this Molecule with another, assuming that both are
       in some (possibly partial) canonical form.
@@ -627,6 +694,7 @@ void init_molecule(pybind11::module& m) {
     &Molecule::modularIsomorphism,
     pybind11::arg("other"),
     pybind11::arg("components_bitmask"),
+    pybind11::call_guard<pybind11::gil_scoped_release>(),
     R"delim(
       Modular comparison of this Molecule with another.
 
@@ -670,8 +738,14 @@ void init_molecule(pybind11::module& m) {
     )delim"
   );
 
-  molecule.def(pybind11::self == pybind11::self);
-  molecule.def(pybind11::self != pybind11::self);
+  molecule.def(
+    pybind11::self == pybind11::self,
+    pybind11::call_guard<pybind11::gil_scoped_release>()
+  );
+  molecule.def(
+    pybind11::self != pybind11::self,
+    pybind11::call_guard<pybind11::gil_scoped_release>()
+  );
 
   /* Integration with IPython / Jupyter */
   if(graphvizInPath()) {
@@ -708,19 +782,71 @@ void init_molecule(pybind11::module& m) {
     "Generate a string representation of the molecule"
   );
 
-  /* Pickling support (allows copying) */
+  /* Pickling support (allows copying and passing between processes) in the
+   * compact binary format
+   */
   molecule.def(
     pybind11::pickle(
       [](const Molecule& mol) {
-        JsonSerialization serialization(mol);
-        std::string serialized = serialization;
-        return serialized;
+        const auto binary = CompactSerialization::serialize(mol);
+        return pybind11::bytes(
+          reinterpret_cast<const char*>(binary.data()),
+          binary.size()
+        );
       },
-      [](const std::string& serialized) {
-        JsonSerialization serialization(serialized);
-        Molecule mol = serialization;
-        return mol;
+      [](const pybind11::bytes& bytes) {
+        const std::string binary = bytes;
+        return CompactSerialization::deserialize(
+          reinterpret_cast<const std::uint8_t*>(binary.data()),
+          binary.size(),
+          CompactSerialization::Validation::Checksum
+        );
       }
     )
   );
+
+  m.def(
+    "canonicalize_many",
+    [](std::vector<Molecule> molecules, const AtomEnvironmentComponents components) {
+      canonicalize(molecules, components);
+      return molecules;
+    },
+    pybind11::arg("molecules"),
+    pybind11::arg("components_bitmask") = AtomEnvironmentComponents::All,
+    pybind11::call_guard<pybind11::gil_scoped_release>(),
+    R"delim(
+      Canonicalizes many molecules in parallel. Equivalent to calling
+      :meth:`Molecule.canonicalize` on a copy of each molecule.
+
+      :param molecules: Molecules to canonicalize
+      :param components_bitmask: Components of the molecular graph to include
+        in the canonicalization procedure
+      :rtype: List of canonical copies of the molecules, in input order
+
+      >>> molecules = [io.experimental.from_smiles(s) for s in ["CCO", "OCC"]]
+      >>> a, b = canonicalize_many(molecules)
+      >>> a == b
+      True
+    )delim"
+  );
+
+  m.def(
+    "hash_many",
+    [](const std::vector<Molecule>& molecules) {
+      std::vector<std::size_t> result;
+      {
+        pybind11::gil_scoped_release release;
+        result = hashes(molecules);
+      }
+      return pybind11::array_t<std::size_t>(result.size(), result.data());
+    },
+    pybind11::arg("molecules"),
+    R"delim(
+      Hashes many molecules in parallel. Equivalent to calling
+      :meth:`Molecule.hash` on each molecule.
+
+      :param molecules: Molecules to hash
+      :rtype: Unsigned integer numpy array of the hashes, in input order
+    )delim"
+  );
 }
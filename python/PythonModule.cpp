@@ -10,16 +10,22 @@ void init_bond_stereopermutator(pybind11::module& m);
 void init_composite(pybind11::module& m);
 void init_conformers(pybind11::module& m);
 void init_cycles(pybind11::module& m);
+void init_descriptors(pybind11::module& m);
 void init_directed_conformer_generator(pybind11::module& m);
 void init_editing(pybind11::module& m);
 void init_interpret(pybind11::module& m);
 void init_io(pybind11::module& m);
+void init_metrics(pybind11::module& m);
+void init_memory(pybind11::module& m);
+void init_cost_model(pybind11::module& m);
+void init_conformer_deduplicator(pybind11::module& m);
 void init_modeling(pybind11::module& m);
 void init_molecule(pybind11::module& m);
 void init_options(pybind11::module& m);
 void init_graph(pybind11::module& m);
 void init_random_engine(pybind11::module& m);
 void init_ranking_information(pybind11::module& m);
+void init_reaction_template(pybind11::module& m);
 void init_serialization(pybind11::module& m);
 void init_stereopermutator_list(pybind11::module& m);
 void init_subgraphs(pybind11::module& m);
@@ -55,12 +61,18 @@ PYBIND11_MODULE(scine_molassembler, m) {
   init_stereopermutator_list(m);
   init_molecule(m);
   init_subgraphs(m);
+  init_descriptors(m);
   init_editing(m);
+  init_reaction_template(m);
   init_interpret(m);
   init_io(m);
   init_serialization(m);
   init_conformers(m);
   init_directed_conformer_generator(m);
+  init_metrics(m);
+  init_memory(m);
+  init_cost_model(m);
+  init_conformer_deduplicator(m);
   init_modeling(m);
   /* Needed to avoid an exception at exit because of GIL and parallelization
    * shenanigans in DirectedConformerGenerator's enumerate functions
@@ -0,0 +1,129 @@
+/*!@file
+ * @copyright This code is licensed under the 3-clause BSD license.
+ *   Copyright ETH Zurich, Laboratory of Physical Chemistry, Reiher Group.
+ *   See LICENSE.txt for details.
+ */
+#include "TypeCasters.h"
+
+#include "Molassembler/ReactionTemplate.h"
+#include "Molassembler/Graph.h"
+#include "Molassembler/Molecule.h"
+
+void init_reaction_template(pybind11::module& m) {
+  using namespace Scine::Molassembler;
+
+  pybind11::class_<ReactionTemplate> reactionTemplate(
+    m,
+    "ReactionTemplate",
+    R"delim(
+      A reactant pattern and the graph edits turning it into the product. The
+      pattern is compiled into a subgraph query once. Applying the template to
+      a molecule applies the edits at each distinct match of the pattern and
+      returns the distinct products.
+    )delim"
+  );
+
+  pybind11::class_<ReactionTemplate::Edit> edit(
+    reactionTemplate,
+    "Edit",
+    "Graph edit of pattern atoms"
+  );
+
+  pybind11::enum_<ReactionTemplate::Edit::Type> editType(
+    edit,
+    "Type",
+    "Kind of graph edit"
+  );
+  editType.value("AddBond", ReactionTemplate::Edit::Type::AddBond, "Adds a bond");
+  editType.value("RemoveBond", ReactionTemplate::Edit::Type::RemoveBond, "Removes a bond");
+  editType.value("SetBondType", ReactionTemplate::Edit::Type::SetBondType, "Changes a bond's type");
+  editType.value("SetElementType", ReactionTemplate::Edit::Type::SetElementType, "Changes an atom's element type");
+
+  edit.def_static(
+    "add_bond",
+    &ReactionTemplate::Edit::addBond,
+    pybind11::arg("a"),
+    pybind11::arg("b"),
+    pybind11::arg("bond_type"),
+    "Adds a bond between pattern atoms that are not bonded in the pattern"
+  );
+  edit.def_static(
+    "remove_bond",
+    &ReactionTemplate::Edit::removeBond,
+    pybind11::arg("a"),
+    pybind11::arg("b"),
+    "Removes a bond of the pattern"
+  );
+  edit.def_static(
+    "set_bond_type",
+    &ReactionTemplate::Edit::setBondType,
+    pybind11::arg("a"),
+    pybind11::arg("b"),
+    pybind11::arg("bond_type"),
+    "Changes the type of a bond of the pattern"
+  );
+  edit.def_static(
+    "set_element_type",
+    &ReactionTemplate::Edit::setElementType,
+    pybind11::arg("a"),
+    pybind11::arg("element_type"),
+    "Changes the element type of a pattern atom"
+  );
+  edit.def_readonly("type", &ReactionTemplate::Edit::type, "Kind of graph edit");
+  edit.def_readonly("first", &ReactionTemplate::Edit::first, "First pattern atom");
+  edit.def_readonly("second", &ReactionTemplate::Edit::second, "Second pattern atom, if a bond is edited");
+  edit.def_readonly("bond_type", &ReactionTemplate::Edit::bondType, "New bond type");
+  edit.def_readonly("element_type", &ReactionTemplate::Edit::elementType, "New element type");
+
+  reactionTemplate.def(
+    pybind11::init<
+      const Graph&,
+      std::vector<ReactionTemplate::Edit>,
+      Subgraphs::VertexStrictness,
+      Subgraphs::EdgeStrictness,
+      AtomEnvironmentComponents
+    >(),
+    pybind11::arg("pattern"),
+    pybind11::arg("edits"),
+    pybind11::arg("vertex_strictness") = Subgraphs::VertexStrictness::ElementType,
+    pybind11::arg("edge_strictness") = Subgraphs::EdgeStrictness::BondType,
+    pybind11::arg("product_components") = AtomEnvironmentComponents::All,
+    R"delim(
+      Compiles a pattern and its edits
+
+      :param pattern: The reactant pattern graph
+      :param edits: The edits applied in order at each match of ``pattern``
+      :param vertex_strictness: Strictness of pattern atom matching
+      :param edge_strictness: Strictness of pattern bond matching
+      :param product_components: Components in which products are
+        canonicalized and distinguished
+    )delim"
+  );
+
+  reactionTemplate.def_property_readonly(
+    "query",
+    &ReactionTemplate::query,
+    "The compiled reactant pattern"
+  );
+
+  reactionTemplate.def_property_readonly(
+    "edits",
+    &ReactionTemplate::edits,
+    "Edits applied at each match"
+  );
+
+  reactionTemplate.def(
+    "apply",
+    &ReactionTemplate::apply,
+    pybind11::arg("reactant"),
+    pybind11::call_guard<pybind11::gil_scoped_release>(),
+    R"delim(
+      Distinct products of applying the edits at each match of the pattern in
+      parallel. Products are canonical in the product components. Matches at
+      which a bond removal would disconnect the molecule yield no product.
+
+      :param reactant: The molecule to apply the template to
+      :return: Distinct products in order of the first match producing each
+    )delim"
+  );
+}
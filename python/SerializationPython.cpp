@@ -55,6 +55,23 @@ std::string toString(const Scine::Molassembler::JsonSerialization& s) {
   return s;
 }
 
+pybind11::list pythonBytesListFromBinaries(const std::vector<std::vector<std::uint8_t>>& binaries) {
+  pybind11::list bytesList;
+  for(const auto& binary : binaries) {
+    bytesList.append(pythonBytesFromBinary(binary));
+  }
+  return bytesList;
+}
+
+std::vector<std::vector<std::uint8_t>> binariesFromPythonBytesList(const std::vector<pybind11::bytes>& bytesList) {
+  std::vector<std::vector<std::uint8_t>> binaries;
+  binaries.reserve(bytesList.size());
+  for(const auto& bytes : bytesList) {
+    binaries.push_back(binaryFromPythonBytes(bytes));
+  }
+  return binaries;
+}
+
 void init_serialization(pybind11::module& m) {
   using namespace Scine::Molassembler;
 
@@ -91,12 +108,14 @@ void init_serialization(pybind11::module& m) {
   serialization.def(
     pybind11::init<const std::string&>(),
     pybind11::arg("json_string"),
+    pybind11::call_guard<pybind11::gil_scoped_release>(),
     "Parse a JSON molecule serialization"
   );
 
   serialization.def(
     pybind11::init<const Molecule&>(),
     pybind11::arg("molecule"),
+    pybind11::call_guard<pybind11::gil_scoped_release>(),
     "Serialize a molecule into JSON"
   );
 
@@ -125,27 +144,82 @@ void init_serialization(pybind11::module& m) {
     "Decode base-64 string into binary"
   );
 
+  serialization.def_static(
+    "serialize_many",
+    pybind11::overload_cast<const std::vector<Molecule>&>(&JsonSerialization::serializeMany),
+    pybind11::arg("molecules"),
+    pybind11::call_guard<pybind11::gil_scoped_release>(),
+    R"delim(
+      Serialize many molecules into JSON strings in parallel without holding
+      the GIL
+
+      >>> molecules = [io.experimental.from_smiles(s) for s in ["CCO", "C=CC"]]
+      >>> strings = JsonSerialization.serialize_many(molecules)
+      >>> JsonSerialization.deserialize_many(strings) == molecules
+      True
+    )delim"
+  );
+
+  serialization.def_static(
+    "serialize_many",
+    [](const std::vector<Molecule>& molecules, const JsonSerialization::BinaryFormat format) {
+      std::vector<JsonSerialization::BinaryType> binaries;
+      {
+        pybind11::gil_scoped_release release;
+        binaries = JsonSerialization::serializeMany(molecules, format);
+      }
+      return pythonBytesListFromBinaries(binaries);
+    },
+    pybind11::arg("molecules"),
+    pybind11::arg("binary_format"),
+    "Serialize many molecules into a binary JSON format in parallel"
+  );
+
+  serialization.def_static(
+    "deserialize_many",
+    pybind11::overload_cast<const std::vector<std::string>&>(&JsonSerialization::deserializeMany),
+    pybind11::arg("json_strings"),
+    pybind11::call_guard<pybind11::gil_scoped_release>(),
+    "Deserialize many molecules from JSON strings in parallel"
+  );
+
+  serialization.def_static(
+    "deserialize_many",
+    [](const std::vector<pybind11::bytes>& bytesList, const JsonSerialization::BinaryFormat format) {
+      const auto binaries = binariesFromPythonBytesList(bytesList);
+      pybind11::gil_scoped_release release;
+      return JsonSerialization::deserializeMany(binaries, format);
+    },
+    pybind11::arg("bytes_list"),
+    pybind11::arg("binary_format"),
+    "Deserialize many molecules from a binary JSON format in parallel"
+  );
+
   serialization.def(
     "__str__",
     &JsonSerialization::operator std::string,
+    pybind11::call_guard<pybind11::gil_scoped_release>(),
     "Dump the JSON serialization into a string"
   );
 
   serialization.def(
     "to_string",
     &JsonSerialization::operator std::string,
+    pybind11::call_guard<pybind11::gil_scoped_release>(),
     "Dump the JSON serialization into a string"
   );
 
   serialization.def(
     "standardize",
     &JsonSerialization::standardize,
+    pybind11::call_guard<pybind11::gil_scoped_release>(),
     "Standardize the internal JSON serialization (only for canonical molecules)"
   );
 
   serialization.def(
     "to_molecule",
     &JsonSerialization::operator Scine::Molassembler::Molecule,
+    pybind11::call_guard<pybind11::gil_scoped_release>(),
     "Construct a molecule from the serialization"
   );
 
@@ -155,4 +229,151 @@ void init_serialization(pybind11::module& m) {
     pybind11::arg("binary_format"),
     "Serialize a molecule into a binary format"
   );
+
+  pybind11::class_<CompactSerialization> compact(
+    m,
+    "CompactSerialization",
+    R"delim(
+      Versioned fixed-layout binary serialization of molecules that is read
+      without an intermediate JSON document
+
+      >>> spiro = io.experimental.from_smiles("C12(CCCC1)CCC2")
+      >>> spiro_as_bytes = CompactSerialization.serialize(spiro)
+      >>> CompactSerialization.deserialize(spiro_as_bytes) == spiro
+      True
+    )delim"
+  );
+
+  pybind11::enum_<CompactSerialization::Validation> validation(
+    compact,
+    "Validation",
+    "Extent of consistency checks during deserialization"
+  );
+  validation.value(
+    "Full",
+    CompactSerialization::Validation::Full,
+    "Check all data and model bond stereopermutator feasibility anew"
+  );
+  validation.value(
+    "Checksum",
+    CompactSerialization::Validation::Checksum,
+    "Trust checksum-verified data, using stored bond stereopermutator feasibilities"
+  );
+
+  compact.def_static(
+    "serialize",
+    [](const Molecule& molecule) -> pybind11::bytes {
+      CompactSerialization::BinaryType binary;
+      {
+        pybind11::gil_scoped_release release;
+        binary = CompactSerialization::serialize(molecule);
+      }
+      return pythonBytesFromBinary(binary);
+    },
+    pybind11::arg("molecule"),
+    "Serialize a molecule into the compact binary format"
+  );
+
+  compact.def_static(
+    "canonical_serialize",
+    [](const Molecule& molecule) -> pybind11::bytes {
+      CompactSerialization::BinaryType binary;
+      {
+        pybind11::gil_scoped_release release;
+        binary = CompactSerialization::canonicalSerialize(molecule);
+      }
+      return pythonBytesFromBinary(binary);
+    },
+    pybind11::arg("molecule"),
+    R"delim(
+      Serialize a molecule canonically into the compact binary format
+
+      Identical molecules yield identical bytes regardless of their atom order.
+
+      >>> a = io.experimental.from_smiles("C[C@H](O)CC")
+      >>> b = io.experimental.from_smiles("CC[C@@H](O)C")
+      >>> CompactSerialization.canonical_serialize(a) == CompactSerialization.canonical_serialize(b)
+      True
+    )delim"
+  );
+
+  compact.def_static(
+    "digest",
+    [](const pybind11::bytes& bytes) -> std::uint64_t {
+      const std::string binary = bytes;
+      return CompactSerialization::digest(
+        reinterpret_cast<const std::uint8_t*>(binary.data()),
+        binary.size()
+      );
+    },
+    pybind11::arg("bytes"),
+    R"delim(
+      Content digest of a compact binary serialization, read without
+      deserializing. Distinct serializations may rarely share a digest, so
+      compare serializations with equal digests to confirm duplicates.
+    )delim"
+  );
+
+  compact.def_static(
+    "deserialize",
+    [](const pybind11::bytes& bytes, const CompactSerialization::Validation validation) -> Molecule {
+      const std::string binary = bytes;
+      pybind11::gil_scoped_release release;
+      return CompactSerialization::deserialize(
+        reinterpret_cast<const std::uint8_t*>(binary.data()),
+        binary.size(),
+        validation
+      );
+    },
+    pybind11::arg("bytes"),
+    pybind11::arg("validation") = CompactSerialization::Validation::Full,
+    "Deserialize a molecule from the compact binary format"
+  );
+
+  compact.def_static(
+    "serialize_many",
+    [](const std::vector<Molecule>& molecules) {
+      std::vector<CompactSerialization::BinaryType> binaries;
+      {
+        pybind11::gil_scoped_release release;
+        binaries = CompactSerialization::serializeMany(molecules);
+      }
+      return pythonBytesListFromBinaries(binaries);
+    },
+    pybind11::arg("molecules"),
+    "Serialize many molecules in parallel without holding the GIL"
+  );
+
+  compact.def_static(
+    "deserialize_many",
+    [](
+      const std::vector<pybind11::bytes>& bytesList,
+      const CompactSerialization::Validation validation
+    ) {
+      const auto binaries = binariesFromPythonBytesList(bytesList);
+      pybind11::gil_scoped_release release;
+      return CompactSerialization::deserializeMany(binaries, validation);
+    },
+    pybind11::arg("bytes_list"),
+    pybind11::arg("validation") = CompactSerialization::Validation::Full,
+    "Deserialize many molecules in parallel without holding the GIL"
+  );
+
+  compact.def_static(
+    "write",
+    &CompactSerialization::write,
+    pybind11::arg("filename"),
+    pybind11::arg("molecule"),
+    pybind11::call_guard<pybind11::gil_scoped_release>(),
+    "Write a molecule's compact binary serialization to a file"
+  );
+
+  compact.def_static(
+    "read",
+    &CompactSerialization::read,
+    pybind11::arg("filename"),
+    pybind11::arg("validation") = CompactSerialization::Validation::Full,
+    pybind11::call_guard<pybind11::gil_scoped_release>(),
+    "Read a molecule from a file in the compact binary format"
+  );
 }
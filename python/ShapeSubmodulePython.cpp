@@ -8,6 +8,7 @@
 
 #include "Molassembler/Shapes/Data.h"
 #include "Molassembler/Shapes/ContinuousMeasures.h"
+#include "Molassembler/Temple/Functional.h"
 
 void init_shape_submodule(pybind11::module& m) {
   using namespace Scine::Molassembler;
@@ -128,6 +129,30 @@ void init_shape_submodule(pybind11::module& m) {
     "Calculates shape measure with centroid pre-matched, last in normalized positions"
   );
 
+  continuousSubmodule.def(
+    "shape_centroid_last",
+    [](
+      const std::vector<Shapes::Continuous::PositionCollection>& normalizedPositionsList,
+      const std::vector<Shapes::Shape>& shapes
+    ) -> std::vector<std::vector<double>> {
+      return Temple::map(
+        Shapes::Continuous::shapeCentroidLast(normalizedPositionsList, shapes),
+        [](const auto& results) {
+          return Temple::map(results, [](const auto& result) { return result.measure; });
+        }
+      );
+    },
+    pybind11::arg("normalized_positions_list"),
+    pybind11::arg("shapes"),
+    R"delim(
+      Calculates shape measures of many normalized position sets with respect
+      to several shapes, with centroids pre-matched, last in normalized
+      positions
+
+      :returns: Shape measures indexed by position set, then by shape
+    )delim"
+  );
+
   continuousSubmodule.def(
     "probability_random_cloud",
     &Shapes::Continuous::probabilityRandomCloud,
@@ -5,6 +5,7 @@
  */
 
 #include "TypeCasters.h"
+#include "pybind11/functional.h"
 
 #include "Molassembler/Molecule.h"
 #include "Molassembler/Graph.h"
@@ -133,7 +134,8 @@ void init_subgraphs(pybind11::module& m) {
     pybind11::arg("needle"),
     pybind11::arg("haystack"),
     pybind11::arg("vertex_strictness") = Subgraphs::VertexStrictness::ElementType,
-    pybind11::arg("edge_strictness") = Subgraphs::EdgeStrictness::Topographic
+    pybind11::arg("edge_strictness") = Subgraphs::EdgeStrictness::Topographic,
+    pybind11::call_guard<pybind11::gil_scoped_release>()
   );
 
   subgraphs.def(
@@ -147,21 +149,190 @@ void init_subgraphs(pybind11::module& m) {
     pybind11::arg("needle"),
     pybind11::arg("haystack"),
     pybind11::arg("vertex_strictness") = Subgraphs::VertexStrictness::ElementType,
+    pybind11::arg("edge_strictness") = Subgraphs::EdgeStrictness::Topographic,
+    pybind11::call_guard<pybind11::gil_scoped_release>()
+  );
+
+  pybind11::enum_<Subgraphs::Uniqueness> uniqueness(
+    subgraphs,
+    "Uniqueness",
+    "Which mappings of a needle are considered distinct"
+  );
+
+  uniqueness.value(
+    "All",
+    Subgraphs::Uniqueness::All,
+    "Every mapping is distinct"
+  );
+
+  uniqueness.value(
+    "HydrogenPermutation",
+    Subgraphs::Uniqueness::HydrogenPermutation,
+    "Mappings differing only in permutations of haystack hydrogen atoms are equivalent"
+  );
+
+  uniqueness.value(
+    "AtomSet",
+    Subgraphs::Uniqueness::AtomSet,
+    "Mappings onto the same set of haystack atoms are equivalent"
+  );
+
+  pybind11::class_<Subgraphs::Query> query(
+    subgraphs,
+    "Query",
+    R"delim(
+      Subgraph search for a needle preprocessed once for many haystacks.
+      Haystacks whose element and bond type counts cannot accommodate the
+      needle are rejected before matching.
+    )delim"
+  );
+
+  query.def(
+    pybind11::init<const Graph&, Subgraphs::VertexStrictness, Subgraphs::EdgeStrictness>(),
+    pybind11::arg("needle"),
+    pybind11::arg("vertex_strictness") = Subgraphs::VertexStrictness::ElementType,
     pybind11::arg("edge_strictness") = Subgraphs::EdgeStrictness::Topographic
   );
 
+  query.def_property_readonly("needle", &Subgraphs::Query::needle, "The compiled needle graph");
+
+  query.def(
+    "may_match",
+    &Subgraphs::Query::mayMatch,
+    pybind11::arg("haystack"),
+    "Whether the fingerprint of a haystack can accommodate the needle"
+  );
+
+  query.def(
+    "__call__",
+    pybind11::overload_cast<const Graph&>(&Subgraphs::Query::operator(), pybind11::const_),
+    pybind11::arg("haystack"),
+    pybind11::call_guard<pybind11::gil_scoped_release>(),
+    "Searches for the needle in a haystack"
+  );
+
+  query.def(
+    "__call__",
+    pybind11::overload_cast<const Molecule&>(&Subgraphs::Query::operator(), pybind11::const_),
+    pybind11::arg("haystack"),
+    pybind11::call_guard<pybind11::gil_scoped_release>(),
+    "Searches for the needle in a haystack"
+  );
+
+  query.def(
+    "__call__",
+    pybind11::overload_cast<const Graph&, Subgraphs::Uniqueness>(&Subgraphs::Query::operator(), pybind11::const_),
+    pybind11::arg("haystack"),
+    pybind11::arg("uniqueness"),
+    pybind11::call_guard<pybind11::gil_scoped_release>(),
+    "Searches for distinct mappings of the needle in a haystack"
+  );
+
+  query.def(
+    "for_each",
+    &Subgraphs::Query::forEach,
+    pybind11::arg("haystack"),
+    pybind11::arg("callback"),
+    pybind11::arg("uniqueness") = Subgraphs::Uniqueness::HydrogenPermutation,
+    pybind11::call_guard<pybind11::gil_scoped_release>(),
+    R"delim(
+      Calls a function with the haystack atom index of each needle atom for
+      each distinct mapping. The enumeration stops if the function returns
+      False. Returns whether the enumeration ran to completion.
+    )delim"
+  );
+
+  query.def(
+    "exists",
+    &Subgraphs::Query::exists,
+    pybind11::arg("haystack"),
+    pybind11::call_guard<pybind11::gil_scoped_release>(),
+    "Whether there is any mapping of the needle in a haystack"
+  );
+
+  query.def(
+    "count",
+    &Subgraphs::Query::count,
+    pybind11::arg("haystack"),
+    pybind11::arg("uniqueness") = Subgraphs::Uniqueness::HydrogenPermutation,
+    pybind11::call_guard<pybind11::gil_scoped_release>(),
+    "Number of distinct mappings of the needle in a haystack"
+  );
+
+  subgraphs.def(
+    "complete",
+    pybind11::overload_cast<
+      const Subgraphs::Query&,
+      const std::vector<Graph>&
+    >(&Subgraphs::complete),
+    pybind11::arg("query"),
+    pybind11::arg("haystacks"),
+    pybind11::call_guard<pybind11::gil_scoped_release>(),
+    "Searches for a compiled needle in many haystacks in parallel"
+  );
+
+  subgraphs.def(
+    "complete",
+    pybind11::overload_cast<
+      const std::vector<Subgraphs::Query>&,
+      const Graph&
+    >(&Subgraphs::complete),
+    pybind11::arg("queries"),
+    pybind11::arg("haystack"),
+    pybind11::call_guard<pybind11::gil_scoped_release>(),
+    "Searches for many compiled needles in a haystack in parallel"
+  );
+
+  pybind11::class_<Subgraphs::MaximumConfiguration> maximumConfiguration(
+    subgraphs,
+    "MaximumConfiguration",
+    R"delim(
+      Limits and goals of maximum common subgraph searches. If a search is
+      stopped by a limit, the largest mappings found so far are returned.
+    )delim"
+  );
+
+  maximumConfiguration.def(pybind11::init<>());
+
+  maximumConfiguration.def_readwrite(
+    "time_limit",
+    &Subgraphs::MaximumConfiguration::timeLimit,
+    "Wall time limit of the search in seconds. Unlimited if not positive."
+  );
+
+  maximumConfiguration.def_readwrite(
+    "node_limit",
+    &Subgraphs::MaximumConfiguration::nodeLimit,
+    "Limit on the number of search tree nodes. Unlimited if zero."
+  );
+
+  maximumConfiguration.def_readwrite(
+    "size_target",
+    &Subgraphs::MaximumConfiguration::sizeTarget,
+    "Stop as soon as a mapping of this many atoms is found. Disabled if zero."
+  );
+
+  maximumConfiguration.def_readwrite(
+    "all_maxima",
+    &Subgraphs::MaximumConfiguration::allMaxima,
+    "Whether to find all maximum mappings up to hydrogen permutations"
+  );
+
   subgraphs.def(
     "maximum",
     pybind11::overload_cast<
       const Graph&,
       const Graph&,
       Subgraphs::VertexStrictness,
-      Subgraphs::EdgeStrictness
+      Subgraphs::EdgeStrictness,
+      const Subgraphs::MaximumConfiguration&
     >(&Subgraphs::maximum),
     pybind11::arg("needle"),
     pybind11::arg("haystack"),
     pybind11::arg("vertex_strictness") = Subgraphs::VertexStrictness::ElementType,
-    pybind11::arg("edge_strictness") = Subgraphs::EdgeStrictness::Topographic
+    pybind11::arg("edge_strictness") = Subgraphs::EdgeStrictness::Topographic,
+    pybind11::arg("configuration") = Subgraphs::MaximumConfiguration {},
+    pybind11::call_guard<pybind11::gil_scoped_release>()
   );
 
   subgraphs.def(
@@ -170,11 +341,14 @@ void init_subgraphs(pybind11::module& m) {
       const Molecule&,
       const Molecule&,
       Subgraphs::VertexStrictness,
-      Subgraphs::EdgeStrictness
+      Subgraphs::EdgeStrictness,
+      const Subgraphs::MaximumConfiguration&
     >(&Subgraphs::maximum),
     pybind11::arg("needle"),
     pybind11::arg("haystack"),
     pybind11::arg("vertex_strictness") = Subgraphs::VertexStrictness::ElementType,
-    pybind11::arg("edge_strictness") = Subgraphs::EdgeStrictness::Topographic
+    pybind11::arg("edge_strictness") = Subgraphs::EdgeStrictness::Topographic,
+    pybind11::arg("configuration") = Subgraphs::MaximumConfiguration {},
+    pybind11::call_guard<pybind11::gil_scoped_release>()
   );
 }
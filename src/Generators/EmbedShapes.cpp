@@ -0,0 +1,110 @@
+/*!@file
+ * @copyright This code is licensed under the 3-clause BSD license.
+ *   Copyright ETH Zurich, Laboratory of Physical Chemistry, Reiher Group.
+ *   See LICENSE.txt for details.
+ * @brief Build-time generator of the shape data embedded into the library
+ *
+ * Compiled with the constexpr shape data only. Writes the runtime shape data
+ * in the layout decoded by Shapes/Data.cpp if built with
+ * MOLASSEMBLER_EMBEDDED_SHAPES.
+ */
+
+#include "Molassembler/Shapes/Data.h"
+
+#include "boost/optional.hpp"
+
+#include <array>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace Scine::Molassembler;
+
+template<typename T>
+void writeBinary(std::ostream& os, const T value) {
+  os.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+void writeShape(std::ostream& os, const Shapes::Shape shape) {
+  const std::string& name = Shapes::name(shape);
+  const unsigned S = Shapes::size(shape);
+
+  writeBinary<std::uint32_t>(os, name.size());
+  os.write(name.data(), name.size());
+  writeBinary<std::uint32_t>(os, S);
+  writeBinary<std::uint32_t>(os, static_cast<unsigned>(Shapes::pointGroup(shape)));
+  writeBinary<std::uint8_t>(os, Shapes::threeDimensional(shape) ? 1 : 0);
+
+  const Shapes::Coordinates coordinates = Shapes::coordinates(shape);
+  for(unsigned i = 0; i < coordinates.size(); ++i) {
+    writeBinary<double>(os, coordinates.data()[i]);
+  }
+
+  const auto& rotations = Shapes::rotations(shape);
+  writeBinary<std::uint32_t>(os, rotations.size());
+  for(const auto& rotation : rotations) {
+    for(const Shapes::Vertex v : rotation) {
+      writeBinary<std::uint8_t>(os, v);
+    }
+  }
+
+  const auto& tetrahedra = Shapes::tetrahedra(shape);
+  writeBinary<std::uint32_t>(os, tetrahedra.size());
+  for(const auto& tetrahedron : tetrahedra) {
+    for(const auto& vertexOption : tetrahedron) {
+      writeBinary<std::uint8_t>(os, vertexOption ? vertexOption.value() : 0xff);
+    }
+  }
+
+  const auto& mirror = Shapes::mirror(shape);
+  writeBinary<std::uint32_t>(os, mirror.size());
+  for(const Shapes::Vertex v : mirror) {
+    writeBinary<std::uint8_t>(os, v);
+  }
+
+  const auto angleFunction = Shapes::angleFunction(shape);
+  for(unsigned i = 0; i < S; ++i) {
+    for(unsigned j = 0; j < S; ++j) {
+      writeBinary<double>(os, angleFunction(Shapes::Vertex(i), Shapes::Vertex(j)));
+    }
+  }
+}
+
+int main(int argc, char* argv[]) {
+  if(argc != 2) {
+    std::cerr << "Usage: " << argv[0] << " <output file>\n";
+    return 1;
+  }
+
+  const std::string filename = argv[1];
+  std::ofstream file(filename, std::ios::binary);
+  if(!file) {
+    std::cerr << "Could not open " << filename << " for writing\n";
+    return 1;
+  }
+
+  // Serialize the records first to determine their offsets
+  std::vector<std::string> records;
+  for(const Shapes::Shape shape : Shapes::allShapes) {
+    std::ostringstream record;
+    writeShape(record, shape);
+    records.push_back(record.str());
+  }
+
+  const std::array<char, 8> magic {{'M', 'A', 'S', 'M', 'S', 'H', 'P', '1'}};
+  file.write(magic.data(), magic.size());
+  writeBinary<std::uint32_t>(file, Shapes::nShapes);
+  std::uint32_t offset = magic.size() + (Shapes::nShapes + 1) * sizeof(std::uint32_t);
+  for(const auto& record : records) {
+    writeBinary<std::uint32_t>(file, offset);
+    offset += record.size();
+  }
+  for(const auto& record : records) {
+    file.write(record.data(), record.size());
+  }
+
+  return 0;
+}
@@ -0,0 +1,28 @@
+/*!@file
+ * @copyright This code is licensed under the 3-clause BSD license.
+ *   Copyright ETH Zurich, Laboratory of Physical Chemistry, Reiher Group.
+ *   See LICENSE.txt for details.
+ * @brief Build-time generator of the shape transitions embedded into the
+ *   library
+ */
+
+#include "Molassembler/Shapes/PropertyCaching.h"
+
+#include <iostream>
+#include <string>
+
+using namespace Scine::Molassembler;
+
+int main(int argc, char* argv[]) {
+  if(argc != 3) {
+    std::cerr << "Usage: " << argv[0] << " <output file> <maximum shape size>\n";
+    return 1;
+  }
+
+  const std::string filename = argv[1];
+  const unsigned maxShapeSize = std::stoul(argv[2]);
+
+  Shapes::precomputeMappings(maxShapeSize);
+  Shapes::writeMappings(filename);
+  return 0;
+}
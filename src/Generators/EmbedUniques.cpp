@@ -0,0 +1,28 @@
+/*!@file
+ * @copyright This code is licensed under the 3-clause BSD license.
+ *   Copyright ETH Zurich, Laboratory of Physical Chemistry, Reiher Group.
+ *   See LICENSE.txt for details.
+ * @brief Build-time generator of the unique stereopermutations embedded into
+ *   the library
+ */
+
+#include "Molassembler/Stereopermutation/Manipulation.h"
+
+#include <iostream>
+#include <string>
+
+using namespace Scine::Molassembler;
+
+int main(int argc, char* argv[]) {
+  if(argc != 3) {
+    std::cerr << "Usage: " << argv[0] << " <output file> <maximum shape size>\n";
+    return 1;
+  }
+
+  const std::string filename = argv[1];
+  const unsigned maxShapeSize = std::stoul(argv[2]);
+
+  Stereopermutations::precomputeUniques(maxShapeSize);
+  Stereopermutations::writeUniques(filename);
+  return 0;
+}
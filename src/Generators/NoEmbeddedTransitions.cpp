@@ -0,0 +1,21 @@
+/*!@file
+ * @copyright This code is licensed under the 3-clause BSD license.
+ *   Copyright ETH Zurich, Laboratory of Physical Chemistry, Reiher Group.
+ *   See LICENSE.txt for details.
+ * @brief Empty embedded shape transitions for the generators
+ */
+
+#include <cstddef>
+
+namespace Scine {
+namespace Molassembler {
+namespace Shapes {
+namespace Detail {
+
+extern const unsigned char embeddedTransitions[] = {0};
+extern const std::size_t embeddedTransitionsSize = 0;
+
+} // namespace Detail
+} // namespace Shapes
+} // namespace Molassembler
+} // namespace Scine
@@ -0,0 +1,21 @@
+/*!@file
+ * @copyright This code is licensed under the 3-clause BSD license.
+ *   Copyright ETH Zurich, Laboratory of Physical Chemistry, Reiher Group.
+ *   See LICENSE.txt for details.
+ * @brief Empty embedded unique stereopermutations for the generators
+ */
+
+#include <cstddef>
+
+namespace Scine {
+namespace Molassembler {
+namespace Stereopermutations {
+namespace Detail {
+
+extern const unsigned char embeddedUniques[] = {0};
+extern const std::size_t embeddedUniquesSize = 0;
+
+} // namespace Detail
+} // namespace Stereopermutations
+} // namespace Molassembler
+} // namespace Scine
@@ -25,9 +25,23 @@ AngstromPositions::AngstromPositions(
   }
 }
 
-Utils::PositionCollection AngstromPositions::getBohr() const {
+AngstromPositions::AngstromPositions(
+  Utils::PositionCollection&& pos,
+  const LengthUnit lengthUnit
+) : positions(std::move(pos)) {
+  if(lengthUnit == LengthUnit::Bohr) {
+    positions *= Utils::Constants::angstrom_per_bohr;
+  }
+}
+
+Utils::PositionCollection AngstromPositions::getBohr() const & {
   return positions * Utils::Constants::bohr_per_angstrom;
 }
 
+Utils::PositionCollection AngstromPositions::getBohr() && {
+  positions *= Utils::Constants::bohr_per_angstrom;
+  return std::move(positions);
+}
+
 } // namespace Molassembler
 } // namespace Scine
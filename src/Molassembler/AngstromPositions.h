@@ -36,9 +36,16 @@ public:
     const Utils::PositionCollection& pos,
     LengthUnit lengthUnit = LengthUnit::Bohr
   );
+  //! Convert from a Utils::PositionCollection, scaling its buffer in place
+  explicit AngstromPositions(
+    Utils::PositionCollection&& pos,
+    LengthUnit lengthUnit = LengthUnit::Bohr
+  );
 
   //! Fetch a bohr representation of the wrapped positions
-  Utils::PositionCollection getBohr() const;
+  Utils::PositionCollection getBohr() const &;
+  //! Convert the wrapped positions to bohr in place and release them
+  Utils::PositionCollection getBohr() &&;
 };
 
 } // namespace molassmbler
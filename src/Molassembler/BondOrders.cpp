@@ -7,55 +7,439 @@
 #include "Molassembler/BondOrders.h"
 
 #include "Utils/Typenames.h"
+#include "Utils/Constants.h"
 #include "Utils/Bonds/BondOrderCollection.h"
-#include "Utils/Geometry/AtomCollection.h"
-#include "Utils/Bonds/BondDetector.h"
+#include "Utils/Bonds/BondDetectorRadii.h"
 
 #include "Molassembler/AngstromPositions.h"
 #include "Molassembler/Modeling/BondDistance.h"
+#include "Molassembler/PeriodicCell.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <tuple>
 
 namespace Scine {
 namespace Molassembler {
+namespace {
 
-Utils::BondOrderCollection uffBondOrders(
+using Cell = std::array<long, 3>;
+
+//! Tolerance in Angstrom added to the sum of covalent radii, as in Utils::BondDetector
+constexpr double covalentBondTolerance = 0.4;
+
+//! Grid of cubic cells that atoms are sorted into, reusing its storage
+struct CellGrid {
+  //! Sorts atoms into cells of a particular edge length
+  void sort(const Utils::PositionCollection& positions, const double cellLength) {
+    const unsigned N = positions.rows();
+    const Eigen::RowVector3d minimum = positions.colwise().minCoeff();
+    atomCells.resize(N);
+    for(unsigned i = 0; i < N; ++i) {
+      for(unsigned k = 0; k < 3; ++k) {
+        atomCells[i][k] = static_cast<long>(std::floor((positions(i, k) - minimum(k)) / cellLength));
+      }
+    }
+    sortedAtoms.resize(N);
+    for(unsigned i = 0; i < N; ++i) {
+      sortedAtoms[i] = i;
+    }
+    std::sort(
+      std::begin(sortedAtoms),
+      std::end(sortedAtoms),
+      [&](const AtomIndex a, const AtomIndex b) { return atomCells[a] < atomCells[b]; }
+    );
+    sortedCells.resize(N);
+    for(unsigned i = 0; i < N; ++i) {
+      sortedCells[i] = atomCells[sortedAtoms[i]];
+    }
+  }
+
+  //! Calls a function with each greater atom index in the same or adjacent cells
+  template<typename UnaryFunction>
+  void forEachNeighbor(const AtomIndex i, UnaryFunction&& function) const {
+    const Cell& cell = atomCells[i];
+    for(long dx = -1; dx <= 1; ++dx) {
+      for(long dy = -1; dy <= 1; ++dy) {
+        for(long dz = -1; dz <= 1; ++dz) {
+          const Cell neighbor {{cell[0] + dx, cell[1] + dy, cell[2] + dz}};
+          const auto range = std::equal_range(std::begin(sortedCells), std::end(sortedCells), neighbor);
+          for(auto iter = range.first; iter != range.second; ++iter) {
+            const AtomIndex j = sortedAtoms[iter - std::begin(sortedCells)];
+            if(j > i) {
+              function(j);
+            }
+          }
+        }
+      }
+    }
+  }
+
+  std::vector<Cell> atomCells;
+  std::vector<AtomIndex> sortedAtoms;
+  std::vector<Cell> sortedCells;
+};
+
+/*! @brief Grid of cells in fractional coordinates of a periodic cell, reusing
+ *   its storage
+ *
+ * Adjacency of cells wraps around the periodic cell, so that pairs of atoms
+ * closer than the cutoff in their minimum image are in adjacent cells.
+ */
+struct PeriodicGrid {
+  /*! @brief Sorts wrapped atoms into cells at least as wide as a cutoff
+   *
+   * @throws std::invalid_argument If the cutoff exceeds half of a face
+   *   distance of the cell, where minimum images are no longer unique
+   */
+  void sort(
+    const Utils::PositionCollection& positions,
+    const PeriodicCell& cell,
+    const double cutoff
+  ) {
+    const Eigen::Vector3d faceDistances = cell.faceDistances();
+    if(2 * cutoff > faceDistances.minCoeff()) {
+      throw std::invalid_argument(
+        "Periodic cell is too small for minimum image bond perception. "
+        "Face distances must be at least " + std::to_string(2 * cutoff) + " Angstrom."
+      );
+    }
+
+    for(unsigned k = 0; k < 3; ++k) {
+      counts[k] = std::max(1L, static_cast<long>(faceDistances(k) / cutoff));
+    }
+
+    const unsigned N = positions.rows();
+    atomCells.resize(N);
+    for(unsigned i = 0; i < N; ++i) {
+      const Eigen::Vector3d fractional = cell.fractional(positions.row(i).transpose());
+      for(unsigned k = 0; k < 3; ++k) {
+        const double wrapped = fractional(k) - std::floor(fractional(k));
+        atomCells[i][k] = std::min(counts[k] - 1, static_cast<long>(wrapped * counts[k]));
+      }
+    }
+
+    // Counting sort of atoms by their flat cell index
+    cellStarts.assign(counts[0] * counts[1] * counts[2] + 1, 0);
+    for(unsigned i = 0; i < N; ++i) {
+      ++cellStarts[flatIndex(atomCells[i]) + 1];
+    }
+    for(unsigned c = 1; c < cellStarts.size(); ++c) {
+      cellStarts[c] += cellStarts[c - 1];
+    }
+    sortedAtoms.resize(N);
+    std::vector<unsigned> fill(std::begin(cellStarts), std::end(cellStarts) - 1);
+    for(unsigned i = 0; i < N; ++i) {
+      sortedAtoms[fill[flatIndex(atomCells[i])]++] = i;
+    }
+  }
+
+  long flatIndex(const Cell& cell) const {
+    return (cell[0] * counts[1] + cell[1]) * counts[2] + cell[2];
+  }
+
+  //! Calls a function with each greater atom index in the same or adjacent cells
+  template<typename UnaryFunction>
+  void forEachNeighbor(const AtomIndex i, UnaryFunction&& function) const {
+    // Wrapped adjacent indices along each axis, without duplicates in narrow grids
+    std::array<std::array<long, 3>, 3> adjacent;
+    std::array<unsigned, 3> adjacentCounts;
+    for(unsigned k = 0; k < 3; ++k) {
+      const long c = atomCells[i][k];
+      adjacent[k][0] = c;
+      adjacentCounts[k] = 1;
+      if(counts[k] >= 2) {
+        adjacent[k][adjacentCounts[k]++] = (c + 1) % counts[k];
+      }
+      if(counts[k] >= 3) {
+        adjacent[k][adjacentCounts[k]++] = (c + counts[k] - 1) % counts[k];
+      }
+    }
+
+    for(unsigned a = 0; a < adjacentCounts[0]; ++a) {
+      for(unsigned b = 0; b < adjacentCounts[1]; ++b) {
+        for(unsigned c = 0; c < adjacentCounts[2]; ++c) {
+          const long flat = flatIndex(Cell {{adjacent[0][a], adjacent[1][b], adjacent[2][c]}});
+          for(unsigned s = cellStarts[flat]; s < cellStarts[flat + 1]; ++s) {
+            const AtomIndex j = sortedAtoms[s];
+            if(j > i) {
+              function(j);
+            }
+          }
+        }
+      }
+    }
+  }
+
+  Cell counts;
+  std::vector<Cell> atomCells;
+  std::vector<unsigned> cellStarts;
+  std::vector<AtomIndex> sortedAtoms;
+};
+
+void checkSizes(const Utils::ElementTypeCollection& elements, const AngstromPositions& angstromPositions) {
+  if(static_cast<unsigned>(angstromPositions.positions.rows()) != elements.size()) {
+    throw std::invalid_argument("Number of elements and positions do not match");
+  }
+}
+
+/* A pair's bond order is at least the minimum order if their distance is
+ * less than the sum of their bond radii times a factor. Yields the largest
+ * such distance of any pair of the present elements.
+ */
+double uffCutoff(const Utils::ElementTypeCollection& elements, const double minimumOrder) {
+  if(!(minimumOrder > 0)) {
+    throw std::invalid_argument("Minimum bond order must be positive");
+  }
+
+  const double cutoffFactor = 1 - Bond::bondOrderCorrectionLambda * std::log(minimumOrder);
+  double maximumRadius = 0.0;
+  for(const Utils::ElementType e : elements) {
+    maximumRadius = std::max(maximumRadius, AtomInfo::bondRadius(e));
+  }
+  return 2 * maximumRadius * cutoffFactor;
+}
+
+//! Evaluates UFF bond orders of the atom pairs in adjacent cells of a grid
+template<typename Grid, typename Displacement>
+std::vector<FractionalBond> uffGridBonds(
   const Utils::ElementTypeCollection& elements,
-  const AngstromPositions& angstromPositions
+  const Grid& grid,
+  Displacement&& displacement,
+  const double minimumOrder
 ) {
   const unsigned N = elements.size();
+  std::vector<FractionalBond> bonds;
+  bool unreasonable = false;
 
-  Utils::BondOrderCollection bondOrders(N);
-
-  for(unsigned i = 0; i < N; ++i) {
-    for(unsigned j = i + 1; j < N; ++j) {
-      double bondOrder = Bond::calculateBondOrder(
-        elements.at(i),
-        elements.at(j),
-        (
-          angstromPositions.positions.row(j)
-          - angstromPositions.positions.row(i)
-        ).norm()
-      );
+#pragma omp parallel
+  {
+    std::vector<FractionalBond> threadBonds;
 
-      if(bondOrder > 6.5) {
-        throw std::logic_error(
-          "Structure bond order interpretation yields bond orders greater than "
-          "sextuple. The structure is most likely unreasonable."
+#pragma omp for schedule(dynamic, 64)
+    for(unsigned i = 0; i < N; ++i) {
+      grid.forEachNeighbor(i, [&](const AtomIndex j) {
+        const double bondOrder = Bond::calculateBondOrder(
+          elements[i],
+          elements[j],
+          displacement(i, j).norm()
         );
-      }
 
-      bondOrders.setOrder(i, j, bondOrder);
+        if(bondOrder > 6.5) {
+#pragma omp atomic write
+          unreasonable = true;
+        }
+
+        if(bondOrder >= minimumOrder) {
+          threadBonds.push_back(FractionalBond {i, j, bondOrder});
+        }
+      });
     }
+
+#pragma omp critical(uffBondListMerge)
+    bonds.insert(std::end(bonds), std::begin(threadBonds), std::end(threadBonds));
   }
 
+  if(unreasonable) {
+    throw std::logic_error(
+      "Structure bond order interpretation yields bond orders greater than "
+      "sextuple. The structure is most likely unreasonable."
+    );
+  }
+
+  // Merge order depends on thread scheduling
+  std::sort(
+    std::begin(bonds),
+    std::end(bonds),
+    [](const FractionalBond& a, const FractionalBond& b) {
+      return std::tie(a.first, a.second) < std::tie(b.first, b.second);
+    }
+  );
+
+  return bonds;
+}
+
+Utils::BondOrderCollection collectBondOrders(
+  const unsigned N,
+  const std::vector<FractionalBond>& bonds
+) {
+  Utils::BondOrderCollection bondOrders(N);
+  for(const FractionalBond& bond : bonds) {
+    bondOrders.setOrder(bond.first, bond.second, bond.order);
+  }
   return bondOrders;
 }
 
+} // namespace
+
+std::vector<FractionalBond> uffBondList(
+  const Utils::ElementTypeCollection& elements,
+  const AngstromPositions& angstromPositions,
+  const double minimumOrder
+) {
+  const double cellLength = uffCutoff(elements, minimumOrder);
+  checkSizes(elements, angstromPositions);
+  if(elements.size() < 2 || cellLength <= 0) {
+    return {};
+  }
+
+  const auto& positions = angstromPositions.positions;
+  CellGrid grid;
+  grid.sort(positions, cellLength);
+  return uffGridBonds(
+    elements,
+    grid,
+    [&](const AtomIndex i, const AtomIndex j) -> Eigen::Vector3d {
+      return (positions.row(j) - positions.row(i)).transpose();
+    },
+    minimumOrder
+  );
+}
+
+std::vector<FractionalBond> uffBondList(
+  const Utils::ElementTypeCollection& elements,
+  const AngstromPositions& angstromPositions,
+  const PeriodicCell& cell,
+  const double minimumOrder
+) {
+  const double cutoff = uffCutoff(elements, minimumOrder);
+  checkSizes(elements, angstromPositions);
+  if(elements.size() < 2 || cutoff <= 0) {
+    return {};
+  }
+
+  const auto& positions = angstromPositions.positions;
+  PeriodicGrid grid;
+  grid.sort(positions, cell, cutoff);
+  return uffGridBonds(
+    elements,
+    grid,
+    [&](const AtomIndex i, const AtomIndex j) -> Eigen::Vector3d {
+      return cell.minimumImage((positions.row(j) - positions.row(i)).transpose());
+    },
+    minimumOrder
+  );
+}
+
+Utils::BondOrderCollection uffBondOrders(
+  const Utils::ElementTypeCollection& elements,
+  const AngstromPositions& angstromPositions
+) {
+  return collectBondOrders(
+    elements.size(),
+    uffBondList(elements, angstromPositions)
+  );
+}
+
+Utils::BondOrderCollection uffBondOrders(
+  const Utils::ElementTypeCollection& elements,
+  const AngstromPositions& angstromPositions,
+  const PeriodicCell& cell
+) {
+  return collectBondOrders(
+    elements.size(),
+    uffBondList(elements, angstromPositions, cell)
+  );
+}
+
+struct CovalentBondDetector::Impl {
+  explicit Impl(Utils::ElementTypeCollection passElements)
+    : elements(std::move(passElements))
+  {
+    const Utils::BondDetectorRadii radiiTable;
+    radii.reserve(elements.size());
+    double maximumRadius = 0.0;
+    for(const Utils::ElementType e : elements) {
+      radii.push_back(radiiTable.getRadius(e) * Utils::Constants::angstrom_per_bohr);
+      maximumRadius = std::max(maximumRadius, radii.back());
+    }
+    cellLength = 2 * maximumRadius + covalentBondTolerance;
+  }
+
+  template<typename Grid, typename Displacement>
+  Utils::BondOrderCollection detect(const Grid& usedGrid, Displacement&& displacement) const {
+    const unsigned N = elements.size();
+    Utils::BondOrderCollection bondOrders(N);
+    for(unsigned i = 0; i < N; ++i) {
+      usedGrid.forEachNeighbor(i, [&](const AtomIndex j) {
+        const double threshold = radii[i] + radii[j] + covalentBondTolerance;
+        if(displacement(i, j).squaredNorm() < threshold * threshold) {
+          bondOrders.setOrder(i, j, 1.0);
+        }
+      });
+    }
+
+    return bondOrders;
+  }
+
+  const Utils::ElementTypeCollection elements;
+  //! Covalent radii of each atom in Angstrom
+  std::vector<double> radii;
+  double cellLength;
+  CellGrid grid;
+  PeriodicGrid periodicGrid;
+};
+
+CovalentBondDetector::CovalentBondDetector(Utils::ElementTypeCollection elements)
+  : pImpl_(std::make_unique<Impl>(std::move(elements))) {}
+
+CovalentBondDetector::CovalentBondDetector(CovalentBondDetector&& other) noexcept = default;
+CovalentBondDetector& CovalentBondDetector::operator = (CovalentBondDetector&& other) noexcept = default;
+CovalentBondDetector::~CovalentBondDetector() = default;
+
+Utils::BondOrderCollection CovalentBondDetector::operator () (const AngstromPositions& angstromPositions) {
+  checkSizes(pImpl_->elements, angstromPositions);
+  const auto& positions = angstromPositions.positions;
+  if(positions.rows() < 2) {
+    return Utils::BondOrderCollection(positions.rows());
+  }
+
+  pImpl_->grid.sort(positions, pImpl_->cellLength);
+  return pImpl_->detect(
+    pImpl_->grid,
+    [&](const AtomIndex i, const AtomIndex j) -> Eigen::Vector3d {
+      return (positions.row(j) - positions.row(i)).transpose();
+    }
+  );
+}
+
+Utils::BondOrderCollection CovalentBondDetector::operator () (
+  const AngstromPositions& angstromPositions,
+  const PeriodicCell& cell
+) {
+  checkSizes(pImpl_->elements, angstromPositions);
+  const auto& positions = angstromPositions.positions;
+  if(positions.rows() < 2) {
+    return Utils::BondOrderCollection(positions.rows());
+  }
+
+  pImpl_->periodicGrid.sort(positions, cell, pImpl_->cellLength);
+  return pImpl_->detect(
+    pImpl_->periodicGrid,
+    [&](const AtomIndex i, const AtomIndex j) -> Eigen::Vector3d {
+      return cell.minimumImage((positions.row(j) - positions.row(i)).transpose());
+    }
+  );
+}
+
+const Utils::ElementTypeCollection& CovalentBondDetector::elements() const {
+  return pImpl_->elements;
+}
+
 Utils::BondOrderCollection covalentRadiiBondOrders(
   const Utils::ElementTypeCollection& elements,
   const AngstromPositions& angstromPositions
 ) {
-  Utils::AtomCollection ac(elements, angstromPositions.getBohr());
-  return Utils::BondDetector::detectBonds(ac);
+  return CovalentBondDetector {elements}(angstromPositions);
+}
+
+Utils::BondOrderCollection covalentRadiiBondOrders(
+  const Utils::ElementTypeCollection& elements,
+  const AngstromPositions& angstromPositions,
+  const PeriodicCell& cell
+) {
+  return CovalentBondDetector {elements}(angstromPositions, cell);
 }
 
 } // namespace Molassembler
@@ -9,7 +9,9 @@
 #define INCLUDE_MOLASSEMBLER_BOND_ORDERS_H
 
 #include "Molassembler/Export.h"
+#include "Molassembler/Types.h"
 #include "Utils/Geometry/ElementTypes.h"
+#include <memory>
 #include <vector>
 
 namespace Scine {
@@ -22,10 +24,93 @@ namespace Molassembler {
 
 // Forward-declarations
 class AngstromPositions;
+class PeriodicCell;
+
+//! Pair of atoms with a fractional bond order
+struct MASM_EXPORT FractionalBond {
+  //! Lesser atom index of the pair
+  AtomIndex first;
+  //! Greater atom index of the pair
+  AtomIndex second;
+  //! Fractional bond order
+  double order;
+};
+
+//! Least fractional bond order kept by uffBondOrders and uffBondList
+constexpr double uffMinimumBondOrder = 0.1;
+
+/*! @brief Calculates fractional bond orders of nearby atom pairs via UFF-like
+ *   bond distance modelling
+ *
+ * Atoms are sorted into a grid of cells whose edge length is the largest
+ * distance at which any pair of the present elements can have a bond order
+ * of at least @p minimumOrder. Only pairs in the same or adjacent cells are
+ * evaluated.
+ *
+ * @param elements Element types of the atoms
+ * @param angstromPositions Positions of the atoms
+ * @param minimumOrder Least bond order of pairs to include. Must be positive.
+ *
+ * @complexity{@math{\Theta(N \log N)} for structures of bounded density}
+ * @throws std::logic_error If interpreted fractional bond orders are greater
+ *   than 6.5.  In these cases, the structure is most likely unreasonable.
+ * @throws std::invalid_argument If @p minimumOrder is not positive or the
+ *   number of elements and positions do not match
+ *
+ * @parblock @note This function is parallelized. Use the OMP_NUM_THREADS
+ * environment variable to control the number of threads used.
+ * @endparblock
+ *
+ * @returns Pairs with bond orders of at least @p minimumOrder, ordered by
+ *   their atom indices
+ */
+MASM_EXPORT std::vector<FractionalBond> uffBondList(
+  const Utils::ElementTypeCollection& elements,
+  const AngstromPositions& angstromPositions,
+  double minimumOrder = uffMinimumBondOrder
+);
+
+/*! @brief Calculates fractional bond orders of nearby atom pairs of a
+ *   periodic structure via UFF-like bond distance modelling
+ *
+ * Atoms may be wrapped into the periodic cell. Pair distances are those of
+ * their minimum images, so bonds across cell faces are found without
+ * replicating the cell. Atoms are sorted into a grid of cells in fractional
+ * coordinates whose adjacency wraps around the periodic cell.
+ *
+ * @param elements Element types of the atoms
+ * @param angstromPositions Positions of the atoms
+ * @param cell Periodic cell of the structure
+ * @param minimumOrder Least bond order of pairs to include. Must be positive.
+ *
+ * @complexity{@math{\Theta(N \log N)} for structures of bounded density}
+ * @throws std::logic_error If interpreted fractional bond orders are greater
+ *   than 6.5.
+ * @throws std::invalid_argument If @p minimumOrder is not positive, the
+ *   number of elements and positions do not match, or any face distance of
+ *   the cell is less than twice the largest distance at which a pair of the
+ *   present elements can have a bond order of at least @p minimumOrder
+ *
+ * @parblock @note This function is parallelized. Use the OMP_NUM_THREADS
+ * environment variable to control the number of threads used.
+ * @endparblock
+ *
+ * @returns Pairs with bond orders of at least @p minimumOrder, ordered by
+ *   their atom indices
+ */
+MASM_EXPORT std::vector<FractionalBond> uffBondList(
+  const Utils::ElementTypeCollection& elements,
+  const AngstromPositions& angstromPositions,
+  const PeriodicCell& cell,
+  double minimumOrder = uffMinimumBondOrder
+);
 
 /*! @brief Calculates a floating-point bond order collection via UFF-like bond distance modelling
  *
- * @complexity{@math{\Theta(N^2)}}
+ * Only bond orders of at least uffMinimumBondOrder are set. Bond
+ * discretization in Interpret only considers bond orders above 0.5.
+ *
+ * @complexity{As uffBondList}
  * @throws std::logic_error If interpreted fractional bond orders are greater
  *   than 6.5.  In these cases, the structure is most likely unreasonable.
  * @warning UFF parameter bond order calculation is a very primitive
@@ -36,17 +121,97 @@ MASM_EXPORT Utils::BondOrderCollection uffBondOrders(
   const AngstromPositions& angstromPositions
 );
 
+/*! @brief Calculates a floating-point bond order collection of a periodic
+ *   structure via UFF-like bond distance modelling
+ *
+ * @complexity{As uffBondList}
+ * @throws As uffBondList
+ * @see uffBondList(const Utils::ElementTypeCollection&, const AngstromPositions&, const PeriodicCell&, double)
+ */
+MASM_EXPORT Utils::BondOrderCollection uffBondOrders(
+  const Utils::ElementTypeCollection& elements,
+  const AngstromPositions& angstromPositions,
+  const PeriodicCell& cell
+);
+
+/*! @brief Reusable binary bond detection via covalent radii for fixed elements
+ *
+ * Two atoms are bonded if their distance is less than the sum of their
+ * covalent radii plus 0.4 Angstrom, as in Utils::BondDetector. The covalent
+ * radii of the atoms and the storage of the spatial grid are kept between
+ * calls, so that repeatedly detecting bonds in frames of a trajectory neither
+ * converts positions nor looks up radii again.
+ *
+ * @note Calls are not thread-safe, as they share the grid storage.
+ */
+class MASM_EXPORT CovalentBondDetector {
+public:
+  //! Constructor, looks up the covalent radii of all elements
+  explicit CovalentBondDetector(Utils::ElementTypeCollection elements);
+
+  CovalentBondDetector(CovalentBondDetector&& other) noexcept;
+  CovalentBondDetector& operator = (CovalentBondDetector&& other) noexcept;
+  CovalentBondDetector(const CovalentBondDetector& other) = delete;
+  CovalentBondDetector& operator = (const CovalentBondDetector& other) = delete;
+  ~CovalentBondDetector();
+
+  /*! @brief Detects bonds of a set of positions
+   *
+   * Only pairs of atoms in the same or adjacent grid cells are compared.
+   *
+   * @complexity{@math{\Theta(N \log N)} for structures of bounded density}
+   * @throws std::invalid_argument If the number of positions does not match
+   *   the number of elements
+   * @returns A binary (single or none) bond order collection
+   */
+  Utils::BondOrderCollection operator () (const AngstromPositions& angstromPositions);
+
+  /*! @brief Detects bonds of a set of positions in a periodic cell
+   *
+   * Pair distances are those of their minimum images.
+   *
+   * @complexity{@math{\Theta(N)} for structures of bounded density}
+   * @throws std::invalid_argument If the number of positions does not match
+   *   the number of elements or any face distance of the cell is less than
+   *   twice the largest bond detection distance of the present elements
+   * @returns A binary (single or none) bond order collection
+   */
+  Utils::BondOrderCollection operator () (
+    const AngstromPositions& angstromPositions,
+    const PeriodicCell& cell
+  );
+
+  //! Element types of the atoms
+  const Utils::ElementTypeCollection& elements() const;
+
+private:
+  struct Impl;
+  std::unique_ptr<Impl> pImpl_;
+};
+
 /*! @brief Calculates a binary (single or none) bond order collection via covalent radii
  *
- * @complexity{@math{\Theta(N^2)}}
- * @note This is just a convenience forwarder for
- * Utils::BondDetector::detectBonds for different types
+ * @complexity{As CovalentBondDetector::operator()}
+ * @note This is just a convenience forwarder to CovalentBondDetector for
+ *   single sets of positions
  */
 MASM_EXPORT Utils::BondOrderCollection covalentRadiiBondOrders(
   const Utils::ElementTypeCollection& elements,
   const AngstromPositions& angstromPositions
 );
 
+/*! @brief Calculates a binary (single or none) bond order collection of a
+ *   periodic structure via covalent radii
+ *
+ * @complexity{As CovalentBondDetector::operator()}
+ * @throws As CovalentBondDetector::operator()
+ */
+MASM_EXPORT Utils::BondOrderCollection covalentRadiiBondOrders(
+  const Utils::ElementTypeCollection& elements,
+  const AngstromPositions& angstromPositions,
+  const PeriodicCell& cell
+);
+
 } // namespace Molassembler
 } // namespace Scine
 
@@ -56,6 +56,20 @@ BondStereopermutator::BondStereopermutator(
   );
 }
 
+BondStereopermutator::BondStereopermutator(
+  const StereopermutatorList& stereopermutators,
+  const BondIndex& edge,
+  const Alignment alignment,
+  std::vector<unsigned> feasiblePermutations
+) {
+  pImpl_ = std::make_unique<Impl>(
+    stereopermutators,
+    edge,
+    alignment,
+    std::move(feasiblePermutations)
+  );
+}
+
 void BondStereopermutator::assign(boost::optional<unsigned> assignment) {
   pImpl_->assign(std::move(assignment));
 }
@@ -102,6 +116,10 @@ const Stereopermutations::Composite& BondStereopermutator::composite() const {
   return pImpl_->composite();
 }
 
+const std::vector<unsigned>& BondStereopermutator::feasiblePermutations() const {
+  return pImpl_->feasiblePermutations();
+}
+
 double BondStereopermutator::dihedral(
   const AtomStereopermutator& stereopermutatorA,
   const SiteIndex siteIndexA,
@@ -140,6 +140,32 @@ public:
     const BondIndex& edge,
     Alignment alignment = Alignment::Eclipsed
   );
+
+  /*! @brief Constructs a bond stereopermutator on two atom stereopermutators
+   *   with previously determined feasible stereopermutations
+   *
+   * Skips the graph-based feasibility determination, e.g. when restoring a
+   * stereopermutator from a serialization of the same library version.
+   *
+   * @complexity{@math{O(S!)} where @math{S} is the size of the larger involved
+   * shape}
+   *
+   * @param stereopermutators The atom stereopermutators at both ends of
+   *   @p edge must be present
+   * @param edge The bond to place the stereopermutator on
+   * @param alignment Alignment of the composite
+   * @param feasiblePermutations Ascending indices into the composite's
+   *   permutations, as from feasiblePermutations()
+   *
+   * @throws std::out_of_range If @p feasiblePermutations is not ascending or
+   *   contains indices exceeding the composite's permutations
+   */
+  BondStereopermutator(
+    const StereopermutatorList& stereopermutators,
+    const BondIndex& edge,
+    Alignment alignment,
+    std::vector<unsigned> feasiblePermutations
+  );
 //!@}
 
 //!@name Modification
@@ -246,6 +272,14 @@ public:
    */
   const Stereopermutations::Composite& composite() const;
 
+  /*! @brief Indices of composite permutations that are assignable
+   *
+   * Assignment indices index into this list.
+   *
+   * @complexity{@math{\Theta(1)}}
+   */
+  const std::vector<unsigned>& feasiblePermutations() const;
+
   /*! @brief Angle between sites at stereopermutators in the current assignment
    *
    * @complexity{@math{\Theta(1)}}
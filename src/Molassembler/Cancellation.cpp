@@ -0,0 +1,90 @@
+/*!@file
+ * @copyright This code is licensed under the 3-clause BSD license.
+ *   Copyright ETH Zurich, Laboratory of Physical Chemistry, Reiher Group.
+ *   See LICENSE.txt for details.
+ */
+
+#include "Molassembler/Cancellation.h"
+
+#include <atomic>
+#include <chrono>
+
+namespace Scine {
+namespace Molassembler {
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// Token of the innermost scope of the calling thread, if any
+thread_local const CancellationToken* threadToken = nullptr;
+
+} // namespace
+
+struct CancellationToken::State {
+  std::atomic<bool> cancelled {false};
+  Clock::time_point deadline = Clock::time_point::max();
+};
+
+CancellationToken::CancellationToken() : state_(std::make_shared<State>()) {}
+
+CancellationToken::CancellationToken(std::shared_ptr<State> state)
+  : state_(std::move(state)) {}
+
+CancellationToken CancellationToken::after(const double seconds) {
+  CancellationToken token;
+  token.state_->deadline = Clock::now() + std::chrono::duration_cast<Clock::duration>(
+    std::chrono::duration<double>(seconds)
+  );
+  return token;
+}
+
+CancellationToken CancellationToken::current() {
+  if(threadToken != nullptr) {
+    return *threadToken;
+  }
+
+  return CancellationToken {nullptr};
+}
+
+void CancellationToken::cancel() const {
+  if(state_) {
+    state_->cancelled = true;
+  }
+}
+
+bool CancellationToken::cancelled() const {
+  if(!state_) {
+    return false;
+  }
+
+  if(state_->cancelled.load(std::memory_order_relaxed)) {
+    return true;
+  }
+
+  if(state_->deadline != Clock::time_point::max() && Clock::now() >= state_->deadline) {
+    state_->cancelled = true;
+    return true;
+  }
+
+  return false;
+}
+
+void CancellationToken::check() const {
+  if(cancelled()) {
+    throw Cancelled {};
+  }
+}
+
+CancellationToken::Scope::Scope(CancellationToken token)
+  : token_(std::move(token)),
+    previous_(threadToken)
+{
+  threadToken = &token_;
+}
+
+CancellationToken::Scope::~Scope() {
+  threadToken = previous_;
+}
+
+} // namespace Molassembler
+} // namespace Scine
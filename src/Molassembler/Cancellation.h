@@ -0,0 +1,99 @@
+/*!@file
+ * @copyright This code is licensed under the 3-clause BSD license.
+ *   Copyright ETH Zurich, Laboratory of Physical Chemistry, Reiher Group.
+ *   See LICENSE.txt for details.
+ * @brief Cooperative cancellation of long-running computations
+ */
+
+#ifndef INCLUDE_MOLASSEMBLER_CANCELLATION_H
+#define INCLUDE_MOLASSEMBLER_CANCELLATION_H
+
+#include "Molassembler/Export.h"
+
+#include <memory>
+#include <stdexcept>
+
+namespace Scine {
+namespace Molassembler {
+
+//! Thrown by computations without partial results if they are cancelled
+struct MASM_EXPORT Cancelled : std::runtime_error {
+  Cancelled() : std::runtime_error("Computation cancelled") {}
+};
+
+/**
+ * @brief Cooperative cancellation flag with an optional deadline
+ *
+ * Copies share their state, so a token can be handed to a computation and
+ * cancelled from another thread. Computations check the token in their inner
+ * loops and return what they have so far:
+ *
+ * - Conformer generation with a DistanceGeometry::Configuration carrying the
+ *   token yields DgError::Cancelled for each conformer not yet finished.
+ * - Directed conformer enumeration skips the remaining decision lists.
+ * - Subgraphs::maximum returns the largest mappings found so far.
+ * - Ranking inside a CancellationToken::Scope throws Cancelled.
+ *
+ * @code{.cpp}
+ * DistanceGeometry::Configuration configuration;
+ * configuration.cancellation = CancellationToken::after(30.0);
+ * auto ensemble = generateEnsemble(molecule, 100, seed, configuration);
+ * @endcode
+ */
+class MASM_EXPORT CancellationToken {
+public:
+  //! Token that is cancelled only by cancel()
+  CancellationToken();
+
+  //! Token that is additionally cancelled after a number of seconds
+  static CancellationToken after(double seconds);
+
+  /*! @brief Token of the innermost Scope of the calling thread
+   *
+   * If the calling thread has no scope, a token that cannot be cancelled.
+   */
+  static CancellationToken current();
+
+  //! Cancels computations checking this token or its copies
+  void cancel() const;
+
+  /*! @brief Whether the token is cancelled or its deadline has passed
+   *
+   * @complexity{@math{\Theta(1)}}
+   */
+  bool cancelled() const;
+
+  //! @throws Cancelled If cancelled() is true
+  void check() const;
+
+  class Scope;
+
+private:
+  struct State;
+  explicit CancellationToken(std::shared_ptr<State> state);
+
+  std::shared_ptr<State> state_;
+};
+
+/*! @brief Sets the token of the calling thread
+ *
+ * Scopes nest, and the previous token is restored on destruction. Loops of
+ * the library run with Parallel::forEach install the scope of the calling
+ * thread in their workers.
+ */
+class MASM_EXPORT CancellationToken::Scope {
+public:
+  explicit Scope(CancellationToken token);
+  Scope(const Scope& other) = delete;
+  Scope& operator = (const Scope& other) = delete;
+  ~Scope();
+
+private:
+  CancellationToken token_;
+  const CancellationToken* previous_;
+};
+
+} // namespace Molassembler
+} // namespace Scine
+
+#endif
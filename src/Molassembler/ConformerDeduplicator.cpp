@@ -0,0 +1,240 @@
+/*!@file
+ * @copyright This code is licensed under the 3-clause BSD license.
+ *   Copyright ETH Zurich, Laboratory of Physical Chemistry, Reiher Group.
+ *   See LICENSE.txt for details.
+ */
+
+#include "Molassembler/ConformerDeduplicator.h"
+
+#include "Utils/Math/QuaternionFit.h"
+
+#include "Molassembler/Molecule.h"
+#include "Molassembler/Parallel.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace Scine {
+namespace Molassembler {
+namespace {
+
+//! Number of dihedrals indexed in the grid of kept fingerprints
+constexpr unsigned indexedDihedrals = 3;
+
+//! Wraps a dihedral into the half-open interval from zero to its period
+double wrap(const double dihedral, const double period) {
+  const double wrapped = std::fmod(dihedral, period);
+  return wrapped < 0 ? wrapped + period : wrapped;
+}
+
+//! Shortest difference between two dihedrals of a period
+double periodicDifference(const double a, const double b, const double period) {
+  const double difference = wrap(a - b, period);
+  return std::min(difference, period - difference);
+}
+
+} // namespace
+
+ConformerDeduplicator::ConformerDeduplicator(
+  const Molecule& molecule,
+  const double dihedralThreshold,
+  const double rmsdThreshold
+) : relabeler_(DirectedConformerGenerator {molecule}.relabeler()),
+    dihedralThreshold_(dihedralThreshold),
+    rmsdThreshold_(rmsdThreshold)
+{
+  if(!(dihedralThreshold_ > 0)) {
+    throw std::invalid_argument("Dihedral threshold must be positive");
+  }
+
+  if(!(rmsdThreshold_ >= 0)) {
+    throw std::invalid_argument("RMSD threshold must not be negative");
+  }
+
+  for(const auto& sequence : relabeler_.sequences) {
+    periods_.push_back(2 * M_PI / std::max(sequence.symmetryOrder, 1u));
+  }
+
+  /* Cells are at least as wide as the threshold, so duplicates are in the
+   * same or adjacent cells in each indexed dihedral
+   */
+  const unsigned D = std::min<unsigned>(periods_.size(), indexedDihedrals);
+  for(unsigned i = 0; i < D; ++i) {
+    cellCounts_.push_back(
+      std::max(1u, static_cast<unsigned>(periods_.at(i) / dihedralThreshold_))
+    );
+  }
+}
+
+std::vector<double> ConformerDeduplicator::fingerprint(
+  const Utils::PositionCollection& positions
+) const {
+  return relabeler_.dihedrals(positions);
+}
+
+bool ConformerDeduplicator::add(const Utils::PositionCollection& positions) {
+  Fingerprint conformerFingerprint = fingerprint(positions);
+  if(duplicateOfKept_(conformerFingerprint, positions)) {
+    return false;
+  }
+
+  keep_(std::move(conformerFingerprint), positions);
+  return true;
+}
+
+std::vector<unsigned> ConformerDeduplicator::add(
+  const std::vector<Utils::PositionCollection>& ensemble
+) {
+  const unsigned K = ensemble.size();
+  std::vector<Fingerprint> ensembleFingerprints(K);
+  std::vector<char> duplicate(K, false);
+
+  // Comparisons with conformers kept before the ensemble are independent
+  Parallel::forEach(K, [&](const unsigned i, unsigned /* worker */) {
+    ensembleFingerprints.at(i) = fingerprint(ensemble.at(i));
+    duplicate.at(i) = duplicateOfKept_(ensembleFingerprints.at(i), ensemble.at(i));
+  });
+
+  /* Conformers kept from the ensemble can only be compared with each other in
+   * sequence. Those kept earlier in the ensemble are indexed from here on.
+   */
+  const unsigned previouslyKept = size();
+  std::vector<unsigned> kept;
+  for(unsigned i = 0; i < K; ++i) {
+    if(duplicate.at(i)) {
+      continue;
+    }
+
+    bool duplicateOfEnsemble = false;
+    for(const CellKey key : neighborhood_(ensembleFingerprints.at(i))) {
+      const auto findIter = cells_.find(key);
+      if(findIter == std::end(cells_)) {
+        continue;
+      }
+
+      duplicateOfEnsemble = std::any_of(
+        std::begin(findIter->second),
+        std::end(findIter->second),
+        [&](const unsigned keptIndex) {
+          return (
+            keptIndex >= previouslyKept
+            && duplicate_(ensembleFingerprints.at(i), ensemble.at(i), keptIndex)
+          );
+        }
+      );
+
+      if(duplicateOfEnsemble) {
+        break;
+      }
+    }
+
+    if(!duplicateOfEnsemble) {
+      keep_(std::move(ensembleFingerprints.at(i)), ensemble.at(i));
+      kept.push_back(i);
+    }
+  }
+
+  return kept;
+}
+
+unsigned ConformerDeduplicator::cell_(
+  const Fingerprint& fingerprint,
+  const unsigned i
+) const {
+  const double period = periods_.at(i);
+  const unsigned count = cellCounts_.at(i);
+  return std::min(
+    static_cast<unsigned>(wrap(fingerprint.at(i), period) / period * count),
+    count - 1
+  );
+}
+
+ConformerDeduplicator::CellKey ConformerDeduplicator::cellKey_(
+  const Fingerprint& fingerprint
+) const {
+  CellKey key = 0;
+  for(unsigned i = 0; i < cellCounts_.size(); ++i) {
+    key = key * cellCounts_.at(i) + cell_(fingerprint, i);
+  }
+  return key;
+}
+
+std::vector<ConformerDeduplicator::CellKey> ConformerDeduplicator::neighborhood_(
+  const Fingerprint& fingerprint
+) const {
+  // Mixed radix keys of all combinations of neighboring cells
+  std::vector<CellKey> keys {0};
+  for(unsigned i = 0; i < cellCounts_.size(); ++i) {
+    const unsigned count = cellCounts_.at(i);
+    const unsigned cell = cell_(fingerprint, i);
+
+    std::vector<unsigned> neighbors {cell, (cell + 1) % count, (cell + count - 1) % count};
+    std::sort(std::begin(neighbors), std::end(neighbors));
+    neighbors.erase(std::unique(std::begin(neighbors), std::end(neighbors)), std::end(neighbors));
+
+    std::vector<CellKey> extended;
+    extended.reserve(keys.size() * neighbors.size());
+    for(const CellKey key : keys) {
+      for(const unsigned neighbor : neighbors) {
+        extended.push_back(key * count + neighbor);
+      }
+    }
+    keys = std::move(extended);
+  }
+  return keys;
+}
+
+bool ConformerDeduplicator::duplicate_(
+  const Fingerprint& fingerprint,
+  const Utils::PositionCollection& positions,
+  const unsigned keptIndex
+) const {
+  const Fingerprint& keptFingerprint = fingerprints_.at(keptIndex);
+  for(unsigned i = 0; i < periods_.size(); ++i) {
+    if(periodicDifference(fingerprint.at(i), keptFingerprint.at(i), periods_.at(i)) > dihedralThreshold_) {
+      return false;
+    }
+  }
+
+  if(rmsdThreshold_ == 0) {
+    return true;
+  }
+
+  const Utils::QuaternionFit fit {positions_.at(keptIndex), positions};
+  return fit.getRMSD() <= rmsdThreshold_;
+}
+
+bool ConformerDeduplicator::duplicateOfKept_(
+  const Fingerprint& fingerprint,
+  const Utils::PositionCollection& positions
+) const {
+  for(const CellKey key : neighborhood_(fingerprint)) {
+    const auto findIter = cells_.find(key);
+    if(findIter == std::end(cells_)) {
+      continue;
+    }
+
+    for(const unsigned keptIndex : findIter->second) {
+      if(duplicate_(fingerprint, positions, keptIndex)) {
+        return true;
+      }
+    }
+  }
+
+  return false;
+}
+
+void ConformerDeduplicator::keep_(
+  Fingerprint fingerprint,
+  const Utils::PositionCollection& positions
+) {
+  const unsigned index = fingerprints_.size();
+  cells_[cellKey_(fingerprint)].push_back(index);
+  fingerprints_.push_back(std::move(fingerprint));
+  if(rmsdThreshold_ > 0) {
+    positions_.push_back(positions);
+  }
+}
+
+} // namespace Molassembler
+} // namespace Scine
@@ -0,0 +1,155 @@
+/*!@file
+ * @copyright This code is licensed under the 3-clause BSD license.
+ *   Copyright ETH Zurich, Laboratory of Physical Chemistry, Reiher Group.
+ *   See LICENSE.txt for details.
+ * @brief Rejection of near-duplicate conformers
+ */
+
+#ifndef INCLUDE_MOLASSEMBLER_CONFORMER_DEDUPLICATOR_H
+#define INCLUDE_MOLASSEMBLER_CONFORMER_DEDUPLICATOR_H
+
+#include "Molassembler/DirectedConformerGenerator.h"
+
+#include <unordered_map>
+
+namespace Scine {
+namespace Molassembler {
+
+/**
+ * @brief Rejects conformers of a molecule that are near-duplicates of
+ *   conformers kept earlier
+ *
+ * Conformers are compared by their torsion fingerprints, the
+ * symmetry-reduced dihedrals of the bonds a DirectedConformerGenerator
+ * considers, as calculated by its Relabeler. A conformer is a duplicate of a
+ * kept conformer if each of their dihedrals differ by at most the dihedral
+ * threshold and, if an RMSD threshold is set, their RMSD after optimal
+ * superposition is at most the RMSD threshold.
+ *
+ * Kept fingerprints are indexed in a grid over the dihedrals of up to
+ * three bonds, so that each conformer is compared only with kept conformers
+ * in neighboring grid cells instead of all kept conformers. Molecules without
+ * considered bonds have a single torsional conformer, so all kept conformers
+ * are compared by RMSD if a threshold is set, and only the first is kept
+ * otherwise.
+ *
+ * Conformers can be added one by one while an ensemble is being generated,
+ * or as a whole ensemble, in which case comparisons are parallelized. Either
+ * way, a conformer is kept if it is not a duplicate of any conformer kept
+ * before it.
+ *
+ * @code{.cpp}
+ * ConformerDeduplicator deduplicator {molecule, M_PI / 12, 0.5};
+ * std::vector<Utils::PositionCollection> unique;
+ * generateEnsemble(molecule, 10000, 42, [&](unsigned, unsigned, auto result) {
+ *   if(result && deduplicator.add(result.value())) {
+ *     unique.push_back(std::move(result.value()));
+ *   }
+ * });
+ * @endcode
+ */
+class MASM_EXPORT ConformerDeduplicator {
+public:
+//!@name Constructors
+//!@{
+  /*! @brief Prepares to deduplicate conformers of a molecule
+   *
+   * @param molecule Molecule whose conformers are deduplicated
+   * @param dihedralThreshold Maximal difference of each dihedral between
+   *   duplicates, in radians
+   * @param rmsdThreshold Maximal RMSD after superposition between duplicates,
+   *   in bohr. If zero, conformers are compared by dihedrals only.
+   *
+   * @complexity{As DirectedConformerGenerator construction}
+   *
+   * @throws std::invalid_argument If @p dihedralThreshold is not positive or
+   *   @p rmsdThreshold is negative
+   */
+  explicit ConformerDeduplicator(
+    const Molecule& molecule,
+    double dihedralThreshold = M_PI / 12,
+    double rmsdThreshold = 0
+  );
+//!@}
+
+//!@name Information
+//!@{
+  /*! @brief Symmetry-reduced dihedrals of the considered bonds in a conformer
+   *
+   * @complexity{Linear in the number of considered bonds}
+   */
+  std::vector<double> fingerprint(const Utils::PositionCollection& positions) const;
+
+  //! Number of kept conformers
+  inline unsigned size() const {
+    return fingerprints_.size();
+  }
+//!@}
+
+//!@name Modification
+//!@{
+  /*! @brief Keeps a conformer unless it is a duplicate of a kept conformer
+   *
+   * @complexity{Linear in the number of kept conformers in neighboring grid
+   * cells, each compared in linear time, or in @math{\Theta(N)} if an RMSD
+   * is calculated}
+   *
+   * @returns Whether the conformer is kept
+   */
+  bool add(const Utils::PositionCollection& positions);
+
+  /*! @brief Keeps each conformer of an ensemble in sequence unless it is a
+   *   duplicate of a kept conformer
+   *
+   * Yields the same conformers as adding each conformer with add() in
+   * sequence. Fingerprints are calculated and conformers are compared with
+   * the conformers kept before the ensemble in parallel. Only conformers
+   * passing this comparison are compared with each other sequentially.
+   *
+   * @returns Indices of kept conformers of @p ensemble in ascending order
+   */
+  std::vector<unsigned> add(const std::vector<Utils::PositionCollection>& ensemble);
+//!@}
+
+private:
+  using Fingerprint = std::vector<double>;
+  using CellKey = std::size_t;
+
+  //! Grid cell index of a fingerprint's i-th dihedral
+  unsigned cell_(const Fingerprint& fingerprint, unsigned i) const;
+  //! Grid cell of a fingerprint
+  CellKey cellKey_(const Fingerprint& fingerprint) const;
+  //! Grid cells of a fingerprint and its neighbors
+  std::vector<CellKey> neighborhood_(const Fingerprint& fingerprint) const;
+  //! Whether a conformer is a duplicate of a kept conformer
+  bool duplicate_(
+    const Fingerprint& fingerprint,
+    const Utils::PositionCollection& positions,
+    unsigned keptIndex
+  ) const;
+  //! Whether a conformer is a duplicate of any kept conformer
+  bool duplicateOfKept_(
+    const Fingerprint& fingerprint,
+    const Utils::PositionCollection& positions
+  ) const;
+  //! Keeps a conformer
+  void keep_(Fingerprint fingerprint, const Utils::PositionCollection& positions);
+
+  DirectedConformerGenerator::Relabeler relabeler_;
+  double dihedralThreshold_;
+  double rmsdThreshold_;
+  //! Period of each dihedral after symmetry reduction
+  std::vector<double> periods_;
+  //! Number of grid cells per period of each indexed dihedral
+  std::vector<unsigned> cellCounts_;
+  std::vector<Fingerprint> fingerprints_;
+  //! Kept positions, only if compared by RMSD
+  std::vector<Utils::PositionCollection> positions_;
+  //! Indices of kept conformers by grid cell
+  std::unordered_map<CellKey, std::vector<unsigned>> cells_;
+};
+
+} // namespace Molassembler
+} // namespace Scine
+
+#endif
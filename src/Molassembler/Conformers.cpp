@@ -4,11 +4,53 @@
  *   See LICENSE.txt for details.
  */
 
-#include "Molassembler/Temple/Functional.h"
 #include "Molassembler/DistanceGeometry/ConformerGeneration.h"
 
 namespace Scine {
 namespace Molassembler {
+namespace DistanceGeometry {
+
+RefinementTrajectory::RefinementTrajectory(const unsigned capacity)
+  : capacity_(capacity)
+{
+  frames_.reserve(capacity);
+}
+
+void RefinementTrajectory::record(RefinementFrame frame) {
+  if(capacity_ == 0) {
+    return;
+  }
+
+  if(frames_.size() < capacity_) {
+    frames_.push_back(std::move(frame));
+  } else {
+    frames_.at(recorded_ % capacity_) = std::move(frame);
+  }
+  ++recorded_;
+}
+
+unsigned RefinementTrajectory::capacity() const {
+  return capacity_;
+}
+
+unsigned long RefinementTrajectory::recorded() const {
+  return recorded_;
+}
+
+std::vector<RefinementFrame> RefinementTrajectory::frames() const {
+  if(frames_.size() < capacity_) {
+    return frames_;
+  }
+
+  // The oldest kept step is the one to be overwritten next
+  const auto oldest = std::begin(frames_) + recorded_ % capacity_;
+  std::vector<RefinementFrame> ordered(oldest, std::end(frames_));
+  ordered.insert(std::end(ordered), std::begin(frames_), oldest);
+  return ordered;
+}
+
+} // namespace DistanceGeometry
+
 
 std::vector<
   outcome::result<Utils::PositionCollection>
@@ -28,7 +70,7 @@ std::vector<
   for(auto& positionResult : result) {
     if(positionResult) {
       converted.emplace_back(
-        positionResult.value().getBohr()
+        std::move(positionResult.value()).getBohr()
       );
     } else {
       converted.emplace_back(positionResult.as_failure());
@@ -57,7 +99,7 @@ std::vector<
   for(auto& positionResult : result) {
     if(positionResult) {
       converted.emplace_back(
-        positionResult.value().getBohr()
+        std::move(positionResult.value()).getBohr()
       );
     } else {
       converted.emplace_back(positionResult.as_failure());
@@ -67,6 +109,167 @@ std::vector<
   return converted;
 }
 
+std::vector<
+  std::pair<
+    outcome::result<Utils::PositionCollection>,
+    DistanceGeometry::RefinementStatistics
+  >
+> generateEnsembleWithStatistics(
+  const Molecule& molecule,
+  const unsigned numStructures,
+  const unsigned seed,
+  const DistanceGeometry::Configuration& configuration
+) {
+  auto result = DistanceGeometry::runWithStatistics(molecule, numStructures, configuration, seed);
+
+  /* Convert the AngstromPositionss into PositionCollections */
+  std::vector<
+    std::pair<
+      outcome::result<Utils::PositionCollection>,
+      DistanceGeometry::RefinementStatistics
+    >
+  > converted;
+  converted.reserve(numStructures);
+
+  for(auto& resultStatisticsPair : result) {
+    auto& positionResult = resultStatisticsPair.first;
+    if(positionResult) {
+      converted.emplace_back(
+        std::move(positionResult.value()).getBohr(),
+        resultStatisticsPair.second
+      );
+    } else {
+      converted.emplace_back(
+        positionResult.as_failure(),
+        resultStatisticsPair.second
+      );
+    }
+  }
+
+  return converted;
+}
+
+void generateEnsemble(
+  const Molecule& molecule,
+  const unsigned numStructures,
+  const unsigned seed,
+  const ConformerCallback& callback,
+  const DistanceGeometry::Configuration& configuration
+) {
+  DistanceGeometry::run(
+    molecule,
+    numStructures,
+    configuration,
+    seed,
+    [&](const unsigned i, const unsigned conformerSeed, outcome::result<AngstromPositions> positionResult) {
+      if(positionResult) {
+        callback(i, conformerSeed, std::move(positionResult.value()).getBohr());
+      } else {
+        callback(i, conformerSeed, positionResult.as_failure());
+      }
+    }
+  );
+}
+
+std::vector<
+  std::vector<outcome::result<Utils::PositionCollection>>
+> generateEnsembles(
+  const std::vector<Molecule>& molecules,
+  const std::vector<unsigned>& numStructures,
+  const unsigned seed,
+  const DistanceGeometry::Configuration& configuration
+) {
+  auto results = DistanceGeometry::runBatch(molecules, numStructures, configuration, seed);
+
+  /* Convert the AngstromPositionss into PositionCollections */
+  std::vector<
+    std::vector<outcome::result<Utils::PositionCollection>>
+  > converted(results.size());
+
+  for(unsigned m = 0; m < results.size(); ++m) {
+    converted.at(m).reserve(results.at(m).size());
+    for(auto& positionResult : results.at(m)) {
+      if(positionResult) {
+        converted.at(m).emplace_back(
+          std::move(positionResult.value()).getBohr()
+        );
+      } else {
+        converted.at(m).emplace_back(positionResult.as_failure());
+      }
+    }
+  }
+
+  return converted;
+}
+
+std::vector<
+  std::vector<outcome::result<Utils::PositionCollection>>
+> generateFixedPositionEnsembles(
+  const Molecule& molecule,
+  const std::vector<DistanceGeometry::Configuration::FixedPositions>& fixedPositionSets,
+  const unsigned numStructures,
+  const unsigned seed,
+  const DistanceGeometry::Configuration& configuration
+) {
+  auto results = DistanceGeometry::runFixedPositionBatch(
+    molecule,
+    fixedPositionSets,
+    numStructures,
+    configuration,
+    seed
+  );
+
+  /* Convert the AngstromPositionss into PositionCollections */
+  std::vector<
+    std::vector<outcome::result<Utils::PositionCollection>>
+  > converted(results.size());
+
+  for(unsigned s = 0; s < results.size(); ++s) {
+    converted.at(s).reserve(results.at(s).size());
+    for(auto& positionResult : results.at(s)) {
+      if(positionResult) {
+        converted.at(s).emplace_back(
+          std::move(positionResult.value()).getBohr()
+        );
+      } else {
+        converted.at(s).emplace_back(positionResult.as_failure());
+      }
+    }
+  }
+
+  return converted;
+}
+
+outcome::result<
+  std::vector<Utils::PositionCollection>
+> generateSuccessfulEnsemble(
+  const Molecule& molecule,
+  const unsigned numSuccesses,
+  const unsigned maxAttempts,
+  const unsigned seed,
+  const DistanceGeometry::Configuration& configuration
+) {
+  auto result = DistanceGeometry::runUntilSuccesses(
+    molecule,
+    numSuccesses,
+    maxAttempts,
+    configuration,
+    seed
+  );
+
+  if(!result) {
+    return result.as_failure();
+  }
+
+  std::vector<Utils::PositionCollection> converted;
+  converted.reserve(result.value().size());
+  for(AngstromPositions& positions : result.value()) {
+    converted.push_back(std::move(positions).getBohr());
+  }
+
+  return converted;
+}
+
 outcome::result<Utils::PositionCollection> generateRandomConformation(
   const Molecule& molecule,
   const DistanceGeometry::Configuration& configuration
@@ -77,7 +280,7 @@ outcome::result<Utils::PositionCollection> generateRandomConformation(
   auto& wrapperResult = result.front();
 
   if(wrapperResult) {
-    return wrapperResult.value().getBohr();
+    return std::move(wrapperResult.value()).getBohr();
   }
 
   return wrapperResult.as_failure();
@@ -94,7 +297,71 @@ outcome::result<Utils::PositionCollection> generateConformation(
   auto& wrapperResult = result.front();
 
   if(wrapperResult) {
-    return wrapperResult.value().getBohr();
+    return std::move(wrapperResult.value()).getBohr();
+  }
+
+  return wrapperResult.as_failure();
+}
+
+std::vector<
+  outcome::result<Utils::PositionCollection>
+> generateEnsemble(
+  const DistanceGeometry::PreparedModel& model,
+  const unsigned numStructures,
+  const unsigned seed
+) {
+  auto result = DistanceGeometry::run(model, numStructures, seed);
+
+  /* Convert the AngstromPositionss into PositionCollections */
+  std::vector<
+    outcome::result<Utils::PositionCollection>
+  > converted;
+  converted.reserve(numStructures);
+
+  for(auto& positionResult : result) {
+    if(positionResult) {
+      converted.emplace_back(
+        std::move(positionResult.value()).getBohr()
+      );
+    } else {
+      converted.emplace_back(positionResult.as_failure());
+    }
+  }
+
+  return converted;
+}
+
+void generateEnsemble(
+  const DistanceGeometry::PreparedModel& model,
+  const unsigned numStructures,
+  const unsigned seed,
+  const ConformerCallback& callback
+) {
+  DistanceGeometry::run(
+    model,
+    numStructures,
+    seed,
+    [&](const unsigned i, const unsigned conformerSeed, outcome::result<AngstromPositions> positionResult) {
+      if(positionResult) {
+        callback(i, conformerSeed, std::move(positionResult.value()).getBohr());
+      } else {
+        callback(i, conformerSeed, positionResult.as_failure());
+      }
+    }
+  );
+}
+
+outcome::result<Utils::PositionCollection> generateConformation(
+  const DistanceGeometry::PreparedModel& model,
+  const unsigned seed
+) {
+  auto result = DistanceGeometry::run(model, 1, seed);
+
+  assert(result.size() == 1);
+  auto& wrapperResult = result.front();
+
+  if(wrapperResult) {
+    return std::move(wrapperResult.value()).getBohr();
   }
 
   return wrapperResult.as_failure();
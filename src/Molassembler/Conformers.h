@@ -8,9 +8,13 @@
 #ifndef INCLUDE_MOLASSEMBLER_CONFORMER_GENERATION_H
 #define INCLUDE_MOLASSEMBLER_CONFORMER_GENERATION_H
 
+#include "Molassembler/Cancellation.h"
 #include "Molassembler/Types.h"
 #include "Utils/Typenames.h"
 #include "outcome/outcome.hpp"
+#include <functional>
+#include <memory>
+#include <string>
 #include <vector>
 
 namespace Scine {
@@ -66,13 +70,74 @@ enum class MASM_EXPORT Partiality {
    * This yields the slowest distance matrix generation, but also the best
    * initial embedded coordinates.
    */
-  All
+  All,
+  /*!
+   * @brief Choose the number of smoothed one-to-all distance choices for each
+   *   conformer from the outcomes of earlier conformers
+   *
+   * Candidates are four atoms, ten percent, a quarter and all atoms. Each
+   * conformer is generated with the candidate of the most estimated successful
+   * conformers per second. Estimates start from a model in which time per
+   * conformer grows with the number of smoothed atoms and failures of few
+   * smoothed atoms grow with the tightness of the distance bounds, and are
+   * replaced by the measured times and refinement failures of earlier
+   * conformers of the same molecule generated on the same thread.
+   *
+   * @note Since choices depend on which conformers a thread generated before,
+   *   ensembles are only reproducible if generated serially.
+   * @note Batched refinement and fragmented embedding smooth as with
+   *   TenPercent.
+   */
+  Adaptive
+};
+
+/**
+ * @brief Floating point precision of the refinement stages
+ *
+ * Single precision halves the memory traffic of the refinement error function
+ * and gradient evaluations, which can be noticeable for large systems.
+ */
+enum class MASM_EXPORT RefinementPrecision {
+  //! All refinement stages are carried out in double precision
+  Double,
+  /*!
+   * @brief All refinement stages are carried out in single precision
+   *
+   * Refinement may be less stable in single precision, leading to more
+   * failed conformers.
+   */
+  Single,
+  /*!
+   * @brief Refinement in single precision, then a final double precision
+   *   polishing stage
+   */
+  Mixed
+};
+
+/**
+ * @brief Optimizer of the refinement stages
+ */
+enum class MASM_EXPORT RefinementOptimizer {
+  //! Limited-memory BFGS with a curvature history of gradient differences
+  Lbfgs,
+  /*!
+   * @brief Trust region Newton-Raphson with the Hessian of the refinement
+   *   error function
+   *
+   * Steps use the exact curvature of the error function, which may reduce
+   * the number of iterations needed for small, stereochemically demanding
+   * molecules. Time per iteration grows cubically with the number of atoms.
+   */
+  TrustRegion
 };
 
 /**
  * @brief A configuration object for distance geometry runs with sane defaults
  */
 struct MASM_EXPORT Configuration {
+  //! Atom indices and their fixed positions in bohr
+  using FixedPositions = std::vector<std::pair<AtomIndex, Utils::Position>>;
+
   /**
    * @brief Choose for how many atoms to re-smooth the distance bounds after
    *   a distance choice
@@ -99,6 +164,203 @@ struct MASM_EXPORT Configuration {
    */
   double refinementGradientTarget {1e-5};
 
+  /**
+   * @brief Sets the floating point precision of refinement
+   *
+   * Defaults to double precision throughout.
+   */
+  RefinementPrecision refinementPrecision {RefinementPrecision::Double};
+
+  /**
+   * @brief Sets the optimizer of the refinement stages
+   *
+   * The refinementHistoryLength, retainRefinementHistory and
+   * preconditionRefinement settings apply to L-BFGS only. Batched refinement
+   * requires L-BFGS.
+   *
+   * Defaults to L-BFGS.
+   */
+  RefinementOptimizer refinementOptimizer {RefinementOptimizer::Lbfgs};
+
+  /**
+   * @brief Sets the skin width of sparse distance term evaluation in angstrom
+   *
+   * If positive, refinement keeps a list of atom pairs close to or outside
+   * of their distance bounds and evaluates only those distance terms until
+   * an atom has moved by more than half the skin width, at which point the
+   * list is rebuilt. Results are identical to dense evaluation. Large
+   * molecules, in which most atom pairs satisfy their bounds by a wide
+   * margin, benefit most. A skin of around 1.0 is a reasonable start.
+   *
+   * Defaults to zero, which evaluates all atom pairs in each step.
+   */
+  double distanceTermSkin {0.0};
+
+  /**
+   * @brief Sets the number of gradient and parameter differences the
+   *   refinement optimizer keeps to approximate the inverse Hessian
+   *
+   * Longer histories may reduce the number of refinement iterations needed
+   * for large systems, but memory and time per iteration grow linearly with
+   * the history length.
+   *
+   * Defaults to 32. Zero is treated as one.
+   */
+  unsigned refinementHistoryLength {32};
+
+  /**
+   * @brief Carry the refinement optimizer's curvature history from each
+   *   refinement stage to the next
+   *
+   * Each refinement stage adds a term to the objective function of the
+   * preceding one (compression of the fourth spatial dimension, then
+   * dihedral terms), so curvature information of a stage can remain useful
+   * in the next. Mixed precision polishing always starts without history.
+   *
+   * Defaults to false, starting each stage without history.
+   */
+  bool retainRefinementHistory {false};
+
+  /**
+   * @brief Precondition refinement with the curvature of the distance bounds
+   *
+   * Scales the refinement optimizer's initial inverse Hessian approximation
+   * per atom by the inverse of the curvature its distance terms contribute
+   * near their upper bounds. This may reduce the number of refinement
+   * iterations needed for floppy molecules such as macrocycles.
+   *
+   * Defaults to false.
+   */
+  bool preconditionRefinement {false};
+
+  /**
+   * @brief Sets the number of conformers refined together in lock-step
+   *
+   * Batched refinement advances the embeddings of several conformers of the
+   * same molecule through each refinement stage together, evaluating the
+   * distance terms of all of them in a single pass over the distance bounds.
+   * This improves cache reuse for molecules whose distance bounds do not fit
+   * into cache. Batches are distributed over threads.
+   *
+   * Batched refinement applies only if no stereopermutators are randomly
+   * assigned for each conformer, no refinement statistics are collected,
+   * the refinement optimizer is L-BFGS and molecules are embedded whole
+   * without deferring hydrogens.
+   * Distance terms are evaluated densely regardless of distanceTermSkin and
+   * curvature histories are not retained across stages.
+   *
+   * Defaults to 1, refining each conformer individually.
+   */
+  unsigned refinementBatchSize {1};
+
+  /**
+   * @brief Embed and refine the atoms apart from terminal hydrogens first
+   *
+   * Terminal hydrogens take up a large share of the atoms of organic
+   * molecules, but contribute little to the difficult part of distance
+   * geometry. If set, the remaining atoms are embedded and refined on their
+   * own with the smoothed distance bounds between them. Terminal hydrogens
+   * are then placed from the local geometry of the atoms they are bonded to,
+   * and a final refinement of all atoms settles them. Metrization, embedding
+   * and most refinement iterations then scale with the number of remaining
+   * atoms only.
+   *
+   * Hydrogens that are part of chiral or dihedral constraints are not
+   * deferred. Hydrogens are not deferred at all if any positions are fixed,
+   * or if fewer than four atoms would remain. Refinement statistics cover
+   * the final refinement only.
+   *
+   * Defaults to false.
+   */
+  bool deferHydrogens {false};
+
+  /**
+   * @brief Sets the number of atoms above which molecules are embedded in
+   *   fragments
+   *
+   * Metrization and embedding of a whole molecule become infeasible for
+   * assemblies of thousands of atoms. If positive, larger molecules are split
+   * along bonds outside of cycles into fragments of up to this many atoms
+   * where possible. Fragments are embedded and refined one after another
+   * with the smoothed distance bounds and the constraints within them, and
+   * fitted onto the atoms they share with fragments embedded before them. A
+   * final refinement of all atoms then assembles the fragments, evaluating
+   * distance terms sparsely with a skin of one angstrom unless
+   * distanceTermSkin is set.
+   *
+   * Fragments count atoms apart from deferred hydrogens. Molecules with
+   * fixed positions are embedded whole. Batched refinement does not apply.
+   *
+   * Defaults to zero, which embeds molecules whole.
+   */
+  unsigned fragmentSize {0};
+
+  /**
+   * @brief Sets the interval in iterations at which refinement steps are
+   *   recorded into the trajectory of refinement statistics
+   *
+   * Each recorded step holds the refinement stage, the iteration within the
+   * stage, the objective function value and its gradient norm, and
+   * optionally the positions. Steps are recorded only where refinement
+   * statistics are collected.
+   *
+   * Defaults to zero, which disables recording.
+   *
+   * @see RefinementStatistics::trajectory
+   */
+  unsigned trajectoryInterval {0};
+
+  /**
+   * @brief Sets the maximum number of recorded refinement steps per conformer
+   *
+   * Once full, each recorded step overwrites the oldest one.
+   *
+   * Defaults to 64.
+   */
+  unsigned trajectoryCapacity {64};
+
+  /**
+   * @brief Record the positions of each recorded refinement step
+   *
+   * Defaults to false.
+   */
+  bool trajectoryPositions {false};
+
+  /**
+   * @brief Sets the minimum proportion of chiral constraints with correct
+   *   sign an embedding must have to be refined
+   *
+   * Embeddings with less than half of their chiral constraints correct are
+   * inverted before refinement, so the proportion is at least one half.
+   * Embeddings below the threshold are discarded with
+   * DgError::EmbeddingRejected instead of using up refinement iterations to
+   * invert their chiral constraints. Chiral constraints with a target volume
+   * of zero are not counted.
+   *
+   * Defaults to zero, which disables screening.
+   */
+  double chiralityScreeningThreshold {0.0};
+
+  /**
+   * @brief Sets the number of chirality inversion refinement iterations after
+   *   which embeddings are probed
+   *
+   * If fewer than chiralityProbeThreshold of an embedding's chiral
+   * constraints have correct sign after this many iterations of the first
+   * refinement stage, refinement is aborted with DgError::EmbeddingRejected.
+   *
+   * Defaults to zero, which disables probing.
+   */
+  unsigned chiralityProbeIterations {0};
+
+  /**
+   * @brief Sets the minimum proportion of chiral constraints with correct
+   *   sign at the chirality probe
+   *
+   * @see chiralityProbeIterations
+   */
+  double chiralityProbeThreshold {0.0};
+
   /**
    * @brief Sets the loosening of the spatial model
    *
@@ -124,9 +386,212 @@ struct MASM_EXPORT Configuration {
    *
    * @note Remember Utils::Positions are in bohr length units!
    */
-  std::vector<
-    std::pair<AtomIndex, Utils::Position>
-  > fixedPositions;
+  FixedPositions fixedPositions;
+
+  /**
+   * @brief Cancels generation of conformers not yet finished
+   *
+   * Conformers whose generation is cancelled yield DgError::Cancelled.
+   * Copies of a configuration share the token.
+   */
+  CancellationToken cancellation;
+};
+
+//! Refinement stages in order of application
+enum class MASM_EXPORT RefinementStage {
+  //! Stage with a free fourth spatial dimension to invert chiral constraints
+  ChiralityInversion,
+  //! Stage compressing out the fourth spatial dimension
+  Compression,
+  //! Final stage including dihedral terms
+  Dihedral,
+  //! Double precision polishing stage of mixed precision refinement
+  Polish
+};
+
+//! Recorded step of refinement
+struct MASM_EXPORT RefinementFrame {
+  //! Stage the step belongs to
+  RefinementStage stage = RefinementStage::ChiralityInversion;
+  //! Iteration within the stage
+  unsigned iteration = 0;
+  //! Refinement objective function value
+  double value = 0.0;
+  //! Norm of the objective function gradient
+  double gradientNorm = 0.0;
+  /*! @brief Refinement positions in angstrom, four coordinates per atom
+   *
+   * Empty unless Configuration::trajectoryPositions is set.
+   */
+  Eigen::VectorXf positions;
+};
+
+/**
+ * @brief Ring buffer of recorded refinement steps
+ *
+ * Keeps the most recently recorded steps up to its capacity.
+ */
+class MASM_EXPORT RefinementTrajectory {
+public:
+  //! Buffer for a number of steps, zero capacity records nothing
+  explicit RefinementTrajectory(unsigned capacity = 0);
+
+  //! Records a step, overwriting the oldest step if full
+  void record(RefinementFrame frame);
+
+  //! Maximum number of kept steps
+  unsigned capacity() const;
+
+  //! Number of steps recorded overall, including overwritten ones
+  unsigned long recorded() const;
+
+  //! Kept steps, oldest first
+  std::vector<RefinementFrame> frames() const;
+
+private:
+  std::vector<RefinementFrame> frames_;
+  unsigned capacity_;
+  unsigned long recorded_ = 0;
+};
+
+//! Convergence data of a single refinement stage
+struct MASM_EXPORT RefinementStageStatistics {
+  //! Number of optimizer iterations, including line search steps
+  unsigned iterations = 0;
+  //! Number of refinement objective function evaluations
+  unsigned evaluations = 0;
+  //! Norm of the objective function gradient at the end of the stage
+  double gradientNorm = 0.0;
+  //! Wall time spent in the stage in seconds
+  double seconds = 0.0;
+};
+
+/**
+ * @brief Refinement convergence data of a single conformer
+ *
+ * Stages that were not carried out, e.g. because an earlier stage failed or
+ * because a molecule has no chiral constraints, have zero iterations.
+ * Conformers failing before refinement have no refinement data at all.
+ */
+struct MASM_EXPORT RefinementStatistics {
+  //! Stage with a free fourth spatial dimension to invert chiral constraints
+  RefinementStageStatistics chiralityInversion;
+  //! Stage compressing out the fourth spatial dimension
+  RefinementStageStatistics compression;
+  //! Final stage including dihedral terms
+  RefinementStageStatistics dihedral;
+  //! Double precision polishing stage of mixed precision refinement
+  RefinementStageStatistics polish;
+  //! Whether the embedded structure was inverted before refinement
+  bool inverted = false;
+  /*! @brief Number of chiral constraints with wrong sign that refinement had
+   *   to invert (after any inversion of the embedded structure)
+   */
+  unsigned chiralFlips = 0;
+  /*! @brief Recorded refinement steps
+   *
+   * @see Configuration::trajectoryInterval
+   */
+  RefinementTrajectory trajectory;
+};
+
+/**
+ * @brief Spatial model data of a Molecule prepared for repeated conformer
+ *   generation
+ *
+ * Conformer generation starts by constructing a spatial model of a molecule
+ * and smoothing the atom-pairwise distance bounds it yields. If conformers
+ * are generated repeatedly for the same molecule, e.g. with different seeds,
+ * this work can be done once and reused by passing an instance of this class
+ * to the generation functions instead of a Molecule.
+ *
+ * Instances are immutable and may be shared between threads. Copies are
+ * cheap since they share the underlying data.
+ */
+class MASM_EXPORT PreparedModel {
+public:
+  //! Library-internal implementation type
+  struct Impl;
+
+  /*! @brief Constructs the spatial model for a molecule
+   *
+   * @param molecule The molecule to model
+   * @param configuration The configuration used for modeling and all
+   *   conformer generation from this model
+   *
+   * @complexity{Roughly @math{O(N^3)}}
+   *
+   * @throws std::logic_error If @p molecule has unassigned or zero-assignment
+   *   stereopermutators. Unassigned stereopermutators would have to be
+   *   assigned randomly for each conformer, which precludes reuse of the
+   *   spatial model.
+   */
+  explicit PreparedModel(
+    const Molecule& molecule,
+    const Configuration& configuration = Configuration {}
+  );
+
+  /*! @brief Deserializes a prepared model from its JSON representation
+   *
+   * @complexity{Linear in the size of the serialization}
+   *
+   * @throws std::exception If the serialization is malformed
+   */
+  static PreparedModel deserialize(const std::string& serialization);
+
+  /*! @brief Loads a prepared model from an on-disk cache, preparing and
+   *   storing it on a cache miss
+   *
+   * Cache entries are serializations named by a key combining the hash of
+   * @p molecule and all @p configuration parameters, and are parsed from a
+   * read-only memory mapping of the file. Entries are only used if their
+   * molecule and configuration match the arguments exactly, so hash
+   * collisions and stale or malformed entries lead to re-preparation and
+   * replacement of the entry. New entries are written to a temporary file and
+   * renamed into place, so the cache may be shared by concurrent processes.
+   *
+   * Models loaded or prepared by this function are shared within the process
+   * for as long as any copy of them is in use, so concurrent requests for a
+   * model load it only once. To share cache entries between the processes of
+   * a node through memory, choose a directory on a memory-backed file system,
+   * e.g. a subdirectory of /dev/shm. Memory mappings of an entry then share
+   * the same pages.
+   *
+   * @param molecule The molecule to model
+   * @param configuration The configuration used for modeling and all
+   *   conformer generation from this model
+   * @param directory Cache directory. Created if it does not exist.
+   *
+   * @complexity{@math{\Theta(N^2)} if the model is in use in this process
+   * or on a cache hit, roughly @math{O(N^3)} otherwise}
+   *
+   * @throws std::logic_error If @p molecule is not canonical, i.e. has no
+   *   hash, or has unassigned or zero-assignment stereopermutators
+   * @throws std::runtime_error If a new cache entry cannot be written
+   */
+  static PreparedModel cached(
+    const Molecule& molecule,
+    const Configuration& configuration,
+    const std::string& directory
+  );
+
+  /*! @brief Serializes the prepared model into a JSON string
+   *
+   * @complexity{@math{\Theta(N^2)}}
+   */
+  std::string serialize() const;
+
+  //! Modeled molecule
+  const Molecule& molecule() const;
+  //! Configuration used in modeling and conformer generation
+  const Configuration& configuration() const;
+  //! Access to library-internal implementation
+  const Impl& impl() const;
+
+private:
+  explicit PreparedModel(std::shared_ptr<const Impl> impl);
+
+  std::shared_ptr<const Impl> pImpl_;
 };
 
 } // namespace DistanceGeometry
@@ -245,6 +710,273 @@ MASM_EXPORT std::vector<
   const DistanceGeometry::Configuration& configuration = DistanceGeometry::Configuration {}
 );
 
+/*! @brief Generate multiple sets of positional data for a Molecule along
+ *   with refinement convergence data for each
+ *
+ * Identical to generateEnsemble(const Molecule&, unsigned, unsigned, const DistanceGeometry::Configuration&)
+ * except that refinement statistics are collected alongside each result,
+ * including failed ones. This is helpful in tuning the refinement settings
+ * of the configuration and in diagnosing troublesome molecules.
+ *
+ * @complexity{Roughly @math{O(C \cdot N^3)} where @math{C} is the number of
+ * conformers and @math{N} is the number of atoms in @p molecule}
+ *
+ * @parblock @note This function is parallelized. Use the OMP_NUM_THREADS
+ * environment variable to control the number of threads used. Results are
+ * sequenced and reproducible, stage timings are not.
+ * @endparblock
+ */
+MASM_EXPORT std::vector<
+  std::pair<
+    outcome::result<Utils::PositionCollection>,
+    DistanceGeometry::RefinementStatistics
+  >
+> generateEnsembleWithStatistics(
+  const Molecule& molecule,
+  unsigned numStructures,
+  unsigned seed,
+  const DistanceGeometry::Configuration& configuration = DistanceGeometry::Configuration {}
+);
+
+/*! @brief Receives conformers as they are finished in streaming ensemble
+ *   generation
+ *
+ * Arguments are the index of the conformer within the ensemble, the seed
+ * with which the conformer's PRNG engine was seeded, and the conformer
+ * generation result (in Bohr length units).
+ */
+using ConformerCallback = std::function<
+  void(unsigned, unsigned, outcome::result<Utils::PositionCollection>)
+>;
+
+/*! @brief Generate multiple sets of positional data for a Molecule, passing
+ *   each to a callback as soon as it is finished
+ *
+ * Identical to the vector-returning generateEnsemble, except that no
+ * conformers are kept. Memory requirements scale with the number of threads
+ * instead of the number of structures, and downstream processing of
+ * conformers can overlap with the generation of others.
+ *
+ * @param molecule The molecule for which to generate sets of three-dimensional
+ *   positions. This molecule may not contain stereopermutators with zero
+ *   assignments.
+ * @param numStructures The number of desired structures to generate
+ * @param seed A number to seed the pseudo-random number generator used in
+ *   conformer generation with
+ * @param callback Function called with each finished conformer
+ * @param configuration The configuration object to control Distance Geometry
+ *   in detail. The defaults are usually fine.
+ *
+ * @pre @p molecule may not contain stereopermutators with zero assignments as
+ *   this means that the molecule is not representable in three dimensions.
+ * @pre @p configuration's preconditions must be met
+ *
+ * @complexity{Roughly @math{O(C \cdot N^3)} where @math{C} is the number of
+ * conformers and @math{N} is the number of atoms in @p molecule}
+ *
+ * @parblock @note This function is parallelized. Calls to @p callback are
+ * serialized, so @p callback does not need to be thread-safe, but these calls
+ * are not ordered by conformer index. The set of results for a particular
+ * seed is reproducible.
+ * @endparblock
+ *
+ * @parblock @note If @p callback throws, no further calls are made and the
+ * exception is rethrown once all threads have finished.
+ * @endparblock
+ *
+ * @code{.cpp}
+ * generateEnsemble(mol, 10000, 42, [&](unsigned i, unsigned, auto result) {
+ *   if(result) {
+ *     score(i, result.value());
+ *   }
+ * });
+ * @endcode
+ */
+MASM_EXPORT void generateEnsemble(
+  const Molecule& molecule,
+  unsigned numStructures,
+  unsigned seed,
+  const ConformerCallback& callback,
+  const DistanceGeometry::Configuration& configuration = DistanceGeometry::Configuration {}
+);
+
+/*! @brief Generate conformer ensembles for multiple molecules at once
+ *
+ * All conformers of all molecules are distributed over the same threads,
+ * keeping threads busy even if individual molecules need only few
+ * conformers.
+ *
+ * @param molecules The molecules for which to generate three-dimensional
+ *   positions
+ * @param numStructures The number of desired structures for each molecule
+ * @param seed A number to seed the pseudo-random number generator used in
+ *   conformer generation with
+ * @param configuration The configuration object to control Distance Geometry
+ *   in detail. The defaults are usually fine.
+ *
+ * @pre @p configuration's preconditions must be met
+ *
+ * @complexity{Roughly @math{O(\sum_m C_m \cdot N_m^3)} where @math{C_m} is the
+ * number of conformers and @math{N_m} is the number of atoms of the m-th
+ * molecule}
+ *
+ * @parblock @note This function is parallelized. Use the OMP_NUM_THREADS
+ * environment variable to control the number of threads used. Results are
+ * sequenced and reproducible. A molecule's results do not depend on the
+ * molecules following it in the batch.
+ * @endparblock
+ *
+ * @throws std::invalid_argument If the numbers of molecules and structure
+ *   counts do not match
+ *
+ * @returns For each molecule, a list of results as in generateEnsemble (in
+ *   Bohr length units)
+ */
+MASM_EXPORT std::vector<
+  std::vector<outcome::result<Utils::PositionCollection>>
+> generateEnsembles(
+  const std::vector<Molecule>& molecules,
+  const std::vector<unsigned>& numStructures,
+  unsigned seed,
+  const DistanceGeometry::Configuration& configuration = DistanceGeometry::Configuration {}
+);
+
+/*! @brief Generate conformer ensembles for a Molecule with each of multiple
+ *   sets of fixed positions
+ *
+ * Instead of modeling the molecule for each set of fixed positions, it is
+ * modeled once and only the information modeled from the fixed positions is
+ * replaced for each set. All conformers for all sets are distributed over
+ * the same threads.
+ *
+ * @param molecule The molecule for which to generate sets of three-dimensional
+ *   positions. This molecule may not contain stereopermutators with zero
+ *   assignments.
+ * @param fixedPositionSets Sets of fixed positions (in bohr) of the same
+ *   atoms. Each must meet the preconditions of
+ *   DistanceGeometry::Configuration::fixedPositions.
+ * @param numStructures The number of desired structures for each set
+ * @param seed A number to seed the pseudo-random number generator used in
+ *   conformer generation with
+ * @param configuration The configuration object to control Distance Geometry
+ *   in detail. Its fixed positions are replaced by each set.
+ *
+ * @complexity{Roughly @math{O(S \cdot C \cdot N^3)} where @math{S} is the
+ * number of sets, @math{C} is the number of conformers and @math{N} is the
+ * number of atoms in @p molecule}
+ *
+ * @parblock @note This function is parallelized. Use the OMP_NUM_THREADS
+ * environment variable to control the number of threads used. Results are
+ * sequenced and reproducible. A set's results do not depend on the sets
+ * following it.
+ * @endparblock
+ *
+ * @parblock @note If @p molecule has unassigned stereopermutators, they are
+ * assigned at random for each conformer, which requires modeling each
+ * conformer anew.
+ * @endparblock
+ *
+ * @throws std::invalid_argument If the sets do not fix the same atoms
+ *
+ * @returns For each set of fixed positions, a list of results as in
+ *   generateEnsemble (in Bohr length units)
+ */
+MASM_EXPORT std::vector<
+  std::vector<outcome::result<Utils::PositionCollection>>
+> generateFixedPositionEnsembles(
+  const Molecule& molecule,
+  const std::vector<DistanceGeometry::Configuration::FixedPositions>& fixedPositionSets,
+  unsigned numStructures,
+  unsigned seed,
+  const DistanceGeometry::Configuration& configuration = DistanceGeometry::Configuration {}
+);
+
+/*! @brief Generate a target number of successful conformers for a Molecule
+ *   within a budget of attempts
+ *
+ * Distance Geometry can fail stochastically. Instead of attempting a fixed
+ * number of conformers, this keeps making attempts until @p numSuccesses of
+ * them are successful or @p maxAttempts attempts have been made. All threads
+ * stop as soon as the target is reached.
+ *
+ * @param molecule The molecule for which to generate sets of three-dimensional
+ *   positions. This molecule may not contain stereopermutators with zero
+ *   assignments.
+ * @param numSuccesses The number of desired successful structures
+ * @param maxAttempts The maximum number of conformer generation attempts
+ * @param seed A number to seed the pseudo-random number generator used in
+ *   conformer generation with
+ * @param configuration The configuration object to control Distance Geometry
+ *   in detail. The defaults are usually fine.
+ *
+ * @pre @p configuration's preconditions must be met
+ *
+ * @complexity{Roughly @math{O(A \cdot N^3)} where @math{A} is the number of
+ * attempts needed and @math{N} is the number of atoms in @p molecule}
+ *
+ * @parblock @note This function is parallelized. Use the OMP_NUM_THREADS
+ * environment variable to control the number of threads used. Results are
+ * the successes of the earliest attempts and are reproducible.
+ * @endparblock
+ *
+ * @returns Up to @p numSuccesses PositionCollections (in Bohr length units).
+ *   Fewer are returned if the attempt budget is exhausted. If @p molecule has
+ *   zero-assignment stereopermutators, an error is returned instead.
+ */
+MASM_EXPORT outcome::result<
+  std::vector<Utils::PositionCollection>
+> generateSuccessfulEnsemble(
+  const Molecule& molecule,
+  unsigned numSuccesses,
+  unsigned maxAttempts,
+  unsigned seed,
+  const DistanceGeometry::Configuration& configuration = DistanceGeometry::Configuration {}
+);
+
+/*! @brief Generate multiple sets of positional data from a prepared model
+ *
+ * Skips spatial modeling and bounds smoothing, otherwise identical to
+ * generateEnsemble with the model's molecule and configuration. For the same
+ * seed, the results are identical, too.
+ *
+ * @param model The prepared spatial model of a molecule
+ * @param numStructures The number of desired structures to generate
+ * @param seed A number to seed the pseudo-random number generator used in
+ *   conformer generation with
+ *
+ * @complexity{Roughly @math{O(C \cdot N^3)} where @math{C} is the number of
+ * conformers and @math{N} is the number of atoms}
+ *
+ * @parblock @note This function is parallelized. Use the OMP_NUM_THREADS
+ * environment variable to control the number of threads used. Results are
+ * sequenced and reproducible.
+ * @endparblock
+ */
+MASM_EXPORT std::vector<
+  outcome::result<Utils::PositionCollection>
+> generateEnsemble(
+  const DistanceGeometry::PreparedModel& model,
+  unsigned numStructures,
+  unsigned seed
+);
+
+/*! @brief Generate multiple sets of positional data from a prepared model,
+ *   passing each to a callback as soon as it is finished
+ *
+ * Skips spatial modeling and bounds smoothing, otherwise identical to the
+ * callback overload of generateEnsemble with the model's molecule and
+ * configuration.
+ *
+ * @complexity{Roughly @math{O(C \cdot N^3)} where @math{C} is the number of
+ * conformers and @math{N} is the number of atoms}
+ */
+MASM_EXPORT void generateEnsemble(
+  const DistanceGeometry::PreparedModel& model,
+  unsigned numStructures,
+  unsigned seed,
+  const ConformerCallback& callback
+);
+
 /*! @brief Generate a 3D structure of a Molecule
  *
  * @param molecule The molecule for which to generate three-dimensional
@@ -295,6 +1027,21 @@ MASM_EXPORT outcome::result<Utils::PositionCollection> generateConformation(
   const DistanceGeometry::Configuration& configuration = DistanceGeometry::Configuration {}
 );
 
+/*! @brief Generate a 3D structure from a prepared model
+ *
+ * @param model The prepared spatial model of a molecule
+ * @param seed A number to seed the pseudo-random number generator used in
+ *   conformer generation with
+ *
+ * @complexity{Roughly @math{O(N^3)}}
+ *
+ * @see generateEnsemble
+ */
+MASM_EXPORT outcome::result<Utils::PositionCollection> generateConformation(
+  const DistanceGeometry::PreparedModel& model,
+  unsigned seed
+);
+
 } // namespace Molassembler
 } // namespace Scine
 
@@ -0,0 +1,133 @@
+/*!@file
+ * @copyright This code is licensed under the 3-clause BSD license.
+ *   Copyright ETH Zurich, Laboratory of Physical Chemistry, Reiher Group.
+ *   See LICENSE.txt for details.
+ */
+
+#include "Molassembler/CostModel.h"
+
+#include "Molassembler/Cycles.h"
+#include "Molassembler/Descriptors.h"
+#include "Molassembler/DirectedConformerGenerator.h"
+#include "Molassembler/Graph.h"
+#include "Molassembler/Molecule.h"
+#include "Molassembler/StereopermutatorList.h"
+
+#include <Eigen/QR>
+#include <algorithm>
+#include <cmath>
+
+namespace Scine {
+namespace Molassembler {
+namespace {
+
+//! Failure rates are clamped to this distance from zero and one
+constexpr double failureRateClamp = 1e-3;
+
+double logit(const double p) {
+  const double clamped = std::min(std::max(p, failureRateClamp), 1 - failureRateClamp);
+  return std::log(clamped / (1 - clamped));
+}
+
+double logistic(const double x) {
+  return 1 / (1 + std::exp(-x));
+}
+
+} // namespace
+
+constexpr unsigned CostModel::coefficientCount;
+
+CostModel::Features CostModel::features(const Molecule& molecule) {
+  Features features;
+  features.atoms = molecule.graph().N();
+  features.atomStereopermutators = molecule.stereopermutators().A();
+  features.bondStereopermutators = molecule.stereopermutators().B();
+  features.cycleFamilies = molecule.graph().cycles().numCycleFamilies();
+  features.rotatableBonds = numRotatableBonds(molecule);
+  features.idealEnsembleSize = DirectedConformerGenerator {molecule}.idealEnsembleSize();
+  return features;
+}
+
+Eigen::VectorXd CostModel::regressors(const Features& features) {
+  Eigen::VectorXd x(coefficientCount);
+  x << 1.0,
+    std::log(std::max(features.atoms, 1u)),
+    features.atomStereopermutators,
+    features.bondStereopermutators,
+    features.cycleFamilies,
+    features.rotatableBonds,
+    std::log1p(features.idealEnsembleSize);
+  return x;
+}
+
+CostModel CostModel::calibrate(const std::vector<Observation>& observations) {
+  if(observations.empty()) {
+    throw std::invalid_argument("Cannot calibrate a cost model without observations");
+  }
+
+  const unsigned M = observations.size();
+  Eigen::MatrixXd X(M, coefficientCount);
+  Eigen::VectorXd logTimes(M);
+  Eigen::VectorXd logitFailures(M);
+  for(unsigned i = 0; i < M; ++i) {
+    const Observation& observation = observations.at(i);
+    X.row(i) = regressors(observation.features).transpose();
+    logTimes(i) = std::log(observation.secondsPerConformer);
+    logitFailures(i) = logit(observation.failureRate);
+  }
+
+  /* Regressors that are constant across all observations are not separable
+   * from the intercept. The minimum norm solution would spread the intercept
+   * over them, so they are dropped from the fit instead.
+   */
+  std::vector<unsigned> varying {0};
+  for(unsigned j = 1; j < coefficientCount; ++j) {
+    if((X.col(j).array() != X(0, j)).any()) {
+      varying.push_back(j);
+    }
+  }
+
+  Eigen::MatrixXd reduced(M, varying.size());
+  for(unsigned k = 0; k < varying.size(); ++k) {
+    reduced.col(k) = X.col(varying.at(k));
+  }
+
+  const Eigen::CompleteOrthogonalDecomposition<Eigen::MatrixXd> decomposition {reduced};
+  const Eigen::VectorXd timeSolution = decomposition.solve(logTimes);
+  const Eigen::VectorXd failureSolution = decomposition.solve(logitFailures);
+
+  Eigen::VectorXd timeCoefficients = Eigen::VectorXd::Zero(coefficientCount);
+  Eigen::VectorXd failureCoefficients = Eigen::VectorXd::Zero(coefficientCount);
+  for(unsigned k = 0; k < varying.size(); ++k) {
+    timeCoefficients(varying.at(k)) = timeSolution(k);
+    failureCoefficients(varying.at(k)) = failureSolution(k);
+  }
+
+  return {std::move(timeCoefficients), std::move(failureCoefficients)};
+}
+
+CostModel::CostModel(
+  Eigen::VectorXd timeCoefficients,
+  Eigen::VectorXd failureCoefficients
+) : timeCoefficients_(std::move(timeCoefficients)),
+    failureCoefficients_(std::move(failureCoefficients))
+{
+  if(
+    timeCoefficients_.size() != coefficientCount
+    || failureCoefficients_.size() != coefficientCount
+  ) {
+    throw std::invalid_argument("Cost model coefficients do not match the number of regressors");
+  }
+}
+
+CostModel::Estimate CostModel::predict(const Features& features) const {
+  const Eigen::VectorXd x = regressors(features);
+  return {
+    std::exp(timeCoefficients_.dot(x)),
+    logistic(failureCoefficients_.dot(x)),
+    features.idealEnsembleSize
+  };
+}
+
+} // namespace Molassembler
+} // namespace Scine
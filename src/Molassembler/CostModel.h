@@ -0,0 +1,158 @@
+/*!@file
+ * @copyright This code is licensed under the 3-clause BSD license.
+ *   Copyright ETH Zurich, Laboratory of Physical Chemistry, Reiher Group.
+ *   See LICENSE.txt for details.
+ * @brief Predicts the expense of conformer generation for job scheduling
+ */
+
+#ifndef INCLUDE_MOLASSEMBLER_COST_MODEL_H
+#define INCLUDE_MOLASSEMBLER_COST_MODEL_H
+
+#include "Molassembler/Export.h"
+
+#include <Eigen/Core>
+#include <vector>
+
+namespace Scine {
+namespace Molassembler {
+
+// Forward-declarations
+class Molecule;
+
+/**
+ * @brief Predicts the time and failure rate of conformer generation from
+ *   cheap molecular features
+ *
+ * The logarithm of the time per conformer and the logit of the failure rate
+ * per conformer are modeled as linear functions of the regressors(). Since
+ * times depend on the hardware, models are calibrated from measurements on
+ * the machines jobs are scheduled on, e.g. with the CalibrateCostModel
+ * analysis binary over the benchmark corpus, and reconstructed from their
+ * coefficients.
+ *
+ * @code{.cpp}
+ * const CostModel model {timeCoefficients, failureCoefficients};
+ * const CostModel::Estimate estimate = model.predict(CostModel::features(molecule));
+ * const double timeout = 2 * estimate.ensembleSeconds(100);
+ * @endcode
+ */
+class MASM_EXPORT CostModel {
+public:
+//!@name Member types
+//!@{
+  //! Cheap molecular features
+  struct MASM_EXPORT Features {
+    //! Number of atoms
+    unsigned atoms = 0;
+    //! Number of atom stereopermutators
+    unsigned atomStereopermutators = 0;
+    //! Number of bond stereopermutators
+    unsigned bondStereopermutators = 0;
+    //! Number of unique ring families
+    unsigned cycleFamilies = 0;
+    //! Number of rotatable bonds as numRotatableBonds()
+    unsigned rotatableBonds = 0;
+    //! Number of conformers of a full directed conformer enumeration
+    unsigned idealEnsembleSize = 0;
+  };
+
+  //! Measured expense of conformer generation for a molecule
+  struct MASM_EXPORT Observation {
+    Features features;
+    //! Mean wall time per generated or failed conformer in seconds
+    double secondsPerConformer;
+    //! Proportion of conformers that failed to generate
+    double failureRate;
+  };
+
+  //! Predicted expense of conformer generation for a molecule
+  struct MASM_EXPORT Estimate {
+    //! Expected wall time per generated or failed conformer in seconds
+    double secondsPerConformer;
+    //! Expected proportion of conformers that fail to generate
+    double failureRate;
+    //! Number of conformers of a full directed conformer enumeration
+    unsigned idealEnsembleSize;
+
+    //! Expected single-threaded time of generating a number of conformers
+    inline double ensembleSeconds(const unsigned conformers) const {
+      return conformers * secondsPerConformer;
+    }
+
+    /*! @brief Expected single-threaded time of enumerating all conformers
+     *   with a DirectedConformerGenerator
+     *
+     * Failed conformers are assumed to be retried until successful.
+     */
+    inline double enumerationSeconds() const {
+      return idealEnsembleSize * secondsPerConformer / (1 - failureRate);
+    }
+  };
+//!@}
+
+//!@name Static members
+//!@{
+  //! Number of regressors and coefficients of each linear model
+  static constexpr unsigned coefficientCount = 7;
+
+  /*! @brief Calculates the features of a molecule
+   *
+   * @complexity{@math{\Theta(B)} plus cycle perception, dominated by the
+   * directed conformer generator's bond considerations}
+   */
+  static Features features(const Molecule& molecule);
+
+  /*! @brief Linear model regressors of features
+   *
+   * An intercept, the logarithm of the number of atoms, the numbers of atom
+   * and bond stereopermutators, unique ring families and rotatable bonds,
+   * and the logarithm of one more than the ideal ensemble size.
+   */
+  static Eigen::VectorXd regressors(const Features& features);
+
+  /*! @brief Fits a model to observations by linear least squares
+   *
+   * Failure rates are clamped away from zero and one before their logit is
+   * taken. Coefficients of regressors that do not vary across the
+   * observations are set to zero.
+   *
+   * @throws std::invalid_argument If there are no observations
+   */
+  static CostModel calibrate(const std::vector<Observation>& observations);
+//!@}
+
+//!@name Constructors
+//!@{
+  /*! @brief Constructs a model from its coefficients
+   *
+   * @throws std::invalid_argument If either coefficient vector does not have
+   *   coefficientCount entries
+   */
+  CostModel(Eigen::VectorXd timeCoefficients, Eigen::VectorXd failureCoefficients);
+//!@}
+
+//!@name Information
+//!@{
+  //! Predicts the expense of conformer generation from features
+  Estimate predict(const Features& features) const;
+
+  //! Coefficients of the logarithm of the time per conformer
+  inline const Eigen::VectorXd& timeCoefficients() const {
+    return timeCoefficients_;
+  }
+
+  //! Coefficients of the logit of the failure rate per conformer
+  inline const Eigen::VectorXd& failureCoefficients() const {
+    return failureCoefficients_;
+  }
+//!@}
+
+private:
+  Eigen::VectorXd timeCoefficients_;
+  Eigen::VectorXd failureCoefficients_;
+};
+
+} // namespace Molassembler
+} // namespace Scine
+
+#endif
@@ -51,6 +51,11 @@ struct Cycles::RdlDataPtrs {
   //! Raw pointer to calculated graph cycle data
   RDL_data* dataPtr;
 
+  /*! Whether each vertex of the graph the cycle data was calculated for is
+   * part of any unique ring family
+   */
+  std::vector<bool> cycleMembership;
+
   RdlDataPtrs() = delete;
   RdlDataPtrs(const PrivateGraph& sourceGraph, bool ignoreEtaBonds);
 
@@ -61,6 +66,8 @@ struct Cycles::RdlDataPtrs {
   ~RdlDataPtrs();
 
   bool bondExists(const BondIndex& bond) const;
+  bool vertexExists(AtomIndex i) const;
+  bool inCycle(AtomIndex i) const;
 };
 
 Cycles::Cycles(const Graph& sourceGraph, const bool ignoreEtaBonds)
@@ -81,6 +88,8 @@ Cycles::Cycles(const PrivateGraph& innerGraph, const bool ignoreEtaBonds)
     for(unsigned j = 0; j < nEdges; ++j) {
       const BondIndex bond { edgeArray[j][0], edgeArray[j][1] };
       urfMap_[bond].push_back(i);
+      rdlPtr_->cycleMembership.at(bond.first) = true;
+      rdlPtr_->cycleMembership.at(bond.second) = true;
     }
   }
 
@@ -98,10 +107,20 @@ unsigned Cycles::numCycleFamilies() const {
 }
 
 unsigned Cycles::numCycleFamilies(const BondIndex& bond) const {
-  return RDL_getNofURFContainingEdge(rdlPtr_->dataPtr, bond.first, bond.second);
+  auto findIter = urfMap_.find(bond);
+  if(findIter == std::end(urfMap_)) {
+    return 0;
+  }
+
+  return findIter->second.size();
 }
 
 unsigned Cycles::numCycleFamilies(const AtomIndex index) const {
+  // Skip searching all URFs for acyclic atoms
+  if(!rdlPtr_->inCycle(index)) {
+    return 0;
+  }
+
   return RDL_getNofURFContainingNode(rdlPtr_->dataPtr, index);
 }
 
@@ -111,10 +130,18 @@ unsigned Cycles::numRelevantCycles() const {
 }
 
 unsigned Cycles::numRelevantCycles(const AtomIndex index) const {
+  if(!rdlPtr_->inCycle(index)) {
+    return 0;
+  }
+
   return RDL_getNofRCFContainingNode(rdlPtr_->dataPtr, index);
 }
 
 unsigned Cycles::numRelevantCycles(const BondIndex& bond) const {
+  if(!rdlPtr_->bondExists(bond)) {
+    return 0;
+  }
+
   return RDL_getNofRCFContainingEdge(rdlPtr_->dataPtr, bond.first, bond.second);
 }
 
@@ -301,6 +328,27 @@ RDL_data* Cycles::dataPtr() const {
   return rdlPtr_->dataPtr;
 }
 
+std::size_t Cycles::heapSize() const {
+  constexpr std::size_t pointer = sizeof(void*);
+  const std::size_t N = rdlPtr_->cycleMembership.size();
+  const std::size_t cycleBonds = urfMap_.size();
+
+  /* The ring decomposition keeps a copy of the graph's adjacencies and an edge
+   * bitset along with some bookkeeping for each family and relevant cycle
+   */
+  std::size_t size = sizeof(RdlDataPtrs) + (N + 7) / 8;
+  size += N * (2 * pointer + 4 * sizeof(unsigned));
+  size += (numCycleFamilies() + numRelevantCycles()) * ((cycleBonds + 7) / 8 + 8 * pointer);
+
+  size += urfMap_.bucket_count() * pointer;
+  for(const auto& mapPair : urfMap_) {
+    size += sizeof(mapPair) + 2 * pointer;
+    size += mapPair.second.capacity() * sizeof(unsigned);
+  }
+
+  return size;
+}
+
 bool Cycles::operator == (const Cycles& other) const {
   return rdlPtr_ == other.rdlPtr_;
 }
@@ -315,6 +363,7 @@ Cycles::RdlDataPtrs::RdlDataPtrs(
   const bool ignoreEtaBonds
 ) {
   // Initialize a new graph
+  cycleMembership.assign(sourceGraph.N(), false);
   graphPtr = RDL_initNewGraph(sourceGraph.N());
 
   if(ignoreEtaBonds) {
@@ -357,10 +406,23 @@ Cycles::RdlDataPtrs::~RdlDataPtrs() {
 }
 
 bool Cycles::RdlDataPtrs::bondExists(const BondIndex& bond) const {
+  if(!vertexExists(bond.first) || !vertexExists(bond.second)) {
+    return false;
+  }
+
   const unsigned bondID = RDL_getEdgeId(dataPtr, bond.first, bond.second);
   return bondID != RDL_INVALID_RESULT;
 }
 
+bool Cycles::RdlDataPtrs::vertexExists(const AtomIndex i) const {
+  return i < cycleMembership.size();
+}
+
+bool Cycles::RdlDataPtrs::inCycle(const AtomIndex i) const {
+  // Vertices added to the graph after calculation are acyclic
+  return vertexExists(i) && cycleMembership[i];
+}
+
 Cycles::AllCyclesIterator::AllCyclesIterator(const AllCyclesIterator& other)
   : rdlPtr_(other.rdlPtr_),
     cyclePtr_(std::make_unique<RdlCyclePtrs>(*rdlPtr_))
@@ -481,6 +543,10 @@ struct Cycles::UrfIdsCycleIterator::UrfHelper {
     AtomIndex atom,
     const RdlDataPtrs& dataPtrs
   ) {
+    if(!dataPtrs.inCycle(atom)) {
+      return {};
+    }
+
     return getURFsHelper(
       dataPtrs,
       &RDL_getURFsContainingNode,
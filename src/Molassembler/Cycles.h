@@ -181,14 +181,13 @@ public:
   /*! @brief Returns the number of unique ring families (URFs) an index is involved in
    *
    * @complexity{@math{\Theta(U)} where @math{U} is the number of unique ring
-   * families in the molecule}
+   * families in the molecule, @math{\Theta(1)} if the atom is in no cycle}
    */
   unsigned numCycleFamilies(AtomIndex index) const;
 
   /*! @brief Returns the number of unique ring families (URFs) a bond is in
    *
-   * @complexity{@math{\Theta(U)} where @math{U} is the number of unique ring
-   * families in the molecule}
+   * @complexity{@math{\Theta(1)}}
    */
   unsigned numCycleFamilies(const BondIndex& bond) const;
 
@@ -201,7 +200,7 @@ public:
   /*! @brief Returns the number of relevant cycles (RCs)
    *
    * @complexity{@math{\Theta(U)} where @math{U} is the number of unique ring
-   * families in the molecule}
+   * families in the molecule, @math{\Theta(1)} if the atom is in no cycle}
    */
   unsigned numRelevantCycles(AtomIndex index) const;
 
@@ -214,6 +213,16 @@ public:
 
   //! Provide access to calculated data
   RDL_data* dataPtr() const;
+
+  /*! @brief Approximate heap memory in bytes owned by the cycle data
+   *
+   * The ring decomposition itself is opaque. Its size is estimated from the
+   * number of unique ring families and relevant cycles.
+   *
+   * @complexity{@math{\Theta(B)} where @math{B} is the number of bonds in
+   * cycles}
+   */
+  std::size_t heapSize() const;
 //!@}
 
 //!@name Iterators
@@ -227,7 +236,7 @@ public:
   /*! @brief Range of relevant cycles containing an atom
    *
    * @complexity{@math{O(U)} where @math{U} is the number of unique ring
-   * families of the molecule}
+   * families of the molecule, @math{\Theta(1)} if the atom is in no cycle}
    */
   IteratorRange<UrfIdsCycleIterator> containing(AtomIndex atom) const;
   /*! @brief Range of relevant cycles containing a bond
@@ -12,12 +12,17 @@
 #include "Molassembler/StereopermutatorList.h"
 #include "Molassembler/BondStereopermutator.h"
 
+#include "Utils/Geometry/ElementInfo.h"
+
 namespace Scine {
 namespace Molassembler {
 
-unsigned numRotatableBonds(const Molecule& mol) {
-  Cycles cycleData = mol.graph().cycles();
+namespace {
 
+//! Sizes of the smallest relevant cycles containing each bond in a cycle
+std::unordered_map<BondIndex, unsigned, boost::hash<BondIndex>> smallestCycleSizes(
+  const Cycles& cycleData
+) {
   std::unordered_map<BondIndex, unsigned, boost::hash<BondIndex>> smallestCycle;
 
   for(const auto& cycleEdges : cycleData) {
@@ -36,17 +41,26 @@ unsigned numRotatableBonds(const Molecule& mol) {
     }
   }
 
+  return smallestCycle;
+}
+
+} // namespace
+
+unsigned numRotatableBonds(const Molecule& mol) {
+  const Graph& graph = mol.graph();
+
   double count = 0;
-  for(const auto& edge : mol.graph().bonds()) {
+  std::vector<BondIndex> cycleBonds;
+  for(const auto& edge : graph.bonds()) {
     // If the bond is not Single, it cannot be a rotatable bond
-    if(mol.graph().bondType(edge) != BondType::Single) {
+    if(graph.bondType(edge) != BondType::Single) {
       continue;
     }
 
     // If either atom on the bond is terminal, it cannot be rotatable
     if(
-      mol.graph().degree(edge.first) == 1
-      || mol.graph().degree(edge.second) == 1
+      graph.degree(edge.first) == 1
+      || graph.degree(edge.second) == 1
     ) {
       continue;
     }
@@ -60,20 +74,26 @@ unsigned numRotatableBonds(const Molecule& mol) {
       continue;
     }
 
-    auto findIter = smallestCycle.find(edge);
-
-    // Is the edge part of a cycle?
-    if(findIter == std::end(smallestCycle)) {
-      // If not, the edge counts as a whole rotatable bond
+    /* Bridges are not part of any cycle and count as a whole rotatable bond.
+     * Cycle data is only needed for the remaining bonds.
+     */
+    if(!graph.canRemove(edge)) {
       count += 1.0;
     } else {
-      /* Otherwise, the contribution to the number of rotatable bonds is
-       * calculated as
+      cycleBonds.push_back(edge);
+    }
+  }
+
+  if(!cycleBonds.empty()) {
+    const auto smallestCycle = smallestCycleSizes(graph.cycles());
+    for(const BondIndex& edge : cycleBonds) {
+      /* The contribution of a bond in a cycle to the number of rotatable
+       * bonds is calculated as
        *
        *   max(0.0, (cycle size - 3) / cycle size)
        *
        */
-      unsigned cycleSize = findIter->second;
+      const unsigned cycleSize = smallestCycle.at(edge);
       count += std::max(0.0, (cycleSize - 3.0) / cycleSize);
     }
   }
@@ -83,5 +103,44 @@ unsigned numRotatableBonds(const Molecule& mol) {
   );
 }
 
+DescriptorColumns descriptors(const std::vector<Molecule>& molecules) {
+  const int M = molecules.size();
+  DescriptorColumns columns;
+  columns.atoms.resize(M);
+  columns.heavyAtoms.resize(M);
+  columns.bonds.resize(M);
+  columns.rotatableBonds.resize(M);
+  columns.cycleFamilies.resize(M);
+  columns.molecularWeights.resize(M);
+
+  /* Each molecule's graph caches its own bridges and cycles, so molecules are
+   * independent of one another
+   */
+#pragma omp parallel for schedule(dynamic)
+  for(int i = 0; i < M; ++i) {
+    const Molecule& molecule = molecules[i];
+    const Graph& graph = molecule.graph();
+
+    unsigned heavyAtoms = 0;
+    double weight = 0;
+    for(const AtomIndex j : graph.atoms()) {
+      const Utils::ElementType element = graph.elementType(j);
+      weight += Utils::ElementInfo::mass(element);
+      if(Utils::ElementInfo::Z(element) != 1) {
+        ++heavyAtoms;
+      }
+    }
+
+    columns.atoms(i) = graph.N();
+    columns.heavyAtoms(i) = heavyAtoms;
+    columns.bonds(i) = graph.B();
+    columns.rotatableBonds(i) = numRotatableBonds(molecule);
+    columns.cycleFamilies(i) = graph.cycles().numCycleFamilies();
+    columns.molecularWeights(i) = weight;
+  }
+
+  return columns;
+}
+
 } // namespace molassmembler
 } // namespace Scine
@@ -10,6 +10,9 @@
 
 #include "Molassembler/Export.h"
 
+#include <Eigen/Core>
+#include <vector>
+
 namespace Scine {
 namespace Molassembler {
 
@@ -31,6 +34,10 @@ class Molecule;
  * - If part of a cycle, contributes (S - 3) / S to the sum (where S is
  *   the cycle size).
  *
+ * Whether a bond is part of a cycle is determined from the graph's cached
+ * bridges, so that cycle data is only needed if a candidate bond is in a
+ * cycle.
+ *
  * @complexity{@math{\Theta(B)} where @math{B} is the number of bonds}
  *
  * @warning The number of rotatable bonds is an unphysical descriptor and
@@ -41,6 +48,44 @@ class Molecule;
  */
 MASM_EXPORT unsigned numRotatableBonds(const Molecule& mol);
 
+/**
+ * @brief Graph descriptors of many molecules in columns
+ *
+ * Each column has an entry per molecule, in the order of the molecules.
+ */
+struct MASM_EXPORT DescriptorColumns {
+  //! Column type of counts
+  using Counts = Eigen::Matrix<unsigned, Eigen::Dynamic, 1>;
+
+  //! Number of atoms
+  Counts atoms;
+  //! Number of atoms that are not hydrogen isotopes
+  Counts heavyAtoms;
+  //! Number of bonds
+  Counts bonds;
+  //! Number of rotatable bonds as numRotatableBonds()
+  Counts rotatableBonds;
+  //! Number of unique ring families
+  Counts cycleFamilies;
+  //! Sum of the atoms' standard atomic weights
+  Eigen::VectorXd molecularWeights;
+};
+
+/*! @brief Calculates graph descriptors of many molecules
+ *
+ * All descriptors of a molecule are calculated in a single pass, sharing the
+ * graph's cached bridges and cycle data.
+ *
+ * @complexity{@math{\Theta(M B)} for @math{M} molecules, plus cycle
+ * perception of each cyclic molecule}
+ *
+ * @parblock @note This function is parallelized over molecules. Use the
+ * OMP_NUM_THREADS environment variable to control the number of threads
+ * used.
+ * @endparblock
+ */
+MASM_EXPORT DescriptorColumns descriptors(const std::vector<Molecule>& molecules);
+
 } // namespace Molassembler
 } // namespace Scine
 
@@ -0,0 +1,78 @@
+/*!@file
+ * @copyright This code is licensed under the 3-clause BSD license.
+ *   Copyright ETH Zurich, Laboratory of Physical Chemistry, Reiher Group.
+ *   See LICENSE.txt for details.
+ */
+
+#include "Molassembler/Detail/CyclicPolygons.h"
+
+#include "boost/functional/hash.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <mutex>
+#include <unordered_map>
+
+namespace Scine {
+namespace Molassembler {
+namespace CyclicPolygons {
+namespace Detail {
+namespace {
+
+constexpr double edgeLengthQuantum = 1e-8;
+
+using CircumradiusKey = std::vector<long long>;
+
+struct CircumradiusCache {
+  std::mutex mutex;
+  std::unordered_map<
+    CircumradiusKey,
+    std::pair<double, bool>,
+    boost::hash<CircumradiusKey>
+  > solutions;
+};
+
+CircumradiusCache& circumradiusCache() {
+  static CircumradiusCache cache;
+  return cache;
+}
+
+} // namespace
+
+std::pair<double, bool> cachedConvexCircumradius(const std::vector<double>& edgeLengths) {
+  CircumradiusKey key = Temple::map(
+    edgeLengths,
+    [](const double length) -> long long {
+      return std::llround(length / edgeLengthQuantum);
+    }
+  );
+  std::sort(std::begin(key), std::end(key));
+
+  CircumradiusCache& cache = circumradiusCache();
+  {
+    std::lock_guard<std::mutex> lock(cache.mutex);
+    const auto findIter = cache.solutions.find(key);
+    if(findIter != std::end(cache.solutions)) {
+      return findIter->second;
+    }
+  }
+
+  // Solve outside the lock, concurrent solutions of the same key are identical
+  const auto solution = convexCircumradius(
+    Temple::map(
+      key,
+      [](const long long quantized) -> double {
+        return quantized * edgeLengthQuantum;
+      }
+    )
+  );
+
+  std::lock_guard<std::mutex> lock(cache.mutex);
+  cache.solutions.emplace(std::move(key), solution);
+  return solution;
+}
+
+} // namespace Detail
+} // namespace CyclicPolygons
+} // namespace Molassembler
+} // namespace Scine
@@ -408,6 +408,31 @@ std::pair<FloatType, bool> convexCircumradius(const std::vector<FloatType>& edge
   return {root, true};
 }
 
+/*!
+ * @brief Memoized circumradius of a convex cyclic polygon
+ *
+ * The circumradius does not depend on the order of edges, so solutions are
+ * kept by the sorted edge lengths, quantized to 1e-8. Each distinct polygon is
+ * solved once per process with the quantized edge lengths, so results do not
+ * depend on the order of calls. Thread-safe.
+ *
+ * @complexity{@math{\Theta(N \log N)} if cached}
+ *
+ * @param edgeLengths adjacent edge lengths composing the polygon
+ */
+std::pair<double, bool> cachedConvexCircumradius(const std::vector<double>& edgeLengths);
+
+//! Solves for the circumradius of a convex cyclic polygon
+template<typename FloatType>
+std::pair<FloatType, bool> circumradius(const std::vector<FloatType>& edgeLengths) {
+  return convexCircumradius(edgeLengths);
+}
+
+//! Looks up the circumradius of a convex cyclic polygon in the cache
+inline std::pair<double, bool> circumradius(const std::vector<double>& edgeLengths) {
+  return cachedConvexCircumradius(edgeLengths);
+}
+
 /*!
  * @brief Calculates the internal angles of a polygon when the circumradius and
  *   position of the circumcenter are known
@@ -545,7 +570,7 @@ std::enable_if_t<
     return Detail::quadrilateralShortcut<FloatType>(edgeLengths);
   }
 
-  auto circumradiusResult = Detail::convexCircumradius(edgeLengths);
+  auto circumradiusResult = Detail::circumradius(edgeLengths);
 
   // General solving scheme
   return Detail::generalizedInternalAngles(
@@ -0,0 +1,83 @@
+/*!@file
+ * @copyright This code is licensed under the 3-clause BSD license.
+ *   Copyright ETH Zurich, Laboratory of Physical Chemistry, Reiher Group.
+ *   See LICENSE.txt for details.
+ * @brief Recording of library metrics, see Metrics.h
+ */
+
+#ifndef INCLUDE_MOLASSEMBLER_DETAIL_METRICS_H
+#define INCLUDE_MOLASSEMBLER_DETAIL_METRICS_H
+
+#include <chrono>
+
+enum class DgError;
+
+namespace Scine {
+namespace Molassembler {
+
+// Forward-declarations
+namespace Metrics {
+struct SlowRanking;
+} // namespace Metrics
+
+namespace Detail {
+namespace Metrics {
+
+//! Counted and timed operations
+enum class Operation : unsigned {
+  Ranking,
+  CycleRecomputation,
+  AbstractPermutations,
+  FeasiblePermutations,
+  ShapeMeasure,
+  Nauty
+};
+
+//! Number of operations
+constexpr unsigned operationCount = 6;
+
+//! Tallies a finished operation
+void record(Operation operation, std::chrono::steady_clock::duration duration);
+
+//! Raises the maximal ranking tree depth if necessary
+void recordRankingDepth(unsigned depth);
+
+//! Tallies a failed conformer
+void recordDgFailure(DgError error);
+
+//! Tallies a spatial model diagnosed as infeasible before generation
+void recordInfeasibleModel();
+
+//! Wall time after which the ranking watchdog reports rankings, zero if off
+std::chrono::steady_clock::duration rankingWatchdogThreshold();
+
+//! Whether ranking watchdog reports include graphviz representations
+bool rankingWatchdogGraphviz();
+
+//! Keeps a ranking watchdog report unless there are enough already
+void recordSlowRanking(Molassembler::Metrics::SlowRanking report);
+
+//! Tallies an operation from construction to destruction
+class Timer {
+public:
+  explicit Timer(const Operation operation)
+    : operation_(operation), begin_(std::chrono::steady_clock::now()) {}
+
+  Timer(const Timer& other) = delete;
+  Timer& operator = (const Timer& other) = delete;
+
+  ~Timer() {
+    record(operation_, std::chrono::steady_clock::now() - begin_);
+  }
+
+private:
+  Operation operation_;
+  std::chrono::steady_clock::time_point begin_;
+};
+
+} // namespace Metrics
+} // namespace Detail
+} // namespace Molassembler
+} // namespace Scine
+
+#endif
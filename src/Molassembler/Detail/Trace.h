@@ -0,0 +1,62 @@
+/*!@file
+ * @copyright This code is licensed under the 3-clause BSD license.
+ *   Copyright ETH Zurich, Laboratory of Physical Chemistry, Reiher Group.
+ *   See LICENSE.txt for details.
+ * @brief Trace span recording, see Trace.h
+ */
+
+#ifndef INCLUDE_MOLASSEMBLER_DETAIL_TRACE_H
+#define INCLUDE_MOLASSEMBLER_DETAIL_TRACE_H
+
+#include <chrono>
+
+namespace Scine {
+namespace Molassembler {
+namespace Detail {
+
+//! Records a finished span in the calling thread's trace
+void recordTraceSpan(
+  const char* name,
+  std::chrono::steady_clock::time_point begin,
+  std::chrono::steady_clock::time_point end
+);
+
+//! Records a span from construction to destruction
+class TraceSpan {
+public:
+  //! @param name Span name, a string literal
+  explicit TraceSpan(const char* name)
+    : name_(name), begin_(std::chrono::steady_clock::now()) {}
+
+  TraceSpan(const TraceSpan& other) = delete;
+  TraceSpan& operator = (const TraceSpan& other) = delete;
+
+  ~TraceSpan() {
+    recordTraceSpan(name_, begin_, std::chrono::steady_clock::now());
+  }
+
+private:
+  const char* name_;
+  std::chrono::steady_clock::time_point begin_;
+};
+
+} // namespace Detail
+} // namespace Molassembler
+} // namespace Scine
+
+#define MOLASSEMBLER_TRACE_CONCAT_IMPL(a, b) a ## b
+#define MOLASSEMBLER_TRACE_CONCAT(a, b) MOLASSEMBLER_TRACE_CONCAT_IMPL(a, b)
+
+/*! @brief Records a span until the end of the enclosing scope
+ *
+ * Expands to nothing unless the library is compiled with tracing.
+ */
+#ifdef MOLASSEMBLER_TRACE
+#define MOLASSEMBLER_TRACE_SPAN(name) \
+  const ::Scine::Molassembler::Detail::TraceSpan \
+    MOLASSEMBLER_TRACE_CONCAT(traceSpan, __LINE__) {name}
+#else
+#define MOLASSEMBLER_TRACE_SPAN(name) static_cast<void>(0)
+#endif
+
+#endif
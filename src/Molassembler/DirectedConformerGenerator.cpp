@@ -8,6 +8,7 @@
 #include "DistanceGeometry/DirectedConformerGeneratorImpl.h"
 
 #include "Molassembler/Molecule.h"
+#include "Molassembler/Parallel.h"
 #include "Molassembler/StereopermutatorList.h"
 #include "Molassembler/Stereopermutation/Composites.h"
 #include "Molassembler/Detail/Cartesian.h"
@@ -16,8 +17,75 @@
 
 #include "boost/variant.hpp"
 
+#include <limits>
+
 namespace Scine {
 namespace Molassembler {
+namespace {
+
+using Relabeler = DirectedConformerGenerator::Relabeler;
+
+//! Index of the bin containing a dihedral, or the number of bins if none does
+unsigned findBin(const Relabeler::Intervals& bins, const double dihedral) {
+  const auto findIter = Temple::find_if(
+    bins,
+    [&](const Relabeler::Interval& interval) -> bool {
+      if(interval.first <= interval.second) {
+        return interval.first <= dihedral && dihedral <= interval.second;
+      }
+
+      return interval.first <= dihedral || dihedral <= interval.second;
+    }
+  );
+
+  assert(findIter != std::end(bins));
+  return findIter - std::begin(bins);
+}
+
+//! Average position of a subset of rows of an Nx3 positions expression
+template<typename Positions>
+Eigen::Vector3d averageRow(
+  const Positions& positions,
+  const std::vector<AtomIndex>& indices
+) {
+  if(indices.size() == 1) {
+    return positions.row(indices.front()).transpose();
+  }
+
+  Eigen::Vector3d sum = Eigen::Vector3d::Zero();
+  for(const AtomIndex i : indices) {
+    sum += positions.row(i).transpose();
+  }
+  return sum / indices.size();
+}
+
+//! Symmetry-reduced dihedral of a sequence in an Nx3 positions expression
+template<typename Positions>
+double sequenceDihedral(
+  const Relabeler::DihedralInfo& sequence,
+  const Positions& positions
+) {
+  double dihedral = Cartesian::dihedral(
+    averageRow(positions, sequence.is),
+    positions.row(sequence.j).transpose(),
+    positions.row(sequence.k).transpose(),
+    averageRow(positions, sequence.ls)
+  );
+
+  // Reduce by rotational symmetry if present
+  if(sequence.symmetryOrder > 1) {
+    dihedral = Cartesian::signedDihedralAngle(
+      std::fmod(
+        Cartesian::positiveDihedralAngle(dihedral),
+        2 * M_PI / sequence.symmetryOrder
+      )
+    );
+  }
+
+  return dihedral;
+}
+
+} // namespace
 
 constexpr std::uint8_t DirectedConformerGenerator::unknownDecision;
 
@@ -54,6 +122,14 @@ DirectedConformerGenerator::DecisionList DirectedConformerGenerator::generateNew
   return pImpl_->generateNewDecisionList(engine);
 }
 
+void DirectedConformerGenerator::setDecisionCosts(const std::vector<std::vector<double>>& costs) {
+  pImpl_->setDecisionCosts(costs);
+}
+
+void DirectedConformerGenerator::setDecisionCosts(const AssignmentCost& cost) {
+  pImpl_->setDecisionCosts(cost);
+}
+
 bool DirectedConformerGenerator::insert(const DecisionList& decisionList) {
   return pImpl_->insert(decisionList);
 }
@@ -70,6 +146,10 @@ const DirectedConformerGenerator::BondList& DirectedConformerGenerator::bondList
   return pImpl_->bondList();
 }
 
+const Molecule& DirectedConformerGenerator::molecule() const {
+  return pImpl_->molecule();
+}
+
 unsigned DirectedConformerGenerator::decisionListSetSize() const {
   return pImpl_->decisionListSetSize();
 }
@@ -97,6 +177,17 @@ DirectedConformerGenerator::generateConformation(
   return pImpl_->generateConformation(decisionList, seed, configuration, fitting);
 }
 
+outcome::result<Utils::PositionCollection>
+DirectedConformerGenerator::generateConformationFrom(
+  const Utils::PositionCollection& reference,
+  const DecisionList& decisionList,
+  const unsigned seed,
+  const DistanceGeometry::Configuration& configuration,
+  const BondStereopermutator::FittingMode fitting
+) const {
+  return pImpl_->generateConformationFrom(reference, decisionList, seed, configuration, fitting);
+}
+
 Molecule DirectedConformerGenerator::conformationMolecule(const DecisionList& decisionList) const {
   return pImpl_->conformationMolecule(decisionList);
 }
@@ -115,6 +206,14 @@ DirectedConformerGenerator::DecisionList DirectedConformerGenerator::getDecision
   return pImpl_->getDecisionList(positions, mode);
 }
 
+std::vector<DirectedConformerGenerator::DecisionList>
+DirectedConformerGenerator::getDecisionLists(
+  const FrameBuffer& frames,
+  const BondStereopermutator::FittingMode mode
+) const {
+  return pImpl_->getDecisionLists(frames, mode);
+}
+
 void DirectedConformerGenerator::enumerate(
   std::function<void(const DecisionList&, Utils::PositionCollection)> callback,
   unsigned seed,
@@ -131,6 +230,44 @@ void DirectedConformerGenerator::enumerateRandom(
   return pImpl_->enumerate(std::move(callback), engine(), settings);
 }
 
+void DirectedConformerGenerator::checkpoint(
+  const std::string& filename,
+  const Random::Engine& engine
+) const {
+  pImpl_->checkpoint(filename, engine);
+}
+
+void DirectedConformerGenerator::resume(
+  const std::string& filename,
+  Random::Engine& engine
+) {
+  pImpl_->resume(filename, engine);
+}
+
+std::string DirectedConformerGenerator::checkpointBytes(
+  const Random::Engine& engine
+) const {
+  return pImpl_->checkpointBytes(engine);
+}
+
+void DirectedConformerGenerator::resumeFromBytes(
+  const std::string& bytes,
+  Random::Engine& engine
+) {
+  pImpl_->resumeFromBytes(bytes, engine);
+}
+
+unsigned DirectedConformerGenerator::merge(const std::string& filename) {
+  return pImpl_->merge(filename);
+}
+
+std::pair<unsigned, unsigned> DirectedConformerGenerator::shardRange(
+  const unsigned count,
+  const unsigned index
+) const {
+  return Impl::shard(idealEnsembleSize(), count, index);
+}
+
 DirectedConformerGenerator::Relabeler DirectedConformerGenerator::relabeler() const {
   return pImpl_->relabeler();
 }
@@ -144,7 +281,8 @@ DirectedConformerGenerator::binMidpointIntegers(
 
 DirectedConformerGenerator::Relabeler::Relabeler(
   const DirectedConformerGenerator::BondList& bonds,
-  const Molecule& mol
+  const Molecule& mol,
+  const unsigned histogramResolution
 ) {
   // Determine the dominant dihedral sequences at each bond
   for(const BondIndex& bond : bonds) {
@@ -173,38 +311,81 @@ DirectedConformerGenerator::Relabeler::Relabeler(
   }
 
   observedDihedrals.resize(sequences.size());
+
+  if(histogramResolution == 0) {
+    throw std::invalid_argument("Dihedral histograms need at least one cell");
+  }
+
+  constexpr double infinity = std::numeric_limits<double>::infinity();
+  dihedralHistograms.assign(
+    sequences.size(),
+    Intervals(histogramResolution, Interval(infinity, -infinity))
+  );
+}
+
+std::vector<double> DirectedConformerGenerator::Relabeler::dihedrals(
+  const Utils::PositionCollection& positions
+) const {
+  return Temple::map(
+    sequences,
+    [&](const DihedralInfo& sequence) -> double {
+      return sequenceDihedral(sequence, positions);
+    }
+  );
 }
 
 void DirectedConformerGenerator::Relabeler::add(
   const Utils::PositionCollection& positions
 ) {
-  auto sequenceIter = std::cbegin(sequences);
-  const auto bondEnd = std::cend(sequences);
-  auto dihedralIter = std::begin(observedDihedrals);
-  const auto dihedralEnd = std::end(observedDihedrals);
-
-  while(sequenceIter != bondEnd && dihedralIter != dihedralEnd) {
-    double dihedral = Cartesian::dihedral(
-      Cartesian::averagePosition(positions, sequenceIter->is),
-      positions.row(sequenceIter->j),
-      positions.row(sequenceIter->k),
-      Cartesian::averagePosition(positions, sequenceIter->ls)
-    );
+  const auto structureDihedrals = dihedrals(positions);
+  const unsigned bondCount = sequences.size();
+  for(unsigned bond = 0; bond < bondCount; ++bond) {
+    observedDihedrals.at(bond).push_back(structureDihedrals.at(bond));
+  }
+}
 
-    // Reduce by rotational symmetry if present
-    if(sequenceIter->symmetryOrder > 1) {
-      dihedral = Cartesian::signedDihedralAngle(
-        std::fmod(
-          Cartesian::positiveDihedralAngle(dihedral),
-          2 * M_PI / sequenceIter->symmetryOrder
-        )
-      );
+void DirectedConformerGenerator::Relabeler::addFrames(const FrameBuffer& frames) {
+  using FrameMap = Eigen::Map<
+    const Eigen::Matrix<double, Eigen::Dynamic, 3, Eigen::RowMajor>
+  >;
+
+  if(frames.cols() % 3 != 0) {
+    throw std::invalid_argument("Frame buffer columns are not a multiple of three");
+  }
+
+  const unsigned frameCount = frames.rows();
+  const unsigned atomCount = frames.cols() / 3;
+  const unsigned bondCount = sequences.size();
+  const unsigned offset = observedDihedrals.empty() ? 0 : observedDihedrals.front().size();
+  for(auto& bondDihedrals : observedDihedrals) {
+    bondDihedrals.resize(offset + frameCount);
+  }
+
+  Parallel::forEach(frameCount, [&](const unsigned frame, unsigned /* worker */) {
+    const FrameMap positions(frames.row(frame).data(), atomCount, 3);
+    for(unsigned bond = 0; bond < bondCount; ++bond) {
+      observedDihedrals[bond][offset + frame] = sequenceDihedral(sequences[bond], positions);
     }
+  });
+}
 
-    dihedralIter->push_back(dihedral);
+void DirectedConformerGenerator::Relabeler::accumulate(
+  const Utils::PositionCollection& positions
+) {
+  const auto structureDihedrals = dihedrals(positions);
+  const unsigned bondCount = sequences.size();
+  for(unsigned bond = 0; bond < bondCount; ++bond) {
+    Intervals& histogram = dihedralHistograms.at(bond);
+    const unsigned resolution = histogram.size();
+    const double dihedral = structureDihedrals.at(bond);
+    const unsigned cell = std::min(
+      static_cast<unsigned>((dihedral + M_PI) / (2 * M_PI) * resolution),
+      resolution - 1
+    );
 
-    ++sequenceIter;
-    ++dihedralIter;
+    Interval& extrema = histogram.at(cell);
+    extrema.first = std::min(extrema.first, dihedral);
+    extrema.second = std::max(extrema.second, dihedral);
   }
 }
 
@@ -275,6 +456,32 @@ DirectedConformerGenerator::Relabeler::bins(const double delta) const {
   );
 }
 
+std::vector<DirectedConformerGenerator::Relabeler::Intervals>
+DirectedConformerGenerator::Relabeler::histogramBins(const double delta) const {
+  return Temple::map(
+    Temple::Adaptors::zip(dihedralHistograms, sequences),
+    [&](const Intervals& histogram, const DihedralInfo& sequence) -> Intervals {
+      if(delta < 2 * M_PI / histogram.size()) {
+        throw std::logic_error("Bin delta is smaller than dihedral histogram cells");
+      }
+
+      std::vector<double> extrema;
+      for(const Interval& cell : histogram) {
+        if(cell.first > cell.second) {
+          continue;
+        }
+
+        extrema.push_back(cell.first);
+        if(cell.second != cell.first) {
+          extrema.push_back(cell.second);
+        }
+      }
+
+      return densityBins(extrema, delta, sequence.symmetryOrder);
+    }
+  );
+}
+
 std::vector<std::vector<unsigned>>
 DirectedConformerGenerator::Relabeler::binIndices(
   const std::vector<Intervals>& allBins
@@ -284,29 +491,61 @@ DirectedConformerGenerator::Relabeler::binIndices(
 
   std::vector<std::vector<unsigned>> relabeling(structureCount, std::vector<unsigned>(bondCount));
 
-#pragma omp parallel for collapse(2)
-  for(unsigned structure = 0; structure < structureCount; ++structure) {
+  Parallel::forEach(structureCount, [&](const unsigned structure, unsigned /* worker */) {
     for(unsigned bond = 0; bond < bondCount; ++bond) {
-      const auto& bins = allBins.at(bond);
-      double observedDihedral = observedDihedrals.at(bond).at(structure);
-
-      const auto findIter = Temple::find_if(
-        bins,
-        [&](const Interval& interval) -> bool {
-          if(interval.first <= interval.second) {
-            return interval.first <= observedDihedral && observedDihedral <= interval.second;
-          }
-
-          return interval.first <= observedDihedral || observedDihedral <= interval.second;
-        }
+      relabeling.at(structure).at(bond) = findBin(
+        allBins.at(bond),
+        observedDihedrals.at(bond).at(structure)
       );
+    }
+  });
 
-      assert(findIter != std::end(bins));
+  return relabeling;
+}
 
-      relabeling.at(structure).at(bond) = findIter - std::begin(bins);
+std::vector<unsigned>
+DirectedConformerGenerator::Relabeler::binIndices(
+  const std::vector<Intervals>& allBins,
+  const Utils::PositionCollection& positions
+) const {
+  return Temple::map(
+    Temple::Adaptors::zip(allBins, dihedrals(positions)),
+    [](const Intervals& bins, const double dihedral) -> unsigned {
+      return findBin(bins, dihedral);
     }
+  );
+}
+
+std::vector<std::vector<unsigned>>
+DirectedConformerGenerator::Relabeler::binIndices(
+  const std::vector<Intervals>& allBins,
+  const FrameReader& reader,
+  const unsigned chunkSize
+) const {
+  if(chunkSize == 0) {
+    throw std::invalid_argument("Chunk size must be positive");
   }
 
+  std::vector<std::vector<unsigned>> relabeling;
+  std::vector<Utils::PositionCollection> chunk(chunkSize);
+  bool exhausted = false;
+  while(!exhausted) {
+    unsigned chunkFrames = 0;
+    while(chunkFrames < chunkSize) {
+      if(!reader(chunk.at(chunkFrames))) {
+        exhausted = true;
+        break;
+      }
+      ++chunkFrames;
+    }
+
+    const unsigned offset = relabeling.size();
+    relabeling.resize(offset + chunkFrames);
+
+    Parallel::forEach(chunkFrames, [&](const unsigned i, unsigned /* worker */) {
+      relabeling[offset + i] = binIndices(allBins, chunk[i]);
+    });
+  }
 
   return relabeling;
 }
@@ -348,14 +587,13 @@ DirectedConformerGenerator::Relabeler::binMidpointIntegers(
 
   std::vector<std::vector<int>> relabeling(structureCount, std::vector<int>(bondCount));
 
-#pragma omp parallel for collapse(2)
-  for(unsigned structure = 0; structure < structureCount; ++structure) {
+  Parallel::forEach(structureCount, [&](const unsigned structure, unsigned /* worker */) {
     for(unsigned bond = 0; bond < bondCount; ++bond) {
       relabeling.at(structure).at(bond) = binMidpointIntegers.at(bond).at(
         binIndices.at(structure).at(bond)
       );
     }
-  }
+  });
 
   return relabeling;
 }
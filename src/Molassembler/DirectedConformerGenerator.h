@@ -104,6 +104,25 @@ public:
   //! Value set in decision lists if no decision could be recovered
   constexpr static std::uint8_t unknownDecision = std::numeric_limits<std::uint8_t>::max();
 
+  /*! @brief Cost of an assignment at a relevant bond, lower is preferred
+   *
+   * Called with the index of the bond in bondList() and an assignment of
+   * that bond's stereopermutator.
+   */
+  using AssignmentCost = std::function<double(unsigned, std::uint8_t)>;
+
+  /*! @brief Row-major buffer of frames, one per row
+   *
+   * Each row holds the x, y and z coordinates of each atom in sequence, i.e.
+   * an F x N x 3 array of F frames of N atoms viewed as F x 3N. Rows may be
+   * strided.
+   */
+  using FrameBuffer = Eigen::Ref<
+    const Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>,
+    0,
+    Eigen::OuterStride<>
+  >;
+
   //* @brief Reason why a bond is ignored
   enum class IgnoreReason {
     //! There is not an assigned stereopermutator on both ends of the bond
@@ -265,6 +284,7 @@ public:
   /*! @brief Generate a new list of discrete dihedral arrangement choices
    *
    * Guarantees that the generated list is not yet part of the underlying set.
+   * Choices are random unless decision costs are set with setDecisionCosts().
    *
    * @complexity{@math{\Theta(N)}}
    *
@@ -282,6 +302,40 @@ public:
    */
   DecisionList generateNewDecisionList(Random::Engine& engine = randomnessEngine());
 
+  /*! @brief Generate decision lists best-first by a sum of assignment costs
+   *
+   * Subsequent calls to generateNewDecisionList() yield the decision lists
+   * not yet part of the underlying set in order of nondecreasing total cost,
+   * i.e. the sum of the costs of each bond's assignment, instead of choosing
+   * them randomly. Ties are broken lexicographically. This is useful in large
+   * decision list spaces, where generation can then be stopped after the
+   * most favorable conformers.
+   *
+   * @param costs Costs indexed by bond in bondList(), then by assignment.
+   *   Passing an empty list restores random decision list generation.
+   *
+   * @complexity{@math{\Theta(A \log A)} where @math{A} is the total number
+   * of assignments.}
+   *
+   * @throws std::invalid_argument If @p costs does not match the number of
+   *   relevant bonds or their number of assignments, or contains NaN.
+   * @post Order of generation restarts from the lowest cost decision list.
+   * @parblock @note Best-first generation is deterministic and does not
+   *   advance the state of the PRNG passed to generateNewDecisionList().
+   * @endparblock
+   */
+  void setDecisionCosts(const std::vector<std::vector<double>>& costs);
+
+  /*! @brief Generate decision lists best-first by a sum of assignment costs
+   *
+   * Evaluates @p cost once for each assignment of each relevant bond and
+   * generates decision lists best-first by their sum. See the overload
+   * taking an explicit cost table for details.
+   *
+   * @throws std::invalid_argument If @p cost yields NaN.
+   */
+  void setDecisionCosts(const AssignmentCost& cost);
+
   /*!
    * @brief Adds a decision list to the underlying set-like data structure
    *
@@ -303,6 +357,98 @@ public:
    * @complexity{@math{\Theta(N)}}
    */
   bool contains(const DecisionList& decisionList) const;
+
+  /*! @brief Writes the generator state to a compact binary checkpoint file
+   *
+   * Stores the alignment, the relevant bonds, all decision lists of the
+   * underlying set and the state of @p engine so that a preempted job can
+   * resume() without generating any decision list a second time. Decision
+   * lists are stored as delta-encoded indices of the decision list space,
+   * usually needing one or two bytes each. Decision costs are not stored.
+   *
+   * @complexity{@math{\Theta(S \log S)} where @math{S} is the size of the
+   * underlying set}
+   *
+   * @param filename Path of the checkpoint file. The file is written under a
+   *   temporary name first and then renamed, so that existing checkpoints are
+   *   not corrupted by interruptions.
+   * @param engine PRNG whose state is stored
+   *
+   * @throws std::runtime_error If the file cannot be written
+   */
+  void checkpoint(
+    const std::string& filename,
+    const Random::Engine& engine = randomnessEngine()
+  ) const;
+
+  /*! @brief Restores the generator state from a checkpoint file
+   *
+   * Replaces the underlying set of decision lists with the checkpointed one
+   * and sets the state of @p engine to the checkpointed state, so that
+   * decision list generation continues exactly where the checkpointed
+   * generator left off.
+   *
+   * @complexity{@math{\Theta(S N)}}
+   *
+   * @param filename Path of the checkpoint file written by checkpoint()
+   * @param engine PRNG whose state is restored
+   *
+   * @throws std::runtime_error If the file cannot be read or is malformed
+   * @throws std::invalid_argument If the checkpoint was written by a
+   *   generator with a different alignment or set of relevant bonds
+   */
+  void resume(
+    const std::string& filename,
+    Random::Engine& engine = randomnessEngine()
+  );
+
+  /*! @brief Checkpoint of the generator state in memory
+   *
+   * Yields the contents of the file that checkpoint() would write, e.g. to
+   * pass the generator state between processes without a file.
+   *
+   * @complexity{@math{\Theta(S \log S)} where @math{S} is the size of the
+   * underlying set}
+   *
+   * @param engine PRNG whose state is stored
+   */
+  std::string checkpointBytes(const Random::Engine& engine = randomnessEngine()) const;
+
+  /*! @brief Restores the generator state from an in-memory checkpoint
+   *
+   * Equivalent to resume() with a file containing @p bytes.
+   *
+   * @complexity{@math{\Theta(S N)}}
+   *
+   * @param bytes Checkpoint yielded by checkpointBytes()
+   * @param engine PRNG whose state is restored
+   *
+   * @throws std::runtime_error If the checkpoint is malformed
+   * @throws std::invalid_argument If the checkpoint was written by a
+   *   generator with a different alignment or set of relevant bonds
+   */
+  void resumeFromBytes(
+    const std::string& bytes,
+    Random::Engine& engine = randomnessEngine()
+  );
+
+  /*! @brief Adds the decision lists of a checkpoint file to the underlying set
+   *
+   * Merges the results of enumerations of separate shards of the decision
+   * list space (see EnumerationSettings::shardCount) or of separate processes.
+   * Does not modify any PRNG state.
+   *
+   * @complexity{@math{\Theta(S N)}}
+   *
+   * @param filename Path of a checkpoint file written by checkpoint()
+   *
+   * @throws std::runtime_error If the file cannot be read or is malformed
+   * @throws std::invalid_argument If the checkpoint was written by a
+   *   generator with a different alignment or set of relevant bonds
+   *
+   * @returns The number of decision lists that were not yet part of the set
+   */
+  unsigned merge(const std::string& filename);
 //!@}
 
 //!@name Information
@@ -319,6 +465,13 @@ public:
    */
   const BondList& bondList() const;
 
+  /*!
+   * @brief Accessor for the underlying molecule
+   *
+   * @complexity{@math{\Theta(1)}}
+   */
+  const Molecule& molecule() const;
+
   /*!
    * @brief Number of conformer decision lists stored in the underlying
    *   set-like data structure
@@ -365,6 +518,13 @@ public:
    *
    * @see Scine::Molassembler::generateConformation()
    *
+   * @parblock @note The spatial model of the molecule without the considered
+   * bonds' dihedral information is built once and reused across decision
+   * lists unless fixed positions are set or the molecule has unassigned
+   * stereopermutators. Only the affected distance bounds are re-smoothed for
+   * each decision list.
+   * @endparblock
+   *
    * @throws std::invalid_argument If the passed decisionList does not match
    *   the length of the result of bondList().
    */
@@ -375,6 +535,35 @@ public:
     BondStereopermutator::FittingMode fitting = BondStereopermutator::FittingMode::Nearest
   ) const;
 
+  /*! @brief Generate a conformer for a decision list from a reference
+   *   structure without embedding
+   *
+   * Rigidly rotates the reference structure about each considered bond to
+   * the dominant dihedral of the decision list and refines the result. Since
+   * the rotated structure is already close to satisfying the distance bounds,
+   * refinement converges in few iterations. If the rotation leads to
+   * clashes, the refinement fails, or the refined conformer does not match
+   * the decision list, falls back to generateConformation() with @p seed.
+   *
+   * @param reference Positions of a conformer of the molecule in bohr, e.g.
+   *   an already generated or energy-minimized conformer
+   * @param decisionList Decision list the new conformer should match
+   * @param seed Seed for the full conformer generation fallback
+   * @param configuration Conformer generation settings
+   * @param fitting How the decision list is fitted to the conformer
+   *
+   * @throws std::invalid_argument If the passed decisionList does not match
+   *   the length of the result of bondList() or @p reference does not match
+   *   the number of atoms of the molecule.
+   */
+  outcome::result<Utils::PositionCollection> generateConformationFrom(
+    const Utils::PositionCollection& reference,
+    const DecisionList& decisionList,
+    unsigned seed,
+    const DistanceGeometry::Configuration& configuration = DistanceGeometry::Configuration {},
+    BondStereopermutator::FittingMode fitting = BondStereopermutator::FittingMode::Nearest
+  ) const;
+
   /*! @brief Yields a molecule reference for a particular decision list
    *
    * @complexity{@math{\Theta(N)} bond stereopermutator assignments}
@@ -427,6 +616,30 @@ public:
     BondStereopermutator::FittingMode mode = BondStereopermutator::FittingMode::Thresholded
   ) const;
 
+  /*! @brief Infer decision lists for relevant bonds from many structures
+   *
+   * Yields the same decision list for each frame as getDecisionList() with
+   * the frame's positions. The stereopermutators to fit and their fitting
+   * references are looked up once for all frames, which are then fitted in
+   * parallel, each worker refitting its own copies of the stereopermutators.
+   *
+   * @param frames Buffer of frames in bohr, one per row
+   * @param mode Mode altering how decisions are fitted
+   *
+   * @complexity{@math{\Theta(FN)} bond stereopermutator fits for @math{F}
+   * frames}
+   *
+   * @throws std::invalid_argument If the number of columns of @p frames is
+   *   not three times the number of atoms of the underlying molecule
+   * @throws std::logic_error Under the same conditions as getDecisionList()
+   *
+   * @returns A decision list per frame
+   */
+  std::vector<DecisionList> getDecisionLists(
+    const FrameBuffer& frames,
+    BondStereopermutator::FittingMode mode = BondStereopermutator::FittingMode::Thresholded
+  ) const;
+
   //! @brief Settings for enumeration
   struct EnumerationSettings {
     EnumerationSettings() : configuration() {}
@@ -437,24 +650,67 @@ public:
     BondStereopermutator::FittingMode fitting = BondStereopermutator::FittingMode::Nearest;
     //! Conformer generation settings
     DistanceGeometry::Configuration configuration;
+    /*! @brief Whether the callback may be invoked simultaneously
+     *
+     * If set, callback invocations from parallel threads are not serialized.
+     * The callback must then be thread-safe.
+     */
+    bool concurrentCallback = false;
+    /*! @brief Whether callback invocations are sequenced
+     *
+     * If set, the callback is invoked in a fixed order of decision lists,
+     * making the entire sequence of callback invocations independent of the
+     * number of threads. Conformers are still generated in parallel, but
+     * threads may have to wait on the callback of preceding decision lists.
+     * Takes precedence over concurrentCallback.
+     */
+    bool orderedCallback = false;
+    /*! @brief Whether to resume an enumeration
+     *
+     * If set, the stored set of decision lists is not cleared and decision
+     * lists already part of it are not enumerated again. Unless
+     * concurrentCallback is set, the callback may insert() the decision lists
+     * of finished conformers and write checkpoint()s, so that an interrupted
+     * enumeration can be resumed from a checkpoint.
+     */
+    bool skipContained = false;
+    /*! @brief Number of disjoint shards the decision list space is split into
+     *
+     * Independent processes, e.g. on different cluster nodes, can each
+     * enumerate a shard with a distinct shardIndex and the same seed without
+     * any shared state. Conformers are identical to those of an enumeration
+     * without shards. The processes' checkpoint()s can be combined with
+     * merge().
+     */
+    unsigned shardCount = 1;
+    //! Index of the shard to enumerate, less than shardCount
+    unsigned shardIndex = 0;
   };
 
   /*! @brief Enumerate all conformers of the captured molecule
    *
    * Clears the stored set of decision lists, then enumerates all conformers of
-   * the molecule in parallel.
+   * the molecule in parallel. See EnumerationSettings::skipContained to
+   * resume enumerations instead.
    *
    * @param callback Function called with decision list and conformer
-   *    positions for each successfully generated. It is guaranteed that the
-   *    callback function is never called simultaneously even in parallel
-   *    execution.
+   *   positions for each successfully generated pair. Unless
+   *   EnumerationSettings::concurrentCallback is set, it is guaranteed that
+   *   the callback function is never called simultaneously even in parallel
+   *   execution.
    * @param seed Randomness initiator for decision list and conformer
    *    generation
    * @param settings Further parameters for enumeration algorithms
    *
+   * @throws The first exception thrown by @p callback, once threads have
+   *   finished the conformers in progress. No further decision lists are
+   *   enumerated after the callback throws.
+   *
    * @parblock @note This function is parallelized. Use the OMP_NUM_THREADS
    * environment variable to control the number of threads used. Callback
-   * invocations are unsequenced but the arguments are reproducible.
+   * invocations are unsequenced unless EnumerationSettings::orderedCallback
+   * is set, but the arguments are reproducible independent of the number of
+   * threads.
    * @endparblock
    */
   void enumerate(
@@ -466,19 +722,27 @@ public:
   /*! @brief Enumerate all conformers of the captured molecule
    *
    * Clears the stored set of decision lists, then enumerates all conformers of
-   * the molecule in parallel.
+   * the molecule in parallel. See EnumerationSettings::skipContained to
+   * resume enumerations instead.
    *
    * @param callback Function called with decision list and conformer
-   *   positions for each successfully generated pair. It is guaranteed that
+   *   positions for each successfully generated pair. Unless
+   *   EnumerationSettings::concurrentCallback is set, it is guaranteed that
    *   the callback function is never called simultaneously even in parallel
    *   execution.
    * @param seed Randomness initiator for decision list and conformer
    *   generation
    * @param settings Further parameters for enumeration algorithms
    *
+   * @throws The first exception thrown by @p callback, once threads have
+   *   finished the conformers in progress. No further decision lists are
+   *   enumerated after the callback throws.
+   *
    * @parblock @note This function is parallelized. Use the OMP_NUM_THREADS
    * environment variable to control the number of threads used. Callback
-   * invocations are unsequenced but the arguments are reproducible.
+   * invocations are unsequenced unless EnumerationSettings::orderedCallback
+   * is set, but the arguments are reproducible independent of the number of
+   * threads.
    * @endparblock
    *
    * @parblock @note This function advances the state of the global PRNG.
@@ -489,6 +753,17 @@ public:
     const EnumerationSettings& settings = {}
   );
 
+  /*! @brief Range of decision list indices enumerated by a shard
+   *
+   * Shards are contiguous, disjoint and cover the decision list space. Their
+   * sizes differ by at most one.
+   *
+   * @throws std::invalid_argument If @p index is not less than @p count
+   *
+   * @returns Half-open range of indices into the decision list space
+   */
+  std::pair<unsigned, unsigned> shardRange(unsigned count, unsigned index) const;
+
   //! Generates a relabeler for the molecule and considered bonds
   Relabeler relabeler() const;
 
@@ -523,6 +798,14 @@ struct DirectedConformerGenerator::Relabeler {
   };
   using Interval = std::pair<double, double>;
   using Intervals = std::vector<Interval>;
+  /*! @brief Reads the next frame of a sequence of structures
+   *
+   * Writes the next frame into the argument and returns whether there was a
+   * frame to read.
+   */
+  using FrameReader = std::function<bool(Utils::PositionCollection&)>;
+  //! Row-major buffer of frames, one per row
+  using FrameBuffer = DirectedConformerGenerator::FrameBuffer;
 //!@}
 
   /*! @brief Simplest density-based binning function
@@ -546,11 +829,54 @@ struct DirectedConformerGenerator::Relabeler {
    * as determined by a DirectedConformerGenerator can be obtained by calling
    * DirectedConformerGenerator::relabeler().
    */
-  Relabeler(const DirectedConformerGenerator::BondList& bonds, const Molecule& mol);
+  Relabeler(
+    const DirectedConformerGenerator::BondList& bonds,
+    const Molecule& mol,
+    unsigned histogramResolution = 720
+  );
+
+  /*! @brief Symmetry-reduced dihedrals of each sequence in a structure
+   *
+   * @complexity{Linear in the number of sequences}
+   */
+  std::vector<double> dihedrals(const Utils::PositionCollection& positions) const;
 
   //! Add a particular position to the set to relabel
   void add(const Utils::PositionCollection& positions);
 
+  /*! @brief Add many frames to the set to relabel at once
+   *
+   * Dihedrals are calculated in parallel across frames directly from the
+   * buffer, without copying frames into position collections.
+   *
+   * @throws std::invalid_argument If the number of columns is not a multiple
+   *   of three
+   */
+  void addFrames(const FrameBuffer& frames);
+
+  /*! @brief Add a particular position to the dihedral histograms only
+   *
+   * Unlike add, the dihedrals are not stored individually, so memory does not
+   * grow with the number of accumulated structures. Structures accumulated
+   * here can be relabeled with histogramBins and the binIndices overloads
+   * taking positions.
+   *
+   * @complexity{Linear in the number of sequences}
+   */
+  void accumulate(const Utils::PositionCollection& positions);
+
+  /*! @brief Generate bins for each set of accumulated dihedrals
+   *
+   * Applies densityBins to the smallest and largest dihedral of each
+   * histogram cell. Since no two consecutive dihedrals within a
+   * cell are further apart than the cell width, the bins are identical to
+   * those of bins for the same structures.
+   *
+   * @throws std::logic_error If @p delta is smaller than the histogram cell
+   *   width or no structures were accumulated
+   */
+  std::vector<Intervals> histogramBins(double delta=M_PI / 6) const;
+
   /*! Generate bins for each set of observed dihedrals
    *
    * Yields a vector of dimension equal to the bonds, with each element a
@@ -571,6 +897,31 @@ struct DirectedConformerGenerator::Relabeler {
     const std::vector<Intervals>& allBins
   ) const;
 
+  //! Determine relabeling of a single structure
+  std::vector<unsigned> binIndices(
+    const std::vector<Intervals>& allBins,
+    const Utils::PositionCollection& positions
+  ) const;
+
+  /*! @brief Determine relabeling of a sequence of structures read in chunks
+   *
+   * Frames are read sequentially in chunks of @p chunkSize, and each chunk is
+   * relabeled in parallel, so that only a chunk of structures is kept in
+   * memory at a time. This is the second pass after accumulating the same
+   * structures.
+   *
+   * @param allBins Bins for all bonds, e.g. from histogramBins
+   * @param reader Reads frames in sequence. Not invoked concurrently.
+   * @param chunkSize Number of frames kept in memory
+   *
+   * @returns Relabeling for each read frame in order
+   */
+  std::vector<std::vector<unsigned>> binIndices(
+    const std::vector<Intervals>& allBins,
+    const FrameReader& reader,
+    unsigned chunkSize = 1024
+  ) const;
+
   //! Relabel bin indices for all structures with bin midpoint integers
   std::vector<std::vector<int>> binMidpointIntegers(
     const std::vector<std::vector<unsigned>>& binIndices,
@@ -581,6 +932,13 @@ struct DirectedConformerGenerator::Relabeler {
 //!@{
   std::vector<DihedralInfo> sequences;
   std::vector<std::vector<double>> observedDihedrals;
+  /*! @brief Smallest and largest accumulated dihedral in each histogram cell
+   *   at each bond
+   *
+   * Cells span equal parts of @math{[-\pi, \pi]}. Empty cells have an
+   * inverted interval of infinities.
+   */
+  std::vector<Intervals> dihedralHistograms;
 //!@}
 };
 
@@ -17,15 +17,30 @@
 #include "Molassembler/DistanceGeometry/MetricMatrix.h"
 #include "Molassembler/DistanceGeometry/RefinementMeta.h"
 #include "Molassembler/Graph/GraphAlgorithms.h"
+#include "Molassembler/Parallel.h"
 #include "Utils/Math/QuaternionFit.h"
 
 #include "Molassembler/Detail/Cartesian.h"
+#include "Molassembler/Detail/Metrics.h"
+#include "Molassembler/Detail/Trace.h"
 #include "Molassembler/Temple/Optimization/Lbfgs.h"
+#include "Molassembler/Temple/Optimization/TrustRegion.h"
 #include "Molassembler/Temple/Optionals.h"
 #include "Molassembler/Temple/Functional.h"
+#include "Molassembler/Temple/Functor.h"
 #include "Molassembler/Temple/Random.h"
+#include "Molassembler/Temple/Stl17.h"
+#include "Molassembler/Temple/Stringify.h"
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <exception>
 #include <iostream>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <numeric>
 
 namespace Scine {
 namespace Molassembler {
@@ -87,9 +102,12 @@ Eigen::MatrixXd fitAndSetFixedPositions(
 }
 
 Molecule narrow(Molecule molecule, Random::Engine& engine) {
-  const auto& stereopermutatorList = molecule.stereopermutators();
-
+  /* The molecule shares its state with the argument until the first
+   * assignment, so the stereopermutator list must be fetched anew after each
+   */
   do {
+    const auto& stereopermutatorList = molecule.stereopermutators();
+
     /* If we change any stereopermutator, we must re-check if there are still
      * unassigned stereopermutators since assigning a stereopermutator can
      * invalidate the entire stereopermutator list (because stereopermutators
@@ -132,11 +150,58 @@ Molecule narrow(Molecule molecule, Random::Engine& engine) {
       );
     }
 
-  } while(stereopermutatorList.hasUnassignedStereopermutators());
+  } while(molecule.stereopermutators().hasUnassignedStereopermutators());
 
   return molecule;
 }
 
+Eigen::VectorXd refinementPreconditioner(const Eigen::MatrixXd& squaredBounds) {
+  constexpr unsigned dimensionality = 4;
+  const unsigned N = squaredBounds.cols();
+  Eigen::VectorXd curvatures = Eigen::VectorXd::Zero(N);
+  for(unsigned i = 0; i < N; ++i) {
+    for(unsigned j = i + 1; j < N; ++j) {
+      const double curvature = 1 / squaredBounds(i, j);
+      curvatures(i) += curvature;
+      curvatures(j) += curvature;
+    }
+  }
+
+  Eigen::VectorXd preconditioner(dimensionality * N);
+  for(unsigned i = 0; i < N; ++i) {
+    const double inverse = (curvatures(i) > 0) ? 1 / curvatures(i) : 1.0;
+    preconditioner.segment<dimensionality>(dimensionality * i).setConstant(inverse);
+  }
+  return preconditioner;
+}
+
+/* Rejects embeddings with too few correct chiral constraints after a number of
+ * chirality inversion iterations
+ */
+struct ChiralityProbe {
+  ChiralityProbe() = default;
+  explicit ChiralityProbe(const Configuration& configuration)
+    : iterations(configuration.chiralityProbeIterations),
+      threshold(configuration.chiralityProbeThreshold)
+  {}
+
+  //! Returns whether refinement may continue
+  bool pass(const unsigned iteration, const double proportionCorrect) {
+    if(iterations == 0 || probed || iteration < iterations) {
+      return true;
+    }
+
+    probed = true;
+    rejected = (proportionCorrect < threshold);
+    return !rejected;
+  }
+
+  unsigned iterations = 0;
+  double threshold = 0.0;
+  bool probed = false;
+  bool rejected = false;
+};
+
 template<typename EigenRefinementType>
 struct InversionOrIterLimitStop {
   using VectorType = typename EigenRefinementType::VectorType;
@@ -155,12 +220,49 @@ struct InversionOrIterLimitStop {
       iteration < iterLimit
       && refinementFunctorReference.proportionChiralConstraintsCorrectSign < 1.0
       && (step.parameters.proposed - step.parameters.current).norm() > minParameterDiffNorm
+      && probe.pass(iteration, refinementFunctorReference.proportionChiralConstraintsCorrectSign)
+      && !(cancellation != nullptr && cancellation->cancelled())
+    );
+  }
+
+  const unsigned iterLimit;
+  const EigenRefinementType& refinementFunctorReference;
+  double minParameterDiffNorm = 1e-3;
+  ChiralityProbe probe;
+  const CancellationToken* cancellation = nullptr;
+};
+
+/* Stops chirality inversion of a conformer in a batched refinement. The
+ * refinement functor's signaling member is shared by all conformers of a
+ * batch, so the proportion of correct chiral constraints is recalculated from
+ * the last evaluated parameters.
+ */
+template<typename EigenRefinementType>
+struct BatchInversionOrIterLimitStop {
+  BatchInversionOrIterLimitStop(
+    const unsigned passIter,
+    const EigenRefinementType& functor
+  ) : iterLimit(passIter),
+      refinementFunctorReference(functor)
+  {}
+
+  template<typename StepValues>
+  bool shouldContinue(unsigned iteration, const StepValues& step) {
+    const double proportionCorrect = refinementFunctorReference.calculateProportionChiralConstraintsCorrectSign(step.parameters.proposed);
+    return (
+      iteration < iterLimit
+      && proportionCorrect < 1.0
+      && (step.parameters.proposed - step.parameters.current).norm() > minParameterDiffNorm
+      && probe.pass(iteration, proportionCorrect)
+      && !(cancellation != nullptr && cancellation->cancelled())
     );
   }
 
   const unsigned iterLimit;
   const EigenRefinementType& refinementFunctorReference;
   double minParameterDiffNorm = 1e-3;
+  ChiralityProbe probe;
+  const CancellationToken* cancellation = nullptr;
 };
 
 template<typename FloatType>
@@ -173,82 +275,169 @@ struct GradientOrIterLimitStop {
       iteration < iterLimit
       && step.gradients.current.template cast<double>().norm() > gradNorm
       && (step.parameters.proposed - step.parameters.current).norm() > minParameterDiffNorm
+      && !(cancellation != nullptr && cancellation->cancelled())
     );
   }
 
   unsigned iterLimit = 10000;
   double gradNorm = 1e-5;
   double minParameterDiffNorm = 1e-3;
+  const CancellationToken* cancellation = nullptr;
 };
 
-template<unsigned dimensionality>
-Eigen::Vector3d averagePosition(
-  const Eigen::VectorXd& linearPositions,
-  const std::vector<AtomIndex>& indices
-) {
-  if(indices.size() == 1) {
-    return linearPositions.template segment<3>(dimensionality * indices.front());
-  }
+/* Records every interval-th step of a refinement stage into a trajectory, if
+ * any, and defers termination to another checker
+ */
+template<typename Checker>
+struct TrajectoryObserver {
+  template<typename StepValues>
+  bool shouldContinue(unsigned iteration, const StepValues& step) {
+    if(trajectory != nullptr && iteration % interval == 0) {
+      RefinementFrame frame;
+      frame.stage = stage;
+      frame.iteration = iteration;
+      frame.value = static_cast<double>(step.values.current);
+      frame.gradientNorm = static_cast<double>(step.gradients.current.norm());
+      if(positions) {
+        frame.positions = step.parameters.current.template cast<float>();
+      }
+      trajectory->record(std::move(frame));
+    }
 
-  Eigen::Vector3d average = Eigen::Vector3d::Zero();
-  for(AtomIndex i : indices) {
-    average += linearPositions.template segment<3>(dimensionality * i);
+    return checker.shouldContinue(iteration, step);
   }
-  average /= indices.size();
-  return average;
-}
 
-template<unsigned dimensionality>
-void twistRotatableDihedrals(
-  Eigen::Ref<Eigen::VectorXd> positions,
-  const std::vector<DihedralConstraint>& constraints,
-  const MoleculeDGInformation::GroupMapType& rotatableGroupMap
-) {
-  for(const DihedralConstraint& constraint : constraints) {
-    const AtomIndex j = constraint.sites.at(1).front();
-    const AtomIndex k = constraint.sites.at(2).front();
-    BondIndex bond {j, k};
+  Checker& checker;
+  RefinementTrajectory* trajectory;
+  RefinementStage stage;
+  unsigned interval;
+  bool positions;
+};
 
-    const auto findIter = rotatableGroupMap.find(bond);
-    if(findIter == std::end(rotatableGroupMap)) {
-      continue;
-    }
+/* Freely rotatable dihedrals packed for twisting to their target values
+ *
+ * Twists are stored in sequence of their dihedral constraints. The atoms of
+ * the first and last sites and the rotated group of each twist are laid out
+ * contiguously, so that twisting gathers a whole group into a matrix and
+ * rotates it at once.
+ */
+class RotatableTwists {
+public:
+  RotatableTwists(
+    const std::vector<DihedralConstraint>& constraints,
+    const MoleculeDGInformation::GroupMapType& rotatableGroupMap
+  ) {
+    offsets_.push_back(0);
+    for(const DihedralConstraint& constraint : constraints) {
+      const AtomIndex j = constraint.sites.at(1).front();
+      const AtomIndex k = constraint.sites.at(2).front();
+
+      const auto findIter = rotatableGroupMap.find(BondIndex {j, k});
+      if(findIter == std::end(rotatableGroupMap)) {
+        continue;
+      }
 
-    const MoleculeDGInformation::RotatableGroup& group = findIter->second;
+      const MoleculeDGInformation::RotatableGroup& group = findIter->second;
+      twists_.push_back(
+        Twist {
+          j,
+          k,
+          group.side,
+          Cartesian::dihedralAverage(constraint.lower, constraint.upper)
+        }
+      );
 
-    const Eigen::Vector3d jVector = positions.template segment<3>(dimensionality * j);
-    const Eigen::Vector3d kVector = positions.template segment<3>(dimensionality * k);
+      pack_(constraint.sites.at(0));
+      pack_(constraint.sites.at(3));
+      pack_(group.vertices);
+      maxGroupSize_ = std::max<unsigned>(maxGroupSize_, group.vertices.size());
+    }
+  }
 
-    const double measuredDihedral = Cartesian::dihedral(
-      averagePosition<dimensionality>(positions, constraint.sites.at(0)),
-      jVector,
-      kVector,
-      averagePosition<dimensionality>(positions, constraint.sites.at(3))
-    );
+  //! Twists all rotatable dihedrals in sequence to their target values
+  template<unsigned dimensionality>
+  void apply(Eigen::Ref<Eigen::VectorXd> positions) const {
+    Eigen::Matrix3Xd groupPositions(3, maxGroupSize_);
+    const unsigned T = twists_.size();
+    for(unsigned t = 0; t < T; ++t) {
+      const Twist& twist = twists_[t];
+
+      const Eigen::Vector3d jVector = positions.template segment<3>(dimensionality * twist.j);
+      const Eigen::Vector3d kVector = positions.template segment<3>(dimensionality * twist.k);
+
+      const double measuredDihedral = Cartesian::dihedral(
+        averagePosition_<dimensionality>(positions, 3 * t),
+        jVector,
+        kVector,
+        averagePosition_<dimensionality>(positions, 3 * t + 1)
+      );
 
-    const double targetDihedral = Cartesian::dihedralAverage(
-      constraint.lower,
-      constraint.upper
-    );
+      Eigen::Vector3d axisVector = (kVector - jVector).normalized();
+      if(twist.side == twist.j) {
+        axisVector *= -1;
+      }
 
-    Eigen::Vector3d axisVector = (kVector - jVector).normalized();
-    if(group.side == j) {
-      axisVector *= -1;
+      const Eigen::Matrix3d rotation = Eigen::AngleAxisd {
+        twist.targetDihedral - measuredDihedral,
+        axisVector
+      }.toRotationMatrix();
+
+      const Eigen::Vector3d sideVector = positions.template segment<3>(dimensionality * twist.side);
+      const unsigned begin = offsets_[3 * t + 2];
+      const unsigned count = offsets_[3 * t + 3] - begin;
+      auto group = groupPositions.leftCols(count);
+      for(unsigned v = 0; v < count; ++v) {
+        group.col(v) = positions.template segment<3>(dimensionality * atoms_[begin + v]);
+      }
+      group = (rotation * (group.colwise() - sideVector)).colwise() + sideVector;
+      for(unsigned v = 0; v < count; ++v) {
+        positions.template segment<3>(dimensionality * atoms_[begin + v]) = group.col(v);
+      }
     }
+  }
 
-    const Eigen::Matrix3d rotation = Eigen::AngleAxisd {
-      targetDihedral - measuredDihedral,
-      axisVector
-    }.toRotationMatrix();
+private:
+  struct Twist {
+    AtomIndex j;
+    AtomIndex k;
+    AtomIndex side;
+    double targetDihedral;
+  };
 
-    const Eigen::Vector3d sideVector = positions.template segment<3>(dimensionality * group.side);
-    for(AtomIndex i : group.vertices) {
-      positions.template segment<3>(dimensionality * i) = sideVector + rotation * (
-        positions.template segment<3>(dimensionality * i) - sideVector
-      );
+  template<typename Sequence>
+  void pack_(const Sequence& sequence) {
+    atoms_.insert(std::end(atoms_), std::begin(sequence), std::end(sequence));
+    offsets_.push_back(atoms_.size());
+  }
+
+  //! Average position of the atoms of a packed sequence
+  template<unsigned dimensionality>
+  Eigen::Vector3d averagePosition_(
+    const Eigen::Ref<Eigen::VectorXd>& positions,
+    const unsigned sequence
+  ) const {
+    const unsigned begin = offsets_[sequence];
+    const unsigned end = offsets_[sequence + 1];
+    if(end - begin == 1) {
+      return positions.template segment<3>(dimensionality * atoms_[begin]);
+    }
+
+    Eigen::Vector3d average = Eigen::Vector3d::Zero();
+    for(unsigned i = begin; i < end; ++i) {
+      average += positions.template segment<3>(dimensionality * atoms_[i]);
     }
+    average /= end - begin;
+    return average;
   }
-}
+
+  std::vector<Twist> twists_;
+  /* Sequences 3t, 3t + 1 and 3t + 2 of twist t are its first and last sites
+   * and its rotated group, spanning atoms_ from offsets_[s] to offsets_[s + 1]
+   */
+  std::vector<AtomIndex> atoms_;
+  std::vector<unsigned> offsets_;
+  unsigned maxGroupSize_ = 0;
+};
 
 } // namespace Detail
 
@@ -292,12 +481,22 @@ MoleculeDGInformation gatherDGInformation(
   const Molecule& molecule,
   const Configuration& configuration
 ) {
+  MOLASSEMBLER_TRACE_SPAN("DG model");
+
   // Generate a spatial model from the molecular graph and stereopermutators
-  SpatialModel spatialModel {molecule, configuration};
+  return gatherDGInformation(
+    SpatialModel {molecule, configuration},
+    molecule
+  );
+}
 
+MoleculeDGInformation gatherDGInformation(
+  const SpatialModel& spatialModel,
+  const Molecule& molecule
+) {
   // Extract gathered data
   MoleculeDGInformation data;
-  data.bounds = spatialModel.makePairwiseBounds();
+  data.bounds = spatialModel.makeSparsePairwiseBounds();
   data.chiralConstraints = spatialModel.getChiralConstraints();
   data.dihedralConstraints = spatialModel.getDihedralConstraints();
   data.rotatableGroups = MoleculeDGInformation::make(data.dihedralConstraints, molecule);
@@ -305,277 +504,2403 @@ MoleculeDGInformation gatherDGInformation(
   return data;
 }
 
-outcome::result<AngstromPositions> refine(
-  Eigen::MatrixXd embeddedPositions,
-  const DistanceBoundsMatrix& distanceBounds,
-  const Configuration& configuration,
-  const std::shared_ptr<MoleculeDGInformation>& DgDataPtr
+namespace Detail {
+
+std::vector<AtomIndex> deferrableHydrogens(
+  const PrivateGraph& inner,
+  const MoleculeDGInformation& data
 ) {
-  /* Refinement problem compile-time settings
-   * - Dimensionality four is needed to ensure chiral constraints invert
-   *   nicely
-   * - FloatType double is helpful for refinement stability, and float
-   *   doesn't affect speed
-   * - Using the alternative SIMD implementations of the refinement problems
-   *   hardly affects speed at all, in fact, it commonly worsens it.
-   */
-  constexpr unsigned dimensionality = 4;
-  using FloatType = double;
-  constexpr bool SIMD = false;
+  const unsigned N = inner.N();
+  std::vector<char> constrained(N, false);
+  const auto markSites = [&](const auto& sites) {
+    for(const auto& site : sites) {
+      for(const AtomIndex i : site) {
+        constrained.at(i) = true;
+      }
+    }
+  };
+  for(const ChiralConstraint& constraint : data.chiralConstraints) {
+    markSites(constraint.sites);
+  }
+  for(const DihedralConstraint& constraint : data.dihedralConstraints) {
+    markSites(constraint.sites);
+  }
 
-  using FullRefinementType = EigenRefinementProblem<dimensionality, FloatType, SIMD>;
-  using VectorType = typename FullRefinementType::VectorType;
+  const auto isHydrogen = [&](const AtomIndex i) {
+    return Utils::ElementInfo::Z(inner.elementType(i)) == 1;
+  };
 
-  // Vectorize positions
-  VectorType transformedPositions = Eigen::Map<Eigen::VectorXd>(
-    embeddedPositions.data(),
-    embeddedPositions.cols() * embeddedPositions.rows()
-  ).template cast<FloatType>().eval();
+  std::vector<AtomIndex> hydrogens;
+  for(AtomIndex i = 0; i < N; ++i) {
+    if(
+      isHydrogen(i)
+      && inner.degree(i) == 1
+      && !constrained.at(i)
+      && !isHydrogen(*inner.adjacents(i).begin())
+    ) {
+      hydrogens.push_back(i);
+    }
+  }
+  return hydrogens;
+}
 
-  const unsigned N = transformedPositions.size() / dimensionality;
+std::vector<std::vector<AtomIndex>> fragment(
+  const PrivateGraph& inner,
+  const std::vector<AtomIndex>& excluded,
+  const unsigned fragmentSize
+) {
+  const unsigned N = inner.N();
+  std::vector<char> isExcluded(N, false);
+  for(const AtomIndex i : excluded) {
+    isExcluded.at(i) = true;
+  }
 
-  const auto squaredBounds = static_cast<Eigen::MatrixXd>(
-    distanceBounds.access().cwiseProduct(distanceBounds.access())
-  );
+  // Bridges between atoms with further bonds separate rigid parts
+  const auto& bridges = inner.removalSafetyData().bridges;
+  const auto separates = [&](const PrivateGraph::Edge& edge) {
+    return (
+      bridges.count(edge) > 0
+      && inner.degree(inner.source(edge)) > 1
+      && inner.degree(inner.target(edge)) > 1
+    );
+  };
 
-  FullRefinementType refinementFunctor {
-    squaredBounds,
-    DgDataPtr->chiralConstraints,
-    DgDataPtr->dihedralConstraints
+  std::vector<AtomIndex> parent(N);
+  std::iota(std::begin(parent), std::end(parent), 0);
+  const auto root = [&](AtomIndex i) {
+    while(parent.at(i) != i) {
+      parent.at(i) = parent.at(parent.at(i));
+      i = parent.at(i);
+    }
+    return i;
   };
 
-  /* If a count of chiral constraints reveals that more than half are
-   * incorrect, we can invert the structure (by multiplying e.g. all y
-   * coordinates with -1) and then have more than half of chirality
-   * constraints correct! In the count, chiral constraints with a target
-   * value of zero are not considered (this would skew the count as those
-   * chiral constraints should not have to pass an energetic maximum to
-   * converge properly as opposed to tetrahedra with volume).
-   */
-  double initiallyCorrectChiralConstraints = refinementFunctor.calculateProportionChiralConstraintsCorrectSign(transformedPositions);
-  if(initiallyCorrectChiralConstraints < 0.5) {
-    // Invert y coordinates
-    for(unsigned i = 0; i < N; ++i) {
-      transformedPositions(dimensionality * i + 1) *= -1;
+  std::vector<std::pair<AtomIndex, AtomIndex>> separatingBonds;
+  for(const PrivateGraph::Edge& edge : inner.edges()) {
+    const AtomIndex a = inner.source(edge);
+    const AtomIndex b = inner.target(edge);
+    if(isExcluded.at(a) || isExcluded.at(b)) {
+      continue;
     }
 
-    initiallyCorrectChiralConstraints = 1 - initiallyCorrectChiralConstraints;
+    if(separates(edge)) {
+      separatingBonds.emplace_back(a, b);
+    } else {
+      parent.at(root(a)) = root(b);
+    }
   }
 
-  /* Refinement without penalty on fourth dimension only necessary if not all
-   * chiral centers are correct. Of course, for molecules without chiral
-   * centers at all, this stage is unnecessary
-   */
-  unsigned firstStageIterations = 0;
-  if(initiallyCorrectChiralConstraints < 1) {
-    Detail::InversionOrIterLimitStop<FullRefinementType> inversionChecker {
-      configuration.refinementStepLimit,
-      refinementFunctor
-    };
-
-    Temple::Lbfgs<FloatType, 32> optimizer;
-
-    try {
-      auto result = optimizer.minimize(
-        transformedPositions,
-        refinementFunctor,
-        inversionChecker
-      );
-      firstStageIterations = result.iterations;
-    } catch(std::runtime_error& e) {
-      return DgError::RefinementException;
+  // Number the rigid parts and collect their atoms and separating bonds
+  std::vector<unsigned> partOf(N, N);
+  std::vector<std::vector<AtomIndex>> partAtoms;
+  for(AtomIndex i = 0; i < N; ++i) {
+    if(isExcluded.at(i)) {
+      continue;
     }
 
-    if(firstStageIterations >= configuration.refinementStepLimit) {
-      return DgError::RefinementMaxIterationsReached;
+    const AtomIndex r = root(i);
+    if(partOf.at(r) == N) {
+      partOf.at(r) = partAtoms.size();
+      partAtoms.emplace_back();
     }
+    partOf.at(i) = partOf.at(r);
+    partAtoms.at(partOf.at(i)).push_back(i);
+  }
 
-    if(refinementFunctor.proportionChiralConstraintsCorrectSign < 1.0) {
-      return DgError::RefinedChiralsWrong;
-    }
+  const unsigned P = partAtoms.size();
+  std::vector<std::vector<std::pair<AtomIndex, AtomIndex>>> partBonds(P);
+  for(const auto& bond : separatingBonds) {
+    partBonds.at(partOf.at(bond.first)).emplace_back(bond.first, bond.second);
+    partBonds.at(partOf.at(bond.second)).emplace_back(bond.second, bond.first);
   }
 
-  /* Set up the second stage of refinement where we compress out the fourth
-   * dimension that we allowed expansion into to invert the chiralities.
+  /* Parts and separating bonds form a tree. Starting from the largest part,
+   * parts join the fragment of the part they are bonded to while it is small
+   * enough, and start new fragments otherwise.
    */
-  refinementFunctor.compressFourthDimension = true;
+  std::vector<unsigned> fragmentOf(P, P);
+  std::vector<std::vector<AtomIndex>> fragments;
+  // Atom of an earlier fragment each fragment is bonded to
+  std::vector<AtomIndex> anchors;
+
+  std::vector<unsigned> queue {
+    static_cast<unsigned>(
+      std::max_element(
+        std::begin(partAtoms),
+        std::end(partAtoms),
+        [](const auto& a, const auto& b) { return a.size() < b.size(); }
+      ) - std::begin(partAtoms)
+    )
+  };
+  fragmentOf.at(queue.front()) = 0;
+  fragments.push_back(partAtoms.at(queue.front()));
+  anchors.push_back(N);
+
+  for(unsigned q = 0; q < queue.size(); ++q) {
+    const unsigned part = queue.at(q);
+    const unsigned partFragment = fragmentOf.at(part);
+    for(const auto& bond : partBonds.at(part)) {
+      const unsigned bondedPart = partOf.at(bond.second);
+      if(fragmentOf.at(bondedPart) != P) {
+        continue;
+      }
 
-  unsigned secondStageIterations = 0;
-  Detail::GradientOrIterLimitStop<FloatType> gradientChecker;
-  gradientChecker.gradNorm = 1e-3;
-  gradientChecker.iterLimit = configuration.refinementStepLimit - firstStageIterations;
+      const auto& bondedAtoms = partAtoms.at(bondedPart);
+      if(fragments.at(partFragment).size() + bondedAtoms.size() <= fragmentSize) {
+        fragmentOf.at(bondedPart) = partFragment;
+        fragments.at(partFragment).insert(
+          std::end(fragments.at(partFragment)),
+          std::begin(bondedAtoms),
+          std::end(bondedAtoms)
+        );
+      } else {
+        fragmentOf.at(bondedPart) = fragments.size();
+        fragments.push_back(bondedAtoms);
+        anchors.push_back(bond.first);
+      }
+      queue.push_back(bondedPart);
+    }
+  }
 
-  try {
-    Temple::Lbfgs<FloatType, 32> optimizer;
+  /* Fragments overlap with the earlier fragment they are bonded to in its
+   * atom bonded to them and that atom's neighbors in it
+   */
+  for(unsigned f = 1; f < fragments.size(); ++f) {
+    const AtomIndex anchor = anchors.at(f);
+    const unsigned anchorFragment = fragmentOf.at(partOf.at(anchor));
+    fragments.at(f).push_back(anchor);
+    for(const AtomIndex neighbor : inner.adjacents(anchor)) {
+      if(!isExcluded.at(neighbor) && fragmentOf.at(partOf.at(neighbor)) == anchorFragment) {
+        fragments.at(f).push_back(neighbor);
+      }
+    }
+  }
 
-    auto result = optimizer.minimize(
-      transformedPositions,
-      refinementFunctor,
-      gradientChecker
+  for(auto& fragmentAtoms : fragments) {
+    std::sort(std::begin(fragmentAtoms), std::end(fragmentAtoms));
+    fragmentAtoms.erase(
+      std::unique(std::begin(fragmentAtoms), std::end(fragmentAtoms)),
+      std::end(fragmentAtoms)
     );
-    secondStageIterations = result.iterations;
-  } catch(std::out_of_range& e) {
-    return DgError::RefinementException;
   }
 
-  // Max iterations reached
-  if(secondStageIterations >= gradientChecker.iterLimit) {
-    return DgError::RefinementMaxIterationsReached;
-  }
+  return fragments;
+}
 
-  // Not all chiral constraints have the right sign
-  if(refinementFunctor.proportionChiralConstraintsCorrectSign < 1) {
-    return DgError::RefinedChiralsWrong;
+void placeHydrogens(
+  Eigen::Ref<Eigen::MatrixXd> positions,
+  const PrivateGraph& inner,
+  const std::vector<AtomIndex>& hydrogens,
+  const DistanceBoundsMatrix& bounds
+) {
+  assert(positions.rows() == 4);
+  std::vector<char> placed(inner.N(), true);
+  std::map<AtomIndex, std::vector<AtomIndex>> anchoredHydrogens;
+  for(const AtomIndex h : hydrogens) {
+    placed.at(h) = false;
+    anchoredHydrogens[*inner.adjacents(h).begin()].push_back(h);
   }
 
-  /* Twist all freely rotatable dihedrals to their target values to avoid
-   * conflicts between distance and dihedral errors to prevent rotations to
-   * target values.
-   */
-  Detail::twistRotatableDihedrals<dimensionality>(
-    transformedPositions,
-    DgDataPtr->dihedralConstraints,
-    DgDataPtr->rotatableGroups
-  );
+  const auto position = [&](const AtomIndex i) -> Eigen::Vector3d {
+    return positions.col(i).head<3>();
+  };
+  const auto modelDistance = [&](const AtomIndex i, const AtomIndex j) {
+    return (bounds.lowerBound(i, j) + bounds.upperBound(i, j)) / 2;
+  };
+  // Angle at b from the law of cosines on the middle of the distance bounds
+  const auto modelAngle = [&](const AtomIndex a, const AtomIndex b, const AtomIndex c) {
+    const double ab = modelDistance(a, b);
+    const double bc = modelDistance(b, c);
+    const double ac = modelDistance(a, c);
+    return std::acos(
+      Temple::Stl17::clamp((ab * ab + bc * bc - ac * ac) / (2 * ab * bc), -1.0, 1.0)
+    );
+  };
 
-  /* Add dihedral terms and refine again */
-  unsigned thirdStageIterations = 0;
-  gradientChecker = Detail::GradientOrIterLimitStop<FloatType> {};
-  gradientChecker.gradNorm = 1e-3;
-  gradientChecker.iterLimit = (
-    configuration.refinementStepLimit
-    - firstStageIterations
-    - secondStageIterations
-  );
+  for(const auto& anchorHydrogensPair : anchoredHydrogens) {
+    const AtomIndex anchor = anchorHydrogensPair.first;
+    const std::vector<AtomIndex>& anchorHydrogens = anchorHydrogensPair.second;
+    const unsigned K = anchorHydrogens.size();
+    const Eigen::Vector3d center = position(anchor);
+
+    std::vector<AtomIndex> neighbors;
+    Eigen::Vector3d bondSum = Eigen::Vector3d::Zero();
+    for(const AtomIndex neighbor : inner.adjacents(anchor)) {
+      if(placed.at(neighbor)) {
+        neighbors.push_back(neighbor);
+        bondSum += (position(neighbor) - center).normalized();
+      }
+    }
 
-  refinementFunctor.dihedralTerms = true;
+    // Hydrogens point away from the anchor's other bonds
+    Eigen::Vector3d axis = -bondSum;
+    if(axis.norm() < 1e-4 && neighbors.size() >= 2) {
+      axis = (position(neighbors.at(0)) - center).cross(position(neighbors.at(1)) - center);
+    }
+    if(axis.norm() < 1e-4) {
+      axis = neighbors.empty()
+        ? Eigen::Vector3d::UnitZ()
+        : (position(neighbors.front()) - center).unitOrthogonal();
+    }
+    axis.normalize();
 
-  try {
-    Temple::Lbfgs<FloatType, 32> optimizer;
+    /* Hydrogens are spaced evenly around the axis. Opposite a single bond, a
+     * single hydrogen is staggered against the far side of that bond.
+     */
+    Eigen::Vector3d reference = Eigen::Vector3d::Zero();
+    if(neighbors.size() >= 2) {
+      reference = (position(neighbors.at(0)) - center).cross(position(neighbors.at(1)) - center);
+    } else if(neighbors.size() == 1) {
+      const AtomIndex neighbor = neighbors.front();
+      for(const AtomIndex farSide : inner.adjacents(neighbor)) {
+        if(farSide != anchor && placed.at(farSide)) {
+          reference = position(neighbor) - position(farSide);
+          break;
+        }
+      }
+    }
+    reference -= reference.dot(axis) * axis;
+    reference = (reference.norm() < 1e-4) ? axis.unitOrthogonal() : reference.normalized();
+    const Eigen::Vector3d binormal = axis.cross(reference);
 
-    auto result = optimizer.minimize(
-      transformedPositions,
-      refinementFunctor,
-      gradientChecker
-    );
-    thirdStageIterations = result.iterations;
-  } catch(std::out_of_range& e) {
-    return DgError::RefinementException;
-  }
+    /* Angle between the axis and each hydrogen. Several hydrogens are opened
+     * up to their modeled mutual angle. A single hydrogen opposite a single
+     * bond is tilted to its modeled angle with that bond.
+     */
+    double coneAngle = 0;
+    if(K >= 2) {
+      const double spacingCosine = std::cos(2 * M_PI / K);
+      const double mutualCosine = std::cos(
+        modelAngle(anchorHydrogens.at(0), anchor, anchorHydrogens.at(1))
+      );
+      coneAngle = std::acos(std::sqrt(Temple::Stl17::clamp(
+        (mutualCosine - spacingCosine) / (1 - spacingCosine),
+        0.0,
+        1.0
+      )));
+    } else if(neighbors.size() == 1) {
+      coneAngle = M_PI - modelAngle(anchorHydrogens.front(), anchor, neighbors.front());
+    }
 
-  if(thirdStageIterations >= gradientChecker.iterLimit) {
-    return DgError::RefinementMaxIterationsReached;
+    for(unsigned k = 0; k < K; ++k) {
+      const AtomIndex h = anchorHydrogens.at(k);
+      const double azimuth = 2 * M_PI * k / K;
+      const Eigen::Vector3d direction = (
+        std::cos(coneAngle) * axis
+        + std::sin(coneAngle) * (
+          std::cos(azimuth) * reference
+          + std::sin(azimuth) * binormal
+        )
+      );
+      positions.col(h).head<3>() = center + modelDistance(anchor, h) * direction;
+      positions(3, h) = 0;
+    }
   }
+}
 
-  // Structure inacceptable
-  if(
-    !finalStructureAcceptable(
-      refinementFunctor,
-      distanceBounds,
-      transformedPositions
-    )
-  ) {
-    return DgError::RefinedStructureInacceptable;
+constexpr double AdaptivePartiality::priorWeight;
+constexpr double AdaptivePartiality::maximumPriorFailureRate;
+
+AdaptivePartiality::AdaptivePartiality(const DistanceBoundsMatrix& bounds)
+  : N_(bounds.N())
+{
+  atoms_ = {
+    smoothedAtomCount(Partiality::FourAtom, N_),
+    smoothedAtomCount(Partiality::TenPercent, N_),
+    std::min(N_, std::max(4U, N_ / 4)),
+    N_
+  };
+  std::sort(std::begin(atoms_), std::end(atoms_));
+  atoms_.erase(std::unique(std::begin(atoms_), std::end(atoms_)), std::end(atoms_));
+
+  // Mean relative gap between lower and upper bounds
+  double gapSum = 0;
+  unsigned pairs = 0;
+  for(AtomIndex i = 0; i < N_; ++i) {
+    for(AtomIndex j = i + 1; j < N_; ++j) {
+      const double upper = bounds.upperBound(i, j);
+      if(upper > 0) {
+        gapSum += (upper - bounds.lowerBound(i, j)) / upper;
+        ++pairs;
+      }
+    }
   }
+  const double looseness = pairs > 0 ? Temple::Stl17::clamp(gapSum / pairs, 0.0, 1.0) : 1.0;
 
-  auto gatheredPositions = Detail::gather(transformedPositions);
-
-  if(!configuration.fixedPositions.empty()) {
-    return Detail::convertToAngstromPositions(
-      Detail::fitAndSetFixedPositions(gatheredPositions, configuration)
-    );
+  for(const unsigned smoothed : atoms_) {
+    const double unsmoothedFraction = N_ > 0 ? 1.0 - static_cast<double>(smoothed) / N_ : 0.0;
+    priorFailureRates_.push_back(maximumPriorFailureRate * (1 - looseness) * unsmoothedFraction);
   }
 
-  return Detail::convertToAngstromPositions(gatheredPositions);
+  attempts_.assign(atoms_.size(), 0);
+  successes_.assign(atoms_.size(), 0);
+  totalSeconds_.assign(atoms_.size(), 0.0);
 }
 
-outcome::result<AngstromPositions> generateConformer(
-  const Molecule& molecule,
-  const Configuration& configuration,
-  std::shared_ptr<MoleculeDGInformation>& DgDataPtr,
-  bool regenerateDGDataEachStep,
-  Random::Engine& engine
-) {
-  if(regenerateDGDataEachStep) {
-    auto moleculeCopy = Detail::narrow(molecule, engine);
-
-    if(moleculeCopy.stereopermutators().hasZeroAssignmentStereopermutators()) {
-      return DgError::ZeroAssignmentStereopermutators;
+unsigned AdaptivePartiality::choose() const {
+  unsigned best = 0;
+  double bestRate = 0;
+  for(unsigned c = 0; c < atoms_.size(); ++c) {
+    const double rate = successRate(c) / seconds(c);
+    if(rate > bestRate) {
+      best = c;
+      bestRate = rate;
     }
-
-    DgDataPtr = std::make_shared<MoleculeDGInformation>(
-      gatherDGInformation(moleculeCopy, configuration)
-    );
   }
+  return atoms_.at(best);
+}
 
-  ExplicitBoundsGraph explicitGraph {
-    molecule.graph().inner(),
-    DgDataPtr->bounds
-  };
-
-  // Get distance bounds matrix from the graph
-  auto distanceBoundsResult = explicitGraph.makeDistanceBounds();
-  if(!distanceBoundsResult) {
-    return distanceBoundsResult.as_failure();
+void AdaptivePartiality::record(
+  const unsigned smoothedAtoms,
+  const double seconds,
+  const bool success
+) {
+  const auto findIter = std::lower_bound(std::begin(atoms_), std::end(atoms_), smoothedAtoms);
+  if(findIter == std::end(atoms_) || *findIter != smoothedAtoms) {
+    return;
   }
 
-  DistanceBoundsMatrix distanceBounds {std::move(distanceBoundsResult.value())};
+  const unsigned c = findIter - std::begin(atoms_);
+  ++attempts_.at(c);
+  successes_.at(c) += success ? 1 : 0;
+  totalSeconds_.at(c) += seconds;
+}
 
-  /* There should be no need to smooth the distance bounds, because the graph
-   * type ought to create them within the triangle inequality bounds:
-   */
-  assert(distanceBounds.boundInconsistencies() == 0);
+double AdaptivePartiality::successRate(const unsigned candidate) const {
+  return (
+    successes_.at(candidate) + priorWeight * (1 - priorFailureRates_.at(candidate))
+  ) / (attempts_.at(candidate) + priorWeight);
+}
 
-  // Generate a distances matrix from the graph
-  auto distanceMatrixResult = explicitGraph.makeDistanceMatrix(
-    engine,
-    configuration.partiality
-  );
-  if(!distanceMatrixResult) {
-    return distanceMatrixResult.as_failure();
+double AdaptivePartiality::seconds(const unsigned candidate) const {
+  if(attempts_.at(candidate) > 0) {
+    return totalSeconds_.at(candidate) / attempts_.at(candidate);
   }
 
-  // Make a metric matrix from the distances matrix
-  MetricMatrix metric(
-    std::move(distanceMatrixResult.value())
-  );
+  // Scale prior times to those measured for any candidate
+  double measuredSeconds = 0;
+  double measuredUnits = 0;
+  for(unsigned c = 0; c < atoms_.size(); ++c) {
+    measuredSeconds += totalSeconds_.at(c);
+    measuredUnits += attempts_.at(c) * static_cast<double>(atoms_.at(c) + N_);
+  }
+  const double scale = (measuredSeconds > 0 && measuredUnits > 0) ? measuredSeconds / measuredUnits : 1.0;
+  return scale * (atoms_.at(candidate) + N_);
+}
 
-  // Get a position matrix by embedding the metric matrix
-  auto embeddedPositions = metric.embed();
+} // namespace Detail
 
-  /* Refinement */
-  return refine(
-    std::move(embeddedPositions),
-    distanceBounds,
-    configuration,
-    DgDataPtr
+bool SharedModel::applicable(const Molecule& molecule) {
+  const auto& permutators = molecule.stereopermutators();
+  return (
+    Temple::all_of(
+      permutators.atomStereopermutators(),
+      [](const AtomStereopermutator& permutator) { return permutator.assigned(); }
+    ) && Temple::any_of(
+      permutators.bondStereopermutators(),
+      [](const BondStereopermutator& permutator) { return !permutator.assigned(); }
+    )
   );
 }
 
-std::vector<
-  outcome::result<AngstromPositions>
-> run(
+SharedModel::SharedModel(
+  const Molecule& molecule,
+  const Configuration& configuration
+) : stereopermutators(molecule.stereopermutators()) {
+  assert(applicable(molecule));
+
+  for(const auto& permutator : stereopermutators.bondStereopermutators()) {
+    if(!permutator.assigned()) {
+      deferredBonds.push_back(permutator.placement());
+    }
+  }
+  std::sort(std::begin(deferredBonds), std::end(deferredBonds));
+
+  const SpatialModel model {molecule, configuration, deferredBonds};
+  bounds = model.makeSparsePairwiseBounds();
+  chiralConstraints = model.getChiralConstraints();
+  dihedralConstraints = model.getDihedralConstraints();
+
+  overlays = Temple::map(
+    deferredBonds,
+    [&](const BondIndex& bond) {
+      const BondStereopermutator& permutator = stereopermutators.option(bond).value();
+      std::vector<SpatialModel::DihedralOverlay> bondOverlays;
+      bondOverlays.reserve(permutator.numAssignments());
+      for(unsigned i = 0; i < permutator.numAssignments(); ++i) {
+        BondStereopermutator assigned = permutator;
+        assigned.assign(i);
+        bondOverlays.push_back(
+          model.makeDihedralOverlay(
+            assigned,
+            configuration.spatialModelLoosening
+          )
+        );
+      }
+      return bondOverlays;
+    }
+  );
+}
+
+boost::optional<MoleculeDGInformation> SharedModel::overlay(const Molecule& narrowed) const {
+  MOLASSEMBLER_TRACE_SPAN("DG model overlay");
+
+  const auto& narrowedPermutators = narrowed.stereopermutators();
+  if(
+    narrowedPermutators.A() != stereopermutators.A()
+    || narrowedPermutators.B() != stereopermutators.B()
+  ) {
+    return boost::none;
+  }
+
+  // Atom stereopermutators have to be unaffected by narrowing
+  for(const auto& permutator : stereopermutators.atomStereopermutators()) {
+    auto narrowedOption = narrowedPermutators.option(permutator.placement());
+    if(!narrowedOption || narrowedOption.value() != permutator) {
+      return boost::none;
+    }
+  }
+
+  MoleculeDGInformation data;
+  data.chiralConstraints = chiralConstraints;
+  data.dihedralConstraints = dihedralConstraints;
+
+  SpatialModel::SparseBoundsMatrixHelper overlaid {bounds};
+  for(const auto& permutator : stereopermutators.bondStereopermutators()) {
+    auto narrowedOption = narrowedPermutators.option(permutator.placement());
+    if(!narrowedOption) {
+      return boost::none;
+    }
+
+    const auto findIter = std::lower_bound(
+      std::begin(deferredBonds),
+      std::end(deferredBonds),
+      permutator.placement()
+    );
+    if(findIter == std::end(deferredBonds) || !(*findIter == permutator.placement())) {
+      if(narrowedOption.value() != permutator) {
+        return boost::none;
+      }
+      continue;
+    }
+
+    // The overlay was modeled from exactly this assignment of the composite
+    const auto assignmentOption = narrowedOption->assigned();
+    if(!assignmentOption) {
+      return boost::none;
+    }
+    BondStereopermutator assigned = permutator;
+    assigned.assign(assignmentOption.value());
+    if(assigned != narrowedOption.value()) {
+      return boost::none;
+    }
+
+    const unsigned deferredIndex = findIter - std::begin(deferredBonds);
+    const auto& dihedralOverlay = overlays.at(deferredIndex).at(assignmentOption.value());
+    for(const auto& pairBoundsPair : dihedralOverlay.distanceBounds) {
+      overlaid.add(
+        pairBoundsPair.first.front(),
+        pairBoundsPair.first.back(),
+        pairBoundsPair.second
+      );
+    }
+    std::copy(
+      std::begin(dihedralOverlay.dihedralConstraints),
+      std::end(dihedralOverlay.dihedralConstraints),
+      std::back_inserter(data.dihedralConstraints)
+    );
+  }
+
+  data.bounds = overlaid.matrix();
+  data.rotatableGroups = MoleculeDGInformation::make(data.dihedralConstraints, narrowed);
+  return data;
+}
+
+namespace {
+
+/* The distance between the average positions of two sites is at most the
+ * largest distance between any of their constituting atoms
+ */
+double siteDistanceUpperBound(
+  const DistanceBoundsMatrix& distanceBounds,
+  const ChiralConstraint::AtomListType& a,
+  const ChiralConstraint::AtomListType& b
+) {
+  double bound = 0;
+  for(const AtomIndex i : a) {
+    for(const AtomIndex j : b) {
+      if(i != j) {
+        bound = std::max(bound, distanceBounds.upperBound(i, j));
+      }
+    }
+  }
+  return bound;
+}
+
+/* The signed volume of a chiral constraint is the triple product of the
+ * vectors from any one site to the other three, up to sign. Its magnitude is
+ * at most the product of their lengths for each choice of that site.
+ */
+double chiralVolumeUpperBound(
+  const DistanceBoundsMatrix& distanceBounds,
+  const ChiralConstraint& constraint
+) {
+  double bound = std::numeric_limits<double>::max();
+  for(unsigned apex = 0; apex < 4; ++apex) {
+    double product = 1;
+    for(unsigned other = 0; other < 4; ++other) {
+      if(other != apex) {
+        product *= siteDistanceUpperBound(
+          distanceBounds,
+          constraint.sites.at(apex),
+          constraint.sites.at(other)
+        );
+      }
+    }
+    bound = std::min(bound, product);
+  }
+  return bound;
+}
+
+void logInfeasibleChiralConstraint(const ChiralConstraint& constraint, const double bound) {
+  using LevelBaseType = std::underlying_type<Log::Level>::type;
+  if(
+    static_cast<LevelBaseType>(Log::level)
+    <= static_cast<LevelBaseType>(Log::Level::Warning)
+  ) {
+    auto& logRef = Log::log(Log::Level::Warning);
+    logRef << "Chiral constraint on sites";
+    for(const auto& site : constraint.sites) {
+      logRef << " {" << Temple::condense(site) << "}";
+    }
+    logRef << " requires volumes in [" << constraint.lower << ", "
+      << constraint.upper << "], but distance bounds limit volumes to "
+      << bound << " in magnitude.\n";
+  }
+}
+
+} // namespace
+
+outcome::result<DistanceBoundsMatrix> checkFeasibility(
+  const Molecule& molecule,
+  const SpatialModel::SparseBoundsMatrix& bounds,
+  const std::vector<ChiralConstraint>& chiralConstraints
+) {
+  MOLASSEMBLER_TRACE_SPAN("DG feasibility");
+
+  auto distanceBoundsResult = ExplicitBoundsGraph {
+    molecule.graph().inner(),
+    bounds
+  }.makeDistanceBounds();
+
+  if(!distanceBoundsResult) {
+    Molassembler::Detail::Metrics::recordInfeasibleModel();
+    return distanceBoundsResult.as_failure();
+  }
+
+  DistanceBoundsMatrix distanceBounds {std::move(distanceBoundsResult.value())};
+  if(distanceBounds.boundInconsistencies() > 0) {
+    Molassembler::Detail::Metrics::recordInfeasibleModel();
+    return DgError::GraphImpossible;
+  }
+
+  for(const ChiralConstraint& constraint : chiralConstraints) {
+    // Nonzero target volumes have a minimal magnitude
+    double minimalMagnitude = 0;
+    if(constraint.lower > 0) {
+      minimalMagnitude = constraint.lower;
+    } else if(constraint.upper < 0) {
+      minimalMagnitude = -constraint.upper;
+    }
+
+    if(minimalMagnitude == 0) {
+      continue;
+    }
+
+    const double bound = chiralVolumeUpperBound(distanceBounds, constraint);
+    if(minimalMagnitude > bound) {
+      logInfeasibleChiralConstraint(constraint, bound);
+      Molassembler::Detail::Metrics::recordInfeasibleModel();
+      return DgError::GraphImpossible;
+    }
+  }
+
+  return distanceBounds;
+}
+
+namespace Detail {
+
+/* Refinement problem compile-time settings
+ * - Dimensionality four is needed to ensure chiral constraints invert
+ *   nicely
+ * - Using the alternative SIMD implementations of the refinement problems
+ *   hardly affects speed at all, in fact, it commonly worsens it.
+ */
+constexpr unsigned refinementDimensionality = 4;
+constexpr bool refinementSIMD = false;
+
+/* Refinement stages in a particular floating point precision. Yields the
+ * refined positions and the number of iterations used. If polishOnly is set,
+ * only the final stage with compressed fourth dimension and dihedral terms
+ * is carried out. The configuration sets the optimizer, its curvature history
+ * and sparse distance term evaluation. Stage convergence data is recorded into
+ * statistics unless it is nullptr, polishing into its polish stage. The
+ * refinement problem holds its distance data inline if maxAtoms is bounded.
+ */
+template<typename FloatType, int maxAtoms>
+outcome::result<std::pair<Eigen::VectorXd, unsigned>> refineInBucket(
+  const Eigen::VectorXd& positions,
+  const Eigen::MatrixXd& squaredBounds,
+  const DistanceBoundsMatrix& distanceBounds,
+  const unsigned iterationLimit,
+  const MoleculeDGInformation& data,
+  const Configuration& configuration,
+  const bool polishOnly,
+  const bool checkFinalStructure,
+  RefinementStatistics* const statistics
+) {
+  constexpr unsigned dimensionality = refinementDimensionality;
+  using FullRefinementType = EigenRefinementProblem<dimensionality, FloatType, refinementSIMD, maxAtoms>;
+  using VectorType = typename FullRefinementType::VectorType;
+
+  VectorType transformedPositions = positions.template cast<FloatType>();
+  const unsigned N = transformedPositions.size() / dimensionality;
+
+  FullRefinementType refinementFunctor {
+    squaredBounds,
+    data.chiralConstraints,
+    data.dihedralConstraints
+  };
+  refinementFunctor.distanceTermSkin = configuration.distanceTermSkin;
+
+  /* A single optimizer is shared by all stages so that its curvature history
+   * allocation is reused. Each stage adds a term to the objective function of
+   * the preceding stage, so the history can optionally be carried over.
+   */
+  Temple::Lbfgs<FloatType, 32> optimizer;
+  optimizer.historyLength = std::max(configuration.refinementHistoryLength, 1U);
+  if(configuration.preconditionRefinement) {
+    optimizer.preconditioner = refinementPreconditioner(squaredBounds).template cast<FloatType>();
+  }
+  bool firstStage = true;
+  unsigned evaluations = 0;
+  auto stageStart = std::chrono::steady_clock::now();
+  const auto beginStage = [&]() {
+    optimizer.retainHistory = configuration.retainRefinementHistory && !firstStage;
+    if(!optimizer.retainHistory) {
+      optimizer.stepLength = 1.0;
+    }
+    firstStage = false;
+    evaluations = 0;
+    stageStart = std::chrono::steady_clock::now();
+  };
+
+  const auto countingFunctor = [&](
+    const VectorType& parameters,
+    FloatType& value,
+    Eigen::Ref<VectorType> gradient
+  ) {
+    ++evaluations;
+    refinementFunctor(parameters, value, gradient);
+  };
+
+  const auto hessianCountingFunctor = [&](
+    const VectorType& parameters,
+    FloatType& value,
+    Eigen::Ref<VectorType> gradient,
+    Eigen::Ref<typename FullRefinementType::HessianType> hessian
+  ) {
+    ++evaluations;
+    refinementFunctor(parameters, value, gradient, hessian);
+  };
+
+  RefinementTrajectory* const trajectory = (
+    statistics != nullptr && configuration.trajectoryInterval > 0
+    ? &statistics->trajectory
+    : nullptr
+  );
+
+  /* Minimizes the current stage's objective with the configured optimizer,
+   * recording sampled steps of the stage
+   */
+  using OptimizationResult = typename Temple::Lbfgs<FloatType, 32>::OptimizationReturnType;
+  const auto minimize = [&](auto& checker, const RefinementStage stage) -> OptimizationResult {
+    TrajectoryObserver<std::decay_t<decltype(checker)>> observer {
+      checker,
+      trajectory,
+      stage,
+      configuration.trajectoryInterval,
+      configuration.trajectoryPositions
+    };
+
+    if(configuration.refinementOptimizer == RefinementOptimizer::TrustRegion) {
+      auto result = Temple::TrustRegionOptimizer<FloatType>::minimize(
+        transformedPositions,
+        hessianCountingFunctor,
+        observer
+      );
+      return {result.iterations, result.value, std::move(result.gradient)};
+    }
+
+    return optimizer.minimize(transformedPositions, countingFunctor, observer);
+  };
+
+  const auto recordStage = [&](
+    RefinementStageStatistics RefinementStatistics::* stage,
+    const auto& result
+  ) {
+    if(statistics == nullptr) {
+      return;
+    }
+
+    RefinementStageStatistics& stageStatistics = statistics->*stage;
+    stageStatistics.iterations = result.iterations;
+    stageStatistics.evaluations = evaluations;
+    stageStatistics.gradientNorm = static_cast<double>(result.gradient.norm());
+    stageStatistics.seconds = std::chrono::duration<double>(
+      std::chrono::steady_clock::now() - stageStart
+    ).count();
+  };
+
+  unsigned firstStageIterations = 0;
+  unsigned secondStageIterations = 0;
+  if(!polishOnly) {
+    /* If a count of chiral constraints reveals that more than half are
+     * incorrect, we can invert the structure (by multiplying e.g. all y
+     * coordinates with -1) and then have more than half of chirality
+     * constraints correct! In the count, chiral constraints with a target
+     * value of zero are not considered (this would skew the count as those
+     * chiral constraints should not have to pass an energetic maximum to
+     * converge properly as opposed to tetrahedra with volume).
+     */
+    double initiallyCorrectChiralConstraints = refinementFunctor.calculateProportionChiralConstraintsCorrectSign(transformedPositions);
+    if(initiallyCorrectChiralConstraints < 0.5) {
+      // Invert y coordinates
+      for(unsigned i = 0; i < N; ++i) {
+        transformedPositions(dimensionality * i + 1) *= -1;
+      }
+
+      initiallyCorrectChiralConstraints = 1 - initiallyCorrectChiralConstraints;
+      if(statistics != nullptr) {
+        statistics->inverted = true;
+      }
+    }
+
+    if(statistics != nullptr) {
+      const auto nonZeroChiralConstraints = std::count_if(
+        std::begin(data.chiralConstraints),
+        std::end(data.chiralConstraints),
+        [](const ChiralConstraint& constraint) { return !constraint.targetVolumeIsZero(); }
+      );
+      statistics->chiralFlips = std::lround(
+        (1 - initiallyCorrectChiralConstraints) * nonZeroChiralConstraints
+      );
+    }
+
+    // Discard embeddings unlikely to reach correct chirality
+    if(initiallyCorrectChiralConstraints < configuration.chiralityScreeningThreshold) {
+      return DgError::EmbeddingRejected;
+    }
+
+    /* Refinement without penalty on fourth dimension only necessary if not all
+     * chiral centers are correct. Of course, for molecules without chiral
+     * centers at all, this stage is unnecessary
+     */
+    if(initiallyCorrectChiralConstraints < 1) {
+      InversionOrIterLimitStop<FullRefinementType> inversionChecker {
+        iterationLimit,
+        refinementFunctor
+      };
+      inversionChecker.probe = ChiralityProbe {configuration};
+      inversionChecker.cancellation = &configuration.cancellation;
+
+      beginStage();
+
+      try {
+        MOLASSEMBLER_TRACE_SPAN("DG refinement chirality inversion");
+        auto result = minimize(inversionChecker, RefinementStage::ChiralityInversion);
+        firstStageIterations = result.iterations;
+        recordStage(&RefinementStatistics::chiralityInversion, result);
+      } catch(std::runtime_error& e) {
+        return DgError::RefinementException;
+      }
+
+      if(configuration.cancellation.cancelled()) {
+        return DgError::Cancelled;
+      }
+
+      if(inversionChecker.probe.rejected) {
+        return DgError::EmbeddingRejected;
+      }
+
+      if(firstStageIterations >= iterationLimit) {
+        return DgError::RefinementMaxIterationsReached;
+      }
+
+      if(refinementFunctor.proportionChiralConstraintsCorrectSign < 1.0) {
+        return DgError::RefinedChiralsWrong;
+      }
+    }
+
+    /* Set up the second stage of refinement where we compress out the fourth
+     * dimension that we allowed expansion into to invert the chiralities.
+     */
+    refinementFunctor.compressFourthDimension = true;
+
+    GradientOrIterLimitStop<FloatType> gradientChecker;
+    gradientChecker.gradNorm = 1e-3;
+    gradientChecker.iterLimit = iterationLimit - firstStageIterations;
+    gradientChecker.cancellation = &configuration.cancellation;
+
+    beginStage();
+
+    try {
+      MOLASSEMBLER_TRACE_SPAN("DG refinement compression");
+      auto result = minimize(gradientChecker, RefinementStage::Compression);
+      secondStageIterations = result.iterations;
+      recordStage(&RefinementStatistics::compression, result);
+    } catch(std::out_of_range& e) {
+      return DgError::RefinementException;
+    }
+
+    if(configuration.cancellation.cancelled()) {
+      return DgError::Cancelled;
+    }
+
+    // Max iterations reached
+    if(secondStageIterations >= gradientChecker.iterLimit) {
+      return DgError::RefinementMaxIterationsReached;
+    }
+
+    // Not all chiral constraints have the right sign
+    if(refinementFunctor.proportionChiralConstraintsCorrectSign < 1) {
+      return DgError::RefinedChiralsWrong;
+    }
+
+    /* Twist all freely rotatable dihedrals to their target values to avoid
+     * conflicts between distance and dihedral errors to prevent rotations to
+     * target values.
+     */
+    Eigen::VectorXd twistedPositions = transformedPositions.template cast<double>();
+    RotatableTwists {data.dihedralConstraints, data.rotatableGroups}.apply<dimensionality>(twistedPositions);
+    transformedPositions = twistedPositions.template cast<FloatType>();
+  }
+
+  /* Add dihedral terms and refine again */
+  unsigned thirdStageIterations = 0;
+  GradientOrIterLimitStop<FloatType> gradientChecker;
+  gradientChecker.gradNorm = 1e-3;
+  gradientChecker.iterLimit = (
+    iterationLimit
+    - firstStageIterations
+    - secondStageIterations
+  );
+  gradientChecker.cancellation = &configuration.cancellation;
+
+  refinementFunctor.compressFourthDimension = true;
+  refinementFunctor.dihedralTerms = true;
+
+  beginStage();
+
+  try {
+    MOLASSEMBLER_TRACE_SPAN(polishOnly ? "DG refinement polish" : "DG refinement dihedral");
+    auto result = minimize(
+      gradientChecker,
+      polishOnly ? RefinementStage::Polish : RefinementStage::Dihedral
+    );
+    thirdStageIterations = result.iterations;
+    recordStage(
+      polishOnly ? &RefinementStatistics::polish : &RefinementStatistics::dihedral,
+      result
+    );
+  } catch(std::out_of_range& e) {
+    return DgError::RefinementException;
+  }
+
+  if(configuration.cancellation.cancelled()) {
+    return DgError::Cancelled;
+  }
+
+  if(thirdStageIterations >= gradientChecker.iterLimit) {
+    return DgError::RefinementMaxIterationsReached;
+  }
+
+  if(polishOnly && refinementFunctor.proportionChiralConstraintsCorrectSign < 1) {
+    return DgError::RefinedChiralsWrong;
+  }
+
+  // Structure inacceptable
+  if(checkFinalStructure) {
+    MOLASSEMBLER_TRACE_SPAN("DG final structure checks");
+    if(!finalStructureAcceptable(refinementFunctor, distanceBounds, transformedPositions)) {
+      return DgError::RefinedStructureInacceptable;
+    }
+  }
+
+  return std::make_pair(
+    static_cast<Eigen::VectorXd>(transformedPositions.template cast<double>()),
+    firstStageIterations + secondStageIterations + thirdStageIterations
+  );
+}
+
+//! Refinement stages in the atom count bucket of the molecule
+template<typename FloatType>
+outcome::result<std::pair<Eigen::VectorXd, unsigned>> refineInPrecision(
+  const Eigen::VectorXd& positions,
+  const Eigen::MatrixXd& squaredBounds,
+  const DistanceBoundsMatrix& distanceBounds,
+  const unsigned iterationLimit,
+  const MoleculeDGInformation& data,
+  const Configuration& configuration,
+  const bool polishOnly,
+  const bool checkFinalStructure,
+  RefinementStatistics* const statistics
+) {
+  return dispatchAtomCount(
+    squaredBounds.cols(),
+    [&](auto maxAtoms) {
+      return refineInBucket<FloatType, decltype(maxAtoms)::value>(
+        positions,
+        squaredBounds,
+        distanceBounds,
+        iterationLimit,
+        data,
+        configuration,
+        polishOnly,
+        checkFinalStructure,
+        statistics
+      );
+    }
+  );
+}
+
+/* Lock-step refinement of a batch of embeddings of the same molecule in a
+ * particular floating point precision. Carries out the stages of
+ * refineInPrecision (excluding polishing) for all embeddings together. The
+ * objective functions of all conformers in the same stage are evaluated in a
+ * single pass over the distance bounds. Yields the refined positions and the
+ * number of iterations used for each embedding.
+ */
+template<typename FloatType, int maxAtoms>
+std::vector<
+  outcome::result<std::pair<Eigen::VectorXd, unsigned>>
+> refineBatchInBucket(
+  const std::vector<Eigen::VectorXd>& positions,
+  const Eigen::MatrixXd& squaredBounds,
+  const DistanceBoundsMatrix& distanceBounds,
+  const MoleculeDGInformation& data,
+  const Configuration& configuration,
+  const bool checkFinalStructure
+) {
+  constexpr unsigned dimensionality = refinementDimensionality;
+  using FullRefinementType = EigenRefinementProblem<dimensionality, FloatType, refinementSIMD, maxAtoms>;
+  using VectorType = typename FullRefinementType::VectorType;
+  using BatchMatrixType = typename FullRefinementType::BatchMatrixType;
+  using OptimizerType = Temple::Lbfgs<FloatType, 32>;
+
+  const unsigned K = positions.size();
+  if(K == 0) {
+    return {};
+  }
+
+  const unsigned P = positions.front().size();
+  const unsigned N = P / dimensionality;
+  const unsigned iterationLimit = configuration.refinementStepLimit;
+
+  BatchMatrixType transformedPositions(P, K);
+  for(unsigned k = 0; k < K; ++k) {
+    transformedPositions.col(k) = positions.at(k).template cast<FloatType>();
+  }
+
+  FullRefinementType refinementFunctor {
+    squaredBounds,
+    data.chiralConstraints,
+    data.dihedralConstraints
+  };
+
+  OptimizerType optimizer;
+  optimizer.historyLength = std::max(configuration.refinementHistoryLength, 1U);
+  if(configuration.preconditionRefinement) {
+    optimizer.preconditioner = refinementPreconditioner(squaredBounds).template cast<FloatType>();
+  }
+
+  const auto batchFunctor = [&](
+    const BatchMatrixType& parameters,
+    Eigen::Ref<VectorType> values,
+    Eigen::Ref<BatchMatrixType> gradients
+  ) {
+    refinementFunctor.evaluateBatch(parameters, values, gradients);
+  };
+
+  std::vector<DgError> failures(K, static_cast<DgError>(0));
+  std::vector<unsigned> iterations(K, 0);
+  const auto failed = [&](const unsigned k) -> bool {
+    return failures.at(k) != static_cast<DgError>(0);
+  };
+
+  /* Minimizes the columns of the conformers in members together, accumulating
+   * iterations and recording failures
+   */
+  const auto minimizeStage = [&](
+    const std::vector<unsigned>& members,
+    auto& checkers
+  ) {
+    BatchMatrixType stagePositions(P, members.size());
+    for(unsigned m = 0; m < members.size(); ++m) {
+      stagePositions.col(m) = transformedPositions.col(members.at(m));
+    }
+
+    optimizer.stepLength = 1.0;
+    const auto results = optimizer.minimizeBatch(stagePositions, batchFunctor, checkers);
+
+    for(unsigned m = 0; m < members.size(); ++m) {
+      const unsigned k = members.at(m);
+      transformedPositions.col(k) = stagePositions.col(m);
+      iterations.at(k) += results.at(m).iterations;
+      if(results.at(m).lineSearchFailed) {
+        failures.at(k) = DgError::RefinementException;
+      } else if(results.at(m).iterations >= checkers.at(m).iterLimit) {
+        failures.at(k) = DgError::RefinementMaxIterationsReached;
+      }
+    }
+  };
+
+  const auto allChiralsCorrect = [&](const unsigned k) -> bool {
+    const VectorType conformerPositions = transformedPositions.col(k);
+    return refinementFunctor.calculateProportionChiralConstraintsCorrectSign(conformerPositions) >= 1;
+  };
+
+  /* Invert conformers with less than half of their chiral constraints
+   * correct, see refineInPrecision. The others are inverted by refinement
+   * without penalty on the fourth dimension.
+   */
+  std::vector<unsigned> members;
+  for(unsigned k = 0; k < K; ++k) {
+    const VectorType conformerPositions = transformedPositions.col(k);
+    double initiallyCorrectChiralConstraints = refinementFunctor.calculateProportionChiralConstraintsCorrectSign(conformerPositions);
+    if(initiallyCorrectChiralConstraints < 0.5) {
+      for(unsigned i = 0; i < N; ++i) {
+        transformedPositions(dimensionality * i + 1, k) *= -1;
+      }
+      initiallyCorrectChiralConstraints = 1 - initiallyCorrectChiralConstraints;
+    }
+
+    if(initiallyCorrectChiralConstraints < configuration.chiralityScreeningThreshold) {
+      failures.at(k) = DgError::EmbeddingRejected;
+    } else if(initiallyCorrectChiralConstraints < 1) {
+      members.push_back(k);
+    }
+  }
+
+  if(!members.empty()) {
+    std::vector<BatchInversionOrIterLimitStop<FullRefinementType>> inversionCheckers;
+    for(unsigned m = 0; m < members.size(); ++m) {
+      inversionCheckers.emplace_back(iterationLimit, refinementFunctor);
+      inversionCheckers.back().probe = ChiralityProbe {configuration};
+      inversionCheckers.back().cancellation = &configuration.cancellation;
+    }
+
+    minimizeStage(members, inversionCheckers);
+
+    for(unsigned m = 0; m < members.size(); ++m) {
+      const unsigned k = members.at(m);
+      if(inversionCheckers.at(m).probe.rejected) {
+        failures.at(k) = DgError::EmbeddingRejected;
+      } else if(!failed(k) && !allChiralsCorrect(k)) {
+        failures.at(k) = DgError::RefinedChiralsWrong;
+      }
+    }
+  }
+
+  const auto survivors = [&]() {
+    std::vector<unsigned> remaining;
+    for(unsigned k = 0; k < K; ++k) {
+      if(!failed(k)) {
+        remaining.push_back(k);
+      }
+    }
+    return remaining;
+  };
+
+  const auto gradientCheckers = [&](const std::vector<unsigned>& stageMembers) {
+    std::vector<GradientOrIterLimitStop<FloatType>> checkers(stageMembers.size());
+    for(unsigned m = 0; m < stageMembers.size(); ++m) {
+      checkers.at(m).gradNorm = 1e-3;
+      checkers.at(m).iterLimit = iterationLimit - iterations.at(stageMembers.at(m));
+      checkers.at(m).cancellation = &configuration.cancellation;
+    }
+    return checkers;
+  };
+
+  // Compress out the fourth dimension
+  members = survivors();
+  if(!members.empty()) {
+    refinementFunctor.compressFourthDimension = true;
+    auto checkers = gradientCheckers(members);
+    minimizeStage(members, checkers);
+  }
+
+  const RotatableTwists twists {data.dihedralConstraints, data.rotatableGroups};
+  for(const unsigned k : members) {
+    if(failed(k)) {
+      continue;
+    }
+
+    if(!allChiralsCorrect(k)) {
+      failures.at(k) = DgError::RefinedChiralsWrong;
+      continue;
+    }
+
+    Eigen::VectorXd twistedPositions = transformedPositions.col(k).template cast<double>();
+    twists.apply<dimensionality>(twistedPositions);
+    transformedPositions.col(k) = twistedPositions.template cast<FloatType>();
+  }
+
+  // Add dihedral terms and refine again
+  members = survivors();
+  if(!members.empty()) {
+    refinementFunctor.dihedralTerms = true;
+    auto checkers = gradientCheckers(members);
+    minimizeStage(members, checkers);
+  }
+
+  std::vector<
+    outcome::result<std::pair<Eigen::VectorXd, unsigned>>
+  > results;
+  results.reserve(K);
+  const bool cancelled = configuration.cancellation.cancelled();
+  for(unsigned k = 0; k < K; ++k) {
+    if(failed(k)) {
+      results.emplace_back(failures.at(k));
+      continue;
+    }
+
+    if(cancelled) {
+      results.emplace_back(DgError::Cancelled);
+      continue;
+    }
+
+    const VectorType conformerPositions = transformedPositions.col(k);
+    if(
+      checkFinalStructure
+      && !finalStructureAcceptable(
+        refinementFunctor,
+        distanceBounds,
+        conformerPositions
+      )
+    ) {
+      results.emplace_back(DgError::RefinedStructureInacceptable);
+      continue;
+    }
+
+    results.emplace_back(
+      std::make_pair(
+        static_cast<Eigen::VectorXd>(conformerPositions.template cast<double>()),
+        iterations.at(k)
+      )
+    );
+  }
+
+  return results;
+}
+
+//! Lock-step refinement in the atom count bucket of the molecule
+template<typename FloatType>
+std::vector<
+  outcome::result<std::pair<Eigen::VectorXd, unsigned>>
+> refineBatchInPrecision(
+  const std::vector<Eigen::VectorXd>& positions,
+  const Eigen::MatrixXd& squaredBounds,
+  const DistanceBoundsMatrix& distanceBounds,
+  const MoleculeDGInformation& data,
+  const Configuration& configuration,
+  const bool checkFinalStructure
+) {
+  return dispatchAtomCount(
+    squaredBounds.cols(),
+    [&](auto maxAtoms) {
+      return refineBatchInBucket<FloatType, decltype(maxAtoms)::value>(
+        positions,
+        squaredBounds,
+        distanceBounds,
+        data,
+        configuration,
+        checkFinalStructure
+      );
+    }
+  );
+}
+
+/* Converts refined linearized positions into a conformer, fitting it onto
+ * any fixed positions
+ */
+AngstromPositions finalizeRefinedPositions(
+  const Eigen::VectorXd& refinedPositions,
+  const Configuration& configuration
+) {
+  auto gatheredPositions = gather(refinedPositions);
+
+  if(!configuration.fixedPositions.empty()) {
+    return convertToAngstromPositions(
+      fitAndSetFixedPositions(gatheredPositions, configuration)
+    );
+  }
+
+  return convertToAngstromPositions(gatheredPositions);
+}
+
+} // namespace Detail
+
+outcome::result<AngstromPositions> refine(
+  Eigen::MatrixXd embeddedPositions,
+  const DistanceBoundsMatrix& distanceBounds,
+  const Configuration& configuration,
+  const std::shared_ptr<MoleculeDGInformation>& DgDataPtr,
+  RefinementStatistics* const statistics
+) {
+  MOLASSEMBLER_TRACE_SPAN("DG refinement");
+
+  // Vectorize positions
+  const Eigen::VectorXd vectorizedPositions = Eigen::Map<Eigen::VectorXd>(
+    embeddedPositions.data(),
+    embeddedPositions.cols() * embeddedPositions.rows()
+  );
+
+  const auto squaredBounds = static_cast<Eigen::MatrixXd>(
+    distanceBounds.access().cwiseProduct(distanceBounds.access())
+  );
+
+  if(statistics != nullptr && configuration.trajectoryInterval > 0) {
+    statistics->trajectory = RefinementTrajectory {configuration.trajectoryCapacity};
+  }
+
+  /* Single precision halves the memory traffic of the refinement functor, but
+   * doubles are helpful for refinement stability. Mixed precision refines in
+   * single precision and polishes the result in double precision.
+   */
+  auto refinementResult = [&]() -> outcome::result<std::pair<Eigen::VectorXd, unsigned>> {
+    switch(configuration.refinementPrecision) {
+      case RefinementPrecision::Single:
+        return Detail::refineInPrecision<float>(
+          vectorizedPositions,
+          squaredBounds,
+          distanceBounds,
+          configuration.refinementStepLimit,
+          *DgDataPtr,
+          configuration,
+          false,
+          true,
+          statistics
+        );
+      case RefinementPrecision::Mixed: {
+        auto singleResult = Detail::refineInPrecision<float>(
+          vectorizedPositions,
+          squaredBounds,
+          distanceBounds,
+          configuration.refinementStepLimit,
+          *DgDataPtr,
+          configuration,
+          false,
+          false,
+          statistics
+        );
+        if(!singleResult) {
+          return singleResult.as_failure();
+        }
+
+        auto polishResult = Detail::refineInPrecision<double>(
+          singleResult.value().first,
+          squaredBounds,
+          distanceBounds,
+          configuration.refinementStepLimit - singleResult.value().second,
+          *DgDataPtr,
+          configuration,
+          true,
+          true,
+          statistics
+        );
+        if(polishResult) {
+          polishResult.value().second += singleResult.value().second;
+        }
+        return polishResult;
+      }
+      default:
+        return Detail::refineInPrecision<double>(
+          vectorizedPositions,
+          squaredBounds,
+          distanceBounds,
+          configuration.refinementStepLimit,
+          *DgDataPtr,
+          configuration,
+          false,
+          true,
+          statistics
+        );
+    }
+  }();
+
+  if(!refinementResult) {
+    return refinementResult.as_failure();
+  }
+
+  return Detail::finalizeRefinedPositions(
+    refinementResult.value().first,
+    configuration
+  );
+}
+
+std::vector<
+  outcome::result<AngstromPositions>
+> refineBatch(
+  const std::vector<Eigen::MatrixXd>& embeddedPositions,
+  const DistanceBoundsMatrix& distanceBounds,
+  const Configuration& configuration,
+  const std::shared_ptr<MoleculeDGInformation>& DgDataPtr
+) {
+  MOLASSEMBLER_TRACE_SPAN("DG batch refinement");
+
+  std::vector<Eigen::VectorXd> vectorizedPositions;
+  vectorizedPositions.reserve(embeddedPositions.size());
+  for(const Eigen::MatrixXd& embedding : embeddedPositions) {
+    vectorizedPositions.emplace_back(
+      Eigen::Map<const Eigen::VectorXd>(
+        embedding.data(),
+        embedding.cols() * embedding.rows()
+      )
+    );
+  }
+
+  const auto squaredBounds = static_cast<Eigen::MatrixXd>(
+    distanceBounds.access().cwiseProduct(distanceBounds.access())
+  );
+
+  std::vector<
+    outcome::result<std::pair<Eigen::VectorXd, unsigned>>
+  > refinementResults;
+  switch(configuration.refinementPrecision) {
+    case RefinementPrecision::Single:
+      refinementResults = Detail::refineBatchInPrecision<float>(
+        vectorizedPositions,
+        squaredBounds,
+        distanceBounds,
+        *DgDataPtr,
+        configuration,
+        true
+      );
+      break;
+    case RefinementPrecision::Mixed:
+      refinementResults = Detail::refineBatchInPrecision<float>(
+        vectorizedPositions,
+        squaredBounds,
+        distanceBounds,
+        *DgDataPtr,
+        configuration,
+        false
+      );
+      // Polish each conformer individually in double precision
+      for(auto& singleResult : refinementResults) {
+        if(!singleResult) {
+          continue;
+        }
+
+        auto polishResult = Detail::refineInPrecision<double>(
+          singleResult.value().first,
+          squaredBounds,
+          distanceBounds,
+          configuration.refinementStepLimit - singleResult.value().second,
+          *DgDataPtr,
+          configuration,
+          true,
+          true,
+          nullptr
+        );
+        if(polishResult) {
+          polishResult.value().second += singleResult.value().second;
+        }
+        singleResult = std::move(polishResult);
+      }
+      break;
+    default:
+      refinementResults = Detail::refineBatchInPrecision<double>(
+        vectorizedPositions,
+        squaredBounds,
+        distanceBounds,
+        *DgDataPtr,
+        configuration,
+        true
+      );
+      break;
+  }
+
+  std::vector<
+    outcome::result<AngstromPositions>
+  > results;
+  results.reserve(refinementResults.size());
+  for(auto& refinementResult : refinementResults) {
+    if(!refinementResult) {
+      results.emplace_back(refinementResult.as_failure());
+    } else {
+      results.emplace_back(
+        Detail::finalizeRefinedPositions(
+          refinementResult.value().first,
+          configuration
+        )
+      );
+    }
+  }
+  return results;
+}
+
+namespace Detail {
+
+/* Constructing an explicit bounds graph allocates each of its quadratically
+ * many edges. Each thread keeps the graph of the most recent molecule instead
+ * and restores it for each further conformer with the same DG data.
+ */
+ExplicitBoundsGraph& threadExplicitGraph(
+  const PrivateGraph& inner,
+  const std::shared_ptr<MoleculeDGInformation>& DgDataPtr
+) {
+  struct Cache {
+    std::weak_ptr<MoleculeDGInformation> data;
+    const PrivateGraph* inner = nullptr;
+    boost::optional<ExplicitBoundsGraph> graph;
+  };
+  thread_local Cache cache;
+
+  MOLASSEMBLER_TRACE_SPAN("DG bounds graph");
+
+  // Owner-based comparison cannot confuse expired data with new data
+  const bool sameData = (
+    !cache.data.owner_before(DgDataPtr)
+    && !DgDataPtr.owner_before(cache.data)
+  );
+  if(cache.graph && sameData && cache.inner == &inner) {
+    cache.graph->restore();
+  } else {
+    cache.graph.emplace(inner, DgDataPtr->bounds);
+    cache.data = DgDataPtr;
+    cache.inner = &inner;
+  }
+
+  return cache.graph.value();
+}
+
+/*! @brief Subset of a molecule's atoms and their modeling data
+ *
+ * Distance bounds are those between the subset's atoms in the molecule's
+ * smoothed distance bounds, which remain smooth between any subset of atoms.
+ * Only constraints whose sites lie entirely within the subset are kept. The
+ * explicit bounds graph refers to the substructure's graph, so substructures
+ * are not movable.
+ */
+struct Substructure {
+  Substructure(
+    const PrivateGraph& inner,
+    const DistanceBoundsMatrix& distanceBounds,
+    const MoleculeDGInformation& moleculeData,
+    std::vector<AtomIndex> passAtoms
+  ) : atoms(std::move(passAtoms)) {
+    assert(std::is_sorted(std::begin(atoms), std::end(atoms)));
+    const unsigned N = inner.N();
+    const unsigned S = atoms.size();
+
+    // Atoms outside the substructure have no index in it
+    std::vector<AtomIndex> index(N, N);
+    for(unsigned a = 0; a < S; ++a) {
+      index.at(atoms.at(a)) = a;
+      graph.addVertex(inner.elementType(atoms.at(a)));
+    }
+
+    for(const PrivateGraph::Edge& edge : inner.edges()) {
+      const AtomIndex a = index.at(inner.source(edge));
+      const AtomIndex b = index.at(inner.target(edge));
+      if(a != N && b != N) {
+        graph.addEdge(a, b, inner.bondType(edge));
+      }
+    }
+
+    Eigen::MatrixXd substructureBounds(S, S);
+    for(unsigned a = 0; a < S; ++a) {
+      for(unsigned b = 0; b < S; ++b) {
+        substructureBounds(a, b) = distanceBounds.access()(atoms.at(a), atoms.at(b));
+      }
+    }
+    bounds = DistanceBoundsMatrix {std::move(substructureBounds)};
+
+    const auto contained = [&](const auto& sites) {
+      return Temple::all_of(sites, [&](const auto& site) {
+        return Temple::all_of(site, [&](const AtomIndex i) { return index.at(i) != N; });
+      });
+    };
+    const auto remap = [&](auto& sites) {
+      for(auto& site : sites) {
+        for(AtomIndex& i : site) {
+          i = index.at(i);
+        }
+      }
+    };
+
+    data = std::make_shared<MoleculeDGInformation>();
+    for(const ChiralConstraint& constraint : moleculeData.chiralConstraints) {
+      if(contained(constraint.sites)) {
+        data->chiralConstraints.push_back(constraint);
+        remap(data->chiralConstraints.back().sites);
+      }
+    }
+    for(const DihedralConstraint& constraint : moleculeData.dihedralConstraints) {
+      if(contained(constraint.sites)) {
+        data->dihedralConstraints.push_back(constraint);
+        remap(data->dihedralConstraints.back().sites);
+      }
+    }
+    for(const auto& bondGroupPair : moleculeData.rotatableGroups) {
+      const BondIndex& bond = bondGroupPair.first;
+      if(index.at(bond.first) == N || index.at(bond.second) == N) {
+        continue;
+      }
+
+      MoleculeDGInformation::RotatableGroup group {
+        index.at(bondGroupPair.second.side),
+        {}
+      };
+      for(const AtomIndex i : bondGroupPair.second.vertices) {
+        if(index.at(i) != N) {
+          group.vertices.push_back(index.at(i));
+        }
+      }
+      data->rotatableGroups.emplace(
+        BondIndex {index.at(bond.first), index.at(bond.second)},
+        std::move(group)
+      );
+    }
+
+    explicitGraph.emplace(graph, bounds);
+  }
+
+  Substructure(const Substructure& other) = delete;
+  Substructure& operator = (const Substructure& other) = delete;
+
+  //! Molecule indices of the substructure's atoms in ascending order
+  std::vector<AtomIndex> atoms;
+  PrivateGraph graph;
+  DistanceBoundsMatrix bounds;
+  std::shared_ptr<MoleculeDGInformation> data;
+  boost::optional<ExplicitBoundsGraph> explicitGraph;
+};
+
+/*! @brief Hierarchical embedding of a molecule
+ *
+ * Substructures are embedded and refined in order, each fitted onto the
+ * atoms it shares with those embedded before it. Deferred hydrogens are
+ * placed afterwards.
+ */
+struct EmbeddingPlan {
+  std::vector<std::unique_ptr<Substructure>> substructures;
+  std::vector<AtomIndex> deferredHydrogens;
+};
+
+/* Each thread keeps the embedding plan of the most recent molecule, like its
+ * explicit bounds graph. Yields nullptr if molecules are embedded whole.
+ */
+EmbeddingPlan* threadEmbeddingPlan(
+  const PrivateGraph& inner,
+  const DistanceBoundsMatrix& distanceBounds,
+  const Configuration& configuration,
+  const std::shared_ptr<MoleculeDGInformation>& DgDataPtr
+) {
+  if(
+    (!configuration.deferHydrogens && configuration.fragmentSize == 0)
+    || !configuration.fixedPositions.empty()
+  ) {
+    return nullptr;
+  }
+
+  struct Cache {
+    std::weak_ptr<MoleculeDGInformation> data;
+    const PrivateGraph* inner = nullptr;
+    std::unique_ptr<EmbeddingPlan> plan;
+  };
+  thread_local Cache cache;
+
+  const bool sameData = (
+    !cache.data.owner_before(DgDataPtr)
+    && !DgDataPtr.owner_before(cache.data)
+  );
+  if(sameData && cache.inner == &inner) {
+    if(cache.plan) {
+      for(auto& substructurePtr : cache.plan->substructures) {
+        substructurePtr->explicitGraph->restore();
+      }
+    }
+    return cache.plan.get();
+  }
+
+  MOLASSEMBLER_TRACE_SPAN("DG embedding plan");
+
+  cache.data = DgDataPtr;
+  cache.inner = &inner;
+  cache.plan.reset();
+
+  const unsigned N = inner.N();
+  std::vector<AtomIndex> hydrogens;
+  if(configuration.deferHydrogens) {
+    hydrogens = deferrableHydrogens(inner, *DgDataPtr);
+    if(N - hydrogens.size() < 4) {
+      hydrogens.clear();
+    }
+  }
+
+  std::vector<std::vector<AtomIndex>> fragments;
+  if(configuration.fragmentSize > 0 && N - hydrogens.size() > configuration.fragmentSize) {
+    fragments = fragment(inner, hydrogens, configuration.fragmentSize);
+  }
+
+  if(hydrogens.empty() && fragments.size() <= 1) {
+    return nullptr;
+  }
+
+  if(fragments.empty()) {
+    std::vector<char> deferred(N, false);
+    for(const AtomIndex h : hydrogens) {
+      deferred.at(h) = true;
+    }
+    fragments.emplace_back();
+    for(AtomIndex i = 0; i < N; ++i) {
+      if(!deferred.at(i)) {
+        fragments.front().push_back(i);
+      }
+    }
+  }
+
+  auto plan = std::make_unique<EmbeddingPlan>();
+  for(auto& fragmentAtoms : fragments) {
+    plan->substructures.push_back(
+      std::make_unique<Substructure>(
+        inner,
+        distanceBounds,
+        *DgDataPtr,
+        std::move(fragmentAtoms)
+      )
+    );
+  }
+  plan->deferredHydrogens = std::move(hydrogens);
+  cache.plan = std::move(plan);
+
+  return cache.plan.get();
+}
+
+//! Metrizes, embeds and refines a substructure on its own
+outcome::result<AngstromPositions> embedAndRefineSubstructure(
+  Substructure& substructure,
+  const Configuration& configuration,
+  Random::Engine& engine
+) {
+  auto distanceMatrixResult = [&]() {
+    MOLASSEMBLER_TRACE_SPAN("DG metrization");
+    return substructure.explicitGraph->makeDistanceMatrix(engine, configuration.partiality);
+  }();
+  if(!distanceMatrixResult) {
+    return distanceMatrixResult.as_failure();
+  }
+
+  thread_local EmbeddingWorkspace embeddingWorkspace;
+  auto embeddedPositions = [&]() {
+    MOLASSEMBLER_TRACE_SPAN("DG embedding");
+    MetricMatrix metric(
+      std::move(distanceMatrixResult.value())
+    );
+    return metric.embed(embeddingWorkspace);
+  }();
+
+  return refine(
+    std::move(embeddedPositions),
+    substructure.bounds,
+    configuration,
+    substructure.data,
+    nullptr
+  );
+}
+
+/* Embeds and refines each substructure of a plan, fitting each onto the
+ * atoms placed before it, places deferred hydrogens and refines all atoms
+ * from there
+ */
+outcome::result<AngstromPositions> embedAndRefinePlan(
+  EmbeddingPlan& plan,
+  const PrivateGraph& inner,
+  const DistanceBoundsMatrix& distanceBounds,
+  const Configuration& configuration,
+  const std::shared_ptr<MoleculeDGInformation>& DgDataPtr,
+  Random::Engine& engine,
+  RefinementStatistics* const statistics
+) {
+  const unsigned N = inner.N();
+  Eigen::MatrixXd positions = Eigen::MatrixXd::Zero(4, N);
+  std::vector<char> placed(N, false);
+  for(const auto& substructurePtr : plan.substructures) {
+    if(configuration.cancellation.cancelled()) {
+      return DgError::Cancelled;
+    }
+
+    auto substructureResult = embedAndRefineSubstructure(*substructurePtr, configuration, engine);
+    if(!substructureResult) {
+      return substructureResult.as_failure();
+    }
+
+    const std::vector<AtomIndex>& atoms = substructurePtr->atoms;
+    const unsigned S = atoms.size();
+    Eigen::MatrixXd substructurePositions = substructureResult.value().positions;
+
+    // Fit onto the atoms shared with substructures placed earlier
+    Eigen::MatrixXd reference = Eigen::MatrixXd::Zero(S, 3);
+    Eigen::VectorXd weights = Eigen::VectorXd::Zero(S);
+    for(unsigned a = 0; a < S; ++a) {
+      if(placed.at(atoms.at(a))) {
+        reference.row(a) = positions.col(atoms.at(a)).head<3>().transpose();
+        weights(a) = 1;
+      }
+    }
+    if(weights.sum() > 0) {
+      substructurePositions = Utils::QuaternionFit(reference, substructurePositions, weights).getFittedData();
+    }
+
+    for(unsigned a = 0; a < S; ++a) {
+      if(!placed.at(atoms.at(a))) {
+        positions.col(atoms.at(a)).head<3>() = substructurePositions.row(a).transpose();
+        placed.at(atoms.at(a)) = true;
+      }
+    }
+  }
+
+  if(configuration.cancellation.cancelled()) {
+    return DgError::Cancelled;
+  }
+
+  placeHydrogens(positions, inner, plan.deferredHydrogens, distanceBounds);
+
+  /* Assembled fragments satisfy most distance bounds by a wide margin, so
+   * their final refinement evaluates distance terms sparsely
+   */
+  if(plan.substructures.size() > 1 && configuration.distanceTermSkin == 0) {
+    Configuration sparseConfiguration = configuration;
+    sparseConfiguration.distanceTermSkin = 1.0;
+    return refine(
+      std::move(positions),
+      distanceBounds,
+      sparseConfiguration,
+      DgDataPtr,
+      statistics
+    );
+  }
+
+  return refine(
+    std::move(positions),
+    distanceBounds,
+    configuration,
+    DgDataPtr,
+    statistics
+  );
+}
+
+/*! @brief Adaptive partiality choices of this thread for a molecule
+ *
+ * Outcomes are kept across conformers of the same molecule, even if its
+ * modeling data is regenerated for each conformer.
+ */
+AdaptivePartiality& threadAdaptivePartiality(
+  const PrivateGraph& inner,
+  const DistanceBoundsMatrix& distanceBounds
+) {
+  struct Cache {
+    const PrivateGraph* inner = nullptr;
+    unsigned N = 0;
+    unsigned B = 0;
+    boost::optional<AdaptivePartiality> adaptive;
+  };
+  thread_local Cache cache;
+
+  if(
+    !cache.adaptive
+    || cache.inner != &inner
+    || cache.N != inner.N()
+    || cache.B != inner.B()
+  ) {
+    cache.adaptive.emplace(distanceBounds);
+    cache.inner = &inner;
+    cache.N = inner.N();
+    cache.B = inner.B();
+  }
+
+  return cache.adaptive.value();
+}
+
+outcome::result<AngstromPositions> embedAndRefine(
+  const PrivateGraph& inner,
+  ExplicitBoundsGraph& explicitGraph,
+  const DistanceBoundsMatrix& distanceBounds,
+  const Configuration& configuration,
+  const std::shared_ptr<MoleculeDGInformation>& DgDataPtr,
+  Random::Engine& engine,
+  RefinementStatistics* const statistics
+) {
+  if(configuration.cancellation.cancelled()) {
+    return DgError::Cancelled;
+  }
+
+  /* With adaptive partiality, the number of smoothed atoms is chosen from
+   * and the outcome recorded in this thread's earlier outcomes
+   */
+  AdaptivePartiality* adaptive = nullptr;
+  unsigned smoothedAtoms = smoothedAtomCount(configuration.partiality, inner.N());
+  if(configuration.partiality == Partiality::Adaptive) {
+    adaptive = &threadAdaptivePartiality(inner, distanceBounds);
+    smoothedAtoms = adaptive->choose();
+  }
+  const auto start = std::chrono::steady_clock::now();
+  auto recordOutcome = [&](const bool success) {
+    if(adaptive != nullptr && !configuration.cancellation.cancelled()) {
+      adaptive->record(
+        smoothedAtoms,
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count(),
+        success
+      );
+    }
+  };
+
+  // Generate a distances matrix from the graph
+  auto distanceMatrixResult = [&]() {
+    MOLASSEMBLER_TRACE_SPAN("DG metrization");
+    return explicitGraph.makeDistanceMatrix(engine, smoothedAtoms);
+  }();
+  if(!distanceMatrixResult) {
+    recordOutcome(false);
+    return distanceMatrixResult.as_failure();
+  }
+
+  /* Make a metric matrix from the distances matrix and get a position matrix
+   * by embedding it. Each thread keeps its own embedding workspace alive
+   * across conformers.
+   */
+  thread_local EmbeddingWorkspace embeddingWorkspace;
+  auto embeddedPositions = [&]() {
+    MOLASSEMBLER_TRACE_SPAN("DG embedding");
+    MetricMatrix metric(
+      std::move(distanceMatrixResult.value())
+    );
+    return metric.embed(embeddingWorkspace);
+  }();
+
+  /* Refinement */
+  auto result = refine(
+    std::move(embeddedPositions),
+    distanceBounds,
+    configuration,
+    DgDataPtr,
+    statistics
+  );
+  recordOutcome(static_cast<bool>(result));
+  return result;
+}
+
+} // namespace Detail
+
+outcome::result<AngstromPositions> generateConformer(
+  const Molecule& molecule,
+  const Configuration& configuration,
+  std::shared_ptr<MoleculeDGInformation>& DgDataPtr,
+  bool regenerateDGDataEachStep,
+  Random::Engine& engine,
+  RefinementStatistics* const statistics
+) {
+  if(regenerateDGDataEachStep) {
+    auto moleculeCopy = Detail::narrow(molecule, engine);
+
+    if(moleculeCopy.stereopermutators().hasZeroAssignmentStereopermutators()) {
+      return DgError::ZeroAssignmentStereopermutators;
+    }
+
+    DgDataPtr = std::make_shared<MoleculeDGInformation>(
+      gatherDGInformation(moleculeCopy, configuration)
+    );
+  }
+
+  ExplicitBoundsGraph& explicitGraph = Detail::threadExplicitGraph(
+    molecule.graph().inner(),
+    DgDataPtr
+  );
+
+  // Get distance bounds matrix from the graph
+  auto distanceBoundsResult = [&]() {
+    MOLASSEMBLER_TRACE_SPAN("DG bounds smoothing");
+    return explicitGraph.makeDistanceBounds();
+  }();
+  if(!distanceBoundsResult) {
+    return distanceBoundsResult.as_failure();
+  }
+
+  DistanceBoundsMatrix distanceBounds {std::move(distanceBoundsResult.value())};
+
+  /* There should be no need to smooth the distance bounds, because the graph
+   * type ought to create them within the triangle inequality bounds:
+   */
+  assert(distanceBounds.boundInconsistencies() == 0);
+
+  const PrivateGraph& inner = molecule.graph().inner();
+  if(auto* plan = Detail::threadEmbeddingPlan(inner, distanceBounds, configuration, DgDataPtr)) {
+    return Detail::embedAndRefinePlan(
+      *plan,
+      inner,
+      distanceBounds,
+      configuration,
+      DgDataPtr,
+      engine,
+      statistics
+    );
+  }
+
+  return Detail::embedAndRefine(
+    inner,
+    explicitGraph,
+    distanceBounds,
+    configuration,
+    DgDataPtr,
+    engine,
+    statistics
+  );
+}
+
+outcome::result<AngstromPositions> generateConformer(
+  const Molecule& molecule,
+  const Configuration& configuration,
+  const SharedModel& sharedModel,
+  Random::Engine& engine,
+  RefinementStatistics* const statistics
+) {
+  auto moleculeCopy = Detail::narrow(molecule, engine);
+
+  if(moleculeCopy.stereopermutators().hasZeroAssignmentStereopermutators()) {
+    return DgError::ZeroAssignmentStereopermutators;
+  }
+
+  auto overlaid = sharedModel.overlay(moleculeCopy);
+  auto DgDataPtr = std::make_shared<MoleculeDGInformation>(
+    overlaid
+    ? std::move(overlaid.value())
+    : gatherDGInformation(moleculeCopy, configuration)
+  );
+
+  return generateConformer(
+    molecule,
+    configuration,
+    DgDataPtr,
+    false,
+    engine,
+    statistics
+  );
+}
+
+outcome::result<AngstromPositions> generateConformer(
+  const Molecule& molecule,
+  const Configuration& configuration,
+  const std::shared_ptr<MoleculeDGInformation>& DgDataPtr,
+  const DistanceBoundsMatrix& distanceBounds,
+  Random::Engine& engine,
+  RefinementStatistics* const statistics
+) {
+  const PrivateGraph& inner = molecule.graph().inner();
+  if(auto* plan = Detail::threadEmbeddingPlan(inner, distanceBounds, configuration, DgDataPtr)) {
+    return Detail::embedAndRefinePlan(
+      *plan,
+      inner,
+      distanceBounds,
+      configuration,
+      DgDataPtr,
+      engine,
+      statistics
+    );
+  }
+
+  ExplicitBoundsGraph& explicitGraph = Detail::threadExplicitGraph(
+    inner,
+    DgDataPtr
+  );
+
+  return Detail::embedAndRefine(
+    inner,
+    explicitGraph,
+    distanceBounds,
+    configuration,
+    DgDataPtr,
+    engine,
+    statistics
+  );
+}
+
+namespace Detail {
+
+//! Tallies a failed result in the library metrics
+template<typename T>
+void recordFailure(const outcome::result<T>& result) {
+  if(!result) {
+    Molassembler::Detail::Metrics::recordDgFailure(
+      static_cast<DgError>(result.error().value())
+    );
+  }
+}
+
+//! Reports the same failure for all conformers until the callback declines
+template<typename T, typename Callback>
+void reportFailure(
+  const unsigned numConformers,
+  const outcome::result<T>& failure,
+  Callback& callback
+) {
+  for(unsigned i = 0; i < numConformers; ++i) {
+    recordFailure(failure);
+    if(!callback(i, 0, failure.as_failure())) {
+      break;
+    }
+  }
+}
+
+/* Each conformer's individual seed is a counter-based function of the
+ * ensemble seed and the conformer index, so no seeds need to be drawn
+ * sequentially. If no seed is supplied, the ensemble seed is drawn from the
+ * global prng. Otherwise, the global prng state is not advanced.
+ */
+std::vector<int> conformerSeeds(
+  const unsigned numConformers,
+  const boost::optional<unsigned> seedOption
+) {
+  const unsigned seed = seedOption.value_or_eval(
+    []() -> unsigned { return randomnessEngine()(); }
+  );
+
+  std::vector<int> seeds(numConformers);
+  for(unsigned i = 0; i < numConformers; ++i) {
+    seeds[i] = Random::streamSeed(seed, i);
+  }
+  return seeds;
+}
+
+/* Parallel conformer generation core. The generator is called with a seeded
+ * PRNG engine for each conformer and the conformer's entry of statistics,
+ * or nullptr if statistics is nullptr. The callback returns whether further
+ * conformers are desired. Once it returns false, remaining attempts are
+ * skipped.
+ */
+template<typename Generator, typename Callback>
+void runParallel(
+  const unsigned numConformers,
+  const boost::optional<unsigned> seedOption,
+  Generator generator,
+  Callback&& callback,
+  std::vector<RefinementStatistics>* const statistics = nullptr
+) {
+  /* We have to distribute pseudo-randomness into each thread reproducibly
+   * and want to avoid having to guard the global PRNG against access from
+   * multiple threads, so we provide each thread its own Engine and pre-generate
+   * each conformer's individual seed in the sequential section.
+   */
+  const auto executor = Parallel::executor();
+  Parallel::WorkerLocal<Random::Engine> randomnessEngines {*executor, Random::Engine {}};
+  const auto seeds = conformerSeeds(numConformers, seedOption);
+
+  /* Exceptions from the callback cannot leave the parallel loop, so the
+   * first one is kept and rethrown once all workers are done
+   */
+  std::exception_ptr callbackException;
+  std::atomic<bool> stop {false};
+  std::mutex outputMutex;
+  std::mutex callbackMutex;
+
+  /* Each worker has its own copy of the generator, which may carry
+   * worker-private state (see MoleculeConformerGenerator)
+   */
+  Parallel::WorkerLocal<Generator> generators {*executor, std::move(generator)};
+
+  Parallel::forEach(*executor, numConformers, [&](const unsigned i, const unsigned worker) {
+    // Parallel loops cannot be broken out of, so skip remaining iterations
+    if(stop) {
+      return;
+    }
+
+    // Get worker-specific randomness engine reference
+    Random::Engine& engine = randomnessEngines[worker];
+
+    // Re-seed the worker's PRNG engine for each conformer
+    engine.seed(seeds.at(i));
+
+    /* We have to handle any and all exceptions here bceause this is a parallel
+     * environment and exceptions are not propagated anywhere
+     */
+    outcome::result<AngstromPositions> conformerResult = static_cast<DgError>(0);
+    try {
+      // Generate the conformer
+      conformerResult = generators[worker](
+        engine,
+        statistics != nullptr ? &statistics->at(i) : nullptr
+      );
+    } catch(std::exception& e) {
+      std::lock_guard<std::mutex> lock(outputMutex);
+      std::cerr << "WARNING: Uncaught exception in conformer generation: " << e.what() << "\n";
+      conformerResult = DgError::UnknownException;
+    } // end catch
+
+    recordFailure(conformerResult);
+
+    std::lock_guard<std::mutex> lock(callbackMutex);
+    if(!stop) {
+      try {
+        if(!callback(i, seeds.at(i), std::move(conformerResult))) {
+          stop = true;
+        }
+      } catch(...) {
+        callbackException = std::current_exception();
+        stop = true;
+      }
+    }
+  });
+
+  if(callbackException) {
+    std::rethrow_exception(callbackException);
+  }
+}
+
+/* Embeds a batch of conformers, each with a PRNG engine reseeded with its
+ * seed, and refines all successful embeddings together
+ */
+std::vector<
+  outcome::result<AngstromPositions>
+> generateConformerBatch(
+  const Molecule& molecule,
+  const Configuration& configuration,
+  const std::shared_ptr<MoleculeDGInformation>& DgDataPtr,
+  const DistanceBoundsMatrix& distanceBounds,
+  const std::vector<int>& seeds,
+  Random::Engine& engine
+) {
+  const unsigned K = seeds.size();
+  if(configuration.cancellation.cancelled()) {
+    return std::vector<outcome::result<AngstromPositions>>(K, DgError::Cancelled);
+  }
+
+  std::vector<
+    outcome::result<AngstromPositions>
+  > results(K, static_cast<DgError>(0));
+
+  thread_local EmbeddingWorkspace embeddingWorkspace;
+  std::vector<Eigen::MatrixXd> embeddings;
+  std::vector<unsigned> embeddedIndices;
+  for(unsigned k = 0; k < K; ++k) {
+    engine.seed(seeds.at(k));
+
+    ExplicitBoundsGraph& explicitGraph = threadExplicitGraph(
+      molecule.graph().inner(),
+      DgDataPtr
+    );
+
+    auto distanceMatrixResult = [&]() {
+      MOLASSEMBLER_TRACE_SPAN("DG metrization");
+      return explicitGraph.makeDistanceMatrix(engine, configuration.partiality);
+    }();
+    if(!distanceMatrixResult) {
+      results.at(k) = distanceMatrixResult.as_failure();
+      continue;
+    }
+
+    {
+      MOLASSEMBLER_TRACE_SPAN("DG embedding");
+      MetricMatrix metric(
+        std::move(distanceMatrixResult.value())
+      );
+      embeddings.push_back(metric.embed(embeddingWorkspace));
+    }
+    embeddedIndices.push_back(k);
+  }
+
+  auto refined = refineBatch(embeddings, distanceBounds, configuration, DgDataPtr);
+  for(unsigned e = 0; e < embeddedIndices.size(); ++e) {
+    results.at(embeddedIndices.at(e)) = std::move(refined.at(e));
+  }
+
+  return results;
+}
+
+/* Parallel batched conformer generation core. Conformers are split into
+ * batches of the configuration's refinement batch size that are distributed
+ * over threads. Seeds and the callback are as in runParallel.
+ */
+template<typename Callback>
+void runParallelBatches(
+  const unsigned numConformers,
+  const boost::optional<unsigned> seedOption,
+  const Molecule& molecule,
+  const Configuration& configuration,
+  const std::shared_ptr<MoleculeDGInformation>& DgDataPtr,
+  const DistanceBoundsMatrix& distanceBounds,
+  Callback&& callback
+) {
+  const auto executor = Parallel::executor();
+  Parallel::WorkerLocal<Random::Engine> randomnessEngines {*executor, Random::Engine {}};
+  const auto seeds = conformerSeeds(numConformers, seedOption);
+
+  const unsigned batchSize = std::max(configuration.refinementBatchSize, 1U);
+  const unsigned numBatches = (numConformers + batchSize - 1) / batchSize;
+
+  std::exception_ptr callbackException;
+  std::atomic<bool> stop {false};
+  std::mutex outputMutex;
+  std::mutex callbackMutex;
+
+  Parallel::forEach(*executor, numBatches, [&](const unsigned b, const unsigned worker) {
+    if(stop) {
+      return;
+    }
+
+    Random::Engine& engine = randomnessEngines[worker];
+
+    const unsigned begin = b * batchSize;
+    const unsigned end = std::min(begin + batchSize, numConformers);
+    const std::vector<int> batchSeeds(
+      std::begin(seeds) + begin,
+      std::begin(seeds) + end
+    );
+
+    std::vector<
+      outcome::result<AngstromPositions>
+    > batchResults;
+    try {
+      batchResults = generateConformerBatch(
+        molecule,
+        configuration,
+        DgDataPtr,
+        distanceBounds,
+        batchSeeds,
+        engine
+      );
+    } catch(std::exception& e) {
+      std::lock_guard<std::mutex> lock(outputMutex);
+      std::cerr << "WARNING: Uncaught exception in conformer generation: " << e.what() << "\n";
+      batchResults.assign(end - begin, DgError::UnknownException);
+    }
+
+    for(const auto& result : batchResults) {
+      recordFailure(result);
+    }
+
+    std::lock_guard<std::mutex> lock(callbackMutex);
+    for(unsigned i = begin; i < end && !stop; ++i) {
+      try {
+        if(!callback(i, seeds.at(i), std::move(batchResults.at(i - begin)))) {
+          stop = true;
+        }
+      } catch(...) {
+        callbackException = std::current_exception();
+        stop = true;
+      }
+    }
+  });
+
+  if(callbackException) {
+    std::rethrow_exception(callbackException);
+  }
+}
+
+
+/* Generates conformers from a molecule. Each thread has its own copy of this
+ * generator and hence its own DgDataPtr, for the following reason: If we do
+ * not need to regenerate the SpatialModel data, then having all threads
+ * share access the underlying data to generate conformers is fine. If,
+ * otherwise, we do need to regenerate the SpatialModel data for each
+ * conformer, then each thread will reset its pointer to its self-generated
+ * SpatialModel data, creating thread-private state.
+ */
+struct MoleculeConformerGenerator {
+  outcome::result<AngstromPositions> operator() (
+    Random::Engine& engine,
+    RefinementStatistics* const statistics
+  ) {
+    return generateConformer(
+      molecule,
+      configuration,
+      DgDataPtr,
+      regenerateEachStep,
+      engine,
+      statistics
+    );
+  }
+
+  const Molecule& molecule;
+  const Configuration& configuration;
+  std::shared_ptr<MoleculeDGInformation> DgDataPtr;
+  bool regenerateEachStep;
+};
+
+//! Generates conformers overlaying assignments on shared modeling data
+struct SharedModelConformerGenerator {
+  outcome::result<AngstromPositions> operator() (
+    Random::Engine& engine,
+    RefinementStatistics* const statistics
+  ) const {
+    return generateConformer(
+      molecule,
+      configuration,
+      *sharedModelPtr,
+      engine,
+      statistics
+    );
+  }
+
+  const Molecule& molecule;
+  const Configuration& configuration;
+  std::shared_ptr<const SharedModel> sharedModelPtr;
+};
+
+//! Generates conformers from a prepared spatial model
+struct PreparedConformerGenerator {
+  outcome::result<AngstromPositions> operator() (
+    Random::Engine& engine,
+    RefinementStatistics* const statistics
+  ) const {
+    if(!model.distanceBounds) {
+      return model.distanceBounds.as_failure();
+    }
+
+    return generateConformer(
+      model.molecule,
+      model.configuration,
+      model.data,
+      model.distanceBounds.value(),
+      engine,
+      statistics
+    );
+  }
+
+  const PreparedModel::Impl& model;
+};
+
+template<typename Callback>
+void runImpl(
   const Molecule& molecule,
   const unsigned numConformers,
   const Configuration& configuration,
-  const boost::optional<unsigned> seedOption
+  const boost::optional<unsigned> seedOption,
+  Callback&& callback,
+  std::vector<RefinementStatistics>* const statistics = nullptr
 ) {
-  using ReturnType = std::vector<
-    outcome::result<AngstromPositions>
-  >;
-
   // In case there are zero assignment stereopermutators, we give up immediately
   if(molecule.stereopermutators().hasZeroAssignmentStereopermutators()) {
-    return ReturnType(numConformers, DgError::ZeroAssignmentStereopermutators);
+    for(unsigned i = 0; i < numConformers; ++i) {
+      Molassembler::Detail::Metrics::recordDgFailure(DgError::ZeroAssignmentStereopermutators);
+      if(!callback(i, 0, DgError::ZeroAssignmentStereopermutators)) {
+        break;
+      }
+    }
+    return;
   }
 
-#ifdef _OPENMP
-  /* Ensure the molecule's mutable properties are already generated so none are
-   * generated on threaded const-access.
-   */
-  molecule.graph().inner().populateProperties();
-#endif
-
   /* In case the molecule has unassigned stereopermutators, we need to randomly
    * assign them for each conformer generated prior to generating the distance
    * bounds matrix. If not, then modelling data can be kept across all
@@ -585,89 +2910,552 @@ std::vector<
   bool regenerateEachStep = molecule.stereopermutators().hasUnassignedStereopermutators();
   if(!regenerateEachStep) {
     *DgDataPtr = gatherDGInformation(molecule, configuration);
-  }
 
-  ReturnType results(numConformers, static_cast<DgError>(0));
+    /* Modelling data shared by all conformers is diagnosed once, so that
+     * infeasible models fail immediately instead of once per conformer
+     */
+    auto distanceBoundsResult = checkFeasibility(molecule, *DgDataPtr);
+    if(!distanceBoundsResult) {
+      reportFailure(numConformers, distanceBoundsResult, callback);
+      return;
+    }
+
+    /* Batched refinement requires that all conformers share their distance
+     * bounds, which do not depend on randomness if the modelling data is kept
+     */
+    if(
+      configuration.refinementBatchSize > 1
+      && configuration.refinementOptimizer == RefinementOptimizer::Lbfgs
+      && !configuration.deferHydrogens
+      && configuration.fragmentSize == 0
+      && statistics == nullptr
+    ) {
+      runParallelBatches(
+        numConformers,
+        seedOption,
+        molecule,
+        configuration,
+        DgDataPtr,
+        distanceBoundsResult.value(),
+        std::forward<Callback>(callback)
+      );
+      return;
+    }
+  }
 
-  /* If a seed is supplied, the global prng state is not to be advanced.
-   * We create a random engine from the seed here if a seed is supplied.
+  /* If only bond stereopermutators are unassigned, the modeling data apart
+   * from their dihedral information is shared between all conformers. The
+   * shared part is looser than any overlaid model, so if it is infeasible,
+   * so are all of them.
    */
-  auto engineOption = Temple::Optionals::map(
+  if(regenerateEachStep && SharedModel::applicable(molecule)) {
+    auto sharedModelPtr = std::make_shared<SharedModel>(molecule, configuration);
+    const auto feasibility = checkFeasibility(
+      molecule,
+      sharedModelPtr->bounds,
+      sharedModelPtr->chiralConstraints
+    );
+    if(!feasibility) {
+      reportFailure(numConformers, feasibility, callback);
+      return;
+    }
+
+    runParallel(
+      numConformers,
+      seedOption,
+      SharedModelConformerGenerator {
+        molecule,
+        configuration,
+        std::move(sharedModelPtr)
+      },
+      std::forward<Callback>(callback),
+      statistics
+    );
+    return;
+  }
+
+  runParallel(
+    numConformers,
     seedOption,
-    [](unsigned seed) { return Random::Engine(seed); }
+    MoleculeConformerGenerator {molecule, configuration, DgDataPtr, regenerateEachStep},
+    std::forward<Callback>(callback),
+    statistics
   );
+}
 
-  /* Now we need something referencing either our new engine or the global prng
-   * engine.
-   */
-  std::reference_wrapper<Random::Engine> backgroundEngineWrapper = randomnessEngine();
-  if(engineOption) {
-    backgroundEngineWrapper = engineOption.value();
+} // namespace Detail
+
+void run(
+  const Molecule& molecule,
+  const unsigned numConformers,
+  const Configuration& configuration,
+  const boost::optional<unsigned> seedOption,
+  const AngstromPositionsCallback& callback
+) {
+  Detail::runImpl(
+    molecule,
+    numConformers,
+    configuration,
+    seedOption,
+    [&](const unsigned i, const unsigned seed, outcome::result<AngstromPositions> result) -> bool {
+      callback(i, seed, std::move(result));
+      return true;
+    }
+  );
+}
+
+std::vector<
+  outcome::result<AngstromPositions>
+> run(
+  const Molecule& molecule,
+  const unsigned numConformers,
+  const Configuration& configuration,
+  const boost::optional<unsigned> seedOption
+) {
+  std::vector<
+    outcome::result<AngstromPositions>
+  > results(numConformers, static_cast<DgError>(0));
+
+  run(
+    molecule,
+    numConformers,
+    configuration,
+    seedOption,
+    [&](const unsigned i, unsigned /* seed */, outcome::result<AngstromPositions> result) {
+      results.at(i) = std::move(result);
+    }
+  );
+
+  return results;
+}
+
+std::vector<
+  std::pair<outcome::result<AngstromPositions>, RefinementStatistics>
+> runWithStatistics(
+  const Molecule& molecule,
+  const unsigned numConformers,
+  const Configuration& configuration,
+  const boost::optional<unsigned> seedOption
+) {
+  std::vector<RefinementStatistics> statistics(numConformers);
+  std::vector<
+    outcome::result<AngstromPositions>
+  > results(numConformers, static_cast<DgError>(0));
+
+  Detail::runImpl(
+    molecule,
+    numConformers,
+    configuration,
+    seedOption,
+    [&](const unsigned i, unsigned /* seed */, outcome::result<AngstromPositions> result) -> bool {
+      results.at(i) = std::move(result);
+      return true;
+    },
+    &statistics
+  );
+
+  std::vector<
+    std::pair<outcome::result<AngstromPositions>, RefinementStatistics>
+  > pairs;
+  pairs.reserve(numConformers);
+  for(unsigned i = 0; i < numConformers; ++i) {
+    pairs.emplace_back(std::move(results.at(i)), statistics.at(i));
   }
-  Random::Engine& backgroundEngine = backgroundEngineWrapper.get();
+  return pairs;
+}
 
-  /* We have to distribute pseudo-randomness into each thread reproducibly
-   * and want to avoid having to guard the global PRNG against access from
-   * multiple threads, so we provide each thread its own Engine and pre-generate
-   * each conformer's individual seed in the sequential section.
-   */
-#ifdef _OPENMP
-  const unsigned nThreads = omp_get_max_threads();
-#else
-  const unsigned nThreads = 1;
-#endif
-
-  std::vector<Random::Engine> randomnessEngines(nThreads);
-  const auto seeds = Temple::Random::getN<int>(
-    0,
-    std::numeric_limits<int>::max(),
+void run(
+  const PreparedModel& model,
+  const unsigned numConformers,
+  const boost::optional<unsigned> seedOption,
+  const AngstromPositionsCallback& callback
+) {
+  const PreparedModel::Impl& impl = model.impl();
+  if(
+    impl.configuration.refinementBatchSize > 1
+    && impl.configuration.refinementOptimizer == RefinementOptimizer::Lbfgs
+    && !impl.configuration.deferHydrogens
+    && impl.configuration.fragmentSize == 0
+    && impl.distanceBounds
+  ) {
+    Detail::runParallelBatches(
+      numConformers,
+      seedOption,
+      impl.molecule,
+      impl.configuration,
+      impl.data,
+      impl.distanceBounds.value(),
+      [&](const unsigned i, const unsigned seed, outcome::result<AngstromPositions> result) -> bool {
+        callback(i, seed, std::move(result));
+        return true;
+      }
+    );
+    return;
+  }
+
+  Detail::runParallel(
+    numConformers,
+    seedOption,
+    Detail::PreparedConformerGenerator {impl},
+    [&](const unsigned i, const unsigned seed, outcome::result<AngstromPositions> result) -> bool {
+      callback(i, seed, std::move(result));
+      return true;
+    }
+  );
+}
+
+std::vector<
+  outcome::result<AngstromPositions>
+> run(
+  const PreparedModel& model,
+  const unsigned numConformers,
+  const boost::optional<unsigned> seedOption
+) {
+  std::vector<
+    outcome::result<AngstromPositions>
+  > results(numConformers, static_cast<DgError>(0));
+
+  run(
+    model,
     numConformers,
-    backgroundEngine
+    seedOption,
+    [&](const unsigned i, unsigned /* seed */, outcome::result<AngstromPositions> result) {
+      results.at(i) = std::move(result);
+    }
   );
 
-  /* Each thread has its own DgDataPtr, for the following reason: If we do
-   * not need to regenerate the SpatialModel data, then having all threads
-   * share access the underlying data to generate conformers is fine. If,
-   * otherwise, we do need to regenerate the SpatialModel data for each
-   * conformer, then each thread will reset its pointer to its self-generated
-   * SpatialModel data, creating thread-private state.
+  return results;
+}
+
+outcome::result<
+  std::vector<AngstromPositions>
+> runUntilSuccesses(
+  const Molecule& molecule,
+  const unsigned numSuccesses,
+  const unsigned maxAttempts,
+  const Configuration& configuration,
+  const boost::optional<unsigned> seedOption
+) {
+  if(molecule.stereopermutators().hasZeroAssignmentStereopermutators()) {
+    Molassembler::Detail::Metrics::recordDgFailure(DgError::ZeroAssignmentStereopermutators);
+    return DgError::ZeroAssignmentStereopermutators;
+  }
+
+  /* Successes are collected alongside their attempt index. Attempts may
+   * finish out of order, so the successes with the lowest attempt indices
+   * are kept to match the result of a sequential run.
    */
-#pragma omp parallel for firstprivate(DgDataPtr) schedule(dynamic)
-  for(unsigned i = 0; i < numConformers; ++i) {
-    // Get thread-specific randomness engine reference
-#ifdef _OPENMP
-    Random::Engine& engine = randomnessEngines.at(
-      omp_get_thread_num()
+  std::vector<std::pair<unsigned, AngstromPositions>> successes;
+  successes.reserve(numSuccesses);
+
+  if(numSuccesses > 0) {
+    Detail::runImpl(
+      molecule,
+      maxAttempts,
+      configuration,
+      seedOption,
+      [&](const unsigned i, unsigned /* seed */, outcome::result<AngstromPositions> result) -> bool {
+        if(result) {
+          successes.emplace_back(i, std::move(result.value()));
+        }
+        return successes.size() < numSuccesses;
+      }
     );
-#else
-    Random::Engine& engine = randomnessEngines.front();
-#endif
+  }
 
-    // Re-seed the thread-local PRNG engine for each conformer
-    engine.seed(seeds.at(i));
+  std::sort(
+    std::begin(successes),
+    std::end(successes),
+    [](const auto& a, const auto& b) { return a.first < b.first; }
+  );
+
+  if(successes.size() > numSuccesses) {
+    successes.erase(std::begin(successes) + numSuccesses, std::end(successes));
+  }
+
+  std::vector<AngstromPositions> positions;
+  positions.reserve(successes.size());
+  for(auto& indexPositionsPair : successes) {
+    positions.push_back(std::move(indexPositionsPair.second));
+  }
+  return positions;
+}
+
+std::vector<
+  std::vector<outcome::result<AngstromPositions>>
+> runBatch(
+  const std::vector<Molecule>& molecules,
+  const std::vector<unsigned>& numConformers,
+  const Configuration& configuration,
+  const unsigned seed
+) {
+  if(molecules.size() != numConformers.size()) {
+    throw std::invalid_argument("Number of molecules and conformer counts do not match");
+  }
+
+  const unsigned M = molecules.size();
+  using ResultType = outcome::result<AngstromPositions>;
+  std::vector<std::vector<ResultType>> results(M);
+
+  /* Each molecule gets its own seed from which its conformers' seeds are
+   * derived as in run, so that each molecule's results are independent of the
+   * composition of the batch
+   */
+
+  std::vector<std::vector<int>> conformerSeeds(M);
+  std::vector<bool> regenerateEachStep(M, false);
+  std::vector<std::shared_ptr<MoleculeDGInformation>> dataPtrs(M);
+  std::vector<std::shared_ptr<const SharedModel>> sharedModelPtrs(M);
+  std::vector<std::pair<unsigned, unsigned>> workItems;
+
+  for(unsigned m = 0; m < M; ++m) {
+    const Molecule& molecule = molecules.at(m);
+    if(molecule.stereopermutators().hasZeroAssignmentStereopermutators()) {
+      results.at(m).resize(numConformers.at(m), DgError::ZeroAssignmentStereopermutators);
+      continue;
+    }
+
+    results.at(m).resize(numConformers.at(m), static_cast<DgError>(0));
+    regenerateEachStep.at(m) = molecule.stereopermutators().hasUnassignedStereopermutators();
+    dataPtrs.at(m) = std::make_shared<MoleculeDGInformation>();
+    conformerSeeds.at(m) = Detail::conformerSeeds(
+      numConformers.at(m),
+      static_cast<unsigned>(Random::streamSeed(seed, m))
+    );
+
+    for(unsigned i = 0; i < numConformers.at(m); ++i) {
+      workItems.emplace_back(m, i);
+    }
+  }
+
+  /* Spatial models of molecules not requiring regeneration for each conformer
+   * are gathered in parallel ahead of conformer generation
+   */
+  std::mutex outputMutex;
+  std::vector<char> infeasible(M, false);
+  Parallel::forEach(M, [&](const unsigned m, unsigned /* worker */) {
+    if(!dataPtrs.at(m)) {
+      return;
+    }
 
-    /* We have to handle any and all exceptions here bceause this is a parallel
-     * environment and exceptions are not propagated anywhere
-     */
     try {
-      // Generate the conformer
-      auto conformerResult = generateConformer(
+      outcome::result<DistanceBoundsMatrix> feasibility = DistanceBoundsMatrix {};
+      if(!regenerateEachStep.at(m)) {
+        *dataPtrs.at(m) = gatherDGInformation(molecules.at(m), configuration);
+        feasibility = checkFeasibility(molecules.at(m), *dataPtrs.at(m));
+      } else if(SharedModel::applicable(molecules.at(m))) {
+        sharedModelPtrs.at(m) = std::make_shared<SharedModel>(molecules.at(m), configuration);
+        feasibility = checkFeasibility(
+          molecules.at(m),
+          sharedModelPtrs.at(m)->bounds,
+          sharedModelPtrs.at(m)->chiralConstraints
+        );
+      }
+
+      // Infeasible models fail all of their conformers without attempting any
+      if(!feasibility) {
+        infeasible.at(m) = true;
+        for(auto& result : results.at(m)) {
+          result = feasibility.as_failure();
+        }
+      }
+    } catch(std::exception& e) {
+      std::lock_guard<std::mutex> lock(outputMutex);
+      std::cerr << "WARNING: Uncaught exception in spatial modeling: " << e.what() << "\n";
+      dataPtrs.at(m).reset();
+    }
+  });
+
+  const auto executor = Parallel::executor();
+  Parallel::WorkerLocal<Random::Engine> randomnessEngines {*executor, Random::Engine {}};
+
+  // All conformers of all molecules are distributed over the same workers
+  const unsigned W = workItems.size();
+  Parallel::forEach(*executor, W, [&](const unsigned w, const unsigned worker) {
+    const unsigned m = workItems.at(w).first;
+    const unsigned i = workItems.at(w).second;
+
+    if(!dataPtrs.at(m)) {
+      results.at(m).at(i) = DgError::UnknownException;
+      return;
+    }
+
+    if(infeasible.at(m)) {
+      return;
+    }
+
+    Random::Engine& engine = randomnessEngines[worker];
+    engine.seed(conformerSeeds.at(m).at(i));
+
+    // Regeneration replaces the pointer, so each item works on its own copy
+    auto DgDataPtr = dataPtrs.at(m);
+
+    try {
+      if(sharedModelPtrs.at(m)) {
+        results.at(m).at(i) = generateConformer(
+          molecules.at(m),
+          configuration,
+          *sharedModelPtrs.at(m),
+          engine
+        );
+      } else {
+        results.at(m).at(i) = generateConformer(
+          molecules.at(m),
+          configuration,
+          DgDataPtr,
+          regenerateEachStep.at(m),
+          engine
+        );
+      }
+    } catch(std::exception& e) {
+      std::lock_guard<std::mutex> lock(outputMutex);
+      std::cerr << "WARNING: Uncaught exception in conformer generation: " << e.what() << "\n";
+      results.at(m).at(i) = DgError::UnknownException;
+    }
+  });
+
+  for(const auto& moleculeResults : results) {
+    for(const auto& result : moleculeResults) {
+      Detail::recordFailure(result);
+    }
+  }
+
+  return results;
+}
+
+std::vector<
+  std::vector<outcome::result<AngstromPositions>>
+> runFixedPositionBatch(
+  const Molecule& molecule,
+  const std::vector<Configuration::FixedPositions>& fixedPositionSets,
+  const unsigned numConformers,
+  const Configuration& configuration,
+  const unsigned seed
+) {
+  const unsigned S = fixedPositionSets.size();
+  if(S > 0) {
+    const auto fixedAtoms = Temple::sorted(Temple::map(fixedPositionSets.front(), Temple::Functor::first));
+    for(const auto& fixedPositions : fixedPositionSets) {
+      if(Temple::sorted(Temple::map(fixedPositions, Temple::Functor::first)) != fixedAtoms) {
+        throw std::invalid_argument("Fixed position sets do not fix the same atoms");
+      }
+    }
+  }
+
+  using ResultType = outcome::result<AngstromPositions>;
+  std::vector<std::vector<ResultType>> results(S);
+
+  if(molecule.stereopermutators().hasZeroAssignmentStereopermutators()) {
+    for(auto& setResults : results) {
+      setResults.resize(numConformers, DgError::ZeroAssignmentStereopermutators);
+      for(const auto& result : setResults) {
+        Detail::recordFailure(result);
+      }
+    }
+    return results;
+  }
+
+  /* Each set of fixed positions gets its own seed from which its conformers'
+   * seeds are derived as in run
+   */
+  const bool regenerateEachStep = molecule.stereopermutators().hasUnassignedStereopermutators();
+  std::vector<Configuration> configurations(S, configuration);
+  std::vector<std::vector<int>> conformerSeeds(S);
+  std::vector<std::shared_ptr<MoleculeDGInformation>> dataPtrs(S);
+  for(unsigned s = 0; s < S; ++s) {
+    results.at(s).resize(numConformers, static_cast<DgError>(0));
+    configurations.at(s).fixedPositions = fixedPositionSets.at(s);
+    conformerSeeds.at(s) = Detail::conformerSeeds(
+      numConformers,
+      static_cast<unsigned>(Random::streamSeed(seed, s))
+    );
+  }
+
+  /* Only the bounds between fixed atoms depend on their positions. The
+   * molecule is modeled once and the model of each set of positions is derived
+   * from it in parallel. Molecules requiring regeneration for each conformer
+   * are modeled for each conformer instead.
+   */
+  std::mutex outputMutex;
+  std::vector<char> infeasible(S, false);
+  if(regenerateEachStep) {
+    for(auto& dataPtr : dataPtrs) {
+      dataPtr = std::make_shared<MoleculeDGInformation>();
+    }
+  } else if(S > 0) {
+    try {
+      const SpatialModel reference {molecule, configurations.front()};
+      Parallel::forEach(S, [&](const unsigned s, unsigned /* worker */) {
+        try {
+          SpatialModel spatialModel = reference;
+          spatialModel.replaceFixedPositions(fixedPositionSets.at(s));
+          dataPtrs.at(s) = std::make_shared<MoleculeDGInformation>(
+            gatherDGInformation(spatialModel, molecule)
+          );
+
+          // Infeasible models fail all of their conformers without attempting any
+          auto feasibility = checkFeasibility(molecule, *dataPtrs.at(s));
+          if(!feasibility) {
+            infeasible.at(s) = true;
+            for(auto& result : results.at(s)) {
+              result = feasibility.as_failure();
+            }
+          }
+        } catch(std::exception& e) {
+          std::lock_guard<std::mutex> lock(outputMutex);
+          std::cerr << "WARNING: Uncaught exception in spatial modeling: " << e.what() << "\n";
+          dataPtrs.at(s).reset();
+        }
+      });
+    } catch(std::exception& e) {
+      std::cerr << "WARNING: Uncaught exception in spatial modeling: " << e.what() << "\n";
+    }
+  }
+
+  const auto executor = Parallel::executor();
+  Parallel::WorkerLocal<Random::Engine> randomnessEngines {*executor, Random::Engine {}};
+
+  // All conformers of all sets are distributed over the same workers
+  const unsigned W = S * numConformers;
+  Parallel::forEach(*executor, W, [&](const unsigned w, const unsigned worker) {
+    const unsigned s = w / numConformers;
+    const unsigned i = w % numConformers;
+
+    if(!dataPtrs.at(s)) {
+      results.at(s).at(i) = DgError::UnknownException;
+      return;
+    }
+
+    if(infeasible.at(s)) {
+      return;
+    }
+
+    Random::Engine& engine = randomnessEngines[worker];
+    engine.seed(conformerSeeds.at(s).at(i));
+
+    // Regeneration replaces the pointer, so each item works on its own copy
+    auto DgDataPtr = dataPtrs.at(s);
+
+    try {
+      results.at(s).at(i) = generateConformer(
         molecule,
-        configuration,
+        configurations.at(s),
         DgDataPtr,
         regenerateEachStep,
         engine
       );
-
-      results.at(i) = std::move(conformerResult);
     } catch(std::exception& e) {
-#pragma omp critical(outputWarning)
-      {
-        std::cerr << "WARNING: Uncaught exception in conformer generation: " << e.what() << "\n";
-      }
-      results.at(i) = DgError::UnknownException;
-    } // end catch
-  } // end pragma omp for private(DgDataPtr)
+      std::lock_guard<std::mutex> lock(outputMutex);
+      std::cerr << "WARNING: Uncaught exception in conformer generation: " << e.what() << "\n";
+      results.at(s).at(i) = DgError::UnknownException;
+    }
+  });
+
+  for(const auto& setResults : results) {
+    for(const auto& result : setResults) {
+      Detail::recordFailure(result);
+    }
+  }
 
   return results;
 }
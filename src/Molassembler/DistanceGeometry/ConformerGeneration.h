@@ -14,6 +14,8 @@
 #include "Molassembler/DistanceGeometry/SpatialModel.h"
 #include "Molassembler/Log.h"
 
+#include <functional>
+
 namespace Scine {
 namespace Molassembler {
 
@@ -65,6 +67,18 @@ Eigen::MatrixXd fitAndSetFixedPositions(
  */
 Molecule narrow(Molecule molecule, Random::Engine& engine);
 
+/*! @brief Diagonal refinement preconditioner from squared distance bounds
+ *
+ * Distance terms near their upper bound @math{u} contribute curvature
+ * proportional to @math{u^{-2}} to both atoms. Each atom's four vectorized
+ * coordinates are preconditioned by the inverse of its summed curvature.
+ *
+ * @param squaredBounds Squared upper bounds in the strict upper triangle
+ *
+ * @complexity{@math{\Theta(N^2)}}
+ */
+Eigen::VectorXd refinementPreconditioner(const Eigen::MatrixXd& squaredBounds);
+
 } // namespace Detail
 
 //! Intermediate conformational data about a Molecule given by a spatial model
@@ -82,7 +96,8 @@ struct MoleculeDGInformation {
     const Molecule& molecule
   );
 
-  SpatialModel::BoundsMatrix bounds;
+  //! Explicit unsmoothed atom-pairwise distance bounds
+  SpatialModel::SparseBoundsMatrix bounds;
   std::vector<ChiralConstraint> chiralConstraints;
   std::vector<DihedralConstraint> dihedralConstraints;
   GroupMapType rotatableGroups;
@@ -99,11 +114,244 @@ MoleculeDGInformation gatherDGInformation(
   const Configuration& configuration
 );
 
-//! @brief Distance Geometry refinement
+/*! @brief Collects intermediate conformational data about a Molecule from an
+ *   existing spatial model
+ *
+ * @complexity{Linear in the size of the spatial model}
+ */
+MoleculeDGInformation gatherDGInformation(
+  const SpatialModel& spatialModel,
+  const Molecule& molecule
+);
+
+namespace Detail {
+
+/*! @brief Terminal hydrogens whose placement can be deferred until the
+ *   remaining atoms are refined
+ *
+ * Hydrogens are deferrable if they are bonded only to an atom other than
+ * hydrogen and are not part of any chiral or dihedral constraint.
+ *
+ * @complexity{Linear in the number of atoms and constraint sites}
+ */
+std::vector<AtomIndex> deferrableHydrogens(
+  const PrivateGraph& inner,
+  const MoleculeDGInformation& data
+);
+
+/*! @brief Splits a molecule into connected fragments along bridges
+ *
+ * Bonds outside of cycles between atoms with further bonds split a molecule
+ * into rigid parts. Starting from the largest part, parts join the fragment
+ * of the part they are bonded to as long as it has at most @p fragmentSize
+ * atoms, and start a new fragment otherwise. Each fragment after the first
+ * also contains the atom of an earlier fragment it is bonded to and that
+ * atom's neighbors in that fragment, so that it can be fitted onto it.
+ *
+ * @param inner Molecular graph
+ * @param excluded Atoms not part of any fragment, e.g. deferred hydrogens
+ * @param fragmentSize Atom count up to which parts are merged into a fragment
+ *
+ * @complexity{Linear in the number of atoms and bonds}
+ *
+ * @returns Atoms of each fragment in ascending order. Each fragment overlaps
+ *   with a fragment before it.
+ */
+std::vector<std::vector<AtomIndex>> fragment(
+  const PrivateGraph& inner,
+  const std::vector<AtomIndex>& excluded,
+  unsigned fragmentSize
+);
+
+/*! @brief Places deferred hydrogens from the local geometry of the atoms they
+ *   are bonded to
+ *
+ * Hydrogens bonded to the same atom are spread on a cone around the
+ * direction opposite its other bonds. Bond lengths and the cone's opening
+ * are taken from the middle of the distance bounds.
+ *
+ * @param positions Four-dimensional positions in angstrom, one atom per
+ *   column. Columns of atoms other than @p hydrogens must be set.
+ * @param inner Molecular graph
+ * @param hydrogens Deferrable hydrogens
+ * @param bounds Smoothed distance bounds of all atoms
+ *
+ * @complexity{Linear in the number of deferred hydrogens and their
+ * neighbors' bonds}
+ */
+void placeHydrogens(
+  Eigen::Ref<Eigen::MatrixXd> positions,
+  const PrivateGraph& inner,
+  const std::vector<AtomIndex>& hydrogens,
+  const DistanceBoundsMatrix& bounds
+);
+
+/*! @brief Chooses the number of smoothed atoms of adaptive partiality
+ *
+ * Candidates are the smoothed atom counts of four-atom, ten-percent, quarter
+ * and full partiality. Each candidate's success rate and time per conformer
+ * are estimated from recorded outcomes and prior pseudo-observations. Prior
+ * times are proportional to the number of smoothed atoms plus the number of
+ * atoms, scaled by the times recorded for any candidate. Prior failure rates
+ * grow the fewer atoms are smoothed and the smaller the mean relative gap
+ * between lower and upper distance bounds is.
+ */
+class AdaptivePartiality {
+public:
+  //! Number of prior pseudo-observations per candidate
+  static constexpr double priorWeight = 4;
+  //! Prior failure rate without smoothing between coinciding bounds
+  static constexpr double maximumPriorFailureRate = 0.8;
+
+  /*! @brief Sets up candidates and priors from smoothed distance bounds
+   *
+   * @complexity{@math{\Theta(N^2)}}
+   */
+  explicit AdaptivePartiality(const DistanceBoundsMatrix& bounds);
+
+  /*! @brief Smoothed atom count of the most estimated successful conformers
+   *   per second
+   *
+   * Ties are broken in favor of fewer smoothed atoms.
+   */
+  unsigned choose() const;
+
+  /*! @brief Records the outcome of a conformer generated with a candidate
+   *
+   * @param smoothedAtoms Smoothed atom count returned by choose()
+   * @param seconds Time spent generating the conformer
+   * @param success Whether the conformer was refined successfully
+   */
+  void record(unsigned smoothedAtoms, double seconds, bool success);
+
+  //! Estimated probability that a conformer is refined successfully
+  double successRate(unsigned candidate) const;
+  //! Estimated time per conformer in seconds
+  double seconds(unsigned candidate) const;
+
+  //! Candidate smoothed atom counts in ascending order
+  const std::vector<unsigned>& candidates() const {
+    return atoms_;
+  }
+
+private:
+  unsigned N_;
+  std::vector<unsigned> atoms_;
+  std::vector<double> priorFailureRates_;
+  std::vector<unsigned> attempts_;
+  std::vector<unsigned> successes_;
+  std::vector<double> totalSeconds_;
+};
+
+} // namespace Detail
+
+/*! @brief Modeling data shared between conformers of a molecule whose only
+ *   unassigned stereopermutators are bond stereopermutators
+ *
+ * Models the molecule once with the unassigned bond stereopermutators'
+ * dihedral information deferred, and models the dihedral information of each
+ * of their assignments once on construction. The modeling data of each
+ * randomly narrowed molecule then only requires overlaying the dihedral
+ * information of its assignments on the shared part.
+ */
+struct SharedModel {
+  /*! @brief Whether a molecule's unassigned stereopermutators are all bond
+   *   stereopermutators
+   *
+   * @complexity{@math{\Theta(S)} in the number of stereopermutators}
+   */
+  static bool applicable(const Molecule& molecule);
+
+  /*! @brief Models the assignment-independent part of a molecule
+   *
+   * @complexity{As SpatialModel construction and once more per assignment of
+   * each unassigned bond stereopermutator}
+   *
+   * @pre applicable(molecule)
+   */
+  SharedModel(const Molecule& molecule, const Configuration& configuration);
+
+  /*! @brief Overlays a narrowed molecule's bond stereopermutator assignments
+   *
+   * @complexity{Linear in the number of explicit bounds}
+   *
+   * @param narrowed The molecule passed at construction after narrowing
+   *
+   * @returns None if narrowing altered any stereopermutators beyond assigning
+   *   the deferred bond stereopermutators, e.g. by ranking changes. Such
+   *   molecules have to be modeled in full.
+   */
+  boost::optional<MoleculeDGInformation> overlay(const Molecule& narrowed) const;
+
+  //! Stereopermutators of the molecule before narrowing
+  StereopermutatorList stereopermutators;
+  //! Bonds of the unassigned bond stereopermutators
+  std::vector<BondIndex> deferredBonds;
+  //! Explicit distance bounds without the deferred dihedral information
+  SpatialModel::SparseBoundsMatrix bounds;
+  std::vector<ChiralConstraint> chiralConstraints;
+  std::vector<DihedralConstraint> dihedralConstraints;
+  //! Indexed by deferred bond, then by assignment
+  std::vector<
+    std::vector<SpatialModel::DihedralOverlay>
+  > overlays;
+};
+
+/*! @brief Diagnoses spatial models that cannot yield any conformer
+ *
+ * Smooths the explicit distance bounds by triangle inequalities, checks the
+ * smoothed bounds for inconsistencies and checks whether the target volumes
+ * of chiral constraints are attainable within the smoothed distance bounds.
+ * Passing does not guarantee that conformers can be generated, but failing
+ * guarantees that none can be, so shared models are checked once before any
+ * conformer is attempted.
+ *
+ * @complexity{As ExplicitBoundsGraph::makeDistanceBounds}
+ *
+ * @returns The smoothed distance bounds or DgError::GraphImpossible
+ */
+outcome::result<DistanceBoundsMatrix> checkFeasibility(
+  const Molecule& molecule,
+  const SpatialModel::SparseBoundsMatrix& bounds,
+  const std::vector<ChiralConstraint>& chiralConstraints
+);
+
+//! @overload
+inline outcome::result<DistanceBoundsMatrix> checkFeasibility(
+  const Molecule& molecule,
+  const MoleculeDGInformation& data
+) {
+  return checkFeasibility(molecule, data.bounds, data.chiralConstraints);
+}
+
+/*! @brief Distance Geometry refinement
+ *
+ * Records convergence data into @p statistics unless it is nullptr.
+ */
 outcome::result<AngstromPositions> refine(
   Eigen::MatrixXd embeddedPositions,
   const DistanceBoundsMatrix& distanceBounds,
   const Configuration& configuration,
+  const std::shared_ptr<MoleculeDGInformation>& DgDataPtr,
+  RefinementStatistics* statistics = nullptr
+);
+
+/*! @brief Lock-step Distance Geometry refinement of multiple embeddings of
+ *   the same molecule
+ *
+ * Each refinement stage minimizes all embeddings still being refined
+ * together, evaluating their distance terms in a single pass over the
+ * distance bounds.
+ *
+ * @complexity{Per refinement iteration, @math{\Theta(KN^2)} for @math{K}
+ * embeddings of @math{N} atoms}
+ */
+std::vector<
+  outcome::result<AngstromPositions>
+> refineBatch(
+  const std::vector<Eigen::MatrixXd>& embeddedPositions,
+  const DistanceBoundsMatrix& distanceBounds,
+  const Configuration& configuration,
   const std::shared_ptr<MoleculeDGInformation>& DgDataPtr
 );
 
@@ -113,7 +361,87 @@ outcome::result<AngstromPositions> generateConformer(
   const Configuration& configuration,
   std::shared_ptr<MoleculeDGInformation>& DgDataPtr,
   bool regenerateDGDataEachStep,
-  Random::Engine& engine
+  Random::Engine& engine,
+  RefinementStatistics* statistics = nullptr
+);
+
+/*! @brief Individual conformer generation routine narrowing a molecule and
+ *   overlaying its assignments on shared modeling data
+ */
+outcome::result<AngstromPositions> generateConformer(
+  const Molecule& molecule,
+  const Configuration& configuration,
+  const SharedModel& sharedModel,
+  Random::Engine& engine,
+  RefinementStatistics* statistics = nullptr
+);
+
+//! @brief Individual conformer generation routine from smoothed distance bounds
+outcome::result<AngstromPositions> generateConformer(
+  const Molecule& molecule,
+  const Configuration& configuration,
+  const std::shared_ptr<MoleculeDGInformation>& DgDataPtr,
+  const DistanceBoundsMatrix& distanceBounds,
+  Random::Engine& engine,
+  RefinementStatistics* statistics = nullptr
+);
+
+//! Data of a prepared spatial model
+struct PreparedModel::Impl {
+  /*! @brief Models a molecule and smoothes its distance bounds
+   *
+   * @throws std::logic_error If the molecule has unassigned or
+   *   zero-assignment stereopermutators
+   */
+  Impl(Molecule passMolecule, Configuration passConfiguration);
+
+  //! Adopts existing modeling data, smoothing the distance bounds if needed
+  Impl(
+    Molecule passMolecule,
+    Configuration passConfiguration,
+    std::shared_ptr<MoleculeDGInformation> passData,
+    boost::optional<DistanceBoundsMatrix> smoothedBounds
+  );
+
+  Molecule molecule;
+  Configuration configuration;
+  std::shared_ptr<MoleculeDGInformation> data;
+  //! Smoothed distance bounds, or the reason smoothing failed
+  outcome::result<DistanceBoundsMatrix> distanceBounds;
+};
+
+/*! @brief Receives finished conformers during streaming ensemble generation
+ *
+ * Arguments are the index of the conformer within the ensemble, the seed the
+ * conformer's PRNG engine was seeded with, and the conformer generation
+ * result.
+ */
+using AngstromPositionsCallback = std::function<
+  void(unsigned, unsigned, outcome::result<AngstromPositions>)
+>;
+
+/** @brief Main and parallel implementation of Distance Geometry. Generates an
+ *   ensemble of 3D structures of a given Molecule and passes each to a
+ *   callback as soon as it is finished
+ *
+ * Conformers are not kept beyond the callback invocation, so memory
+ * requirements scale with the number of threads instead of the number of
+ * conformers.
+ *
+ * @complexity{Roughly @math{O(C \cdot N^3)} where @math{C} is the number of
+ * conformers and @math{N} is the number of atoms in @p molecule}
+ *
+ * @note Invocations of @p callback are serialized, but not sequenced by
+ *   conformer index. Exceptions thrown by @p callback are rethrown after all
+ *   threads have finished, and no further callbacks are made once one has
+ *   thrown.
+ */
+void run(
+  const Molecule& molecule,
+  unsigned numConformers,
+  const Configuration& configuration,
+  boost::optional<unsigned> seedOption,
+  const AngstromPositionsCallback& callback
 );
 
 /** @brief Main and parallel implementation of Distance Geometry. Generates an
@@ -133,6 +461,119 @@ std::vector<
   boost::optional<unsigned> seedOption
 );
 
+/** @brief Generates an ensemble of 3D structures of a given Molecule and
+ *   collects refinement statistics for each
+ *
+ * @complexity{Roughly @math{O(C \cdot N^3)} where @math{C} is the number of
+ * conformers and @math{N} is the number of atoms in @p molecule}
+ *
+ * @see run
+ */
+std::vector<
+  std::pair<outcome::result<AngstromPositions>, RefinementStatistics>
+> runWithStatistics(
+  const Molecule& molecule,
+  unsigned numConformers,
+  const Configuration& configuration,
+  boost::optional<unsigned> seedOption
+);
+
+/** @brief Generates an ensemble of 3D structures from a prepared spatial model
+ *   and passes each to a callback as soon as it is finished
+ *
+ * @complexity{Roughly @math{O(C \cdot N^3)} where @math{C} is the number of
+ * conformers and @math{N} is the number of atoms}
+ *
+ * @see run
+ */
+void run(
+  const PreparedModel& model,
+  unsigned numConformers,
+  boost::optional<unsigned> seedOption,
+  const AngstromPositionsCallback& callback
+);
+
+/** @brief Generates an ensemble of 3D structures from a prepared spatial model
+ *
+ * @complexity{Roughly @math{O(C \cdot N^3)} where @math{C} is the number of
+ * conformers and @math{N} is the number of atoms}
+ *
+ * @see run
+ */
+std::vector<
+  outcome::result<AngstromPositions>
+> run(
+  const PreparedModel& model,
+  unsigned numConformers,
+  boost::optional<unsigned> seedOption
+);
+
+/** @brief Generates conformers until a target number of them are successful
+ *   or an attempt budget is exhausted
+ *
+ * Attempts are distributed over threads as in run. Once enough successes are
+ * collected, all threads skip their remaining attempts.
+ *
+ * @complexity{Roughly @math{O(A \cdot N^3)} where @math{A} is the number of
+ * attempts needed and @math{N} is the number of atoms in @p molecule}
+ *
+ * @returns Up to @p numSuccesses refined structures, ordered by the attempt
+ *   they resulted from, or DgError::ZeroAssignmentStereopermutators
+ */
+outcome::result<
+  std::vector<AngstromPositions>
+> runUntilSuccesses(
+  const Molecule& molecule,
+  unsigned numSuccesses,
+  unsigned maxAttempts,
+  const Configuration& configuration,
+  boost::optional<unsigned> seedOption
+);
+
+/** @brief Generates ensembles for multiple molecules, distributing all
+ *   conformers of all molecules over the same threads
+ *
+ * Each molecule's conformers are seeded from a per-molecule seed drawn from
+ * @p seed, so results for a molecule do not depend on which other molecules
+ * are part of the batch.
+ *
+ * @complexity{Roughly @math{O(\sum_m C_m \cdot N_m^3)}}
+ *
+ * @throws std::invalid_argument If the number of molecules and conformer
+ *   counts do not match
+ */
+std::vector<
+  std::vector<outcome::result<AngstromPositions>>
+> runBatch(
+  const std::vector<Molecule>& molecules,
+  const std::vector<unsigned>& numConformers,
+  const Configuration& configuration,
+  unsigned seed
+);
+
+/** @brief Generates ensembles for a molecule with multiple sets of fixed
+ *   positions of the same atoms, distributing all conformers over the same
+ *   threads
+ *
+ * The molecule is modeled once. The model of each set of fixed positions is
+ * derived from it by replacing the information modeled from fixed positions.
+ * Each set's conformers are seeded from a per-set seed drawn from @p seed.
+ * The fixed positions of @p configuration are replaced by each set.
+ *
+ * @complexity{Roughly @math{O(S \cdot C \cdot N^3)}}
+ *
+ * @throws std::invalid_argument If the sets do not fix the same atoms
+ */
+std::vector<
+  std::vector<outcome::result<AngstromPositions>>
+> runFixedPositionBatch(
+  const Molecule& molecule,
+  const std::vector<Configuration::FixedPositions>& fixedPositionSets,
+  unsigned numConformers,
+  const Configuration& configuration,
+  unsigned seed
+);
+
 } // namespace DistanceGeometry
 } // namespace Molassembler
 } // namespace Scine
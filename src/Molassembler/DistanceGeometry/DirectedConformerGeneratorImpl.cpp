@@ -6,8 +6,12 @@
 #include "Molassembler/DistanceGeometry/DirectedConformerGeneratorImpl.h"
 
 #include "Molassembler/Cycles.h"
+#include "Molassembler/Detail/Cartesian.h"
 #include "Molassembler/Molecule/MoleculeImpl.h"
 #include "Molassembler/Graph.h"
+#include "Molassembler/Graph/PrivateGraph.h"
+#include "Molassembler/Options.h"
+#include "Molassembler/Parallel.h"
 #include "Molassembler/StereopermutatorList.h"
 
 #include "Molassembler/Stereopermutation/Composites.h"
@@ -15,11 +19,22 @@
 #include "Molassembler/Temple/Functional.h"
 #include "Molassembler/Temple/Optionals.h"
 #include "Molassembler/Temple/Random.h"
+#include "Molassembler/DistanceGeometry/ConformerGeneration.h"
 #include "Molassembler/DistanceGeometry/Error.h"
+#include "Molassembler/DistanceGeometry/ExplicitBoundsGraph.h"
 
+#include "Utils/Constants.h"
 #include "Utils/Geometry/AtomCollection.h"
+#include "boost/filesystem.hpp"
 #include "boost/variant.hpp"
 
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <exception>
+#include <fstream>
+#include <mutex>
+
 namespace Scine {
 namespace Molassembler {
 namespace Detail {
@@ -109,8 +124,84 @@ struct BoundedNodeTrieChooseFunctor {
   }
 };
 
+/*!
+ * @brief Decodes an index into the decision space as a mixed-radix number
+ *
+ * Indices in [0, product of bounds) map onto all distinct decision lists.
+ */
+DirectedConformerGenerator::DecisionList decodeDecisionList(
+  unsigned index,
+  const DirectedConformerGenerator::DecisionList& bounds
+) {
+  DirectedConformerGenerator::DecisionList decisionList(bounds.size());
+  for(unsigned i = 0; i < bounds.size(); ++i) {
+    decisionList.at(i) = index % bounds.at(i);
+    index /= bounds.at(i);
+  }
+  return decisionList;
+}
+
+unsigned encodeDecisionList(
+  const DirectedConformerGenerator::DecisionList& decisionList,
+  const DirectedConformerGenerator::DecisionList& bounds
+) {
+  unsigned index = 0;
+  for(unsigned i = bounds.size(); i-- > 0;) {
+    index = index * bounds.at(i) + decisionList.at(i);
+  }
+  return index;
+}
+
+//! Appends an unsigned integer in a variable number of bytes (LEB128)
+void writeVarint(std::string& bytes, std::uint64_t value) {
+  while(value >= 0x80) {
+    bytes.push_back(static_cast<char>((value & 0x7F) | 0x80));
+    value >>= 7;
+  }
+  bytes.push_back(static_cast<char>(value));
+}
+
+//! Reads an unsigned integer written by writeVarint, advancing @p position
+std::uint64_t readVarint(const std::string& bytes, std::size_t& position) {
+  std::uint64_t value = 0;
+  for(unsigned shift = 0; shift < 64; shift += 7) {
+    if(position >= bytes.size()) {
+      throw std::runtime_error("Checkpoint is truncated");
+    }
+    const auto byte = static_cast<unsigned char>(bytes[position++]);
+    value |= static_cast<std::uint64_t>(byte & 0x7F) << shift;
+    if((byte & 0x80) == 0) {
+      return value;
+    }
+  }
+  throw std::runtime_error("Checkpoint contains malformed integer");
+}
+
+/* Atom pairs of rigidly rotated structures closer than this fraction of
+ * their lower distance bound are clashing
+ */
+constexpr double clashFraction = 0.5;
+
+//! Identifies checkpoint files and their format version
+const std::string checkpointMagic {"MASMDCG\x01"};
+
 } // namespace Detail
 
+std::pair<unsigned, unsigned> DirectedConformerGenerator::Impl::shard(
+  const unsigned size,
+  const unsigned count,
+  const unsigned index
+) {
+  if(count == 0 || index >= count) {
+    throw std::invalid_argument("Shard index must be smaller than a nonzero shard count");
+  }
+
+  const auto boundary = [&](const unsigned i) -> unsigned {
+    return static_cast<std::uint64_t>(size) * i / count;
+  };
+  return {boundary(index), boundary(index + 1)};
+}
+
 unsigned DirectedConformerGenerator::Impl::distance(
   const DecisionList& a,
   const DecisionList& b,
@@ -295,10 +386,121 @@ DirectedConformerGenerator::Impl::generateNewDecisionList(Random::Engine& engine
     throw std::logic_error("List of relevant bonds is empty!");
   }
 
+  if(!rankedAssignments_.empty()) {
+    DecisionList decisionList;
+    do {
+      if(decisionFrontier_.empty()) {
+        throw std::logic_error("All decision lists have been generated");
+      }
+      decisionList = popDecisionFrontier();
+    } while(!decisionLists_.insert(decisionList));
+
+    return decisionList;
+  }
+
   Detail::BoundedNodeTrieChooseFunctor<std::uint8_t> chooseFunctor {engine};
   return decisionLists_.generateNewEntry(chooseFunctor);
 }
 
+void DirectedConformerGenerator::Impl::setDecisionCosts(
+  const std::vector<std::vector<double>>& costs
+) {
+  rankedAssignments_.clear();
+  if(costs.empty()) {
+    resetDecisionFrontier();
+    return;
+  }
+
+  const DecisionList bounds = decisionLists_.bounds();
+  if(costs.size() != bounds.size()) {
+    throw std::invalid_argument("Decision costs do not match number of relevant bonds");
+  }
+
+  std::vector<std::vector<std::pair<double, std::uint8_t>>> ranked;
+  ranked.reserve(costs.size());
+  for(unsigned i = 0; i < costs.size(); ++i) {
+    if(costs.at(i).size() != bounds.at(i)) {
+      throw std::invalid_argument("Decision costs do not match number of bond assignments");
+    }
+
+    std::vector<std::pair<double, std::uint8_t>> bondAssignments;
+    bondAssignments.reserve(bounds.at(i));
+    for(unsigned j = 0; j < bounds.at(i); ++j) {
+      if(std::isnan(costs.at(i).at(j))) {
+        throw std::invalid_argument("Decision costs may not be NaN");
+      }
+      bondAssignments.emplace_back(costs.at(i).at(j), j);
+    }
+    std::sort(std::begin(bondAssignments), std::end(bondAssignments));
+    ranked.push_back(std::move(bondAssignments));
+  }
+
+  rankedAssignments_ = std::move(ranked);
+  resetDecisionFrontier();
+}
+
+void DirectedConformerGenerator::Impl::setDecisionCosts(const AssignmentCost& cost) {
+  const DecisionList bounds = decisionLists_.bounds();
+  std::vector<std::vector<double>> costs(bounds.size());
+  for(unsigned i = 0; i < bounds.size(); ++i) {
+    costs.at(i).reserve(bounds.at(i));
+    for(unsigned j = 0; j < bounds.at(i); ++j) {
+      costs.at(i).push_back(cost(i, j));
+    }
+  }
+  setDecisionCosts(costs);
+}
+
+void DirectedConformerGenerator::Impl::resetDecisionFrontier() {
+  decisionFrontier_ = DecisionFrontier {};
+  if(rankedAssignments_.empty()) {
+    return;
+  }
+
+  DecisionCandidate root {0.0, DecisionList(rankedAssignments_.size(), 0)};
+  for(const auto& bondAssignments : rankedAssignments_) {
+    root.cost += bondAssignments.front().first;
+  }
+  decisionFrontier_.push(std::move(root));
+}
+
+DirectedConformerGenerator::DecisionList
+DirectedConformerGenerator::Impl::popDecisionFrontier() {
+  const DecisionCandidate candidate = decisionFrontier_.top();
+  decisionFrontier_.pop();
+
+  const unsigned B = candidate.ranks.size();
+  unsigned lastNonzero = 0;
+  for(unsigned i = 0; i < B; ++i) {
+    if(candidate.ranks.at(i) > 0) {
+      lastNonzero = i;
+    }
+  }
+
+  /* Incrementing only ranks at or after the last nonzero rank makes the
+   * successor sets of all candidates disjoint, so no candidate is pushed
+   * twice. Costs are sorted ascending, so successors never cost less.
+   */
+  for(unsigned i = lastNonzero; i < B; ++i) {
+    const auto& bondAssignments = rankedAssignments_.at(i);
+    const unsigned rank = candidate.ranks.at(i);
+    if(rank + 1 < bondAssignments.size()) {
+      DecisionCandidate successor {0.0, candidate.ranks};
+      successor.ranks.at(i) += 1;
+      for(unsigned j = 0; j < B; ++j) {
+        successor.cost += rankedAssignments_.at(j).at(successor.ranks.at(j)).first;
+      }
+      decisionFrontier_.push(std::move(successor));
+    }
+  }
+
+  DecisionList decisionList(B);
+  for(unsigned i = 0; i < B; ++i) {
+    decisionList.at(i) = rankedAssignments_.at(i).at(candidate.ranks.at(i)).second;
+  }
+  return decisionList;
+}
+
 Molecule DirectedConformerGenerator::Impl::conformationMolecule(const DecisionList& decisionList) const {
   StereopermutatorList permutators = molecule_.stereopermutators();
 
@@ -340,12 +542,232 @@ DirectedConformerGenerator::Impl::checkGeneratedConformation(
   return conformerResult;
 }
 
+std::shared_ptr<const DirectedConformerGenerator::Impl::ModelCache>
+DirectedConformerGenerator::Impl::modelCache(
+  const DistanceGeometry::Configuration& configuration
+) const {
+  /* Fixed positions are modeled into the dihedral information and any
+   * unassigned stereopermutators outside of the relevant bonds are assigned
+   * anew for each conformer, so the base model cannot be reused in those cases
+   */
+  if(relevantBonds_.empty() || !configuration.fixedPositions.empty()) {
+    return nullptr;
+  }
+
+  const auto& permutators = molecule_.stereopermutators();
+  if(
+    permutators.hasZeroAssignmentStereopermutators()
+    || Temple::any_of(
+      permutators.atomStereopermutators(),
+      [](const AtomStereopermutator& permutator) -> bool {
+        return !permutator.assigned();
+      }
+    ) || Temple::any_of(
+      permutators.bondStereopermutators(),
+      [&](const BondStereopermutator& permutator) -> bool {
+        return !permutator.assigned() && !std::binary_search(
+          std::begin(relevantBonds_),
+          std::end(relevantBonds_),
+          permutator.placement()
+        );
+      }
+    )
+  ) {
+    return nullptr;
+  }
+
+  std::shared_ptr<const ModelCache> cache;
+  {
+    std::lock_guard<std::mutex> lock(modelCacheMutex_);
+    if(
+      !modelCache_
+      || modelCache_->looseningMultiplier != configuration.spatialModelLoosening
+    ) {
+      modelCache_ = nullptr;
+
+      // Failure to model leaves the cache empty
+      try {
+        const DistanceGeometry::SpatialModel model {
+          molecule_,
+          configuration,
+          relevantBonds_
+        };
+        auto bounds = model.makeSparsePairwiseBounds();
+
+        DistanceGeometry::ExplicitBoundsGraph explicitGraph {
+          molecule_.graph().inner(),
+          bounds
+        };
+        auto distanceBoundsResult = explicitGraph.makeDistanceBounds();
+        outcome::result<DistanceGeometry::DistanceBoundsMatrix> distanceBounds = DgError::GraphImpossible;
+        if(distanceBoundsResult) {
+          distanceBounds = DistanceGeometry::DistanceBoundsMatrix {
+            std::move(distanceBoundsResult.value())
+          };
+        } else {
+          distanceBounds = distanceBoundsResult.as_failure();
+        }
+
+        auto overlays = Temple::map(
+          relevantBonds_,
+          [&](const BondIndex& bond) {
+            const BondStereopermutator& permutator = permutators.at(bond);
+            std::vector<DistanceGeometry::SpatialModel::DihedralOverlay> bondOverlays;
+            bondOverlays.reserve(permutator.numAssignments());
+            for(unsigned i = 0; i < permutator.numAssignments(); ++i) {
+              BondStereopermutator assigned = permutator;
+              assigned.assign(i);
+              bondOverlays.push_back(
+                model.makeDihedralOverlay(
+                  assigned,
+                  configuration.spatialModelLoosening
+                )
+              );
+            }
+            return bondOverlays;
+          }
+        );
+
+        modelCache_ = std::make_shared<ModelCache>(
+          ModelCache {
+            configuration.spatialModelLoosening,
+            std::move(bounds),
+            std::move(distanceBounds),
+            model.getChiralConstraints(),
+            model.getDihedralConstraints(),
+            std::move(overlays)
+          }
+        );
+      } catch(...) {}
+    }
+
+    cache = modelCache_;
+  }
+
+  return cache;
+}
+
+outcome::result<DirectedConformerGenerator::Impl::DecisionListModel>
+DirectedConformerGenerator::Impl::modelDecisionList(
+  const ModelCache& cache,
+  const DecisionList& decisionList
+) const {
+  if(decisionList.size() != relevantBonds_.size()) {
+    throw std::invalid_argument("Passed decision list has wrong length");
+  }
+
+  if(!cache.distanceBounds) {
+    return cache.distanceBounds.as_failure();
+  }
+
+  auto data = std::make_shared<DistanceGeometry::MoleculeDGInformation>();
+  data->chiralConstraints = cache.chiralConstraints;
+  data->dihedralConstraints = cache.dihedralConstraints;
+
+  DistanceGeometry::SpatialModel::SparseBoundsMatrixHelper bounds {cache.bounds};
+  Eigen::MatrixXd distanceBounds = cache.distanceBounds.value().access();
+
+  // Overlay the chosen dihedral information onto the base model
+  std::vector<AtomIndex> affected;
+  for(unsigned i = 0; i < decisionList.size(); ++i) {
+    const auto& overlay = cache.overlays.at(i).at(decisionList.at(i));
+
+    for(const auto& pairBoundsPair : overlay.distanceBounds) {
+      const AtomIndex a = pairBoundsPair.first.front();
+      const AtomIndex b = pairBoundsPair.first.back();
+      bounds.add(a, b, pairBoundsPair.second);
+
+      const DistanceGeometry::ValueBounds pairBounds = bounds.get(a, b);
+      double& lower = DistanceGeometry::DistanceBoundsMatrix::lowerBound(distanceBounds, a, b);
+      double& upper = DistanceGeometry::DistanceBoundsMatrix::upperBound(distanceBounds, a, b);
+      if(pairBounds.upper < lower || pairBounds.lower > upper) {
+        return DgError::GraphImpossible;
+      }
+      lower = std::max(lower, pairBounds.lower);
+      upper = std::min(upper, pairBounds.upper);
+
+      affected.push_back(a);
+      affected.push_back(b);
+    }
+
+    std::copy(
+      std::begin(overlay.dihedralConstraints),
+      std::end(overlay.dihedralConstraints),
+      std::back_inserter(data->dihedralConstraints)
+    );
+  }
+
+  data->bounds = bounds.matrix();
+  data->rotatableGroups = DistanceGeometry::MoleculeDGInformation::make(
+    data->dihedralConstraints,
+    molecule_
+  );
+
+  // Only the overlaid atoms need to be smoothed through
+  Temple::sort(affected);
+  affected.erase(
+    std::unique(std::begin(affected), std::end(affected)),
+    std::end(affected)
+  );
+  try {
+    DistanceGeometry::DistanceBoundsMatrix::smooth(distanceBounds, affected);
+  } catch(std::runtime_error&) {
+    return DgError::GraphImpossible;
+  }
+
+  return DecisionListModel {
+    std::move(data),
+    DistanceGeometry::DistanceBoundsMatrix {std::move(distanceBounds)}
+  };
+}
+
+outcome::result<Utils::PositionCollection>
+DirectedConformerGenerator::Impl::generateCachedConformation(
+  const ModelCache& cache,
+  const DecisionList& decisionList,
+  const unsigned seed,
+  const DistanceGeometry::Configuration& configuration
+) const {
+  auto model = modelDecisionList(cache, decisionList);
+  if(!model) {
+    return model.as_failure();
+  }
+
+  Random::Engine engine(seed);
+  auto result = DistanceGeometry::generateConformer(
+    molecule_,
+    configuration,
+    model.value().data,
+    model.value().distanceBounds,
+    engine
+  );
+
+  if(result) {
+    return std::move(result.value()).getBohr();
+  }
+
+  return result.as_failure();
+}
+
 outcome::result<Utils::PositionCollection>
 DirectedConformerGenerator::Impl::generateRandomConformation(
   const DecisionList& decisionList,
   const DistanceGeometry::Configuration& configuration,
   const BondStereopermutator::FittingMode fitting
 ) const {
+  if(auto cache = modelCache(configuration)) {
+    return checkGeneratedConformation(
+      generateCachedConformation(
+        *cache,
+        decisionList,
+        randomnessEngine()(),
+        configuration
+      ),
+      decisionList,
+      fitting
+    );
+  }
+
   return checkGeneratedConformation(
     Scine::Molassembler::generateRandomConformation(
       conformationMolecule(decisionList),
@@ -363,6 +785,14 @@ DirectedConformerGenerator::Impl::generateConformation(
   const DistanceGeometry::Configuration& configuration,
   const BondStereopermutator::FittingMode fitting
 ) const {
+  if(auto cache = modelCache(configuration)) {
+    return checkGeneratedConformation(
+      generateCachedConformation(*cache, decisionList, seed, configuration),
+      decisionList,
+      fitting
+    );
+  }
+
   return checkGeneratedConformation(
     Scine::Molassembler::generateConformation(
       conformationMolecule(decisionList),
@@ -374,6 +804,139 @@ DirectedConformerGenerator::Impl::generateConformation(
   );
 }
 
+outcome::result<Utils::PositionCollection>
+DirectedConformerGenerator::Impl::generateConformationFrom(
+  const Utils::PositionCollection& reference,
+  const DecisionList& decisionList,
+  const unsigned seed,
+  const DistanceGeometry::Configuration& configuration,
+  const BondStereopermutator::FittingMode fitting
+) const {
+  const unsigned N = molecule_.graph().N();
+  if(reference.rows() != N) {
+    throw std::invalid_argument("Reference positions do not match the number of atoms");
+  }
+
+  auto cache = modelCache(configuration);
+  if(!cache) {
+    return generateConformation(decisionList, seed, configuration, fitting);
+  }
+
+  auto model = modelDecisionList(*cache, decisionList);
+  if(!model) {
+    return model.as_failure();
+  }
+
+  // Refinement takes place in four dimensions, in angstrom
+  Eigen::MatrixXd positions = Eigen::MatrixXd::Zero(4, N);
+  positions.topRows<3>() = rotateToDecisionList(reference, decisionList).transpose() * Utils::Constants::angstrom_per_bohr;
+
+  /* Rigid rotations can move parts of the molecule into one another. Such
+   * clashes are not resolved by a short refinement, so full embedding is
+   * needed instead.
+   */
+  const auto& distanceBounds = model.value().distanceBounds;
+  bool clashes = false;
+  for(unsigned i = 0; i < N && !clashes; ++i) {
+    for(unsigned j = i + 1; j < N; ++j) {
+      const double distance = (positions.col(i) - positions.col(j)).norm();
+      if(distance < Detail::clashFraction * distanceBounds.lowerBound(i, j)) {
+        clashes = true;
+        break;
+      }
+    }
+  }
+
+  if(!clashes) {
+    auto refined = checkGeneratedConformation(
+      [&]() -> outcome::result<Utils::PositionCollection> {
+        auto result = DistanceGeometry::refine(
+          std::move(positions),
+          distanceBounds,
+          configuration,
+          model.value().data
+        );
+        if(result) {
+          return std::move(result.value()).getBohr();
+        }
+        return result.as_failure();
+      }(),
+      decisionList,
+      fitting
+    );
+
+    if(refined) {
+      return refined;
+    }
+  }
+
+  return checkGeneratedConformation(
+    generateCachedConformation(*cache, decisionList, seed, configuration),
+    decisionList,
+    fitting
+  );
+}
+
+Utils::PositionCollection DirectedConformerGenerator::Impl::rotateToDecisionList(
+  Utils::PositionCollection positions,
+  const DecisionList& decisionList
+) const {
+  const Relabeler dihedralSequences(relevantBonds_, molecule_, 1);
+  const unsigned N = molecule_.graph().N();
+
+  for(unsigned i = 0; i < relevantBonds_.size(); ++i) {
+    const auto& sequence = dihedralSequences.sequences.at(i);
+    const auto& composite = molecule_.stereopermutators().at(relevantBonds_.at(i)).composite();
+    const double target = std::get<2>(
+      composite.allPermutations().at(decisionList.at(i)).dihedrals.front()
+    );
+
+    /* Rotations about preceding bonds move the sites of this bond's dihedral
+     * rigidly, so the current dihedral is measured right before rotating
+     */
+    const auto averagePosition = [&](const std::vector<AtomIndex>& atoms) -> Eigen::Vector3d {
+      Eigen::Vector3d sum = Eigen::Vector3d::Zero();
+      for(const AtomIndex a : atoms) {
+        sum += positions.row(a).transpose();
+      }
+      return sum / atoms.size();
+    };
+    const double current = Cartesian::dihedral(
+      averagePosition(sequence.is),
+      positions.row(sequence.j).transpose(),
+      positions.row(sequence.k).transpose(),
+      averagePosition(sequence.ls)
+    );
+
+    // Collect the atoms on the far side of the bond by a search from k
+    std::vector<bool> farSide(N, false);
+    std::vector<AtomIndex> stack {sequence.k};
+    farSide.at(sequence.k) = true;
+    while(!stack.empty()) {
+      const AtomIndex a = stack.back();
+      stack.pop_back();
+      for(const AtomIndex b : molecule_.graph().adjacents(a)) {
+        if(b != sequence.j && !farSide.at(b)) {
+          farSide.at(b) = true;
+          stack.push_back(b);
+        }
+      }
+    }
+
+    // Rotating the far side about the j-k axis changes the dihedral directly
+    const Eigen::Vector3d origin = positions.row(sequence.k).transpose();
+    const Eigen::Vector3d axis = (origin - positions.row(sequence.j).transpose()).normalized();
+    const Eigen::Matrix3d rotation = Eigen::AngleAxisd(target - current, axis).toRotationMatrix();
+    for(unsigned a = 0; a < N; ++a) {
+      if(farSide.at(a)) {
+        positions.row(a) = (rotation * (positions.row(a).transpose() - origin) + origin).transpose();
+      }
+    }
+  }
+
+  return positions;
+}
+
 DirectedConformerGenerator::DecisionList
 DirectedConformerGenerator::Impl::getDecisionList(
   const Utils::AtomCollection& atomCollection,
@@ -398,33 +961,83 @@ DirectedConformerGenerator::Impl::getDecisionList(
   const Utils::PositionCollection& positions,
   const BondStereopermutator::FittingMode fitting
 ) const {
-  const AngstromPositions angstromPositions {positions};
+  DecisionFitting decisionFitting = this->decisionFitting();
+  return fitDecisionList(decisionFitting, AngstromPositions {positions}, fitting);
+}
 
-  if(
-    !Temple::all_of(
-      relevantBonds_,
-      [&](const BondIndex& bondIndex) -> bool {
-        const auto& permutators = molecule_.stereopermutators();
-        return (
-          permutators.option(bondIndex.first)
-          && permutators.option(bondIndex.second)
-          && permutators.option(bondIndex)
-        );
-      }
-    )
-  ) {
-    throw std::logic_error("Underlying molecule permutator preconditions unmet!");
+std::vector<DirectedConformerGenerator::DecisionList>
+DirectedConformerGenerator::Impl::getDecisionLists(
+  const FrameBuffer& frames,
+  const BondStereopermutator::FittingMode fitting
+) const {
+  using FrameMap = Eigen::Map<
+    const Eigen::Matrix<double, Eigen::Dynamic, 3, Eigen::RowMajor>
+  >;
+
+  const unsigned atomCount = molecule_.graph().N();
+  if(frames.cols() != 3 * atomCount) {
+    throw std::invalid_argument("Frame buffer columns do not match the number of atoms");
+  }
+
+  const auto executor = Parallel::executor();
+  std::vector<DecisionFitting> workerFittings(executor->concurrency(), decisionFitting());
+  std::vector<AngstromPositions> workerPositions(executor->concurrency(), AngstromPositions {atomCount});
+
+  const unsigned frameCount = frames.rows();
+  std::vector<DecisionList> decisionLists(frameCount);
+  Parallel::forEach(*executor, frameCount, [&](const unsigned frame, const unsigned worker) {
+    AngstromPositions& angstromPositions = workerPositions.at(worker);
+    angstromPositions.positions = Utils::Constants::angstrom_per_bohr * FrameMap(frames.row(frame).data(), atomCount, 3);
+    decisionLists.at(frame) = fitDecisionList(workerFittings.at(worker), angstromPositions, fitting);
+  });
+
+  return decisionLists;
+}
+
+DirectedConformerGenerator::Impl::DecisionFitting
+DirectedConformerGenerator::Impl::decisionFitting() const {
+  const auto& permutators = molecule_.stereopermutators();
+  DecisionFitting fitting;
+
+  std::unordered_map<AtomIndex, unsigned> atomIndices;
+  for(const AtomStereopermutator& stereopermutator : permutators.atomStereopermutators()) {
+    atomIndices.emplace(stereopermutator.placement(), fitting.atomStereopermutators.size());
+    fitting.atomStereopermutators.push_back(stereopermutator);
   }
 
+  for(const BondIndex& bondIndex : relevantBonds_) {
+    const auto stereoOption = permutators.option(bondIndex);
+    if(
+      !stereoOption
+      || !permutators.option(bondIndex.first)
+      || !permutators.option(bondIndex.second)
+    ) {
+      throw std::logic_error("Underlying molecule permutator preconditions unmet!");
+    }
+
+    fitting.bondStereopermutators.push_back(stereoOption.value());
+    fitting.bondAtoms.emplace_back(
+      atomIndices.at(bondIndex.first),
+      atomIndices.at(bondIndex.second)
+    );
+  }
+
+  return fitting;
+}
+
+DirectedConformerGenerator::DecisionList
+DirectedConformerGenerator::Impl::fitDecisionList(
+  DecisionFitting& fitting,
+  const AngstromPositions& angstromPositions,
+  const BondStereopermutator::FittingMode mode
+) const {
   /* Refit all atom stereopermutators and ensure stereopermutations are
    * identical, storing fitted shape maps for bond stereopermutator fitting later
    */
-  std::unordered_map<AtomIndex, AtomStereopermutator::ShapeMap> shapeMaps;
-  for(
-    const AtomStereopermutator& stereopermutator :
-    molecule_.stereopermutators().atomStereopermutators()
-  ) {
-    AtomStereopermutator refitted = stereopermutator;
+  std::vector<AtomStereopermutator::ShapeMap> shapeMaps;
+  shapeMaps.reserve(fitting.atomStereopermutators.size());
+  for(AtomStereopermutator& refitted : fitting.atomStereopermutators) {
+    const AtomStereopermutator& stereopermutator = molecule_.stereopermutators().at(refitted.placement());
     auto shapeMap = refitted.fit(molecule_.graph(), angstromPositions);
     if(refitted.getShape() != stereopermutator.getShape()) {
       const std::string error = (
@@ -456,34 +1069,25 @@ DirectedConformerGenerator::Impl::getDecisionList(
       );
       throw std::logic_error(error);
     }
-    shapeMaps.emplace(stereopermutator.placement(), std::move(shapeMap.value()));
+    shapeMaps.push_back(std::move(shapeMap.value()));
   }
 
-  return Temple::map(
-    relevantBonds_,
-    [&](const BondIndex& bondIndex) -> std::uint8_t {
-      const auto stereoOption = molecule_.stereopermutators().option(bondIndex);
-      if(!stereoOption) {
-        throw std::logic_error(
-          "No BondStereopermutator for selected bond in molecule!"
-        );
-      }
+  const unsigned bondCount = fitting.bondStereopermutators.size();
+  DecisionList decisionList(bondCount);
+  for(unsigned i = 0; i < bondCount; ++i) {
+    const BondIndex& bondIndex = relevantBonds_.at(i);
+    const auto& atoms = fitting.bondAtoms.at(i);
+    const std::pair<BondStereopermutator::FittingReferences, BondStereopermutator::FittingReferences> fittingReferences {
+      {molecule_.stereopermutators().at(bondIndex.first), shapeMaps.at(atoms.first)},
+      {molecule_.stereopermutators().at(bondIndex.second), shapeMaps.at(atoms.second)}
+    };
 
-      const auto fittingReferences = Temple::mapHomogeneousPairlike(
-        bondIndex,
-        [&](const AtomIndex v) -> BondStereopermutator::FittingReferences {
-          return {
-            molecule_.stereopermutators().at(v),
-            shapeMaps.at(v)
-          };
-        }
-      );
+    BondStereopermutator& stereopermutator = fitting.bondStereopermutators.at(i);
+    stereopermutator.fit(angstromPositions, fittingReferences, mode);
+    decisionList.at(i) = stereopermutator.assigned().value_or(unknownDecision);
+  }
 
-      BondStereopermutator stereopermutator = stereoOption.value();
-      stereopermutator.fit(angstromPositions, fittingReferences, fitting);
-      return stereopermutator.assigned().value_or(unknownDecision);
-    }
-  );
+  return decisionList;
 }
 
 void DirectedConformerGenerator::Impl::enumerate(
@@ -491,22 +1095,40 @@ void DirectedConformerGenerator::Impl::enumerate(
   const unsigned seed,
   const EnumerationSettings& settings
 ) {
-  clear();
-  const unsigned size = idealEnsembleSize();
-
-#pragma omp parallel for
-  for(unsigned increment = 0; increment < size; ++increment) {
-    Random::Engine localEngine(seed + increment);
+  const DecisionList bounds = decisionLists_.bounds();
 
-    DecisionList decisionList;
-#pragma omp critical(decisionSetAccess)
-    {
-      decisionList = generateNewDecisionList(localEngine);
+  /* When resuming, the indices of the decision lists yet to enumerate are
+   * determined beforehand. The set is then not read during enumeration and
+   * the callback may insert into it.
+   */
+  const auto range = shard(idealEnsembleSize(), settings.shardCount, settings.shardIndex);
+  std::vector<unsigned> pending;
+  if(settings.skipContained) {
+    for(unsigned i = range.first; i < range.second; ++i) {
+      if(!decisionLists_.contains(Detail::decodeDecisionList(i, bounds))) {
+        pending.push_back(i);
+      }
     }
+  } else {
+    clear();
+  }
 
-    for(unsigned i = 0; i < settings.dihedralRetries; ++i) {
-      outcome::result<Utils::PositionCollection> conformer {DgError::DecisionListMismatch};
+  const unsigned size = settings.skipContained ? pending.size() : range.second - range.first;
+  const auto listIndex = [&](const unsigned k) -> unsigned {
+    return settings.skipContained ? pending[k] : range.first + k;
+  };
+
+  /* Every decision list is enumerated, so each iteration can decode its own
+   * from the iteration index instead of drawing it from the shared trie. Each
+   * iteration's result depends only on its index and the seed, so the
+   * results are independent of the number of threads.
+   */
+  const auto generate = [&](const unsigned increment) -> outcome::result<Utils::PositionCollection> {
+    Random::Engine localEngine(Random::streamSeed(seed, increment));
+    const DecisionList decisionList = Detail::decodeDecisionList(increment, bounds);
 
+    outcome::result<Utils::PositionCollection> conformer {DgError::DecisionListMismatch};
+    for(unsigned i = 0; i < settings.dihedralRetries; ++i) {
       try {
         conformer = generateConformation(
           decisionList,
@@ -514,24 +1136,257 @@ void DirectedConformerGenerator::Impl::enumerate(
           settings.configuration,
           settings.fitting
         );
-      } catch(...) {}
-
-      if(conformer) {
-#pragma omp critical(guardCallback)
-        {
-          callback(decisionList, conformer.value());
-        }
-        break;
+      } catch(...) {
+        conformer = DgError::DecisionListMismatch;
       }
 
-      if(conformer.error() != DgError::DecisionListMismatch) {
+      if(conformer || conformer.error() != DgError::DecisionListMismatch) {
         /* Only allow decision list failure retries for retries, break on
          * anything else
          */
         break;
       }
     }
+
+    return conformer;
+  };
+
+  /* The first exception thrown by the callback is kept and rethrown once all
+   * workers are done. Remaining decision lists are skipped.
+   */
+  std::exception_ptr exception;
+  std::atomic<bool> failed {false};
+  std::mutex exceptionMutex;
+  const auto invoke = [&](const DecisionList& decisionList, Utils::PositionCollection positions) {
+    try {
+      callback(decisionList, std::move(positions));
+    } catch(...) {
+      std::lock_guard<std::mutex> lock(exceptionMutex);
+      if(!exception) {
+        exception = std::current_exception();
+      }
+      failed = true;
+    }
+  };
+
+  std::mutex callbackMutex;
+  if(settings.orderedCallback) {
+    /* Conformers finished out of order are held back until all preceding
+     * ones are passed to the callback
+     */
+    std::vector<boost::optional<outcome::result<Utils::PositionCollection>>> finished(size);
+    unsigned next = 0;
+    Parallel::forEach(size, [&](const unsigned k, unsigned /* worker */) {
+      outcome::result<Utils::PositionCollection> conformer {DgError::DecisionListMismatch};
+      if(!failed) {
+        conformer = generate(listIndex(k));
+      }
+
+      std::lock_guard<std::mutex> lock(callbackMutex);
+      finished.at(k) = std::move(conformer);
+      for(; next < size && finished.at(next); ++next) {
+        if(finished.at(next).value() && !failed) {
+          invoke(
+            Detail::decodeDecisionList(listIndex(next), bounds),
+            std::move(finished.at(next).value().value())
+          );
+        }
+        finished.at(next) = boost::none;
+      }
+    });
+  } else {
+    Parallel::forEach(size, [&](const unsigned k, unsigned /* worker */) {
+      if(failed) {
+        return;
+      }
+
+      const unsigned increment = listIndex(k);
+      auto conformer = generate(increment);
+      if(!conformer) {
+        return;
+      }
+
+      const DecisionList decisionList = Detail::decodeDecisionList(increment, bounds);
+      if(settings.concurrentCallback) {
+        invoke(decisionList, conformer.value());
+      } else {
+        std::lock_guard<std::mutex> lock(callbackMutex);
+        if(!failed) {
+          invoke(decisionList, conformer.value());
+        }
+      }
+    });
+  }
+
+  if(exception) {
+    std::rethrow_exception(exception);
+  }
+
+  // Record all enumerated decision lists
+  for(unsigned k = 0; k < size; ++k) {
+    decisionLists_.insert(Detail::decodeDecisionList(listIndex(k), bounds));
+  }
+}
+
+std::string DirectedConformerGenerator::Impl::checkpointBytes(
+  const Random::Engine& engine
+) const {
+  const DecisionList bounds = decisionLists_.bounds();
+
+  std::string bytes = Detail::checkpointMagic;
+  Detail::writeVarint(bytes, static_cast<unsigned>(alignment_));
+  Detail::writeVarint(bytes, relevantBonds_.size());
+  for(unsigned i = 0; i < relevantBonds_.size(); ++i) {
+    Detail::writeVarint(bytes, relevantBonds_.at(i).first);
+    Detail::writeVarint(bytes, relevantBonds_.at(i).second);
+    Detail::writeVarint(bytes, bounds.at(i));
+  }
+
+  for(const auto value : engine.state()) {
+    Detail::writeVarint(bytes, value);
+  }
+
+  /* Decision lists are stored as the differences between their successive
+   * sorted indices in the space of decision lists
+   */
+  std::vector<unsigned> indices;
+  indices.reserve(decisionLists_.size());
+  decisionLists_.forEach(
+    [&](const DecisionList& decisionList) {
+      indices.push_back(Detail::encodeDecisionList(decisionList, bounds));
+    }
+  );
+  std::sort(std::begin(indices), std::end(indices));
+
+  Detail::writeVarint(bytes, indices.size());
+  unsigned previous = 0;
+  for(const unsigned index : indices) {
+    Detail::writeVarint(bytes, index - previous);
+    previous = index;
+  }
+
+  return bytes;
+}
+
+void DirectedConformerGenerator::Impl::checkpoint(
+  const std::string& filename,
+  const Random::Engine& engine
+) const {
+  const std::string bytes = checkpointBytes(engine);
+
+  /* Write to a uniquely named file first and rename it into place so that
+   * interruptions never leave a partially written checkpoint
+   */
+  const boost::filesystem::path filepath {filename};
+  const boost::filesystem::path temporaryPath = filepath.parent_path() / boost::filesystem::unique_path("%%%%-%%%%-%%%%.tmp");
+  {
+    std::ofstream file {temporaryPath.string(), std::ios::binary};
+    file.write(bytes.data(), bytes.size());
+    if(!file) {
+      throw std::runtime_error("Could not write checkpoint " + temporaryPath.string());
+    }
+  }
+  boost::filesystem::rename(temporaryPath, filepath);
+}
+
+DirectedConformerGenerator::Impl::CheckpointContents
+DirectedConformerGenerator::Impl::readCheckpoint(const std::string& filename) const {
+  std::ifstream file {filename, std::ios::binary};
+  if(!file) {
+    throw std::runtime_error("Could not read checkpoint " + filename);
+  }
+  const std::string bytes {
+    std::istreambuf_iterator<char>(file),
+    std::istreambuf_iterator<char>()
+  };
+
+  return parseCheckpoint(bytes);
+}
+
+DirectedConformerGenerator::Impl::CheckpointContents
+DirectedConformerGenerator::Impl::parseCheckpoint(const std::string& bytes) const {
+  if(bytes.compare(0, Detail::checkpointMagic.size(), Detail::checkpointMagic) != 0) {
+    throw std::runtime_error("File is not a directed conformer generator checkpoint");
+  }
+  std::size_t position = Detail::checkpointMagic.size();
+
+  const DecisionList bounds = decisionLists_.bounds();
+  bool matches = (Detail::readVarint(bytes, position) == static_cast<unsigned>(alignment_));
+  const std::uint64_t B = Detail::readVarint(bytes, position);
+  matches = matches && (B == relevantBonds_.size());
+  for(std::uint64_t i = 0; matches && i < B; ++i) {
+    const std::uint64_t first = Detail::readVarint(bytes, position);
+    const std::uint64_t second = Detail::readVarint(bytes, position);
+    const std::uint64_t bound = Detail::readVarint(bytes, position);
+    matches = (
+      first == relevantBonds_.at(i).first
+      && second == relevantBonds_.at(i).second
+      && bound == bounds.at(i)
+    );
+  }
+  if(!matches) {
+    throw std::invalid_argument("Checkpoint does not match alignment or relevant bonds of generator");
+  }
+
+  CheckpointContents contents;
+  for(auto& value : contents.engineState) {
+    value = Detail::readVarint(bytes, position);
+  }
+
+  const std::uint64_t count = Detail::readVarint(bytes, position);
+  if(count > idealEnsembleSize()) {
+    throw std::runtime_error("Checkpoint contains more decision lists than possible");
+  }
+  contents.indices.reserve(count);
+  std::uint64_t index = 0;
+  for(std::uint64_t i = 0; i < count; ++i) {
+    index += Detail::readVarint(bytes, position);
+    if(index >= idealEnsembleSize()) {
+      throw std::runtime_error("Checkpoint contains decision list out of bounds");
+    }
+    contents.indices.push_back(index);
+  }
+
+  return contents;
+}
+
+void DirectedConformerGenerator::Impl::resume(
+  const std::string& filename,
+  Random::Engine& engine
+) {
+  // Modify state only once the checkpoint is known to be intact
+  restore(readCheckpoint(filename), engine);
+}
+
+void DirectedConformerGenerator::Impl::resumeFromBytes(
+  const std::string& bytes,
+  Random::Engine& engine
+) {
+  restore(parseCheckpoint(bytes), engine);
+}
+
+void DirectedConformerGenerator::Impl::restore(
+  const CheckpointContents& contents,
+  Random::Engine& engine
+) {
+  const DecisionList bounds = decisionLists_.bounds();
+  clear();
+  for(const unsigned i : contents.indices) {
+    decisionLists_.insert(Detail::decodeDecisionList(i, bounds));
+  }
+  engine.setState(contents.engineState);
+}
+
+unsigned DirectedConformerGenerator::Impl::merge(const std::string& filename) {
+  const CheckpointContents contents = readCheckpoint(filename);
+  const DecisionList bounds = decisionLists_.bounds();
+  unsigned inserted = 0;
+  for(const unsigned i : contents.indices) {
+    inserted += static_cast<unsigned>(
+      decisionLists_.insert(Detail::decodeDecisionList(i, bounds))
+    );
   }
+  return inserted;
 }
 
 DirectedConformerGenerator::Relabeler DirectedConformerGenerator::Impl::relabeler() const {
@@ -10,8 +10,15 @@
 
 #include "Molassembler/DirectedConformerGenerator.h"
 #include "Molassembler/Molecule.h"
+#include "Molassembler/DistanceGeometry/SpatialModel.h"
+#include "Molassembler/DistanceGeometry/ConformerGeneration.h"
 
-#include "Molassembler/Temple/BoundedNodeTrie.h"
+#include "Molassembler/Temple/CompactBoundedNodeTrie.h"
+
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <tuple>
 
 namespace Scine {
 namespace Molassembler {
@@ -24,6 +31,9 @@ public:
     const DecisionList& bounds
   );
 
+  //! Half-open range of decision list indices of a shard
+  static std::pair<unsigned, unsigned> shard(unsigned size, unsigned count, unsigned index);
+
   static boost::variant<IgnoreReason, BondStereopermutator> considerBond(
     const BondIndex& bondIndex,
     const Molecule& molecule,
@@ -38,11 +48,16 @@ public:
 
   DecisionList generateNewDecisionList(Random::Engine& engine);
 
+  void setDecisionCosts(const std::vector<std::vector<double>>& costs);
+
+  void setDecisionCosts(const AssignmentCost& cost);
+
   bool insert(const DecisionList& decisionList) {
     return decisionLists_.insert(decisionList);
   }
 
   void clear() {
+    resetDecisionFrontier();
     return decisionLists_.clear();
   }
 
@@ -54,6 +69,10 @@ public:
     return relevantBonds_;
   }
 
+  const Molecule& molecule() const {
+    return molecule_;
+  }
+
   bool contains(const DecisionList& decisionList) const {
     return decisionLists_.contains(decisionList);
   }
@@ -85,6 +104,14 @@ public:
     BondStereopermutator::FittingMode fitting
   ) const;
 
+  outcome::result<Utils::PositionCollection> generateConformationFrom(
+    const Utils::PositionCollection& reference,
+    const DecisionList& decisionList,
+    unsigned seed,
+    const DistanceGeometry::Configuration& configuration,
+    BondStereopermutator::FittingMode fitting
+  ) const;
+
   DecisionList getDecisionList(
     const Utils::AtomCollection& atomCollection,
     BondStereopermutator::FittingMode fitting
@@ -95,6 +122,11 @@ public:
     BondStereopermutator::FittingMode fitting
   ) const;
 
+  std::vector<DecisionList> getDecisionLists(
+    const FrameBuffer& frames,
+    BondStereopermutator::FittingMode fitting
+  ) const;
+
   Molecule conformationMolecule(const DecisionList& decisionList) const;
 
   void enumerate(
@@ -103,11 +135,141 @@ public:
     const EnumerationSettings& settings
   );
 
+  void checkpoint(const std::string& filename, const Random::Engine& engine) const;
+
+  std::string checkpointBytes(const Random::Engine& engine) const;
+
+  void resume(const std::string& filename, Random::Engine& engine);
+
+  void resumeFromBytes(const std::string& bytes, Random::Engine& engine);
+
+  unsigned merge(const std::string& filename);
+
   Relabeler relabeler() const;
 
   std::vector<int> binMidpointIntegers(const DecisionList& decision) const;
 
 private:
+  /* Spatial model of the underlying molecule with the dihedral information of
+   * the relevant bonds deferred, and each relevant bond's dihedral
+   * information for each of its assignments. Modeling a decision list then
+   * only requires overlaying the chosen dihedral information onto the base
+   * model and re-smoothing through the affected atoms.
+   */
+  struct ModelCache {
+    double looseningMultiplier;
+    DistanceGeometry::SpatialModel::SparseBoundsMatrix bounds;
+    outcome::result<DistanceGeometry::DistanceBoundsMatrix> distanceBounds;
+    std::vector<DistanceGeometry::ChiralConstraint> chiralConstraints;
+    std::vector<DistanceGeometry::DihedralConstraint> dihedralConstraints;
+    //! Indexed by relevant bond, then by assignment
+    std::vector<
+      std::vector<DistanceGeometry::SpatialModel::DihedralOverlay>
+    > overlays;
+  };
+
+  struct CheckpointContents {
+    std::array<Random::Engine::result_type, 4> engineState;
+    //! Sorted decision list indices
+    std::vector<unsigned> indices;
+  };
+
+  //! Reads and validates a checkpoint file written for this generator
+  CheckpointContents readCheckpoint(const std::string& filename) const;
+
+  //! Validates the bytes of a checkpoint written for this generator
+  CheckpointContents parseCheckpoint(const std::string& bytes) const;
+
+  //! Replaces the set of decision lists and the engine state
+  void restore(const CheckpointContents& contents, Random::Engine& engine);
+
+  /* Yields a model cache for the configuration, or nullptr if decision lists
+   * cannot be modeled by overlaying dihedral information in this case
+   */
+  std::shared_ptr<const ModelCache> modelCache(
+    const DistanceGeometry::Configuration& configuration
+  ) const;
+
+  /* Candidate of best-first decision list generation. Ranks index into each
+   * bond's assignments sorted by ascending cost.
+   */
+  struct DecisionCandidate {
+    double cost;
+    DecisionList ranks;
+
+    bool operator > (const DecisionCandidate& other) const {
+      return std::tie(cost, ranks) > std::tie(other.cost, other.ranks);
+    }
+  };
+
+  using DecisionFrontier = std::priority_queue<
+    DecisionCandidate,
+    std::vector<DecisionCandidate>,
+    std::greater<>
+  >;
+
+  //! Restarts best-first generation from the lowest cost decision list
+  void resetDecisionFrontier();
+
+  //! Pops the lowest cost candidate, pushing its successors
+  DecisionList popDecisionFrontier();
+
+  //! Spatial model of a particular decision list
+  struct DecisionListModel {
+    std::shared_ptr<DistanceGeometry::MoleculeDGInformation> data;
+    DistanceGeometry::DistanceBoundsMatrix distanceBounds;
+  };
+
+  //! Overlays a decision list's dihedral information onto the model cache
+  outcome::result<DecisionListModel> modelDecisionList(
+    const ModelCache& cache,
+    const DecisionList& decisionList
+  ) const;
+
+  /*! @brief Stereopermutators fitted to infer decision lists
+   *
+   * Looked up once and copied for refitting to each structure.
+   */
+  struct DecisionFitting {
+    std::vector<AtomStereopermutator> atomStereopermutators;
+    //! Bond stereopermutator of each relevant bond
+    std::vector<BondStereopermutator> bondStereopermutators;
+    //! Indices into atomStereopermutators of each relevant bond's atoms
+    std::vector<std::pair<unsigned, unsigned>> bondAtoms;
+  };
+
+  /*! @brief Looks up the stereopermutators to fit
+   *
+   * @throws std::logic_error If a relevant bond lacks stereopermutators
+   */
+  DecisionFitting decisionFitting() const;
+
+  /*! @brief Fits a decision list to positions
+   *
+   * Refits the stereopermutators of @p fitting in place.
+   *
+   * @throws std::logic_error If an atom stereopermutator's shape or
+   *   assignment changes on refitting
+   */
+  DecisionList fitDecisionList(
+    DecisionFitting& fitting,
+    const AngstromPositions& angstromPositions,
+    BondStereopermutator::FittingMode mode
+  ) const;
+
+  //! Rigidly rotates about the relevant bonds to a decision list's dihedrals
+  Utils::PositionCollection rotateToDecisionList(
+    Utils::PositionCollection positions,
+    const DecisionList& decisionList
+  ) const;
+
+  outcome::result<Utils::PositionCollection> generateCachedConformation(
+    const ModelCache& cache,
+    const DecisionList& decisionList,
+    unsigned seed,
+    const DistanceGeometry::Configuration& configuration
+  ) const;
+
   Molecule molecule_;
   BondStereopermutator::Alignment alignment_;
   BondList relevantBonds_;
@@ -131,7 +293,19 @@ private:
    * dihedral you have explored and which ones might lead to a conformer that
    * is most different from the ones you already have.
    */
-  Temple::BoundedNodeTrie<std::uint8_t> decisionLists_;
+  Temple::CompactBoundedNodeTrie<std::uint8_t> decisionLists_;
+
+  /* Best-first generation state if decision costs are set: Each bond's
+   * assignments ordered by ascending cost with the costs, and the frontier of
+   * candidates. Every rank vector is pushed exactly once, from the parent
+   * obtained by decrementing its last nonzero rank.
+   */
+  std::vector<std::vector<std::pair<double, std::uint8_t>>> rankedAssignments_;
+  DecisionFrontier decisionFrontier_;
+
+  // Lazily constructed, guarded by modelCacheMutex_
+  mutable std::shared_ptr<const ModelCache> modelCache_;
+  mutable std::mutex modelCacheMutex_;
 };
 
 } // namespace Molassembler
@@ -55,61 +55,224 @@ bool DistanceBoundsMatrix::setLowerBound(const AtomIndex i, const AtomIndex j, c
   return false;
 }
 
-void DistanceBoundsMatrix::smooth(Eigen::Ref<Eigen::MatrixXd> matrix) {
-  /* Floyd's algorithm: O(N³) */
+namespace {
+
+//! Single iteration of Floyd's algorithm with k as the intermediate atom
+void smoothThrough(Eigen::Ref<Eigen::MatrixXd> matrix, const AtomIndex k) {
   const unsigned N = matrix.cols();
 
-  for(AtomIndex k = 0; k < N; ++k) {
-    for(AtomIndex i = 0; i < N - 1; ++i) {
-      /* Single-branch references to lower and upper ik parts */
-      auto upperLowerIK = (i < k
-        ? std::pair<double&, double&>(matrix(i, k), matrix(k, i))
-        : std::pair<double&, double&>(matrix(k, i), matrix(i, k))
+  for(AtomIndex i = 0; i < N - 1; ++i) {
+    /* Single-branch references to lower and upper ik parts */
+    auto upperLowerIK = (i < k
+      ? std::pair<double&, double&>(matrix(i, k), matrix(k, i))
+      : std::pair<double&, double&>(matrix(k, i), matrix(i, k))
+    );
+    double& upperIK = upperLowerIK.first;
+    double& lowerIK = upperLowerIK.second;
+
+    if(lowerIK > upperIK) {
+      throw std::runtime_error("Triangle smoothing encountered bound inversion");
+    }
+
+    for(AtomIndex j = i + 1; j < N; ++j) {
+      /* i < j is known, so lower(matrix, i, j) is always matrix(j, i),
+       * and upper(matrix, i, j) always matrix(i, j)
+       */
+      double& upperIJ = matrix(i, j);
+      double& lowerIJ = matrix(j, i);
+
+      /* Single-branch references to lower and upper jk parts */
+      auto upperLowerJK = (j < k
+        ? std::pair<double&, double&>(matrix(j, k), matrix(k, j))
+        : std::pair<double&, double&>(matrix(k, j), matrix(j, k))
       );
-      double& upperIK = upperLowerIK.first;
-      double& lowerIK = upperLowerIK.second;
+      double& upperJK = upperLowerJK.first;
+      double& lowerJK = upperLowerJK.second;
+
+      /* Actual algorithm */
+      if(upperIJ > upperIK + upperJK) {
+        upperIJ = upperIK + upperJK;
+      }
 
-      if(lowerIK > upperIK) {
+      if(lowerIJ < lowerIK - upperJK) {
+        lowerIJ = lowerIK - upperJK;
+      } else if(lowerIJ < lowerJK - upperIK) {
+        lowerIJ = lowerJK - upperIK;
+      }
+
+      // Safety
+      if(lowerIJ > upperIJ) {
         throw std::runtime_error("Triangle smoothing encountered bound inversion");
       }
+    }
+  }
+}
+
+//! Tile edge length of blocked smoothing, three tiles fit into L2 cache
+constexpr unsigned smoothingBlockSize = 64;
+
+/*! @brief Floyd-Warshall min-plus update of a tile of a symmetric shortest
+ *   paths matrix through a range of intermediate vertices
+ *
+ * Updates rows [i, i + I) of columns [j, j + J) through intermediates
+ * [k, k + K). The tile may overlap the row or column range of the
+ * intermediates, in which case the update is carried out in place as in
+ * Floyd-Warshall.
+ */
+void minPlusTile(
+  Eigen::MatrixXd& distances,
+  const unsigned i,
+  const unsigned I,
+  const unsigned j,
+  const unsigned J,
+  const unsigned k,
+  const unsigned K
+) {
+  for(unsigned b = k; b < k + K; ++b) {
+    for(unsigned c = j; c < j + J; ++c) {
+      const double bc = distances(b, c);
+      distances.col(c).segment(i, I) = distances.col(c).segment(i, I).cwiseMin(
+        (distances.col(b).segment(i, I).array() + bc).matrix()
+      );
+    }
+  }
+}
+
+void blockedSmooth(Eigen::Ref<Eigen::MatrixXd> matrix) {
+  const unsigned N = matrix.cols();
+  if(N < 2) {
+    return;
+  }
+
+  const unsigned B = smoothingBlockSize;
+  const unsigned numBlocks = (N + B - 1) / B;
+  const auto blockStart = [&](const unsigned block) { return block * B; };
+  const auto blockSize = [&](const unsigned block) { return std::min(B, N - block * B); };
+
+  // Symmetric upper bounds, shortened to shortest paths in place
+  Eigen::MatrixXd upper = matrix.triangularView<Eigen::StrictlyUpper>();
+  upper.triangularView<Eigen::StrictlyLower>() = upper.transpose();
+
+  for(unsigned kb = 0; kb < numBlocks; ++kb) {
+    const unsigned k = blockStart(kb);
+    const unsigned K = blockSize(kb);
+
+    // Phase one: Diagonal tile through itself
+    minPlusTile(upper, k, K, k, K, k, K);
+
+    // Phase two: Tiles sharing the diagonal tile's rows or columns
+#pragma omp parallel for schedule(dynamic)
+    for(unsigned ob = 0; ob < 2 * numBlocks; ++ob) {
+      const unsigned other = ob / 2;
+      if(other == kb) {
+        continue;
+      }
+
+      if(ob % 2 == 0) {
+        minPlusTile(upper, k, K, blockStart(other), blockSize(other), k, K);
+      } else {
+        minPlusTile(upper, blockStart(other), blockSize(other), k, K, k, K);
+      }
+    }
+
+    // Phase three: All other tiles through the diagonal tile
+#pragma omp parallel for schedule(dynamic)
+    for(unsigned tile = 0; tile < numBlocks * numBlocks; ++tile) {
+      const unsigned ib = tile / numBlocks;
+      const unsigned jb = tile % numBlocks;
+      if(ib == kb || jb == kb) {
+        continue;
+      }
 
-      for(AtomIndex j = i + 1; j < N; ++j) {
-        /* i < j is known, so lower(matrix, i, j) is always matrix(j, i),
-         * and upper(matrix, i, j) always matrix(i, j)
-         */
-        double& upperIJ = matrix(i, j);
-        double& lowerIJ = matrix(j, i);
-
-        /* Single-branch references to lower and upper jk parts */
-        auto upperLowerJK = (j < k
-          ? std::pair<double&, double&>(matrix(j, k), matrix(k, j))
-          : std::pair<double&, double&>(matrix(k, j), matrix(j, k))
-        );
-        double& upperJK = upperLowerJK.first;
-        double& lowerJK = upperLowerJK.second;
-
-        /* Actual algorithm */
-        if(upperIJ > upperIK + upperJK) {
-          upperIJ = upperIK + upperJK;
-        }
-
-        if(lowerIJ < lowerIK - upperJK) {
-          lowerIJ = lowerIK - upperJK;
-        } else if(lowerIJ < lowerJK - upperIK) {
-          lowerIJ = lowerJK - upperIK;
-        }
-
-        // Safety
-        if(lowerIJ > upperIJ) {
-          throw std::runtime_error("Triangle smoothing encountered bound inversion");
-        }
+      minPlusTile(
+        upper,
+        blockStart(ib), blockSize(ib),
+        blockStart(jb), blockSize(jb),
+        k, K
+      );
+    }
+  }
+
+  /* Lower bounds from the smoothed upper bounds:
+   *   L'_ij = max_kl (L_kl - U'_ik - U'_lj)
+   * as two max-plus products. Diagonal shortest paths are zero, so L' >= L.
+   */
+  Eigen::MatrixXd lower = matrix.triangularView<Eigen::StrictlyLower>();
+  lower.triangularView<Eigen::StrictlyUpper>() = lower.transpose();
+
+  // A_il = max_k (L_kl - U'_ik)
+  Eigen::MatrixXd intermediate(N, N);
+#pragma omp parallel for schedule(static)
+  for(unsigned l = 0; l < N; ++l) {
+    intermediate.col(l) = (lower(0, l) - upper.col(0).array()).matrix();
+    for(unsigned k = 1; k < N; ++k) {
+      intermediate.col(l) = intermediate.col(l).cwiseMax(
+        (lower(k, l) - upper.col(k).array()).matrix()
+      );
+    }
+  }
+
+  // L'_ij = max_l (A_il - U'_lj)
+#pragma omp parallel for schedule(static)
+  for(unsigned j = 0; j < N; ++j) {
+    lower.col(j) = (intermediate.col(0).array() - upper(0, j)).matrix();
+    for(unsigned l = 1; l < N; ++l) {
+      lower.col(j) = lower.col(j).cwiseMax(
+        (intermediate.col(l).array() - upper(l, j)).matrix()
+      );
+    }
+  }
+
+  for(AtomIndex i = 0; i < N - 1; ++i) {
+    for(AtomIndex j = i + 1; j < N; ++j) {
+      // Safety
+      if(lower(j, i) > upper(i, j)) {
+        throw std::runtime_error("Triangle smoothing encountered bound inversion");
       }
+
+      matrix(i, j) = upper(i, j);
+      matrix(j, i) = lower(j, i);
     }
   }
 }
 
-void DistanceBoundsMatrix::smooth() {
-  smooth(matrix_);
+} // namespace
+
+void DistanceBoundsMatrix::smooth(
+  Eigen::Ref<Eigen::MatrixXd> matrix,
+  const SmoothingAlgorithm algorithm
+) {
+  if(algorithm == SmoothingAlgorithm::Blocked) {
+    blockedSmooth(matrix);
+    return;
+  }
+
+  /* Floyd's algorithm: O(N³) */
+  const unsigned N = matrix.cols();
+
+  for(AtomIndex k = 0; k < N; ++k) {
+    smoothThrough(matrix, k);
+  }
+}
+
+void DistanceBoundsMatrix::smooth(
+  Eigen::Ref<Eigen::MatrixXd> matrix,
+  const std::vector<AtomIndex>& affected
+) {
+  /* Any path shortened by the tightened bounds passes through at least one
+   * affected atom, so only those need to be considered as intermediates
+   */
+  for(const AtomIndex k : affected) {
+    smoothThrough(matrix, k);
+  }
+}
+
+void DistanceBoundsMatrix::smooth(const SmoothingAlgorithm algorithm) {
+  smooth(matrix_, algorithm);
+}
+
+void DistanceBoundsMatrix::smooth(const std::vector<AtomIndex>& affected) {
+  smooth(matrix_, affected);
 }
 
 unsigned DistanceBoundsMatrix::boundInconsistencies() const {
@@ -145,15 +308,7 @@ outcome::result<Eigen::MatrixXd> DistanceBoundsMatrix::makeDistanceMatrix(Random
 
   Temple::Random::shuffle(indices, engine);
 
-  std::vector<AtomIndex>::const_iterator separator;
-
-  if(partiality == Partiality::FourAtom) {
-    separator = indices.cbegin() + std::min(N, 4U);
-  } else if(partiality == Partiality::TenPercent) {
-    separator = indices.cbegin() + std::min(N, static_cast<unsigned>(0.1 * N));
-  } else { // All
-    separator = indices.cend();
-  }
+  const auto separator = indices.cbegin() + smoothedAtomCount(partiality, N);
 
   // Up to the separator decided by partiality
   for(auto iter = indices.cbegin(); iter != separator; ++iter) {
@@ -9,6 +9,7 @@
 #define INCLUDE_MOLASSEMBLER_DISTANCE_GEOMETRY_DISTANCE_BOUNDS_MATRIX_H
 
 #include <Eigen/Core>
+#include <vector>
 
 #include "Molassembler/DistanceGeometry/DistanceGeometry.h"
 #include "Molassembler/Modeling/AtomInfo.h"
@@ -30,6 +31,23 @@ public:
   static constexpr double defaultLower = 0.0;
   static constexpr double defaultUpper = 100.0;
 
+  //! Triangle smoothing algorithms
+  enum class SmoothingAlgorithm {
+    //! Floyd's algorithm, updating bounds in place through each atom in turn
+    Floyd,
+    /*! @brief Blocked all-pairs shortest paths for the upper bounds, then
+     *   lower bounds from two max-plus products
+     *
+     * Upper bounds are smoothed by a cache-blocked Floyd-Warshall over
+     * tiles. The lower bounds then follow as
+     * @math{L'_{ij} = \max_{kl} (L_{kl} - U'_{ik} - U'_{lj})}. All phases are
+     * parallelized with OpenMP and vectorize over matrix columns. Yields the
+     * same bounds as Floyd's algorithm up to floating point rounding, but
+     * detects bound inversions only after all bounds are smoothed.
+     */
+    Blocked
+  };
+
 //!@name Static member functions
 //!@{
   static inline double& lowerBound(Eigen::Ref<Eigen::MatrixXd> matrix, const AtomIndex i, const AtomIndex j) {
@@ -48,11 +66,33 @@ public:
     return matrix(j, i);
   }
 
-  /*! @brief Uses Floyd's algorithm to smooth the matrix
+  /*! @brief Triangle smoothes the matrix
    *
    * @complexity{@math{\Theta(N^3)}}
+   *
+   * @throws std::runtime_error If a bound inversion is encountered
+   */
+  static void smooth(
+    Eigen::Ref<Eigen::MatrixXd> matrix,
+    SmoothingAlgorithm algorithm = SmoothingAlgorithm::Floyd
+  );
+
+  /*! @brief Re-smoothes a smooth matrix after bounds between some atoms
+   *   have been tightened
+   *
+   * Runs Floyd's algorithm with only the passed atoms as intermediates. If
+   * the matrix was smooth before bounds of pairs of @p affected atoms were
+   * tightened, the result is identical to a full smoothing.
+   *
+   * @complexity{@math{\Theta(AN^2)} where @math{A} is the number of
+   * affected atoms}
+   *
+   * @throws std::runtime_error If a bound inversion is encountered
    */
-  static void smooth(Eigen::Ref<Eigen::MatrixXd> matrix);
+  static void smooth(
+    Eigen::Ref<Eigen::MatrixXd> matrix,
+    const std::vector<AtomIndex>& affected
+  );
 //!@}
 
 //!@name Member types
@@ -109,8 +149,11 @@ public:
   bool setUpperBound(AtomIndex i, AtomIndex j, double newUpperBound);
   bool setLowerBound(AtomIndex i, AtomIndex j, double newLowerBound);
 
-  //! Smoothes the underlying matrix using smooth(Eigen::Ref<Eigen::MatrixXd>)
-  void smooth();
+  //! Smoothes the underlying matrix using smooth(Eigen::Ref<Eigen::MatrixXd>, SmoothingAlgorithm)
+  void smooth(SmoothingAlgorithm algorithm = SmoothingAlgorithm::Floyd);
+
+  //! Re-smoothes the underlying matrix through a subset of atoms
+  void smooth(const std::vector<AtomIndex>& affected);
 //!@}
 
 //!@name Information
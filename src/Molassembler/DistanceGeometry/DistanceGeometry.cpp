@@ -6,6 +6,8 @@
 
 #include "Molassembler/DistanceGeometry/DistanceGeometry.h"
 
+#include <algorithm>
+
 namespace Scine {
 namespace Molassembler {
 namespace DistanceGeometry {
@@ -37,6 +39,22 @@ DihedralConstraint::DihedralConstraint(
   }
 }
 
+unsigned smoothedAtomCount(const Partiality partiality, const unsigned N) {
+  switch(partiality) {
+    case Partiality::FourAtom:
+      return std::min(N, 4U);
+    case Partiality::All:
+      return N;
+    default:
+      /* At most N atoms, and at least four atoms (guards against situations
+       * where 4 <= N < 40 and 10% would yield less smoothing than FourAtom)
+       *
+       * Not equivalent to std::clamp(4u, cast<u>(0.1 * N), N) if N < 4!
+       */
+      return std::min(N, std::max(4U, static_cast<unsigned>(0.1 * N)));
+  }
+}
+
 } // namespace DistanceGeometry
 } // namespace Molassembler
 } // namespace Scine
@@ -12,6 +12,7 @@
 #define INCLUDE_MOLASSEMBLER_DISTANCE_GEOMETRY_H
 
 #include "Molassembler/DistanceGeometry/ValueBounds.h"
+#include "Molassembler/Conformers.h"
 #include "Molassembler/Types.h"
 
 #include <vector>
@@ -72,6 +73,16 @@ struct DihedralConstraint {
   DihedralConstraint(SiteSequence passSites, double passLower, double passUpper);
 };
 
+/*! @brief Number of atoms whose one-to-all distance choices are followed by
+ *   smoothing for a partiality
+ *
+ * Adaptive partiality is smoothed as TenPercent where no choice is made for
+ * it.
+ *
+ * @complexity{@math{\Theta(1)}}
+ */
+unsigned smoothedAtomCount(Partiality partiality, unsigned N);
+
 } // namespace DistanceGeometry
 } // namespace Molassembler
 } // namespace Scine
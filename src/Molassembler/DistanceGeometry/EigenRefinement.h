@@ -9,6 +9,10 @@
 #define INCLUDE_MOLASSEMBLER_DG_EIGEN_REFINEMENT_PROBLEM_H
 
 #include <Eigen/Dense>
+#include <Eigen/Sparse>
+#include <array>
+#include <limits>
+#include <vector>
 
 #include "Molassembler/DistanceGeometry/DistanceBoundsMatrix.h"
 
@@ -23,13 +27,20 @@ namespace DistanceGeometry {
  * @tparam FloatType float or double
  * @tparam SIMD Whether to use rewritten implementations that try to take
  *   advantage of Eigen's SIMD capabilities
+ * @tparam maxAtoms Maximum number of atoms, or Eigen::Dynamic. If bounded,
+ *   distance bounds and the workspaces of the SIMD distance kernel are stored
+ *   inline instead of on the heap. See dispatchAtomCount.
  */
-template<unsigned dimensionality, typename FloatType, bool SIMD>
+template<unsigned dimensionality, typename FloatType, bool SIMD, int maxAtoms = Eigen::Dynamic>
 class EigenRefinementProblem {
   static_assert(
     dimensionality == 3 || dimensionality == 4,
     "EigenRefinementProblem is only suitable for three or four dimensions"
   );
+  static_assert(
+    maxAtoms == Eigen::Dynamic || maxAtoms > 1,
+    "A bounded EigenRefinementProblem must allow at least two atoms"
+  );
 
 public:
 //!@name Public types
@@ -46,9 +57,32 @@ public:
   using ThreeDimensionalMatrixType = Eigen::Matrix<FloatType, 3, Eigen::Dynamic>;
   //! Three or four-row dynamic column matrix
   using FullDimensionalMatrixType = Eigen::Matrix<FloatType, dimensionality, Eigen::Dynamic>;
+  //! Batch layout of positions, each column holding a conformer's positions
+  using BatchMatrixType = Eigen::Matrix<FloatType, Eigen::Dynamic, Eigen::Dynamic>;
+  //! Dense Hessian matrix
+  using HessianType = Eigen::Matrix<FloatType, Eigen::Dynamic, Eigen::Dynamic>;
+  //! Sparse Hessian matrix
+  using SparseHessianType = Eigen::SparseMatrix<FloatType>;
   //! Template argument specifying floating-point type
   using FloatingPointType = FloatType;
 
+  //! Maximum number of atom pairs, or Eigen::Dynamic
+  static constexpr int maxPairs = (
+    maxAtoms == Eigen::Dynamic
+    ? Eigen::Dynamic
+    : maxAtoms * (maxAtoms - 1) / 2
+  );
+  //! Vector layout of atom pair data, linearized in i < j
+  using PairVectorType = Eigen::Matrix<FloatType, Eigen::Dynamic, 1, Eigen::ColMajor, maxPairs, 1>;
+  //! Array layout of per-constraint data
+  using ConstraintArrayType = Eigen::Array<FloatType, Eigen::Dynamic, 1>;
+  /*! @brief Site positions of all chiral constraints
+   *
+   * The first three sites of each constraint relative to its fourth site, each
+   * matrix holding a site of every constraint in its columns
+   */
+  using ChiralSitesType = std::array<ThreeDimensionalMatrixType, 3>;
+
   //! Visitor that can be passed to visit all terms
   struct DefaultTermVisitor {
     void distanceTerm(unsigned /* i */, unsigned /* j */, double /* value */) {}
@@ -78,11 +112,18 @@ public:
     }
 
     if(SIMD) {
-      name += ", SIMD=true>";
+      name += ", SIMD=true";
     } else {
-      name += ", SIMD=false>";
+      name += ", SIMD=false";
+    }
+
+    if(maxAtoms != Eigen::Dynamic) {
+      name += ", maxAtoms=";
+      name += std::to_string(maxAtoms);
     }
 
+    name += ">";
+
     return name;
   }
 
@@ -154,9 +195,9 @@ public:
 //!@name Public members
 //!@{
   //! Upper distance bounds squared, linearized in i < j
-  VectorType upperDistanceBoundsSquared;
+  PairVectorType upperDistanceBoundsSquared;
   //! Lower distance bounds squared, linearized in i < j
-  VectorType lowerDistanceBoundsSquared;
+  PairVectorType lowerDistanceBoundsSquared;
   //! Chiral upper constraints, in sequence of @p chiralConstraints
   VectorType chiralUpperConstraints;
   //! Chiral lower constraints, in sequence of @p chiralConstraints
@@ -167,17 +208,57 @@ public:
   VectorType dihedralConstraintDiffsHalved;
   //! List of chiral constraints
   std::vector<ChiralConstraint> chiralConstraints;
+  /*! @brief Atoms composing the sites of chiral constraints, packed
+   *
+   * Site @math{s} of chiral constraint @math{c} consists of the atoms in
+   * chiralSiteAtoms from chiralSiteOffsets[4c + s] up to
+   * chiralSiteOffsets[4c + s + 1].
+   */
+  std::vector<AtomIndex> chiralSiteAtoms;
+  //! Offsets of each chiral constraint site into @p chiralSiteAtoms
+  std::vector<unsigned> chiralSiteOffsets;
+  //! Chiral constraint weights, in sequence of @p chiralConstraints
+  VectorType chiralWeights;
+  /*! @brief Sign of each chiral constraint's lower bound, in sequence of
+   *   @p chiralConstraints
+   *
+   * Zero if the target volume is zero, so that only constraints with
+   * nonzero target volumes are counted in sign census.
+   */
+  VectorType chiralTargetSigns;
+  //! Number of chiral constraints with nonzero target volume
+  unsigned nonZeroChiralConstraints = 0;
   //! List of dihedral constraints
   std::vector<DihedralConstraint> dihedralConstraints;
+  /*! @brief Atoms composing the sites of dihedral constraints, packed
+   *
+   * Site @math{s} of dihedral constraint @math{d} consists of the atoms in
+   * dihedralSiteAtoms from dihedralSiteOffsets[4d + s] up to
+   * dihedralSiteOffsets[4d + s + 1].
+   */
+  std::vector<AtomIndex> dihedralSiteAtoms;
+  //! Offsets of each dihedral constraint site into @p dihedralSiteAtoms
+  std::vector<unsigned> dihedralSiteOffsets;
   //! Whether to compress the fourth dimension
   bool compressFourthDimension = false;
   //! Whether to enable dihedral terms
   bool dihedralTerms = false;
+  /*! @brief Skin width for sparse distance term evaluation
+   *
+   * If positive, atom pairs whose distance is within its bounds by at least
+   * this margin are skipped in distance error and gradient evaluations until
+   * any atom has moved by more than half the skin width. Since no such pair
+   * can reach its bounds in the meantime, the evaluation remains exact. If
+   * zero, all atom pairs are evaluated in each call.
+   */
+  FloatType distanceTermSkin = 0;
 //!@}
 
 //!@name Signaling members
 //!@{
   mutable double proportionChiralConstraintsCorrectSign = 0.0;
+  //! Proportion of correct sign chiral constraints of each conformer of the last batch evaluation
+  mutable std::vector<double> batchProportionsChiralConstraintsCorrectSign;
 //!@}
 
 //!@name Constructors
@@ -190,6 +271,7 @@ public:
       dihedralConstraints(std::move(passDihedralConstraints))
   {
     const unsigned N = squaredBounds.cols();
+    assert(maxAtoms == Eigen::Dynamic || N <= static_cast<unsigned>(maxAtoms));
     const unsigned strictlyUpperTriangularElements = N * (N - 1) / 2;
 
     // Lineize upper distance bounds squared
@@ -206,10 +288,27 @@ public:
     const unsigned C = chiralConstraints.size();
     chiralUpperConstraints.resize(C);
     chiralLowerConstraints.resize(C);
+    chiralWeights.resize(C);
+    chiralTargetSigns.resize(C);
+    chiralSiteOffsets.reserve(4 * C + 1);
+    chiralSiteOffsets.push_back(0);
     for(unsigned i = 0; i < C; ++i) {
       const ChiralConstraint& constraint = chiralConstraints[i];
       chiralUpperConstraints(i) = constraint.upper;
       chiralLowerConstraints(i) = constraint.lower;
+      chiralWeights(i) = constraint.weight;
+      if(constraint.targetVolumeIsZero()) {
+        chiralTargetSigns(i) = 0;
+      } else {
+        chiralTargetSigns(i) = (constraint.lower > 0) - (constraint.lower < 0);
+        ++nonZeroChiralConstraints;
+      }
+
+      // Pack sites into a contiguous atom list
+      for(const auto& site : constraint.sites) {
+        chiralSiteAtoms.insert(std::end(chiralSiteAtoms), std::begin(site), std::end(site));
+        chiralSiteOffsets.push_back(chiralSiteAtoms.size());
+      }
     }
 
     // Vectorize dihedral constraint bounds sum halves and diff halves
@@ -221,6 +320,16 @@ public:
       dihedralConstraintSumsHalved(i) = (constraint.upper + constraint.lower) / 2;
       dihedralConstraintDiffsHalved(i) = (constraint.upper - constraint.lower) / 2;
     }
+
+    // Pack dihedral sites into a contiguous atom list
+    dihedralSiteOffsets.reserve(4 * D + 1);
+    dihedralSiteOffsets.push_back(0);
+    for(const DihedralConstraint& constraint : dihedralConstraints) {
+      for(const auto& site : constraint.sites) {
+        dihedralSiteAtoms.insert(std::end(dihedralSiteAtoms), std::begin(site), std::end(site));
+        dihedralSiteOffsets.push_back(dihedralSiteAtoms.size());
+      }
+    }
   }
 //!@}
 
@@ -235,6 +344,11 @@ public:
     FloatType& error,
     Eigen::Ref<VectorType> gradient
   ) const {
+    if(distanceTermSkin > 0) {
+      sparseDistanceContributions(positions, error, gradient);
+      return;
+    }
+
     // Delegate to SIMD or non-SIMD implementation
     distanceContributionsImpl(positions, error, gradient, DefaultTermVisitor {});
   }
@@ -295,54 +409,256 @@ public:
     chiralContributions(parameters, value, gradient);
   }
 
-  /*! @brief Calculates the number of chiral constraints with correct sign
+  /*! @brief Calculates the error value, gradient and dense Hessian
    *
-   * @complexity{@math{\Theta(C)} where @math{C} is the number of chiral
-   * constraints}
+   * Suitable for second-order optimizers such as Temple::TrustRegionOptimizer.
+   *
+   * @see visitHessian
    */
-  double calculateProportionChiralConstraintsCorrectSign(const VectorType& positions) const {
-    unsigned nonZeroChiralConstraints = 0;
-    unsigned incorrectNonZeroChiralConstraints = 0;
+  void operator() (
+    const VectorType& parameters,
+    FloatType& value,
+    Eigen::Ref<VectorType> gradient,
+    Eigen::Ref<HessianType> hessian
+  ) const {
+    assert(hessian.rows() == parameters.size() && hessian.cols() == parameters.size());
+    (*this)(parameters, value, gradient);
+
+    hessian.setZero();
+    visitHessian(
+      parameters,
+      [&](const unsigned row, const unsigned col, const FloatType entry) {
+        hessian(row, col) += entry;
+      }
+    );
+  }
 
-    for(const auto& constraint : chiralConstraints) {
-      /* Make sure that chiral constraints meant to cause coplanarity of
-       * four indices aren't counted here - Their volume bounds are
-       * usually so tight that they might be slightly outside in any given
-       * refinement step. If they are outside their target values by a large
-       * amount, that is caught by finalStructureAcceptable anyway.
-       */
-      if(!constraint.targetVolumeIsZero()) {
-        nonZeroChiralConstraints += 1;
-
-        const ThreeDimensionalVector delta = getAveragePosition3D(positions, constraint.sites[3]);
-
-        const double volume = (
-          getAveragePosition3D(positions, constraint.sites[0]) - delta
-        ).dot(
-          (
-            getAveragePosition3D(positions, constraint.sites[1]) - delta
-          ).cross(
-            getAveragePosition3D(positions, constraint.sites[2]) - delta
-          )
-        );
+  /*! @brief Calculates the sparse Hessian of the error function
+   *
+   * @see visitHessian
+   */
+  void hessian(const VectorType& parameters, SparseHessianType& hessian) const {
+    std::vector<Eigen::Triplet<FloatType>> triplets;
+    visitHessian(
+      parameters,
+      [&](const unsigned row, const unsigned col, const FloatType entry) {
+        triplets.emplace_back(row, col, entry);
+      }
+    );
 
-        if( // can this be simplified? -> sign bit XOR?
-          (volume < 0 && constraint.lower > 0)
-          || (volume > 0 && constraint.lower < 0)
-        ) {
-          incorrectNonZeroChiralConstraints += 1;
+    hessian.resize(parameters.size(), parameters.size());
+    // Duplicate entries are summed
+    hessian.setFromTriplets(std::begin(triplets), std::end(triplets));
+  }
+
+  /*! @brief Passes all contributions to the Hessian of the error function
+   *   to a function
+   *
+   * The Hessian is the Jacobian of the gradient calculated by operator().
+   * Distance, chiral and fourth dimension terms are differentiated
+   * analytically, dihedral terms by central differences of their site
+   * gradients. Only terms outside of their bounds contribute, so the Hessian
+   * of a nearly refined structure is sparse. Distance terms are always
+   * evaluated densely.
+   *
+   * @param parameters The linearized positions of all particles
+   * @param add Called with row, column and value of each contribution.
+   *   Contributions to the same entry are to be summed.
+   *
+   * @complexity{@math{\Theta(N^2 + C + D)}}
+   */
+  template<typename Accumulator>
+  void visitHessian(const VectorType& parameters, Accumulator&& add) const {
+    assert(parameters.size() % dimensionality == 0);
+
+    distanceHessianImpl(parameters, add);
+    chiralHessianImpl(parameters, add);
+    if(dihedralTerms) {
+      dihedralHessianImpl(parameters, add);
+    }
+
+    if(dimensionality == 4 && compressFourthDimension) {
+      const unsigned N = parameters.size() / dimensionality;
+      for(unsigned i = 0; i < N; ++i) {
+        add(dimensionality * i + 3, dimensionality * i + 3, FloatType {2});
+      }
+    }
+  }
+
+  /*! @brief Calculates error values and gradients for a batch of conformers
+   *   of the same molecule
+   *
+   * Distance terms of all conformers are evaluated in a single pass over the
+   * bounds (see distanceContributionsBatch), and the remaining terms per
+   * conformer. Distance terms are always evaluated densely.
+   *
+   * @param[in] parameters Linearized positions, one conformer per column
+   * @param[out] values Error function value of each conformer
+   * @param[out] gradients Gradient of each conformer, one per column
+   *
+   * @post Chiral constraint sign proportions of each conformer are stored in
+   *   batchProportionsChiralConstraintsCorrectSign
+   */
+  void evaluateBatch(
+    const BatchMatrixType& parameters,
+    Eigen::Ref<VectorType> values,
+    Eigen::Ref<BatchMatrixType> gradients
+  ) const {
+    assert(parameters.rows() == gradients.rows());
+    assert(parameters.cols() == gradients.cols());
+    assert(parameters.cols() == values.size());
+    assert(parameters.rows() % dimensionality == 0);
+
+    const unsigned K = parameters.cols();
+    values.setZero();
+    gradients.setZero();
+    batchProportionsChiralConstraintsCorrectSign.resize(K);
+
+    distanceContributionsBatch(parameters, values, gradients);
+
+    VectorType conformer;
+    for(unsigned k = 0; k < K; ++k) {
+      conformer = parameters.col(k);
+      Eigen::Ref<VectorType> gradient = gradients.col(k);
+      fourthDimensionContributions(conformer, values(k), gradient);
+      dihedralContributions(conformer, values(k), gradient);
+      chiralContributions(conformer, values(k), gradient);
+      batchProportionsChiralConstraintsCorrectSign[k] = proportionChiralConstraintsCorrectSign;
+    }
+  }
+
+  /*! @brief Adds pairwise distance error and gradient contributions of a
+   *   batch of conformers
+   *
+   * The bounds of each atom pair are read once for all conformers. If
+   * compiled with MOLASSEMBLER_OFFLOAD_REFINEMENT, the terms are instead
+   * evaluated in an OpenMP target region with one team per conformer, which
+   * runs on an offload device if one is available and on the host
+   * otherwise.
+   *
+   * @complexity{@math{\Theta(KN^2)}}
+   */
+  void distanceContributionsBatch(
+    const BatchMatrixType& positions,
+    Eigen::Ref<VectorType> errors,
+    Eigen::Ref<BatchMatrixType> gradients
+  ) const {
+    const unsigned P = positions.rows();
+    const unsigned K = positions.cols();
+    const unsigned N = P / dimensionality;
+    if(N < 2) {
+      return;
+    }
+
+    const FloatType* const x = positions.data();
+    const FloatType* const lower = lowerDistanceBoundsSquared.data();
+    const FloatType* const upper = upperDistanceBoundsSquared.data();
+    FloatType* const g = gradients.data();
+    FloatType* const e = errors.data();
+
+#ifdef MOLASSEMBLER_OFFLOAD_REFINEMENT
+    const unsigned M = N * (N - 1) / 2;
+#pragma omp target teams distribute map(to: x[0:P * K], lower[0:M], upper[0:M]) map(tofrom: g[0:P * K], e[0:K])
+    for(unsigned k = 0; k < K; ++k) {
+      const FloatType* const xk = x + k * P;
+      FloatType* const gk = g + k * P;
+      FloatType conformerError = 0;
+
+#pragma omp parallel for reduction(+:conformerError) schedule(static, 1)
+      for(unsigned i = 0; i < N - 1; ++i) {
+        // Linear index of pair (i, i + 1)
+        unsigned linearIndex = i * (2 * N - i - 1) / 2;
+        for(unsigned j = i + 1; j < N; ++j, ++linearIndex) {
+          FloatType difference[dimensionality];
+          FloatType squareDistance = 0;
+          for(unsigned d = 0; d < dimensionality; ++d) {
+            difference[d] = xk[dimensionality * i + d] - xk[dimensionality * j + d];
+            squareDistance += difference[d] * difference[d];
+          }
+
+          FloatType factor = 0;
+          const FloatType upperTerm = squareDistance / upper[linearIndex] - 1;
+          if(upperTerm > 0) {
+            conformerError += upperTerm * upperTerm;
+            factor = 4 * upperTerm / upper[linearIndex];
+          } else {
+            const FloatType quotient = lower[linearIndex] + squareDistance;
+            const FloatType lowerTerm = 2 * lower[linearIndex] / quotient - 1;
+            if(lowerTerm > 0) {
+              conformerError += lowerTerm * lowerTerm;
+              factor = -8 * lower[linearIndex] * lowerTerm / (quotient * quotient);
+            }
+          }
+
+          if(factor != 0) {
+            for(unsigned d = 0; d < dimensionality; ++d) {
+              const FloatType f = factor * difference[d];
+#pragma omp atomic
+              gk[dimensionality * i + d] += f;
+#pragma omp atomic
+              gk[dimensionality * j + d] -= f;
+            }
+          }
         }
       }
+
+      e[k] += conformerError;
     }
+#else
+    for(unsigned linearIndex = 0, i = 0; i < N - 1; ++i) {
+      for(unsigned j = i + 1; j < N; ++j, ++linearIndex) {
+        const FloatType lowerBoundSquared = lower[linearIndex];
+        const FloatType upperBoundSquared = upper[linearIndex];
+        assert(lowerBoundSquared <= upperBoundSquared);
 
-    if(nonZeroChiralConstraints == 0) {
-      proportionChiralConstraintsCorrectSign = 1.0;
-    } else {
-      proportionChiralConstraintsCorrectSign = static_cast<double>(
-        nonZeroChiralConstraints - incorrectNonZeroChiralConstraints
-      ) / nonZeroChiralConstraints;
+        for(unsigned k = 0; k < K; ++k) {
+          const FloatType* const xk = x + k * P;
+          FloatType* const gk = g + k * P;
+
+          FloatType difference[dimensionality];
+          FloatType squareDistance = 0;
+          for(unsigned d = 0; d < dimensionality; ++d) {
+            difference[d] = xk[dimensionality * i + d] - xk[dimensionality * j + d];
+            squareDistance += difference[d] * difference[d];
+          }
+
+          // Same terms as in addDistanceTerm
+          FloatType factor = 0;
+          const FloatType upperTerm = squareDistance / upperBoundSquared - 1;
+          if(upperTerm > 0) {
+            e[k] += upperTerm * upperTerm;
+            factor = 4 * upperTerm / upperBoundSquared;
+          } else {
+            const FloatType quotient = lowerBoundSquared + squareDistance;
+            const FloatType lowerTerm = 2 * lowerBoundSquared / quotient - 1;
+            if(lowerTerm > 0) {
+              e[k] += lowerTerm * lowerTerm;
+              factor = -8 * lowerBoundSquared * lowerTerm / (quotient * quotient);
+            }
+          }
+
+          if(factor != 0) {
+            for(unsigned d = 0; d < dimensionality; ++d) {
+              gk[dimensionality * i + d] += factor * difference[d];
+              gk[dimensionality * j + d] -= factor * difference[d];
+            }
+          }
+        }
+      }
     }
+#endif
+  }
 
+  /*! @brief Calculates the number of chiral constraints with correct sign
+   *
+   * @complexity{@math{\Theta(C)} where @math{C} is the number of chiral
+   * constraints}
+   */
+  double calculateProportionChiralConstraintsCorrectSign(const VectorType& positions) const {
+    ChiralSitesType sites;
+    ConstraintArrayType volumes;
+    chiralVolumes(positions, sites, volumes);
+    proportionChiralConstraintsCorrectSign = chiralSignCensus(volumes);
     return proportionChiralConstraintsCorrectSign;
   }
 
@@ -478,6 +794,14 @@ public:
   }
 
 private:
+  //! Three-dimensional positions or gradients of four constraint sites
+  using SitePositions = Eigen::Matrix<FloatType, 3, 4>;
+
+  //! Positions at the last neighbor list rebuild
+  mutable VectorType neighborListReference_;
+  //! Atom pairs and linear pair index that may contribute to the distance error
+  mutable std::vector<std::array<unsigned, 3>> neighborList_;
+
 //!@name Contribution implementations
 //!@{
   /*!
@@ -495,60 +819,133 @@ private:
 
     for(unsigned linearIndex = 0, i = 0; i < N - 1; ++i) {
       for(unsigned j = i + 1; j < N; ++j, ++linearIndex) {
-        const FloatType lowerBoundSquared = lowerDistanceBoundsSquared(linearIndex);
-        const FloatType upperBoundSquared = upperDistanceBoundsSquared(linearIndex);
-        assert(lowerBoundSquared <= upperBoundSquared);
+        addDistanceTerm(i, j, linearIndex, positions, error, gradient, visitor);
+      }
+    }
+  }
 
-        // For both
-        const FullDimensionalVector positionDifference = (
-          positions.template segment<dimensionality>(dimensionality * i)
-          - positions.template segment<dimensionality>(dimensionality * j)
+  //! Adds the distance error and gradient contributions of a single atom pair
+  template<class Visitor>
+  inline void addDistanceTerm(
+    const unsigned i,
+    const unsigned j,
+    const unsigned linearIndex,
+    const VectorType& positions,
+    FloatType& error,
+    Eigen::Ref<VectorType> gradient,
+    Visitor&& visitor
+  ) const {
+    const FloatType lowerBoundSquared = lowerDistanceBoundsSquared(linearIndex);
+    const FloatType upperBoundSquared = upperDistanceBoundsSquared(linearIndex);
+    assert(lowerBoundSquared <= upperBoundSquared);
+
+    // For both
+    const FullDimensionalVector positionDifference = (
+      positions.template segment<dimensionality>(dimensionality * i)
+      - positions.template segment<dimensionality>(dimensionality * j)
+    );
+
+    const FloatType squareDistance = positionDifference.squaredNorm();
+
+    // Upper term
+    const FloatType upperTerm = squareDistance / upperBoundSquared - 1;
+
+    if(upperTerm > 0) {
+      const FloatType value = upperTerm * upperTerm;
+      error += value;
+      visitor.distanceTerm(i, j, value);
+
+      const FullDimensionalVector f = 4 * positionDifference * upperTerm / upperBoundSquared;
+
+      gradient.template segment<dimensionality>(dimensionality * i) += f;
+      gradient.template segment<dimensionality>(dimensionality * j) -= f;
+    } else {
+      // Lower term is only possible if the upper term does not contribute
+      const FloatType quotient = lowerBoundSquared + squareDistance;
+      const FloatType lowerTerm = 2 * lowerBoundSquared / quotient - 1;
+
+      if(lowerTerm > 0) {
+        const FloatType value = lowerTerm * lowerTerm;
+        error += value;
+        visitor.distanceTerm(i, j, value);
+
+        const FullDimensionalVector g = 8 * lowerBoundSquared * positionDifference * lowerTerm / (
+          quotient * quotient
         );
 
-        const FloatType squareDistance = positionDifference.squaredNorm();
+        /* We use -= because the lower term needs the position vector
+         * difference (j - i), so we reuse positionDifference and just subtract
+         * from the gradient instead of adding to it
+         */
+        gradient.template segment<dimensionality>(dimensionality * i) -= g;
+        gradient.template segment<dimensionality>(dimensionality * j) += g;
+      } else {
+        visitor.distanceTerm(i, j, 0.0);
+      }
+    }
+  }
 
-        // Upper term
-        const FloatType upperTerm = squareDistance / upperBoundSquared - 1;
+  /*!
+   * @brief Adds distance contributions of atom pairs in the neighbor list
+   *
+   * Rebuilds the neighbor list if any atom has moved by more than half the
+   * skin width since the last rebuild.
+   */
+  void sparseDistanceContributions(
+    const VectorType& positions,
+    FloatType& error,
+    Eigen::Ref<VectorType> gradient
+  ) const {
+    assert(positions.size() == gradient.size());
+    const unsigned N = positions.size() / dimensionality;
 
-        if(upperTerm > 0) {
-          const FloatType value = upperTerm * upperTerm;
-          error += value;
-          visitor.distanceTerm(i, j, value);
+    bool rebuild = (neighborListReference_.size() != positions.size());
+    if(!rebuild) {
+      const FloatType halfSkinSquared = distanceTermSkin * distanceTermSkin / 4;
+      for(unsigned i = 0; i < N; ++i) {
+        const FloatType displacementSquared = (
+          positions.template segment<dimensionality>(dimensionality * i)
+          - neighborListReference_.template segment<dimensionality>(dimensionality * i)
+        ).squaredNorm();
 
-          const FullDimensionalVector f = 4 * positionDifference * upperTerm / upperBoundSquared;
+        if(displacementSquared > halfSkinSquared) {
+          rebuild = true;
+          break;
+        }
+      }
+    }
 
-          gradient.template segment<dimensionality>(dimensionality * i) += f;
-          gradient.template segment<dimensionality>(dimensionality * j) -= f;
-        } else {
-          // Lower term is only possible if the upper term does not contribute
-          const FloatType quotient = lowerBoundSquared + squareDistance;
-          const FloatType lowerTerm = 2 * lowerBoundSquared / quotient - 1;
+    if(rebuild) {
+      neighborListReference_ = positions;
+      neighborList_.clear();
+      for(unsigned linearIndex = 0, i = 0; i < N - 1; ++i) {
+        for(unsigned j = i + 1; j < N; ++j, ++linearIndex) {
+          const FloatType distance = (
+            positions.template segment<dimensionality>(dimensionality * i)
+            - positions.template segment<dimensionality>(dimensionality * j)
+          ).norm();
 
-          if(lowerTerm > 0) {
-            const FloatType value = lowerTerm * lowerTerm;
-            error += value;
-            visitor.distanceTerm(i, j, value);
-
-            const FullDimensionalVector g = 8 * lowerBoundSquared * positionDifference * lowerTerm / (
-              quotient * quotient
-            );
-
-            /* We use -= because the lower term needs the position vector
-             * difference (j - i), so we reuse positionDifference and just subtract
-             * from the gradient instead of adding to it
-             */
-            gradient.template segment<dimensionality>(dimensionality * i) -= g;
-            gradient.template segment<dimensionality>(dimensionality * j) += g;
-          } else {
-            visitor.distanceTerm(i, j, 0.0);
+          if(
+            distance < std::sqrt(lowerDistanceBoundsSquared(linearIndex)) + distanceTermSkin
+            || distance > std::sqrt(upperDistanceBoundsSquared(linearIndex)) - distanceTermSkin
+          ) {
+            neighborList_.push_back({{i, j, linearIndex}});
           }
         }
       }
     }
+
+    for(const auto& pair : neighborList_) {
+      addDistanceTerm(pair[0], pair[1], pair[2], positions, error, gradient, DefaultTermVisitor {});
+    }
   }
 
   /*!
    * @brief SIMD implementation of distance contributions
+   *
+   * Transposes the positions into a structure-of-arrays layout so that the
+   * terms of all pairs (i, j > i) of a particular atom i are evaluated
+   * branch-free across contiguous coordinate columns.
    */
   template<class Visitor, bool dependent = SIMD, std::enable_if_t<dependent, int>...>
   void distanceContributionsImpl(
@@ -562,135 +959,94 @@ private:
      *
      * NOTE: positions are full-dimensional
      *
-     * for each nonredundant pair of atoms (i < j)
-     *   Calculate a squared vector distance:
-     *   sq_distance = (position[j] - position[i]).array().square().sum()
-     *
-     *   upper_term = (sq_distance / upperBoundSquared) - 1
-     *
-     *   if upper_term > 0:
-     *     error += upper_term.square()
-     *
-     *   lower_term = (
-     *    2 * lowerBoundSquared / (lowerBoundSquared + sq_distance)
-     *   ) - 1
-     *
-     *   if lowerTerm > 0:
-     *     error += lower_term.square()
+     * for each atom i:
+     *   differences = position[i] - position[j > i] (one row per j)
+     *   sq_distances = differences.rowwise().squaredNorm()
      *
-     * SIMDize:
-     *   sq_distances = list of upper triangular square distance terms
-     *   upper_bounds_sq = list of corresponding upper bounds (identical across runs, no need to gather multiple times)
-     *   lower_bounds_sq = list of corresponding lower bounds (same as above)
+     *   upper_terms = max(sq_distances / upper_bounds_sq - 1, 0)
+     *   lower_terms = max(2 * lower_bounds_sq / (lower_bounds_sq + sq_distances) - 1, 0)
+     *   error += (upper_terms.square() + lower_terms.square()).sum()
      *
-     *   upper_terms = (sq_distances / upper_bounds_sq) - 1
-     *   error += upper_terms.max(0.0).square().sum()
-     *
-     *   lower_terms = (2 * lower_bounds_sq / (lower_bounds_sq + sq_distances)) - 1
-     *   error += lower_terms.max(0.0).square().sum()
+     *   factors = 4 * upper_terms / upper_bounds_sq
+     *     - 8 * lower_bounds_sq * lower_terms / (lower_bounds_sq + sq_distances)^2
+     *   gradient[i] += (factors * differences).colwise().sum()
+     *   gradient[j > i] -= factors * differences
      *
+     * Since lower bounds never exceed upper bounds, at most one of the upper
+     * and lower terms of a pair is positive, so no branching is needed.
      */
+    // Bounded atom counts keep the workspaces on the stack
+    using SoAMatrixType = Eigen::Matrix<FloatType, Eigen::Dynamic, dimensionality, Eigen::ColMajor, maxAtoms, dimensionality>;
+    using ArrayType = Eigen::Array<FloatType, Eigen::Dynamic, 1, Eigen::ColMajor, maxAtoms, 1>;
 
-    // Calculate all full-dimensional N(N-1) / 2 position differences
     const unsigned N = positions.size() / dimensionality;
-    const unsigned differencesCount = N * (N - 1) / 2;
-
-    FullDimensionalMatrixType positionDifferences(dimensionality, differencesCount);
-    {
-      unsigned offset = 0;
-      for(unsigned i = 0; i < N - 1; ++i) {
-        auto iPosition = positions.template segment<dimensionality>(dimensionality * i);
-        for(unsigned j = i + 1; j < N; ++j) {
-          positionDifferences.col(offset) = (
-            iPosition
-            - positions.template segment<dimensionality>(dimensionality * j)
-          );
-          ++offset;
-        }
-      }
+    if(N < 2) {
+      return;
     }
 
-    // SIMD
-    const VectorType squareDistances = positionDifferences.colwise().squaredNorm();
-
-    // SIMD
-    const VectorType upperTerms = squareDistances.array() / upperDistanceBoundsSquared.array() - 1;
-
-#ifndef NDEBUG
-    {
-      // Check correctness of results so far
-      unsigned offset = 0;
-      for(unsigned i = 0; i < N - 1; ++i) {
-        for(unsigned j = i + 1; j < N; ++j) {
-          const FullDimensionalVector positionDifference = (
-            positions.template segment<dimensionality>(dimensionality * i)
-            - positions.template segment<dimensionality>(dimensionality * j)
-          );
-
-          assert(positionDifferences.col(offset) == positionDifference);
-
-          const FloatType squareDistance = positionDifference.squaredNorm();
-
-          assert(squareDistance == squareDistances(offset));
-
-          // Upper term
-          const FloatType upperTerm = squareDistance / upperDistanceBoundsSquared(offset) - 1;
-
-          assert(upperTerm == upperTerms(offset));
-
-          ++offset;
-        }
+    const SoAMatrixType soaPositions = Eigen::Map<const FullDimensionalMatrixType>(
+      positions.data(),
+      dimensionality,
+      N
+    ).transpose();
+    SoAMatrixType soaGradient = SoAMatrixType::Zero(N, dimensionality);
+
+    // Per-atom workspace, sized for the atom with the most pairs
+    SoAMatrixType differences(N - 1, dimensionality);
+    ArrayType squareDistances(N - 1);
+    ArrayType quotients(N - 1);
+    ArrayType upperTerms(N - 1);
+    ArrayType lowerTerms(N - 1);
+    ArrayType factors(N - 1);
+
+    for(unsigned offset = 0, i = 0; i < N - 1; ++i) {
+      const unsigned crossTerms = N - i - 1;
+      auto iDifferences = differences.topRows(crossTerms);
+      auto iSquareDistances = squareDistances.head(crossTerms);
+      auto iQuotients = quotients.head(crossTerms);
+      auto iUpperTerms = upperTerms.head(crossTerms);
+      auto iLowerTerms = lowerTerms.head(crossTerms);
+      auto iFactors = factors.head(crossTerms);
+
+      const auto upperBoundsSquared = upperDistanceBoundsSquared.segment(offset, crossTerms).array();
+      const auto lowerBoundsSquared = lowerDistanceBoundsSquared.segment(offset, crossTerms).array();
+
+      // position difference is i - j, not j - i (!)
+      iSquareDistances.setZero();
+      for(unsigned d = 0; d < dimensionality; ++d) {
+        iDifferences.col(d).array() = soaPositions(i, d) - soaPositions.col(d).tail(crossTerms).array();
+        iSquareDistances += iDifferences.col(d).array().square();
       }
-    }
-#endif
+      iQuotients = lowerBoundsSquared + iSquareDistances;
 
-    // Traverse upper terms and calculate gradients
-    for(unsigned iOffset = 0, i = 0; i < N - 1; ++i) {
-      const unsigned crossTerms = N - i - 1;
-      for(unsigned jOffset = 0, j = i + 1;  j < N; ++j, ++jOffset) {
-        const FloatType upperTerm = upperTerms(iOffset + jOffset);
-        if(upperTerm > 0) {
-          error += upperTerm * upperTerm;
-
-          /* This i-j combination has an upper value contribution
-           *
-           * calculate gradient and apply to i and j
-           */
-          const FullDimensionalVector f = (
-            4 * positionDifferences.col(iOffset + jOffset) * upperTerm
-            / upperDistanceBoundsSquared(iOffset + jOffset)
-          );
-
-          // position difference is i - j, not j - i (!)
-          gradient.template segment<dimensionality>(dimensionality * i) += f;
-          gradient.template segment<dimensionality>(dimensionality * j) -= f;
-        } else {
-          /* This i-j combination MAYBE has a lower value contribution
-           */
-          const auto& lowerBoundSquared = lowerDistanceBoundsSquared(iOffset + jOffset);
-          const FloatType quotient = lowerBoundSquared + squareDistances(iOffset + jOffset);
-          const FloatType lowerTerm = 2 * lowerBoundSquared / quotient - 1;
+      iUpperTerms = iSquareDistances / upperBoundsSquared - 1;
+      iUpperTerms = (iUpperTerms > 0).select(iUpperTerms, 0);
+      iLowerTerms = 2 * lowerBoundsSquared / iQuotients - 1;
+      // Selection also discards NaNs from coincident atoms with zero lower bound
+      iLowerTerms = (iLowerTerms > 0).select(iLowerTerms, 0);
 
-          if(lowerTerm > 0) {
-            // Add it to the error
-            error += lowerTerm * lowerTerm;
+      error += (iUpperTerms.square() + iLowerTerms.square()).sum();
 
-            // Calculate gradient and apply
-            const FullDimensionalVector g = (
-              8 * lowerBoundSquared * positionDifferences.col(iOffset + jOffset) * lowerTerm / (
-                quotient * quotient
-              )
-            );
+      iFactors = 4 * iUpperTerms / upperBoundsSquared;
+      iFactors -= (iLowerTerms > 0).select(
+        8 * lowerBoundsSquared * iLowerTerms / iQuotients.square(),
+        0
+      );
 
-            // position difference is i - j, not j - i (!)
-            gradient.template segment<dimensionality>(dimensionality * i) -= g;
-            gradient.template segment<dimensionality>(dimensionality * j) += g;
-          }
-        }
+      for(unsigned d = 0; d < dimensionality; ++d) {
+        iDifferences.col(d).array() *= iFactors;
+        soaGradient(i, d) += iDifferences.col(d).sum();
+        soaGradient.col(d).tail(crossTerms) -= iDifferences.col(d);
       }
 
-      iOffset += crossTerms;
+      offset += crossTerms;
     }
+
+    Eigen::Map<FullDimensionalMatrixType>(
+      gradient.data(),
+      dimensionality,
+      N
+    ) += soaGradient.transpose();
   }
 
   /*!
@@ -703,110 +1059,128 @@ private:
     Eigen::Ref<VectorType> gradient,
     Visitor&& visitor
   ) const {
-    unsigned nonZeroChiralConstraints = 0;
-    unsigned incorrectNonZeroChiralConstraints = 0;
+    ChiralSitesType sites;
+    ConstraintArrayType volumes;
+    chiralVolumes(positions, sites, volumes);
 
-    for(const auto& constraint : chiralConstraints) {
-      const ThreeDimensionalVector alpha = getAveragePosition3D(positions, constraint.sites[0]);
-      const ThreeDimensionalVector beta = getAveragePosition3D(positions, constraint.sites[1]);
-      const ThreeDimensionalVector gamma = getAveragePosition3D(positions, constraint.sites[2]);
-      const ThreeDimensionalVector delta = getAveragePosition3D(positions, constraint.sites[3]);
+    // Set signaling member
+    proportionChiralConstraintsCorrectSign = chiralSignCensus(volumes);
 
-      const ThreeDimensionalVector alphaMinusDelta = alpha - delta;
-      const ThreeDimensionalVector betaMinusDelta = beta - delta;
-      const ThreeDimensionalVector gammaMinusDelta = gamma - delta;
+    const ConstraintArrayType upperTerms = (
+      chiralWeights.array() * (volumes - chiralUpperConstraints.array())
+    ).max(0);
+    const ConstraintArrayType lowerTerms = (
+      chiralWeights.array() * (chiralLowerConstraints.array() - volumes)
+    ).max(0);
+    error += (upperTerms.square() + lowerTerms.square()).sum();
+    const ConstraintArrayType factors = 2 * (upperTerms - lowerTerms);
 
-      const FloatType volume = (alphaMinusDelta).dot(
-        betaMinusDelta.cross(gammaMinusDelta)
-      );
-
-      if(!constraint.targetVolumeIsZero()) {
-        ++nonZeroChiralConstraints;
-        if(
-          ( volume < 0 && constraint.lower > 0)
-          || (volume > 0 && constraint.lower < 0)
-        ) {
-          ++incorrectNonZeroChiralConstraints;
-        }
-      }
+    const auto& alphaMinusDelta = sites[0];
+    const auto& betaMinusDelta = sites[1];
+    const auto& gammaMinusDelta = sites[2];
 
-      // Upper bound term
-      const FloatType upperTerm = static_cast<FloatType>(constraint.weight) * (volume - static_cast<FloatType>(constraint.upper));
-      if(upperTerm > 0) {
-        const FloatType value = upperTerm * upperTerm;
-        error += value;
-        visitor.chiralTerm(constraint.sites, value);
+    const unsigned C = chiralConstraints.size();
+    for(unsigned c = 0; c < C; ++c) {
+      const ChiralConstraint::SiteSequence& constraintSites = chiralConstraints[c].sites;
+      if(upperTerms(c) > 0) {
+        visitor.chiralTerm(constraintSites, upperTerms(c) * upperTerms(c));
       }
-
-      // Lower bound term
-      const FloatType lowerTerm = static_cast<FloatType>(constraint.weight) * (static_cast<FloatType>(constraint.lower) - volume);
-      if(lowerTerm > 0) {
-        const FloatType value = lowerTerm * lowerTerm;
-        error += value;
-        visitor.chiralTerm(constraint.sites, value);
+      if(lowerTerms(c) > 0) {
+        visitor.chiralTerm(constraintSites, lowerTerms(c) * lowerTerms(c));
       }
 
-      const FloatType factor = 2 * (
-        std::max(FloatType {0}, upperTerm)
-        - std::max(FloatType {0}, lowerTerm)
-      );
-
       /* Make sure computing all cross products is worth it by checking that
        * one of both terms is actually greater than 0
        */
-      if(factor != 0) {
-        // Specific to deltaI only but still repeated
-        const ThreeDimensionalVector alphaMinusGamma = alpha - gamma;
-        const ThreeDimensionalVector betaMinusGamma = beta - gamma;
-
-        const ThreeDimensionalVector iContribution = (
-          factor * betaMinusDelta.cross(gammaMinusDelta)
-          / constraint.sites[0].size()
-        );
-
-        const ThreeDimensionalVector jContribution = (
-          factor * gammaMinusDelta.cross(alphaMinusDelta)
-          / constraint.sites[1].size()
-        );
-
-        const ThreeDimensionalVector kContribution = (
-          factor * alphaMinusDelta.cross(betaMinusDelta)
-          / constraint.sites[2].size()
-        );
-
-        const ThreeDimensionalVector lContribution = (
-          factor * betaMinusGamma.cross(alphaMinusGamma)
-          / constraint.sites[3].size()
-        );
+      const FloatType factor = factors(c);
+      if(factor == 0) {
+        visitor.chiralTerm(constraintSites, 0.0);
+        continue;
+      }
 
-        for(const AtomIndex alphaI : constraint.sites[0]) {
-          gradient.template segment<3>(dimensionality * alphaI) += iContribution;
+      const ThreeDimensionalVector alpha = alphaMinusDelta.col(c);
+      const ThreeDimensionalVector beta = betaMinusDelta.col(c);
+      const ThreeDimensionalVector gamma = gammaMinusDelta.col(c);
+
+      const std::array<ThreeDimensionalVector, 4> contributions {{
+        factor * beta.cross(gamma),
+        factor * gamma.cross(alpha),
+        factor * alpha.cross(beta),
+        factor * (beta - gamma).cross(alpha - gamma)
+      }};
+
+      for(unsigned siteIndex = 0; siteIndex < 4; ++siteIndex) {
+        const unsigned begin = chiralSiteOffsets[4 * c + siteIndex];
+        const unsigned end = chiralSiteOffsets[4 * c + siteIndex + 1];
+        const ThreeDimensionalVector contribution = contributions[siteIndex] / (end - begin);
+        for(unsigned k = begin; k < end; ++k) {
+          gradient.template segment<3>(dimensionality * chiralSiteAtoms[k]) += contribution;
         }
+      }
+    }
+  }
 
-        for(const AtomIndex betaI : constraint.sites[1]) {
-          gradient.template segment<3>(dimensionality * betaI) += jContribution;
-        }
+  /*! @brief Calculates the signed volumes of all chiral constraints
+   *
+   * Gathers averaged site positions from the packed site atom lists into
+   * @p sites, then evaluates all volumes at once on their rows.
+   *
+   * @complexity{@math{\Theta(A)} where @math{A} is the number of atoms in
+   * all chiral constraint sites}
+   */
+  void chiralVolumes(
+    const VectorType& positions,
+    ChiralSitesType& sites,
+    ConstraintArrayType& volumes
+  ) const {
+    const unsigned C = chiralConstraints.size();
+    ThreeDimensionalMatrixType delta(3, C);
+    for(auto& site : sites) {
+      site.resize(3, C);
+    }
 
-        for(const AtomIndex gammaI : constraint.sites[2]) {
-          gradient.template segment<3>(dimensionality * gammaI) += kContribution;
+    for(unsigned c = 0; c < C; ++c) {
+      for(unsigned siteIndex = 0; siteIndex < 4; ++siteIndex) {
+        const unsigned begin = chiralSiteOffsets[4 * c + siteIndex];
+        const unsigned end = chiralSiteOffsets[4 * c + siteIndex + 1];
+        ThreeDimensionalVector sum = getPosition3D(positions, chiralSiteAtoms[begin]);
+        for(unsigned k = begin + 1; k < end; ++k) {
+          sum += getPosition3D(positions, chiralSiteAtoms[k]);
         }
 
-        for(const AtomIndex deltaI : constraint.sites[3]) {
-          gradient.template segment<3>(dimensionality * deltaI) += lContribution;
+        if(siteIndex < 3) {
+          sites[siteIndex].col(c) = sum / (end - begin);
+        } else {
+          delta.col(c) = sum / (end - begin);
         }
-      } else {
-        visitor.chiralTerm(constraint.sites, 0.0);
       }
     }
 
-    // Set signaling member
+    for(auto& site : sites) {
+      site -= delta;
+    }
+
+    // Triple products alpha . (beta x gamma) on whole rows
+    const auto& alpha = sites[0];
+    const auto& beta = sites[1];
+    const auto& gamma = sites[2];
+    volumes = (
+      alpha.row(0).array() * (beta.row(1).array() * gamma.row(2).array() - beta.row(2).array() * gamma.row(1).array())
+      + alpha.row(1).array() * (beta.row(2).array() * gamma.row(0).array() - beta.row(0).array() * gamma.row(2).array())
+      + alpha.row(2).array() * (beta.row(0).array() * gamma.row(1).array() - beta.row(1).array() * gamma.row(0).array())
+    ).transpose();
+  }
+
+  /*! @brief Proportion of chiral constraints with nonzero target volume whose
+   *   volumes have the correct sign
+   */
+  double chiralSignCensus(const ConstraintArrayType& volumes) const {
     if(nonZeroChiralConstraints == 0) {
-      proportionChiralConstraintsCorrectSign = 1;
-    } else {
-      proportionChiralConstraintsCorrectSign = static_cast<double>(
-        nonZeroChiralConstraints - incorrectNonZeroChiralConstraints
-      ) / nonZeroChiralConstraints;
+      return 1;
     }
+
+    const unsigned incorrect = (volumes * chiralTargetSigns.array() < 0).count();
+    return static_cast<double>(nonZeroChiralConstraints - incorrect) / nonZeroChiralConstraints;
   }
 
   /*!
@@ -820,126 +1194,161 @@ private:
     Visitor&& visitor
   ) const {
     assert(positions.size() == gradient.size());
-    constexpr FloatType reductionFactor = 1.0 / 10;
-
-    for(const DihedralConstraint& constraint : dihedralConstraints) {
-      const ThreeDimensionalVector alpha = getAveragePosition3D(positions, constraint.sites[0]);
-      const ThreeDimensionalVector beta = getAveragePosition3D(positions, constraint.sites[1]);
-      const ThreeDimensionalVector gamma = getAveragePosition3D(positions, constraint.sites[2]);
-      const ThreeDimensionalVector delta = getAveragePosition3D(positions, constraint.sites[3]);
-
-      const ThreeDimensionalVector f = alpha - beta;
-      const ThreeDimensionalVector g = beta - gamma;
-      const ThreeDimensionalVector h = delta - gamma;
-
-      ThreeDimensionalVector a = f.cross(g);
-      ThreeDimensionalVector b = h.cross(g);
-
-      const FloatType constraintSumHalved = (static_cast<FloatType>(constraint.lower) + static_cast<FloatType>(constraint.upper)) / 2;
-      constexpr FloatType pi {M_PI};
 
-      // Calculate the dihedral angle
-      FloatType phi = std::atan2(
-        a.cross(b).dot(-g.normalized()),
-        a.dot(b)
-      );
+    ThreeDimensionalMatrixType sites;
+    dihedralSitePositions(positions, sites);
 
-      if(phi < constraintSumHalved - pi) {
-        phi += 2 * pi;
-      } else if(phi > constraintSumHalved + pi) {
-        phi -= 2 * pi;
-      }
-
-      const FloatType w_phi = phi - constraintSumHalved;
-
-      FloatType h_phi = std::fabs(w_phi) - (static_cast<FloatType>(constraint.upper) - static_cast<FloatType>(constraint.lower)) / 2;
+    SitePositions sitePositions;
+    SitePositions siteGradients;
+    const unsigned D = dihedralConstraints.size();
+    for(unsigned d = 0; d < D; ++d) {
+      const DihedralConstraint& constraint = dihedralConstraints[d];
+      sitePositions = sites.template middleCols<4>(4 * d);
 
-      /* "Apply the max function": If h <= 0, then the max function yields zero,
-       * so we can skip this constraint
-       */
-      if(h_phi <= 0) {
+      FloatType errorContribution;
+      if(!dihedralSiteTerms(constraint, sitePositions, errorContribution, siteGradients)) {
         visitor.dihedralTerm(constraint.sites, 0.0);
         continue;
       }
 
-      // Error contribution
-      const FloatType errorContribution = h_phi * h_phi * reductionFactor;
       error += errorContribution;
       visitor.dihedralTerm(constraint.sites, errorContribution);
 
-      // Multiply with sgn (w)
-      h_phi *= static_cast<int>(0 < w_phi) - static_cast<int>(w_phi < 0);
-
-      // Multiply in 2 and the reduction factor
-      h_phi *= 2 * reductionFactor;
-
-      // Precompute some reused expressions
-      const FloatType gLength = g.norm();
-      if(gLength == 0) {
-        throw std::runtime_error("Encountered zero-length g vector in dihedral errors");
+      if(!siteGradients.array().isFinite().all()) {
+        throw std::runtime_error("Encountered non-finite dihedral gradient contributions");
       }
 
-      const FloatType aLengthSq = a.squaredNorm();
-      if(aLengthSq == 0) {
-        throw std::runtime_error("Encountered zero-length a vector in dihedral gradient contributions");
+      /* Distribute contributions among constituting indices */
+      for(unsigned s = 0; s < 4; ++s) {
+        const unsigned begin = dihedralSiteOffsets[4 * d + s];
+        const unsigned end = dihedralSiteOffsets[4 * d + s + 1];
+        const ThreeDimensionalVector contribution = siteGradients.col(s) / (end - begin);
+        for(unsigned k = begin; k < end; ++k) {
+          gradient.template segment<3>(dimensionality * dihedralSiteAtoms[k]) += contribution;
+        }
       }
-      a /= aLengthSq;
-      const FloatType bLengthSq = b.squaredNorm();
-      if(bLengthSq == 0) {
-        throw std::runtime_error("Encountered zero-length b vector in dihedral gradient contributions");
+    }
+  }
+
+  /*! @brief Gathers the averaged site positions of all dihedral constraints
+   *
+   * Column @math{4d + s} of @p sites holds site @math{s} of dihedral
+   * constraint @math{d}, averaged from the packed site atom lists in a single
+   * pass.
+   *
+   * @complexity{@math{\Theta(A)} where @math{A} is the number of atoms in
+   * all dihedral constraint sites}
+   */
+  void dihedralSitePositions(
+    const VectorType& positions,
+    ThreeDimensionalMatrixType& sites
+  ) const {
+    const unsigned S = dihedralSiteOffsets.size() - 1;
+    sites.resize(3, S);
+    for(unsigned s = 0; s < S; ++s) {
+      const unsigned begin = dihedralSiteOffsets[s];
+      const unsigned end = dihedralSiteOffsets[s + 1];
+      ThreeDimensionalVector sum = getPosition3D(positions, dihedralSiteAtoms[begin]);
+      for(unsigned k = begin + 1; k < end; ++k) {
+        sum += getPosition3D(positions, dihedralSiteAtoms[k]);
       }
-      b /= bLengthSq;
-      const FloatType fDotG = f.dot(g);
-      const FloatType gDotH = g.dot(h);
+      sites.col(s) = sum / (end - begin);
+    }
+  }
 
-      const ThreeDimensionalVector iContribution = (
-        -(h_phi / constraint.sites[0].size()) * gLength * a
-      );
+  /*! @brief Calculates the error and site gradients of a dihedral constraint
+   *
+   * @param constraint The dihedral constraint
+   * @param sitePositions Averaged positions of the constraint's sites, one
+   *   per column
+   * @param[out] value Error contribution of the constraint
+   * @param[out] siteGradients Gradient of the error contribution with
+   *   respect to each site position, one per column
+   *
+   * @returns Whether the constraint contributes to the error. If not, @p
+   *   value and @p siteGradients are not set.
+   */
+  static bool dihedralSiteTerms(
+    const DihedralConstraint& constraint,
+    const SitePositions& sitePositions,
+    FloatType& value,
+    SitePositions& siteGradients
+  ) {
+    constexpr FloatType reductionFactor = 1.0 / 10;
 
-      const ThreeDimensionalVector jContribution = (
-        (h_phi / constraint.sites[1].size()) * (
-          (gLength + fDotG / gLength) * a
-          - (gDotH / gLength) * b
-        )
-      );
+    const ThreeDimensionalVector f = sitePositions.col(0) - sitePositions.col(1);
+    const ThreeDimensionalVector g = sitePositions.col(1) - sitePositions.col(2);
+    const ThreeDimensionalVector h = sitePositions.col(3) - sitePositions.col(2);
 
-      const ThreeDimensionalVector kContribution = (
-        (h_phi / constraint.sites[2].size()) * (
-          (gDotH / gLength - gLength) * b
-          - (fDotG / gLength) * a
-        )
-      );
+    ThreeDimensionalVector a = f.cross(g);
+    ThreeDimensionalVector b = h.cross(g);
 
-      const ThreeDimensionalVector lContribution = (
-        (h_phi / constraint.sites[3].size()) * gLength * b
-      );
+    const FloatType constraintSumHalved = (static_cast<FloatType>(constraint.lower) + static_cast<FloatType>(constraint.upper)) / 2;
+    constexpr FloatType pi {M_PI};
 
-      if(
-        !iContribution.array().isFinite().all()
-        || !jContribution.array().isFinite().all()
-        || !kContribution.array().isFinite().all()
-        || !lContribution.array().isFinite().all()
-      ) {
-        throw std::runtime_error("Encountered non-finite dihedral gradient contributions");
-      }
+    // Calculate the dihedral angle
+    FloatType phi = std::atan2(
+      a.cross(b).dot(-g.normalized()),
+      a.dot(b)
+    );
 
-      /* Distribute contributions among constituting indices */
-      for(const AtomIndex alphaConstitutingIndex : constraint.sites[0]) {
-        gradient.template segment<3>(dimensionality * alphaConstitutingIndex) += iContribution;
-      }
+    if(phi < constraintSumHalved - pi) {
+      phi += 2 * pi;
+    } else if(phi > constraintSumHalved + pi) {
+      phi -= 2 * pi;
+    }
 
-      for(const AtomIndex betaConstitutingIndex: constraint.sites[1]) {
-        gradient.template segment<3>(dimensionality * betaConstitutingIndex) += jContribution;
-      }
+    const FloatType w_phi = phi - constraintSumHalved;
 
-      for(const AtomIndex gammaConstitutingIndex : constraint.sites[2]) {
-        gradient.template segment<3>(dimensionality * gammaConstitutingIndex) += kContribution;
-      }
+    FloatType h_phi = std::fabs(w_phi) - (static_cast<FloatType>(constraint.upper) - static_cast<FloatType>(constraint.lower)) / 2;
 
-      for(const AtomIndex deltaConstitutingIndex : constraint.sites[3]) {
-        gradient.template segment<3>(dimensionality * deltaConstitutingIndex) += lContribution;
-      }
+    /* "Apply the max function": If h <= 0, then the max function yields zero,
+     * so we can skip this constraint
+     */
+    if(h_phi <= 0) {
+      return false;
     }
+
+    // Error contribution
+    value = h_phi * h_phi * reductionFactor;
+
+    // Multiply with sgn (w)
+    h_phi *= static_cast<int>(0 < w_phi) - static_cast<int>(w_phi < 0);
+
+    // Multiply in 2 and the reduction factor
+    h_phi *= 2 * reductionFactor;
+
+    // Precompute some reused expressions
+    const FloatType gLength = g.norm();
+    if(gLength == 0) {
+      throw std::runtime_error("Encountered zero-length g vector in dihedral errors");
+    }
+
+    const FloatType aLengthSq = a.squaredNorm();
+    if(aLengthSq == 0) {
+      throw std::runtime_error("Encountered zero-length a vector in dihedral gradient contributions");
+    }
+    a /= aLengthSq;
+    const FloatType bLengthSq = b.squaredNorm();
+    if(bLengthSq == 0) {
+      throw std::runtime_error("Encountered zero-length b vector in dihedral gradient contributions");
+    }
+    b /= bLengthSq;
+    const FloatType fDotG = f.dot(g);
+    const FloatType gDotH = g.dot(h);
+
+    siteGradients.col(0) = -h_phi * gLength * a;
+    siteGradients.col(1) = h_phi * (
+      (gLength + fDotG / gLength) * a
+      - (gDotH / gLength) * b
+    );
+    siteGradients.col(2) = h_phi * (
+      (gDotH / gLength - gLength) * b
+      - (fDotG / gLength) * a
+    );
+    siteGradients.col(3) = h_phi * gLength * b;
+
+    return true;
   }
 
   /*! @brief Adds fourth dimension error and gradient contributions
@@ -974,8 +1383,277 @@ private:
     }
   }
 //!@}
+
+//!@name Hessian implementations
+//!@{
+  //! Cross product matrix @math{[v]_\times} such that @math{[v]_\times x = v \times x}
+  static Eigen::Matrix<FloatType, 3, 3> crossProductMatrix(const ThreeDimensionalVector& v) {
+    Eigen::Matrix<FloatType, 3, 3> matrix;
+    matrix <<     0, -v.z(),  v.y(),
+              v.z(),      0, -v.x(),
+             -v.y(),  v.x(),      0;
+    return matrix;
+  }
+
+  //! Passes a block of second derivatives between two atoms to a function
+  template<int size, typename Accumulator>
+  static void addAtomBlock(
+    Accumulator& add,
+    const unsigned i,
+    const unsigned j,
+    const Eigen::Matrix<FloatType, size, size>& block
+  ) {
+    for(unsigned col = 0; col < size; ++col) {
+      for(unsigned row = 0; row < size; ++row) {
+        add(dimensionality * i + row, dimensionality * j + col, block(row, col));
+      }
+    }
+  }
+
+  //! Distributes second derivatives with respect to site positions among atoms
+  template<typename Sites, typename Accumulator>
+  static void addSiteBlocks(
+    Accumulator& add,
+    const Sites& sites,
+    const Eigen::Matrix<FloatType, 12, 12>& siteHessian
+  ) {
+    for(unsigned s = 0; s < 4; ++s) {
+      for(unsigned t = 0; t < 4; ++t) {
+        const Eigen::Matrix<FloatType, 3, 3> block = (
+          siteHessian.template block<3, 3>(3 * s, 3 * t)
+          / (sites[s].size() * sites[t].size())
+        );
+        for(const AtomIndex i : sites[s]) {
+          for(const AtomIndex j : sites[t]) {
+            addAtomBlock<3>(add, i, j, block);
+          }
+        }
+      }
+    }
+  }
+
+  /*! @brief Passes distance term Hessian contributions to a function
+   *
+   * The gradient of a pair term with respect to the position difference
+   * @math{d = x_i - x_j} is @math{c(s) d} with @math{s = |d|^2}, so its
+   * second derivatives are @math{c I + 2 c'(s) d d^T}.
+   */
+  template<typename Accumulator>
+  void distanceHessianImpl(const VectorType& positions, Accumulator& add) const {
+    using BlockType = Eigen::Matrix<FloatType, dimensionality, dimensionality>;
+    const unsigned N = positions.size() / dimensionality;
+
+    for(unsigned linearIndex = 0, i = 0; i + 1 < N; ++i) {
+      for(unsigned j = i + 1; j < N; ++j, ++linearIndex) {
+        const FloatType lowerBoundSquared = lowerDistanceBoundsSquared(linearIndex);
+        const FloatType upperBoundSquared = upperDistanceBoundsSquared(linearIndex);
+
+        const FullDimensionalVector positionDifference = (
+          positions.template segment<dimensionality>(dimensionality * i)
+          - positions.template segment<dimensionality>(dimensionality * j)
+        );
+        const FloatType squareDistance = positionDifference.squaredNorm();
+
+        // Same terms as in addDistanceTerm
+        FloatType factor;
+        FloatType factorDerivative;
+        const FloatType upperTerm = squareDistance / upperBoundSquared - 1;
+        if(upperTerm > 0) {
+          factor = 4 * upperTerm / upperBoundSquared;
+          factorDerivative = 4 / (upperBoundSquared * upperBoundSquared);
+        } else {
+          const FloatType quotient = lowerBoundSquared + squareDistance;
+          const FloatType lowerTerm = 2 * lowerBoundSquared / quotient - 1;
+          if(!(lowerTerm > 0)) {
+            continue;
+          }
+
+          factor = -8 * lowerBoundSquared * lowerTerm / (quotient * quotient);
+          factorDerivative = 16 * lowerBoundSquared * (
+            lowerBoundSquared / quotient + lowerTerm
+          ) / (quotient * quotient * quotient);
+        }
+
+        const BlockType block = (
+          factor * BlockType::Identity()
+          + 2 * factorDerivative * positionDifference * positionDifference.transpose()
+        );
+
+        addAtomBlock<dimensionality>(add, i, i, block);
+        addAtomBlock<dimensionality>(add, j, j, block);
+        addAtomBlock<dimensionality>(add, i, j, -block);
+        addAtomBlock<dimensionality>(add, j, i, -block);
+      }
+    }
+  }
+
+  /*! @brief Passes chiral term Hessian contributions to a function
+   *
+   * The gradient of a chiral term is @math{c \nabla V} for the signed volume
+   * @math{V}, which is trilinear in the site positions relative to the
+   * fourth site.
+   */
+  template<typename Accumulator>
+  void chiralHessianImpl(const VectorType& positions, Accumulator& add) const {
+    using Matrix3 = Eigen::Matrix<FloatType, 3, 3>;
+    using Matrix12 = Eigen::Matrix<FloatType, 12, 12>;
+    using Vector12 = Eigen::Matrix<FloatType, 12, 1>;
+
+    // Maps site positions onto positions relative to the fourth site
+    Eigen::Matrix<FloatType, 9, 12> relative = Eigen::Matrix<FloatType, 9, 12>::Zero();
+    relative.template leftCols<9>().setIdentity();
+    for(unsigned s = 0; s < 3; ++s) {
+      relative.template block<3, 3>(3 * s, 9) = -Matrix3::Identity();
+    }
+
+    for(const auto& constraint : chiralConstraints) {
+      const ThreeDimensionalVector alpha = getAveragePosition3D(positions, constraint.sites[0]);
+      const ThreeDimensionalVector beta = getAveragePosition3D(positions, constraint.sites[1]);
+      const ThreeDimensionalVector gamma = getAveragePosition3D(positions, constraint.sites[2]);
+      const ThreeDimensionalVector delta = getAveragePosition3D(positions, constraint.sites[3]);
+
+      const ThreeDimensionalVector alphaMinusDelta = alpha - delta;
+      const ThreeDimensionalVector betaMinusDelta = beta - delta;
+      const ThreeDimensionalVector gammaMinusDelta = gamma - delta;
+
+      const FloatType volume = alphaMinusDelta.dot(
+        betaMinusDelta.cross(gammaMinusDelta)
+      );
+
+      // Same terms as in chiralContributionsImpl
+      const FloatType weight = constraint.weight;
+      const FloatType upperTerm = weight * (volume - static_cast<FloatType>(constraint.upper));
+      const FloatType lowerTerm = weight * (static_cast<FloatType>(constraint.lower) - volume);
+      if(upperTerm <= 0 && lowerTerm <= 0) {
+        continue;
+      }
+
+      const FloatType factor = 2 * (
+        std::max(FloatType {0}, upperTerm)
+        - std::max(FloatType {0}, lowerTerm)
+      );
+
+      Vector12 volumeGradient;
+      volumeGradient.template segment<3>(0) = betaMinusDelta.cross(gammaMinusDelta);
+      volumeGradient.template segment<3>(3) = gammaMinusDelta.cross(alphaMinusDelta);
+      volumeGradient.template segment<3>(6) = alphaMinusDelta.cross(betaMinusDelta);
+      volumeGradient.template segment<3>(9) = (beta - gamma).cross(alpha - gamma);
+
+      // Second derivatives of the volume in the relative positions
+      Eigen::Matrix<FloatType, 9, 9> relativeHessian = Eigen::Matrix<FloatType, 9, 9>::Zero();
+      relativeHessian.template block<3, 3>(0, 3) = -crossProductMatrix(gammaMinusDelta);
+      relativeHessian.template block<3, 3>(3, 0) = crossProductMatrix(gammaMinusDelta);
+      relativeHessian.template block<3, 3>(0, 6) = crossProductMatrix(betaMinusDelta);
+      relativeHessian.template block<3, 3>(6, 0) = -crossProductMatrix(betaMinusDelta);
+      relativeHessian.template block<3, 3>(3, 6) = -crossProductMatrix(alphaMinusDelta);
+      relativeHessian.template block<3, 3>(6, 3) = crossProductMatrix(alphaMinusDelta);
+
+      const Matrix12 siteHessian = (
+        2 * weight * volumeGradient * volumeGradient.transpose()
+        + factor * relative.transpose() * relativeHessian * relative
+      );
+
+      addSiteBlocks(add, constraint.sites, siteHessian);
+    }
+  }
+
+  /*! @brief Passes dihedral term Hessian contributions to a function
+   *
+   * Differentiates the site gradients of each contributing constraint by
+   * central differences.
+   */
+  template<typename Accumulator>
+  void dihedralHessianImpl(const VectorType& positions, Accumulator& add) const {
+    using Matrix12 = Eigen::Matrix<FloatType, 12, 12>;
+    using Vector12 = Eigen::Matrix<FloatType, 12, 1>;
+    const FloatType step = std::cbrt(std::numeric_limits<FloatType>::epsilon());
+
+    ThreeDimensionalMatrixType sites;
+    dihedralSitePositions(positions, sites);
+
+    SitePositions sitePositions;
+    SitePositions forwardGradients;
+    SitePositions backwardGradients;
+    FloatType value;
+    const unsigned D = dihedralConstraints.size();
+    for(unsigned d = 0; d < D; ++d) {
+      const DihedralConstraint& constraint = dihedralConstraints[d];
+      sitePositions = sites.template middleCols<4>(4 * d);
+
+      if(!dihedralSiteTerms(constraint, sitePositions, value, forwardGradients)) {
+        continue;
+      }
+
+      Matrix12 siteHessian;
+      for(unsigned p = 0; p < 12; ++p) {
+        // Site positions are column-major, so p is site p / 3, component p % 3
+        FloatType& coordinate = sitePositions(p % 3, p / 3);
+        const FloatType original = coordinate;
+
+        coordinate = original + step;
+        if(!dihedralSiteTerms(constraint, sitePositions, value, forwardGradients)) {
+          forwardGradients.setZero();
+        }
+        coordinate = original - step;
+        if(!dihedralSiteTerms(constraint, sitePositions, value, backwardGradients)) {
+          backwardGradients.setZero();
+        }
+        coordinate = original;
+
+        siteHessian.col(p) = (
+          Eigen::Map<const Vector12>(forwardGradients.data())
+          - Eigen::Map<const Vector12>(backwardGradients.data())
+        ) / (2 * step);
+      }
+
+      const Matrix12 symmetrized = (siteHessian + siteHessian.transpose()) / 2;
+      addSiteBlocks(add, constraint.sites, symmetrized);
+    }
+  }
+//!@}
+
+public:
+  EIGEN_MAKE_ALIGNED_OPERATOR_NEW_IF(maxAtoms != Eigen::Dynamic)
 };
 
+template<unsigned dimensionality, typename FloatType, bool SIMD, int maxAtoms>
+constexpr int EigenRefinementProblem<dimensionality, FloatType, SIMD, maxAtoms>::maxPairs;
+
+/**
+ * @brief Calls a function with the bounded atom count bucket fitting a molecule
+ *
+ * Refinement problems instantiated with the bucket as their maxAtoms template
+ * argument store their distance data inline. Molecules with more atoms than
+ * the largest bucket get Eigen::Dynamic.
+ *
+ * @code{.cpp}
+ * dispatchAtomCount(N, [&](auto maxAtoms) {
+ *   EigenRefinementProblem<4, double, false, decltype(maxAtoms)::value> problem {...};
+ * });
+ * @endcode
+ *
+ * @param N Number of atoms
+ * @param f Function called with a std::integral_constant<int, maxAtoms>
+ *
+ * @returns The return value of @p f
+ */
+template<typename F>
+auto dispatchAtomCount(const unsigned N, F&& f) {
+  if(N <= 8) {
+    return f(std::integral_constant<int, 8> {});
+  }
+
+  if(N <= 16) {
+    return f(std::integral_constant<int, 16> {});
+  }
+
+  if(N <= 32) {
+    return f(std::integral_constant<int, 32> {});
+  }
+
+  return f(std::integral_constant<int, Eigen::Dynamic> {});
+}
+
 /**
  * @brief This is for when you have a fully qualified Refinement typename but
  *   want to get the template arguments back
@@ -984,15 +1662,17 @@ template<typename RefinementType>
 struct RefinementTraits {
   // Trick to make the compiler tell me the template arguments to RefinementType
   template<
-    template<unsigned, typename, bool> class BaseClass,
+    template<unsigned, typename, bool, int> class BaseClass,
     unsigned dimensionality,
     typename FloatingPointType,
-    bool SIMD
-  > static auto templateArgumentHelper(BaseClass<dimensionality, FloatingPointType, SIMD> /* a */)
+    bool SIMD,
+    int maxAtoms
+  > static auto templateArgumentHelper(BaseClass<dimensionality, FloatingPointType, SIMD, maxAtoms> /* a */)
     -> std::tuple<
       std::integral_constant<unsigned, dimensionality>,
       FloatingPointType,
-      std::integral_constant<bool, SIMD>
+      std::integral_constant<bool, SIMD>,
+      std::integral_constant<int, maxAtoms>
     >
   {
     return {};
@@ -1002,6 +1682,7 @@ struct RefinementTraits {
   using DimensionalityConstant = std::tuple_element_t<0, TemplateArgumentsTuple>;
   using FloatingPointType = std::tuple_element_t<1, TemplateArgumentsTuple>;
   using SimdConstant = std::tuple_element_t<2, TemplateArgumentsTuple>;
+  using MaxAtomsConstant = std::tuple_element_t<3, TemplateArgumentsTuple>;
 };
 
 } // namespace DistanceGeometry
@@ -51,6 +51,11 @@ enum class DgError {
    * get this error to indicate that the spatial model cannot deal with your
    * input graph.
    *
+   * Spatial models shared between conformers are diagnosed once before any
+   * conformer is attempted. If the diagnosis finds contradictory distance
+   * bounds or unattainable chiral constraint volumes, all conformers fail
+   * with this error immediately.
+   *
    * If you get this error, reconsider whether your input graph is reasonable
    * and representable in three dimensions. If you are sure it is, please
    * contact us and open an issue.
@@ -116,7 +121,22 @@ enum class DgError {
   /**
    * @brief Unknown exception
    */
-  UnknownException = 8
+  UnknownException = 8,
+  /**
+   * @brief An embedding was discarded before completing refinement since its
+   *   chiral constraints were unlikely to be corrected
+   *
+   * Only occurs if chirality screening or probing is enabled in the
+   * configuration. Rejected embeddings would likely have yielded
+   * RefinedChiralsWrong after using up their refinement iterations.
+   *
+   * Generate more conformers or loosen the screening thresholds.
+   */
+  EmbeddingRejected = 9,
+  /**
+   * @brief Generation was cancelled by the configuration's cancellation token
+   */
+  Cancelled = 10
 };
 
 // Boilerplate to allow interoperability of DgError with std::error_code
@@ -148,6 +168,10 @@ namespace Detail {
           return "Failed to generate decision list.";
         case DgError::UnknownException:
           return "Conformer generation encountered an unexpected exception.";
+        case DgError::EmbeddingRejected:
+          return "Embedding rejected by chirality screening.";
+        case DgError::Cancelled:
+          return "Conformer generation was cancelled.";
         default:
           return "Unknown error.";
       };
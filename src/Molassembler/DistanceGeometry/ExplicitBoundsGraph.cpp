@@ -25,6 +25,9 @@
 #include "Molassembler/Graph/Gor1.h"
 #endif
 
+#include <deque>
+#include <limits>
+
 
 /* Using Dijkstra's shortest paths despite there being negative edge weights is
  * alright since there are, by construction, no negative edge weight sum cycles,
@@ -38,12 +41,47 @@
 namespace Scine {
 namespace Molassembler {
 namespace DistanceGeometry {
+namespace {
+
+// Determine the two heaviest element types in the molecule, O(N)
+std::array<Utils::ElementType, 2> findHeaviestAtoms(const PrivateGraph& inner) {
+  std::array<Utils::ElementType, 2> heaviestAtoms {{Utils::ElementType::H, Utils::ElementType::H}};
+  const AtomIndex N = inner.N();
+  for(AtomIndex i = 0; i < N; ++i) {
+    auto elementType = inner.elementType(i);
+    if(
+      Utils::ElementInfo::Z(elementType)
+      > Utils::ElementInfo::Z(heaviestAtoms.back())
+    ) {
+      heaviestAtoms.back() = elementType;
+
+      if(
+        Utils::ElementInfo::Z(heaviestAtoms.back())
+        > Utils::ElementInfo::Z(heaviestAtoms.front())
+      ) {
+        std::swap(heaviestAtoms.front(), heaviestAtoms.back());
+      }
+    }
+  }
+  return heaviestAtoms;
+}
+
+} // namespace
+
+ExplicitBoundsGraph::ShortestPathsBuffers::ShortestPathsBuffers(const std::size_t M)
+  : distances(M),
+    predecessors(M),
+    colorMap {M},
+    queued(M, false),
+    relabelCounts(M, 0)
+{}
 
 ExplicitBoundsGraph::ExplicitBoundsGraph(
   const PrivateGraph& inner,
   const BoundsMatrix& bounds
 ) : graph_ {2 * inner.N()},
-    inner_ {inner}
+    inner_ {inner},
+    buffers_ {2 * inner.N()}
 {
   const AtomIndex N = inner.N();
 
@@ -82,31 +120,15 @@ ExplicitBoundsGraph::ExplicitBoundsGraph(
     }
   }
 
-  // Determine the two heaviest element types in the molecule, O(N)
-  heaviestAtoms_ = {{Utils::ElementType::H, Utils::ElementType::H}};
-  for(AtomIndex i = 0; i < N; ++i) {
-    auto elementType = inner.elementType(i);
-    if(
-      Utils::ElementInfo::Z(elementType)
-      > Utils::ElementInfo::Z(heaviestAtoms_.back())
-    ) {
-      heaviestAtoms_.back() = elementType;
-
-      if(
-        Utils::ElementInfo::Z(heaviestAtoms_.back())
-        > Utils::ElementInfo::Z(heaviestAtoms_.front())
-      ) {
-        std::swap(heaviestAtoms_.front(), heaviestAtoms_.back());
-      }
-    }
-  }
+  heaviestAtoms_ = findHeaviestAtoms(inner);
 }
 
 ExplicitBoundsGraph::ExplicitBoundsGraph(
   const PrivateGraph& inner,
   const DistanceBoundsMatrix& bounds
 ) : graph_ {2 * inner.N()},
-    inner_ {inner}
+    inner_ {inner},
+    buffers_ {2 * inner.N()}
 {
   const VertexDescriptor N = inner.N();
   for(VertexDescriptor a = 0; a < N; ++a) {
@@ -141,24 +163,69 @@ ExplicitBoundsGraph::ExplicitBoundsGraph(
     }
   }
 
-  // Determine the two heaviest element types in the molecule, O(N)
-  heaviestAtoms_ = {{Utils::ElementType::H, Utils::ElementType::H}};
-  for(AtomIndex i = 0; i < N; ++i) {
-    auto elementType = inner.elementType(i);
-    if(
-      Utils::ElementInfo::Z(elementType)
-      > Utils::ElementInfo::Z(heaviestAtoms_.back())
-    ) {
-      heaviestAtoms_.back() = elementType;
+  heaviestAtoms_ = findHeaviestAtoms(inner);
+}
 
-      if(
-        Utils::ElementInfo::Z(heaviestAtoms_.back())
-        > Utils::ElementInfo::Z(heaviestAtoms_.front())
-      ) {
-        std::swap(heaviestAtoms_.front(), heaviestAtoms_.back());
+ExplicitBoundsGraph::ExplicitBoundsGraph(
+  const PrivateGraph& inner,
+  const SparseBoundsMatrix& bounds
+) : graph_ {2 * inner.N()},
+    inner_ {inner},
+    buffers_ {2 * inner.N()}
+{
+  const AtomIndex N = inner.N();
+  assert(static_cast<AtomIndex>(bounds.cols()) == N);
+
+  /* Column a holds the lower bounds of a to all b > a, and column a of the
+   * transpose holds the upper bounds. Scatter both into dense rows so that
+   * pairs can be visited in the same order as from a dense matrix.
+   */
+  const SparseBoundsMatrix transposed = bounds.transpose();
+  std::vector<double> lowerRow(N, 0.0);
+  std::vector<double> upperRow(N, 0.0);
+
+  for(AtomIndex a = 0; a < N; ++a) {
+    for(SparseBoundsMatrix::InnerIterator it(bounds, a); it; ++it) {
+      if(static_cast<AtomIndex>(it.row()) > a) {
+        lowerRow.at(it.row()) = it.value();
       }
     }
+    for(SparseBoundsMatrix::InnerIterator it(transposed, a); it; ++it) {
+      if(static_cast<AtomIndex>(it.row()) > a) {
+        upperRow.at(it.row()) = it.value();
+      }
+    }
+
+    for(AtomIndex b = a + 1; b < N; ++b) {
+      const double lowerBound = lowerRow.at(b);
+      const double upperBound = upperRow.at(b);
+      assert(lowerBound <= upperBound);
+
+      if(lowerBound == 0.0 && upperBound == 0.0) {
+        const double vdwLowerBound = (
+          AtomInfo::vdwRadius(inner.elementType(a))
+          + AtomInfo::vdwRadius(inner.elementType(b))
+        );
+
+        boost::add_edge(left(a), right(b), -vdwLowerBound, graph_);
+        boost::add_edge(left(b), right(a), -vdwLowerBound, graph_);
+      } else {
+        boost::add_edge(left(a), left(b), upperBound, graph_);
+        boost::add_edge(left(b), left(a), upperBound, graph_);
+
+        boost::add_edge(right(a), right(b), upperBound, graph_);
+        boost::add_edge(right(b), right(a), upperBound, graph_);
+
+        boost::add_edge(left(a), right(b), -lowerBound, graph_);
+        boost::add_edge(left(b), right(a), -lowerBound, graph_);
+      }
+
+      lowerRow.at(b) = 0.0;
+      upperRow.at(b) = 0.0;
+    }
   }
+
+  heaviestAtoms_ = findHeaviestAtoms(inner);
 }
 
 void ExplicitBoundsGraph::addBound(
@@ -215,16 +282,92 @@ void ExplicitBoundsGraph::explainContradictionPaths(
   }
 }
 
-void ExplicitBoundsGraph::updateOrAddEdge_(
+std::size_t ExplicitBoundsGraph::flatEdgeIndex_(
+  const VertexDescriptor i,
+  const VertexDescriptor j
+) const {
+  /* Left vertices have edges to the left and then the right vertices of all
+   * other atoms, right vertices only to the right vertices of all other atoms
+   */
+  const std::size_t N = inner_.N();
+  const VertexDescriptor a = i / 2;
+  const VertexDescriptor b = j / 2;
+  assert(a != b);
+  const std::size_t offset = a * 3 * (N - 1) + (b < a ? b : b - 1);
+
+  if(isLeft(i)) {
+    return offset + (isLeft(j) ? 0 : N - 1);
+  }
+
+  assert(!isLeft(j));
+  return offset + 2 * (N - 1);
+}
+
+void ExplicitBoundsGraph::setFlatWeight_(
   const VertexDescriptor i,
   const VertexDescriptor j,
-  const double edgeWeight
+  const double weight
 ) {
-  auto edgeSearchPair = boost::edge(i, j, graph_);
-  if(edgeSearchPair.second) {
-    boost::get(boost::edge_weight, graph_, edgeSearchPair.first) = edgeWeight;
-  } else {
-    boost::add_edge(i, j, edgeWeight, graph_);
+  boost::put(
+    boost::edge_weight,
+    flatGraph_,
+    FlatGraphType::edge_descriptor(i, flatEdgeIndex_(i, j)),
+    weight
+  );
+}
+
+void ExplicitBoundsGraph::makeFlatGraph_() {
+  const VertexDescriptor N = inner_.N();
+  const std::size_t E = N > 0 ? 3 * N * (N - 1) : 0;
+
+  // Lower bounds are always present, upper bounds may be absent
+  flatBoundWeights_.assign(E, std::numeric_limits<double>::infinity());
+  for(const auto& edge : boost::make_iterator_range(boost::edges(graph_))) {
+    const std::size_t index = flatEdgeIndex_(
+      boost::source(edge, graph_),
+      boost::target(edge, graph_)
+    );
+    flatBoundWeights_[index] = boost::get(boost::edge_weight, graph_, edge);
+  }
+
+  std::vector<std::pair<VertexDescriptor, VertexDescriptor>> flatEdges;
+  flatEdges.reserve(E);
+  for(VertexDescriptor a = 0; a < N; ++a) {
+    for(VertexDescriptor b = 0; b < N; ++b) {
+      if(a != b) {
+        flatEdges.emplace_back(left(a), left(b));
+      }
+    }
+    for(VertexDescriptor b = 0; b < N; ++b) {
+      if(a != b) {
+        flatEdges.emplace_back(left(a), right(b));
+      }
+    }
+    for(VertexDescriptor b = 0; b < N; ++b) {
+      if(a != b) {
+        flatEdges.emplace_back(right(a), right(b));
+      }
+    }
+  }
+
+  const std::vector<EdgeWeightProperty> weights(
+    std::begin(flatBoundWeights_),
+    std::end(flatBoundWeights_)
+  );
+  flatGraph_ = FlatGraphType {
+    boost::edges_are_sorted,
+    std::begin(flatEdges),
+    std::end(flatEdges),
+    std::begin(weights),
+    2 * N
+  };
+}
+
+void ExplicitBoundsGraph::restore() {
+  std::size_t index = 0;
+  for(const auto& edge : boost::make_iterator_range(boost::edges(flatGraph_))) {
+    boost::put(boost::edge_weight, flatGraph_, edge, flatBoundWeights_[index]);
+    ++index;
   }
 }
 
@@ -233,14 +376,14 @@ void ExplicitBoundsGraph::updateGraphWithFixedDistance_(
   const VertexDescriptor b,
   const double fixedDistance
 ) {
-  updateOrAddEdge_(left(a), left(b), fixedDistance);
-  updateOrAddEdge_(left(b), left(a), fixedDistance);
+  setFlatWeight_(left(a), left(b), fixedDistance);
+  setFlatWeight_(left(b), left(a), fixedDistance);
 
-  updateOrAddEdge_(right(a), right(b), fixedDistance);
-  updateOrAddEdge_(right(b), right(a), fixedDistance);
+  setFlatWeight_(right(a), right(b), fixedDistance);
+  setFlatWeight_(right(b), right(a), fixedDistance);
 
-  updateOrAddEdge_(left(a), right(b), -fixedDistance);
-  updateOrAddEdge_(left(b), right(a), -fixedDistance);
+  setFlatWeight_(left(a), right(b), -fixedDistance);
+  setFlatWeight_(left(b), right(a), -fixedDistance);
 }
 
 double ExplicitBoundsGraph::lowerBound(
@@ -286,6 +429,32 @@ const ExplicitBoundsGraph::GraphType& ExplicitBoundsGraph::graph() const {
   return graph_;
 }
 
+std::size_t ExplicitBoundsGraph::peakHeapSize() const {
+  using StoredEdge = std::remove_reference_t<decltype(graph_.out_edge_list(0))>::value_type;
+
+  const std::size_t N = inner_.N();
+  const std::size_t M = 2 * N;
+  const std::size_t E = N > 0 ? 3 * N * (N - 1) : 0;
+
+  std::size_t size = graph_.m_vertices.capacity() * sizeof(GraphType::stored_vertex);
+  for(const VertexDescriptor v : boost::make_iterator_range(boost::vertices(graph_))) {
+    size += graph_.out_edge_list(v).capacity() * sizeof(StoredEdge);
+  }
+
+  // Flat graph row offsets, targets and weights and the weights upon creation
+  size += (M + 1) * sizeof(std::size_t);
+  size += E * (sizeof(VertexDescriptor) + sizeof(EdgeWeightProperty) + sizeof(double));
+  // Edge and weight lists the flat graph is constructed from
+  size += E * (2 * sizeof(VertexDescriptor) + sizeof(EdgeWeightProperty));
+
+  // Shortest paths buffers
+  size += 2 * N * sizeof(AtomIndex);
+  size += M * (sizeof(double) + 2 * sizeof(VertexDescriptor) + sizeof(unsigned));
+  size += (M + 3) / 4 + (M + 7) / 8;
+
+  return size;
+}
+
 outcome::result<Eigen::MatrixXd> ExplicitBoundsGraph::makeDistanceBounds() const noexcept {
   unsigned N = inner_.N();
 
@@ -358,11 +527,95 @@ outcome::result<Eigen::MatrixXd> ExplicitBoundsGraph::makeDistanceBounds() const
   return bounds;
 }
 
+#ifndef MOLASSEMBLER_EXPLICIT_GRAPH_USE_SPECIALIZED_GOR1_ALGORITHM
+namespace {
+
+/* Propagates decreases of edge weights into single-source shortest path
+ * distances and predecessors by label correction, starting from the targets
+ * of the changed edges. Yields the same distances as recalculating all
+ * shortest paths from the source, but only visits vertices whose distance
+ * actually decreases.
+ *
+ * Returns false if propagation is aborted because a vertex was relabeled
+ * more often than there are vertices in the graph, which indicates a
+ * negative cycle. Distances and predecessors are then inconsistent.
+ */
+struct ChangedEdge {
+  ExplicitBoundsGraph::VertexDescriptor source;
+  ExplicitBoundsGraph::VertexDescriptor target;
+  double weight;
+};
+
+template<typename Buffers>
+bool propagateDecreasedEdgeWeights(
+  const ExplicitBoundsGraph::FlatGraphType& graph,
+  const std::array<ChangedEdge, 6>& changedEdges,
+  Buffers& buffers
+) {
+  using VertexDescriptor = ExplicitBoundsGraph::VertexDescriptor;
+  constexpr double unreachable = std::numeric_limits<double>::max();
+
+  const unsigned M = boost::num_vertices(graph);
+  std::vector<double>& distances = buffers.distances;
+  std::vector<VertexDescriptor>& predecessors = buffers.predecessors;
+  std::deque<VertexDescriptor>& queue = buffers.queue;
+  std::vector<bool>& queued = buffers.queued;
+  std::vector<unsigned>& relabelCounts = buffers.relabelCounts;
+  queue.clear();
+  std::fill(std::begin(queued), std::end(queued), false);
+  std::fill(std::begin(relabelCounts), std::end(relabelCounts), 0);
+
+  auto relax = [&](const VertexDescriptor u, const VertexDescriptor v, const double weight) -> bool {
+    if(distances[u] == unreachable || distances[u] + weight >= distances[v]) {
+      return true;
+    }
+
+    distances[v] = distances[u] + weight;
+    predecessors[v] = u;
+    if(++relabelCounts[v] > M) {
+      return false;
+    }
+
+    if(!queued[v]) {
+      queued[v] = true;
+      queue.push_back(v);
+    }
+    return true;
+  };
+
+  for(const ChangedEdge& edge : changedEdges) {
+    if(!relax(edge.source, edge.target, edge.weight)) {
+      return false;
+    }
+  }
+
+  while(!queue.empty()) {
+    const VertexDescriptor u = queue.front();
+    queue.pop_front();
+    queued[u] = false;
+
+    for(const auto& edge : boost::make_iterator_range(boost::out_edges(u, graph))) {
+      if(!relax(u, boost::target(edge, graph), boost::get(boost::edge_weight, graph, edge))) {
+        return false;
+      }
+    }
+  }
+
+  return true;
+}
+
+} // namespace
+#endif
+
 outcome::result<Eigen::MatrixXd> ExplicitBoundsGraph::makeDistanceMatrix(Random::Engine& engine) noexcept {
   return makeDistanceMatrix(engine, Partiality::All);
 }
 
 outcome::result<Eigen::MatrixXd> ExplicitBoundsGraph::makeDistanceMatrix(Random::Engine& engine, Partiality partiality) noexcept {
+  return makeDistanceMatrix(engine, smoothedAtomCount(partiality, inner_.N()));
+}
+
+outcome::result<Eigen::MatrixXd> ExplicitBoundsGraph::makeDistanceMatrix(Random::Engine& engine, const unsigned smoothedAtoms) noexcept {
   const unsigned N = inner_.N();
 
   Eigen::MatrixXd distancesMatrix;
@@ -371,39 +624,29 @@ outcome::result<Eigen::MatrixXd> ExplicitBoundsGraph::makeDistanceMatrix(Random:
 
   auto upperTriangle = distancesMatrix.triangularView<Eigen::StrictlyUpper>();
 
-  std::vector<AtomIndex> indices (N);
+  if(boost::num_vertices(flatGraph_) == 0) {
+    makeFlatGraph_();
+  }
+
+  std::vector<AtomIndex>& indices = buffers_.indices;
+  indices.resize(N);
 
   std::iota(std::begin(indices), std::end(indices), 0);
 
   Temple::Random::shuffle(indices, engine);
 
-  const unsigned M = boost::num_vertices(graph_);
-  std::vector<double> distances (M);
+  std::vector<double>& distances = buffers_.distances;
   using ColorMapType = boost::two_bit_color_map<>;
-  ColorMapType color_map {M};
-  std::vector<VertexDescriptor> predecessors (M);
-
-  std::vector<AtomIndex>::const_iterator separator;
+  ColorMapType& color_map = buffers_.colorMap;
+  std::vector<VertexDescriptor>& predecessors = buffers_.predecessors;
 
-  if(partiality == Partiality::FourAtom) {
-    separator = indices.cbegin() + std::min(N, 4U);
-  } else if(partiality == Partiality::TenPercent) {
-    /* Advance the separator at most by N positions (guards against advancing
-     * past-the-end), and at least by four atoms (guards against situations
-     * where 4 <= N < 40 and 10% would yield less smoothing than FourAtom)
-     *
-     * Not equivalent to std::clamp(4u, cast<u>(0.1 * N), N) if N < 4!
-     */
-    separator = indices.cbegin() + std::min(N, std::max(4U, static_cast<unsigned>(0.1 * N)));
-  } else { // All
-    separator = indices.cend();
-  }
+  const auto separator = indices.cbegin() + std::min(N, smoothedAtoms);
 
   for(auto iter = indices.cbegin(); iter != separator; ++iter) {
     const AtomIndex a = *iter;
 
-    std::vector<AtomIndex> otherIndices;
-    otherIndices.reserve(N - 1);
+    std::vector<AtomIndex>& otherIndices = buffers_.otherIndices;
+    otherIndices.clear();
 
     // Avoid already-chosen elements
     for(AtomIndex b = 0; b < a; ++b) {
@@ -420,44 +663,52 @@ outcome::result<Eigen::MatrixXd> ExplicitBoundsGraph::makeDistanceMatrix(Random:
 
     Temple::Random::shuffle(otherIndices, engine);
 
+    /* Fixing the distance between a and b only decreases the weights of the
+     * edges between their vertices, so the shortest paths from left(a) can
+     * be updated incrementally instead of recalculated for each b.
+     */
+    bool shortestPathsAreCurrent = false;
+
     // Again through N - 1 indices: N²
     for(const auto& b : otherIndices) {
+      if(!shortestPathsAreCurrent) {
+        auto predecessor_map = boost::make_iterator_property_map(
+          predecessors.begin(),
+          boost::get(boost::vertex_index, flatGraph_)
+        );
 
-      auto predecessor_map = boost::make_iterator_property_map(
-        predecessors.begin(),
-        boost::get(boost::vertex_index, graph_)
-      );
-
-      auto distance_map = boost::make_iterator_property_map(
-        distances.begin(),
-        boost::get(boost::vertex_index, graph_)
-      );
+        auto distance_map = boost::make_iterator_property_map(
+          distances.begin(),
+          boost::get(boost::vertex_index, flatGraph_)
+        );
 
-      // re-fill color map with white
-      std::fill(
-        color_map.data.get(),
-        color_map.data.get() + (color_map.n + ColorMapType::elements_per_char - 1)
-          / ColorMapType::elements_per_char,
-        0
-      );
+        // re-fill color map with white
+        std::fill(
+          color_map.data.get(),
+          color_map.data.get() + (color_map.n + ColorMapType::elements_per_char - 1)
+            / ColorMapType::elements_per_char,
+          0
+        );
 
 #ifdef MOLASSEMBLER_EXPLICIT_GRAPH_USE_SPECIALIZED_GOR1_ALGORITHM
-      boost::gor1_eg_shortest_paths(
-        *this,
-        left(a),
-        predecessor_map,
-        color_map,
-        distance_map
-      );
+        boost::gor1_eg_shortest_paths(
+          *this,
+          left(a),
+          predecessor_map,
+          color_map,
+          distance_map
+        );
 #else
-      boost::gor1_simplified_shortest_paths(
-        graph_,
-        left(a),
-        predecessor_map,
-        color_map,
-        distance_map
-      );
+        boost::gor1_simplified_shortest_paths(
+          flatGraph_,
+          left(a),
+          predecessor_map,
+          color_map,
+          distance_map
+        );
 #endif
+        shortestPathsAreCurrent = true;
+      }
 
       double lower = -distances.at(right(b));
       double upper = distances.at(left(b));
@@ -483,6 +734,24 @@ outcome::result<Eigen::MatrixXd> ExplicitBoundsGraph::makeDistanceMatrix(Random:
 
       // Modify the graph accordingly
       updateGraphWithFixedDistance_(a, b, tightenedBound);
+
+#ifdef MOLASSEMBLER_EXPLICIT_GRAPH_USE_SPECIALIZED_GOR1_ALGORITHM
+      // The specialized algorithm also traverses implicit edges
+      shortestPathsAreCurrent = false;
+#else
+      shortestPathsAreCurrent = propagateDecreasedEdgeWeights(
+        flatGraph_,
+        {{
+          {left(a), left(b), tightenedBound},
+          {left(b), left(a), tightenedBound},
+          {right(a), right(b), tightenedBound},
+          {right(b), right(a), tightenedBound},
+          {left(a), right(b), -tightenedBound},
+          {left(b), right(a), -tightenedBound}
+        }},
+        buffers_
+      );
+#endif
     }
   }
 
@@ -491,12 +760,12 @@ outcome::result<Eigen::MatrixXd> ExplicitBoundsGraph::makeDistanceMatrix(Random:
 
     auto predecessor_map = boost::make_iterator_property_map(
       predecessors.begin(),
-      boost::get(boost::vertex_index, graph_)
+      boost::get(boost::vertex_index, flatGraph_)
     );
 
     auto distance_map = boost::make_iterator_property_map(
       distances.begin(),
-      boost::get(boost::vertex_index, graph_)
+      boost::get(boost::vertex_index, flatGraph_)
     );
 
     // re-fill color map with white
@@ -517,7 +786,7 @@ outcome::result<Eigen::MatrixXd> ExplicitBoundsGraph::makeDistanceMatrix(Random:
     );
 #else
     boost::gor1_simplified_shortest_paths(
-      graph_,
+      flatGraph_,
       left(a),
       predecessor_map,
       color_map,
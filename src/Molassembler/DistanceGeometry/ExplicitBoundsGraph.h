@@ -15,7 +15,10 @@
 // #define MOLASSEMBLER_EXPLICIT_GRAPH_USE_SPECIALIZED_GOR1_ALGORITHM
 
 #include "boost/graph/adjacency_list.hpp"
+#include "boost/graph/compressed_sparse_row_graph.hpp"
+#include "boost/graph/two_bit_color_map.hpp"
 #include "Eigen/Core"
+#include "Eigen/SparseCore"
 #include "Utils/Geometry/ElementInfo.h"
 
 #include "Molassembler/DistanceGeometry/ValueBounds.h"
@@ -51,10 +54,12 @@ class DistanceBoundsMatrix;
  * and kept for refinement. For every new conformation, the underlying graph
  * containing the information from the ValueBounds needs to be copied and
  * generateDistanceMatrix called upon it. This procedure modifies the
- * underlying graph and hence cannot be called repeatedly.
+ * underlying graph and hence cannot be called repeatedly. Instead of copying,
+ * the graph can also be restored to its initial bounds.
  *
  * The underlying data structure is a fully explicit BGL graph containing all
- * edges and edge weights.
+ * edges and edge weights. Distance matrices are generated on a flat copy
+ * containing the edges of all pairs.
  */
 class ExplicitBoundsGraph {
 public:
@@ -71,7 +76,19 @@ public:
   using VertexDescriptor = GraphType::vertex_descriptor;
   using EdgeDescriptor = GraphType::edge_descriptor;
 
+  /*! @brief Flat graph with the edges of all pairs
+   *
+   * Out edges are stored contiguously in a fixed order, so that the edges of
+   * a pair are found by index. Absent upper bounds have infinite weight.
+   */
+  using FlatGraphType = boost::compressed_sparse_row_graph<
+    boost::directedS,
+    boost::no_property,
+    EdgeWeightProperty
+  >;
+
   using BoundsMatrix = Eigen::MatrixXd;
+  using SparseBoundsMatrix = Eigen::SparseMatrix<double>;
 //!@}
 
 //!@name Special member functions
@@ -93,6 +110,18 @@ public:
     const PrivateGraph& inner,
     const BoundsMatrix& bounds
   );
+
+  /*! @brief Construct from sparse explicit bounds
+   *
+   * Entries have the same layout as in the dense bounds matrix. Pairs without
+   * entries receive implicit van der Waals lower bounds.
+   *
+   * @complexity{@math{\Theta(N^2)}}
+   */
+  ExplicitBoundsGraph(
+    const PrivateGraph& inner,
+    const SparseBoundsMatrix& bounds
+  );
 //!@}
 
 //!@name Static member functions
@@ -169,17 +198,41 @@ public:
    */
   double upperBound(VertexDescriptor a, VertexDescriptor b) const;
 
+  /*! @brief Restores the bounds the graph was constructed with
+   *
+   * Undoes the modifications of makeDistanceMatrix by copying the initial
+   * edge weights, so that further distance matrices can be generated without
+   * reconstructing the graph.
+   *
+   * @complexity{@math{\Theta(N^2)}}
+   */
+  void restore();
+
   /*! @brief Generate a distance matrix
    *
    * Generates a distances matrix conforming to the triangle inequality bounds
-   * while modifying state information. Can only be called once!
+   * while modifying state information. Can only be called once unless
+   * restore() is called in between!
    *
-   * @complexity{@math{O(V^2 \cdot E)}}
+   * Shortest paths are calculated once per metrized atom on the flat graph,
+   * which is created upon the first call. After each distance from that atom
+   * is fixed, they are updated incrementally starting from the changed edges.
+   *
+   * @complexity{@math{O(V^2 \cdot E)}, but typically much closer to
+   * @math{O(V \cdot E)} since incremental updates only visit vertices whose
+   * shortest path distance changes}
    */
   outcome::result<Eigen::MatrixXd> makeDistanceMatrix(Random::Engine& engine) noexcept;
 
   //!@overload
   outcome::result<Eigen::MatrixXd> makeDistanceMatrix(Random::Engine& engine, Partiality partiality) noexcept;
+
+  /*! @overload
+   *
+   * Smooths after the one-to-all distance choices of @p smoothedAtoms atoms
+   * only, at most all atoms.
+   */
+  outcome::result<Eigen::MatrixXd> makeDistanceMatrix(Random::Engine& engine, unsigned smoothedAtoms) noexcept;
 //!@}
 
 //!@name Information
@@ -196,6 +249,15 @@ public:
    */
   const GraphType& graph() const;
 
+  /*! @brief Approximate peak heap memory in bytes of distance matrix generation
+   *
+   * Includes the flat graph and its construction temporaries even if no
+   * distance matrix has been generated yet, but not the generated matrix.
+   *
+   * @complexity{@math{\Theta(N)}}
+   */
+  std::size_t peakHeapSize() const;
+
   /*! @brief Make smooth distance bounds
    *
    * @complexity{@math{\Theta(V \cdot E)}}
@@ -204,16 +266,39 @@ public:
 //!@}
 
 private:
+  //! Shortest paths buffers kept allocated across distance matrix generations
+  struct ShortestPathsBuffers {
+    explicit ShortestPathsBuffers(std::size_t M);
+
+    std::vector<AtomIndex> indices;
+    std::vector<AtomIndex> otherIndices;
+    std::vector<double> distances;
+    std::vector<VertexDescriptor> predecessors;
+    boost::two_bit_color_map<> colorMap;
+    //! Label correction queue for incremental shortest paths updates
+    std::deque<VertexDescriptor> queue;
+    std::vector<bool> queued;
+    std::vector<unsigned> relabelCounts;
+  };
+
   GraphType graph_;
   const PrivateGraph& inner_;
   //! Stores the two heaviest element types
   std::array<Utils::ElementType, 2> heaviestAtoms_;
+  //! Graph modified by distance matrix generation, empty until then
+  FlatGraphType flatGraph_;
+  //! Flat graph edge weights upon creation, indexed as its edges
+  std::vector<double> flatBoundWeights_;
+  ShortestPathsBuffers buffers_;
 
-  void updateOrAddEdge_(
-    VertexDescriptor i,
-    VertexDescriptor j,
-    double edgeWeight
-  );
+  //! Creates the flat graph from the graph's current bounds
+  void makeFlatGraph_();
+
+  //! Index of the flat graph edge between two vertices
+  std::size_t flatEdgeIndex_(VertexDescriptor i, VertexDescriptor j) const;
+
+  //! Sets the weight of a flat graph edge
+  void setFlatWeight_(VertexDescriptor i, VertexDescriptor j, double weight);
 
   void updateGraphWithFixedDistance_(
     VertexDescriptor a,
@@ -11,11 +11,14 @@
 #ifndef INCLUDE_MOLASSEMBLER_DG_GOR_SPECIALIZATION_H
 #define INCLUDE_MOLASSEMBLER_DG_GOR_SPECIALIZATION_H
 
+#include <cassert>
 #include <stack>
 #include <limits>
+#include <vector>
 
 #include "boost/graph/graph_traits.hpp"
 #include "boost/graph/graph_concepts.hpp"
+#include "Eigen/Core"
 
 // Forward-declare ImplicitBoundsGraph
 namespace Scine {
@@ -247,6 +250,191 @@ std::enable_if_t<
   return true;
 }
 
+/*!
+ * @brief Relaxes all out-edges of an ImplicitBoundsGraph vertex at once
+ *
+ * Tentative distances along all out-edges of the vertex are calculated as a
+ * single array operation over its column of dense edge weights. Only if any
+ * target's distance improves are the targets updated, in the same order in
+ * which the graph's out-edge iterators visit them.
+ *
+ * @param candidates Scratch space for the tentative distances of at least as
+ *   many entries as there are vertices in the graph
+ */
+template<
+  typename VertexDescriptor,
+  class IncidenceGraph,
+  class ColorMap
+>
+std::enable_if_t<
+  std::is_same<IncidenceGraph, Scine::Molassembler::DistanceGeometry::ImplicitBoundsGraph>::value,
+  void
+> gor1_ig_row_scan(
+  const VertexDescriptor& vertex,
+  const IncidenceGraph& graph,
+  std::vector<VertexDescriptor>& predecessors,
+  ColorMap& color_map,
+  std::vector<double>& distances,
+  Eigen::ArrayXd& candidates,
+  std::stack<VertexDescriptor>& B
+) {
+  using ColorValue = typename property_traits<ColorMap>::value_type;
+  using Color = color_traits<ColorValue>;
+
+  const double vertexDistance = distances[vertex];
+  const auto weights = graph.outEdgeWeights(IncidenceGraph::internal(vertex));
+  const auto M = weights.size();
+
+  auto relax = [&](const VertexDescriptor targetVertex, const double distance) {
+    distances[targetVertex] = distance;
+    predecessors[targetVertex] = vertex;
+
+    if(get(color_map, targetVertex) != Color::black()) {
+      B.push(targetVertex);
+      put(color_map, targetVertex, Color::gray());
+    }
+  };
+
+  if(IncidenceGraph::isLeft(vertex)) {
+    /* Left vertices have edges to all left vertices with explicit bounds and
+     * to all other right vertices, weights of absent edges are infinite
+     */
+    const Eigen::Map<const Eigen::ArrayXd> current(distances.data(), M);
+    candidates.head(M) = vertexDistance + weights.array();
+    if(!(candidates.head(M) < current).any()) {
+      return;
+    }
+
+    // Left-left edges precede left-right edges in out-edge iteration order
+    for(VertexDescriptor t = 0; t < static_cast<VertexDescriptor>(M); t += 2) {
+      if(candidates[t] < distances[t]) {
+        relax(t, candidates[t]);
+      }
+    }
+    for(VertexDescriptor t = 1; t < static_cast<VertexDescriptor>(M); t += 2) {
+      if(candidates[t] < distances[t]) {
+        relax(t, candidates[t]);
+      }
+    }
+  } else {
+    /* Right vertices only have edges to right vertices, weighted like the
+     * edges between the corresponding left vertices
+     */
+    using Strided = Eigen::Map<const Eigen::ArrayXd, 0, Eigen::InnerStride<2>>;
+    const auto N = M / 2;
+    const Strided inGroupWeights(weights.data(), N);
+    const Strided current(distances.data() + 1, N);
+    candidates.head(N) = vertexDistance + inGroupWeights;
+    if(!(candidates.head(N) < current).any()) {
+      return;
+    }
+
+    for(VertexDescriptor b = 0; b < static_cast<VertexDescriptor>(N); ++b) {
+      if(candidates[b] < distances[IncidenceGraph::right(b)]) {
+        relax(IncidenceGraph::right(b), candidates[b]);
+      }
+    }
+  }
+}
+
+/*!
+ * @brief GOR1 shortest paths over an ImplicitBoundsGraph relaxing whole rows
+ *
+ * Equivalent to gor1_simplified_shortest_paths over the same graph, but scans
+ * vertices with gor1_ig_row_scan instead of iterating through each out-edge.
+ * Distances and predecessors are passed as vectors since the scans operate
+ * directly on their contiguous storage.
+ *
+ * @complexity{@math{\Theta(V E)}}
+ */
+template<
+  class IncidenceGraph,
+  class ColorMap,
+  typename VertexDescriptor
+>
+std::enable_if_t<
+  std::is_same<IncidenceGraph, Scine::Molassembler::DistanceGeometry::ImplicitBoundsGraph>::value,
+  bool
+> gor1_ig_row_shortest_paths(
+  const IncidenceGraph& graph,
+  const VertexDescriptor& root_vertex,
+  std::vector<VertexDescriptor>& predecessors,
+  ColorMap& color_map,
+  std::vector<double>& distances
+) {
+  using Vertex = typename graph_traits<IncidenceGraph>::vertex_descriptor;
+  BOOST_CONCEPT_ASSERT(( ReadWritePropertyMapConcept<ColorMap, Vertex> ));
+
+  using ColorValue = typename property_traits<ColorMap>::value_type;
+  using Color = color_traits<ColorValue>;
+
+  const auto M = graph.num_vertices();
+  assert(distances.size() >= M && predecessors.size() >= M);
+  std::fill(
+    std::begin(distances),
+    std::begin(distances) + M,
+    std::numeric_limits<double>::max()
+  );
+
+  distances[root_vertex] = 0.0;
+  put(color_map, root_vertex, Color::gray());
+  predecessors[root_vertex] = root_vertex;
+
+  Eigen::ArrayXd candidates(M);
+  std::stack<VertexDescriptor> A;
+  std::stack<VertexDescriptor> B;
+  B.push(root_vertex);
+
+  while(!B.empty()) {
+    // Compute A from B, emptying B in the process
+    while(!B.empty()) {
+      VertexDescriptor v = B.top();
+      B.pop();
+
+      ColorValue v_color = get(color_map, v);
+
+      if(v_color == Color::black()) {
+        A.push(v);
+      } else if(v_color == Color::gray()) {
+        // Re-push v so that it precedes its descendants in A, see gor1_ig_shortest_paths
+        B.push(v);
+        put(color_map, v, Color::black());
+
+        gor1_ig_row_scan(
+          v,
+          graph,
+          predecessors,
+          color_map,
+          distances,
+          candidates,
+          B
+        );
+      }
+    }
+
+    // Scan all elements in A, populating B with nodes added to the tree
+    while(!A.empty()) {
+      VertexDescriptor v = A.top();
+      A.pop();
+
+      gor1_ig_row_scan(
+        v,
+        graph,
+        predecessors,
+        color_map,
+        distances,
+        candidates,
+        B
+      );
+
+      // Mark white
+      put(color_map, v, Color::white());
+    }
+  }
+
+  return true;
+}
+
 template<
   typename VertexDescriptor,
   class GraphClass,
@@ -19,11 +19,7 @@
 
 #include "Utils/Geometry/ElementInfo.h"
 
-#ifdef MOLASSEMBLER_IMPLICIT_GRAPH_USE_SPECIALIZED_GOR1_ALGORITHM
 #include "Molassembler/DistanceGeometry/Gor1.h"
-#else
-#include "Molassembler/Graph/Gor1.h"
-#endif
 
 
 namespace Scine {
@@ -91,6 +87,49 @@ ImplicitBoundsGraph::ImplicitBoundsGraph(
       }
     }
   }
+
+  // Collect the dense out-edge weights of left vertices, O(N^2)
+  Eigen::VectorXd vdwRadii(N);
+  for(AtomIndex i = 0; i < N; ++i) {
+    vdwRadii(i) = AtomInfo::vdwRadius(inner.elementType(i));
+  }
+
+  outWeights_.resize(2 * N, N);
+  for(AtomIndex a = 0; a < N; ++a) {
+    for(AtomIndex b = 0; b < N; ++b) {
+      if(a == b) {
+        outWeights_(left(b), a) = std::numeric_limits<double>::infinity();
+        outWeights_(right(b), a) = std::numeric_limits<double>::infinity();
+        continue;
+      }
+
+      if(distances_(a, b) != 0) {
+        outWeights_(left(b), a) = upperBound(a, b);
+      } else {
+        outWeights_(left(b), a) = std::numeric_limits<double>::infinity();
+      }
+
+      const double lower = lowerBound(a, b);
+      if(lower != 0) {
+        outWeights_(right(b), a) = -lower;
+      } else {
+        outWeights_(right(b), a) = -(vdwRadii(a) + vdwRadii(b));
+      }
+    }
+  }
+}
+
+void ImplicitBoundsGraph::fixDistance_(
+  const VertexDescriptor a,
+  const VertexDescriptor b,
+  const double distance
+) {
+  distances_(a, b) = distance;
+  distances_(b, a) = distance;
+  outWeights_(left(b), a) = distance;
+  outWeights_(right(b), a) = -distance;
+  outWeights_(left(a), b) = distance;
+  outWeights_(right(a), b) = -distance;
 }
 
 ImplicitBoundsGraph::VertexDescriptor ImplicitBoundsGraph::num_vertices() const {
@@ -175,6 +214,15 @@ outcome::result<Eigen::MatrixXd> ImplicitBoundsGraph::makeDistanceBounds() const
   for(VertexDescriptor a = 0; a < N; ++a) {
     // Perform a single shortest paths calculation for a
 
+    // re-fill color map with white
+    std::fill(
+      color_map.data.get(),
+      color_map.data.get() + (color_map.n + ColorMapType::elements_per_char - 1)
+        / ColorMapType::elements_per_char,
+      0
+    );
+
+#ifdef MOLASSEMBLER_IMPLICIT_GRAPH_USE_SPECIALIZED_GOR1_ALGORITHM
     auto predecessor_map = boost::make_iterator_property_map(
       predecessors.begin(),
       VertexIndexMap()
@@ -185,15 +233,6 @@ outcome::result<Eigen::MatrixXd> ImplicitBoundsGraph::makeDistanceBounds() const
       VertexIndexMap()
     );
 
-    // re-fill color map with white
-    std::fill(
-      color_map.data.get(),
-      color_map.data.get() + (color_map.n + ColorMapType::elements_per_char - 1)
-        / ColorMapType::elements_per_char,
-      0
-    );
-
-#ifdef MOLASSEMBLER_IMPLICIT_GRAPH_USE_SPECIALIZED_GOR1_ALGORITHM
     boost::gor1_ig_shortest_paths(
       *this,
       VertexDescriptor {left(a)},
@@ -202,12 +241,12 @@ outcome::result<Eigen::MatrixXd> ImplicitBoundsGraph::makeDistanceBounds() const
       distance_map
     );
 #else
-    boost::gor1_simplified_shortest_paths(
+    boost::gor1_ig_row_shortest_paths(
       *this,
       VertexDescriptor {left(a)},
-      predecessor_map,
+      predecessors,
       color_map,
-      distance_map
+      distances
     );
 #endif
 
@@ -250,21 +289,7 @@ outcome::result<Eigen::MatrixXd> ImplicitBoundsGraph::makeDistanceMatrix(Random:
   // Determine triangle inequality limits for pair
   ColorMapType color_map {M};
 
-  std::vector<AtomIndex>::const_iterator separator;
-
-  if(partiality == Partiality::FourAtom) {
-    separator = indices.cbegin() + std::min(N, 4U);
-  } else if(partiality == Partiality::TenPercent) {
-    /* Advance the separator at most by N positions (guards against advancing
-     * past-the-end), and at least by four atoms (guards against situations
-     * where 4 <= N < 40 and 10% would yield less smoothing than FourAtom)
-     *
-     * Not equivalent to std::clamp(4u, cast<u>(0.1 * N), N) if N < 4!
-     */
-    separator = indices.cbegin() + std::min(N, std::max(4U, static_cast<unsigned>(0.1 * N)));
-  } else { // All
-    separator = indices.cend();
-  }
+  const auto separator = indices.cbegin() + smoothedAtomCount(partiality, N);
 
   for(auto iter = indices.cbegin(); iter != separator; ++iter) {
     const AtomIndex a = *iter;
@@ -285,6 +310,15 @@ outcome::result<Eigen::MatrixXd> ImplicitBoundsGraph::makeDistanceMatrix(Random:
     Temple::Random::shuffle(otherIndices, engine);
 
     for(const AtomIndex b : otherIndices) {
+      // re-fill color map with white
+      std::fill(
+        color_map.data.get(),
+        color_map.data.get() + (color_map.n + ColorMapType::elements_per_char - 1)
+          / ColorMapType::elements_per_char,
+        0
+      );
+
+#ifdef MOLASSEMBLER_IMPLICIT_GRAPH_USE_SPECIALIZED_GOR1_ALGORITHM
       auto predecessor_map = boost::make_iterator_property_map(
         predecessors.begin(),
         VertexIndexMap()
@@ -295,15 +329,6 @@ outcome::result<Eigen::MatrixXd> ImplicitBoundsGraph::makeDistanceMatrix(Random:
         VertexIndexMap()
       );
 
-      // re-fill color map with white
-      std::fill(
-        color_map.data.get(),
-        color_map.data.get() + (color_map.n + ColorMapType::elements_per_char - 1)
-          / ColorMapType::elements_per_char,
-        0
-      );
-
-#ifdef MOLASSEMBLER_IMPLICIT_GRAPH_USE_SPECIALIZED_GOR1_ALGORITHM
       boost::gor1_ig_shortest_paths(
         *this,
         VertexDescriptor {left(a)},
@@ -321,12 +346,12 @@ outcome::result<Eigen::MatrixXd> ImplicitBoundsGraph::makeDistanceMatrix(Random:
         engine
       );
 #else
-      boost::gor1_simplified_shortest_paths(
+      boost::gor1_ig_row_shortest_paths(
         *this,
         VertexDescriptor {left(a)},
-        predecessor_map,
+        predecessors,
         color_map,
-        distance_map
+        distances
       );
 
       if(distances.at(left(b)) < -distances.at(right(b))) {
@@ -344,14 +369,22 @@ outcome::result<Eigen::MatrixXd> ImplicitBoundsGraph::makeDistanceMatrix(Random:
 #endif
 
       // Record in distances matrix
-      distances_(a, b) = fixedDistance;
-      distances_(b, a) = fixedDistance;
+      fixDistance_(a, b, fixedDistance);
     }
   }
 
   for(auto iter = separator; iter != indices.cend(); ++iter) {
     const AtomIndex a = *iter;
 
+    // re-fill color map with white
+    std::fill(
+      color_map.data.get(),
+      color_map.data.get() + (color_map.n + ColorMapType::elements_per_char - 1)
+        / ColorMapType::elements_per_char,
+      0
+    );
+
+#ifdef MOLASSEMBLER_IMPLICIT_GRAPH_USE_SPECIALIZED_GOR1_ALGORITHM
     auto predecessor_map = boost::make_iterator_property_map(
       predecessors.begin(),
       VertexIndexMap()
@@ -362,15 +395,6 @@ outcome::result<Eigen::MatrixXd> ImplicitBoundsGraph::makeDistanceMatrix(Random:
       VertexIndexMap()
     );
 
-    // re-fill color map with white
-    std::fill(
-      color_map.data.get(),
-      color_map.data.get() + (color_map.n + ColorMapType::elements_per_char - 1)
-        / ColorMapType::elements_per_char,
-      0
-    );
-
-#ifdef MOLASSEMBLER_IMPLICIT_GRAPH_USE_SPECIALIZED_GOR1_ALGORITHM
     boost::gor1_ig_shortest_paths(
       *this,
       VertexDescriptor {left(a)},
@@ -379,12 +403,12 @@ outcome::result<Eigen::MatrixXd> ImplicitBoundsGraph::makeDistanceMatrix(Random:
       distance_map
     );
 #else
-    boost::gor1_simplified_shortest_paths(
+    boost::gor1_ig_row_shortest_paths(
       *this,
       VertexDescriptor {left(a)},
-      predecessor_map,
+      predecessors,
       color_map,
-      distance_map
+      distances
     );
 #endif
 
@@ -411,8 +435,7 @@ outcome::result<Eigen::MatrixXd> ImplicitBoundsGraph::makeDistanceMatrix(Random:
       );
 
       // Record in distances matrix
-      distances_(a, b) = fixedDistance;
-      distances_(b, a) = fixedDistance;
+      fixDistance_(a, b, fixedDistance);
     }
   }
 
@@ -436,20 +459,6 @@ ImplicitBoundsGraph::VertexDescriptor ImplicitBoundsGraph::out_degree(VertexDesc
   return count;
 }
 
-double& ImplicitBoundsGraph::lowerBound(const VertexDescriptor a, const VertexDescriptor b) {
-  return distances_(
-    std::max(a, b),
-    std::min(a, b)
-  );
-}
-
-double& ImplicitBoundsGraph::upperBound(const VertexDescriptor a, const VertexDescriptor b) {
-  return distances_(
-    std::min(a, b),
-    std::max(a, b)
-  );
-}
-
 double ImplicitBoundsGraph::lowerBound(const VertexDescriptor a, const VertexDescriptor b) const {
   return distances_(
     std::max(a, b),
@@ -171,6 +171,17 @@ private:
   //! Dense adjacency matrix for O(1) access to fixed distances
   Eigen::MatrixXd distances_;
 
+  /*! @brief Dense out-edge weights of left vertices
+   *
+   * Column a contains the weights of the edges from left(a) to all vertices
+   * in vertex descriptor order, including the implicit lower bounds. Absent
+   * edges have infinite weight.
+   */
+  Eigen::MatrixXd outWeights_;
+
+  //! Records a fixed distance between two atoms
+  void fixDistance_(VertexDescriptor a, VertexDescriptor b, double distance);
+
   static void explainContradictionPaths_(
     VertexDescriptor a,
     VertexDescriptor b,
@@ -294,9 +305,6 @@ public:
   VertexDescriptor out_degree(VertexDescriptor i) const;
 
   /* These are all O(1) */
-  double& lowerBound(VertexDescriptor a, VertexDescriptor b);
-  double& upperBound(VertexDescriptor a, VertexDescriptor b);
-
   double lowerBound(VertexDescriptor a, VertexDescriptor b) const;
   double upperBound(VertexDescriptor a, VertexDescriptor b) const;
 
@@ -306,6 +314,18 @@ public:
    */
   double maximalImplicitLowerBound(VertexDescriptor i) const;
 
+  /*! @brief Weights of the edges from left(a) to all vertices
+   *
+   * Indexed by target vertex descriptor. Absent edges have infinite weight.
+   * Also the weights of the edges from right(a) to the left vertices' right
+   * counterparts.
+   *
+   * @complexity{@math{\Theta(1)}}
+   */
+  inline Eigen::MatrixXd::ConstColXpr outEdgeWeights(const VertexDescriptor a) const {
+    return outWeights_.col(a);
+  }
+
   //! A helper struct permitting read-access to an edge weight via an edge descriptor
   struct EdgeWeightMap : public boost::put_get_helper<double, EdgeWeightMap> {
     using value_type = double;
@@ -7,11 +7,92 @@
 #include "Molassembler/DistanceGeometry/MetricMatrix.h"
 #include "Molassembler/Types.h"
 
+#include "boost/optional.hpp"
 #include <Eigen/Eigenvalues>
 
+#include <algorithm>
+#include <numeric>
+
 namespace Scine {
 namespace Molassembler {
 namespace DistanceGeometry {
+namespace {
+
+constexpr unsigned dimensionality = 4;
+
+/* Full diagonalization is faster for small matrices. Iterative eigenpair
+ * calculation is only attempted above these sizes, depending on whether it
+ * is warm started.
+ */
+constexpr unsigned partialDiagonalizationMinimumSize = 70;
+constexpr unsigned warmStartedPartialDiagonalizationMinimumSize = 20;
+
+/* Iteratively calculated eigenpairs are converged when all residual norms
+ * are below this tolerance relative to the largest eigenvalue magnitude
+ */
+constexpr double partialDiagonalizationTolerance = 1e-6;
+constexpr unsigned partialDiagonalizationIterationLimit = 200;
+
+/* Iterating on a few more eigenpairs than needed speeds up convergence if the
+ * last needed eigenvalue is close to the next one
+ */
+constexpr unsigned partialDiagonalizationGuardVectors = 2;
+
+/* Orthonormalizes the leading columns of a matrix in place with modified
+ * Gram-Schmidt, dropping linearly dependent columns. Retained columns are
+ * compacted to the front. Returns the number of retained columns.
+ */
+unsigned orthonormalize(Eigen::Ref<Eigen::MatrixXd> columns) {
+  unsigned retained = 0;
+  for(unsigned k = 0; k < columns.cols(); ++k) {
+    Eigen::VectorXd column = columns.col(k);
+    const double originalNorm = column.norm();
+    if(originalNorm == 0) {
+      continue;
+    }
+
+    // Orthogonalize twice for numerical stability
+    for(unsigned pass = 0; pass < 2; ++pass) {
+      for(unsigned l = 0; l < retained; ++l) {
+        column -= columns.col(l).dot(column) * columns.col(l);
+      }
+    }
+
+    const double norm = column.norm();
+    if(norm > 1e-10 * originalNorm) {
+      columns.col(retained) = column / norm;
+      ++retained;
+    }
+  }
+
+  return retained;
+}
+
+/* Embeds eigenpairs, eigenvalues in decreasing order, into four dimensions.
+ * Only eigenpairs with positive eigenvalues contribute.
+ */
+Eigen::MatrixXd embedEigenpairs(
+  const Eigen::Ref<const Eigen::VectorXd>& eigenvalues,
+  const Eigen::Ref<const Eigen::MatrixXd>& eigenvectors
+) {
+  // Construct L
+  Eigen::MatrixXd L = Eigen::MatrixXd::Zero(dimensionality, dimensionality);
+  for(unsigned i = 0; i < eigenvalues.size(); ++i) {
+    if(eigenvalues(i) > 0) {
+      L.diagonal()(i) = std::sqrt(eigenvalues(i));
+    }
+  }
+
+  Eigen::MatrixXd V = Eigen::MatrixXd::Zero(eigenvectors.rows(), dimensionality);
+  V.leftCols(eigenvectors.cols()) = eigenvectors;
+
+  /* Calculate X = VL
+   * (N x 4) · (4 x 4) -> (N x 4), but we want (4 x N), so we transpose
+   */
+  return (V * L).transpose();
+}
+
+} // namespace
 
 void MetricMatrix::constructFromTemporary_(Eigen::MatrixXd&& distances) {
   /* We have to be a little careful since only strict upper triangle of
@@ -105,49 +186,183 @@ const Eigen::MatrixXd& MetricMatrix::access() const {
 }
 
 Eigen::MatrixXd MetricMatrix::embed() const {
-  return embedWithFullDiagonalization();
+  EmbeddingWorkspace workspace;
+  return embed(workspace);
+}
+
+Eigen::MatrixXd MetricMatrix::embed(EmbeddingWorkspace& workspace) const {
+  /* With warm starts, iterative eigenpair calculations are worthwhile at
+   * smaller sizes, also to seed subsequent embeddings
+   */
+  const unsigned N = matrix_.rows();
+  if(
+    N > partialDiagonalizationMinimumSize
+    || (workspace.warmStart && N > warmStartedPartialDiagonalizationMinimumSize)
+  ) {
+    if(auto embedding = embedWithPartialDiagonalization(workspace)) {
+      return std::move(embedding.value());
+    }
+  }
+
+  return embedWithFullDiagonalization(workspace);
 }
 
 Eigen::MatrixXd MetricMatrix::embedWithFullDiagonalization() const {
-  constexpr unsigned dimensionality = 4;
+  EmbeddingWorkspace workspace;
+  return embedWithFullDiagonalization(workspace);
+}
 
+Eigen::MatrixXd MetricMatrix::embedWithFullDiagonalization(EmbeddingWorkspace& workspace) const {
   // SelfAdjointEigenSolver only references the lower triangle
-  Eigen::SelfAdjointEigenSolver<Eigen::MatrixXd> eigenSolver(matrix_);
+  auto& eigenSolver = workspace.solver_;
+  eigenSolver.compute(matrix_);
 
-  Eigen::VectorXd eigenvalues = eigenSolver.eigenvalues();
+  const Eigen::VectorXd& eigenvalues = eigenSolver.eigenvalues();
 
-  // Construct L
-  Eigen::MatrixXd L = Eigen::MatrixXd::Zero(dimensionality, dimensionality);
   // We want the algebraically largest eigenvalues (up to four, if present)
-  unsigned numEigenvalues = std::min(
+  const unsigned numEigenvalues = std::min(
     static_cast<unsigned>(eigenvalues.size()),
     dimensionality
   );
-  for(unsigned i = 0; i < numEigenvalues; ++i) {
-    /* Since Eigen stores them in increasing order, we have to fetch the
-     * algebraically largest from the back. We only want to use the eigenpair
-     * if the eigenvalue is greater than zero.
-     */
-    if(eigenvalues(eigenvalues.size() - i - 1) > 0) {
-      L.diagonal()(i) = std::sqrt(
-        eigenvalues(eigenvalues.size() - i - 1)
-      );
-    }
+
+  /* Since Eigen stores eigenpairs in increasing order of the eigenvalues, we
+   * have to fetch the algebraically largest from the back and reverse them.
+   */
+  return embedEigenpairs(
+    eigenvalues.tail(numEigenvalues).reverse(),
+    eigenSolver.eigenvectors().rightCols(numEigenvalues).rowwise().reverse()
+  );
+}
+
+boost::optional<Eigen::MatrixXd> MetricMatrix::embedWithPartialDiagonalization(
+  EmbeddingWorkspace& workspace
+) const {
+  const unsigned N = matrix_.rows();
+  const unsigned blockSize = std::min(N, dimensionality + partialDiagonalizationGuardVectors);
+  if(blockSize < dimensionality) {
+    return boost::none;
   }
 
-  // V is initially N x N
-  Eigen::MatrixXd V = eigenSolver.eigenvectors();
-  /* Again, eigenvectors are sorted in increasing corresponding eigenvalues
-   * algebraic value. We have to reverse them to match the ordering in L.
+  /* Only the lower triangle of the underlying matrix is meaningful. A full
+   * symmetric copy makes the repeated products considerably faster.
    */
-  V.rowwise().reverseInPlace();
-  V.conservativeResize(V.rows(), dimensionality);
-  // now N x dimensionality
+  Eigen::MatrixXd& metric = workspace.symmetric_;
+  metric = matrix_.selfadjointView<Eigen::Lower>();
 
-  /* Calculate X = VL
-   * (N x 4) · (4 x 4) -> (N x 4), but we want (4 x N), so we transpose
+  Eigen::MatrixXd& X = workspace.subspace_;
+  Eigen::MatrixXd& AX = workspace.subspaceImage_;
+  Eigen::MatrixXd& P = workspace.directions_;
+  Eigen::MatrixXd& Q = workspace.basis_;
+  Eigen::MatrixXd& AQ = workspace.basisImage_;
+
+  const bool warmStart = (
+    workspace.warmStart
+    && workspace.hasPreviousSubspace_
+    && X.rows() == N
+    && X.cols() == blockSize
+  );
+  workspace.hasPreviousSubspace_ = false;
+
+  /* Without a warm start, start from the columns of the atoms furthest from
+   * the centroid, i.e. with the largest diagonal metric matrix elements,
+   * which is one power iteration away from their unit vectors
    */
-  return (V * L).transpose();
+  Q.resize(N, 3 * blockSize);
+  if(warmStart) {
+    Q.leftCols(blockSize) = X;
+  } else {
+    std::vector<unsigned> indices(N);
+    std::iota(std::begin(indices), std::end(indices), 0);
+    std::partial_sort(
+      std::begin(indices),
+      std::begin(indices) + blockSize,
+      std::end(indices),
+      [&](const unsigned a, const unsigned b) {
+        return matrix_(a, a) > matrix_(b, b);
+      }
+    );
+    for(unsigned k = 0; k < blockSize; ++k) {
+      Q.col(k) = metric * Eigen::VectorXd::Unit(N, indices.at(k));
+    }
+  }
+
+  // Complete a deficient initial block with unit vectors
+  unsigned rank = orthonormalize(Q.leftCols(blockSize));
+  for(unsigned k = 0; rank < blockSize && k < N; ++k) {
+    Q.col(rank) = Eigen::VectorXd::Unit(N, k);
+    rank = orthonormalize(Q.leftCols(rank + 1));
+  }
+  if(rank < blockSize) {
+    return boost::none;
+  }
+
+  X = Q.leftCols(blockSize);
+  AX.noalias() = metric * X;
+
+  // Initial Rayleigh-Ritz procedure within the block
+  Eigen::VectorXd eigenvalues;
+  {
+    const Eigen::MatrixXd ritz = X.transpose() * AX;
+    Eigen::SelfAdjointEigenSolver<Eigen::MatrixXd> ritzSolver(ritz);
+    const Eigen::MatrixXd Y = ritzSolver.eigenvectors().rowwise().reverse();
+    eigenvalues = ritzSolver.eigenvalues().reverse();
+    X = X * Y;
+    AX = AX * Y;
+  }
+
+  unsigned directionColumns = 0;
+  for(unsigned iteration = 0; iteration < partialDiagonalizationIterationLimit; ++iteration) {
+    const Eigen::MatrixXd residuals = AX - X * eigenvalues.asDiagonal();
+    const double scale = std::max(eigenvalues.cwiseAbs().maxCoeff(), 1.0);
+    if(
+      residuals.leftCols(dimensionality).colwise().norm().maxCoeff()
+      < partialDiagonalizationTolerance * scale
+    ) {
+      /* Fix the arbitrary sign of each eigenvector so that results do not
+       * depend on the starting subspace beyond the convergence tolerance
+       */
+      for(unsigned k = 0; k < blockSize; ++k) {
+        Eigen::Index maxIndex;
+        X.col(k).cwiseAbs().maxCoeff(&maxIndex);
+        if(X(maxIndex, k) < 0) {
+          X.col(k) *= -1;
+          AX.col(k) *= -1;
+        }
+      }
+
+      workspace.hasPreviousSubspace_ = true;
+      return embedEigenpairs(
+        eigenvalues.head(dimensionality),
+        X.leftCols(dimensionality)
+      );
+    }
+
+    // Rayleigh-Ritz procedure on the span of X, the residuals and P
+    Q.leftCols(blockSize) = X;
+    Q.middleCols(blockSize, blockSize) = residuals;
+    if(directionColumns > 0) {
+      Q.middleCols(2 * blockSize, directionColumns) = P;
+    }
+    const unsigned basisSize = orthonormalize(Q.leftCols(2 * blockSize + directionColumns));
+    if(basisSize < blockSize) {
+      return boost::none;
+    }
+
+    AQ.noalias() = metric * Q.leftCols(basisSize);
+    const Eigen::MatrixXd ritz = Q.leftCols(basisSize).transpose() * AQ;
+    Eigen::SelfAdjointEigenSolver<Eigen::MatrixXd> ritzSolver(ritz);
+    const Eigen::MatrixXd Y = ritzSolver.eigenvectors().rightCols(blockSize).rowwise().reverse();
+    eigenvalues = ritzSolver.eigenvalues().tail(blockSize).reverse();
+
+    const Eigen::MatrixXd updatedX = Q.leftCols(basisSize) * Y;
+    // New search directions are the components of the update orthogonal to X
+    P = updatedX - X * (X.transpose() * updatedX);
+    directionColumns = blockSize;
+    X = updatedX;
+    AX = AQ * Y;
+  }
+
+  return boost::none;
 }
 
 bool MetricMatrix::operator == (const MetricMatrix& other) const {
@@ -25,7 +25,8 @@
 #ifndef INCLUDE_MOLASSEMBLER_DISTANCE_GEOMETRY_METRIC_MATRIX_H
 #define INCLUDE_MOLASSEMBLER_DISTANCE_GEOMETRY_METRIC_MATRIX_H
 
-#include <Eigen/Core>
+#include <Eigen/Eigenvalues>
+#include "boost/optional/optional_fwd.hpp"
 
 #include "Molassembler/DistanceGeometry/DistanceGeometry.h"
 
@@ -33,6 +34,52 @@ namespace Scine {
 namespace Molassembler {
 namespace DistanceGeometry {
 
+class MetricMatrix;
+
+/**
+ * @brief Reusable state for embedding metric matrices
+ *
+ * Keeps eigensolver workspaces allocated across embeddings of metric matrices
+ * of the same size, avoiding repeated allocations when many conformers of a
+ * molecule are generated.
+ *
+ * @note Not thread-safe. Use one instance per thread.
+ */
+class EmbeddingWorkspace {
+public:
+  /*! @brief Whether to warm start iterative eigenpair calculations
+   *
+   * If set, iterative eigenpair calculations for metric matrices of the same
+   * size as the previous embedding start from the previous embedding's
+   * eigenvectors. This reduces the number of iterations needed for similar
+   * metric matrices, but makes results depend on the order in which metric
+   * matrices are embedded at the level of the convergence tolerance.
+   *
+   * Defaults to false.
+   */
+  bool warmStart = false;
+
+private:
+  friend class MetricMatrix;
+
+  //! Full diagonalization solver
+  Eigen::SelfAdjointEigenSolver<Eigen::MatrixXd> solver_;
+  //! Symmetric copy of the metric matrix
+  Eigen::MatrixXd symmetric_;
+  //! Current eigenvector approximations, one per column
+  Eigen::MatrixXd subspace_;
+  //! Images of the current eigenvector approximations under the metric matrix
+  Eigen::MatrixXd subspaceImage_;
+  //! Previous search directions
+  Eigen::MatrixXd directions_;
+  //! Orthonormal basis of the Rayleigh-Ritz search space
+  Eigen::MatrixXd basis_;
+  //! Images of the search space basis under the metric matrix
+  Eigen::MatrixXd basisImage_;
+  //! Whether subspace_ holds converged eigenvectors of the previous embedding
+  bool hasPreviousSubspace_ = false;
+};
+
 class MetricMatrix {
 public:
 /* Constructors */
@@ -51,12 +98,24 @@ public:
    * Embeds itself into 4D space, returning a dynamically sized Matrix where
    * every column vector is the coordinates of a particle.
    *
-   * @note For Molecules of size 20 and lower, employs full diagonalization. If
+   * @note For Molecules of size 70 and lower, employs full diagonalization. If
    * larger, attempts to calculate only the required eigenpairs. If that fails,
    * falls back on full diagonalization.
    */
   Eigen::MatrixXd embed() const;
 
+  /*! @brief Embeds metric matrix into four dimensional space reusing a workspace
+   *
+   * As embed(), but reuses the solver allocations of the passed workspace.
+   * If the workspace is set to warm start, only the required eigenpairs are
+   * calculated for molecules larger than 20.
+   *
+   * @complexity{@math{\Theta(N^2)} per iteration for the iterative
+   * calculation of the four algebraically largest eigenpairs,
+   * @math{\Theta(9 N^3)} for full diagonalization}
+   */
+  Eigen::MatrixXd embed(EmbeddingWorkspace& workspace) const;
+
   /*! @brief Implements embedding employing full diagonalization
    *
    * Uses Eigen's SelfAdjointEigenSolver to fully diagonalize the matrix,
@@ -70,6 +129,24 @@ public:
    */
   Eigen::MatrixXd embedWithFullDiagonalization() const;
 
+  /*! @brief Implements embedding employing full diagonalization reusing a workspace
+   *
+   * @complexity{@math{\Theta(9 N^3)}}
+   */
+  Eigen::MatrixXd embedWithFullDiagonalization(EmbeddingWorkspace& workspace) const;
+
+  /*! @brief Implements embedding by iterative calculation of the largest eigenpairs
+   *
+   * Calculates the four algebraically largest eigenpairs with a locally
+   * optimal block preconditioned conjugate gradient (LOBPCG) method.
+   *
+   * @complexity{@math{\Theta(N^2)} per iteration}
+   *
+   * @returns None if the eigenpairs do not converge within the iteration
+   * limit
+   */
+  boost::optional<Eigen::MatrixXd> embedWithPartialDiagonalization(EmbeddingWorkspace& workspace) const;
+
 /* Operators */
   bool operator == (const MetricMatrix& other) const;
 
@@ -0,0 +1,507 @@
+/*!@file
+ * @copyright This code is licensed under the 3-clause BSD license.
+ *   Copyright ETH Zurich, Laboratory of Physical Chemistry, Reiher Group.
+ *   See LICENSE.txt for details.
+ */
+
+#include "Molassembler/DistanceGeometry/ConformerGeneration.h"
+
+#include "boost/filesystem.hpp"
+#include "boost/functional/hash.hpp"
+#include "boost/interprocess/file_mapping.hpp"
+#include "boost/interprocess/mapped_region.hpp"
+#include "nlohmann/json.hpp"
+
+#include "Molassembler/DistanceGeometry/Error.h"
+#include "Molassembler/Graph/PrivateGraph.h"
+#include "Molassembler/Serialization.h"
+
+#include <fstream>
+#include <mutex>
+#include <sstream>
+#include <unordered_map>
+
+namespace Scine {
+namespace Molassembler {
+namespace DistanceGeometry {
+namespace {
+
+/* Keys of the JSON representation:
+ * - m: Molecule JSON Object (see JsonSerialization)
+ * - c: Configuration Object
+ *   - p: Partiality index
+ *   - r: Refinement step limit
+ *   - g: Refinement gradient target
+ *   - l: Spatial model loosening
+ *   - q: Refinement precision
+ *   - k: Distance term skin width
+ *   - h: Refinement history length
+ *   - t: Whether refinement history is retained across stages
+ *   - f: Fixed positions, each a List of atom index and x, y, z in bohr
+ * - b: Pairwise bounds matrix as a row-major List
+ * - s: Smoothed distance bounds matrix as a row-major List (key omitted if
+ *   smoothing failed)
+ * - x: List of chiral constraint Objects
+ *   - s: List of four site atom index Lists
+ *   - l: Lower bound
+ *   - u: Upper bound
+ *   - w: Weight
+ * - d: List of dihedral constraint Objects (keys as in chiral constraints,
+ *   without weight)
+ */
+
+nlohmann::json serializeMatrix(const Eigen::MatrixXd& matrix) {
+  nlohmann::json j = nlohmann::json::array();
+  for(Eigen::Index i = 0; i < matrix.rows(); ++i) {
+    for(Eigen::Index k = 0; k < matrix.cols(); ++k) {
+      j.push_back(matrix(i, k));
+    }
+  }
+  return j;
+}
+
+Eigen::MatrixXd deserializeMatrix(const nlohmann::json& j, const unsigned N) {
+  if(j.size() != N * N) {
+    throw std::runtime_error("Serialized matrix has unexpected size");
+  }
+
+  Eigen::MatrixXd matrix(N, N);
+  for(unsigned i = 0; i < N; ++i) {
+    for(unsigned k = 0; k < N; ++k) {
+      matrix(i, k) = j.at(i * N + k).get<double>();
+    }
+  }
+  return matrix;
+}
+
+//! Serializes only the explicit entries as (row, column, value) triples
+nlohmann::json serializeSparseMatrix(const SpatialModel::SparseBoundsMatrix& matrix) {
+  nlohmann::json j = nlohmann::json::array();
+  for(Eigen::Index k = 0; k < matrix.outerSize(); ++k) {
+    for(SpatialModel::SparseBoundsMatrix::InnerIterator it(matrix, k); it; ++it) {
+      j.push_back({it.row(), it.col(), it.value()});
+    }
+  }
+  return j;
+}
+
+//! Also reads dense matrices serialized by earlier versions
+SpatialModel::SparseBoundsMatrix deserializeSparseMatrix(const nlohmann::json& j, const unsigned N) {
+  if(!j.empty() && j.front().is_number()) {
+    return deserializeMatrix(j, N).sparseView();
+  }
+
+  std::vector<Eigen::Triplet<double>> triplets;
+  triplets.reserve(j.size());
+  for(const auto& entry : j) {
+    const auto row = entry.at(0).get<unsigned>();
+    const auto col = entry.at(1).get<unsigned>();
+    if(row >= N || col >= N) {
+      throw std::runtime_error("Serialized sparse matrix entry out of bounds");
+    }
+    triplets.emplace_back(row, col, entry.at(2).get<double>());
+  }
+
+  SpatialModel::SparseBoundsMatrix matrix(N, N);
+  matrix.setFromTriplets(std::begin(triplets), std::end(triplets));
+  return matrix;
+}
+
+template<typename SiteSequence>
+nlohmann::json serializeSites(const SiteSequence& sites) {
+  nlohmann::json j = nlohmann::json::array();
+  for(const auto& site : sites) {
+    j.push_back(site);
+  }
+  return j;
+}
+
+template<typename SiteSequence>
+SiteSequence deserializeSites(const nlohmann::json& j) {
+  SiteSequence sites;
+  if(j.size() != sites.size()) {
+    throw std::runtime_error("Serialized constraint does not have four sites");
+  }
+
+  for(unsigned i = 0; i < sites.size(); ++i) {
+    sites.at(i) = j.at(i).get<typename SiteSequence::value_type>();
+  }
+  return sites;
+}
+
+nlohmann::json serializeConfiguration(const Configuration& configuration) {
+  nlohmann::json j;
+  j["p"] = static_cast<unsigned>(configuration.partiality);
+  j["r"] = configuration.refinementStepLimit;
+  j["g"] = configuration.refinementGradientTarget;
+  j["l"] = configuration.spatialModelLoosening;
+  j["q"] = static_cast<unsigned>(configuration.refinementPrecision);
+  j["o"] = static_cast<unsigned>(configuration.refinementOptimizer);
+  j["k"] = configuration.distanceTermSkin;
+  j["h"] = configuration.refinementHistoryLength;
+  j["t"] = configuration.retainRefinementHistory;
+  j["pc"] = configuration.preconditionRefinement;
+  j["b"] = configuration.refinementBatchSize;
+  j["dh"] = configuration.deferHydrogens;
+  j["fs"] = configuration.fragmentSize;
+  j["s"] = configuration.chiralityScreeningThreshold;
+  j["si"] = configuration.chiralityProbeIterations;
+  j["st"] = configuration.chiralityProbeThreshold;
+  j["f"] = nlohmann::json::array();
+  for(const auto& indexPositionPair : configuration.fixedPositions) {
+    j["f"].push_back({
+      indexPositionPair.first,
+      indexPositionPair.second.x(),
+      indexPositionPair.second.y(),
+      indexPositionPair.second.z()
+    });
+  }
+  return j;
+}
+
+Configuration deserializeConfiguration(const nlohmann::json& j) {
+  Configuration configuration;
+  configuration.partiality = static_cast<Partiality>(j.at("p").get<unsigned>());
+  configuration.refinementStepLimit = j.at("r").get<unsigned>();
+  configuration.refinementGradientTarget = j.at("g").get<double>();
+  configuration.spatialModelLoosening = j.at("l").get<double>();
+  configuration.refinementPrecision = static_cast<RefinementPrecision>(j.at("q").get<unsigned>());
+  configuration.refinementOptimizer = static_cast<RefinementOptimizer>(j.value("o", 0U));
+  configuration.distanceTermSkin = j.at("k").get<double>();
+  configuration.refinementHistoryLength = j.at("h").get<unsigned>();
+  configuration.retainRefinementHistory = j.at("t").get<bool>();
+  configuration.preconditionRefinement = j.value("pc", false);
+  configuration.refinementBatchSize = j.at("b").get<unsigned>();
+  configuration.deferHydrogens = j.value("dh", false);
+  configuration.fragmentSize = j.value("fs", 0U);
+  configuration.chiralityScreeningThreshold = j.at("s").get<double>();
+  configuration.chiralityProbeIterations = j.at("si").get<unsigned>();
+  configuration.chiralityProbeThreshold = j.at("st").get<double>();
+  for(const auto& fixed : j.at("f")) {
+    configuration.fixedPositions.emplace_back(
+      fixed.at(0).get<AtomIndex>(),
+      Utils::Position {
+        fixed.at(1).get<double>(),
+        fixed.at(2).get<double>(),
+        fixed.at(3).get<double>()
+      }
+    );
+  }
+  return configuration;
+}
+
+std::shared_ptr<PreparedModel::Impl> deserializeImpl(const nlohmann::json& j) {
+  Molecule molecule = JsonSerialization(j.at("m").dump());
+  const unsigned N = molecule.graph().N();
+
+  auto data = std::make_shared<MoleculeDGInformation>();
+  data->bounds = deserializeSparseMatrix(j.at("b"), N);
+  for(const auto& chiral : j.at("x")) {
+    ChiralConstraint constraint {
+      deserializeSites<ChiralConstraint::SiteSequence>(chiral.at("s")),
+      chiral.at("l").get<double>(),
+      chiral.at("u").get<double>()
+    };
+    constraint.weight = chiral.at("w").get<double>();
+    data->chiralConstraints.push_back(std::move(constraint));
+  }
+  for(const auto& dihedral : j.at("d")) {
+    data->dihedralConstraints.emplace_back(
+      deserializeSites<DihedralConstraint::SiteSequence>(dihedral.at("s")),
+      dihedral.at("l").get<double>(),
+      dihedral.at("u").get<double>()
+    );
+  }
+  data->rotatableGroups = MoleculeDGInformation::make(data->dihedralConstraints, molecule);
+
+  boost::optional<DistanceBoundsMatrix> smoothedBounds;
+  if(j.count("s") > 0) {
+    smoothedBounds = DistanceBoundsMatrix {deserializeMatrix(j.at("s"), N)};
+  }
+
+  return std::make_shared<PreparedModel::Impl>(
+    std::move(molecule),
+    deserializeConfiguration(j.at("c")),
+    std::move(data),
+    std::move(smoothedBounds)
+  );
+}
+
+//! Parses a JSON file directly from a read-only memory mapping of it
+nlohmann::json parseMappedFile(const boost::filesystem::path& path) {
+  const boost::interprocess::file_mapping mapping {
+    path.string().c_str(),
+    boost::interprocess::read_only
+  };
+  const boost::interprocess::mapped_region region {
+    mapping,
+    boost::interprocess::read_only
+  };
+  const char* begin = static_cast<const char*>(region.get_address());
+  return nlohmann::json::parse(begin, begin + region.get_size());
+}
+
+std::size_t cacheKey(const Molecule& molecule, const std::string& configurationSerialization) {
+  std::size_t key = molecule.hash();
+  boost::hash_combine(key, configurationSerialization);
+  return key;
+}
+
+/*! @brief Models loaded from caches in this process, shared while in use
+ *
+ * Entries do not keep models alive, so the registry only holds models that are
+ * in use somewhere in the process.
+ */
+class LoadedModels {
+public:
+  using ImplPtr = std::shared_ptr<const PreparedModel::Impl>;
+
+  //! Finds a loaded model of an entry whose molecule and configuration match exactly
+  ImplPtr find(
+    const std::string& entryPath,
+    const std::string& moleculeSerialization,
+    const std::string& configurationSerialization
+  ) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return find_(entryPath, moleculeSerialization, configurationSerialization);
+  }
+
+  /*! @brief Registers a loaded model
+   *
+   * @returns A matching model that was registered concurrently, or @p impl
+   */
+  ImplPtr add(
+    const std::string& entryPath,
+    std::string moleculeSerialization,
+    std::string configurationSerialization,
+    ImplPtr impl
+  ) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if(ImplPtr existing = find_(entryPath, moleculeSerialization, configurationSerialization)) {
+      return existing;
+    }
+
+    // Drop entries of models no longer in use
+    for(auto iter = std::begin(entries_); iter != std::end(entries_); ) {
+      if(iter->second.impl.expired()) {
+        iter = entries_.erase(iter);
+      } else {
+        ++iter;
+      }
+    }
+
+    entries_.emplace(
+      entryPath,
+      Entry {
+        std::move(moleculeSerialization),
+        std::move(configurationSerialization),
+        impl
+      }
+    );
+    return impl;
+  }
+
+private:
+  struct Entry {
+    std::string molecule;
+    std::string configuration;
+    std::weak_ptr<const PreparedModel::Impl> impl;
+  };
+
+  ImplPtr find_(
+    const std::string& entryPath,
+    const std::string& moleculeSerialization,
+    const std::string& configurationSerialization
+  ) const {
+    const auto range = entries_.equal_range(entryPath);
+    for(auto iter = range.first; iter != range.second; ++iter) {
+      const Entry& entry = iter->second;
+      if(
+        entry.molecule == moleculeSerialization
+        && entry.configuration == configurationSerialization
+      ) {
+        if(ImplPtr impl = entry.impl.lock()) {
+          return impl;
+        }
+      }
+    }
+    return nullptr;
+  }
+
+  std::mutex mutex_;
+  //! Entries by cache entry file path
+  std::unordered_multimap<std::string, Entry> entries_;
+};
+
+LoadedModels& loadedModels() {
+  static LoadedModels models;
+  return models;
+}
+
+} // namespace
+
+PreparedModel::Impl::Impl(
+  Molecule passMolecule,
+  Configuration passConfiguration
+) : molecule(std::move(passMolecule)),
+    configuration(std::move(passConfiguration)),
+    distanceBounds(DgError::GraphImpossible)
+{
+  if(molecule.stereopermutators().hasZeroAssignmentStereopermutators()) {
+    throw std::logic_error("Molecule has zero-assignment stereopermutators and cannot be modeled");
+  }
+
+  if(molecule.stereopermutators().hasUnassignedStereopermutators()) {
+    throw std::logic_error("Molecule has unassigned stereopermutators. Spatial models cannot be reused across conformers.");
+  }
+
+  data = std::make_shared<MoleculeDGInformation>(
+    gatherDGInformation(molecule, configuration)
+  );
+  distanceBounds = checkFeasibility(molecule, *data);
+}
+
+PreparedModel::Impl::Impl(
+  Molecule passMolecule,
+  Configuration passConfiguration,
+  std::shared_ptr<MoleculeDGInformation> passData,
+  boost::optional<DistanceBoundsMatrix> smoothedBounds
+) : molecule(std::move(passMolecule)),
+    configuration(std::move(passConfiguration)),
+    data(std::move(passData)),
+    distanceBounds(DgError::GraphImpossible)
+{
+  if(smoothedBounds) {
+    distanceBounds = std::move(smoothedBounds.value());
+  } else {
+    distanceBounds = checkFeasibility(molecule, *data);
+  }
+}
+
+PreparedModel::PreparedModel(
+  const Molecule& molecule,
+  const Configuration& configuration
+) : pImpl_(std::make_shared<Impl>(molecule, configuration)) {}
+
+PreparedModel::PreparedModel(std::shared_ptr<const Impl> impl)
+  : pImpl_(std::move(impl)) {}
+
+PreparedModel PreparedModel::deserialize(const std::string& serialization) {
+  return PreparedModel {
+    deserializeImpl(nlohmann::json::parse(serialization))
+  };
+}
+
+PreparedModel PreparedModel::cached(
+  const Molecule& molecule,
+  const Configuration& configuration,
+  const std::string& directory
+) {
+  const nlohmann::json configurationJson = serializeConfiguration(configuration);
+  const std::string configurationSerialization = configurationJson.dump();
+  std::ostringstream filename;
+  filename << std::hex << cacheKey(molecule, configurationSerialization) << ".json";
+  const boost::filesystem::path cacheDirectory {directory};
+  const boost::filesystem::path filepath = cacheDirectory / filename.str();
+  const std::string entryPath = filepath.string();
+
+  const std::string moleculeSerialization = JsonSerialization(molecule);
+
+  // Models loaded earlier and still in use in this process are shared
+  if(auto impl = loadedModels().find(entryPath, moleculeSerialization, configurationSerialization)) {
+    return PreparedModel {std::move(impl)};
+  }
+
+  if(boost::filesystem::exists(filepath)) {
+    std::shared_ptr<const Impl> impl;
+    try {
+      const nlohmann::json j = parseMappedFile(filepath);
+      /* Hashes can collide, so the stored molecule and configuration have to
+       * match exactly for the entry to be usable.
+       */
+      if(
+        j.at("c") == configurationJson
+        && j.at("m") == nlohmann::json::parse(moleculeSerialization)
+      ) {
+        impl = deserializeImpl(j);
+      }
+    } catch(const std::exception& /* e */) {
+      // Unreadable or malformed entries are replaced below
+    }
+
+    if(impl) {
+      return PreparedModel {
+        loadedModels().add(entryPath, moleculeSerialization, configurationSerialization, std::move(impl))
+      };
+    }
+  }
+
+  PreparedModel model {molecule, configuration};
+
+  /* Write to a uniquely named file first and rename it into place so that
+   * concurrent processes never read a partially written entry
+   */
+  boost::filesystem::create_directories(cacheDirectory);
+  const boost::filesystem::path temporaryPath = cacheDirectory / boost::filesystem::unique_path("%%%%-%%%%-%%%%.tmp");
+  {
+    std::ofstream file {temporaryPath.string()};
+    file << model.serialize();
+    if(!file) {
+      throw std::runtime_error("Could not write bounds cache entry " + temporaryPath.string());
+    }
+  }
+  boost::filesystem::rename(temporaryPath, filepath);
+
+  return PreparedModel {
+    loadedModels().add(entryPath, moleculeSerialization, configurationSerialization, model.pImpl_)
+  };
+}
+
+std::string PreparedModel::serialize() const {
+  nlohmann::json j;
+  j["m"] = nlohmann::json::parse(
+    static_cast<std::string>(JsonSerialization(pImpl_->molecule))
+  );
+  j["c"] = serializeConfiguration(pImpl_->configuration);
+  j["b"] = serializeSparseMatrix(pImpl_->data->bounds);
+  if(pImpl_->distanceBounds) {
+    j["s"] = serializeMatrix(pImpl_->distanceBounds.value().access());
+  }
+
+  j["x"] = nlohmann::json::array();
+  for(const ChiralConstraint& chiral : pImpl_->data->chiralConstraints) {
+    nlohmann::json c;
+    c["s"] = serializeSites(chiral.sites);
+    c["l"] = chiral.lower;
+    c["u"] = chiral.upper;
+    c["w"] = chiral.weight;
+    j["x"].push_back(std::move(c));
+  }
+
+  j["d"] = nlohmann::json::array();
+  for(const DihedralConstraint& dihedral : pImpl_->data->dihedralConstraints) {
+    nlohmann::json d;
+    d["s"] = serializeSites(dihedral.sites);
+    d["l"] = dihedral.lower;
+    d["u"] = dihedral.upper;
+    j["d"].push_back(std::move(d));
+  }
+
+  return j.dump();
+}
+
+const Molecule& PreparedModel::molecule() const {
+  return pImpl_->molecule;
+}
+
+const Configuration& PreparedModel::configuration() const {
+  return pImpl_->configuration;
+}
+
+const PreparedModel::Impl& PreparedModel::impl() const {
+  return *pImpl_;
+}
+
+} // namespace DistanceGeometry
+} // namespace Molassembler
+} // namespace Scine
@@ -20,6 +20,7 @@
 #include "Molassembler/Temple/Adaptors/CyclicFrame.h"
 #include "Molassembler/Temple/Adaptors/Transform.h"
 #include "Molassembler/Temple/Functional.h"
+#include "Molassembler/Temple/Functor.h"
 #include "Molassembler/Temple/Optionals.h"
 #include "Molassembler/Temple/SetAlgorithms.h"
 #include "Molassembler/Temple/Stringify.h"
@@ -98,6 +99,149 @@ Eigen::Vector3d averagePosition(
   return mean / siteAtoms.size();
 }
 
+/* Adds atom-pairwise distance bounds from internal coordinate bounds to
+ * either of the SpatialModel's bounds matrix helper types
+ */
+template<typename Helper>
+void addPairwiseBounds(
+  Helper& bounds,
+  const SpatialModel::BoundsMapType<2>& fixedPositionBounds,
+  const SpatialModel::BoundsMapType<2>& bondBounds,
+  const SpatialModel::BoundsMapType<3>& angleBounds,
+  const SpatialModel::BoundsMapType<4>& dihedralBounds
+) {
+  // Copy the constraints as ground truth
+  bounds.addMap(fixedPositionBounds);
+
+  // Add 1-2 information from the bonds
+  if(fixedPositionBounds.empty()) {
+    /* If there are no ground constraints, then we can just copy over the
+     * entire bond bounds (these are definitely compatible with triangle
+     * inequalities)
+     */
+    bounds.addMap(bondBounds);
+  } else {
+    // Otherwise, we have to carefully add bond information
+    for(const auto& bondPair : bondBounds) {
+      bounds.add(
+        bondPair.first.front(),
+        bondPair.first.back(),
+        bondPair.second
+      );
+    }
+  }
+
+  // Add 1-3 information
+  for(const auto& anglePair : angleBounds) {
+    const auto& indices = anglePair.first;
+    const auto& angleValueBounds = anglePair.second;
+
+    ValueBounds firstBounds = bounds.get(indices.front(), indices.at(1));
+    ValueBounds secondBounds = bounds.get(indices.at(1), indices.back());
+
+    bounds.add(
+      indices.front(),
+      indices.back(),
+      ValueBounds {
+        CommonTrig::lawOfCosines(
+          firstBounds.lower,
+          secondBounds.lower,
+          angleValueBounds.lower
+        ),
+        CommonTrig::lawOfCosines(
+          firstBounds.upper,
+          secondBounds.upper,
+          angleValueBounds.upper
+        )
+      }
+    );
+  }
+
+  // Add 1-4 information
+  for(const auto& dihedralPair : dihedralBounds) {
+    const auto& indices = dihedralPair.first;
+    const auto& dihedralValueBounds = dihedralPair.second;
+
+    ValueBounds firstBounds = bounds.get(indices.front(), indices.at(1));
+    ValueBounds secondBounds = bounds.get(indices.at(1), indices.at(2));
+    ValueBounds thirdBounds = bounds.get(indices.at(2), indices.back());
+
+    auto firstAngleFindIter = angleBounds.find(
+      orderedSequence(
+        indices.at(0),
+        indices.at(1),
+        indices.at(2)
+      )
+    );
+
+    auto secondAngleFindIter = angleBounds.find(
+      orderedSequence(
+        indices.at(1),
+        indices.at(2),
+        indices.at(3)
+      )
+    );
+
+    if(
+      firstAngleFindIter == angleBounds.end()
+      || secondAngleFindIter == angleBounds.end()
+    ) {
+      continue;
+    }
+
+    const auto& abAngleBounds = firstAngleFindIter->second;
+    const auto& bcAngleBounds = secondAngleFindIter->second;
+
+    bounds.add(
+      indices.front(),
+      indices.back(),
+      CommonTrig::dihedralLengthBounds(
+        firstBounds,
+        secondBounds,
+        thirdBounds,
+        abAngleBounds,
+        bcAngleBounds,
+        dihedralValueBounds
+      )
+    );
+  }
+
+}
+
+/* There may be overlapping and possibly conflicting information present in
+ * the gathered data. If data affects the same atom-pair, we must ensure that
+ * we merely raise the lower bound and lower the upper bound, while never
+ * inverting the bounds overall.
+ */
+void narrowBounds(
+  double& lowerBound,
+  double& upperBound,
+  const ValueBounds& bounds
+) {
+  assert(bounds.lower <= bounds.upper);
+  assert(lowerBound <= upperBound);
+
+  if(lowerBound != 0.0 && upperBound != 0.0) {
+    if(
+      bounds.lower > lowerBound
+      && bounds.lower < upperBound
+    ) {
+      lowerBound = bounds.lower;
+    }
+
+    // Try to lower the upper bound
+    if(
+      bounds.upper < upperBound
+      && bounds.upper > lowerBound
+    ) {
+      upperBound = bounds.upper;
+    }
+  } else {
+    lowerBound = bounds.lower;
+    upperBound = bounds.upper;
+  }
+}
+
 } // namespace
 
 // General availability of static constexpr members
@@ -111,6 +255,12 @@ const ValueBounds SpatialModel::defaultDihedralBounds {std::nextafter(-M_PI, 0),
 SpatialModel::SpatialModel(
   const Molecule& molecule,
   const Configuration& configuration
+) : SpatialModel(molecule, configuration, {}) {}
+
+SpatialModel::SpatialModel(
+  const Molecule& molecule,
+  const Configuration& configuration,
+  const std::vector<BondIndex>& deferredBonds
 ) : molecule_(molecule) {
   /* This is overall a pretty complicated constructor since it encompasses the
    * entire conversion from a molecular graph into some model of the internal
@@ -134,10 +284,31 @@ SpatialModel::SpatialModel(
    * positions, not generated from graph or stereopermutator information.
    */
 
+  const auto isDeferred = [&](const BondIndex& bond) -> bool {
+    return std::find(
+      std::begin(deferredBonds),
+      std::end(deferredBonds),
+      bond
+    ) != std::end(deferredBonds);
+  };
+
   // Check invariants
+  const bool hasUnassigned = (
+    Temple::any_of(
+      molecule.stereopermutators().atomStereopermutators(),
+      [](const AtomStereopermutator& permutator) -> bool {
+        return !permutator.assigned();
+      }
+    ) || Temple::any_of(
+      molecule.stereopermutators().bondStereopermutators(),
+      [&](const BondStereopermutator& permutator) -> bool {
+        return !permutator.assigned() && !isDeferred(permutator.placement());
+      }
+    )
+  );
   if(
     molecule.stereopermutators().hasZeroAssignmentStereopermutators()
-    || molecule.stereopermutators().hasUnassignedStereopermutators()
+    || hasUnassigned
   ) {
     throw std::logic_error("Failed precondition: molecule has zero-assignment or unassigned stereopermutators");
   }
@@ -192,6 +363,7 @@ SpatialModel::SpatialModel(
       fixedPositionPair.second * Utils::Constants::angstrom_per_bohr
     );
   }
+  fixedAtoms_ = Temple::sorted(Temple::map(configuration.fixedPositions, Temple::Functor::first));
 
   // Set bond distances
   modelBondDistances_(fixedAngstromPositions, configuration.spatialModelLoosening);
@@ -225,6 +397,10 @@ SpatialModel::SpatialModel(
 
   // Get 1-4 information from BondStereopermutators
   for(const auto& bondStereopermutator : molecule_.stereopermutators().bondStereopermutators()) {
+    if(isDeferred(bondStereopermutator.placement())) {
+      continue;
+    }
+
     addBondStereopermutatorInformation(
       bondStereopermutator,
       molecule_.stereopermutators().at(bondStereopermutator.placement().first),
@@ -284,6 +460,75 @@ void SpatialModel::setDihedralBoundsIfEmpty(
   );
 }
 
+void SpatialModel::replaceFixedPositions(const Configuration::FixedPositions& fixedPositions) {
+  if(Temple::sorted(Temple::map(fixedPositions, Temple::Functor::first)) != fixedAtoms_) {
+    throw std::invalid_argument("Fixed positions do not fix the atoms fixed in modeling");
+  }
+
+  FixedPositionsMapType fixedAngstromPositions;
+  for(const auto& fixedPositionPair : fixedPositions) {
+    fixedAngstromPositions.emplace(
+      fixedPositionPair.first,
+      fixedPositionPair.second * Utils::Constants::angstrom_per_bohr
+    );
+  }
+
+  const auto allFixed = [&](const auto& indices) -> bool {
+    return Temple::all_of(
+      indices,
+      [&](const AtomIndex i) { return fixedAngstromPositions.count(i) > 0; }
+    );
+  };
+
+  for(auto& constraintPair : constraints_) {
+    const double distance = Cartesian::distance(
+      fixedAngstromPositions.at(constraintPair.first.front()),
+      fixedAngstromPositions.at(constraintPair.first.back())
+    );
+    constraintPair.second = ValueBounds {distance, distance};
+  }
+
+  /* Internal coordinates between fixed atoms are modeled exactly from their
+   * positions, all others are independent of them
+   */
+  for(auto& bondPair : bondBounds_) {
+    if(allFixed(bondPair.first) && bondPair.second.lower == bondPair.second.upper) {
+      const double distance = Cartesian::distance(
+        fixedAngstromPositions.at(bondPair.first.front()),
+        fixedAngstromPositions.at(bondPair.first.back())
+      );
+      bondPair.second = ValueBounds {distance, distance};
+    }
+  }
+
+  for(auto& anglePair : angleBounds_) {
+    if(allFixed(anglePair.first) && anglePair.second.lower == anglePair.second.upper) {
+      const double angle = Cartesian::angle(
+        fixedAngstromPositions.at(anglePair.first.at(0)),
+        fixedAngstromPositions.at(anglePair.first.at(1)),
+        fixedAngstromPositions.at(anglePair.first.at(2))
+      );
+      anglePair.second = clamp(ValueBounds {angle, angle}, angleClampBounds);
+    }
+  }
+
+  for(DihedralConstraint& constraint : dihedralConstraints_) {
+    if(
+      constraint.lower == constraint.upper
+      && Temple::all_of(constraint.sites, allFixed)
+    ) {
+      const double dihedral = Cartesian::dihedral(
+        averagePosition(constraint.sites.at(0), fixedAngstromPositions),
+        averagePosition(constraint.sites.at(1), fixedAngstromPositions),
+        averagePosition(constraint.sites.at(2), fixedAngstromPositions),
+        averagePosition(constraint.sites.at(3), fixedAngstromPositions)
+      );
+      constraint.lower = dihedral;
+      constraint.upper = dihedral;
+    }
+  }
+}
+
 void SpatialModel::addAtomStereopermutatorInformation(
   const AtomStereopermutator& permutator,
   const PrivateGraph& graph,
@@ -434,6 +679,11 @@ void SpatialModel::addAtomStereopermutatorInformation(
    * NOTE: Cone angles are calculated for non-haptic sites too -> (0, 0).
    */
   const unsigned siteCount = ranking.sites.size();
+  // The cycle search for the center is independent of the site pair
+  const double cycleMultiplier = smallestCycleDistortionMultiplier(
+    centerAtom,
+    graph.cycles()
+  );
   for(SiteIndex i {0}; i < siteCount - 1; ++i) {
     if(!feasiblePermutations.coneAngles.at(i)) {
       continue;
@@ -466,8 +716,15 @@ void SpatialModel::addAtomStereopermutatorInformation(
         );
       } else {
         /* The computed angle bounds are valid for each pair of atoms
-         * constituting each site
+         * constituting each site, so they are modeled once per site pair
          */
+        const ValueBounds siteAngleBounds = modelSiteAngleBounds(
+          permutator,
+          {i, j},
+          looseningMultiplier,
+          cycleMultiplier,
+          graph
+        );
         Temple::forEach(
           Temple::Adaptors::allPairs(
             ranking.sites.at(i),
@@ -476,12 +733,7 @@ void SpatialModel::addAtomStereopermutatorInformation(
           [&](const AtomIndex x, const AtomIndex y) -> void {
             setAngleBoundsIfEmpty(
               orderedSequence(x, centerAtom, y),
-              modelSiteAngleBounds(
-                permutator,
-                {i, j},
-                looseningMultiplier,
-                graph
-              )
+              siteAngleBounds
             );
           }
         );
@@ -786,106 +1038,34 @@ SpatialModel::BoundsMatrix SpatialModel::makePairwiseBounds(
   const BoundsMapType<4>& dihedralBounds
 ) {
   BoundsMatrixHelper bounds(N);
-
-  // Copy the constraints as ground truth
-  bounds.addMap(fixedPositionBounds);
-
-  // Add 1-2 information from the bonds
-  if(fixedPositionBounds.empty()) {
-    /* If there are no ground constraints, then we can just copy over the
-     * entire bond bounds (these are definitely compatible with triangle
-     * inequalities)
-     */
-    bounds.addMap(bondBounds);
-  } else {
-    // Otherwise, we have to carefully add bond information
-    for(const auto& bondPair : bondBounds) {
-      bounds.add(
-        bondPair.first.front(),
-        bondPair.first.back(),
-        bondPair.second
-      );
-    }
-  }
-
-  // Add 1-3 information
-  for(const auto& anglePair : angleBounds) {
-    const auto& indices = anglePair.first;
-    const auto& angleValueBounds = anglePair.second;
-
-    ValueBounds firstBounds = bounds.get(indices.front(), indices.at(1));
-    ValueBounds secondBounds = bounds.get(indices.at(1), indices.back());
-
-    bounds.add(
-      indices.front(),
-      indices.back(),
-      ValueBounds {
-        CommonTrig::lawOfCosines(
-          firstBounds.lower,
-          secondBounds.lower,
-          angleValueBounds.lower
-        ),
-        CommonTrig::lawOfCosines(
-          firstBounds.upper,
-          secondBounds.upper,
-          angleValueBounds.upper
-        )
-      }
-    );
-  }
-
-  // Add 1-4 information
-  for(const auto& dihedralPair : dihedralBounds) {
-    const auto& indices = dihedralPair.first;
-    const auto& dihedralValueBounds = dihedralPair.second;
-
-    ValueBounds firstBounds = bounds.get(indices.front(), indices.at(1));
-    ValueBounds secondBounds = bounds.get(indices.at(1), indices.at(2));
-    ValueBounds thirdBounds = bounds.get(indices.at(2), indices.back());
-
-    auto firstAngleFindIter = angleBounds.find(
-      orderedSequence(
-        indices.at(0),
-        indices.at(1),
-        indices.at(2)
-      )
-    );
-
-    auto secondAngleFindIter = angleBounds.find(
-      orderedSequence(
-        indices.at(1),
-        indices.at(2),
-        indices.at(3)
-      )
-    );
-
-    if(
-      firstAngleFindIter == angleBounds.end()
-      || secondAngleFindIter == angleBounds.end()
-    ) {
-      continue;
-    }
-
-    const auto& abAngleBounds = firstAngleFindIter->second;
-    const auto& bcAngleBounds = secondAngleFindIter->second;
-
-    bounds.add(
-      indices.front(),
-      indices.back(),
-      CommonTrig::dihedralLengthBounds(
-        firstBounds,
-        secondBounds,
-        thirdBounds,
-        abAngleBounds,
-        bcAngleBounds,
-        dihedralValueBounds
-      )
-    );
-  }
-
+  addPairwiseBounds(
+    bounds,
+    fixedPositionBounds,
+    bondBounds,
+    angleBounds,
+    dihedralBounds
+  );
   return bounds.matrix;
 }
 
+SpatialModel::SparseBoundsMatrix SpatialModel::makeSparsePairwiseBounds(
+  unsigned N,
+  const BoundsMapType<2>& fixedPositionBounds,
+  const BoundsMapType<2>& bondBounds,
+  const BoundsMapType<3>& angleBounds,
+  const BoundsMapType<4>& dihedralBounds
+) {
+  SparseBoundsMatrixHelper bounds(N);
+  addPairwiseBounds(
+    bounds,
+    fixedPositionBounds,
+    bondBounds,
+    angleBounds,
+    dihedralBounds
+  );
+  return bounds.matrix();
+}
+
 double SpatialModel::siteCentralAngle(
   const AtomIndex placement,
   const Shapes::Shape& shape,
@@ -920,6 +1100,15 @@ double SpatialModel::siteCentralAngle(
     return idealAngle;
   }
 
+  return smallCycleSiteAngle(placement, ranking, sites, inner).value_or(idealAngle);
+}
+
+boost::optional<double> SpatialModel::smallCycleSiteAngle(
+  const AtomIndex placement,
+  const RankingInformation& ranking,
+  const std::pair<SiteIndex, SiteIndex>& sites,
+  const PrivateGraph& inner
+) {
   /* The shape also does not distort if the central index isn't part of a
    * small cycle (i.e. size < 6). So we look for cycles that contain the central
    * index and the specified two monoatomic sites.
@@ -940,7 +1129,7 @@ double SpatialModel::siteCentralAngle(
 
   // If the range is zero-length, there are no cycles with both edges!
   if(cycleRange.begin() == cycleRange.end()) {
-    return idealAngle;
+    return boost::none;
   }
 
   unsigned smallestCycleSize = 100;
@@ -954,7 +1143,7 @@ double SpatialModel::siteCentralAngle(
 
   // If the smallest cycle isn't small, then the angle doesn't distort
   if(smallestCycleSize >= 6) {
-    return idealAngle;
+    return boost::none;
   }
 
   /* Now it's time to model how the angle distorts for the given cycle.
@@ -1029,6 +1218,25 @@ ValueBounds SpatialModel::modelSiteAngleBounds(
   const std::pair<SiteIndex, SiteIndex>& sites,
   const double looseningMultiplier,
   const PrivateGraph& inner
+) {
+  return modelSiteAngleBounds(
+    permutator,
+    sites,
+    looseningMultiplier,
+    smallestCycleDistortionMultiplier(
+      permutator.placement(),
+      inner.cycles()
+    ),
+    inner
+  );
+}
+
+ValueBounds SpatialModel::modelSiteAngleBounds(
+  const AtomStereopermutator& permutator,
+  const std::pair<SiteIndex, SiteIndex>& sites,
+  const double looseningMultiplier,
+  const double cycleMultiplier,
+  const PrivateGraph& inner
 ) {
   assert(permutator.assigned());
 
@@ -1041,10 +1249,7 @@ ValueBounds SpatialModel::modelSiteAngleBounds(
   const double absoluteVariance = [&]() -> double{
     // Turn the angle relative variance into an absolute variance
     double variance = SpatialModel::angleRelativeVariance * centralAngle;
-    variance *= smallestCycleDistortionMultiplier(
-      permutator.placement(),
-      inner.cycles()
-    );
+    variance *= cycleMultiplier;
     variance *= looseningMultiplier;
 
     // Additional terms are the upper(!) cone angles!
@@ -1221,6 +1426,61 @@ SpatialModel::BoundsMatrix SpatialModel::makePairwiseBounds() const {
   );
 }
 
+SpatialModel::SparseBoundsMatrix SpatialModel::makeSparsePairwiseBounds() const {
+  return makeSparsePairwiseBounds(
+    molecule_.graph().N(),
+    constraints_,
+    bondBounds_,
+    angleBounds_,
+    dihedralBounds_
+  );
+}
+
+SpatialModel::DihedralOverlay SpatialModel::makeDihedralOverlay(
+  const BondStereopermutator& permutator,
+  const double looseningMultiplier
+) const {
+  /* Model the bond stereopermutator in a scratch copy without any dihedral
+   * information so that exactly its contributions can be collected
+   */
+  SpatialModel scratch = *this;
+  scratch.dihedralBounds_.clear();
+  scratch.dihedralConstraints_.clear();
+  scratch.addBondStereopermutatorInformation(
+    permutator,
+    molecule_.stereopermutators().at(permutator.placement().first),
+    molecule_.stereopermutators().at(permutator.placement().second),
+    looseningMultiplier,
+    {}
+  );
+
+  const SparseBoundsMatrix pairwiseBounds = makeSparsePairwiseBounds(
+    molecule_.graph().N(),
+    constraints_,
+    bondBounds_,
+    angleBounds_,
+    scratch.dihedralBounds_
+  );
+
+  DihedralOverlay overlay;
+  for(const auto& dihedralPair : scratch.dihedralBounds_) {
+    const AtomIndex i = dihedralPair.first.front();
+    const AtomIndex j = dihedralPair.first.back();
+    // Dihedrals without angle information yield no distance bounds
+    if(pairwiseBounds.coeff(i, j) == 0.0) {
+      continue;
+    }
+
+    overlay.distanceBounds.emplace(
+      orderedSequence(i, j),
+      ValueBounds {pairwiseBounds.coeff(j, i), pairwiseBounds.coeff(i, j)}
+    );
+  }
+  overlay.dihedralConstraints = std::move(scratch.dihedralConstraints_);
+
+  return overlay;
+}
+
 std::vector<DistanceGeometry::ChiralConstraint> SpatialModel::getChiralConstraints() const {
   return chiralConstraints_;
 }
@@ -1475,7 +1735,7 @@ boost::optional<ValueBounds> SpatialModel::coneAngle(
       }
     );
 
-    auto lowerCircumradiusResult = CyclicPolygons::Detail::convexCircumradius(
+    auto lowerCircumradiusResult = CyclicPolygons::Detail::cachedConvexCircumradius(
       Temple::map(
         distances,
         [&](const double distance) -> double {
@@ -1484,7 +1744,7 @@ boost::optional<ValueBounds> SpatialModel::coneAngle(
       )
     );
 
-    auto upperCircumradiusResult = CyclicPolygons::Detail::convexCircumradius(
+    auto upperCircumradiusResult = CyclicPolygons::Detail::cachedConvexCircumradius(
       Temple::map(
         distances,
         [&](const double distance) -> double {
@@ -2095,42 +2355,13 @@ void SpatialModel::BoundsMatrixHelper::add(
   AtomIndex j,
   const ValueBounds& bounds
 ) {
-  /* There may be overlapping and possibly conflicting information present in
-   * the gathered data. If data affects the same atom-pair, we must ensure that
-   * we merely raise the lower bound and lower the upper bound, while never
-   * inverting the bounds overall.
-   */
   assert(i != j);
   // Ensure i < j
   if(j < i) {
     std::swap(i, j);
   }
 
-  double& lowerBound = matrix(j, i);
-  double& upperBound = matrix(i, j);
-
-  assert(bounds.lower <= bounds.upper);
-  assert(lowerBound <= upperBound);
-
-  if(lowerBound != 0.0 && upperBound != 0.0) {
-    if(
-      bounds.lower > lowerBound
-      && bounds.lower < upperBound
-    ) {
-      lowerBound = bounds.lower;
-    }
-
-    // Try to lower the upper bound
-    if(
-      bounds.upper < upperBound
-      && bounds.upper > lowerBound
-    ) {
-      upperBound = bounds.upper;
-    }
-  } else {
-    lowerBound = bounds.lower;
-    upperBound = bounds.upper;
-  }
+  narrowBounds(matrix(j, i), matrix(i, j), bounds);
 }
 
 ValueBounds SpatialModel::BoundsMatrixHelper::get(
@@ -2161,6 +2392,87 @@ void SpatialModel::BoundsMatrixHelper::addMap(const BoundsMapType<2>& boundsMap)
   }
 }
 
+SpatialModel::SparseBoundsMatrixHelper::SparseBoundsMatrixHelper(
+  const SparseBoundsMatrix& matrix
+) : N(matrix.cols()) {
+  for(Eigen::Index k = 0; k < matrix.outerSize(); ++k) {
+    for(SparseBoundsMatrix::InnerIterator it(matrix, k); it; ++it) {
+      const AtomIndex row = it.row();
+      const AtomIndex col = it.col();
+      if(row < col) {
+        pairBounds(row, col).upper = it.value();
+      } else {
+        pairBounds(col, row).lower = it.value();
+      }
+    }
+  }
+}
+
+void SpatialModel::SparseBoundsMatrixHelper::add(
+  AtomIndex i,
+  AtomIndex j,
+  const ValueBounds& newBounds
+) {
+  assert(i != j);
+  // Ensure i < j
+  if(j < i) {
+    std::swap(i, j);
+  }
+
+  ValueBounds& existing = pairBounds(i, j);
+  narrowBounds(existing.lower, existing.upper, newBounds);
+}
+
+ValueBounds& SpatialModel::SparseBoundsMatrixHelper::pairBounds(
+  const AtomIndex i,
+  const AtomIndex j
+) {
+  // Absent pairs have no bounds, not the default-constructed bounds
+  assert(i < j);
+  return bounds.emplace(
+    std::array<AtomIndex, 2> {{i, j}},
+    ValueBounds {0.0, 0.0}
+  ).first->second;
+}
+
+void SpatialModel::SparseBoundsMatrixHelper::addMap(const BoundsMapType<2>& boundsMap) {
+  for(const auto& indexArrayBoundsPair : boundsMap) {
+    assert(indexArrayBoundsPair.first.front() < indexArrayBoundsPair.first.back());
+    bounds[indexArrayBoundsPair.first] = indexArrayBoundsPair.second;
+  }
+}
+
+ValueBounds SpatialModel::SparseBoundsMatrixHelper::get(
+  AtomIndex i,
+  AtomIndex j
+) const {
+  if(j < i) {
+    std::swap(i, j);
+  }
+
+  const auto findIter = bounds.find({{i, j}});
+  if(findIter == std::end(bounds)) {
+    return ValueBounds {0.0, 0.0};
+  }
+
+  return findIter->second;
+}
+
+SpatialModel::SparseBoundsMatrix SpatialModel::SparseBoundsMatrixHelper::matrix() const {
+  std::vector<Eigen::Triplet<double>> triplets;
+  triplets.reserve(2 * bounds.size());
+  for(const auto& indexArrayBoundsPair : bounds) {
+    const AtomIndex i = indexArrayBoundsPair.first.front();
+    const AtomIndex j = indexArrayBoundsPair.first.back();
+    triplets.emplace_back(j, i, indexArrayBoundsPair.second.lower);
+    triplets.emplace_back(i, j, indexArrayBoundsPair.second.upper);
+  }
+
+  SparseBoundsMatrix sparse(N, N);
+  sparse.setFromTriplets(std::begin(triplets), std::end(triplets));
+  return sparse;
+}
+
 } // namespace DistanceGeometry
 } // namespace Molassembler
 } // namespace Scine
@@ -24,6 +24,8 @@
 #include "Molassembler/StereopermutatorList.h"
 #include "Molassembler/AtomStereopermutator.h"
 
+#include <Eigen/SparseCore>
+
 #include <unordered_map>
 
 namespace Scine {
@@ -75,6 +77,51 @@ public:
 
     Eigen::MatrixXd matrix;
   };
+
+  /*!
+   * @brief Type used to represent only the explicit atom-pairwise distance
+   *   bounds constructed from bounds on internal coordinates
+   *
+   * Same layout as BoundsMatrix: Strict lower triangle contains lower bounds,
+   * strict upper triangle contains upper bounds. Atom pairs without entries
+   * have no explicit bounds, so that memory scales with the number of
+   * bonded, 1-3 and 1-4 atom pairs instead of quadratically.
+   */
+  using SparseBoundsMatrix = Eigen::SparseMatrix<double>;
+
+  //! Accumulates explicit bounds like BoundsMatrixHelper without dense storage
+  struct SparseBoundsMatrixHelper {
+    inline explicit SparseBoundsMatrixHelper(AtomIndex size) : N(size) {}
+    explicit SparseBoundsMatrixHelper(const SparseBoundsMatrix& matrix);
+
+    void add(AtomIndex i, AtomIndex j, const ValueBounds& bounds);
+    void addMap(const BoundsMapType<2>& boundsMap);
+
+    ValueBounds get(AtomIndex i, AtomIndex j) const;
+
+    //! Collects the accumulated bounds into a sparse matrix
+    SparseBoundsMatrix matrix() const;
+
+    AtomIndex N;
+    BoundsMapType<2> bounds;
+
+  private:
+    //! Accesses the bounds of an ordered pair, inserting zeros if absent
+    ValueBounds& pairBounds(AtomIndex i, AtomIndex j);
+  };
+
+  /*! @brief Dihedral information of a single deferred bond stereopermutator
+   *
+   * Atom-pairwise 1-4 distance bounds and dihedral constraints that a model
+   * constructed with deferred bonds lacks for a specific assignment of one of
+   * those bonds' stereopermutators.
+   */
+  struct DihedralOverlay {
+    //! 1-4 atom-pairwise distance bounds
+    BoundsMapType<2> distanceBounds;
+    //! Dihedral constraints emitted by the bond stereopermutator
+    std::vector<DihedralConstraint> dihedralConstraints;
+  };
 //!@}
 
 //!@name Static members
@@ -222,6 +269,20 @@ public:
     const BoundsMapType<4>& dihedralBounds
   );
 
+  /*! @brief Generates a sparse matrix of explicit atom-pairwise distance bounds
+   *
+   * Identical to makePairwiseBounds(), but never allocates dense storage.
+   *
+   * @complexity{@math{O(P_2 + P_3 + P_4)} expected}
+   */
+  static SparseBoundsMatrix makeSparsePairwiseBounds(
+    unsigned N,
+    const BoundsMapType<2>& fixedPositionBounds,
+    const BoundsMapType<2>& bondBounds,
+    const BoundsMapType<3>& angleBounds,
+    const BoundsMapType<4>& dihedralBounds
+  );
+
   /** @brief Determines the central value of the angle between
    *   AtomStereopermutator sites
    *
@@ -252,6 +313,26 @@ public:
     const PrivateGraph& inner
   );
 
+  /** @brief Determines the angle between two monoatomic sites that is
+   *   enforced by a small cycle containing both and the central atom
+   *
+   * This is the angle that siteCentralAngle() yields if the ideal angle
+   * between the sites is the smallest angle of the shape. It does not depend
+   * on the shape vertices of the sites.
+   *
+   * @complexity{Varies. For most cases, @math{\Omega(1)}}
+   * @pre Both @p sites consist of a single atom
+   *
+   * @return None if the sites are not part of a cycle of size less than six
+   *   with the central atom
+   */
+  static boost::optional<double> smallCycleSiteAngle(
+    AtomIndex placement,
+    const RankingInformation& ranking,
+    const std::pair<SiteIndex, SiteIndex>& sites,
+    const PrivateGraph& inner
+  );
+
   /** @brief Models bounds on the angle between AtomStereopermutator sites
    *
    * @complexity{Varies. For most cases, @math{\Omega(1)}}
@@ -270,6 +351,19 @@ public:
     const PrivateGraph& inner
   );
 
+  /*! @overload
+   *
+   * @param cycleMultiplier Precalculated smallestCycleDistortionMultiplier of
+   *   the permutator's placement, avoiding a cycle search per site pair
+   */
+  static ValueBounds modelSiteAngleBounds(
+    const AtomStereopermutator& permutator,
+    const std::pair<SiteIndex, SiteIndex>& sites,
+    double looseningMultiplier,
+    double cycleMultiplier,
+    const PrivateGraph& inner
+  );
+
   /** @brief Creates a volume-specific chiral constraint from a list of
    *
    * @complexity{@math{\Theta(1)}}
@@ -343,6 +437,29 @@ public:
     const Molecule& molecule,
     const Configuration& configuration
   );
+
+  /**
+   * @brief Model a molecule, deferring dihedral information of some bonds
+   *
+   * Models the molecule as normal, except that the stereopermutators on the
+   * deferred bonds may be unassigned and do not contribute any 1-4
+   * information. Their dihedral information can be generated separately for
+   * each of their assignments with makeDihedralOverlay().
+   *
+   * @complexity{As the other constructor}
+   *
+   * @param molecule The molecule that is to be modeled. This may not contain
+   *   stereopermutators with zero assignments or unassigned stereopermutators
+   *   except for bond stereopermutators on @p deferredBonds.
+   * @param configuration The Distance Geometry configuration object
+   * @param deferredBonds Bonds whose stereopermutators' dihedral information
+   *   is not to be modeled
+   */
+  SpatialModel(
+    const Molecule& molecule,
+    const Configuration& configuration,
+    const std::vector<BondIndex>& deferredBonds
+  );
 //!@}
 
 //!@name Modifiers
@@ -389,6 +506,24 @@ public:
     ValueBounds bounds
   );
 
+  /*! @brief Replaces the information modeled from fixed positions with that
+   *   of other positions of the same atoms
+   *
+   * Only bounds between fixed atoms and dihedral constraints between fixed
+   * sites are modeled from their positions. Replacing them yields the model
+   * of the molecule with the new fixed positions without modeling its
+   * stereopermutators again.
+   *
+   * @complexity{Linear in the number of modeled internal coordinates and
+   * quadratic in the number of fixed atoms}
+   *
+   * @param fixedPositions New positions of the fixed atoms, in bohr
+   *
+   * @throws std::invalid_argument If @p fixedPositions does not fix exactly
+   *   the atoms fixed in modeling
+   */
+  void replaceFixedPositions(const Configuration::FixedPositions& fixedPositions);
+
   /** @brief Adds angle information to the internal coordinate bounds and
    *   collects chiral constraints
    *
@@ -470,6 +605,33 @@ public:
    */
   BoundsMatrix makePairwiseBounds() const;
 
+  /** @brief Generate unsmoothed sparse atom-pairwise distance bounds
+   *
+   * @complexity{@math{O(P_2 + P_3 + P_4)} expected}
+   *
+   * @return Explicit atom-pairwise distance bounds in the same layout as
+   *   makePairwiseBounds(), without entries for pairs lacking bounds
+   */
+  SparseBoundsMatrix makeSparsePairwiseBounds() const;
+
+  /** @brief Models the dihedral information of an assigned deferred bond
+   *   stereopermutator
+   *
+   * Models the bond stereopermutator against the bond and angle bounds of
+   * this model, yielding the 1-4 distance bounds and dihedral constraints it
+   * would have contributed had it not been deferred during construction.
+   *
+   * @complexity{@math{O(P_2 + P_3 + P_4)} expected}
+   *
+   * @param permutator An assigned stereopermutator on one of the deferred
+   *   bonds passed at construction
+   * @param looseningMultiplier A loosening factor for the overall model
+   */
+  DihedralOverlay makeDihedralOverlay(
+    const BondStereopermutator& permutator,
+    double looseningMultiplier
+  ) const;
+
   /** @brief Generates a string graphviz representation of the modeled molecule
    *
    * The graph contains basic connectivity, stereopermutator information
@@ -498,6 +660,8 @@ private:
   // Molecule closure
   const Molecule& molecule_;
 
+  //! Atoms with fixed positions in ascending order
+  std::vector<AtomIndex> fixedAtoms_;
   //! Constraints by fixed positions
   BoundsMapType<2> constraints_;
   //! Bond distance value bounds on index pairs
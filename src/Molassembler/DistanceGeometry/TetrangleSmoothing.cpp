@@ -11,7 +11,10 @@
 #include "Molassembler/Temple/Invoke.h"
 
 #include <Eigen/Dense>
+#include <atomic>
 #include <cfenv>
+#include <exception>
+#include <vector>
 
 namespace Scine {
 namespace Molassembler {
@@ -933,6 +936,141 @@ unsigned tetrangleSmooth(Eigen::Ref<Eigen::MatrixXd> bounds) {
   return iterations;
 }
 
+unsigned tetrangleSmoothParallel(Eigen::Ref<Eigen::MatrixXd> bounds) {
+  const unsigned N = bounds.cols();
+  if(N < 2) {
+    return 0;
+  }
+
+  // Minimal change in the bounds required to consider something has changed
+  constexpr double epsilon = 0.01;
+
+  // Target pairs (k, l) with k < l, flattened for dynamic scheduling
+  std::vector<std::pair<unsigned, unsigned>> pairs;
+  pairs.reserve(N * (N - 1) / 2);
+  for(unsigned k = 0; k < N - 1; ++k) {
+    for(unsigned l = k + 1; l < N; ++l) {
+      pairs.emplace_back(k, l);
+    }
+  }
+
+  using ChangedMatrixType = Eigen::Matrix<bool, Eigen::Dynamic, Eigen::Dynamic>;
+  /* Symmetric flags of pairs whose bounds changed in the previous sweep.
+   * Initially, all pairs are considered changed.
+   */
+  ChangedMatrixType changed = ChangedMatrixType::Constant(N, N, true);
+  changed.diagonal().setConstant(false);
+  ChangedMatrixType nextChanged(N, N);
+
+  /* Exceptions cannot leave the parallel region, so the first one is kept and
+   * rethrown once all threads are done
+   */
+  std::exception_ptr exception;
+  std::atomic<bool> stop {false};
+
+  bool changedSomething;
+  unsigned iterations = 0;
+  do {
+    // All limits of a sweep are calculated from the bounds of the previous one
+    const Eigen::MatrixXd previous = bounds;
+    nextChanged.setConstant(false);
+    changedSomething = false;
+
+#pragma omp parallel for schedule(dynamic) reduction(||:changedSomething)
+    for(unsigned p = 0; p < pairs.size(); ++p) {
+      if(stop) {
+        continue;
+      }
+
+      const unsigned k = pairs[p].first;
+      const unsigned l = pairs[p].second;
+
+      // k < l, so bounds(k, l) is the upper bound, bounds(l, k) the lower
+      const double klLowerBound = previous(l, k);
+      const double klUpperBound = previous(k, l);
+      double lowerLimit = klLowerBound;
+      double upperLimit = klUpperBound;
+
+      try {
+        for(unsigned i = 0; i < N - 1; ++i) {
+          for(unsigned j = i + 1; j < N; ++j) {
+            /* Tetrangle inequalities concern four distinct atoms. Quadruples
+             * with shared indices degenerate to triangles, which triangle
+             * smoothing has already taken care of.
+             */
+            if(i == k || i == l || j == k || j == l) {
+              continue;
+            }
+
+            /* The limits of a quadruple only change if the bounds of one of
+             * its pairs have changed in the previous sweep
+             */
+            if(!(
+              changed(k, l) || changed(i, j)
+              || changed(i, k) || changed(i, l)
+              || changed(j, k) || changed(j, l)
+            )) {
+              continue;
+            }
+
+            const TetrangleLimits limits {previous, {i, j, k, l}};
+
+            if(limits.boundViolation) {
+              throw std::runtime_error("Bound violation found!");
+            }
+
+            lowerLimit = std::max(lowerLimit, limits.klLimits.lower);
+            upperLimit = std::min(upperLimit, limits.klLimits.upper);
+          }
+        }
+
+        if(
+          lowerLimit > klLowerBound
+          && std::fabs(lowerLimit - klLowerBound) / klLowerBound > epsilon
+        ) {
+          if(lowerLimit > klUpperBound) {
+            throw std::runtime_error("Bound violation found!");
+          }
+
+          bounds(l, k) = lowerLimit;
+          nextChanged(k, l) = nextChanged(l, k) = true;
+          changedSomething = true;
+        }
+
+        if(
+          upperLimit < klUpperBound
+          && std::fabs(klUpperBound - upperLimit) / klUpperBound > epsilon
+        ) {
+          if(upperLimit < bounds(l, k)) {
+            throw std::runtime_error("Bound violation found!");
+          }
+
+          bounds(k, l) = upperLimit;
+          nextChanged(k, l) = nextChanged(l, k) = true;
+          changedSomething = true;
+        }
+      } catch(...) {
+#pragma omp critical(tetrangleSmoothingException)
+        {
+          if(!exception) {
+            exception = std::current_exception();
+          }
+        }
+        stop = true;
+      }
+    }
+
+    if(exception) {
+      std::rethrow_exception(exception);
+    }
+
+    changed.swap(nextChanged);
+    ++iterations;
+  } while(changedSomething);
+
+  return iterations;
+}
+
 } // namespace DistanceGeometry
 } // namespace Molassembler
 } // namespace Scine
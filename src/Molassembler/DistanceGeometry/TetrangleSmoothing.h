@@ -31,6 +31,30 @@ namespace DistanceGeometry {
  */
 unsigned tetrangleSmooth(Eigen::Ref<Eigen::MatrixXd> bounds);
 
+/**
+ * @brief Smoothes the bounds matrix using tetrangle inequalities in parallel
+ *
+ * Unlike tetrangleSmooth, calculates all limits of a sweep from the bounds of
+ * the previous sweep, so that target pairs can be processed in parallel. In
+ * sweeps after the first, only quadruples containing a pair whose bounds
+ * changed in the previous sweep are re-evaluated. Only quadruples of four
+ * distinct atoms are considered.
+ *
+ * @pre Assumes @p bounds has already been triangle inequality smoothed
+ *
+ * @param bounds A square matrix with zeros on the diagonal and
+ *   B(j, i) <= B(i, j) for all i < j (lower bounds on strictly lower triangle,
+ *   upper bounds on strictly upper triangle)
+ *
+ * @complexity{@math{\Theta(N^4)} for the first sweep, subsequent sweeps
+ * evaluate limits only for quadruples involving changed pairs}
+ *
+ * @throws std::runtime_error If a bound violation is found
+ *
+ * @return Number of sweeps
+ */
+unsigned tetrangleSmoothParallel(Eigen::Ref<Eigen::MatrixXd> bounds);
+
 } // namespace DistanceGeometry
 } // namespace Molassembler
 } // namespace Scine
@@ -18,6 +18,9 @@
 
 #include "Molassembler/Temple/Functional.h"
 
+#include <exception>
+#include <map>
+
 namespace Scine {
 namespace Molassembler {
 namespace {
@@ -158,6 +161,183 @@ void transferStereopermutators(
   }
 }
 
+//! Heavier side of a bond, which is kept in substitutions
+struct SubstitutionSide {
+  SubstitutionSide(const Molecule& molecule, const BondIndex bond) {
+    const auto sides = molecule.graph().splitAlongBridge(bond);
+
+    // The heavier side has more atoms or, if equal, more mass
+    auto mass = [&molecule](const std::vector<AtomIndex>& side) -> double {
+      return Temple::accumulate(
+        side,
+        0.0,
+        [&molecule](double carry, const AtomIndex i) -> double {
+          return carry + Utils::ElementInfo::mass(molecule.graph().elementType(i));
+        }
+      );
+    };
+
+    bool firstIsLighter = sides.first.size() < sides.second.size();
+    if(sides.first.size() == sides.second.size()) {
+      firstIsLighter = mass(sides.first) < mass(sides.second);
+    }
+
+    if(firstIsLighter) {
+      atoms = sides.second;
+      heavierAtom = bond.second;
+      lighterAtom = bond.first;
+    } else {
+      atoms = sides.first;
+      heavierAtom = bond.first;
+      lighterAtom = bond.second;
+    }
+
+    assert(Temple::makeContainsPredicate(atoms)(heavierAtom));
+  }
+
+  //! Atoms of the heavier side
+  std::vector<AtomIndex> atoms;
+  //! Atom of the bond on the heavier side
+  AtomIndex heavierAtom;
+  //! Atom of the bond on the lighter side
+  AtomIndex lighterAtom;
+};
+
+//! Heavier side of a molecule's bond transferred into a new graph
+struct PreparedSubstitution {
+  PreparedSubstitution(const Molecule& passMolecule, const BondIndex bond)
+    : molecule(passMolecule),
+      side(molecule, bond),
+      vertexMapping(transferGraph(molecule.graph().inner(), graph, side.atoms))
+  {}
+
+  const Molecule& molecule;
+  SubstitutionSide side;
+  PrivateGraph graph;
+  std::unordered_map<AtomIndex, AtomIndex> vertexMapping;
+};
+
+//! Graph and stereopermutators of a substitution product before ranking
+struct SubstitutionProduct {
+  PrivateGraph graph;
+  StereopermutatorList stereopermutators;
+};
+
+/**
+ * @brief Combines a prepared left side with the heavier side of a right bond
+ *
+ * @param left The prepared left molecule, which is copied from
+ * @param right The right molecule
+ * @param rightBond The right molecule's bond
+ * @param withStereopermutators Whether to transfer stereopermutators
+ */
+SubstitutionProduct substitutionProduct(
+  const PreparedSubstitution& left,
+  const Molecule& right,
+  const BondIndex rightBond,
+  const bool withStereopermutators
+) {
+  SubstitutionProduct product {left.graph, {}};
+  const SubstitutionSide rightSide {right, rightBond};
+
+  auto leftVertexMapping = left.vertexMapping;
+  auto rightVertexMapping = transferGraph(
+    right.graph().inner(),
+    product.graph,
+    rightSide.atoms
+  );
+
+  if(withStereopermutators) {
+    // Copy over left stereopermutators
+    leftVertexMapping[left.side.lighterAtom] = rightVertexMapping.at(rightSide.heavierAtom);
+    transferStereopermutators(
+      left.molecule.stereopermutators(),
+      product.stereopermutators,
+      leftVertexMapping,
+      left.molecule.graph().N(),
+      {left.side.lighterAtom}
+    );
+
+    // Copy over right stereopermutators
+    rightVertexMapping[rightSide.lighterAtom] = leftVertexMapping.at(left.side.heavierAtom);
+    transferStereopermutators(
+      right.stereopermutators(),
+      product.stereopermutators,
+      rightVertexMapping,
+      right.graph().N(),
+      {rightSide.lighterAtom}
+    );
+  }
+
+  // Add the missing bond
+  product.graph.addEdge(
+    leftVertexMapping.at(left.side.heavierAtom),
+    rightVertexMapping.at(rightSide.heavierAtom),
+    BondType::Single
+  );
+
+  return product;
+}
+
+//! Components of product fingerprints in batch editing
+constexpr AtomEnvironmentComponents constitution = (
+  AtomEnvironmentComponents::ElementTypes | AtomEnvironmentComponents::BondOrders
+);
+
+//! Throws if the numbers of fragments and their attachment sites differ
+void checkFragments(const std::size_t fragments, const std::size_t sites) {
+  if(fragments != sites) {
+    throw std::invalid_argument("Number of fragments and attachment sites differ");
+  }
+}
+
+//! Graph of two molecules connected by a new bond
+PrivateGraph connectionGraph(
+  const Molecule& a,
+  const Molecule& b,
+  const AtomIndex aConnectAtom,
+  const AtomIndex bConnectAtom,
+  const BondType bondType
+) {
+  PrivateGraph product = a.graph().inner();
+  const auto vertexMapping = transferGraph(b.graph().inner(), product, {});
+  product.addEdge(aConnectAtom, vertexMapping.at(bConnectAtom), bondType);
+  return product;
+}
+
+/**
+ * @brief Graph of a deferred product
+ *
+ * @param prepared The prepared core side if the product is a substitution. If
+ *   null, the core side is prepared here.
+ */
+PrivateGraph productGraph(
+  const Editing::Product& product,
+  const PreparedSubstitution* prepared,
+  const std::vector<Molecule>& cores,
+  const std::vector<Molecule>& fragments
+) {
+  const Molecule& core = cores.at(product.core);
+  const Molecule& fragment = fragments.at(product.fragment);
+
+  if(product.operation == Editing::Product::Operation::Connect) {
+    return connectionGraph(
+      core,
+      fragment,
+      product.coreAtom,
+      product.fragmentAtom,
+      product.bondType
+    );
+  }
+
+  if(prepared != nullptr) {
+    return substitutionProduct(*prepared, fragment, product.fragmentBond, false).graph;
+  }
+
+  const PreparedSubstitution local {core, product.coreBond};
+  return substitutionProduct(local, fragment, product.fragmentBond, false).graph;
+}
+
 } // namespace
 
 std::pair<Molecule, Molecule> Editing::cleave(const Molecule& a, const BondIndex bridge) {
@@ -222,6 +402,26 @@ std::pair<Molecule, Molecule> Editing::cleave(const Molecule& a, const BondIndex
     )
   );
 
+  /* Ranking depths carry over from the cleaved molecule, so that only atoms
+   * whose ranking trees reached across the bridge are re-ranked
+   */
+  const std::vector<unsigned>& depths = a.pImpl_->rankingDepths_;
+  if(depths.size() == N) {
+    auto transferDepths = [&depths](
+      Molecule& molecule,
+      const std::unordered_map<AtomIndex, AtomIndex>& vertexMapping
+    ) {
+      std::vector<unsigned>& targetDepths = molecule.pImpl_->rankingDepths_;
+      targetDepths.resize(molecule.graph().N());
+      for(const auto& iterPair : vertexMapping) {
+        targetDepths.at(iterPair.second) = depths.at(iterPair.first);
+      }
+    };
+
+    transferDepths(molecules.first, vertexMappings.first);
+    transferDepths(molecules.second, vertexMappings.second);
+  }
+
   /* Follow a procedure similar to Molecule::Impl::removeBond to get valid
    * state after removal:
    */
@@ -239,7 +439,7 @@ std::pair<Molecule, Molecule> Editing::cleave(const Molecule& a, const BondIndex
       }
 
       boost::optional<Shapes::Shape> shapeOption;
-      if(Options::shapeTransition == ShapeTransition::PrioritizeInferenceFromGraph) {
+      if(Options::current().shapeTransition == ShapeTransition::PrioritizeInferenceFromGraph) {
         shapeOption = molecule.inferShape(notifyIndex, localRanking);
       }
 
@@ -269,8 +469,8 @@ std::pair<Molecule, Molecule> Editing::cleave(const Molecule& a, const BondIndex
       }
     }
 
-    // Rerank everywhere and update all stereopermutators
-    molecule.pImpl_->propagateGraphChange_();
+    // Rerank in the vicinity of the bridge and update stereopermutators
+    molecule.pImpl_->propagateGraphChange_({notifyIndex});
   };
 
   fixEdgeAndPropagate(
@@ -370,7 +570,7 @@ Molecule Editing::insert(
       auto localRanking = log.rankPriority(newWedgeIndex);
 
       boost::optional<Shapes::Shape> shapeOption;
-      if(Options::shapeTransition == ShapeTransition::PrioritizeInferenceFromGraph) {
+      if(Options::current().shapeTransition == ShapeTransition::PrioritizeInferenceFromGraph) {
         shapeOption = log.inferShape(newWedgeIndex, localRanking);
       }
 
@@ -405,8 +605,26 @@ Molecule Editing::insert(
     secondWedgeAtom
   );
 
-  // Rerank everywhere and return
-  log.pImpl_->propagateGraphChange_();
+  /* If the ranking depths of both log and wedge are known, only atoms whose
+   * ranking trees reach the new bonds need to be re-ranked
+   */
+  std::vector<unsigned>& logDepths = log.pImpl_->rankingDepths_;
+  const std::vector<unsigned>& wedgeDepths = wedge.pImpl_->rankingDepths_;
+  if(logDepths.size() == logN && wedgeDepths.size() == wedge.graph().N()) {
+    logDepths.resize(logInner.N());
+    for(const auto& iterPair : vertexMapping) {
+      logDepths.at(iterPair.second) = wedgeDepths.at(iterPair.first);
+    }
+  } else {
+    logDepths.clear();
+  }
+
+  log.pImpl_->propagateGraphChange_({
+    logBond.first,
+    logBond.second,
+    vertexMapping.at(firstWedgeAtom),
+    vertexMapping.at(secondWedgeAtom)
+  });
   return log;
 }
 
@@ -477,7 +695,7 @@ Molecule Editing::superpose(
       auto localRanking = top.rankPriority(topAtom);
 
       boost::optional<Shapes::Shape> shapeOption;
-      if(Options::shapeTransition == ShapeTransition::PrioritizeInferenceFromGraph) {
+      if(Options::current().shapeTransition == ShapeTransition::PrioritizeInferenceFromGraph) {
         shapeOption = top.inferShape(topAtom, localRanking);
       }
 
@@ -498,6 +716,9 @@ Molecule Editing::superpose(
     }
   }
 
+  // Bottom's atoms were appended and only topAtom gained bonds
+  top.pImpl_->constitutionalColors_.mark({topAtom});
+
   // Rerank everywhere and return
   top.pImpl_->propagateGraphChange_();
   return top;
@@ -509,123 +730,93 @@ Molecule Editing::substitute(
   const BondIndex leftBond,
   const BondIndex rightBond
 ) {
-  PrivateGraph innerGraph;
-  StereopermutatorList stereopermutators;
-
-  // Identify sides of each bond
-  const auto leftSides = left.graph().splitAlongBridge(leftBond);
-  const auto rightSides = right.graph().splitAlongBridge(rightBond);
-
-  // Figure out which side of each bond is 'heavier'
-  auto sideCompare = [](
-    const Molecule& molecule,
-    const std::vector<AtomIndex>& sideA,
-    const std::vector<AtomIndex>& sideB
-  ) -> bool {
-    if(sideA.size() < sideB.size()) {
-      return true;
-    }
-
-    if(sideA.size() > sideB.size()) {
-      return false;
-    }
-
-    const double aWeight = Temple::accumulate(
-      sideA,
-      0.0,
-      [&molecule](double carry, const AtomIndex i) -> double {
-        return carry + Utils::ElementInfo::mass(molecule.graph().elementType(i));
-      }
-    );
-
-    const double bWeight = Temple::accumulate(
-      sideB,
-      0.0,
-      [&molecule](double carry, const AtomIndex i) -> double {
-        return carry + Utils::ElementInfo::mass(molecule.graph().elementType(i));
-      }
-    );
+  const PreparedSubstitution prepared {left, leftBond};
+  SubstitutionProduct product = substitutionProduct(prepared, right, rightBond, true);
 
-    return aWeight < bWeight;
+  // Make a molecule out of the components
+  Molecule compound {
+    Graph(std::move(product.graph)),
+    std::move(product.stereopermutators)
   };
 
-  const auto& leftHeavierSide = sideCompare(left, leftSides.first, leftSides.second) ? leftSides.second : leftSides.first;
-  const auto& rightHeavierSide = sideCompare(right, rightSides.first, rightSides.second) ? rightSides.second : rightSides.first;
-
-  // Figure out which bond index of the bond is the one that belongs to the heavier side
-  AtomIndex leftHeavierBondSide;
-  AtomIndex leftLighterBondSide;
-  AtomIndex rightHeavierBondSide;
-  AtomIndex rightLighterBondSide;
+  // Rerank everywhere and return
+  compound.pImpl_->propagateGraphChange_();
+  return compound;
+}
 
-  if(std::addressof(leftHeavierSide) == std::addressof(leftSides.first)) {
-    leftHeavierBondSide = leftBond.first;
-    leftLighterBondSide = leftBond.second;
-  } else {
-    leftHeavierBondSide = leftBond.second;
-    leftLighterBondSide = leftBond.first;
+std::vector<Molecule> Editing::substitute(
+  const Molecule& core,
+  const BondIndex coreBond,
+  const std::vector<Molecule>& fragments,
+  const std::vector<BondIndex>& fragmentBonds
+) {
+  checkFragments(fragments.size(), fragmentBonds.size());
+  // The core's side is determined and copied into a graph only once
+  const PreparedSubstitution prepared {core, coreBond};
+
+  const int F = fragments.size();
+  std::vector<boost::optional<Molecule>> products(F);
+  std::exception_ptr exception;
+
+#pragma omp parallel for schedule(dynamic)
+  for(int i = 0; i < F; ++i) {
+    try {
+      SubstitutionProduct product = substitutionProduct(prepared, fragments[i], fragmentBonds[i], true);
+      products[i] = Molecule {
+        Graph(std::move(product.graph)),
+        std::move(product.stereopermutators)
+      };
+      products[i]->pImpl_->propagateGraphChange_();
+    } catch(...) {
+#pragma omp critical(editingBatchException)
+      {
+        if(!exception) {
+          exception = std::current_exception();
+        }
+      }
+    }
   }
 
-  if(std::addressof(rightHeavierSide) == std::addressof(rightSides.first)) {
-    rightHeavierBondSide = rightBond.first;
-    rightLighterBondSide = rightBond.second;
-  } else {
-    rightHeavierBondSide = rightBond.second;
-    rightLighterBondSide = rightBond.first;
+  if(exception) {
+    std::rethrow_exception(exception);
   }
 
-  assert(Temple::makeContainsPredicate(leftHeavierSide)(leftHeavierBondSide));
-  assert(Temple::makeContainsPredicate(rightHeavierSide)(rightHeavierBondSide));
-
-  // Copy over graphs
-  auto leftVertexMapping = transferGraph(
-    left.graph().inner(),
-    innerGraph,
-    leftHeavierSide
-  );
-
-  auto rightVertexMapping = transferGraph(
-    right.graph().inner(),
-    innerGraph,
-    rightHeavierSide
-  );
-
-  // Copy over left stereopermutators
-  leftVertexMapping[leftLighterBondSide] = rightVertexMapping.at(rightHeavierBondSide);
-  transferStereopermutators(
-    left.stereopermutators(),
-    stereopermutators,
-    leftVertexMapping,
-    left.graph().N(),
-    {leftLighterBondSide}
-  );
-
-  // Copy over right stereopermutators
-  rightVertexMapping[rightLighterBondSide] = leftVertexMapping.at(leftHeavierBondSide);
-  transferStereopermutators(
-    right.stereopermutators(),
-    stereopermutators,
-    rightVertexMapping,
-    right.graph().N(),
-    {rightLighterBondSide}
-  );
+  return Temple::map(products, [](auto&& product) { return std::move(product.value()); });
+}
 
-  // Add the missing bond
-  innerGraph.addEdge(
-    leftVertexMapping.at(leftHeavierBondSide),
-    rightVertexMapping.at(rightHeavierBondSide),
-    BondType::Single
-  );
+std::vector<Fingerprint> Editing::substituteFingerprints(
+  const Molecule& core,
+  const BondIndex coreBond,
+  const std::vector<Molecule>& fragments,
+  const std::vector<BondIndex>& fragmentBonds
+) {
+  checkFragments(fragments.size(), fragmentBonds.size());
+  const PreparedSubstitution prepared {core, coreBond};
+
+  const int F = fragments.size();
+  std::vector<Fingerprint> fingerprints(F);
+  std::exception_ptr exception;
+
+#pragma omp parallel for schedule(dynamic)
+  for(int i = 0; i < F; ++i) {
+    try {
+      const SubstitutionProduct product = substitutionProduct(prepared, fragments[i], fragmentBonds[i], false);
+      fingerprints[i] = Molecule::Impl::invariantFingerprint(product.graph, boost::none, constitution);
+    } catch(...) {
+#pragma omp critical(editingBatchException)
+      {
+        if(!exception) {
+          exception = std::current_exception();
+        }
+      }
+    }
+  }
 
-  // Make a molecule out of the components
-  Molecule compound {
-    Graph(std::move(innerGraph)),
-    std::move(stereopermutators)
-  };
+  if(exception) {
+    std::rethrow_exception(exception);
+  }
 
-  // Rerank everywhere and return
-  compound.pImpl_->propagateGraphChange_();
-  return compound;
+  return fingerprints;
 }
 
 Molecule Editing::connect(
@@ -659,6 +850,76 @@ Molecule Editing::connect(
   return a;
 }
 
+std::vector<Molecule> Editing::connect(
+  const Molecule& core,
+  const AtomIndex coreAtom,
+  const std::vector<Molecule>& fragments,
+  const std::vector<AtomIndex>& fragmentAtoms,
+  const BondType bondType
+) {
+  checkFragments(fragments.size(), fragmentAtoms.size());
+
+  const int F = fragments.size();
+  std::vector<boost::optional<Molecule>> products(F);
+  std::exception_ptr exception;
+
+#pragma omp parallel for schedule(dynamic)
+  for(int i = 0; i < F; ++i) {
+    try {
+      products[i] = connect(core, fragments[i], coreAtom, fragmentAtoms[i], bondType);
+    } catch(...) {
+#pragma omp critical(editingBatchException)
+      {
+        if(!exception) {
+          exception = std::current_exception();
+        }
+      }
+    }
+  }
+
+  if(exception) {
+    std::rethrow_exception(exception);
+  }
+
+  return Temple::map(products, [](auto&& product) { return std::move(product.value()); });
+}
+
+std::vector<Fingerprint> Editing::connectFingerprints(
+  const Molecule& core,
+  const AtomIndex coreAtom,
+  const std::vector<Molecule>& fragments,
+  const std::vector<AtomIndex>& fragmentAtoms,
+  const BondType bondType
+) {
+  checkFragments(fragments.size(), fragmentAtoms.size());
+
+  const int F = fragments.size();
+  std::vector<Fingerprint> fingerprints(F);
+  std::exception_ptr exception;
+
+#pragma omp parallel for schedule(dynamic)
+  for(int i = 0; i < F; ++i) {
+    try {
+      // Only the graph is copied and no stereopermutators are ranked
+      const PrivateGraph product = connectionGraph(core, fragments[i], coreAtom, fragmentAtoms[i], bondType);
+      fingerprints[i] = Molecule::Impl::invariantFingerprint(product, boost::none, constitution);
+    } catch(...) {
+#pragma omp critical(editingBatchException)
+      {
+        if(!exception) {
+          exception = std::current_exception();
+        }
+      }
+    }
+  }
+
+  if(exception) {
+    std::rethrow_exception(exception);
+  }
+
+  return fingerprints;
+}
+
 Molecule Editing::addLigand(
   Molecule a,
   const Molecule& ligand,
@@ -682,12 +943,211 @@ Molecule Editing::addLigand(
     ligand.graph().N()
   );
 
+  // Re-rank the vicinity of all new bonds once
+  a.beginEdits();
   for(const AtomIndex bindingAtom : ligandBindingAtoms) {
     a.addBond(complexatingAtom, vertexMapping.at(bindingAtom), BondType::Single);
   }
+  a.commitEdits();
 
   return a;
 }
 
+Molecule Editing::addLigands(
+  Molecule a,
+  const std::vector<Molecule>& ligands,
+  const AtomIndex complexatingAtom,
+  const std::vector<std::vector<AtomIndex>>& ligandBindingAtoms
+) {
+  checkFragments(ligands.size(), ligandBindingAtoms.size());
+
+  PrivateGraph& aInnerGraph = a.pImpl_->adjacencies_.inner();
+  StereopermutatorList& aStereopermutators = a.pImpl_->stereopermutators_;
+
+  // Copy all ligands' graphs and stereopermutators into a
+  std::vector<std::unordered_map<AtomIndex, AtomIndex>> vertexMappings;
+  vertexMappings.reserve(ligands.size());
+  for(const Molecule& ligand : ligands) {
+    vertexMappings.push_back(
+      transferGraph(ligand.graph().inner(), aInnerGraph, {})
+    );
+    transferStereopermutators(
+      ligand.stereopermutators(),
+      aStereopermutators,
+      vertexMappings.back(),
+      ligand.graph().N()
+    );
+  }
+
+  /* Re-rank the vicinity of all new bonds once, so that the complexating
+   * atom's shape is inferred only for its final coordination environment
+   */
+  a.beginEdits();
+  for(unsigned i = 0; i < ligands.size(); ++i) {
+    for(const AtomIndex bindingAtom : ligandBindingAtoms[i]) {
+      a.addBond(complexatingAtom, vertexMappings[i].at(bindingAtom), BondType::Single);
+    }
+  }
+  a.commitEdits();
+
+  return a;
+}
+
+Editing::Product Editing::Product::substitution(
+  const unsigned core,
+  const BondIndex coreBond,
+  const unsigned fragment,
+  const BondIndex fragmentBond
+) {
+  Product product {};
+  product.operation = Operation::Substitute;
+  product.core = core;
+  product.fragment = fragment;
+  product.coreBond = coreBond;
+  product.fragmentBond = fragmentBond;
+  return product;
+}
+
+Editing::Product Editing::Product::connection(
+  const unsigned core,
+  const AtomIndex coreAtom,
+  const unsigned fragment,
+  const AtomIndex fragmentAtom,
+  const BondType bondType
+) {
+  Product product {};
+  product.operation = Operation::Connect;
+  product.core = core;
+  product.fragment = fragment;
+  product.coreAtom = coreAtom;
+  product.fragmentAtom = fragmentAtom;
+  product.bondType = bondType;
+  return product;
+}
+
+Graph Editing::Product::graph(
+  const std::vector<Molecule>& cores,
+  const std::vector<Molecule>& fragments
+) const {
+  return Graph {productGraph(*this, nullptr, cores, fragments)};
+}
+
+Fingerprint Editing::Product::fingerprint(
+  const std::vector<Molecule>& cores,
+  const std::vector<Molecule>& fragments
+) const {
+  return Molecule::Impl::invariantFingerprint(
+    productGraph(*this, nullptr, cores, fragments),
+    boost::none,
+    constitution
+  );
+}
+
+Molecule Editing::Product::materialize(
+  const std::vector<Molecule>& cores,
+  const std::vector<Molecule>& fragments
+) const {
+  if(operation == Operation::Connect) {
+    return connect(
+      cores.at(core),
+      fragments.at(fragment),
+      coreAtom,
+      fragmentAtom,
+      bondType
+    );
+  }
+
+  return substitute(
+    cores.at(core),
+    fragments.at(fragment),
+    coreBond,
+    fragmentBond
+  );
+}
+
+std::vector<Fingerprint> Editing::fingerprints(
+  const std::vector<Product>& products,
+  const std::vector<Molecule>& cores,
+  const std::vector<Molecule>& fragments
+) {
+  // Prepare the core side of each distinct substituted core bond once
+  std::map<std::pair<unsigned, BondIndex>, PreparedSubstitution> preparations;
+  for(const Product& product : products) {
+    if(product.operation == Product::Operation::Substitute) {
+      const auto key = std::make_pair(product.core, product.coreBond);
+      if(preparations.count(key) == 0) {
+        preparations.emplace(
+          std::piecewise_construct,
+          std::forward_as_tuple(key),
+          std::forward_as_tuple(cores.at(product.core), product.coreBond)
+        );
+      }
+    }
+  }
+
+  const int P = products.size();
+  std::vector<Fingerprint> fingerprints(P);
+  std::exception_ptr exception;
+
+#pragma omp parallel for schedule(dynamic)
+  for(int i = 0; i < P; ++i) {
+    try {
+      const Product& product = products[i];
+      const PreparedSubstitution* prepared = nullptr;
+      if(product.operation == Product::Operation::Substitute) {
+        prepared = &preparations.at(std::make_pair(product.core, product.coreBond));
+      }
+      fingerprints[i] = Molecule::Impl::invariantFingerprint(
+        productGraph(product, prepared, cores, fragments),
+        boost::none,
+        constitution
+      );
+    } catch(...) {
+#pragma omp critical(editingBatchException)
+      {
+        if(!exception) {
+          exception = std::current_exception();
+        }
+      }
+    }
+  }
+
+  if(exception) {
+    std::rethrow_exception(exception);
+  }
+
+  return fingerprints;
+}
+
+std::vector<Molecule> Editing::materialize(
+  const std::vector<Product>& products,
+  const std::vector<Molecule>& cores,
+  const std::vector<Molecule>& fragments
+) {
+  const int P = products.size();
+  std::vector<boost::optional<Molecule>> molecules(P);
+  std::exception_ptr exception;
+
+#pragma omp parallel for schedule(dynamic)
+  for(int i = 0; i < P; ++i) {
+    try {
+      molecules[i] = products[i].materialize(cores, fragments);
+    } catch(...) {
+#pragma omp critical(editingBatchException)
+      {
+        if(!exception) {
+          exception = std::current_exception();
+        }
+      }
+    }
+  }
+
+  if(exception) {
+    std::rethrow_exception(exception);
+  }
+
+  return Temple::map(molecules, [](auto&& molecule) { return std::move(molecule.value()); });
+}
+
 } // namespace Molassembler
 } // namespace Scine
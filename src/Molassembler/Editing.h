@@ -14,6 +14,7 @@
 namespace Scine {
 namespace Molassembler {
 
+class Graph;
 class Molecule;
 
 /**
@@ -104,6 +105,65 @@ struct MASM_EXPORT Editing {
     BondIndex rightBond
   );
 
+  /**
+   * @brief Substitutes many fragments onto a core
+   *
+   * Products are identical to those of substitute(core, fragments[i],
+   * coreBond, fragmentBonds[i]), but the heavier side of the core bond is
+   * determined and copied out of the core only once.
+   *
+   * @complexity{@math{\Theta(F N)} for @math{F} fragments}
+   *
+   * @param core The molecule common to all products
+   * @param coreBond @p core's bond from which to substitute the lighter part away
+   * @param fragments The molecules to substitute onto the core
+   * @param fragmentBonds For each fragment, the bond from which to
+   *   substitute the lighter part away
+   *
+   * @parblock @note This function is parallelized over fragments. Use the
+   * OMP_NUM_THREADS environment variable to control the number of threads
+   * used.
+   * @endparblock
+   *
+   * @throws std::invalid_argument If the number of fragments and bonds differ
+   *
+   * @return For each fragment, the substitution product
+   */
+  static std::vector<Molecule> substitute(
+    const Molecule& core,
+    BondIndex coreBond,
+    const std::vector<Molecule>& fragments,
+    const std::vector<BondIndex>& fragmentBonds
+  );
+
+  /**
+   * @brief Constitutional fingerprints of substitution products of many
+   *   fragments onto a core
+   *
+   * Products' graphs are assembled without stereopermutators or ranking, and
+   * fingerprinted as Molecule::invariantFingerprint with element types and
+   * bond orders. Use the fingerprints to deduplicate fragments before
+   * constructing the products with substitute().
+   *
+   * @complexity{@math{\Theta(F N \log N)} for @math{F} fragments}
+   *
+   * @parblock @note This function is parallelized over fragments. Use the
+   * OMP_NUM_THREADS environment variable to control the number of threads
+   * used.
+   * @endparblock
+   *
+   * @warning Stereoisomeric products share fingerprints, as may rare
+   *   non-isomorphic products indistinguishable by refinement
+   *
+   * @throws std::invalid_argument If the number of fragments and bonds differ
+   */
+  static std::vector<Fingerprint> substituteFingerprints(
+    const Molecule& core,
+    BondIndex coreBond,
+    const std::vector<Molecule>& fragments,
+    const std::vector<BondIndex>& fragmentBonds
+  );
+
   /**
    * @brief Connect molecules by creating a new bond between two atoms from
    *   separate molecules
@@ -132,6 +192,62 @@ struct MASM_EXPORT Editing {
     BondType bondType
   );
 
+  /**
+   * @brief Connects many fragments to a core
+   *
+   * Products are identical to those of connect(core, fragments[i], coreAtom,
+   * fragmentAtoms[i], bondType).
+   *
+   * @complexity{@math{\Theta(F N)} for @math{F} fragments}
+   *
+   * @param core The molecule common to all products
+   * @param coreAtom The atom index to connect to in @p core
+   * @param fragments The molecules to connect to the core
+   * @param fragmentAtoms For each fragment, the atom index to connect to
+   * @param bondType The type of the new bonds
+   *
+   * @parblock @note This function is parallelized over fragments. Use the
+   * OMP_NUM_THREADS environment variable to control the number of threads
+   * used.
+   * @endparblock
+   *
+   * @throws std::invalid_argument If the number of fragments and atoms differ
+   *
+   * @return For each fragment, the connected molecule
+   */
+  static std::vector<Molecule> connect(
+    const Molecule& core,
+    AtomIndex coreAtom,
+    const std::vector<Molecule>& fragments,
+    const std::vector<AtomIndex>& fragmentAtoms,
+    BondType bondType
+  );
+
+  /**
+   * @brief Constitutional fingerprints of many fragments connected to a core
+   *
+   * As substituteFingerprints() for connect().
+   *
+   * @complexity{@math{\Theta(F N \log N)} for @math{F} fragments}
+   *
+   * @parblock @note This function is parallelized over fragments. Use the
+   * OMP_NUM_THREADS environment variable to control the number of threads
+   * used.
+   * @endparblock
+   *
+   * @warning Stereoisomeric products share fingerprints, as may rare
+   *   non-isomorphic products indistinguishable by refinement
+   *
+   * @throws std::invalid_argument If the number of fragments and atoms differ
+   */
+  static std::vector<Fingerprint> connectFingerprints(
+    const Molecule& core,
+    AtomIndex coreAtom,
+    const std::vector<Molecule>& fragments,
+    const std::vector<AtomIndex>& fragmentAtoms,
+    BondType bondType
+  );
+
   /**
    * @brief Connects two molecules by connecting multiple atoms from one to a
    *   single atom of the other via single bonds
@@ -152,6 +268,164 @@ struct MASM_EXPORT Editing {
     AtomIndex complexatingAtom,
     const std::vector<AtomIndex>& ligandBindingAtoms
   );
+
+  /**
+   * @brief Connects many ligands to a single atom of a molecule at once
+   *
+   * Equivalent to successive addLigand() calls, but the graph change is
+   * propagated only once, so that the shape of @p complexatingAtom is
+   * inferred and its stereopermutator constructed only for the final
+   * coordination environment.
+   *
+   * @complexity{@math{\Theta(N)}}
+   *
+   * @param a The molecule the ligands are being connected to
+   * @param ligands The ligand molecules being bound to @p complexatingAtom
+   * @param complexatingAtom The atom in @p a that @p ligands are being bound to
+   * @param ligandBindingAtoms For each ligand, the atoms that should be
+   *   connected to @p a
+   *
+   * @throws std::invalid_argument If the number of ligands and lists of
+   *   binding atoms differ
+   *
+   * @return A joined molecule
+   */
+  static Molecule addLigands(
+    Molecule a,
+    const std::vector<Molecule>& ligands,
+    AtomIndex complexatingAtom,
+    const std::vector<std::vector<AtomIndex>>& ligandBindingAtoms
+  );
+
+  /**
+   * @brief Deferred product of substituting or connecting a core and a
+   *   fragment from separate lists of molecules
+   *
+   * Products hold only indices into the lists and the attachment sites, so
+   * that combinatorial enumerations can be filtered on the products' graphs
+   * or fingerprints before any stereopermutators are constructed. Only the
+   * survivors need to be materialized.
+   */
+  struct MASM_EXPORT Product {
+    //! Editing operation combining core and fragment
+    enum class Operation {
+      //! As substitute(), from coreBond and fragmentBond
+      Substitute,
+      //! As connect(), at coreAtom and fragmentAtom with bondType
+      Connect
+    };
+
+    //! Deferred substitute(cores[core], fragments[fragment], coreBond, fragmentBond)
+    static Product substitution(
+      unsigned core,
+      BondIndex coreBond,
+      unsigned fragment,
+      BondIndex fragmentBond
+    );
+
+    //! Deferred connect(cores[core], fragments[fragment], coreAtom, fragmentAtom, bondType)
+    static Product connection(
+      unsigned core,
+      AtomIndex coreAtom,
+      unsigned fragment,
+      AtomIndex fragmentAtom,
+      BondType bondType
+    );
+
+    /*! @brief Graph of the product
+     *
+     * @complexity{@math{\Theta(N)}}
+     *
+     * @throws std::out_of_range If the indices are invalid for the lists
+     */
+    Graph graph(
+      const std::vector<Molecule>& cores,
+      const std::vector<Molecule>& fragments
+    ) const;
+
+    /*! @brief Constitutional fingerprint of the product
+     *
+     * Equal to Molecule::invariantFingerprint of the materialized product with
+     * element types and bond orders.
+     *
+     * @complexity{@math{\Theta(N \log N)}}
+     *
+     * @throws std::out_of_range If the indices are invalid for the lists
+     */
+    Fingerprint fingerprint(
+      const std::vector<Molecule>& cores,
+      const std::vector<Molecule>& fragments
+    ) const;
+
+    /*! @brief Constructs the product molecule
+     *
+     * @complexity{As the editing operation}
+     *
+     * @throws std::out_of_range If the indices are invalid for the lists
+     */
+    Molecule materialize(
+      const std::vector<Molecule>& cores,
+      const std::vector<Molecule>& fragments
+    ) const;
+
+    //! Editing operation
+    Operation operation;
+    //! Index of the core molecule
+    unsigned core;
+    //! Index of the fragment molecule
+    unsigned fragment;
+    //! Core bond substituted from, if operation is Substitute
+    BondIndex coreBond;
+    //! Fragment bond substituted from, if operation is Substitute
+    BondIndex fragmentBond;
+    //! Core atom connected, if operation is Connect
+    AtomIndex coreAtom;
+    //! Fragment atom connected, if operation is Connect
+    AtomIndex fragmentAtom;
+    //! Type of the new bond, if operation is Connect
+    BondType bondType;
+  };
+
+  /**
+   * @brief Constitutional fingerprints of many deferred products
+   *
+   * The heavier side of each distinct core bond of substitutions is
+   * determined and copied only once.
+   *
+   * @complexity{@math{\Theta(P N \log N)} for @math{P} products}
+   *
+   * @parblock @note This function is parallelized over products. Use the
+   * OMP_NUM_THREADS environment variable to control the number of threads
+   * used.
+   * @endparblock
+   *
+   * @throws std::out_of_range If any product's indices are invalid for the
+   *   lists
+   */
+  static std::vector<Fingerprint> fingerprints(
+    const std::vector<Product>& products,
+    const std::vector<Molecule>& cores,
+    const std::vector<Molecule>& fragments
+  );
+
+  /**
+   * @brief Constructs the molecules of many deferred products
+   *
+   * @complexity{@math{\Theta(P N)} for @math{P} products}
+   *
+   * @parblock @note This function is parallelized over products. Use the
+   * OMP_NUM_THREADS environment variable to control the number of threads
+   * used.
+   * @endparblock
+   *
+   * @throws std::out_of_range If any product's indices are invalid for the
+   *   lists
+   */
+  static std::vector<Molecule> materialize(
+    const std::vector<Product>& products,
+    const std::vector<Molecule>& cores,
+    const std::vector<Molecule>& fragments
+  );
 };
 
 } // namespace Molassembler
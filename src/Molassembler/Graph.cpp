@@ -46,21 +46,20 @@ static_assert(
 
 Graph::Graph(Graph&& other) noexcept = default;
 Graph& Graph::operator = (Graph&& other) noexcept = default;
-Graph::Graph(const Graph& other) : innerPtr_(
-  std::make_unique<PrivateGraph>(*other.innerPtr_)
-) {}
-Graph& Graph::operator = (const Graph& other) {
-  *innerPtr_ = *other.innerPtr_;
-  return *this;
-}
+/* Copies share the inner graph until either of them is modified. The shared
+ * graph's cached properties are generated safely on concurrent const access
+ * of either copy.
+ */
+Graph::Graph(const Graph& other) = default;
+Graph& Graph::operator = (const Graph& other) = default;
 Graph::~Graph() = default;
 
 Graph::Graph() : innerPtr_(
-  std::make_unique<PrivateGraph>()
+  std::make_shared<PrivateGraph>()
 ) {}
 
 Graph::Graph(PrivateGraph&& inner) : innerPtr_(
-  std::make_unique<PrivateGraph>(std::move(inner))
+  std::make_shared<PrivateGraph>(std::move(inner))
 ) {}
 
 Utils::ElementTypeCollection Graph::elementCollection() const {
@@ -175,10 +174,23 @@ const Cycles& Graph::cycles() const {
   return inner().cycles();
 }
 
+const GraphDistanceMatrix& Graph::distances() const {
+  return inner().distances();
+}
+
 PrivateGraph& Graph::inner() {
+  // Detach from any copies before handing out mutable access
+  if(innerPtr_.use_count() > 1) {
+    innerPtr_ = std::make_shared<PrivateGraph>(*innerPtr_);
+  }
+
   return *innerPtr_;
 }
 
+bool Graph::sharesInner(const Graph& other) const {
+  return innerPtr_ == other.innerPtr_;
+}
+
 const PrivateGraph& Graph::inner() const {
   return *innerPtr_;
 }
@@ -29,6 +29,7 @@ namespace Molassembler {
 // Forward-declare PrivateGraph
 class PrivateGraph;
 class Cycles;
+class GraphDistanceMatrix;
 
 /**
  * @brief Represents the connectivity of atoms of a molecule
@@ -53,6 +54,9 @@ class Cycles;
  *
  * @note This class wraps PrivateGraph so that no Boost Graph types are exposed
  *   to library consumers.
+ *
+ * @note Copies share their representation and cached properties until either
+ *   copy is modified, so copying is cheap.
  */
 class MASM_EXPORT Graph {
 public:
@@ -209,26 +213,29 @@ public:
    *
    * @complexity{@math{O(N)} worst case, if removal data is cached
    * @math{\Theta(1)}}
-   *
-   * @note This function is not thread-safe.
    */
   bool canRemove(AtomIndex a) const;
   /*! @brief Returns whether a bond can be removed without disconnecting the graph
    *
    * @complexity{@math{O(N)} worst case, if removal data is cached
    * @math{\Theta(1)}}
-   *
-   * @note This function is not thread-safe.
    */
   bool canRemove(const BondIndex& edge) const;
   /*! @brief Fetch a reference to Cycles
    *
    * @complexity{@math{O(B)} worst case where @math{B} is the number of bonds
    * in cycles, if cycles are cached @math{\Theta(1)}}
-   *
-   * @note This function is not thread-safe.
    */
   const Cycles& cycles() const;
+  /*! @brief Fetch a reference to the graph distances between all atom pairs
+   *
+   * @complexity{@math{O(\lceil N / 64 \rceil \cdot D \cdot (N + B) + N^2)}
+   * worst case where @math{D} is the graph diameter, if distances are cached
+   * @math{\Theta(1)}}
+   *
+   * @note Unmodified copies of this graph share the cached distances.
+   */
+  const GraphDistanceMatrix& distances() const;
   /*! @brief Returns the number of bonds incident upon an atom
    *
    * @complexity{@math{\Theta(1)}}
@@ -273,8 +280,6 @@ public:
    * @complexity{@math{\Theta(N)}}
    *
    * The atoms making up the bond are in the resulting atom lists, too.
-   *
-   * @note This function is not thread-safe.
    */
   std::pair<
     std::vector<AtomIndex>,
@@ -326,7 +331,10 @@ public:
 
   /*! @brief Access to library-internal graph representation class
    *
-   * @complexity{@math{\Theta(1)}}
+   * Detaches this graph from copies sharing its representation first.
+   *
+   * @complexity{@math{\Theta(1)}, @math{\Theta(N + B)} if the
+   * representation is shared with a copy}
    *
    * @warning This function is not intended for library consumers, merely used
    * for implementation purposes.
@@ -342,8 +350,16 @@ public:
    */
   MASM_NO_EXPORT const PrivateGraph& inner() const;
 
+  /*! @brief Whether this graph shares its representation with another
+   *
+   * Copies share their representation until either is modified.
+   *
+   * @complexity{@math{\Theta(1)}}
+   */
+  bool sharesInner(const Graph& other) const;
+
 private:
-  std::unique_ptr<PrivateGraph> innerPtr_;
+  std::shared_ptr<PrivateGraph> innerPtr_;
 };
 
 } // namespace Molassembler
@@ -13,12 +13,12 @@
 #include "Molassembler/Graph/Canonicalization.h"
 
 #include "Molassembler/Graph/PrivateGraph.h"
+#include "Molassembler/Detail/Metrics.h"
 #include "Molassembler/Molecule/AtomEnvironmentHash.h"
 #include "Molassembler/Graph.h"
 
-#include "Molassembler/Temple/Adaptors/SequentialPairs.h"
-#include "Molassembler/Temple/Adaptors/Iota.h"
-#include "Molassembler/Temple/Functional.h"
+#include <algorithm>
+#include <numeric>
 
 extern "C" {
 #include "nauty/nausparse.h"
@@ -29,10 +29,14 @@ extern "C" {
  * @complexity{Generally sub-exponential in the number of vertices: @math{c^N}
  * with @math{c} some fixed constant.}
  *
+ * @param orbits Workspace of at least nv elements
+ * @param canong Canonical graph workspace. Its arrays are reallocated by
+ *   nauty only if they are too small and are not freed here.
+ *
  * @post lab contains an (inverse) index permutation yielding canonical graph
  *   labeling according to the coloring provided.
  */
-void molassembler_nauty_canonicalize(int nv, size_t nde, size_t* v, int* d, int* e, size_t vlen, size_t dlen, size_t elen, int* lab, int* ptn) {
+void molassembler_nauty_canonicalize(int nv, size_t nde, size_t* v, int* d, int* e, size_t vlen, size_t dlen, size_t elen, int* lab, int* ptn, int* orbits, sparsegraph* canong) {
   DEFAULTOPTIONS_SPARSEGRAPH(options);
   // We want to specify a non-uniform vertex coloring
   options.defaultptn = false;
@@ -46,24 +50,18 @@ void molassembler_nauty_canonicalize(int nv, size_t nde, size_t* v, int* d, int*
 
   statsblk stats;
 
-  SG_DECL(canong);
-
-  DYNALLSTAT(int, orbits, orbits_sz);
-  DYNALLOC1(int, orbits, orbits_sz, nv, "malloc");
   sparsegraph source {nde, v, nv, d, e, nullptr, vlen, dlen, elen, 0};
 
   int m = SETWORDSNEEDED(nv);
   nauty_check(WORDSIZE, m, nv, NAUTYVERSIONID);
 
-  sparsenauty(&source, lab, ptn, orbits, &options, &stats, &canong);
+  sparsenauty(&source, lab, ptn, orbits, &options, &stats, canong);
 
   /* After execution, vertex indices should be mapped pursuant to lab:
    *
    *   [i] 0 1 2 3 = new_idx
    *   lab 4 3 1 2 = old_idx
    */
-  SG_FREE(canong);
-  DYNFREE(orbits, orbits_sz);
 }
 
 } // end extern "C"
@@ -72,11 +70,14 @@ namespace Scine {
 namespace Molassembler {
 namespace {
 
-struct NautySparseGraph {
+/* All arrays passed to nauty. Every thread keeps one instance alive, so that
+ * repeated canonicalizations reuse the allocations of previous ones.
+ */
+struct NautyWorkspace {
   // Number of vertices
-  int nv;
+  int nv = 0;
   // Number of directed edges (all undirected edges count as 2)
-  std::size_t nde;
+  std::size_t nde = 0;
   /* Adjacency-list structure:
    * - For each vertex i, d[i] is the out-degree of the vertex
    * - For each vertex i, v[i] is an index into the array e so that
@@ -92,8 +93,23 @@ struct NautySparseGraph {
    *   identically colored vertices (cell) is closed by its vertex in lab.
    */
   std::vector<int> lab, ptn;
+  // Vertex orbits under the automorphism group
+  std::vector<int> orbits;
+  // Canonical graph, unused but required for the canonical labeling
+  sparsegraph canong;
+
+  NautyWorkspace() {
+    SG_INIT(canong);
+  }
+
+  NautyWorkspace(const NautyWorkspace& other) = delete;
+  NautyWorkspace& operator = (const NautyWorkspace& other) = delete;
+
+  ~NautyWorkspace() {
+    SG_FREE(canong);
+  }
 
-  NautySparseGraph(
+  void populate(
     const PrivateGraph& inner,
     const std::vector<Hashes::WideHashType>& hashes
   ) {
@@ -137,6 +153,9 @@ struct NautySparseGraph {
 
     nv = inner.N();
     nde = 2 * inner.B();
+    v.clear();
+    d.clear();
+    e.clear();
     v.reserve(nv);
     d.reserve(nv);
     e.reserve(nde);
@@ -167,56 +186,78 @@ struct NautySparseGraph {
      */
 
     // We use the hashes to order our vertices
-    lab = Temple::sorted(
-      Temple::iota<int>(nv),
+    lab.resize(nv);
+    std::iota(std::begin(lab), std::end(lab), 0);
+    std::sort(
+      std::begin(lab),
+      std::end(lab),
       [&hashes](const int a, const int b) -> bool {
-        return hashes.at(a) < hashes.at(b);
+        return hashes[a] < hashes[b];
       }
     );
 
-    // And then generate the partition from checking adjacent hash equality
-    ptn = Temple::map(
-      Temple::Adaptors::sequentialPairs(lab),
-      [&hashes](const int a, const int b) -> int {
-        return static_cast<int>(hashes.at(a) == hashes.at(b));
-      }
-    );
-
-    /* Add final element (since taking sequential pairs yields an element fewer),
-     * which is always the end of a cell (group of vertices with identical
-     * coloring)
+    /* And then generate the partition from checking adjacent hash equality.
+     * The final element is always the end of a cell (group of vertices with
+     * identical coloring).
      */
-    ptn.push_back(0);
+    ptn.resize(nv);
+    for(int i = 0; i + 1 < nv; ++i) {
+      ptn[i] = static_cast<int>(hashes[lab[i]] == hashes[lab[i + 1]]);
+    }
+    if(nv > 0) {
+      ptn.back() = 0;
+    }
+
+    orbits.resize(nv);
   }
 };
 
-} // namespace
-
-std::vector<int> canonicalAutomorphism(
+//! Runs nauty on the per-thread workspace
+NautyWorkspace& runNauty(
   const PrivateGraph& inner,
   const std::vector<Hashes::WideHashType>& hashes
 ) {
-  NautySparseGraph nautyGraph(inner, hashes);
+  const Detail::Metrics::Timer timer {Detail::Metrics::Operation::Nauty};
+  thread_local NautyWorkspace workspace;
+  workspace.populate(inner, hashes);
 
   /* Call the C function with addresses to the start of the underlying arrays
    * and their sizes. The sizes of lab and ptn are known since they have to be
    * nv elements long.
    */
   molassembler_nauty_canonicalize(
-    nautyGraph.nv,
-    nautyGraph.nde,
-    &nautyGraph.v[0],
-    &nautyGraph.d[0],
-    &nautyGraph.e[0],
-    nautyGraph.v.size(),
-    nautyGraph.d.size(),
-    nautyGraph.e.size(),
-    &nautyGraph.lab[0],
-    &nautyGraph.ptn[0]
+    workspace.nv,
+    workspace.nde,
+    workspace.v.data(),
+    workspace.d.data(),
+    workspace.e.data(),
+    workspace.v.size(),
+    workspace.d.size(),
+    workspace.e.size(),
+    workspace.lab.data(),
+    workspace.ptn.data(),
+    workspace.orbits.data(),
+    &workspace.canong
   );
 
+  return workspace;
+}
+
+} // namespace
+
+std::vector<int> canonicalAutomorphism(
+  const PrivateGraph& inner,
+  const std::vector<Hashes::WideHashType>& hashes
+) {
   // lab is now the (inverse) permutation we need to apply for a canonical graph
-  return nautyGraph.lab;
+  return runNauty(inner, hashes).lab;
+}
+
+std::vector<int> automorphismOrbits(
+  const PrivateGraph& inner,
+  const std::vector<Hashes::WideHashType>& hashes
+) {
+  return runNauty(inner, hashes).orbits;
 }
 
 } // namespace Molassembler
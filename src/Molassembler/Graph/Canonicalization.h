@@ -62,6 +62,27 @@ std::vector<int> canonicalAutomorphism(
   const std::vector<Hashes::WideHashType>& hashes
 );
 
+/** @brief Calculate the vertex orbits of the automorphism group of a molecule
+ *   colored by a set of hashes
+ *
+ * @complexity{As canonicalAutomorphism}
+ *
+ * @param inner The inner graph representation of a Molecule
+ * @param hashes A flat map of hashes for each vertex
+ *
+ * @throws std::domain_error If the size of mol's graph exceeds the maximum
+ *   value of int.
+ *
+ * @throws std::invalid_argument If vector of hashes length does not match
+ *   the molecule's number of vertices.
+ *
+ * @return For each vertex, the smallest vertex index in its orbit
+ */
+std::vector<int> automorphismOrbits(
+  const PrivateGraph& inner,
+  const std::vector<Hashes::WideHashType>& hashes
+);
+
 } // namespace Molassembler
 } // namespace Scine
 
@@ -0,0 +1,57 @@
+/*!@file
+ * @copyright This code is licensed under the 3-clause BSD license.
+ *   Copyright ETH Zurich, Laboratory of Physical Chemistry, Reiher Group.
+ *   See LICENSE.txt for details.
+ */
+
+#include "Molassembler/Graph/FrozenGraph.h"
+
+namespace Scine {
+namespace Molassembler {
+
+FrozenGraph::FrozenGraph(const PrivateGraph& graph) {
+  const Vertex N = graph.N();
+  elementTypes_.reserve(N);
+  offsets_.resize(N + 1);
+  offsets_.front() = 0;
+  for(Vertex i = 0; i < N; ++i) {
+    elementTypes_.push_back(graph.elementType(i));
+    offsets_[i + 1] = offsets_[i] + graph.degree(i);
+  }
+
+  adjacents_.resize(offsets_.back());
+  bondTypes_.resize(offsets_.back());
+  std::vector<std::pair<Vertex, BondType>> incident;
+  for(Vertex i = 0; i < N; ++i) {
+    incident.clear();
+    for(const PrivateGraph::Edge& edge : graph.edges(i)) {
+      incident.emplace_back(graph.target(edge), graph.bondType(edge));
+    }
+    std::sort(
+      std::begin(incident),
+      std::end(incident),
+      [](const auto& a, const auto& b) { return a.first < b.first; }
+    );
+
+    unsigned position = offsets_[i];
+    for(const auto& adjacent : incident) {
+      adjacents_[position] = adjacent.first;
+      bondTypes_[position] = adjacent.second;
+      ++position;
+    }
+  }
+}
+
+boost::optional<BondType> FrozenGraph::bondType(const Vertex a, const Vertex b) const {
+  const auto begin = std::begin(adjacents_) + offsets_[a];
+  const auto end = std::begin(adjacents_) + offsets_[a + 1];
+  const auto findIter = std::lower_bound(begin, end, b);
+  if(findIter == end || *findIter != b) {
+    return boost::none;
+  }
+
+  return bondTypes_[findIter - std::begin(adjacents_)];
+}
+
+} // namespace Molassembler
+} // namespace Scine
@@ -0,0 +1,117 @@
+/*!@file
+ * @copyright This code is licensed under the 3-clause BSD license.
+ *   Copyright ETH Zurich, Laboratory of Physical Chemistry, Reiher Group.
+ *   See LICENSE.txt for details.
+ * @brief Immutable compressed sparse row snapshot of a molecular graph
+ */
+
+#ifndef INCLUDE_MOLASSEMBLER_FROZEN_GRAPH_H
+#define INCLUDE_MOLASSEMBLER_FROZEN_GRAPH_H
+
+#include "Molassembler/Graph/PrivateGraph.h"
+
+namespace Scine {
+namespace Molassembler {
+
+/**
+ * @brief Immutable compressed sparse row snapshot of a PrivateGraph
+ *
+ * The adjacent vertices of each vertex and the types of the bonds to them are
+ * stored contiguously and ordered by adjacent vertex, so that read-only
+ * traversals do not chase per-vertex edge lists and edge lookups are binary
+ * searches. A snapshot does not reflect later changes to the graph it was
+ * frozen from.
+ */
+class FrozenGraph {
+public:
+//!@name Member types
+//!@{
+  using Vertex = PrivateGraph::Vertex;
+  using AdjacentVertexRange = IteratorRange<std::vector<Vertex>::const_iterator>;
+  using BondTypeRange = IteratorRange<std::vector<BondType>::const_iterator>;
+//!@}
+
+//!@name Constructors
+//!@{
+  //! Empty snapshot
+  FrozenGraph() : offsets_(1, 0) {}
+
+  /*! @brief Snapshots a graph
+   *
+   * @complexity{@math{\Theta(N + B \log D)} where @math{D} is the largest
+   * vertex degree}
+   */
+  explicit FrozenGraph(const PrivateGraph& graph);
+//!@}
+
+//!@name Information
+//!@{
+  //! Number of vertices
+  inline Vertex N() const {
+    return elementTypes_.size();
+  }
+
+  //! Number of edges
+  inline Vertex B() const {
+    return adjacents_.size() / 2;
+  }
+
+  //! Element type of a vertex
+  inline Utils::ElementType elementType(const Vertex a) const {
+    return elementTypes_[a];
+  }
+
+  //! Number of adjacent vertices
+  inline Vertex degree(const Vertex a) const {
+    return offsets_[a + 1] - offsets_[a];
+  }
+
+  /*! @brief Bond type between two vertices, if bonded
+   *
+   * @complexity{@math{\Theta(\log D)}}
+   */
+  boost::optional<BondType> bondType(Vertex a, Vertex b) const;
+
+  /*! @brief Whether two vertices are bonded
+   *
+   * @complexity{@math{\Theta(\log D)}}
+   */
+  inline bool adjacent(const Vertex a, const Vertex b) const {
+    return static_cast<bool>(bondType(a, b));
+  }
+//!@}
+
+//!@name Ranges
+//!@{
+  //! Adjacent vertices in ascending order
+  inline AdjacentVertexRange adjacents(const Vertex a) const {
+    return {
+      std::begin(adjacents_) + offsets_[a],
+      std::begin(adjacents_) + offsets_[a + 1]
+    };
+  }
+
+  //! Bond types to the adjacent vertices, in the same order as adjacents()
+  inline BondTypeRange bondTypes(const Vertex a) const {
+    return {
+      std::begin(bondTypes_) + offsets_[a],
+      std::begin(bondTypes_) + offsets_[a + 1]
+    };
+  }
+//!@}
+
+private:
+  //! Element type of each vertex
+  std::vector<Utils::ElementType> elementTypes_;
+  //! Start of each vertex's adjacencies, plus the total count at the end
+  std::vector<unsigned> offsets_;
+  //! Adjacent vertices, ascending per vertex
+  std::vector<Vertex> adjacents_;
+  //! Bond types parallel to adjacents_
+  std::vector<BondType> bondTypes_;
+};
+
+} // namespace Molassembler
+} // namespace Scine
+
+#endif
@@ -16,6 +16,7 @@
 #include "Molassembler/Temple/Functional.h"
 #include "Molassembler/Temple/UnorderedSetAlgorithms.h"
 #include "Molassembler/Temple/TinySet.h"
+#include "Molassembler/Temple/VisitedSet.h"
 
 #include "Molassembler/AtomStereopermutator.h"
 #include "Molassembler/Cycles.h"
@@ -283,7 +284,7 @@ void findSites(
   const std::function<void(const std::vector<AtomIndex>&)>& callback
 ) {
   const unsigned A = graph.degree(placement);
-  Temple::TinySet<PrivateGraph::Vertex> centralAdjacents;
+  Temple::TinySet<PrivateGraph::Vertex, 8> centralAdjacents;
   centralAdjacents.reserve(A);
 
   for(const PrivateGraph::Vertex adjacent : graph.adjacents(placement)) {
@@ -292,14 +293,16 @@ void findSites(
 
   std::vector<bool> skipList (A, false);
 
-  Temple::TinySet<AtomIndex> site;
+  // Reused across calls, since sites are found for every atom
+  thread_local Temple::VisitedSet<AtomIndex> inSite;
+  std::vector<AtomIndex> site;
 
   std::function<void(const PrivateGraph::Vertex)> recursiveDiscover
   = [&](const PrivateGraph::Vertex seed) {
     for(const PrivateGraph::Vertex adjacent : graph.adjacents(seed)) {
-      if(centralAdjacents.count(adjacent) > 0 && site.count(adjacent) == 0) {
+      if(centralAdjacents.count(adjacent) > 0 && inSite.insert(adjacent)) {
         // *iter is shared adjacent of center and seed and not yet discovered
-        site.insert(adjacent);
+        site.push_back(adjacent);
         recursiveDiscover(adjacent);
       }
     }
@@ -317,10 +320,13 @@ void findSites(
     }
 
     const AtomIndex& adjacent = centralAdjacents.at(i);
+    inSite.reset(graph.N());
+    inSite.insert(adjacent);
     site = {adjacent};
     recursiveDiscover(adjacent);
 
-    callback(site.data);
+    Temple::sort(site);
+    callback(site);
   }
 }
 
@@ -0,0 +1,108 @@
+/*!@file
+ * @copyright This code is licensed under the 3-clause BSD license.
+ *   Copyright ETH Zurich, Laboratory of Physical Chemistry, Reiher Group.
+ *   See LICENSE.txt for details.
+ */
+
+#include "Molassembler/Graph/PathFingerprint.h"
+
+#include "Molassembler/Graph/PrivateGraph.h"
+
+#include "Utils/Geometry/ElementInfo.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace Scine {
+namespace Molassembler {
+namespace {
+
+//! SplitMix64 finalizer
+inline std::uint64_t mix(std::uint64_t x) {
+  x += 0x9E3779B97F4A7C15ULL;
+  x = (x ^ (x >> 30U)) * 0xBF58476D1CE4E5B9ULL;
+  x = (x ^ (x >> 27U)) * 0x94D049BB133111EBULL;
+  return x ^ (x >> 31U);
+}
+
+//! Depth-first enumeration of simple paths starting at a vertex
+struct PathEnumerator {
+  using Vertex = PrivateGraph::Vertex;
+
+  PathEnumerator(
+    const PrivateGraph& passGraph,
+    PathFingerprint::Bitset& passTopographic,
+    PathFingerprint::Bitset& passBondTyped
+  ) : graph(passGraph),
+      topographic(passTopographic),
+      bondTyped(passBondTyped),
+      onPath(passGraph.N(), false)
+  {
+    atomicNumbers.reserve(graph.N());
+    for(const Vertex i : graph.vertices()) {
+      atomicNumbers.push_back(Utils::ElementInfo::Z(graph.elementType(i)));
+    }
+  }
+
+  void extend(
+    const Vertex v,
+    const std::uint64_t topographicHash,
+    const std::uint64_t bondTypedHash,
+    const unsigned bonds
+  ) {
+    topographic.set(topographicHash % PathFingerprint::size);
+    bondTyped.set(bondTypedHash % PathFingerprint::size);
+    if(bonds == PathFingerprint::maxBonds) {
+      return;
+    }
+
+    const auto& bgl = graph.bgl();
+    onPath[v] = true;
+    for(const auto& edge : boost::make_iterator_range(boost::out_edges(v, bgl))) {
+      const Vertex w = boost::target(edge, bgl);
+      if(onPath[w]) {
+        continue;
+      }
+
+      const unsigned bondType = static_cast<unsigned>(bgl[edge].bondType) + 1;
+      extend(
+        w,
+        mix(topographicHash ^ atomicNumbers[w]),
+        mix(bondTypedHash ^ (atomicNumbers[w] | (bondType << 8U))),
+        bonds + 1
+      );
+    }
+    onPath[v] = false;
+  }
+
+  const PrivateGraph& graph;
+  PathFingerprint::Bitset& topographic;
+  PathFingerprint::Bitset& bondTyped;
+  std::vector<unsigned> atomicNumbers;
+  std::vector<bool> onPath;
+};
+
+} // namespace
+
+constexpr unsigned PathFingerprint::size;
+constexpr unsigned PathFingerprint::maxBonds;
+
+PathFingerprint::PathFingerprint(const PrivateGraph& graph) {
+  PathEnumerator enumerator {graph, topographic_, bondTyped_};
+  for(const PrivateGraph::Vertex i : graph.vertices()) {
+    const std::uint64_t Z = enumerator.atomicNumbers[i];
+    enumerator.extend(i, mix(Z), mix(Z), 0);
+
+    /* A needle vertex maps onto a haystack vertex of the same element type
+     * and at least equal degree, so each degree up to the vertex's own is
+     * recorded
+     */
+    const unsigned degree = graph.degree(i);
+    for(unsigned d = 1; d <= degree; ++d) {
+      topographic_.set(mix(mix(Z | (1ULL << 16U)) ^ d) % size);
+    }
+  }
+}
+
+} // namespace Molassembler
+} // namespace Scine
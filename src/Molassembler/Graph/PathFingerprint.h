@@ -0,0 +1,83 @@
+/*!@file
+ * @copyright This code is licensed under the 3-clause BSD license.
+ *   Copyright ETH Zurich, Laboratory of Physical Chemistry, Reiher Group.
+ *   See LICENSE.txt for details.
+ * @brief Hashed path fingerprint of a molecular graph for subgraph screening
+ */
+
+#ifndef INCLUDE_MOLASSEMBLER_GRAPH_PATH_FINGERPRINT_H
+#define INCLUDE_MOLASSEMBLER_GRAPH_PATH_FINGERPRINT_H
+
+#include <bitset>
+
+namespace Scine {
+namespace Molassembler {
+
+// Forward-declarations
+class PrivateGraph;
+
+/**
+ * @brief Bits set by hashed features of a graph that survive subgraph
+ *   monomorphisms
+ *
+ * Features are simple paths of up to maxBonds bonds, labeled by element types,
+ * and the lower bounds on vertex degree of each element type. The features of
+ * a subgraph are a subset of the features of any graph containing it, so the
+ * fingerprint of a needle having bits unset in a haystack's fingerprint proves
+ * that no mapping exists. Hash collisions only weaken the test.
+ *
+ * Paths are additionally recorded with bond types, to be compared only if
+ * bond types are relevant for the match.
+ */
+class PathFingerprint {
+public:
+  //! Number of bits of each bitset
+  static constexpr unsigned size = 1024;
+  //! Maximum number of bonds of recorded paths
+  static constexpr unsigned maxBonds = 4;
+
+  using Bitset = std::bitset<size>;
+
+  //! Empty fingerprint
+  PathFingerprint() = default;
+
+  /*! @brief Fingerprints a graph
+   *
+   * @complexity{@math{O(N d^{maxBonds})} where @math{d} is the maximum vertex
+   * degree}
+   */
+  explicit PathFingerprint(const PrivateGraph& graph);
+
+  /*! @brief Whether all bits of a needle's fingerprint are set in this one
+   *
+   * @param needle The possible subgraph's fingerprint
+   * @param compareBondTypes Whether bond types of paths have to match
+   *
+   * @complexity{@math{\Theta(1)}}
+   */
+  inline bool contains(const PathFingerprint& needle, const bool compareBondTypes) const {
+    return (
+      (needle.topographic_ & ~topographic_).none()
+      && (!compareBondTypes || (needle.bondTyped_ & ~bondTyped_).none())
+    );
+  }
+
+  //! Bits of element type labeled paths and vertex degrees
+  inline const Bitset& topographic() const {
+    return topographic_;
+  }
+
+  //! Bits of element and bond type labeled paths
+  inline const Bitset& bondTyped() const {
+    return bondTyped_;
+  }
+
+private:
+  Bitset topographic_;
+  Bitset bondTyped_;
+};
+
+} // namespace Molassembler
+} // namespace Scine
+
+#endif
@@ -6,6 +6,8 @@
 
 #include "Molassembler/Graph/PrivateGraph.h"
 
+#include "Molassembler/Graph/FrozenGraph.h"
+#include "Molassembler/Detail/Metrics.h"
 #include "Molassembler/Molecule/AtomEnvironmentHash.h"
 #include "boost/graph/isomorphism.hpp"
 #include "boost/graph/graph_utility.hpp"
@@ -15,6 +17,7 @@
 #include "boost/optional.hpp"
 
 #include "Molassembler/Temple/Functional.h"
+#include "Molassembler/Temple/VisitedSet.h"
 
 namespace Scine {
 namespace Molassembler {
@@ -108,7 +111,11 @@ PrivateGraph::Edge PrivateGraph::addEdge(const Vertex a, const Vertex b, const B
   }
 
   // Invalidate the cache only after all throwing conditions
-  properties_.invalidate();
+  if(properties_.hasCycles() && !connected_(a, b)) {
+    properties_.invalidateAcyclic();
+  } else {
+    properties_.invalidate();
+  }
 
   auto newBondPair = boost::add_edge(a, b, graph_);
 
@@ -120,8 +127,8 @@ PrivateGraph::Edge PrivateGraph::addEdge(const Vertex a, const Vertex b, const B
 }
 
 PrivateGraph::Vertex PrivateGraph::addVertex(const Utils::ElementType elementType) {
-  // Invalidate the cache values
-  properties_.invalidate();
+  // An isolated vertex is in no cycle
+  properties_.invalidateAcyclic();
 
   PrivateGraph::Vertex newVertex = boost::add_vertex(graph_);
   graph_[newVertex].elementType = elementType;
@@ -162,15 +169,22 @@ BondType& PrivateGraph::bondType(const PrivateGraph::Edge& edge) {
 }
 
 void PrivateGraph::clearVertex(Vertex a) {
-  // Invalidate the cache values
-  properties_.invalidate();
+  // If the vertex is in no cycle, all of its edges are bridges
+  if(properties_.hasCycles() && !cycleMembership().at(a)) {
+    properties_.invalidateAcyclic();
+  } else {
+    properties_.invalidate();
+  }
 
   boost::clear_vertex(a, graph_);
 }
 
 void PrivateGraph::removeEdge(const Edge& e) {
-  // Invalidate the cache values
-  properties_.invalidate();
+  if(properties_.hasCycles() && removalSafetyData().bridges.count(e) > 0) {
+    properties_.invalidateAcyclic();
+  } else {
+    properties_.invalidate();
+  }
 
   boost::remove_edge(e, graph_);
 }
@@ -183,9 +197,8 @@ void PrivateGraph::removeVertex(Vertex a) {
 }
 
 Utils::ElementType& PrivateGraph::elementType(const Vertex a) {
-  // Invalidate the cache values
-  properties_.invalidate();
-
+  // Of the cached properties, only the fingerprint depends on element types
+  properties_.pathFingerprint.reset();
   return graph_[a].elementType;
 }
 
@@ -334,6 +347,10 @@ boost::optional<std::vector<AtomIndex>> PrivateGraph::modularIsomorphism(
   return boost::none;
 }
 
+FrozenGraph PrivateGraph::freeze() const {
+  return FrozenGraph {*this};
+}
+
 bool PrivateGraph::identicalGraph(const PrivateGraph& other) const {
   assert(N() == other.N() && B() == other.B());
 
@@ -396,6 +413,55 @@ std::pair<
   );
 }
 
+std::size_t PrivateGraph::heapSize() const {
+  using OutEdgeList = std::remove_reference_t<decltype(graph_.out_edge_list(0))>;
+  using EdgeList = decltype(graph_.m_edges);
+
+  /* Node-based containers allocate each value with bookkeeping pointers: two
+   * for list nodes and hash nodes (cached hash), four for tree nodes
+   */
+  constexpr std::size_t pointer = sizeof(void*);
+
+  std::size_t size = graph_.m_vertices.capacity() * sizeof(BglType::stored_vertex);
+  for(const Vertex v : vertices()) {
+    size += graph_.out_edge_list(v).capacity() * sizeof(OutEdgeList::value_type);
+  }
+  // Properties of undirected edges are stored once in a list of edges
+  size += B() * (sizeof(EdgeList::value_type) + 2 * pointer);
+
+  if(const RemovalSafetyData* safety = properties_.removalSafetyData.peek()) {
+    size += sizeof(RemovalSafetyData);
+    size += safety->articulationVertices.bucket_count() * pointer;
+    size += safety->articulationVertices.size() * (sizeof(Vertex) + 2 * pointer);
+    size += safety->bridges.size() * (sizeof(Edge) + 4 * pointer);
+  }
+
+  if(const std::vector<bool>* membership = properties_.cycleMembership.peek()) {
+    size += sizeof(std::vector<bool>) + (membership->capacity() + 7) / 8;
+  }
+
+  if(const GraphDistanceMatrix* distances = properties_.distances.peek()) {
+    size += sizeof(GraphDistanceMatrix) + distances->N() * distances->N();
+  }
+
+  if(properties_.pathFingerprint.peek() != nullptr) {
+    size += sizeof(PathFingerprint);
+  }
+
+  return size;
+}
+
+std::size_t PrivateGraph::cyclesHeapSize() const {
+  std::size_t size = 0;
+  if(const Cycles* cycles = properties_.cycles.peek()) {
+    size += sizeof(Cycles) + cycles->heapSize();
+  }
+  if(const Cycles* cycles = properties_.etaPreservedCycles.peek()) {
+    size += sizeof(Cycles) + cycles->heapSize();
+  }
+  return size;
+}
+
 PrivateGraph::VertexRange PrivateGraph::vertices() const {
   auto iters = boost::vertices(graph_);
   return {
@@ -440,36 +506,45 @@ const PrivateGraph::BglType& PrivateGraph::bgl() const {
 }
 
 void PrivateGraph::populateProperties() const {
-  if(!properties_.removalSafetyDataOption) {
-    properties_.removalSafetyDataOption = generateRemovalSafetyData_();
-  }
-  if(!properties_.cyclesOption) {
-    properties_.cyclesOption = generateCycles_();
-  }
+  removalSafetyData();
+  cycles();
+  cycleMembership();
 }
 
 const PrivateGraph::RemovalSafetyData& PrivateGraph::removalSafetyData() const {
-  if(!properties_.removalSafetyDataOption) {
-    properties_.removalSafetyDataOption = generateRemovalSafetyData_();
-  }
-
-  return *properties_.removalSafetyDataOption;
+  return properties_.removalSafetyData.get(
+    [this]() { return generateRemovalSafetyData_(); }
+  );
 }
 
 const Cycles& PrivateGraph::cycles() const {
-  if(!properties_.cyclesOption) {
-    properties_.cyclesOption = generateCycles_();
-  }
-
-  return *properties_.cyclesOption;
+  return properties_.cycles.get(
+    [this]() { return generateCycles_(); }
+  );
 }
 
 const Cycles& PrivateGraph::etaPreservedCycles() const {
-  if(!properties_.etaPreservedCyclesOption) {
-    properties_.etaPreservedCyclesOption = generateEtaPreservedCycles_();
-  }
+  return properties_.etaPreservedCycles.get(
+    [this]() { return generateEtaPreservedCycles_(); }
+  );
+}
 
-  return *properties_.etaPreservedCyclesOption;
+const std::vector<bool>& PrivateGraph::cycleMembership() const {
+  return properties_.cycleMembership.get(
+    [this]() { return generateCycleMembership_(); }
+  );
+}
+
+const GraphDistanceMatrix& PrivateGraph::distances() const {
+  return properties_.distances.get(
+    [this]() { return GraphDistanceMatrix {*this}; }
+  );
+}
+
+const PathFingerprint& PrivateGraph::pathFingerprint() const {
+  return properties_.pathFingerprint.get(
+    [this]() { return PathFingerprint {*this}; }
+  );
 }
 
 PrivateGraph::RemovalSafetyData PrivateGraph::generateRemovalSafetyData_() const {
@@ -520,11 +595,48 @@ PrivateGraph::RemovalSafetyData PrivateGraph::generateRemovalSafetyData_() const
   return safetyData;
 }
 
+bool PrivateGraph::connected_(const Vertex a, const Vertex b) const {
+  // Reused across calls, since each bond addition checks connectivity
+  thread_local Temple::VisitedSet<Vertex> visited;
+  visited.reset(N());
+  std::vector<Vertex> stack {a};
+  visited.insert(a);
+  while(!stack.empty()) {
+    const Vertex v = stack.back();
+    stack.pop_back();
+    if(v == b) {
+      return true;
+    }
+
+    for(const Vertex w : adjacents(v)) {
+      if(visited.insert(w)) {
+        stack.push_back(w);
+      }
+    }
+  }
+
+  return false;
+}
+
+std::vector<bool> PrivateGraph::generateCycleMembership_() const {
+  const auto& bridges = removalSafetyData().bridges;
+  std::vector<bool> membership(N(), false);
+  for(const Edge& edge : edges()) {
+    if(bridges.count(edge) == 0) {
+      membership.at(source(edge)) = true;
+      membership.at(target(edge)) = true;
+    }
+  }
+  return membership;
+}
+
 Cycles PrivateGraph::generateCycles_() const {
+  const Detail::Metrics::Timer timer {Detail::Metrics::Operation::CycleRecomputation};
   return Cycles(*this);
 }
 
 Cycles PrivateGraph::generateEtaPreservedCycles_() const {
+  const Detail::Metrics::Timer timer {Detail::Metrics::Operation::CycleRecomputation};
   return Cycles(*this, false);
 }
 
@@ -12,12 +12,19 @@
 #include "Utils/Geometry/ElementTypes.h"
 
 #include "Molassembler/Cycles.h"
+#include "Molassembler/GraphDistanceMatrix.h"
+#include "Molassembler/Graph/PathFingerprint.h"
 
+#include <atomic>
 #include <limits>
+#include <memory>
+#include <mutex>
 
 namespace Scine {
 namespace Molassembler {
 
+class FrozenGraph;
+
 /**
  * @brief Library internal graph class wrapping BGL types
  */
@@ -115,12 +122,17 @@ public:
 //!@{
   /*! @brief Add an edge to the graph
    *
-   * @complexity{@math{\Theta(1)}}
+   * Cached cycle data is kept if the edge joins two previously disconnected
+   * components, since no cycle is closed.
+   *
+   * @complexity{@math{\Theta(1)}, @math{O(V + E)} if cycle data is cached}
    * @throws std::logic_error if the edge already exists
    */
   Edge addEdge(Vertex a, Vertex b, BondType bondType);
 
   /*! @brief Add a (disconnected) vertex to the graph
+   *
+   * Keeps cached cycle data.
    *
    * @complexity{@math{\Theta(1)}}
    */
@@ -144,7 +156,9 @@ public:
 
   /*! @brief Removes all bonds involving a vertex
    *
-   * @complexity{@math{\Theta(1)}}
+   * Cached cycle data is kept if the vertex is not part of any cycle.
+   *
+   * @complexity{@math{\Theta(1)}, @math{O(V + E)} if cycle data is cached}
    */
   void clearVertex(Vertex a);
 
@@ -157,7 +171,9 @@ public:
 
   /*! @brief Removes an edge from the graph.
    *
-   * @complexity{@math{\Theta(1)}}
+   * Cached cycle data is kept if the edge is a bridge.
+   *
+   * @complexity{@math{\Theta(1)}, @math{O(V + E)} if cycle data is cached}
    */
   void removeEdge(const Edge& e);
 
@@ -193,8 +209,6 @@ public:
    *
    * @complexity{@math{O(V)} worst case, if removal data is cached
    * @math{\Theta(1)}}
-   *
-   * @note This function is not thread-safe.
    */
   bool canRemove(Vertex a) const;
   /*! @brief Determine whether an edge can be safely removed
@@ -202,8 +216,6 @@ public:
    *
    * @complexity{@math{O(V)} worst case, if removal data is cached
    * @math{\Theta(1)}}
-   *
-   * @note This function is not thread-safe.
    */
   bool canRemove(const Edge& edge) const;
 
@@ -258,6 +270,13 @@ public:
     AtomEnvironmentComponents components = AtomEnvironmentComponents::All
   ) const;
 
+  /*! @brief Immutable compressed sparse row snapshot for read-only traversals
+   *
+   * @complexity{@math{\Theta(N + B \log D)} where @math{D} is the largest
+   * vertex degree}
+   */
+  FrozenGraph freeze() const;
+
   /*! @brief Checks whether all edges present in *this are present in @p other
    *
    * @complexity{@math{O(B)}}
@@ -267,12 +286,24 @@ public:
   /*! @brief Determine which vertices belong to which side of a bridge edge
    *
    * @complexity{@math{\Theta(N)}}
-   * @note This function is not thread-safe.
    */
   std::pair<
     std::vector<AtomIndex>,
     std::vector<AtomIndex>
   > splitAlongBridge(Edge bridge) const;
+
+  /*! @brief Approximate heap memory in bytes of the graph and its generated
+   *   cached properties other than cycle information
+   *
+   * @complexity{@math{\Theta(N)}}
+   */
+  std::size_t heapSize() const;
+
+  /*! @brief Approximate heap memory in bytes of generated cycle information
+   *
+   * @complexity{@math{\Theta(B)}}
+   */
+  std::size_t cyclesHeapSize() const;
 //!@}
 
 /*!
@@ -281,9 +312,11 @@ public:
  * before. After generation, properties are valid as long as no non-const
  * method is called on this class that modifies state.
  *
- * None of these methods are thread-safe.
+ * Concurrent calls of these const methods are safe. Each property is
+ * generated at most once, and callers racing for it wait for its generation.
  * @{
  */
+  //! Eagerly generate the properties most algorithms depend on
   void populateProperties() const;
   //! Access cycle information of the graph
   const Cycles& cycles() const;
@@ -291,6 +324,12 @@ public:
   const RemovalSafetyData& removalSafetyData() const;
   //! Access cycle information of the graph with eta bonds preserved
   const Cycles& etaPreservedCycles() const;
+  //! Whether each vertex is part of any cycle, i.e. has non-bridge edges
+  const std::vector<bool>& cycleMembership() const;
+  //! Graph distances between all pairs of vertices
+  const GraphDistanceMatrix& distances() const;
+  //! Hashed paths and vertex degrees for subgraph screening
+  const PathFingerprint& pathFingerprint() const;
 //!@}
 
 //!@name Ranges
@@ -313,21 +352,98 @@ public:
 private:
 //!@name Private types
 //!@{
+  /* Lazily generated value. Concurrent get() calls generate the value once,
+   * readers take a lock-free path after publication. Moving and resetting are
+   * mutating operations and may not race with get().
+   */
+  template<typename T>
+  class Lazy {
+  public:
+    Lazy() = default;
+    Lazy(Lazy&& other) noexcept : value_(std::move(other.value_)) {
+      pointer_.store(value_.get(), std::memory_order_relaxed);
+      other.pointer_.store(nullptr, std::memory_order_relaxed);
+    }
+    Lazy& operator = (Lazy&& other) noexcept {
+      value_ = std::move(other.value_);
+      pointer_.store(value_.get(), std::memory_order_relaxed);
+      other.pointer_.store(nullptr, std::memory_order_relaxed);
+      return *this;
+    }
+
+    template<typename F>
+    const T& get(F&& generate) {
+      if(const T* published = pointer_.load(std::memory_order_acquire)) {
+        return *published;
+      }
+
+      std::lock_guard<std::mutex> lock(mutex_);
+      if(!value_) {
+        value_ = std::make_unique<const T>(generate());
+        pointer_.store(value_.get(), std::memory_order_release);
+      }
+      return *value_;
+    }
+
+    void reset() {
+      value_.reset();
+      pointer_.store(nullptr, std::memory_order_relaxed);
+    }
+
+    explicit operator bool() const {
+      return pointer_.load(std::memory_order_acquire) != nullptr;
+    }
+
+    //! The value if it has been generated, without generating it
+    const T* peek() const {
+      return pointer_.load(std::memory_order_acquire);
+    }
+
+  private:
+    std::unique_ptr<const T> value_;
+    std::atomic<const T*> pointer_ {nullptr};
+    std::mutex mutex_;
+  };
+
   struct Properties {
-    boost::optional<RemovalSafetyData> removalSafetyDataOption;
-    boost::optional<Cycles> cyclesOption;
-    boost::optional<Cycles> etaPreservedCyclesOption;
+    Lazy<RemovalSafetyData> removalSafetyData;
+    Lazy<Cycles> cycles;
+    Lazy<Cycles> etaPreservedCycles;
+    Lazy<std::vector<bool>> cycleMembership;
+    Lazy<GraphDistanceMatrix> distances;
+    Lazy<PathFingerprint> pathFingerprint;
 
     inline void invalidate() {
-      removalSafetyDataOption = boost::none;
-      cyclesOption = boost::none;
-      etaPreservedCyclesOption = boost::none;
+      removalSafetyData.reset();
+      cycles.reset();
+      etaPreservedCycles.reset();
+      cycleMembership.reset();
+      distances.reset();
+      pathFingerprint.reset();
+    }
+
+    /* Adding or removing bridges or isolated vertices neither opens nor
+     * closes cycles, so cycle data can be kept
+     */
+    inline void invalidateAcyclic() {
+      removalSafetyData.reset();
+      cycleMembership.reset();
+      distances.reset();
+      pathFingerprint.reset();
+    }
+
+    inline bool hasCycles() const {
+      return static_cast<bool>(cycles) || static_cast<bool>(etaPreservedCycles);
     }
   };
 
+  //! Whether two vertices are in the same connected component
+  bool connected_(Vertex a, Vertex b) const;
+
   RemovalSafetyData generateRemovalSafetyData_() const;
   Cycles generateCycles_() const;
   Cycles generateEtaPreservedCycles_() const;
+  std::vector<bool> generateCycleMembership_() const;
 //!@}
 
 //!@name Private state
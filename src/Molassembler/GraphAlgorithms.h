@@ -26,6 +26,9 @@ class Graph;
  *
  * @throws std::out_of_range If i >= N()
  *
+ * @note To query distances from many atoms, use the cached all-pairs
+ *   Graph::distances() instead.
+ *
  * @returns A vector containing the distances of all vertices to the supplied
  *   index
  */
@@ -0,0 +1,94 @@
+/*!@file
+ * @copyright This code is licensed under the 3-clause BSD license.
+ *   Copyright ETH Zurich, Laboratory of Physical Chemistry, Reiher Group.
+ *   See LICENSE.txt for details.
+ */
+
+#include "Molassembler/GraphDistanceMatrix.h"
+
+#include "Molassembler/Graph.h"
+#include "Molassembler/Graph/FrozenGraph.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace Scine {
+namespace Molassembler {
+
+constexpr std::uint8_t GraphDistanceMatrix::unreachable;
+constexpr unsigned GraphDistanceMatrix::maxStorableDepth;
+
+GraphDistanceMatrix::GraphDistanceMatrix(const Graph& graph, const unsigned maxDepth)
+  : GraphDistanceMatrix {graph.inner(), maxDepth}
+{}
+
+GraphDistanceMatrix::GraphDistanceMatrix(const PrivateGraph& graph, const unsigned maxDepth)
+  : N_(graph.N()),
+    maxDepth_(std::min(maxDepth, maxStorableDepth)),
+    distances_(N_ * N_, unreachable)
+{
+  using Word = std::uint64_t;
+  constexpr unsigned wordBits = 64;
+
+  const FrozenGraph frozen = graph.freeze();
+
+  /* Each bit of a vertex's words stands for one of the sources of the current
+   * block: visited marks sources whose search has reached the vertex,
+   * frontier those that reached it at the previous depth
+   */
+  std::vector<Word> visited(N_);
+  std::vector<Word> frontier(N_);
+  std::vector<Word> next(N_);
+
+  for(unsigned blockStart = 0; blockStart < N_; blockStart += wordBits) {
+    const unsigned blockSize = std::min(wordBits, N_ - blockStart);
+    std::fill(std::begin(visited), std::end(visited), 0);
+    std::fill(std::begin(frontier), std::end(frontier), 0);
+    for(unsigned b = 0; b < blockSize; ++b) {
+      const AtomIndex source = blockStart + b;
+      visited[source] = frontier[source] = Word {1} << b;
+      distances_[source * N_ + source] = 0;
+    }
+
+    for(unsigned depth = 1; depth <= maxDepth_; ++depth) {
+      bool advanced = false;
+      for(AtomIndex v = 0; v < N_; ++v) {
+        Word reached = 0;
+        for(const AtomIndex w : frozen.adjacents(v)) {
+          reached |= frontier[w];
+        }
+        reached &= ~visited[v];
+        next[v] = reached;
+
+        if(reached == 0) {
+          continue;
+        }
+
+        advanced = true;
+        visited[v] |= reached;
+        for(unsigned b = 0; reached != 0; ++b, reached >>= 1) {
+          if((reached & 1) != 0) {
+            distances_[(blockStart + b) * N_ + v] = depth;
+          }
+        }
+      }
+
+      if(!advanced) {
+        break;
+      }
+
+      std::swap(frontier, next);
+    }
+  }
+}
+
+std::uint8_t GraphDistanceMatrix::at(const AtomIndex i, const AtomIndex j) const {
+  if(i >= N_ || j >= N_) {
+    throw std::out_of_range("Atom index out of range in graph distance matrix");
+  }
+
+  return (*this)(i, j);
+}
+
+} // namespace Molassembler
+} // namespace Scine
@@ -0,0 +1,109 @@
+/*!@file
+ * @copyright This code is licensed under the 3-clause BSD license.
+ *   Copyright ETH Zurich, Laboratory of Physical Chemistry, Reiher Group.
+ *   See LICENSE.txt for details.
+ * @brief All-pairs topological distances of a molecular graph
+ */
+
+#ifndef INCLUDE_MOLASSEMBLER_GRAPH_DISTANCE_MATRIX_H
+#define INCLUDE_MOLASSEMBLER_GRAPH_DISTANCE_MATRIX_H
+
+#include "Molassembler/Types.h"
+
+#include <vector>
+
+namespace Scine {
+namespace Molassembler {
+
+// Forward-declarations
+class Graph;
+class PrivateGraph;
+
+/**
+ * @brief Symmetric matrix of graph distances between all pairs of atoms
+ *
+ * Distances are stored in a single byte each and are truncated at a maximum
+ * depth: Pairs of atoms further apart than the maximum depth or in separate
+ * connected components are reported as unreachable.
+ *
+ * Distances are calculated by breadth-first searches from up to 64 source
+ * atoms at once, each source represented by a bit of a machine word, so that
+ * a single traversal of the graph per search depth serves all sources in the
+ * word.
+ */
+class MASM_EXPORT GraphDistanceMatrix {
+public:
+//!@name Static members
+//!@{
+  //! Distance value of pairs that are unreachable within the maximum depth
+  static constexpr std::uint8_t unreachable = 255;
+  //! Largest maximum depth that can be stored
+  static constexpr unsigned maxStorableDepth = 254;
+//!@}
+
+//!@name Constructors
+//!@{
+  //! Empty matrix
+  GraphDistanceMatrix() = default;
+
+  /*! @brief Calculate distances of all pairs of atoms in a graph
+   *
+   * @complexity{@math{O(\lceil N / 64 \rceil \cdot d \cdot (N + B) + N^2)}
+   * where @math{d} is the lesser of the maximum depth and the graph diameter}
+   *
+   * @param graph The graph to calculate distances for
+   * @param maxDepth Maximum distance to record. Values above
+   *   maxStorableDepth are clamped to it.
+   */
+  explicit GraphDistanceMatrix(const Graph& graph, unsigned maxDepth = maxStorableDepth);
+  //! @overload
+  explicit GraphDistanceMatrix(const PrivateGraph& graph, unsigned maxDepth = maxStorableDepth);
+//!@}
+
+//!@name Information
+//!@{
+  //! Number of atoms
+  inline unsigned N() const {
+    return N_;
+  }
+
+  //! Maximum recorded distance
+  inline unsigned maxDepth() const {
+    return maxDepth_;
+  }
+
+  /*! @brief Graph distance between two atoms
+   *
+   * @complexity{@math{\Theta(1)}}
+   * @pre @p i and @p j are less than N()
+   *
+   * @returns The distance, or unreachable if the atoms are further apart than
+   *   maxDepth() or not connected
+   */
+  inline std::uint8_t operator() (const AtomIndex i, const AtomIndex j) const {
+    return distances_[i * N_ + j];
+  }
+
+  /*! @brief Graph distance between two atoms, with bounds checking
+   *
+   * @throws std::out_of_range If @p i or @p j is not less than N()
+   */
+  std::uint8_t at(AtomIndex i, AtomIndex j) const;
+
+  //! Whether two atoms are within maxDepth() of one another
+  inline bool reachable(const AtomIndex i, const AtomIndex j) const {
+    return (*this)(i, j) != unreachable;
+  }
+//!@}
+
+private:
+  unsigned N_ = 0;
+  unsigned maxDepth_ = 0;
+  //! Row-major distances
+  std::vector<std::uint8_t> distances_;
+};
+
+} // namespace Molassembler
+} // namespace Scine
+
+#endif
@@ -190,6 +190,10 @@ Molecule read(const std::string& filename) {
   }
 
   // Direct serializations of molecules have their own filetypes
+  if(filepath.extension() == ".masm") {
+    return CompactSerialization::read(filename);
+  }
+
   if(filepath.extension() == ".cbor") {
     return JsonSerialization(
       BinaryHandler::read(filename),
@@ -297,6 +301,11 @@ void write(const std::string& filename, const Molecule& molecule) {
     }
   }
 
+  if(filepath.extension() == ".masm") {
+    CompactSerialization::write(filename, molecule);
+    return;
+  }
+
   if(filepath.extension() == ".cbor") {
     BinaryHandler::write(
       filename,
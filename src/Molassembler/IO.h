@@ -17,6 +17,7 @@
 #include "Molassembler/Types.h"
 #include "Utils/Typenames.h"
 
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -98,8 +99,9 @@ MASM_EXPORT std::tuple<Utils::AtomCollection, Utils::BondOrderCollection, std::v
  * @complexity{@math{\Theta(N)} typically}
  * @throws If interpretation of coordinates and connectivity yields multiple
  *   molecules.
- * @note Interprets file type from extension. mol is a MOLFile, xyz an XYZ file
- *   and cbor/bson/json are serializations of Molecule
+ * @note Interprets file type from extension. mol is a MOLFile, xyz an XYZ file,
+ *   masm is a CompactSerialization and cbor/bson/json are JSON serializations
+ *   of Molecule
  */
 MASM_EXPORT Molecule read(const std::string& filename);
 
@@ -139,12 +141,178 @@ MASM_EXPORT void write(
  *
  * @complexity{@math{\Theta(V + E + A + B)}}
  * @note Canonicalization state is retained using the molecule serializations.
- * @throws std::logic_error If the file extension does not match .cbor, .bson, .json, .dot or .svg
+ * @throws std::logic_error If the file extension does not match .masm, .cbor,
+ *   .bson, .json, .dot or .svg
  * @throws std::runtime_error If the file extension is .svg but the dot binary
  *   is not found in the path
  */
 MASM_EXPORT void write(const std::string& filename, const Molecule& molecule);
 
+/**
+ * @brief Streaming reader of multi-frame XYZ files
+ *
+ * Reads frames one at a time into buffers that are reused across frames, so
+ * that reading a trajectory does not allocate per frame. Positions are
+ * converted to bohr units.
+ *
+ * Instances can be passed as frame readers to
+ * DirectedConformerGenerator::Relabeler::binIndices.
+ *
+ * @code{cpp}
+ * IO::XyzTrajectoryReader reader {"trajectory.xyz"};
+ * while(reader.next()) {
+ *   auto interpretation = Interpret::molecules(
+ *     reader.elements(),
+ *     AngstromPositions {reader.positions()}
+ *   );
+ * }
+ * @endcode
+ */
+class MASM_EXPORT XyzTrajectoryReader {
+public:
+//!@name Special member functions
+//!@{
+  /*! @brief Open a trajectory file
+   *
+   * @throws std::runtime_error If the file cannot be opened
+   */
+  explicit XyzTrajectoryReader(const std::string& filename);
+
+  XyzTrajectoryReader(XyzTrajectoryReader&& other) noexcept;
+  XyzTrajectoryReader& operator = (XyzTrajectoryReader&& other) noexcept;
+  XyzTrajectoryReader(const XyzTrajectoryReader& other) = delete;
+  XyzTrajectoryReader& operator = (const XyzTrajectoryReader& other) = delete;
+  ~XyzTrajectoryReader();
+//!@}
+
+//!@name Modification
+//!@{
+  /*! @brief Read the next frame into the buffers
+   *
+   * @complexity{@math{\Theta(N)}}
+   * @throws std::runtime_error If the frame is truncated or malformed
+   *
+   * @returns Whether a frame was read, false at the end of the file
+   */
+  bool next();
+
+  /*! @brief Read the next frame's positions in bohr into @p positions
+   *
+   * Frame reader interface, see DirectedConformerGenerator::Relabeler
+   *
+   * @throws std::runtime_error If the frame is truncated or malformed
+   *
+   * @returns Whether a frame was read, false at the end of the file
+   */
+  bool operator () (Utils::PositionCollection& positions);
+//!@}
+
+//!@name Information
+//!@{
+  //! Element types of the last read frame
+  const Utils::ElementTypeCollection& elements() const;
+
+  //! Positions of the last frame read with next() in bohr
+  const Utils::PositionCollection& positions() const;
+
+  //! Comment line of the last read frame
+  const std::string& comment() const;
+
+  //! Number of frames read so far
+  unsigned frames() const;
+//!@}
+
+private:
+  struct Impl;
+  std::unique_ptr<Impl> pImpl_;
+};
+
+/**
+ * @brief Writes conformers to a file on a background thread
+ *
+ * Conformers are queued by add() and formatted and written by a background
+ * thread, so that disk I/O overlaps with conformer generation. The queue is
+ * bounded: add() blocks while it is full.
+ *
+ * @code{cpp}
+ * IO::AsyncConformerWriter writer {"ensemble.xyz", mol};
+ * generateEnsemble(mol, 10000, 42, [&](unsigned i, unsigned, auto result) {
+ *   if(result) {
+ *     writer.add(std::move(result.value()), "Conformer " + std::to_string(i));
+ *   }
+ * });
+ * writer.close();
+ * @endcode
+ */
+class MASM_EXPORT AsyncConformerWriter {
+public:
+//!@name Member types
+//!@{
+  //! File format to write
+  enum class Format {
+    //! Multi-frame XYZ file in angstrom units
+    Xyz,
+    //! ConformerArchive with double precision coordinates
+    Archive
+  };
+//!@}
+
+//!@name Special member functions
+//!@{
+  /*! @brief Open a file and start the background thread
+   *
+   * @param filename Path of the file to create or overwrite
+   * @param molecule Molecule of which the conformers are
+   * @param format File format to write
+   * @param capacity Maximum number of queued conformers
+   *
+   * @throws std::runtime_error If the file cannot be opened
+   */
+  AsyncConformerWriter(
+    const std::string& filename,
+    const Molecule& molecule,
+    Format format = Format::Xyz,
+    unsigned capacity = 64
+  );
+
+  AsyncConformerWriter(AsyncConformerWriter&& other) noexcept;
+  AsyncConformerWriter& operator = (AsyncConformerWriter&& other) noexcept;
+  AsyncConformerWriter(const AsyncConformerWriter& other) = delete;
+  AsyncConformerWriter& operator = (const AsyncConformerWriter& other) = delete;
+  //! Closes the writer if not already closed
+  ~AsyncConformerWriter();
+//!@}
+
+//!@name Modification
+//!@{
+  /*! @brief Queue a conformer for writing
+   *
+   * Blocks while the queue is full. Thread-safe.
+   *
+   * @param positions Conformer positions in bohr
+   * @param comment Comment line of the frame in XYZ files. Ignored for
+   *   archives.
+   *
+   * @throws std::invalid_argument If the number of rows of @p positions does
+   *   not match the molecule's number of atoms
+   * @throws std::logic_error If the writer is already closed
+   * @throws std::runtime_error If writing a previous conformer failed
+   */
+  void add(Utils::PositionCollection positions, std::string comment = "");
+
+  /*! @brief Write all queued conformers and close the file
+   *
+   * @throws std::runtime_error If writing any conformer failed
+   * @note Repeated calls have no effect
+   */
+  void close();
+//!@}
+
+private:
+  struct Impl;
+  std::unique_ptr<Impl> pImpl_;
+};
+
 } // namespace IO
 } // namespace Molassembler
 } // namespace Scine
@@ -8,12 +8,30 @@
 #ifndef INCLUDE_BASE_64_ENCODING_H
 #define INCLUDE_BASE_64_ENCODING_H
 
+#include <cstdint>
 #include <string>
 #include <vector>
 
 namespace Scine {
 namespace base64 {
 
+/* If compiled for a target with SSSE3 (e.g. via SCINE_MARCH), encoding and
+ * decoding proceed in 16-character blocks using vector instructions.
+ */
+
+//! Number of characters of the encoding of @p size bytes
+std::size_t encodedSize(std::size_t size);
+
+/** @brief Encode binary data into a caller-provided buffer
+ *
+ * @complexity{@math{\Theta(N)}}
+ *
+ * @param input binary data
+ * @param size number of bytes of @p input
+ * @param output buffer of at least encodedSize(size) characters
+ */
+void encode(const std::uint8_t* input, std::size_t size, char* output);
+
 /** @brief Encode binary data as a string
  *
  * @complexity{@math{\Theta(N)}}
@@ -22,6 +40,26 @@ namespace base64 {
  */
 std::string encode(const std::vector<std::uint8_t>& inputBuffer);
 
+/** @brief Number of bytes encoded in a base 64 string
+ *
+ * @complexity{@math{\Theta(1)}}
+ * @throws std::runtime_error If @p length is not a multiple of four
+ */
+std::size_t decodedSize(const char* input, std::size_t length);
+
+/** @brief Decode base 64 string data into a caller-provided buffer
+ *
+ * @complexity{@math{\Theta(N)}}
+ *
+ * @param input base 64 characters
+ * @param length number of characters of @p input
+ * @param output buffer of at least decodedSize(input, length) bytes
+ *
+ * @throws std::runtime_error If @p input is not valid base 64
+ * @returns Number of bytes written
+ */
+std::size_t decode(const char* input, std::size_t length, std::uint8_t* output);
+
 /** @brief Decode base 64 string data to binary
  *
  * @complexity{@math{\Theta(N)}}
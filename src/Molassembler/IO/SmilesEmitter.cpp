@@ -0,0 +1,635 @@
+/*!@file
+ * @copyright This code is licensed under the 3-clause BSD license.
+ *   Copyright ETH Zurich, Laboratory of Physical Chemistry, Reiher Group.
+ *   See LICENSE.txt for details.
+ */
+#include "Molassembler/IO/SmilesEmitter.h"
+
+#include "Molassembler/IO/SmilesBondStereo.h"
+#include "Molassembler/IO/SmilesMoleculeBuilder.h"
+#include "Molassembler/AtomStereopermutator.h"
+#include "Molassembler/BondStereopermutator.h"
+#include "Molassembler/StereopermutatorList.h"
+#include "Molassembler/Stereopermutators/AbstractPermutations.h"
+#include "Molassembler/Stereopermutators/ShapeVertexMaps.h"
+#include "Molassembler/Stereopermutation/Manipulation.h"
+#include "Molassembler/RankingInformation.h"
+#include "Molassembler/Graph.h"
+#include "Molassembler/Modeling/BondDistance.h"
+#include "Molassembler/Molecule.h"
+#include "Molassembler/Shapes/Data.h"
+#include "Molassembler/Shapes/Properties.h"
+
+#include "Molassembler/Temple/Functional.h"
+
+#include "Utils/Geometry/ElementInfo.h"
+
+#include <map>
+#include <set>
+
+namespace Scine {
+namespace Molassembler {
+namespace IO {
+namespace {
+
+//! Number of chiral indices smiles defines for a shape, zero if none
+unsigned chiralIndexCount(const Shapes::Shape shape) {
+  switch(shape) {
+    case Shapes::Shape::Tetrahedron: return 2;
+    case Shapes::Shape::Square: return 3;
+    case Shapes::Shape::TrigonalBipyramid: return 20;
+    case Shapes::Shape::Octahedron: return 30;
+    default: return 0;
+  }
+}
+
+std::string chiralString(const ChiralData& chiralData) {
+  const std::string index = std::to_string(chiralData.chiralIndex);
+  switch(chiralData.shape) {
+    case Shapes::Shape::Tetrahedron: return (chiralData.chiralIndex == 1) ? "@" : "@@";
+    case Shapes::Shape::Square: return "@SP" + index;
+    case Shapes::Shape::TrigonalBipyramid: return "@TB" + index;
+    default: return "@OH" + index;
+  }
+}
+
+std::string bondString(const BondType type) {
+  switch(type) {
+    case BondType::Single: return "";
+    case BondType::Double: return "=";
+    case BondType::Triple: return "#";
+    case BondType::Quadruple: return "$";
+    // Haptic bonds are re-detected from the graph on parsing
+    case BondType::Eta: return "";
+    default: throw std::invalid_argument("Bond order cannot be expressed in smiles");
+  }
+}
+
+std::string ringNumberString(const unsigned number) {
+  if(number < 10) {
+    return std::to_string(number);
+  }
+
+  return "%" + std::to_string(number);
+}
+
+/**
+ * @brief Writes a smiles string from a depth-first spanning tree of a
+ *   canonical molecule
+ *
+ * Construction fixes the spanning tree, the order in which each atom's
+ * children are written and all stereo markers. Marker choices mirror the
+ * interpretation in MoleculeBuilder, so that the emitted string parses back
+ * into the same molecule.
+ */
+class Emitter {
+public:
+  explicit Emitter(const Molecule& molecule)
+    : molecule_(molecule),
+      graph_(molecule.graph()),
+      suppressed_(graph_.N(), false),
+      hydrogenCount_(graph_.N(), 0),
+      parent_(graph_.N()),
+      children_(graph_.N()),
+      ringPartners_(graph_.N()),
+      position_(graph_.N(), 0),
+      markedFor_(graph_.N(), -1),
+      markers_(graph_.N()),
+      chiralStrings_(graph_.N())
+  {
+    const AtomIndex N = graph_.N();
+    std::vector<bool> stereocenter(N, false);
+    for(const AtomStereopermutator& permutator : molecule_.stereopermutators().atomStereopermutators()) {
+      if(permutator.assigned() && permutator.numAssignments() > 1) {
+        stereocenter.at(permutator.placement()) = true;
+      }
+    }
+
+    std::vector<bool> stereoBondAtom(N, false);
+    for(const BondStereopermutator& permutator : molecule_.stereopermutators().bondStereopermutators()) {
+      const BondIndex bond = permutator.placement();
+      if(
+        permutator.assigned()
+        && permutator.numAssignments() == 2
+        && graph_.bondType(bond) == BondType::Double
+      ) {
+        stereoBonds_.push_back(bond);
+        stereoBondAtom.at(bond.first) = true;
+        stereoBondAtom.at(bond.second) = true;
+      }
+    }
+    std::sort(std::begin(stereoBonds_), std::end(stereoBonds_));
+
+    /* Terminal hydrogen atoms become hydrogen counts unless they are needed
+     * to express stereo
+     */
+    for(AtomIndex i = 0; i < N; ++i) {
+      if(graph_.elementType(i) != Utils::ElementType::H || graph_.degree(i) != 1) {
+        continue;
+      }
+
+      const AtomIndex j = *graph_.adjacents(i).begin();
+      if(
+        Utils::ElementInfo::Z(graph_.elementType(j)) == 1
+        || stereocenter.at(j)
+        || stereoBondAtom.at(j)
+        || graph_.bondType(BondIndex {i, j}) != BondType::Single
+      ) {
+        continue;
+      }
+
+      suppressed_.at(i) = true;
+      ++hydrogenCount_.at(j);
+    }
+
+    for(AtomIndex i = 0; i < N; ++i) {
+      if(!suppressed_.at(i)) {
+        root_ = i;
+        break;
+      }
+    }
+
+    std::vector<bool> visited(N, false);
+    buildTree_(root_, visited);
+    placeBondMarkers_();
+    setChiralStrings_(stereocenter);
+  }
+
+  std::string emit() {
+    std::vector<bool> ringNumberInUse(100, false);
+    std::map<BondIndex, unsigned> ringNumbers;
+    emit_(root_, ringNumberInUse, ringNumbers);
+    return smiles_;
+  }
+
+private:
+  //! A marked single bond of a stereogenic double bond in writing order
+  struct MarkedBond {
+    AtomIndex first;
+    AtomIndex second;
+    unsigned stereoBond;
+  };
+
+  static AtomIndex other(const BondIndex& bond, const AtomIndex i) {
+    return (bond.first == i) ? bond.second : bond.first;
+  }
+
+  void buildTree_(const AtomIndex i, std::vector<bool>& visited) {
+    visited.at(i) = true;
+    std::vector<AtomIndex> adjacents;
+    for(const AtomIndex j : graph_.adjacents(i)) {
+      if(!suppressed_.at(j) && parent_.at(i) != j) {
+        adjacents.push_back(j);
+      }
+    }
+    std::sort(std::begin(adjacents), std::end(adjacents));
+
+    for(const AtomIndex j : adjacents) {
+      if(visited.at(j)) {
+        if(ringBonds_.count(BondIndex {i, j}) == 0) {
+          ringBonds_.emplace(i, j);
+          ringPartners_.at(i).push_back(j);
+          ringPartners_.at(j).push_back(i);
+        }
+        continue;
+      }
+
+      parent_.at(j) = i;
+      children_.at(i).push_back(j);
+      buildTree_(j, visited);
+    }
+  }
+
+  bool isChild_(const AtomIndex parent, const AtomIndex child) const {
+    return parent_.at(child) == parent;
+  }
+
+  bool singleBonded_(const AtomIndex a, const AtomIndex b) const {
+    return graph_.bondType(BondIndex {a, b}) == BondType::Single;
+  }
+
+  void moveToFront_(const AtomIndex parent, const AtomIndex child) {
+    auto& children = children_.at(parent);
+    auto iter = std::find(std::begin(children), std::end(children), child);
+    assert(iter != std::end(children));
+    std::rotate(std::begin(children), iter, iter + 1);
+  }
+
+  //! Determines writing order of atoms
+  void setPositions_() {
+    unsigned position = 0;
+    std::vector<AtomIndex> stack {root_};
+    while(!stack.empty()) {
+      const AtomIndex i = stack.back();
+      stack.pop_back();
+      position_.at(i) = position++;
+      const auto& children = children_.at(i);
+      std::copy(children.rbegin(), children.rend(), std::back_inserter(stack));
+    }
+  }
+
+  //! Marked bonds in the order the parser encounters them
+  std::vector<MarkedBond> markedBonds_() const {
+    std::vector<AtomIndex> writingOrder;
+    for(AtomIndex i = 0; i < graph_.N(); ++i) {
+      if(!suppressed_.at(i)) {
+        writingOrder.push_back(i);
+      }
+    }
+    std::sort(
+      std::begin(writingOrder),
+      std::end(writingOrder),
+      [&](const AtomIndex a, const AtomIndex b) { return position_.at(a) < position_.at(b); }
+    );
+
+    std::vector<MarkedBond> marked;
+    for(const AtomIndex i : writingOrder) {
+      if(markedFor_.at(i) >= 0) {
+        marked.push_back(
+          MarkedBond {parent_.at(i).value(), i, static_cast<unsigned>(markedFor_.at(i))}
+        );
+      }
+    }
+    return marked;
+  }
+
+  /*! @brief Finds the first stereo bond whose markers the parser would group
+   *   differently than intended
+   *
+   * Mirrors the marker grouping of MoleculeBuilder::setBondStereo
+   */
+  boost::optional<unsigned> misgroupedStereoBond_() const {
+    const auto marked = markedBonds_();
+    const unsigned M = marked.size();
+    auto doubleBonded = [&](const AtomIndex a, const AtomIndex b) -> bool {
+      const auto bondOption = graph_.bond(a, b);
+      return bondOption && graph_.bondType(*bondOption) == BondType::Double;
+    };
+
+    unsigned i = 0;
+    while(i < M) {
+      const MarkedBond& leftMarker = marked.at(i);
+      const BondIndex& stereoBond = stereoBonds_.at(leftMarker.stereoBond);
+      unsigned j = i + 1;
+
+      boost::optional<AtomIndex> left;
+      if(j < M && (marked.at(j).first == leftMarker.first || marked.at(j).first == leftMarker.second)) {
+        left = marked.at(j).first;
+        ++j;
+      }
+      if(j >= M) {
+        return leftMarker.stereoBond;
+      }
+
+      const AtomIndex right = marked.at(j).first;
+      if(!left) {
+        if(doubleBonded(leftMarker.first, right)) {
+          left = leftMarker.first;
+        } else if(doubleBonded(leftMarker.second, right)) {
+          left = leftMarker.second;
+        } else {
+          return leftMarker.stereoBond;
+        }
+      }
+      ++j;
+      if(j < M && marked.at(j).first == right) {
+        ++j;
+      }
+
+      const bool intended = (
+        j - i == 2
+        && marked.at(i + 1).stereoBond == leftMarker.stereoBond
+        && BondIndex {left.value(), right} == stereoBond
+        && parent_.at(right) == left.value()
+      );
+      if(!intended) {
+        return leftMarker.stereoBond;
+      }
+
+      i = j;
+    }
+
+    return boost::none;
+  }
+
+  /*! @brief Marks one bond on each side of stereogenic double bonds
+   *
+   * Each double bond L=R written in the spanning tree is marked on a bond of L
+   * written immediately before R and a bond of R written immediately after
+   * it, which the parser groups together. Double bonds for which no such
+   * bonds are available are left unmarked.
+   */
+  void placeBondMarkers_() {
+    const unsigned B = stereoBonds_.size();
+    std::vector<bool> inMarkedStereoBond(graph_.N(), false);
+    std::vector<AtomIndex> rightMarked(B);
+    std::vector<AtomIndex> leftMarked(B);
+    std::vector<bool> marked(B, false);
+
+    for(unsigned k = 0; k < B; ++k) {
+      AtomIndex left = stereoBonds_.at(k).first;
+      AtomIndex right = stereoBonds_.at(k).second;
+      if(isChild_(right, left)) {
+        std::swap(left, right);
+      }
+
+      if(
+        !isChild_(left, right)
+        || inMarkedStereoBond.at(left)
+        || inMarkedStereoBond.at(right)
+      ) {
+        continue;
+      }
+
+      // Right of the bond, mark a child of R
+      const auto& rightChildren = children_.at(right);
+      const auto rightIter = std::find_if(
+        std::begin(rightChildren),
+        std::end(rightChildren),
+        [&](const AtomIndex i) { return markedFor_.at(i) < 0 && singleBonded_(right, i); }
+      );
+      if(rightIter == std::end(rightChildren)) {
+        continue;
+      }
+
+      // Left of the bond, mark the bond to the parent of L or a leaf child
+      boost::optional<AtomIndex> leftLeaf;
+      if(!(parent_.at(left) && markedFor_.at(left) < 0 && singleBonded_(*parent_.at(left), left))) {
+        for(const AtomIndex i : children_.at(left)) {
+          if(
+            i != right
+            && children_.at(i).empty()
+            && markedFor_.at(i) < 0
+            && singleBonded_(left, i)
+          ) {
+            leftLeaf = i;
+            break;
+          }
+        }
+        if(!leftLeaf) {
+          continue;
+        }
+      }
+
+      rightMarked.at(k) = *rightIter;
+      leftMarked.at(k) = leftLeaf.value_or(left);
+      markedFor_.at(rightMarked.at(k)) = k;
+      markedFor_.at(leftMarked.at(k)) = k;
+      marked.at(k) = true;
+      inMarkedStereoBond.at(left) = true;
+      inMarkedStereoBond.at(right) = true;
+
+      moveToFront_(right, *rightIter);
+      moveToFront_(left, right);
+      if(leftLeaf) {
+        moveToFront_(left, *leftLeaf);
+      }
+    }
+
+    setPositions_();
+
+    // Drop markers until the parser's grouping matches
+    while(auto misgroupedOption = misgroupedStereoBond_()) {
+      const unsigned k = *misgroupedOption;
+      markedFor_.at(leftMarked.at(k)) = -1;
+      markedFor_.at(rightMarked.at(k)) = -1;
+      marked.at(k) = false;
+    }
+
+    // Choose marker directions by trial of the parser's interpretation
+    const std::vector<PrivateGraph::Vertex> identity = Temple::iota<PrivateGraph::Vertex>(graph_.N());
+    for(unsigned k = 0; k < B; ++k) {
+      if(!marked.at(k)) {
+        continue;
+      }
+
+      const BondStereopermutator& permutator = molecule_.stereopermutators().option(stereoBonds_.at(k)).value();
+      const AtomIndex leftChild = leftMarked.at(k);
+      const AtomIndex right = parent_.at(rightMarked.at(k)).value();
+      const AtomIndex left = parent_.at(right).value();
+
+      SmilesBondStereo state;
+      state.left = left;
+      state.right = right;
+      // A forward marker on the bond of L and its child marks the child up
+      if(leftChild != left) {
+        state.upOfLeft = leftChild;
+      } else {
+        state.downOfLeft = parent_.at(left).value();
+      }
+      markers_.at(leftChild) = BondData::StereoMarker::Forward;
+
+      state.upOfRight = rightMarked.at(k);
+      if(state.findAssignment(permutator, molecule_, identity) == permutator.assigned().value()) {
+        markers_.at(rightMarked.at(k)) = BondData::StereoMarker::Forward;
+      } else {
+        markers_.at(rightMarked.at(k)) = BondData::StereoMarker::Backward;
+      }
+    }
+
+    for(auto& partners : ringPartners_) {
+      std::sort(
+        std::begin(partners),
+        std::end(partners),
+        [&](const AtomIndex a, const AtomIndex b) { return position_.at(a) < position_.at(b); }
+      );
+    }
+  }
+
+  /*! @brief Finds chiral markers for stereocenters
+   *
+   * Mirrors MoleculeBuilder::setAtomStereo: Sites are ordered by the writing
+   * position of their atoms and mapped onto shape vertices for each of the
+   * shape's chiral indices in turn.
+   */
+  void setChiralStrings_(const std::vector<bool>& stereocenter) {
+    for(const AtomStereopermutator& permutator : molecule_.stereopermutators().atomStereopermutators()) {
+      const AtomIndex i = permutator.placement();
+      const Shapes::Shape shape = permutator.getShape();
+      const unsigned K = chiralIndexCount(shape);
+      const RankingInformation& ranking = permutator.getRanking();
+      if(
+        !stereocenter.at(i)
+        || K == 0
+        || !Temple::all_of(ranking.sites, [](const auto& site) { return site.size() == 1; })
+      ) {
+        continue;
+      }
+
+      const unsigned S = Shapes::size(shape);
+      const std::vector<SiteIndex> sortedSites = Temple::sorted(
+        Temple::iota<SiteIndex>(S),
+        [&](const SiteIndex a, const SiteIndex b) -> bool {
+          return position_.at(ranking.sites.at(a).front()) < position_.at(ranking.sites.at(b).front());
+        }
+      );
+
+      const auto& abstract = permutator.getAbstract();
+      const auto& stereopermutation = abstract.permutations->list.at(
+        permutator.indexOfPermutation().value()
+      );
+
+      for(unsigned chiralIndex = 1; chiralIndex <= K; ++chiralIndex) {
+        const ChiralData chiralData {shape, chiralIndex};
+        const auto vertexMap = Shapes::Properties::inverseRotation(
+          MoleculeBuilder::shapeMap(chiralData)
+        );
+        SiteToShapeVertexMap siteToShapeVertexMap;
+        siteToShapeVertexMap.resize(S);
+        for(unsigned j = 0; j < S; ++j) {
+          siteToShapeVertexMap.at(sortedSites.at(j)) = vertexMap.at(j);
+        }
+
+        const auto soughtStereopermutation = stereopermutationFromSiteToShapeVertexMap(
+          siteToShapeVertexMap,
+          ranking.links,
+          abstract.canonicalSites
+        );
+
+        if(Stereopermutations::rotationallySuperimposable(soughtStereopermutation, stereopermutation, shape)) {
+          chiralStrings_.at(i) = chiralString(chiralData);
+          break;
+        }
+      }
+    }
+  }
+
+  std::string atomString_(const AtomIndex i) const {
+    const Utils::ElementType e = graph_.elementType(i);
+    const Utils::ElementType base = Utils::ElementInfo::element(Utils::ElementInfo::Z(e));
+    const std::string symbol = Utils::ElementInfo::symbol(base);
+
+    // Organic subset atoms are written without brackets if valence filling
+    // yields their hydrogen count
+    if(
+      e == base
+      && chiralStrings_.at(i).empty()
+      && MoleculeBuilder::isValenceFillElement(e)
+    ) {
+      int valence = 0;
+      for(const BondIndex& bond : graph_.bonds(i)) {
+        if(!suppressed_.at(other(bond, i))) {
+          valence += Bond::bondOrderMap.at(
+            static_cast<unsigned>(graph_.bondType(bond))
+          );
+        }
+      }
+
+      if(MoleculeBuilder::valenceFillElementImplicitHydrogenCount(valence, e) == hydrogenCount_.at(i)) {
+        return symbol;
+      }
+    }
+
+    std::string atom = "[";
+    if(e != base) {
+      atom += std::to_string(Utils::ElementInfo::A(e));
+    }
+    atom += symbol;
+    atom += chiralStrings_.at(i);
+    if(hydrogenCount_.at(i) > 0) {
+      atom += "H";
+      if(hydrogenCount_.at(i) > 1) {
+        atom += std::to_string(hydrogenCount_.at(i));
+      }
+    }
+    atom += "]";
+    return atom;
+  }
+
+  void emit_(
+    const AtomIndex i,
+    std::vector<bool>& ringNumberInUse,
+    std::map<BondIndex, unsigned>& ringNumbers
+  ) {
+    smiles_ += atomString_(i);
+
+    // Close rings first, then open new ones
+    std::vector<unsigned> closedNumbers;
+    for(const AtomIndex j : ringPartners_.at(i)) {
+      if(position_.at(j) < position_.at(i)) {
+        const unsigned number = ringNumbers.at(BondIndex {i, j});
+        smiles_ += ringNumberString(number);
+        closedNumbers.push_back(number);
+      }
+    }
+    for(const AtomIndex j : ringPartners_.at(i)) {
+      if(position_.at(j) > position_.at(i)) {
+        const auto freeIter = std::find(std::begin(ringNumberInUse) + 1, std::end(ringNumberInUse), false);
+        if(freeIter == std::end(ringNumberInUse)) {
+          throw std::invalid_argument("Too many simultaneously open rings for smiles ring closure numbers");
+        }
+        *freeIter = true;
+        const unsigned number = freeIter - std::begin(ringNumberInUse);
+        const BondIndex bond {i, j};
+        ringNumbers.emplace(bond, number);
+        smiles_ += bondString(graph_.bondType(bond));
+        smiles_ += ringNumberString(number);
+      }
+    }
+    for(const unsigned number : closedNumbers) {
+      ringNumberInUse.at(number) = false;
+    }
+
+    // All but the last child are written as branches
+    const auto& children = children_.at(i);
+    const unsigned C = children.size();
+    for(unsigned c = 0; c < C; ++c) {
+      const AtomIndex j = children.at(c);
+      const bool branch = (c + 1 < C);
+      if(branch) {
+        smiles_ += "(";
+      }
+      if(markers_.at(j)) {
+        smiles_ += (markers_.at(j).value() == BondData::StereoMarker::Forward) ? "/" : "\\";
+      } else {
+        smiles_ += bondString(graph_.bondType(BondIndex {i, j}));
+      }
+      emit_(j, ringNumberInUse, ringNumbers);
+      if(branch) {
+        smiles_ += ")";
+      }
+    }
+  }
+
+  const Molecule& molecule_;
+  const Graph& graph_;
+  //! Hydrogen atoms expressed as hydrogen counts of their bonded atom
+  std::vector<bool> suppressed_;
+  std::vector<unsigned> hydrogenCount_;
+  AtomIndex root_ = 0;
+  //! Spanning tree
+  std::vector<boost::optional<AtomIndex>> parent_;
+  std::vector<std::vector<AtomIndex>> children_;
+  //! Bonds not in the spanning tree, written as ring closures
+  std::set<BondIndex> ringBonds_;
+  std::vector<std::vector<AtomIndex>> ringPartners_;
+  //! Writing order position of each atom
+  std::vector<unsigned> position_;
+  //! Assigned, stereogenic double bonds
+  std::vector<BondIndex> stereoBonds_;
+  //! Index of the stereo bond the bond to an atom's parent marks, if any
+  std::vector<int> markedFor_;
+  //! Stereo marker on the bond to an atom's parent
+  std::vector<boost::optional<BondData::StereoMarker>> markers_;
+  std::vector<std::string> chiralStrings_;
+  std::string smiles_;
+};
+
+} // namespace
+
+namespace Experimental {
+
+std::string emitCanonicalSmiles(const Molecule& molecule) {
+  if(molecule.canonicalComponents() == AtomEnvironmentComponents::All) {
+    return Emitter {molecule}.emit();
+  }
+
+  Molecule canonical = molecule;
+  canonical.canonicalize(AtomEnvironmentComponents::All);
+  return Emitter {canonical}.emit();
+}
+
+} // namespace Experimental
+} // namespace IO
+} // namespace Molassembler
+} // namespace Scine
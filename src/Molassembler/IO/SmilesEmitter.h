@@ -0,0 +1,65 @@
+/*!@file
+ * @copyright This code is licensed under the 3-clause BSD license.
+ *   Copyright ETH Zurich, Laboratory of Physical Chemistry, Reiher Group.
+ *   See LICENSE.txt for details.
+ * @brief Emit canonical SMILES strings from molecules
+ */
+#ifndef INCLUDE_MOLASSEMBLER_IO_SMILES_EMITTER_H
+#define INCLUDE_MOLASSEMBLER_IO_SMILES_EMITTER_H
+
+#include "Molassembler/Export.h"
+#include <string>
+
+namespace Scine {
+namespace Molassembler {
+
+class Molecule;
+
+namespace IO {
+namespace Experimental {
+
+/**
+ * @brief Emit a canonical smiles string for a molecule
+ *
+ * The string is written from the fully canonical form of the molecule, so
+ * molecules that compare equal yield identical strings and the strings can be
+ * used as hashable identity keys. The emitter supports the following features:
+ * - Isotope markers
+ * - Hydrogen counts and valence filling of the organic subset
+ * - Ring closures (in Kekulé form, there are no aromatic symbols)
+ * - Stereo markers
+ *   - Double bond
+ *   - Tetrahedral (\@ / \@\@)
+ *   - Square planar (\@SP1 - \@SP3)
+ *   - Trigonal bipyramidal (\@TB1 - \@TB20)
+ *   - Octahedral (\@OH1 - \@OH30)
+ *
+ * Stereo markers follow the conventions of parseSmiles, so that parsing the
+ * emitted string yields a molecule equal to the passed one wherever smiles
+ * can express its features. Hydrogen atoms bonded to stereocenters and to
+ * stereogenic double bonds are written explicitly, and neighbors of
+ * stereocenters are ordered by their appearance in the string, also if
+ * bonded by ring closures.
+ *
+ * @warning Not expressible are: charges, shapes of non-stereogenic atoms,
+ * stereo of haptic ligands and of double bonds without a distinct pair of
+ * markable bonds, e.g. in some conjugated or cyclic systems.
+ *
+ * @complexity{@math{\Theta(N + B)} if the molecule is canonical, otherwise
+ * as Molecule::canonicalize}
+ *
+ * @param molecule The molecule to write
+ *
+ * @throws std::invalid_argument If the molecule contains quintuple or
+ *   sextuple bonds
+ *
+ * @return A canonical smiles string
+ */
+MASM_EXPORT std::string emitCanonicalSmiles(const Molecule& molecule);
+
+} // namespace Experimental
+} // namespace IO
+} // namespace Molassembler
+} // namespace Scine
+
+#endif
@@ -453,11 +453,11 @@ void MoleculeBuilder::setAtomStereo(
     );
 
     auto soughtRotations = Stereopermutations::generateAllRotations(soughtStereopermutation, chiralData.shape);
-    const auto& assignables = permutator.getFeasible().indices;
+    const auto& assignables = permutator.getFeasible().indices();
     auto assignmentIter = Temple::find_if(
       assignables,
       [&](const unsigned stereopermutationIndex) -> bool {
-        const auto& stereopermutation = permutator.getAbstract().permutations.list.at(stereopermutationIndex);
+        const auto& stereopermutation = permutator.getAbstract().permutations->list.at(stereopermutationIndex);
         return Temple::find(soughtRotations, stereopermutation) != std::end(soughtRotations);
       }
     );
@@ -672,12 +672,14 @@ void MoleculeBuilder::setBondStereo(
   }
 }
 
-std::vector<Molecule> MoleculeBuilder::interpret() {
+std::vector<PrivateGraph> MoleculeBuilder::splitComponents(
+  std::vector<unsigned>& componentMap,
+  std::vector<PrivateGraph::Vertex>& indexInComponentMap
+) const {
   if(!ringClosures.empty()) {
     throw std::runtime_error("Unmatched ring closure markers remain!");
   }
 
-  std::vector<unsigned> componentMap;
   const unsigned M = graph.connectedComponents(componentMap);
 
   std::vector<PrivateGraph> precursors;
@@ -685,7 +687,7 @@ std::vector<Molecule> MoleculeBuilder::interpret() {
 
   const unsigned N = graph.N();
 
-  std::vector<PrivateGraph::Vertex> indexInComponentMap(N);
+  indexInComponentMap.resize(N);
   // Copy vertices
   for(unsigned i = 0; i < N; ++i) {
     auto& precursor = precursors.at(componentMap.at(i));
@@ -749,9 +751,17 @@ std::vector<Molecule> MoleculeBuilder::interpret() {
     }
   }
 
+  return precursors;
+}
+
+std::vector<Molecule> MoleculeBuilder::interpret() {
+  std::vector<unsigned> componentMap;
+  std::vector<PrivateGraph::Vertex> indexInComponentMap;
+  auto precursors = splitComponents(componentMap, indexInComponentMap);
+
   /* Convert the graphs to molecules */
   std::vector<Molecule> molecules;
-  molecules.reserve(M);
+  molecules.reserve(precursors.size());
   for(auto&& precursor : precursors) {
     molecules.emplace_back(
       Graph(std::move(precursor))
@@ -766,6 +776,30 @@ std::vector<Molecule> MoleculeBuilder::interpret() {
   return molecules;
 }
 
+std::vector<Graph> MoleculeBuilder::interpretConstitution() {
+  std::vector<unsigned> componentMap;
+  std::vector<PrivateGraph::Vertex> indexInComponentMap;
+  auto precursors = splitComponents(componentMap, indexInComponentMap);
+
+  std::vector<Graph> graphs;
+  graphs.reserve(precursors.size());
+  for(auto&& precursor : precursors) {
+    graphs.emplace_back(std::move(precursor));
+  }
+  return graphs;
+}
+
+void MoleculeBuilder::clear() {
+  lastBondData = SimpleLastBondData::Unbonded;
+  graph = PrivateGraph {};
+  while(!vertexStack.empty()) {
+    vertexStack.pop();
+  }
+  stereoMarkedBonds.clear();
+  ringClosures.clear();
+  vertexData.clear();
+}
+
 } // namespace IO
 } // namespace Molassembler
 } // namespace Scine
@@ -23,6 +23,7 @@ enum class ElementType : unsigned;
 
 namespace Molassembler {
 
+class Graph;
 class Molecule;
 
 namespace IO {
@@ -69,8 +70,21 @@ public:
   //! @brief Interpret the collected graph as (possibly multiple molecules)
   std::vector<Molecule> interpret();
 
-private:
-//!@name Static private members
+  /*! @brief Interpret only the constitution of the collected graph
+   *
+   * Skips the ranking and stereopermutator instantiation of molecule
+   * construction, and ignores stereo markers.
+   */
+  std::vector<Graph> interpretConstitution();
+
+  /*! @brief Reset to the state before parsing
+   *
+   * Allows a builder to be reused across parses, retaining the capacity of
+   * its buffers.
+   */
+  void clear();
+
+//!@name Interpretation conventions, shared with the SMILES emitter
 //!@{
   //! Checks whether an element type is valence filled
   static bool isValenceFillElement(Utils::ElementType e);
@@ -81,6 +95,13 @@ private:
     Utils::ElementType e
   );
 
+  //! Fetches a map to help with the atom chiral markers
+  static std::vector<Shapes::Vertex> shapeMap(const ChiralData& chiralData);
+//!@}
+
+private:
+//!@name Static private members
+//!@{
   /*! Determines the mutual bond type of two bond type optionals
    *
    * @throws std::runtime_error If the bond types are mismatched
@@ -89,13 +110,20 @@ private:
     const boost::optional<BondType>& a,
     const boost::optional<BondType>& b
   );
-
-  //! Fetches a map to help with the atom chiral markers
-  static std::vector<Shapes::Vertex> shapeMap(const ChiralData& chiralData);
 //!@}
 
 //!@name Private member functions
 //!@{
+  /*! @brief Split the collected graph into its connected components and
+   *   fill valences
+   *
+   * @throws std::runtime_error If unmatched ring closure markers remain
+   */
+  std::vector<PrivateGraph> splitComponents(
+    std::vector<unsigned>& componentMap,
+    std::vector<PrivateGraph::Vertex>& indexInComponentMap
+  ) const;
+
   //! @brief Set shapes according to specified charges and stereo markers
   void setShapes(
     std::vector<Molecule>& molecules,
@@ -9,11 +9,17 @@
 #include <boost/spirit/include/phoenix_operator.hpp>
 #include <boost/spirit/include/phoenix.hpp>
 #include <boost/phoenix/fusion/at.hpp>
+#include <boost/optional.hpp>
 
 #include "Molassembler/IO/SmilesParseData.h"
 #include "Molassembler/IO/SmilesMoleculeBuilder.h"
+#include "Molassembler/Graph.h"
 #include "Molassembler/Molecule.h"
+#include "Molassembler/Temple/Functional.h"
 
+#include <algorithm>
+#include <exception>
+#include <fstream>
 #include <iostream>
 
 /* TODO
@@ -331,23 +337,48 @@ struct openSMILES : qi::grammar<Iterator> {
 
 namespace Experimental {
 
-std::vector<Molecule> parseSmiles(const std::string& smiles) {
-  auto iter = std::begin(smiles);
-  const auto end = std::end(smiles);
+namespace {
 
+/*! @brief Parse a smiles string and interpret the builder's state
+ *
+ * The grammar is costly to construct, so each thread keeps an instance whose
+ * builder is cleared and reused across parses.
+ */
+template<typename F>
+auto parseWithBuilder(const std::string& smiles, F&& interpret) {
   using Iterator = std::string::const_iterator;
   using Parser = openSMILES<Iterator>;
 
-  Parser parser;
+  thread_local Parser parser;
+  parser.builder.clear();
+
+  auto iter = std::begin(smiles);
+  const auto end = std::end(smiles);
   bool result = qi::parse(iter, end, parser);
 
   if(result && iter == end) {
-    return parser.builder.interpret();
+    return interpret(parser.builder);
   }
 
   throw std::runtime_error("Failed to parse SMILES");
 }
 
+} // namespace
+
+std::vector<Molecule> parseSmiles(const std::string& smiles) {
+  return parseWithBuilder(
+    smiles,
+    [](MoleculeBuilder& builder) { return builder.interpret(); }
+  );
+}
+
+std::vector<Graph> parseSmilesConstitution(const std::string& smiles) {
+  return parseWithBuilder(
+    smiles,
+    [](MoleculeBuilder& builder) { return builder.interpretConstitution(); }
+  );
+}
+
 Molecule parseSmilesSingleMolecule(const std::string& smiles) {
   auto results = parseSmiles(smiles);
 
@@ -358,6 +389,87 @@ Molecule parseSmilesSingleMolecule(const std::string& smiles) {
   return results.front();
 }
 
+std::vector<Molecule> parseSmilesSingleMolecules(
+  const std::vector<std::string>& smiles
+) {
+  const unsigned S = smiles.size();
+  std::vector<boost::optional<Molecule>> molecules(S);
+  std::vector<std::exception_ptr> exceptions(S);
+
+#pragma omp parallel for schedule(dynamic)
+  for(unsigned i = 0; i < S; ++i) {
+    try {
+      molecules[i] = parseSmilesSingleMolecule(smiles[i]);
+    } catch(...) {
+      exceptions[i] = std::current_exception();
+    }
+  }
+
+  // Rethrow in input order so that the reported error is reproducible
+  for(const std::exception_ptr& exception : exceptions) {
+    if(exception) {
+      std::rethrow_exception(exception);
+    }
+  }
+
+  return Temple::map(molecules, [](auto&& x) { return std::move(x.value()); });
+}
+
+void parseSmilesFile(
+  const std::string& filename,
+  const std::function<void(SmilesFileLine)>& callback,
+  const unsigned linesPerChunk
+) {
+  std::ifstream file(filename);
+  if(!file) {
+    throw std::runtime_error("Could not open " + filename + " for reading");
+  }
+
+  std::vector<std::string> smiles;
+  std::vector<SmilesFileLine> chunk;
+  smiles.reserve(linesPerChunk);
+  chunk.reserve(linesPerChunk);
+
+  unsigned lineNumber = 0;
+  std::string line;
+  while(file) {
+    // Split off a chunk of non-empty lines
+    while(chunk.size() < std::max(linesPerChunk, 1u) && std::getline(file, line)) {
+      ++lineNumber;
+      if(!line.empty() && line.back() == '\r') {
+        line.pop_back();
+      }
+
+      const auto smilesBegin = line.find_first_not_of(" \t");
+      if(smilesBegin == std::string::npos) {
+        continue;
+      }
+      const auto smilesEnd = std::min(line.find_first_of(" \t", smilesBegin), line.size());
+      const auto titleBegin = std::min(line.find_first_not_of(" \t", smilesEnd), line.size());
+
+      smiles.push_back(line.substr(smilesBegin, smilesEnd - smilesBegin));
+      chunk.push_back(SmilesFileLine {lineNumber, line.substr(titleBegin), {}, {}});
+    }
+
+    const unsigned C = chunk.size();
+#pragma omp parallel for schedule(dynamic)
+    for(unsigned i = 0; i < C; ++i) {
+      try {
+        chunk[i].molecules = parseSmiles(smiles[i]);
+      } catch(std::exception& e) {
+        chunk[i].error = e.what();
+      }
+    }
+
+    for(SmilesFileLine& parsed : chunk) {
+      callback(std::move(parsed));
+    }
+
+    smiles.clear();
+    chunk.clear();
+  }
+}
+
 } // namespace Experimental
 } // namespace IO
 } // namespace Molassembler
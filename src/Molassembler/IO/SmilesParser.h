@@ -8,6 +8,8 @@
 #define INCLUDE_MOLASSEMBLER_IO_SMILES_PARSER_H
 
 #include "Molassembler/Export.h"
+#include "Molassembler/Molecule.h"
+#include <functional>
 #include <string>
 #include <vector>
 
@@ -16,6 +18,8 @@ namespace Molassembler {
 
 class Molecule;
 
+class Graph;
+
 namespace IO {
 namespace Experimental {
 
@@ -74,6 +78,92 @@ MASM_EXPORT std::vector<Molecule> parseSmiles(const std::string& smiles);
  */
 MASM_EXPORT Molecule parseSmilesSingleMolecule(const std::string& smiles);
 
+/**
+ * @brief Parse many smiles strings each containing a single molecule
+ *
+ * Equivalent to calling parseSmilesSingleMolecule on each string.
+ *
+ * @parblock @note This function is parallelized. Use the OMP_NUM_THREADS
+ * environment variable to control the number of threads used.
+ * @endparblock
+ *
+ * @param smiles The smiles strings, each containing only a single molecule
+ *
+ * @throws std::logic_error If there are multiple molecules in a string
+ * @throws std::runtime_error If there are errors parsing a string. If several
+ *   strings cannot be parsed, the error of the first of them is thrown.
+ *
+ * @return A molecule for each smiles string
+ */
+MASM_EXPORT std::vector<Molecule> parseSmilesSingleMolecules(
+  const std::vector<std::string>& smiles
+);
+
+/**
+ * @brief Parse only the constitution of the molecules in a smiles string
+ *
+ * Parses as parseSmiles(), including valence filling of the organic subset,
+ * but returns graphs instead of molecules. This skips ranking and
+ * stereopermutator instantiation, which dominate the cost of parsing. Stereo
+ * markers are accepted, but ignored.
+ *
+ * @param smiles the smiles string to parse containing possibly multiple
+ *   molecules
+ * @throws std::runtime_error If there are errors parsing the smiles string
+ *
+ * @return A graph for each molecule in the string
+ */
+MASM_EXPORT std::vector<Graph> parseSmilesConstitution(const std::string& smiles);
+
+//! Parse result of a line of a SMILES file
+struct MASM_EXPORT SmilesFileLine {
+  //! One-based line number in the file
+  unsigned lineNumber;
+  //! Text following the SMILES on the line, e.g. a compound identifier
+  std::string title;
+  //! Parsed molecules, empty if parsing failed
+  std::vector<Molecule> molecules;
+  //! Parse error message, empty if parsing succeeded
+  std::string error;
+};
+
+/**
+ * @brief Parse a SMILES file line by line in parallel
+ *
+ * Each non-empty line of the file is expected to contain a SMILES string,
+ * optionally followed by whitespace and a title. The file is read in chunks
+ * of lines, each of which is parsed in parallel before the results are
+ * passed to @p callback in file order. Only a single chunk is held in memory
+ * at a time.
+ *
+ * Errors parsing a line do not end parsing of the file, but are reported in
+ * SmilesFileLine::error.
+ *
+ * @code{cpp}
+ * IO::Experimental::parseSmilesFile("catalog.smi", [](SmilesFileLine line) {
+ *   if(!line.error.empty()) {
+ *     std::cerr << "Line " << line.lineNumber << ": " << line.error << "\n";
+ *   }
+ * });
+ * @endcode
+ *
+ * @parblock @note This function is parallelized. Use the OMP_NUM_THREADS
+ * environment variable to control the number of threads used.
+ * @endparblock
+ *
+ * @param filename Path to the SMILES file
+ * @param callback Function called with the parse result of each non-empty
+ *   line, in file order and from the calling thread
+ * @param linesPerChunk Number of lines parsed in parallel at a time
+ *
+ * @throws std::runtime_error If the file cannot be opened
+ */
+MASM_EXPORT void parseSmilesFile(
+  const std::string& filename,
+  const std::function<void(SmilesFileLine)>& callback,
+  unsigned linesPerChunk = 4096
+);
+
 } // namespace Experimental
 } // namespace IO
 } // namespace Molassembler
@@ -0,0 +1,359 @@
+/*!@file
+ * @copyright This code is licensed under the 3-clause BSD license.
+ *   Copyright ETH Zurich, Laboratory of Physical Chemistry, Reiher Group.
+ *   See LICENSE.txt for details.
+ */
+
+#include "Molassembler/IO.h"
+
+#include "Molassembler/Graph.h"
+#include "Molassembler/Molecule.h"
+#include "Molassembler/Serialization.h"
+
+#include "Utils/Constants.h"
+#include "Utils/Geometry/ElementInfo.h"
+
+#include <algorithm>
+#include <array>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <mutex>
+#include <thread>
+
+namespace Scine {
+namespace Molassembler {
+namespace IO {
+namespace {
+
+const char* skipWhitespace(const char* iter) {
+  while(*iter == ' ' || *iter == '\t') {
+    ++iter;
+  }
+  return iter;
+}
+
+const char* skipToken(const char* iter) {
+  while(*iter != '\0' && *iter != ' ' && *iter != '\t' && *iter != '\r') {
+    ++iter;
+  }
+  return iter;
+}
+
+} // namespace
+
+struct XyzTrajectoryReader::Impl {
+  explicit Impl(const std::string& filename) : file(filename) {
+    if(!file) {
+      throw std::runtime_error("Could not open " + filename + " for reading");
+    }
+  }
+
+  [[noreturn]] void fail(const std::string& message) const {
+    throw std::runtime_error(
+      "XYZ trajectory frame " + std::to_string(count + 1) + ": " + message
+    );
+  }
+
+  bool readFrame(Utils::PositionCollection& positions) {
+    // Skip blank lines between frames
+    do {
+      if(!std::getline(file, line)) {
+        return false;
+      }
+    } while(*skipWhitespace(line.c_str()) == '\0' || line == "\r");
+
+    char* end = nullptr;
+    const long N = std::strtol(line.c_str(), &end, 10);
+    if(end == line.c_str() || N < 0) {
+      fail("Expected number of atoms, got '" + line + "'");
+    }
+
+    if(!std::getline(file, comment)) {
+      fail("Missing comment line");
+    }
+    if(!comment.empty() && comment.back() == '\r') {
+      comment.pop_back();
+    }
+
+    // Buffers keep their storage if the number of atoms is unchanged
+    if(static_cast<long>(elements.size()) != N) {
+      elements.resize(N);
+      symbols.assign(N, std::string {});
+    }
+    if(positions.rows() != N) {
+      positions.resize(N, 3);
+    }
+
+    for(long i = 0; i < N; ++i) {
+      if(!std::getline(file, line)) {
+        fail("Truncated after " + std::to_string(i) + " atoms");
+      }
+
+      const char* symbolBegin = skipWhitespace(line.c_str());
+      const char* symbolEnd = skipToken(symbolBegin);
+      const std::size_t symbolLength = symbolEnd - symbolBegin;
+      if(symbolLength == 0) {
+        fail("Missing element symbol of atom " + std::to_string(i));
+      }
+
+      // Element lookup only for symbols differing from the previous frame
+      std::string& symbol = symbols[i];
+      if(symbol.size() != symbolLength || std::memcmp(symbol.data(), symbolBegin, symbolLength) != 0) {
+        symbol.assign(symbolBegin, symbolLength);
+        try {
+          elements[i] = Utils::ElementInfo::elementTypeForSymbol(symbol);
+        } catch(...) {
+          symbol.clear();
+          fail("Unknown element symbol '" + std::string(symbolBegin, symbolLength) + "'");
+        }
+      }
+
+      const char* iter = symbolEnd;
+      for(unsigned j = 0; j < 3; ++j) {
+        char* coordinateEnd = nullptr;
+        const double value = std::strtod(iter, &coordinateEnd);
+        if(coordinateEnd == iter) {
+          fail("Missing coordinates of atom " + std::to_string(i));
+        }
+        positions(i, j) = value * Utils::Constants::bohr_per_angstrom;
+        iter = coordinateEnd;
+      }
+    }
+
+    ++count;
+    return true;
+  }
+
+  std::ifstream file;
+  //! Line buffer, reused across lines
+  std::string line;
+  std::string comment;
+  Utils::ElementTypeCollection elements;
+  //! Element symbols as they were read, to skip repeated element lookups
+  std::vector<std::string> symbols;
+  Utils::PositionCollection positions;
+  unsigned count = 0;
+};
+
+XyzTrajectoryReader::XyzTrajectoryReader(const std::string& filename)
+  : pImpl_(std::make_unique<Impl>(filename)) {}
+
+XyzTrajectoryReader::XyzTrajectoryReader(XyzTrajectoryReader&& other) noexcept = default;
+XyzTrajectoryReader& XyzTrajectoryReader::operator = (XyzTrajectoryReader&& other) noexcept = default;
+XyzTrajectoryReader::~XyzTrajectoryReader() = default;
+
+bool XyzTrajectoryReader::next() {
+  return pImpl_->readFrame(pImpl_->positions);
+}
+
+bool XyzTrajectoryReader::operator () (Utils::PositionCollection& positions) {
+  return pImpl_->readFrame(positions);
+}
+
+const Utils::ElementTypeCollection& XyzTrajectoryReader::elements() const {
+  return pImpl_->elements;
+}
+
+const Utils::PositionCollection& XyzTrajectoryReader::positions() const {
+  return pImpl_->positions;
+}
+
+const std::string& XyzTrajectoryReader::comment() const {
+  return pImpl_->comment;
+}
+
+unsigned XyzTrajectoryReader::frames() const {
+  return pImpl_->count;
+}
+
+/* AsyncConformerWriter */
+
+struct AsyncConformerWriter::Impl {
+  struct Frame {
+    Utils::PositionCollection positions;
+    std::string comment;
+  };
+
+  Impl(
+    const std::string& filename,
+    const Molecule& molecule,
+    const Format format,
+    const unsigned passCapacity
+  ) : N(molecule.graph().N()),
+      capacity(std::max(passCapacity, 1u))
+  {
+    if(format == Format::Archive) {
+      archive = std::make_unique<ConformerArchiveWriter>(filename, molecule);
+    } else {
+      xyz.open(filename);
+      if(!xyz) {
+        throw std::runtime_error("Could not open " + filename + " for writing");
+      }
+
+      for(const Utils::ElementType e : molecule.graph().elementCollection()) {
+        symbols.push_back(Utils::ElementInfo::symbol(e));
+      }
+    }
+
+    worker = std::thread([this]() { run(); });
+  }
+
+  //! Background thread loop, writing frames until closed and drained
+  void run() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while(true) {
+      notEmpty.wait(lock, [this]() { return !queue.empty() || closing; });
+      if(queue.empty()) {
+        return;
+      }
+
+      Frame frame = std::move(queue.front());
+      queue.pop_front();
+      notFull.notify_one();
+
+      // Skip writing after a failure, but keep draining the queue
+      if(exception) {
+        continue;
+      }
+
+      lock.unlock();
+      try {
+        write(frame);
+      } catch(...) {
+        lock.lock();
+        exception = std::current_exception();
+        continue;
+      }
+      lock.lock();
+    }
+  }
+
+  void write(const Frame& frame) {
+    if(archive) {
+      archive->add(frame.positions);
+      return;
+    }
+
+    // Format into a buffer reused across frames
+    buffer.clear();
+    buffer += std::to_string(N);
+    buffer += '\n';
+    buffer += frame.comment;
+    buffer += '\n';
+    std::array<char, 96> line;
+    for(unsigned i = 0; i < N; ++i) {
+      buffer += symbols[i];
+      std::snprintf(
+        line.data(),
+        line.size(),
+        " %16.10f %16.10f %16.10f\n",
+        frame.positions(i, 0) * Utils::Constants::angstrom_per_bohr,
+        frame.positions(i, 1) * Utils::Constants::angstrom_per_bohr,
+        frame.positions(i, 2) * Utils::Constants::angstrom_per_bohr
+      );
+      buffer += line.data();
+    }
+
+    xyz.write(buffer.data(), buffer.size());
+    if(!xyz) {
+      throw std::runtime_error("Could not write conformer to XYZ file");
+    }
+  }
+
+  void add(Frame frame) {
+    std::unique_lock<std::mutex> lock(mutex);
+    if(closing) {
+      throw std::logic_error("Cannot add conformers to a closed writer");
+    }
+    if(exception) {
+      std::rethrow_exception(exception);
+    }
+
+    notFull.wait(lock, [this]() { return queue.size() < capacity; });
+    queue.push_back(std::move(frame));
+    notEmpty.notify_one();
+  }
+
+  void close() {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      if(closing) {
+        return;
+      }
+      closing = true;
+    }
+    notEmpty.notify_one();
+    worker.join();
+
+    if(archive) {
+      try {
+        archive->close();
+      } catch(...) {
+        if(!exception) {
+          exception = std::current_exception();
+        }
+      }
+    } else {
+      xyz.close();
+    }
+
+    if(exception) {
+      std::rethrow_exception(exception);
+    }
+  }
+
+  const unsigned N;
+  const std::size_t capacity;
+  std::vector<std::string> symbols;
+  std::ofstream xyz;
+  std::unique_ptr<ConformerArchiveWriter> archive;
+  std::string buffer;
+
+  std::mutex mutex;
+  std::condition_variable notEmpty;
+  std::condition_variable notFull;
+  std::deque<Frame> queue;
+  bool closing = false;
+  std::exception_ptr exception;
+  std::thread worker;
+};
+
+AsyncConformerWriter::AsyncConformerWriter(
+  const std::string& filename,
+  const Molecule& molecule,
+  const Format format,
+  const unsigned capacity
+) : pImpl_(std::make_unique<Impl>(filename, molecule, format, capacity)) {}
+
+AsyncConformerWriter::AsyncConformerWriter(AsyncConformerWriter&& other) noexcept = default;
+AsyncConformerWriter& AsyncConformerWriter::operator = (AsyncConformerWriter&& other) noexcept = default;
+
+AsyncConformerWriter::~AsyncConformerWriter() {
+  if(pImpl_) {
+    try {
+      close();
+    } catch(...) {
+      // Destructors must not throw. Call close() to observe failures.
+    }
+  }
+}
+
+void AsyncConformerWriter::add(Utils::PositionCollection positions, std::string comment) {
+  if(static_cast<unsigned>(positions.rows()) != pImpl_->N) {
+    throw std::invalid_argument("Conformer positions do not match the number of atoms");
+  }
+
+  pImpl_->add(Impl::Frame {std::move(positions), std::move(comment)});
+}
+
+void AsyncConformerWriter::close() {
+  pImpl_->close();
+}
+
+} // namespace IO
+} // namespace Molassembler
+} // namespace Scine
@@ -8,6 +8,7 @@
 
 #include "Utils/Geometry/AtomCollection.h"
 #include "Utils/Bonds/BondOrderCollection.h"
+#include "Utils/Geometry/ElementInfo.h"
 
 #include "Molassembler/BondOrders.h"
 #include "Molassembler/Detail/Cartesian.h"
@@ -15,6 +16,7 @@
 #include "Molassembler/Graph/GraphAlgorithms.h"
 #include "Molassembler/Graph/PrivateGraph.h"
 #include "Molassembler/Molecule.h"
+#include "Molassembler/PeriodicCell.h"
 #include "Molassembler/Shapes/ContinuousMeasures.h"
 #include "Molassembler/Temple/Adaptors/AllPairs.h"
 #include "Molassembler/Temple/Functional.h"
@@ -22,6 +24,13 @@
 
 #include <Eigen/Geometry>
 
+#include <algorithm>
+#include <array>
+#include <exception>
+#include <map>
+#include <set>
+#include <tuple>
+
 namespace Scine {
 namespace Molassembler {
 namespace Interpret {
@@ -98,11 +107,10 @@ HapticPlaneGeometry hapticPlaneGeometry(
 }
 
 boost::optional<double> minimumClassificationProbability(
-  const PrivateGraph& graph,
+  const std::vector<std::vector<AtomIndex>>& sites,
   const std::vector<Utils::Position>& positions,
   const AtomIndex v
 ) {
-  auto sites = GraphAlgorithms::sites(graph, v);
   if(sites.size() <= 1) {
     return boost::none;
   }
@@ -118,36 +126,42 @@ boost::optional<double> minimumClassificationProbability(
   }
   sitePositions.col(S) = positions.at(v);
 
-  auto normalizedPositions = Shapes::Continuous::normalize(sitePositions);
+  // Classify all suitable shapes with a single normalization of the site cloud
+  const std::vector<Shapes::Shape>& viableShapes = Shapes::shapesOfSize(S);
+  const auto results = Shapes::Continuous::shapeCentroidLast(
+    {Shapes::Continuous::normalize(sitePositions)},
+    viableShapes
+  ).front();
+
+  boost::optional<double> minimumProbability;
+  for(unsigned i = 0; i < viableShapes.size(); ++i) {
+    const auto probability = Shapes::Continuous::probabilityRandomCloud(
+      results.at(i).measure,
+      viableShapes.at(i)
+    );
 
-  // Classify all suitable shapes
-  std::vector<Shapes::Shape> viableShapes;
-  for(const Shapes::Shape shape : Shapes::allShapes) {
-    if(Shapes::size(shape) == S) {
-      viableShapes.push_back(shape);
+    if(!probability) {
+      return boost::none;
     }
-  }
 
-  const auto classifications = Temple::map(viableShapes,
-    [&](const Shapes::Shape shape) -> boost::optional<double> {
-      const double measure = Shapes::Continuous::shapeCentroidLast(normalizedPositions, shape).measure;
-      return Shapes::Continuous::probabilityRandomCloud(measure, shape);
+    if(!minimumProbability || *probability < *minimumProbability) {
+      minimumProbability = probability;
     }
-  );
-
-  if(Temple::all_of(classifications)) {
-    const double minimumProbability = std::min_element(
-      std::begin(classifications),
-      std::end(classifications),
-      [](const auto& a, const auto& b) -> bool {
-        return a.value() < b.value();
-      }
-    )->value();
-
-    return minimumProbability;
   }
 
-  return boost::none;
+  return minimumProbability;
+}
+
+boost::optional<double> minimumClassificationProbability(
+  const PrivateGraph& graph,
+  const std::vector<Utils::Position>& positions,
+  const AtomIndex v
+) {
+  return minimumClassificationProbability(
+    GraphAlgorithms::sites(graph, v),
+    positions,
+    v
+  );
 }
 
 struct BestRemovals {
@@ -165,37 +179,51 @@ boost::optional<BestRemovals> bestRemovalFromHapticSite(
   const unsigned S = sites.size();
   const std::vector<AtomIndex>& hapticSite = sites.at(hapticSiteIndex);
   const unsigned hapticSiteSize = hapticSite.size();
-  return Temple::accumulate(
-    hapticSite,
-    boost::optional<BestRemovals>(boost::none),
-    [&](const auto& carry, const AtomIndex siteVertexToRemove) -> boost::optional<BestRemovals> {
+
+  // Independent of the candidate removal, so evaluated only once
+  const auto priorCertainty = minimumClassificationProbability(sites, positions, v);
+
+  /* Possible effects of bond removal
+   * - Separating a haptic ligand into two single-atom ligands,
+   *   changing shapes
+   *   - recognizable by size change
+   *   - accept if new certainty is low or significantly
+   *     lower than old (factor 0.5)
+   * - Improves the haptic plane angle by removing a bad bond
+   *   - recognized by matching sites and comparing angles
+   *   - accept if angle halves
+   *
+   * Candidates are evaluated independently and reduced in site order
+   * afterwards so that the result does not depend on scheduling.
+   */
+  struct Outcome {
+    bool splitsSite = false;
+    boost::optional<BestRemovals> removal;
+  };
+
+  std::vector<Outcome> outcomes(hapticSiteSize);
+  std::exception_ptr exception;
+
+#pragma omp parallel for schedule(dynamic)
+  for(unsigned i = 0; i < hapticSiteSize; ++i) {
+    try {
+      const AtomIndex siteVertexToRemove = hapticSite[i];
       auto graphCopy = graph;
       graphCopy.removeEdge(graphCopy.edge(v, siteVertexToRemove));
       GraphAlgorithms::updateEtaBonds(graphCopy);
       const auto newSites = GraphAlgorithms::sites(graphCopy, v);
 
-      /* Possible effects of bond removal
-       * - Separating a haptic ligand into two single-atom ligands,
-       *   changing shapes
-       *   - recognizable by size change
-       *   - accept if new certainty is low or significantly
-       *     lower than old (factor 0.5)
-       * - Improves the haptic plane angle by removing a bad bond
-       *   - recognized by matching sites and comparing angles
-       *   - accept if angle halves
-       *
-       * How to compare cases?
-       */
+      Outcome& outcome = outcomes[i];
       if(newSites.size() > S) {
-        const auto priorCertainty = minimumClassificationProbability(graph, positions, v);
-        const auto posteriorCertainty = minimumClassificationProbability(graphCopy, positions, v);
+        outcome.splitsSite = true;
+        const auto posteriorCertainty = minimumClassificationProbability(newSites, positions, v);
 
         if(priorCertainty && posteriorCertainty) {
           if(
             posteriorCertainty.value() <= 0.01
             || posteriorCertainty.value() <= 0.5 * priorCertainty.value()
           ) {
-            return BestRemovals {{siteVertexToRemove}, 1 - *posteriorCertainty};
+            outcome.removal = BestRemovals {{siteVertexToRemove}, 1 - *posteriorCertainty};
           }
         }
       } else {
@@ -223,19 +251,39 @@ boost::optional<BestRemovals> bestRemovalFromHapticSite(
 
         if(siteFindIter != std::end(newSites)) {
           const double newHapticAngle = hapticPlaneGeometry(positions, v, *siteFindIter).angle;
-          const double newHapticAngleCertainty = 1 - newHapticAngle * 2 / M_PI;
-          const double carryCertainty = Temple::Optionals::map(carry,
-            [](const auto& removal) { return removal.certainty; }
-          ).value_or(0.0);
-          if(newHapticAngleCertainty > carryCertainty) {
-            return BestRemovals {{siteVertexToRemove}, newHapticAngleCertainty};
-          }
+          outcome.removal = BestRemovals {{siteVertexToRemove}, 1 - newHapticAngle * 2 / M_PI};
+        }
+      }
+    } catch(...) {
+#pragma omp critical(bestRemovalException)
+      {
+        if(!exception) {
+          exception = std::current_exception();
         }
       }
+    }
+  }
+
+  if(exception) {
+    std::rethrow_exception(exception);
+  }
 
-      return carry;
+  boost::optional<BestRemovals> best;
+  for(auto& outcome : outcomes) {
+    if(!outcome.removal) {
+      continue;
     }
-  );
+
+    // Accepted site splits always supersede, angle improvements must improve
+    const double bestCertainty = Temple::Optionals::map(best,
+      [](const auto& removal) { return removal.certainty; }
+    ).value_or(0.0);
+    if(outcome.splitsSite || outcome.removal->certainty > bestCertainty) {
+      best = std::move(outcome.removal);
+    }
+  }
+
+  return best;
 }
 
 } // namespace
@@ -322,6 +370,67 @@ unsigned ComponentMap::invert(const ComponentIndexPair& pair) const {
   throw std::out_of_range("No match found in component map!");
 }
 
+ComponentMap::Index::Index(const ComponentMap& componentMap)
+  : components_(componentMap.map),
+    indicesInComponent_(componentMap.size())
+{
+  const unsigned N = components_.size();
+  const unsigned nComponents = N > 0 ? *std::max_element(
+    std::begin(components_),
+    std::end(components_)
+  ) + 1 : 0;
+
+  // Counting sort of the original indices by component
+  starts_.assign(nComponents + 1, 0);
+  for(const unsigned component : components_) {
+    ++starts_.at(component + 1);
+  }
+  for(unsigned c = 0; c < nComponents; ++c) {
+    starts_[c + 1] += starts_[c];
+  }
+
+  atoms_.resize(N);
+  std::vector<unsigned> fill(std::begin(starts_), std::end(starts_) - 1);
+  for(unsigned i = 0; i < N; ++i) {
+    const unsigned component = components_[i];
+    indicesInComponent_[i] = fill[component] - starts_[component];
+    atoms_[fill[component]++] = i;
+  }
+}
+
+ComponentMap::ComponentIndexPair ComponentMap::Index::apply(const unsigned index) const {
+  ComponentIndexPair pair;
+  pair.component = components_.at(index);
+  pair.atomIndex = indicesInComponent_.at(index);
+  return pair;
+}
+
+unsigned ComponentMap::Index::invert(const ComponentIndexPair& pair) const {
+  if(
+    pair.component >= components()
+    || pair.atomIndex >= starts_[pair.component + 1] - starts_[pair.component]
+  ) {
+    throw std::out_of_range("No match found in component map!");
+  }
+
+  return atoms_[starts_[pair.component] + pair.atomIndex];
+}
+
+ComponentMap::Index::AtomRange ComponentMap::Index::atoms(const unsigned component) const {
+  if(component >= components()) {
+    throw std::out_of_range("Component index out of range");
+  }
+
+  return {
+    std::begin(atoms_) + starts_[component],
+    std::begin(atoms_) + starts_[component + 1]
+  };
+}
+
+ComponentMap::Index ComponentMap::index() const {
+  return Index {*this};
+}
+
 struct MoleculeParts {
   PrivateGraph graph;
   std::vector<Utils::Position> angstromPositions;
@@ -336,45 +445,143 @@ struct Parts {
   unsigned nZeroLengthPositions = 0;
 };
 
+/* Sequence of element types, bonds and bond stereopermutator candidates of a
+ * component. Components with equal signatures have identical graphs
+ * including their atom order.
+ */
+std::vector<unsigned> constitutionSignature(const MoleculeParts& precursor) {
+  const PrivateGraph& graph = precursor.graph;
+  std::vector<unsigned> signature;
+  signature.reserve(1 + graph.N() + 3 * graph.B() + 2);
+  signature.push_back(graph.N());
+  for(const PrivateGraph::Vertex i : graph.vertices()) {
+    signature.push_back(Utils::ElementInfo::Z(graph.elementType(i)));
+  }
+
+  std::vector<std::array<unsigned, 3>> bonds;
+  bonds.reserve(graph.B());
+  for(const PrivateGraph::Edge& edge : graph.edges()) {
+    const auto bounds = std::minmax(graph.source(edge), graph.target(edge));
+    bonds.push_back({{
+      static_cast<unsigned>(bounds.first),
+      static_cast<unsigned>(bounds.second),
+      static_cast<unsigned>(graph.bondType(edge))
+    }});
+  }
+  std::sort(std::begin(bonds), std::end(bonds));
+  signature.push_back(bonds.size());
+  for(const auto& bond : bonds) {
+    signature.insert(std::end(signature), std::begin(bond), std::end(bond));
+  }
+
+  if(precursor.bondStereopermutatorCandidatesOptional) {
+    auto candidates = Temple::map(
+      *precursor.bondStereopermutatorCandidatesOptional,
+      [](const BondIndex& bond) { return std::make_pair(bond.first, bond.second); }
+    );
+    std::sort(std::begin(candidates), std::end(candidates));
+    signature.push_back(candidates.size());
+    for(const auto& candidate : candidates) {
+      signature.push_back(candidate.first);
+      signature.push_back(candidate.second);
+    }
+  }
+
+  return signature;
+}
+
 // Yields a graph structure without element type annotations
 PrivateGraph discretize(
   const Utils::BondOrderCollection& bondOrders,
   const BondDiscretizationOption discretization
 ) {
-  const PrivateGraph::Vertex N = bondOrders.getSystemSize();
-  PrivateGraph graph {N};
+  using Edge = std::tuple<PrivateGraph::Vertex, PrivateGraph::Vertex, BondType>;
 
-  if(discretization == BondDiscretizationOption::Binary) {
-    for(unsigned i = 0; i < N; ++i) {
-      for(unsigned j = i + 1; j < N; ++j) {
-        double bondOrder = bondOrders.getOrder(i, j);
+  const PrivateGraph::Vertex N = bondOrders.getSystemSize();
+  const Eigen::SparseMatrix<double>& matrix = bondOrders.getMatrix();
+  const int columns = matrix.outerSize();
+  std::vector<Edge> edges;
+
+  // Only the stored entries of the upper triangle are visited
+#pragma omp parallel
+  {
+    std::vector<Edge> threadEdges;
+
+#pragma omp for schedule(dynamic, 64)
+    for(int j = 0; j < columns; ++j) {
+      for(Eigen::SparseMatrix<double>::InnerIterator iter(matrix, j); iter; ++iter) {
+        const auto i = static_cast<PrivateGraph::Vertex>(iter.row());
+        const double bondOrder = iter.value();
+        if(i >= static_cast<PrivateGraph::Vertex>(j) || bondOrder <= 0.5) {
+          continue;
+        }
 
-        if(bondOrder > 0.5) {
-          graph.addEdge(i, j, BondType::Single);
+        BondType bond = BondType::Single;
+        if(discretization == BondDiscretizationOption::RoundToNearest) {
+          bond = static_cast<BondType>(std::round(bondOrder) - 1);
+          if(bondOrder > 6.5) {
+            bond = BondType::Sextuple;
+          }
         }
+
+        threadEdges.emplace_back(i, j, bond);
       }
     }
-  } else if(discretization == BondDiscretizationOption::RoundToNearest) {
-    for(unsigned i = 0; i < N; ++i) {
-      for(unsigned j = i + 1; j < N; ++j) {
-        double bondOrder = bondOrders.getOrder(i, j);
 
-        if(bondOrder > 0.5) {
-          auto bond = static_cast<BondType>(
-            std::round(bondOrder) - 1
-          );
+#pragma omp critical(discretizeMerge)
+    edges.insert(std::end(edges), std::begin(threadEdges), std::end(threadEdges));
+  }
 
-          if(bondOrder > 6.5) {
-            bond = BondType::Sextuple;
-          }
+  // Edges are added in index order independent of thread scheduling
+  std::sort(std::begin(edges), std::end(edges));
 
-          graph.addEdge(i, j, bond);
+  PrivateGraph graph {N};
+  for(const Edge& edge : edges) {
+    graph.addEdge(std::get<0>(edge), std::get<1>(edge), std::get<2>(edge));
+  }
+
+  return graph;
+}
+
+/* Places each atom of a periodic structure at the minimum image of a bond
+ * partner, breadth-first from the least index atom of each component. Cycles
+ * of extended networks closing through the cell faces cannot be placed
+ * consistently, so their closing bonds remain stretched.
+ */
+Utils::PositionCollection unwrapPositions(
+  const PrivateGraph& graph,
+  const Utils::PositionCollection& positions,
+  const PeriodicCell& cell
+) {
+  const PrivateGraph::Vertex N = graph.N();
+  Utils::PositionCollection unwrapped = positions;
+  std::vector<bool> placed(N, false);
+  std::vector<PrivateGraph::Vertex> queue;
+  queue.reserve(N);
+  for(PrivateGraph::Vertex root = 0; root < N; ++root) {
+    if(placed[root]) {
+      continue;
+    }
+
+    placed[root] = true;
+    queue.clear();
+    queue.push_back(root);
+    for(unsigned k = 0; k < queue.size(); ++k) {
+      const PrivateGraph::Vertex v = queue[k];
+      for(const PrivateGraph::Vertex w : graph.adjacents(v)) {
+        if(placed[w]) {
+          continue;
         }
+
+        placed[w] = true;
+        const Eigen::Vector3d displacement = (positions.row(w) - positions.row(v)).transpose();
+        unwrapped.row(w) = unwrapped.row(v) + cell.minimumImage(displacement).transpose();
+        queue.push_back(w);
       }
     }
   }
 
-  return graph;
+  return unwrapped;
 }
 
 Parts construeParts(
@@ -382,7 +589,8 @@ Parts construeParts(
   const AngstromPositions& angstromWrapper,
   const Utils::BondOrderCollection& bondOrders,
   const BondDiscretizationOption discretization,
-  const boost::optional<double>& stereopermutatorThreshold
+  const boost::optional<double>& stereopermutatorThreshold,
+  const PeriodicCell* const cellPtr = nullptr
 ) {
   const unsigned N = elements.size();
 
@@ -401,6 +609,17 @@ Parts construeParts(
 
   PrivateGraph atomCollectionGraph = discretize(bondOrders, discretization);
 
+  // Components of periodic structures are assembled from wrapped positions
+  Utils::PositionCollection unwrappedPositions;
+  if(cellPtr != nullptr) {
+    unwrappedPositions = unwrapPositions(atomCollectionGraph, angstromWrapper.positions, *cellPtr);
+  }
+  const Utils::PositionCollection& positions = (
+    cellPtr != nullptr
+    ? unwrappedPositions
+    : angstromWrapper.positions
+  );
+
   Parts parts;
   const unsigned numComponents = atomCollectionGraph.connectedComponents(parts.componentMap.map);
   parts.precursors.resize(numComponents);
@@ -425,7 +644,7 @@ Parts construeParts(
 
   for(unsigned i = 0; i < N; ++i) {
     auto& precursor = parts.precursors.at(
-      parts.componentMap.apply(i).component
+      parts.componentMap.map.at(i)
     );
 
     // Add a new vertex with element information
@@ -439,9 +658,7 @@ Parts construeParts(
     }
 
     // Copy over position information
-    precursor.angstromPositions.emplace_back(
-      angstromWrapper.positions.row(i)
-    );
+    precursor.angstromPositions.emplace_back(positions.row(i));
   }
 
   // Copy over edges and bond orders
@@ -451,7 +668,7 @@ Parts construeParts(
 
     // Both source and target are part of the same component (since they are bonded)
     auto& precursor = parts.precursors.at(
-      parts.componentMap.apply(source).component
+      parts.componentMap.map.at(source)
     );
 
     // Copy over the edge
@@ -476,21 +693,11 @@ Parts construeParts(
   return parts;
 }
 
-MoleculesResult molecules(
-  const Utils::ElementTypeCollection& elements,
-  const AngstromPositions& angstromWrapper,
-  const Utils::BondOrderCollection& bondOrders,
-  const BondDiscretizationOption discretization,
-  const boost::optional<double>& stereopermutatorThreshold
+MoleculesResult moleculesFromParts(
+  Parts parts,
+  const ComponentDeduplicationOption deduplication,
+  const InterpretationTier tier
 ) {
-  Parts parts = construeParts(
-    elements,
-    angstromWrapper,
-    bondOrders,
-    discretization,
-    stereopermutatorThreshold
-  );
-
   // Collect results
   MoleculesResult result;
 
@@ -499,24 +706,96 @@ MoleculesResult molecules(
    * the given positions are faulty or no positional information is present,
    * and only the graph is used to create the Molecules.
    */
-  if(parts.nZeroLengthPositions < 2) {
-    result.molecules.reserve(parts.precursors.size());
-    for(auto& precursor : parts.precursors) {
-      result.molecules.emplace_back(
-        Graph {std::move(precursor.graph)},
-        AngstromPositions(paste(precursor.angstromPositions), LengthUnit::Angstrom),
-        precursor.bondStereopermutatorCandidatesOptional
-      );
+  const bool usePositions = (
+    parts.nZeroLengthPositions < 2
+    && tier != InterpretationTier::Constitution
+  );
+
+  /* Components are instantiated in parallel and collected in component order.
+   * Exceptions cannot leave the parallel region, so the first one is kept and
+   * rethrown once all threads are done
+   */
+  const unsigned M = parts.precursors.size();
+  std::vector<boost::optional<Molecule>> componentMolecules(M);
+  std::exception_ptr exception;
+
+  /* Components with the same constitution as an earlier component are
+   * instantiated after it, reusing its rankings
+   */
+  std::vector<unsigned> representatives = Temple::iota<unsigned>(M);
+  if(deduplication == ComponentDeduplicationOption::Constitutional) {
+    std::map<std::vector<unsigned>, unsigned> firstWithSignature;
+    for(unsigned i = 0; i < M; ++i) {
+      const auto& precursor = parts.precursors[i];
+      // Single atoms and diatomics are not ranked
+      if(precursor.graph.N() <= 2) {
+        continue;
+      }
+
+      representatives[i] = firstWithSignature.emplace(
+        constitutionSignature(precursor),
+        i
+      ).first->second;
     }
-  } else {
-    result.molecules.reserve(parts.precursors.size());
-    for(auto& precursor : parts.precursors) {
-      result.molecules.emplace_back(
-        Graph {std::move(precursor.graph)}
-      );
+  }
+
+  // Representatives are instantiated in the first pass, the rest in the second
+  for(const bool representativePass : {true, false}) {
+#pragma omp parallel for schedule(dynamic)
+    for(unsigned i = 0; i < M; ++i) {
+      if((representatives[i] == i) != representativePass) {
+        continue;
+      }
+
+      auto& precursor = parts.precursors[i];
+      try {
+        if(!usePositions) {
+          // Molecules from graphs alone are equal for equal constitutions
+          if(representativePass) {
+            componentMolecules[i] = Molecule {Graph {std::move(precursor.graph)}};
+          } else {
+            componentMolecules[i] = componentMolecules[representatives[i]].value();
+          }
+        } else if(tier == InterpretationTier::Shapes) {
+          componentMolecules[i] = Molecule::shapesFromPositions(
+            Graph {std::move(precursor.graph)},
+            AngstromPositions(paste(precursor.angstromPositions), LengthUnit::Angstrom),
+            representativePass ? nullptr : &componentMolecules[representatives[i]].value()
+          );
+        } else if(representativePass) {
+          componentMolecules[i] = Molecule {
+            Graph {std::move(precursor.graph)},
+            AngstromPositions(paste(precursor.angstromPositions), LengthUnit::Angstrom),
+            precursor.bondStereopermutatorCandidatesOptional
+          };
+        } else {
+          componentMolecules[i] = Molecule {
+            Graph {std::move(precursor.graph)},
+            AngstromPositions(paste(precursor.angstromPositions), LengthUnit::Angstrom),
+            precursor.bondStereopermutatorCandidatesOptional,
+            componentMolecules[representatives[i]].value()
+          };
+        }
+      } catch(...) {
+#pragma omp critical(interpretMoleculesException)
+        {
+          if(!exception) {
+            exception = std::current_exception();
+          }
+        }
+      }
+    }
+
+    if(exception) {
+      std::rethrow_exception(exception);
     }
   }
 
+  result.molecules.reserve(M);
+  for(auto& moleculeOption : componentMolecules) {
+    result.molecules.push_back(std::move(moleculeOption.value()));
+  }
+
   result.componentMap = std::move(parts.componentMap);
 
   return result;
@@ -525,15 +804,86 @@ MoleculesResult molecules(
 MoleculesResult molecules(
   const Utils::ElementTypeCollection& elements,
   const AngstromPositions& angstromWrapper,
+  const Utils::BondOrderCollection& bondOrders,
   const BondDiscretizationOption discretization,
-  const boost::optional<double>& stereopermutatorThreshold
+  const boost::optional<double>& stereopermutatorThreshold,
+  const ComponentDeduplicationOption deduplication,
+  const InterpretationTier tier
+) {
+  return moleculesFromParts(
+    construeParts(
+      elements,
+      angstromWrapper,
+      bondOrders,
+      discretization,
+      stereopermutatorThreshold
+    ),
+    deduplication,
+    tier
+  );
+}
+
+MoleculesResult molecules(
+  const Utils::ElementTypeCollection& elements,
+  const AngstromPositions& angstromWrapper,
+  const PeriodicCell& cell,
+  const Utils::BondOrderCollection& bondOrders,
+  const BondDiscretizationOption discretization,
+  const boost::optional<double>& stereopermutatorThreshold,
+  const ComponentDeduplicationOption deduplication,
+  const InterpretationTier tier
+) {
+  return moleculesFromParts(
+    construeParts(
+      elements,
+      angstromWrapper,
+      bondOrders,
+      discretization,
+      stereopermutatorThreshold,
+      &cell
+    ),
+    deduplication,
+    tier
+  );
+}
+
+MoleculesResult molecules(
+  const Utils::ElementTypeCollection& elements,
+  const AngstromPositions& angstromWrapper,
+  const PeriodicCell& cell,
+  const BondDiscretizationOption discretization,
+  const boost::optional<double>& stereopermutatorThreshold,
+  const ComponentDeduplicationOption deduplication,
+  const InterpretationTier tier
+) {
+  return molecules(
+    elements,
+    angstromWrapper,
+    cell,
+    uffBondOrders(elements, angstromWrapper, cell),
+    discretization,
+    stereopermutatorThreshold,
+    deduplication,
+    tier
+  );
+}
+
+MoleculesResult molecules(
+  const Utils::ElementTypeCollection& elements,
+  const AngstromPositions& angstromWrapper,
+  const BondDiscretizationOption discretization,
+  const boost::optional<double>& stereopermutatorThreshold,
+  const ComponentDeduplicationOption deduplication,
+  const InterpretationTier tier
 ) {
   return molecules(
     elements,
     angstromWrapper,
     uffBondOrders(elements, angstromWrapper),
     discretization,
-    stereopermutatorThreshold
+    stereopermutatorThreshold,
+    deduplication,
+    tier
   );
 }
 
@@ -541,21 +891,27 @@ MoleculesResult molecules(
   const Utils::AtomCollection& atomCollection,
   const Utils::BondOrderCollection& bondOrders,
   const BondDiscretizationOption discretization,
-  const boost::optional<double>& stereopermutatorThreshold
+  const boost::optional<double>& stereopermutatorThreshold,
+  const ComponentDeduplicationOption deduplication,
+  const InterpretationTier tier
 ) {
   return molecules(
     atomCollection.getElements(),
     AngstromPositions {atomCollection.getPositions(), LengthUnit::Bohr},
     bondOrders,
     discretization,
-    stereopermutatorThreshold
+    stereopermutatorThreshold,
+    deduplication,
+    tier
   );
 }
 
 MoleculesResult molecules(
   const Utils::AtomCollection& atomCollection,
   const BondDiscretizationOption discretization,
-  const boost::optional<double>& stereopermutatorThreshold
+  const boost::optional<double>& stereopermutatorThreshold,
+  const ComponentDeduplicationOption deduplication,
+  const InterpretationTier tier
 ) {
   AngstromPositions angstromWrapper {atomCollection.getPositions(), LengthUnit::Bohr};
 
@@ -564,7 +920,9 @@ MoleculesResult molecules(
     angstromWrapper,
     uffBondOrders(atomCollection.getElements(), angstromWrapper),
     discretization,
-    stereopermutatorThreshold
+    stereopermutatorThreshold,
+    deduplication,
+    tier
   );
 }
 
@@ -604,155 +962,218 @@ GraphsResult graphs(
   );
 }
 
-std::vector<FalsePositive> uncertainBonds(
-  const Utils::AtomCollection& atomCollection,
-  const Utils::BondOrderCollection& bondOrders
-) {
-  std::vector<FalsePositive> falsePositives;
-
-  Parts parts = construeParts(
-    atomCollection.getElements(),
-    AngstromPositions {atomCollection.getPositions(), LengthUnit::Bohr},
-    bondOrders,
-    BondDiscretizationOption::Binary,
-    boost::none
-  );
-
-  for(unsigned component = 0; component < parts.precursors.size(); ++component) {
-    MoleculeParts& part = parts.precursors[component];
-    GraphAlgorithms::updateEtaBonds(part.graph);
+//! Binary interpretation of components with eta bonds, as analyzed for false positives
+struct AnalysisParts {
+  AnalysisParts(
+    const Utils::AtomCollection& atomCollection,
+    const Utils::BondOrderCollection& bondOrders
+  ) : parts(
+        construeParts(
+          atomCollection.getElements(),
+          AngstromPositions {atomCollection.getPositions(), LengthUnit::Bohr},
+          bondOrders,
+          BondDiscretizationOption::Binary,
+          boost::none
+        )
+      ),
+      indexInComponent(atomCollection.size())
+  {
+    for(MoleculeParts& part : parts.precursors) {
+      GraphAlgorithms::updateEtaBonds(part.graph);
+    }
 
-    std::vector<std::pair<PrivateGraph::Vertex, double>> sketchyClassifications;
+    if(!parts.componentMap.map.empty()) {
+      componentAtoms = parts.componentMap.invert();
+    }
+    for(const auto& atoms : componentAtoms) {
+      for(unsigned k = 0; k < atoms.size(); ++k) {
+        indexInComponent[atoms[k]] = k;
+      }
+    }
+  }
 
-    for(const PrivateGraph::Vertex v : part.graph.vertices()) {
-      /* Detect high uncertainty shape classifications. Adjacent pairs with high
-       * uncertainties are candidates for false positives.
-       */
-      auto classificationUncertainty = minimumClassificationProbability(part.graph, part.angstromPositions, v);
-      if(classificationUncertainty && *classificationUncertainty >= 0.5) {
-        sketchyClassifications.emplace_back(v, *classificationUncertainty);
+  //! Marks atoms within a graph distance of two of either atom of a bond
+  void markVicinity(const FalsePositive& bond, std::vector<char>& marks) const {
+    const unsigned component = parts.componentMap.map.at(bond.i);
+    const PrivateGraph& graph = parts.precursors.at(component).graph;
+    const std::vector<unsigned>& atoms = componentAtoms.at(component);
+    for(const AtomIndex a : {indexInComponent.at(bond.i), indexInComponent.at(bond.j)}) {
+      marks[atoms[a]] = 1;
+      for(const AtomIndex b : graph.adjacents(a)) {
+        marks[atoms[b]] = 1;
+        for(const AtomIndex c : graph.adjacents(b)) {
+          marks[atoms[c]] = 1;
+        }
       }
     }
+  }
 
-    // NOTE: Cannot remove bonds with overlapping constituent atoms!
-    for(const auto& sketchyPair : Temple::Adaptors::allPairs(sketchyClassifications)) {
-      const unsigned i = sketchyPair.first.first;
-      const unsigned j = sketchyPair.second.first;
-      const double i_random = sketchyPair.first.second;
-      const double j_random = sketchyPair.second.second;
+  /* Evaluates a per-atom analysis of stale atoms in parallel, storing results
+   * at atom collection indices
+   */
+  template<typename T, typename F>
+  void analyze(
+    const std::vector<char>& stale,
+    std::vector<T>& results,
+    F&& analysis
+  ) const {
+    std::vector<std::pair<unsigned, PrivateGraph::Vertex>> work;
+    for(unsigned component = 0; component < componentAtoms.size(); ++component) {
+      const std::vector<unsigned>& atoms = componentAtoms[component];
+      for(unsigned k = 0; k < atoms.size(); ++k) {
+        if(stale[atoms[k]] != 0) {
+          work.emplace_back(component, k);
+        }
+      }
+    }
 
-      if(part.graph.edgeOption(i, j)) {
-        falsePositives.push_back(
-          FalsePositive {
-            parts.componentMap.invert(ComponentMap::ComponentIndexPair {component, i}),
-            parts.componentMap.invert(ComponentMap::ComponentIndexPair {component, j}),
-            i_random * j_random
-          }
+    const unsigned W = work.size();
+    std::exception_ptr exception;
+#pragma omp parallel for schedule(dynamic)
+    for(unsigned w = 0; w < W; ++w) {
+      const unsigned component = work[w].first;
+      try {
+        results[componentAtoms[component][work[w].second]] = analysis(
+          parts.precursors[component],
+          componentAtoms[component],
+          work[w].second
         );
+      } catch(...) {
+#pragma omp critical(interpretFalsePositiveException)
+        {
+          if(!exception) {
+            exception = std::current_exception();
+          }
+        }
       }
     }
+
+    if(exception) {
+      std::rethrow_exception(exception);
+    }
   }
 
-  return falsePositives;
+  Parts parts;
+  //! Atom collection indices of each component's atoms
+  std::vector<std::vector<unsigned>> componentAtoms;
+  //! Index of each atom within its component
+  std::vector<AtomIndex> indexInComponent;
+};
+
+boost::optional<double> atomClassification(
+  const MoleculeParts& part,
+  const std::vector<unsigned>& /* atoms */,
+  const PrivateGraph::Vertex v
+) {
+  return minimumClassificationProbability(part.graph, part.angstromPositions, v);
 }
 
-std::vector<FalsePositive> badHapticLigandBonds(
-  const Utils::AtomCollection& atomCollection,
-  const Utils::BondOrderCollection& bondOrders
+/* Detect haptic shape planes with large angles to the axis defined by the
+ * site position and the central atom or with high rms deviations on their
+ * plane fit
+ */
+std::vector<FalsePositive> hapticSuggestions(
+  const MoleculeParts& part,
+  const std::vector<unsigned>& atoms,
+  const PrivateGraph::Vertex v
 ) {
-  std::vector<FalsePositive> falsePositives;
+  std::vector<FalsePositive> suggestions;
+  auto suggest = [&](const AtomIndex a, const AtomIndex b, const double p) {
+    const auto bounds = std::minmax(atoms.at(a), atoms.at(b));
+    suggestions.push_back(FalsePositive {bounds.first, bounds.second, p});
+  };
 
-  // Avoid duplicate bonds in list with reverse i-j
-  auto addFalsePositive = [&](unsigned i, unsigned j, double p) {
-    if(i > j) {
-      std::swap(i, j);
-    }
-    auto findIter = std::find_if(
-      std::begin(falsePositives),
-      std::end(falsePositives),
-      [=](const FalsePositive& fp) -> bool {
-        return fp.i == i && fp.j == j;
-      }
-    );
-    if(findIter == std::end(falsePositives)) {
-      falsePositives.push_back(FalsePositive {i, j, p});
+  const auto sites = GraphAlgorithms::sites(part.graph, v);
+  const unsigned S = sites.size();
+  for(unsigned siteIndex = 0; siteIndex < S; ++siteIndex) {
+    const auto& site = sites.at(siteIndex);
+    const unsigned siteSize = site.size();
+    if(siteSize == 1) {
+      continue;
     }
-  };
 
-  Parts parts = construeParts(
-    atomCollection.getElements(),
-    AngstromPositions {atomCollection.getPositions(), LengthUnit::Bohr},
-    bondOrders,
-    BondDiscretizationOption::Binary,
-    boost::none
-  );
+    const auto geometry = hapticPlaneGeometry(part.angstromPositions, v, site);
 
-  for(unsigned component = 0; component < parts.precursors.size(); ++component) {
-    MoleculeParts& part = parts.precursors[component];
-    GraphAlgorithms::updateEtaBonds(part.graph);
-
-    for(const PrivateGraph::Vertex v : part.graph.vertices()) {
-      /* Detect haptic shape planes with large angles to the axis defined by the
-       * site position and the central atom or with high rms deviations on
-       * their plane fit
-       */
-      const auto sites = GraphAlgorithms::sites(part.graph, v);
-      const unsigned S = sites.size();
-      for(unsigned siteIndex = 0; siteIndex < S; ++siteIndex) {
-        const auto& site = sites.at(siteIndex);
-        const unsigned siteSize = site.size();
-        if(siteSize == 1) {
-          continue;
+    // Less than 30° and a good plane fit indicate the haptic site is fine
+    if(geometry.angle < M_PI / 6 && geometry.rmsd < 0.2) {
+      continue;
+    }
+
+    if(siteSize == 2) {
+      // Suggest the vertex further from the center
+      const double frontDistance = (
+        part.angstromPositions.at(v)
+        - part.angstromPositions.at(site.front())
+      ).norm();
+      const double backDistance = (
+        part.angstromPositions.at(v)
+        - part.angstromPositions.at(site.back())
+      ).norm();
+      const AtomIndex toRemove = frontDistance < backDistance ? site.back() : site.front();
+      suggest(v, toRemove, geometry.angle * 2 / M_PI);
+    } else {
+      const auto suggestedRemovalOption = bestRemovalFromHapticSite(
+        part.graph,
+        part.angstromPositions,
+        v,
+        sites,
+        siteIndex
+      );
+      if(suggestedRemovalOption) {
+        for(const AtomIndex w : suggestedRemovalOption->removals) {
+          suggest(v, w, suggestedRemovalOption->certainty);
         }
+      }
+    }
+  }
 
-        const auto geometry = hapticPlaneGeometry(part.angstromPositions, v, site);
+  return suggestions;
+}
 
-        // Less than 30° and a good plane fit indicate the haptic site is fine
-        if(geometry.angle < M_PI / 6 && geometry.rmsd < 0.2) {
-          continue;
-        }
+//! Bonds whose atoms both have uncertain shape classifications
+std::vector<FalsePositive> uncertainPairs(
+  const AnalysisParts& analysisParts,
+  const std::vector<boost::optional<double>>& classifications
+) {
+  // NOTE: Cannot remove bonds with overlapping constituent atoms!
+  std::vector<FalsePositive> falsePositives;
+  for(unsigned component = 0; component < analysisParts.componentAtoms.size(); ++component) {
+    const PrivateGraph& graph = analysisParts.parts.precursors[component].graph;
+    const std::vector<unsigned>& atoms = analysisParts.componentAtoms[component];
+    for(const PrivateGraph::Edge& edge : graph.edges()) {
+      const auto bounds = std::minmax(atoms[graph.source(edge)], atoms[graph.target(edge)]);
+      const auto& i_random = classifications[bounds.first];
+      const auto& j_random = classifications[bounds.second];
+      if(i_random && *i_random >= 0.5 && j_random && *j_random >= 0.5) {
+        falsePositives.push_back(
+          FalsePositive {bounds.first, bounds.second, *i_random * *j_random}
+        );
+      }
+    }
+  }
 
-        if(siteSize == 2) {
-          // Suggest the vertex further from the center
-          const double frontDistance = (
-            part.angstromPositions.at(v)
-            - part.angstromPositions.at(site.front())
-          ).norm();
-          const double backDistance = (
-            part.angstromPositions.at(v)
-            - part.angstromPositions.at(site.back())
-          ).norm();
-          const AtomIndex toRemove = frontDistance < backDistance ? site.back() : site.front();
-          addFalsePositive(
-            parts.componentMap.invert(
-              ComponentMap::ComponentIndexPair {component, v}
-            ),
-            parts.componentMap.invert(
-              ComponentMap::ComponentIndexPair {component, toRemove}
-            ),
-            geometry.angle * 2 / M_PI
-          );
-        } else {
-          const auto suggestedRemovalOption = bestRemovalFromHapticSite(
-            part.graph,
-            part.angstromPositions,
-            v,
-            sites,
-            siteIndex
-          );
-          if(suggestedRemovalOption) {
-            for(const AtomIndex w : suggestedRemovalOption->removals) {
-              addFalsePositive(
-                parts.componentMap.invert(
-                  ComponentMap::ComponentIndexPair {component, v}
-                ),
-                parts.componentMap.invert(
-                  ComponentMap::ComponentIndexPair {component, w}
-                ),
-                suggestedRemovalOption->certainty
-              );
-            }
-          }
+  std::sort(
+    std::begin(falsePositives),
+    std::end(falsePositives),
+    [](const FalsePositive& a, const FalsePositive& b) {
+      return std::tie(a.i, a.j) < std::tie(b.i, b.j);
+    }
+  );
+  return falsePositives;
+}
+
+//! Suggestions of all atoms in component order, avoiding duplicate bonds
+std::vector<FalsePositive> collectHapticSuggestions(
+  const AnalysisParts& analysisParts,
+  const std::vector<std::vector<FalsePositive>>& suggestions
+) {
+  std::vector<FalsePositive> falsePositives;
+  std::set<std::pair<unsigned, unsigned>> suggested;
+  for(const auto& atoms : analysisParts.componentAtoms) {
+    for(const unsigned i : atoms) {
+      for(const FalsePositive& suggestion : suggestions[i]) {
+        if(suggested.emplace(suggestion.i, suggestion.j).second) {
+          falsePositives.push_back(suggestion);
         }
       }
     }
@@ -760,26 +1181,95 @@ std::vector<FalsePositive> badHapticLigandBonds(
   return falsePositives;
 }
 
+/* Selects the most likely false positive and, for batch removal, all further
+ * false positives neither of whose atoms is in the vicinity of a selected one.
+ * Marks the vicinities of selected false positives as stale.
+ */
+std::vector<FalsePositive> selectRemovals(
+  std::vector<FalsePositive> falsePositives,
+  const AnalysisParts& analysisParts,
+  const FalsePositiveRemovalOption removal,
+  std::vector<char>& stale
+) {
+  Temple::sort(falsePositives);
+  std::fill(std::begin(stale), std::end(stale), 0);
+  std::vector<FalsePositive> selected;
+  for(auto iter = falsePositives.rbegin(); iter != falsePositives.rend(); ++iter) {
+    if(stale[iter->i] != 0 || stale[iter->j] != 0) {
+      continue;
+    }
+
+    selected.push_back(*iter);
+    analysisParts.markVicinity(*iter, stale);
+    if(removal == FalsePositiveRemovalOption::Sequential) {
+      break;
+    }
+  }
+  return selected;
+}
+
+std::vector<FalsePositive> uncertainBonds(
+  const Utils::AtomCollection& atomCollection,
+  const Utils::BondOrderCollection& bondOrders
+) {
+  const AnalysisParts analysisParts {atomCollection, bondOrders};
+  const std::vector<char> stale(atomCollection.size(), 1);
+  std::vector<boost::optional<double>> classifications(atomCollection.size());
+  analysisParts.analyze(stale, classifications, atomClassification);
+  return uncertainPairs(analysisParts, classifications);
+}
+
+std::vector<FalsePositive> badHapticLigandBonds(
+  const Utils::AtomCollection& atomCollection,
+  const Utils::BondOrderCollection& bondOrders
+) {
+  const AnalysisParts analysisParts {atomCollection, bondOrders};
+  const std::vector<char> stale(atomCollection.size(), 1);
+  std::vector<std::vector<FalsePositive>> suggestions(atomCollection.size());
+  analysisParts.analyze(stale, suggestions, hapticSuggestions);
+  return collectHapticSuggestions(analysisParts, suggestions);
+}
+
 Utils::BondOrderCollection removeFalsePositives(
   const Utils::AtomCollection& atoms,
-  Utils::BondOrderCollection bonds
+  Utils::BondOrderCollection bonds,
+  const FalsePositiveRemovalOption removal
 ) {
+  /* Per-atom analyses only depend on the bonds within a graph distance of two.
+   * Only atoms in the vicinity of removed bonds are analyzed again.
+   */
+  const unsigned N = atoms.size();
+  std::vector<char> stale(N, 1);
+
   // First do bad haptic bond orders
-  auto haptics = badHapticLigandBonds(atoms, bonds);
-  while(!haptics.empty()) {
-    Temple::sort(haptics);
-    FalsePositive& mostLikely = haptics.back();
-    bonds.setOrder(mostLikely.i, mostLikely.j, 0.0);
-    haptics = badHapticLigandBonds(atoms, bonds);
+  std::vector<std::vector<FalsePositive>> suggestions(N);
+  while(true) {
+    const AnalysisParts analysisParts {atoms, bonds};
+    analysisParts.analyze(stale, suggestions, hapticSuggestions);
+    auto haptics = collectHapticSuggestions(analysisParts, suggestions);
+    if(haptics.empty()) {
+      break;
+    }
+
+    for(const FalsePositive& bond : selectRemovals(std::move(haptics), analysisParts, removal, stale)) {
+      bonds.setOrder(bond.i, bond.j, 0.0);
+    }
   }
 
   // Then do uncertain bonds
-  auto uncertains = uncertainBonds(atoms, bonds);
-  while(!uncertains.empty()) {
-    Temple::sort(uncertains);
-    FalsePositive& mostLikely = uncertains.back();
-    bonds.setOrder(mostLikely.i, mostLikely.j, 0.0);
-    uncertains = uncertainBonds(atoms, bonds);
+  std::fill(std::begin(stale), std::end(stale), 1);
+  std::vector<boost::optional<double>> classifications(N);
+  while(true) {
+    const AnalysisParts analysisParts {atoms, bonds};
+    analysisParts.analyze(stale, classifications, atomClassification);
+    auto uncertains = uncertainPairs(analysisParts, classifications);
+    if(uncertains.empty()) {
+      break;
+    }
+
+    for(const FalsePositive& bond : selectRemovals(std::move(uncertains), analysisParts, removal, stale)) {
+      bonds.setOrder(bond.i, bond.j, 0.0);
+    }
   }
 
   return bonds;
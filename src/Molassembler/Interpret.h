@@ -12,7 +12,9 @@
 #define INCLUDE_MOLASSEMBLER_INTERPRET_H
 
 #include "Molassembler/Export.h"
+#include "Molassembler/IteratorRange.h"
 #include "boost/optional.hpp"
+#include <memory>
 #include <vector>
 
 
@@ -32,6 +34,7 @@ namespace Molassembler {
 class Molecule;
 class Graph;
 class AngstromPositions;
+class PeriodicCell;
 
 //! @brief Given Cartesian coordinates, construct graphs or molecules
 namespace Interpret {
@@ -44,6 +47,33 @@ enum class MASM_EXPORT BondDiscretizationOption {
   RoundToNearest
 };
 
+//! @brief Whether molecules of identical connected components are instantiated independently
+enum class MASM_EXPORT ComponentDeduplicationOption {
+  //! @brief Every component's molecule is instantiated independently
+  Off,
+  /*! @brief Components with equal element types, bonds and bond
+   *   stereopermutator candidates in the same atom order reuse the rankings
+   *   of the first such component. Their stereopermutators are still fitted
+   *   to their own positions.
+   */
+  Constitutional
+};
+
+//! @brief How much of a molecule is interpreted from positions
+enum class MASM_EXPORT InterpretationTier {
+  /*! @brief Stereopermutators are modeled from the graph alone, as for
+   *   molecules constructed from graphs. Positions are ignored.
+   */
+  Constitution,
+  /*! @brief Atoms are ranked from the graph alone and the shapes of atom
+   *   stereopermutators are classified from positions. Stereopermutators are
+   *   not assigned and bond stereopermutators are not instantiated.
+   */
+  Shapes,
+  //! @brief All stereopermutators are interpreted from positions
+  Full
+};
+
 //! Type used to represent a map from an atom collection index to an interpreted object
 struct MASM_EXPORT ComponentMap {
   struct ComponentIndexPair {
@@ -53,11 +83,65 @@ struct MASM_EXPORT ComponentMap {
     unsigned long atomIndex;
   };
 
-  //! Transform index from original atom collection to component and atom index
+  /*! @brief Precomputed inverse of a component map
+   *
+   * Transforms indices in either direction in constant time. The original
+   * indices of each component's atoms are stored contiguously and can be
+   * viewed without copying.
+   *
+   * @note Later changes to the map it is constructed from are not reflected.
+   */
+  class MASM_EXPORT Index {
+  public:
+    using AtomRange = IteratorRange<std::vector<unsigned>::const_iterator>;
+
+    /*! @brief Constructor
+     *
+     * @complexity{@math{\Theta(N)}}
+     */
+    explicit Index(const ComponentMap& componentMap);
+
+    //! Transform index from original atom collection to component and atom index
+    ComponentIndexPair apply(unsigned index) const;
+    //! Transform component and atom index to index from original atom collection
+    unsigned invert(const ComponentIndexPair& pair) const;
+
+    /*! @brief View of the original indices of a component's atoms
+     *
+     * The original indices are ordered by their index within the component.
+     *
+     * @throws std::out_of_range If the component does not exist
+     */
+    AtomRange atoms(unsigned component) const;
+
+    //! Number of components
+    inline unsigned components() const { return starts_.size() - 1; }
+
+  private:
+    //! Component index of each original index
+    std::vector<unsigned> components_;
+    //! Index within its component of each original index
+    std::vector<unsigned> indicesInComponent_;
+    //! Offsets of each component's atoms in atoms_
+    std::vector<unsigned> starts_;
+    //! Original indices grouped by component
+    std::vector<unsigned> atoms_;
+  };
+
+  /*! @brief Transform index from original atom collection to component and atom index
+   *
+   * @complexity{@math{\Theta(N)}. Use index() for repeated lookups.}
+   */
   ComponentIndexPair apply(unsigned index) const;
-  //! Transform component and atom index to index from original atom collection
+  /*! @brief Transform component and atom index to index from original atom collection
+   *
+   * @complexity{@math{\Theta(N)}. Use index() for repeated lookups.}
+   */
   unsigned invert(const ComponentIndexPair& pair) const;
 
+  //! Precomputes the inverse of the map for repeated lookups
+  Index index() const;
+
 
   /*!
    * @brief Yields mapping from indices in components to original input indices
@@ -114,10 +198,21 @@ struct MASM_EXPORT MoleculesResult {
  * @param stereopermutatorThreshold From which fractional bond
  *   order on to try the interpretation of bond stereopermutator. If set as
  *   @p boost::none, no bond stereopermutators are interpreted.
+ * @param deduplication Whether identical components reuse the rankings of
+ *   the first of them instead of ranking their atoms anew. Rankings are only
+ *   reused if neither component has stereogenic stereopermutators.
+ * @param tier How much of each molecule is interpreted from positions.
+ *   Lower tiers skip the costlier parts of interpretation.
  *
  * @throws invalid_argument If the number of particles in the element
  *   collection, angstrom wrapper or bond order collection do not match.
  *
+ * @parblock @note This function is parallelized over connected components.
+ * Use the OMP_NUM_THREADS environment variable to control the number of
+ * threads used. The order of the molecules is independent of the number of
+ * threads and matches the component indices of the component map.
+ * @endparblock
+ *
  * @returns A list of found molecules and an index mapping to each molecule
  */
 MASM_EXPORT MoleculesResult molecules(
@@ -125,7 +220,9 @@ MASM_EXPORT MoleculesResult molecules(
   const AngstromPositions& angstromWrapper,
   const Utils::BondOrderCollection& bondOrders,
   BondDiscretizationOption discretization = BondDiscretizationOption::Binary,
-  const boost::optional<double>& stereopermutatorThreshold = 1.4
+  const boost::optional<double>& stereopermutatorThreshold = 1.4,
+  ComponentDeduplicationOption deduplication = ComponentDeduplicationOption::Off,
+  InterpretationTier tier = InterpretationTier::Full
 );
 
 /*! @brief Interpret a molecule from positional information only. Calculates
@@ -137,6 +234,9 @@ MASM_EXPORT MoleculesResult molecules(
  * @param stereopermutatorThreshold From which fractional bond
  *   order on to try the interpretation of bond stereopermutator. If set as
  *   @p boost::none, no bond stereopermutators are interpreted.
+ * @param deduplication Whether identical components reuse the rankings of
+ *   the first of them
+ * @param tier How much of each molecule is interpreted from positions
  *
  * @throws invalid_argument If the number of particles in the element
  *   collection and angstrom wrapper do not match.
@@ -151,7 +251,78 @@ MASM_EXPORT MoleculesResult molecules(
   const Utils::ElementTypeCollection& elements,
   const AngstromPositions& angstromWrapper,
   BondDiscretizationOption discretization = BondDiscretizationOption::Binary,
-  const boost::optional<double>& stereopermutatorThreshold = 1.4
+  const boost::optional<double>& stereopermutatorThreshold = 1.4,
+  ComponentDeduplicationOption deduplication = ComponentDeduplicationOption::Off,
+  InterpretationTier tier = InterpretationTier::Full
+);
+
+/*! @brief Interpret molecules of a periodic structure from element types,
+ *   wrapped positions and a bond order collection.
+ *
+ * Components are found from the discretized bonds regardless of where their
+ * atoms are wrapped to. The positions of each component are unwrapped
+ * breadth-first along its bonds by placing atoms at the minimum image of
+ * their bond partner. In extended networks, bonds closing cycles through the
+ * cell faces cannot be placed consistently and remain stretched, which may
+ * misinterpret the shapes of their atoms.
+ *
+ * @param elements Element type collection
+ * @param angstromWrapper Wrapped positional information in Angstrom units
+ * @param cell Periodic cell of the structure
+ * @param bondOrders Bond orders, e.g. from
+ *   uffBondOrders(const Utils::ElementTypeCollection&, const AngstromPositions&, const PeriodicCell&)
+ * @param discretization How to discretize fractional bond orders
+ * @param stereopermutatorThreshold From which fractional bond
+ *   order on to try the interpretation of bond stereopermutator. If set as
+ *   @p boost::none, no bond stereopermutators are interpreted.
+ * @param deduplication Whether identical components reuse the rankings of
+ *   the first of them
+ * @param tier How much of each molecule is interpreted from positions
+ *
+ * @throws invalid_argument If the number of particles in the element
+ *   collection, angstrom wrapper or bond order collection do not match.
+ *
+ * @returns A list of found molecules and an index mapping to each molecule
+ */
+MASM_EXPORT MoleculesResult molecules(
+  const Utils::ElementTypeCollection& elements,
+  const AngstromPositions& angstromWrapper,
+  const PeriodicCell& cell,
+  const Utils::BondOrderCollection& bondOrders,
+  BondDiscretizationOption discretization = BondDiscretizationOption::Binary,
+  const boost::optional<double>& stereopermutatorThreshold = 1.4,
+  ComponentDeduplicationOption deduplication = ComponentDeduplicationOption::Off,
+  InterpretationTier tier = InterpretationTier::Full
+);
+
+/*! @brief Interpret molecules of a periodic structure from wrapped positions
+ *   only. Calculates bond orders using minimum image uffBondOrders.
+ *
+ * @param elements Element type collection
+ * @param angstromWrapper Wrapped positional information in Angstrom units
+ * @param cell Periodic cell of the structure
+ * @param discretization How to discretize fractional bond orders
+ * @param stereopermutatorThreshold From which fractional bond
+ *   order on to try the interpretation of bond stereopermutator. If set as
+ *   @p boost::none, no bond stereopermutators are interpreted.
+ * @param deduplication Whether identical components reuse the rankings of
+ *   the first of them
+ * @param tier How much of each molecule is interpreted from positions
+ *
+ * @throws invalid_argument If the number of particles in the element
+ *   collection and angstrom wrapper do not match, or the cell is too small
+ *   for minimum image bond perception
+ *
+ * @returns A list of found molecules and an index mapping to each molecule
+ */
+MASM_EXPORT MoleculesResult molecules(
+  const Utils::ElementTypeCollection& elements,
+  const AngstromPositions& angstromWrapper,
+  const PeriodicCell& cell,
+  BondDiscretizationOption discretization = BondDiscretizationOption::Binary,
+  const boost::optional<double>& stereopermutatorThreshold = 1.4,
+  ComponentDeduplicationOption deduplication = ComponentDeduplicationOption::Off,
+  InterpretationTier tier = InterpretationTier::Full
 );
 
 /*!
@@ -170,6 +341,9 @@ MASM_EXPORT MoleculesResult molecules(
  * @param stereopermutatorThreshold If specified, limits the
  *   instantiation of BondStereopermutators onto edges whose fractional bond orders
  *   exceed the provided threshold. If this is not desired, specify boost::none.
+ * @param deduplication Whether identical components reuse the rankings of
+ *   the first of them
+ * @param tier How much of each molecule is interpreted from positions
  *
  * @throws invalid_argument If the number of particles in the atom
  *   collection and bond order collection do not match.
@@ -181,7 +355,9 @@ MASM_EXPORT MoleculesResult molecules(
   const Utils::AtomCollection& atomCollection,
   const Utils::BondOrderCollection& bondOrders,
   BondDiscretizationOption discretization = BondDiscretizationOption::Binary,
-  const boost::optional<double>& stereopermutatorThreshold = 1.4
+  const boost::optional<double>& stereopermutatorThreshold = 1.4,
+  ComponentDeduplicationOption deduplication = ComponentDeduplicationOption::Off,
+  InterpretationTier tier = InterpretationTier::Full
 );
 
 /*!
@@ -200,6 +376,9 @@ MASM_EXPORT MoleculesResult molecules(
  * @param stereopermutatorThreshold If specified, limits the
  *   instantiation of BondStereopermutators onto edges whose fractional bond orders
  *   exceed the provided threshold
+ * @param deduplication Whether identical components reuse the rankings of
+ *   the first of them
+ * @param tier How much of each molecule is interpreted from positions
  *
  * @note Assumes that the provided atom collection's positions are in
  * Bohr units.
@@ -210,7 +389,9 @@ MASM_EXPORT MoleculesResult molecules(
 MASM_EXPORT MoleculesResult molecules(
   const Utils::AtomCollection& atomCollection,
   BondDiscretizationOption discretization = BondDiscretizationOption::Binary,
-  const boost::optional<double>& stereopermutatorThreshold = 1.4
+  const boost::optional<double>& stereopermutatorThreshold = 1.4,
+  ComponentDeduplicationOption deduplication = ComponentDeduplicationOption::Off,
+  InterpretationTier tier = InterpretationTier::Full
 );
 
 //! Result type of a graph interpret call
@@ -268,6 +449,178 @@ MASM_EXPORT GraphsResult graphs(
   BondDiscretizationOption discretization = BondDiscretizationOption::Binary
 );
 
+//! Result type of an ensemble interpret call
+struct MASM_EXPORT EnsembleResult {
+  //! Mapping from atom index to component index, shared by all frames
+  ComponentMap componentMap;
+  //! Molecules of each frame, in component order
+  std::vector<std::vector<Molecule>> frames;
+};
+
+/*! @brief Interpret an ensemble of conformers sharing a single topology
+ *
+ * Bonds are discretized and components are found once from the topology.
+ * Each component is instantiated once from the topology's positions, and
+ * its molecules in each frame only fit stereopermutators to the frame's
+ * positions, reusing the graph and rankings of the topology's molecule
+ * where they are not stereogenic.
+ *
+ * @complexity{@math{\Theta(KM)} stereopermutator fits for @math{K} frames
+ * and @math{M} components}
+ *
+ * @param topology Element types and reference positions in Bohr units
+ * @param bondOrders Bond orders of the topology
+ * @param frames Positions of the conformers in Angstrom units
+ * @param discretization How to discretize fractional bond orders
+ * @param stereopermutatorThreshold From which fractional bond order on to
+ *   try the interpretation of bond stereopermutators. If set as
+ *   @p boost::none, no bond stereopermutators are interpreted.
+ *
+ * @throws invalid_argument If the number of particles in the topology, bond
+ *   order collection or any frame do not match.
+ *
+ * @parblock @note This function is parallelized over components and frames.
+ * Use the OMP_NUM_THREADS environment variable to control the number of
+ * threads used.
+ * @endparblock
+ *
+ * @returns The shared component map and the molecules of each frame
+ */
+MASM_EXPORT EnsembleResult ensemble(
+  const Utils::AtomCollection& topology,
+  const Utils::BondOrderCollection& bondOrders,
+  const std::vector<AngstromPositions>& frames,
+  BondDiscretizationOption discretization = BondDiscretizationOption::Binary,
+  const boost::optional<double>& stereopermutatorThreshold = 1.4
+);
+
+/*! @brief Interpret an ensemble of conformers sharing a single topology.
+ *   Calculates bond orders of the topology using uffBondOrders.
+ *
+ * @param topology Element types and reference positions in Bohr units
+ * @param frames Positions of the conformers in Angstrom units
+ * @param discretization How to discretize fractional bond orders
+ * @param stereopermutatorThreshold From which fractional bond order on to
+ *   try the interpretation of bond stereopermutators. If set as
+ *   @p boost::none, no bond stereopermutators are interpreted.
+ *
+ * @throws invalid_argument If the number of particles in the topology and
+ *   any frame do not match.
+ *
+ * @returns The shared component map and the molecules of each frame
+ */
+MASM_EXPORT EnsembleResult ensemble(
+  const Utils::AtomCollection& topology,
+  const std::vector<AngstromPositions>& frames,
+  BondDiscretizationOption discretization = BondDiscretizationOption::Binary,
+  const boost::optional<double>& stereopermutatorThreshold = 1.4
+);
+
+/*! @brief Interprets molecules in consecutive frames of a trajectory,
+ *   reusing the molecules of components whose bonding is unchanged
+ *
+ * Keeps the discretized bonds, component map and molecules of the previous
+ * frame. A pair's discretized bond type changes only if its fractional bond
+ * order passes the discretization boundary by more than the hysteresis, and
+ * likewise for bond stereopermutator candidacy at the stereopermutator
+ * threshold. Only components whose bonding changed are instantiated anew.
+ * Components with unchanged bonding keep their molecule if none of their
+ * atoms moved further than the refit displacement since they were last
+ * fitted, and are otherwise refitted to the new positions reusing their
+ * rankings.
+ *
+ * The first frame is interpreted as by molecules.
+ *
+ * @parblock @note Interpretation of each frame is parallelized over
+ * components. Use the OMP_NUM_THREADS environment variable to control the
+ * number of threads used.
+ * @endparblock
+ */
+class MASM_EXPORT TrajectoryInterpreter {
+public:
+  /*! @brief Constructor
+   *
+   * @param elements Element types of all frames
+   * @param discretization How to discretize fractional bond orders
+   * @param stereopermutatorThreshold From which fractional bond order on to
+   *   try the interpretation of bond stereopermutators. If set as
+   *   @p boost::none, no bond stereopermutators are interpreted.
+   * @param hysteresis Distance past a discretization boundary or the
+   *   stereopermutator threshold a fractional bond order must reach to change
+   *   the interpretation of a pair
+   * @param refitDisplacement Largest displacement in Angstrom of any atom of
+   *   a component with unchanged bonding since it was last fitted up to which
+   *   its molecule is kept as is
+   *
+   * @throws std::invalid_argument If @p hysteresis is not in @math{[0, 0.5)}
+   *   or @p refitDisplacement is negative
+   */
+  explicit TrajectoryInterpreter(
+    Utils::ElementTypeCollection elements,
+    BondDiscretizationOption discretization = BondDiscretizationOption::Binary,
+    const boost::optional<double>& stereopermutatorThreshold = 1.4,
+    double hysteresis = 0.1,
+    double refitDisplacement = 0.0
+  );
+
+  TrajectoryInterpreter(TrajectoryInterpreter&& other) noexcept;
+  TrajectoryInterpreter& operator = (TrajectoryInterpreter&& other) noexcept;
+  TrajectoryInterpreter(const TrajectoryInterpreter& other) = delete;
+  TrajectoryInterpreter& operator = (const TrajectoryInterpreter& other) = delete;
+  ~TrajectoryInterpreter();
+
+  /*! @brief Interprets the next frame from positions and bond orders
+   *
+   * @complexity{Linear in the number of atoms and stored bond orders if no
+   * component is refitted or instantiated anew}
+   *
+   * @throws std::invalid_argument If the number of particles in the angstrom
+   *   wrapper or bond order collection do not match the number of elements
+   *
+   * @returns The molecules of the frame and an index mapping to each molecule
+   */
+  const MoleculesResult& operator () (
+    const AngstromPositions& angstromWrapper,
+    const Utils::BondOrderCollection& bondOrders
+  );
+
+  /*! @brief Interprets the next frame from positions only. Calculates bond
+   *   orders using uffBondList.
+   *
+   * @throws std::invalid_argument If the number of particles in the angstrom
+   *   wrapper does not match the number of elements
+   *
+   * @returns The molecules of the frame and an index mapping to each molecule
+   */
+  const MoleculesResult& operator () (const AngstromPositions& angstromWrapper);
+
+  //! Interpretation of the last frame
+  const MoleculesResult& result() const;
+
+  //! Components of the last frame that were instantiated anew
+  const std::vector<unsigned>& rebuiltComponents() const;
+
+  //! Components of the last frame with unchanged bonding that were refitted
+  const std::vector<unsigned>& refittedComponents() const;
+
+  //! Number of interpreted frames
+  unsigned frames() const;
+
+private:
+  struct Impl;
+  std::unique_ptr<Impl> pImpl_;
+};
+
+//! @brief How many false positives are removed per iteration
+enum class MASM_EXPORT FalsePositiveRemovalOption {
+  //! @brief Only the most likely false positive is removed
+  Sequential,
+  /*! @brief The most likely false positive and all further ones not within a
+   *   graph distance of two of an already selected one are removed
+   */
+  Batch
+};
+
 //! @brief Fn result datatype
 struct FalsePositive {
   unsigned i;
@@ -315,12 +668,25 @@ std::vector<FalsePositive> badHapticLigandBonds(
 
 /*! @brief Iteratively applies false positive detection schemes
  *
- * @warning Pretty darn conservative implementation, removes only a single bond
- * from each false positive detection function call each iteration.
+ * Shape analyses of atoms are reused across iterations unless a removed bond
+ * is within a graph distance of two.
+ *
+ * @param atoms Element types and positional information in Bohr units
+ * @param bonds Fractional bond orders
+ * @param removal How many false positives are removed per iteration
+ *
+ * @parblock @note This function is parallelized over atoms. Use the
+ * OMP_NUM_THREADS environment variable to control the number of threads used.
+ * @endparblock
+ *
+ * @warning Pretty darn conservative implementation. By default, removes only
+ * a single bond from each false positive detection function call each
+ * iteration.
  */
 Utils::BondOrderCollection removeFalsePositives(
   const Utils::AtomCollection& atoms,
-  Utils::BondOrderCollection bonds
+  Utils::BondOrderCollection bonds,
+  FalsePositiveRemovalOption removal = FalsePositiveRemovalOption::Sequential
 );
 
 } // namespace Interpret
@@ -0,0 +1,176 @@
+/*!@file
+ * @copyright This code is licensed under the 3-clause BSD license.
+ *   Copyright ETH Zurich, Laboratory of Physical Chemistry, Reiher Group.
+ *   See LICENSE.txt for details.
+ */
+
+#include "Molassembler/Interpret.h"
+
+#include "Molassembler/AngstromPositions.h"
+#include "Molassembler/BondOrders.h"
+#include "Molassembler/Graph.h"
+#include "Molassembler/Molecule.h"
+
+#include "Utils/Bonds/BondOrderCollection.h"
+#include "Utils/Geometry/AtomCollection.h"
+
+#include <exception>
+
+namespace Scine {
+namespace Molassembler {
+namespace Interpret {
+namespace {
+
+//! Positions of a component's atoms in a frame
+AngstromPositions componentPositions(
+  const AngstromPositions& positions,
+  const ComponentMap::Index::AtomRange atoms
+) {
+  AngstromPositions result(atoms.end() - atoms.begin());
+  unsigned i = 0;
+  for(const unsigned atom : atoms) {
+    result.positions.row(i++) = positions.positions.row(atom);
+  }
+  return result;
+}
+
+} // namespace
+
+EnsembleResult ensemble(
+  const Utils::AtomCollection& topology,
+  const Utils::BondOrderCollection& bondOrders,
+  const std::vector<AngstromPositions>& frames,
+  const BondDiscretizationOption discretization,
+  const boost::optional<double>& stereopermutatorThreshold
+) {
+  const unsigned N = topology.size();
+  for(const AngstromPositions& frame : frames) {
+    if(static_cast<unsigned>(frame.positions.rows()) != N) {
+      throw std::invalid_argument(
+        "Number of positions in ensemble frame does not match number of elements"
+      );
+    }
+  }
+
+  const AngstromPositions topologyPositions {topology.getPositions(), LengthUnit::Bohr};
+  GraphsResult parts = graphs(
+    topology.getElements(),
+    topologyPositions,
+    bondOrders,
+    discretization
+  );
+
+  EnsembleResult result;
+  result.componentMap = std::move(parts.componentMap);
+  const unsigned M = parts.graphs.size();
+  const unsigned K = frames.size();
+  result.frames.resize(K);
+  if(M == 0) {
+    return result;
+  }
+  const ComponentMap::Index componentIndex = result.componentMap.index();
+
+  // Bond stereopermutator candidates of each component in component indices
+  std::vector<boost::optional<std::vector<BondIndex>>> candidates(M);
+  if(stereopermutatorThreshold) {
+    for(unsigned c = 0; c < M; ++c) {
+      candidates[c] = std::vector<BondIndex> {};
+      for(const BondIndex& bond : parts.graphs[c].bonds()) {
+        const double bondOrder = bondOrders.getOrder(
+          componentIndex.invert({c, bond.first}),
+          componentIndex.invert({c, bond.second})
+        );
+        if(bondOrder >= *stereopermutatorThreshold) {
+          candidates[c]->push_back(bond);
+        }
+      }
+    }
+  }
+
+  /* Each component is instantiated once from the topology, serving as the
+   * ranking template of its frames. Exceptions cannot leave the parallel
+   * regions, so the first one is kept and rethrown once all threads are done
+   */
+  std::vector<boost::optional<Molecule>> templates(M);
+  std::exception_ptr exception;
+
+#pragma omp parallel for schedule(dynamic)
+  for(unsigned c = 0; c < M; ++c) {
+    try {
+      templates[c] = Molecule {
+        parts.graphs[c],
+        componentPositions(topologyPositions, componentIndex.atoms(c)),
+        candidates[c]
+      };
+    } catch(...) {
+#pragma omp critical(interpretEnsembleException)
+      {
+        if(!exception) {
+          exception = std::current_exception();
+        }
+      }
+    }
+  }
+
+  if(exception) {
+    std::rethrow_exception(exception);
+  }
+
+  std::vector<boost::optional<Molecule>> molecules(K * M);
+
+#pragma omp parallel for schedule(dynamic)
+  for(unsigned k = 0; k < K * M; ++k) {
+    const unsigned frame = k / M;
+    const unsigned c = k % M;
+    try {
+      molecules[k] = Molecule {
+        parts.graphs[c],
+        componentPositions(frames[frame], componentIndex.atoms(c)),
+        candidates[c],
+        templates[c].value()
+      };
+    } catch(...) {
+#pragma omp critical(interpretEnsembleException)
+      {
+        if(!exception) {
+          exception = std::current_exception();
+        }
+      }
+    }
+  }
+
+  if(exception) {
+    std::rethrow_exception(exception);
+  }
+
+  for(unsigned frame = 0; frame < K; ++frame) {
+    result.frames[frame].reserve(M);
+    for(unsigned c = 0; c < M; ++c) {
+      result.frames[frame].push_back(std::move(molecules[frame * M + c].value()));
+    }
+  }
+
+  return result;
+}
+
+EnsembleResult ensemble(
+  const Utils::AtomCollection& topology,
+  const std::vector<AngstromPositions>& frames,
+  const BondDiscretizationOption discretization,
+  const boost::optional<double>& stereopermutatorThreshold
+) {
+  return ensemble(
+    topology,
+    uffBondOrders(
+      topology.getElements(),
+      AngstromPositions {topology.getPositions(), LengthUnit::Bohr}
+    ),
+    frames,
+    discretization,
+    stereopermutatorThreshold
+  );
+}
+
+} // namespace Interpret
+} // namespace Molassembler
+} // namespace Scine
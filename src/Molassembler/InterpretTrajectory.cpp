@@ -0,0 +1,452 @@
+/*!@file
+ * @copyright This code is licensed under the 3-clause BSD license.
+ *   Copyright ETH Zurich, Laboratory of Physical Chemistry, Reiher Group.
+ *   See LICENSE.txt for details.
+ */
+
+#include "Molassembler/Interpret.h"
+
+#include "Molassembler/AngstromPositions.h"
+#include "Molassembler/BondOrders.h"
+#include "Molassembler/Graph.h"
+#include "Molassembler/Graph/PrivateGraph.h"
+#include "Molassembler/Molecule.h"
+
+#include "Utils/Bonds/BondOrderCollection.h"
+
+#include <algorithm>
+#include <cmath>
+#include <exception>
+#include <tuple>
+
+namespace Scine {
+namespace Molassembler {
+namespace Interpret {
+namespace {
+
+//! Discretized interpretation of a bonded atom pair
+struct PairState {
+  AtomIndex first;
+  AtomIndex second;
+  BondType type;
+  bool candidate;
+};
+
+template<typename T, typename U>
+bool pairLess(const T& a, const U& b) {
+  return std::tie(a.first, a.second) < std::tie(b.first, b.second);
+}
+
+template<typename T, typename U>
+bool samePair(const T& a, const U& b) {
+  return a.first == b.first && a.second == b.second;
+}
+
+BondType roundBondOrder(const double bondOrder) {
+  if(bondOrder > 6.5) {
+    return BondType::Sextuple;
+  }
+
+  return static_cast<BondType>(std::round(bondOrder) - 1);
+}
+
+std::vector<FractionalBond> upperTriangle(const Utils::BondOrderCollection& bondOrders) {
+  const Eigen::SparseMatrix<double>& matrix = bondOrders.getMatrix();
+  std::vector<FractionalBond> bonds;
+  for(int j = 0; j < matrix.outerSize(); ++j) {
+    for(Eigen::SparseMatrix<double>::InnerIterator iter(matrix, j); iter; ++iter) {
+      if(iter.row() < j) {
+        bonds.push_back(
+          FractionalBond {
+            static_cast<AtomIndex>(iter.row()),
+            static_cast<AtomIndex>(j),
+            iter.value()
+          }
+        );
+      }
+    }
+  }
+
+  std::sort(
+    std::begin(bonds),
+    std::end(bonds),
+    [](const FractionalBond& a, const FractionalBond& b) { return pairLess(a, b); }
+  );
+  return bonds;
+}
+
+} // namespace
+
+struct TrajectoryInterpreter::Impl {
+  //! What happens to a component's molecule in a frame
+  enum class Action {Keep, Refit, Rebuild};
+
+  Impl(
+    Utils::ElementTypeCollection passElements,
+    const BondDiscretizationOption passDiscretization,
+    const boost::optional<double>& passStereopermutatorThreshold,
+    const double passHysteresis,
+    const double passRefitDisplacement
+  ) : elements(std::move(passElements)),
+      discretization(passDiscretization),
+      stereopermutatorThreshold(passStereopermutatorThreshold),
+      hysteresis(passHysteresis),
+      refitDisplacement(passRefitDisplacement)
+  {
+    if(hysteresis < 0.0 || hysteresis >= 0.5) {
+      throw std::invalid_argument("Hysteresis must be in [0, 0.5)");
+    }
+
+    if(refitDisplacement < 0.0) {
+      throw std::invalid_argument("Refit displacement must not be negative");
+    }
+  }
+
+  void checkSize(const AngstromPositions& angstromWrapper) const {
+    if(static_cast<std::size_t>(angstromWrapper.positions.rows()) != elements.size()) {
+      throw std::invalid_argument(
+        "Number of positions in angstrom wrapper do not match number of elements"
+      );
+    }
+  }
+
+  /* Discretizes a pair's bond order. The first frame has no hysteresis, so
+   * that it is interpreted as by molecules.
+   */
+  boost::optional<PairState> discretizePair(
+    const FractionalBond& bond,
+    const PairState* previous
+  ) const {
+    const double margin = (count == 0) ? 0.0 : hysteresis;
+
+    PairState pair {bond.first, bond.second, BondType::Single, false};
+    if(previous != nullptr) {
+      if(bond.order <= 0.5 - margin) {
+        return boost::none;
+      }
+
+      if(discretization == BondDiscretizationOption::RoundToNearest) {
+        const double nominal = static_cast<double>(previous->type) + 1;
+        const bool keepType = (
+          bond.order > nominal - 0.5 - margin
+          && (bond.order <= nominal + 0.5 + margin || previous->type == BondType::Sextuple)
+        );
+        pair.type = keepType ? previous->type : roundBondOrder(bond.order);
+      }
+    } else {
+      if(bond.order <= 0.5 + margin) {
+        return boost::none;
+      }
+
+      if(discretization == BondDiscretizationOption::RoundToNearest) {
+        pair.type = roundBondOrder(bond.order);
+      }
+    }
+
+    if(stereopermutatorThreshold) {
+      const bool wasCandidate = (previous != nullptr && previous->candidate);
+      pair.candidate = wasCandidate
+        ? bond.order >= *stereopermutatorThreshold - margin
+        : bond.order >= *stereopermutatorThreshold + margin;
+    }
+
+    return pair;
+  }
+
+  const MoleculesResult& interpret(
+    const AngstromPositions& angstromWrapper,
+    const std::vector<FractionalBond>& bonds
+  ) {
+    const unsigned N = elements.size();
+    const Utils::PositionCollection& positions = angstromWrapper.positions;
+
+    // Discretize with the previous frame's pairs, which are sorted alike
+    std::vector<PairState> nextPairs;
+    auto previousIter = std::begin(pairs);
+    for(const FractionalBond& bond : bonds) {
+      while(previousIter != std::end(pairs) && pairLess(*previousIter, bond)) {
+        ++previousIter;
+      }
+      const bool hasPrevious = (previousIter != std::end(pairs) && samePair(*previousIter, bond));
+      if(auto pairOption = discretizePair(bond, hasPrevious ? &*previousIter : nullptr)) {
+        nextPairs.push_back(*pairOption);
+      }
+    }
+
+    // Atoms whose pairs were discretized differently than in the last frame
+    std::vector<char> changed(N, static_cast<char>(count == 0));
+    bool anyChanged = (count == 0);
+    const auto markChanged = [&](const PairState& pair) {
+      changed[pair.first] = changed[pair.second] = 1;
+      anyChanged = true;
+    };
+    {
+      auto a = std::begin(pairs);
+      auto b = std::begin(nextPairs);
+      while(a != std::end(pairs) || b != std::end(nextPairs)) {
+        if(b == std::end(nextPairs) || (a != std::end(pairs) && pairLess(*a, *b))) {
+          markChanged(*a++);
+        } else if(a == std::end(pairs) || pairLess(*b, *a)) {
+          markChanged(*b++);
+        } else {
+          if(a->type != b->type || a->candidate != b->candidate) {
+            markChanged(*b);
+          }
+          ++a;
+          ++b;
+        }
+      }
+    }
+
+    // Positions are only used if at most one is very close to the origin
+    unsigned nZeroLengthPositions = 0;
+    for(unsigned i = 0; i < N; ++i) {
+      if(positions.row(i).norm() <= 1e-14) {
+        nZeroLengthPositions += 1;
+      }
+    }
+    const bool nextUsePositions = nZeroLengthPositions < 2;
+    if(count > 0 && nextUsePositions != usePositions) {
+      std::fill(std::begin(changed), std::end(changed), 1);
+      anyChanged = true;
+    }
+
+    ComponentMap componentMap;
+    if(anyChanged) {
+      PrivateGraph graph {N};
+      for(const PairState& pair : nextPairs) {
+        graph.addEdge(pair.first, pair.second, pair.type);
+      }
+      graph.connectedComponents(componentMap.map);
+    } else {
+      componentMap = result.componentMap;
+    }
+
+    std::vector<std::vector<unsigned>> componentAtoms;
+    if(N > 0) {
+      componentAtoms = componentMap.invert();
+    }
+    const unsigned M = componentAtoms.size();
+
+    /* Components without changed atoms have the same atoms and bonds as a
+     * component of the last frame
+     */
+    std::vector<Action> actions(M, Action::Rebuild);
+    std::vector<unsigned> previousComponent(M);
+    for(unsigned c = 0; c < M; ++c) {
+      const std::vector<unsigned>& atoms = componentAtoms[c];
+      const bool anyAtomChanged = std::any_of(
+        std::begin(atoms),
+        std::end(atoms),
+        [&](const unsigned i) { return changed[i] != 0; }
+      );
+      if(anyAtomChanged) {
+        continue;
+      }
+
+      previousComponent[c] = result.componentMap.map[atoms.front()];
+      actions[c] = Action::Keep;
+      if(nextUsePositions) {
+        for(const unsigned i : atoms) {
+          if((positions.row(i) - fittedPositions.row(i)).norm() > refitDisplacement) {
+            actions[c] = Action::Refit;
+            break;
+          }
+        }
+      }
+    }
+
+    // Component graphs and candidates for components to instantiate
+    std::vector<AtomIndex> indexInComponent(N);
+    for(const auto& atoms : componentAtoms) {
+      for(unsigned k = 0; k < atoms.size(); ++k) {
+        indexInComponent[atoms[k]] = k;
+      }
+    }
+
+    std::vector<PrivateGraph> graphs(M);
+    std::vector<boost::optional<std::vector<BondIndex>>> candidates(M);
+    for(unsigned c = 0; c < M; ++c) {
+      if(actions[c] == Action::Keep) {
+        continue;
+      }
+
+      for(const unsigned i : componentAtoms[c]) {
+        graphs[c].addVertex(elements[i]);
+      }
+      if(stereopermutatorThreshold) {
+        candidates[c] = std::vector<BondIndex> {};
+      }
+    }
+    for(const PairState& pair : nextPairs) {
+      const unsigned c = componentMap.map[pair.first];
+      if(actions[c] == Action::Keep) {
+        continue;
+      }
+
+      const AtomIndex source = indexInComponent[pair.first];
+      const AtomIndex target = indexInComponent[pair.second];
+      graphs[c].addEdge(source, target, pair.type);
+      if(pair.candidate) {
+        candidates[c]->emplace_back(source, target);
+      }
+    }
+
+    // Instantiate in parallel, rethrowing the first exception afterwards
+    std::vector<boost::optional<Molecule>> componentMolecules(M);
+    std::exception_ptr exception;
+#pragma omp parallel for schedule(dynamic)
+    for(unsigned c = 0; c < M; ++c) {
+      if(actions[c] == Action::Keep) {
+        continue;
+      }
+
+      try {
+        if(!nextUsePositions) {
+          componentMolecules[c] = Molecule {Graph {std::move(graphs[c])}};
+          continue;
+        }
+
+        const std::vector<unsigned>& atoms = componentAtoms[c];
+        Utils::PositionCollection componentPositions(atoms.size(), 3);
+        for(unsigned k = 0; k < atoms.size(); ++k) {
+          componentPositions.row(k) = positions.row(atoms[k]);
+        }
+        const AngstromPositions componentWrapper {componentPositions, LengthUnit::Angstrom};
+
+        if(actions[c] == Action::Refit) {
+          componentMolecules[c] = Molecule {
+            Graph {std::move(graphs[c])},
+            componentWrapper,
+            candidates[c],
+            result.molecules[previousComponent[c]]
+          };
+        } else {
+          componentMolecules[c] = Molecule {
+            Graph {std::move(graphs[c])},
+            componentWrapper,
+            candidates[c]
+          };
+        }
+      } catch(...) {
+#pragma omp critical(trajectoryInterpreterException)
+        {
+          if(!exception) {
+            exception = std::current_exception();
+          }
+        }
+      }
+    }
+
+    if(exception) {
+      std::rethrow_exception(exception);
+    }
+
+    // Commit the frame
+    if(count == 0) {
+      fittedPositions = positions;
+    }
+
+    rebuilt.clear();
+    refitted.clear();
+    MoleculesResult nextResult;
+    nextResult.molecules.reserve(M);
+    for(unsigned c = 0; c < M; ++c) {
+      if(actions[c] == Action::Keep) {
+        nextResult.molecules.push_back(std::move(result.molecules[previousComponent[c]]));
+        continue;
+      }
+
+      nextResult.molecules.push_back(std::move(componentMolecules[c].value()));
+      (actions[c] == Action::Refit ? refitted : rebuilt).push_back(c);
+      for(const unsigned i : componentAtoms[c]) {
+        fittedPositions.row(i) = positions.row(i);
+      }
+    }
+    nextResult.componentMap = std::move(componentMap);
+
+    result = std::move(nextResult);
+    pairs = std::move(nextPairs);
+    usePositions = nextUsePositions;
+    ++count;
+    return result;
+  }
+
+  const Utils::ElementTypeCollection elements;
+  const BondDiscretizationOption discretization;
+  const boost::optional<double> stereopermutatorThreshold;
+  const double hysteresis;
+  const double refitDisplacement;
+
+  //! Discretized bonded pairs of the last frame, ordered by atom indices
+  std::vector<PairState> pairs;
+  //! Positions each atom's component was last fitted to
+  Utils::PositionCollection fittedPositions;
+  bool usePositions = true;
+  MoleculesResult result;
+  std::vector<unsigned> rebuilt;
+  std::vector<unsigned> refitted;
+  unsigned count = 0;
+};
+
+TrajectoryInterpreter::TrajectoryInterpreter(
+  Utils::ElementTypeCollection elements,
+  const BondDiscretizationOption discretization,
+  const boost::optional<double>& stereopermutatorThreshold,
+  const double hysteresis,
+  const double refitDisplacement
+) : pImpl_(
+  std::make_unique<Impl>(
+    std::move(elements),
+    discretization,
+    stereopermutatorThreshold,
+    hysteresis,
+    refitDisplacement
+  )
+) {}
+
+TrajectoryInterpreter::TrajectoryInterpreter(TrajectoryInterpreter&& other) noexcept = default;
+TrajectoryInterpreter& TrajectoryInterpreter::operator = (TrajectoryInterpreter&& other) noexcept = default;
+TrajectoryInterpreter::~TrajectoryInterpreter() = default;
+
+const MoleculesResult& TrajectoryInterpreter::operator () (
+  const AngstromPositions& angstromWrapper,
+  const Utils::BondOrderCollection& bondOrders
+) {
+  pImpl_->checkSize(angstromWrapper);
+  if(bondOrders.getSystemSize<unsigned>() != pImpl_->elements.size()) {
+    throw std::invalid_argument(
+      "Bond order argument system size does not match number of elements"
+    );
+  }
+
+  return pImpl_->interpret(angstromWrapper, upperTriangle(bondOrders));
+}
+
+const MoleculesResult& TrajectoryInterpreter::operator () (const AngstromPositions& angstromWrapper) {
+  pImpl_->checkSize(angstromWrapper);
+  return pImpl_->interpret(
+    angstromWrapper,
+    uffBondList(pImpl_->elements, angstromWrapper)
+  );
+}
+
+const MoleculesResult& TrajectoryInterpreter::result() const {
+  return pImpl_->result;
+}
+
+const std::vector<unsigned>& TrajectoryInterpreter::rebuiltComponents() const {
+  return pImpl_->rebuilt;
+}
+
+const std::vector<unsigned>& TrajectoryInterpreter::refittedComponents() const {
+  return pImpl_->refitted;
+}
+
+unsigned TrajectoryInterpreter::frames() const {
+  return pImpl_->count;
+}
+
+} // namespace Interpret
+} // namespace Molassembler
+} // namespace Scine
@@ -9,37 +9,108 @@
 #include "Molassembler/Molecule.h"
 #include "Molassembler/Molecule/AtomEnvironmentHash.h"
 #include "Molassembler/Graph.h"
+#include "Molassembler/Graph/Canonicalization.h"
 #include "Molassembler/AtomStereopermutator.h"
 #include "Molassembler/BondStereopermutator.h"
 #include "Molassembler/StereopermutatorList.h"
 #include "Molassembler/Stereopermutators/AbstractPermutations.h"
 #include "Molassembler/Stereopermutators/FeasiblePermutations.h"
+#include "Molassembler/Stereopermutation/Manipulation.h"
 #include "Molassembler/Shapes/Data.h"
 #include "Molassembler/Temple/Optionals.h"
 #include "Molassembler/Temple/Functional.h"
 
+#include <unordered_map>
+
 namespace Scine {
 namespace Molassembler {
+struct StereoDescriptor::Impl {
+  //! Description of an atom stereopermutator
+  struct AtomEntry {
+    AtomIndex placement;
+    Shapes::Shape shape;
+    unsigned numStereopermutations;
+    boost::optional<unsigned> indexOfPermutation;
+    //! Smallest rotation of the assigned stereopermutation
+    boost::optional<Stereopermutations::Stereopermutation> canonicalPermutation;
+    /*! Smallest rotation of the mirrored assigned stereopermutation, None if
+     * unassigned or if the shape has no enantiomers
+     */
+    boost::optional<Stereopermutations::Stereopermutation> canonicalMirror;
+  };
+
+  //! Description of a bond stereopermutator
+  struct BondEntry {
+    BondIndex placement;
+    unsigned numStereopermutations;
+    boost::optional<unsigned> indexOfPermutation;
+  };
+
+  explicit Impl(const Molecule& molecule);
+
+  //! Number of bonds
+  unsigned B;
+  //! Atom environment hashes of the canonical graph
+  std::vector<Hashes::WideHashType> hashes;
+  //! Atom stereopermutator entries, ordered by placement
+  std::vector<AtomEntry> atoms;
+  //! Bond stereopermutator entries, ordered by placement
+  std::vector<BondEntry> bonds;
+
+  const AtomEntry* find(AtomIndex i) const;
+  const BondEntry* find(const BondIndex& bond) const;
+};
+
 namespace {
 
-bool everythingBesidesStereopermutationsSame(const Molecule& a, const Molecule& b) {
-  // Use weaker definition
-  constexpr auto bitmask = AtomEnvironmentComponents::ElementTypes
-    | AtomEnvironmentComponents::BondOrders
-    | AtomEnvironmentComponents::Shapes;
+constexpr auto descriptorComponents = AtomEnvironmentComponents::ElementTypes
+  | AtomEnvironmentComponents::BondOrders
+  | AtomEnvironmentComponents::Shapes;
+
+boost::optional<Molecule> maybeCanonicalize(const Molecule& m) {
+  if(m.canonicalComponents() != descriptorComponents) {
+    boost::optional<Molecule> canonicalCopy = m;
+    canonicalCopy->canonicalize(descriptorComponents);
+    return canonicalCopy;
+  }
+
+  return boost::none;
+}
 
-  // Check the precondition
-  assert(a.canonicalComponents() == bitmask && b.canonicalComponents() == bitmask);
+//! Lexicographically smallest rotation of a stereopermutation
+Stereopermutations::Stereopermutation smallestRotation(
+  const Stereopermutations::Stereopermutation& permutation,
+  const Shapes::Shape shape
+) {
+  const auto rotations = Stereopermutations::generateAllRotations(permutation, shape);
+  return *std::min_element(std::begin(rotations), std::end(rotations));
+}
 
+template<typename Entry, typename Placement>
+const Entry* findEntry(const std::vector<Entry>& entries, const Placement& placement) {
+  auto findIter = std::lower_bound(
+    std::begin(entries),
+    std::end(entries),
+    placement,
+    [](const Entry& entry, const Placement& p) { return entry.placement < p; }
+  );
+  if(findIter != std::end(entries) && findIter->placement == placement) {
+    return &(*findIter);
+  }
+
+  return nullptr;
+}
+
+bool everythingBesidesStereopermutationsSame(
+  const StereoDescriptor::Impl& a,
+  const StereoDescriptor::Impl& b
+) {
   // Graph basic equality
-  if(a.graph().N() != b.graph().N() || a.graph().B() != b.graph().B()) {
+  if(a.hashes.size() != b.hashes.size() || a.B != b.B) {
     return false;
   }
 
-  const auto aHashes = Hashes::generate(a.graph().inner(), a.stereopermutators(), bitmask);
-  const auto bHashes = Hashes::generate(b.graph().inner(), b.stereopermutators(), bitmask);
-
-  if(aHashes != bHashes) {
+  if(a.hashes != b.hashes) {
     return false;
   }
 
@@ -47,8 +118,8 @@ bool everythingBesidesStereopermutationsSame(const Molecule& a, const Molecule&
    * between both molecules.
    */
   if(
-    a.stereopermutators().A() != b.stereopermutators().A()
-    && a.stereopermutators().B() != b.stereopermutators().B()
+    a.atoms.size() != b.atoms.size()
+    && a.bonds.size() != b.bonds.size()
   ) {
     return false;
   }
@@ -56,7 +127,10 @@ bool everythingBesidesStereopermutationsSame(const Molecule& a, const Molecule&
   return true;
 }
 
-bool partiallyCanonicalizedEnantiomeric(const Molecule& a, const Molecule& b) {
+bool describedEnantiomeric(
+  const StereoDescriptor::Impl& a,
+  const StereoDescriptor::Impl& b
+) {
   if(!everythingBesidesStereopermutationsSame(a, b)) {
     return false;
   }
@@ -80,55 +154,40 @@ bool partiallyCanonicalizedEnantiomeric(const Molecule& a, const Molecule& b) {
   bool atLeastOneEnantiomericPair = false;
 
   // Match B's stereopermutators to A's (lists are same-size as established above)
-  for(
-    const AtomStereopermutator& aPermutator :
-    a.stereopermutators().atomStereopermutators()
-  ) {
+  for(const auto& aEntry : a.atoms) {
     // Skip all stereopermutators with just one stereopermutation
-    if(aPermutator.numStereopermutations() <= 1) {
+    if(aEntry.numStereopermutations <= 1) {
       continue;
     }
 
-    const auto bPermutatorOption = b.stereopermutators().option(
-      aPermutator.placement()
-    );
+    const auto* bEntryPtr = b.find(aEntry.placement);
 
     // If there is no matching permutator, then these cannot be enantiomers
-    if(!bPermutatorOption) {
+    if(bEntryPtr == nullptr) {
       return false;
     }
 
-    const AtomStereopermutator& bPermutator = *bPermutatorOption;
+    const auto& bEntry = *bEntryPtr;
 
     /* If one or both permutators are unassigned, then we cannot say for certain
      * if a 3D representation of both will be enantiomeric, hence we return
      * false
      */
-    if(!aPermutator.assigned() || !bPermutator.assigned()) {
+    if(!aEntry.indexOfPermutation || !bEntry.indexOfPermutation) {
       return false;
     }
 
     // If the shapes do not match, these molecules cannot be enantiomers
-    if(aPermutator.getShape() != bPermutator.getShape()) {
+    if(aEntry.shape != bEntry.shape) {
       return false;
     }
 
-    const auto& aPermutation = aPermutator.getAbstract().permutations.list.at(
-      *aPermutator.indexOfPermutation()
-    );
-    const auto& bPermutation = bPermutator.getAbstract().permutations.list.at(
-      *bPermutator.indexOfPermutation()
-    );
-
-    // Stereopermutation enantiomerism comparison
-    boost::optional<bool> enantiomericPairOption = Stereopermutations::enantiomer(
-      aPermutation,
-      bPermutation,
-      aPermutator.getShape()
-    );
-
-    if(enantiomericPairOption) {
-      if(*enantiomericPairOption) {
+    /* Stereopermutation enantiomerism comparison: The mirror image of A's
+     * stereopermutation is rotationally superimposable with B's exactly if
+     * their smallest rotations are identical
+     */
+    if(aEntry.canonicalMirror) {
+      if(aEntry.canonicalMirror == bEntry.canonicalPermutation) {
         atLeastOneEnantiomericPair = true;
       } else {
         return false;
@@ -144,19 +203,19 @@ bool partiallyCanonicalizedEnantiomeric(const Molecule& a, const Molecule& b) {
    * unaffected by mirroring.
    */
   return Temple::all_of(
-    a.stereopermutators().bondStereopermutators(),
-    [&](const BondStereopermutator& permutator) -> bool {
-      if(permutator.numStereopermutations() <= 1) {
+    a.bonds,
+    [&](const StereoDescriptor::Impl::BondEntry& entry) -> bool {
+      if(entry.numStereopermutations <= 1) {
         return true;
       }
 
-      const auto matchOption = b.stereopermutators().option(permutator.placement());
+      const auto* matchPtr = b.find(entry.placement);
 
-      if(!matchOption) {
+      if(matchPtr == nullptr) {
         return false;
       }
 
-      if(permutator.indexOfPermutation() != matchOption->indexOfPermutation()) {
+      if(entry.indexOfPermutation != matchPtr->indexOfPermutation) {
         return false;
       }
 
@@ -165,36 +224,33 @@ bool partiallyCanonicalizedEnantiomeric(const Molecule& a, const Molecule& b) {
   );
 }
 
-boost::optional<unsigned> permutationDifferences(const Molecule& a, const Molecule &b) {
+boost::optional<unsigned> permutationDifferences(
+  const StereoDescriptor::Impl& a,
+  const StereoDescriptor::Impl& b
+) {
   unsigned permutationDifferences = 0;
-  for(
-    const AtomStereopermutator& permutator :
-    a.stereopermutators().atomStereopermutators()
-  ) {
-    auto matchOption = b.stereopermutators().option(permutator.placement());
-    if(!matchOption) {
+  for(const auto& entry : a.atoms) {
+    const auto* matchPtr = b.find(entry.placement);
+    if(matchPtr == nullptr) {
       return boost::none;
     }
 
-    if(permutator.getShape() != matchOption->getShape()) {
+    if(entry.shape != matchPtr->shape) {
       return boost::none;
     }
 
-    if(permutator.indexOfPermutation() != matchOption->indexOfPermutation()) {
+    if(entry.indexOfPermutation != matchPtr->indexOfPermutation) {
       ++permutationDifferences;
     }
   }
 
-  for(
-    const BondStereopermutator& permutator :
-    a.stereopermutators().bondStereopermutators()
-  ) {
-    auto matchOption = b.stereopermutators().option(permutator.placement());
-    if(!matchOption) {
+  for(const auto& entry : a.bonds) {
+    const auto* matchPtr = b.find(entry.placement);
+    if(matchPtr == nullptr) {
       return boost::none;
     }
 
-    if(permutator.indexOfPermutation() != matchOption->indexOfPermutation()) {
+    if(entry.indexOfPermutation != matchPtr->indexOfPermutation) {
       ++permutationDifferences;
     }
   }
@@ -202,82 +258,122 @@ boost::optional<unsigned> permutationDifferences(const Molecule& a, const Molecu
   return permutationDifferences;
 }
 
-bool partiallyCanonicalizedDiastereomeric(const Molecule& a, const Molecule& b) {
+} // namespace
+
+StereoDescriptor::Impl::Impl(const Molecule& molecule) {
+  const auto maybeCanonical = maybeCanonicalize(molecule);
+  const Molecule& canonical = maybeCanonical.value_or(molecule);
+
+  B = canonical.graph().B();
+  hashes = Hashes::generate(
+    canonical.graph().inner(),
+    canonical.stereopermutators(),
+    descriptorComponents
+  );
+
+  // Stereopermutators are iterated in order of their placements
+  for(
+    const AtomStereopermutator& permutator :
+    canonical.stereopermutators().atomStereopermutators()
+  ) {
+    AtomEntry entry {
+      permutator.placement(),
+      permutator.getShape(),
+      permutator.numStereopermutations(),
+      permutator.indexOfPermutation(),
+      boost::none,
+      boost::none
+    };
+
+    if(permutator.assigned()) {
+      const Shapes::Shape shape = permutator.getShape();
+      const auto& permutation = permutator.getAbstract().permutations->list.at(
+        *permutator.indexOfPermutation()
+      );
+      entry.canonicalPermutation = smallestRotation(permutation, shape);
+
+      const auto& mirrorPermutation = Shapes::mirror(shape);
+      if(!mirrorPermutation.empty()) {
+        entry.canonicalMirror = smallestRotation(
+          permutation.applyPermutation(mirrorPermutation),
+          shape
+        );
+      }
+    }
+
+    atoms.push_back(std::move(entry));
+  }
+
+  for(
+    const BondStereopermutator& permutator :
+    canonical.stereopermutators().bondStereopermutators()
+  ) {
+    bonds.push_back(
+      BondEntry {
+        permutator.placement(),
+        permutator.numStereopermutations(),
+        permutator.indexOfPermutation()
+      }
+    );
+  }
+}
+
+auto StereoDescriptor::Impl::find(const AtomIndex i) const -> const AtomEntry* {
+  return findEntry(atoms, i);
+}
+
+auto StereoDescriptor::Impl::find(const BondIndex& bond) const -> const BondEntry* {
+  return findEntry(bonds, bond);
+}
+
+StereoDescriptor::StereoDescriptor(const Molecule& molecule)
+  : pImpl_(std::make_shared<const Impl>(molecule)) {}
+
+bool enantiomeric(const StereoDescriptor& a, const StereoDescriptor& b) {
+  return describedEnantiomeric(*a.pImpl_, *b.pImpl_);
+}
+
+bool diastereomeric(const StereoDescriptor& a, const StereoDescriptor& b) {
   // Different at one or more stereopermutators, but not mirror images
-  if(!everythingBesidesStereopermutationsSame(a, b)) {
+  if(!everythingBesidesStereopermutationsSame(*a.pImpl_, *b.pImpl_)) {
     return false;
   }
 
-  if(partiallyCanonicalizedEnantiomeric(a, b)) {
+  if(describedEnantiomeric(*a.pImpl_, *b.pImpl_)) {
     return false;
   }
 
   return Temple::Optionals::map(
-    permutationDifferences(a, b),
+    permutationDifferences(*a.pImpl_, *b.pImpl_),
     [](unsigned differences) -> bool {
       return differences > 0;
     }
   ).value_or(false);
 }
 
-bool partiallyCanonicalizedEpimeric(const Molecule& a, const Molecule& b) {
-  // Different at one or more stereopermutators, but not mirror images
-  if(!everythingBesidesStereopermutationsSame(a, b)) {
+bool epimeric(const StereoDescriptor& a, const StereoDescriptor& b) {
+  if(!everythingBesidesStereopermutationsSame(*a.pImpl_, *b.pImpl_)) {
     return false;
   }
 
   return Temple::Optionals::map(
-    permutationDifferences(a, b),
+    permutationDifferences(*a.pImpl_, *b.pImpl_),
     [](unsigned differences) -> bool {
       return differences == 1;
     }
   ).value_or(false);
 }
 
-boost::optional<Molecule> maybeCanonicalize(const Molecule& m) {
-  constexpr auto componentsBitmask = AtomEnvironmentComponents::ElementTypes
-    | AtomEnvironmentComponents::BondOrders
-    | AtomEnvironmentComponents::Shapes;
-
-  if(m.canonicalComponents() != componentsBitmask) {
-    boost::optional<Molecule> canonicalCopy = m;
-    canonicalCopy->canonicalize(componentsBitmask);
-    return canonicalCopy;
-  }
-
-  return boost::none;
-}
-
-} // namespace
-
 bool enantiomeric(const Molecule& a, const Molecule& b) {
-  const auto maybeCanonicalA = maybeCanonicalize(a);
-  const auto maybeCanonicalB = maybeCanonicalize(b);
-
-  return partiallyCanonicalizedEnantiomeric(
-    maybeCanonicalA.value_or(a),
-    maybeCanonicalB.value_or(b)
-  );
+  return enantiomeric(StereoDescriptor {a}, StereoDescriptor {b});
 }
 
 bool diastereomeric(const Molecule& a, const Molecule& b) {
-  const auto maybeCanonicalA = maybeCanonicalize(a);
-  const auto maybeCanonicalB = maybeCanonicalize(b);
-
-  return partiallyCanonicalizedDiastereomeric(
-    maybeCanonicalA.value_or(a),
-    maybeCanonicalB.value_or(b)
-  );
+  return diastereomeric(StereoDescriptor {a}, StereoDescriptor {b});
 }
 
 bool epimeric(const Molecule& a, const Molecule& b) {
-  const auto maybeCanonicalA = maybeCanonicalize(a);
-  const auto maybeCanonicalB = maybeCanonicalize(b);
-
-  return partiallyCanonicalizedEpimeric(
-    maybeCanonicalA.value_or(a),
-    maybeCanonicalB.value_or(b)
-  );
+  return epimeric(StereoDescriptor {a}, StereoDescriptor {b});
 }
 
 Molecule enantiomer(const Molecule& a) {
@@ -302,7 +398,7 @@ Molecule enantiomer(const Molecule& a) {
     }
 
     // Find the current permutation
-    const auto& currentStereopermutation = permutator.getAbstract().permutations.list.at(
+    const auto& currentStereopermutation = permutator.getAbstract().permutations->list.at(
       *permutator.indexOfPermutation()
     );
 
@@ -310,7 +406,7 @@ Molecule enantiomer(const Molecule& a) {
     auto mirrored = currentStereopermutation.applyPermutation(mirrorPermutation);
 
     // Find an existing permutation that is superposable with the mirror permutation
-    const auto& permutationsList = permutator.getAbstract().permutations.list;
+    const auto& permutationsList = permutator.getAbstract().permutations->list;
     auto matchingPermutationIter = std::find_if(
       std::begin(permutationsList),
       std::end(permutationsList),
@@ -332,7 +428,7 @@ Molecule enantiomer(const Molecule& a) {
     // Now we have a stereopermutation index, but we need an assignment index
     unsigned stereopermutationIndex = matchingPermutationIter - std::begin(permutationsList);
 
-    const auto& feasiblePermutations = permutator.getFeasible().indices;
+    const auto& feasiblePermutations = permutator.getFeasible().indices();
 
     auto assignmentIter = std::find(
       std::begin(feasiblePermutations),
@@ -359,5 +455,167 @@ Molecule enantiomer(const Molecule& a) {
   };
 }
 
+struct StereoisomerEnumerator::Impl {
+  explicit Impl(const Molecule& molecule);
+
+  //! Molecules whose remaining stereopermutators are yet to be branched on
+  std::vector<Molecule> stack;
+  //! Whether distinct assignments may yield identical stereoisomers
+  bool symmetric;
+  //! Canonical forms of emitted stereoisomers by hash if symmetric
+  std::unordered_map<std::size_t, std::vector<Molecule>> canonicalIsomers;
+
+  //! Whether a complete stereoisomer is new, recording it if so
+  bool unseen(const Molecule& isomer);
+};
+
+StereoisomerEnumerator::Impl::Impl(const Molecule& molecule) {
+  // Drop all assignments so that every stereoisomer is reachable
+  Molecule unassigned = molecule;
+  std::vector<AtomIndex> assignedAtoms;
+  for(const auto& permutator : unassigned.stereopermutators().atomStereopermutators()) {
+    if(permutator.assigned() && permutator.numAssignments() > 1) {
+      assignedAtoms.push_back(permutator.placement());
+    }
+  }
+  std::vector<BondIndex> assignedBonds;
+  for(const auto& permutator : unassigned.stereopermutators().bondStereopermutators()) {
+    if(permutator.assigned() && permutator.numAssignments() > 1) {
+      assignedBonds.push_back(permutator.placement());
+    }
+  }
+
+  /* Unassigning a stereopermutator can remove or alter others, so each is
+   * looked up anew
+   */
+  for(const BondIndex& bond : assignedBonds) {
+    auto permutatorOption = unassigned.stereopermutators().option(bond);
+    if(permutatorOption && permutatorOption->assigned()) {
+      unassigned.assignStereopermutator(bond, boost::none);
+    }
+  }
+  for(const AtomIndex atom : assignedAtoms) {
+    auto permutatorOption = unassigned.stereopermutators().option(atom);
+    if(permutatorOption && permutatorOption->assigned() && permutatorOption->numAssignments() > 1) {
+      unassigned.assignStereopermutator(atom, boost::none);
+    }
+  }
+
+  /* Distinct assignment combinations can only yield the same stereoisomer if
+   * an automorphism of the molecule maps a stereocenter onto another atom
+   */
+  constexpr auto bitmask = AtomEnvironmentComponents::ElementTypes
+    | AtomEnvironmentComponents::BondOrders
+    | AtomEnvironmentComponents::Shapes;
+  const PrivateGraph& inner = unassigned.graph().inner();
+  const std::vector<int> orbits = automorphismOrbits(
+    inner,
+    Hashes::generate(inner, unassigned.stereopermutators(), bitmask)
+  );
+  std::vector<unsigned> orbitSizes(orbits.size(), 0);
+  for(const int orbit : orbits) {
+    ++orbitSizes.at(orbit);
+  }
+  auto moved = [&](const AtomIndex i) -> bool {
+    return orbitSizes.at(orbits.at(i)) > 1;
+  };
+
+  symmetric = Temple::any_of(
+    unassigned.stereopermutators().atomStereopermutators(),
+    [&](const AtomStereopermutator& permutator) {
+      return permutator.numAssignments() > 1 && moved(permutator.placement());
+    }
+  ) || Temple::any_of(
+    unassigned.stereopermutators().bondStereopermutators(),
+    [&](const BondStereopermutator& permutator) {
+      return permutator.numAssignments() > 1 && (
+        moved(permutator.placement().first)
+        || moved(permutator.placement().second)
+      );
+    }
+  );
+
+  stack.push_back(std::move(unassigned));
+}
+
+bool StereoisomerEnumerator::Impl::unseen(const Molecule& isomer) {
+  Molecule canonical = isomer;
+  canonical.canonicalize();
+  auto& bucket = canonicalIsomers[canonical.hash()];
+  const bool seen = Temple::any_of(
+    bucket,
+    [&](const Molecule& other) { return other == canonical; }
+  );
+
+  if(seen) {
+    return false;
+  }
+
+  bucket.push_back(std::move(canonical));
+  return true;
+}
+
+StereoisomerEnumerator::StereoisomerEnumerator(const Molecule& molecule)
+  : pImpl_(std::make_unique<Impl>(molecule)) {}
+
+StereoisomerEnumerator::StereoisomerEnumerator(StereoisomerEnumerator&& other) noexcept = default;
+StereoisomerEnumerator& StereoisomerEnumerator::operator = (StereoisomerEnumerator&& other) noexcept = default;
+StereoisomerEnumerator::~StereoisomerEnumerator() = default;
+
+boost::optional<Molecule> StereoisomerEnumerator::next() {
+  auto& stack = pImpl_->stack;
+  while(!stack.empty()) {
+    Molecule molecule = std::move(stack.back());
+    stack.pop_back();
+
+    // Branch on the first unassigned stereopermutator with multiple assignments
+    auto branching = [](const auto& permutator) {
+      return !permutator.assigned() && permutator.numAssignments() > 1;
+    };
+    const auto& stereopermutators = molecule.stereopermutators();
+    const auto atomIter = std::find_if(
+      std::begin(stereopermutators.atomStereopermutators()),
+      std::end(stereopermutators.atomStereopermutators()),
+      branching
+    );
+    if(atomIter != std::end(stereopermutators.atomStereopermutators())) {
+      const AtomIndex atom = (*atomIter).placement();
+      // Push in reverse so that assignments are explored in increasing order
+      for(unsigned k = (*atomIter).numAssignments(); k-- > 0;) {
+        Molecule assigned = molecule;
+        assigned.assignStereopermutator(atom, k);
+        stack.push_back(std::move(assigned));
+      }
+      continue;
+    }
+
+    const auto bondIter = std::find_if(
+      std::begin(stereopermutators.bondStereopermutators()),
+      std::end(stereopermutators.bondStereopermutators()),
+      branching
+    );
+    if(bondIter != std::end(stereopermutators.bondStereopermutators())) {
+      const BondIndex bond = (*bondIter).placement();
+      for(unsigned k = (*bondIter).numAssignments(); k-- > 0;) {
+        Molecule assigned = molecule;
+        assigned.assignStereopermutator(bond, k);
+        stack.push_back(std::move(assigned));
+      }
+      continue;
+    }
+
+    // The molecule is a complete stereoisomer
+    if(!pImpl_->symmetric || pImpl_->unseen(molecule)) {
+      return molecule;
+    }
+  }
+
+  return boost::none;
+}
+
+bool StereoisomerEnumerator::symmetric() const {
+  return pImpl_->symmetric;
+}
+
 } // namespace Molassembler
 } // namespace Scine
@@ -2,7 +2,9 @@
  * @copyright This code is licensed under the 3-clause BSD license.
  *   Copyright ETH Zurich, Laboratory of Physical Chemistry, Reiher Group.
  *   See LICENSE.txt for details.
- * @brief Predicates to determine what kinds of stereoisomers molecule pairs are
+ * @brief Predicates to determine what kinds of stereoisomers molecule pairs are,
+ *   precomputed descriptors for such predicates and enumeration of
+ *   stereoisomers
  */
 
 #ifndef INCLUDE_MOLASSEMBLER_ISOMERS_H
@@ -10,11 +12,15 @@
 
 #include "Molassembler/Export.h"
 
+#include "boost/optional/optional_fwd.hpp"
+#include <memory>
+
 namespace Scine {
 namespace Molassembler {
 
 // Forward-declarations
 class Molecule;
+class StereoDescriptor;
 
 /*!
  * @brief Returns whether three dimensional representations of two molecules
@@ -71,6 +77,151 @@ MASM_EXPORT bool epimeric(
  */
 MASM_EXPORT Molecule enantiomer(const Molecule& a);
 
+/*! @brief Returns whether described molecules are enantiomers
+ *
+ * @complexity{@math{O(N + A \log A + B \log B)}}
+ *
+ * @see enantiomeric(const Molecule&, const Molecule&)
+ */
+MASM_EXPORT bool enantiomeric(
+  const StereoDescriptor& a,
+  const StereoDescriptor& b
+);
+
+/*! @brief Returns whether described molecules are diastereomers
+ *
+ * @complexity{@math{O(N + A \log A + B \log B)}}
+ *
+ * @see diastereomeric(const Molecule&, const Molecule&)
+ */
+MASM_EXPORT bool diastereomeric(
+  const StereoDescriptor& a,
+  const StereoDescriptor& b
+);
+
+/*! @brief Returns whether described molecules are epimers
+ *
+ * @complexity{@math{O(N + A \log A + B \log B)}}
+ *
+ * @see epimeric(const Molecule&, const Molecule&)
+ */
+MASM_EXPORT bool epimeric(
+  const StereoDescriptor& a,
+  const StereoDescriptor& b
+);
+
+/**
+ * @brief Precomputed stereochemical description of a molecule for repeated
+ *   isomer relation queries
+ *
+ * The molecule is canonicalized once with respect to element types, bond
+ * orders and shapes. Its constitution is then recorded as the atom environment
+ * hashes of the canonical graph, and each stereopermutator by its placement,
+ * shape and assignment. Assigned atom stereopermutators additionally store the
+ * rotationally canonical forms of their stereopermutation and its mirror
+ * image, so that mirror relations between stereopermutators need no
+ * enumeration of rotations at comparison time.
+ *
+ * Isomer relations between descriptors then reduce to comparisons of these
+ * sequences, which is preferable to the Molecule overloads of the predicates
+ * if many pairs from a set of molecules are compared.
+ *
+ * @code{.cpp}
+ * const auto descriptors = Temple::map(molecules, [](const Molecule& m) {
+ *   return StereoDescriptor {m};
+ * });
+ * const bool pairEnantiomeric = enantiomeric(descriptors.at(0), descriptors.at(1));
+ * @endcode
+ */
+class MASM_EXPORT StereoDescriptor {
+public:
+  //! Library-internal implementation type
+  struct Impl;
+
+  /*! @brief Describe a molecule
+   *
+   * @complexity{One partial canonicalization if @p molecule is not already
+   * canonical with respect to element types, bond orders and shapes, plus the
+   * generation of all rotations of each assigned atom stereopermutator's
+   * stereopermutation and mirror image}
+   */
+  explicit StereoDescriptor(const Molecule& molecule);
+
+private:
+  friend bool enantiomeric(const StereoDescriptor& a, const StereoDescriptor& b);
+  friend bool diastereomeric(const StereoDescriptor& a, const StereoDescriptor& b);
+  friend bool epimeric(const StereoDescriptor& a, const StereoDescriptor& b);
+
+  // Immutable, hence shared between copies
+  std::shared_ptr<const Impl> pImpl_;
+};
+
+/**
+ * @brief Lazily enumerates all distinct stereoisomers of a molecule
+ *
+ * Stereoisomers are generated by a depth-first search over the assignments of
+ * stereopermutators. At each step, the first unassigned stereopermutator with
+ * multiple assignments is branched on, so that stereopermutators that only
+ * appear or become stereogenic once others are assigned are enumerated too.
+ * Any assignments of the molecule passed at construction are dropped.
+ *
+ * Distinct assignment combinations can only yield the same stereoisomer if an
+ * automorphism of the graph (colored by element types, bond orders and
+ * shapes) maps a stereocenter onto another atom. If all stereocenters are
+ * fixed by the automorphism group, as determined from the vertex orbits of
+ * the canonicalization algorithm, every combination is emitted without
+ * further checks. Otherwise, each generated stereoisomer is canonicalized and
+ * emitted only if not encountered before.
+ *
+ * @code{.cpp}
+ * StereoisomerEnumerator enumerator {molecule};
+ * while(auto isomerOption = enumerator.next()) {
+ *   // Use *isomerOption
+ * }
+ * @endcode
+ */
+class MASM_EXPORT StereoisomerEnumerator {
+public:
+//!@name Special member functions
+//!@{
+  /*! @brief Prepare enumeration of a molecule's stereoisomers
+   *
+   * @complexity{One unassignment per assigned stereopermutator and one
+   * automorphism group calculation}
+   */
+  explicit StereoisomerEnumerator(const Molecule& molecule);
+
+  StereoisomerEnumerator(StereoisomerEnumerator&& other) noexcept;
+  StereoisomerEnumerator& operator = (StereoisomerEnumerator&& other) noexcept;
+  StereoisomerEnumerator(const StereoisomerEnumerator& other) = delete;
+  StereoisomerEnumerator& operator = (const StereoisomerEnumerator& other) = delete;
+  ~StereoisomerEnumerator();
+//!@}
+
+//!@name Enumeration
+//!@{
+  /*! @brief Generate the next distinct stereoisomer
+   *
+   * @complexity{Assignments along a path of the search tree, plus a
+   * canonicalization per stereoisomer if symmetric()}
+   *
+   * @returns The next stereoisomer, or boost::none if all stereoisomers have
+   *   been generated
+   */
+  boost::optional<Molecule> next();
+
+  /*! @brief Whether generated stereoisomers are checked for duplicates
+   *
+   * @complexity{@math{\Theta(1)}}
+   */
+  bool symmetric() const;
+//!@}
+
+private:
+  struct Impl;
+  std::unique_ptr<Impl> pImpl_;
+};
+
 } // namespace Molassembler
 } // namespace Scine
 
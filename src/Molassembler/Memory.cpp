@@ -0,0 +1,231 @@
+/*!@file
+ * @copyright This code is licensed under the 3-clause BSD license.
+ *   Copyright ETH Zurich, Laboratory of Physical Chemistry, Reiher Group.
+ *   See LICENSE.txt for details.
+ */
+
+#include "Molassembler/Memory.h"
+
+#include "Molassembler/AtomStereopermutator.h"
+#include "Molassembler/BondStereopermutator.h"
+#include "Molassembler/DistanceGeometry/ConformerGeneration.h"
+#include "Molassembler/DistanceGeometry/ExplicitBoundsGraph.h"
+#include "Molassembler/Graph.h"
+#include "Molassembler/Graph/PrivateGraph.h"
+#include "Molassembler/Molecule.h"
+#include "Molassembler/Parallel.h"
+#include "Molassembler/Stereopermutation/Composites.h"
+#include "Molassembler/StereopermutatorList.h"
+#include "Molassembler/Stereopermutators/AbstractPermutations.h"
+#include "Molassembler/Stereopermutators/FeasiblePermutations.h"
+
+#include <algorithm>
+
+namespace Scine {
+namespace Molassembler {
+namespace Memory {
+namespace {
+
+//! Bookkeeping pointers of hash map nodes: next node and cached hash
+constexpr std::size_t hashNodeOverhead = 2 * sizeof(void*);
+//! Bookkeeping of node-based containers: two pointers per list node
+constexpr std::size_t listNodeOverhead = 2 * sizeof(void*);
+//! Number of correction pairs the refinement's L-BFGS optimizer keeps
+constexpr std::size_t lbfgsMemory = 32;
+
+template<typename T>
+std::size_t heapSize(const std::vector<T>& values) {
+  return values.capacity() * sizeof(T);
+}
+
+template<typename T>
+std::size_t heapSize(const std::vector<std::vector<T>>& values) {
+  std::size_t size = values.capacity() * sizeof(std::vector<T>);
+  for(const auto& nested : values) {
+    size += heapSize(nested);
+  }
+  return size;
+}
+
+template<typename T, std::size_t N>
+std::size_t heapSize(const std::array<std::vector<T>, N>& values) {
+  std::size_t size = 0;
+  for(const auto& nested : values) {
+    size += heapSize(nested);
+  }
+  return size;
+}
+
+std::size_t heapSize(const RankingInformation& ranking) {
+  std::size_t size = heapSize(ranking.substituentRanking);
+  size += heapSize(ranking.sites);
+  size += heapSize(ranking.siteRanking);
+  size += heapSize(ranking.links);
+  for(const auto& link : ranking.links) {
+    size += heapSize(link.cycleSequence);
+  }
+  return size;
+}
+
+std::size_t heapSize(const AtomStereopermutator& permutator) {
+  const Stereopermutators::Abstract& abstract = permutator.getAbstract();
+  const Stereopermutators::Feasible& feasible = permutator.getFeasible();
+
+  std::size_t size = sizeof(AtomStereopermutator) + listNodeOverhead;
+  size += heapSize(abstract.canonicalSites);
+  size += heapSize(abstract.symbolicCharacters);
+  size += heapSize(abstract.selfReferentialLinks);
+  size += heapSize(feasible.siteDistances);
+  size += heapSize(feasible.coneAngles);
+  size += heapSize(feasible.indices());
+  size += permutator.getShapePositionMap().size() * sizeof(Shapes::Vertex);
+  return size;
+}
+
+std::size_t heapSize(const BondStereopermutator& permutator) {
+  return sizeof(BondStereopermutator) + listNodeOverhead
+    + sizeof(Stereopermutations::Composite)
+    + permutator.numAssignments() * sizeof(unsigned);
+}
+
+std::size_t heapSize(const DistanceGeometry::SpatialModel::SparseBoundsMatrix& bounds) {
+  using StorageIndex = DistanceGeometry::SpatialModel::SparseBoundsMatrix::StorageIndex;
+  return (bounds.outerSize() + 1) * sizeof(StorageIndex)
+    + bounds.nonZeros() * (sizeof(double) + sizeof(StorageIndex));
+}
+
+std::size_t heapSize(const DistanceGeometry::MoleculeDGInformation& model) {
+  std::size_t size = heapSize(model.bounds);
+
+  size += heapSize(model.chiralConstraints);
+  for(const auto& constraint : model.chiralConstraints) {
+    size += heapSize(constraint.sites);
+  }
+
+  size += heapSize(model.dihedralConstraints);
+  for(const auto& constraint : model.dihedralConstraints) {
+    size += heapSize(constraint.sites);
+  }
+
+  size += model.rotatableGroups.bucket_count() * sizeof(void*);
+  for(const auto& groupPair : model.rotatableGroups) {
+    size += sizeof(groupPair) + hashNodeOverhead;
+    size += heapSize(groupPair.second.vertices);
+  }
+
+  return size;
+}
+
+//! Dense matrix of doubles
+constexpr std::size_t matrixSize(const std::size_t rows, const std::size_t cols) {
+  return rows * cols * sizeof(double);
+}
+
+} // namespace
+
+MoleculeFootprint footprint(const Molecule& molecule) {
+  const PrivateGraph& inner = molecule.graph().inner();
+
+  MoleculeFootprint footprint;
+  footprint.graph = inner.heapSize();
+  footprint.cycles = inner.cyclesHeapSize();
+
+  for(const AtomStereopermutator& permutator : molecule.stereopermutators().atomStereopermutators()) {
+    footprint.stereopermutators += heapSize(permutator);
+    footprint.ranking += heapSize(permutator.getRanking());
+  }
+  for(const BondStereopermutator& permutator : molecule.stereopermutators().bondStereopermutators()) {
+    footprint.stereopermutators += heapSize(permutator);
+  }
+
+  // Ranking depths of each atom
+  footprint.ranking += molecule.graph().N() * sizeof(unsigned);
+
+  return footprint;
+}
+
+ConformerJobFootprint conformerJobFootprint(
+  const Molecule& molecule,
+  const unsigned numConformers,
+  const DistanceGeometry::Configuration& configuration
+) {
+  const std::size_t N = molecule.graph().N();
+  // Refinement operates on four-dimensional positions
+  const std::size_t dimensions = 4 * N;
+  const bool regenerateEachStep = molecule.stereopermutators().hasUnassignedStereopermutators();
+
+  /* Unassigned stereopermutators are assigned for each conformer. Any
+   * assignment's model is representative in size.
+   */
+  Random::Engine engine;
+  const Molecule narrowed = regenerateEachStep
+    ? DistanceGeometry::Detail::narrow(molecule, engine)
+    : molecule;
+  const auto model = DistanceGeometry::gatherDGInformation(narrowed, configuration);
+  const std::size_t modelSize = heapSize(model);
+
+  ConformerJobFootprint job;
+  job.threads = std::max(
+    1u,
+    std::min(Parallel::executor()->concurrency(), numConformers)
+  );
+
+  if(regenerateEachStep) {
+    // Each thread narrows its own copy of the molecule and models it
+    job.perThread += modelSize + footprint(narrowed).total();
+  } else {
+    job.model = modelSize;
+  }
+
+  // Explicit bounds graph, its flat copy and shortest paths buffers
+  job.perThread += DistanceGeometry::ExplicitBoundsGraph {
+    narrowed.graph().inner(),
+    model.bounds
+  }.peakHeapSize();
+
+  /* Dense distance bounds, distance matrix, metric matrix and the eigenvalue
+   * decomposition's symmetric matrix and eigenvectors of metric embedding
+   */
+  job.perThread += 5 * matrixSize(N, N) + matrixSize(4, N);
+
+  // Squared distance bounds and optimizer state of refinement
+  const std::size_t refinement = matrixSize(N, N);
+  std::size_t optimizer = 0;
+  if(configuration.refinementOptimizer == DistanceGeometry::RefinementOptimizer::TrustRegion) {
+    optimizer = matrixSize(dimensions, dimensions) + matrixSize(dimensions, 8);
+  } else {
+    // Correction pairs, positions, gradients and search direction
+    optimizer = matrixSize(dimensions, 2 * lbfgsMemory + 8);
+  }
+
+  /* Batched refinement refines several conformers in one thread sharing their
+   * distance bounds
+   */
+  if(
+    !regenerateEachStep
+    && configuration.refinementBatchSize > 1
+    && configuration.refinementOptimizer == DistanceGeometry::RefinementOptimizer::Lbfgs
+    && !configuration.deferHydrogens
+    && configuration.fragmentSize == 0
+  ) {
+    const unsigned batchSize = configuration.refinementBatchSize;
+    const unsigned numBatches = (numConformers + batchSize - 1) / batchSize;
+    job.threads = std::max(
+      1u,
+      std::min(Parallel::executor()->concurrency(), numBatches)
+    );
+    optimizer *= std::min(batchSize, numConformers);
+  }
+  job.perThread += refinement + optimizer;
+
+  job.results = numConformers * (
+    sizeof(outcome::result<Utils::PositionCollection>)
+    + matrixSize(N, 3)
+  );
+
+  return job;
+}
+
+} // namespace Memory
+} // namespace Molassembler
+} // namespace Scine
@@ -0,0 +1,102 @@
+/*!@file
+ * @copyright This code is licensed under the 3-clause BSD license.
+ *   Copyright ETH Zurich, Laboratory of Physical Chemistry, Reiher Group.
+ *   See LICENSE.txt for details.
+ * @brief Approximate memory footprints of molecules and conformer generation
+ */
+
+#ifndef INCLUDE_MOLASSEMBLER_MEMORY_H
+#define INCLUDE_MOLASSEMBLER_MEMORY_H
+
+#include "Molassembler/Conformers.h"
+
+#include <cstddef>
+
+namespace Scine {
+namespace Molassembler {
+
+// Forward-declarations
+class Molecule;
+
+/**
+ * @brief Approximate memory footprints of molecules and conformer generation
+ *
+ * Sizes are estimated in bytes from container sizes and capacities and
+ * include allocator bookkeeping of node-based containers only roughly.
+ * Process-wide caches shared between molecules, like those of
+ * stereopermutation lists, are not attributed to any molecule.
+ *
+ * @code{.cpp}
+ * const auto job = Memory::conformerJobFootprint(molecule, 100);
+ * if(job.peak() > availableBytes) {
+ *   // Schedule the job on another node or with fewer threads
+ * }
+ * @endcode
+ */
+namespace Memory {
+
+//! Approximate heap memory of a molecule in bytes by constituent
+struct MoleculeFootprint {
+  //! Atoms, bonds and cached graph properties other than cycle information
+  std::size_t graph = 0;
+  //! Cached cycle information of the graph
+  std::size_t cycles = 0;
+  //! Atom and bond stereopermutators, excluding their ranking information
+  std::size_t stereopermutators = 0;
+  //! Ranking information of atom stereopermutators and ranking depths of atoms
+  std::size_t ranking = 0;
+
+  //! Sum of all constituents
+  inline std::size_t total() const {
+    return graph + cycles + stereopermutators + ranking;
+  }
+};
+
+/*! @brief Approximate heap memory of a molecule
+ *
+ * Cached properties of the graph are only included if they have been
+ * generated already.
+ *
+ * @complexity{@math{\Theta(N + B)}}
+ */
+MASM_EXPORT MoleculeFootprint footprint(const Molecule& molecule);
+
+//! Approximate heap memory of a conformer generation job in bytes
+struct ConformerJobFootprint {
+  //! Spatial model shared by all threads
+  std::size_t model = 0;
+  //! Temporary memory of each thread generating conformers
+  std::size_t perThread = 0;
+  //! Number of threads generating conformers concurrently
+  unsigned threads = 1;
+  //! Generated conformers held until the job finishes
+  std::size_t results = 0;
+
+  //! Peak heap memory of the entire job
+  inline std::size_t peak() const {
+    return model + threads * perThread + results;
+  }
+};
+
+/*! @brief Approximate peak heap memory of a conformer generation job
+ *
+ * Estimates the memory of generating @p numConformers conformers of
+ * @p molecule with generateEnsemble() or generateRandomEnsemble() using the
+ * currently set Parallel::executor(). The molecule's own memory is not
+ * included.
+ *
+ * @complexity{At least @math{O(P_2 + P_3 + P_4)} where @math{P_i} is the
+ * number of distinct paths of length @math{i} in the graph since the
+ * spatial model is gathered to determine its size}
+ */
+MASM_EXPORT ConformerJobFootprint conformerJobFootprint(
+  const Molecule& molecule,
+  unsigned numConformers,
+  const DistanceGeometry::Configuration& configuration = DistanceGeometry::Configuration {}
+);
+
+} // namespace Memory
+} // namespace Molassembler
+} // namespace Scine
+
+#endif
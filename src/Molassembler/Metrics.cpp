@@ -0,0 +1,174 @@
+/*!@file
+ * @copyright This code is licensed under the 3-clause BSD license.
+ *   Copyright ETH Zurich, Laboratory of Physical Chemistry, Reiher Group.
+ *   See LICENSE.txt for details.
+ */
+
+#include "Molassembler/Metrics.h"
+
+#include "Molassembler/Detail/Metrics.h"
+#include "Molassembler/Molecule/RankingTree.h"
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+
+namespace Scine {
+namespace Molassembler {
+namespace {
+
+constexpr unsigned dgErrorCount = static_cast<unsigned>(DgError::Cancelled);
+
+//! Separate cache lines keep threads tallying different operations apart
+struct alignas(64) OperationTally {
+  std::atomic<unsigned long> count {0};
+  std::atomic<long long> nanoseconds {0};
+};
+
+std::array<OperationTally, Detail::Metrics::operationCount> operationTallies;
+std::atomic<unsigned> maxRankingDepth {0};
+std::array<std::atomic<unsigned long>, dgErrorCount> dgFailureCounts {};
+std::atomic<unsigned long> infeasibleModelCount {0};
+
+std::atomic<std::chrono::steady_clock::rep> rankingWatchdogTicks {0};
+std::atomic<bool> rankingWatchdogGraphvizFlag {false};
+std::mutex slowRankingsMutex;
+std::vector<Metrics::SlowRanking> slowRankings;
+
+Metrics::OperationMetrics read(const Detail::Metrics::Operation operation) {
+  const OperationTally& tally = operationTallies.at(static_cast<unsigned>(operation));
+  Metrics::OperationMetrics metrics;
+  metrics.count = tally.count.load(std::memory_order_relaxed);
+  metrics.seconds = std::chrono::duration<double>(
+    std::chrono::nanoseconds(tally.nanoseconds.load(std::memory_order_relaxed))
+  ).count();
+  return metrics;
+}
+
+} // namespace
+
+namespace Detail {
+namespace Metrics {
+
+void record(const Operation operation, const std::chrono::steady_clock::duration duration) {
+  OperationTally& tally = operationTallies.at(static_cast<unsigned>(operation));
+  tally.count.fetch_add(1, std::memory_order_relaxed);
+  tally.nanoseconds.fetch_add(
+    std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count(),
+    std::memory_order_relaxed
+  );
+}
+
+void recordRankingDepth(const unsigned depth) {
+  unsigned current = maxRankingDepth.load(std::memory_order_relaxed);
+  while(
+    depth > current
+    && !maxRankingDepth.compare_exchange_weak(current, depth, std::memory_order_relaxed)
+  ) {}
+}
+
+void recordDgFailure(const DgError error) {
+  const unsigned index = static_cast<unsigned>(error);
+  if(1 <= index && index <= dgErrorCount) {
+    dgFailureCounts.at(index - 1).fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+void recordInfeasibleModel() {
+  infeasibleModelCount.fetch_add(1, std::memory_order_relaxed);
+}
+
+std::chrono::steady_clock::duration rankingWatchdogThreshold() {
+  return std::chrono::steady_clock::duration {
+    rankingWatchdogTicks.load(std::memory_order_relaxed)
+  };
+}
+
+bool rankingWatchdogGraphviz() {
+  return rankingWatchdogGraphvizFlag.load(std::memory_order_relaxed);
+}
+
+void recordSlowRanking(Molassembler::Metrics::SlowRanking report) {
+  std::lock_guard<std::mutex> lock(slowRankingsMutex);
+  if(slowRankings.size() < Molassembler::Metrics::slowRankingCapacity) {
+    slowRankings.push_back(std::move(report));
+  }
+}
+
+} // namespace Metrics
+} // namespace Detail
+
+namespace Metrics {
+
+Snapshot snapshot() {
+  using Detail::Metrics::Operation;
+
+  Snapshot snapshot;
+  snapshot.rankings = read(Operation::Ranking);
+  snapshot.maxRankingDepth = maxRankingDepth.load(std::memory_order_relaxed);
+
+  const auto rankingStatistics = RankingTree::statistics();
+  for(unsigned i = 0; i < rankingStatistics.reached.size(); ++i) {
+    snapshot.sequenceRulesReached.at(i) = rankingStatistics.reached.at(i);
+  }
+  snapshot.stereodescriptorRulesSkipped = rankingStatistics.stereodescriptorRulesSkipped;
+
+  snapshot.cycleRecomputations = read(Operation::CycleRecomputation);
+  snapshot.abstractPermutations = read(Operation::AbstractPermutations);
+  snapshot.feasiblePermutations = read(Operation::FeasiblePermutations);
+  snapshot.shapeMeasures = read(Operation::ShapeMeasure);
+  snapshot.nauty = read(Operation::Nauty);
+
+  for(unsigned i = 0; i < dgErrorCount; ++i) {
+    const unsigned long count = dgFailureCounts.at(i).load(std::memory_order_relaxed);
+    if(count > 0) {
+      snapshot.dgFailures.emplace(static_cast<DgError>(i + 1), count);
+    }
+  }
+  snapshot.infeasibleModels = infeasibleModelCount.load(std::memory_order_relaxed);
+
+  {
+    std::lock_guard<std::mutex> lock(slowRankingsMutex);
+    snapshot.slowRankings = slowRankings;
+  }
+
+  return snapshot;
+}
+
+void reset() {
+  for(OperationTally& tally : operationTallies) {
+    tally.count.store(0, std::memory_order_relaxed);
+    tally.nanoseconds.store(0, std::memory_order_relaxed);
+  }
+  maxRankingDepth.store(0, std::memory_order_relaxed);
+  for(auto& count : dgFailureCounts) {
+    count.store(0, std::memory_order_relaxed);
+  }
+  infeasibleModelCount.store(0, std::memory_order_relaxed);
+  {
+    std::lock_guard<std::mutex> lock(slowRankingsMutex);
+    slowRankings.clear();
+  }
+  RankingTree::resetStatistics();
+}
+
+void setRankingWatchdog(const RankingWatchdog& watchdog) {
+  const auto threshold = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+    std::chrono::duration<double>(std::max(watchdog.seconds, 0.0))
+  );
+  rankingWatchdogTicks.store(threshold.count(), std::memory_order_relaxed);
+  rankingWatchdogGraphvizFlag.store(watchdog.graphviz, std::memory_order_relaxed);
+}
+
+RankingWatchdog rankingWatchdog() {
+  RankingWatchdog watchdog;
+  watchdog.seconds = std::chrono::duration<double>(
+    Detail::Metrics::rankingWatchdogThreshold()
+  ).count();
+  watchdog.graphviz = Detail::Metrics::rankingWatchdogGraphviz();
+  return watchdog;
+}
+
+} // namespace Metrics
+} // namespace Molassembler
+} // namespace Scine
@@ -0,0 +1,155 @@
+/*!@file
+ * @copyright This code is licensed under the 3-clause BSD license.
+ *   Copyright ETH Zurich, Laboratory of Physical Chemistry, Reiher Group.
+ *   See LICENSE.txt for details.
+ * @brief Counters and cumulative timings of library operations
+ */
+
+#ifndef INCLUDE_MOLASSEMBLER_METRICS_H
+#define INCLUDE_MOLASSEMBLER_METRICS_H
+
+#include "Molassembler/Export.h"
+#include "Molassembler/DistanceGeometry/Error.h"
+#include "Molassembler/Types.h"
+
+#include <array>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace Scine {
+namespace Molassembler {
+
+/**
+ * @brief Counters and cumulative timings of library operations
+ *
+ * Tallies are shared by all threads and accumulate from library load or the
+ * last reset. Recording is always on and costs a clock read and a relaxed
+ * atomic increment per operation.
+ *
+ * @code{.cpp}
+ * Metrics::reset();
+ * auto ensemble = generateRandomEnsemble(molecule, 100);
+ * const Metrics::Snapshot metrics = Metrics::snapshot();
+ * std::cout << metrics.shapeMeasures.count << " shape measures in "
+ *   << metrics.shapeMeasures.seconds << "s\n";
+ * @endcode
+ */
+namespace Metrics {
+
+//! Number of times an operation was performed and their total duration
+struct OperationMetrics {
+  //! Number of operations
+  unsigned long count = 0;
+  //! Total wall clock time spent in the operations, in seconds
+  double seconds = 0;
+};
+
+/*! @brief A ranking reported by the ranking watchdog
+ *
+ * @see setRankingWatchdog
+ */
+struct SlowRanking {
+  //! Atom whose substituents were ranked
+  AtomIndex atom;
+  //! Wall time the ranking had taken when it was reported, in seconds
+  double seconds;
+  //! Depth of the deepest expanded ranking tree vertex
+  unsigned depth;
+  //! Number of ranking tree vertices
+  unsigned treeSize;
+  //! Sequence rule being evaluated, one to five
+  unsigned sequenceRule;
+  //! Whether the ranking had finished when it was reported
+  bool finished;
+  //! Graphviz representation of the ranking tree if requested, else empty
+  std::string graphviz;
+};
+
+//! Settings of the ranking watchdog
+struct RankingWatchdog {
+  //! Wall time after which a ranking is reported, in seconds. Off if zero
+  double seconds = 0;
+  //! Whether reports include a graphviz representation of the ranking tree
+  bool graphviz = false;
+};
+
+//! Tallies of library operations at a point in time
+struct Snapshot {
+  //! Substituent rankings of atoms by ranking trees
+  OperationMetrics rankings;
+  //! Maximal depth of any ranking tree
+  unsigned maxRankingDepth = 0;
+  /*! Number of rankings reaching each sequence rule, indexed by rule minus one
+   *
+   * @see RankingTree::statistics
+   */
+  std::array<unsigned long, 5> sequenceRulesReached {};
+  //! Number of rankings skipping sequence rules three to five
+  unsigned long stereodescriptorRulesSkipped = 0;
+  //! Cycle data recomputations of graphs after modification
+  OperationMetrics cycleRecomputations;
+  //! Constructions of abstract atom stereopermutations
+  OperationMetrics abstractPermutations;
+  //! Constructions of feasible atom stereopermutations
+  OperationMetrics feasiblePermutations;
+  //! Continuous shape measure calculations
+  OperationMetrics shapeMeasures;
+  //! Graph canonicalizations by nauty
+  OperationMetrics nauty;
+  /*! Number of conformers by error that the conformer generation functions of
+   * Conformers.h failed to generate, only listing errors that occurred
+   */
+  std::map<DgError, unsigned long> dgFailures;
+  /*! Number of spatial models shared between conformers that were diagnosed
+   * as unable to yield any conformer before generation was attempted
+   */
+  unsigned long infeasibleModels = 0;
+  /*! Rankings reported by the ranking watchdog, at most the first
+   * slowRankingCapacity
+   */
+  std::vector<SlowRanking> slowRankings;
+};
+
+//! Maximum number of reports kept by the ranking watchdog
+constexpr unsigned slowRankingCapacity = 64;
+
+//! Reads all tallies
+MASM_EXPORT Snapshot snapshot();
+
+/*! @brief Sets the ranking watchdog, which is off by default
+ *
+ * Rankings running longer than the watchdog's wall time are reported with
+ * their ranked atom, tree size and depth and the sequence rule being
+ * evaluated. Running rankings are checked whenever their tree grows by 256
+ * vertices and on each breadth-first step of sequence rules two to five, so
+ * pathological rankings are reported while they run, even if they are
+ * cancelled or never finish. Rankings that finish past the wall time without
+ * having been reported are reported on completion. Graphviz representations
+ * can be large and are only included if requested.
+ *
+ * @code{.cpp}
+ * Metrics::setRankingWatchdog({5.0, true});
+ * Molecule molecule = IO::read("pathological.mol");
+ * for(const Metrics::SlowRanking& report : Metrics::snapshot().slowRankings) {
+ *   std::ofstream("ranking-" + std::to_string(report.atom) + ".dot") << report.graphviz;
+ * }
+ * @endcode
+ */
+MASM_EXPORT void setRankingWatchdog(const RankingWatchdog& watchdog);
+
+//! Current ranking watchdog settings
+MASM_EXPORT RankingWatchdog rankingWatchdog();
+
+/*! @brief Zeroes all tallies, including the ranking tree sequence rule
+ *   statistics, and discards ranking watchdog reports
+ *
+ * The ranking watchdog settings are kept.
+ */
+MASM_EXPORT void reset();
+
+} // namespace Metrics
+} // namespace Molassembler
+} // namespace Scine
+
+#endif
@@ -16,6 +16,8 @@
 #include "Molassembler/Modeling/AtomInfo.h"
 #include "Molassembler/Graph.h"
 
+#include <array>
+
 namespace Scine {
 namespace Molassembler {
 namespace ShapeInference {
@@ -30,65 +32,74 @@ const std::map<BondType, double> bondWeights {
   {BondType::Eta, 0.0}
 };
 
-boost::optional<Shapes::Shape> vsepr(
-  const Utils::ElementType centerAtomType,
-  const std::vector<BindingSite>& sites,
-  const int formalCharge
-) {
-  const unsigned nSites = sites.size();
-
-  if(nSites <= 1) {
-    throw std::logic_error(
-      "Don't use a model on terminal atoms! Single bonds don't "
-      "have stereochemistry!"
-    );
+namespace {
+
+//! Same as bondWeights, without the map lookup
+double bondWeight(const BondType bondType) {
+  switch(bondType) {
+    case BondType::Single: return 1.0;
+    case BondType::Double: return 2.0;
+    case BondType::Triple: return 3.0;
+    case BondType::Quadruple: return 4.0;
+    case BondType::Quintuple: return 5.0;
+    case BondType::Sextuple: return 6.0;
+    case BondType::Eta: return 0.0;
+    default: return bondWeights.at(bondType);
   }
+}
 
-  if(!AtomInfo::isMainGroupElement(centerAtomType)) {
-    return boost::none;
-  }
+//! Electron counts of an element needed for shape inference
+struct ElementElectrons {
+  bool mainGroup = false;
+  //! Valence electrons in s and p shells, as used in VSEPR
+  unsigned vseprValenceElectrons = 0;
+  //! All valence electrons, as used in formal charges
+  int valenceElectrons = 0;
+};
 
-  /* Make sure the ligand set doesn't include multiple atoms on a site.
-   * VSEPR shouldn't try to handle haptic ligands.
-   */
-  if(
-    std::any_of(
-      sites.begin(),
-      sites.end(),
-      [](const auto& ligand) -> bool {
-        return ligand.elements.size() > 1;
-      }
-    )
-  ) {
-    return boost::none;
-  }
+using ElementElectronsTable = std::array<
+  ElementElectrons,
+  std::tuple_size<decltype(AtomInfo::elementData)>::value
+>;
 
-  // get uncharged VE count, returns none if not a main group element
-  auto veOption = Molassembler::AtomInfo::mainGroupVE(centerAtomType);
+/*! @brief Electron counts of all elements with atom info data by Z
+ *
+ * Shape inference is run for each ranked atom, so the counts are looked up
+ * once instead of being collected from shells each time
+ */
+const ElementElectronsTable& elementElectrons() {
+  static const auto table = []() {
+    ElementElectronsTable electrons;
+    for(unsigned Z = 1; Z < electrons.size(); ++Z) {
+      const Utils::ElementType element = Utils::ElementInfo::element(Z);
+      if(AtomInfo::isMainGroupElement(element)) {
+        electrons.at(Z).mainGroup = true;
+        electrons.at(Z).vseprValenceElectrons = AtomInfo::mainGroupVE(element).value();
+        electrons.at(Z).valenceElectrons = AtomInfo::elementData.at(Z).valenceElectrons();
+      }
+    }
+    return electrons;
+  }();
+  return table;
+}
 
-  if(!veOption) {
-    return boost::none;
+//! Pairs off electrons into non-bonding pairs, yielding the formal charge
+int unpairedCharge(int valenceElectrons) {
+  if(valenceElectrons > 0) {
+    // Make any electrons that we can pair off non-bonding electron pairs
+    int freeElectronPairs = valenceElectrons / 2;
+    valenceElectrons -= 2 * freeElectronPairs;
   }
 
-  /* calculate X, E (VSEPR parameters). X is the number of connected atoms and E
-   * is the number of non-bonding electron pairs
-   */
-  const unsigned X = nSites;
-  const int E = std::ceil(
-    (
-      static_cast<double>(veOption.value())
-      - formalCharge
-      - std::accumulate(
-        sites.begin(),
-        sites.end(),
-        0.0,
-        [](const double carry, const auto& ligand) -> double {
-          return carry + bondWeights.at(ligand.bondType);
-        }
-      )
-    ) / 2.0
-  );
+  return valenceElectrons;
+}
 
+/*! @brief Shape from the VSEPR parameters
+ *
+ * @param X Number of connected atoms
+ * @param E Number of non-bonding electron pairs
+ */
+boost::optional<Shapes::Shape> vseprShape(const unsigned X, const int E) {
   if(E < 0) {
     // "For some reason, E is < 0 in VSEPR. That shouldn't happen."
     return boost::none;
@@ -142,21 +153,90 @@ boost::optional<Shapes::Shape> vsepr(
   }
 }
 
-Shapes::Shape firstOfSize(const unsigned size) {
-  // Pick the first shape of fitting size
-  const auto findIter = std::find_if(
-    std::begin(Shapes::allShapes),
-    std::end(Shapes::allShapes),
-    [&size](const auto shape) -> bool {
-      return Shapes::size(shape) == size;
-    }
+//! Number of non-bonding electron pairs in VSEPR
+int vseprE(
+  const unsigned valenceElectrons,
+  const int formalCharge,
+  const double siteBondWeights
+) {
+  return std::ceil(
+    (static_cast<double>(valenceElectrons) - formalCharge - siteBondWeights) / 2.0
+  );
+}
+
+void throwIfTerminal(const unsigned nSites) {
+  if(nSites <= 1) {
+    throw std::logic_error(
+      "Don't use a model on terminal atoms! Single bonds don't "
+      "have stereochemistry!"
+    );
+  }
+}
+
+} // namespace
+
+boost::optional<Shapes::Shape> vsepr(
+  const Utils::ElementType centerAtomType,
+  const std::vector<BindingSite>& sites,
+  const int formalCharge
+) {
+  const unsigned nSites = sites.size();
+  throwIfTerminal(nSites);
+
+  if(!AtomInfo::isMainGroupElement(centerAtomType)) {
+    return boost::none;
+  }
+
+  /* Make sure the ligand set doesn't include multiple atoms on a site.
+   * VSEPR shouldn't try to handle haptic ligands.
+   */
+  if(
+    std::any_of(
+      sites.begin(),
+      sites.end(),
+      [](const auto& ligand) -> bool {
+        return ligand.elements.size() > 1;
+      }
+    )
+  ) {
+    return boost::none;
+  }
+
+  // get uncharged VE count, returns none if not a main group element
+  auto veOption = Molassembler::AtomInfo::mainGroupVE(centerAtomType);
+
+  if(!veOption) {
+    return boost::none;
+  }
+
+  /* calculate X, E (VSEPR parameters). X is the number of connected atoms and E
+   * is the number of non-bonding electron pairs
+   */
+  const unsigned X = nSites;
+  const int E = vseprE(
+    veOption.value(),
+    formalCharge,
+    std::accumulate(
+      sites.begin(),
+      sites.end(),
+      0.0,
+      [](const double carry, const auto& ligand) -> double {
+        return carry + bondWeight(ligand.bondType);
+      }
+    )
   );
 
-  if(findIter == std::end(Shapes::allShapes)) {
+  return vseprShape(X, E);
+}
+
+Shapes::Shape firstOfSize(const unsigned size) {
+  // Pick the first shape of fitting size
+  const auto& shapes = Shapes::shapesOfSize(size);
+  if(shapes.empty()) {
     throw std::runtime_error("No shapes of that size!");
   }
 
-  return *findIter;
+  return shapes.front();
 }
 
 std::vector<BindingSite> reduceToSiteInformation(
@@ -213,21 +293,15 @@ int formalCharge(
     ).valenceElectrons();
 
     for(const AtomIndex adjacent : graph.adjacents(index)) {
-      valenceElectrons -= bondWeights.at(
+      valenceElectrons -= bondWeight(
         graph.bondType(
           *graph.bond(index, adjacent)
         )
       );
     }
 
-    if(valenceElectrons > 0) {
-      // Make any electrons that we can pair off non-bonding electron pairs
-      int freeElectronPairs = valenceElectrons / 2;
-      valenceElectrons -= 2 * freeElectronPairs;
-    }
-
     // Assign the result of our calculation to formal charge
-    formalCharge = valenceElectrons;
+    formalCharge = unpairedCharge(valenceElectrons);
   }
 
   return formalCharge;
@@ -238,11 +312,46 @@ boost::optional<Shapes::Shape> inferShape(
   const AtomIndex index,
   const RankingInformation& ranking
 ) {
-  // So long as only VSEPR is implemented, this function is very simple:
-  return vsepr(
-    graph.elementType(index),
-    reduceToSiteInformation(graph, index, ranking),
-    formalCharge(graph, index)
+  const Utils::ElementType element = graph.elementType(index);
+  const unsigned Z = Utils::ElementInfo::Z(element);
+  if(Z == 0 || Z >= elementElectrons().size()) {
+    // So long as only VSEPR is implemented, this function is very simple:
+    return vsepr(
+      element,
+      reduceToSiteInformation(graph, index, ranking),
+      formalCharge(graph, index)
+    );
+  }
+
+  /* Same as VSEPR on the reduced site information, but the result depends
+   * only on a few counts, which are collected without reducing the sites
+   */
+  const unsigned X = ranking.sites.size();
+  throwIfTerminal(X);
+
+  const ElementElectrons& electrons = elementElectrons().at(Z);
+  if(!electrons.mainGroup) {
+    return boost::none;
+  }
+
+  double siteBondWeights = 0.0;
+  for(const auto& site : ranking.sites) {
+    // VSEPR shouldn't try to handle haptic ligands
+    if(site.size() > 1) {
+      return boost::none;
+    }
+
+    siteBondWeights += bondWeight(graph.bondType(BondIndex {index, site.front()}));
+  }
+
+  int valenceElectrons = electrons.valenceElectrons;
+  for(const AtomIndex adjacent : graph.adjacents(index)) {
+    valenceElectrons -= bondWeight(graph.bondType(BondIndex {index, adjacent}));
+  }
+
+  return vseprShape(
+    X,
+    vseprE(electrons.vseprValenceElectrons, unpairedCharge(valenceElectrons), siteBondWeights)
   );
 }
 
@@ -7,8 +7,21 @@
 #include "Molassembler/Molecule/MoleculeImpl.h"
 #include "Molassembler/RankingInformation.h"
 
+#include <exception>
+
 namespace Scine {
 namespace Molassembler {
+namespace {
+
+//! Whether hashing with a components bitmask reads stereopermutators
+bool readsStereopermutators(const AtomEnvironmentComponents componentBitmask) {
+  return componentBitmask & (
+    AtomEnvironmentComponents::Shapes
+    | AtomEnvironmentComponents::Stereopermutations
+  );
+}
+
+} // namespace
 
 Utils::AtomCollection Molecule::applyCanonicalizationMap(
   const std::vector<AtomIndex>& canonicalizationIndexMap,
@@ -20,26 +33,77 @@ Utils::AtomCollection Molecule::applyCanonicalizationMap(
   );
 }
 
+Molecule Molecule::shapesFromPositions(
+  Graph graph,
+  const AngstromPositions& positions,
+  const Molecule* rankingTemplatePtr
+) {
+  Molecule molecule;
+  molecule.pImpl_ = ImplPtr {
+    std::make_shared<Impl>(
+      std::move(graph),
+      positions,
+      boost::none,
+      rankingTemplatePtr != nullptr ? &rankingTemplatePtr->stereopermutators() : nullptr,
+      true
+    )
+  };
+  return molecule;
+}
+
+Molecule Molecule::lazy(Graph graph) {
+  Molecule molecule;
+  molecule.pImpl_ = ImplPtr {
+    std::make_shared<Impl>(std::move(graph), true)
+  };
+  return molecule;
+}
+
 /* Molecule interface to Impl call forwards */
 Molecule::Molecule() noexcept : pImpl_(
-  std::make_unique<Impl>()
+  std::make_shared<Impl>()
 ) {}
 
 Molecule::Molecule(Molecule&& other) noexcept = default;
 Molecule& Molecule::operator = (Molecule&& rhs) noexcept = default;
 
-Molecule::Molecule(const Molecule& other) : pImpl_(
-  std::make_unique<Impl>(*other.pImpl_)
-) {}
-Molecule& Molecule::operator = (const Molecule& rhs) {
-  *pImpl_ = *rhs.pImpl_;
-  return *this;
+/* Copies share the implementation until either of them is modified. The
+ * graph's cached properties are generated safely on concurrent const access
+ * of either copy.
+ */
+Molecule::Molecule(const Molecule& other) = default;
+Molecule& Molecule::operator = (const Molecule& rhs) = default;
+
+Molecule::Impl* Molecule::ImplPtr::operator -> () {
+  detach_();
+  ptr_->withStereopermutators();
+  return ptr_.get();
+}
+
+Molecule::Impl& Molecule::ImplPtr::operator * () {
+  detach_();
+  ptr_->withStereopermutators();
+  return *ptr_;
+}
+
+Molecule::Impl& Molecule::ImplPtr::deferred() {
+  detach_();
+  return *ptr_;
+}
+
+void Molecule::ImplPtr::detach_() {
+  if(ptr_.use_count() > 1) {
+    ptr_ = std::make_shared<Impl>(*ptr_);
+  } else {
+    // Unshared implementations are about to be modified
+    ptr_->invalidateCanonicalForms();
+  }
 }
 
 Molecule::~Molecule() = default;
 
 Molecule::Molecule(const Utils::ElementType element) noexcept : pImpl_(
-  std::make_unique<Impl>(element)
+  std::make_shared<Impl>(element)
 ) {}
 
 Molecule::Molecule(
@@ -47,11 +111,11 @@ Molecule::Molecule(
   const Utils::ElementType b,
   const BondType bondType
 ) noexcept : pImpl_(
-  std::make_unique<Impl>(a, b, bondType)
+  std::make_shared<Impl>(a, b, bondType)
 ) {}
 
 Molecule::Molecule(Graph graph) : pImpl_(
-  std::make_unique<Impl>(std::move(graph))
+  std::make_shared<Impl>(std::move(graph))
 ) {}
 
 Molecule::Molecule(
@@ -61,19 +125,35 @@ Molecule::Molecule(
     std::vector<BondIndex>
   >& bondStereopermutatorCandidatesOptional
 ) : pImpl_(
-  std::make_unique<Impl>(
+  std::make_shared<Impl>(
     std::move(graph),
     positions,
     bondStereopermutatorCandidatesOptional
   )
 ) {}
 
+Molecule::Molecule(
+  Graph graph,
+  const AngstromPositions& positions,
+  const boost::optional<
+    std::vector<BondIndex>
+  >& bondStereopermutatorCandidatesOptional,
+  const Molecule& rankingTemplate
+) : pImpl_(
+  std::make_shared<Impl>(
+    std::move(graph),
+    positions,
+    bondStereopermutatorCandidatesOptional,
+    &rankingTemplate.stereopermutators()
+  )
+) {}
+
 Molecule::Molecule(
   Graph graph,
   StereopermutatorList stereopermutators,
   boost::optional<AtomEnvironmentComponents> canonicalComponentsOption
 ) : pImpl_(
-  std::make_unique<Impl>(
+  std::make_shared<Impl>(
     std::move(graph),
     std::move(stereopermutators),
     std::move(canonicalComponentsOption)
@@ -129,16 +209,35 @@ void Molecule::assignStereopermutatorRandomly(
   pImpl_->assignStereopermutatorRandomly(e, engine);
 }
 
+void Molecule::beginEdits() {
+  pImpl_->beginEdits();
+}
+
 std::vector<AtomIndex> Molecule::canonicalize(
   const AtomEnvironmentComponents componentBitmask
 ) {
-  return pImpl_->canonicalize(componentBitmask);
+  if(readsStereopermutators(componentBitmask)) {
+    return pImpl_->canonicalize(componentBitmask);
+  }
+
+  /* Detection is equivariant under index permutations, so detection can stay
+   * deferred until after canonicalization
+   */
+  return pImpl_.deferred().canonicalize(componentBitmask);
+}
+
+void Molecule::commitEdits() {
+  pImpl_->commitEdits();
 }
 
 void Molecule::removeAtom(const AtomIndex a) {
   pImpl_->removeAtom(a);
 }
 
+void Molecule::removeAtoms(std::vector<AtomIndex> atoms) {
+  pImpl_->removeAtoms(std::move(atoms));
+}
+
 void Molecule::removeBond(
   const AtomIndex a,
   const AtomIndex b
@@ -188,7 +287,7 @@ boost::optional<Shapes::Shape> Molecule::inferShape(
 }
 
 std::string Molecule::dumpGraphviz() const {
-  return pImpl_->dumpGraphviz();
+  return pImpl_->withStereopermutators().dumpGraphviz();
 }
 
 const Graph& Molecule::graph() const {
@@ -196,11 +295,36 @@ const Graph& Molecule::graph() const {
 }
 
 std::size_t Molecule::hash() const {
+  const auto componentsOption = pImpl_->canonicalComponents();
+  if(componentsOption && readsStereopermutators(componentsOption.value())) {
+    return pImpl_->withStereopermutators().hash();
+  }
+
   return pImpl_->hash();
 }
 
+Fingerprint Molecule::fingerprint(const AtomEnvironmentComponents componentBitmask) const {
+  if(readsStereopermutators(componentBitmask)) {
+    return pImpl_->withStereopermutators().fingerprint(componentBitmask);
+  }
+
+  return pImpl_->fingerprint(componentBitmask);
+}
+
+Fingerprint Molecule::invariantFingerprint(const AtomEnvironmentComponents componentBitmask) const {
+  if(readsStereopermutators(componentBitmask)) {
+    return pImpl_->withStereopermutators().invariantFingerprint(componentBitmask);
+  }
+
+  return pImpl_->invariantFingerprint(componentBitmask);
+}
+
+Fingerprint Molecule::constitutionalFingerprint() const {
+  return pImpl_->constitutionalFingerprint();
+}
+
 const StereopermutatorList& Molecule::stereopermutators() const {
-  return pImpl_->stereopermutators();
+  return pImpl_->withStereopermutators().stereopermutators();
 }
 
 StereopermutatorList Molecule::inferStereopermutatorsFromPositions(
@@ -209,16 +333,35 @@ StereopermutatorList Molecule::inferStereopermutatorsFromPositions(
     std::vector<BondIndex>
   >& explicitBondStereopermutatorCandidatesOption
 ) const {
-  return pImpl_->inferStereopermutatorsFromPositions(
+  return pImpl_->withStereopermutators().inferStereopermutatorsFromPositions(
     angstromWrapper,
     explicitBondStereopermutatorCandidatesOption
   );
 }
 
+std::vector<StereopermutatorList> Molecule::inferStereopermutatorsFromFrames(
+  const std::vector<AngstromPositions>& frames,
+  const boost::optional<
+    std::vector<BondIndex>
+  >& explicitBondStereopermutatorCandidatesOption
+) const {
+  return pImpl_->withStereopermutators().inferStereopermutatorsFromFrames(
+    frames,
+    explicitBondStereopermutatorCandidatesOption
+  );
+}
+
 bool Molecule::canonicalCompare(
   const Molecule& other,
   const AtomEnvironmentComponents componentBitmask
 ) const {
+  if(readsStereopermutators(componentBitmask)) {
+    return pImpl_->withStereopermutators().canonicalCompare(
+      other.pImpl_->withStereopermutators(),
+      componentBitmask
+    );
+  }
+
   return pImpl_->canonicalCompare(*other.pImpl_, componentBitmask);
 }
 
@@ -226,11 +369,18 @@ boost::optional<std::vector<AtomIndex>> Molecule::modularIsomorphism(
   const Molecule& other,
   const AtomEnvironmentComponents componentBitmask
 ) const {
+  if(readsStereopermutators(componentBitmask)) {
+    return pImpl_->withStereopermutators().modularIsomorphism(
+      other.pImpl_->withStereopermutators(),
+      componentBitmask
+    );
+  }
+
   return pImpl_->modularIsomorphism(*other.pImpl_, componentBitmask);
 }
 
 std::string Molecule::str() const {
-  return pImpl_->str();
+  return pImpl_->withStereopermutators().str();
 }
 
 RankingInformation Molecule::rankPriority(
@@ -238,16 +388,174 @@ RankingInformation Molecule::rankPriority(
   const std::vector<AtomIndex>& excludeAdjacent,
   const boost::optional<AngstromPositions>& positionsOption
 ) const {
-  return pImpl_->rankPriority(a, excludeAdjacent, positionsOption);
+  return pImpl_->withStereopermutators().rankPriority(a, excludeAdjacent, positionsOption);
 }
 
 /* Operators */
 bool Molecule::operator == (const Molecule& other) const {
-  return *pImpl_ == *other.pImpl_;
+  if(pImpl_.shares(other.pImpl_)) {
+    return true;
+  }
+
+  return pImpl_->withStereopermutators() == other.pImpl_->withStereopermutators();
 }
 
 bool Molecule::operator != (const Molecule& other) const {
-  return *pImpl_ != *other.pImpl_;
+  return !(*this == other);
+}
+
+std::vector<std::vector<AtomIndex>> canonicalize(
+  std::vector<Molecule>& molecules,
+  const AtomEnvironmentComponents componentBitmask
+) {
+  const unsigned M = molecules.size();
+  std::vector<std::vector<AtomIndex>> permutations(M);
+
+  /* Exceptions cannot leave the parallel region, so the first one is kept and
+   * rethrown once all threads are done
+   */
+  std::exception_ptr exception;
+
+#pragma omp parallel for schedule(dynamic)
+  for(unsigned i = 0; i < M; ++i) {
+    try {
+      permutations[i] = molecules[i].canonicalize(componentBitmask);
+    } catch(...) {
+#pragma omp critical(canonicalizeException)
+      {
+        if(!exception) {
+          exception = std::current_exception();
+        }
+      }
+    }
+  }
+
+  if(exception) {
+    std::rethrow_exception(exception);
+  }
+
+  return permutations;
+}
+
+std::vector<std::size_t> hashes(const std::vector<Molecule>& molecules) {
+  const unsigned M = molecules.size();
+  std::vector<std::size_t> result(M);
+
+#pragma omp parallel for schedule(dynamic)
+  for(unsigned i = 0; i < M; ++i) {
+    result[i] = molecules[i].hash();
+  }
+
+  return result;
+}
+
+InvariantSignature::InvariantSignature(
+  const Molecule& molecule,
+  const AtomEnvironmentComponents componentBitmask
+) : components(componentBitmask),
+    numAtoms(molecule.graph().N()),
+    numBonds(molecule.graph().B()),
+    fingerprint(molecule.invariantFingerprint(componentBitmask))
+{}
+
+bool InvariantSignature::compatible(const InvariantSignature& other) const {
+  if(components != other.components) {
+    throw std::logic_error("Signatures with different components are not comparable");
+  }
+
+  return (
+    numAtoms == other.numAtoms
+    && numBonds == other.numBonds
+    && fingerprint == other.fingerprint
+  );
+}
+
+boost::optional<std::vector<AtomIndex>> modularIsomorphism(
+  const Molecule& a,
+  const InvariantSignature& aSignature,
+  const Molecule& b,
+  const InvariantSignature& bSignature
+) {
+  if(!aSignature.compatible(bSignature)) {
+    return boost::none;
+  }
+
+  return a.modularIsomorphism(b, aSignature.components);
+}
+
+std::vector<
+  boost::optional<std::vector<AtomIndex>>
+> modularIsomorphisms(
+  const Molecule& query,
+  const std::vector<Molecule>& candidates,
+  const AtomEnvironmentComponents componentBitmask
+) {
+  const unsigned C = candidates.size();
+  std::vector<boost::optional<InvariantSignature>> candidateSignatures(C);
+
+#pragma omp parallel for schedule(dynamic)
+  for(unsigned i = 0; i < C; ++i) {
+    candidateSignatures[i] = InvariantSignature {candidates[i], componentBitmask};
+  }
+
+  std::vector<InvariantSignature> signatures;
+  signatures.reserve(C);
+  for(const auto& signatureOption : candidateSignatures) {
+    signatures.push_back(signatureOption.value());
+  }
+
+  return modularIsomorphisms(
+    query,
+    InvariantSignature {query, componentBitmask},
+    candidates,
+    signatures
+  );
+}
+
+std::vector<
+  boost::optional<std::vector<AtomIndex>>
+> modularIsomorphisms(
+  const Molecule& query,
+  const InvariantSignature& querySignature,
+  const std::vector<Molecule>& candidates,
+  const std::vector<InvariantSignature>& candidateSignatures
+) {
+  if(candidates.size() != candidateSignatures.size()) {
+    throw std::invalid_argument("Number of candidates and signatures do not match");
+  }
+
+  const unsigned C = candidates.size();
+  std::vector<boost::optional<std::vector<AtomIndex>>> results(C);
+
+  /* Exceptions cannot leave the parallel region, so the first one is kept and
+   * rethrown once all threads are done
+   */
+  std::exception_ptr exception;
+
+#pragma omp parallel for schedule(dynamic)
+  for(unsigned i = 0; i < C; ++i) {
+    try {
+      results[i] = modularIsomorphism(
+        query,
+        querySignature,
+        candidates[i],
+        candidateSignatures[i]
+      );
+    } catch(...) {
+#pragma omp critical(modularIsomorphismsException)
+      {
+        if(!exception) {
+          exception = std::current_exception();
+        }
+      }
+    }
+  }
+
+  if(exception) {
+    std::rethrow_exception(exception);
+  }
+
+  return results;
 }
 
 
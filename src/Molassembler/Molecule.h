@@ -69,6 +69,14 @@ struct RankingInformation;
  *   - @math{\Theta} implies that the function grow asymptotically as fast as
  *   - @math{\Omega} implies that the function grows asympotically at least as fast as (Knuth definition)
  * @endparblock
+ *
+ * @parblock@note
+ *   Copies of a molecule share their state until either copy is modified,
+ *   so copying is cheap. The modified copy then duplicates the shared state.
+ *   References previously obtained from its graph() or stereopermutators()
+ *   continue to refer to the state of the unmodified copies and must be
+ *   fetched anew.
+ * @endparblock
  */
 class MASM_EXPORT Molecule {
 public:
@@ -88,6 +96,49 @@ public:
     const std::vector<AtomIndex>& canonicalizationIndexMap,
     const Utils::AtomCollection& atomCollection
   );
+
+  /*! @brief Construct from connectivity and positions, classifying only the
+   *   shapes of atoms
+   *
+   * Atoms are ranked from the graph alone. Atom stereopermutators take the
+   * shapes realized in the positions, but are left unassigned. No bond
+   * stereopermutators are instantiated.
+   *
+   * @param graph The graph from which to construct the molecule
+   * @param positions Atom positions to classify shapes with
+   * @param rankingTemplatePtr If not null, a molecule with identical graph
+   *   constructed likewise whose rankings are reused
+   *
+   * @warning This function is not intended for library consumers. It is used
+   *   internally in implementation details.
+   */
+  MASM_NO_EXPORT static Molecule shapesFromPositions(
+    Graph graph,
+    const AngstromPositions& positions,
+    const Molecule* rankingTemplatePtr = nullptr
+  );
+
+  /*! @brief Construct from connectivity alone, deferring ranking and
+   *   stereopermutator instantiation until they are first needed
+   *
+   * Yields the same molecule as the graph constructor. Stereopermutators are
+   * inferred from the graph on the first access to them, e.g. through
+   * stereopermutators(), str(), modification, comparisons or serialization.
+   * Hashes, fingerprints, canonicalization and comparisons with components
+   * excluding shapes and stereopermutations do not need stereopermutators,
+   * so loading molecules for constitution-only purposes need not rank atoms
+   * at all.
+   *
+   * Deferred instantiation is safe on concurrent const access of the
+   * molecule or its copies.
+   *
+   * @complexity{@math{\Theta(V + E)} for the graph. Rankings and
+   * stereopermutator instantiations as for the graph constructor on first
+   * access}
+   * @throws std::logic_error If the supplied graph has multiple connected
+   *   components or there are less than 2 atoms
+   */
+  static Molecule lazy(Graph graph);
 //!@}
 
 //!@name Special member functions
@@ -180,6 +231,29 @@ public:
     StereopermutatorList stereopermutators,
     boost::optional<AtomEnvironmentComponents> canonicalComponentsOption = boost::none
   );
+
+  /*! @brief Construct from connectivity and positions, reusing the rankings
+   *   of a molecule with identical graph
+   *
+   * The rankings of the template's atom stereopermutators are reused instead
+   * of ranking atoms anew if neither the template nor the fitted
+   * stereopermutators are stereogenic. Otherwise, this is equivalent to the
+   * connectivity and positions constructor.
+   *
+   * @pre @p graph is identical to the template's graph, including the atom
+   *   order.
+   *
+   * @warning This function is not intended for library consumers. It is used
+   *   internally in implementation details.
+   */
+  MASM_NO_EXPORT Molecule(
+    Graph graph,
+    const AngstromPositions& positions,
+    const boost::optional<
+      std::vector<BondIndex>
+    >& bondStereopermutatorCandidatesOptional,
+    const Molecule& rankingTemplate
+  );
 //!@}
 
 //!@name Modifiers
@@ -375,6 +449,25 @@ public:
    */
   void assignStereopermutatorRandomly(const BondIndex& e, Random::Engine& engine = randomnessEngine());
 
+  /*! @brief Defers stereopermutator propagation of graph edits until
+   *   commitEdits
+   *
+   * Graph edits (adding and removing atoms and bonds, changing bond and
+   * element types) ordinarily re-rank and propagate stereopermutators in the
+   * vicinity of each edit. Within a batched edit, only the edited atoms are
+   * recorded, and the vicinity of all of them is re-ranked once on commit.
+   * Atoms edited more than once are re-ranked before each further edit, since
+   * stereopermutator propagation handles only a single site change at a time.
+   *
+   * @complexity{@math{\Theta(1)}}
+   *
+   * @note Until commitEdits() is called, stereopermutators() may not reflect
+   *   the edits made. Any other modification of the molecule, e.g.
+   *   stereopermutator assignment or canonicalization, commits the batched
+   *   edit first. Calling this function within a batched edit has no effect.
+   */
+  void beginEdits();
+
   /** @brief Transform the molecule to a canonical form. Invalidates all atom
    *   and bond indices.
    *
@@ -389,7 +482,7 @@ public:
    *
    * @note Use Molecule::canonicalCompare to compare instances of canonicalized
    *   molecules. If you are using the default value for @p componentBitmask,
-   *   Molecule::operator == has a shortcut for fully canonical molecules.
+   *   Molecule::operator == uses the molecule as its own canonical form.
    *
    * @post A call to canonicalComponents() yields @p components supplied here.
    *
@@ -404,6 +497,15 @@ public:
     AtomEnvironmentComponents componentBitmask = AtomEnvironmentComponents::All
   );
 
+  /*! @brief Propagates all graph edits made since beginEdits
+   *
+   * @complexity{@math{O(N + A + B)} stereopermutator updates, re-rankings and
+   * propagations}
+   *
+   * @note Does nothing outside of a batched edit
+   */
+  void commitEdits();
+
   /*! @brief Removes an atom from the graph, including bonds to it.
    *
    * Removes an atom from the molecular graph, including bonds to the atom,
@@ -429,6 +531,28 @@ public:
    */
   void removeAtom(AtomIndex a);
 
+  /*! @brief Removes several atoms from the graph, including bonds to them.
+   *
+   * Unlike repeated calls to removeAtom(), checks only once whether the
+   * remaining atoms stay connected and re-ranks and propagates
+   * stereopermutators once for the whole batch. The atoms may be supplied in
+   * any order. Atoms whose removal would disconnect the graph on their own
+   * may be removed if the remaining atoms stay connected, e.g. a methyl
+   * carbon together with its hydrogen atoms.
+   *
+   * @complexity{@math{O(N + A + B)} stereopermutator updates, re-rankings and
+   * propagations, plus @math{O(N + B)} per removed atom}
+   *
+   * @param atoms Atoms to remove, in current indexing. Duplicates are ignored.
+   *
+   * @throws std::out_of_range If any supplied index is invalid, i.e. >= N()
+   * @throws std::logic_error If removing the atoms disconnects the remaining
+   *   atoms or removes all atoms.
+   *
+   * @warning Invalidates **all** atom indices due to renumbering
+   */
+  void removeAtoms(std::vector<AtomIndex> atoms);
+
   /*! @brief Removes a bond from the graph
    *
    * Removes a bond after checking if removing that bond is safe, i.e. does not
@@ -631,6 +755,80 @@ public:
    */
   std::size_t hash() const;
 
+  /*! @brief Platform-independent 128-bit fingerprint of the canonical form
+   *
+   * Folds the atom environment hashes of the canonical form in
+   * @p componentBitmask and its bonds. Two molecules have the same
+   * fingerprint if canonicalCompare with @p componentBitmask yields true for
+   * their canonical forms, and different fingerprints otherwise except for
+   * hash collisions, whose probability is negligible even for very large
+   * sets of molecules. Fingerprints do not depend on the word size or byte
+   * order of the platform, so they can be stored and compared across
+   * machines, but may change between library versions.
+   *
+   * @complexity{@math{\Theta(N \log N)} if the molecule is canonical in
+   * exactly @p componentBitmask. Otherwise, a canonical copy is made, whose
+   * complexity dominates.}
+   *
+   * @param componentBitmask The components of the molecular graph identified
+   *   by the fingerprint
+   *
+   * @note Use fingerprints as keys of a hash set to deduplicate large sets of
+   *   molecules. Consider canonicalizing the molecules in @p componentBitmask
+   *   beforehand, e.g. in parallel with canonicalize(std::vector<Molecule>&,
+   *   AtomEnvironmentComponents), to avoid repeated canonicalizations.
+   */
+  Fingerprint fingerprint(
+    AtomEnvironmentComponents componentBitmask = AtomEnvironmentComponents::All
+  ) const;
+
+  /*! @brief Platform-independent 128-bit fingerprint of graph invariants
+   *
+   * Calculated without canonicalization by iteratively refining atom
+   * environment hashes of @p componentBitmask with those of adjacent atoms
+   * until the number of distinct hashes no longer increases. Isomorphic
+   * molecules always have the same invariant fingerprint, regardless of
+   * their atom order.
+   *
+   * @complexity{@math{O(N^2 \log N)}, but typically @math{\Theta(N \log N)}
+   * for a small number of refinement iterations}
+   *
+   * @param componentBitmask The components of the molecular graph to include
+   *
+   * @warning Some non-isomorphic molecules cannot be distinguished by
+   *   refinement (e.g. decalin and bicyclopentyl) and share their invariant
+   *   fingerprint. Use it to pre-bucket molecules and fingerprint() or
+   *   canonicalCompare() to confirm identity within buckets.
+   */
+  Fingerprint invariantFingerprint(
+    AtomEnvironmentComponents componentBitmask = AtomEnvironmentComponents::All
+  ) const;
+
+  /*! @brief Platform-independent 128-bit fingerprint of the constitution,
+   *   maintained incrementally under edits
+   *
+   * Folds atom colors refined three times from element types with the colors
+   * of adjacent atoms and bond orders. Like invariantFingerprint, it needs no
+   * canonicalization and isomorphic molecules always have the same
+   * constitutional fingerprint. Atom colors are kept with the molecule and
+   * copied along with it, and edits mark the edited atoms only. Subsequent
+   * calls recolor just the atoms within three bonds of edited atoms, so that
+   * detecting duplicates after each edit of a copy does not cost a full
+   * canonicalization or refinement.
+   *
+   * @complexity{@math{\Theta(N \log N)} on the first call, afterwards
+   * linear in the number of atoms within three bonds of edited atoms, up to
+   * a logarithmic factor}
+   *
+   * @note Safe on concurrent const access.
+   *
+   * @warning Refinement is not continued until stable, so this distinguishes
+   *   fewer molecules than invariantFingerprint. Use it to pre-bucket
+   *   molecules and fingerprint() or canonicalCompare() to confirm identity
+   *   within buckets.
+   */
+  Fingerprint constitutionalFingerprint() const;
+
   /*! @brief Provides read-only access to the list of stereopermutators
    *
    * @complexity{@math{\Theta(1)}}
@@ -664,6 +862,37 @@ public:
     >& explicitBondStereopermutatorCandidatesOption = boost::none
   ) const;
 
+  /*! @brief Generates stereopermutators for each of several sets of positions
+   *
+   * Intended for trajectories: The first frame is interpreted as in
+   * inferStereopermutatorsFromPositions(). If none of its stereopermutators
+   * are stereogenic, the remaining frames reuse its rankings and start
+   * fitting from its stereopermutators, keeping their abstract and feasible
+   * stereopermutations unless a fitted shape changes. Otherwise, or if a
+   * frame's fit yields stereogenic atoms, that frame is interpreted from
+   * scratch. Frames after the first are interpreted in parallel.
+   *
+   * @complexity{@math{\Theta(F \cdot S!)} where @math{F} is the number of
+   * frames and @math{S} is the largest shape size fitted}
+   *
+   * @param frames Wrapped positions in angstrom length units of each frame
+   * @param explicitBondStereopermutatorCandidatesOption Permits the
+   *   specification of a limited set of bonds on which BondStereopermutator
+   *   instantiation is attempted, as in inferStereopermutatorsFromPositions()
+   *
+   * @returns A list of stereopermutators for each frame, in order
+   *
+   * @throws std::out_of_range if a BondIndex in
+   *   explicitBondStereopermutatorCandidatesOption does not reference an
+   *   existing bond (irrelevant if left default).
+   */
+  std::vector<StereopermutatorList> inferStereopermutatorsFromFrames(
+    const std::vector<AngstromPositions>& frames,
+    const boost::optional<
+      std::vector<BondIndex>
+    >& explicitBondStereopermutatorCandidatesOption = boost::none
+  ) const;
+
   //! Returns a command-line interface information string
   std::string str() const;
 
@@ -766,20 +995,14 @@ public:
 //!@{
   /*! @brief Equality operator, performs most strict equality comparison
    *
-   * If both molecule instances are fully canonical, calls canonicalCompare().
-   * Otherwise calls modularIsomorphism().
+   * Compares fully canonical forms of both molecules with canonicalCompare().
+   * Canonical forms are cached in each molecule until it is modified, and
+   * copies share them until either is modified, so that repeated comparisons
+   * of the same molecules are linear in their size. Molecules that are
+   * already fully canonical are their own canonical form.
    *
-   * Implemented as
-   * @code{.cpp}
-   * if(
-   *   canonicalComponents() == AtomEnvironmentComponents::All
-   *   && other.canonicalComponents() == AtomEnvironmentComponents::All
-   * ) {
-   *   return canonicalCompare(other, AtomEnvironmentComponents::All);
-   * }
-   *
-   * return modularIsomorphism(other, AtomEnvironmentComponents::All);
-   * @endcode
+   * @complexity{Linear in the number of atoms and bonds if canonical forms
+   * are cached, otherwise as canonicalize()}
    */
   bool operator == (const Molecule& other) const;
   //! Inverts Molecule::operator ==
@@ -789,7 +1012,46 @@ public:
 private:
   //! Private implementation member
   struct Impl;
-  std::unique_ptr<Impl> pImpl_;
+
+  /*! @brief Copy-on-write pointer to the implementation
+   *
+   * Copies share the pointee. Mutable access duplicates the pointee first if
+   * it is shared, so that modifications do not affect other copies, and
+   * detects any deferred stereopermutators.
+   */
+  class ImplPtr {
+  public:
+    ImplPtr() = default;
+    explicit ImplPtr(std::shared_ptr<Impl> ptr) : ptr_(std::move(ptr)) {}
+
+    inline const Impl* operator -> () const {
+      return ptr_.get();
+    }
+    inline const Impl& operator * () const {
+      return *ptr_;
+    }
+    Impl* operator -> ();
+    Impl& operator * ();
+
+    /*! @brief Mutable access without detecting deferred stereopermutators
+     *
+     * Only for modifications that do not read stereopermutators while
+     * detection is pending.
+     */
+    Impl& deferred();
+
+    //! Whether two pointers share a pointee
+    inline bool shares(const ImplPtr& other) const {
+      return ptr_ == other.ptr_;
+    }
+
+  private:
+    void detach_();
+
+    std::shared_ptr<Impl> ptr_;
+  };
+
+  ImplPtr pImpl_;
 
   /* Allow access to implementation to editor class that enables more
    * macro-oriented editing as opposed to the low-level editing provided here
@@ -803,6 +1065,151 @@ private:
   friend class DirectedConformerGenerator;
 };
 
+/*! @brief Transforms many molecules to a canonical form in parallel
+ *
+ * Equivalent to calling Molecule::canonicalize on each molecule. Use this to
+ * canonicalize large sets of molecules, e.g. to remove duplicates.
+ *
+ * @complexity{Sum of the complexities of the molecules' canonicalizations,
+ * divided among threads}
+ *
+ * @param molecules Molecules to canonicalize in-place
+ * @param componentBitmask The components of the molecular graph to include
+ *   in the canonicalization procedure.
+ *
+ * @parblock @note This function is parallelized. Use the OMP_NUM_THREADS
+ * environment variable to control the number of threads used.
+ * @endparblock
+ *
+ * @returns For each molecule, the permutation mapping from old indices to new
+ *   as in Molecule::canonicalize
+ */
+MASM_EXPORT std::vector<std::vector<AtomIndex>> canonicalize(
+  std::vector<Molecule>& molecules,
+  AtomEnvironmentComponents componentBitmask = AtomEnvironmentComponents::All
+);
+
+/*! @brief Convolutional hashes of many molecules in parallel
+ *
+ * Equivalent to calling Molecule::hash on each molecule.
+ *
+ * @complexity{Sum of the complexities of the molecules' hashes, divided among
+ * threads}
+ *
+ * @parblock @note This function is parallelized. Use the OMP_NUM_THREADS
+ * environment variable to control the number of threads used.
+ * @endparblock
+ */
+MASM_EXPORT std::vector<std::size_t> hashes(const std::vector<Molecule>& molecules);
+
+/*! @brief Isomorphism invariants of a molecule
+ *
+ * Molecules whose signatures are incompatible cannot be isomorphic in the
+ * signatures' components. Calculate signatures once to reject most
+ * non-isomorphic pairs among many comparisons without isomorphism searches.
+ */
+struct MASM_EXPORT InvariantSignature {
+  /*! @brief Calculates the signature of a molecule
+   *
+   * @complexity{As Molecule::invariantFingerprint}
+   */
+  explicit InvariantSignature(
+    const Molecule& molecule,
+    AtomEnvironmentComponents componentBitmask = AtomEnvironmentComponents::All
+  );
+
+  //! Components of the atom environments included in the signature
+  AtomEnvironmentComponents components;
+  //! Number of atoms
+  unsigned numAtoms;
+  //! Number of bonds
+  unsigned numBonds;
+  //! Invariant fingerprint of refined atom environments
+  Fingerprint fingerprint;
+
+  /*! @brief Whether molecules with these signatures can be isomorphic
+   *
+   * @complexity{@math{\Theta(1)}}
+   *
+   * @throws std::logic_error If the signatures' components differ
+   */
+  bool compatible(const InvariantSignature& other) const;
+};
+
+/*! @brief Modular isomorphism that first rejects incompatible signatures
+ *
+ * @complexity{@math{\Theta(1)} for incompatible signatures, otherwise as
+ * Molecule::modularIsomorphism}
+ *
+ * @param a The first molecule
+ * @param aSignature The signature of @p a
+ * @param b The second molecule
+ * @param bSignature The signature of @p b, with the same components as
+ *   @p aSignature
+ *
+ * @throws std::logic_error If the signatures' components differ
+ *
+ * @returns As Molecule::modularIsomorphism with the signatures' components
+ */
+MASM_EXPORT boost::optional<std::vector<AtomIndex>> modularIsomorphism(
+  const Molecule& a,
+  const InvariantSignature& aSignature,
+  const Molecule& b,
+  const InvariantSignature& bSignature
+);
+
+/*! @brief Modular isomorphisms of a query molecule against many candidates
+ *
+ * Calculates signatures of all molecules and only searches for isomorphisms
+ * between the query and candidates with compatible signatures.
+ *
+ * @complexity{@math{O(C)} isomorphism searches for @math{C} candidates}
+ *
+ * @param query The molecule to find among the candidates
+ * @param candidates The molecules to compare the query against
+ * @param componentBitmask Components of an atom's environment to include in
+ *   isomorphism tests. May not be None.
+ *
+ * @parblock @note This function is parallelized. Use the OMP_NUM_THREADS
+ * environment variable to control the number of threads used.
+ * @endparblock
+ *
+ * @returns For each candidate, the result of
+ *   query.modularIsomorphism(candidate, componentBitmask)
+ */
+MASM_EXPORT std::vector<
+  boost::optional<std::vector<AtomIndex>>
+> modularIsomorphisms(
+  const Molecule& query,
+  const std::vector<Molecule>& candidates,
+  AtomEnvironmentComponents componentBitmask = AtomEnvironmentComponents::All
+);
+
+/*! @brief Modular isomorphisms of a query molecule against many candidates
+ *   with precalculated signatures
+ *
+ * Reuse the candidates' signatures across queries to calculate them only
+ * once.
+ *
+ * @complexity{@math{O(C)} isomorphism searches for @math{C} candidates}
+ *
+ * @throws std::invalid_argument If the numbers of candidates and signatures
+ *   do not match
+ * @throws std::logic_error If the signatures' components differ
+ *
+ * @parblock @note This function is parallelized. Use the OMP_NUM_THREADS
+ * environment variable to control the number of threads used.
+ * @endparblock
+ */
+MASM_EXPORT std::vector<
+  boost::optional<std::vector<AtomIndex>>
+> modularIsomorphisms(
+  const Molecule& query,
+  const InvariantSignature& querySignature,
+  const std::vector<Molecule>& candidates,
+  const std::vector<InvariantSignature>& candidateSignatures
+);
+
 } // namespace Molassembler
 } // namespace Scine
 
@@ -11,7 +11,8 @@
 #include "Molassembler/AtomStereopermutator.h"
 #include "Molassembler/BondStereopermutator.h"
 #include "Molassembler/StereopermutatorList.h"
-#include "Molassembler/Graph/PrivateGraph.h"
+#include "Molassembler/Graph/FrozenGraph.h"
+#include "Molassembler/Parallel.h"
 #include "Molassembler/Temple/Functional.h"
 #include "Molassembler/Temple/Adaptors/Iota.h"
 #include "Utils/Geometry/ElementInfo.h"
@@ -19,6 +20,18 @@
 namespace Scine {
 namespace Molassembler {
 namespace Hashes {
+namespace {
+
+/* The bit representation of element types is 16 bits wide storing both atomic
+ * number and atomic mass number in order to account for isotopes
+ */
+constexpr unsigned elementTypeBits = 16;
+constexpr unsigned shapeNameBits = Temple::Math::ceil(
+  Temple::Math::log(Shapes::nShapes + 1.0, 2.0)
+);
+constexpr unsigned bondsHashSectionWidth = BondInformation::hashWidth * Shapes::ConstexprProperties::maxShapeSize;
+
+} // namespace
 
 BondInformation::BondInformation(
   BondType passBondType,
@@ -103,14 +116,6 @@ WideHashType hash(
   const boost::optional<Shapes::Shape>& shapeOptional,
   const boost::optional<unsigned>& assignedOptional
 ) {
-  /* The bit representation of element types is 16 bits wide storing both atomic
-   * number and atomic mass number in order to account for isotopes
-   */
-  constexpr unsigned elementTypeBits = 16;
-  constexpr unsigned shapeNameBits = Temple::Math::ceil(
-    Temple::Math::log(Shapes::nShapes + 1.0, 2.0)
-  );
-
   static_assert(
     // Sum of information in bits we want to pack in the 128 bit hash
     (
@@ -153,8 +158,6 @@ WideHashType hash(
    *
    * This occupies 6 * 12 = 72 bits.
    */
-  constexpr unsigned bondsHashSectionWidth = BondInformation::hashWidth * Shapes::ConstexprProperties::maxShapeSize;
-
   if(bitmask & AtomEnvironmentComponents::BondOrders) {
     unsigned bondNumber = 0;
     for(const auto& bond : sortedBonds) {
@@ -190,7 +193,7 @@ WideHashType hash(
 }
 
 std::vector<BondInformation> gatherBonds(
-  const PrivateGraph& inner,
+  const FrozenGraph& graph,
   const boost::optional<const StereopermutatorList&>& stereopermutators,
   const AtomEnvironmentComponents componentsBitmask,
   const AtomIndex i
@@ -198,19 +201,20 @@ std::vector<BondInformation> gatherBonds(
   std::vector<BondInformation> bonds;
   bonds.reserve(Shapes::ConstexprProperties::maxShapeSize);
 
+  const auto adjacents = graph.adjacents(i);
+  const auto bondTypes = graph.bondTypes(i);
+  const unsigned D = graph.degree(i);
+
   if(componentsBitmask & AtomEnvironmentComponents::Stereopermutations) {
-    for(const PrivateGraph::Edge& edge : inner.edges(i)) {
-      const BondIndex bond {
-        inner.source(edge),
-        inner.target(edge)
-      };
+    for(unsigned k = 0; k < D; ++k) {
+      const BondIndex bond {i, adjacents.first[k]};
 
       if(stereopermutators) {
         auto stereopermutatorOption = stereopermutators->option(bond);
 
         if(stereopermutatorOption && stereopermutatorOption->numAssignments() > 1) {
           bonds.emplace_back(
-            inner.bondType(edge),
+            bondTypes.first[k],
             true,
             stereopermutatorOption->assigned()
           );
@@ -223,7 +227,7 @@ std::vector<BondInformation> gatherBonds(
            * molecules.
            */
           bonds.emplace_back(
-            inner.bondType(edge),
+            bondTypes.first[k],
             false,
             boost::none
           );
@@ -231,9 +235,9 @@ std::vector<BondInformation> gatherBonds(
       }
     }
   } else {
-    for(const PrivateGraph::Edge& edge : inner.edges(i)) {
+    for(const BondType bondType : bondTypes) {
       bonds.emplace_back(
-        inner.bondType(edge),
+        bondType,
         false,
         boost::none
       );
@@ -248,18 +252,134 @@ std::vector<BondInformation> gatherBonds(
   return bonds;
 }
 
+static_assert(
+  AtomEnvironment::maxBonds == Shapes::ConstexprProperties::maxShapeSize,
+  "AtomEnvironment can no longer store the bonds of the largest shape"
+);
+
+static_assert(
+  elementTypeBits + 8 * BondInformation::hashWidth == 64,
+  "The element type and the first eight bonds no longer exactly fill the lower 64 bits"
+);
+
+WideHashType AtomEnvironment::hash() const {
+  /* Same bit layout as the hash function above, but assembled in two 64-bit
+   * halves. The element type and the first eight bonds exactly fill the lower
+   * half, the remaining information is placed in the upper half.
+   */
+  std::uint64_t lower = elementType;
+  std::uint64_t upper = 0;
+  for(unsigned b = 0; b < numBonds; ++b) {
+    const unsigned offset = elementTypeBits + BondInformation::hashWidth * b;
+    if(offset < 64) {
+      lower += static_cast<std::uint64_t>(bonds[b]) << offset;
+    } else {
+      upper += static_cast<std::uint64_t>(bonds[b]) << (offset - 64);
+    }
+  }
+
+  if(shape > 0) {
+    constexpr unsigned shapeOffset = elementTypeBits + bondsHashSectionWidth - 64;
+    upper += static_cast<std::uint64_t>(shape) << shapeOffset;
+    upper += static_cast<std::uint64_t>(assignment) << (shapeOffset + shapeNameBits);
+  }
+
+  return (static_cast<WideHashType>(upper) << 64) + lower;
+}
+
+boost::optional<AtomEnvironment> gatherEnvironment(
+  const FrozenGraph& graph,
+  const boost::optional<const StereopermutatorList&>& stereopermutators,
+  const AtomEnvironmentComponents bitmask,
+  const AtomIndex i
+) {
+  AtomEnvironment environment;
+  environment.elementType = 0;
+  if(bitmask & AtomEnvironmentComponents::ElementTypes) {
+    environment.elementType = static_cast<std::uint32_t>(graph.elementType(i));
+  }
+
+  environment.numBonds = 0;
+  const bool withBondStereopermutators = bitmask & AtomEnvironmentComponents::Stereopermutations;
+  if(
+    (bitmask & AtomEnvironmentComponents::BondOrders)
+    && (!withBondStereopermutators || stereopermutators)
+  ) {
+    const unsigned D = graph.degree(i);
+    if(D > AtomEnvironment::maxBonds) {
+      return boost::none;
+    }
+
+    const auto adjacents = graph.adjacents(i);
+    const auto bondTypes = graph.bondTypes(i);
+    for(unsigned k = 0; k < D; ++k) {
+      // Identical to BondInformation::hash
+      unsigned code = (
+        static_cast<std::underlying_type_t<BondType>>(bondTypes.first[k]) + 1
+      ) << BondInformation::bondTypeBits;
+
+      if(withBondStereopermutators) {
+        auto stereopermutatorOption = stereopermutators->option(
+          BondIndex {i, adjacents.first[k]}
+        );
+
+        if(stereopermutatorOption && stereopermutatorOption->numAssignments() > 1) {
+          if(auto assignmentOption = stereopermutatorOption->assigned()) {
+            // Larger assignments are not ordered like BondInformation
+            if(*assignmentOption > 5) {
+              return boost::none;
+            }
+            code += 2 + *assignmentOption;
+          } else {
+            code += 1;
+          }
+        }
+      }
+
+      // Insertion sort, ascending codes are ordered like BondInformation
+      unsigned j = environment.numBonds;
+      while(j > 0 && environment.bonds[j - 1] > code) {
+        environment.bonds[j] = environment.bonds[j - 1];
+        --j;
+      }
+      environment.bonds[j] = code;
+      ++environment.numBonds;
+    }
+  }
+
+  environment.shape = 0;
+  environment.assignment = 0;
+  if(stereopermutators && (bitmask & AtomEnvironmentComponents::Shapes)) {
+    if(auto refOption = stereopermutators->option(i)) {
+      environment.shape = static_cast<std::uint8_t>(refOption->getShape()) + 1;
+
+      if(bitmask & AtomEnvironmentComponents::Stereopermutations) {
+        const auto& assignmentOption = refOption->assigned();
+        environment.assignment = assignmentOption ? *assignmentOption + 2 : 1;
+      }
+    }
+  }
+
+  return environment;
+}
+
 WideHashType atomEnvironment(
-  const PrivateGraph& inner,
+  const FrozenGraph& graph,
   boost::optional<const StereopermutatorList&> stereopermutators,
   AtomEnvironmentComponents bitmask,
   AtomIndex i
 ) {
+  if(auto environmentOption = gatherEnvironment(graph, stereopermutators, bitmask, i)) {
+    return environmentOption->hash();
+  }
+
+  // Fall back to variable-size bond information
   std::vector<BondInformation> bonds;
   boost::optional<Shapes::Shape> shapeOption;
   boost::optional<unsigned> assignmentOption;
 
   if(bitmask & AtomEnvironmentComponents::BondOrders) {
-    bonds = gatherBonds(inner, stereopermutators, bitmask, i);
+    bonds = gatherBonds(graph, stereopermutators, bitmask, i);
   }
 
   if(stereopermutators) {
@@ -271,7 +391,7 @@ WideHashType atomEnvironment(
 
   return hash(
     bitmask,
-    inner.elementType(i),
+    graph.elementType(i),
     bonds,
     shapeOption,
     assignmentOption
@@ -283,18 +403,18 @@ std::vector<WideHashType> generate(
   boost::optional<const StereopermutatorList&> stereopermutators,
   const AtomEnvironmentComponents bitmask
 ) {
-  const unsigned N = inner.N();
+  const FrozenGraph graph = inner.freeze();
+  const unsigned N = graph.N();
   std::vector<WideHashType> hashes(N);
 
-#pragma omp parallel for
-  for(unsigned i = 0; i < N; ++i) {
+  Parallel::forEach(N, [&](const unsigned i, unsigned /* worker */) {
     hashes.at(i) = atomEnvironment(
-      inner,
+      graph,
       stereopermutators,
       bitmask,
       i
     );
-  }
+  });
 
   return hashes;
 }
@@ -307,17 +427,19 @@ bool identityCompare(
   AtomEnvironmentComponents componentBitmask
 ) {
   assert(aGraph.N() == bGraph.N());
+  const FrozenGraph aFrozen = aGraph.freeze();
+  const FrozenGraph bFrozen = bGraph.freeze();
 
   return Temple::all_of(
     Temple::Adaptors::range(aGraph.N()),
     [&](const AtomIndex i) -> WideHashType {
       return atomEnvironment(
-        aGraph,
+        aFrozen,
         aStereopermutators,
         componentBitmask,
         i
       ) == atomEnvironment(
-        bGraph,
+        bFrozen,
         bStereopermutators,
         componentBitmask,
         i
@@ -13,6 +13,7 @@
 #include "Utils/Geometry/ElementTypes.h"
 #include "Molassembler/Shapes/Shapes.h"
 #include "Molassembler/Types.h"
+#include <array>
 #include <vector>
 
 namespace Scine {
@@ -21,6 +22,7 @@ namespace Molassembler {
 // Forward-declarations
 class StereopermutatorList;
 class PrivateGraph;
+class FrozenGraph;
 
 /**
  * @brief Classes and methods to compute hashes of atom environments
@@ -87,12 +89,54 @@ std::vector<BondInformation> gatherBonds(
   AtomIndex i
 );
 
+/*! @brief Packed fixed-width atom environment
+ *
+ * Holds the same information as the arguments to hash() in a flat layout
+ * that can be gathered and hashed without heap allocations. Components
+ * excluded by the bitmask it is gathered with are zero.
+ */
+struct AtomEnvironment {
+  //! Largest number of bonds that can be stored, the largest shape size
+  static constexpr unsigned maxBonds = 12;
+
+  //! Underlying value of the element type
+  std::uint32_t elementType;
+  //! Stereopermutator assignment plus two, one if unassigned, zero if none
+  std::uint32_t assignment;
+  //! Shape plus one, zero if none
+  std::uint8_t shape;
+  //! Number of stored bonds
+  std::uint8_t numBonds;
+  //! Ascending BondInformation::hash values of the atom's bonds
+  std::array<std::uint8_t, maxBonds> bonds;
+
+  /*! @brief Identical to hash() of the atom environment's information
+   *
+   * @complexity{@math{\Theta(1)}}
+   */
+  WideHashType hash() const;
+};
+
+/*! @brief Gathers the packed atom environment of an atom
+ *
+ * @complexity{@math{\Theta(1)}}
+ *
+ * @returns The packed atom environment, or None if the atom's bonds do not
+ *   fit into AtomEnvironment
+ */
+boost::optional<AtomEnvironment> gatherEnvironment(
+  const FrozenGraph& graph,
+  const boost::optional<const StereopermutatorList&>& stereopermutators,
+  AtomEnvironmentComponents bitmask,
+  AtomIndex i
+);
+
 /*! @brief Calculate the hash for a particular atom index
  *
  * @complexity{@math{\Theta(1)}}
  */
 WideHashType atomEnvironment(
-  const PrivateGraph& inner,
+  const FrozenGraph& graph,
   boost::optional<const StereopermutatorList&> stereopermutators,
   AtomEnvironmentComponents bitmask,
   AtomIndex i
@@ -24,6 +24,7 @@
 #include "Molassembler/Molecule/MolGraphWriter.h"
 #include "Molassembler/Molecule/RankingTree.h"
 #include "Molassembler/Options.h"
+#include "Molassembler/Parallel.h"
 #include "Molassembler/Stereopermutators/AbstractPermutations.h"
 #include "Molassembler/Stereopermutators/FeasiblePermutations.h"
 
@@ -54,11 +55,43 @@ void Molecule::Impl::tryAddAtomStereopermutator_(
     return;
   }
 
-  RankingInformation localRanking = rankPriority(candidateIndex);
+  tryAddAtomStereopermutator_(
+    candidateIndex,
+    rankPriority(candidateIndex),
+    stereopermutators
+  );
+}
 
+bool Molecule::Impl::tryAddAtomStereopermutator_(
+  const AtomIndex candidateIndex,
+  RankingInformation localRanking,
+  StereopermutatorList& stereopermutators
+) const {
+  // If there is already an atom stereopermutator on this index, stop
+  if(stereopermutators.option(candidateIndex)) {
+    return false;
+  }
+
+  auto stereopermutatorOption = makeAtomStereopermutator_(
+    candidateIndex,
+    std::move(localRanking)
+  );
+
+  if(!stereopermutatorOption) {
+    return false;
+  }
+
+  stereopermutators.add(std::move(stereopermutatorOption.value()));
+  return true;
+}
+
+boost::optional<AtomStereopermutator> Molecule::Impl::makeAtomStereopermutator_(
+  const AtomIndex candidateIndex,
+  RankingInformation localRanking
+) const {
   // Only non-terminal atoms may have permutators
   if(localRanking.sites.size() <= 1) {
-    return;
+    return boost::none;
   }
 
   Shapes::Shape shape = inferShape(candidateIndex, localRanking).value_or_eval(
@@ -79,7 +112,7 @@ void Molecule::Impl::tryAddAtomStereopermutator_(
     newStereopermutator.assign(0);
   }
 
-  stereopermutators.add(std::move(newStereopermutator));
+  return newStereopermutator;
 }
 
 void Molecule::Impl::tryAddBondStereopermutator_(
@@ -127,20 +160,22 @@ void Molecule::Impl::tryAddBondStereopermutator_(
 StereopermutatorList Molecule::Impl::detectStereopermutators_() const {
   StereopermutatorList stereopermutatorList;
 
-#ifdef _OPENMP
-  /* Ensure inner's properties are populated to avoid data races in its mutable
-   * members
+  /* Find AtomStereopermutators: Rankings are independent of one another, so
+   * stereopermutators are instantiated in parallel and added in index order
    */
-  adjacencies_.inner().populateProperties();
-#endif
+  const AtomIndex N = graph().N();
+  std::vector<boost::optional<AtomStereopermutator>> atomStereopermutators(N);
+  Parallel::forEach(N, [&](const unsigned candidateIndex, unsigned /* worker */) {
+    atomStereopermutators[candidateIndex] = makeAtomStereopermutator_(
+      candidateIndex,
+      rankPriority(candidateIndex)
+    );
+  });
 
-  // Find AtomStereopermutators
-  for(
-    AtomIndex candidateIndex = 0;
-    candidateIndex < graph().N();
-    ++candidateIndex
-  ) {
-    tryAddAtomStereopermutator_(candidateIndex, stereopermutatorList);
+  for(auto& stereopermutatorOption : atomStereopermutators) {
+    if(stereopermutatorOption) {
+      stereopermutatorList.add(std::move(stereopermutatorOption.value()));
+    }
   }
 
   // Find BondStereopermutators
@@ -179,12 +214,105 @@ bool Molecule::Impl::isGraphBasedBondStereopermutatorCandidate_(
   );
 }
 
+bool Molecule::Impl::propagateRanking_(
+  const AtomIndex vertex,
+  RankingInformation localRanking
+) {
+  auto stereopermutatorOption = stereopermutators_.option(vertex);
+  if(!stereopermutatorOption) {
+    // There is no atom stereopermutator on this vertex, so try to add one
+    return tryAddAtomStereopermutator_(
+      vertex,
+      std::move(localRanking),
+      stereopermutators_
+    );
+  }
+
+  // The atom has become terminal
+  if(localRanking.sites.size() <= 1) {
+    stereopermutators_.remove(vertex);
+    return true;
+  }
+
+  // Has the ranking changed?
+  if(localRanking == stereopermutatorOption->getRanking()) {
+    return false;
+  }
+
+  // Are there adjacent bond stereopermutators?
+  std::vector<BondIndex> adjacentBondStereopermutators;
+  for(BondIndex bond : adjacencies_.bonds(vertex)) {
+    if(stereopermutators_.option(bond)) {
+      adjacentBondStereopermutators.push_back(std::move(bond));
+    }
+  }
+
+  // Suggest a shape if desired
+  boost::optional<Shapes::Shape> newShapeOption;
+  if(Options::current().shapeTransition == ShapeTransition::PrioritizeInferenceFromGraph) {
+    newShapeOption = inferShape(vertex, localRanking);
+  }
+
+  // Propagate the state
+  auto oldAtomStereopermutatorStateOption = stereopermutatorOption->propagate(
+    adjacencies_,
+    std::move(localRanking),
+    newShapeOption
+  );
+
+  /* If the modified stereopermutator has only one assignment and is
+   * unassigned due to the graph change, default-assign it
+   */
+  if(
+    stereopermutatorOption->numAssignments() == 1
+    && stereopermutatorOption->assigned() == boost::none
+  ) {
+    stereopermutatorOption->assign(0);
+  }
+
+  /* If the chiral state for this atom stereopermutator was not successfully
+   * propagated or it is now unassigned, then bond stereopermutators sharing
+   * this atom stereopermutator must be removed. Bond stereopermutators can
+   * only be undetermined if its constituting atom stereopermutators are
+   * assigned.
+   */
+  if(!stereopermutatorOption->assigned()) {
+    for(const BondIndex& bond : adjacentBondStereopermutators) {
+      stereopermutators_.remove(bond);
+    }
+
+    return true;
+  }
+
+  /* If the chiral state for this atom stereopermutator was successfully
+   * propagated and/or the permutator could be default-assigned, we can also
+   * propagate adjacent BondStereopermutators.
+   *
+   * TODO we may have to keep track if assignments change within the
+   * propagated bondstereopermutators, or if any bond stereopermutators
+   * are removed, since this may cause another re-rank!
+   */
+  if(oldAtomStereopermutatorStateOption) {
+    for(const BondIndex& bond : adjacentBondStereopermutators) {
+      stereopermutators_.option(bond)->propagateGraphChange(
+        *oldAtomStereopermutatorStateOption,
+        *stereopermutatorOption,
+        adjacencies_.inner(),
+        stereopermutators_
+      );
+    }
+  }
+
+  return true;
+}
+
 void Molecule::Impl::propagateGraphChange_() {
   /* Two cases: If the StereopermutatorList is empty, we can just use detect to
    * find any new stereopermutators in the Molecule.
    */
   if(stereopermutators_.empty()) {
     stereopermutators_ = detectStereopermutators_();
+    rankingDepths_.clear();
     return;
   }
 
@@ -198,89 +326,92 @@ void Molecule::Impl::propagateGraphChange_() {
   GraphAlgorithms::updateEtaBonds(adjacencies_.inner());
 
   const PrivateGraph& inner = adjacencies_.inner();
+  rankingDepths_.resize(inner.N());
 
   for(const PrivateGraph::Vertex vertex : inner.vertices()) {
-    auto stereopermutatorOption = stereopermutators_.option(vertex);
-    RankingInformation localRanking = rankPriority(vertex);
-
-    if(stereopermutatorOption) {
-      // The atom has become terminal
-      if(localRanking.sites.size() <= 1) {
-        stereopermutators_.remove(vertex);
-        continue;
-      }
+    auto rankingAndDepth = rankPriorityAndDepth_(vertex);
+    rankingDepths_.at(vertex) = rankingAndDepth.second;
+    propagateRanking_(vertex, std::move(rankingAndDepth.first));
+  }
 
-      // Has the ranking changed?
-      if(localRanking == stereopermutatorOption->getRanking()) {
-        continue;
-      }
+  // Look for new bond stereopermutators
+  for(BondIndex bond : graph().bonds()) {
+    if(isGraphBasedBondStereopermutatorCandidate_(graph().bondType(bond))) {
+      tryAddBondStereopermutator_(bond, stereopermutators_);
+    }
+  }
+}
 
-      // Are there adjacent bond stereopermutators?
-      std::vector<BondIndex> adjacentBondStereopermutators;
-      for(BondIndex bond : adjacencies_.bonds(vertex)) {
-        if(stereopermutators_.option(bond)) {
-          adjacentBondStereopermutators.push_back(std::move(bond));
-        }
-      }
+void Molecule::Impl::propagateGraphChange_(std::vector<AtomIndex> editSites) {
+  constitutionalColors_.mark(editSites);
 
-      // Suggest a shape if desired
-      boost::optional<Shapes::Shape> newShapeOption;
-      if(Options::shapeTransition == ShapeTransition::PrioritizeInferenceFromGraph) {
-        newShapeOption = inferShape(vertex, localRanking);
-      }
+  if(batchedEditSites_) {
+    batchedEditSites_->insert(
+      std::end(batchedEditSites_.value()),
+      std::begin(editSites),
+      std::end(editSites)
+    );
+    return;
+  }
 
-      // Propagate the state
-      auto oldAtomStereopermutatorStateOption = stereopermutatorOption->propagate(
-        adjacencies_,
-        std::move(localRanking),
-        newShapeOption
-      );
+  const PrivateGraph& inner = adjacencies_.inner();
+  const AtomIndex N = inner.N();
 
-      /* If the modified stereopermutator has only one assignment and is
-       * unassigned due to the graph change, default-assign it
-       */
-      if(
-        stereopermutatorOption->numAssignments() == 1
-        && stereopermutatorOption->assigned() == boost::none
-      ) {
-        stereopermutatorOption->assign(0);
-      }
+  if(stereopermutators_.empty() || rankingDepths_.size() != N) {
+    propagateGraphChange_();
+    return;
+  }
 
-      /* If the chiral state for this atom stereopermutator was not successfully
-       * propagated or it is now unassigned, then bond stereopermutators sharing
-       * this atom stereopermutator must be removed. Bond stereopermutators can
-       * only be undetermined if its constituting atom stereopermutators are
-       * assigned.
-       */
-      if(!stereopermutatorOption->assigned()) {
-        for(const BondIndex& bond : adjacentBondStereopermutators) {
-          stereopermutators_.remove(bond);
-        }
+  updateEtaBonds_(editSites);
 
-        continue;
-      }
+  /* A ranking tree of depth d only contains atoms within d bonds of the ranked
+   * atom, so only atoms at most their ranking depth away from an edit site
+   * need re-ranking. Graph distances to the nearest edit site are bounded by
+   * the deepest ranking tree.
+   */
+  const unsigned maxDepth = *std::max_element(
+    std::begin(rankingDepths_),
+    std::end(rankingDepths_)
+  );
+  const unsigned unreached = std::numeric_limits<unsigned>::max();
+  std::vector<unsigned> distances(N, unreached);
+  auto addEditSite = [&](const AtomIndex site) {
+    if(distances.at(site) == 0) {
+      return;
+    }
 
-      /* If the chiral state for this atom stereopermutator was successfully
-       * propagated and/or the permutator could be default-assigned, we can also
-       * propagate adjacent BondStereopermutators.
-       *
-       * TODO we may have to keep track if assignments change within the
-       * propagated bondstereopermutators, or if any bond stereopermutators
-       * are removed, since this may cause another re-rank!
-       */
-      if(oldAtomStereopermutatorStateOption) {
-        for(const BondIndex& bond : adjacentBondStereopermutators) {
-          stereopermutators_.option(bond)->propagateGraphChange(
-            *oldAtomStereopermutatorStateOption,
-            *stereopermutatorOption,
-            inner,
-            stereopermutators_
-          );
+    distances.at(site) = 0;
+    std::vector<AtomIndex> front {site};
+    for(unsigned depth = 1; depth <= maxDepth && !front.empty(); ++depth) {
+      std::vector<AtomIndex> next;
+      for(const AtomIndex i : front) {
+        for(const AtomIndex j : inner.adjacents(i)) {
+          if(distances.at(j) > depth) {
+            distances.at(j) = depth;
+            next.push_back(j);
+          }
         }
       }
-    } else {
-      // There is no atom stereopermutator on this vertex, so try to add one
-      tryAddAtomStereopermutator_(vertex, stereopermutators_);
+      front = std::move(next);
+    }
+  };
+
+  for(const AtomIndex site : editSites) {
+    addEditSite(site);
+  }
+
+  for(const PrivateGraph::Vertex vertex : inner.vertices()) {
+    if(distances.at(vertex) > rankingDepths_.at(vertex)) {
+      continue;
+    }
+
+    auto rankingAndDepth = rankPriorityAndDepth_(vertex);
+    rankingDepths_.at(vertex) = rankingAndDepth.second;
+    /* Altered stereopermutators can change the ranking of atoms processed
+     * later in the same manner as graph edits
+     */
+    if(propagateRanking_(vertex, std::move(rankingAndDepth.first))) {
+      addEditSite(vertex);
     }
   }
 
@@ -292,6 +423,49 @@ void Molecule::Impl::propagateGraphChange_() {
   }
 }
 
+void Molecule::Impl::updateEtaBonds_(std::vector<AtomIndex>& editSites) {
+  /* Eta bond updates are a graph modification of their own. Any bonds whose
+   * type is altered are edit sites, too.
+   */
+  std::vector<std::pair<BondIndex, BondType>> bondTypes;
+  for(const BondIndex& bond : graph().bonds()) {
+    bondTypes.emplace_back(bond, graph().bondType(bond));
+  }
+  GraphAlgorithms::updateEtaBonds(adjacencies_.inner());
+  for(const auto& bondTypePair : bondTypes) {
+    if(graph().bondType(bondTypePair.first) != bondTypePair.second) {
+      editSites.push_back(bondTypePair.first.first);
+      editSites.push_back(bondTypePair.first.second);
+    }
+  }
+}
+
+void Molecule::Impl::prepareBatchedEdit_(const std::vector<AtomIndex>& sites) {
+  if(!batchedEditSites_) {
+    return;
+  }
+
+  std::vector<AtomIndex>& editSites = batchedEditSites_.value();
+  bool etaBondsUpdated = false;
+  for(const AtomIndex site : sites) {
+    if(std::find(std::begin(editSites), std::end(editSites), site) == std::end(editSites)) {
+      continue;
+    }
+
+    // Rankings depend on eta bonds, which are otherwise only updated on commit
+    if(!etaBondsUpdated) {
+      updateEtaBonds_(editSites);
+      etaBondsUpdated = true;
+    }
+
+    auto rankingAndDepth = rankPriorityAndDepth_(site);
+    if(rankingDepths_.size() == graph().N()) {
+      rankingDepths_.at(site) = rankingAndDepth.second;
+    }
+    propagateRanking_(site, std::move(rankingAndDepth.first));
+  }
+}
+
 /* Public members */
 /* Constructors */
 Molecule::Impl::Impl() noexcept
@@ -314,27 +488,57 @@ Molecule::Impl::Impl(
   inner.addEdge(i, j, bondType);
 }
 
-Molecule::Impl::Impl(Graph graph)
+Molecule::Impl::Impl(Graph graph, const bool lazy)
   : adjacencies_(std::move(graph))
 {
   // Initialization
   GraphAlgorithms::updateEtaBonds(adjacencies_.inner());
-  stereopermutators_ = detectStereopermutators_();
+  if(lazy) {
+    deferredDetection_.pending.store(true, std::memory_order_relaxed);
+  } else {
+    stereopermutators_ = detectStereopermutators_();
+  }
   ensureModelInvariants_();
 }
 
+Molecule::Impl::Impl(const Impl& other) : Impl(
+  other,
+  other.deferredStereopermutators()
+    ? std::unique_lock<std::mutex> {other.deferredDetection_.mutex}
+    : std::unique_lock<std::mutex> {}
+) {}
+
+/* While the other's detection is pending, holding its lock ensures its
+ * stereopermutators are not written to during the copy. Once published, they
+ * are not written to on const access anymore.
+ */
+Molecule::Impl::Impl(const Impl& other, std::unique_lock<std::mutex> /* detectionLock */)
+  : adjacencies_(other.adjacencies_),
+    stereopermutators_(other.stereopermutators_),
+    deferredDetection_(other.deferredDetection_),
+    canonicalComponentsOption_(other.canonicalComponentsOption_),
+    rankingDepths_(other.rankingDepths_),
+    batchedEditSites_(other.batchedEditSites_),
+    canonicalForms_(other.canonicalForms_),
+    constitutionalColors_(other.constitutionalColors_)
+{}
+
 Molecule::Impl::Impl(
   Graph graph,
   const AngstromPositions& positions,
   const boost::optional<
     std::vector<BondIndex>
-  >& bondStereopermutatorCandidatesOptional
+  >& bondStereopermutatorCandidatesOptional,
+  const StereopermutatorList* rankingTemplatePtr,
+  const bool shapesOnly
 ) : adjacencies_(std::move(graph))
 {
   GraphAlgorithms::updateEtaBonds(adjacencies_.inner());
   stereopermutators_ = inferStereopermutatorsFromPositions(
     positions,
-    bondStereopermutatorCandidatesOptional
+    bondStereopermutatorCandidatesOptional,
+    rankingTemplatePtr,
+    shapesOnly
   );
   ensureModelInvariants_();
 }
@@ -361,10 +565,15 @@ AtomIndex Molecule::Impl::addAtom(
     throw std::out_of_range("Molecule::addAtom: Supplied atom index is invalid!");
   }
 
+  const bool rankingDepthsKnown = (rankingDepths_.size() == graph().N());
   const AtomIndex index = adjacencies_.inner().addVertex(elementType);
+  if(rankingDepthsKnown) {
+    // The new atom is an edit site and will be ranked regardless
+    rankingDepths_.push_back(0);
+  }
   addBond(index, adjacentTo, bondType);
   /* addBond handles the stereopermutator update on adjacentTo and also
-   * performs a full-molecule rerank propagation.
+   * re-ranks all atoms whose rankings could be affected.
    */
 
   return index;
@@ -383,6 +592,8 @@ BondIndex Molecule::Impl::addBond(
     throw std::logic_error("Molecule::addBond: Cannot add a bond between identical indices!");
   }
 
+  prepareBatchedEdit_({a, b});
+
   PrivateGraph& inner = adjacencies_.inner();
 
   inner.addEdge(a, b, bondType);
@@ -399,15 +610,26 @@ BondIndex Molecule::Impl::addBond(
   notifySubstituentAddition(a);
   notifySubstituentAddition(b);
 
-  propagateGraphChange_();
+  propagateGraphChange_({a, b});
   canonicalComponentsOption_ = boost::none;
 
   return BondIndex {a, b};
 }
 
 void Molecule::Impl::applyPermutation(const std::vector<AtomIndex>& permutation) {
+  commitEdits();
   adjacencies_.inner().applyPermutation(permutation);
   stereopermutators_.applyPermutation(permutation);
+  constitutionalColors_.permute(permutation);
+  if(rankingDepths_.size() == permutation.size()) {
+    std::vector<unsigned> permutedDepths(rankingDepths_.size());
+    for(unsigned i = 0; i < permutation.size(); ++i) {
+      permutedDepths.at(permutation.at(i)) = rankingDepths_.at(i);
+    }
+    rankingDepths_ = std::move(permutedDepths);
+  } else {
+    rankingDepths_.clear();
+  }
   canonicalComponentsOption_ = boost::none;
 }
 
@@ -419,6 +641,7 @@ void Molecule::Impl::assignStereopermutator(
     throw std::out_of_range("Molecule::assignStereopermutator: Supplied index is invalid!");
   }
 
+  commitEdits();
   auto stereopermutatorOption = stereopermutators_.option(a);
 
   if(!stereopermutatorOption) {
@@ -437,7 +660,7 @@ void Molecule::Impl::assignStereopermutator(
     stereopermutatorOption->assign(assignmentOption);
 
     // A reassignment can change ranking! See the RankingTree tests
-    propagateGraphChange_();
+    propagateGraphChange_({a});
     canonicalComponentsOption_ = boost::none;
   }
 }
@@ -450,6 +673,7 @@ void Molecule::Impl::assignStereopermutator(
     throw std::out_of_range("Molecule::assignStereopermutator: Supplied bond atom indices is invalid!");
   }
 
+  commitEdits();
   auto stereopermutatorOption = stereopermutators_.option(edge);
 
   if(!stereopermutatorOption) {
@@ -468,12 +692,13 @@ void Molecule::Impl::assignStereopermutator(
     stereopermutatorOption->assign(assignmentOption);
 
     // A reassignment can change ranking! See the RankingTree tests
-    propagateGraphChange_();
+    propagateGraphChange_({edge.first, edge.second});
     canonicalComponentsOption_ = boost::none;
   }
 }
 
 void Molecule::Impl::assignStereopermutatorRandomly(const AtomIndex a, Random::Engine& engine) {
+  commitEdits();
   if(!isValidIndex_(a)) {
     throw std::out_of_range("Molecule::assignStereopermutatorRandomly: Supplied index is invalid!");
   }
@@ -487,11 +712,12 @@ void Molecule::Impl::assignStereopermutatorRandomly(const AtomIndex a, Random::E
   stereopermutatorOption->assignRandom(engine);
 
   // A reassignment can change ranking! See the RankingTree tests
-  propagateGraphChange_();
+  propagateGraphChange_({a});
   canonicalComponentsOption_ = boost::none;
 }
 
 void Molecule::Impl::assignStereopermutatorRandomly(const BondIndex& e, Random::Engine& engine) {
+  commitEdits();
   auto stereopermutatorOption = stereopermutators_.option(e);
 
   if(!stereopermutatorOption) {
@@ -501,13 +727,21 @@ void Molecule::Impl::assignStereopermutatorRandomly(const BondIndex& e, Random::
   stereopermutatorOption->assignRandom(engine);
 
   // A reassignment can change ranking! See the RankingTree tests
-  propagateGraphChange_();
+  propagateGraphChange_({e.first, e.second});
   canonicalComponentsOption_ = boost::none;
 }
 
+void Molecule::Impl::beginEdits() {
+  if(!batchedEditSites_) {
+    batchedEditSites_ = std::vector<AtomIndex> {};
+  }
+}
+
 std::vector<AtomIndex> Molecule::Impl::canonicalize(
   const AtomEnvironmentComponents componentBitmask
 ) {
+  commitEdits();
+
   // Generate hashes according to the passed bitmask
   auto vertexHashes = Hashes::generate(
     graph().inner(),
@@ -545,6 +779,18 @@ std::vector<AtomIndex> Molecule::Impl::canonicalize(
   return inverse.permutation;
 }
 
+void Molecule::Impl::commitEdits() {
+  if(!batchedEditSites_) {
+    return;
+  }
+
+  std::vector<AtomIndex> editSites = std::move(batchedEditSites_.value());
+  batchedEditSites_ = boost::none;
+  if(!editSites.empty()) {
+    propagateGraphChange_(std::move(editSites));
+  }
+}
+
 void Molecule::Impl::removeAtom(const AtomIndex a) {
   if(!isValidIndex_(a)) {
     throw std::out_of_range("Molecule::removeAtom: Supplied index is invalid!");
@@ -554,6 +800,87 @@ void Molecule::Impl::removeAtom(const AtomIndex a) {
     throw std::logic_error("Removing this atom disconnects the graph!");
   }
 
+  propagateGraphChange_(removeAtomUnchecked_(a));
+  canonicalComponentsOption_ = boost::none;
+}
+
+void Molecule::Impl::removeAtoms(std::vector<AtomIndex> atoms) {
+  for(const AtomIndex a : atoms) {
+    if(!isValidIndex_(a)) {
+      throw std::out_of_range("Molecule::removeAtoms: Supplied index is invalid!");
+    }
+  }
+
+  std::sort(std::begin(atoms), std::end(atoms));
+  atoms.erase(
+    std::unique(std::begin(atoms), std::end(atoms)),
+    std::end(atoms)
+  );
+
+  if(atoms.empty()) {
+    return;
+  }
+
+  const PrivateGraph& constInner = adjacencies_.inner();
+  const unsigned N = constInner.N();
+  if(atoms.size() >= N) {
+    throw std::logic_error("Removing these atoms removes all atoms!");
+  }
+
+  // Check once that the remaining atoms are connected
+  std::vector<bool> visited(N, false);
+  for(const AtomIndex a : atoms) {
+    visited.at(a) = true;
+  }
+  AtomIndex root = 0;
+  while(visited.at(root)) {
+    ++root;
+  }
+  std::vector<AtomIndex> stack {root};
+  visited.at(root) = true;
+  unsigned remainingVisited = 1;
+  while(!stack.empty()) {
+    const AtomIndex v = stack.back();
+    stack.pop_back();
+    for(const AtomIndex w : constInner.adjacents(v)) {
+      if(!visited.at(w)) {
+        visited.at(w) = true;
+        ++remainingVisited;
+        stack.push_back(w);
+      }
+    }
+  }
+  if(remainingVisited != N - atoms.size()) {
+    throw std::logic_error("Removing these atoms disconnects the graph!");
+  }
+
+  /* Remove from the highest index down so that the indices of atoms yet to
+   * be removed stay valid, and keep the collected edit sites in the current
+   * indexing
+   */
+  std::vector<AtomIndex> editSites;
+  for(auto iter = atoms.rbegin(); iter != atoms.rend(); ++iter) {
+    const AtomIndex a = *iter;
+    editSites.erase(
+      std::remove(std::begin(editSites), std::end(editSites), a),
+      std::end(editSites)
+    );
+    for(AtomIndex& site : editSites) {
+      if(site > a) {
+        --site;
+      }
+    }
+
+    for(const AtomIndex site : removeAtomUnchecked_(a)) {
+      editSites.push_back(site);
+    }
+  }
+
+  propagateGraphChange_(std::move(editSites));
+  canonicalComponentsOption_ = boost::none;
+}
+
+std::vector<AtomIndex> Molecule::Impl::removeAtomUnchecked_(const AtomIndex a) {
   PrivateGraph& inner = adjacencies_.inner();
 
   std::vector<AtomIndex> previouslyAdjacentVertices;
@@ -564,6 +891,8 @@ void Molecule::Impl::removeAtom(const AtomIndex a) {
     std::back_inserter(previouslyAdjacentVertices)
   );
 
+  prepareBatchedEdit_(previouslyAdjacentVertices);
+
   // Remove all edges to and from this vertex
   inner.clearVertex(a);
 
@@ -577,6 +906,22 @@ void Molecule::Impl::removeAtom(const AtomIndex a) {
 
   // Remove the vertex itself
   inner.removeVertex(a);
+  if(rankingDepths_.size() == inner.N() + 1) {
+    rankingDepths_.erase(std::begin(rankingDepths_) + a);
+  }
+  constitutionalColors_.remove(a);
+  if(batchedEditSites_) {
+    std::vector<AtomIndex>& editSites = batchedEditSites_.value();
+    editSites.erase(
+      std::remove(std::begin(editSites), std::end(editSites), a),
+      std::end(editSites)
+    );
+    for(AtomIndex& site : editSites) {
+      if(site > a) {
+        --site;
+      }
+    }
+  }
 
   /* Removing the vertex invalidates some vertex descriptors, which are used
    * liberally in the stereopermutator classes' state. We have to correct
@@ -601,7 +946,7 @@ void Molecule::Impl::removeAtom(const AtomIndex a) {
       }
 
       boost::optional<Shapes::Shape> newShapeOption;
-      if(Options::shapeTransition == ShapeTransition::PrioritizeInferenceFromGraph) {
+      if(Options::current().shapeTransition == ShapeTransition::PrioritizeInferenceFromGraph) {
         newShapeOption = inferShape(indexToUpdate, localRanking);
       }
 
@@ -626,8 +971,14 @@ void Molecule::Impl::removeAtom(const AtomIndex a) {
     }*/
   }
 
-  propagateGraphChange_();
-  canonicalComponentsOption_ = boost::none;
+  /* Vertex removal shifts all indices above the removed one, the formerly
+   * adjacent vertices are the edit sites
+   */
+  std::vector<AtomIndex> editSites;
+  for(const AtomIndex adjacent : previouslyAdjacentVertices) {
+    editSites.push_back(adjacent > a ? adjacent - 1 : adjacent);
+  }
+  return editSites;
 }
 
 void Molecule::Impl::removeBond(
@@ -653,6 +1004,8 @@ void Molecule::Impl::removeBond(
   }
 
 
+  prepareBatchedEdit_({a, b});
+
   /* If there is an BondStereopermutator on this edge, we have to drop it explicitly,
    * since propagateGraphChange_ cannot iterate over a now-removed edge.
    */
@@ -673,7 +1026,7 @@ void Molecule::Impl::removeBond(
       }
 
       boost::optional<Shapes::Shape> newShapeOption;
-      if(Options::shapeTransition == ShapeTransition::PrioritizeInferenceFromGraph) {
+      if(Options::current().shapeTransition == ShapeTransition::PrioritizeInferenceFromGraph) {
         newShapeOption = inferShape(indexToUpdate, localRanking);
       }
 
@@ -698,14 +1051,17 @@ void Molecule::Impl::removeBond(
     }*/
   };
 
-  notifyRemoval(a);
-  notifyRemoval(b);
+  // Batched edits defer this to the re-ranking of edit sites on commit
+  if(!batchedEditSites_) {
+    notifyRemoval(a);
+    notifyRemoval(b);
+  }
 
   /* All other cases, where there may be BondStereopermutators or AtomStereopermutators
    * on a or b, should be handled correctly by propagateGraphChange_.
    */
 
-  propagateGraphChange_();
+  propagateGraphChange_({a, b});
   canonicalComponentsOption_ = boost::none;
 }
 
@@ -732,8 +1088,9 @@ bool Molecule::Impl::setBondType(
     return false;
   }
 
+  prepareBatchedEdit_({a, b});
   inner.bondType(edgeOption.value()) = bondType;
-  propagateGraphChange_();
+  propagateGraphChange_({a, b});
   canonicalComponentsOption_ = boost::none;
   return true;
 }
@@ -747,7 +1104,7 @@ void Molecule::Impl::setElementType(
   }
 
   adjacencies_.inner().elementType(a) = elementType;
-  propagateGraphChange_();
+  propagateGraphChange_({a});
   canonicalComponentsOption_ = boost::none;
 }
 
@@ -759,6 +1116,7 @@ void Molecule::Impl::setShapeAtAtom(
     throw std::out_of_range("Molecule::setShapeAtAtom: Supplied atom index is invalid");
   }
 
+  commitEdits();
   auto stereopermutatorOption = stereopermutators_.option(a);
 
   // If there is no stereopermutator at this position yet, we have to create it
@@ -787,7 +1145,7 @@ void Molecule::Impl::setShapeAtAtom(
 
     stereopermutators_.add(std::move(newStereopermutator));
 
-    propagateGraphChange_();
+    propagateGraphChange_({a});
     canonicalComponentsOption_ = boost::none;
     return;
   }
@@ -817,11 +1175,71 @@ void Molecule::Impl::setShapeAtAtom(
     stereopermutators_.try_remove(bond);
   }
 
-  propagateGraphChange_();
+  propagateGraphChange_({a});
   canonicalComponentsOption_ = boost::none;
 }
 
 /* Information */
+const Molecule::Impl& Molecule::Impl::withStereopermutators() const {
+  if(deferredStereopermutators()) {
+    std::lock_guard<std::mutex> lock(deferredDetection_.mutex);
+    if(deferredDetection_.pending.load(std::memory_order_relaxed)) {
+      stereopermutators_ = detectStereopermutators_();
+      deferredDetection_.pending.store(false, std::memory_order_release);
+    }
+  }
+
+  return *this;
+}
+
+bool Molecule::Impl::deferredStereopermutators() const {
+  return deferredDetection_.pending.load(std::memory_order_acquire);
+}
+
+std::shared_ptr<const Molecule::Impl::CanonicalForm> Molecule::Impl::canonicalForm(
+  const AtomEnvironmentComponents components
+) const {
+  const auto findForm = [&]() -> std::shared_ptr<const CanonicalForm> {
+    for(const auto& form : canonicalForms_.forms) {
+      if(form->components == components) {
+        return form;
+      }
+    }
+    return nullptr;
+  };
+
+  {
+    std::lock_guard<std::mutex> lock(canonicalForms_.mutex);
+    if(auto form = findForm()) {
+      return form;
+    }
+  }
+
+  auto form = std::make_shared<CanonicalForm>();
+  form->components = components;
+  if(canonicalComponentsOption_ == components) {
+    // The cache does not own this implementation, it only points to it
+    form->permutation = Temple::iota<AtomIndex>(graph().N());
+    form->canonical = std::shared_ptr<const Impl>(std::shared_ptr<const Impl> {}, this);
+  } else {
+    // Canonicalization is expensive, so it is done without holding the lock
+    auto canonical = std::make_shared<Impl>(*this);
+    form->permutation = canonical->canonicalize(components);
+    form->canonical = std::move(canonical);
+  }
+
+  std::lock_guard<std::mutex> lock(canonicalForms_.mutex);
+  if(auto concurrentForm = findForm()) {
+    return concurrentForm;
+  }
+  canonicalForms_.forms.push_back(form);
+  return form;
+}
+
+void Molecule::Impl::invalidateCanonicalForms() {
+  canonicalForms_.forms.clear();
+}
+
 boost::optional<AtomEnvironmentComponents> Molecule::Impl::canonicalComponents() const {
   return canonicalComponentsOption_;
 }
@@ -890,6 +1308,96 @@ const Graph& Molecule::Impl::graph() const {
   return adjacencies_;
 }
 
+namespace {
+
+//! Platform-independent 64-bit mixing function (SplitMix64 finalizer)
+std::uint64_t mix64(std::uint64_t x) {
+  x ^= x >> 30;
+  x *= 0xbf58476d1ce4e5b9ULL;
+  x ^= x >> 27;
+  x *= 0x94d049bb133111ebULL;
+  x ^= x >> 31;
+  return x;
+}
+
+//! Folds a sequence of words into a 128-bit fingerprint in two mixed lanes
+struct FingerprintAccumulator {
+  Fingerprint state {0x6a09e667f3bcc908ULL, 0xbb67ae8584caa73bULL};
+
+  explicit FingerprintAccumulator(const std::uint64_t domain) {
+    add(domain);
+  }
+
+  void add(const std::uint64_t word) {
+    state.high = mix64(state.high ^ word);
+    state.low = mix64(state.low + word + 0x9e3779b97f4a7c15ULL) ^ state.high;
+  }
+
+  void add(const Fingerprint& fingerprint) {
+    add(fingerprint.high);
+    add(fingerprint.low);
+  }
+
+  void add(const Hashes::WideHashType& wideHash) {
+    const Hashes::WideHashType lowMask = std::numeric_limits<std::uint64_t>::max();
+    add(static_cast<std::uint64_t>((wideHash >> 64) & lowMask));
+    add(static_cast<std::uint64_t>(wideHash & lowMask));
+  }
+};
+
+// Distinguishes the kinds of fingerprints from one another
+constexpr std::uint64_t canonicalFingerprintDomain = 1;
+constexpr std::uint64_t invariantFingerprintDomain = 2;
+constexpr std::uint64_t constitutionalFingerprintDomain = 3;
+
+//! Constitutional color of an atom before refinement
+Fingerprint elementColor(const PrivateGraph& inner, const AtomIndex i) {
+  using ElementTypeUnderlying = std::underlying_type<Utils::ElementType>::type;
+  FingerprintAccumulator accumulator {constitutionalFingerprintDomain};
+  accumulator.add(
+    static_cast<std::uint64_t>(static_cast<ElementTypeUnderlying>(inner.elementType(i)))
+  );
+  return accumulator.state;
+}
+
+//! Refines an atom's constitutional color with those of its adjacent atoms
+Fingerprint refinedColor(
+  const PrivateGraph& inner,
+  const std::vector<Fingerprint>& colors,
+  const AtomIndex i
+) {
+  std::vector<std::pair<std::uint64_t, Fingerprint>> adjacentColors;
+  for(const AtomIndex j : inner.adjacents(i)) {
+    adjacentColors.emplace_back(
+      static_cast<std::uint64_t>(inner.bondType(inner.edge(i, j))) + 1,
+      colors[j]
+    );
+  }
+  std::sort(
+    std::begin(adjacentColors),
+    std::end(adjacentColors),
+    [](const auto& a, const auto& b) -> bool {
+      return std::tie(a.first, a.second) < std::tie(b.first, b.second);
+    }
+  );
+
+  FingerprintAccumulator accumulator {constitutionalFingerprintDomain};
+  accumulator.add(colors[i]);
+  for(const auto& adjacentColor : adjacentColors) {
+    accumulator.add(adjacentColor.first);
+    accumulator.add(adjacentColor.second);
+  }
+  return accumulator.state;
+}
+
+//! Sorts atom indices and removes duplicates
+void sortUnique(std::vector<AtomIndex>& atoms) {
+  std::sort(std::begin(atoms), std::end(atoms));
+  atoms.erase(std::unique(std::begin(atoms), std::end(atoms)), std::end(atoms));
+}
+
+} // namespace
+
 std::size_t Molecule::Impl::hash() const {
   if(canonicalComponentsOption_ == boost::none) {
     throw std::logic_error("Trying to hash an uncanonical molecule.");
@@ -922,6 +1430,256 @@ std::size_t Molecule::Impl::hash() const {
   return hash;
 }
 
+Fingerprint Molecule::Impl::fingerprint(const AtomEnvironmentComponents componentBitmask) const {
+  if(canonicalComponentsOption_ != componentBitmask) {
+    return canonicalForm(componentBitmask)->canonical->fingerprint(componentBitmask);
+  }
+
+  const PrivateGraph& inner = graph().inner();
+  const auto hashes = Hashes::generate(inner, stereopermutators_, componentBitmask);
+
+  FingerprintAccumulator accumulator {canonicalFingerprintDomain};
+  accumulator.add(static_cast<std::uint64_t>(inner.N()));
+  accumulator.add(static_cast<std::uint64_t>(inner.B()));
+  for(const auto& wideHash : hashes) {
+    accumulator.add(wideHash);
+  }
+
+  // Bonds in canonical index order
+  std::vector<BondIndex> bonds;
+  bonds.reserve(inner.B());
+  for(const auto& edge : inner.edges()) {
+    bonds.emplace_back(inner.source(edge), inner.target(edge));
+  }
+  std::sort(std::begin(bonds), std::end(bonds));
+  for(const BondIndex& bond : bonds) {
+    accumulator.add(static_cast<std::uint64_t>(bond.first));
+    accumulator.add(static_cast<std::uint64_t>(bond.second));
+  }
+
+  return accumulator.state;
+}
+
+Fingerprint Molecule::Impl::invariantFingerprint(const AtomEnvironmentComponents componentBitmask) const {
+  return invariantFingerprint(graph().inner(), stereopermutators_, componentBitmask);
+}
+
+Fingerprint Molecule::Impl::invariantFingerprint(
+  const PrivateGraph& inner,
+  const boost::optional<const StereopermutatorList&> stereopermutatorsOption,
+  const AtomEnvironmentComponents componentBitmask
+) {
+  const AtomIndex N = inner.N();
+  const bool includeBondOrders = componentBitmask & AtomEnvironmentComponents::BondOrders;
+
+  const auto hashes = Hashes::generate(inner, stereopermutatorsOption, componentBitmask);
+  std::vector<Fingerprint> colors;
+  colors.reserve(N);
+  for(const auto& wideHash : hashes) {
+    FingerprintAccumulator accumulator {invariantFingerprintDomain};
+    accumulator.add(wideHash);
+    colors.push_back(accumulator.state);
+  }
+
+  auto countDistinct = [](std::vector<Fingerprint> values) -> unsigned {
+    std::sort(std::begin(values), std::end(values));
+    return std::unique(std::begin(values), std::end(values)) - std::begin(values);
+  };
+
+  /* Refine each atom's color with the sorted colors of its adjacent atoms
+   * until the partition of atoms by color is stable
+   */
+  unsigned distinctColors = countDistinct(colors);
+  std::vector<Fingerprint> refinedColors(N);
+  std::vector<std::pair<std::uint64_t, Fingerprint>> adjacentColors;
+  for(AtomIndex iteration = 0; iteration < N && distinctColors < N; ++iteration) {
+    for(AtomIndex i = 0; i < N; ++i) {
+      adjacentColors.clear();
+      for(const AtomIndex j : inner.adjacents(i)) {
+        const std::uint64_t bondWord = (
+          includeBondOrders
+          ? static_cast<std::uint64_t>(inner.bondType(inner.edge(i, j))) + 1
+          : 0
+        );
+        adjacentColors.emplace_back(bondWord, colors[j]);
+      }
+      std::sort(
+        std::begin(adjacentColors),
+        std::end(adjacentColors),
+        [](const auto& a, const auto& b) -> bool {
+          return std::tie(a.first, a.second) < std::tie(b.first, b.second);
+        }
+      );
+
+      FingerprintAccumulator accumulator {invariantFingerprintDomain};
+      accumulator.add(colors[i]);
+      for(const auto& adjacentColor : adjacentColors) {
+        accumulator.add(adjacentColor.first);
+        accumulator.add(adjacentColor.second);
+      }
+      refinedColors[i] = accumulator.state;
+    }
+
+    const unsigned refinedDistinctColors = countDistinct(refinedColors);
+    std::swap(colors, refinedColors);
+    if(refinedDistinctColors == distinctColors) {
+      break;
+    }
+    distinctColors = refinedDistinctColors;
+  }
+
+  // Fold the multiset of colors
+  std::sort(std::begin(colors), std::end(colors));
+  FingerprintAccumulator accumulator {invariantFingerprintDomain};
+  accumulator.add(static_cast<std::uint64_t>(N));
+  accumulator.add(static_cast<std::uint64_t>(inner.B()));
+  for(const Fingerprint& color : colors) {
+    accumulator.add(color);
+  }
+  return accumulator.state;
+}
+
+constexpr unsigned Molecule::Impl::constitutionalRefinements;
+
+Molecule::Impl::ConstitutionalColors::ConstitutionalColors(const ConstitutionalColors& other) {
+  std::lock_guard<std::mutex> lock(other.mutex);
+  rounds = other.rounds;
+  marked = other.marked;
+  sum = other.sum;
+}
+
+void Molecule::Impl::ConstitutionalColors::mark(const std::vector<AtomIndex>& atoms) {
+  // Without colors, everything is colored on the next update anyway
+  if(!rounds.empty()) {
+    marked.insert(std::end(marked), std::begin(atoms), std::end(atoms));
+  }
+}
+
+void Molecule::Impl::ConstitutionalColors::remove(const AtomIndex a) {
+  if(rounds.empty()) {
+    return;
+  }
+
+  if(a < rounds.back().size()) {
+    const Fingerprint& color = rounds.back().at(a);
+    sum.high -= color.high;
+    sum.low -= color.low;
+    for(auto& round : rounds) {
+      round.erase(std::begin(round) + a);
+    }
+  }
+
+  marked.erase(
+    std::remove(std::begin(marked), std::end(marked), a),
+    std::end(marked)
+  );
+  for(AtomIndex& site : marked) {
+    if(site > a) {
+      --site;
+    }
+  }
+}
+
+void Molecule::Impl::ConstitutionalColors::permute(const std::vector<AtomIndex>& permutation) {
+  // Missing colors of added atoms cannot be permuted, so start over
+  if(rounds.empty() || rounds.front().size() != permutation.size()) {
+    rounds.clear();
+    marked.clear();
+    return;
+  }
+
+  for(auto& round : rounds) {
+    std::vector<Fingerprint> permuted(round.size());
+    for(unsigned i = 0; i < permutation.size(); ++i) {
+      permuted.at(permutation.at(i)) = round.at(i);
+    }
+    round = std::move(permuted);
+  }
+
+  for(AtomIndex& site : marked) {
+    site = permutation.at(site);
+  }
+}
+
+Fingerprint Molecule::Impl::ConstitutionalColors::update(const PrivateGraph& inner) {
+  if(rounds.empty()) {
+    rounds.resize(constitutionalRefinements + 1);
+    marked.clear();
+    sum = {0, 0};
+  }
+
+  const AtomIndex N = inner.N();
+  const AtomIndex colored = rounds.front().size();
+  for(AtomIndex i = colored; i < N; ++i) {
+    marked.push_back(i);
+  }
+  if(marked.empty()) {
+    return sum;
+  }
+
+  for(auto& round : rounds) {
+    round.resize(N);
+  }
+
+  /* Colors of round r depend only on atoms at most r bonds away, so the
+   * outdated atoms of each round are those of the previous round and their
+   * adjacent atoms
+   */
+  std::vector<AtomIndex> outdated = std::move(marked);
+  marked.clear();
+  sortUnique(outdated);
+  const unsigned R = rounds.size();
+  for(unsigned r = 0; r < R; ++r) {
+    if(r > 0) {
+      const unsigned previouslyOutdated = outdated.size();
+      for(unsigned k = 0; k < previouslyOutdated; ++k) {
+        for(const AtomIndex j : inner.adjacents(outdated[k])) {
+          outdated.push_back(j);
+        }
+      }
+      sortUnique(outdated);
+    }
+
+    std::vector<Fingerprint>& colors = rounds.at(r);
+    for(const AtomIndex i : outdated) {
+      const Fingerprint color = (
+        r == 0
+        ? elementColor(inner, i)
+        : refinedColor(inner, rounds.at(r - 1), i)
+      );
+
+      if(r == R - 1) {
+        if(i < colored) {
+          sum.high -= colors[i].high;
+          sum.low -= colors[i].low;
+        }
+        sum.high += color.high;
+        sum.low += color.low;
+      }
+
+      colors[i] = color;
+    }
+  }
+
+  return sum;
+}
+
+Fingerprint Molecule::Impl::constitutionalFingerprint() const {
+  const PrivateGraph& inner = graph().inner();
+
+  Fingerprint sum;
+  {
+    std::lock_guard<std::mutex> lock(constitutionalColors_.mutex);
+    sum = constitutionalColors_.update(inner);
+  }
+
+  FingerprintAccumulator accumulator {constitutionalFingerprintDomain};
+  accumulator.add(static_cast<std::uint64_t>(inner.N()));
+  accumulator.add(static_cast<std::uint64_t>(inner.B()));
+  accumulator.add(sum);
+  return accumulator.state;
+}
+
 const StereopermutatorList& Molecule::Impl::stereopermutators() const {
   return stereopermutators_;
 }
@@ -930,17 +1688,76 @@ StereopermutatorList Molecule::Impl::inferStereopermutatorsFromPositions(
   const AngstromPositions& angstromWrapper,
   const boost::optional<
     std::vector<BondIndex>
-  >& explicitBondStereopermutatorCandidatesOption
+  >& explicitBondStereopermutatorCandidatesOption,
+  const StereopermutatorList* rankingTemplatePtr,
+  const bool shapesOnly
 ) const {
   const AtomIndex size = graph().N();
   StereopermutatorList stereopermutators;
 
-  for(AtomIndex vertex = 0; vertex < size; vertex++) {
-    RankingInformation localRanking = rankPriority(vertex, {}, angstromWrapper);
+  /* Rankings depend on positions only through stereogenic units in the
+   * ranked branches, so a template's rankings are only reusable if it has
+   * none or rankings are made from the graph alone
+   */
+  const bool reuseRankings = (
+    rankingTemplatePtr != nullptr
+    && (
+      shapesOnly
+      || (
+        Temple::all_of(
+          rankingTemplatePtr->atomStereopermutators(),
+          [](const AtomStereopermutator& permutator) {
+            return permutator.numAssignments() <= 1;
+          }
+        ) && Temple::all_of(
+          rankingTemplatePtr->bondStereopermutators(),
+          [](const BondStereopermutator& permutator) {
+            return permutator.numAssignments() <= 1;
+          }
+        )
+      )
+    )
+  );
+
+  /* Atom stereopermutators are ranked and fitted in parallel and added in
+   * index order
+   */
+  std::vector<boost::optional<AtomStereopermutator>> atomStereopermutators(size);
+  Parallel::forEach(size, [&](const unsigned vertex, unsigned /* worker */) {
+    if(reuseRankings) {
+      // Templates have stereopermutators on exactly the non-terminal atoms
+      const auto templateOption = rankingTemplatePtr->option(vertex);
+      if(!templateOption) {
+        return;
+      }
+
+      /* Start from a copy of the template so that its abstract and feasible
+       * stereopermutations are kept if the fitted shape is unchanged
+       */
+      AtomStereopermutator stereopermutator = templateOption.value();
+      stereopermutator.assign(boost::none);
+      const Shapes::Shape dummyShape = ShapeInference::firstOfSize(
+        stereopermutator.getRanking().sites.size()
+      );
+      if(!stereopermutator.fit(adjacencies_, angstromWrapper)) {
+        // Match the state of an unfittable newly constructed stereopermutator
+        stereopermutator.setShape(dummyShape, adjacencies_);
+      }
+      if(shapesOnly) {
+        stereopermutator.assign(boost::none);
+      }
+      atomStereopermutators[vertex] = std::move(stereopermutator);
+      return;
+    }
+
+    // Positions only affect rankings through assigned stereopermutators
+    RankingInformation localRanking = shapesOnly
+      ? rankPriority(vertex)
+      : rankPriority(vertex, {}, angstromWrapper);
 
     // Skip terminal atoms
     if(localRanking.sites.size() <= 1) {
-      continue;
+      return;
     }
 
     Shapes::Shape dummyShape = ShapeInference::firstOfSize(localRanking.sites.size());
@@ -954,7 +1771,39 @@ StereopermutatorList Molecule::Impl::inferStereopermutatorsFromPositions(
     };
 
     stereopermutator.fit(adjacencies_, angstromWrapper);
-    stereopermutators.add(std::move(stereopermutator));
+    if(shapesOnly) {
+      stereopermutator.assign(boost::none);
+    }
+    atomStereopermutators[vertex] = std::move(stereopermutator);
+  });
+
+  /* Stereogenic atoms fitted here could change the rankings of other atoms,
+   * so the reused rankings are discarded
+   */
+  if(
+    reuseRankings
+    && !shapesOnly
+    && Temple::any_of(
+      atomStereopermutators,
+      [](const auto& stereopermutatorOption) {
+        return stereopermutatorOption && stereopermutatorOption->numAssignments() > 1;
+      }
+    )
+  ) {
+    return inferStereopermutatorsFromPositions(
+      angstromWrapper,
+      explicitBondStereopermutatorCandidatesOption
+    );
+  }
+
+  for(auto& stereopermutatorOption : atomStereopermutators) {
+    if(stereopermutatorOption) {
+      stereopermutators.add(std::move(stereopermutatorOption.value()));
+    }
+  }
+
+  if(shapesOnly) {
+    return stereopermutators;
   }
 
   auto tryInstantiateBondStereopermutator = [&](const BondIndex& bondIndex) -> void {
@@ -1040,6 +1889,40 @@ StereopermutatorList Molecule::Impl::inferStereopermutatorsFromPositions(
   return stereopermutators;
 }
 
+std::vector<StereopermutatorList> Molecule::Impl::inferStereopermutatorsFromFrames(
+  const std::vector<AngstromPositions>& frames,
+  const boost::optional<
+    std::vector<BondIndex>
+  >& explicitBondStereopermutatorCandidatesOption
+) const {
+  const unsigned F = frames.size();
+  std::vector<StereopermutatorList> lists(F);
+  if(F == 0) {
+    return lists;
+  }
+
+  // Subsequent frames start from the rankings and stereopermutators of the first
+  lists.front() = inferStereopermutatorsFromPositions(
+    frames.front(),
+    explicitBondStereopermutatorCandidatesOption
+  );
+  const StereopermutatorList& firstFrame = lists.front();
+
+  /* Graph properties were populated while inferring the first frame, so
+   * frames are independent and only read shared state
+   */
+  Parallel::forEach(F - 1, [&](const unsigned i, unsigned /* worker */) {
+    const unsigned f = i + 1;
+    lists[f] = inferStereopermutatorsFromPositions(
+      frames[f],
+      explicitBondStereopermutatorCandidatesOption,
+      &firstFrame
+    );
+  });
+
+  return lists;
+}
+
 bool Molecule::Impl::canonicalCompare(
   const Molecule::Impl& other,
   const AtomEnvironmentComponents componentBitmask
@@ -1144,6 +2027,14 @@ RankingInformation Molecule::Impl::rankPriority(
   const AtomIndex a,
   const std::vector<AtomIndex>& excludeAdjacent,
   const boost::optional<AngstromPositions>& positionsOption
+) const {
+  return rankPriorityAndDepth_(a, excludeAdjacent, positionsOption).first;
+}
+
+std::pair<RankingInformation, unsigned> Molecule::Impl::rankPriorityAndDepth_(
+  const AtomIndex a,
+  const std::vector<AtomIndex>& excludeAdjacent,
+  const boost::optional<AngstromPositions>& positionsOption
 ) const {
   if(!isValidIndex_(a)) {
     throw std::out_of_range("Supplied atom index is invalid!");
@@ -1190,20 +2081,20 @@ RankingInformation Molecule::Impl::rankPriority(
     excludeAdjacent
   );
 
-  return rankingResult;
+  return {std::move(rankingResult), expandedTree.depth()};
 }
 
 bool Molecule::Impl::operator == (const Impl& other) const {
-  if(
-    canonicalComponentsOption_ == AtomEnvironmentComponents::All
-    && other.canonicalComponentsOption_ == AtomEnvironmentComponents::All
-  ) {
-    return canonicalCompare(other, AtomEnvironmentComponents::All);
+  if(graph().N() != other.graph().N() || graph().B() != other.graph().B()) {
+    return false;
   }
 
-  // Better with newer boost: .has_value()
-  return static_cast<bool>(
-    modularIsomorphism(other, AtomEnvironmentComponents::All)
+  /* Fully canonical forms are cached, so that repeated comparisons of the
+   * same molecules only compare hashes and graphs
+   */
+  return canonicalForm(AtomEnvironmentComponents::All)->canonical->canonicalCompare(
+    *other.canonicalForm(AtomEnvironmentComponents::All)->canonical,
+    AtomEnvironmentComponents::All
   );
 }
 
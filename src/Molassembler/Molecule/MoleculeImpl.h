@@ -15,6 +15,9 @@
 #include "Molassembler/StereopermutatorList.h"
 #include "Utils/Geometry/AtomCollection.h"
 
+#include <atomic>
+#include <mutex>
+
 namespace Scine {
 namespace Molassembler {
 
@@ -27,9 +30,94 @@ struct Molecule::Impl {
   //! Returns whether an edge is double, triple or higher bond order
   static bool isGraphBasedBondStereopermutatorCandidate_(BondType bondType);
 
+  /*! @brief Pending stereopermutator detection of lazily constructed molecules
+   *
+   * Copies take over whether detection is pending, but not the mutex.
+   */
+  struct DeferredDetection {
+    DeferredDetection() = default;
+    DeferredDetection(const DeferredDetection& other) noexcept
+      : pending(other.pending.load(std::memory_order_acquire)) {}
+
+    std::atomic<bool> pending {false};
+    std::mutex mutex;
+  };
+
+  //! Canonical form of a molecule for a set of components
+  struct CanonicalForm {
+    AtomEnvironmentComponents components;
+    //! Mapping from the molecule's atom indices to canonical indices
+    std::vector<AtomIndex> permutation;
+    //! Canonical implementation, the molecule's own if already canonical
+    std::shared_ptr<const Impl> canonical;
+  };
+
+  /*! @brief Canonical forms of a molecule, cached for repeated comparisons
+   *
+   * Copies start without cached forms.
+   */
+  struct CanonicalFormCache {
+    CanonicalFormCache() = default;
+    CanonicalFormCache(const CanonicalFormCache& /* other */) {}
+
+    std::mutex mutex;
+    std::vector<std::shared_ptr<const CanonicalForm>> forms;
+  };
+
+  //! Number of refinement rounds of constitutional colors
+  static constexpr unsigned constitutionalRefinements = 3;
+
+  /*! @brief Constitutional atom colors of each refinement round, maintained
+   *   under edits
+   *
+   * Edits mark the atoms whose element type or bonds changed. Colors of atoms
+   * beyond those colored are missing, i.e. those atoms were added since.
+   * Not thread-safe by itself. Copies take over colors and marks.
+   */
+  struct ConstitutionalColors {
+    ConstitutionalColors() = default;
+    ConstitutionalColors(const ConstitutionalColors& other);
+
+    //! Marks atoms whose element type or bonds changed
+    void mark(const std::vector<AtomIndex>& atoms);
+    //! Drops the colors of a removed atom, shifting marks of higher indices
+    void remove(AtomIndex a);
+    //! Applies an index permutation to colors and marks
+    void permute(const std::vector<AtomIndex>& permutation);
+    /*! @brief Recolors marked and added atoms and atoms close to them
+     *
+     * @returns The lane-wise sum of colors of the last round
+     */
+    Fingerprint update(const PrivateGraph& inner);
+
+    mutable std::mutex mutex;
+    //! Atom colors of each round. Empty if no colors were calculated yet.
+    std::vector<std::vector<Fingerprint>> rounds;
+    //! Atoms whose colors are outdated
+    std::vector<AtomIndex> marked;
+    //! Lane-wise sum of colors of the last round
+    Fingerprint sum {0, 0};
+  };
+
   Graph adjacencies_;
-  StereopermutatorList stereopermutators_;
+  /*! Empty while detection is pending. Detection on first const access
+   * publishes the list, so it is mutable.
+   */
+  mutable StereopermutatorList stereopermutators_;
+  mutable DeferredDetection deferredDetection_;
   boost::optional<AtomEnvironmentComponents> canonicalComponentsOption_;
+  /*! Depth of the ranking tree last used to rank each atom while propagating
+   * graph changes. Empty if unknown.
+   */
+  std::vector<unsigned> rankingDepths_;
+  /*! Atoms at which the graph changed during a batched edit. None if graph
+   * changes are propagated immediately.
+   */
+  boost::optional<std::vector<AtomIndex>> batchedEditSites_;
+  //! Cleared on mutable access through Molecule
+  mutable CanonicalFormCache canonicalForms_;
+  //! Updated on const access, so it is mutable
+  mutable ConstitutionalColors constitutionalColors_;
 
 /* "Private" helpers */
   void tryAddAtomStereopermutator_(
@@ -37,6 +125,22 @@ struct Molecule::Impl {
     StereopermutatorList& stereopermutators
   ) const;
 
+  /*! @brief Instantiates a stereopermutator for an already determined ranking
+   *
+   * @returns None if the atom is terminal
+   */
+  boost::optional<AtomStereopermutator> makeAtomStereopermutator_(
+    AtomIndex candidateIndex,
+    RankingInformation localRanking
+  ) const;
+
+  //! Adds an atom stereopermutator with an already determined ranking
+  bool tryAddAtomStereopermutator_(
+    AtomIndex candidateIndex,
+    RankingInformation localRanking,
+    StereopermutatorList& stereopermutators
+  ) const;
+
   void tryAddBondStereopermutator_(
     const BondIndex& bond,
     StereopermutatorList& stereopermutators
@@ -51,9 +155,55 @@ struct Molecule::Impl {
   //! Returns whether the specified index is valid or not
   bool isValidIndex_(AtomIndex index) const;
 
+  //! Ranks an atom's substituents, also yielding the ranking tree depth
+  std::pair<RankingInformation, unsigned> rankPriorityAndDepth_(
+    AtomIndex a,
+    const std::vector<AtomIndex>& excludeAdjacent = {},
+    const boost::optional<AngstromPositions>& positionsOption = boost::none
+  ) const;
+
+  /*! @brief Updates or adds the stereopermutator at an atom for a new ranking
+   *
+   * @returns Whether the atom's stereopermutator was altered
+   */
+  bool propagateRanking_(AtomIndex vertex, RankingInformation localRanking);
+
   //! Updates the molecule's StereopermutatorList after a graph modification
   void propagateGraphChange_();
 
+  /*! @brief Updates the molecule's StereopermutatorList after a local graph
+   *   modification
+   *
+   * Re-ranks only atoms whose last ranking tree was deep enough to reach any
+   * of the modified atoms. Falls back to a full propagation if ranking depths
+   * are not known for all atoms.
+   *
+   * @param editSites Atoms at which the graph or stereopermutators changed
+   */
+  void propagateGraphChange_(std::vector<AtomIndex> editSites);
+
+  //! Updates eta bond types, adding the atoms of altered bonds to the edit sites
+  void updateEtaBonds_(std::vector<AtomIndex>& editSites);
+
+  /*! @brief Propagates stereopermutators at atoms about to be edited again
+   *   within a batched edit
+   *
+   * Stereopermutator propagation handles only a single site change, so atoms
+   * with deferred changes are re-ranked before they are edited once more.
+   * Does nothing outside of batched edits.
+   */
+  void prepareBatchedEdit_(const std::vector<AtomIndex>& sites);
+
+  /*! @brief Removes an atom without checking whether that disconnects the graph
+   *
+   * @returns The adjacent atoms of the removed atom in the new indexing, i.e.
+   *   the edit sites to propagate
+   */
+  std::vector<AtomIndex> removeAtomUnchecked_(AtomIndex a);
+
+  //! Copies while holding the lock on the other's pending detection, if any
+  Impl(const Impl& other, std::unique_lock<std::mutex> detectionLock);
+
 
 //!@name Constructors
 //!@{
@@ -70,16 +220,29 @@ struct Molecule::Impl {
     BondType bondType
   ) noexcept;
 
-  //! Graph-only constructor
-  explicit Impl(Graph graph);
+  /*! @brief Graph-only constructor
+   *
+   * @param graph The graph from which to construct the molecule
+   * @param lazy Whether to defer ranking and stereopermutator detection until
+   *   stereopermutators are first needed
+   */
+  explicit Impl(Graph graph, bool lazy = false);
+
+  /*! @brief Copy constructor
+   *
+   * Waits for a concurrent detection of deferred stereopermutators to finish
+   */
+  Impl(const Impl& other);
 
-  //! Graph and positions constructor
+  //! Graph and positions constructor, optionally reusing template rankings
   Impl(
     Graph graph,
     const AngstromPositions& positions,
     const boost::optional<
       std::vector<BondIndex>
-    >& bondStereopermutatorCandidatesOptional = boost::none
+    >& bondStereopermutatorCandidatesOptional = boost::none,
+    const StereopermutatorList* rankingTemplatePtr = nullptr,
+    bool shapesOnly = false
   );
 
   //! Graph and stereopermutators constructor
@@ -175,6 +338,9 @@ struct Molecule::Impl {
    */
   void assignStereopermutatorRandomly(const BondIndex& e, Random::Engine& engine);
 
+  //! Defers stereopermutator propagation of graph edits until commitEdits
+  void beginEdits();
+
   /**
    * @brief Canonicalizes the graph, invalidating all atom and bond indices.
    *
@@ -203,6 +369,9 @@ struct Molecule::Impl {
     AtomEnvironmentComponents componentBitmask
   );
 
+  //! Propagates all graph edits deferred since beginEdits
+  void commitEdits();
+
   /*! Removes an atom from the graph, including bonds to it.
    *
    * Removes an atom from the molecular graph, including bonds to the atom,
@@ -213,6 +382,16 @@ struct Molecule::Impl {
    */
   void removeAtom(AtomIndex a);
 
+  /*! Removes several atoms from the graph, including bonds to them.
+   *
+   * Checks only once that the remaining atoms stay connected and propagates
+   * the graph change once for the whole batch.
+   *
+   * \throws if any index is invalid, if all atoms would be removed or if the
+   *   remaining atoms are disconnected.
+   */
+  void removeAtoms(std::vector<AtomIndex> atoms);
+
   /*!
    * Removes an atom after checking if removing that bond is safe, i.e. does not
    * disconnect the graph. An example of bonds that can always be removed are
@@ -264,6 +443,31 @@ struct Molecule::Impl {
 
 //!@name Information
 //!@{
+  /*! @brief Detects stereopermutators if detection was deferred
+   *
+   * Safe on concurrent const access. Member functions of Impl expect
+   * detection to have happened if they read stereopermutators. Molecule's
+   * member functions call this as needed.
+   *
+   * @returns This implementation
+   */
+  const Impl& withStereopermutators() const;
+
+  //! Whether stereopermutator detection is deferred and still pending
+  bool deferredStereopermutators() const;
+
+  /*! @brief Canonical form for a set of components, cached until modification
+   *
+   * Safe on concurrent const access.
+   *
+   * @pre Stereopermutators are detected if @p components include shapes or
+   *   stereopermutations
+   */
+  std::shared_ptr<const CanonicalForm> canonicalForm(AtomEnvironmentComponents components) const;
+
+  //! Drops cached canonical forms before modification
+  void invalidateCanonicalForms();
+
   //! Yield which components were used in canonicalization
   boost::optional<AtomEnvironmentComponents> canonicalComponents() const;
 
@@ -286,14 +490,56 @@ struct Molecule::Impl {
   //! Convolutional hash
   std::size_t hash() const;
 
+  //! Fingerprint of the canonical form
+  Fingerprint fingerprint(AtomEnvironmentComponents componentBitmask) const;
+
+  //! Fingerprint of refined atom environment hashes
+  Fingerprint invariantFingerprint(AtomEnvironmentComponents componentBitmask) const;
+
+  /*! @brief Fingerprint of incrementally refined constitutional atom colors
+   *
+   * Safe on concurrent const access.
+   */
+  Fingerprint constitutionalFingerprint() const;
+
+  //! Fingerprint of refined atom environment hashes of any graph
+  static Fingerprint invariantFingerprint(
+    const PrivateGraph& inner,
+    boost::optional<const StereopermutatorList&> stereopermutatorsOption,
+    AtomEnvironmentComponents componentBitmask
+  );
+
   //! Provides read-only access to the list of stereopermutators
   const StereopermutatorList& stereopermutators() const;
 
+  /*! @brief Infer stereopermutators from positions
+   *
+   * If a ranking template is supplied and neither it nor any of the fitted
+   * atom stereopermutators is stereogenic, the template atom
+   * stereopermutators' rankings are reused instead of ranking atoms anew.
+   * The template must belong to a molecule with an identical graph. Its atom
+   * stereopermutators are then copied and refitted, keeping their abstract
+   * and feasible stereopermutations unless the fitted shape changes.
+   *
+   * If only shapes are to be inferred, atoms are ranked from the graph alone,
+   * atom stereopermutators are left unassigned and no bond stereopermutators
+   * are instantiated.
+   */
   StereopermutatorList inferStereopermutatorsFromPositions(
     const AngstromPositions& angstromWrapper,
     const boost::optional<
       std::vector<BondIndex>
-    >& explicitBondStereopermutatorCandidatesOption = boost::none
+    >& explicitBondStereopermutatorCandidatesOption = boost::none,
+    const StereopermutatorList* rankingTemplatePtr = nullptr,
+    bool shapesOnly = false
+  ) const;
+
+  //! Infer stereopermutators from several frames of positions
+  std::vector<StereopermutatorList> inferStereopermutatorsFromFrames(
+    const std::vector<AngstromPositions>& frames,
+    const boost::optional<
+      std::vector<BondIndex>
+    >& explicitBondStereopermutatorCandidatesOption
   ) const;
 
   //! Compares two canonical instances with one another
@@ -14,16 +14,20 @@
  *   particularly now since addAllFromOther and addRelationshipsFromOther
  *   exist, which can hypothetically create completely disjoint sets which can
  *   then get conflated in getSets and getUnorderedSets
- * - addTransferabilityEdges needs a better algorithm
  */
 
 #ifndef INCLUDE_MOLASSEMBLER_ORDER_DISCORVERY_HELPER
 #define INCLUDE_MOLASSEMBLER_ORDER_DISCORVERY_HELPER
 
-#include "boost/graph/adjacency_list.hpp"
-#include "boost/graph/graphviz.hpp"
 #include "Molassembler/Temple/Adaptors/Transform.h"
 #include "Molassembler/Temple/Functional.h"
+#include "boost/optional.hpp"
+
+#include <algorithm>
+#include <bitset>
+#include <cstdint>
+#include <sstream>
+#include <stdexcept>
 
 namespace Scine {
 
@@ -31,46 +35,84 @@ namespace Molassembler {
 
 /**
  * @brief Container aiding in gradual discovery of order
+ *
+ * Less-than relationships are stored as rows of a flat bit matrix, so that
+ * the small sets typical in ranking need only a handful of allocations and
+ * transferability edges are found with word-wise bit operations.
+ *
  * @tparam T The type whose order is to be discovered
  */
 template<typename T>
 class OrderDiscoveryHelper {
 public:
-  struct VertexData {
-    T data;
-  };
-
-  using DependencyGraphType = boost::adjacency_list<
-    /* OutEdgeListS = Type of Container for edges of a vertex
-     * Options: vector, list, slist, set, multiset, unordered_set
-     * Choice: setS
-     */
-    boost::setS,
-    /* VertexListS = Type of Container for vertices
-     * Options: vector, list, slist, set, multiset, unordered_set
-     * Choice: vecS, removing vertices does not occur
-     */
-    boost::vecS,
-    /* DirectedS = Is the graph directed or not?
-     * Choice: Directed, do not need bidirectional
-     */
-    boost::directedS,
-    /* VertexProperty = What information is stored about vertices?
-     * Choice: Atom, containing an index and an element type
-     */
-    VertexData
-  >;
-
-  using VertexIndexType = typename DependencyGraphType::vertex_descriptor;
+  using VertexIndexType = unsigned;
 
 private:
-  std::map<T, VertexIndexType> sourceMap_;
-  DependencyGraphType graph_;
+  using Word = std::uint64_t;
+  static constexpr unsigned wordBits = 64;
+
+  //! Values by vertex index
+  std::vector<T> values_;
+  //! Words per row of the relationship matrix
+  unsigned stride_ = 0;
+  //! Bit j of row i is set if values_[i] < values_[j]
+  std::vector<Word> smaller_;
+
+  static unsigned wordsFor_(const unsigned N) {
+    return (N + wordBits - 1) / wordBits;
+  }
+
+  bool test_(const VertexIndexType i, const VertexIndexType j) const {
+    return (smaller_[i * stride_ + j / wordBits] >> (j % wordBits)) & 1U;
+  }
+
+  void set_(const VertexIndexType i, const VertexIndexType j) {
+    smaller_[i * stride_ + j / wordBits] |= Word {1} << (j % wordBits);
+  }
+
+  unsigned outDegree_(const VertexIndexType i) const {
+    unsigned degree = 0;
+    for(unsigned w = 0; w < stride_; ++w) {
+      degree += std::bitset<wordBits>(smaller_[i * stride_ + w]).count();
+    }
+    return degree;
+  }
+
+  //! Linear search suffices for the small sets this is used for
+  boost::optional<VertexIndexType> index_(const T& item) const {
+    const auto findIter = std::find(std::begin(values_), std::end(values_), item);
+    if(findIter == std::end(values_)) {
+      return boost::none;
+    }
+
+    return static_cast<VertexIndexType>(findIter - std::begin(values_));
+  }
+
+  //! Resizes the relationship matrix to the number of values, keeping relationships
+  void restride_() {
+    const unsigned N = values_.size();
+    const unsigned stride = wordsFor_(N);
+    if(stride == stride_) {
+      smaller_.resize(N * stride_, 0);
+      return;
+    }
+
+    std::vector<Word> smaller(N * stride, 0);
+    for(unsigned i = 0; i < smaller_.size() / std::max(stride_, 1U); ++i) {
+      std::copy_n(
+        std::begin(smaller_) + i * stride_,
+        stride_,
+        std::begin(smaller) + i * stride
+      );
+    }
+    smaller_ = std::move(smaller);
+    stride_ = stride;
+  }
 
   /*!
    * @brief Get a grouped list of the ordered data sorted by out_degree ascending
    *
-   * @complexity{@math{\Theta(N)}}
+   * @complexity{@math{\Theta(N \log N)}}
    */
   std::vector<
     std::vector<T>
@@ -81,81 +123,67 @@ private:
      * relationship is represented by a directed edge from the smaller object
      * to the bigger object.
      */
-
-    // Keep a mapping of out_degree to index in sets to avoid empty sets
-    std::map<
-      unsigned,
-      std::vector<VertexIndexType>
-    > degreeToSetMap;
-
-    using Iterator = typename DependencyGraphType::vertex_iterator;
-    Iterator iter;
-    Iterator end;
-    std::tie(iter, end) = boost::vertices(graph_);
-
-    while(iter != end) {
-      auto outDegree = boost::out_degree(*iter, graph_);
-
-      if(degreeToSetMap.count(outDegree) == 0) {
-        degreeToSetMap[outDegree] = {*iter};
-      } else {
-        degreeToSetMap.at(outDegree).push_back(*iter);
-      }
-
-      ++iter;
+    const unsigned N = values_.size();
+    std::vector<std::pair<unsigned, VertexIndexType>> degrees;
+    degrees.reserve(N);
+    for(VertexIndexType i = 0; i < N; ++i) {
+      degrees.emplace_back(outDegree_(i), i);
     }
-
-    /* The map is ordered by key (outDegree ASC), so the result of mapValues
-     * should is ordered too, so we can just map the vertex descriptors for
-     * every degree into the stored underlying data
-     */
-    return Temple::map(
-      degreeToSetMap,
-      [&](const auto& mapIterPair) -> std::vector<T> {
-        return Temple::map_stl(
-          mapIterPair.second,
-          [&](const auto& index) -> T {
-            return graph_[index].data;
-          }
-        );
+    std::sort(std::begin(degrees), std::end(degrees));
+
+    std::vector<
+      std::vector<T>
+    > sets;
+    for(unsigned i = 0; i < N; ++i) {
+      if(i == 0 || degrees[i].first != degrees[i - 1].first) {
+        sets.emplace_back();
       }
-    );
+      sets.back().push_back(values_[degrees[i].second]);
+    }
+    return sets;
   }
 
   VertexIndexType addItem_(const T& item) {
-    auto newIndex = boost::add_vertex(graph_);
-
-    graph_[newIndex].data = item;
-    sourceMap_.emplace(
-      item,
-      newIndex
-    );
-
-    return newIndex;
+    values_.push_back(item);
+    restride_();
+    return values_.size() - 1;
   }
 
+  /*! @brief Adds relationships of another instance between values of both
+   *
+   * @throws const char* If relationships contradict one another
+   */
+  void addEdgesFromOther_(const OrderDiscoveryHelper& other) {
+    const unsigned M = other.values_.size();
+    const auto vertexMapping = Temple::map(
+      other.values_,
+      [&](const T& value) { return index_(value); }
+    );
 
-  class GraphvizWriter {
-  private:
-    const OrderDiscoveryHelper& baseRef_;
+    for(VertexIndexType i = 0; i < M; ++i) {
+      if(!vertexMapping[i]) {
+        continue;
+      }
 
-  public:
-    GraphvizWriter(const OrderDiscoveryHelper& base) : baseRef_(base) {}
+      for(VertexIndexType j = 0; j < M; ++j) {
+        if(!vertexMapping[j] || !other.test_(i, j)) {
+          continue;
+        }
 
-    void operator() (std::ostream& os) const {
-      os << "graph [fontname = \"Arial\", layout = \"dot\"];\n"
-        << "node [fontname = \"Arial\", shape = circle, style = filled];\n"
-        << "edge [fontname = \"Arial\"];\n";
-    }
+        const VertexIndexType thisSource = *vertexMapping[i];
+        const VertexIndexType thisTarget = *vertexMapping[j];
+        if(test_(thisSource, thisTarget)) {
+          continue;
+        }
 
-    void operator() (std::ostream& os, const VertexIndexType& vertexIndex) const {
-      os << R"([label=")" << baseRef_.graph_[vertexIndex].data << R"("])";
-    }
+        if(test_(thisTarget, thisSource)) {
+          throw "Contradicting information in other OrderDiscoveryHelper graph!";
+        }
 
-    void operator() (std::ostream& /* os */, const typename DependencyGraphType::edge_descriptor& /* edge */) const {
-      // do nothing particular
+        set_(thisSource, thisTarget);
+      }
     }
-  };
+  }
 
 public:
   OrderDiscoveryHelper() = default;
@@ -185,65 +213,7 @@ public:
    * @complexity{@math{\Theta(N^2)}}
    */
   void addRelationshipsFromOther(const OrderDiscoveryHelper& other) {
-    // Build a mapping of vertices
-    std::map<VertexIndexType, VertexIndexType> vertexMapping;
-
-    for(VertexIndexType i = 0; i < boost::num_vertices(other.graph_); ++i) {
-      // Does this vertex exist in this graph already?
-      const auto& vertexData = other.graph_[i].data;
-      if(sourceMap_.count(vertexData) > 0) {
-        vertexMapping.emplace(
-          i,
-          sourceMap_.at(vertexData)
-        );
-      }
-    }
-
-    // Add non-contradicting edges from the other graph
-    for(
-      auto edgeIterPair = boost::edges(other.graph_);
-      edgeIterPair.first != edgeIterPair.second;
-      ++edgeIterPair.first
-    ) {
-      auto otherEdgeSource = boost::source(*edgeIterPair.first, other.graph_);
-      auto otherEdgeTarget = boost::target(*edgeIterPair.first, other.graph_);
-
-      if( // Both endpoints must have a counterpart in this graph
-        vertexMapping.count(otherEdgeSource) > 0
-        && vertexMapping.count(otherEdgeTarget) > 0
-      ) {
-        auto thisEdgeSource = vertexMapping.at(otherEdgeSource);
-        auto thisEdgeTarget = vertexMapping.at(otherEdgeTarget);
-
-        // Check if that edge already exists (or its inverse)
-        auto thisGraphEdge = boost::edge(
-          thisEdgeSource,
-          thisEdgeTarget,
-          graph_
-        );
-
-        // In case the graph edge is found, go to the next edge
-        if(thisGraphEdge.second) {
-          continue;
-        }
-
-        // If not, check if the inverse is present in the graph
-        auto inverseGraphEdge = boost::edge(
-          thisEdgeTarget,
-          thisEdgeSource,
-          graph_
-        );
-
-        if(inverseGraphEdge.second) {
-          throw "Contradicting information in other OrderDiscoveryHelper graph!";
-        }
-
-        // Add the edge to this graph
-        boost::add_edge(thisEdgeSource, thisEdgeTarget, graph_);
-
-      }
-    }
-
+    addEdgesFromOther_(other);
     addTransferabilityEdges();
   }
 
@@ -258,113 +228,39 @@ public:
    * @complexity{@math{O(N^2)}}
    */
   void addAllFromOther(const OrderDiscoveryHelper& other) {
-    // Left is the other graph, right is this graph
-    std::map<VertexIndexType, VertexIndexType> vertexMapping;
-
     // Add all new vertices from the other graph
-    for(VertexIndexType i = 0; i < boost::num_vertices(other.graph_); ++i) {
-      // Does this vertex exist in this graph already?
-      const auto& vertexData = other.graph_[i].data;
-      if(sourceMap_.count(vertexData) == 0) {
-        auto newIndex = addItem_(other.graph_[i].data);
-        vertexMapping.emplace(
-          i,
-          newIndex
-        );
-      } else {
-        vertexMapping.emplace(
-          i,
-          sourceMap_.at(vertexData)
-        );
+    for(const T& value : other.values_) {
+      if(!index_(value)) {
+        values_.push_back(value);
       }
     }
+    restride_();
 
-    // Add non-contradicting edges from the other graph
-    for(
-      auto edgeIterPair = boost::edges(other.graph_);
-      edgeIterPair.first != edgeIterPair.second;
-      ++edgeIterPair.first
-    ) {
-      auto otherEdgeSource = boost::source(*edgeIterPair.first, other.graph_);
-      auto otherEdgeTarget = boost::target(*edgeIterPair.first, other.graph_);
-
-      auto thisEdgeSource = vertexMapping.at(otherEdgeSource);
-      auto thisEdgeTarget = vertexMapping.at(otherEdgeTarget);
-
-      // Check if that edge already exists (or its inverse)
-      auto thisGraphEdge = boost::edge(
-        thisEdgeSource,
-        thisEdgeTarget,
-        graph_
-      );
-
-      // In case the graph edge is found, go to the next edge
-      if(thisGraphEdge.second) {
-        continue;
-      }
-
-      // If not, check if the inverse is present in the graph
-      auto inverseGraphEdge = boost::edge(
-        thisEdgeTarget,
-        thisEdgeSource,
-        graph_
-      );
-
-      if(inverseGraphEdge.second) {
-        throw "Contradicting information in other OrderDiscoveryHelper graph!";
-      }
-
-      // Add the edge to this graph
-      boost::add_edge(thisEdgeSource, thisEdgeTarget, graph_);
-    }
-
+    addEdgesFromOther_(other);
     addTransferabilityEdges();
   }
 
   /*! @brief Adds missing transferability edges
    *
-   * Adds any missing transferability edges (if a < b && b < c, then a < c).
-   *
-   * @complexity{@math{O(N^2)}}
+   * Adds any missing transferability edges (if a < b && b < c, then a < c) by
+   * Warshall's algorithm on the rows of the relationship matrix.
    *
-   * This function is awful in terms of complexity, it's worst case of O(N²).
-   * There must be better ways of doing this.
+   * @complexity{@math{\Theta(N^3 / w)} for word size @math{w}}
    */
   void addTransferabilityEdges() {
-    for(VertexIndexType i = 0; i < boost::num_vertices(graph_); ++i) {
-      std::vector<VertexIndexType> seeds;
-
-      for(
-        auto edgeIterPair = boost::out_edges(i, graph_);
-        edgeIterPair.first != edgeIterPair.second;
-        ++edgeIterPair.first
-      ) {
-        seeds.emplace_back(
-          boost::target(*edgeIterPair.first, graph_)
-        );
-      }
-
-      do {
-        std::vector<VertexIndexType> newSeeds;
-
-        for(const auto& seed: seeds) {
-          if(!boost::edge(i, seed, graph_).second) {
-            boost::add_edge(i, seed, graph_);
-          }
-
-          for(
-            auto edgeIterPair = boost::out_edges(seed, graph_);
-            edgeIterPair.first != edgeIterPair.second;
-            ++edgeIterPair.first
-          ) {
-            newSeeds.emplace_back(
-              boost::target(*edgeIterPair.first, graph_)
-            );
-          }
+    const unsigned N = values_.size();
+    for(VertexIndexType k = 0; k < N; ++k) {
+      const auto kRow = std::begin(smaller_) + k * stride_;
+      for(VertexIndexType i = 0; i < N; ++i) {
+        if(!test_(i, k)) {
+          continue;
         }
 
-        seeds = std::move(newSeeds);
-      } while(!seeds.empty());
+        const auto iRow = std::begin(smaller_) + i * stride_;
+        for(unsigned w = 0; w < stride_; ++w) {
+          iRow[w] |= kRow[w];
+        }
+      }
     }
   }
 
@@ -375,15 +271,15 @@ public:
    */
   template<typename It>
   void setUnorderedValues(It iter, const It end) {
-    if(boost::num_vertices(graph_) > 0) {
-      graph_.clear();
-    }
-
-    sourceMap_.clear();
+    values_.clear();
+    smaller_.clear();
+    stride_ = 0;
 
     for(/* */; iter != end; ++iter) {
-      addItem_(*iter);
+      values_.push_back(*iter);
     }
+
+    restride_();
   }
 
   /*!  @brief Container-abstracted @see setUnorderedValues
@@ -408,7 +304,7 @@ public:
 
   /*! @brief Get a list of sets (in descending order) as currently discovered
    *
-   * @complexity{@math{\Theta(N)}}
+   * @complexity{@math{\Theta(N \log N)}}
    */
   std::vector<
     std::vector<T>
@@ -419,7 +315,7 @@ public:
 
   /*! @brief Returns grouped data (in descending order) whose internal order is undecided
    *
-   * @complexity{@math{\Theta(N)}}
+   * @complexity{@math{\Theta(N \log N)}}
    */
   std::vector<
     std::vector<T>
@@ -435,17 +331,21 @@ public:
 
   /*! @brief Returns whether the total order has been discovered or not
    *
-   * @complexity{@math{\Theta(1)}}
+   * @complexity{@math{\Theta(N^2 / w)} for word size @math{w}}
    */
   bool isTotallyOrdered() const {
-    auto N = boost::num_vertices(graph_);
+    const unsigned N = values_.size();
+    unsigned edges = 0;
+    for(const Word word : smaller_) {
+      edges += std::bitset<wordBits>(word).count();
+    }
 
-    return(boost::num_edges(graph_) == N * (N - 1) / 2);
+    return edges == N * (N - 1) / 2;
   }
 
   /*! @brief Add a less-than relationship to the graph
    *
-   * @complexity{@math{\Theta(1)}}
+   * @complexity{@math{O(N)}}
    */
   void addLessThanRelationship(
     const T& a,
@@ -456,30 +356,40 @@ public:
     /* Less-than relationship is represented as directed edge from vertex
      * storing a to vertex storing b
      */
-    boost::add_edge(
-      sourceMap_.at(a),
-      sourceMap_.at(b),
-      graph_
-    );
+    const auto aIndex = index_(a);
+    const auto bIndex = index_(b);
+    if(!aIndex || !bIndex) {
+      throw std::out_of_range("Value not in OrderDiscoveryHelper");
+    }
+
+    set_(*aIndex, *bIndex);
   }
 
   /*! @brief Dumps a graphviz string for visualization of relationships
    *
-   * @complexity{@math{\Theta(N)}}
+   * @complexity{@math{\Theta(N^2)}}
    */
   std::string dumpGraphviz() const {
-    GraphvizWriter propertyWriter(*this);
-
+    const unsigned N = values_.size();
     std::stringstream ss;
+    ss << "digraph G {\n"
+      << "graph [fontname = \"Arial\", layout = \"dot\"];\n"
+      << "node [fontname = \"Arial\", shape = circle, style = filled];\n"
+      << "edge [fontname = \"Arial\"];\n";
 
-    boost::write_graphviz(
-      ss,
-      graph_,
-      propertyWriter,
-      propertyWriter,
-      propertyWriter
-    );
+    for(VertexIndexType i = 0; i < N; ++i) {
+      ss << i << R"([label=")" << values_[i] << R"("];)" << "\n";
+    }
+
+    for(VertexIndexType i = 0; i < N; ++i) {
+      for(VertexIndexType j = 0; j < N; ++j) {
+        if(test_(i, j)) {
+          ss << i << "->" << j << " ;\n";
+        }
+      }
+    }
 
+    ss << "}\n";
     return ss.str();
   }
 
@@ -492,16 +402,17 @@ public:
    * ordering relationship or the ordering relationship is the other way
    * around), this function returns false.
    *
-   * @complexity{@math{\Theta(1)}}
+   * @complexity{@math{O(N)}}
    */
   bool isSmaller(const T& a, const T& b) const {
-    if(sourceMap_.count(a) == 0 || sourceMap_.count(b) == 0) {
+    const auto aIndex = index_(a);
+    const auto bIndex = index_(b);
+    if(!aIndex || !bIndex) {
       return false;
     }
 
     // is a < b?
-    auto smallerEdge = boost::edge(sourceMap_.at(a), sourceMap_.at(b), graph_);
-    return smallerEdge.second;
+    return test_(*aIndex, *bIndex);
   }
 };
 
@@ -20,6 +20,8 @@
 #include "Molassembler/Graph.h"
 #include "Molassembler/Graph/GraphAlgorithms.h"
 #include "Molassembler/Graph/PrivateGraph.h"
+#include "Molassembler/Detail/Metrics.h"
+#include "Molassembler/Metrics.h"
 #include "Molassembler/Modeling/ShapeInference.h"
 #include "Molassembler/Molecule/MolGraphWriter.h"
 #include "Molassembler/Options.h"
@@ -27,12 +29,63 @@
 #include "Molassembler/Stereopermutators/AbstractPermutations.h"
 #include "Molassembler/Stereopermutators/FeasiblePermutations.h"
 
+#include <atomic>
 #include <fstream>
 #include <iostream>
 
 namespace Scine {
 namespace Molassembler {
 
+namespace {
+
+std::array<std::atomic<unsigned>, 5> sequenceRuleReachedCounts {};
+std::atomic<unsigned> stereodescriptorRulesSkippedCount {0};
+
+void countReached(const unsigned rule) {
+  sequenceRuleReachedCounts.at(rule - 1).fetch_add(1, std::memory_order_relaxed);
+}
+
+//! Tallies a ranking and the depth its tree reached in the library metrics
+class RankingTally {
+public:
+  explicit RankingTally(const std::vector<unsigned>& depths) : depths_(depths) {}
+
+  RankingTally(const RankingTally& other) = delete;
+  RankingTally& operator = (const RankingTally& other) = delete;
+
+  ~RankingTally() {
+    if(!depths_.empty()) {
+      Detail::Metrics::recordRankingDepth(
+        *std::max_element(std::begin(depths_), std::end(depths_))
+      );
+    }
+  }
+
+private:
+  const Detail::Metrics::Timer timer_ {Detail::Metrics::Operation::Ranking};
+  const std::vector<unsigned>& depths_;
+};
+
+} // namespace
+
+class RankingTree::WatchdogScope {
+public:
+  explicit WatchdogScope(const RankingTree& tree) : tree_(tree) {}
+
+  WatchdogScope(const WatchdogScope& other) = delete;
+  WatchdogScope& operator = (const WatchdogScope& other) = delete;
+
+  ~WatchdogScope() {
+    // Cancelled or failed rankings were reported while running, if at all
+    if(!std::uncaught_exception()) {
+      tree_.watch_(true);
+    }
+  }
+
+private:
+  const RankingTree& tree_;
+};
+
 // Must declare constexpr static member without definition!
 constexpr decltype(RankingTree::rootIndex) RankingTree::rootIndex;
 
@@ -657,6 +710,8 @@ public:
 void RankingTree::applySequenceRules_(
   const boost::optional<AngstromPositions>& positionsOption
 ) {
+  reachRule_(2);
+
   /* Sequence rule 2
    * - A node with higher atomic mass precedes ones with lower atomic mass
    */
@@ -764,6 +819,51 @@ void RankingTree::applySequenceRules_(
     }
   } while(moreEdges);
 
+  /* Without positions, auxiliary stereopermutators are only assigned with
+   * more than a single assignment if they can take over the assignment of an
+   * assigned molecule stereopermutator with multiple stereopermutations, and
+   * bond stereopermutators only if a molecule bond stereopermutator is
+   * assigned. If there are none of these in the undecided branches, sequence
+   * rules three to five cannot order them and stereopermutators need not be
+   * instantiated.
+   */
+  if(!positionsOption) {
+    auto atomIsStereogenic = [&](const TreeVertexIndex vertex) -> bool {
+      auto permutatorOption = stereopermutatorsRef_.option(tree_[vertex].molIndex);
+      return (
+        permutatorOption
+        && permutatorOption->assigned()
+        && permutatorOption->numStereopermutations() > 1
+      );
+    };
+
+    const bool anyStereogenic = Temple::any_of(
+      byDepth,
+      [&](const std::set<TreeEdgeIndex>& edges) -> bool {
+        return Temple::any_of(
+          edges,
+          [&](const TreeEdgeIndex& edge) -> bool {
+            const TreeVertexIndex source = boost::source(edge, tree_);
+            const TreeVertexIndex target = boost::target(edge, tree_);
+            if(atomIsStereogenic(source) || atomIsStereogenic(target)) {
+              return true;
+            }
+
+            auto bondPermutatorOption = stereopermutatorsRef_.option(
+              BondIndex {tree_[source].molIndex, tree_[target].molIndex}
+            );
+            return bondPermutatorOption && bondPermutatorOption->assigned();
+          }
+        );
+      }
+    );
+
+    if(!anyStereogenic) {
+      stereodescriptorRulesSkippedCount.fetch_add(1, std::memory_order_relaxed);
+      return;
+    }
+  }
+
   // Remember if you found something to instantiate or not
   bool foundBondStereopermutators = false;
   bool foundAtomStereopermutators = false;
@@ -1084,6 +1184,7 @@ void RankingTree::applySequenceRules_(
 
   // Was any BondStereopermutator added? If not, we can skip rule 3.
   if(foundBondStereopermutators) {
+    reachRule_(3);
 
     // Apply sequence rule 3
     runBFS_<
@@ -1160,6 +1261,8 @@ void RankingTree::applySequenceRules_(
    */
 
   { // Sequence rule 4 local scope
+    reachRule_(4);
+
     /* First part of rule: A regular omni-directional BFS, inserting both
      * edges and node indices into the multiset! Perhaps avoiding the
      * insertion of uninstantiated edges and vertices entirely?
@@ -1236,6 +1339,9 @@ void RankingTree::applySequenceRules_(
     /* Loop BFS */
 
     while(!undecidedSets.empty() && relevantSeeds_(seeds, undecidedSets)) {
+      cancellation_.check();
+      watch_(false);
+
       // Perform a full BFS Step on all undecided set seeds
       for(const auto& undecidedSet : undecidedSets) {
         for(const auto& undecidedBranch : undecidedSet) {
@@ -1672,6 +1778,7 @@ void RankingTree::applySequenceRules_(
   /* Sequence rule 5:
    * - Atom or group with {R, M, Z} precedes {S, P, E}
    */
+  reachRule_(5);
   runBFS_<
     5, // Sequence rule 5
     true, // BFS downwards only
@@ -1963,6 +2070,9 @@ std::vector<
       && relevantSeeds_(seeds, undecidedSets)
       && depth < depthLimitOptional.value_or(std::numeric_limits<unsigned>::max())
     ) {
+      cancellation_.check();
+      watch_(false);
+
       // Perform a full BFS Step on all undecided set seeds
       for(const auto& undecidedSet : undecidedSets) {
         for(const auto& undecidedBranch : undecidedSet) {
@@ -2412,9 +2522,23 @@ std::vector<
 }
 
 std::vector<RankingTree::TreeVertexIndex> RankingTree::expand_(
-  const RankingTree::TreeVertexIndex& index,
-  const std::unordered_set<AtomIndex>& molIndicesInBranch
+  const RankingTree::TreeVertexIndex& index
 ) {
+  const AtomIndex molIndex = tree_[index].molIndex;
+  const AtomIndex parentMolIndex = tree_[parent_(index)].molIndex;
+
+  /* Outside of cycles, the parent is the only adjacent atom that can be part
+   * of the branch. The molecule's cycle membership is shared by all trees.
+   */
+  const bool inCycle = graph_.inner().cycleMembership().at(molIndex);
+  auto inBranch = [&](const AtomIndex molAdjacentIndex) -> bool {
+    if(inCycle) {
+      return molIndexExistsInBranch_(molAdjacentIndex, index);
+    }
+
+    return molAdjacentIndex == parentMolIndex;
+  };
+
   std::vector<TreeVertexIndex> newIndices;
 
   std::set<AtomIndex> treeOutAdjacencies;
@@ -2435,21 +2559,16 @@ std::vector<RankingTree::TreeVertexIndex> RankingTree::expand_(
 
   for(
     const PrivateGraph::Vertex& molAdjacentIndex :
-    graph_.inner().adjacents(tree_[index].molIndex)
+    graph_.inner().adjacents(molIndex)
   ) {
     if(treeOutAdjacencies.count(molAdjacentIndex) != 0) {
       continue;
     }
 
-    if(molIndicesInBranch.count(molAdjacentIndex) == 0) {
-      auto newIndex = boost::add_vertex(tree_);
-      tree_[newIndex].molIndex = molAdjacentIndex;
-      tree_[newIndex].isDuplicate = false;
-
+    if(!inBranch(molAdjacentIndex)) {
+      auto newIndex = addChild_(index, molAdjacentIndex, false);
       newIndices.push_back(newIndex);
 
-      boost::add_edge(index, newIndex, tree_);
-
       // Need to add duplicates!
       auto duplicateVertices = addBondOrderDuplicates_(index, newIndex);
       std::copy(
@@ -2457,18 +2576,8 @@ std::vector<RankingTree::TreeVertexIndex> RankingTree::expand_(
         duplicateVertices.end(),
         std::back_inserter(newIndices)
       );
-
-      // Copy the indices and insert the newest addition
-      auto molIndicesInBranchCopy = molIndicesInBranch;
-      molIndicesInBranchCopy.insert(molAdjacentIndex);
-    } else if(molAdjacentIndex != tree_[parent_(index)].molIndex)  {
-      auto newIndex = boost::add_vertex(tree_);
-      tree_[newIndex].molIndex = molAdjacentIndex;
-      tree_[newIndex].isDuplicate = true;
-
-      newIndices.push_back(newIndex);
-
-      boost::add_edge(index, newIndex, tree_);
+    } else if(molAdjacentIndex != parentMolIndex)  {
+      newIndices.push_back(addChild_(index, molAdjacentIndex, true));
     }
   }
 
@@ -2476,6 +2585,38 @@ std::vector<RankingTree::TreeVertexIndex> RankingTree::expand_(
   return newIndices;
 }
 
+void RankingTree::reachRule_(const unsigned rule) {
+  countReached(rule);
+  sequenceRule_ = rule;
+}
+
+void RankingTree::watch_(const bool finished) const {
+  if(watchdogThreshold_.count() == 0 || watchdogReported_) {
+    return;
+  }
+
+  const auto elapsed = std::chrono::steady_clock::now() - watchdogStart_;
+  if(elapsed < watchdogThreshold_) {
+    return;
+  }
+
+  watchdogReported_ = true;
+
+  Metrics::SlowRanking report;
+  report.atom = tree_[rootIndex].molIndex;
+  report.seconds = std::chrono::duration<double>(elapsed).count();
+  report.depth = depth();
+  report.treeSize = boost::num_vertices(tree_);
+  report.sequenceRule = sequenceRule_;
+  report.finished = finished;
+  if(Detail::Metrics::rankingWatchdogGraphviz()) {
+    report.graphviz = dumpGraphviz(
+      "Ranking of atom " + std::to_string(report.atom)
+    );
+  }
+  Detail::Metrics::recordSlowRanking(std::move(report));
+}
+
 std::string RankingTree::toString(const TreeVertexIndex vertex) {
   return std::to_string(vertex);
 }
@@ -2501,13 +2642,7 @@ std::string RankingTree::toString(const VariantType& vertexOrEdge) const {
 //! Returns the parent of a node. Fails if called on the root!
 RankingTree::TreeVertexIndex RankingTree::parent_(const RankingTree::TreeVertexIndex& index) const {
   assert(index != rootIndex);
-
-  // All nodes in the graph must have in_degree of 1
-  assert(boost::in_degree(index, tree_) == 1);
-
-  // Follow singular in_node to source, overwrite index
-  auto iterPair = boost::in_edges(index, tree_);
-  return boost::source(*iterPair.first, tree_);
+  return parents_[index];
 }
 
 std::vector<RankingTree::TreeVertexIndex> RankingTree::adjacents_(const RankingTree::TreeVertexIndex index) const {
@@ -2738,53 +2873,39 @@ std::vector<RankingTree::TreeVertexIndex> RankingTree::addBondOrderDuplicates_(
     // Add duplicate atom to source and target integralBondOrder - 1 times
     for(unsigned N = 1; N < integralBondOrder; ++N) {
       // Add a node with molIndex molSource to treeTarget
-      auto a = boost::add_vertex(tree_);
-      tree_[a].molIndex = tree_[treeSource].molIndex;
-      tree_[a].isDuplicate = true;
-      boost::add_edge(treeTarget, a, tree_);
+      addChild_(treeTarget, tree_[treeSource].molIndex, true);
 
       // Add a node with molIndex molTarget to treeSource
-      auto b = boost::add_vertex(tree_);
-      tree_[b].molIndex = tree_[treeTarget].molIndex;
-      tree_[b].isDuplicate = true;
-
-      newIndices.push_back(b);
-
-      boost::add_edge(treeSource, b, tree_);
+      newIndices.push_back(
+        addChild_(treeSource, tree_[treeTarget].molIndex, true)
+      );
     }
   }
 
   return newIndices;
 }
 
-std::unordered_set<RankingTree::TreeVertexIndex> RankingTree::treeIndicesInBranch_(
-  TreeVertexIndex index
-) const {
-  std::unordered_set<AtomIndex> indices {index};
-
-  while(index != rootIndex) {
-    // All nodes in the graph must have in_degree of 1
-    assert(boost::in_degree(index, tree_) == 1);
+RankingTree::TreeVertexIndex RankingTree::addChild_(
+  const TreeVertexIndex parent,
+  const AtomIndex molIndex,
+  const bool isDuplicate
+) {
+  const TreeVertexIndex child = boost::add_vertex(tree_);
+  tree_[child].molIndex = molIndex;
+  tree_[child].isDuplicate = isDuplicate;
+  boost::add_edge(parent, child, tree_);
 
-    // Follow singular in_node to source, overwrite index
-    auto iterPair = boost::in_edges(index, tree_);
-    index = boost::source(*iterPair.first, tree_);
+  assert(parents_.size() == child && depths_.size() == child);
+  parents_.push_back(parent);
+  depths_.push_back(depths_[parent] + 1);
 
-    indices.insert(index);
+  // Pathological trees grow very large, so check for cancellation as they grow
+  if(child % 256 == 0) {
+    cancellation_.check();
+    watch_(false);
   }
 
-  return indices;
-}
-
-std::unordered_set<AtomIndex> RankingTree::molIndicesInBranch_(
-  const TreeVertexIndex index
-) const {
-  return Temple::map_stl(
-    treeIndicesInBranch_(index),
-    [&](const auto& treeIndex) -> AtomIndex {
-      return tree_[treeIndex].molIndex;
-    }
-  );
+  return child;
 }
 
 unsigned RankingTree::duplicateDepth_(TreeVertexIndex index) const {
@@ -2801,12 +2922,7 @@ unsigned RankingTree::duplicateDepth_(TreeVertexIndex index) const {
   unsigned depth = 0;
 
   while(index != rootIndex) {
-    // All nodes in the graph must have in_degree of 1
-    assert(boost::in_degree(index, tree_) == 1);
-
-    // Follow singular in_node to source, overwrite index
-    auto iterPair = boost::in_edges(index, tree_);
-    index = boost::source(*iterPair.first, tree_);
+    index = parents_[index];
 
     ++depth;
 
@@ -2822,24 +2938,8 @@ unsigned RankingTree::duplicateDepth_(TreeVertexIndex index) const {
 }
 
 //! Returns the depth of a node in the tree
-unsigned RankingTree::depthOfNode_(TreeVertexIndex index) const {
-  /* As long as VertexListS is vecS, the first node (root) will always have
-   * index zero
-   */
-  unsigned depth = 0;
-
-  while(index != rootIndex) {
-    // All nodes in the graph must have in_degree of 1
-    assert(boost::in_degree(index, tree_) == 1);
-
-    // Follow singular in_node to source, overwrite index
-    auto iterPair = boost::in_edges(index, tree_);
-    index = boost::source(*iterPair.first, tree_);
-
-    ++depth;
-  }
-
-  return depth;
+unsigned RankingTree::depthOfNode_(const TreeVertexIndex index) const {
+  return depths_[index];
 }
 
 //!  Returns a mixed depth measure for ranking both vertices and edges
@@ -2866,27 +2966,22 @@ typename RankingTree::JunctionInfo RankingTree::junction_(
 
   JunctionInfo data;
 
-  /* Determine the junction vertex */
-  auto aBranchIndices = treeIndicesInBranch_(a);
-
-  // By default, the junction is root
-  data.junction = rootIndex;
-
-  // In case b is included in the path, that is the junction
-  if(aBranchIndices.count(b) > 0) {
-    data.junction = b;
-  } else {
-    // Backtrack with b, checking at each iteration
-    auto bCurrent = b;
-    while(bCurrent != rootIndex) {
-      bCurrent = parent_(bCurrent);
-
-      if(aBranchIndices.count(bCurrent) > 0) {
-        data.junction = bCurrent;
-        break;
-      }
-    }
+  /* Determine the junction vertex: Backtrack from the deeper vertex to equal
+   * depth, then backtrack from both until the paths meet
+   */
+  TreeVertexIndex aCurrent = a;
+  TreeVertexIndex bCurrent = b;
+  while(depths_[aCurrent] > depths_[bCurrent]) {
+    aCurrent = parents_[aCurrent];
   }
+  while(depths_[bCurrent] > depths_[aCurrent]) {
+    bCurrent = parents_[bCurrent];
+  }
+  while(aCurrent != bCurrent) {
+    aCurrent = parents_[aCurrent];
+    bCurrent = parents_[bCurrent];
+  }
+  data.junction = aCurrent;
 
   /* Reconstruct the paths to the junction */
   for(
@@ -2919,14 +3014,7 @@ bool RankingTree::molIndexExistsInBranch_(
   }
 
   while(treeIndex != rootIndex) {
-    // All nodes in the graph must have in_degree of 1
-    assert(boost::in_degree(treeIndex, tree_) == 1);
-
-    /* Move up one node in the graph. Follow singular in_node to source,
-     * overwrite index
-     */
-    auto iterPair = boost::in_edges(treeIndex, tree_);
-    treeIndex = boost::source(*iterPair.first, tree_);
+    treeIndex = parents_[treeIndex];
 
     // Test this position
     if(tree_[treeIndex].molIndex == molIndex) {
@@ -2970,10 +3058,18 @@ RankingTree::RankingTree(
   const boost::optional<AngstromPositions>& positionsOption
 ) : graph_(graph),
     stereopermutatorsRef_(stereopermutators),
-    adaptedMolGraphviz_(adaptMolGraph_(std::move(molGraphviz)))
+    adaptedMolGraphviz_(adaptMolGraph_(std::move(molGraphviz))),
+    cancellation_(CancellationToken::current()),
+    watchdogStart_(std::chrono::steady_clock::now()),
+    watchdogThreshold_(Detail::Metrics::rankingWatchdogThreshold())
 {
+  const RankingTally tally {depths_};
+  const WatchdogScope watchdogScope {*this};
+
   // Add the root index
   boost::add_vertex(tree_);
+  parents_.push_back(rootIndex);
+  depths_.push_back(0);
 
   tree_[rootIndex].molIndex = atomToRank;
   tree_[rootIndex].isDuplicate = false;
@@ -2993,11 +3089,11 @@ RankingTree::RankingTree(
         rootAdjacentIndex
       ) == std::end(excludeIndices)
     ) {
-      TreeVertexIndex branchIndex = boost::add_vertex(tree_);
-      tree_[branchIndex].molIndex = rootAdjacentIndex;
-      tree_[branchIndex].isDuplicate = false;
-
-      boost::add_edge(rootIndex, branchIndex, tree_);
+      const TreeVertexIndex branchIndex = addChild_(
+        rootIndex,
+        rootAdjacentIndex,
+        false
+      );
 
       addBondOrderDuplicates_(rootIndex, branchIndex);
 
@@ -3028,6 +3124,8 @@ RankingTree::RankingTree(
       ) << "\n";
   }
 
+  reachRule_(1);
+
   // The class should work regardless of which tree expansion method is chosen
   if(expansionMethod == ExpansionOption::OnlyRequiredBranches) {
     /* Expand only those branches which are yet undecided, immediately compare
@@ -3088,7 +3186,6 @@ RankingTree::RankingTree(
 
     unsigned depth = 1;
 
-    //! @todo try to avoid repeated computation with molIndicesInBranch_ somehow
     // Main BFS loop
     while(!undecidedSets.empty() && relevantSeeds_(seeds, undecidedSets)) {
       /* If the number of vertices in the partially (!) expanded tree exceeds
@@ -3114,10 +3211,7 @@ RankingTree::RankingTree(
           std::vector<TreeVertexIndex> newSeeds;
 
           for(const auto& seedVertex : branchSeeds) {
-            auto newVertices = expand_(
-              seedVertex,
-              molIndicesInBranch_(seedVertex)
-            );
+            auto newVertices = expand_(seedVertex);
 
             // Add ALL new vertices to the comparison set
             std::copy(
@@ -3183,10 +3277,7 @@ RankingTree::RankingTree(
       std::vector<TreeVertexIndex> newSeeds;
 
       for(const auto& seedVertex : seeds) {
-        auto newVertices = expand_(
-          seedVertex,
-          molIndicesInBranch_(seedVertex)
-        );
+        auto newVertices = expand_(seedVertex);
 
         // Add non-duplicate vertices to the new seeds
         std::copy_if(
@@ -3462,6 +3553,25 @@ std::vector<
   );
 }
 
+unsigned RankingTree::depth() const {
+  return *std::max_element(std::begin(depths_), std::end(depths_));
+}
+
+RankingTree::SequenceRuleStatistics RankingTree::statistics() {
+  SequenceRuleStatistics statistics;
+  for(unsigned i = 0; i < statistics.reached.size(); ++i) {
+    statistics.reached.at(i) = sequenceRuleReachedCounts.at(i).load(std::memory_order_relaxed);
+  }
+  statistics.stereodescriptorRulesSkipped = stereodescriptorRulesSkippedCount.load(std::memory_order_relaxed);
+  return statistics;
+}
+
+void RankingTree::resetStatistics() {
+  for(auto& count : sequenceRuleReachedCounts) {
+    count.store(0, std::memory_order_relaxed);
+  }
+  stereodescriptorRulesSkippedCount.store(0, std::memory_order_relaxed);
+}
 
 // Initialize the debug counter
 unsigned RankingTree::debugMessageCounter_ = 0;
@@ -33,8 +33,11 @@
 
 #include "boost/variant.hpp"
 
+#include "boost/graph/adjacency_list.hpp"
+#include "boost/graph/graphviz.hpp"
 #include "Molassembler/Detail/BuildTypeSwitch.h"
 #include "Molassembler/AtomStereopermutator.h"
+#include "Molassembler/Cancellation.h"
 #include "Molassembler/Modeling/BondDistance.h"
 #include "Molassembler/BondStereopermutator.h"
 #include "Molassembler/Log.h"
@@ -42,6 +45,9 @@
 #include "Molassembler/Molecule/OrderDiscoveryHelper.h"
 
 #include "Molassembler/Temple/Adaptors/AllPairs.h"
+#include "Molassembler/Temple/VisitedSet.h"
+
+#include <chrono>
 
 using namespace std::string_literals;
 
@@ -116,9 +122,10 @@ public:
   using BglType = boost::adjacency_list<
     /* OutEdgeListS = Type of Container for edges of a vertex
      * Options: vector, list, slist, set, multiset, unordered_set
-     * Choice: setS
+     * Choice: vecS, edges are only ever added to newly created vertices, so
+     *   there are no parallel edges and out-edges are ordered by target
      */
-    boost::setS,
+    boost::vecS,
     /* VertexListS = Type of Container for vertices
      * Options: vector, list, slist, set, multiset, unordered_set
      * Choice: vecS, removing vertices does not occur
@@ -195,6 +202,14 @@ private:
   //! The BGL Graph representing the acyclic tree
   BglType tree_;
 
+  /*! Flat parent of each tree vertex, avoiding in-edge traversals. The root is
+   * its own parent.
+   */
+  std::vector<TreeVertexIndex> parents_;
+
+  //! Flat depth of each tree vertex
+  std::vector<unsigned> depths_;
+
   //! The helper instance for discovering the ordering of the to-rank branches
   OrderDiscoveryHelper<TreeVertexIndex> branchOrderingHelper_;
 
@@ -202,8 +217,31 @@ private:
   const Graph& graph_;
   const StereopermutatorList& stereopermutatorsRef_;
   const std::string adaptedMolGraphviz_;
+  //! Cancellation token of the constructing thread
+  const CancellationToken cancellation_;
+
+  //! Sequence rule being evaluated, for the ranking watchdog
+  unsigned sequenceRule_ = 1;
+  //! Start of the ranking, for the ranking watchdog
+  const std::chrono::steady_clock::time_point watchdogStart_;
+  //! Ranking watchdog wall time, zero if the watchdog is off
+  const std::chrono::steady_clock::duration watchdogThreshold_;
+  //! Whether the ranking watchdog has reported this ranking already
+  mutable bool watchdogReported_ = false;
+
+  //! Reports this ranking to the watchdog on destruction
+  class WatchdogScope;
 
 /* Minor helper classes and functions */
+  //! Tallies reaching a sequence rule and sets it as evaluated
+  void reachRule_(unsigned rule);
+
+  /*! @brief Reports this ranking if it has exceeded the watchdog's wall time
+   *
+   * Reports at most once per ranking and costs a clock read otherwise.
+   */
+  void watch_(bool finished) const;
+
   //! Returns the parent of a node. Fails if called on the root!
   TreeVertexIndex parent_(const TreeVertexIndex& index) const;
 
@@ -258,11 +296,12 @@ private:
     const TreeVertexIndex& treeTarget
   );
 
-  //! Returns all tree indices in the branch from the specified index up to root
-  std::unordered_set<TreeVertexIndex> treeIndicesInBranch_(TreeVertexIndex index) const;
-
-  //! Returns all mol indices in the branch from the specified index up to root
-  std::unordered_set<AtomIndex> molIndicesInBranch_(TreeVertexIndex index) const;
+  //! Adds a child vertex to the tree, maintaining flat parents and depths
+  TreeVertexIndex addChild_(
+    TreeVertexIndex parent,
+    AtomIndex molIndex,
+    bool isDuplicate
+  );
 
   //! Returns a depth measure of a duplicate vertex for sequence rule 1
   unsigned duplicateDepth_(TreeVertexIndex index) const;
@@ -296,11 +335,11 @@ private:
    * all new and existing child tree vertex indices of the newly expanded node.
    * Pre-expansion existing children may come about due to the addition of
    * multiple bond order duplicate atoms.
+   *
+   * Cycle closure duplicates can only arise at atoms that are part of a cycle,
+   * so only for those are the node's ancestors searched for adjacent atoms.
    */
-  std::vector<TreeVertexIndex> expand_(
-    const TreeVertexIndex& index,
-    const std::unordered_set<AtomIndex>& molIndicesInBranch
-  );
+  std::vector<TreeVertexIndex> expand_(const TreeVertexIndex& index);
 
   /*!
    * Since multiset's operator < does not actually USE the custom comparator
@@ -557,7 +596,7 @@ private:
     /* In case the BFS in not down-only, we have to track which indices we
      * have visited to ensure BFS doesn't backtrack or reuse vertices.
      */
-    std::unordered_set<TreeVertexIndex> visitedVertices;
+    Temple::VisitedSet<TreeVertexIndex> visitedVertices;
 
 
     /* Initialization */
@@ -565,6 +604,7 @@ private:
     VertexInserter<insertVertices, MultisetValueType, MultisetComparatorType> vertexInserter;
 
     if(!bfsDownOnly) { // Initialization is only necessary in this case
+      visitedVertices.reset(boost::num_vertices(tree_));
       visitedVertices.insert(sourceIndex);
     }
 
@@ -1093,6 +1133,36 @@ public:
     std::vector<AtomIndex>
   > getRanked() const;
 
+  /*! @brief Depth of the deepest expanded tree vertex
+   *
+   * Any graph modification further than this many bonds away from the ranked
+   * atom cannot alter the ranked result.
+   *
+   * @complexity{@math{\Theta(V)} in the number of tree vertices}
+   */
+  unsigned depth() const;
+
+  //! Tally of how far rankings proceed through the sequence rules
+  struct SequenceRuleStatistics {
+    //! Number of rankings reaching each sequence rule, indexed by rule minus one
+    std::array<unsigned, 5> reached;
+    /*! Number of rankings skipping sequence rules three to five since no
+     * stereodescriptors can be instantiated in their undecided branches
+     */
+    unsigned stereodescriptorRulesSkipped;
+  };
+
+  /*! @brief Tallies of all rankings since the last reset
+   *
+   * Only rankings of the root atom's substituents are counted, not the
+   * auxiliary rankings for stereodescriptor instantiation. Tallies are
+   * shared by all threads.
+   */
+  static SequenceRuleStatistics statistics();
+
+  //! Resets the sequence rule statistics
+  static void resetStatistics();
+
   /*! Returns an annotated graphviz graph of the tree
    *
    * Creates a graphviz representation of the tree, with optional title string,
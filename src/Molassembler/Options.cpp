@@ -11,7 +11,19 @@
 namespace Scine {
 namespace Molassembler {
 
+namespace {
+
+// Innermost overrides of the calling thread, if any
+thread_local const Options::Values* threadValues = nullptr;
+thread_local Random::Engine* threadEngine = nullptr;
+
+} // namespace
+
 Random::Engine& randomnessEngine() {
+  if(threadEngine != nullptr) {
+    return *threadEngine;
+  }
+
   // Pursuant to Construct-on-first-use idiom
   static Random::Engine engine;
   return engine;
@@ -24,5 +36,42 @@ bool Options::Thermalization::bartellMechanism = true;
 ChiralStatePreservation Options::chiralStatePreservation = ChiralStatePreservation::EffortlessAndUnique;
 ShapeTransition Options::shapeTransition = ShapeTransition::MaximizeChiralStatePreservation;
 
+Options::Values Options::Values::global() {
+  return {
+    Thermalization::pyramidalInversion,
+    Thermalization::berryPseudorotation,
+    Thermalization::bartellMechanism,
+    Options::chiralStatePreservation,
+    Options::shapeTransition
+  };
+}
+
+Options::Values Options::current() {
+  if(threadValues != nullptr) {
+    return *threadValues;
+  }
+
+  return Values::global();
+}
+
+Options::ThreadOverride::ThreadOverride(const Values& values)
+  : values_(values),
+    previousValues_(threadValues),
+    previousEngine_(threadEngine)
+{
+  threadValues = &values_;
+}
+
+Options::ThreadOverride::ThreadOverride(const Values& values, Random::Engine& engine)
+  : ThreadOverride(values)
+{
+  threadEngine = &engine;
+}
+
+Options::ThreadOverride::~ThreadOverride() {
+  threadValues = previousValues_;
+  threadEngine = previousEngine_;
+}
+
 } // namespace Molassembler
 } // namespace Scine
@@ -31,6 +31,9 @@ class Graph;
  *
  * @complexity{@math{\Theta(1)}}
  *
+ * @note An Options::ThreadOverride of the calling thread may replace this
+ * instance with another engine.
+ *
  * @warning Do not use this instance in any static object's destructor!
  */
 MASM_EXPORT Random::Engine& randomnessEngine();
@@ -230,6 +233,70 @@ struct MASM_EXPORT Options {
    * Defaults to MaximizeChiralStatePreservation
    */
   static ShapeTransition shapeTransition;
+
+  //! Values of all options, e.g. to override them in a single thread
+  struct MASM_EXPORT Values {
+    //! Process-wide values of the static members
+    static Values global();
+
+    //! See Thermalization::pyramidalInversion
+    bool pyramidalInversion;
+    //! See Thermalization::berryPseudorotation
+    bool berryPseudorotation;
+    //! See Thermalization::bartellMechanism
+    bool bartellMechanism;
+    //! See Options::chiralStatePreservation
+    ChiralStatePreservation chiralStatePreservation;
+    //! See Options::shapeTransition
+    ShapeTransition shapeTransition;
+  };
+
+  /*! @brief Options in effect in the calling thread
+   *
+   * The values of the innermost ThreadOverride of the calling thread, or the
+   * process-wide values of the static members otherwise. The library reads
+   * all options through this function.
+   *
+   * @complexity{@math{\Theta(1)}}
+   */
+  static Values current();
+
+  /*! @brief Overrides options and the randomness engine in the calling thread
+   *
+   * Concurrent computations in different threads can each use their own
+   * settings without locking or affecting one another. Overrides nest, and
+   * the previous override is restored on destruction.
+   *
+   * @code{.cpp}
+   * Options::Values values = Options::Values::global();
+   * values.chiralStatePreservation = ChiralStatePreservation::Unique;
+   * Random::Engine engine {1010};
+   * Options::ThreadOverride scope {values, engine};
+   * // Edits of molecules in this thread now preserve only unique chiral state
+   * // and randomness is drawn from engine instead of randomnessEngine()
+   * @endcode
+   *
+   * @note Worker threads of the library's parallelized functions do not
+   *   inherit overrides of the calling thread.
+   */
+  class MASM_EXPORT ThreadOverride {
+  public:
+    //! Overrides options only
+    explicit ThreadOverride(const Values& values);
+    //! Overrides options and the randomness engine
+    ThreadOverride(const Values& values, Random::Engine& engine);
+
+    ThreadOverride(const ThreadOverride& other) = delete;
+    ThreadOverride& operator = (const ThreadOverride& other) = delete;
+
+    //! Restores the previous override
+    ~ThreadOverride();
+
+  private:
+    Values values_;
+    const Values* previousValues_;
+    Random::Engine* previousEngine_;
+  };
 };
 
 } // namespace Molassembler
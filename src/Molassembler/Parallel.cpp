@@ -0,0 +1,206 @@
+/*!@file
+ * @copyright This code is licensed under the 3-clause BSD license.
+ *   Copyright ETH Zurich, Laboratory of Physical Chemistry, Reiher Group.
+ *   See LICENSE.txt for details.
+ */
+
+#include "Molassembler/Parallel.h"
+
+#include "Molassembler/Cancellation.h"
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace Scine {
+namespace Molassembler {
+namespace Parallel {
+namespace {
+
+// Number of loop bodies the calling thread is running
+thread_local unsigned depth = 0;
+
+//! Marks the calling thread as running a loop body
+class BodyScope {
+public:
+  BodyScope() {
+    ++depth;
+#ifdef _OPENMP
+    // OpenMP regions of the body are not to spawn teams of their own
+    maxThreads_ = omp_get_max_threads();
+    omp_set_num_threads(1);
+#endif
+  }
+
+  BodyScope(const BodyScope& other) = delete;
+  BodyScope& operator = (const BodyScope& other) = delete;
+
+  ~BodyScope() {
+#ifdef _OPENMP
+    omp_set_num_threads(maxThreads_);
+#endif
+    --depth;
+  }
+
+private:
+#ifdef _OPENMP
+  int maxThreads_;
+#endif
+};
+
+struct SerialExecutor final : Executor {
+  unsigned concurrency() const final {
+    return 1;
+  }
+
+  void run(const unsigned N, const Body& body) final {
+    for(unsigned i = 0; i < N; ++i) {
+      body(i, 0);
+    }
+  }
+};
+
+struct OpenMPExecutor final : Executor {
+  unsigned concurrency() const final {
+#ifdef _OPENMP
+    return omp_get_max_threads();
+#else
+    return 1;
+#endif
+  }
+
+  void run(const unsigned N, const Body& body) final {
+    const int M = N;
+#pragma omp parallel for schedule(dynamic)
+    for(int i = 0; i < M; ++i) {
+#ifdef _OPENMP
+      body(i, omp_get_thread_num());
+#else
+      body(i, 0);
+#endif
+    }
+  }
+};
+
+struct ThreadsExecutor final : Executor {
+  explicit ThreadsExecutor(const unsigned count) : workers(count) {}
+
+  unsigned concurrency() const final {
+    return workers;
+  }
+
+  void run(const unsigned N, const Body& body) final {
+    std::atomic<unsigned> next {0};
+    const auto work = [&](const unsigned worker) {
+      for(unsigned i = next++; i < N; i = next++) {
+        body(i, worker);
+      }
+    };
+
+    // The calling thread is the first worker
+    std::vector<std::thread> threads;
+    const unsigned spawned = std::min(workers, N) - 1;
+    threads.reserve(spawned);
+    for(unsigned w = 1; w <= spawned; ++w) {
+      threads.emplace_back(work, w);
+    }
+    work(0);
+    for(auto& thread : threads) {
+      thread.join();
+    }
+  }
+
+  unsigned workers;
+};
+
+std::shared_ptr<Executor>& globalExecutor() {
+  // Pursuant to Construct-on-first-use idiom
+  static std::shared_ptr<Executor> executor = openMP();
+  return executor;
+}
+
+} // namespace
+
+std::shared_ptr<Executor> openMP() {
+  return std::make_shared<OpenMPExecutor>();
+}
+
+std::shared_ptr<Executor> serial() {
+  return std::make_shared<SerialExecutor>();
+}
+
+std::shared_ptr<Executor> threads(unsigned count) {
+  if(count == 0) {
+    count = std::max(std::thread::hardware_concurrency(), 1U);
+  }
+
+  return std::make_shared<ThreadsExecutor>(count);
+}
+
+void setExecutor(std::shared_ptr<Executor> executor) {
+  if(!executor) {
+    throw std::invalid_argument("Executor may not be null");
+  }
+
+  std::atomic_store(&globalExecutor(), std::move(executor));
+}
+
+std::shared_ptr<Executor> executor() {
+  if(nested()) {
+    static const std::shared_ptr<Executor> inner = serial();
+    return inner;
+  }
+
+  return std::atomic_load(&globalExecutor());
+}
+
+bool nested() {
+  return depth > 0;
+}
+
+void forEach(Executor& executor, const unsigned N, const Executor::Body& body) {
+  if(N == 0) {
+    return;
+  }
+
+  // Workers are cancelled along with the calling thread
+  const CancellationToken cancellation = CancellationToken::current();
+
+  std::exception_ptr exception;
+  std::mutex exceptionMutex;
+  executor.run(
+    N,
+    [&](const unsigned index, const unsigned worker) {
+      BodyScope scope;
+      CancellationToken::Scope cancellationScope {cancellation};
+      try {
+        body(index, worker);
+      } catch(...) {
+        std::lock_guard<std::mutex> lock(exceptionMutex);
+        if(!exception) {
+          exception = std::current_exception();
+        }
+      }
+    }
+  );
+
+  if(exception) {
+    std::rethrow_exception(exception);
+  }
+}
+
+void forEach(const unsigned N, const Executor::Body& body) {
+  forEach(*executor(), N, body);
+}
+
+} // namespace Parallel
+} // namespace Molassembler
+} // namespace Scine
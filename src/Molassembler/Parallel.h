@@ -0,0 +1,170 @@
+/*!@file
+ * @copyright This code is licensed under the 3-clause BSD license.
+ *   Copyright ETH Zurich, Laboratory of Physical Chemistry, Reiher Group.
+ *   See LICENSE.txt for details.
+ * @brief Executors running the library's parallel loops
+ */
+
+#ifndef INCLUDE_MOLASSEMBLER_PARALLEL_H
+#define INCLUDE_MOLASSEMBLER_PARALLEL_H
+
+#include "Molassembler/Export.h"
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace Scine {
+namespace Molassembler {
+
+//! @brief Executors running the library's parallel loops
+namespace Parallel {
+
+/**
+ * @brief Runs the bodies of a parallel loop
+ *
+ * By default, the library's parallel loops run with OpenMP. Implement this
+ * interface to run them on a thread pool of your own instead, e.g. one backed
+ * by a TBB task arena:
+ *
+ * @code{.cpp}
+ * struct ArenaExecutor final : Parallel::Executor {
+ *   unsigned concurrency() const override {
+ *     return arena.max_concurrency();
+ *   }
+ *   void run(unsigned N, const Body& body) override {
+ *     arena.execute([&]() {
+ *       tbb::parallel_for(0U, N, [&](unsigned i) {
+ *         body(i, tbb::this_task_arena::current_thread_index());
+ *       });
+ *     });
+ *   }
+ *   tbb::task_arena arena;
+ * };
+ * Parallel::setExecutor(std::make_shared<ArenaExecutor>());
+ * @endcode
+ */
+class MASM_EXPORT Executor {
+public:
+  /*! @brief Loop body
+   *
+   * Called with the loop index and the index of the worker calling it. Bodies
+   * do not throw.
+   */
+  using Body = std::function<void(unsigned index, unsigned worker)>;
+
+  virtual ~Executor() = default;
+
+  /*! @brief Number of workers bodies may be called from
+   *
+   * Worker indices passed to bodies are less than this number.
+   */
+  virtual unsigned concurrency() const = 0;
+
+  /*! @brief Calls a body for each index in @math{[0, N)}
+   *
+   * Returns once all calls have finished. Calls may be concurrent, but never
+   * with the same worker index.
+   */
+  virtual void run(unsigned N, const Body& body) = 0;
+};
+
+/*! @brief Runs loops with OpenMP
+ *
+ * The default executor. Runs loops serially if the library is compiled
+ * without OpenMP.
+ */
+MASM_EXPORT std::shared_ptr<Executor> openMP();
+
+//! Runs loops serially in the calling thread
+MASM_EXPORT std::shared_ptr<Executor> serial();
+
+/*! @brief Runs loops on the calling thread and additional standard threads
+ *
+ * @param count Number of workers including the calling thread. Zero selects
+ *   the hardware concurrency.
+ */
+MASM_EXPORT std::shared_ptr<Executor> threads(unsigned count = 0);
+
+/*! @brief Sets the executor of the library's parallel loops
+ *
+ * @throws std::invalid_argument If @p executor is null
+ */
+MASM_EXPORT void setExecutor(std::shared_ptr<Executor> executor);
+
+/*! @brief Executor for a loop started in the calling thread
+ *
+ * The executor set with setExecutor, or serial() if the calling thread is
+ * already running a loop body.
+ */
+MASM_EXPORT std::shared_ptr<Executor> executor();
+
+//! Whether the calling thread is running a loop body
+MASM_EXPORT bool nested();
+
+/*! @brief Runs a parallel loop on an executor
+ *
+ * Nested loops run serially in the worker calling them, so parallelism is
+ * only ever exploited at the outermost loop. OpenMP regions in bodies are
+ * limited to a single thread likewise.
+ *
+ * Bodies run in the CancellationToken::Scope of the calling thread.
+ *
+ * @throws Rethrows the first exception thrown by a body once all calls have
+ *   finished
+ */
+MASM_EXPORT void forEach(Executor& executor, unsigned N, const Executor::Body& body);
+
+//! Runs a parallel loop on executor()
+MASM_EXPORT void forEach(unsigned N, const Executor::Body& body);
+
+/**
+ * @brief Worker-private state of a parallel loop, made by each worker on
+ *   first use
+ *
+ * State is allocated and initialized by the worker using it instead of the
+ * thread starting the loop. On NUMA systems, where memory is placed on the
+ * node of the thread first touching it, this keeps each worker's state local
+ * to the socket the worker runs on, provided workers are bound to cores, e.g.
+ * with OMP_PROC_BIND=spread and OMP_PLACES=cores for the OpenMP executor.
+ * Separate allocations also keep workers from sharing cache lines.
+ *
+ * @code{.cpp}
+ * auto executor = Parallel::executor();
+ * Parallel::WorkerLocal<Random::Engine> engines {*executor, Random::Engine {}};
+ * Parallel::forEach(*executor, N, [&](unsigned i, unsigned worker) {
+ *   Random::Engine& engine = engines[worker];
+ * });
+ * @endcode
+ */
+template<typename T>
+class WorkerLocal {
+public:
+  /*! @brief Prepares state for each worker of an executor
+   *
+   * @param executor Executor whose workers use the state
+   * @param prototype State each worker's state is copied from
+   */
+  WorkerLocal(const Executor& executor, T prototype)
+    : prototype_(std::move(prototype)),
+      values_(executor.concurrency()) {}
+
+  //! The worker's state, copied from the prototype on first use
+  T& operator [] (const unsigned worker) {
+    std::unique_ptr<T>& value = values_.at(worker);
+    if(!value) {
+      value = std::make_unique<T>(prototype_);
+    }
+    return *value;
+  }
+
+private:
+  const T prototype_;
+  std::vector<std::unique_ptr<T>> values_;
+};
+
+} // namespace Parallel
+} // namespace Molassembler
+} // namespace Scine
+
+#endif
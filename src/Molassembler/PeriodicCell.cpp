@@ -0,0 +1,70 @@
+/*!@file
+ * @copyright This code is licensed under the 3-clause BSD license.
+ *   Copyright ETH Zurich, Laboratory of Physical Chemistry, Reiher Group.
+ *   See LICENSE.txt for details.
+ */
+
+#include "Molassembler/PeriodicCell.h"
+
+#include "Utils/Constants.h"
+
+#include <Eigen/Geometry>
+#include <Eigen/LU>
+
+#include <cmath>
+#include <stdexcept>
+
+namespace Scine {
+namespace Molassembler {
+
+PeriodicCell::PeriodicCell(
+  const Eigen::Matrix3d& lattice,
+  const LengthUnit lengthUnit
+) {
+  if(lengthUnit == LengthUnit::Bohr) {
+    lattice_ = Utils::Constants::angstrom_per_bohr * lattice;
+  } else {
+    lattice_ = lattice;
+  }
+
+  const double volume = std::fabs(lattice_.determinant());
+  if(!(volume > 1e-8 * lattice_.rowwise().norm().prod())) {
+    throw std::invalid_argument("Lattice vectors of periodic cell are linearly dependent");
+  }
+
+  fractionalTransform_ = lattice_.transpose().inverse();
+}
+
+Eigen::Vector3d PeriodicCell::fractional(const Eigen::Vector3d& position) const {
+  return fractionalTransform_ * position;
+}
+
+Eigen::Vector3d PeriodicCell::faceDistances() const {
+  // The face distance along a lattice vector is the inverse norm of the matching reciprocal vector
+  return fractionalTransform_.rowwise().norm().cwiseInverse();
+}
+
+Eigen::Vector3d PeriodicCell::minimumImage(const Eigen::Vector3d& displacement) const {
+  Eigen::Vector3d rounded = fractional(displacement);
+  for(unsigned k = 0; k < 3; ++k) {
+    rounded(k) -= std::round(rounded(k));
+  }
+  Eigen::Vector3d best = lattice_.transpose() * rounded;
+
+  // Rounding alone can miss the shortest image in skewed cells
+  for(int a = -1; a <= 1; ++a) {
+    for(int b = -1; b <= 1; ++b) {
+      for(int c = -1; c <= 1; ++c) {
+        const Eigen::Vector3d image = lattice_.transpose() * (rounded + Eigen::Vector3d(a, b, c));
+        if(image.squaredNorm() < best.squaredNorm()) {
+          best = image;
+        }
+      }
+    }
+  }
+
+  return best;
+}
+
+} // namespace Molassembler
+} // namespace Scine
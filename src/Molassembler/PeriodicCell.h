@@ -0,0 +1,68 @@
+/*!@file
+ * @copyright This code is licensed under the 3-clause BSD license.
+ *   Copyright ETH Zurich, Laboratory of Physical Chemistry, Reiher Group.
+ *   See LICENSE.txt for details.
+ * @brief Periodic cell of structures with wrapped coordinates
+ */
+
+#ifndef INCLUDE_MOLASSEMBLER_PERIODIC_CELL_H
+#define INCLUDE_MOLASSEMBLER_PERIODIC_CELL_H
+
+#include "Molassembler/Types.h"
+
+#include <Eigen/Core>
+
+namespace Scine {
+namespace Molassembler {
+
+/**
+ * @brief Lattice of a periodic structure in Angstrom
+ *
+ * Atoms of periodic structures may be wrapped into the cell. Distances between
+ * atoms are then those of their closest periodic images.
+ */
+class MASM_EXPORT PeriodicCell {
+public:
+  /*! @brief Constructor from lattice vectors
+   *
+   * @param lattice Lattice vectors as rows
+   * @param lengthUnit Length unit of the lattice vectors
+   *
+   * @throws std::invalid_argument If the lattice vectors are linearly dependent
+   */
+  explicit PeriodicCell(
+    const Eigen::Matrix3d& lattice,
+    LengthUnit lengthUnit = LengthUnit::Bohr
+  );
+
+  //! Lattice vectors in Angstrom as rows
+  const Eigen::Matrix3d& lattice() const {
+    return lattice_;
+  }
+
+  //! Fractional coordinates of a position in Angstrom
+  Eigen::Vector3d fractional(const Eigen::Vector3d& position) const;
+
+  /*! @brief Distances between opposite faces of the cell in Angstrom
+   *
+   * Two points less than a face distance apart differ by less than one in the
+   * corresponding fractional coordinate.
+   */
+  Eigen::Vector3d faceDistances() const;
+
+  /*! @brief Shortest periodic image of a displacement in Angstrom
+   *
+   * @complexity{@math{\Theta(1)}}
+   */
+  Eigen::Vector3d minimumImage(const Eigen::Vector3d& displacement) const;
+
+private:
+  Eigen::Matrix3d lattice_;
+  //! Inverse of the transposed lattice, mapping positions to fractional coordinates
+  Eigen::Matrix3d fractionalTransform_;
+};
+
+} // namespace Molassembler
+} // namespace Scine
+
+#endif
@@ -79,10 +79,43 @@ Engine::result_type Engine::operator() () const {
   return pImpl_->operator()();
 }
 
+std::array<Engine::result_type, 4> Engine::state() const {
+  return pImpl_->engine.state();
+}
+
+void Engine::setState(const std::array<result_type, 4>& state) {
+  pImpl_->engine.seed(state);
+}
+
 bool Engine::operator == (const Engine& other) const {
   return *pImpl_ == *other.pImpl_;
 }
 
+int streamSeed(const unsigned seed, const unsigned stream) {
+  // Philox4x32 round multipliers and Weyl sequence key increments
+  constexpr std::uint64_t M0 = 0xD2511F53;
+  constexpr std::uint64_t M1 = 0xCD9E8D57;
+  constexpr std::uint32_t W0 = 0x9E3779B9;
+  constexpr std::uint32_t W1 = 0xBB67AE85;
+
+  std::array<std::uint32_t, 4> counter {{stream, 0, 0, 0}};
+  std::array<std::uint32_t, 2> key {{seed, 0}};
+  for(unsigned round = 0; round < 10; ++round) {
+    const std::uint64_t a = M0 * counter[0];
+    const std::uint64_t b = M1 * counter[2];
+    counter = {{
+      static_cast<std::uint32_t>(b >> 32U) ^ counter[1] ^ key[0],
+      static_cast<std::uint32_t>(b),
+      static_cast<std::uint32_t>(a >> 32U) ^ counter[3] ^ key[1],
+      static_cast<std::uint32_t>(a)
+    }};
+    key[0] += W0;
+    key[1] += W1;
+  }
+
+  return static_cast<int>(counter[0] & 0x7FFFFFFFU);
+}
+
 } // namespace Random
 } // namespace Molassembler
 } // namespace Scine
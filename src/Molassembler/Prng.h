@@ -9,6 +9,8 @@
 #define INCLUDE_MOLASSEMBLER_PRNG_H
 
 #include "Molassembler/Export.h"
+#include <array>
+#include <cstdint>
 #include <memory>
 #include <vector>
 
@@ -50,6 +52,16 @@ public:
   //! Seed the underlying state with multiple integer values
   void seed(const std::vector<int>& signedSeeds);
 
+  /*! @brief Underlying state of the engine
+   *
+   * Setting this state on another engine makes it continue the sequence of
+   * values of this engine, e.g. across process restarts.
+   */
+  std::array<result_type, 4> state() const;
+
+  //! Sets the underlying state of the engine
+  void setState(const std::array<result_type, 4>& state);
+
   /*! @brief Advances the state and returns a value
    *
    * @complexity{@math{\Theta(1)}}
@@ -64,6 +76,21 @@ private:
   std::unique_ptr<Impl> pImpl_;
 };
 
+/*! @brief Seed of a stream of a family of independent PRNG streams
+ *
+ * Counter-based: the result is a pure function of @p seed and @p stream,
+ * calculated by a Philox4x32-10 bijection keyed with @p seed of the counter
+ * @p stream. Seeding an engine for each of many parallel tasks with this
+ * function makes each task's stream independent of the order of task
+ * execution, the number of threads and of the other tasks, so that tasks can
+ * also be distributed among processes.
+ *
+ * @complexity{@math{\Theta(1)}}
+ *
+ * @returns A non-negative seed
+ */
+MASM_EXPORT int streamSeed(unsigned seed, unsigned stream);
+
 } // namespace Random
 } // namespace Molassembler
 } // namespace Scine
@@ -249,7 +249,7 @@ bool RankingInformation::operator == (const RankingInformation& other) const {
         const auto& thisEqualSiteGroup,
         const auto& otherEqualSiteGroup
       ) -> bool {
-        Temple::TinyUnorderedSet<AtomIndex> thisSiteGroupVertices;
+        Temple::TinyUnorderedSet<AtomIndex, 8> thisSiteGroupVertices;
 
         for(const auto siteIndex : thisEqualSiteGroup) {
           for(const auto siteConstitutingIndex : sites.at(siteIndex)) {
@@ -0,0 +1,183 @@
+/*!@file
+ * @copyright This code is licensed under the 3-clause BSD license.
+ *   Copyright ETH Zurich, Laboratory of Physical Chemistry, Reiher Group.
+ *   See LICENSE.txt for details.
+ */
+
+#include "Molassembler/ReactionTemplate.h"
+
+#include "boost/functional/hash.hpp"
+#include "boost/optional.hpp"
+#include "Molassembler/Graph.h"
+#include "Molassembler/Molecule.h"
+
+#include <exception>
+#include <unordered_set>
+
+namespace Scine {
+namespace Molassembler {
+namespace {
+
+void checkEdit(const Graph& pattern, const ReactionTemplate::Edit& edit) {
+  using Type = ReactionTemplate::Edit::Type;
+  const AtomIndex N = pattern.N();
+  if(edit.first >= N) {
+    throw std::invalid_argument("Edit atom index is not part of the pattern");
+  }
+
+  if(edit.type == Type::SetElementType) {
+    return;
+  }
+
+  if(edit.second >= N || edit.first == edit.second) {
+    throw std::invalid_argument("Edit bond is not a pair of distinct pattern atoms");
+  }
+
+  const bool bonded = pattern.adjacent(edit.first, edit.second);
+  if(edit.type == Type::AddBond && bonded) {
+    throw std::invalid_argument("Cannot add a bond that the pattern already has");
+  }
+
+  if(edit.type != Type::AddBond && !bonded) {
+    throw std::invalid_argument("Cannot edit a bond that the pattern does not have");
+  }
+
+  if(edit.type != Type::RemoveBond && edit.bondType == BondType::Eta) {
+    throw std::invalid_argument("Eta bonds are determined internally and cannot be set");
+  }
+}
+
+} // namespace
+
+ReactionTemplate::Edit ReactionTemplate::Edit::addBond(
+  const AtomIndex a,
+  const AtomIndex b,
+  const BondType bondType
+) {
+  return {Type::AddBond, a, b, bondType, Utils::ElementType::none};
+}
+
+ReactionTemplate::Edit ReactionTemplate::Edit::removeBond(
+  const AtomIndex a,
+  const AtomIndex b
+) {
+  return {Type::RemoveBond, a, b, BondType::Single, Utils::ElementType::none};
+}
+
+ReactionTemplate::Edit ReactionTemplate::Edit::setBondType(
+  const AtomIndex a,
+  const AtomIndex b,
+  const BondType bondType
+) {
+  return {Type::SetBondType, a, b, bondType, Utils::ElementType::none};
+}
+
+ReactionTemplate::Edit ReactionTemplate::Edit::setElementType(
+  const AtomIndex a,
+  const Utils::ElementType elementType
+) {
+  return {Type::SetElementType, a, a, BondType::Single, elementType};
+}
+
+ReactionTemplate::ReactionTemplate(
+  const Graph& pattern,
+  std::vector<Edit> edits,
+  const Subgraphs::VertexStrictness vertexStrictness,
+  const Subgraphs::EdgeStrictness edgeStrictness,
+  const AtomEnvironmentComponents productComponents
+) : query_(pattern, vertexStrictness, edgeStrictness),
+    edits_(std::move(edits)),
+    productComponents_(productComponents)
+{
+  for(const Edit& edit : edits_) {
+    checkEdit(pattern, edit);
+  }
+}
+
+const Subgraphs::Query& ReactionTemplate::query() const {
+  return query_;
+}
+
+const std::vector<ReactionTemplate::Edit>& ReactionTemplate::edits() const {
+  return edits_;
+}
+
+std::vector<Molecule> ReactionTemplate::apply(const Molecule& reactant) const {
+  // Matches are collected first so that edits can be applied in parallel
+  std::vector<std::vector<AtomIndex>> matches;
+  query_.forEach(
+    reactant.graph(),
+    [&matches](const std::vector<AtomIndex>& mapping) -> bool {
+      matches.push_back(mapping);
+      return true;
+    },
+    Subgraphs::Uniqueness::HydrogenPermutation
+  );
+
+  const int M = matches.size();
+  std::vector<boost::optional<Molecule>> products(M);
+  std::vector<Fingerprint> fingerprints(M);
+  std::exception_ptr exception;
+
+#pragma omp parallel for schedule(dynamic)
+  for(int i = 0; i < M; ++i) {
+    try {
+      const std::vector<AtomIndex>& mapping = matches[i];
+      Molecule product = reactant;
+      bool connected = true;
+      product.beginEdits();
+      for(const Edit& edit : edits_) {
+        const AtomIndex a = mapping.at(edit.first);
+        const AtomIndex b = mapping.at(edit.second);
+        switch(edit.type) {
+          case Edit::Type::AddBond: product.addBond(a, b, edit.bondType); break;
+          case Edit::Type::RemoveBond:
+            // Removing a bridge bond would disconnect the molecule
+            connected = product.graph().canRemove(BondIndex {a, b});
+            if(connected) {
+              product.removeBond(a, b);
+            }
+            break;
+          case Edit::Type::SetBondType: product.setBondType(a, b, edit.bondType); break;
+          case Edit::Type::SetElementType: product.setElementType(a, edit.elementType); break;
+        }
+
+        if(!connected) {
+          break;
+        }
+      }
+
+      if(connected) {
+        product.commitEdits();
+        product.canonicalize(productComponents_);
+        fingerprints[i] = product.fingerprint(productComponents_);
+        products[i] = std::move(product);
+      }
+    } catch(...) {
+#pragma omp critical(reactionTemplateException)
+      {
+        if(!exception) {
+          exception = std::current_exception();
+        }
+      }
+    }
+  }
+
+  if(exception) {
+    std::rethrow_exception(exception);
+  }
+
+  // Keep the first product with each fingerprint
+  std::unordered_set<Fingerprint, boost::hash<Fingerprint>> seen;
+  std::vector<Molecule> distinct;
+  for(int i = 0; i < M; ++i) {
+    if(products[i] && seen.insert(fingerprints[i]).second) {
+      distinct.push_back(std::move(products[i].value()));
+    }
+  }
+
+  return distinct;
+}
+
+} // namespace Molassembler
+} // namespace Scine
@@ -0,0 +1,129 @@
+/*!@file
+ * @copyright This code is licensed under the 3-clause BSD license.
+ *   Copyright ETH Zurich, Laboratory of Physical Chemistry, Reiher Group.
+ *   See LICENSE.txt for details.
+ * @brief Application of graph edits at all matches of a reactant pattern
+ */
+
+#ifndef INCLUDE_MOLASSEMBLER_REACTION_TEMPLATE_H
+#define INCLUDE_MOLASSEMBLER_REACTION_TEMPLATE_H
+
+#include "Molassembler/Subgraphs.h"
+#include "Utils/Geometry/ElementTypes.h"
+
+namespace Scine {
+namespace Molassembler {
+
+/**
+ * @brief A reactant pattern and the graph edits turning it into the product
+ *
+ * The pattern is compiled into a Subgraphs::Query once. Applying the template
+ * to a molecule applies the edits at each distinct match of the pattern and
+ * returns the distinct products.
+ *
+ * @code{.cpp}
+ * // Hydrogen transfer between a pair of carbon atoms bonded to each other
+ * Graph pattern = ...; // C(0)-C(1), C(0)-H(2)
+ * ReactionTemplate transfer {
+ *   pattern,
+ *   {
+ *     ReactionTemplate::Edit::addBond(1, 2, BondType::Single),
+ *     ReactionTemplate::Edit::removeBond(0, 2)
+ *   }
+ * };
+ * std::vector<Molecule> products = transfer.apply(molecule);
+ * @endcode
+ */
+class MASM_EXPORT ReactionTemplate {
+public:
+  //! Graph edit of pattern atoms
+  struct MASM_EXPORT Edit {
+    //! Kind of graph edit
+    enum class Type {
+      //! Adds a bond of bondType between first and second
+      AddBond,
+      //! Removes the bond between first and second
+      RemoveBond,
+      //! Changes the type of the bond between first and second to bondType
+      SetBondType,
+      //! Changes the element type of first to elementType
+      SetElementType
+    };
+
+    //! Adds a bond between pattern atoms that are not bonded in the pattern
+    static Edit addBond(AtomIndex a, AtomIndex b, BondType bondType);
+    //! Removes a bond of the pattern
+    static Edit removeBond(AtomIndex a, AtomIndex b);
+    //! Changes the type of a bond of the pattern
+    static Edit setBondType(AtomIndex a, AtomIndex b, BondType bondType);
+    //! Changes the element type of a pattern atom
+    static Edit setElementType(AtomIndex a, Utils::ElementType elementType);
+
+    //! Kind of graph edit
+    Type type;
+    //! First pattern atom
+    AtomIndex first;
+    //! Second pattern atom, if a bond is edited
+    AtomIndex second;
+    //! New bond type, if a bond is added or its type changed
+    BondType bondType;
+    //! New element type, if an element type is changed
+    Utils::ElementType elementType;
+  };
+
+  /*! @brief Compiles a pattern and its edits
+   *
+   * @param pattern The reactant pattern graph
+   * @param edits The edits applied in order at each match of @p pattern
+   * @param vertexStrictness Strictness of pattern atom matching
+   * @param edgeStrictness Strictness of pattern bond matching
+   * @param productComponents Components in which products are canonicalized
+   *   and distinguished
+   *
+   * @throws std::invalid_argument If an edit refers to an atom index outside
+   *   the pattern, adds a bond that the pattern already has or edits one it
+   *   does not have, or sets an eta bond type
+   */
+  ReactionTemplate(
+    const Graph& pattern,
+    std::vector<Edit> edits,
+    Subgraphs::VertexStrictness vertexStrictness = Subgraphs::VertexStrictness::ElementType,
+    Subgraphs::EdgeStrictness edgeStrictness = Subgraphs::EdgeStrictness::BondType,
+    AtomEnvironmentComponents productComponents = AtomEnvironmentComponents::All
+  );
+
+  //! The compiled reactant pattern
+  const Subgraphs::Query& query() const;
+
+  //! Edits applied at each match
+  const std::vector<Edit>& edits() const;
+
+  /*! @brief Distinct products of applying the edits at each match
+   *
+   * Matches differing only in permutations of hydrogen atoms are applied once.
+   * Products are canonicalized in the product components and deduplicated by
+   * their fingerprints, keeping the order of the first match producing each.
+   *
+   * @complexity{@math{\Theta(M N \log N)} for @math{M} matches, dominated
+   * by propagation of the edits and canonicalization of each product}
+   *
+   * @parblock @note This function is parallelized over matches. Use the
+   * OMP_NUM_THREADS environment variable to control the number of threads
+   * used.
+   * @endparblock
+   *
+   * @note Matches at which a bond removal would disconnect the molecule yield
+   *   no product, since molecules are connected graphs.
+   */
+  std::vector<Molecule> apply(const Molecule& reactant) const;
+
+private:
+  Subgraphs::Query query_;
+  std::vector<Edit> edits_;
+  AtomEnvironmentComponents productComponents_;
+};
+
+} // namespace Molassembler
+} // namespace Scine
+
+#endif
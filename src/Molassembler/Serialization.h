@@ -8,11 +8,15 @@
 #ifndef INCLUDE_MOLASSEMBLER_SERIALIZATION_H
 #define INCLUDE_MOLASSEMBLER_SERIALIZATION_H
 
+#include <cstdint>
+#include <iterator>
 #include <vector>
 #include <string>
 #include <memory>
+#include <utility>
 
 #include "Molassembler/Export.h"
+#include "Utils/Typenames.h"
 
 namespace Scine {
 namespace Molassembler {
@@ -94,6 +98,46 @@ public:
 //!@{
   static std::string base64Encode(const BinaryType& binary);
   static BinaryType base64Decode(const std::string& base64String);
+
+  /*! @brief Serialize many molecules into JSON strings in parallel
+   *
+   * @complexity{@math{\Theta(\sum_i V_i + E_i + A_i + B_i)}, divided among
+   * threads}
+   *
+   * @parblock @note This function is parallelized. Use the OMP_NUM_THREADS
+   * environment variable to control the number of threads used.
+   * @endparblock
+   *
+   * @returns Serializations in the order of @p molecules
+   */
+  static std::vector<std::string> serializeMany(const std::vector<Molecule>& molecules);
+
+  //! @overload Serializes into a binary JSON format
+  static std::vector<BinaryType> serializeMany(
+    const std::vector<Molecule>& molecules,
+    BinaryFormat format
+  );
+
+  /*! @brief Deserialize many molecules from JSON strings in parallel
+   *
+   * @complexity{Sum of the individual deserializations, divided among
+   * threads}
+   *
+   * @parblock @note This function is parallelized. Use the OMP_NUM_THREADS
+   * environment variable to control the number of threads used.
+   * @endparblock
+   *
+   * @throws The first exception encountered, once all conversions have ended
+   *
+   * @returns Molecules in the order of @p jsonStrings
+   */
+  static std::vector<Molecule> deserializeMany(const std::vector<std::string>& jsonStrings);
+
+  //! @overload Deserializes from a binary JSON format
+  static std::vector<Molecule> deserializeMany(
+    const std::vector<BinaryType>& binaries,
+    BinaryFormat format
+  );
 //!@}
 
 //!@name Special member functions
@@ -154,6 +198,525 @@ private:
   std::unique_ptr<Impl> pImpl_;
 };
 
+/**
+ * @brief Versioned fixed-layout binary serialization of molecules
+ *
+ * Unlike the binary JSON formats of JsonSerialization, this format is read
+ * directly into a Molecule without an intermediate document. Files can be
+ * read from a read-only memory mapping, so that no copy of the file contents
+ * is made.
+ *
+ * All values are stored in native byte order:
+ *
+ * @verbatim
+ * - Magic bytes "MASMMOL", a format version (uint32) and a 64-bit FNV-1a
+ *   checksum of all following bytes (uint64)
+ * - Number of atoms N, number of bonds E, number of atom and bond
+ *   stereopermutators, and canonical components (+1, zero if not canonical)
+ *   (all uint32)
+ * - Element types (N uint32)
+ * - Edges in compressed sparse row layout, listing per atom only neighbors
+ *   with greater index: N + 1 row offsets (uint32), followed by E
+ *   neighbor indices (uint32) and E bond types (uint8)
+ * - Per atom stereopermutator: placement (uint32), shape name index (uint8),
+ *   assignment (uint32, all bits set if unassigned), and its ranking as
+ *   nested lists. Each list is its length (uint32) followed by its elements:
+ *   - Ranked substituents (lists of atom indices)
+ *   - Sites (lists of atom indices)
+ *   - Ranked sites (lists of site indices)
+ *   - Links, each of a site index pair and a cycle sequence of atom indices
+ * - Per bond stereopermutator: placement (two uint32), assignment (uint32,
+ *   all bits set if unassigned), alignment (uint8) and the list of feasible
+ *   stereopermutations (uint32 length and elements)
+ * @endverbatim
+ *
+ * Serializations from trusted sources, e.g. a registry written by this
+ * library, can be deserialized with Validation::Checksum. This skips the
+ * graph-based feasibility modeling of bond stereopermutators in favor of the
+ * stored feasible stereopermutations, which dominates deserialization time
+ * of molecules with many double bonds.
+ *
+ * @code{cpp}
+ * Molecule mol;
+ * CompactSerialization::write("registry/0000001.masm", mol);
+ * Molecule reverted = CompactSerialization::read("registry/0000001.masm");
+ * @endcode
+ *
+ * @note Files are not portable between platforms of different endianness.
+ */
+struct MASM_EXPORT CompactSerialization {
+  //! Type used to represent serializations in memory
+  using BinaryType = std::vector<std::uint8_t>;
+
+  //! Version of the layout written by serialize()
+  static constexpr std::uint32_t formatVersion = 2;
+
+  //! Extent of consistency checks during deserialization
+  enum class Validation {
+    //! Check all data and model bond stereopermutator feasibility anew
+    Full,
+    /*! @brief Trust checksum-verified data
+     *
+     * Bounds checks remain, but stored bond stereopermutator feasibilities
+     * are used as-is and edge ordering is not checked.
+     */
+    Checksum
+  };
+
+  /*! @brief Serialize a molecule
+   *
+   * @complexity{@math{\Theta(N + E + A + B)}}
+   */
+  static BinaryType serialize(const Molecule& molecule);
+
+  /*! @brief Serialize a molecule canonically for content-addressed storage
+   *
+   * Serializes a fully canonicalized copy of the molecule in the layout of
+   * serialize(), eliminating all remaining notational freedom: atom
+   * stereopermutator rankings list sorted atom indices and lexicographically
+   * ordered sites, and bond stereopermutators are ordered by their placement
+   * edges. Assignments are carried over to the reordered sites. Identical
+   * molecules therefore yield byte-identical serializations regardless of
+   * their atom order or editing history, and deserialize() reads them as
+   * usual.
+   *
+   * @complexity{Canonicalization of the molecule unless it is fully
+   * canonical, plus the construction of each reordered atom stereopermutator}
+   */
+  static BinaryType canonicalSerialize(const Molecule& molecule);
+
+  /*! @brief Content digest of a serialization
+   *
+   * Reads the checksum over all data following the header from the fixed
+   * position it is stored at, without reading or verifying the remaining
+   * data. Digests of canonical serializations identify molecules, so that
+   * stored serializations can be deduplicated by digest. Distinct
+   * serializations may share a digest, albeit rarely, so compare the
+   * serializations with equal digests byte-wise to confirm duplicates.
+   *
+   * @complexity{@math{\Theta(1)}}
+   * @throws std::runtime_error If the data is not a compact serialization
+   *   of this format version
+   */
+  static std::uint64_t digest(const std::uint8_t* data, std::size_t size);
+
+  //! @overload
+  static std::uint64_t digest(const BinaryType& binary);
+
+  /*! @brief Deserialize a molecule from memory
+   *
+   * @complexity{@math{\Theta(N + E)} plus the construction of each
+   * stereopermutator}
+   * @throws std::runtime_error If the data is truncated, malformed, does not
+   *   match its checksum or is of a different format version
+   */
+  static Molecule deserialize(
+    const std::uint8_t* data,
+    std::size_t size,
+    Validation validation = Validation::Full
+  );
+
+  //! @overload
+  static Molecule deserialize(
+    const BinaryType& binary,
+    Validation validation = Validation::Full
+  );
+
+  /*! @brief Serialize many molecules in parallel
+   *
+   * @complexity{As serialize() for each molecule, divided among threads}
+   *
+   * @parblock @note This function is parallelized. Use the OMP_NUM_THREADS
+   * environment variable to control the number of threads used.
+   * @endparblock
+   *
+   * @returns Serializations in the order of @p molecules
+   */
+  static std::vector<BinaryType> serializeMany(const std::vector<Molecule>& molecules);
+
+  /*! @brief Deserialize many molecules in parallel
+   *
+   * @complexity{As deserialize() for each serialization, divided among
+   * threads}
+   *
+   * @parblock @note This function is parallelized. Use the OMP_NUM_THREADS
+   * environment variable to control the number of threads used.
+   * @endparblock
+   *
+   * @throws std::runtime_error The first exception encountered, once all
+   *   conversions have ended
+   *
+   * @returns Molecules in the order of @p binaries
+   */
+  static std::vector<Molecule> deserializeMany(
+    const std::vector<BinaryType>& binaries,
+    Validation validation = Validation::Full
+  );
+
+  /*! @brief Write a molecule's serialization to a file
+   *
+   * @complexity{@math{\Theta(N + E + A + B)}}
+   * @throws std::runtime_error If the file cannot be opened
+   */
+  static void write(const std::string& filename, const Molecule& molecule);
+
+  /*! @brief Read a molecule from a memory-mapped file
+   *
+   * @complexity{As deserialize()}
+   * @throws std::runtime_error If the file contents are not a valid
+   *   serialization
+   */
+  static Molecule read(
+    const std::string& filename,
+    Validation validation = Validation::Full
+  );
+};
+
+/**
+ * @brief Random-access reader of files containing many molecules
+ *
+ * Archives are written by CompactArchiveWriter and store each molecule as a
+ * CompactSerialization blob. In native byte order, the layout is:
+ *
+ * @verbatim
+ * - Magic bytes "MASMARC", format version (uint32) and flags (uint32, zero)
+ * - Number of molecules M and byte position of the offset table (uint64)
+ * - Serialized molecules, back to back
+ * - Offset table: M + 1 byte positions (uint64) delimiting the serialized
+ *   molecules
+ * @endverbatim
+ *
+ * The file is memory-mapped, so that only the accessed molecules are read
+ * from disk.
+ *
+ * @code{cpp}
+ * CompactArchive archive {"library.masmarc"};
+ * Molecule tenth = archive.at(9);
+ * for(const Molecule& molecule : archive) {
+ *   // Molecules are deserialized one at a time
+ * }
+ * @endcode
+ */
+class MASM_EXPORT CompactArchive {
+public:
+//!@name Member types
+//!@{
+  //! Input iterator deserializing molecules in archive order
+  class MASM_EXPORT Iterator {
+  public:
+    using iterator_category = std::input_iterator_tag;
+    using value_type = Molecule;
+    using difference_type = std::ptrdiff_t;
+    using pointer = void;
+    using reference = Molecule;
+
+    Iterator(const CompactArchive& archive, unsigned index);
+
+    Iterator& operator ++ ();
+    Iterator operator ++ (int);
+    Molecule operator * () const;
+
+    bool operator == (const Iterator& other) const;
+    bool operator != (const Iterator& other) const;
+
+  private:
+    const CompactArchive* archivePtr_;
+    unsigned index_;
+  };
+//!@}
+
+//!@name Static members
+//!@{
+  //! Version of the archive layout written by CompactArchiveWriter
+  static constexpr std::uint32_t formatVersion = 1;
+//!@}
+
+//!@name Special member functions
+//!@{
+  /*! @brief Open an archive
+   *
+   * @param filename Path to the archive file
+   * @param validation Validation applied to each molecule on access
+   *
+   * @complexity{@math{\Theta(M)} to validate the offset table}
+   * @throws std::runtime_error If the file is not a valid archive
+   */
+  explicit CompactArchive(
+    const std::string& filename,
+    CompactSerialization::Validation validation = CompactSerialization::Validation::Full
+  );
+
+  CompactArchive(CompactArchive&& other) noexcept;
+  CompactArchive& operator = (CompactArchive&& other) noexcept;
+  CompactArchive(const CompactArchive& other) = delete;
+  CompactArchive& operator = (const CompactArchive& other) = delete;
+  ~CompactArchive();
+//!@}
+
+//!@name Information
+//!@{
+  //! Number of molecules in the archive
+  unsigned size() const;
+
+  /*! @brief Deserialize a molecule by its index in the archive
+   *
+   * @complexity{As CompactSerialization::deserialize of the molecule}
+   * @throws std::out_of_range If @p i is not less than size()
+   * @throws std::runtime_error If the molecule's serialization is invalid
+   */
+  Molecule at(unsigned i) const;
+//!@}
+
+//!@name Iterators
+//!@{
+  Iterator begin() const;
+  Iterator end() const;
+//!@}
+
+private:
+  struct Impl;
+  std::unique_ptr<Impl> pImpl_;
+};
+
+/**
+ * @brief Sequential writer of CompactArchive files
+ *
+ * Molecules are serialized and written as they are added. The offset table
+ * is written on close() or destruction, so an archive is only readable once
+ * its writer has finished.
+ */
+class MASM_EXPORT CompactArchiveWriter {
+public:
+//!@name Special member functions
+//!@{
+  /*! @brief Create or overwrite an archive file
+   *
+   * @throws std::runtime_error If the file cannot be opened
+   */
+  explicit CompactArchiveWriter(const std::string& filename);
+
+  CompactArchiveWriter(CompactArchiveWriter&& other) noexcept;
+  CompactArchiveWriter& operator = (CompactArchiveWriter&& other) noexcept;
+  CompactArchiveWriter(const CompactArchiveWriter& other) = delete;
+  CompactArchiveWriter& operator = (const CompactArchiveWriter& other) = delete;
+  //! Closes the archive if not already closed
+  ~CompactArchiveWriter();
+//!@}
+
+//!@name Modification
+//!@{
+  /*! @brief Append a molecule to the archive
+   *
+   * @complexity{As CompactSerialization::serialize}
+   * @throws std::logic_error If the archive is already closed
+   *
+   * @returns The index of the molecule in the archive
+   */
+  unsigned add(const Molecule& molecule);
+
+  /*! @brief Write the offset table and close the file
+   *
+   * @complexity{@math{\Theta(M)}}
+   * @note Repeated calls have no effect
+   */
+  void close();
+//!@}
+
+private:
+  struct Impl;
+  std::unique_ptr<Impl> pImpl_;
+};
+
+/**
+ * @brief Memory-mapped file of a molecule and an ensemble of its conformers
+ *
+ * Stores the molecule once as a CompactSerialization blob, followed by a
+ * contiguous block of the positions of all conformers. In native byte order,
+ * the layout is:
+ *
+ * @verbatim
+ * - Magic bytes "MASMCNF", format version (uint32) and precision (uint32)
+ * - Number of conformers K and number of atoms N (uint64)
+ * - Quantization offset and scale (double, zero unless quantized)
+ * - Size of the serialized molecule (uint64) and the serialized molecule,
+ *   zero-padded to a multiple of eight bytes
+ * - Positions in bohr: K conformers of N rows of three coordinates, stored
+ *   as double, float or uint16 values depending on precision
+ * @endverbatim
+ *
+ * Quantized coordinates are offset + scale * value, with offset and scale
+ * chosen per file so that the range of all coordinates maps onto the range
+ * of uint16. The position block is aligned within the file, so that
+ * positionData() can be used in place for scoring.
+ *
+ * @code{cpp}
+ * auto ensemble = generateEnsemble(mol, 100, 42);
+ * std::vector<Utils::PositionCollection> conformers;
+ * for(auto& result : ensemble) {
+ *   if(result) {
+ *     conformers.push_back(std::move(result.value()));
+ *   }
+ * }
+ * ConformerArchive::write("ensemble.masmcnf", mol, conformers);
+ * ConformerArchive archive {"ensemble.masmcnf"};
+ * Utils::PositionCollection first = archive.at(0);
+ * @endcode
+ */
+class MASM_EXPORT ConformerArchive {
+public:
+//!@name Member types
+//!@{
+  //! Storage type of coordinates
+  enum class Precision : std::uint32_t {
+    //! 64-bit floating point, lossless
+    Double,
+    //! 32-bit floating point
+    Single,
+    //! 16-bit unsigned integers spanning the range of all coordinates
+    Quantized
+  };
+//!@}
+
+//!@name Static members
+//!@{
+  //! Version of the layout written by write()
+  static constexpr std::uint32_t formatVersion = 1;
+
+  /*! @brief Write a molecule and its conformers to a file
+   *
+   * @param filename Path of the file to create or overwrite
+   * @param molecule Molecule of which the conformers are
+   * @param conformers Conformer positions in bohr, each with a row per atom
+   * @param precision Storage type of coordinates
+   *
+   * @complexity{@math{\Theta(N + E + A + B + KN)}}
+   * @throws std::invalid_argument If any conformer's number of rows does not
+   *   match the molecule's number of atoms
+   * @throws std::runtime_error If the file cannot be opened
+   */
+  static void write(
+    const std::string& filename,
+    const Molecule& molecule,
+    const std::vector<Utils::PositionCollection>& conformers,
+    Precision precision = Precision::Double
+  );
+//!@}
+
+//!@name Special member functions
+//!@{
+  /*! @brief Open a conformer archive
+   *
+   * @param filename Path to the archive file
+   * @param validation Validation applied to the molecule's serialization
+   *
+   * @complexity{As CompactSerialization::deserialize of the molecule}
+   * @throws std::runtime_error If the file is not a valid conformer archive
+   */
+  explicit ConformerArchive(
+    const std::string& filename,
+    CompactSerialization::Validation validation = CompactSerialization::Validation::Full
+  );
+
+  ConformerArchive(ConformerArchive&& other) noexcept;
+  ConformerArchive& operator = (ConformerArchive&& other) noexcept;
+  ConformerArchive(const ConformerArchive& other) = delete;
+  ConformerArchive& operator = (const ConformerArchive& other) = delete;
+  ~ConformerArchive();
+//!@}
+
+//!@name Information
+//!@{
+  //! Molecule of which the conformers are
+  const Molecule& molecule() const;
+
+  //! Number of conformers K in the archive
+  unsigned size() const;
+
+  //! Storage type of the coordinates
+  Precision precision() const;
+
+  /*! @brief Positions of a conformer in bohr
+   *
+   * @complexity{@math{\Theta(N)}}
+   * @throws std::out_of_range If @p k is not less than size()
+   */
+  Utils::PositionCollection at(unsigned k) const;
+
+  /*! @brief Memory-mapped position block
+   *
+   * Points to size() * N * 3 values of the type indicated by precision(),
+   * ordered by conformer, atom and coordinate. Valid for the lifetime of the
+   * archive.
+   */
+  const void* positionData() const;
+
+  //! Offset and scale of quantized coordinates, zeros unless quantized
+  std::pair<double, double> quantization() const;
+//!@}
+
+private:
+  struct Impl;
+  std::unique_ptr<Impl> pImpl_;
+};
+
+/**
+ * @brief Sequential writer of ConformerArchive files
+ *
+ * Conformers are written as they are added, so that ensembles need not be
+ * kept in memory. The number of conformers is written on close() or
+ * destruction.
+ *
+ * @note Quantized precision is not supported, since it requires the range of
+ *   all coordinates in advance. Use ConformerArchive::write instead.
+ */
+class MASM_EXPORT ConformerArchiveWriter {
+public:
+//!@name Special member functions
+//!@{
+  /*! @brief Create or overwrite a conformer archive file
+   *
+   * @throws std::invalid_argument If @p precision is quantized
+   * @throws std::runtime_error If the file cannot be opened
+   */
+  ConformerArchiveWriter(
+    const std::string& filename,
+    const Molecule& molecule,
+    ConformerArchive::Precision precision = ConformerArchive::Precision::Double
+  );
+
+  ConformerArchiveWriter(ConformerArchiveWriter&& other) noexcept;
+  ConformerArchiveWriter& operator = (ConformerArchiveWriter&& other) noexcept;
+  ConformerArchiveWriter(const ConformerArchiveWriter& other) = delete;
+  ConformerArchiveWriter& operator = (const ConformerArchiveWriter& other) = delete;
+  //! Closes the archive if not already closed
+  ~ConformerArchiveWriter();
+//!@}
+
+//!@name Modification
+//!@{
+  /*! @brief Append a conformer to the archive
+   *
+   * @complexity{@math{\Theta(N)}}
+   * @throws std::invalid_argument If the number of rows of @p positions does
+   *   not match the molecule's number of atoms
+   * @throws std::logic_error If the archive is already closed
+   *
+   * @returns The index of the conformer in the archive
+   */
+  unsigned add(const Utils::PositionCollection& positions);
+
+  /*! @brief Write the number of conformers and close the file
+   *
+   * @note Repeated calls have no effect
+   */
+  void close();
+//!@}
+
+private:
+  struct Impl;
+  std::unique_ptr<Impl> pImpl_;
+};
+
 } // namespace Molassembler
 } // namespace Scine
 
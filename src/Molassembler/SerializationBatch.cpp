@@ -0,0 +1,117 @@
+/*!@file
+ * @copyright This code is licensed under the 3-clause BSD license.
+ *   Copyright ETH Zurich, Laboratory of Physical Chemistry, Reiher Group.
+ *   See LICENSE.txt for details.
+ */
+
+#include "Molassembler/Serialization.h"
+
+#include "Molassembler/Molecule.h"
+
+#include <exception>
+
+namespace Scine {
+namespace Molassembler {
+namespace {
+
+/*! @brief Applies a conversion to each input in parallel, keeping the order
+ *
+ * Exceptions cannot leave the parallel region, so the first one is kept and
+ * rethrown once all threads are done
+ */
+template<typename T, typename U, typename F>
+std::vector<T> parallelConvert(const std::vector<U>& inputs, F&& f) {
+  const unsigned M = inputs.size();
+  std::vector<T> results(M);
+  std::exception_ptr exception;
+
+#pragma omp parallel for schedule(dynamic)
+  for(unsigned i = 0; i < M; ++i) {
+    try {
+      results[i] = f(inputs[i]);
+    } catch(...) {
+#pragma omp critical(serializationBatchException)
+      {
+        if(!exception) {
+          exception = std::current_exception();
+        }
+      }
+    }
+  }
+
+  if(exception) {
+    std::rethrow_exception(exception);
+  }
+
+  return results;
+}
+
+} // namespace
+
+std::vector<std::string> JsonSerialization::serializeMany(const std::vector<Molecule>& molecules) {
+  return parallelConvert<std::string>(
+    molecules,
+    [](const Molecule& molecule) -> std::string {
+      return JsonSerialization(molecule);
+    }
+  );
+}
+
+std::vector<JsonSerialization::BinaryType> JsonSerialization::serializeMany(
+  const std::vector<Molecule>& molecules,
+  const BinaryFormat format
+) {
+  return parallelConvert<BinaryType>(
+    molecules,
+    [format](const Molecule& molecule) -> BinaryType {
+      return JsonSerialization(molecule).toBinary(format);
+    }
+  );
+}
+
+std::vector<Molecule> JsonSerialization::deserializeMany(const std::vector<std::string>& jsonStrings) {
+  return parallelConvert<Molecule>(
+    jsonStrings,
+    [](const std::string& jsonString) -> Molecule {
+      return JsonSerialization(jsonString);
+    }
+  );
+}
+
+std::vector<Molecule> JsonSerialization::deserializeMany(
+  const std::vector<BinaryType>& binaries,
+  const BinaryFormat format
+) {
+  return parallelConvert<Molecule>(
+    binaries,
+    [format](const BinaryType& binary) -> Molecule {
+      return JsonSerialization(binary, format);
+    }
+  );
+}
+
+std::vector<CompactSerialization::BinaryType> CompactSerialization::serializeMany(
+  const std::vector<Molecule>& molecules
+) {
+  return parallelConvert<BinaryType>(
+    molecules,
+    [](const Molecule& molecule) -> BinaryType {
+      return serialize(molecule);
+    }
+  );
+}
+
+std::vector<Molecule> CompactSerialization::deserializeMany(
+  const std::vector<BinaryType>& binaries,
+  const Validation validation
+) {
+  return parallelConvert<Molecule>(
+    binaries,
+    [validation](const BinaryType& binary) -> Molecule {
+      return deserialize(binary, validation);
+    }
+  );
+}
+
+} // namespace Molassembler
+} // namespace Scine
@@ -0,0 +1,798 @@
+/*!@file
+ * @copyright This code is licensed under the 3-clause BSD license.
+ *   Copyright ETH Zurich, Laboratory of Physical Chemistry, Reiher Group.
+ *   See LICENSE.txt for details.
+ */
+
+#include "Molassembler/Serialization.h"
+
+#include "Molassembler/Graph.h"
+#include "Molassembler/Graph/PrivateGraph.h"
+#include "Molassembler/Molecule.h"
+#include "Molassembler/RankingInformation.h"
+#include "Molassembler/AtomStereopermutator.h"
+#include "Molassembler/BondStereopermutator.h"
+#include "Molassembler/StereopermutatorList.h"
+#include "Molassembler/Shapes/Data.h"
+#include "Molassembler/Stereopermutators/AbstractPermutations.h"
+#include "Molassembler/Stereopermutators/FeasiblePermutations.h"
+
+#include "boost/interprocess/file_mapping.hpp"
+#include "boost/interprocess/mapped_region.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <numeric>
+
+namespace Scine {
+namespace Molassembler {
+namespace {
+
+constexpr std::array<char, 8> compactMagic {{'M', 'A', 'S', 'M', 'M', 'O', 'L', '\0'}};
+constexpr std::array<char, 8> archiveMagic {{'M', 'A', 'S', 'M', 'A', 'R', 'C', '\0'}};
+//! Magic bytes, version, flags, number of molecules and offset table position
+constexpr std::size_t archiveHeaderSize = 8 + 2 * sizeof(std::uint32_t) + 2 * sizeof(std::uint64_t);
+constexpr std::uint32_t unassignedMarker = std::numeric_limits<std::uint32_t>::max();
+
+template<typename T>
+void appendBinary(CompactSerialization::BinaryType& binary, const T value) {
+  const auto offset = binary.size();
+  binary.resize(offset + sizeof(T));
+  std::memcpy(binary.data() + offset, &value, sizeof(T));
+}
+
+template<typename T>
+void appendList(CompactSerialization::BinaryType& binary, const std::vector<T>& list) {
+  appendBinary<std::uint32_t>(binary, list.size());
+  for(const T& value : list) {
+    appendBinary<std::uint32_t>(binary, value);
+  }
+}
+
+template<typename T>
+void appendNestedList(
+  CompactSerialization::BinaryType& binary,
+  const RankingInformation::NestedList<T>& lists
+) {
+  appendBinary<std::uint32_t>(binary, lists.size());
+  for(const auto& list : lists) {
+    appendList(binary, list);
+  }
+}
+
+//! Position of the checksum, following the magic bytes and format version
+constexpr std::size_t checksumPosition = 8 + sizeof(std::uint32_t);
+
+//! 64-bit FNV-1a hash of a range of bytes
+std::uint64_t fnv1a(const std::uint8_t* data, const std::size_t size) {
+  std::uint64_t hash = 14695981039346656037ULL;
+  for(std::size_t i = 0; i < size; ++i) {
+    hash ^= data[i];
+    hash *= 1099511628211ULL;
+  }
+  return hash;
+}
+
+//! Bounds-checked reading from a contiguous range of bytes
+class Reader {
+public:
+  Reader(const std::uint8_t* data, const std::size_t size)
+    : cursor_(data), end_(data + size) {}
+
+  template<typename T>
+  T read() {
+    if(end_ - cursor_ < static_cast<std::ptrdiff_t>(sizeof(T))) {
+      throw std::runtime_error("Compact molecule serialization is truncated");
+    }
+
+    T value;
+    std::memcpy(&value, cursor_, sizeof(T));
+    cursor_ += sizeof(T);
+    return value;
+  }
+
+  //! Reads a value that must be less than a bound
+  std::uint32_t readIndex(const std::uint32_t bound) {
+    const auto value = read<std::uint32_t>();
+    if(value >= bound) {
+      throw std::runtime_error("Compact molecule serialization contains an invalid index");
+    }
+    return value;
+  }
+
+  template<typename T>
+  std::vector<T> readList(const std::uint32_t bound) {
+    const auto size = read<std::uint32_t>();
+    if(static_cast<std::size_t>(end_ - cursor_) / sizeof(std::uint32_t) < size) {
+      throw std::runtime_error("Compact molecule serialization is truncated");
+    }
+
+    std::vector<T> list;
+    list.reserve(size);
+    for(unsigned i = 0; i < size; ++i) {
+      list.emplace_back(readIndex(bound));
+    }
+    return list;
+  }
+
+  template<typename T>
+  RankingInformation::NestedList<T> readNestedList(const std::uint32_t bound) {
+    const auto size = read<std::uint32_t>();
+    if(static_cast<std::size_t>(end_ - cursor_) / sizeof(std::uint32_t) < size) {
+      throw std::runtime_error("Compact molecule serialization is truncated");
+    }
+
+    RankingInformation::NestedList<T> lists;
+    lists.reserve(size);
+    for(unsigned i = 0; i < size; ++i) {
+      lists.push_back(readList<T>(bound));
+    }
+    return lists;
+  }
+
+  bool exhausted() const {
+    return cursor_ == end_;
+  }
+
+private:
+  const std::uint8_t* cursor_;
+  const std::uint8_t* const end_;
+};
+
+RankingInformation readRanking(Reader& reader, const std::uint32_t N) {
+  RankingInformation ranking;
+  ranking.substituentRanking = reader.readNestedList<AtomIndex>(N);
+  ranking.sites = reader.readNestedList<AtomIndex>(N);
+  const std::uint32_t S = ranking.sites.size();
+  ranking.siteRanking = reader.readNestedList<SiteIndex>(S);
+
+  const auto L = reader.read<std::uint32_t>();
+  for(unsigned i = 0; i < L; ++i) {
+    RankingInformation::Link link;
+    link.sites.first = SiteIndex(reader.readIndex(S));
+    link.sites.second = SiteIndex(reader.readIndex(S));
+    link.cycleSequence = reader.readList<AtomIndex>(N);
+    ranking.links.push_back(std::move(link));
+  }
+
+  return ranking;
+}
+
+/* Eliminates the notational freedom of a ranking in the manner of
+ * JsonSerialization::standardize: Atom index lists are sorted, sites are
+ * ordered lexicographically with site rankings and links remapped
+ * accordingly, and links are ordered.
+ */
+RankingInformation standardizedRanking(RankingInformation ranking) {
+  for(auto& group : ranking.substituentRanking) {
+    std::sort(std::begin(group), std::end(group));
+  }
+  for(auto& site : ranking.sites) {
+    std::sort(std::begin(site), std::end(site));
+  }
+
+  const unsigned S = ranking.sites.size();
+  std::vector<unsigned> order(S);
+  std::iota(std::begin(order), std::end(order), 0);
+  std::sort(
+    std::begin(order),
+    std::end(order),
+    [&](const unsigned a, const unsigned b) -> bool {
+      return ranking.sites.at(a) < ranking.sites.at(b);
+    }
+  );
+
+  std::vector<SiteIndex> newIndices(S);
+  RankingInformation::SiteListType sites;
+  sites.reserve(S);
+  for(unsigned i = 0; i < S; ++i) {
+    newIndices.at(order.at(i)) = SiteIndex(i);
+    sites.push_back(std::move(ranking.sites.at(order.at(i))));
+  }
+  ranking.sites = std::move(sites);
+
+  for(auto& group : ranking.siteRanking) {
+    for(SiteIndex& site : group) {
+      site = newIndices.at(site);
+    }
+    std::sort(std::begin(group), std::end(group));
+  }
+
+  for(RankingInformation::Link& link : ranking.links) {
+    link.sites.first = newIndices.at(link.sites.first);
+    link.sites.second = newIndices.at(link.sites.second);
+    if(link.sites.first > link.sites.second) {
+      std::swap(link.sites.first, link.sites.second);
+    }
+  }
+  std::sort(std::begin(ranking.links), std::end(ranking.links));
+
+  return ranking;
+}
+
+} // namespace
+
+constexpr std::uint32_t CompactSerialization::formatVersion;
+
+CompactSerialization::BinaryType CompactSerialization::serialize(const Molecule& molecule) {
+  const PrivateGraph& inner = molecule.graph().inner();
+  const StereopermutatorList& stereopermutators = molecule.stereopermutators();
+  const unsigned N = inner.N();
+  const unsigned E = inner.B();
+
+  BinaryType binary;
+  binary.reserve(
+    compactMagic.size() + 6 * sizeof(std::uint32_t) + sizeof(std::uint64_t)
+    + N * sizeof(std::uint32_t)
+    + (N + 1 + E) * sizeof(std::uint32_t) + E
+  );
+
+  for(const char c : compactMagic) {
+    appendBinary<char>(binary, c);
+  }
+  appendBinary<std::uint32_t>(binary, formatVersion);
+  // Checksum placeholder, set once all data is written
+  appendBinary<std::uint64_t>(binary, 0);
+  appendBinary<std::uint32_t>(binary, N);
+  appendBinary<std::uint32_t>(binary, E);
+  appendBinary<std::uint32_t>(binary, stereopermutators.A());
+  appendBinary<std::uint32_t>(binary, stereopermutators.B());
+  appendBinary<std::uint32_t>(
+    binary,
+    molecule.canonicalComponents()
+      ? static_cast<std::uint32_t>(molecule.canonicalComponents().value()) + 1
+      : 0
+  );
+
+  for(AtomIndex i = 0; i < N; ++i) {
+    appendBinary<std::uint32_t>(binary, static_cast<unsigned>(inner.elementType(i)));
+  }
+
+  // Row offsets, then neighbors and bond types of upper triangle edges
+  std::vector<std::uint32_t> neighbors;
+  std::vector<std::uint8_t> bondTypes;
+  neighbors.reserve(E);
+  bondTypes.reserve(E);
+  appendBinary<std::uint32_t>(binary, 0);
+  for(AtomIndex i = 0; i < N; ++i) {
+    std::vector<std::pair<AtomIndex, BondType>> row;
+    for(const PrivateGraph::Edge& edge : inner.edges(i)) {
+      const AtomIndex j = inner.source(edge) == i ? inner.target(edge) : inner.source(edge);
+      if(j > i) {
+        row.emplace_back(j, inner.bondType(edge));
+      }
+    }
+    std::sort(std::begin(row), std::end(row));
+    for(const auto& entry : row) {
+      neighbors.push_back(entry.first);
+      bondTypes.push_back(static_cast<std::uint8_t>(entry.second));
+    }
+    appendBinary<std::uint32_t>(binary, neighbors.size());
+  }
+  for(const std::uint32_t j : neighbors) {
+    appendBinary<std::uint32_t>(binary, j);
+  }
+  for(const std::uint8_t bondType : bondTypes) {
+    appendBinary<std::uint8_t>(binary, bondType);
+  }
+
+  for(const AtomStereopermutator& permutator : stereopermutators.atomStereopermutators()) {
+    appendBinary<std::uint32_t>(binary, permutator.placement());
+    appendBinary<std::uint8_t>(binary, Shapes::nameIndex(permutator.getShape()));
+    appendBinary<std::uint32_t>(binary, permutator.assigned().value_or(unassignedMarker));
+
+    const RankingInformation& ranking = permutator.getRanking();
+    appendNestedList(binary, ranking.substituentRanking);
+    appendNestedList(binary, ranking.sites);
+    appendNestedList(binary, ranking.siteRanking);
+    appendBinary<std::uint32_t>(binary, ranking.links.size());
+    for(const RankingInformation::Link& link : ranking.links) {
+      appendBinary<std::uint32_t>(binary, link.sites.first);
+      appendBinary<std::uint32_t>(binary, link.sites.second);
+      appendList(binary, link.cycleSequence);
+    }
+  }
+
+  for(const BondStereopermutator& permutator : stereopermutators.bondStereopermutators()) {
+    appendBinary<std::uint32_t>(binary, permutator.placement().first);
+    appendBinary<std::uint32_t>(binary, permutator.placement().second);
+    appendBinary<std::uint32_t>(binary, permutator.assigned().value_or(unassignedMarker));
+    appendBinary<std::uint8_t>(binary, static_cast<unsigned>(permutator.alignment()));
+    appendList(binary, permutator.feasiblePermutations());
+  }
+
+  const std::size_t payloadPosition = checksumPosition + sizeof(std::uint64_t);
+  const std::uint64_t checksum = fnv1a(
+    binary.data() + payloadPosition,
+    binary.size() - payloadPosition
+  );
+  std::memcpy(binary.data() + checksumPosition, &checksum, sizeof(std::uint64_t));
+
+  return binary;
+}
+
+CompactSerialization::BinaryType CompactSerialization::canonicalSerialize(const Molecule& molecule) {
+  Molecule canonical = molecule;
+  if(canonical.canonicalComponents() != AtomEnvironmentComponents::All) {
+    canonical.canonicalize();
+  }
+
+  const Graph& graph = canonical.graph();
+  StereopermutatorList standardized = canonical.stereopermutators();
+  for(AtomStereopermutator& permutator : standardized.atomStereopermutators()) {
+    // Propagation carries the assignment over to the reordered sites
+    const auto oldStateOption = permutator.propagate(
+      graph,
+      standardizedRanking(permutator.getRanking()),
+      permutator.getShape()
+    );
+    if(!oldStateOption) {
+      continue;
+    }
+
+    for(const BondIndex& bond : graph.bonds(permutator.placement())) {
+      if(auto bondPermutatorOption = standardized.option(bond)) {
+        bondPermutatorOption->propagateGraphChange(
+          *oldStateOption,
+          permutator,
+          graph.inner(),
+          standardized
+        );
+      }
+    }
+  }
+
+  // Order bond stereopermutators by their placement edges
+  StereopermutatorList stereopermutators;
+  for(const AtomStereopermutator& permutator : standardized.atomStereopermutators()) {
+    stereopermutators.add(permutator);
+  }
+  std::vector<BondStereopermutator> bondStereopermutators;
+  for(const BondStereopermutator& permutator : standardized.bondStereopermutators()) {
+    bondStereopermutators.push_back(permutator);
+  }
+  std::sort(
+    std::begin(bondStereopermutators),
+    std::end(bondStereopermutators),
+    [](const BondStereopermutator& a, const BondStereopermutator& b) -> bool {
+      return a.placement() < b.placement();
+    }
+  );
+  for(BondStereopermutator& permutator : bondStereopermutators) {
+    stereopermutators.add(std::move(permutator));
+  }
+
+  return serialize(
+    Molecule {graph, std::move(stereopermutators), AtomEnvironmentComponents::All}
+  );
+}
+
+std::uint64_t CompactSerialization::digest(const std::uint8_t* const data, const std::size_t size) {
+  Reader reader {data, size};
+  for(const char c : compactMagic) {
+    if(reader.read<char>() != c) {
+      throw std::runtime_error("Not a compact molecule serialization");
+    }
+  }
+
+  if(reader.read<std::uint32_t>() != formatVersion) {
+    throw std::runtime_error("Compact molecule serialization is of a different format version");
+  }
+
+  return reader.read<std::uint64_t>();
+}
+
+std::uint64_t CompactSerialization::digest(const BinaryType& binary) {
+  return digest(binary.data(), binary.size());
+}
+
+Molecule CompactSerialization::deserialize(
+  const std::uint8_t* const data,
+  const std::size_t size,
+  const Validation validation
+) {
+  Reader reader {data, size};
+  const bool full = (validation == Validation::Full);
+
+  for(const char c : compactMagic) {
+    if(reader.read<char>() != c) {
+      throw std::runtime_error("Not a compact molecule serialization");
+    }
+  }
+
+  if(reader.read<std::uint32_t>() != formatVersion) {
+    throw std::runtime_error("Compact molecule serialization is of a different format version");
+  }
+
+  const auto checksum = reader.read<std::uint64_t>();
+  const std::size_t payloadPosition = checksumPosition + sizeof(std::uint64_t);
+  if(fnv1a(data + payloadPosition, size - payloadPosition) != checksum) {
+    throw std::runtime_error("Compact molecule serialization checksum mismatch");
+  }
+
+  const auto N = reader.read<std::uint32_t>();
+  const auto E = reader.read<std::uint32_t>();
+  const auto A = reader.read<std::uint32_t>();
+  const auto B = reader.read<std::uint32_t>();
+  const auto canonical = reader.read<std::uint32_t>();
+
+  /* Check the counts against the data size before allocating anything so
+   * that corrupt counts cannot trigger huge allocations
+   */
+  const std::size_t minimumSize = static_cast<std::size_t>(N) * 2 * sizeof(std::uint32_t)
+    + sizeof(std::uint32_t)
+    + static_cast<std::size_t>(E) * (sizeof(std::uint32_t) + 1);
+  if(size < minimumSize) {
+    throw std::runtime_error("Compact molecule serialization is truncated");
+  }
+
+  PrivateGraph inner(N);
+  for(AtomIndex i = 0; i < N; ++i) {
+    inner.elementType(i) = static_cast<Utils::ElementType>(reader.read<std::uint32_t>());
+  }
+
+  std::vector<std::uint32_t> offsets;
+  offsets.reserve(N + 1);
+  for(unsigned i = 0; i <= N; ++i) {
+    offsets.push_back(reader.read<std::uint32_t>());
+    if(offsets.back() > E || (i > 0 && offsets.back() < offsets.at(i - 1))) {
+      throw std::runtime_error("Compact molecule serialization has invalid row offsets");
+    }
+  }
+  if(offsets.front() != 0 || offsets.back() != E) {
+    throw std::runtime_error("Compact molecule serialization has invalid row offsets");
+  }
+
+  std::vector<std::uint32_t> neighbors;
+  neighbors.reserve(E);
+  for(unsigned e = 0; e < E; ++e) {
+    neighbors.push_back(reader.readIndex(N));
+  }
+  for(AtomIndex i = 0; i < N; ++i) {
+    for(unsigned e = offsets[i]; e < offsets[i + 1]; ++e) {
+      const auto bondType = reader.read<std::uint8_t>();
+      const bool ordered = neighbors[e] > i && (e == offsets[i] || neighbors[e] > neighbors[e - 1]);
+      if(bondType >= nBondTypes || (full && !ordered)) {
+        throw std::runtime_error("Compact molecule serialization contains an invalid edge");
+      }
+      inner.addEdge(i, neighbors[e], static_cast<BondType>(bondType));
+    }
+  }
+
+  Graph graph {std::move(inner)};
+  StereopermutatorList stereopermutators;
+
+  for(unsigned a = 0; a < A; ++a) {
+    const AtomIndex placement = reader.readIndex(N);
+    const auto shapeIndex = reader.read<std::uint8_t>();
+    if(shapeIndex >= Shapes::nShapes) {
+      throw std::runtime_error("Compact molecule serialization contains an invalid shape");
+    }
+    const auto assignment = reader.read<std::uint32_t>();
+
+    AtomStereopermutator stereopermutator {
+      graph,
+      Shapes::allShapes.at(shapeIndex),
+      placement,
+      readRanking(reader, N)
+    };
+
+    if(assignment != unassignedMarker) {
+      if(assignment >= stereopermutator.numAssignments()) {
+        throw std::runtime_error("Compact molecule serialization contains an invalid assignment");
+      }
+      stereopermutator.assign(assignment);
+    }
+
+    stereopermutators.add(std::move(stereopermutator));
+  }
+
+  for(unsigned b = 0; b < B; ++b) {
+    const AtomIndex first = reader.readIndex(N);
+    const AtomIndex second = reader.readIndex(N);
+    const auto assignment = reader.read<std::uint32_t>();
+    const auto alignment = reader.read<std::uint8_t>();
+    auto feasiblePermutations = reader.readList<unsigned>(unassignedMarker);
+    if(
+      alignment > static_cast<unsigned>(BondStereopermutator::Alignment::BetweenEclipsedAndStaggered)
+      || !stereopermutators.option(first)
+      || !stereopermutators.option(second)
+      || !graph.inner().edgeOption(first, second)
+    ) {
+      throw std::runtime_error("Compact molecule serialization contains an invalid bond stereopermutator");
+    }
+
+    const BondIndex bond {first, second};
+    const auto bondAlignment = static_cast<BondStereopermutator::Alignment>(alignment);
+    auto makeStereopermutator = [&]() -> BondStereopermutator {
+      if(full) {
+        // Model feasibility from the graph instead of trusting the data
+        return {graph.inner(), stereopermutators, bond, bondAlignment};
+      }
+
+      try {
+        return {stereopermutators, bond, bondAlignment, std::move(feasiblePermutations)};
+      } catch(std::out_of_range& e) {
+        throw std::runtime_error("Compact molecule serialization contains an invalid bond stereopermutator");
+      }
+    };
+    BondStereopermutator stereopermutator = makeStereopermutator();
+
+    if(assignment != unassignedMarker) {
+      if(assignment >= stereopermutator.numAssignments()) {
+        throw std::runtime_error("Compact molecule serialization contains an invalid assignment");
+      }
+      stereopermutator.assign(assignment);
+    }
+
+    stereopermutators.add(std::move(stereopermutator));
+  }
+
+  if(!reader.exhausted()) {
+    throw std::runtime_error("Compact molecule serialization has trailing data");
+  }
+
+  boost::optional<AtomEnvironmentComponents> canonicalComponentsOption;
+  if(canonical > 0) {
+    canonicalComponentsOption = static_cast<AtomEnvironmentComponents>(canonical - 1);
+  }
+
+  return Molecule {std::move(graph), std::move(stereopermutators), canonicalComponentsOption};
+}
+
+Molecule CompactSerialization::deserialize(const BinaryType& binary, const Validation validation) {
+  return deserialize(binary.data(), binary.size(), validation);
+}
+
+void CompactSerialization::write(const std::string& filename, const Molecule& molecule) {
+  const BinaryType binary = serialize(molecule);
+
+  std::ofstream file(filename, std::ios::binary);
+  if(!file) {
+    throw std::runtime_error("Could not open " + filename + " for writing");
+  }
+
+  file.write(reinterpret_cast<const char*>(binary.data()), binary.size());
+}
+
+Molecule CompactSerialization::read(const std::string& filename, const Validation validation) {
+  const boost::interprocess::file_mapping mapping {
+    filename.c_str(),
+    boost::interprocess::read_only
+  };
+  const boost::interprocess::mapped_region region {
+    mapping,
+    boost::interprocess::read_only
+  };
+
+  try {
+    return deserialize(
+      static_cast<const std::uint8_t*>(region.get_address()),
+      region.get_size(),
+      validation
+    );
+  } catch(std::runtime_error& e) {
+    throw std::runtime_error(filename + ": " + e.what());
+  }
+}
+
+/* CompactArchive */
+
+struct CompactArchive::Impl {
+  Impl(const std::string& filename, const CompactSerialization::Validation passValidation)
+    : validation(passValidation),
+      mapping(filename.c_str(), boost::interprocess::read_only),
+      region(mapping, boost::interprocess::read_only),
+      data(static_cast<const std::uint8_t*>(region.get_address()))
+  {
+    const std::size_t size = region.get_size();
+    Reader reader {data, size};
+
+    try {
+      for(const char c : archiveMagic) {
+        if(reader.read<char>() != c) {
+          throw std::runtime_error("Not a compact molecule archive");
+        }
+      }
+
+      if(reader.read<std::uint32_t>() != formatVersion) {
+        throw std::runtime_error("Compact molecule archive is of a different format version");
+      }
+
+      if(reader.read<std::uint32_t>() != 0) {
+        throw std::runtime_error("Compact molecule archive uses unsupported features");
+      }
+
+      const auto M = reader.read<std::uint64_t>();
+      const auto tablePosition = reader.read<std::uint64_t>();
+      if(
+        M > std::numeric_limits<unsigned>::max()
+        || tablePosition < archiveHeaderSize
+        || tablePosition > size
+        || (size - tablePosition) / sizeof(std::uint64_t) != M + 1
+        || (size - tablePosition) % sizeof(std::uint64_t) != 0
+      ) {
+        throw std::runtime_error("Compact molecule archive has an invalid offset table");
+      }
+
+      count = M;
+      offsetTable = data + tablePosition;
+
+      // Offsets must delimit consecutive ranges between header and table
+      std::uint64_t previous = archiveHeaderSize;
+      for(unsigned i = 0; i <= count; ++i) {
+        const std::uint64_t current = offset(i);
+        if(
+          (i == 0 && current != archiveHeaderSize)
+          || current < previous
+          || (i == count && current != tablePosition)
+        ) {
+          throw std::runtime_error("Compact molecule archive has an invalid offset table");
+        }
+        previous = current;
+      }
+    } catch(std::runtime_error& e) {
+      throw std::runtime_error(filename + ": " + e.what());
+    }
+  }
+
+  std::uint64_t offset(const unsigned i) const {
+    std::uint64_t value;
+    std::memcpy(&value, offsetTable + i * sizeof(std::uint64_t), sizeof(std::uint64_t));
+    return value;
+  }
+
+  CompactSerialization::Validation validation;
+  boost::interprocess::file_mapping mapping;
+  boost::interprocess::mapped_region region;
+  const std::uint8_t* data;
+  const std::uint8_t* offsetTable;
+  unsigned count;
+};
+
+constexpr std::uint32_t CompactArchive::formatVersion;
+
+CompactArchive::CompactArchive(
+  const std::string& filename,
+  const CompactSerialization::Validation validation
+) : pImpl_(std::make_unique<Impl>(filename, validation)) {}
+
+CompactArchive::CompactArchive(CompactArchive&& other) noexcept = default;
+CompactArchive& CompactArchive::operator = (CompactArchive&& other) noexcept = default;
+CompactArchive::~CompactArchive() = default;
+
+unsigned CompactArchive::size() const {
+  return pImpl_->count;
+}
+
+Molecule CompactArchive::at(const unsigned i) const {
+  if(i >= pImpl_->count) {
+    throw std::out_of_range("Molecule index exceeds archive size");
+  }
+
+  const std::uint64_t begin = pImpl_->offset(i);
+  const std::uint64_t end = pImpl_->offset(i + 1);
+  return CompactSerialization::deserialize(
+    pImpl_->data + begin,
+    end - begin,
+    pImpl_->validation
+  );
+}
+
+CompactArchive::Iterator CompactArchive::begin() const {
+  return {*this, 0};
+}
+
+CompactArchive::Iterator CompactArchive::end() const {
+  return {*this, size()};
+}
+
+CompactArchive::Iterator::Iterator(const CompactArchive& archive, const unsigned index)
+  : archivePtr_(&archive), index_(index) {}
+
+CompactArchive::Iterator& CompactArchive::Iterator::operator ++ () {
+  ++index_;
+  return *this;
+}
+
+CompactArchive::Iterator CompactArchive::Iterator::operator ++ (int) {
+  Iterator copy = *this;
+  ++index_;
+  return copy;
+}
+
+Molecule CompactArchive::Iterator::operator * () const {
+  return archivePtr_->at(index_);
+}
+
+bool CompactArchive::Iterator::operator == (const Iterator& other) const {
+  return archivePtr_ == other.archivePtr_ && index_ == other.index_;
+}
+
+bool CompactArchive::Iterator::operator != (const Iterator& other) const {
+  return !(*this == other);
+}
+
+/* CompactArchiveWriter */
+
+struct CompactArchiveWriter::Impl {
+  explicit Impl(const std::string& filename) : file(filename, std::ios::binary) {
+    if(!file) {
+      throw std::runtime_error("Could not open " + filename + " for writing");
+    }
+
+    writeHeader(0, archiveHeaderSize);
+    offsets.push_back(archiveHeaderSize);
+  }
+
+  void writeHeader(const std::uint64_t M, const std::uint64_t tablePosition) {
+    file.write(archiveMagic.data(), archiveMagic.size());
+    writeValue<std::uint32_t>(CompactArchive::formatVersion);
+    writeValue<std::uint32_t>(0);
+    writeValue<std::uint64_t>(M);
+    writeValue<std::uint64_t>(tablePosition);
+  }
+
+  template<typename T>
+  void writeValue(const T value) {
+    file.write(reinterpret_cast<const char*>(&value), sizeof(T));
+  }
+
+  std::ofstream file;
+  std::vector<std::uint64_t> offsets;
+  bool closed = false;
+};
+
+CompactArchiveWriter::CompactArchiveWriter(const std::string& filename)
+  : pImpl_(std::make_unique<Impl>(filename)) {}
+
+CompactArchiveWriter::CompactArchiveWriter(CompactArchiveWriter&& other) noexcept = default;
+CompactArchiveWriter& CompactArchiveWriter::operator = (CompactArchiveWriter&& other) noexcept = default;
+
+CompactArchiveWriter::~CompactArchiveWriter() {
+  if(pImpl_) {
+    try {
+      close();
+    } catch(...) {
+      // Destructors must not throw. Call close() to observe failures.
+    }
+  }
+}
+
+unsigned CompactArchiveWriter::add(const Molecule& molecule) {
+  if(pImpl_->closed) {
+    throw std::logic_error("Cannot add molecules to a closed archive");
+  }
+
+  const auto binary = CompactSerialization::serialize(molecule);
+  pImpl_->file.write(reinterpret_cast<const char*>(binary.data()), binary.size());
+  pImpl_->offsets.push_back(pImpl_->offsets.back() + binary.size());
+  return pImpl_->offsets.size() - 2;
+}
+
+void CompactArchiveWriter::close() {
+  if(pImpl_->closed) {
+    return;
+  }
+  pImpl_->closed = true;
+
+  const std::uint64_t tablePosition = pImpl_->offsets.back();
+  for(const std::uint64_t offset : pImpl_->offsets) {
+    pImpl_->writeValue(offset);
+  }
+
+  // Patch the header now that the number of molecules is known
+  pImpl_->file.seekp(0);
+  pImpl_->writeHeader(pImpl_->offsets.size() - 1, tablePosition);
+  pImpl_->file.close();
+
+  if(pImpl_->file.fail()) {
+    throw std::runtime_error("Failed to write compact molecule archive");
+  }
+}
+
+} // namespace Molassembler
+} // namespace Scine
@@ -0,0 +1,375 @@
+/*!@file
+ * @copyright This code is licensed under the 3-clause BSD license.
+ *   Copyright ETH Zurich, Laboratory of Physical Chemistry, Reiher Group.
+ *   See LICENSE.txt for details.
+ */
+
+#include "Molassembler/Serialization.h"
+
+#include "Molassembler/Graph.h"
+#include "Molassembler/Molecule.h"
+
+#include "boost/optional.hpp"
+#include "boost/interprocess/file_mapping.hpp"
+#include "boost/interprocess/mapped_region.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <limits>
+
+namespace Scine {
+namespace Molassembler {
+namespace {
+
+constexpr std::array<char, 8> conformerMagic {{'M', 'A', 'S', 'M', 'C', 'N', 'F', '\0'}};
+/*! Magic bytes, version, precision, number of conformers and atoms,
+ * quantization offset and scale and the molecule's serialization size
+ */
+constexpr std::size_t conformerHeaderSize = 8 + 2 * sizeof(std::uint32_t)
+  + 3 * sizeof(std::uint64_t) + 2 * sizeof(double);
+constexpr std::size_t positionAlignment = 8;
+constexpr double quantizationLevels = std::numeric_limits<std::uint16_t>::max();
+
+std::size_t coordinateSize(const ConformerArchive::Precision precision) {
+  switch(precision) {
+    case ConformerArchive::Precision::Double: return sizeof(double);
+    case ConformerArchive::Precision::Single: return sizeof(float);
+    case ConformerArchive::Precision::Quantized: return sizeof(std::uint16_t);
+  }
+
+  throw std::runtime_error("Conformer archive has an unknown precision");
+}
+
+std::size_t paddedSize(const std::size_t size) {
+  return (size + positionAlignment - 1) / positionAlignment * positionAlignment;
+}
+
+template<typename T>
+void writeValue(std::ofstream& file, const T value) {
+  file.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template<typename T>
+T readValue(const std::uint8_t* const data) {
+  T value;
+  std::memcpy(&value, data, sizeof(T));
+  return value;
+}
+
+//! Writes the header and serialized molecule, padded up to the position block
+void writeHeader(
+  std::ofstream& file,
+  const Molecule& molecule,
+  const ConformerArchive::Precision precision,
+  const std::uint64_t K,
+  const double offset,
+  const double scale
+) {
+  const auto binary = CompactSerialization::serialize(molecule);
+  file.write(conformerMagic.data(), conformerMagic.size());
+  writeValue<std::uint32_t>(file, ConformerArchive::formatVersion);
+  writeValue<std::uint32_t>(file, static_cast<std::uint32_t>(precision));
+  writeValue<std::uint64_t>(file, K);
+  writeValue<std::uint64_t>(file, molecule.graph().N());
+  writeValue<double>(file, offset);
+  writeValue<double>(file, scale);
+  writeValue<std::uint64_t>(file, binary.size());
+  file.write(reinterpret_cast<const char*>(binary.data()), binary.size());
+
+  const std::size_t padding = paddedSize(conformerHeaderSize + binary.size()) - conformerHeaderSize - binary.size();
+  for(std::size_t i = 0; i < padding; ++i) {
+    writeValue<char>(file, '\0');
+  }
+}
+
+void writeCoordinates(
+  std::ofstream& file,
+  const Utils::PositionCollection& conformer,
+  const ConformerArchive::Precision precision,
+  const double offset,
+  const double scale
+) {
+  using Precision = ConformerArchive::Precision;
+  const unsigned N = conformer.rows();
+  for(unsigned i = 0; i < N; ++i) {
+    for(unsigned j = 0; j < 3; ++j) {
+      const double value = conformer(i, j);
+      switch(precision) {
+        case Precision::Double:
+          writeValue<double>(file, value);
+          break;
+        case Precision::Single:
+          writeValue<float>(file, static_cast<float>(value));
+          break;
+        case Precision::Quantized:
+          writeValue<std::uint16_t>(
+            file,
+            scale > 0.0 ? static_cast<std::uint16_t>(std::lround((value - offset) / scale)) : 0
+          );
+          break;
+      }
+    }
+  }
+}
+
+} // namespace
+
+/* ConformerArchive */
+
+struct ConformerArchive::Impl {
+  Impl(const std::string& filename, const CompactSerialization::Validation validation)
+    : mapping(filename.c_str(), boost::interprocess::read_only),
+      region(mapping, boost::interprocess::read_only)
+  {
+    const auto data = static_cast<const std::uint8_t*>(region.get_address());
+    const std::size_t size = region.get_size();
+
+    try {
+      if(size < conformerHeaderSize || std::memcmp(data, conformerMagic.data(), conformerMagic.size()) != 0) {
+        throw std::runtime_error("Not a conformer archive");
+      }
+
+      const std::uint8_t* cursor = data + conformerMagic.size();
+      if(readValue<std::uint32_t>(cursor) != formatVersion) {
+        throw std::runtime_error("Conformer archive is of a different format version");
+      }
+      cursor += sizeof(std::uint32_t);
+
+      const auto precisionIndex = readValue<std::uint32_t>(cursor);
+      if(precisionIndex > static_cast<std::uint32_t>(Precision::Quantized)) {
+        throw std::runtime_error("Conformer archive has an unknown precision");
+      }
+      storedPrecision = static_cast<Precision>(precisionIndex);
+      cursor += sizeof(std::uint32_t);
+
+      const auto K = readValue<std::uint64_t>(cursor);
+      cursor += sizeof(std::uint64_t);
+      const auto N = readValue<std::uint64_t>(cursor);
+      cursor += sizeof(std::uint64_t);
+      quantizationOffset = readValue<double>(cursor);
+      cursor += sizeof(double);
+      quantizationScale = readValue<double>(cursor);
+      cursor += sizeof(double);
+      const auto moleculeSize = readValue<std::uint64_t>(cursor);
+      cursor += sizeof(std::uint64_t);
+
+      if(moleculeSize > size - conformerHeaderSize) {
+        throw std::runtime_error("Conformer archive is truncated");
+      }
+
+      moleculeOption = CompactSerialization::deserialize(cursor, moleculeSize, validation);
+      if(moleculeOption->graph().N() != N || K > std::numeric_limits<unsigned>::max()) {
+        throw std::runtime_error("Conformer archive header does not match its molecule");
+      }
+
+      const std::size_t positionsBegin = paddedSize(conformerHeaderSize + moleculeSize);
+      const std::size_t conformerSize = N * 3 * coordinateSize(storedPrecision);
+      if(positionsBegin > size || (size - positionsBegin) != K * conformerSize) {
+        throw std::runtime_error("Conformer archive has an invalid position block");
+      }
+
+      count = K;
+      atoms = N;
+      positions = data + positionsBegin;
+    } catch(std::runtime_error& e) {
+      throw std::runtime_error(filename + ": " + e.what());
+    }
+  }
+
+  template<typename T>
+  Utils::PositionCollection convert(const unsigned k) const {
+    Utils::PositionCollection result(atoms, 3);
+    const std::size_t begin = static_cast<std::size_t>(k) * atoms * 3;
+    for(unsigned i = 0; i < atoms; ++i) {
+      for(unsigned j = 0; j < 3; ++j) {
+        result(i, j) = readValue<T>(positions + (begin + 3 * i + j) * sizeof(T));
+      }
+    }
+    return result;
+  }
+
+  boost::interprocess::file_mapping mapping;
+  boost::interprocess::mapped_region region;
+  boost::optional<Molecule> moleculeOption;
+  Precision storedPrecision;
+  double quantizationOffset;
+  double quantizationScale;
+  const std::uint8_t* positions;
+  unsigned count;
+  unsigned atoms;
+};
+
+constexpr std::uint32_t ConformerArchive::formatVersion;
+
+void ConformerArchive::write(
+  const std::string& filename,
+  const Molecule& molecule,
+  const std::vector<Utils::PositionCollection>& conformers,
+  const Precision precision
+) {
+  const unsigned N = molecule.graph().N();
+  for(const auto& conformer : conformers) {
+    if(static_cast<unsigned>(conformer.rows()) != N) {
+      throw std::invalid_argument("Conformer positions do not match the number of atoms");
+    }
+  }
+
+  double offset = 0.0;
+  double scale = 0.0;
+  if(precision == Precision::Quantized && !conformers.empty()) {
+    double minimum = std::numeric_limits<double>::max();
+    double maximum = std::numeric_limits<double>::lowest();
+    for(const auto& conformer : conformers) {
+      minimum = std::min(minimum, conformer.minCoeff());
+      maximum = std::max(maximum, conformer.maxCoeff());
+    }
+    offset = minimum;
+    scale = (maximum - minimum) / quantizationLevels;
+  }
+
+  std::ofstream file(filename, std::ios::binary);
+  if(!file) {
+    throw std::runtime_error("Could not open " + filename + " for writing");
+  }
+
+  writeHeader(file, molecule, precision, conformers.size(), offset, scale);
+  for(const auto& conformer : conformers) {
+    writeCoordinates(file, conformer, precision, offset, scale);
+  }
+
+  if(!file) {
+    throw std::runtime_error("Could not write " + filename);
+  }
+}
+
+ConformerArchive::ConformerArchive(
+  const std::string& filename,
+  const CompactSerialization::Validation validation
+) : pImpl_(std::make_unique<Impl>(filename, validation)) {}
+
+ConformerArchive::ConformerArchive(ConformerArchive&& other) noexcept = default;
+ConformerArchive& ConformerArchive::operator = (ConformerArchive&& other) noexcept = default;
+ConformerArchive::~ConformerArchive() = default;
+
+const Molecule& ConformerArchive::molecule() const {
+  return pImpl_->moleculeOption.value();
+}
+
+unsigned ConformerArchive::size() const {
+  return pImpl_->count;
+}
+
+ConformerArchive::Precision ConformerArchive::precision() const {
+  return pImpl_->storedPrecision;
+}
+
+Utils::PositionCollection ConformerArchive::at(const unsigned k) const {
+  if(k >= pImpl_->count) {
+    throw std::out_of_range("Conformer index exceeds archive size");
+  }
+
+  switch(pImpl_->storedPrecision) {
+    case Precision::Double:
+      return pImpl_->convert<double>(k);
+    case Precision::Single:
+      return pImpl_->convert<float>(k);
+    case Precision::Quantized: {
+      Utils::PositionCollection positions = pImpl_->convert<std::uint16_t>(k);
+      positions *= pImpl_->quantizationScale;
+      positions.array() += pImpl_->quantizationOffset;
+      return positions;
+    }
+  }
+
+  throw std::runtime_error("Conformer archive has an unknown precision");
+}
+
+const void* ConformerArchive::positionData() const {
+  return pImpl_->positions;
+}
+
+std::pair<double, double> ConformerArchive::quantization() const {
+  return {pImpl_->quantizationOffset, pImpl_->quantizationScale};
+}
+
+/* ConformerArchiveWriter */
+
+struct ConformerArchiveWriter::Impl {
+  Impl(const std::string& filename, const Molecule& molecule, const ConformerArchive::Precision passPrecision)
+    : file(filename, std::ios::binary),
+      precision(passPrecision),
+      N(molecule.graph().N())
+  {
+    if(precision == ConformerArchive::Precision::Quantized) {
+      throw std::invalid_argument(
+        "Quantization requires the range of all coordinates. Use ConformerArchive::write instead."
+      );
+    }
+
+    if(!file) {
+      throw std::runtime_error("Could not open " + filename + " for writing");
+    }
+
+    writeHeader(file, molecule, precision, 0, 0.0, 0.0);
+  }
+
+  std::ofstream file;
+  ConformerArchive::Precision precision;
+  unsigned N;
+  unsigned count = 0;
+  bool closed = false;
+};
+
+ConformerArchiveWriter::ConformerArchiveWriter(
+  const std::string& filename,
+  const Molecule& molecule,
+  const ConformerArchive::Precision precision
+) : pImpl_(std::make_unique<Impl>(filename, molecule, precision)) {}
+
+ConformerArchiveWriter::ConformerArchiveWriter(ConformerArchiveWriter&& other) noexcept = default;
+ConformerArchiveWriter& ConformerArchiveWriter::operator = (ConformerArchiveWriter&& other) noexcept = default;
+
+ConformerArchiveWriter::~ConformerArchiveWriter() {
+  if(pImpl_) {
+    try {
+      close();
+    } catch(...) {
+      // Destructors must not throw. Call close() to observe failures.
+    }
+  }
+}
+
+unsigned ConformerArchiveWriter::add(const Utils::PositionCollection& positions) {
+  if(pImpl_->closed) {
+    throw std::logic_error("Cannot add conformers to a closed archive");
+  }
+
+  if(static_cast<unsigned>(positions.rows()) != pImpl_->N) {
+    throw std::invalid_argument("Conformer positions do not match the number of atoms");
+  }
+
+  writeCoordinates(pImpl_->file, positions, pImpl_->precision, 0.0, 0.0);
+  return pImpl_->count++;
+}
+
+void ConformerArchiveWriter::close() {
+  if(pImpl_->closed) {
+    return;
+  }
+
+  pImpl_->closed = true;
+  // Patch the number of conformers into the header
+  pImpl_->file.seekp(conformerMagic.size() + 2 * sizeof(std::uint32_t));
+  writeValue<std::uint64_t>(pImpl_->file, pImpl_->count);
+  pImpl_->file.close();
+
+  if(!pImpl_->file) {
+    throw std::runtime_error("Could not write conformer archive");
+  }
+}
+
+} // namespace Molassembler
+} // namespace Scine
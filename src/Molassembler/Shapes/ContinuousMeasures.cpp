@@ -8,13 +8,16 @@
 
 #include "Molassembler/Shapes/Diophantine.h"
 #include "Molassembler/Shapes/Partitioner.h"
+#include "Molassembler/Shapes/PropertyCaching.h"
 #include "Molassembler/Shapes/Data.h"
+#include "Molassembler/Parallel.h"
+#include "Molassembler/Detail/Metrics.h"
 
 #include "Molassembler/Temple/Adaptors/Iota.h"
 #include "Molassembler/Temple/Adaptors/Transform.h"
 #include "Molassembler/Temple/Functional.h"
-#include "Molassembler/Temple/Loops.h"
 #include "Molassembler/Temple/Optimization/SO3NelderMead.h"
+#include "Molassembler/Temple/Stl17.h"
 #include "Molassembler/Temple/constexpr/Jsf.h"
 #include "Molassembler/Temple/constexpr/Numeric.h"
 
@@ -22,8 +25,15 @@
 #include "boost/math/tools/minima.hpp"
 #include "boost/math/distributions/beta.hpp"
 #include <Eigen/Eigenvalues>
+#include <Eigen/SVD>
 
+#include <algorithm>
+#include <atomic>
+#include <map>
+#include <memory>
+#include <numeric>
 #include <random>
+#include <tuple>
 
 namespace Scine {
 namespace Molassembler {
@@ -190,6 +200,140 @@ PositionCollection normalize(const PositionCollection& positions) {
   return transformed;
 }
 
+namespace {
+
+/* Enumerations for fixed rotation and reflection element measures. These
+ * depend only on the number of points P and the element order, so they are
+ * generated once per pair and iterated from flat tables thereafter.
+ */
+struct ElementEnumeration {
+  //! Permutations are only tabulated up to this element order
+  static constexpr unsigned maxPermutationOrder = 8;
+
+  //! Enumerations for a single solution of groups * order + rest = P
+  struct Split {
+    //! Number of groups of size order, non-zero
+    unsigned groups;
+    /*! @brief Flat list of point selections of P indices each
+     *
+     * The first groups * order indices of a selection are partitioned, the
+     * remaining ones are symmetrized onto the element. Both ranges ascend.
+     */
+    std::vector<unsigned> selections;
+    /*! @brief Flat list of partitions of groups * order local indices each
+     *
+     * Group g of a partition occupies the range [g * order, (g + 1) * order)
+     * in ascending order.
+     */
+    std::vector<unsigned> partitions;
+  };
+
+  ElementEnumeration(const unsigned P, const unsigned order) {
+    const std::vector<unsigned> diophantineConstants {order, 1};
+    std::vector<unsigned> diophantineMultipliers;
+    if(!Diophantine::first_solution(diophantineMultipliers, diophantineConstants, P)) {
+      throw std::logic_error("Diophantine failure! Couldn't find first solution");
+    }
+
+    do {
+      const unsigned groups = diophantineMultipliers.front();
+      if(groups == 0) {
+        allSymmetrized = true;
+        continue;
+      }
+
+      Split split;
+      split.groups = groups;
+
+      std::vector<unsigned> partitionOrSymmetrize;
+      partitionOrSymmetrize.reserve(P);
+      partitionOrSymmetrize.resize(order * groups, 0);
+      partitionOrSymmetrize.resize(P, 1);
+      do {
+        for(unsigned i = 0; i < P; ++i) {
+          if(partitionOrSymmetrize[i] == 0) {
+            split.selections.push_back(i);
+          }
+        }
+        for(unsigned i = 0; i < P; ++i) {
+          if(partitionOrSymmetrize[i] == 1) {
+            split.selections.push_back(i);
+          }
+        }
+      } while(std::next_permutation(std::begin(partitionOrSymmetrize), std::end(partitionOrSymmetrize)));
+
+      Partitioner partitioner {groups, order};
+      do {
+        for(auto&& partitionIndices : partitioner.partitions()) {
+          std::copy(
+            std::begin(partitionIndices),
+            std::end(partitionIndices),
+            std::back_inserter(split.partitions)
+          );
+        }
+      } while(partitioner.next_partition());
+
+      splits.push_back(std::move(split));
+    } while(Diophantine::next_solution(diophantineMultipliers, diophantineConstants, P));
+
+    if(order <= maxPermutationOrder) {
+      std::vector<unsigned> permutation(order);
+      std::iota(std::begin(permutation), std::end(permutation), 0);
+      do {
+        std::copy(
+          std::begin(permutation),
+          std::end(permutation),
+          std::back_inserter(permutations)
+        );
+      } while(std::next_permutation(std::begin(permutation), std::end(permutation)));
+    }
+  }
+
+  //! Whether a solution symmetrizes all points onto the element
+  bool allSymmetrized = false;
+  //! Solutions with at least one group, in enumeration order
+  std::vector<Split> splits;
+  //! Flat list of permutations of order indices each, if order is small
+  std::vector<unsigned> permutations;
+};
+
+constexpr unsigned ElementEnumeration::maxPermutationOrder;
+
+/* Fetches or generates the enumerations for P points and an element order.
+ * Accesses are serialized by the continuousElementEnumerations critical
+ * section.
+ */
+std::shared_ptr<const ElementEnumeration> elementEnumeration(
+  const unsigned P,
+  const unsigned order
+) {
+  using Key = std::pair<unsigned, unsigned>;
+  static std::map<Key, std::shared_ptr<const ElementEnumeration>> cache;
+  const Key key {P, order};
+
+  std::shared_ptr<const ElementEnumeration> enumeration;
+#pragma omp critical(continuousElementEnumerations)
+  {
+    const auto findIter = cache.find(key);
+    if(findIter != std::end(cache)) {
+      enumeration = findIter->second;
+    }
+  }
+
+  if(enumeration) {
+    return enumeration;
+  }
+
+  // Generate outside the critical section. Racing threads keep the first one.
+  auto generated = std::make_shared<const ElementEnumeration>(P, order);
+#pragma omp critical(continuousElementEnumerations)
+  enumeration = cache.emplace(key, std::move(generated)).first->second;
+
+  return enumeration;
+}
+
+} // namespace
+
 namespace Fixed {
 
 double element(
@@ -200,8 +344,9 @@ double element(
   assert(std::fabs(rotation.axis.norm() - 1) < 1e-10);
   assert(rotation.n >= 2);
   const unsigned P = normalizedPositions.cols();
+  const unsigned n = rotation.n;
 
-  if(rotation.n > P) {
+  if(n > P) {
     return 100;
   }
 
@@ -210,21 +355,13 @@ double element(
     rotation.axis
   );
 
-  std::vector<unsigned> diophantineConstants {rotation.n, 1};
-  if(!Diophantine::has_solution(diophantineConstants, P)) {
-    return 100;
-  }
-
-  std::vector<unsigned> diophantineMultipliers;
-  if(!Diophantine::first_solution(diophantineMultipliers, diophantineConstants, P)) {
-    throw std::logic_error("Diophantine failure! Couldn't find first solution");
-  }
+  const auto enumeration = elementEnumeration(P, n);
 
   /* Precalculate fold and unfold matrices */
-  Eigen::Matrix<double, 3, Eigen::Dynamic> foldMatrices(3, 3 * (rotation.n - 1));
-  Eigen::Matrix<double, 3, Eigen::Dynamic> unfoldMatrices(3, 3 * (rotation.n - 1));
+  Eigen::Matrix<double, 3, Eigen::Dynamic> foldMatrices(3, 3 * (n - 1));
+  Eigen::Matrix<double, 3, Eigen::Dynamic> unfoldMatrices(3, 3 * (n - 1));
   auto cumulativeRotation = rotation;
-  for(unsigned i = 0; i < rotation.n - 1; ++i) {
+  for(unsigned i = 0; i < n - 1; ++i) {
     foldMatrices.block<3, 3>(0, 3 * i) = cumulativeRotation.matrix();
     unfoldMatrices.block<3, 3>(0, 3 * i) = foldMatrices.block<3, 3>(0, 3 * i).inverse();
 
@@ -232,87 +369,91 @@ double element(
     cumulativeRotation.reflect xor_eq rotation.reflect;
   }
 
-  auto calculateBestPermutationCSM = [&](std::vector<unsigned> particlePermutation) -> double {
-    assert(std::is_sorted(std::begin(particlePermutation), std::end(particlePermutation)));
-    const unsigned p = particlePermutation.size();
+  // Ascending point indices of the group being symmetrized
+  std::vector<unsigned> particles(n);
+
+  auto calculatePermutationCSM = [&](const unsigned* permutation) -> double {
+    auto position = [&](const unsigned i) {
+      return normalizedPositions.col(particles[permutation[i]]);
+    };
 
+    /* Fold and average */
+    Eigen::Vector3d averagePoint = position(0);
+    for(unsigned i = 1; i < n; ++i) {
+      averagePoint += foldMatrices.block<3, 3>(0, 3 * (i - 1)) * position(i);
+    }
+    averagePoint /= n;
+
+    /* Unfold and calculate CSM */
+    double csm = (position(0) - averagePoint).squaredNorm();
+    for(unsigned i = 1; i < n; ++i) {
+      csm += (
+        unfoldMatrices.block<3, 3>(0, 3 * (i - 1)) * averagePoint
+        - position(i)
+      ).squaredNorm();
+    }
+    return csm / n;
+  };
+
+  auto calculateBestPermutationCSM = [&]() -> double {
+    assert(std::is_sorted(std::begin(particles), std::end(particles)));
     double minimalPermutationCSM = 1000;
-    do {
-      /* Fold and average */
-      Eigen::Vector3d averagePoint = normalizedPositions.col(particlePermutation.front());
-      for(unsigned i = 1; i < p; ++i) {
-        averagePoint += foldMatrices.block<3, 3>(0, 3 * (i - 1)) * normalizedPositions.col(particlePermutation.at(i));
-      }
-      averagePoint /= p;
-
-      /* Unfold and calculate CSM */
-      double csm = (normalizedPositions.col(particlePermutation.front()) - averagePoint).squaredNorm();
-      for(unsigned i = 1; i < p; ++i) {
-        csm += (
-          unfoldMatrices.block<3, 3>(0, 3 * (i - 1)) * averagePoint
-          - normalizedPositions.col(particlePermutation.at(i))
-        ).squaredNorm();
+    const auto& permutations = enumeration->permutations;
+    if(!permutations.empty()) {
+      for(const unsigned* permutation = permutations.data(); permutation != permutations.data() + permutations.size(); permutation += n) {
+        minimalPermutationCSM = std::min(minimalPermutationCSM, calculatePermutationCSM(permutation));
       }
-      csm /= p;
-
-      minimalPermutationCSM = std::min(minimalPermutationCSM, csm);
-    } while(std::next_permutation(std::begin(particlePermutation), std::end(particlePermutation)));
+      return minimalPermutationCSM;
+    }
 
+    std::vector<unsigned> permutation(n);
+    std::iota(std::begin(permutation), std::end(permutation), 0);
+    do {
+      minimalPermutationCSM = std::min(minimalPermutationCSM, calculatePermutationCSM(permutation.data()));
+    } while(std::next_permutation(std::begin(permutation), std::end(permutation)));
     return minimalPermutationCSM;
   };
 
   double value = 1000;
-  do {
-    // Handle case that all points are symmetrized
-    if(diophantineMultipliers.front() == 0) {
-      double allAxisSymmetrizedCSM = 0;
-      for(unsigned i = 0; i < P; ++i) {
-        allAxisSymmetrizedCSM += axisLine.squaredDistance(normalizedPositions.col(i));
-      }
-      allAxisSymmetrizedCSM /= P;
-      value = std::min(value, allAxisSymmetrizedCSM);
-      continue;
+  // Handle case that all points are symmetrized
+  if(enumeration->allSymmetrized) {
+    double allAxisSymmetrizedCSM = 0;
+    for(unsigned i = 0; i < P; ++i) {
+      allAxisSymmetrizedCSM += axisLine.squaredDistance(normalizedPositions.col(i));
     }
+    allAxisSymmetrizedCSM /= P;
+    value = std::min(value, allAxisSymmetrizedCSM);
+  }
 
-    std::vector<unsigned> partitionOrAxisSymmetrize;
-    partitionOrAxisSymmetrize.reserve(P);
-    partitionOrAxisSymmetrize.resize(rotation.n * diophantineMultipliers.front(), 0);
-    partitionOrAxisSymmetrize.resize(P, 1);
-
+  for(const auto& split : enumeration->splits) {
+    const unsigned partitioned = n * split.groups;
     double diophantineCSM = 1000;
-    do {
+    for(auto selection = std::begin(split.selections); selection != std::end(split.selections); selection += P) {
+      /* Axis symmetrize the points past the partitioned ones */
       double permutationCSM = 0;
-      /* Collect indices to partition, axis symmetrize the rest */
-      std::vector<unsigned> indicesToPartition;
-      for(unsigned i = 0; i < P; ++i) {
-        if(partitionOrAxisSymmetrize.at(i) == 0) {
-          indicesToPartition.push_back(i);
-        } else {
-          permutationCSM += axisLine.squaredDistance(normalizedPositions.col(i));
-        }
+      for(unsigned i = partitioned; i < P; ++i) {
+        permutationCSM += axisLine.squaredDistance(normalizedPositions.col(selection[i]));
       }
-      assert(!indicesToPartition.empty());
 
       /* Perform partitioning */
-      Partitioner partitioner {diophantineMultipliers.front(), rotation.n};
-      assert(diophantineMultipliers.front() * rotation.n == indicesToPartition.size());
       double bestPartitionCSM = 1000;
-      do {
+      for(auto partition = std::begin(split.partitions); partition != std::end(split.partitions); partition += partitioned) {
         double partitionCSM = 0;
-        for(auto&& partitionIndices : partitioner.partitions()) {
-          auto partitionParticleIndices = Temple::map(partitionIndices, Temple::Functor::at(indicesToPartition));
-          const double subpartitionCSM = calculateBestPermutationCSM(partitionParticleIndices);
-          partitionCSM += subpartitionCSM;
+        for(unsigned g = 0; g < split.groups; ++g) {
+          for(unsigned i = 0; i < n; ++i) {
+            particles[i] = selection[partition[g * n + i]];
+          }
+          partitionCSM += calculateBestPermutationCSM();
         }
-        partitionCSM /= diophantineMultipliers.front();
+        partitionCSM /= split.groups;
         bestPartitionCSM = std::min(bestPartitionCSM, partitionCSM);
-      } while(partitioner.next_partition());
-      permutationCSM += rotation.n * diophantineMultipliers.front() * bestPartitionCSM;
+      }
+      permutationCSM += partitioned * bestPartitionCSM;
       permutationCSM /= P;
       diophantineCSM = std::min(diophantineCSM, permutationCSM);
-    } while(std::next_permutation(std::begin(partitionOrAxisSymmetrize), std::end(partitionOrAxisSymmetrize)));
+    }
     value = std::min(value, diophantineCSM);
-  } while(Diophantine::next_solution(diophantineMultipliers, diophantineConstants, P));
+  }
 
   return 100 * value;
 }
@@ -333,12 +474,7 @@ double element(
   const Eigen::Matrix3d reflectMatrix = reflection.matrix();
   assert(reflectMatrix.inverse().isApprox(reflectMatrix, 1e-10));
 
-  const std::vector<unsigned> diophantineConstants {2, 1};
-  assert(Diophantine::has_solution(diophantineConstants, P));
-  std::vector<unsigned> diophantineMultipliers;
-  if(!Diophantine::first_solution(diophantineMultipliers, diophantineConstants, P)) {
-    throw std::logic_error("Diophantine failure! Couldn't find first solution");
-  }
+  const auto enumeration = elementEnumeration(P, 2);
 
   auto calculateReflectionCSM = [](
     const unsigned a,
@@ -355,61 +491,47 @@ double element(
   };
 
   double value = 1000;
-  do {
-    if(diophantineMultipliers.front() == 0) {
-      /* All points are symmetrized to the plane */
-      const double csm = Temple::sum(
-        Temple::Adaptors::transform(
-          Temple::Adaptors::range(P),
-          [&](const unsigned i) -> double {
-            return std::pow(plane.absDistance(normalizedPositions.col(i)), 2);
-          }
-        )
-      ) / P;
-      value = std::min(value, csm);
-      continue;
-    }
-
-    std::vector<unsigned> pairOrPlaneSymmetrize;
-    pairOrPlaneSymmetrize.reserve(P);
-    pairOrPlaneSymmetrize.resize(2 * diophantineMultipliers.front(), 0);
-    pairOrPlaneSymmetrize.resize(P, 1);
+  if(enumeration->allSymmetrized) {
+    /* All points are symmetrized to the plane */
+    const double csm = Temple::sum(
+      Temple::Adaptors::transform(
+        Temple::Adaptors::range(P),
+        [&](const unsigned i) -> double {
+          return std::pow(plane.absDistance(normalizedPositions.col(i)), 2);
+        }
+      )
+    ) / P;
+    value = std::min(value, csm);
+  }
 
+  for(const auto& split : enumeration->splits) {
+    const unsigned partitioned = 2 * split.groups;
     double diophantineCSM = 1000;
-    do {
+    for(auto selection = std::begin(split.selections); selection != std::end(split.selections); selection += P) {
+      /* Plane symmetrize the points past the partitioned ones */
       double permutationCSM = 0;
-      /* Collect indices to partition */
-      std::vector<unsigned> indicesToPartition;
-      for(unsigned i = 0; i < P; ++i) {
-        if(pairOrPlaneSymmetrize.at(i) == 0) {
-          indicesToPartition.push_back(i);
-        } else {
-          permutationCSM += std::pow(plane.absDistance(normalizedPositions.col(i)), 2);
-        }
+      for(unsigned i = partitioned; i < P; ++i) {
+        permutationCSM += std::pow(plane.absDistance(normalizedPositions.col(selection[i])), 2);
       }
 
       /* Perform partitioning into groups of size two */
-      Partitioner partitioner {diophantineMultipliers.front(), 2};
-      assert(diophantineMultipliers.front() * 2 == indicesToPartition.size());
       double bestPartitionCSM = 1000;
-      do {
+      for(auto partition = std::begin(split.partitions); partition != std::end(split.partitions); partition += partitioned) {
         double partitionCSM = 0;
-        for(auto&& partitionIndices : partitioner.partitions()) {
-          assert(partitionIndices.size() == 2);
-          const unsigned i = indicesToPartition.at(partitionIndices.front());
-          const unsigned j = indicesToPartition.at(partitionIndices.back());
-          const double subpartitionCSM = calculateReflectionCSM(i, j, reflectMatrix, normalizedPositions);
-          partitionCSM += subpartitionCSM;
+        for(unsigned g = 0; g < split.groups; ++g) {
+          const unsigned i = selection[partition[2 * g]];
+          const unsigned j = selection[partition[2 * g + 1]];
+          partitionCSM += calculateReflectionCSM(i, j, reflectMatrix, normalizedPositions);
         }
         partitionCSM /= 2;
         bestPartitionCSM = std::min(bestPartitionCSM, partitionCSM);
-      } while(partitioner.next_partition());
-      permutationCSM += 2 * diophantineMultipliers.front() * bestPartitionCSM;
+      }
+      permutationCSM += partitioned * bestPartitionCSM;
       permutationCSM /= P;
       diophantineCSM = std::min(diophantineCSM, permutationCSM);
-    } while(std::next_permutation(std::begin(pairOrPlaneSymmetrize), std::end(pairOrPlaneSymmetrize)));
+    }
     value = std::min(value, diophantineCSM);
-  } while(Diophantine::next_solution(diophantineMultipliers, diophantineConstants, P));
+  }
 
   return 100 * value;
 }
@@ -432,36 +554,68 @@ double Cinf(
 
 } // namespace Fixed
 
-std::pair<double, Elements::Rotation> element(
-  const PositionCollection& normalizedPositions,
-  Elements::Rotation rotation
+namespace Detail {
+
+struct NelderMeadChecker {
+  bool shouldContinue(unsigned iteration, double lowestValue, double stddev) const {
+    return iteration < 1000 && lowestValue > 1e-3 && stddev > 1e-4;
+  }
+};
+
+/**
+ * @brief Minimizes a function of a rotation, returning the minimal value and
+ *   the minimizing rotation
+ *
+ * A single start minimizes from the axis simplex. Multiple starts are
+ * minimized in parallel.
+ */
+template<typename Functor>
+std::pair<double, Eigen::Matrix3d> minimizeRotation(
+  Functor&& functor,
+  const unsigned starts
 ) {
   using MinimizerType = Temple::SO3NelderMead<>;
 
-  MinimizerType::Parameters simplex;
-  simplex.at(0) = Eigen::Matrix3d::Identity();
-  simplex.at(1) = Eigen::AngleAxisd(M_PI / 2, Eigen::Vector3d::UnitX()).toRotationMatrix();
-  simplex.at(2) = Eigen::AngleAxisd(M_PI / 2, Eigen::Vector3d::UnitY()).toRotationMatrix();
-  simplex.at(3) = Eigen::AngleAxisd(M_PI / 2, Eigen::Vector3d::UnitZ()).toRotationMatrix();
+  if(starts <= 1) {
+    MinimizerType::Parameters simplex = MinimizerType::axisParameters();
+    const auto result = MinimizerType::minimize(
+      simplex,
+      functor,
+      NelderMeadChecker {}
+    );
+    return {result.value, simplex.at(result.minimalIndex)};
+  }
 
-  struct NelderMeadChecker {
-    bool shouldContinue(unsigned iteration, double lowestValue, double stddev) const {
-      return iteration < 1000 && lowestValue > 1e-3 && stddev > 1e-4;
-    }
+  auto simplices = MinimizerType::multistartParameters(starts);
+  const auto multistart = MinimizerType::minimizeMultistart(
+    simplices,
+    functor,
+    NelderMeadChecker {}
+  );
+  return {
+    multistart.result.value,
+    simplices.at(multistart.start).at(multistart.result.minimalIndex)
   };
+}
 
-  auto minimizationResult = MinimizerType::minimize(
-    simplex,
+} // namespace Detail
+
+std::pair<double, Elements::Rotation> element(
+  const PositionCollection& normalizedPositions,
+  Elements::Rotation rotation,
+  const unsigned starts
+) {
+  const auto minimization = Detail::minimizeRotation(
     [&](const Eigen::Matrix3d& R) -> double {
       return Fixed::element(R * normalizedPositions, rotation);
     },
-    NelderMeadChecker {}
+    starts
   );
 
-  rotation.axis = simplex.at(minimizationResult.minimalIndex).inverse() * rotation.axis;
+  rotation.axis = minimization.second.inverse() * rotation.axis;
 
   return {
-    minimizationResult.value,
+    minimization.first,
     rotation
   };
 }
@@ -469,34 +623,20 @@ std::pair<double, Elements::Rotation> element(
 
 std::pair<double, Elements::Reflection> element(
   const PositionCollection& normalizedPositions,
-  Elements::Reflection reflection
+  Elements::Reflection reflection,
+  const unsigned starts
 ) {
-  using MinimizerType = Temple::SO3NelderMead<>;
-
-  MinimizerType::Parameters simplex;
-  simplex.at(0) = Eigen::Matrix3d::Identity();
-  simplex.at(1) = Eigen::AngleAxisd(M_PI / 2, Eigen::Vector3d::UnitX()).toRotationMatrix();
-  simplex.at(2) = Eigen::AngleAxisd(M_PI / 2, Eigen::Vector3d::UnitY()).toRotationMatrix();
-  simplex.at(3) = Eigen::AngleAxisd(M_PI / 2, Eigen::Vector3d::UnitZ()).toRotationMatrix();
-
-  struct NelderMeadChecker {
-    bool shouldContinue(unsigned iteration, double lowestValue, double stddev) const {
-      return iteration < 1000 && lowestValue > 1e-3 && stddev > 1e-4;
-    }
-  };
-
-  auto minimizationResult = MinimizerType::minimize(
-    simplex,
+  const auto minimization = Detail::minimizeRotation(
     [&](const Eigen::Matrix3d& R) -> double {
       return Fixed::element(R * normalizedPositions, reflection);
     },
-    NelderMeadChecker {}
+    starts
   );
 
   return {
-    minimizationResult.value,
+    minimization.first,
     Elements::Reflection {
-      simplex.at(minimizationResult.minimalIndex).inverse() * reflection.normal
+      minimization.second.inverse() * reflection.normal
     }
   };
 }
@@ -572,7 +712,7 @@ double element(
   return 100 * bestCSM / P;
 }
 
-double Cinf(const PositionCollection& normalizedPositions) {
+double Cinf(const PositionCollection& normalizedPositions, const unsigned starts) {
   struct Functor {
     const PositionCollection& coordinates;
     Functor(const PositionCollection& normalizedPositions) : coordinates(normalizedPositions) {}
@@ -582,30 +722,7 @@ double Cinf(const PositionCollection& normalizedPositions) {
     }
   };
 
-  Functor functor {normalizedPositions};
-
-  using MinimizerType = Temple::SO3NelderMead<>;
-
-  // Set up the initial simplex to capture asymmetric tops and x/y mixups
-  MinimizerType::Parameters simplex;
-  simplex.at(0) = Eigen::Matrix3d::Identity();
-  simplex.at(1) = Eigen::AngleAxisd(M_PI / 2, Eigen::Vector3d::UnitX()).toRotationMatrix();
-  simplex.at(2) = Eigen::AngleAxisd(M_PI / 2, Eigen::Vector3d::UnitY()).toRotationMatrix();
-  simplex.at(3) = Eigen::AngleAxisd(M_PI / 2, Eigen::Vector3d::UnitZ()).toRotationMatrix();
-
-  struct NelderMeadChecker {
-    bool shouldContinue(unsigned iteration, double lowestValue, double stddev) const {
-      return iteration < 1000 && lowestValue > 1e-3 && stddev > 1e-4;
-    }
-  };
-
-  auto minimizationResult = MinimizerType::minimize(
-    simplex,
-    functor,
-    NelderMeadChecker {}
-  );
-
-  return minimizationResult.value;
+  return Detail::minimizeRotation(Functor {normalizedPositions}, starts).first;
 }
 
 double calculateCSM(
@@ -758,17 +875,19 @@ struct OrientationCSMFunctor {
   using MatrixType = Eigen::Matrix<double, 3, Eigen::Dynamic>;
 
   const PositionCollection& coordinates;
-  const MatrixType unfoldMatrices;
-  const MatrixType foldMatrices;
-  const Elements::NpGroupingsMapType npGroups;
+  const MatrixType& unfoldMatrices;
+  const MatrixType& foldMatrices;
+  const Elements::NpGroupingsMapType& npGroups;
 
   OrientationCSMFunctor(
     const PositionCollection& normalizedPositions,
-    const PointGroup group
+    const MatrixType& unfold,
+    const MatrixType& fold,
+    const Elements::NpGroupingsMapType& groupings
   ) : coordinates(normalizedPositions),
-      unfoldMatrices(makeUnfoldMatrices(Elements::symmetryElements(group))),
-      foldMatrices(makeFoldMatrices(unfoldMatrices)),
-      npGroups(Elements::npGroupings(Elements::symmetryElements(group)))
+      unfoldMatrices(unfold),
+      foldMatrices(fold),
+      npGroups(groupings)
   {}
 
   static MatrixType makeUnfoldMatrices(const Elements::ElementsList& elements) {
@@ -980,22 +1099,33 @@ struct OrientationCSMFunctor {
   }
 };
 
-double pointGroup(
-  const PositionCollection& normalizedPositions,
-  const PointGroup group
-) {
-  assert(isNormalized(normalizedPositions));
-
-  // Special-case Cinfv
+PointGroupEvaluator::PointGroupEvaluator(
+  const PointGroup group,
+  const bool warmStart
+) : group_(group),
+    orientation_(Eigen::Matrix3d::Identity()),
+    warmStart_(warmStart)
+{
+  // Cinfv is special-cased and needs no symmetry elements
   if(group == PointGroup::Cinfv) {
-    return Cinf(normalizedPositions);
+    return;
   }
 
   const auto elements = Elements::symmetryElements(group);
-  const auto npGroups = npGroupings(elements);
+  G_ = elements.size();
+  unfoldMatrices_ = OrientationCSMFunctor::makeUnfoldMatrices(elements);
+  foldMatrices_ = OrientationCSMFunctor::makeFoldMatrices(unfoldMatrices_);
+  npGroups_ = Elements::npGroupings(elements);
+}
 
-  const unsigned G = elements.size();
-  const unsigned P = normalizedPositions.cols();
+void PointGroupEvaluator::reset() {
+  orientation_ = Eigen::Matrix3d::Identity();
+}
+
+void PointGroupEvaluator::checkParticleCount(const unsigned P) const {
+  if(group_ == PointGroup::Cinfv) {
+    return;
+  }
 
   /* There are conditions on when we can calculate a CSM for this number of
    * particles P and the particular point group with G symmetry elements.
@@ -1006,10 +1136,10 @@ double pointGroup(
   /* The sizes of groups that we can subdivide contains the full set only
    * if there are more particles than symmetry elements:
    */
-  if(P > G) {
-    subdivisionGroupSizes.push_back(G);
+  if(P > G_) {
+    subdivisionGroupSizes.push_back(G_);
   }
-  for(const auto& groupMapPair : npGroups) {
+  for(const auto& groupMapPair : npGroups_) {
     subdivisionGroupSizes.push_back(groupMapPair.first);
   }
   std::sort(
@@ -1021,36 +1151,210 @@ double pointGroup(
   if(!Diophantine::has_solution(subdivisionGroupSizes, P)) {
     throw std::logic_error("Cannot calculate a CSM for this number of points and this point group. This is most likely an implementation error.");
   }
+}
 
-  OrientationCSMFunctor functor {normalizedPositions, group};
+double PointGroupEvaluator::minimize(
+  const PositionCollection& normalizedPositions,
+  Eigen::Matrix3d& orientation
+) const {
+  assert(isNormalized(normalizedPositions));
 
-  using MinimizerType = Temple::SO3NelderMead<>;
-  // Set up the initial simplex to capture asymmetric tops and x/y mixups
-  MinimizerType::Parameters simplex;
-  simplex.at(0) = Eigen::Matrix3d::Identity();
-  simplex.at(1) = Eigen::AngleAxisd(M_PI / 2, Eigen::Vector3d::UnitX()).toRotationMatrix();
-  simplex.at(2) = Eigen::AngleAxisd(M_PI / 2, Eigen::Vector3d::UnitY()).toRotationMatrix();
-  simplex.at(3) = Eigen::AngleAxisd(M_PI / 2, Eigen::Vector3d::UnitZ()).toRotationMatrix();
-
-  struct NelderMeadChecker {
-    bool shouldContinue(unsigned iteration, double lowestValue, double stddev) const {
-      return iteration < 1000 && lowestValue > 1e-3 && stddev > 1e-4;
-    }
+  // Special-case Cinfv
+  if(group_ == PointGroup::Cinfv) {
+    return Cinf(normalizedPositions);
+  }
+
+  OrientationCSMFunctor functor {
+    normalizedPositions,
+    unfoldMatrices_,
+    foldMatrices_,
+    npGroups_
   };
 
+  /* If warm starting, a small simplex is centered on the previous optimal
+   * orientation if it improves upon the identity. The latter check keeps
+   * dissimilar successive structures from starting in a far-off local
+   * minimum. Otherwise, the initial simplex is set up to capture asymmetric
+   * tops and x/y mixups.
+   */
+  Eigen::Matrix3d base = Eigen::Matrix3d::Identity();
+  double angle = M_PI / 2;
+  if(warmStart_ && !orientation.isIdentity() && functor(orientation) < functor(base)) {
+    base = orientation;
+    angle = 0.1;
+  }
+
+  using MinimizerType = Temple::SO3NelderMead<>;
+  MinimizerType::Parameters simplex = MinimizerType::axisParameters(base, angle);
+
   auto minimizationResult = MinimizerType::minimize(
     simplex,
     functor,
-    NelderMeadChecker {}
+    Detail::NelderMeadChecker {}
   );
 
+  orientation = simplex.at(minimizationResult.minimalIndex);
   return minimizationResult.value;
 }
 
+double PointGroupEvaluator::operator() (const PositionCollection& normalizedPositions) {
+  checkParticleCount(normalizedPositions.cols());
+  return minimize(normalizedPositions, orientation_);
+}
+
+std::vector<double> PointGroupEvaluator::operator() (
+  const std::vector<PositionCollection>& normalizedPositionsList
+) {
+  // Check sizes up front, exceptions cannot leave the parallel region
+  for(const PositionCollection& positions : normalizedPositionsList) {
+    checkParticleCount(positions.cols());
+  }
+
+  const int N = normalizedPositionsList.size();
+  std::vector<double> values(N);
+
+  /* Static scheduling hands each thread a contiguous range of structures so
+   * that each warm starts from its predecessor in the list
+   */
+  Eigen::Matrix3d lastOrientation = orientation_;
+#pragma omp parallel
+  {
+    Eigen::Matrix3d orientation = orientation_;
+#pragma omp for schedule(static)
+    for(int i = 0; i < N; ++i) {
+      values[i] = minimize(normalizedPositionsList[i], orientation);
+      if(i == N - 1) {
+        lastOrientation = orientation;
+      }
+    }
+  }
+
+  // Continue from the last structure's optimum
+  orientation_ = lastOrientation;
+  return values;
+}
+
+double pointGroup(
+  const PositionCollection& normalizedPositions,
+  const PointGroup group
+) {
+  return PointGroupEvaluator {group, false}(normalizedPositions);
+}
+
+/* Index mappings that differ only by a rotation of the shape are equivalent
+ * for continuous shape measures. Of each orbit of vertex sequences under the
+ * shape's rotation group, only the lexicographically smallest needs to be
+ * considered: A sequence is the smallest of its orbit if each of its vertices
+ * is the smallest of its orbit under the subgroup fixing all preceding
+ * vertices. Vertices beyond the shape's size (i.e. the centroid) are fixed by
+ * all rotations.
+ */
+inline Vertex rotationImage(const std::vector<Vertex>& rotation, const Vertex v) {
+  if(v < rotation.size()) {
+    return rotation[v];
+  }
+
+  return v;
+}
+
+template<typename F>
+void forEachOrbitRepresentativeImpl(
+  const std::vector<std::vector<Vertex>>& group,
+  const std::vector<unsigned>& stabilizer,
+  std::vector<Vertex>& sequence,
+  std::vector<bool>& used,
+  const unsigned count,
+  F& f
+) {
+  if(sequence.size() == count) {
+    f(sequence);
+    return;
+  }
+
+  const unsigned N = used.size();
+  std::vector<unsigned> subStabilizer;
+  subStabilizer.reserve(stabilizer.size());
+  for(Vertex v {0}; v < N; ++v) {
+    if(used[v]) {
+      continue;
+    }
+
+    const bool smallestOfOrbit = Temple::all_of(
+      stabilizer,
+      [&](const unsigned g) { return rotationImage(group[g], v) >= v; }
+    );
+    if(!smallestOfOrbit) {
+      continue;
+    }
+
+    subStabilizer.clear();
+    for(const unsigned g : stabilizer) {
+      if(rotationImage(group[g], v) == v) {
+        subStabilizer.push_back(g);
+      }
+    }
+
+    used[v] = true;
+    sequence.push_back(v);
+    forEachOrbitRepresentativeImpl(group, subStabilizer, sequence, used, count, f);
+    sequence.pop_back();
+    used[v] = false;
+  }
+}
+
+/*! @brief Calls a function with one sequence of count distinct vertices in
+ *   [0, N) per orbit under the shape's rotations
+ *
+ * Reduces an enumeration over all sequences by up to the order of the shape's
+ * rotation group.
+ */
+template<typename F>
+void forEachOrbitRepresentative(
+  const Shape shape,
+  const unsigned count,
+  const unsigned N,
+  F&& f
+) {
+  assert(count <= N);
+  const auto& group = rotationGroup(shape);
+  std::vector<Vertex> sequence;
+  sequence.reserve(count);
+  std::vector<bool> used(N, false);
+  forEachOrbitRepresentativeImpl(
+    group,
+    Temple::iota<unsigned>(group.size()),
+    sequence,
+    used,
+    count,
+    f
+  );
+}
+
+/*! @brief Images of an index mapping under all rotations of a shape
+ *
+ * Shape vertex coordinates are not exactly symmetric, so mappings of the same
+ * orbit can have very slightly different fits.
+ */
+std::vector<std::vector<Vertex>> rotationalImages(
+  const Shape shape,
+  const std::vector<Vertex>& mapping
+) {
+  return Temple::map(
+    rotationGroup(shape),
+    [&](const std::vector<Vertex>& rotation) {
+      return Temple::map(
+        mapping,
+        [&](const Vertex v) { return rotationImage(rotation, v); }
+      );
+    }
+  );
+}
+
 ShapeResult shapeFaithfulPaperImplementation(
   const PositionCollection& normalizedPositions,
   const Shape shape
 ) {
+  const Molassembler::Detail::Metrics::Timer timer {Molassembler::Detail::Metrics::Operation::ShapeMeasure};
   assert(isNormalized(normalizedPositions));
   const unsigned N = normalizedPositions.cols();
 
@@ -1058,8 +1362,6 @@ ShapeResult shapeFaithfulPaperImplementation(
     throw std::logic_error("Mismatched number of positions between supplied coordinates and shape!");
   }
 
-  auto permutation = Temple::iota<Vertex>(N);
-
   // Add the origin
   Matrix shapeCoordinates(3, N);
   shapeCoordinates.block(0, 0, 3, N - 1) = coordinates(shape);
@@ -1074,8 +1376,7 @@ ShapeResult shapeFaithfulPaperImplementation(
 
   Eigen::Matrix<double, 3, Eigen::Dynamic> permutedShape(3, N);
   std::vector<Vertex> bestPermutation;
-  Eigen::Matrix3d bestRotationMatrix;
-  do {
+  auto evaluate = [&](const std::vector<Vertex>& permutation) {
     // Construct a permuted shape positions matrix
     for(unsigned i = 0; i < N; ++i) {
       permutedShape.col(i) = shapeCoordinates.col(permutation.at(i));
@@ -1099,7 +1400,13 @@ ShapeResult shapeFaithfulPaperImplementation(
       permutationalMinimum = scalingMinimizationResult.second;
       bestPermutation = permutation;
     }
-  } while(std::next_permutation(std::begin(permutation), std::end(permutation)));
+  };
+
+  // Only one permutation per orbit under the shape's rotations needs fitting
+  forEachOrbitRepresentative(shape, N, N, evaluate);
+  for(const auto& image : rotationalImages(shape, bestPermutation)) {
+    evaluate(image);
+  }
 
   const double normalization = normalizedPositions.colwise().squaredNorm().sum();
   return {
@@ -1110,11 +1417,289 @@ ShapeResult shapeFaithfulPaperImplementation(
 
 namespace Detail {
 
-template<typename EndFunctor>
-ShapeResult shapeAlternateImplementationBase(
-  const PositionCollection& normalizedPositions,
-  const Shape shape,
-  EndFunctor&& endFunctor
+//! Normalized shape coordinates with origin, shared between mapping searches
+struct ShapeReference {
+  explicit ShapeReference(const Shape passShape) : shape(passShape) {
+    const unsigned N = size(shape) + 1;
+    // Add the origin
+    coordinates.resize(3, N);
+    coordinates.block(0, 0, 3, N - 1) = Shapes::coordinates(shape);
+    coordinates.col(N - 1) = Eigen::Vector3d::Zero();
+    // Normalize the coordinates
+    coordinates = normalize(coordinates);
+
+    vertexOrder = Temple::iota<Vertex>(N);
+    Temple::sort(
+      vertexOrder,
+      [&](const Vertex a, const Vertex b) {
+        return coordinates.col(a).squaredNorm() > coordinates.col(b).squaredNorm();
+      }
+    );
+
+    squaredNorm = coordinates.colwise().squaredNorm().sum();
+  }
+
+  Shape shape;
+  Matrix coordinates;
+  //! Vertices in order of decreasing norm
+  std::vector<Vertex> vertexOrder;
+  double squaredNorm;
+};
+
+//! List of bounded size on the stack
+template<typename T, int N>
+class BoundedList {
+public:
+  void reserve(unsigned /* size */) {}
+
+  template<typename ... Args>
+  void emplace_back(Args&& ... args) {
+    assert(count_ < N);
+    items_[count_] = T {std::forward<Args>(args)...};
+    ++count_;
+  }
+
+  T* begin() { return items_.data(); }
+  T* end() { return items_.data() + count_; }
+
+private:
+  std::array<T, N> items_;
+  unsigned count_ = 0;
+};
+
+/*! @brief Storage of the mapping search, heap-allocated for a dynamic number
+ *   of positions
+ */
+template<int N>
+struct MappingStorage {
+  using Positions = Eigen::Matrix<double, 3, N>;
+  using Vertices = std::array<Vertex, N>;
+  using Flags = std::array<bool, N>;
+  template<typename T> using List = BoundedList<T, N>;
+
+  static Vertices vertices(const unsigned /* size */, const Vertex fill) {
+    Vertices v;
+    v.fill(fill);
+    return v;
+  }
+
+  static Flags flags(const unsigned /* size */) {
+    Flags f;
+    f.fill(false);
+    return f;
+  }
+};
+
+template<>
+struct MappingStorage<Eigen::Dynamic> {
+  using Positions = PositionCollection;
+  using Vertices = std::vector<Vertex>;
+  using Flags = std::vector<bool>;
+  template<typename T> using List = std::vector<T>;
+
+  static Vertices vertices(const unsigned size, const Vertex fill) {
+    return Vertices(size, fill);
+  }
+
+  static Flags flags(const unsigned size) {
+    return Flags(size, false);
+  }
+};
+
+/**
+ * @brief Exact minimization of the rotational fit residual over all index
+ *   mappings by branch and bound
+ *
+ * Positions are mapped one at a time, in order of decreasing norm. For a
+ * partial mapping with cross-covariance @math{H_p = \sum x_i y_{\sigma(i)}^T},
+ * the residual of any completion after rotation is bounded from below by
+ *
+ * @math{\sum |x|^2 + \sum |y|^2 - 2 (\|H_p\|_* + \sum_{rem} |x_i| |y_{\sigma(i)}|)},
+ *
+ * since the nuclear norm of the full cross-covariance matrix bounds the
+ * trace achievable by any rotation and each remaining rank-one term
+ * contributes at most the product of its norms. The remaining norm products
+ * are maximal when sorted norms are paired. Partial mappings whose bound
+ * exceeds the best residual found so far are pruned.
+ *
+ * @tparam N Number of positions, or Eigen::Dynamic. A fixed number of
+ *   positions keeps the search free of heap allocations.
+ */
+template<int N = Eigen::Dynamic>
+class MappingSearch {
+public:
+  using Storage = MappingStorage<N>;
+  using Positions = typename Storage::Positions;
+  using Vertices = typename Storage::Vertices;
+
+  MappingSearch(
+    const Positions& positions,
+    const ShapeReference& reference,
+    const bool fixLast
+  ) : positions_(positions),
+      shape_(reference.coordinates),
+      vertexOrder_(reference.vertexOrder),
+      N_(positions.cols()),
+      P_(N_ - (fixLast ? 1 : 0)),
+      fixLast_(fixLast),
+      positionOrder_(Storage::vertices(N_, Vertex(N_))),
+      mapping_(Storage::vertices(N_, Vertex(N_))),
+      used_(Storage::flags(N_)),
+      bestMapping_(Storage::vertices(N_, Vertex(N_)))
+  {
+    for(unsigned i = 0; i < P_; ++i) {
+      positionOrder_[i] = Vertex(i);
+    }
+    std::sort(
+      std::begin(positionOrder_),
+      std::begin(positionOrder_) + P_,
+      [&](const Vertex a, const Vertex b) {
+        return positions_.col(a).squaredNorm() > positions_.col(b).squaredNorm();
+      }
+    );
+    squaredNormSum_ = positions_.colwise().squaredNorm().sum() + reference.squaredNorm;
+
+    Eigen::Matrix3d H = Eigen::Matrix3d::Zero();
+    if(fixLast_) {
+      const Vertex last {N_ - 1};
+      mapping_[last] = last;
+      used_[last] = true;
+      H = positions_.col(last) * shape_.col(last).transpose();
+    }
+
+    search(0, H);
+  }
+
+  const Vertices& bestMapping() const {
+    return bestMapping_;
+  }
+
+  const Eigen::Matrix3d& bestRotation() const {
+    return bestRotation_;
+  }
+
+private:
+  using Child = std::tuple<double, Vertex, Eigen::Matrix3d>;
+
+  const Positions& positions_;
+  const Matrix& shape_;
+  //! Shape vertices in order of decreasing norm
+  const std::vector<Vertex>& vertexOrder_;
+  const unsigned N_;
+  //! Number of positions to map
+  const unsigned P_;
+  const bool fixLast_;
+  //! Positions in order of mapping
+  Vertices positionOrder_;
+  double squaredNormSum_;
+
+  Vertices mapping_;
+  typename Storage::Flags used_;
+
+  double bestResidual_ = std::numeric_limits<double>::max();
+  Vertices bestMapping_;
+  Eigen::Matrix3d bestRotation_;
+
+  double lowerBound(const Eigen::Matrix3d& H, const unsigned depth) const {
+    double trace = Eigen::JacobiSVD<Eigen::Matrix3d>(H).singularValues().sum();
+
+    // Pair remaining position and unused vertex norms in order
+    unsigned remaining = depth;
+    for(const Vertex j : vertexOrder_) {
+      if(remaining == P_) {
+        break;
+      }
+
+      if(!used_[j]) {
+        trace += positions_.col(positionOrder_[remaining]).norm() * shape_.col(j).norm();
+        ++remaining;
+      }
+    }
+
+    return squaredNormSum_ - 2 * trace;
+  }
+
+  void leaf() {
+    Positions permutedShape(3, N_);
+    for(unsigned i = 0; i < N_; ++i) {
+      permutedShape.col(i) = shape_.col(mapping_[i]);
+    }
+
+    const Eigen::Matrix3d R = fitQuaternion(positions_, permutedShape);
+    const double residual = (positions_ - R * permutedShape).colwise().squaredNorm().sum();
+    if(residual < bestResidual_) {
+      bestResidual_ = residual;
+      bestMapping_ = mapping_;
+      bestRotation_ = R;
+    }
+  }
+
+  void search(const unsigned depth, const Eigen::Matrix3d& H) {
+    if(depth == P_) {
+      leaf();
+      return;
+    }
+
+    const Vertex i = positionOrder_[depth];
+
+    // Bound all children and descend into the most promising first
+    typename Storage::template List<Child> children;
+    children.reserve(N_ - depth);
+    for(const Vertex j : vertexOrder_) {
+      if(used_[j]) {
+        continue;
+      }
+
+      Eigen::Matrix3d childH = H + positions_.col(i) * shape_.col(j).transpose();
+      used_[j] = true;
+      const double bound = lowerBound(childH, depth + 1);
+      used_[j] = false;
+      if(bound < bestResidual_) {
+        children.emplace_back(bound, j, std::move(childH));
+      }
+    }
+
+    // Stable insertion sort, few children and no temporary buffer
+    for(auto it = std::begin(children); it != std::end(children); ++it) {
+      std::rotate(
+        std::upper_bound(
+          std::begin(children),
+          it,
+          *it,
+          [](const Child& a, const Child& b) {
+            return std::get<0>(a) < std::get<0>(b);
+          }
+        ),
+        it,
+        it + 1
+      );
+    }
+
+    for(const auto& child : children) {
+      if(std::get<0>(child) >= bestResidual_) {
+        break;
+      }
+
+      const Vertex j = std::get<1>(child);
+      mapping_[i] = j;
+      used_[j] = true;
+      search(depth + 1, std::get<2>(child));
+      used_[j] = false;
+    }
+    mapping_[i] = Vertex(N_);
+  }
+};
+
+/*! @brief Minimizes the continuous shape measure over index mappings,
+ *   rotation and scaling
+ *
+ * @returns The best index mapping and the continuous shape measure
+ */
+template<int N>
+std::pair<typename MappingStorage<N>::Vertices, double> shapeMeasure(
+  const typename MappingStorage<N>::Positions& normalizedPositions,
+  const ShapeReference& reference,
+  const bool fixLast
 ) {
   /* There is a bit of a conundrum: The paper says
    * - For each index mapping
@@ -1135,52 +1720,25 @@ ShapeResult shapeAlternateImplementationBase(
    *
    * So here we speed up the faithful implementation by minimizing over rotation,
    * remembering the best rotation matrix and minimizing over scaling outside
-   * of the permutational loop
+   * of the permutational search. Instead of enumerating all index mappings,
+   * the search over mappings is a branch and bound.
    */
+  const Molassembler::Detail::Metrics::Timer timer {Molassembler::Detail::Metrics::Operation::ShapeMeasure};
 
-  assert(isNormalized(normalizedPositions));
-  const unsigned N = normalizedPositions.cols();
+  const unsigned P = normalizedPositions.cols();
 
-  if(N != size(shape) + 1) {
+  if(P != size(reference.shape) + 1) {
     throw std::logic_error("Mismatched number of positions between supplied coordinates and shape!");
   }
 
-  auto permutation = Temple::iota<Vertex>(N);
-
-  // Add the origin
-  Matrix shapeCoordinates(3, N);
-  shapeCoordinates.block(0, 0, 3, N - 1) = coordinates(shape);
-  shapeCoordinates.col(N - 1) = Eigen::Vector3d::Zero();
-  // Normalize the coordinates
-  shapeCoordinates = normalize(shapeCoordinates);
-
-  double permutationalMinimum = std::numeric_limits<double>::max();
-
-  Eigen::Matrix<double, 3, Eigen::Dynamic> permutedShape(3, N);
-  std::vector<Vertex> bestPermutation;
-  Eigen::Matrix3d bestRotationMatrix;
-  do {
-    // Construct a permuted shape positions matrix
-    for(unsigned i = 0; i < N; ++i) {
-      permutedShape.col(i) = shapeCoordinates.col(permutation.at(i));
-    }
-
-    // Perform a quaternion fit
-    auto rotationMatrix = fitQuaternion(normalizedPositions, permutedShape);
-    permutedShape = rotationMatrix * permutedShape;
-
-    const double value = (normalizedPositions - permutedShape).colwise().squaredNorm().sum();
-    if(value < permutationalMinimum) {
-      bestPermutation = permutation;
-      permutationalMinimum = value;
-      bestRotationMatrix = rotationMatrix;
-    }
-  } while(std::next_permutation(std::begin(permutation), endFunctor(permutation)));
+  const MappingSearch<N> search {normalizedPositions, reference, fixLast};
+  const auto& bestPermutation = search.bestMapping();
 
-  for(unsigned i = 0; i < N; ++i) {
-    permutedShape.col(i) = shapeCoordinates.col(bestPermutation.at(i));
+  typename MappingStorage<N>::Positions permutedShape(3, P);
+  for(unsigned i = 0; i < P; ++i) {
+    permutedShape.col(i) = reference.coordinates.col(bestPermutation[i]);
   }
-  permutedShape = bestRotationMatrix * permutedShape;
+  permutedShape = search.bestRotation() * permutedShape;
 
   constexpr double scalingLowerBound = 0.5;
   constexpr double scalingUpperBound = 1.1;
@@ -1202,20 +1760,27 @@ ShapeResult shapeAlternateImplementationBase(
   };
 }
 
-struct EndIter {
-  template<typename T>
-  auto operator() (T& t) {
-    return std::end(t);
-  }
-};
+ShapeResult shapeAlternateImplementationBase(
+  const PositionCollection& normalizedPositions,
+  const ShapeReference& reference,
+  const bool fixLast
+) {
+  assert(isNormalized(normalizedPositions));
+  auto result = shapeMeasure<Eigen::Dynamic>(normalizedPositions, reference, fixLast);
+  return {
+    std::move(result.first),
+    result.second
+  };
+}
 
-struct BackIter {
-  template<typename T>
-  auto operator() (T& t) {
-    assert(!t.empty());
-    return --std::end(t);
-  }
-};
+//! Shape references of all shapes, prepared on first use
+const ShapeReference& cachedReference(const Shape shape) {
+  static const auto references = Temple::map(
+    allShapes,
+    [](const Shape s) { return ShapeReference {s}; }
+  );
+  return references.at(nameIndex(shape));
+}
 
 } // namespace Detail
 
@@ -1225,8 +1790,8 @@ ShapeResult shapeAlternateImplementation(
 ) {
   return Detail::shapeAlternateImplementationBase(
     normalizedPositions,
-    shape,
-    Detail::EndIter {}
+    Detail::ShapeReference {shape},
+    false
   );
 }
 
@@ -1236,8 +1801,8 @@ ShapeResult shapeAlternateImplementationCentroidLast(
 ) {
   return Detail::shapeAlternateImplementationBase(
     normalizedPositions,
-    shape,
-    Detail::BackIter {}
+    Detail::ShapeReference {shape},
+    true
   );
 }
 
@@ -1313,10 +1878,44 @@ NarrowType shapeHeuristicsNarrow(
   return {energy, permutation};
 }
 
+/*! @brief Selects the image of a mapping under the shape's rotations with the
+ *   best rotational fit
+ *
+ * @returns The fitted shape coordinates permuted by the selected image, which
+ *   is written into @p mapping
+ */
+PositionCollection bestRotationalImage(
+  const PositionCollection& normalizedPositions,
+  const PositionCollection& shapeCoords,
+  const Shape shape,
+  std::vector<Vertex>& mapping
+) {
+  const unsigned N = normalizedPositions.cols();
+  PositionCollection permutedShape(3, N);
+  PositionCollection bestShape;
+  double bestPenalty = std::numeric_limits<double>::max();
+  for(auto& image : rotationalImages(shape, mapping)) {
+    for(unsigned i = 0; i < N; ++i) {
+      permutedShape.col(i) = shapeCoords.col(image.at(i));
+    }
+    auto R = fitQuaternion(normalizedPositions, permutedShape);
+    permutedShape = R * permutedShape;
+    const double penalty = (normalizedPositions - permutedShape).colwise().squaredNorm().sum();
+    if(penalty < bestPenalty) {
+      bestPenalty = penalty;
+      bestShape = permutedShape;
+      mapping = std::move(image);
+    }
+  }
+
+  return bestShape;
+}
+
 ShapeResult shapeHeuristics(
   const PositionCollection& normalizedPositions,
   const Shape shape
 ) {
+  const Molassembler::Detail::Metrics::Timer timer {Molassembler::Detail::Metrics::Operation::ShapeMeasure};
   /* Heuristics employed:
    *
    * - Minimize over the rotation first, then take that solution and minimize
@@ -1338,9 +1937,9 @@ ShapeResult shapeHeuristics(
    * later is not well-converged and the minimal solution is not the shortest
    * cost path through the graph.
    *
-   * Further optimization opportunities
-   * - Variant with rotation memory (divides number of quaternion fits by the
-   *   number of rotations of the iota permutation in the shape)
+   * Five-position combinations that differ only by a rotation of the shape
+   * are equivalent, so only one combination per orbit is fitted, dividing the
+   * number of quaternion fits by up to the number of rotations of the shape.
    */
 
   const unsigned N = normalizedPositions.cols();
@@ -1358,8 +1957,13 @@ ShapeResult shapeHeuristics(
   NarrowType minimalNarrow {std::numeric_limits<double>::max(), {}};
   PartialMapping permutation;
 
-  // i != j != k != l != m with {i, j, k, l, m} in [0, N)
-  Temple::Loops::different(
+  /* i != j != k != l != m with {i, j, k, l, m} in [0, N), one
+   * combination per orbit under the shape's rotations
+   */
+  forEachOrbitRepresentative(
+    shape,
+    5,
+    N,
     [&](const std::vector<Vertex>& vertices) {
       permutation.clear();
       for(unsigned i = 0; i < 5; ++i) {
@@ -1418,9 +2022,7 @@ ShapeResult shapeHeuristics(
       if(narrowed.first < minimalNarrow.first) {
         minimalNarrow = narrowed;
       }
-    },
-    5,
-    Vertex {N}
+    }
   );
 
   /* Given the best permutation for the rotational fit, we still have to
@@ -1434,12 +2036,12 @@ ShapeResult shapeHeuristics(
     bestPermutation.at(iterPair.first) = iterPair.second;
   }
 
-  PositionCollection permutedShape(3, N);
-  for(unsigned i = 0; i < N; ++i) {
-    permutedShape.col(i) = shapeCoords.col(bestPermutation.at(i));
-  }
-  auto R = fitQuaternion(normalizedPositions, permutedShape);
-  permutedShape = R * permutedShape;
+  PositionCollection permutedShape = bestRotationalImage(
+    normalizedPositions,
+    shapeCoords,
+    shape,
+    bestPermutation
+  );
 
   constexpr double scalingLowerBound = 0.5;
   constexpr double scalingUpperBound = 1.1;
@@ -1463,6 +2065,7 @@ ShapeResult shapeHeuristicsCentroidLast(
   const PositionCollection& normalizedPositions,
   const Shape shape
 ) {
+  const Molassembler::Detail::Metrics::Timer timer {Molassembler::Detail::Metrics::Operation::ShapeMeasure};
   /* Same as shapeHeuristics, except we know two things:
    *
    * The centroid mapping is known, so the centroid index is unavailable in
@@ -1486,8 +2089,13 @@ ShapeResult shapeHeuristicsCentroidLast(
   NarrowType minimalNarrow {std::numeric_limits<double>::max(), {}};
   PartialMapping permutation;
 
-  // i != j != k != l != m with {i, j, k, l, m} in [0, N - 1)
-  Temple::Loops::different(
+  /* i != j != k != l != m with {i, j, k, l, m} in [0, N - 1), one
+   * combination per orbit under the shape's rotations
+   */
+  forEachOrbitRepresentative(
+    shape,
+    5,
+    N - 1,
     [&](const std::vector<Vertex>& vertices) {
       permutation.clear();
       permutation.emplace(N - 1, N - 1);
@@ -1548,9 +2156,7 @@ ShapeResult shapeHeuristicsCentroidLast(
       if(narrowed.first < minimalNarrow.first) {
         minimalNarrow = narrowed;
       }
-    },
-    5,
-    Vertex {N - 1}
+    }
   );
 
   /* Given the best permutation for the rotational fit, we still have to
@@ -1564,12 +2170,12 @@ ShapeResult shapeHeuristicsCentroidLast(
     bestPermutation.at(iterPair.first) = iterPair.second;
   }
 
-  PositionCollection permutedShape(3, N);
-  for(unsigned i = 0; i < N; ++i) {
-    permutedShape.col(i) = shapeCoords.col(bestPermutation.at(i));
-  }
-  auto R = fitQuaternion(normalizedPositions, permutedShape);
-  permutedShape = R * permutedShape;
+  PositionCollection permutedShape = bestRotationalImage(
+    normalizedPositions,
+    shapeCoords,
+    shape,
+    bestPermutation
+  );
 
   constexpr double scalingLowerBound = 0.5;
   constexpr double scalingUpperBound = 1.1;
@@ -1594,17 +2200,6 @@ ShapeResult shape(
   const PositionCollection& normalizedPositions,
   const Shape shape
 ) {
-#ifdef NDEBUG
-  // In release builds, use heuristics starting from size 9
-  constexpr unsigned minSizeForHeuristics = 8;
-#else
-  // In debug builds, use heuristics starting from size 6
-  constexpr unsigned minSizeForHeuristics = 6;
-#endif
-  if(size(shape) >= minSizeForHeuristics) {
-    return shapeHeuristics(normalizedPositions, shape);
-  }
-
   return shapeAlternateImplementation(normalizedPositions, shape);
 }
 
@@ -1612,18 +2207,212 @@ ShapeResult shapeCentroidLast(
   const PositionCollection& normalizedPositions,
   const Shape shape
 ) {
-#ifdef NDEBUG
-  // In release builds, use heuristics starting from size 8
-  constexpr unsigned minSizeForHeuristics = 8;
-#else
-  // In debug builds, use heuristics starting from size 6
-  constexpr unsigned minSizeForHeuristics = 6;
-#endif
-  if(size(shape) >= minSizeForHeuristics) {
-    return shapeHeuristicsCentroidLast(normalizedPositions, shape);
+  return shapeAlternateImplementationCentroidLast(normalizedPositions, shape);
+}
+
+std::vector<std::vector<ShapeResult>> shapeCentroidLast(
+  const std::vector<PositionCollection>& normalizedPositionsList,
+  const std::vector<Shape>& shapes
+) {
+  const unsigned P = normalizedPositionsList.size();
+  const unsigned S = shapes.size();
+
+  // Check sizes up front, exceptions cannot leave the parallel region
+  for(const PositionCollection& positions : normalizedPositionsList) {
+    for(const Shape shape : shapes) {
+      if(positions.cols() != size(shape) + 1) {
+        throw std::logic_error("Mismatched number of positions between supplied coordinates and shape!");
+      }
+    }
   }
 
-  return shapeAlternateImplementationCentroidLast(normalizedPositions, shape);
+  // Prepare each shape's coordinates once for all position sets
+  const auto references = Temple::map(
+    shapes,
+    [](const Shape shape) { return Detail::ShapeReference {shape}; }
+  );
+
+  std::vector<std::vector<ShapeResult>> results(P, std::vector<ShapeResult>(S));
+
+  Parallel::forEach(P * S, [&](const unsigned k, unsigned /* worker */) {
+    const unsigned i = k / S;
+    const unsigned j = k % S;
+    results[i][j] = Detail::shapeAlternateImplementationBase(
+      normalizedPositionsList[i],
+      references[j],
+      true
+    );
+  });
+
+  return results;
+}
+
+template<unsigned S>
+FixedShapeResult<S> shapeCentroidLast(
+  const FixedPositionCollection<S>& normalizedPositions,
+  const Shape shape
+) {
+  const auto result = Detail::shapeMeasure<S + 1>(
+    normalizedPositions,
+    Detail::cachedReference(shape),
+    true
+  );
+  return {result.first, result.second};
+}
+
+template<unsigned S>
+std::pair<Shape, FixedShapeResult<S>> classifyCentroidLast(
+  const FixedPositionCollection<S>& normalizedPositions
+) {
+  std::pair<Shape, FixedShapeResult<S>> best;
+  best.second.measure = std::numeric_limits<double>::max();
+  for(const Shape shape : allShapes) {
+    if(size(shape) != S) {
+      continue;
+    }
+
+    const auto result = shapeCentroidLast<S>(normalizedPositions, shape);
+    if(result.measure < best.second.measure) {
+      best = {shape, result};
+    }
+  }
+  return best;
+}
+
+template MASM_EXPORT FixedShapeResult<2> shapeCentroidLast<2>(const FixedPositionCollection<2>&, Shape);
+template MASM_EXPORT FixedShapeResult<3> shapeCentroidLast<3>(const FixedPositionCollection<3>&, Shape);
+template MASM_EXPORT FixedShapeResult<4> shapeCentroidLast<4>(const FixedPositionCollection<4>&, Shape);
+template MASM_EXPORT FixedShapeResult<5> shapeCentroidLast<5>(const FixedPositionCollection<5>&, Shape);
+template MASM_EXPORT FixedShapeResult<6> shapeCentroidLast<6>(const FixedPositionCollection<6>&, Shape);
+template MASM_EXPORT FixedShapeResult<7> shapeCentroidLast<7>(const FixedPositionCollection<7>&, Shape);
+template MASM_EXPORT FixedShapeResult<8> shapeCentroidLast<8>(const FixedPositionCollection<8>&, Shape);
+template MASM_EXPORT FixedShapeResult<9> shapeCentroidLast<9>(const FixedPositionCollection<9>&, Shape);
+template MASM_EXPORT FixedShapeResult<10> shapeCentroidLast<10>(const FixedPositionCollection<10>&, Shape);
+template MASM_EXPORT FixedShapeResult<11> shapeCentroidLast<11>(const FixedPositionCollection<11>&, Shape);
+template MASM_EXPORT FixedShapeResult<12> shapeCentroidLast<12>(const FixedPositionCollection<12>&, Shape);
+
+template MASM_EXPORT std::pair<Shape, FixedShapeResult<2>> classifyCentroidLast<2>(const FixedPositionCollection<2>&);
+template MASM_EXPORT std::pair<Shape, FixedShapeResult<3>> classifyCentroidLast<3>(const FixedPositionCollection<3>&);
+template MASM_EXPORT std::pair<Shape, FixedShapeResult<4>> classifyCentroidLast<4>(const FixedPositionCollection<4>&);
+template MASM_EXPORT std::pair<Shape, FixedShapeResult<5>> classifyCentroidLast<5>(const FixedPositionCollection<5>&);
+template MASM_EXPORT std::pair<Shape, FixedShapeResult<6>> classifyCentroidLast<6>(const FixedPositionCollection<6>&);
+template MASM_EXPORT std::pair<Shape, FixedShapeResult<7>> classifyCentroidLast<7>(const FixedPositionCollection<7>&);
+template MASM_EXPORT std::pair<Shape, FixedShapeResult<8>> classifyCentroidLast<8>(const FixedPositionCollection<8>&);
+template MASM_EXPORT std::pair<Shape, FixedShapeResult<9>> classifyCentroidLast<9>(const FixedPositionCollection<9>&);
+template MASM_EXPORT std::pair<Shape, FixedShapeResult<10>> classifyCentroidLast<10>(const FixedPositionCollection<10>&);
+template MASM_EXPORT std::pair<Shape, FixedShapeResult<11>> classifyCentroidLast<11>(const FixedPositionCollection<11>&);
+template MASM_EXPORT std::pair<Shape, FixedShapeResult<12>> classifyCentroidLast<12>(const FixedPositionCollection<12>&);
+
+namespace Detail {
+
+//! Angular fingerprint of a shape's idealized coordinates
+std::vector<double> referenceFingerprint(const Shape shape) {
+  const unsigned S = size(shape);
+  PositionCollection positions(3, S + 1);
+  positions.block(0, 0, 3, S) = coordinates(shape);
+  positions.col(S) = Eigen::Vector3d::Zero();
+  return angularFingerprint(positions);
+}
+
+const std::vector<double>& referenceFingerprintCached(const Shape shape) {
+  static const auto fingerprints = Temple::map(allShapes, referenceFingerprint);
+  return fingerprints.at(nameIndex(shape));
+}
+
+} // namespace Detail
+
+std::vector<double> angularFingerprint(const PositionCollection& positions) {
+  const unsigned S = positions.cols() - 1;
+  std::vector<double> fingerprint;
+  fingerprint.reserve(S * (S - 1) / 2);
+  for(unsigned i = 0; i < S; ++i) {
+    const Eigen::Vector3d a = positions.col(i) - positions.col(S);
+    for(unsigned j = i + 1; j < S; ++j) {
+      const Eigen::Vector3d b = positions.col(j) - positions.col(S);
+      const double cosine = a.dot(b) / (a.norm() * b.norm());
+      fingerprint.push_back(std::acos(Temple::Stl17::clamp(cosine, -1.0, 1.0)));
+    }
+  }
+  std::sort(std::begin(fingerprint), std::end(fingerprint));
+  return fingerprint;
+}
+
+double fingerprintDistance(const PositionCollection& positions, const Shape shape) {
+  if(positions.cols() != size(shape) + 1) {
+    throw std::logic_error("Mismatched number of positions between supplied coordinates and shape!");
+  }
+
+  const auto fingerprint = angularFingerprint(positions);
+  const auto& reference = Detail::referenceFingerprintCached(shape);
+  assert(fingerprint.size() == reference.size());
+  if(fingerprint.empty()) {
+    return 0;
+  }
+
+  double sum = 0;
+  for(unsigned i = 0; i < fingerprint.size(); ++i) {
+    const double difference = fingerprint[i] - reference[i];
+    sum += difference * difference;
+  }
+  return std::sqrt(sum / fingerprint.size());
+}
+
+std::vector<Shape> shapeCandidates(
+  const PositionCollection& positions,
+  const std::vector<Shape>& shapes,
+  const unsigned count,
+  const double margin
+) {
+  using DistancePair = std::pair<double, Shape>;
+  auto distances = Temple::map(
+    shapes,
+    [&](const Shape shape) -> DistancePair {
+      return {fingerprintDistance(positions, shape), shape};
+    }
+  );
+  std::stable_sort(
+    std::begin(distances),
+    std::end(distances),
+    [](const DistancePair& a, const DistancePair& b) -> bool {
+      return a.first < b.first;
+    }
+  );
+
+  /* Keep only the closest shapes unless any discarded shape is not clearly
+   * worse than the closest shape
+   */
+  unsigned kept = std::max(count, 1u);
+  if(kept < distances.size() && distances.at(kept).first < distances.front().first + margin) {
+    kept = distances.size();
+  }
+  distances.resize(std::min<std::size_t>(kept, distances.size()));
+
+  return Temple::map(distances, [](const DistancePair& p) { return p.second; });
+}
+
+std::pair<Shape, ShapeResult> classifyApproximate(
+  const PositionCollection& normalizedPositions,
+  const std::vector<Shape>& shapes,
+  const unsigned count,
+  const double margin
+) {
+  if(shapes.empty()) {
+    throw std::logic_error("No shapes to classify against!");
+  }
+
+  const auto candidates = shapeCandidates(normalizedPositions, shapes, count, margin);
+  auto results = std::move(
+    shapeCentroidLast({normalizedPositions}, candidates).front()
+  );
+  const auto minElementIter = std::min_element(
+    std::begin(results),
+    std::end(results),
+    [](const ShapeResult& a, const ShapeResult& b) -> bool {
+      return a.measure < b.measure;
+    }
+  );
+  const unsigned minimalIndex = minElementIter - std::begin(results);
+  return {candidates.at(minimalIndex), std::move(*minElementIter)};
 }
 
 double minimumDistortionAngle(const Shape a, const Shape b) {
@@ -1631,15 +2420,31 @@ double minimumDistortionAngle(const Shape a, const Shape b) {
     throw std::logic_error("Shapes are not of identical size!");
   }
 
+  if(a == b) {
+    return 0;
+  }
+
+  /* Calculated angles are published lock-free. Since distinct shapes have
+   * nonzero distortion angles, zero marks an angle yet to be calculated.
+   */
+  static std::array<std::atomic<double>, nShapes * nShapes> angles {};
+  std::atomic<double>& slot = angles.at(nameIndex(a) * nShapes + nameIndex(b));
+  const double cached = slot.load(std::memory_order_acquire);
+  if(cached > 0) {
+    return cached;
+  }
+
   // Add origin to shape b's coordinates
   const unsigned S = size(b);
   PositionCollection p (3, S + 1);
   p.block(0, 0, 3, S) = coordinates(b);
   p.col(S) = Eigen::Vector3d::Zero();
 
-  return std::asin(
+  const double angle = std::asin(
     std::sqrt(shape(normalize(p), a).measure) / 10
   );
+  slot.store(angle, std::memory_order_release);
+  return angle;
 }
 
 double minimalDistortionPathDeviation(
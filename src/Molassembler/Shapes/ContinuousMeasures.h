@@ -78,19 +78,31 @@ MASM_EXPORT double Cinf(
 /**
  * @brief Optimizes the axis of a rotational symmetry element and calculates the
  *   continuous symmetry measure
+ *
+ * @param normalizedPositions Particle positions
+ * @param rotation Symmetry element of rotation
+ * @param starts Number of starting orientations of the axis optimization.
+ *   Multiple starts are minimized in parallel and help avoid local minima.
  */
 MASM_EXPORT std::pair<double, Elements::Rotation> element(
   const PositionCollection& normalizedPositions,
-  Elements::Rotation rotation
+  Elements::Rotation rotation,
+  unsigned starts = 1
 );
 
 /**
  * @brief Optimizes the norm of a reflection symmetry element and calculates the
  *   continuous symmetry measure
+ *
+ * @param normalizedPositions Particle positions
+ * @param reflection Symmetry element of reflection
+ * @param starts Number of starting orientations of the norm optimization,
+ *   minimized in parallel
  */
 MASM_EXPORT std::pair<double, Elements::Reflection> element(
   const PositionCollection& normalizedPositions,
-  Elements::Reflection reflection
+  Elements::Reflection reflection,
+  unsigned starts = 1
 );
 
 /*! @brief Calculates the CSM for centroid inversion
@@ -103,8 +115,12 @@ MASM_EXPORT double element(
 );
 
 /*! @brief Calculates the continuous symmetry measure for an infinite order rotation axis
+ *
+ * @param normalizedPositions Particle positions
+ * @param starts Number of starting orientations of the axis optimization,
+ *   minimized in parallel
  */
-MASM_EXPORT double Cinf(const PositionCollection& normalizedPositions);
+MASM_EXPORT double Cinf(const PositionCollection& normalizedPositions, unsigned starts = 1);
 
 /** @brief Calculates the continuous symmetry measure for a set of particles
  *   and a particular point group
@@ -117,6 +133,9 @@ MASM_EXPORT double Cinf(const PositionCollection& normalizedPositions);
  * a local minimum. Not very performant either, it would be better with
  * quaternions instead of rotation matrices.
  *
+ * @note To calculate measures of many structures for the same point group,
+ *   prefer PointGroupEvaluator.
+ *
  * @return The continuous symmetry measure
  */
 MASM_EXPORT double pointGroup(
@@ -124,6 +143,81 @@ MASM_EXPORT double pointGroup(
   PointGroup pointGroup
 );
 
+/** @brief Reusable continuous symmetry measure calculation for a particular
+ *   point group
+ *
+ * Prepares the point group's symmetry element matrices and groupings once
+ * for any number of structures. Optionally warm starts the minimization over
+ * orientations from the optimal orientation of the previous structure, which
+ * is useful for scanning similar structures, e.g. frames of a trajectory.
+ *
+ * @note Warm starting makes results dependent on the order of evaluation.
+ */
+class MASM_EXPORT PointGroupEvaluator {
+public:
+  /*! @brief Prepares the symmetry elements of a point group
+   *
+   * @param group Point group to calculate continuous symmetry measures for
+   * @param warmStart Whether to start from a small simplex around the
+   *   previous structure's optimal orientation if it is better than the
+   *   identity
+   */
+  explicit PointGroupEvaluator(PointGroup group, bool warmStart = true);
+
+  /*! @brief Calculates the continuous symmetry measure of a structure
+   *
+   * @param normalizedPositions Normalized particle positions
+   *
+   * @throws std::logic_error If no CSM can be calculated for the number of
+   *   particles in this point group
+   *
+   * @return The continuous symmetry measure
+   */
+  double operator() (const PositionCollection& normalizedPositions);
+
+  /*! @brief Calculates continuous symmetry measures of many structures in
+   *   parallel
+   *
+   * Each thread calculates a contiguous range of structures, warm starting
+   * from its predecessors if enabled.
+   *
+   * @throws std::logic_error If no CSM can be calculated for the number of
+   *   particles of any structure in this point group
+   *
+   * @return The continuous symmetry measures, in order
+   */
+  std::vector<double> operator() (const std::vector<PositionCollection>& normalizedPositionsList);
+
+  //! Point group measures are calculated for
+  inline PointGroup group() const {
+    return group_;
+  }
+
+  //! Optimal orientation of the last calculated structure
+  inline const Eigen::Matrix3d& orientation() const {
+    return orientation_;
+  }
+
+  //! Discard the warm start orientation
+  void reset();
+
+private:
+  void checkParticleCount(unsigned P) const;
+
+  double minimize(
+    const PositionCollection& normalizedPositions,
+    Eigen::Matrix3d& orientation
+  ) const;
+
+  PointGroup group_;
+  unsigned G_ = 0;
+  Eigen::Matrix<double, 3, Eigen::Dynamic> unfoldMatrices_;
+  Eigen::Matrix<double, 3, Eigen::Dynamic> foldMatrices_;
+  Elements::NpGroupingsMapType npGroups_;
+  Eigen::Matrix3d orientation_;
+  bool warmStart_;
+};
+
 //! Result of a continuous shape measure calculation
 struct MASM_EXPORT ShapeResult {
   //! Lowest value mapping from position indices to shape indices
@@ -165,9 +259,18 @@ MASM_EXPORT ShapeResult shapeFaithfulPaperImplementation(
  *
  * and is hence faster. Gives the same results.
  *
+ * Instead of enumerating all index mappings, positions are mapped one at a
+ * time and partial mappings are pruned by a lower bound on the rotational fit
+ * residual of any of their completions: The optimal residual of the mapped
+ * positions plus the residual of the remaining norms paired in order.
+ *
  * @param normalizedPositions
  * @param shape
  *
+ * @complexity{Worst case @math{O(N!)}, but typically few quaternion fits
+ * for positions that are close to the shape. Remains practical for all shapes
+ * of size 12 even for random positions.}
+ *
  * @return
  */
 MASM_EXPORT ShapeResult shapeAlternateImplementation(
@@ -193,8 +296,9 @@ MASM_EXPORT ShapeResult shapeAlternateImplementationCentroidLast(
  * then greedily choose the best next sequence alignments until all positions
  * are matched.
  *
- * Judgement of accuracy / speed tradeoff is that this is worth using from size
- * 6 onwards in debug builds and from size 9 onwards in release builds.
+ * Since shapeAlternateImplementation() prunes its search over index mappings,
+ * it is faster than this function for all shapes and this function is no
+ * longer used by shape().
  *
  * @param normalizedPositions set of coordinates to compare with the shape
  * @param shape Reference shape to compare against
@@ -225,10 +329,7 @@ MASM_EXPORT ShapeResult shapeHeuristicsCentroidLast(
 /**
  * @brief Forwarding function to calculate the continuous shape measure
  *
- * Forwards its call to shapeAlternateImplementation() by default. In debug
- * builds, forwards its call to shapeHeuristics() from shape size 6 onwards. In
- * release builds, forwards its call to shapeHeuristics() from shape size 9
- * onwards.
+ * Forwards its call to shapeAlternateImplementation() for all shape sizes.
  */
 MASM_EXPORT ShapeResult shape(
   const PositionCollection& normalizedPositions,
@@ -241,16 +342,188 @@ MASM_EXPORT ShapeResult shapeCentroidLast(
   Shape shape
 );
 
+/**
+ * @brief Calculates continuous shape measures of many position sets with
+ *   respect to several shapes, with set centroid mapping
+ *
+ * Each shape's normalized coordinates are prepared once for all position
+ * sets, and the calculations are distributed over threads. Useful for
+ * interpreting many coordination sites of equal size at once, e.g. over
+ * frames of a trajectory.
+ *
+ * @param normalizedPositionsList Normalized position sets, each with the
+ *   centroid as last position
+ * @param shapes Shapes to compare against, all of the size of the position
+ *   sets minus one
+ *
+ * @complexity{One shapeCentroidLast() calculation per pair of position set
+ * and shape}
+ * @throws std::logic_error If the size of any position set does not match
+ *   the size of any shape plus one
+ *
+ * @returns Results indexed by position set, then by shape
+ */
+MASM_EXPORT std::vector<std::vector<ShapeResult>> shapeCentroidLast(
+  const std::vector<PositionCollection>& normalizedPositionsList,
+  const std::vector<Shape>& shapes
+);
+
+//! Positions of a shape of size S and its centroid as last position
+template<unsigned S>
+using FixedPositionCollection = Eigen::Matrix<double, 3, S + 1>;
+
+//! Result of a continuous shape measure calculation for a shape of size S
+template<unsigned S>
+struct FixedShapeResult {
+  //! Lowest value mapping from position indices to shape indices
+  std::array<Vertex, S + 1> mapping;
+  //! Continuous shape measure value
+  double measure;
+};
+
+/*! @brief Normalize positions for continuous shape measure analysis without
+ *   heap allocations
+ *
+ * @see normalize()
+ */
+template<unsigned S>
+FixedPositionCollection<S> normalize(const FixedPositionCollection<S>& positions) {
+  const Eigen::Vector3d center = positions.rowwise().sum() / positions.cols();
+  FixedPositionCollection<S> transformed = positions.colwise() - center;
+  transformed /= std::sqrt(transformed.colwise().squaredNorm().maxCoeff());
+  return transformed;
+}
+
+/**
+ * @brief Same as shapeCentroidLast(), except without heap allocations
+ *
+ * Shape coordinates are prepared once for all shapes on first call.
+ * Instantiated for all shape sizes.
+ *
+ * @tparam S Size of the shape
+ * @param normalizedPositions Normalized positions with the centroid as last
+ *   position
+ * @param shape Shape of size @p S to compare against
+ *
+ * @throws std::logic_error If the size of @p shape is not @p S
+ */
+template<unsigned S>
+MASM_EXPORT FixedShapeResult<S> shapeCentroidLast(
+  const FixedPositionCollection<S>& normalizedPositions,
+  Shape shape
+);
+
+/**
+ * @brief Determines the shape of size S with minimal continuous shape
+ *   measure without heap allocations
+ *
+ * @tparam S Size of the shape
+ * @param normalizedPositions Normalized positions with the centroid as last
+ *   position
+ *
+ * @complexity{One shapeCentroidLast() calculation per shape of size @p S}
+ *
+ * @returns The shape with minimal continuous shape measure and its shape
+ *   measure result
+ */
+template<unsigned S>
+MASM_EXPORT std::pair<Shape, FixedShapeResult<S>> classifyCentroidLast(
+  const FixedPositionCollection<S>& normalizedPositions
+);
+
+/**
+ * @brief Sorted angles in radians between all pairs of non-centroid positions
+ *   with respect to the centroid
+ *
+ * The fingerprint is invariant to rotation and to permutation of the
+ * positions, so comparing it against the fingerprint of a shape requires no
+ * index mapping search.
+ *
+ * @param positions Positions with the centroid as last position
+ *
+ * @complexity{@math{\Theta(S^2 \log S)} where @math{S} is the number of
+ * non-centroid positions}
+ */
+MASM_EXPORT std::vector<double> angularFingerprint(const PositionCollection& positions);
+
+/**
+ * @brief Root mean square deviation in radians of the angular fingerprint of
+ *   positions from that of a shape's idealized coordinates
+ *
+ * @param positions Positions with the centroid as last position
+ * @param shape Shape to compare against
+ *
+ * @complexity{@math{\Theta(S^2 \log S)}}
+ * @throws std::logic_error If the number of positions does not match the
+ *   size of the shape plus one
+ */
+MASM_EXPORT double fingerprintDistance(const PositionCollection& positions, Shape shape);
+
+/**
+ * @brief Prunes shapes to those whose angular fingerprints are closest to the
+ *   positions'
+ *
+ * @param positions Positions with the centroid as last position
+ * @param shapes Shapes to choose from, all of the size of the positions minus
+ *   one
+ * @param count Number of closest shapes to keep
+ * @param margin Confidence margin in radians. If any discarded shape's
+ *   fingerprint distance is within this margin of the closest shape's, the
+ *   fingerprints are not conclusive and all shapes are kept.
+ *
+ * @complexity{One fingerprintDistance() call per shape}
+ * @returns Kept shapes, ordered by increasing fingerprint distance
+ */
+MASM_EXPORT std::vector<Shape> shapeCandidates(
+  const PositionCollection& positions,
+  const std::vector<Shape>& shapes,
+  unsigned count = 3,
+  double margin = 0.05
+);
+
+/**
+ * @brief Classifies positions as the shape with minimal continuous shape
+ *   measure, calculating measures only for the candidates from
+ *   shapeCandidates()
+ *
+ * Faster than calculating shape measures for all shapes if only the winning
+ * shape is of interest. If the fingerprints are not conclusive within the
+ * margin, all shapes are considered, so the result equals that of the exact
+ * calculation.
+ *
+ * @param normalizedPositions Normalized positions with the centroid as last
+ *   position
+ * @param shapes Shapes to choose from, all of the size of the positions minus
+ *   one
+ * @param count Number of shapes to calculate shape measures for
+ * @param margin Confidence margin in radians, see shapeCandidates()
+ *
+ * @complexity{One shapeCentroidLast() calculation per candidate shape}
+ * @throws std::logic_error If @p shapes is empty or sizes do not match
+ *
+ * @returns The shape with minimal continuous shape measure among the
+ *   candidates and its shape measure result
+ */
+MASM_EXPORT std::pair<Shape, ShapeResult> classifyApproximate(
+  const PositionCollection& normalizedPositions,
+  const std::vector<Shape>& shapes,
+  unsigned count = 3,
+  double margin = 0.05
+);
+
 /*! @brief Calculates minimum distortion angle in radians for shapes A and B
  *
  * Calculates @math{\theta_AB} in:
  *
  * @math{k_XY = \sqrt{\textrm{CShM}A_(B)} = \sqrt{\textrm{CShM}B_(A)} = 10 \sin(\theta_AB)}
  *
+ * Angles are calculated on first use for each pair of shapes and cached.
+ *
  * @warning This function calls shape(), where heuristics are used for
  * particular shape sizes.
  *
- * @complexity{One continuous shape calculation.}
+ * @complexity{One continuous shape calculation on first use,
+ * @math{\Theta(1)} afterwards.}
  */
 MASM_EXPORT double minimumDistortionAngle(Shape a, Shape b);
 
@@ -281,7 +554,8 @@ MASM_EXPORT double minimalDistortionPathDeviation(
 
 /*! @overload
  *
- * @complexity{Three continuous shape calculations.}
+ * @complexity{Two continuous shape calculations, plus one on first use of
+ * the pair of shapes.}
  */
 MASM_EXPORT double minimalDistortionPathDeviation(const PositionCollection& positions, Shape a, Shape b);
 
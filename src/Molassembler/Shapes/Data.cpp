@@ -6,11 +6,20 @@
 
 #include "Molassembler/Shapes/Data.h"
 
-#include "Molassembler/Shapes/constexpr/Data.h"
 #include "boost/optional.hpp"
+
+#ifdef MOLASSEMBLER_EMBEDDED_SHAPES
+#include "Molassembler/Temple/OnceTable.h"
+
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#else
+#include "Molassembler/Shapes/constexpr/Data.h"
 #include "Molassembler/Temple/constexpr/TupleType.h"
 
 #include <unordered_map>
+#endif
 
 namespace Scine {
 namespace Molassembler {
@@ -26,10 +35,135 @@ struct ShapeInformation {
   const Permutation mirror;
   const PointGroup pointGroup;
   bool threeDimensional;
+#ifdef MOLASSEMBLER_EMBEDDED_SHAPES
+  //! Angles between all pairs of vertices, row-major
+  std::vector<double> angles;
+#endif
 
   EIGEN_MAKE_ALIGNED_OPERATOR_NEW
 };
 
+#ifdef MOLASSEMBLER_EMBEDDED_SHAPES
+namespace Detail {
+
+/* Shape data in the format described below, generated at build time from the
+ * constexpr shape classes and compiled into the library separately
+ */
+extern const unsigned char embeddedShapes[];
+extern const std::size_t embeddedShapesSize;
+
+} // namespace Detail
+
+namespace {
+
+/* Binary shape data layout, in native byte order:
+ * - Magic bytes, the number of shapes (uint32) and the offset of each
+ *   shape's record from the start of the data (uint32 each)
+ * - Per shape record: name length (uint32) and characters, size, point group
+ *   (uint32), whether three-dimensional (uint8), coordinates (3 x size
+ *   doubles, column-major), number of rotations (uint32) and their vertices
+ *   (uint8), number of tetrahedra (uint32) and their vertices (uint8, with
+ *   the centroid as 0xff), mirror length (uint32) and its vertices (uint8),
+ *   and the angles between all vertex pairs (size x size doubles, row-major)
+ *
+ * Records are decoded only once their shape is first accessed, so untouched
+ * shapes' pages of the data are never read.
+ */
+constexpr std::array<char, 8> shapesDataMagic {{'M', 'A', 'S', 'M', 'S', 'H', 'P', '1'}};
+constexpr std::uint8_t centroidPlaceholder = 0xff;
+
+template<typename T>
+T readBinary(const char*& cursor, const char* end) {
+  if(end - cursor < static_cast<std::ptrdiff_t>(sizeof(T))) {
+    throw std::runtime_error("Embedded shape data is truncated");
+  }
+
+  T value;
+  std::memcpy(&value, cursor, sizeof(T));
+  cursor += sizeof(T);
+  return value;
+}
+
+ShapeInformation decodeShapeInformation(const unsigned shapeIndex) {
+  const char* const data = reinterpret_cast<const char*>(Detail::embeddedShapes);
+  const char* const end = data + Detail::embeddedShapesSize;
+  const char* cursor = data;
+
+  for(const char c : shapesDataMagic) {
+    if(readBinary<char>(cursor, end) != c) {
+      throw std::runtime_error("Embedded data is not shape data");
+    }
+  }
+
+  if(readBinary<std::uint32_t>(cursor, end) != nShapes) {
+    throw std::runtime_error("Embedded shape data is for a different set of shapes");
+  }
+
+  cursor += shapeIndex * sizeof(std::uint32_t);
+  cursor = data + readBinary<std::uint32_t>(cursor, end);
+
+  const unsigned nameLength = readBinary<std::uint32_t>(cursor, end);
+  if(end - cursor < static_cast<std::ptrdiff_t>(nameLength)) {
+    throw std::runtime_error("Embedded shape data is truncated");
+  }
+  std::string stringName(cursor, nameLength);
+  cursor += nameLength;
+
+  const unsigned S = readBinary<std::uint32_t>(cursor, end);
+  const auto group = static_cast<PointGroup>(readBinary<std::uint32_t>(cursor, end));
+  const bool threeDimensional = readBinary<std::uint8_t>(cursor, end) > 0;
+
+  Coordinates coordinates(3, S);
+  for(unsigned i = 0; i < 3 * S; ++i) {
+    coordinates.data()[i] = readBinary<double>(cursor, end);
+  }
+
+  const auto readPermutation = [&](const unsigned length) {
+    Permutation permutation;
+    permutation.reserve(length);
+    for(unsigned i = 0; i < length; ++i) {
+      permutation.emplace_back(readBinary<std::uint8_t>(cursor, end));
+    }
+    return permutation;
+  };
+
+  RotationsList rotations(readBinary<std::uint32_t>(cursor, end));
+  for(auto& rotation : rotations) {
+    rotation = readPermutation(S);
+  }
+
+  TetrahedronList tetrahedra(readBinary<std::uint32_t>(cursor, end));
+  for(auto& tetrahedron : tetrahedra) {
+    for(auto& vertexOption : tetrahedron) {
+      const std::uint8_t vertex = readBinary<std::uint8_t>(cursor, end);
+      if(vertex != centroidPlaceholder) {
+        vertexOption = Vertex(vertex);
+      }
+    }
+  }
+
+  Permutation mirror = readPermutation(readBinary<std::uint32_t>(cursor, end));
+
+  std::vector<double> angles(S * S);
+  for(double& angle : angles) {
+    angle = readBinary<double>(cursor, end);
+  }
+
+  return ShapeInformation {
+    std::move(stringName),
+    S,
+    std::move(rotations),
+    std::move(tetrahedra),
+    std::move(coordinates),
+    std::move(mirror),
+    group,
+    threeDimensional,
+    std::move(angles)
+  };
+}
+
+} // namespace
+#else
 //! Map type used to store shape information structs
 using ShapeDataMapType = std::unordered_map<
   Shape,
@@ -258,20 +392,49 @@ const ShapeDataMapType& shapeData() {
 
   return dataMap;
 }
+#endif
+
+namespace {
+
+//! Dynamic information of a shape
+const ShapeInformation& information(const Shape shape) {
+#ifdef MOLASSEMBLER_EMBEDDED_SHAPES
+  static Temple::OnceTable<ShapeInformation, nShapes> table;
+  const auto shapeIndex = static_cast<unsigned>(shape);
+  if(const auto* cached = table.get(shapeIndex)) {
+    return *cached;
+  }
+
+  return table.publish(shapeIndex, decodeShapeInformation(shapeIndex));
+#else
+  return shapeData().at(shape);
+#endif
+}
+
+} // namespace
 
 AngleFunction angleFunction(const Shape shape) {
+#ifdef MOLASSEMBLER_EMBEDDED_SHAPES
+  const ShapeInformation& shapeInformation = information(shape);
+  const unsigned S = shapeInformation.size;
+  const double* const angles = shapeInformation.angles.data();
+  return [S, angles](const Vertex a, const Vertex b) {
+    return angles[a * S + b];
+  };
+#else
   auto shapeIndex = static_cast<unsigned>(shape);
   return [shapeIndex](const Vertex a, const Vertex b) {
     return Data::angleFunctions.at(shapeIndex)(a, b);
   };
+#endif
 }
 
 Coordinates coordinates(const Shape shape) {
-  return shapeData().at(shape).coordinates;
+  return information(shape).coordinates;
 }
 
 std::string spaceFreeName(const Shape shape) {
-  std::string toModify = shapeData().at(shape).stringName;
+  std::string toModify = information(shape).stringName;
 
   std::replace(
     toModify.begin(),
@@ -292,7 +455,7 @@ unsigned nameIndex(const Shape shape) {
 }
 
 const std::string& name(const Shape shape) {
-  return shapeData().at(shape).stringName;
+  return information(shape).stringName;
 }
 
 /*! @brief Fetch the shape name from its string
@@ -302,7 +465,7 @@ const std::string& name(const Shape shape) {
  */
 Shape nameFromString(const std::string& shapeNameString) {
   for(const Shape shape : allShapes) {
-    if(shapeData().at(shape).stringName == shapeNameString) {
+    if(information(shape).stringName == shapeNameString) {
       return shape;
     }
   }
@@ -311,27 +474,49 @@ Shape nameFromString(const std::string& shapeNameString) {
 }
 
 unsigned size(const Shape shape) {
-  return shapeData().at(shape).size;
+  return information(shape).size;
+}
+
+const std::vector<Shape>& shapesOfSize(const unsigned shapeSize) {
+  // Shapes are grouped by size on first use
+  static const std::vector<std::vector<Shape>> shapesBySize = []() {
+    std::vector<std::vector<Shape>> groups;
+    for(const Shape shape : allShapes) {
+      const unsigned S = size(shape);
+      if(S >= groups.size()) {
+        groups.resize(S + 1);
+      }
+      groups[S].push_back(shape);
+    }
+    return groups;
+  }();
+  static const std::vector<Shape> noShapes;
+
+  if(shapeSize >= shapesBySize.size()) {
+    return noShapes;
+  }
+
+  return shapesBySize[shapeSize];
 }
 
 const RotationsList& rotations(const Shape shape) {
-  return shapeData().at(shape).rotations;
+  return information(shape).rotations;
 }
 
 const Permutation& mirror(const Shape shape) {
-  return shapeData().at(shape).mirror;
+  return information(shape).mirror;
 }
 
 PointGroup pointGroup(const Shape shape) {
-  return shapeData().at(shape).pointGroup;
+  return information(shape).pointGroup;
 }
 
 const TetrahedronList& tetrahedra(const Shape shape) {
-  return shapeData().at(shape).tetrahedra;
+  return information(shape).tetrahedra;
 }
 
 bool threeDimensional(const Shape shape) {
-  return shapeData().at(shape).threeDimensional;
+  return information(shape).threeDimensional;
 }
 
 } // namespace Shapes
@@ -104,6 +104,12 @@ MASM_EXPORT std::string spaceFreeName(Shape shape);
  */
 MASM_EXPORT unsigned size(Shape shape);
 
+/*! @brief Fetch all shapes with a number of vertices in order of allShapes
+ *
+ * @complexity{@math{\Theta(1)}}
+ */
+MASM_EXPORT const std::vector<Shape>& shapesOfSize(unsigned shapeSize);
+
 /*! @brief Fetches a shape's list of rotations
  *
  * @complexity{@math{\Theta(1)}}
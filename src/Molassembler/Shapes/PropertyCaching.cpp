@@ -6,9 +6,17 @@
 
 #include "Molassembler/Shapes/PropertyCaching.h"
 
+#include "boost/interprocess/file_mapping.hpp"
+#include "boost/interprocess/mapped_region.hpp"
+
 #include "Molassembler/Temple/constexpr/ToStl.h"
 #include "Molassembler/Temple/constexpr/TupleTypePairs.h"
 #include "Molassembler/Temple/Functional.h"
+#include "Molassembler/Temple/OnceTable.h"
+
+#include <cstring>
+#include <fstream>
+#include <memory>
 
 namespace Scine {
 namespace Molassembler {
@@ -55,10 +63,138 @@ constexpr Temple::UpperTriangularMatrix<
 );
 #endif
 
-Temple::MinimalCache<
-  std::tuple<Shape, Shape, boost::optional<unsigned>>,
-  Properties::ShapeTransitionGroup
-> mappingsCache;
+#ifdef MOLASSEMBLER_EMBEDDED_TRANSITIONS
+namespace Detail {
+
+/* Transitions data in the format of writeMappings(), generated at build time
+ * and compiled into the library separately
+ */
+extern const unsigned char embeddedTransitions[];
+extern const std::size_t embeddedTransitionsSize;
+
+} // namespace Detail
+#endif
+
+namespace {
+
+//! Number of distinct removed vertex states, including none
+constexpr unsigned removedVertexStates = ConstexprProperties::maxShapeSize + 1;
+constexpr std::size_t mappingsTableSize = nShapes * nShapes * removedVertexStates;
+
+Temple::OnceTable<Properties::ShapeTransitionGroup, mappingsTableSize> mappingsTable;
+
+std::size_t mappingIndex(
+  const Shape a,
+  const Shape b,
+  const boost::optional<Vertex>& removedIndexOption
+) {
+  return (
+    (static_cast<unsigned>(a) * nShapes + static_cast<unsigned>(b)) * removedVertexStates
+    + (removedIndexOption ? removedIndexOption.value() + 1 : 0)
+  );
+}
+
+Properties::ShapeTransitionGroup calculateMapping(
+  const Shape a,
+  const Shape b,
+  const boost::optional<Vertex>& removedIndexOption
+) {
+  if(Shapes::size(b) + 1 == Shapes::size(a)) {
+    // Deletion case (always dynamic)
+    return Properties::selectBestTransitionMappings(
+      Properties::ligandLossTransitionMappings(a, b, removedIndexOption.value())
+    );
+  }
+
+#ifdef USE_CONSTEXPR_TRANSITION_MAPPINGS
+  /* Is the desired mapping in the generated list of mappings?
+   * It can be that allMappings contains only a limited set of mappings!
+   *
+   * WARNING: this assumes that the enum containing the names of symmetries has
+   * the same order as the tuple specifying all (or some) symmetry data types
+   * used at compile-time to generate allMappings
+   */
+  auto& constexprOption = allMappings.at(
+    std::min(
+      static_cast<unsigned>(a),
+      static_cast<unsigned>(b)
+    ),
+    std::max(
+      static_cast<unsigned>(a),
+      static_cast<unsigned>(b)
+    )
+  );
+
+  if(constexprOption.hasValue()) {
+    const auto& constexprMappings = constexprOption.value();
+
+    Properties::ShapeTransitionGroup stlResult;
+    stlResult.indexMappings = Temple::map(
+      Temple::toSTL(constexprMappings.mappings),
+      [&](const auto& indexList) -> std::vector<Vertex> {
+        std::vector<Vertex> v;
+        for(unsigned i : indexList) {
+          v.emplace_back(i);
+        }
+        return v;
+      }
+    );
+
+    stlResult.angularDistortion = constexprMappings.angularDistortion;
+    stlResult.chiralDistortion = constexprMappings.chiralDistortion;
+    return stlResult;
+  }
+#endif
+
+  // Calculate dynamically (relevant for targets of size 9 and higher)
+  return Properties::selectBestTransitionMappings(
+    Properties::shapeTransitionMappings(a, b)
+  );
+}
+
+/* Binary transitions file layout, in native byte order:
+ * - Magic bytes, the number of shapes and removed vertex states, and the
+ *   number of entries (all uint32)
+ * - Per entry: mapping table index (uint32), angular and chiral distortion
+ *   (double), number of index mappings and their length (uint32), followed by
+ *   the index mappings' vertices (uint8)
+ */
+constexpr std::array<char, 8> mappingsFileMagic {{'M', 'A', 'S', 'M', 'S', 'T', 'G', '1'}};
+
+template<typename T>
+void writeBinary(std::ostream& os, const T value) {
+  os.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template<typename T>
+T readBinary(const char*& cursor, const char* end) {
+  if(end - cursor < static_cast<std::ptrdiff_t>(sizeof(T))) {
+    throw std::runtime_error("Shape transitions data is truncated");
+  }
+
+  T value;
+  std::memcpy(&value, cursor, sizeof(T));
+  cursor += sizeof(T);
+  return value;
+}
+
+#ifdef MOLASSEMBLER_EMBEDDED_TRANSITIONS
+/* Loads the transitions embedded into the library at build time into the
+ * mappings table once
+ */
+void loadEmbeddedMappings() {
+  static const unsigned loaded [[gnu::unused]] = (
+    Detail::embeddedTransitionsSize > 0
+    ? loadMappings(
+      reinterpret_cast<const char*>(Detail::embeddedTransitions),
+      Detail::embeddedTransitionsSize
+    )
+    : 0
+  );
+}
+#endif
+
+} // namespace
 
 boost::optional<const Properties::ShapeTransitionGroup&> getMapping(
   const Shape a,
@@ -69,86 +205,162 @@ boost::optional<const Properties::ShapeTransitionGroup&> getMapping(
     return boost::none;
   }
 
-  using Key = typename decltype(mappingsCache)::key_type;
+  const int sizeDiff = static_cast<int>(Shapes::size(b)) - static_cast<int>(Shapes::size(a));
+  const bool calculable = (
+    sizeDiff == 1
+    || sizeDiff == 0
+    || (sizeDiff == -1 && removedIndexOption)
+  );
 
-  const Key key {a, b, removedIndexOption};
+  if(!calculable) {
+    return boost::none;
+  }
 
-  if(mappingsCache.has(key)) {
-    return mappingsCache.getOption(key);
+  if(removedIndexOption && removedIndexOption.value() >= Shapes::size(a)) {
+    throw std::out_of_range("Removed vertex is not a vertex of the source shape");
   }
 
-  int sizeDiff = static_cast<int>(Shapes::size(b)) - static_cast<int>(Shapes::size(a));
+#ifdef MOLASSEMBLER_EMBEDDED_TRANSITIONS
+  loadEmbeddedMappings();
+#endif
 
-  if(sizeDiff == 1 || sizeDiff == 0) {
-#ifdef USE_CONSTEXPR_TRANSITION_MAPPINGS
-    /* Is the desired mapping in the generated list of mappings?
-     * It can be that allMappings contains only a limited set of mappings!
-     *
-     * WARNING: this assumes that the enum containing the names of symmetries has
-     * the same order as the tuple specifying all (or some) symmetry data types
-     * used at compile-time to generate allMappings
-     */
-    auto& constexprOption = allMappings.at(
-      std::min(
-        static_cast<unsigned>(a),
-        static_cast<unsigned>(b)
-      ),
-      std::max(
-        static_cast<unsigned>(a),
-        static_cast<unsigned>(b)
-      )
-    );
+  const std::size_t index = mappingIndex(a, b, removedIndexOption);
+  if(const auto* cached = mappingsTable.get(index)) {
+    return *cached;
+  }
+
+  return mappingsTable.publish(index, calculateMapping(a, b, removedIndexOption));
+}
 
-    if(constexprOption.hasValue()) {
-      const auto& constexprMappings = constexprOption.value();
-
-      Properties::ShapeTransitionGroup stlResult;
-      stlResult.indexMappings = Temple::map(
-        Temple::toSTL(constexprMappings.mappings),
-        [&](const auto& indexList) -> std::vector<Vertex> {
-          std::vector<Vertex> v;
-          for(unsigned i : indexList) {
-            v.emplace_back(i);
-          }
-          return v;
+void precomputeMappings(const unsigned maxShapeSize) {
+  std::vector<std::tuple<Shape, Shape, boost::optional<Vertex>>> keys;
+  for(const Shape a : allShapes) {
+    for(const Shape b : allShapes) {
+      if(a == b || Shapes::size(a) > maxShapeSize || Shapes::size(b) > maxShapeSize) {
+        continue;
+      }
+
+      const int sizeDiff = static_cast<int>(Shapes::size(b)) - static_cast<int>(Shapes::size(a));
+      if(sizeDiff == 0 || sizeDiff == 1) {
+        keys.emplace_back(a, b, boost::none);
+      } else if(sizeDiff == -1) {
+        for(Vertex v {0}; v < Shapes::size(a); ++v) {
+          keys.emplace_back(a, b, v);
         }
-      );
+      }
+    }
+  }
 
-      stlResult.angularDistortion = constexprMappings.angularDistortion;
-      stlResult.chiralDistortion = constexprMappings.chiralDistortion;
+  const unsigned K = keys.size();
+#pragma omp parallel for schedule(dynamic)
+  for(unsigned i = 0; i < K; ++i) {
+    getMapping(std::get<0>(keys[i]), std::get<1>(keys[i]), std::get<2>(keys[i]));
+  }
+}
 
-      mappingsCache.add(
-        key,
-        stlResult
-      );
-    } else {
-      // Calculate dynamically (relevant for targets of size 9 and higher)
-      mappingsCache.add(
-        key,
-        Properties::selectBestTransitionMappings(
-          Properties::shapeTransitionMappings(a, b)
-        )
-      );
+void writeMappings(const std::string& filename) {
+  std::vector<unsigned> publishedIndices;
+  for(unsigned i = 0; i < mappingsTableSize; ++i) {
+    if(mappingsTable.get(i) != nullptr) {
+      publishedIndices.push_back(i);
     }
-#else
-    mappingsCache.add(
-      key,
-      Properties::selectBestTransitionMappings(
-        Properties::shapeTransitionMappings(a, b)
-      )
-    );
-#endif
-  } else if(sizeDiff == -1 && removedIndexOption) {
-    // Deletion case (always dynamic)
-    mappingsCache.add(
-      key,
-      Properties::selectBestTransitionMappings(
-        Properties::ligandLossTransitionMappings(a, b, removedIndexOption.value())
-      )
+  }
+
+  std::ofstream file(filename, std::ios::binary);
+  if(!file) {
+    throw std::runtime_error("Could not open " + filename + " for writing");
+  }
+
+  file.write(mappingsFileMagic.data(), mappingsFileMagic.size());
+  writeBinary<std::uint32_t>(file, nShapes);
+  writeBinary<std::uint32_t>(file, removedVertexStates);
+  writeBinary<std::uint32_t>(file, publishedIndices.size());
+  for(const unsigned i : publishedIndices) {
+    const Properties::ShapeTransitionGroup& group = *mappingsTable.get(i);
+    const unsigned mappingLength = group.indexMappings.empty() ? 0 : group.indexMappings.front().size();
+    writeBinary<std::uint32_t>(file, i);
+    writeBinary<double>(file, group.angularDistortion);
+    writeBinary<double>(file, group.chiralDistortion);
+    writeBinary<std::uint32_t>(file, group.indexMappings.size());
+    writeBinary<std::uint32_t>(file, mappingLength);
+    for(const auto& mapping : group.indexMappings) {
+      for(const Vertex v : mapping) {
+        writeBinary<std::uint8_t>(file, v);
+      }
+    }
+  }
+}
+
+unsigned loadMappings(const std::string& filename) {
+  const boost::interprocess::file_mapping mapping {
+    filename.c_str(),
+    boost::interprocess::read_only
+  };
+  const boost::interprocess::mapped_region region {
+    mapping,
+    boost::interprocess::read_only
+  };
+
+  try {
+    return loadMappings(
+      static_cast<const char*>(region.get_address()),
+      region.get_size()
     );
+  } catch(std::runtime_error& e) {
+    throw std::runtime_error(filename + ": " + e.what());
+  }
+}
+
+unsigned loadMappings(const char* const data, const std::size_t size) {
+  const char* cursor = data;
+  const char* const end = data + size;
+
+  for(const char c : mappingsFileMagic) {
+    if(readBinary<char>(cursor, end) != c) {
+      throw std::runtime_error("Not shape transitions data");
+    }
   }
 
-  return mappingsCache.getOption(key);
+  if(
+    readBinary<std::uint32_t>(cursor, end) != nShapes
+    || readBinary<std::uint32_t>(cursor, end) != removedVertexStates
+  ) {
+    throw std::runtime_error("Shape transitions were written for a different set of shapes");
+  }
+
+  const auto entries = readBinary<std::uint32_t>(cursor, end);
+  unsigned published = 0;
+  for(unsigned e = 0; e < entries; ++e) {
+    const auto index = readBinary<std::uint32_t>(cursor, end);
+    if(index >= mappingsTableSize) {
+      throw std::runtime_error("Shape transitions data contains an invalid entry");
+    }
+
+    Properties::ShapeTransitionGroup group;
+    group.angularDistortion = readBinary<double>(cursor, end);
+    group.chiralDistortion = readBinary<double>(cursor, end);
+    const auto mappingsCount = readBinary<std::uint32_t>(cursor, end);
+    const auto mappingLength = readBinary<std::uint32_t>(cursor, end);
+    if(mappingLength > ConstexprProperties::maxShapeSize) {
+      throw std::runtime_error("Shape transitions data contains an invalid entry");
+    }
+    group.indexMappings.reserve(mappingsCount);
+    for(unsigned m = 0; m < mappingsCount; ++m) {
+      std::vector<Vertex> indexMapping;
+      indexMapping.reserve(mappingLength);
+      for(unsigned k = 0; k < mappingLength; ++k) {
+        indexMapping.emplace_back(readBinary<std::uint8_t>(cursor, end));
+      }
+      group.indexMappings.push_back(std::move(indexMapping));
+    }
+
+    if(mappingsTable.get(index) == nullptr) {
+      mappingsTable.publish(index, std::move(group));
+      ++published;
+    }
+  }
+
+  return published;
 }
 
 #ifdef USE_CONSTEXPR_HAS_MULTIPLE_UNLINKED_STEREOPERMUTATIONS
@@ -180,42 +392,18 @@ constexpr Temple::Array<
 >();
 #endif
 
-Temple::MinimalCache<
-  Shape,
-  std::vector<bool>
-> hasMultipleUnlinkedCache;
+namespace {
 
-bool hasMultipleUnlinkedStereopermutations(
-  const Shape shape,
-  unsigned nIdenticalLigands
-) {
-  if(nIdenticalLigands == Shapes::size(shape)) {
-    return false;
-  }
-
-  // Alias a call with 0 to a call with 1 since that is the first calculated value
-  if(nIdenticalLigands == 0) {
-    ++nIdenticalLigands;
-  }
-
-  if(hasMultipleUnlinkedCache.has(shape)) {
-    return hasMultipleUnlinkedCache.get(shape).at(nIdenticalLigands - 1);
-  }
+Temple::OnceTable<std::vector<bool>, nShapes> hasMultipleUnlinkedTable;
 
+std::vector<bool> calculateHasMultipleUnlinked(const Shape shape) {
 #ifdef USE_CONSTEXPR_HAS_MULTIPLE_UNLINKED_STEREOPERMUTATIONS
   // Generate the cache element from constexpr non-STL data
   const auto& dynArrRef = allHasMultipleUnlinkedStereopermutations.at(
     static_cast<unsigned>(shape)
   );
 
-  auto stlMapped = Temple::toSTL(dynArrRef);
-
-  hasMultipleUnlinkedCache.add(
-    shape,
-    stlMapped
-  );
-
-  return stlMapped.at(nIdenticalLigands - 1);
+  return Temple::toSTL(dynArrRef);
 #else
   // Generate the cache element using dynamic properties
   std::vector<bool> unlinkedStereopermutations;
@@ -228,13 +416,50 @@ bool hasMultipleUnlinkedStereopermutations(
     );
   }
 
-  hasMultipleUnlinkedCache.add(
-    shape,
-    unlinkedStereopermutations
+  return unlinkedStereopermutations;
+#endif
+}
+
+} // namespace
+
+bool hasMultipleUnlinkedStereopermutations(
+  const Shape shape,
+  unsigned nIdenticalLigands
+) {
+  if(nIdenticalLigands == Shapes::size(shape)) {
+    return false;
+  }
+
+  // Alias a call with 0 to a call with 1 since that is the first calculated value
+  if(nIdenticalLigands == 0) {
+    ++nIdenticalLigands;
+  }
+
+  const unsigned index = static_cast<unsigned>(shape);
+  if(const auto* cached = hasMultipleUnlinkedTable.get(index)) {
+    return cached->at(nIdenticalLigands - 1);
+  }
+
+  return hasMultipleUnlinkedTable.publish(
+    index,
+    calculateHasMultipleUnlinked(shape)
+  ).at(nIdenticalLigands - 1);
+}
+
+const std::vector<std::vector<Vertex>>& rotationGroup(const Shape shape) {
+  // Thread-safe initialization on first use
+  static const auto groups = Temple::map(
+    allShapes,
+    [](const Shape s) -> std::vector<std::vector<Vertex>> {
+      const auto rotations = Properties::generateAllRotations(
+        s,
+        Temple::iota<Vertex>(Shapes::size(s))
+      );
+      return {std::begin(rotations), std::end(rotations)};
+    }
   );
 
-  return unlinkedStereopermutations.at(nIdenticalLigands - 1);
-#endif
+  return groups.at(nameIndex(shape));
 }
 
 } // namespace Shapes
@@ -64,16 +64,16 @@ extern const Temple::UpperTriangularMatrix<
 #endif
 
 /* Dynamic access to constexpr data */
-/*! @brief Cache for on-the-fly generated mappings between symmetries
- *
- * Accesses allMappings if it was generated.
- */
-extern Temple::MinimalCache<
-  std::tuple<Shape, Shape, boost::optional<unsigned>>,
-  Properties::ShapeTransitionGroup
-> mappingsCache;
-
 /*! @brief Cached access to mappings. Populates the cache from constexpr if generated.
+ *
+ * If the library is built with MOLASSEMBLER_EMBED_TRANSITIONS, transitions
+ * calculated at build time are loaded into the cache on first call.
+ *
+ * Transitions are calculated on first use and kept in a table indexed by
+ * the shapes and the removed vertex. Calculated transitions are published
+ * without locks, so that concurrent calls for cached transitions never
+ * block. Concurrent first calls for the same transition may each calculate
+ * it, but yield the same kept transition.
  *
  * @complexity{@math{\Theta(S!)} where @math{S} is the size of the symmetry if
  * the transition is not cached, @math{\Theta(1)} otherwise.}
@@ -84,6 +84,8 @@ extern Temple::MinimalCache<
  *   transition is to be a symmetry position loss. Necessary if the size of the
  *   target is one less than that of the source. Defaults to None.
  *
+ * @throws std::out_of_range If the removed vertex is not a vertex of @p a
+ *
  * @returns The symmetry transition if possible, None otherwise
  */
 boost::optional<const Properties::ShapeTransitionGroup&> getMapping(
@@ -92,6 +94,49 @@ boost::optional<const Properties::ShapeTransitionGroup&> getMapping(
   const boost::optional<Vertex>& removedIndexOption = boost::none
 );
 
+/*! @brief Calculates all transitions between shapes up to a size in parallel
+ *
+ * Populates the transitions cache of getMapping() eagerly, including all
+ * vertex loss transitions.
+ *
+ * @complexity{@math{\Theta(S!)} per transition, where @math{S} is at most
+ * @p maxShapeSize. Transitions between shapes of size 12 take very long.}
+ */
+MASM_EXPORT void precomputeMappings(unsigned maxShapeSize = 8);
+
+/*! @brief Writes all cached transitions to a binary file
+ *
+ * Combine with precomputeMappings() to generate a transitions file that
+ * loadMappings() can read at startup.
+ *
+ * @throws std::runtime_error If the file cannot be opened
+ */
+MASM_EXPORT void writeMappings(const std::string& filename);
+
+/*! @brief Populates the transitions cache from a file written by writeMappings()
+ *
+ * Reads the file from a read-only memory mapping. Transitions that are
+ * already cached are kept.
+ *
+ * @complexity{Linear in the file size}
+ * @throws std::runtime_error If the file is malformed or was written for a
+ *   different set of shapes
+ *
+ * @returns The number of transitions newly added to the cache
+ */
+MASM_EXPORT unsigned loadMappings(const std::string& filename);
+
+/*! @brief Populates the transitions cache from data in the format written by
+ *   writeMappings()
+ *
+ * @complexity{Linear in @p size}
+ * @throws std::runtime_error If the data is malformed or was written for a
+ *   different set of shapes
+ *
+ * @returns The number of transitions newly added to the cache
+ */
+MASM_EXPORT unsigned loadMappings(const char* data, std::size_t size);
+
 #ifdef USE_CONSTEXPR_HAS_MULTIPLE_UNLINKED_STEREOPERMUTATIONS
 /*! @brief All precomputed values for hasMultipleUnlinkedStereopermutations
  *
@@ -106,12 +151,6 @@ extern const Temple::Array<
 > allHasMultipleUnlinkedStereopermutations;
 #endif
 
-//! Run-time cache
-extern Temple::MinimalCache<
-  Shape,
-  std::vector<bool>
-> hasMultipleUnlinkedCache;
-
 /*! @brief Cached access to multiple unlinked values
  *
  * Populates the cache with allHasMultipleUnlinkedStereopermutations if the
@@ -132,6 +171,16 @@ MASM_EXPORT bool hasMultipleUnlinkedStereopermutations(
   unsigned nIdenticalLigands
 );
 
+/*! @brief Cached access to the rotation group of a shape
+ *
+ * All distinct vertex permutations generated by the shape's rotations,
+ * including the identity, in lexicographical order. Calculated for all shapes
+ * on first use.
+ *
+ * @complexity{@math{\Theta(1)} after first use}
+ */
+MASM_EXPORT const std::vector<std::vector<Vertex>>& rotationGroup(Shape shape);
+
 } // namespace Shapes
 } // namespace Molassembler
 } // namespace Scine
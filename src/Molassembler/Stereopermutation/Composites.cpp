@@ -21,6 +21,9 @@
 #include "Molassembler/Temple/Permutations.h"
 #include "Molassembler/Temple/Stl17.h"
 
+#include <list>
+#include <map>
+
 namespace Scine {
 namespace Molassembler {
 namespace Stereopermutations {
@@ -911,6 +914,122 @@ std::vector<Shapes::Vertex> Composite::rotation(
   return {};
 }
 
+namespace {
+
+using PermutationsPtr = std::shared_ptr<const Composite::PermutationsList>;
+
+/*! @brief Bounded least recently used cache of generated permutations
+ *
+ * Keyed by everything the permutations depend on: Both orientation states'
+ * shape, fused vertex and characters in the order of the ordered pair, and
+ * the alignment. Identifiers are excluded and remain per-instance.
+ *
+ * Not thread-safe by itself. Accesses are serialized by the
+ * compositePermutationsCache critical section.
+ */
+class PermutationsCache {
+public:
+  using Key = std::tuple<
+    Shapes::Shape, Shapes::Vertex, std::vector<char>,
+    Shapes::Shape, Shapes::Vertex, std::vector<char>,
+    Composite::Alignment
+  >;
+
+  //! Fetches cached permutations and marks them as most recently used
+  PermutationsPtr fetch(const Key& key) {
+    const auto findIter = index_.find(key);
+    if(findIter == std::end(index_)) {
+      return nullptr;
+    }
+
+    entries_.splice(std::begin(entries_), entries_, findIter->second);
+    return findIter->second->second;
+  }
+
+  //! Inserts permutations unless present, evicting the least recently used if full
+  PermutationsPtr insert(const Key& key, PermutationsPtr permutations) {
+    if(PermutationsPtr cached = fetch(key)) {
+      return cached;
+    }
+
+    entries_.emplace_front(key, std::move(permutations));
+    index_.emplace(key, std::begin(entries_));
+    if(entries_.size() > Composite::cacheCapacity) {
+      index_.erase(entries_.back().first);
+      entries_.pop_back();
+    }
+
+    return entries_.front().second;
+  }
+
+  unsigned size() const {
+    return entries_.size();
+  }
+
+  void clear() {
+    index_.clear();
+    entries_.clear();
+  }
+
+private:
+  using Entries = std::list<std::pair<Key, PermutationsPtr>>;
+
+  //! Entries ordered from most to least recently used
+  Entries entries_;
+  std::map<Key, Entries::iterator> index_;
+};
+
+PermutationsCache& permutationsCache() {
+  static PermutationsCache cache;
+  return cache;
+}
+
+PermutationsPtr cachedPermutations(
+  const Temple::OrderedPair<Composite::OrientationState>& orientations,
+  const Composite::Alignment alignment
+) {
+  const PermutationsCache::Key key {
+    orientations.first.shape,
+    orientations.first.fusedVertex,
+    orientations.first.characters,
+    orientations.second.shape,
+    orientations.second.fusedVertex,
+    orientations.second.characters,
+    alignment
+  };
+
+  PermutationsPtr permutations;
+#pragma omp critical(compositePermutationsCache)
+  permutations = permutationsCache().fetch(key);
+
+  if(permutations) {
+    return permutations;
+  }
+
+  // Generate outside the critical section. Racing threads keep the first list.
+  Composite::PermutationGenerator generator(orientations);
+  auto generated = generator.generate(alignment);
+
+  if(alignment == Composite::Alignment::Eclipsed) {
+    /* Reverse the stereopermutation sequence. This is so that the indices of the
+     * generated permutations yield the following simple comparison:
+     *
+     *   0 is E, 1 is Z
+     *   1 > 0 == Z > E
+     */
+    std::reverse(std::begin(generated), std::end(generated));
+  }
+
+  permutations = std::make_shared<const Composite::PermutationsList>(std::move(generated));
+
+#pragma omp critical(compositePermutationsCache)
+  permutations = permutationsCache().insert(key, std::move(permutations));
+
+  return permutations;
+}
+
+} // namespace
+
 Composite::Composite(
   OrientationState first,
   OrientationState second,
@@ -921,21 +1040,21 @@ Composite::Composite(
   // Do not construct the ordered pair of OrientationStates with same identifier
   assert(orientations_.first.identifier != orientations_.second.identifier);
 
-  PermutationGenerator generator(orientations_);
-  stereopermutations_ = generator.generate(alignment);
+  stereopermutations_ = cachedPermutations(orientations_, alignment);
+}
 
-  if(alignment == Alignment::Eclipsed) {
-    /* Reverse the stereopermutation sequence. This is so that the indices of the
-     * generated permutations yield the following simple comparison:
-     *
-     *   0 is E, 1 is Z
-     *   1 > 0 == Z > E
-     */
-    std::reverse(
-      std::begin(stereopermutations_),
-      std::end(stereopermutations_)
-    );
-  }
+constexpr unsigned Composite::cacheCapacity;
+
+unsigned Composite::cacheSize() {
+  unsigned size;
+#pragma omp critical(compositePermutationsCache)
+  size = permutationsCache().size();
+  return size;
+}
+
+void Composite::clearCache() {
+#pragma omp critical(compositePermutationsCache)
+  permutationsCache().clear();
 }
 
 void Composite::applyIdentifierPermutation(const std::vector<std::size_t>& permutation) {
@@ -945,7 +1064,7 @@ void Composite::applyIdentifierPermutation(const std::vector<std::size_t>& permu
 }
 
 const Composite::PermutationsList& Composite::allPermutations() const {
-  return stereopermutations_;
+  return *stereopermutations_;
 }
 
 Composite::Alignment Composite::alignment() const {
@@ -953,14 +1072,14 @@ Composite::Alignment Composite::alignment() const {
 }
 
 unsigned Composite::rankingEquivalentBase(const unsigned permutation) const {
-  const Permutation& stereopermutation = stereopermutations_.at(permutation);
+  const Permutation& stereopermutation = stereopermutations_->at(permutation);
 
   if(!stereopermutation.rankingEquivalentTo) {
     return permutation;
   }
 
   auto findIter = Temple::find_if(
-    stereopermutations_,
+    *stereopermutations_,
     [&](const auto& searchPermutation) {
       return (
         searchPermutation.alignment == stereopermutation.alignment
@@ -969,16 +1088,16 @@ unsigned Composite::rankingEquivalentBase(const unsigned permutation) const {
     }
   );
 
-  assert(findIter != std::end(stereopermutations_));
+  assert(findIter != std::end(*stereopermutations_));
 
-  return findIter - std::begin(stereopermutations_);
+  return findIter - std::begin(*stereopermutations_);
 }
 
 std::vector<unsigned> Composite::nonEquivalentPermutationIndices() const {
   std::vector<unsigned> indices;
-  const unsigned N = stereopermutations_.size();
+  const unsigned N = stereopermutations_->size();
   for(unsigned i = 0; i < N; ++i) {
-    if(!stereopermutations_.at(i).rankingEquivalentTo) {
+    if(!stereopermutations_->at(i).rankingEquivalentTo) {
       indices.push_back(i);
     }
   }
@@ -987,7 +1106,7 @@ std::vector<unsigned> Composite::nonEquivalentPermutationIndices() const {
 
 unsigned Composite::countNonEquivalentPermutations() const {
   return Temple::accumulate(
-    stereopermutations_,
+    *stereopermutations_,
     0U,
     [](unsigned carry, const Permutation& permutation) -> unsigned {
       if(permutation.rankingEquivalentTo) {
@@ -1010,7 +1129,7 @@ std::pair<unsigned, unsigned> Composite::orders() const {
    */
   const auto countDistinct = [&](auto&& f) {
     std::set<unsigned> positions;
-    for(const Permutation::DihedralTuple& t : stereopermutations_.front().dihedrals) {
+    for(const Permutation::DihedralTuple& t : stereopermutations_->front().dihedrals) {
       positions.insert(f(t));
     }
     return positions.size();
@@ -1036,13 +1155,13 @@ unsigned Composite::rotationalAxisSymmetryOrder() const {
    */
 
   std::set<unsigned> counts;
-  for(const Permutation& permutation : stereopermutations_) {
+  for(const Permutation& permutation : *stereopermutations_) {
     if(permutation.rankingEquivalentTo) {
       continue;
     }
 
     const auto count = Temple::accumulate(
-      stereopermutations_,
+      *stereopermutations_,
       1U,
       [&](unsigned carry, const Permutation& other) -> unsigned {
         if(
@@ -1076,11 +1195,11 @@ const Temple::OrderedPair<Composite::OrientationState>& Composite::orientations(
 }
 
 Composite::PermutationsList::const_iterator Composite::begin() const {
-  return std::begin(stereopermutations_);
+  return std::begin(*stereopermutations_);
 }
 
 Composite::PermutationsList::const_iterator Composite::end() const {
-  return std::end(stereopermutations_);
+  return std::end(*stereopermutations_);
 }
 
 bool Composite::operator < (const Composite& other) const {
@@ -18,6 +18,7 @@
 #include "Molassembler/Temple/constexpr/FloatingPointComparison.h"
 
 #include "boost/optional.hpp"
+#include <memory>
 
 namespace Scine {
 namespace Molassembler {
@@ -219,9 +220,14 @@ public:
 //!@name Constructors
 //!@{
   /*! @brief Constructor calculating all permutations
+   *
+   * Lists of permutations are memoized in a bounded process-wide cache keyed
+   * by both orientation states (excluding their identifiers) and the
+   * alignment, so that instances with identical keys share their
+   * permutations. Least recently used lists are evicted first.
    *
    * @complexity{@math{O(S!)} where S is the size of the larger shape of the
-   * two OrientationState instances}
+   * two OrientationState instances, if the permutations are not cached}
    *
    * @post Each permutations' dihedrals are sorted (lexicographically)
    */
@@ -260,6 +266,18 @@ public:
   );
 //!@}
 
+//!@name Cache
+//!@{
+  //! Maximum number of cached lists of permutations
+  static constexpr unsigned cacheCapacity = 1024;
+
+  //! Number of currently cached lists of permutations
+  static unsigned cacheSize();
+
+  //! Removes all cached lists of permutations
+  static void clearCache();
+//!@}
+
 //!@name Modification
 //!@{
   void applyIdentifierPermutation(const std::vector<std::size_t>& permutation);
@@ -340,7 +358,7 @@ private:
   Temple::OrderedPair<OrientationState> orientations_;
 
   //! List of dihedral sets that comprise all spatial arrangements
-  PermutationsList stereopermutations_;
+  std::shared_ptr<const PermutationsList> stereopermutations_;
 
   //! Stores with which Alignment the stereopermutations were generated
   Alignment alignment_;
@@ -7,13 +7,19 @@
 #include "Molassembler/Stereopermutation/Manipulation.h"
 
 #include "Molassembler/Shapes/Data.h"
+#include "Molassembler/Shapes/constexpr/Properties.h"
 #include "Molassembler/Stereopermutation/RotationEnumerator.h"
 #include "Molassembler/Temple/Functional.h"
+#include "Molassembler/Temple/OnceTable.h"
 #include "Molassembler/Temple/Permutations.h"
 
+#include "boost/interprocess/file_mapping.hpp"
+#include "boost/interprocess/mapped_region.hpp"
 #include "boost/optional.hpp"
 #include "boost/integer/common_factor_rt.hpp"
 
+#include <cstring>
+#include <fstream>
 #include <unordered_map>
 
 namespace Scine {
@@ -37,6 +43,154 @@ inline unsigned gcd(const std::vector<unsigned>& c) {
 
 } // namespace
 
+#ifdef MOLASSEMBLER_EMBEDDED_UNIQUES
+namespace Detail {
+
+/* Unique stereopermutations data in the format of writeUniques(), generated
+ * at build time and compiled into the library separately
+ */
+extern const unsigned char embeddedUniques[];
+extern const std::size_t embeddedUniquesSize;
+
+} // namespace Detail
+#endif
+
+namespace {
+
+//! Number of partitions of n into parts no larger than maxPart
+constexpr unsigned partitionCount(const unsigned n, const unsigned maxPart) {
+  if(n == 0) {
+    return 1;
+  }
+
+  unsigned count = 0;
+  for(unsigned part = std::min(n, maxPart); part >= 1; --part) {
+    count += partitionCount(n - part, part);
+  }
+  return count;
+}
+
+constexpr unsigned maxShapeSize = Shapes::ConstexprProperties::maxShapeSize;
+//! Number of character multisets of the largest shape
+constexpr unsigned partitionSlots = partitionCount(maxShapeSize, maxShapeSize);
+constexpr std::size_t uniquesTableSize = Shapes::nShapes * partitionSlots;
+
+/* Precomputed unique stereopermutations without links, indexed by shape and
+ * by the partition of the shape's size into numbers of equal characters
+ */
+Temple::OnceTable<Uniques, uniquesTableSize> uniquesTable;
+
+//! Partitions of n into non-increasing parts in descending lexicographical order
+std::vector<std::vector<unsigned>> partitions(const unsigned n, const unsigned maxPart) {
+  if(n == 0) {
+    return {{}};
+  }
+
+  std::vector<std::vector<unsigned>> result;
+  for(unsigned part = std::min(n, maxPart); part >= 1; --part) {
+    for(auto& tail : partitions(n - part, part)) {
+      tail.insert(std::begin(tail), part);
+      result.push_back(std::move(tail));
+    }
+  }
+  return result;
+}
+
+const std::vector<std::vector<unsigned>>& sizePartitions(const unsigned S) {
+  // Thread-safe initialization on first use
+  static const auto allPartitions = Temple::map(
+    Temple::iota<unsigned>(maxShapeSize + 1),
+    [](const unsigned n) { return partitions(n, n); }
+  );
+  return allPartitions.at(S);
+}
+
+//! Characters of equal-character group sizes, e.g. 3, 2, 1 -> AAABBC
+Stereopermutation::CharacterOccupation canonicalCharacters(const std::vector<unsigned>& groupSizes) {
+  Stereopermutation::CharacterOccupation characters;
+  char currentChar = 'A';
+  for(const unsigned groupSize : groupSizes) {
+    characters.insert(std::end(characters), groupSize, currentChar);
+    ++currentChar;
+  }
+  return characters;
+}
+
+/* Table slot of a stereopermutation without links whose characters are
+ * canonical, i.e. in alphabetical order starting from A with non-increasing
+ * numbers of equal characters
+ */
+boost::optional<std::size_t> uniquesSlot(const Stereopermutation& base, const Shapes::Shape shape) {
+  if(!base.links.empty()) {
+    return boost::none;
+  }
+
+  std::vector<unsigned> groupSizes;
+  char expected = 'A';
+  for(const char c : base.characters) {
+    if(c == expected) {
+      groupSizes.push_back(1);
+      ++expected;
+    } else if(!groupSizes.empty() && c == expected - 1) {
+      ++groupSizes.back();
+    } else {
+      return boost::none;
+    }
+  }
+
+  const auto& shapePartitions = sizePartitions(Shapes::size(shape));
+  const auto findIter = Temple::find(shapePartitions, groupSizes);
+  if(findIter == std::end(shapePartitions)) {
+    return boost::none;
+  }
+
+  return static_cast<unsigned>(shape) * partitionSlots + (findIter - std::begin(shapePartitions));
+}
+
+/* Binary unique stereopermutations file layout, in native byte order:
+ * - Magic bytes, the number of shapes and partition slots per shape, and the
+ *   number of entries (all uint32)
+ * - Per entry: uniques table index and number of unique stereopermutations
+ *   (uint32), followed by each stereopermutation's characters (uint8, as
+ *   many as the shape size) and weight (uint32)
+ */
+constexpr std::array<char, 8> uniquesFileMagic {{'M', 'A', 'S', 'M', 'S', 'T', 'U', '1'}};
+
+template<typename T>
+void writeBinary(std::ostream& os, const T value) {
+  os.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template<typename T>
+T readBinary(const char*& cursor, const char* end) {
+  if(end - cursor < static_cast<std::ptrdiff_t>(sizeof(T))) {
+    throw std::runtime_error("Unique stereopermutations data is truncated");
+  }
+
+  T value;
+  std::memcpy(&value, cursor, sizeof(T));
+  cursor += sizeof(T);
+  return value;
+}
+
+#ifdef MOLASSEMBLER_EMBEDDED_UNIQUES
+/* Loads the unique stereopermutations embedded into the library at build
+ * time into the uniques table once
+ */
+void loadEmbeddedUniques() {
+  static const unsigned loaded [[gnu::unused]] = (
+    Detail::embeddedUniquesSize > 0
+    ? loadUniques(
+      reinterpret_cast<const char*>(Detail::embeddedUniques),
+      Detail::embeddedUniquesSize
+    )
+    : 0
+  );
+}
+#endif
+
+} // namespace
+
 inline void checkArguments(const Stereopermutation& s, const Shapes::Shape shape) {
   if(s.characters.size() != Shapes::size(shape)) {
     throw std::invalid_argument("Stereopermutation character count does not match shape size");
@@ -109,13 +263,14 @@ bool hasTransArrangedLinks(
   );
 }
 
-Uniques uniques(
+namespace {
+
+//! Generates the unique stereopermutations by enumerating all permutations
+Uniques enumerateUniques(
   const Stereopermutation& base,
   const Shapes::Shape shape,
   const bool removeTransSpanningGroups
 ) {
-  checkArguments(base, shape);
-
   const unsigned S = Shapes::size(shape);
   auto permutation = Temple::iota<Shapes::Vertex>(S);
   auto stereopermutation = base;
@@ -211,6 +366,154 @@ Uniques uniques(
   return ordered;
 }
 
+} // namespace
+
+Uniques uniques(
+  const Stereopermutation& base,
+  const Shapes::Shape shape,
+  const bool removeTransSpanningGroups
+) {
+  checkArguments(base, shape);
+
+#ifdef MOLASSEMBLER_EMBEDDED_UNIQUES
+  loadEmbeddedUniques();
+#endif
+
+  // Without links, the result depends only on the shape and the characters
+  if(const auto slotOption = uniquesSlot(base, shape)) {
+    if(const Uniques* precomputed = uniquesTable.get(slotOption.value())) {
+      return *precomputed;
+    }
+  }
+
+  return enumerateUniques(base, shape, removeTransSpanningGroups);
+}
+
+void precomputeUniques(const unsigned maxShapeSize) {
+  std::vector<std::pair<Shapes::Shape, std::vector<unsigned>>> keys;
+  for(const Shapes::Shape shape : Shapes::allShapes) {
+    const unsigned S = Shapes::size(shape);
+    if(S > maxShapeSize) {
+      continue;
+    }
+
+    for(const auto& partition : sizePartitions(S)) {
+      keys.emplace_back(shape, partition);
+    }
+  }
+
+  const unsigned K = keys.size();
+#pragma omp parallel for schedule(dynamic)
+  for(unsigned i = 0; i < K; ++i) {
+    const Stereopermutation base {canonicalCharacters(keys[i].second)};
+    const Shapes::Shape shape = keys[i].first;
+    const std::size_t slot = uniquesSlot(base, shape).value();
+    if(uniquesTable.get(slot) == nullptr) {
+      uniquesTable.publish(slot, enumerateUniques(base, shape, false));
+    }
+  }
+}
+
+void writeUniques(const std::string& filename) {
+  std::vector<unsigned> publishedIndices;
+  for(unsigned i = 0; i < uniquesTableSize; ++i) {
+    if(uniquesTable.get(i) != nullptr) {
+      publishedIndices.push_back(i);
+    }
+  }
+
+  std::ofstream file(filename, std::ios::binary);
+  if(!file) {
+    throw std::runtime_error("Could not open " + filename + " for writing");
+  }
+
+  file.write(uniquesFileMagic.data(), uniquesFileMagic.size());
+  writeBinary<std::uint32_t>(file, Shapes::nShapes);
+  writeBinary<std::uint32_t>(file, partitionSlots);
+  writeBinary<std::uint32_t>(file, publishedIndices.size());
+  for(const unsigned i : publishedIndices) {
+    const Uniques& entry = *uniquesTable.get(i);
+    writeBinary<std::uint32_t>(file, i);
+    writeBinary<std::uint32_t>(file, entry.list.size());
+    for(unsigned j = 0; j < entry.list.size(); ++j) {
+      for(const char c : entry.list[j].characters) {
+        writeBinary<std::uint8_t>(file, c);
+      }
+      writeBinary<std::uint32_t>(file, entry.weights[j]);
+    }
+  }
+}
+
+unsigned loadUniques(const std::string& filename) {
+  const boost::interprocess::file_mapping mapping {
+    filename.c_str(),
+    boost::interprocess::read_only
+  };
+  const boost::interprocess::mapped_region region {
+    mapping,
+    boost::interprocess::read_only
+  };
+
+  try {
+    return loadUniques(
+      static_cast<const char*>(region.get_address()),
+      region.get_size()
+    );
+  } catch(std::runtime_error& e) {
+    throw std::runtime_error(filename + ": " + e.what());
+  }
+}
+
+unsigned loadUniques(const char* const data, const std::size_t size) {
+  const char* cursor = data;
+  const char* const end = data + size;
+
+  for(const char c : uniquesFileMagic) {
+    if(readBinary<char>(cursor, end) != c) {
+      throw std::runtime_error("Not unique stereopermutations data");
+    }
+  }
+
+  if(
+    readBinary<std::uint32_t>(cursor, end) != Shapes::nShapes
+    || readBinary<std::uint32_t>(cursor, end) != partitionSlots
+  ) {
+    throw std::runtime_error("Unique stereopermutations were written for a different set of shapes");
+  }
+
+  const auto entries = readBinary<std::uint32_t>(cursor, end);
+  unsigned published = 0;
+  for(unsigned e = 0; e < entries; ++e) {
+    const auto index = readBinary<std::uint32_t>(cursor, end);
+    const Shapes::Shape shape = Shapes::allShapes.at(index / partitionSlots);
+    const unsigned S = Shapes::size(shape);
+    if(index % partitionSlots >= sizePartitions(S).size()) {
+      throw std::runtime_error("Unique stereopermutations data contains an invalid entry");
+    }
+
+    const auto count = readBinary<std::uint32_t>(cursor, end);
+    Uniques entry;
+    entry.list.reserve(count);
+    entry.weights.reserve(count);
+    for(unsigned j = 0; j < count; ++j) {
+      Stereopermutation::CharacterOccupation characters;
+      characters.reserve(S);
+      for(unsigned k = 0; k < S; ++k) {
+        characters.push_back(readBinary<std::uint8_t>(cursor, end));
+      }
+      entry.list.emplace_back(std::move(characters));
+      entry.weights.push_back(readBinary<std::uint32_t>(cursor, end));
+    }
+
+    if(uniquesTable.get(index) == nullptr) {
+      uniquesTable.publish(index, std::move(entry));
+      ++published;
+    }
+  }
+
+  return published;
+}
+
 } // namespace Stereopermutations
 } // namespace Molassembler
 } // namespace Scine
@@ -9,6 +9,7 @@
 #define INCLUDE_MOLASSEMBLER_STEREOPERMUTATION_MANIPULATION_H
 
 #include "Molassembler/Stereopermutation/Stereopermutation.h"
+#include <string>
 #include <unordered_set>
 
 namespace Scine {
@@ -99,6 +100,53 @@ MASM_EXPORT Uniques uniques(
   bool removeTransSpanningGroups = false
 );
 
+/*! @brief Calculates the unique stereopermutations of all unlinked character
+ *   patterns of shapes up to a size in parallel
+ *
+ * Populates the table of precomputed results that uniques() consults for
+ * stereopermutations without links whose characters are in canonical order,
+ * i.e. alphabetical from A with non-increasing numbers of equal characters,
+ * such as AAABBC. Other stereopermutations are always enumerated.
+ *
+ * @complexity{@math{\Theta(S!)} per character pattern, where @math{S} is at
+ * most @p maxShapeSize}
+ */
+MASM_EXPORT void precomputeUniques(unsigned maxShapeSize = 8);
+
+/*! @brief Writes all precomputed unique stereopermutations to a binary file
+ *
+ * Combine with precomputeUniques() to generate a file that loadUniques() can
+ * read at startup.
+ *
+ * @throws std::runtime_error If the file cannot be opened
+ */
+MASM_EXPORT void writeUniques(const std::string& filename);
+
+/*! @brief Populates the precomputed unique stereopermutations from a file
+ *   written by writeUniques()
+ *
+ * Reads the file from a read-only memory mapping. Entries that are already
+ * precomputed are kept.
+ *
+ * @complexity{Linear in the file size}
+ * @throws std::runtime_error If the file is malformed or was written for a
+ *   different set of shapes
+ *
+ * @returns The number of newly added character patterns
+ */
+MASM_EXPORT unsigned loadUniques(const std::string& filename);
+
+/*! @brief Populates the precomputed unique stereopermutations from data in
+ *   the format written by writeUniques()
+ *
+ * @complexity{Linear in @p size}
+ * @throws std::runtime_error If the data is malformed or was written for a
+ *   different set of shapes
+ *
+ * @returns The number of newly added character patterns
+ */
+MASM_EXPORT unsigned loadUniques(const char* data, std::size_t size);
+
 } // namespace Stereopermutations
 } // namespace Molassembler
 } // namespace Scine
@@ -108,10 +108,12 @@ public:
    * @throws std::out_of_range If there is no bond stereopermutator on the
    * passed bond
    *
-   * @complexity{@math{\Theta(1)}}
+   * @complexity{@math{\Theta(\log B)}}
    */
   BondStereopermutator& at(const BondIndex& index);
   /*! @brief Add a new AtomStereopermutator to the list
+   *
+   * May invalidate references to other atom stereopermutators
    *
    * @complexity{@math{\Theta(1)} amortized}
    *
@@ -121,7 +123,9 @@ public:
 
   /*! @brief Add a new BondStereopermutator to the list
    *
-   * @complexity{@math{\Theta(1)} amortized}
+   * Invalidates references to other bond stereopermutators
+   *
+   * @complexity{@math{O(B)}}
    *
    * @returns An iterator pointing to the added stereopermutator
    */
@@ -156,7 +160,7 @@ public:
 
   /*! @brief Fetch a reference-option to a BondStereopermutator
    *
-   * @complexity{@math{\Theta(1)}}
+   * @complexity{@math{\Theta(\log B)}}
    */
   boost::optional<BondStereopermutator&> option(const BondIndex& edge);
 
@@ -178,7 +182,7 @@ public:
 
   /*! @brief Removes the BondStereopermutator on a specified edge
    *
-   * @complexity{@math{\Theta(1)}}
+   * @complexity{@math{O(B)}}
    */
   void remove(const BondIndex& edge);
 
@@ -190,7 +194,7 @@ public:
 
   /*! @brief Removes the BondStereopermutator on a specified edge, if present
    *
-   * @complexity{@math{\Theta(1)}}
+   * @complexity{@math{O(B)}}
    */
   void try_remove(const BondIndex& edge);
 //!@}
@@ -211,7 +215,7 @@ public:
    * @throws std::out_of_range If there is no bond stereopermutator on the
    * passed bond
    *
-   * @complexity{@math{\Theta(1)}}
+   * @complexity{@math{\Theta(\log B)}}
    */
   const BondStereopermutator& at(const BondIndex& index) const;
 
@@ -250,7 +254,7 @@ public:
 
   /*! @brief Fetch a const ref-option to a BondStereopermutator, if present
    *
-   * @complexity{@math{\Theta(1)}}
+   * @complexity{@math{\Theta(\log B)}}
    */
   boost::optional<const BondStereopermutator&> option(const BondIndex& edge) const;
 
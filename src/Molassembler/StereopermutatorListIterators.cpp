@@ -123,12 +123,9 @@ struct IteratorWrapper {
    */
 };
 
-using AtomMapType = std::unordered_map<AtomIndex, AtomStereopermutator>;
-using BondMapType = std::unordered_map<BondIndex, BondStereopermutator, boost::hash<BondIndex>>;
-
 template<>
 struct StereopermutatorList::iterator<AtomStereopermutator>::Impl
-  : public IteratorWrapper<typename AtomMapType::iterator>
+  : public IteratorWrapper<typename AtomStereopermutatorSlots::iterator>
 {
   Impl() = default;
   Impl(StereopermutatorList::Impl& impl, bool begin) {
@@ -140,13 +137,13 @@ struct StereopermutatorList::iterator<AtomStereopermutator>::Impl
   }
 
   AtomStereopermutator& operator * () const {
-    return iterator->second;
+    return *iterator;
   }
 };
 
 template<>
 struct StereopermutatorList::iterator<const AtomStereopermutator>::Impl
-  : public IteratorWrapper<typename AtomMapType::const_iterator>
+  : public IteratorWrapper<typename AtomStereopermutatorSlots::const_iterator>
 {
   Impl() = default;
   Impl(const StereopermutatorList::Impl& impl, bool begin) {
@@ -158,13 +155,13 @@ struct StereopermutatorList::iterator<const AtomStereopermutator>::Impl
   }
 
   const AtomStereopermutator& operator * () const {
-    return iterator->second;
+    return *iterator;
   }
 };
 
 template<>
 struct StereopermutatorList::iterator<BondStereopermutator>::Impl
-  : public IteratorWrapper<typename BondMapType::iterator>
+  : public IteratorWrapper<typename BondStereopermutatorSequence::iterator>
 {
   Impl() = default;
   Impl(StereopermutatorList::Impl& impl, bool begin) {
@@ -176,13 +173,13 @@ struct StereopermutatorList::iterator<BondStereopermutator>::Impl
   }
 
   BondStereopermutator& operator * () const {
-    return iterator->second;
+    return *iterator;
   }
 };
 
 template<>
 struct StereopermutatorList::iterator<const BondStereopermutator>::Impl
-  : public IteratorWrapper<typename BondMapType::const_iterator>
+  : public IteratorWrapper<typename BondStereopermutatorSequence::const_iterator>
 {
   Impl() = default;
   Impl(const StereopermutatorList::Impl& impl, bool begin) {
@@ -194,7 +191,7 @@ struct StereopermutatorList::iterator<const BondStereopermutator>::Impl
   }
 
   const BondStereopermutator& operator * () const {
-    return iterator->second;
+    return *iterator;
   }
 };
 
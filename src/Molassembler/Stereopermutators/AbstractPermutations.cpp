@@ -5,14 +5,183 @@
  */
 #include "Molassembler/Stereopermutators/AbstractPermutations.h"
 
+#include "Molassembler/Detail/Metrics.h"
 #include "Molassembler/Temple/Functional.h"
 
+#include "boost/optional.hpp"
+
 #include <algorithm>
 #include <cassert>
+#include <list>
+#include <map>
+#include <tuple>
 
 namespace Scine {
 namespace Molassembler {
 namespace Stereopermutators {
+namespace {
+
+using UniquesPtr = std::shared_ptr<const Stereopermutations::Uniques>;
+
+//! Cached set of stereopermutations with the maps memoized for it
+struct CacheEntry {
+  UniquesPtr uniques;
+  std::shared_ptr<Abstract::VertexMaps> vertexMaps;
+};
+
+/*! @brief Bounded least recently used cache of sets of stereopermutations
+ *
+ * Not thread-safe by itself. Accesses are serialized by the
+ * abstractPermutationsCache critical section.
+ */
+class UniquesCache {
+public:
+  using Key = std::tuple<
+    Shapes::Shape,
+    std::vector<char>,
+    Stereopermutations::Stereopermutation::OrderedLinks
+  >;
+
+  //! Fetches a cached set and marks it as most recently used
+  CacheEntry fetch(const Key& key) {
+    const auto findIter = index_.find(key);
+    if(findIter == std::end(index_)) {
+      return {};
+    }
+
+    entries_.splice(std::begin(entries_), entries_, findIter->second);
+    return findIter->second->second;
+  }
+
+  //! Inserts a set unless present, evicting the least recently used set if full
+  CacheEntry insert(const Key& key, UniquesPtr uniques) {
+    CacheEntry cached = fetch(key);
+    if(cached.uniques) {
+      return cached;
+    }
+
+    entries_.emplace_front(
+      key,
+      CacheEntry {std::move(uniques), std::make_shared<Abstract::VertexMaps>()}
+    );
+    index_.emplace(key, std::begin(entries_));
+    if(entries_.size() > Abstract::cacheCapacity) {
+      index_.erase(entries_.back().first);
+      entries_.pop_back();
+    }
+
+    return entries_.front().second;
+  }
+
+  unsigned size() const {
+    return entries_.size();
+  }
+
+  void clear() {
+    index_.clear();
+    entries_.clear();
+  }
+
+private:
+  using Entries = std::list<std::pair<Key, CacheEntry>>;
+
+  //! Entries ordered from most to least recently used
+  Entries entries_;
+  std::map<Key, Entries::iterator> index_;
+};
+
+UniquesCache& uniquesCache() {
+  static UniquesCache cache;
+  return cache;
+}
+
+CacheEntry cachedUniques(
+  const std::vector<char>& symbolicCharacters,
+  const Stereopermutations::Stereopermutation::OrderedLinks& selfReferentialLinks,
+  const Shapes::Shape shape
+) {
+  const UniquesCache::Key key {shape, symbolicCharacters, selfReferentialLinks};
+
+  CacheEntry entry;
+#pragma omp critical(abstractPermutationsCache)
+  entry = uniquesCache().fetch(key);
+
+  if(entry.uniques) {
+    return entry;
+  }
+
+  // Generate outside the critical section. Racing threads keep the first set.
+  auto uniques = std::make_shared<const Stereopermutations::Uniques>(
+    Stereopermutations::uniques(
+      Stereopermutations::Stereopermutation {
+        symbolicCharacters,
+        selfReferentialLinks
+      },
+      shape,
+      false
+    )
+  );
+
+#pragma omp critical(abstractPermutationsCache)
+  entry = uniquesCache().insert(key, std::move(uniques));
+
+  return entry;
+}
+
+} // namespace
+
+constexpr unsigned Abstract::VertexMaps::capacity;
+constexpr unsigned Abstract::cacheCapacity;
+
+SiteToShapeVertexMap Abstract::VertexMaps::at(
+  const Stereopermutations::Uniques& uniques,
+  const unsigned stereopermutationIndex,
+  const RankingInformation::RankedSitesType& canonicalSites,
+  const std::vector<RankingInformation::Link>& links
+) {
+  Key key {
+    stereopermutationIndex,
+    canonicalSites,
+    Temple::map(links, [](const auto& link) { return link.sites; })
+  };
+
+  boost::optional<SiteToShapeVertexMap> memoized;
+#pragma omp critical(abstractPermutationsVertexMaps)
+  {
+    const auto findIter = maps_.find(key);
+    if(findIter != std::end(maps_)) {
+      memoized = findIter->second;
+    }
+  }
+
+  if(memoized) {
+    return memoized.value();
+  }
+
+  auto map = Molassembler::siteToShapeVertexMap(
+    uniques.list.at(stereopermutationIndex),
+    canonicalSites,
+    links
+  );
+
+#pragma omp critical(abstractPermutationsVertexMaps)
+  {
+    // Maps are cheap to regenerate, so there is no need for finer eviction
+    if(maps_.size() >= capacity) {
+      maps_.clear();
+    }
+    maps_.emplace(std::move(key), map);
+  }
+
+  return map;
+}
+
+unsigned Abstract::VertexMaps::size() const {
+  unsigned size = 0;
+#pragma omp critical(abstractPermutationsVertexMaps)
+  size = maps_.size();
+  return size;
+}
 
 RankingInformation::RankedSitesType Abstract::canonicalize(
   RankingInformation::RankedSitesType rankedSites
@@ -136,18 +305,40 @@ Abstract::Abstract(
   const Shapes::Shape shape
 ) : canonicalSites(canonicalize(ranking.siteRanking)),
     symbolicCharacters(transferToSymbolicCharacters(canonicalSites)),
-    selfReferentialLinks(selfReferentialTransform(ranking.links, canonicalSites)),
-    permutations(
-      Stereopermutations::uniques(
-        Stereopermutations::Stereopermutation {
-          symbolicCharacters,
-          selfReferentialLinks
-        },
-        shape,
-        false
-      )
-    )
-{}
+    selfReferentialLinks(selfReferentialTransform(ranking.links, canonicalSites))
+{
+  const Detail::Metrics::Timer timer {Detail::Metrics::Operation::AbstractPermutations};
+  CacheEntry entry = cachedUniques(symbolicCharacters, selfReferentialLinks, shape);
+  permutations = std::move(entry.uniques);
+  vertexMaps = std::move(entry.vertexMaps);
+}
+
+SiteToShapeVertexMap Abstract::siteToShapeVertexMap(
+  const unsigned stereopermutationIndex,
+  const std::vector<RankingInformation::Link>& links
+) const {
+  if(vertexMaps) {
+    return vertexMaps->at(*permutations, stereopermutationIndex, canonicalSites, links);
+  }
+
+  return Molassembler::siteToShapeVertexMap(
+    permutations->list.at(stereopermutationIndex),
+    canonicalSites,
+    links
+  );
+}
+
+unsigned Abstract::cacheSize() {
+  unsigned size = 0;
+#pragma omp critical(abstractPermutationsCache)
+  size = uniquesCache().size();
+  return size;
+}
+
+void Abstract::clearCache() {
+#pragma omp critical(abstractPermutationsCache)
+  uniquesCache().clear();
+}
 
 } // namespace Stereopermutators
 } // namespace Molassembler
@@ -11,6 +11,10 @@
 #include "Molassembler/Stereopermutators/ShapeVertexMaps.h"
 #include "Molassembler/Stereopermutation/Manipulation.h"
 
+#include <map>
+#include <memory>
+#include <tuple>
+
 namespace Scine {
 namespace Molassembler {
 
@@ -22,6 +26,45 @@ namespace Stereopermutators {
  *   and shape
  */
 struct Abstract {
+  /**
+   * @brief Memoized site to shape vertex maps of a set of stereopermutations
+   *
+   * Maps depend on the site indices of the ranking in addition to the
+   * stereopermutation, so they are keyed by the stereopermutation index, the
+   * canonical sites and the linked site pairs. Shared by all instances whose
+   * stereopermutations are shared, e.g. those repeatedly constructed while
+   * fitting a stereopermutator to many frames of a trajectory. Thread-safe.
+   */
+  class VertexMaps {
+  public:
+    //! Maximum number of memoized maps before all are discarded
+    static constexpr unsigned capacity = 256;
+
+    /*! @brief Fetches or generates the map of a stereopermutation
+     *
+     * @complexity{@math{\Theta(\log M)} if memoized, where @math{M} is the
+     * number of memoized maps, as siteToShapeVertexMap otherwise}
+     */
+    SiteToShapeVertexMap at(
+      const Stereopermutations::Uniques& uniques,
+      unsigned stereopermutationIndex,
+      const RankingInformation::RankedSitesType& canonicalSites,
+      const std::vector<RankingInformation::Link>& links
+    );
+
+    //! Number of memoized maps
+    unsigned size() const;
+
+  private:
+    using Key = std::tuple<
+      unsigned,
+      RankingInformation::RankedSitesType,
+      std::vector<std::pair<SiteIndex, SiteIndex>>
+    >;
+
+    std::map<Key, SiteToShapeVertexMap> maps_;
+  };
+
 //!@name Static functions
 //!@{
   /*!
@@ -103,7 +146,13 @@ struct Abstract {
    * @brief Generates the set of abstract stereopermutations and intermediate
    *   data
    *
-   * @complexity{The generation of permutations dominates: @math{\Theta(S!)}}
+   * Sets of stereopermutations are memoized in a bounded process-wide cache
+   * keyed by the shape, symbolic characters and self-referential links, so
+   * that instances with identical keys share their stereopermutations. Least
+   * recently used sets are evicted first.
+   *
+   * @complexity{The generation of permutations dominates: @math{\Theta(S!)}
+   * if the set of stereopermutations is not cached}
    *
    * @param ranking Ranking object indicating chemical differences between
    *    substituents and sites
@@ -115,6 +164,35 @@ struct Abstract {
   );
 //!@}
 
+//!@name Information
+//!@{
+  /*! @brief Site to shape vertex map of a stereopermutation
+   *
+   * Memoized alongside the set of stereopermutations if it is cached.
+   *
+   * @param stereopermutationIndex Index into the list of stereopermutations
+   * @param links Links of the ranking this instance was generated from
+   *
+   * @complexity{As VertexMaps::at}
+   */
+  SiteToShapeVertexMap siteToShapeVertexMap(
+    unsigned stereopermutationIndex,
+    const std::vector<RankingInformation::Link>& links
+  ) const;
+//!@}
+
+//!@name Cache
+//!@{
+  //! Maximum number of cached sets of stereopermutations
+  static constexpr unsigned cacheCapacity = 1024;
+
+  //! Number of currently cached sets of stereopermutations
+  static unsigned cacheSize();
+
+  //! Removes all cached sets of stereopermutations
+  static void clearCache();
+//!@}
+
 //!@name Data members
 //!@{
   //! Stably resorted (by set size) site ranking
@@ -127,7 +205,10 @@ struct Abstract {
   Stereopermutations::Stereopermutation::OrderedLinks selfReferentialLinks;
 
   //! Vector of rotationally unique stereopermutations with associated weights
-  Stereopermutations::Uniques permutations;
+  std::shared_ptr<const Stereopermutations::Uniques> permutations = std::make_shared<Stereopermutations::Uniques>();
+
+  //! Memoized site to shape vertex maps of the stereopermutations, if cached
+  std::shared_ptr<VertexMaps> vertexMaps;
 //!@}
 };
 
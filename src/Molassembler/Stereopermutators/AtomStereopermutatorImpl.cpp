@@ -74,6 +74,8 @@ Shapes::Shape pickTransition(
     }
   };
 
+  const ChiralStatePreservation preservation = Options::current().chiralStatePreservation;
+
   // Populate the list of shape with candidates
   for(const Shapes::Shape propositionalShape : Shapes::allShapes) {
     if(Shapes::size(propositionalShape) != T) {
@@ -86,7 +88,7 @@ Shapes::Shape pickTransition(
       }
 
       if(
-        Options::chiralStatePreservation == ChiralStatePreservation::EffortlessAndUnique
+        preservation == ChiralStatePreservation::EffortlessAndUnique
         && transitionOptional->indexMappings.size() == 1
         && transitionOptional->angularDistortion <= 0.2
       ) {
@@ -94,13 +96,13 @@ Shapes::Shape pickTransition(
       }
 
       if(
-        Options::chiralStatePreservation == ChiralStatePreservation::Unique
+        preservation == ChiralStatePreservation::Unique
         && transitionOptional->indexMappings.size() == 1
       ) {
         replaceOrAdd(propositionalShape, *transitionOptional);
       }
 
-      if(Options::chiralStatePreservation == ChiralStatePreservation::RandomFromMultipleBest) {
+      if(preservation == ChiralStatePreservation::RandomFromMultipleBest) {
         replaceOrAdd(propositionalShape, *transitionOptional);
       }
     }
@@ -121,20 +123,15 @@ std::pair<Shapes::Shape, std::vector<Shapes::Vertex>> classifyShape(const Eigen:
   const unsigned S = sitePositions.cols() - 1;
   auto normalized = Shapes::Continuous::normalize(sitePositions);
 
-  std::vector<Shapes::Shape> viableShapes;
-  for(const Shapes::Shape shape : Shapes::allShapes) {
-    if(Shapes::size(shape) == S) {
-      viableShapes.push_back(shape);
-    }
-  }
+  const std::vector<Shapes::Shape>& viableShapes = Shapes::shapesOfSize(S);
   const unsigned shapesCount = viableShapes.size();
-  std::vector<Shapes::Continuous::ShapeResult> shapeMeasureResults (shapesCount);
+  auto shapeMeasureResults = std::move(
+    Shapes::Continuous::shapeCentroidLast({normalized}, viableShapes).front()
+  );
   std::vector<boost::optional<double>> randomCloudProbabilities (shapesCount);
 
-#pragma omp parallel for
   for(unsigned i = 0; i < shapesCount; ++i) {
     const Shapes::Shape candidateShape = viableShapes[i];
-    shapeMeasureResults[i] = Shapes::Continuous::shapeCentroidLast(normalized, candidateShape);
     // Shape classification for size 2 is better based on continuous shape measures themselves
     if(Shapes::size(candidateShape) > 2) {
       randomCloudProbabilities[i] = Shapes::Continuous::probabilityRandomCloud(shapeMeasureResults[i].measure, candidateShape);
@@ -232,7 +229,8 @@ bool AtomStereopermutator::Impl::thermalized(
   const Shapes::Shape shape,
   const RankingInformation& ranking
 ) {
-  if(Options::Thermalization::pyramidalInversion) {
+  const Options::Values options = Options::current();
+  if(options.pyramidalInversion) {
     /* Nitrogen atom inversion */
     constexpr unsigned nitrogenZ = Utils::ElementInfo::Z(Utils::ElementType::N);
     const bool isNitrogenIsotope = Utils::ElementInfo::Z(graph.elementType(centerAtom)) == nitrogenZ;
@@ -249,11 +247,11 @@ bool AtomStereopermutator::Impl::thermalized(
   }
 
   if(ranking.links.empty()) {
-    if(Options::Thermalization::berryPseudorotation && shape == Shapes::Shape::TrigonalBipyramid) {
+    if(options.berryPseudorotation && shape == Shapes::Shape::TrigonalBipyramid) {
       return true;
     }
 
-    if(Options::Thermalization::bartellMechanism && shape == Shapes::Shape::PentagonalBipyramid) {
+    if(options.bartellMechanism && shape == Shapes::Shape::PentagonalBipyramid) {
       return true;
     }
   }
@@ -287,7 +285,7 @@ AtomStereopermutator::Impl::Impl(
 
 /* Modification */
 void AtomStereopermutator::Impl::assign(boost::optional<unsigned> assignment) {
-  if(assignment && assignment.value() >= feasible_.indices.size()) {
+  if(assignment && assignment.value() >= feasible_.indices().size()) {
     throw std::out_of_range("Supplied assignment index is out of range");
   }
 
@@ -298,13 +296,8 @@ void AtomStereopermutator::Impl::assign(boost::optional<unsigned> assignment) {
    * assigning (AtomIndex -> unsigned).
    */
   if(assignmentOption_) {
-    shapePositionMap_ = siteToShapeVertexMap(
-      abstract_.permutations.list.at(
-        feasible_.indices.at(
-          assignmentOption_.value()
-        )
-      ),
-      abstract_.canonicalSites,
+    shapePositionMap_ = abstract_.siteToShapeVertexMap(
+      feasible_.indices().at(assignmentOption_.value()),
       ranking_.links
     );
   } else { // Wipe the map
@@ -347,10 +340,10 @@ void AtomStereopermutator::Impl::assign(std::vector<Shapes::Vertex> vertexMappin
    * as long as we use continuous shape measure-based shape classification.
    */
   boost::optional<unsigned> foundStereopermutation;
-  const unsigned A = feasible_.indices.size();
+  const unsigned A = feasible_.indices().size();
   for(unsigned a = 0; a < A; ++a) {
-    const auto& feasiblePermutation = abstract_.permutations.list.at(
-      feasible_.indices.at(a)
+    const auto& feasiblePermutation = abstract_.permutations->list.at(
+      feasible_.indices().at(a)
     );
     auto findIter = std::find(
       std::begin(soughtRotations),
@@ -382,9 +375,9 @@ void AtomStereopermutator::Impl::assignRandom(Random::Engine& engine) {
       Temple::Random::pickDiscrete(
         // Map the feasible permutations onto their weights
         Temple::map(
-          feasible_.indices,
+          feasible_.indices(),
           [&](const unsigned permutationIndex) -> unsigned {
-            return abstract_.permutations.weights.at(permutationIndex);
+            return abstract_.permutations->weights.at(permutationIndex);
           }
         ),
         engine
@@ -540,7 +533,7 @@ boost::optional<AtomStereopermutator::PropagatedState> AtomStereopermutator::Imp
     const auto shapeMapping = Temple::Optionals::flatMap(
       Shapes::getMapping(shape_, newShape, removedVertexOptional),
       [](const auto& mapping) {
-        return selectTransitionMapping(mapping, Options::chiralStatePreservation);
+        return selectTransitionMapping(mapping, Options::current().chiralStatePreservation);
       }
     );
 
@@ -619,11 +612,11 @@ boost::optional<AtomStereopermutator::PropagatedState> AtomStereopermutator::Imp
       auto allTrialRotations = Stereopermutations::generateAllRotations(trialStereopermutation, newShape);
 
       // Find out which of the new assignments has a rotational equivalent
-      for(unsigned i = 0; i < newAbstract.permutations.list.size(); ++i) {
+      for(unsigned i = 0; i < newAbstract.permutations->list.size(); ++i) {
         auto findIter = std::find(
           std::begin(allTrialRotations),
           std::end(allTrialRotations),
-          newAbstract.permutations.list.at(i)
+          newAbstract.permutations->list.at(i)
         );
         if(findIter != std::end(allTrialRotations)) {
           newStereopermutationOption = i;
@@ -640,17 +633,17 @@ boost::optional<AtomStereopermutator::PropagatedState> AtomStereopermutator::Imp
     newStereopermutationOption,
     [&](const unsigned stereopermutationIndex) -> boost::optional<unsigned> {
       auto assignmentFindIter = std::find(
-        std::begin(newFeasible.indices),
-        std::end(newFeasible.indices),
+        std::begin(newFeasible.indices()),
+        std::end(newFeasible.indices()),
         stereopermutationIndex
       );
 
-      if(assignmentFindIter == std::end(newFeasible.indices)) {
+      if(assignmentFindIter == std::end(newFeasible.indices())) {
         // The stereopermutation is infeasible
         return boost::none;
       }
 
-      return assignmentFindIter - std::begin(newFeasible.indices);
+      return assignmentFindIter - std::begin(newFeasible.indices());
     }
   );
 
@@ -832,7 +825,7 @@ boost::optional<unsigned> AtomStereopermutator::Impl::indexOfPermutation() const
 
   return Temple::Optionals::map(
     assignmentOption_,
-    Temple::Functor::at(feasible_.indices)
+    Temple::Functor::at(feasible_.indices())
   );
 }
 
@@ -957,7 +950,7 @@ unsigned AtomStereopermutator::Impl::numAssignments() const {
     return 1;
   }
 
-  return feasible_.indices.size();
+  return feasible_.indices().size();
 }
 
 unsigned AtomStereopermutator::Impl::numStereopermutations() const {
@@ -965,7 +958,7 @@ unsigned AtomStereopermutator::Impl::numStereopermutations() const {
     return 1;
   }
 
-  return abstract_.permutations.list.size();
+  return abstract_.permutations->list.size();
 }
 
 void AtomStereopermutator::Impl::setShape(
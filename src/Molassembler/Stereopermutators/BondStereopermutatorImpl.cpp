@@ -166,6 +166,10 @@ const Stereopermutations::Composite& BondStereopermutator::Impl::composite() con
   return composite_;
 }
 
+const std::vector<unsigned>& BondStereopermutator::Impl::feasiblePermutations() const {
+  return feasiblePermutations_;
+}
+
 double BondStereopermutator::Impl::dihedral(
   const AtomStereopermutator& stereopermutatorA,
   const SiteIndex siteIndexA,
@@ -799,6 +803,27 @@ BondStereopermutator::Impl::Impl(
     assignment_(boost::none)
 {}
 
+BondStereopermutator::Impl::Impl(
+  const StereopermutatorList& stereopermutators,
+  const BondIndex edge,
+  Alignment alignment,
+  std::vector<unsigned> feasiblePermutations
+) : composite_(constructComposite_(stereopermutators, edge, alignment)),
+    edge_(edge),
+    feasiblePermutations_(std::move(feasiblePermutations)),
+    assignment_(boost::none)
+{
+  if(
+    !std::is_sorted(std::begin(feasiblePermutations_), std::end(feasiblePermutations_))
+    || (
+      !feasiblePermutations_.empty()
+      && feasiblePermutations_.back() >= composite_.allPermutations().size()
+    )
+  ) {
+    throw std::out_of_range("Feasible stereopermutations do not match the composite");
+  }
+}
+
 /* Public members */
 /* Modification */
 void BondStereopermutator::Impl::assign(boost::optional<unsigned> assignment) {
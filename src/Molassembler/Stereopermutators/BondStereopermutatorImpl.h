@@ -94,6 +94,17 @@ struct BondStereopermutator::Impl : public Temple::Crtp::LexicographicComparable
     Alignment alignment
   );
 
+  /*!
+   * @brief Constructor for use of BondStereopermutator in a Molecule with
+   *   previously determined feasible stereopermutations
+   */
+  Impl(
+    const StereopermutatorList& stereopermutators,
+    BondIndex edge,
+    Alignment alignment,
+    std::vector<unsigned> feasiblePermutations
+  );
+
   void assign(boost::optional<unsigned> assignment);
 
   void assignRandom(Random::Engine& engine);
@@ -120,6 +131,8 @@ struct BondStereopermutator::Impl : public Temple::Crtp::LexicographicComparable
 
   const Stereopermutations::Composite& composite() const;
 
+  const std::vector<unsigned>& feasiblePermutations() const;
+
   double dihedral(
     const AtomStereopermutator& stereopermutatorA,
     SiteIndex siteIndexA,
@@ -11,6 +11,7 @@
 #include "Molassembler/Modeling/BondDistance.h"
 #include "Molassembler/Modeling/CommonTrig.h"
 #include "Molassembler/DistanceGeometry/SpatialModel.h"
+#include "Molassembler/Detail/Metrics.h"
 
 #include "Molassembler/Shapes/PropertyCaching.h"
 #include "Molassembler/Temple/Adaptors/CyclicFrame.h"
@@ -21,33 +22,204 @@ namespace Scine {
 namespace Molassembler {
 namespace Stereopermutators {
 
-bool Feasible::linkPossiblyFeasible(
-  const RankingInformation::Link& link,
+Feasible::Feasible(
+  const Abstract& abstractPermutations,
+  const Shapes::Shape shape,
   const AtomIndex placement,
-  const ConeAngleType& cones,
   const RankingInformation& ranking,
-  const Shapes::Shape shape,
-  const SiteToShapeVertexMap& shapeVertexMap,
   const Graph& graph
-) {
-  // The algorithm below is explained in detail in documents/denticity_feasibility
-  assert(link.cycleSequence.front() != link.cycleSequence.back());
+) : permutations_(abstractPermutations.permutations),
+    vertexMaps_(abstractPermutations.vertexMaps),
+    canonicalSites_(abstractPermutations.canonicalSites),
+    links_(ranking.links),
+    shape_(shape),
+    placementElement_(graph.elementType(placement))
+{
+  const Detail::Metrics::Timer timer {Detail::Metrics::Operation::FeasiblePermutations};
+  using ModelType = DistanceGeometry::SpatialModel;
+
+  siteDistances = Temple::map(
+    ranking.sites,
+    [&](const auto& siteAtomsList) -> DistanceGeometry::ValueBounds {
+      return ModelType::siteDistanceFromCenter(
+        siteAtomsList,
+        placement,
+        graph
+      );
+    }
+  );
+
+  coneAngles.reserve(ranking.sites.size());
+
+  for(unsigned i = 0; i < ranking.sites.size(); ++i) {
+    coneAngles.push_back(
+      ModelType::coneAngle(
+        ranking.sites.at(i),
+        siteDistances.at(i),
+        graph
+      )
+    );
+  }
+
+  siteSizes_ = Temple::map(
+    ranking.sites,
+    [](const auto& siteAtomsList) -> unsigned { return siteAtomsList.size(); }
+  );
+
+  // Gather everything the graph contributes to link feasibility
+  linkModels_ = Temple::map(
+    ranking.links,
+    [&](const RankingInformation::Link& link) -> LinkModel {
+      // The algorithm using this is explained in detail in documents/denticity_feasibility
+      assert(link.cycleSequence.front() != link.cycleSequence.back());
+      assert(link.cycleSequence.front() == placement);
+
+      LinkModel model;
+      model.cycleEdgeLengths = Temple::map(
+        Temple::Adaptors::cyclicFrame<2>(link.cycleSequence),
+        [&](const auto& i, const auto& j) -> double {
+          return ModelType::modelDistance(i, j, graph.inner());
+        }
+      );
+
+      model.elementTypes = Temple::map(
+        link.cycleSequence,
+        [&](const AtomIndex i) -> Utils::ElementType {
+          return graph.elementType(i);
+        }
+      );
+      // Drop the central index's element type from this map
+      model.elementTypes.erase(std::begin(model.elementTypes));
+
+      if(
+        ranking.sites.at(link.sites.first).size() == 1
+        && ranking.sites.at(link.sites.second).size() == 1
+      ) {
+        model.smallCycleAngle = ModelType::smallCycleSiteAngle(
+          placement,
+          ranking,
+          link.sites,
+          graph.inner()
+        );
+      }
+
+      return model;
+    }
+  );
+
+  /* Without links or haptic sites, all stereopermutations are feasible and
+   * there is nothing to defer
+   */
+  if(
+    links_.empty()
+    && Temple::all_of(siteSizes_, [](const unsigned size) { return size == 1; })
+  ) {
+    indices_ = std::make_shared<const std::vector<unsigned>>(
+      Temple::iota<unsigned>(maximumCount())
+    );
+  }
+}
+
+Feasible::Feasible(const Feasible& other)
+  : siteDistances(other.siteDistances),
+    coneAngles(other.coneAngles),
+    permutations_(other.permutations_),
+    vertexMaps_(other.vertexMaps_),
+    canonicalSites_(other.canonicalSites_),
+    links_(other.links_),
+    linkModels_(other.linkModels_),
+    siteSizes_(other.siteSizes_),
+    shape_(other.shape_),
+    placementElement_(other.placementElement_),
+    indices_(std::atomic_load(&other.indices_))
+{}
+
+Feasible& Feasible::operator = (const Feasible& other) {
+  Feasible copy {other};
+  *this = std::move(copy);
+  return *this;
+}
+
+unsigned Feasible::maximumCount() const {
+  if(!permutations_) {
+    return 0;
+  }
+
+  return permutations_->list.size();
+}
+
+bool Feasible::evaluated() const {
+  return static_cast<bool>(std::atomic_load(&indices_));
+}
+
+const std::vector<unsigned>& Feasible::indices() const {
+  if(auto evaluatedIndices = std::atomic_load(&indices_)) {
+    return *evaluatedIndices;
+  }
+
+  std::vector<unsigned> feasibleIndices;
+  const unsigned P = maximumCount();
+  feasibleIndices.reserve(P);
+  for(unsigned i = 0; i < P; ++i) {
+    const SiteToShapeVertexMap shapeVertexMap = vertexMaps_
+      ? vertexMaps_->at(*permutations_, i, canonicalSites_, links_)
+      : siteToShapeVertexMap(permutations_->list.at(i), canonicalSites_, links_);
+
+    if(possiblyFeasible_(shapeVertexMap)) {
+      feasibleIndices.push_back(i);
+    }
+  }
+  feasibleIndices.shrink_to_fit();
+
+  /* Concurrent first calls arrive at identical results. Keep whichever was
+   * stored first so that references handed out remain valid
+   */
+  std::shared_ptr<const std::vector<unsigned>> expected;
+  auto desired = std::make_shared<const std::vector<unsigned>>(std::move(feasibleIndices));
+  std::atomic_compare_exchange_strong(&indices_, &expected, desired);
+  return *std::atomic_load(&indices_);
+}
+
+double Feasible::siteCentralAngle_(
+  const std::pair<SiteIndex, SiteIndex>& sites,
+  const SiteToShapeVertexMap& shapeVertexMap,
+  const boost::optional<double>& smallCycleAngle
+) const {
+  /* Equivalent to SpatialModel::siteCentralAngle with the graph-dependent
+   * part precomputed: The shape distorts only between monoatomic sites at its
+   * smallest angle
+   */
+  const double idealAngle = Shapes::angleFunction(shape_)(
+    shapeVertexMap.at(sites.first),
+    shapeVertexMap.at(sites.second)
+  );
+
+  if(smallCycleAngle && idealAngle == Shapes::minimumAngle(shape_)) {
+    return smallCycleAngle.value();
+  }
+
+  return idealAngle;
+}
+
+bool Feasible::linkPossiblyFeasible_(
+  const unsigned linkIndex,
+  const SiteToShapeVertexMap& shapeVertexMap
+) const {
+  const RankingInformation::Link& link = links_.at(linkIndex);
+  const LinkModel& model = linkModels_.at(linkIndex);
 
   // Perform no checks if, for either of the sites, no cone angle could be calculated
-  if(!cones.at(link.sites.first) || !cones.at(link.sites.second)) {
+  if(!coneAngles.at(link.sites.first) || !coneAngles.at(link.sites.second)) {
     return true;
   }
 
-  const DistanceGeometry::ValueBounds siteIConeAngle = cones.at(link.sites.first).value();
-  const DistanceGeometry::ValueBounds siteJConeAngle = cones.at(link.sites.second).value();
+  const DistanceGeometry::ValueBounds siteIConeAngle = coneAngles.at(link.sites.first).value();
+  const DistanceGeometry::ValueBounds siteJConeAngle = coneAngles.at(link.sites.second).value();
 
-  const double symmetryAngle = DistanceGeometry::SpatialModel::siteCentralAngle(
-    placement,
-    shape,
-    ranking,
-    shapeVertexMap,
+  const double symmetryAngle = siteCentralAngle_(
     link.sites,
-    graph.inner()
+    shapeVertexMap,
+    model.smallCycleAngle
   );
 
   if(link.cycleSequence.size() == 3) {
@@ -58,7 +230,6 @@ bool Feasible::linkPossiblyFeasible(
      * distort the angle to enable the graph in some situations, and leave
      * the ideal angle preserved in others)
      */
-    assert(link.cycleSequence.front() == placement);
 
     /* TODO maybe it might be better to ask in a very boolean way whether
      * the shape is willing to distort for this particular link or not
@@ -66,18 +237,10 @@ bool Feasible::linkPossiblyFeasible(
      */
 
     return !Stereopermutators::triangleBondTooClose(
-      DistanceGeometry::SpatialModel::modelDistance(
-        placement,
-        link.cycleSequence[1],
-        graph.inner()
-      ),
-      DistanceGeometry::SpatialModel::modelDistance(
-        placement,
-        link.cycleSequence[2],
-        graph.inner()
-      ),
+      model.cycleEdgeLengths.front(),
+      model.cycleEdgeLengths.back(),
       symmetryAngle,
-      AtomInfo::bondRadius(graph.elementType(placement))
+      AtomInfo::bondRadius(placementElement_)
     );
   }
 
@@ -104,21 +267,12 @@ bool Feasible::linkPossiblyFeasible(
   // auto symmetryGroups = Shapes::Properties::positionGroupCharacters(shape);
 
 
-  /* First we need to construct the cyclic polygon of the cycle sequence
-   * without the central atom.
-   */
-  assert(link.cycleSequence.front() == placement);
-  auto cycleEdgeLengths = Temple::map(
-    Temple::Adaptors::cyclicFrame<2>(link.cycleSequence),
-    [&](const auto& i, const auto& j) -> double {
-      return DistanceGeometry::SpatialModel::modelDistance(i, j, graph.inner());
-    }
-  );
-
-  /* The first and last cycle edge lengths are from and to the central atom,
+  /* The cyclic polygon of the cycle sequence without the central atom: The
+   * first and last cycle edge lengths are from and to the central atom,
    * and so we remove those by combining alpha with those edge lengths
    * with the law of cosines
    */
+  auto cycleEdgeLengths = model.cycleEdgeLengths;
   const double a = cycleEdgeLengths.front();
   const double b = cycleEdgeLengths.back();
   const double c = CommonTrig::lawOfCosines(a, b, alpha); // B-A
@@ -128,50 +282,35 @@ bool Feasible::linkPossiblyFeasible(
 
   std::vector<Stereopermutators::BaseAtom> bases (1);
   auto& base = bases.front();
-  base.elementType = graph.elementType(placement);
+  base.elementType = placementElement_;
   base.distanceToLeft = a;
   base.distanceToRight = b;
 
-  auto elementTypes = Temple::map(
-    link.cycleSequence,
-    [&](const AtomIndex i) -> Utils::ElementType {
-      return graph.elementType(i);
-    }
-  );
-  // Drop the central index's element type from this map
-  elementTypes.erase(std::begin(elementTypes));
-
   return !Stereopermutators::cycleModelContradictsGraph(
-    elementTypes,
+    model.elementTypes,
     cycleEdgeLengths,
     bases
   );
 }
 
 bool Feasible::possiblyFeasible(
-  const Stereopermutations::Stereopermutation& stereopermutation,
-  const AtomIndex placement,
-  const RankingInformation::RankedSitesType& canonicalSites,
-  const ConeAngleType& coneAngles,
-  const RankingInformation& ranking,
-  const Shapes::Shape shape,
-  const Graph& graph
-) {
-  const auto shapeVertexMap = siteToShapeVertexMap(
-    stereopermutation,
-    canonicalSites,
-    ranking.links
+  const Stereopermutations::Stereopermutation& stereopermutation
+) const {
+  return possiblyFeasible_(
+    siteToShapeVertexMap(stereopermutation, canonicalSites_, links_)
   );
+}
 
+bool Feasible::possiblyFeasible_(const SiteToShapeVertexMap& shapeVertexMap) const {
   // Check if any haptic site cones intersect
-  const unsigned L = ranking.sites.size();
+  const unsigned L = siteSizes_.size();
   for(SiteIndex siteI {0}; siteI < L - 1; ++siteI) {
-    if(ranking.sites.at(siteI).size() == 1) {
+    if(siteSizes_.at(siteI) == 1) {
       continue;
     }
 
     for(SiteIndex siteJ {siteI + 1}; siteJ < L; ++siteJ) {
-      if(ranking.sites.at(siteJ).size() == 1) {
+      if(siteSizes_.at(siteJ) == 1) {
         continue;
       }
 
@@ -180,14 +319,11 @@ bool Feasible::possiblyFeasible(
         continue;
       }
 
-      // siteCentralAngle yields undistorted symmetry angles for haptic sites
-      const double symmetryAngle = DistanceGeometry::SpatialModel::siteCentralAngle(
-        placement,
-        shape,
-        ranking,
-        shapeVertexMap,
+      // Symmetry angles between haptic sites are undistorted
+      const double symmetryAngle = siteCentralAngle_(
         {siteI, siteJ},
-        graph.inner()
+        shapeVertexMap,
+        boost::none
       );
 
       /* A haptic steropermutation of sites is only feasible if the haptic
@@ -211,93 +347,14 @@ bool Feasible::possiblyFeasible(
    * atom are merged using the joint angle calculable from the
    * stereopermutation and shape.
    */
-  return Temple::all_of(
-    ranking.links,
-    [&](const auto& link) -> bool {
-      return linkPossiblyFeasible(
-        link,
-        placement,
-        coneAngles,
-        ranking,
-        shape,
-        shapeVertexMap,
-        graph
-      );
-    }
-  );
-}
-
-Feasible::Feasible(
-  const Abstract& abstractPermutations,
-  const Shapes::Shape shape,
-  const AtomIndex placement,
-  const RankingInformation& ranking,
-  const Graph& graph
-) {
-  using ModelType = DistanceGeometry::SpatialModel;
-
-  siteDistances = Temple::map(
-    ranking.sites,
-    [&](const auto& siteAtomsList) -> DistanceGeometry::ValueBounds {
-      return ModelType::siteDistanceFromCenter(
-        siteAtomsList,
-        placement,
-        graph
-      );
+  const unsigned linkCount = links_.size();
+  for(unsigned i = 0; i < linkCount; ++i) {
+    if(!linkPossiblyFeasible_(i, shapeVertexMap)) {
+      return false;
     }
-  );
-
-  coneAngles.reserve(ranking.sites.size());
-
-  for(unsigned i = 0; i < ranking.sites.size(); ++i) {
-    coneAngles.push_back(
-      ModelType::coneAngle(
-        ranking.sites.at(i),
-        siteDistances.at(i),
-        graph
-      )
-    );
   }
 
-  // Determine which permutations are feasible and which aren't
-  const unsigned P = abstractPermutations.permutations.list.size();
-  if(
-    // Links are present
-    !ranking.links.empty()
-    // OR there are haptic sites
-    || Temple::sum(
-      Temple::Adaptors::transform(
-        ranking.sites,
-        [](const auto& siteAtomsList) -> unsigned {
-          if(siteAtomsList.size() == 1) {
-            return 0;
-          }
-
-          return 1;
-        }
-      )
-    ) > 0
-  ) {
-    indices.reserve(P);
-    for(unsigned i = 0; i < P; ++i) {
-      if(
-        possiblyFeasible(
-          abstractPermutations.permutations.list.at(i),
-          placement,
-          abstractPermutations.canonicalSites,
-          coneAngles,
-          ranking,
-          shape,
-          graph
-        )
-      ) {
-        indices.push_back(i);
-      }
-    }
-    indices.shrink_to_fit();
-  } else {
-    indices = Temple::iota<unsigned>(P);
-  }
+  return true;
 }
 
 } // namespace Stereopermutators
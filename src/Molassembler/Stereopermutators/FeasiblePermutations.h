@@ -10,61 +10,42 @@
 
 #include "Molassembler/DistanceGeometry/ValueBounds.h"
 #include "Molassembler/Options.h"
-#include "Molassembler/Stereopermutators/ShapeVertexMaps.h"
+#include "Molassembler/Stereopermutators/AbstractPermutations.h"
 
 #include "Molassembler/Stereopermutation/Stereopermutation.h"
 
+#include "boost/optional.hpp"
+#include <memory>
+
 namespace Scine {
 namespace Molassembler {
 namespace Stereopermutators {
 
-// Forward-declarations
-struct Abstract;
-
+/**
+ * @brief Decides which abstract stereopermutations are feasible in three
+ *   dimensions
+ *
+ * The graph-dependent data needed to decide feasibility is gathered on
+ * construction, but abstract stereopermutations are checked only on the first
+ * call to indices(). Stereopermutators that are never assigned or whose
+ * number of assignments is never queried skip the checks entirely.
+ */
 struct Feasible {
 //!@name Public types
 //!@{
   using ConeAngleType = std::vector<
     boost::optional<DistanceGeometry::ValueBounds>
   >;
-//!@}
-
-//!@name Static functions
-//!@{
-  /*! @brief Determine whether a link is possibly feasible
-   *
-   * Catches some obviously impossible links, but does not imply
-   * that the link is truly feasible if the test passes.
-   *
-   * @todo Move this to SpatialModel
-   */
-  static bool linkPossiblyFeasible(
-    const RankingInformation::Link& link,
-    AtomIndex placement,
-    const ConeAngleType& cones,
-    const RankingInformation& ranking,
-    Shapes::Shape shape,
-    const SiteToShapeVertexMap& shapeVertexMap,
-    const Graph& graph
-  );
 
-  /*! @brief Determine whether a stereopermutation is possibly feasible
-   *
-   * Catches some obviously impossible stereopermutations, but does not
-   * imply that the stereopermutation is truly feasibly if the test passes.
-   *
-   * @complexity{@math{\Theta(L)}}
-   * @todo Move this to SpatialModel
-   */
-  static bool possiblyFeasible(
-    const Stereopermutations::Stereopermutation& stereopermutation,
-    AtomIndex placement,
-    const RankingInformation::RankedSitesType& canonicalSites,
-    const ConeAngleType& coneAngles,
-    const RankingInformation& ranking,
-    Shapes::Shape shape,
-    const Graph& graph
-  );
+  //! Graph-dependent data of a link needed to decide its feasibility
+  struct LinkModel {
+    //! Modeled lengths of the cycle edges, starting at the central atom
+    std::vector<double> cycleEdgeLengths;
+    //! Element types of the cycle atoms other than the central atom
+    std::vector<Utils::ElementType> elementTypes;
+    //! Site angle if the shape distorts at its smallest angle for a small cycle
+    boost::optional<double> smallCycleAngle;
+  };
 //!@}
 
 //!@name Constructors
@@ -73,8 +54,8 @@ struct Feasible {
   Feasible() = default;
 
   /**
-   * @brief Determines the subset of stereopermutations that are feasible in
-   *   three dimensions
+   * @brief Gathers the data needed to determine the subset of
+   *   stereopermutations that are feasible in three dimensions
    *
    * @param abstractPermutations The set of abstract stereopermutations
    * @param shape The underlying shape of the stereopermutator
@@ -83,8 +64,7 @@ struct Feasible {
    *   sites and substituents
    * @param graph The graph being modeled
    *
-   * @complexity{@math{\Theta(P\cdot L)} where @math{P} is the number of
-   * abstract stereopermutations and @math{L} is the number of links}
+   * @complexity{@math{\Theta(L)} where @math{L} is the number of links}
    */
   Feasible(
     const Abstract& abstractPermutations,
@@ -93,6 +73,49 @@ struct Feasible {
     const RankingInformation& ranking,
     const Graph& graph
   );
+
+  Feasible(const Feasible& other);
+  Feasible(Feasible&& other) = default;
+  Feasible& operator = (const Feasible& other);
+  Feasible& operator = (Feasible&& other) = default;
+//!@}
+
+//!@name Information
+//!@{
+  /*! @brief Upper bound on the number of feasible stereopermutations
+   *
+   * The number of abstract stereopermutations, available without checking
+   * their feasibility.
+   *
+   * @complexity{@math{\Theta(1)}}
+   */
+  unsigned maximumCount() const;
+
+  //! Whether feasibility of the abstract stereopermutations has been decided
+  bool evaluated() const;
+
+  /*! @brief Indices of the abstract stereopermutations that are feasible
+   *
+   * Checks every abstract stereopermutation on the first call. Concurrent
+   * calls are safe, although each may check the stereopermutations.
+   *
+   * @complexity{@math{\Theta(P\cdot L)} on the first call, where @math{P} is
+   * the number of abstract stereopermutations and @math{L} is the number of
+   * links, @math{\Theta(1)} afterwards}
+   */
+  const std::vector<unsigned>& indices() const;
+
+  /*! @brief Determine whether a stereopermutation is possibly feasible
+   *
+   * Catches some obviously impossible stereopermutations, but does not
+   * imply that the stereopermutation is truly feasibly if the test passes.
+   *
+   * @complexity{@math{\Theta(L)}}
+   * @todo Move this to SpatialModel
+   */
+  bool possiblyFeasible(
+    const Stereopermutations::Stereopermutation& stereopermutation
+  ) const;
 //!@}
 
 //!@name Data members
@@ -102,10 +125,41 @@ struct Feasible {
 
   //! Mapping from site index to cone angle optional
   ConeAngleType coneAngles;
-
-  //! Vector of permutation indices that are feasible
-  std::vector<unsigned> indices;
 //!@}
+
+private:
+  //! Determine whether sites at their shape vertices are possibly feasible
+  bool possiblyFeasible_(const SiteToShapeVertexMap& shapeVertexMap) const;
+
+  /*! @brief Determine whether a link is possibly feasible
+   *
+   * Catches some obviously impossible links, but does not imply
+   * that the link is truly feasible if the test passes.
+   */
+  bool linkPossiblyFeasible_(
+    unsigned linkIndex,
+    const SiteToShapeVertexMap& shapeVertexMap
+  ) const;
+
+  //! Angle between two sites at their shape vertices, distorted by small cycles
+  double siteCentralAngle_(
+    const std::pair<SiteIndex, SiteIndex>& sites,
+    const SiteToShapeVertexMap& shapeVertexMap,
+    const boost::optional<double>& smallCycleAngle
+  ) const;
+
+  std::shared_ptr<const Stereopermutations::Uniques> permutations_;
+  //! Memoized site to shape vertex maps shared with the abstract permutations
+  std::shared_ptr<Abstract::VertexMaps> vertexMaps_;
+  RankingInformation::RankedSitesType canonicalSites_;
+  std::vector<RankingInformation::Link> links_;
+  std::vector<LinkModel> linkModels_;
+  //! Number of atoms of each site
+  std::vector<unsigned> siteSizes_;
+  Shapes::Shape shape_ = Shapes::Shape::Line;
+  Utils::ElementType placementElement_ = Utils::ElementType::none;
+  //! Feasible stereopermutation indices, accessed atomically once evaluated
+  mutable std::shared_ptr<const std::vector<unsigned>> indices_;
 };
 
 } // namespace Stereopermutators
@@ -7,95 +7,183 @@
 #include "Molassembler/Stereopermutators/StereopermutatorListImpl.h"
 
 #include "Molassembler/Temple/Functional.h"
-#include "boost/range/adaptor/map.hpp"
+#include <algorithm>
+#include <cassert>
 
 namespace Scine {
 namespace Molassembler {
 
-AtomStereopermutator& StereopermutatorList::Impl::add(
+AtomStereopermutator& AtomStereopermutatorSlots::insert(
+  const AtomIndex i,
   AtomStereopermutator stereopermutator
 ) {
-  const AtomIndex i = stereopermutator.placement();
+  if(i >= slots_.size()) {
+    slots_.resize(i + 1);
+  }
+
+  assert(!slots_[i]);
+  slots_[i] = std::move(stereopermutator);
+  ++count_;
+  return *slots_[i];
+}
+
+bool AtomStereopermutatorSlots::erase(const AtomIndex i) {
+  if(i < slots_.size() && slots_[i]) {
+    slots_[i] = boost::none;
+    --count_;
+    return true;
+  }
+
+  return false;
+}
+
+void AtomStereopermutatorSlots::applyPermutation(const std::vector<AtomIndex>& permutation) {
+  /* Each stereopermutator is moved into the slot of its new placement.
+   * Distinct stereopermutators have distinct placements, so the writes into
+   * the new slots never overlap and need no synchronization.
+   */
+  Slots permutedSlots(std::max(permutation.size(), slots_.size()));
+  const int S = slots_.size();
+#pragma omp parallel for schedule(dynamic)
+  for(int i = 0; i < S; ++i) {
+    if(Slot& slot = slots_[i]) {
+      slot->applyPermutation(permutation);
+      const AtomIndex placement = slot->placement();
+      permutedSlots[placement] = std::move(slot);
+    }
+  }
+  std::swap(slots_, permutedSlots);
+}
+
+bool AtomStereopermutatorSlots::operator == (const AtomStereopermutatorSlots& other) const {
+  if(count_ != other.count_) {
+    return false;
+  }
+
+  const unsigned common = std::min(slots_.size(), other.slots_.size());
+  for(unsigned i = 0; i < common; ++i) {
+    if(slots_[i] != other.slots_[i]) {
+      return false;
+    }
+  }
+
+  /* With equal counts and equal common slots, any trailing slots of the
+   * longer storage must be empty
+   */
+  return true;
+}
+
+namespace {
+
+struct PlacementLess {
+  bool operator() (const BondStereopermutator& a, const BondIndex& b) const {
+    return a.placement() < b;
+  }
+
+  bool operator() (const BondStereopermutator& a, const BondStereopermutator& b) const {
+    return a.placement() < b.placement();
+  }
+};
 
-  auto emplaceResult = atomStereopermutators.emplace(
-    i,
-    std::move(stereopermutator)
+} // namespace
+
+BondStereopermutator* BondStereopermutatorSequence::find(const BondIndex& bond) {
+  auto findIter = std::lower_bound(
+    std::begin(sequence_),
+    std::end(sequence_),
+    bond,
+    PlacementLess {}
   );
 
-  if(!emplaceResult.second) {
-    throw std::logic_error("Stereopermutator not added. Another is already at its place");
+  if(findIter != std::end(sequence_) && findIter->placement() == bond) {
+    return &(*findIter);
   }
 
-  return emplaceResult.first->second;
+  return nullptr;
 }
 
-BondStereopermutator& StereopermutatorList::Impl::add(
+const BondStereopermutator* BondStereopermutatorSequence::find(const BondIndex& bond) const {
+  auto findIter = std::lower_bound(
+    std::begin(sequence_),
+    std::end(sequence_),
+    bond,
+    PlacementLess {}
+  );
+
+  if(findIter != std::end(sequence_) && findIter->placement() == bond) {
+    return &(*findIter);
+  }
+
+  return nullptr;
+}
+
+BondStereopermutator& BondStereopermutatorSequence::insert(
   BondStereopermutator stereopermutator
 ) {
-  const BondIndex edge = stereopermutator.placement();
+  auto insertIter = std::lower_bound(
+    std::begin(sequence_),
+    std::end(sequence_),
+    stereopermutator.placement(),
+    PlacementLess {}
+  );
+
+  assert(insertIter == std::end(sequence_) || !(insertIter->placement() == stereopermutator.placement()));
+  return *sequence_.insert(insertIter, std::move(stereopermutator));
+}
 
-  auto emplaceResult = bondStereopermutators.emplace(
-    edge,
-    std::move(stereopermutator)
+bool BondStereopermutatorSequence::erase(const BondIndex& bond) {
+  auto findIter = std::lower_bound(
+    std::begin(sequence_),
+    std::end(sequence_),
+    bond,
+    PlacementLess {}
   );
 
-  if(!emplaceResult.second) {
-    throw std::logic_error("Stereopermutator not added. Another is already at its place");
+  if(findIter != std::end(sequence_) && findIter->placement() == bond) {
+    sequence_.erase(findIter);
+    return true;
   }
 
-  return emplaceResult.first->second;
+  return false;
 }
 
-
-//! Apply an index mapping to the list of stereopermutators
-void StereopermutatorList::Impl::applyPermutation(const std::vector<AtomIndex>& permutation) {
-  // C++17 splice / merge maybe?
-  AtomMapType newAtomMap;
-
-  /* A note on the parallelism:
-   * This is safe because we are not actually mutating the unordered_map
-   * itself, merely the elements stored in it. The access path towards other
-   * elements does not change merely because we mutate the values. For that to
-   * happen, we would have to mutate keys, which we aren't doing.
-   *
-   * Inserting into the new atom map does have to be managed, though.
+void BondStereopermutatorSequence::applyPermutation(const std::vector<AtomIndex>& permutation) {
+  /* applyPermutation on BondStereopermutators is really cheap, so this is not
+   * worth parallelizing
    */
-
-  auto applyPermutationAndMoveAtomStereopermutator = [&](AtomStereopermutator& permutator) -> void {
+  for(BondStereopermutator& permutator : sequence_) {
     permutator.applyPermutation(permutation);
-#pragma omp critical(applyPermutationAtomMapMutation)
-    {
-      const AtomIndex placement = permutator.placement();
-      newAtomMap.emplace(placement, std::move(permutator));
-    }
-  };
-
-#pragma omp parallel
-  {
-#pragma omp single
-    {
-      for(auto& mapPair : atomStereopermutators) {
-        AtomStereopermutator& permutator = mapPair.second;
-#pragma omp task
-        {
-          applyPermutationAndMoveAtomStereopermutator(permutator);
-        }
-      }
-    }
   }
-  std::swap(newAtomMap, atomStereopermutators);
+  std::sort(std::begin(sequence_), std::end(sequence_), PlacementLess {});
+}
 
-  /* Create a new bond map (this is not worth parallelizing, applyPermutation
-   * on BondStereopermutators is really cheap so the threads just get in each
-   * others way mutating newBondMap)
-   */
-  BondMapType newBondMap;
-  for(auto& mapPair : bondStereopermutators) {
-    BondStereopermutator& permutator = mapPair.second;
-    permutator.applyPermutation(permutation);
-    newBondMap.emplace(permutator.placement(), std::move(permutator));
+AtomStereopermutator& StereopermutatorList::Impl::add(
+  AtomStereopermutator stereopermutator
+) {
+  const AtomIndex i = stereopermutator.placement();
+
+  if(atomStereopermutators.find(i) != nullptr) {
+    throw std::logic_error("Stereopermutator not added. Another is already at its place");
   }
-  std::swap(newBondMap, bondStereopermutators);
+
+  return atomStereopermutators.insert(i, std::move(stereopermutator));
+}
+
+BondStereopermutator& StereopermutatorList::Impl::add(
+  BondStereopermutator stereopermutator
+) {
+  if(bondStereopermutators.find(stereopermutator.placement()) != nullptr) {
+    throw std::logic_error("Stereopermutator not added. Another is already at its place");
+  }
+
+  return bondStereopermutators.insert(std::move(stereopermutator));
+}
+
+
+//! Apply an index mapping to the list of stereopermutators
+void StereopermutatorList::Impl::applyPermutation(const std::vector<AtomIndex>& permutation) {
+  atomStereopermutators.applyPermutation(permutation);
+  bondStereopermutators.applyPermutation(permutation);
 }
 
 void StereopermutatorList::Impl::clear() {
@@ -109,15 +197,12 @@ void StereopermutatorList::Impl::clearBonds() {
 
 void StereopermutatorList::Impl::propagateVertexRemoval(const AtomIndex removedIndex) {
   // Drop any stereopermutators involving this atom from the list
-  auto findIter = atomStereopermutators.find(removedIndex);
-  if(findIter != atomStereopermutators.end()) {
-    atomStereopermutators.erase(findIter);
-  }
+  atomStereopermutators.erase(removedIndex);
 
   /* Go through all state in the StereopermutatorList and decrement any indices
    * larger than the one being removed
    */
-  for(auto& stereopermutators : atomStereopermutators | boost::adaptors::map_values) {
+  for(auto& stereopermutators : atomStereopermutators) {
     stereopermutators.propagateVertexRemoval(removedIndex);
   }
 
@@ -127,64 +212,52 @@ void StereopermutatorList::Impl::propagateVertexRemoval(const AtomIndex removedI
 }
 
 void StereopermutatorList::Impl::remove(const AtomIndex index) {
-  auto findIter = atomStereopermutators.find(index);
-
-  if(findIter != atomStereopermutators.end()) {
-    atomStereopermutators.erase(findIter);
-  } else {
+  if(!atomStereopermutators.erase(index)) {
     throw std::logic_error("No such atom stereopermutator found!");
   }
 }
 
 void StereopermutatorList::Impl::remove(const BondIndex& edge) {
-  auto findIter = bondStereopermutators.find(edge);
-
-  if(findIter != bondStereopermutators.end()) {
-    bondStereopermutators.erase(findIter);
-  } else {
+  if(!bondStereopermutators.erase(edge)) {
     throw std::logic_error("No such bond stereopermutator found!");
   }
 }
 
 void StereopermutatorList::Impl::try_remove(const AtomIndex index) {
-  auto findIter = atomStereopermutators.find(index);
-
-  if(findIter != atomStereopermutators.end()) {
-    atomStereopermutators.erase(findIter);
-  }
+  atomStereopermutators.erase(index);
 }
 
 void StereopermutatorList::Impl::try_remove(const BondIndex& edge) {
-  auto findIter = bondStereopermutators.find(edge);
-
-  if(findIter != bondStereopermutators.end()) {
-    bondStereopermutators.erase(findIter);
-  }
+  bondStereopermutators.erase(edge);
 }
 
 AtomStereopermutator& StereopermutatorList::Impl::at(const AtomIndex index) {
-  return atomStereopermutators.at(index);
+  if(AtomStereopermutator* stereopermutatorPtr = atomStereopermutators.find(index)) {
+    return *stereopermutatorPtr;
+  }
+
+  throw std::out_of_range("No atom stereopermutator at this index");
 }
 
 BondStereopermutator& StereopermutatorList::Impl::at(const BondIndex& index) {
-  return bondStereopermutators.at(index);
+  if(BondStereopermutator* stereopermutatorPtr = bondStereopermutators.find(index)) {
+    return *stereopermutatorPtr;
+  }
+
+  throw std::out_of_range("No bond stereopermutator on this bond");
 }
 
 boost::optional<AtomStereopermutator&> StereopermutatorList::Impl::option(const AtomIndex index) {
-  auto findIter = atomStereopermutators.find(index);
-
-  if(findIter != atomStereopermutators.end()) {
-    return findIter->second;
+  if(AtomStereopermutator* stereopermutatorPtr = atomStereopermutators.find(index)) {
+    return *stereopermutatorPtr;
   }
 
   return boost::none;
 }
 
 boost::optional<BondStereopermutator&> StereopermutatorList::Impl::option(const BondIndex& edge) {
-  auto findIter = bondStereopermutators.find(edge);
-
-  if(findIter != bondStereopermutators.end()) {
-    return findIter->second;
+  if(BondStereopermutator* stereopermutatorPtr = bondStereopermutators.find(edge)) {
+    return *stereopermutatorPtr;
   }
 
   return boost::none;
@@ -208,28 +281,32 @@ unsigned StereopermutatorList::Impl::size() const {
 }
 
 const AtomStereopermutator& StereopermutatorList::Impl::at(const AtomIndex index) const {
-  return atomStereopermutators.at(index);
+  if(const AtomStereopermutator* stereopermutatorPtr = atomStereopermutators.find(index)) {
+    return *stereopermutatorPtr;
+  }
+
+  throw std::out_of_range("No atom stereopermutator at this index");
 }
 
 const BondStereopermutator& StereopermutatorList::Impl::at(const BondIndex& index) const {
-  return bondStereopermutators.at(index);
+  if(const BondStereopermutator* stereopermutatorPtr = bondStereopermutators.find(index)) {
+    return *stereopermutatorPtr;
+  }
+
+  throw std::out_of_range("No bond stereopermutator on this bond");
 }
 
 boost::optional<const AtomStereopermutator&> StereopermutatorList::Impl::option(const AtomIndex index) const {
-  auto findIter = atomStereopermutators.find(index);
-
-  if(findIter != atomStereopermutators.end()) {
-    return findIter->second;
+  if(const AtomStereopermutator* stereopermutatorPtr = atomStereopermutators.find(index)) {
+    return *stereopermutatorPtr;
   }
 
   return boost::none;
 }
 
 boost::optional<const BondStereopermutator&> StereopermutatorList::Impl::option(const BondIndex& edge) const {
-  auto findIter = bondStereopermutators.find(edge);
-
-  if(findIter != bondStereopermutators.end()) {
-    return findIter->second;
+  if(const BondStereopermutator* stereopermutatorPtr = bondStereopermutators.find(edge)) {
+    return *stereopermutatorPtr;
   }
 
   return boost::none;
@@ -237,12 +314,12 @@ boost::optional<const BondStereopermutator&> StereopermutatorList::Impl::option(
 
 bool StereopermutatorList::Impl::hasZeroAssignmentStereopermutators() const {
   return Temple::any_of(
-    atomStereopermutators | boost::adaptors::map_values,
+    atomStereopermutators,
     [](const auto& stereopermutator) -> bool {
       return stereopermutator.numAssignments() == 0u;
     }
   ) || Temple::any_of(
-    bondStereopermutators | boost::adaptors::map_values,
+    bondStereopermutators,
     [](const auto& stereopermutator) -> bool {
       return stereopermutator.numAssignments() == 0u;
     }
@@ -251,12 +328,12 @@ bool StereopermutatorList::Impl::hasZeroAssignmentStereopermutators() const {
 
 bool StereopermutatorList::Impl::hasUnassignedStereopermutators() const {
   return Temple::any_of(
-    atomStereopermutators | boost::adaptors::map_values,
+    atomStereopermutators,
     [](const auto& stereopermutator) -> bool {
       return !stereopermutator.assigned();
     }
   ) || Temple::any_of(
-    bondStereopermutators | boost::adaptors::map_values,
+    bondStereopermutators,
     [](const auto& stereopermutator) -> bool {
       return !stereopermutator.assigned();
     }
@@ -277,7 +354,7 @@ bool StereopermutatorList::Impl::compare(
     }
 
     // Check all atom stereopermutators
-    for(const auto& stereopermutator : atomStereopermutators | boost::adaptors::map_values) {
+    for(const auto& stereopermutator : atomStereopermutators) {
       auto otherStereopermutatorOption = other.option(stereopermutator.placement());
 
       // Ensure there is a matching stereopermutator
@@ -299,7 +376,7 @@ bool StereopermutatorList::Impl::compare(
     }
 
     // Check all bond stereopermutators
-    for(const auto& stereopermutator : bondStereopermutators | boost::adaptors::map_values) {
+    for(const auto& stereopermutator : bondStereopermutators) {
       auto otherStereopermutatorOption = other.option(stereopermutator.placement());
 
       // Ensure there is a matching stereopermutator
@@ -11,14 +11,252 @@
 #include "Molassembler/StereopermutatorList.h"
 #include "Molassembler/BondStereopermutator.h"
 
-#include <unordered_map>
+#include "boost/optional.hpp"
+
+#include <vector>
 
 namespace Scine {
 namespace Molassembler {
 
+/**
+ * @brief Flat storage of atom stereopermutators addressed by atom index
+ *
+ * Each atom index has a slot that is either empty or holds the atom
+ * stereopermutator placed on it. Since distinct atoms own distinct slots,
+ * stereopermutators can be moved between slots concurrently without locking.
+ * Iteration skips empty slots and proceeds in order of increasing index.
+ */
+class AtomStereopermutatorSlots {
+public:
+  using Slot = boost::optional<AtomStereopermutator>;
+  using Slots = std::vector<Slot>;
+
+  //! Forward iterator over the occupied slots
+  template<typename Value, typename SlotIterator>
+  class Iterator {
+  public:
+    using difference_type = std::ptrdiff_t;
+    using value_type = std::remove_const_t<Value>;
+    using pointer = Value*;
+    using reference = Value&;
+    using iterator_category = std::forward_iterator_tag;
+
+    Iterator() = default;
+    Iterator(SlotIterator position, SlotIterator end)
+      : position_(position), end_(end) {
+      skipEmpty_();
+    }
+
+    Iterator& operator ++ () {
+      ++position_;
+      skipEmpty_();
+      return *this;
+    }
+
+    Iterator operator ++ (int) {
+      Iterator copy = *this;
+      ++(*this);
+      return copy;
+    }
+
+    reference operator * () const {
+      return **position_;
+    }
+
+    pointer operator -> () const {
+      return &(**position_);
+    }
+
+    bool operator == (const Iterator& other) const {
+      return position_ == other.position_;
+    }
+
+    bool operator != (const Iterator& other) const {
+      return position_ != other.position_;
+    }
+
+  private:
+    void skipEmpty_() {
+      while(position_ != end_ && !*position_) {
+        ++position_;
+      }
+    }
+
+    SlotIterator position_;
+    SlotIterator end_;
+  };
+
+  using iterator = Iterator<AtomStereopermutator, Slots::iterator>;
+  using const_iterator = Iterator<const AtomStereopermutator, Slots::const_iterator>;
+
+  /*! @brief Fetch the stereopermutator at an index, if present
+   *
+   * @complexity{@math{\Theta(1)}}
+   * @returns nullptr if the slot is empty
+   */
+  AtomStereopermutator* find(const AtomIndex i) {
+    if(i < slots_.size() && slots_[i]) {
+      return &(*slots_[i]);
+    }
+    return nullptr;
+  }
+
+  //! @overload
+  const AtomStereopermutator* find(const AtomIndex i) const {
+    if(i < slots_.size() && slots_[i]) {
+      return &(*slots_[i]);
+    }
+    return nullptr;
+  }
+
+  /*! @brief Place a stereopermutator into an empty slot
+   *
+   * @complexity{@math{\Theta(1)} amortized}
+   * @pre The slot at @p i is empty
+   */
+  AtomStereopermutator& insert(AtomIndex i, AtomStereopermutator stereopermutator);
+
+  /*! @brief Empty the slot at an index
+   *
+   * @complexity{@math{\Theta(1)}}
+   * @returns Whether the slot was occupied
+   */
+  bool erase(AtomIndex i);
+
+  /*! @brief Move each stereopermutator into the slot of its placement
+   *
+   * Applies the index permutation to each stereopermutator and scatters them
+   * into a new set of slots in parallel.
+   *
+   * @complexity{@math{\Theta(N)}}
+   * @pre The permutation maps each occupied slot's index to a distinct index
+   */
+  void applyPermutation(const std::vector<AtomIndex>& permutation);
+
+  //! Empty all slots
+  void clear() {
+    slots_.clear();
+    count_ = 0;
+  }
+
+  //! Number of stereopermutators
+  unsigned size() const {
+    return count_;
+  }
+
+  //! Whether there are no stereopermutators
+  bool empty() const {
+    return count_ == 0;
+  }
+
+  iterator begin() {
+    return {std::begin(slots_), std::end(slots_)};
+  }
+
+  iterator end() {
+    return {std::end(slots_), std::end(slots_)};
+  }
+
+  const_iterator begin() const {
+    return {std::begin(slots_), std::end(slots_)};
+  }
+
+  const_iterator end() const {
+    return {std::end(slots_), std::end(slots_)};
+  }
+
+  //! Equality of the occupied slots, independent of trailing empty slots
+  bool operator == (const AtomStereopermutatorSlots& other) const;
+
+private:
+  Slots slots_;
+  unsigned count_ = 0;
+};
+
+/**
+ * @brief Flat storage of bond stereopermutators sorted by bond index
+ *
+ * Lookups are binary searches over a contiguous sequence. Insertions and
+ * removals shift the stereopermutators following their position, which
+ * invalidates references to them.
+ */
+class BondStereopermutatorSequence {
+public:
+  using Sequence = std::vector<BondStereopermutator>;
+  using iterator = Sequence::iterator;
+  using const_iterator = Sequence::const_iterator;
+
+  /*! @brief Fetch the stereopermutator on a bond, if present
+   *
+   * @complexity{@math{\Theta(\log B)}}
+   * @returns nullptr if there is no stereopermutator on the bond
+   */
+  BondStereopermutator* find(const BondIndex& bond);
+
+  //! @overload
+  const BondStereopermutator* find(const BondIndex& bond) const;
+
+  /*! @brief Insert a stereopermutator at its sorted position
+   *
+   * @complexity{@math{O(B)}}
+   * @pre There is no stereopermutator on the same bond
+   */
+  BondStereopermutator& insert(BondStereopermutator stereopermutator);
+
+  /*! @brief Remove the stereopermutator on a bond
+   *
+   * @complexity{@math{O(B)}}
+   * @returns Whether there was a stereopermutator on the bond
+   */
+  bool erase(const BondIndex& bond);
+
+  /*! @brief Apply an index permutation to all stereopermutators and re-sort
+   *
+   * @complexity{@math{\Theta(B \log B)}}
+   */
+  void applyPermutation(const std::vector<AtomIndex>& permutation);
+
+  //! Remove all stereopermutators
+  void clear() {
+    sequence_.clear();
+  }
+
+  //! Number of stereopermutators
+  unsigned size() const {
+    return sequence_.size();
+  }
+
+  //! Whether there are no stereopermutators
+  bool empty() const {
+    return sequence_.empty();
+  }
+
+  iterator begin() {
+    return std::begin(sequence_);
+  }
+
+  iterator end() {
+    return std::end(sequence_);
+  }
+
+  const_iterator begin() const {
+    return std::begin(sequence_);
+  }
+
+  const_iterator end() const {
+    return std::end(sequence_);
+  }
+
+  //! Element-wise equality, which is independent of insertion order
+  bool operator == (const BondStereopermutatorSequence& other) const {
+    return sequence_ == other.sequence_;
+  }
+
+private:
+  Sequence sequence_;
+};
+
 struct StereopermutatorList::Impl {
-  using AtomMapType = std::unordered_map<AtomIndex, AtomStereopermutator>;
-  using BondMapType = std::unordered_map<BondIndex, BondStereopermutator, boost::hash<BondIndex>>;
 
 //!@name Modification
 //!@{
@@ -36,7 +274,7 @@ struct StereopermutatorList::Impl {
    * @throws std::out_of_range If there is no bond stereopermutator on the
    * passed bond
    *
-   * @complexity{@math{\Theta(1)}}
+   * @complexity{@math{\Theta(\log B)}}
    */
   BondStereopermutator& at(const BondIndex& index);
 
@@ -50,7 +288,7 @@ struct StereopermutatorList::Impl {
 
   /*! @brief Add a new BondStereopermutator to the list
    *
-   * @complexity{@math{\Theta(1)} amortized}
+   * @complexity{@math{O(B)}}
    *
    * @returns An iterator pointing to the added stereopermutator
    */
@@ -58,10 +296,11 @@ struct StereopermutatorList::Impl {
 
   /*! @brief Apply an index mapping to the list of stereopermutators
    *
-   * Applies the permutation to its maps, transforming the keys (atom and bond
-   * indices) and all stereopermutators.
+   * Applies the permutation to its containers, transforming the keys (atom
+   * and bond indices) and all stereopermutators. Atom stereopermutators are
+   * permuted in parallel.
    *
-   * @complexity{@math{\Theta(A + B)}}
+   * @complexity{@math{\Theta(N + B)}}
    */
   void applyPermutation(const std::vector<AtomIndex>& permutation);
 
@@ -85,7 +324,7 @@ struct StereopermutatorList::Impl {
 
   /*! @brief Fetch a reference-option to a BondStereopermutator
    *
-   * @complexity{@math{\Theta(1)}}
+   * @complexity{@math{\Theta(\log B)}}
    */
   boost::optional<BondStereopermutator&> option(const BondIndex& edge);
 
@@ -107,7 +346,7 @@ struct StereopermutatorList::Impl {
 
   /*! @brief Removes the BondStereopermutator on a specified edge
    *
-   * @complexity{@math{\Theta(1)}}
+   * @complexity{@math{O(B)}}
    */
   void remove(const BondIndex& edge);
 
@@ -119,7 +358,7 @@ struct StereopermutatorList::Impl {
 
   /*! @brief Removes the BondStereopermutator on a specified edge, if present
    *
-   * @complexity{@math{\Theta(1)}}
+   * @complexity{@math{O(B)}}
    */
   void try_remove(const BondIndex& edge);
 //!@}
@@ -140,7 +379,7 @@ struct StereopermutatorList::Impl {
    * @throws std::out_of_range If there is no bond stereopermutator on the
    * passed bond
    *
-   * @complexity{@math{\Theta(1)}}
+   * @complexity{@math{\Theta(\log B)}}
    */
   const BondStereopermutator& at(const BondIndex& index) const;
 
@@ -179,7 +418,7 @@ struct StereopermutatorList::Impl {
 
   /*! @brief Fetch a const ref-option to a BondStereopermutator, if present
    *
-   * @complexity{@math{\Theta(1)}}
+   * @complexity{@math{\Theta(\log B)}}
    */
   boost::optional<const BondStereopermutator&> option(const BondIndex& edge) const;
 
@@ -212,10 +451,10 @@ struct StereopermutatorList::Impl {
 //!@}
 
   //! The underlying storage for atom stereopermutators
-  AtomMapType atomStereopermutators;
+  AtomStereopermutatorSlots atomStereopermutators;
 
   //! The underlying storage for bond stereopermutators
-  BondMapType bondStereopermutators;
+  BondStereopermutatorSequence bondStereopermutators;
 };
 
 } // namespace Molassembler
@@ -6,7 +6,6 @@
 
 #include "Molassembler/Subgraphs.h"
 
-#include "boost/graph/mcgregor_common_subgraphs.hpp"
 #include "boost/graph/vf2_sub_graph_iso.hpp"
 
 #include "Molassembler/Shapes/PropertyCaching.h"
@@ -18,6 +17,13 @@
 #include "Molassembler/StereopermutatorList.h"
 #include "Molassembler/Temple/Functional.h"
 
+#include "Utils/Geometry/ElementInfo.h"
+
+#include <array>
+#include <bitset>
+#include <exception>
+#include <set>
+
 /* TODO
  * - Missing algorithm for stereopermutator extension
  * - Ensure comparisons are symmetric! I.e. not needle-haystack but
@@ -29,225 +35,425 @@ namespace Molassembler {
 namespace Subgraphs {
 namespace {
 
-bool isHydrogenPermutation(
-  const IndexMap& a,
-  const IndexMap& b,
-  const Graph& right
-) {
-  /* Left maps are ordered in their first index, so we can
-   * sequentially compare elements of the mapping.
-   *
-   * The idea here is that if the mapping is sequence identical
-   * regarding non-hydrogen elements, then it must be a permutation
-   * thereof. This is much cheaper than using std::is_permutation.
-   */
-  return std::equal(
-    std::begin(a.left),
-    std::end(a.left),
-    std::begin(b.left),
-    std::end(b.left),
-    [&](const auto& firstMap, const auto& secondMap) -> bool {
-      // Ensure left-sequence identical
-      if(firstMap.first != secondMap.first) {
-        return false;
-      }
+template<typename Enum>
+auto underlying(Enum a) {
+  return static_cast<std::underlying_type_t<Enum>>(a);
+}
 
-      /* Do not compare mapped indices if the elements of the mapped vertices
-       * are hydrogen
-       */
-      if(
-        right.elementType(firstMap.second) == Utils::ElementType::H
-        && right.elementType(secondMap.second) == Utils::ElementType::H
-      ) {
-        return true;
-      }
+struct PartialMolecule {
+  using MaybePermutators = boost::optional<const StereopermutatorList&>;
+
+  explicit PartialMolecule(const Molecule& molecule) : graph(molecule.graph()), permutatorsOption(molecule.stereopermutators()) {}
+  explicit PartialMolecule(const Graph& passGraph) : graph(passGraph), permutatorsOption(boost::none) {}
+
+  const Graph& graph;
+  MaybePermutators permutatorsOption;
+};
+
+/**
+ * @brief Helper object to compare edges between two molecules
+ */
+struct EdgeComparator {
+  EdgeComparator(PartialMolecule a, PartialMolecule b, const EdgeStrictness passStrictness)
+    : data({std::move(a), std::move(b)}), strictness(passStrictness)
+    {}
 
-      // Compare target vertices of the mappings
-      return (firstMap.second == secondMap.second);
+  bool operator () (const PrivateGraph::Edge i, const PrivateGraph::Edge j) const {
+    if(
+      underlying(strictness) >= underlying(EdgeStrictness::BondType)
+      && data.first.graph.inner().bondType(i) != data.second.graph.inner().bondType(j)
+    ) {
+      return false;
     }
-  );
-}
 
-struct SubgraphCallback {
-  AtomIndex N;
-  using IndexMapVector = std::vector<IndexMap>;
-  const Graph& targetGraph;
-  std::reference_wrapper<IndexMapVector> mappingsRef;
-  bool removeHydrogenPermutations = true;
+    if(underlying(strictness) >= underlying(EdgeStrictness::SubsumeStereopermutation)) {
+      throw std::logic_error("Not implemented!");
+    }
 
-  SubgraphCallback(const Graph& a, const Graph& b, IndexMapVector& mappings)
-    : N {a.N()}, targetGraph(b), mappingsRef(mappings) {}
+    return true;
+  }
 
-  template<class AbMap>
-  IndexMap makeIndexMap(const AbMap& m) {
-    // TODO this has to be possible to do better
-    IndexMap bimap;
+  std::pair<PartialMolecule, PartialMolecule> data;
+  const EdgeStrictness strictness;
+};
 
+//! Vertex invariants and fingerprint of a graph for subgraph matching
+struct GraphProfile {
+  explicit GraphProfile(const Graph& passGraph) : graph(passGraph) {
+    const PrivateGraph& inner = graph.inner();
+    const AtomIndex N = inner.N();
+    elementTypes.reserve(N);
+    degrees.reserve(N);
+    cyclic.assign(N, false);
+    elementCounts.fill(0);
+    bondTypeCounts.fill(0);
     for(AtomIndex i = 0; i < N; ++i) {
-      AtomIndex t = boost::get(m, i);
-      if(t != boost::graph_traits<PrivateGraph::BglType>::null_vertex()) {
-        bimap.insert(
-          IndexMap::value_type(i, t)
-        );
+      elementTypes.push_back(inner.elementType(i));
+      degrees.push_back(inner.degree(i));
+      const unsigned Z = Utils::ElementInfo::Z(elementTypes.back());
+      elements.set(Z);
+      ++elementCounts.at(Z);
+    }
+
+    // Vertices are in cycles if they are incident to an edge that is not a bridge
+    const auto& bridges = inner.removalSafetyData().bridges;
+    for(const PrivateGraph::Edge& edge : inner.edges()) {
+      ++bondTypeCounts.at(underlying(inner.bondType(edge)));
+      if(bridges.count(edge) == 0) {
+        cyclic.at(inner.source(edge)) = true;
+        cyclic.at(inner.target(edge)) = true;
       }
     }
+    cyclicCount = std::count(std::begin(cyclic), std::end(cyclic), true);
 
-    return bimap;
+    sortedDegrees = degrees;
+    std::sort(std::begin(sortedDegrees), std::end(sortedDegrees), std::greater<>());
   }
 
-  template<class AbMap, class BaMap>
-  bool operator() (const AbMap& a, const BaMap& /* b */) {
-    auto indexMap = makeIndexMap(a);
-
+  //! Whether a needle with some profile can possibly be a subgraph
+  bool accommodates(const GraphProfile& needle, const bool compareBondTypes) const {
     if(
-      removeHydrogenPermutations
-      && Temple::any_of(
-        mappingsRef.get(),
-        [&](const IndexMap& foundMap) -> bool {
-          return isHydrogenPermutation(indexMap, foundMap, targetGraph);
-        }
-      )
+      needle.degrees.size() > degrees.size()
+      || needle.graph.B() > graph.B()
+      || (needle.elements & ~elements).any()
+      || needle.cyclicCount > cyclicCount
     ) {
-      return true;
+      return false;
     }
 
-    mappingsRef.get().push_back(std::move(indexMap));
+    for(unsigned Z = 0; Z < elementCounts.size(); ++Z) {
+      if(needle.elementCounts[Z] > elementCounts[Z]) {
+        return false;
+      }
+    }
 
-    //! Don't force stop after any mappings are found
-    return true;
-  }
+    if(compareBondTypes) {
+      for(unsigned i = 0; i < bondTypeCounts.size(); ++i) {
+        if(needle.bondTypeCounts[i] > bondTypeCounts[i]) {
+          return false;
+        }
+      }
+    }
 
-  template<class AbMap, class BaMap>
-  bool operator() (const AbMap& a, const BaMap& b, AtomIndex /* subgraphSize */) {
-    return this->operator()(a, b);
+    // The k-th largest degree of the needle must not exceed that of the haystack
+    return std::equal(
+      std::begin(needle.sortedDegrees),
+      std::end(needle.sortedDegrees),
+      std::begin(sortedDegrees),
+      std::less_equal<>()
+    );
   }
-};
-
-template<typename Enum>
-auto underlying(Enum a) {
-  return static_cast<std::underlying_type_t<Enum>>(a);
-}
-
-struct PartialMolecule {
-  using MaybePermutators = boost::optional<const StereopermutatorList&>;
-
-  explicit PartialMolecule(const Molecule& molecule) : graph(molecule.graph()), permutatorsOption(molecule.stereopermutators()) {}
-  explicit PartialMolecule(const Graph& passGraph) : graph(passGraph), permutatorsOption(boost::none) {}
 
   const Graph& graph;
-  MaybePermutators permutatorsOption;
+  std::vector<Utils::ElementType> elementTypes;
+  std::vector<unsigned> degrees;
+  std::vector<bool> cyclic;
+  unsigned cyclicCount;
+  std::vector<unsigned> sortedDegrees;
+  std::bitset<128> elements;
+  std::array<unsigned, 128> elementCounts;
+  std::array<unsigned, 7> bondTypeCounts;
 };
 
-struct VertexComparator {
-  VertexComparator(PartialMolecule a, PartialMolecule b, const VertexStrictness passStrictness)
-    : data({std::move(a), std::move(b)}), strictness(passStrictness)
-    {}
+/*! @brief VF2 callback passing distinct mappings on to a mapping callback
+ *
+ * Equivalent mappings share a key: For hydrogen permutations, the mapping
+ * with haystack hydrogen atoms replaced by a placeholder, and for atom sets,
+ * the sorted mapped atoms.
+ */
+struct EnumerationCallback {
+  EnumerationCallback(
+    const Graph& passHaystack,
+    const AtomIndex needleSize,
+    const MappingCallback& passCallback,
+    const Uniqueness passUniqueness
+  ) : haystack(passHaystack),
+      callback(passCallback),
+      uniqueness(passUniqueness),
+      image(needleSize)
+  {}
+
+  std::vector<AtomIndex> key() const {
+    std::vector<AtomIndex> result = image;
+    if(uniqueness == Uniqueness::AtomSet) {
+      std::sort(std::begin(result), std::end(result));
+      return result;
+    }
 
-  bool operator () (const AtomIndex i, const AtomIndex j) const {
-    if(data.first.graph.elementType(i) != data.second.graph.elementType(j)) {
-      return false;
+    const AtomIndex placeholder = haystack.N();
+    for(AtomIndex& j : result) {
+      if(haystack.elementType(j) == Utils::ElementType::H) {
+        j = placeholder;
+      }
     }
+    return result;
+  }
 
-    if(underlying(strictness) >= underlying(VertexStrictness::SubsumeShape)) {
-      throw std::logic_error("Not implemented!");
-      /* Determine if there is a low-effort (< 0.2 per step) transition from
-       * the lower shape to the larger one, provided both vertices are
-       * non-terminal in each molecule and both have a stereocenter defined on
-       * it
-       */
+  template<class AbMap, class BaMap>
+  bool operator() (const AbMap& a, const BaMap& /* b */) {
+    const AtomIndex N = image.size();
+    for(AtomIndex i = 0; i < N; ++i) {
+      image[i] = boost::get(a, i);
     }
 
-    if(underlying(strictness) >= underlying(VertexStrictness::SubsumeStereopermutation)) {
-      /* Determine if the shape on both vertices is the same, provided both
-       * vertices are non-terminal
-       */
-      throw std::logic_error("Not implemented!");
+    if(uniqueness != Uniqueness::All && !seen.insert(key()).second) {
+      return true;
+    }
+
+    if(!callback(image)) {
+      stopped = true;
+      return false;
     }
 
     return true;
   }
 
-  std::pair<PartialMolecule, PartialMolecule> data;
-  const VertexStrictness strictness;
+  const Graph& haystack;
+  const MappingCallback& callback;
+  const Uniqueness uniqueness;
+  //! Haystack atom index of each needle atom index
+  std::vector<AtomIndex> image;
+  std::set<std::vector<AtomIndex>> seen;
+  bool stopped = false;
 };
 
-/**
- * @brief Helper object to compare edges between two molecules
- */
-struct EdgeComparator {
-  EdgeComparator(PartialMolecule a, PartialMolecule b, const EdgeStrictness passStrictness)
-    : data({std::move(a), std::move(b)}), strictness(passStrictness)
-    {}
+//! Vertex comparison of a compiled needle with pruning by vertex invariants
+struct ProfileVertexComparator {
+  bool operator () (const AtomIndex i, const AtomIndex j) const {
+    return (
+      needle.elementTypes[i] == haystack.elementTypes[j]
+      && needle.degrees[i] <= haystack.degrees[j]
+      && (!needle.cyclic[i] || haystack.cyclic[j])
+    );
+  }
 
-  bool operator () (const PrivateGraph::Edge i, const PrivateGraph::Edge j) const {
+  const GraphProfile& needle;
+  const GraphProfile& haystack;
+};
+
+} // namespace
+
+struct Query::Impl {
+  Impl(
+    const Graph& needle,
+    const VertexStrictness passVertexStrictness,
+    const EdgeStrictness passEdgeStrictness
+  ) : graph(needle),
+      profile(graph),
+      order(boost::vertex_order_by_mult(graph.inner().bgl())),
+      edgeStrictness(passEdgeStrictness)
+  {
     if(
-      underlying(strictness) >= underlying(EdgeStrictness::BondType)
-      && data.first.graph.inner().bondType(i) != data.second.graph.inner().bondType(j)
+      underlying(passVertexStrictness) >= underlying(VertexStrictness::SubsumeShape)
+      || underlying(passEdgeStrictness) >= underlying(EdgeStrictness::SubsumeStereopermutation)
     ) {
-      return false;
+      throw std::logic_error("Not implemented!");
     }
 
-    if(underlying(strictness) >= underlying(EdgeStrictness::SubsumeStereopermutation)) {
-      throw std::logic_error("Not implemented!");
+    // Populate the cache so that concurrent screens only read
+    graph.inner().pathFingerprint();
+  }
+
+  bool compareBondTypes() const {
+    return underlying(edgeStrictness) >= underlying(EdgeStrictness::BondType);
+  }
+
+  //! Constant time rejection of haystacks lacking any of the needle's paths
+  bool screen(const Graph& haystack) const {
+    return haystack.inner().pathFingerprint().contains(
+      graph.inner().pathFingerprint(),
+      compareBondTypes()
+    );
+  }
+
+  //! Passes distinct mappings to a callback, returning whether it completed
+  bool enumerate(
+    const GraphProfile& haystack,
+    const MappingCallback& callback,
+    const Uniqueness uniqueness
+  ) const {
+    if(!screen(haystack.graph) || !haystack.accommodates(profile, compareBondTypes())) {
+      return true;
     }
 
-    return true;
+    EnumerationCallback enumeration {haystack.graph, graph.N(), callback, uniqueness};
+
+    boost::vf2_subgraph_mono(
+      graph.inner().bgl(),
+      haystack.graph.inner().bgl(),
+      std::ref(enumeration),
+      order,
+      boost::vertices_equivalent(
+        ProfileVertexComparator {profile, haystack}
+      ).edges_equivalent(
+        EdgeComparator {PartialMolecule(graph), PartialMolecule(haystack.graph), edgeStrictness}
+      )
+    );
+
+    return !enumeration.stopped;
   }
 
-  std::pair<PartialMolecule, PartialMolecule> data;
-  const EdgeStrictness strictness;
+  std::vector<IndexMap> match(
+    const GraphProfile& haystack,
+    const Uniqueness uniqueness = Uniqueness::HydrogenPermutation
+  ) const {
+    std::vector<IndexMap> mappings;
+    enumerate(
+      haystack,
+      [&](const std::vector<AtomIndex>& image) -> bool {
+        IndexMap bimap;
+        const AtomIndex N = image.size();
+        for(AtomIndex i = 0; i < N; ++i) {
+          bimap.insert(IndexMap::value_type(i, image[i]));
+        }
+        mappings.push_back(std::move(bimap));
+        return true;
+      },
+      uniqueness
+    );
+    return mappings;
+  }
+
+  const Graph graph;
+  const GraphProfile profile;
+  //! Order in which needle vertices are matched
+  const std::vector<PrivateGraph::Vertex> order;
+  const EdgeStrictness edgeStrictness;
 };
 
-std::vector<IndexMap> maximumImpl(
-  const PartialMolecule& a,
-  const PartialMolecule& b,
+Query::Query(
+  const Graph& needle,
   const VertexStrictness vertexStrictness,
   const EdgeStrictness edgeStrictness
-) {
-  std::vector<IndexMap> mappings;
-  SubgraphCallback callback {a.graph, b.graph, mappings};
-
-  boost::mcgregor_common_subgraphs_maximum_unique(
-    a.graph.inner().bgl(),
-    b.graph.inner().bgl(),
-    false, // Permit disconnected subgraphs
-    callback,
-    boost::vertices_equivalent(
-      VertexComparator {a, b, vertexStrictness}
-    ).
-    edges_equivalent(
-      EdgeComparator {a, b, edgeStrictness}
-    )
+) : pImpl_(std::make_shared<Impl>(needle, vertexStrictness, edgeStrictness)) {}
+
+const Graph& Query::needle() const {
+  return pImpl_->graph;
+}
+
+bool Query::mayMatch(const Graph& haystack) const {
+  return (
+    pImpl_->screen(haystack)
+    && GraphProfile {haystack}.accommodates(pImpl_->profile, pImpl_->compareBondTypes())
   );
+}
 
-  return mappings;
+std::vector<IndexMap> Query::operator () (const Graph& haystack) const {
+  // Skip profiling haystacks rejected by their fingerprint
+  if(!pImpl_->screen(haystack)) {
+    return {};
+  }
+
+  return pImpl_->match(GraphProfile {haystack});
 }
 
-std::vector<IndexMap> completeImpl(
-  const PartialMolecule& needle,
-  const PartialMolecule& haystack,
-  VertexStrictness vertexStrictness = VertexStrictness::ElementType,
-  EdgeStrictness edgeStrictness = EdgeStrictness::Topographic
-) {
-  std::vector<IndexMap> mappings;
-  SubgraphCallback callback {needle.graph, haystack.graph, mappings};
-
-  boost::vf2_subgraph_mono(
-    needle.graph.inner().bgl(),
-    haystack.graph.inner().bgl(),
-    callback,
-    boost::vertex_order_by_mult(needle.graph.inner().bgl()),
-    boost::vertices_equivalent(
-      VertexComparator {needle, haystack, vertexStrictness}
-    ).edges_equivalent(
-      EdgeComparator {needle, haystack, edgeStrictness}
-    )
+std::vector<IndexMap> Query::operator () (const Molecule& haystack) const {
+  return operator () (haystack.graph());
+}
+
+std::vector<IndexMap> Query::operator () (const Graph& haystack, const Uniqueness uniqueness) const {
+  if(!pImpl_->screen(haystack)) {
+    return {};
+  }
+
+  return pImpl_->match(GraphProfile {haystack}, uniqueness);
+}
+
+bool Query::forEach(
+  const Graph& haystack,
+  const MappingCallback& callback,
+  const Uniqueness uniqueness
+) const {
+  if(!pImpl_->screen(haystack)) {
+    return true;
+  }
+
+  return pImpl_->enumerate(GraphProfile {haystack}, callback, uniqueness);
+}
+
+bool Query::exists(const Graph& haystack) const {
+  // Completing the enumeration means no mapping was found
+  return !forEach(
+    haystack,
+    [](const std::vector<AtomIndex>& /* image */) { return false; },
+    Uniqueness::All
   );
+}
 
+unsigned Query::count(const Graph& haystack, const Uniqueness uniqueness) const {
+  unsigned mappings = 0;
+  forEach(
+    haystack,
+    [&](const std::vector<AtomIndex>& /* image */) {
+      ++mappings;
+      return true;
+    },
+    uniqueness
+  );
   return mappings;
 }
 
-} // namespace
+std::vector<std::vector<IndexMap>> complete(
+  const Query& query,
+  const std::vector<Graph>& haystacks
+) {
+  const unsigned H = haystacks.size();
+  std::vector<std::vector<IndexMap>> results(H);
+  std::exception_ptr exception;
+
+#pragma omp parallel for schedule(dynamic)
+  for(unsigned i = 0; i < H; ++i) {
+    try {
+      results[i] = query(haystacks[i]);
+    } catch(...) {
+#pragma omp critical(subgraphsQueryException)
+      {
+        if(!exception) {
+          exception = std::current_exception();
+        }
+      }
+    }
+  }
+
+  if(exception) {
+    std::rethrow_exception(exception);
+  }
+
+  return results;
+}
+
+std::vector<std::vector<IndexMap>> complete(
+  const std::vector<Query>& queries,
+  const Graph& haystack
+) {
+  // Shared by all queries
+  const GraphProfile profile {haystack};
+  haystack.inner().pathFingerprint();
+
+  const unsigned Q = queries.size();
+  std::vector<std::vector<IndexMap>> results(Q);
+  std::exception_ptr exception;
+
+#pragma omp parallel for schedule(dynamic)
+  for(unsigned i = 0; i < Q; ++i) {
+    try {
+      results[i] = queries[i].pImpl_->match(profile);
+    } catch(...) {
+#pragma omp critical(subgraphsQueryException)
+      {
+        if(!exception) {
+          exception = std::current_exception();
+        }
+      }
+    }
+  }
+
+  if(exception) {
+    std::rethrow_exception(exception);
+  }
+
+  return results;
+}
 
 std::vector<IndexMap> complete(
   const Graph& needle,
@@ -255,12 +461,7 @@ std::vector<IndexMap> complete(
   VertexStrictness vertexStrictness,
   EdgeStrictness edgeStrictness
 ) {
-  return completeImpl(
-    PartialMolecule(needle),
-    PartialMolecule(haystack),
-    vertexStrictness,
-    edgeStrictness
-  );
+  return Query {needle, vertexStrictness, edgeStrictness}(haystack);
 }
 
 std::vector<IndexMap> complete(
@@ -269,48 +470,7 @@ std::vector<IndexMap> complete(
   VertexStrictness vertexStrictness,
   EdgeStrictness edgeStrictness
 ) {
-  return completeImpl(
-    PartialMolecule(needle),
-    PartialMolecule(haystack),
-    vertexStrictness,
-    edgeStrictness
-  );
-}
-
-std::vector<IndexMap> maximum(
-  const Graph& a,
-  const Graph& b,
-  const VertexStrictness vertexStrictness,
-  const EdgeStrictness edgeStrictness
-) {
-  if(underlying(vertexStrictness) >= underlying(VertexStrictness::SubsumeShape)) {
-    throw std::runtime_error("Requested vertex comparison strictness not possible without stereopermutator information");
-  }
-
-  if(underlying(edgeStrictness) >= underlying(EdgeStrictness::SubsumeStereopermutation)) {
-    throw std::runtime_error("Requested edge comparison strictness not possible without stereopermutator information");
-  }
-
-  return maximumImpl(
-    PartialMolecule(a),
-    PartialMolecule(b),
-    vertexStrictness,
-    edgeStrictness
-  );
-}
-
-std::vector<IndexMap> maximum(
-  const Molecule& a,
-  const Molecule& b,
-  const VertexStrictness vertexStrictness,
-  const EdgeStrictness edgeStrictness
-) {
-  return maximumImpl(
-    PartialMolecule(a),
-    PartialMolecule(b),
-    vertexStrictness,
-    edgeStrictness
-  );
+  return Query {needle.graph(), vertexStrictness, edgeStrictness}(haystack.graph());
 }
 
 } // namespace Subgraphs
@@ -9,8 +9,13 @@
 #define INCLUDE_MOLASSEMBLER_SUBGRAPHS_H
 
 #include "boost/bimap.hpp"
+#include "Molassembler/Cancellation.h"
 #include "Molassembler/Types.h"
 
+#include <functional>
+#include <memory>
+#include <vector>
+
 namespace Scine {
 namespace Molassembler {
 
@@ -81,6 +86,32 @@ enum class MASM_EXPORT EdgeStrictness : unsigned {
   SubsumeStereopermutation
 };
 
+/**
+ * @brief Which mappings of a needle are considered distinct
+ */
+enum class MASM_EXPORT Uniqueness : unsigned {
+  //! Every mapping is distinct
+  All,
+  /*!
+   * Mappings differing only in which hydrogen atoms of the haystack needle
+   * atoms map onto are equivalent. The default for complete().
+   */
+  HydrogenPermutation,
+  /*!
+   * Mappings onto the same set of haystack atoms are equivalent, e.g. only one
+   * mapping of benzene per ring of a polycyclic aromatic hydrocarbon
+   */
+  AtomSet
+};
+
+/*! @brief Callback receiving mappings in enumeration
+ *
+ * The argument is the haystack atom index for each needle atom index. The
+ * referenced data is only valid for the duration of the call. Return false to
+ * stop the enumeration.
+ */
+using MappingCallback = std::function<bool(const std::vector<AtomIndex>&)>;
+
 /**
  * @brief Searches for subgraphs of needle in haystack
  *
@@ -124,11 +155,203 @@ MASM_EXPORT std::vector<IndexMap> complete(
   EdgeStrictness edgeStrictness = EdgeStrictness::Topographic
 );
 
+class Query;
+
+/**
+ * @brief Searches for a compiled needle in many haystacks
+ *
+ * @param query The compiled needle
+ * @param haystacks The graphs to search in
+ *
+ * @parblock @note This function is parallelized over haystacks. Use the
+ * OMP_NUM_THREADS environment variable to control the number of threads
+ * used.
+ * @endparblock
+ *
+ * @return Index mappings of the needle for each haystack
+ */
+MASM_EXPORT std::vector<std::vector<IndexMap>> complete(
+  const Query& query,
+  const std::vector<Graph>& haystacks
+);
+
+/**
+ * @brief Searches for many compiled needles in a haystack
+ *
+ * The fingerprint, degrees and cycle membership of the haystack are
+ * determined only once for all needles.
+ *
+ * @param queries The compiled needles
+ * @param haystack The graph to search in
+ *
+ * @parblock @note This function is parallelized over needles. Use the
+ * OMP_NUM_THREADS environment variable to control the number of threads
+ * used.
+ * @endparblock
+ *
+ * @return Index mappings of each needle in the haystack
+ */
+MASM_EXPORT std::vector<std::vector<IndexMap>> complete(
+  const std::vector<Query>& queries,
+  const Graph& haystack
+);
+
+/**
+ * @brief Subgraph search for a needle preprocessed once for many haystacks
+ *
+ * Compiling a query fixes the order in which needle vertices are matched and
+ * precomputes the element types, degrees and cycle membership of the needle
+ * vertices, as well as a fingerprint of element and bond type counts. A
+ * haystack is rejected before any matching if its cached path fingerprint
+ * lacks any of the needle's element-labeled paths or if its counts cannot
+ * accommodate the needle's. Needle vertices only match haystack vertices of equal
+ * element type, at least equal degree and, if in a cycle, in a cycle.
+ *
+ * Queries are immutable after construction, so copies share their data and
+ * can be executed concurrently.
+ */
+class MASM_EXPORT Query {
+public:
+  //! Library-internal implementation type
+  struct Impl;
+
+  /*! @brief Compiles a needle graph
+   *
+   * @param needle The smaller graph to search for
+   * @param vertexStrictness Strictness with which to allow vertex matching.
+   *   Maximum implemented strictness is VertexStrictness::ElementType.
+   * @param edgeStrictness Strictness with which to allow edge matching.
+   *   Maximum implemented strictness is EdgeStrictness::BondType.
+   *
+   * @complexity{@math{\Theta(N \log N + B)}}
+   * @throws std::logic_error If a strictness is not implemented
+   */
+  explicit Query(
+    const Graph& needle,
+    VertexStrictness vertexStrictness = VertexStrictness::ElementType,
+    EdgeStrictness edgeStrictness = EdgeStrictness::Topographic
+  );
+
+  //! The compiled needle graph
+  const Graph& needle() const;
+
+  /*! @brief Whether the fingerprint of a haystack can accommodate the needle
+   *
+   * A false result guarantees that there are no matches. A true result does
+   * not guarantee any.
+   *
+   * @complexity{@math{\Theta(1)} for haystacks rejected by their path
+   * fingerprint once it is cached, otherwise @math{\Theta(N + B)} of the
+   * haystack}
+   */
+  bool mayMatch(const Graph& haystack) const;
+
+  /*! @brief Searches for the needle in a haystack
+   *
+   * @return List of index mappings of vertices the needle to vertices of the
+   *   haystack, as complete()
+   */
+  std::vector<IndexMap> operator () (const Graph& haystack) const;
+
+  //! @overload
+  std::vector<IndexMap> operator () (const Molecule& haystack) const;
+
+  /*! @brief Searches for distinct mappings of the needle in a haystack
+   *
+   * @param haystack The graph to search in
+   * @param uniqueness Which mappings are distinct
+   *
+   * @return List of index mappings, in the order they are found
+   */
+  std::vector<IndexMap> operator () (const Graph& haystack, Uniqueness uniqueness) const;
+
+  /*! @brief Calls a function with each distinct mapping of the needle
+   *
+   * No index mappings are allocated. Equivalent mappings are recognized with
+   * compact keys of the mappings passed so far, unless all mappings are
+   * distinct.
+   *
+   * @param haystack The graph to search in
+   * @param callback Function called with each mapping, returning whether to
+   *   continue the enumeration
+   * @param uniqueness Which mappings are distinct
+   *
+   * @return Whether the enumeration ran to completion, i.e. was not stopped
+   *   by the callback
+   */
+  bool forEach(
+    const Graph& haystack,
+    const MappingCallback& callback,
+    Uniqueness uniqueness = Uniqueness::HydrogenPermutation
+  ) const;
+
+  /*! @brief Whether there is any mapping of the needle in a haystack
+   *
+   * Stops at the first mapping found.
+   */
+  bool exists(const Graph& haystack) const;
+
+  //! Number of distinct mappings of the needle in a haystack
+  unsigned count(
+    const Graph& haystack,
+    Uniqueness uniqueness = Uniqueness::HydrogenPermutation
+  ) const;
+
+private:
+  friend std::vector<std::vector<IndexMap>> complete(
+    const std::vector<Query>& queries,
+    const Graph& haystack
+  );
+
+  // Immutable, hence shared between copies
+  std::shared_ptr<const Impl> pImpl_;
+};
+
+/**
+ * @brief Limits and goals of maximum common subgraph searches
+ *
+ * The search keeps the largest mappings found so far. If it is stopped by a
+ * limit, these are returned, but need not be maximum.
+ */
+struct MASM_EXPORT MaximumConfiguration {
+  //! Wall time limit of the search in seconds. Unlimited if not positive.
+  double timeLimit {0};
+
+  //! Limit on the number of search tree nodes. Unlimited if zero.
+  unsigned long nodeLimit {0};
+
+  /*! @brief Stop as soon as a mapping of this many atoms is found
+   *
+   * Disabled if zero.
+   */
+  unsigned sizeTarget {0};
+
+  /*! @brief Whether to find all maximum mappings up to hydrogen permutations
+   *
+   * If false, only a single maximum mapping is found, which is considerably
+   * faster for symmetric graphs.
+   */
+  bool allMaxima {true};
+
+  /*! @brief Stops the search once cancelled, like the time limit
+   *
+   * Copies of a configuration share the token.
+   */
+  CancellationToken cancellation;
+};
+
 /*!
  * @brief Find mappings for the maximum common subgraph between two graphs
  *
- * Finds an index mapping from a to b representing all found maximum common
- * subgraphs (if present).
+ * Finds index mappings from a to b representing all found maximum common
+ * induced subgraphs (if present), which need not be connected. Mappings
+ * differing only in permutations of hydrogen atoms are reported once.
+ *
+ * The search is a branch and bound over vertex pairs in which the vertices
+ * yet to be matched are partitioned into classes of equal element type and
+ * equal edges to all matched vertices, after J. McCreesh, P. Prosser and
+ * C. Trimble, "A Partitioning Algorithm for Maximum Common Subgraph
+ * Problems", IJCAI 2017.
  *
  * @params a The first graph
  * @params b The second graph
@@ -136,9 +359,13 @@ MASM_EXPORT std::vector<IndexMap> complete(
  *   Maximum strictness for graph MCS is VertexStrictness::ElementType.
  * @params edgeStrictness Strictness with which to allow edge matching. Maximum
  *   strictness for graph MCS is EdgeStrictness::BondType.
+ * @params configuration Limits of the search
+ *
+ * @complexity{Exponential in the worst case, @math{\Theta(N_1^2 + N_2^2)}
+ * space}
  *
- * @complexity{@math{O(N_1 \cdot N_2)} where @math{N_i} is the number of
- * vertices in graph @math{i}}
+ * @throws std::runtime_error If a strictness is not possible without
+ *   stereopermutator information
  *
  * @warning For subgraph comparison, only element and bond types are considered.
  * Stereocenters and Stereopermutations are not graph-local properties suitable
@@ -148,14 +375,14 @@ MASM_EXPORT std::vector<IndexMap> maximum(
   const Graph& a,
   const Graph& b,
   VertexStrictness vertexStrictness = VertexStrictness::ElementType,
-  EdgeStrictness edgeStrictness = EdgeStrictness::Topographic
+  EdgeStrictness edgeStrictness = EdgeStrictness::Topographic,
+  const MaximumConfiguration& configuration = MaximumConfiguration {}
 );
 
 /*!
  * @brief Find mappings for the maximum common subgraph between two molecules
  *
- * Finds an index mapping from a to b representing all found maximum common
- * subgraphs (if present).
+ * As the graph overload.
  *
  * @params a The first molecule
  * @params b The second molecule
@@ -164,9 +391,12 @@ MASM_EXPORT std::vector<IndexMap> maximum(
  *   VertexStrictness::ElementType.
  * @params edgeStrictness Strictness with which to allow edge matching. Maximum
  *   implemented strictness for molecule MCS is EdgeStrictness::BondType.
+ * @params configuration Limits of the search
  *
- * @complexity{@math{O(N_1 \cdot N_2)} where @math{N_i} is the number of
- * vertices in graph @math{i}}
+ * @complexity{Exponential in the worst case, @math{\Theta(N_1^2 + N_2^2)}
+ * space}
+ *
+ * @throws std::logic_error If a strictness is not implemented
  *
  * @warning For subgraph comparison, only element and bond types are considered.
  * Stereocenters and Stereopermutations are not graph-local properties suitable
@@ -176,7 +406,8 @@ MASM_EXPORT std::vector<IndexMap> maximum(
   const Molecule& a,
   const Molecule& b,
   VertexStrictness vertexStrictness = VertexStrictness::ElementType,
-  EdgeStrictness edgeStrictness = EdgeStrictness::Topographic
+  EdgeStrictness edgeStrictness = EdgeStrictness::Topographic,
+  const MaximumConfiguration& configuration = MaximumConfiguration {}
 );
 
 } // namespace Subgraphs
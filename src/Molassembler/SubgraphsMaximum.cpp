@@ -0,0 +1,505 @@
+/*!@file
+ * @copyright This code is licensed under the 3-clause BSD license.
+ *   Copyright ETH Zurich, Laboratory of Physical Chemistry, Reiher Group.
+ *   See LICENSE.txt for details.
+ */
+
+#include "Molassembler/Subgraphs.h"
+
+#include "Molassembler/Graph.h"
+#include "Molassembler/Graph/PrivateGraph.h"
+#include "Molassembler/Molecule.h"
+
+#include "Utils/Geometry/ElementInfo.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <set>
+
+namespace Scine {
+namespace Molassembler {
+namespace Subgraphs {
+namespace {
+
+template<typename Enum>
+auto underlying(Enum a) {
+  return static_cast<std::underlying_type_t<Enum>>(a);
+}
+
+/*! @brief Maximum common induced subgraph search by partitioning
+ *
+ * Vertices not yet matched are kept in bidomains: pairs of ranges of the
+ * left and right vertex arrays whose vertices share their element type and
+ * their edge labels to every matched vertex, and hence may be matched with
+ * one another. The number of vertices that can still be matched is bounded by
+ * the sum of the lesser range lengths of all bidomains.
+ *
+ * Matching two vertices splits each bidomain by the edge labels to the newly
+ * matched pair, which the ranges are partitioned by in place.
+ */
+class McSplit {
+public:
+  using Clock = std::chrono::steady_clock;
+  using Mapping = std::vector<std::pair<AtomIndex, AtomIndex>>;
+
+  McSplit(
+    const Graph& a,
+    const Graph& b,
+    const bool compareBondTypes,
+    const MaximumConfiguration& configuration
+  ) : configuration_(configuration),
+      left_(a),
+      right_(b),
+      leftLabels_(edgeLabels(a, compareBondTypes)),
+      rightLabels_(edgeLabels(b, compareBondTypes)),
+      rightTwins_(hydrogenTwins(b))
+  {
+    if(configuration_.timeLimit > 0) {
+      deadline_ = Clock::now() + std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double>(configuration_.timeLimit)
+      );
+    }
+  }
+
+  std::vector<IndexMap> run() {
+    std::vector<Bidomain> domains = initialDomains();
+    solve(domains, false);
+
+    /* Enumerating equally large mappings prunes far less, so all maxima are
+     * only sought once the maximum size is known
+     */
+    if(configuration_.allMaxima && !stopped_ && bestSize_ > 0) {
+      enumerating_ = true;
+      leftVertices_.clear();
+      rightVertices_.clear();
+      domains = initialDomains();
+      solve(domains, false);
+    }
+
+    std::vector<IndexMap> mappings;
+    mappings.reserve(best_.size());
+    for(const Mapping& mapping : best_) {
+      IndexMap bimap;
+      for(const auto& pair : mapping) {
+        bimap.insert(IndexMap::value_type(pair.first, pair.second));
+      }
+      mappings.push_back(std::move(bimap));
+    }
+    return mappings;
+  }
+
+private:
+  struct Bidomain {
+    //! Start of the left vertex range
+    unsigned l;
+    //! Start of the right vertex range
+    unsigned r;
+    unsigned leftLength;
+    unsigned rightLength;
+  };
+
+  //! Edge labels of all vertex pairs, zero if not bonded
+  static std::vector<std::uint8_t> edgeLabels(const Graph& graph, const bool compareBondTypes) {
+    const PrivateGraph& inner = graph.inner();
+    const unsigned N = inner.N();
+    std::vector<std::uint8_t> labels(N * N, 0);
+    for(const PrivateGraph::Edge& edge : inner.edges()) {
+      const unsigned i = inner.source(edge);
+      const unsigned j = inner.target(edge);
+      const std::uint8_t label = compareBondTypes ? 1 + underlying(inner.bondType(edge)) : 1;
+      labels[i * N + j] = label;
+      labels[j * N + i] = label;
+    }
+    return labels;
+  }
+
+  /*! @brief Representatives of terminal hydrogen atoms on the same atom
+   *
+   * Such hydrogen atoms are interchangeable by an automorphism, so matching a
+   * vertex to either yields mappings that are hydrogen permutations of one
+   * another. Other vertices have no representative, marked by N.
+   */
+  static std::vector<AtomIndex> hydrogenTwins(const Graph& graph) {
+    const PrivateGraph& inner = graph.inner();
+    const unsigned N = inner.N();
+    std::vector<AtomIndex> twins(N, N);
+    std::map<std::pair<AtomIndex, BondType>, AtomIndex> representatives;
+    for(AtomIndex i = 0; i < N; ++i) {
+      if(inner.elementType(i) != Utils::ElementType::H || inner.degree(i) != 1) {
+        continue;
+      }
+
+      const PrivateGraph::Edge edge = *std::begin(inner.edges(i));
+      const AtomIndex neighbor = inner.source(edge) == i ? inner.target(edge) : inner.source(edge);
+      const auto key = std::make_pair(neighbor, inner.bondType(edge));
+      twins[i] = representatives.emplace(key, i).first->second;
+    }
+    return twins;
+  }
+
+  //! Bidomains of vertices of equal element type
+  std::vector<Bidomain> initialDomains() {
+    auto byElement = [](const Graph& graph) {
+      std::map<unsigned, std::vector<AtomIndex>> elements;
+      for(const AtomIndex i : graph.atoms()) {
+        elements[Utils::ElementInfo::Z(graph.elementType(i))].push_back(i);
+      }
+      return elements;
+    };
+
+    const auto leftElements = byElement(left_);
+    const auto rightElements = byElement(right_);
+
+    std::vector<Bidomain> domains;
+    for(const auto& leftIterPair : leftElements) {
+      const auto rightFindIter = rightElements.find(leftIterPair.first);
+      if(rightFindIter == std::end(rightElements)) {
+        continue;
+      }
+
+      domains.push_back(Bidomain {
+        static_cast<unsigned>(leftVertices_.size()),
+        static_cast<unsigned>(rightVertices_.size()),
+        static_cast<unsigned>(leftIterPair.second.size()),
+        static_cast<unsigned>(rightFindIter->second.size())
+      });
+      std::copy(
+        std::begin(leftIterPair.second),
+        std::end(leftIterPair.second),
+        std::back_inserter(leftVertices_)
+      );
+      std::copy(
+        std::begin(rightFindIter->second),
+        std::end(rightFindIter->second),
+        std::back_inserter(rightVertices_)
+      );
+    }
+    return domains;
+  }
+
+  static unsigned bound(const std::vector<Bidomain>& domains) {
+    unsigned sum = 0;
+    for(const Bidomain& domain : domains) {
+      sum += std::min(domain.leftLength, domain.rightLength);
+    }
+    return sum;
+  }
+
+  AtomIndex minimumLeft(const Bidomain& domain) const {
+    return *std::min_element(
+      std::begin(leftVertices_) + domain.l,
+      std::begin(leftVertices_) + domain.l + domain.leftLength
+    );
+  }
+
+  //! Bidomain with the fewest vertices on its larger side, or -1 if none
+  int selectDomain(const std::vector<Bidomain>& domains) const {
+    int best = -1;
+    unsigned minimumSize = std::numeric_limits<unsigned>::max();
+    AtomIndex minimumVertex = std::numeric_limits<AtomIndex>::max();
+    const int D = domains.size();
+    for(int i = 0; i < D; ++i) {
+      const Bidomain& domain = domains[i];
+      if(domain.leftLength == 0) {
+        continue;
+      }
+
+      const unsigned size = std::max(domain.leftLength, domain.rightLength);
+      if(size < minimumSize) {
+        minimumSize = size;
+        minimumVertex = minimumLeft(domain);
+        best = i;
+      } else if(size == minimumSize) {
+        const AtomIndex vertex = minimumLeft(domain);
+        if(vertex < minimumVertex) {
+          minimumVertex = vertex;
+          best = i;
+        }
+      }
+    }
+    return best;
+  }
+
+  /*! @brief Splits all bidomains by their edge labels to a matched pair
+   *
+   * Bonded vertices are sorted by label within their ranges. Vertices not
+   * bonded to the pair are moved to the back of the ranges.
+   */
+  std::vector<Bidomain> filter(
+    const std::vector<Bidomain>& domains,
+    const AtomIndex v,
+    const AtomIndex w
+  ) {
+    const unsigned leftN = left_.N();
+    const unsigned rightN = right_.N();
+    const std::uint8_t* leftRow = leftLabels_.data() + v * leftN;
+    const std::uint8_t* rightRow = rightLabels_.data() + w * rightN;
+
+    std::vector<Bidomain> filtered;
+    filtered.reserve(domains.size() + 2);
+    for(const Bidomain& domain : domains) {
+      const auto leftBegin = std::begin(leftVertices_) + domain.l;
+      const auto rightBegin = std::begin(rightVertices_) + domain.r;
+      const auto leftBonded = std::partition(
+        leftBegin,
+        leftBegin + domain.leftLength,
+        [&](const AtomIndex i) { return leftRow[i] != 0; }
+      );
+      const auto rightBonded = std::partition(
+        rightBegin,
+        rightBegin + domain.rightLength,
+        [&](const AtomIndex i) { return rightRow[i] != 0; }
+      );
+      const unsigned leftBondedLength = leftBonded - leftBegin;
+      const unsigned rightBondedLength = rightBonded - rightBegin;
+
+      if(leftBondedLength < domain.leftLength && rightBondedLength < domain.rightLength) {
+        filtered.push_back(Bidomain {
+          domain.l + leftBondedLength,
+          domain.r + rightBondedLength,
+          domain.leftLength - leftBondedLength,
+          domain.rightLength - rightBondedLength
+        });
+      }
+
+      if(leftBondedLength == 0 || rightBondedLength == 0) {
+        continue;
+      }
+
+      std::sort(
+        leftBegin,
+        leftBonded,
+        [&](const AtomIndex i, const AtomIndex j) { return leftRow[i] < leftRow[j]; }
+      );
+      std::sort(
+        rightBegin,
+        rightBonded,
+        [&](const AtomIndex i, const AtomIndex j) { return rightRow[i] < rightRow[j]; }
+      );
+
+      unsigned l = domain.l;
+      unsigned r = domain.r;
+      const unsigned leftEnd = domain.l + leftBondedLength;
+      const unsigned rightEnd = domain.r + rightBondedLength;
+      while(l < leftEnd && r < rightEnd) {
+        const std::uint8_t leftLabel = leftRow[leftVertices_[l]];
+        const std::uint8_t rightLabel = rightRow[rightVertices_[r]];
+        if(leftLabel < rightLabel) {
+          ++l;
+        } else if(leftLabel > rightLabel) {
+          ++r;
+        } else {
+          const unsigned leftStart = l;
+          const unsigned rightStart = r;
+          do {
+            ++l;
+          } while(l < leftEnd && leftRow[leftVertices_[l]] == leftLabel);
+          do {
+            ++r;
+          } while(r < rightEnd && rightRow[rightVertices_[r]] == leftLabel);
+          filtered.push_back(Bidomain {leftStart, rightStart, l - leftStart, r - rightStart});
+        }
+      }
+    }
+
+    return filtered;
+  }
+
+  bool limitsReached() {
+    ++nodes_;
+    if(configuration_.nodeLimit > 0 && nodes_ > configuration_.nodeLimit) {
+      return true;
+    }
+
+    // Reading the clock is comparatively expensive
+    if(nodes_ % 256 != 0) {
+      return false;
+    }
+
+    return (
+      (configuration_.timeLimit > 0 && Clock::now() > deadline_)
+      || configuration_.cancellation.cancelled()
+    );
+  }
+
+  //! Stores the current mapping if it is not a hydrogen permutation of another
+  void record() {
+    Mapping mapping = current_;
+    std::sort(std::begin(mapping), std::end(mapping));
+
+    Mapping key = mapping;
+    const AtomIndex placeholder = right_.N();
+    for(auto& pair : key) {
+      if(right_.elementType(pair.second) == Utils::ElementType::H) {
+        pair.second = placeholder;
+      }
+    }
+
+    if(keys_.insert(std::move(key)).second) {
+      best_.push_back(std::move(mapping));
+    }
+  }
+
+  void solve(std::vector<Bidomain>& domains, const bool matched) {
+    if(stopped_ || limitsReached()) {
+      stopped_ = true;
+      return;
+    }
+
+    const unsigned size = current_.size();
+    if(size > bestSize_) {
+      bestSize_ = size;
+      best_.clear();
+      keys_.clear();
+      record();
+    } else if(matched && size == bestSize_ && enumerating_) {
+      record();
+    }
+
+    if(configuration_.sizeTarget > 0 && bestSize_ >= configuration_.sizeTarget) {
+      stopped_ = true;
+      return;
+    }
+
+    // Equally large mappings are only of interest when enumerating maxima
+    const unsigned upperBound = size + bound(domains);
+    if(upperBound < bestSize_ || (upperBound == bestSize_ && !enumerating_)) {
+      return;
+    }
+
+    const int domainIndex = selectDomain(domains);
+    if(domainIndex < 0) {
+      return;
+    }
+
+    // Remove the least left vertex from its range by moving it to the back
+    Bidomain& domain = domains[domainIndex];
+    const auto leftBegin = std::begin(leftVertices_) + domain.l;
+    const auto vIter = std::min_element(leftBegin, leftBegin + domain.leftLength);
+    const AtomIndex v = *vIter;
+    --domain.leftLength;
+    std::iter_swap(vIter, leftBegin + domain.leftLength);
+
+    /* Try matching v to each right vertex of the bidomain in ascending order.
+     * Each tried vertex is moved to the back of the range, out of reach of
+     * filtering, and the range is otherwise only permuted by recursion.
+     */
+    --domain.rightLength;
+    std::vector<AtomIndex> triedTwins;
+    bool first = true;
+    AtomIndex w = 0;
+    for(unsigned i = 0; i <= domain.rightLength; ++i) {
+      const auto rightBegin = std::begin(rightVertices_) + domain.r;
+      const auto rightEnd = rightBegin + domain.rightLength + 1;
+      auto wIter = rightEnd;
+      for(auto iter = rightBegin; iter != rightEnd; ++iter) {
+        if((first || *iter > w) && (wIter == rightEnd || *iter < *wIter)) {
+          wIter = iter;
+        }
+      }
+      first = false;
+      w = *wIter;
+      std::iter_swap(wIter, rightBegin + domain.rightLength);
+
+      // Skip hydrogen atoms interchangeable with one matched to v before
+      const AtomIndex twin = rightTwins_[w];
+      if(twin != right_.N()) {
+        if(std::find(std::begin(triedTwins), std::end(triedTwins), twin) != std::end(triedTwins)) {
+          continue;
+        }
+        triedTwins.push_back(twin);
+      }
+
+      auto filtered = filter(domains, v, w);
+      current_.emplace_back(v, w);
+      solve(filtered, true);
+      current_.pop_back();
+      if(stopped_) {
+        return;
+      }
+    }
+    ++domain.rightLength;
+
+    // Leave v unmatched
+    if(domain.leftLength == 0) {
+      domains[domainIndex] = domains.back();
+      domains.pop_back();
+    }
+    solve(domains, false);
+  }
+
+  const MaximumConfiguration& configuration_;
+  const Graph& left_;
+  const Graph& right_;
+  const std::vector<std::uint8_t> leftLabels_;
+  const std::vector<std::uint8_t> rightLabels_;
+  const std::vector<AtomIndex> rightTwins_;
+  Clock::time_point deadline_;
+
+  std::vector<AtomIndex> leftVertices_;
+  std::vector<AtomIndex> rightVertices_;
+  Mapping current_;
+
+  unsigned bestSize_ = 0;
+  std::vector<Mapping> best_;
+  std::set<Mapping> keys_;
+
+  unsigned long nodes_ = 0;
+  bool stopped_ = false;
+  //! Whether equally large mappings as the best are recorded
+  bool enumerating_ = false;
+};
+
+} // namespace
+
+std::vector<IndexMap> maximum(
+  const Graph& a,
+  const Graph& b,
+  const VertexStrictness vertexStrictness,
+  const EdgeStrictness edgeStrictness,
+  const MaximumConfiguration& configuration
+) {
+  if(underlying(vertexStrictness) >= underlying(VertexStrictness::SubsumeShape)) {
+    throw std::runtime_error("Requested vertex comparison strictness not possible without stereopermutator information");
+  }
+
+  if(underlying(edgeStrictness) >= underlying(EdgeStrictness::SubsumeStereopermutation)) {
+    throw std::runtime_error("Requested edge comparison strictness not possible without stereopermutator information");
+  }
+
+  return McSplit {
+    a,
+    b,
+    underlying(edgeStrictness) >= underlying(EdgeStrictness::BondType),
+    configuration
+  }.run();
+}
+
+std::vector<IndexMap> maximum(
+  const Molecule& a,
+  const Molecule& b,
+  const VertexStrictness vertexStrictness,
+  const EdgeStrictness edgeStrictness,
+  const MaximumConfiguration& configuration
+) {
+  if(
+    underlying(vertexStrictness) >= underlying(VertexStrictness::SubsumeShape)
+    || underlying(edgeStrictness) >= underlying(EdgeStrictness::SubsumeStereopermutation)
+  ) {
+    throw std::logic_error("Not implemented!");
+  }
+
+  return McSplit {
+    a.graph(),
+    b.graph(),
+    underlying(edgeStrictness) >= underlying(EdgeStrictness::BondType),
+    configuration
+  }.run();
+}
+
+} // namespace Subgraphs
+} // namespace Molassembler
+} // namespace Scine
@@ -386,10 +386,11 @@ private:
 
       InsertResult result;
       result.insertedSomething = !children.test(choice);
-      result.subtreeIsFull = children.all();
 
       children.set(choice);
 
+      result.subtreeIsFull = children.all();
+
       return result;
     }
 
@@ -0,0 +1,471 @@
+/*!@file
+ * @copyright This code is licensed under the 3-clause BSD license.
+ *   Copyright ETH Zurich, Laboratory of Physical Chemistry, Reiher Group.
+ *   See LICENSE.txt for details.
+ * @brief Prefix trie of bounded values in flat per-level arrays
+ */
+
+#ifndef INCLUDE_MOLASSEMBLER_TEMPLE_COMPACT_BOUNDED_NODE_TRIE_H
+#define INCLUDE_MOLASSEMBLER_TEMPLE_COMPACT_BOUNDED_NODE_TRIE_H
+
+#include "Molassembler/Temple/Functional.h"
+
+#include "boost/dynamic_bitset.hpp"
+
+#include <cassert>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <stdexcept>
+
+namespace Scine {
+namespace Molassembler {
+namespace Temple {
+
+/*!
+ * @brief Memory-compact variant of BoundedNodeTrie with the same interface
+ *
+ * Instead of an object per node, all nodes at a level of the trie are stored
+ * in flat arrays: per node, a 32-bit child index and a fullness bit for each
+ * possible choice at that level. Nodes at the last level are bit-packed into
+ * a single bitset. A node at a level with @math{U} choices then occupies
+ * @math{4U} bytes and @math{U} bits instead of a heap-allocated node with a
+ * vtable, a vector of owning pointers and two bitsets.
+ *
+ * Given the same choosing function invocation results, generateNewEntry
+ * yields the same entries as BoundedNodeTrie.
+ *
+ * @tparam ChoiceIndex Value type in which the count of possible choices is
+ *   representable. This needs to be an integer type.
+ *
+ * @note Complexiy annotations use @math{N} for the length of the set ChoiceList
+ * and @math{U} for the largest bound.
+ */
+template<typename ChoiceIndex>
+class CompactBoundedNodeTrie {
+  static_assert(std::is_integral<ChoiceIndex>::value, "ChoiceIndex must be an integral type");
+
+public:
+//!@name Public types
+//!@{
+  //! Type used to represent choices made at each level of the tree
+  using ChoiceList = std::vector<ChoiceIndex>;
+  /*!
+   * @brief Function signature needed to choose which child to descend to at a
+   *   level in the tree
+   */
+  using ChoosingFunction = std::function<ChoiceIndex(const std::vector<ChoiceIndex>&, const boost::dynamic_bitset<>&)>;
+//!@}
+
+//!@name Constructors
+//!@{
+  CompactBoundedNodeTrie() = default;
+  /**
+   * @brief Construct an empty trie, setting the upper exclusive bound on
+   *   values at each level
+   *
+   * @param bounds The upper exclusive bound on values at each level.
+   */
+  CompactBoundedNodeTrie(ChoiceList bounds) {
+    setBounds(std::move(bounds));
+  }
+//!@}
+
+//!@name Modification
+//!@{
+  /**
+   * @brief Inserts a value list into the prefix trie if not already present
+   *
+   * @complexity{@math{\Theta(N U)}}
+   *
+   * @param values The value list to insert into the prefix trie
+   *
+   * @throws std::logic_error If no bounds are set.
+   * @throws std::out_of_range If @p values does not match the bounds
+   *
+   * @returns Whether anything was inserted. I.e. returns true if @p values
+   *   was not yet a member of the set.
+   */
+  bool insert(const ChoiceList& values) {
+    if(bounds_.empty()) {
+      throw std::logic_error("No bounds are set!");
+    }
+    checkValues_(values);
+
+    establishRoot_();
+
+    const unsigned N = bounds_.size();
+    std::vector<Index> path(N);
+    Index node = 0;
+    for(unsigned depth = 0; depth + 1 < N; ++depth) {
+      path.at(depth) = node;
+      node = child_(depth, node, values.at(depth));
+    }
+
+    const std::size_t leafBit = std::size_t {node} * bounds_.back() + values.back();
+    if(leaves_.test(leafBit)) {
+      return false;
+    }
+
+    leaves_.set(leafBit);
+    markFull_(path, values, node);
+    ++size_;
+    return true;
+  }
+
+  /**
+   * @brief Create a new entry by choosing branch at each level of the trie
+   *
+   * @complexity{@math{\Theta(N U)}}
+   *
+   * @param chooseFunction Function that chooses the branch to descend to at
+   *   each level. The function is supplied a list of viable choices at the
+   *   depth (indicating which parts of the tree are full) and a bitset
+   *   indicating which children exist.
+   *
+   * @throws std::logic_error If the trie is full, i.e. size() == capacity()
+   *
+   * @return The newly generated entry
+   */
+  ChoiceList generateNewEntry(const ChoosingFunction& chooseFunction) {
+    if(bounds_.empty()) {
+      throw std::logic_error("No bounds are set!");
+    }
+
+    if(size_ == capacity_) {
+      throw std::logic_error("Trie is at capacity!");
+    }
+
+    establishRoot_();
+
+    const unsigned N = bounds_.size();
+    ChoiceList values;
+    values.reserve(N);
+    std::vector<Index> path(N);
+    std::vector<ChoiceIndex> viableIndices;
+    Index node = 0;
+    for(unsigned depth = 0; depth + 1 < N; ++depth) {
+      const ChoiceIndex U = bounds_.at(depth);
+      const Level& level = levels_.at(depth);
+      const std::size_t offset = std::size_t {node} * U;
+
+      boost::dynamic_bitset<> existingChildren(U);
+      viableIndices.clear();
+      for(ChoiceIndex i = 0; i < U; ++i) {
+        if(level.children.at(offset + i) != absent) {
+          existingChildren.set(i);
+        }
+        if(!level.fullChildren.test(offset + i)) {
+          viableIndices.push_back(i);
+        }
+      }
+
+      const ChoiceIndex choice = chooseFunction(viableIndices, existingChildren);
+      assert(choice < U);
+      assert(Temple::makeContainsPredicate(viableIndices)(choice));
+
+      values.push_back(choice);
+      path.at(depth) = node;
+      node = child_(depth, node, choice);
+    }
+
+    const ChoiceIndex U = bounds_.back();
+    const std::size_t offset = std::size_t {node} * U;
+    boost::dynamic_bitset<> existingChildren(U);
+    viableIndices.clear();
+    for(ChoiceIndex i = 0; i < U; ++i) {
+      if(leaves_.test(offset + i)) {
+        existingChildren.set(i);
+      } else {
+        viableIndices.push_back(i);
+      }
+    }
+
+    const ChoiceIndex choice = chooseFunction(viableIndices, existingChildren);
+    assert(choice < U);
+    assert(!existingChildren.test(choice));
+
+    values.push_back(choice);
+    leaves_.set(offset + choice);
+    markFull_(path, values, node);
+    ++size_;
+
+    return values;
+  }
+
+  /*! @brief Changes the bounds of the trie. Clears the trie.
+   *
+   * @complexity{@math{\Theta(N)}}
+   */
+  void setBounds(ChoiceList bounds) {
+    bounds_ = std::move(bounds);
+
+    // Make sure there is at least a single bound
+    assert(!bounds_.empty());
+    // For there to be a decision, there need to be at least two options
+    assert(
+      Temple::all_of(
+        bounds_,
+        [](const ChoiceIndex value) -> bool {
+          return value > 1;
+        }
+      )
+    );
+
+    capacity_ = Temple::accumulate(
+      bounds_,
+      1U,
+      std::multiplies<>()
+    );
+    clear();
+  }
+
+  /*! @brief Removes all inserted lists from the trie, releasing its memory
+   *
+   * @complexity{@math{\Theta(N)}}
+   */
+  void clear() {
+    levels_.clear();
+    levels_.shrink_to_fit();
+    leaves_.clear();
+    leaves_.shrink_to_fit();
+    size_ = 0;
+  }
+//!@}
+
+//!@name Information
+//!@{
+  /**
+   * @brief Checks whether a value list is present in the trie
+   *
+   * @complexity{@math{O(N)}}
+   *
+   * @param values The value list to check for
+   * @return Whether the value list is in the tree
+   */
+  bool contains(const ChoiceList& values) const {
+    if(!hasRoot_()) {
+      return false;
+    }
+    checkValues_(values);
+
+    const unsigned N = bounds_.size();
+    Index node = 0;
+    for(unsigned depth = 0; depth + 1 < N; ++depth) {
+      node = levels_.at(depth).children.at(std::size_t {node} * bounds_.at(depth) + values.at(depth));
+      if(node == absent) {
+        return false;
+      }
+    }
+
+    return leaves_.test(std::size_t {node} * bounds_.back() + values.back());
+  }
+
+  /*! @brief Calls a function with each value list in the trie in
+   *   lexicographical order
+   *
+   * @complexity{@math{\Theta(S U)} where @math{S} is the number of nodes}
+   */
+  template<typename UnaryFunction>
+  void forEach(UnaryFunction&& function) const {
+    if(!hasRoot_()) {
+      return;
+    }
+
+    ChoiceList values;
+    values.reserve(bounds_.size());
+    forEach_(function, values, 0, 0);
+  }
+
+  //! Accessor for underlying bounds
+  const ChoiceList& bounds() const {
+    return bounds_;
+  }
+
+  /*! @brief Returns the number of value lists this trie contains
+   *
+   * @complexity{@math{\Theta(1)}}
+   */
+  unsigned size() const {
+    return size_;
+  }
+
+  /*! @brief Returns the total number of value lists this trie might contain
+   *
+   * @complexity{@math{\Theta(1)}}
+   */
+  unsigned capacity() const {
+    return capacity_;
+  }
+
+  /*! @brief Number of bytes allocated for the nodes of the trie
+   *
+   * @complexity{@math{\Theta(N)}}
+   */
+  std::size_t memoryUsage() const {
+    using Block = boost::dynamic_bitset<>::block_type;
+    std::size_t bytes = leaves_.num_blocks() * sizeof(Block);
+    for(const Level& level : levels_) {
+      bytes += level.children.capacity() * sizeof(Index);
+      bytes += level.fullChildren.num_blocks() * sizeof(Block);
+    }
+    return bytes;
+  }
+//!@}
+
+private:
+//!@name Private types
+//!@{
+  using Index = std::uint32_t;
+
+  //! Marks a child that does not exist
+  static constexpr Index absent = std::numeric_limits<Index>::max();
+
+  /* Nodes at a level that is not the last. The children and fullness of child
+   * subtrees of node i are at i * U up to (i + 1) * U, where U is the
+   * level's bound. Child indices refer to nodes at the next level.
+   */
+  struct Level {
+    std::vector<Index> children;
+    boost::dynamic_bitset<> fullChildren;
+  };
+//!@}
+
+//!@name Private member functions
+//!@{
+  void checkValues_(const ChoiceList& values) const {
+    if(values.size() != bounds_.size()) {
+      throw std::out_of_range("Value list length does not match bounds");
+    }
+
+    for(unsigned i = 0; i < values.size(); ++i) {
+      if(values.at(i) >= bounds_.at(i)) {
+        throw std::out_of_range("Value list exceeds bounds");
+      }
+    }
+  }
+
+  //! Adds a node at a level, returning its index
+  Index addNode_(const unsigned depth) {
+    const ChoiceIndex U = bounds_.at(depth);
+    const bool isLastLevel = (depth + 1 == bounds_.size());
+    const std::size_t index = (isLastLevel ? leaves_.size() : levels_.at(depth).children.size()) / U;
+    if(index >= absent) {
+      throw std::length_error("Trie level node count exceeds index range");
+    }
+
+    if(isLastLevel) {
+      leaves_.resize(leaves_.size() + U);
+      return index;
+    }
+
+    Level& level = levels_.at(depth);
+    level.children.resize(level.children.size() + U, absent);
+    level.fullChildren.resize(level.fullChildren.size() + U);
+    return index;
+  }
+
+  bool hasRoot_() const {
+    if(bounds_.size() == 1) {
+      return !leaves_.empty();
+    }
+
+    return !levels_.empty() && !levels_.front().children.empty();
+  }
+
+  //! Generate a root node
+  void establishRoot_() {
+    if(hasRoot_()) {
+      return;
+    }
+
+    levels_.resize(bounds_.size() - 1);
+    addNode_(0);
+  }
+
+  template<typename UnaryFunction>
+  void forEach_(
+    UnaryFunction& function,
+    ChoiceList& values,
+    const unsigned depth,
+    const Index node
+  ) const {
+    const ChoiceIndex U = bounds_.at(depth);
+    const std::size_t offset = std::size_t {node} * U;
+    for(ChoiceIndex i = 0; i < U; ++i) {
+      values.push_back(i);
+      if(depth + 1 == bounds_.size()) {
+        if(leaves_.test(offset + i)) {
+          function(static_cast<const ChoiceList&>(values));
+        }
+      } else {
+        const Index child = levels_.at(depth).children.at(offset + i);
+        if(child != absent) {
+          forEach_(function, values, depth + 1, child);
+        }
+      }
+      values.pop_back();
+    }
+  }
+
+  //! Child of a node at a level, created if it does not exist yet
+  Index child_(const unsigned depth, const Index node, const ChoiceIndex choice) {
+    const std::size_t offset = std::size_t {node} * bounds_.at(depth) + choice;
+    Index child = levels_.at(depth).children.at(offset);
+    if(child == absent) {
+      child = addNode_(depth + 1);
+      levels_.at(depth).children.at(offset) = child;
+    }
+    return child;
+  }
+
+  //! Propagates fullness of the last level node along the inserted path
+  void markFull_(
+    const std::vector<Index>& path,
+    const ChoiceList& values,
+    const Index leafNode
+  ) {
+    const auto allSet = [](const boost::dynamic_bitset<>& bits, const std::size_t offset, const ChoiceIndex U) {
+      for(ChoiceIndex i = 0; i < U; ++i) {
+        if(!bits.test(offset + i)) {
+          return false;
+        }
+      }
+      return true;
+    };
+
+    const unsigned N = bounds_.size();
+    if(!allSet(leaves_, std::size_t {leafNode} * bounds_.back(), bounds_.back())) {
+      return;
+    }
+
+    for(unsigned depth = N - 1; depth-- > 0;) {
+      const ChoiceIndex U = bounds_.at(depth);
+      Level& level = levels_.at(depth);
+      const std::size_t offset = std::size_t {path.at(depth)} * U;
+      level.fullChildren.set(offset + values.at(depth));
+      if(!allSet(level.fullChildren, offset, U)) {
+        return;
+      }
+    }
+  }
+//!@}
+
+//!@name Private members
+//!@{
+  ChoiceList bounds_;
+  std::vector<Level> levels_;
+  boost::dynamic_bitset<> leaves_;
+  unsigned size_ = 0;
+  unsigned capacity_ = 0;
+//!@}
+};
+
+template<typename ChoiceIndex>
+constexpr typename CompactBoundedNodeTrie<ChoiceIndex>::Index CompactBoundedNodeTrie<ChoiceIndex>::absent;
+
+} // namespace Temple
+} // namespace Molassembler
+} // namespace Scine
+
+#endif
@@ -0,0 +1,70 @@
+/*!@file
+ * @copyright This code is licensed under the 3-clause BSD license.
+ *   Copyright ETH Zurich, Laboratory of Physical Chemistry, Reiher Group.
+ *   See LICENSE.txt for details.
+ * @brief Fixed-size table of values calculated once on first use
+ */
+
+#ifndef INCLUDE_MOLASSEMBLER_TEMPLE_ONCE_TABLE_H
+#define INCLUDE_MOLASSEMBLER_TEMPLE_ONCE_TABLE_H
+
+#include <array>
+#include <atomic>
+#include <memory>
+
+namespace Scine {
+namespace Molassembler {
+namespace Temple {
+
+/*! @brief Table of values calculated once on first use
+ *
+ * Calculated values are published into their slot with a single
+ * compare-and-swap, so readers never block. Threads racing to calculate the
+ * same slot may each calculate it, but only the first published value is
+ * kept.
+ */
+template<typename T, std::size_t N>
+class OnceTable {
+public:
+  OnceTable() = default;
+  OnceTable(const OnceTable& other) = delete;
+  OnceTable& operator = (const OnceTable& other) = delete;
+
+  ~OnceTable() {
+    for(auto& slot : slots_) {
+      delete slot.load(std::memory_order_relaxed);
+    }
+  }
+
+  //! Fetches a slot's value if it has been published
+  const T* get(const std::size_t i) const {
+    return slots_.at(i).load(std::memory_order_acquire);
+  }
+
+  //! Publishes a value into an empty slot, yields the slot's kept value
+  const T& publish(const std::size_t i, T value) {
+    auto owned = std::make_unique<T>(std::move(value));
+    const T* expected = nullptr;
+    if(
+      slots_.at(i).compare_exchange_strong(
+        expected,
+        owned.get(),
+        std::memory_order_acq_rel,
+        std::memory_order_acquire
+      )
+    ) {
+      return *owned.release();
+    }
+
+    return *expected;
+  }
+
+private:
+  std::array<std::atomic<const T*>, N> slots_ {};
+};
+
+} // namespace Temple
+} // namespace Molassembler
+} // namespace Scine
+
+#endif
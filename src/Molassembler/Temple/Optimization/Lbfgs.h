@@ -10,6 +10,9 @@
 #include "Molassembler/Temple/Stl17.h"
 #include "Molassembler/Temple/Optimization/Common.h"
 
+#include <numeric>
+#include <vector>
+
 /* TODO
  * - Detect ill-conditioning of LBFGS? Doesn't do well at all near maxima
  */
@@ -127,8 +130,9 @@ void adjustDirection(
  * @brief LBFGS optimizer with optional boxing
  *
  * @tparam FloatType Type to represent floating point numbers
- * @tparam ringBufferSize Number of gradients to use in Hessian approximation,
- *   this is akin to memory
+ * @tparam ringBufferSize Default number of gradients to use in Hessian
+ *   approximation, this is akin to memory. Can be changed at runtime with
+ *   historyLength.
  */
 template<typename FloatType = double, unsigned ringBufferSize = 16>
 class Lbfgs {
@@ -155,6 +159,14 @@ public:
     VectorType gradient;
   };
 
+  //! Type returned for each column of a batch optimization
+  struct BatchOptimizationReturnType : OptimizationReturnType {
+    /*! @brief Whether no step length reducing the objective function value
+     *   could be found. Single minimizations throw in this case.
+     */
+    bool lineSearchFailed;
+  };
+
   /**
    * @brief Type storing boundaries for parameter values
    */
@@ -233,6 +245,27 @@ public:
     }
   };
 
+  /*! @brief Normalized, possibly preconditioned steepest descent direction
+   *
+   * Small gradients are not normalized.
+   */
+  static VectorType initialDirection(
+    const VectorType& gradient,
+    const VectorType* diagonal
+  ) {
+    VectorType direction = FloatType {-1.0} * gradient;
+    if(diagonal != nullptr) {
+      direction = direction.cwiseProduct(*diagonal);
+    }
+
+    const FloatType directionNorm = direction.norm();
+    if(directionNorm > FloatType {1e-4}) {
+      direction /= directionNorm;
+    }
+
+    return direction;
+  }
+
   /**
    * @brief Class carrying proposed parameter updates in an optimization
    */
@@ -247,6 +280,7 @@ public:
      * @param function objective function generating values and gradients from parameters
      * @param initialParameters Parameters passed to optimization method
      * @param multiplier Initial step length
+     * @param diagonal Diagonal preconditioner, if any
      * @param boxes Bounds on the parameter values (optional parameter)
      *
      * @return First direction vector
@@ -256,6 +290,7 @@ public:
       UpdateFunction&& function,
       Eigen::Ref<VectorType> initialParameters,
       const FloatType multiplier,
+      const VectorType* diagonal,
       const Boxes& ... boxes
     ) {
       const unsigned P = initialParameters.size();
@@ -268,14 +303,7 @@ public:
       Detail::Boxes::adjustGradient<VectorType>(gradients.current, parameters.current, boxes ...);
 
       // Initialize new with a small steepest descent step
-      VectorType direction;
-      const FloatType gradientNorm = gradients.current.norm();
-      if(gradientNorm > FloatType {1e-4}) {
-        direction = -gradients.current / gradientNorm;
-      } else {
-        direction = FloatType {-1.0} * gradients.current;
-      }
-
+      VectorType direction = initialDirection(gradients.current, diagonal);
       prepare(function, multiplier, direction, boxes ...);
 
       return direction;
@@ -483,6 +511,104 @@ public:
     return results;
   }
 
+  /**
+   * @brief Minimize independent objective functions of a batch of parameter
+   *   sets in lock-step
+   *
+   * Each column of @p parameters is minimized exactly as by minimize, with
+   * its own step length and curvature history. In each round, all pending
+   * evaluations of columns that have not yet terminated are made in a single
+   * call to @p function, so that data shared by the objective functions is
+   * read once per round instead of once per column.
+   *
+   * @tparam BatchUpdateFunction A callable object taking arguments
+   *   (const MatrixType&, Ref<VectorType>, Ref<MatrixType>): parameters of a
+   *   subset of columns, their values and their gradients, one per column.
+   * @tparam Checker As in minimize
+   * @param parameters The initial parameters to optimize, one set per
+   *   column. Resulting optimization parameters are written to this argument.
+   * @param function The batch objective function
+   * @param checkers One Checker per column
+   *
+   * @note Curvature histories of batch minimizations are never retained and
+   *   each column starts with the current stepLength.
+   *
+   * @return An @p BatchOptimizationReturnType for each column
+   */
+  template<typename BatchUpdateFunction, typename Checker>
+  std::vector<BatchOptimizationReturnType> minimizeBatch(
+    Eigen::Ref<MatrixType> parameters,
+    BatchUpdateFunction&& function,
+    std::vector<Checker>& checkers
+  ) {
+    const unsigned P = parameters.rows();
+    const unsigned K = parameters.cols();
+    assert(checkers.size() == K);
+
+    std::vector<BatchColumn> columns(K);
+    for(unsigned k = 0; k < K; ++k) {
+      BatchColumn& column = columns[k];
+      column.step.parameters.current = parameters.col(k);
+      column.step.gradients.current.resize(P);
+      column.step.gradients.proposed.resize(P);
+      column.stepLength = stepLength;
+      column.ringBuffer.prepare(P, historyLength, false);
+    }
+
+    std::vector<unsigned> active(K);
+    std::iota(std::begin(active), std::end(active), 0);
+    MatrixType batchParameters;
+    VectorType batchValues;
+    MatrixType batchGradients;
+
+    while(!active.empty()) {
+      // Evaluate the pending parameters of all active columns at once
+      const unsigned A = active.size();
+      batchParameters.resize(P, A);
+      batchValues.resize(A);
+      batchGradients.resize(P, A);
+      for(unsigned a = 0; a < A; ++a) {
+        const BatchColumn& column = columns[active[a]];
+        batchParameters.col(a) = (column.phase == BatchPhase::Initial)
+          ? column.step.parameters.current
+          : column.step.parameters.proposed;
+      }
+
+      function(Stl17::as_const(batchParameters), batchValues, batchGradients);
+
+      // Advance each column to its next pending evaluation or termination
+      unsigned remaining = 0;
+      for(unsigned a = 0; a < A; ++a) {
+        const unsigned k = active[a];
+        BatchColumn& column = columns[k];
+        if(column.phase == BatchPhase::Initial) {
+          column.step.values.current = batchValues(a);
+          column.step.gradients.current = batchGradients.col(a);
+        } else {
+          column.step.values.proposed = batchValues(a);
+          column.step.gradients.proposed = batchGradients.col(a);
+        }
+
+        if(advanceBatchColumn(column, checkers[k])) {
+          active[remaining] = k;
+          ++remaining;
+        }
+      }
+      active.resize(remaining);
+    }
+
+    std::vector<BatchOptimizationReturnType> results(K);
+    for(unsigned k = 0; k < K; ++k) {
+      BatchColumn& column = columns[k];
+      parameters.col(k) = column.step.parameters.current;
+      results[k].iterations = column.iteration;
+      results[k].value = column.step.values.current;
+      results[k].gradient = std::move(column.step.gradients.current);
+      results[k].lineSearchFailed = column.lineSearchFailed;
+    }
+    return results;
+  }
+
   /**
    * @brief 1st parameter for the Wolfe conditions.
    */
@@ -499,31 +625,93 @@ public:
    * Note: the first step is a gradient descent with 0.1 times the steplength.
    */
   FloatType stepLength = 1.0;
+  /**
+   * @brief Number of gradient and parameter differences kept to approximate
+   *   the inverse Hessian
+   *
+   * Longer histories can reduce the number of iterations at the cost of
+   * memory and time per iteration linear in the history length.
+   */
+  unsigned historyLength = ringBufferSize;
+  /**
+   * @brief Whether a minimization starts with the curvature history of the
+   *   preceding one
+   *
+   * Useful if successive minimizations have similar objective functions,
+   * e.g. when a term is added to an objective function already minimized.
+   * The history is discarded regardless if the number of parameters or the
+   * history length differ from the preceding minimization.
+   */
+  bool retainHistory = false;
+
+  /**
+   * @brief Diagonal preconditioner approximating the inverse Hessian
+   *
+   * If sized as the parameters, directions are generated with this diagonal
+   * scaled by the latest curvature information as the initial inverse
+   * Hessian approximation instead of a scaled identity. Entries must be
+   * positive. Otherwise ignored.
+   */
+  VectorType preconditioner;
 
 private:
+  //! Preconditioner for a number of parameters, if applicable
+  const VectorType* preconditionerFor_(const Eigen::Index P) const {
+    if(preconditioner.size() == P) {
+      return &preconditioner;
+    }
+
+    return nullptr;
+  }
+
   /**
    * @brief Class containing hessian information for LBFGS update
    */
   struct CollectiveRingBuffer {
     //! Ring buffer containing gradient differences: y_k = g_{k+1} - g_k
-    Eigen::Matrix<FloatType, Eigen::Dynamic, ringBufferSize> y;
+    MatrixType y;
     //! Ring buffer containing parameter differnces: s_k = x_{k+1} - x_k
-    Eigen::Matrix<FloatType, Eigen::Dynamic, ringBufferSize> s;
+    MatrixType s;
     //! Ring buffered result of s_k.dot(y_k)
-    Eigen::Matrix<FloatType, ringBufferSize, 1> sDotY;
+    VectorType sDotY;
+    //! Two-loop recursion coefficients, kept allocated across directions
+    mutable VectorType alpha;
     unsigned count = 0, offset = 0;
 
-    CollectiveRingBuffer(const unsigned nParams)
-      : y(nParams, ringBufferSize),
-        s(nParams, ringBufferSize)
-    {}
+    //! Number of columns of the ring buffer
+    unsigned capacity() const {
+      return sDotY.size();
+    }
+
+    /*! @brief Prepares the buffer for a minimization, discarding stored
+     *   information unless requested and compatible
+     *
+     * Allocations are kept if the dimensions are unchanged.
+     */
+    void prepare(const unsigned nParams, const unsigned size, const bool retain) {
+      assert(size > 0);
+      if(
+        retain
+        && static_cast<unsigned>(y.rows()) == nParams
+        && capacity() == size
+      ) {
+        return;
+      }
+
+      y.resize(nParams, size);
+      s.resize(nParams, size);
+      sDotY.resize(size);
+      alpha.resize(size);
+      count = 0;
+      offset = 0;
+    }
 
     unsigned newestOffset() const {
-      return (count + offset - 1) % ringBufferSize;
+      return (count + offset - 1) % capacity();
     }
 
     unsigned oldestOffset() const {
-      return (count + offset) % ringBufferSize;
+      return (count + offset) % capacity();
     }
 
     /**
@@ -541,7 +729,7 @@ private:
         fn(i);
       }
 
-      const int countOrSizeLimit = std::min(count - 1, ringBufferSize - 1);
+      const int countOrSizeLimit = std::min(count - 1, capacity() - 1);
       for(int i = countOrSizeLimit; i > newest; --i) {
         fn(i);
       }
@@ -572,7 +760,7 @@ private:
       const Optimization::EigenUpdateBuffer<VectorType>& gradientBuffer
     ) {
       bool dotProductNotZero;
-      if(count < ringBufferSize) {
+      if(count < capacity()) {
         y.col(count).noalias() = gradientBuffer.proposed - gradientBuffer.current;
         s.col(count).noalias() = parameterBuffer.proposed - parameterBuffer.current;
         sDotY(count) = s.col(count).dot(y.col(count));
@@ -580,12 +768,12 @@ private:
         ++count;
       } else {
         // Rotate columns without copying (introduce modulo offset)
-        const unsigned columnOffset = (count + offset) % ringBufferSize;
+        const unsigned columnOffset = (count + offset) % capacity();
         y.col(columnOffset).noalias() = gradientBuffer.proposed - gradientBuffer.current;
         s.col(columnOffset).noalias() = parameterBuffer.proposed - parameterBuffer.current;
         sDotY(columnOffset) = s.col(columnOffset).dot(y.col(columnOffset));
         dotProductNotZero = (sDotY(columnOffset) != 0);
-        offset = (offset + 1) % ringBufferSize;
+        offset = (offset + 1) % capacity();
       }
 
       return dotProductNotZero;
@@ -597,10 +785,12 @@ private:
      *
      * @param q The vector in which to store the direction
      * @param proposedGradient The proposed gradient
+     * @param diagonal Diagonal preconditioner, if any
      */
     void generateNewDirection(
       Eigen::Ref<VectorType> q,
-      const VectorType& proposedGradient
+      const VectorType& proposedGradient,
+      const VectorType* diagonal
     ) const {
       /* Note: Naming follows Numerical Optimization (2006)'s naming scheme,
        * p.178.
@@ -608,7 +798,6 @@ private:
       const unsigned kMinusOne = newestOffset();
 
       q = -proposedGradient;
-      VectorType alpha(count);
 
       newestToOldest(
         [&](const unsigned i) {
@@ -627,8 +816,17 @@ private:
        * a new vector r we just reuse q.
        *
        * -> q *= gamma_k;
+       *
+       * With a diagonal preconditioner D, H_k^0 = gamma_k * D instead, where
+       * gamma_k = s_{k-1}^T y_{k-1} / (y_{k-1}^T D y_{k-1})
        */
-      q *= sDotY(kMinusOne) / y.col(kMinusOne).squaredNorm();
+      if(diagonal != nullptr) {
+        q = q.cwiseProduct(*diagonal) * (
+          sDotY(kMinusOne) / y.col(kMinusOne).cwiseProduct(*diagonal).dot(y.col(kMinusOne))
+        );
+      } else {
+        q *= sDotY(kMinusOne) / y.col(kMinusOne).squaredNorm();
+      }
 
       oldestToNewest(
         [&](const unsigned i) {
@@ -642,6 +840,7 @@ private:
     bool updateAndGenerateNewDirection(
       Eigen::Ref<VectorType> direction,
       const StepValues& step,
+      const VectorType* diagonal,
       const Boxes& ... boxes
     ) {
       /* L-BFGS update: Use current parameters and gradients to improve steepest
@@ -651,7 +850,7 @@ private:
         return false;
       }
 
-      generateNewDirection(direction, step.gradients.proposed);
+      generateNewDirection(direction, step.gradients.proposed, diagonal);
       Detail::Boxes::adjustDirection(
         direction,
         step.parameters.proposed,
@@ -783,14 +982,15 @@ private:
     assert(Detail::Boxes::validate(parameters, boxes ...));
 
     // Set up a first small conjugate gradient step
+    const VectorType* diagonal = preconditionerFor_(parameters.size());
     StepValues step;
-    VectorType direction = step.generateInitialDirection(function, parameters, stepLength, boxes ...);
+    VectorType direction = step.generateInitialDirection(function, parameters, stepLength, diagonal, boxes ...);
     observer(step.parameters.proposed);
 
     /* Set up ring buffer to keep changes in gradient and parameters to
      * approximate the inverse Hessian with
      */
-    CollectiveRingBuffer ringBuffer {static_cast<unsigned>(parameters.size())};
+    ringBuffer_.prepare(parameters.size(), historyLength, retainHistory);
 
     // Begin optimization loop
     unsigned iteration = 1;
@@ -805,7 +1005,7 @@ private:
       /* Add more information to approximate the inverse Hessian and use it to
        * generate a new direction.
        */
-      if(!ringBuffer.updateAndGenerateNewDirection(direction, step, boxes ...)) {
+      if(!ringBuffer_.updateAndGenerateNewDirection(direction, step, diagonal, boxes ...)) {
         break;
       }
 
@@ -824,6 +1024,118 @@ private:
       std::move(step.gradients.current)
     };
   }
+
+  //! Points in the minimization at which a batch column awaits an evaluation
+  enum class BatchPhase {
+    //! Initial parameters
+    Initial,
+    //! Parameters proposed after a direction update
+    Proposed,
+    //! Parameters proposed with an adjusted step length during line search
+    LineSearch
+  };
+
+  //! Minimization state of a single column of a batch
+  struct BatchColumn {
+    StepValues step;
+    VectorType direction;
+    CollectiveRingBuffer ringBuffer;
+    FloatType stepLength;
+    unsigned iteration = 1;
+    unsigned lineSearchIterations = 0;
+    BatchPhase phase = BatchPhase::Initial;
+    bool lineSearchFailed = false;
+
+    void propose() {
+      step.parameters.proposed.noalias() = step.parameters.current + stepLength * direction;
+    }
+  };
+
+  /*! @brief Advances a batch column's minimization after an evaluation of
+   *   its pending parameters
+   *
+   * Mirrors minimizeBase and adjustStepAlongDirection without boxes and
+   * observers.
+   *
+   * @return Whether the column has proposed parameters to evaluate next
+   */
+  template<typename Checker>
+  bool advanceBatchColumn(BatchColumn& column, Checker& check) const {
+    StepValues& step = column.step;
+
+    switch(column.phase) {
+      case BatchPhase::Initial: {
+        column.direction = initialDirection(
+          step.gradients.current,
+          preconditionerFor_(step.gradients.current.size())
+        );
+        column.propose();
+        column.phase = BatchPhase::Proposed;
+        return true;
+      }
+      case BatchPhase::Proposed:
+        if(!check.shouldContinue(column.iteration, Stl17::as_const(step))) {
+          return false;
+        }
+
+        if(column.stepLength < 1) {
+          column.stepLength = 1;
+        }
+        column.lineSearchIterations = 0;
+        break;
+      case BatchPhase::LineSearch:
+        ++column.lineSearchIterations;
+        break;
+    }
+
+    // Line search, see adjustStepAlongDirection
+    if(column.stepLength > 0 && column.lineSearchIterations < 100) {
+      const FloatType currentGradDotDirection = step.gradients.current.dot(column.direction);
+      const bool armijoRule = (
+        step.values.proposed
+        <= step.values.current + c1 * column.stepLength * currentGradDotDirection
+      );
+      const bool curvatureCondition = (
+        step.gradients.proposed.dot(column.direction)
+        >= c2 * currentGradDotDirection
+      );
+      const bool backtrack = (step.values.proposed >= step.values.current);
+
+      if(!armijoRule) {
+        column.stepLength *= FloatType {0.5};
+      } else if(!curvatureCondition) {
+        column.stepLength *= FloatType {1.5};
+      }
+
+      if(backtrack && (!armijoRule || !curvatureCondition)) {
+        column.propose();
+        column.phase = BatchPhase::LineSearch;
+        return true;
+      }
+    }
+
+    if(column.stepLength == 0) {
+      column.lineSearchFailed = true;
+      return false;
+    }
+
+    column.iteration += column.lineSearchIterations;
+    const VectorType* diagonal = preconditionerFor_(step.gradients.current.size());
+    if(!column.ringBuffer.updateAndGenerateNewDirection(column.direction, step, diagonal)) {
+      return false;
+    }
+
+    step.parameters.propagate();
+    step.values.propagate();
+    step.gradients.propagate();
+    column.propose();
+    column.phase = BatchPhase::Proposed;
+    ++column.iteration;
+    return true;
+  }
+
+  //! Curvature history, kept between minimizations
+  CollectiveRingBuffer ringBuffer_;
 };
 
 } // namespace Temple
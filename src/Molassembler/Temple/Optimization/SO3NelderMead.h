@@ -14,6 +14,8 @@
 #include "Molassembler/Temple/Adaptors/AllPairs.h"
 #include "Molassembler/Temple/Functional.h"
 
+#include <Eigen/StdVector>
+
 namespace Scine {
 namespace Molassembler {
 namespace Temple {
@@ -53,6 +55,17 @@ struct SO3NelderMead {
     unsigned minimalIndex;
   };
 
+  //! Type returned from a multi-start optimization
+  struct MultistartReturnType {
+    //! Index of the starting simplex yielding the minimal function value
+    unsigned start;
+    //! Optimization result of that starting simplex
+    OptimizationReturnType result;
+  };
+
+  //! Aligned list of simplices
+  using ParametersList = std::vector<Parameters, Eigen::aligned_allocator<Parameters>>;
+
   struct Manifold {
     // Returns the skew-symmetric parts of m
     template<typename Derived>
@@ -166,6 +179,59 @@ struct SO3NelderMead {
     return parameters;
   }
 
+  /**
+   * @brief Simplex of a base rotation and the base rotated about each
+   *   coordinate axis
+   *
+   * @param base Rotation of the first simplex vertex
+   * @param angle Angle in radians by which the base is rotated about each axis.
+   *   The default captures asymmetric tops and x/y mixups.
+   */
+  static Parameters axisParameters(
+    const Matrix& base = Matrix::Identity(),
+    const FloatType angle = M_PI / 2
+  ) {
+    Parameters parameters;
+    parameters.at(0) = base;
+    parameters.at(1) = Eigen::AngleAxis<FloatType>(angle, Eigen::Matrix<FloatType, 3, 1>::UnitX()).toRotationMatrix() * base;
+    parameters.at(2) = Eigen::AngleAxis<FloatType>(angle, Eigen::Matrix<FloatType, 3, 1>::UnitY()).toRotationMatrix() * base;
+    parameters.at(3) = Eigen::AngleAxis<FloatType>(angle, Eigen::Matrix<FloatType, 3, 1>::UnitZ()).toRotationMatrix() * base;
+    return parameters;
+  }
+
+  /**
+   * @brief Deterministic starting simplices for multi-start minimization
+   *
+   * The first simplex is axisParameters(). The others are the same simplex
+   * rotated by a quarter turn about axes spread evenly over the sphere.
+   */
+  static ParametersList multistartParameters(const unsigned count) {
+    ParametersList starts;
+    starts.reserve(count);
+    for(unsigned i = 0; i < count; ++i) {
+      if(i == 0) {
+        starts.push_back(axisParameters());
+        continue;
+      }
+
+      // Fibonacci sphere distribution of the rotation axes
+      const FloatType z = 1 - 2 * (i - FloatType {0.5}) / (count - 1);
+      const FloatType radius = std::sqrt(std::max(FloatType {0}, 1 - z * z));
+      const FloatType phi = i * M_PI * (3 - std::sqrt(FloatType {5}));
+      const Eigen::Matrix<FloatType, 3, 1> axis {
+        radius * std::cos(phi),
+        radius * std::sin(phi),
+        z
+      };
+      starts.push_back(
+        axisParameters(
+          Eigen::AngleAxis<FloatType>(M_PI / 4, axis.normalized()).toRotationMatrix()
+        )
+      );
+    }
+    return starts;
+  }
+
   struct IndexValuePair {
     unsigned column;
     FloatType value;
@@ -374,6 +440,67 @@ struct SO3NelderMead {
       values.front().column
     };
   }
+
+  /**
+   * @brief Minimizes from several starting simplices in parallel
+   *
+   * Each starting simplex is minimized independently by minimize(), so
+   * local minima found from some starts do not affect the others. The
+   * starts are distributed over threads.
+   *
+   * @param starts Starting simplices. Each is modified as in minimize().
+   * @param function Objective function. Must be safe to call concurrently.
+   * @param check Checker, copied for each start
+   *
+   * @throws std::logic_error If @p starts is empty or any starting simplex
+   *   does not lie within a ball of radius pi/2
+   *
+   * @returns The index of the start yielding the minimal function value and
+   *   its optimization result
+   */
+  template<
+    typename UpdateFunction,
+    typename Checker
+  > static MultistartReturnType minimizeMultistart(
+    ParametersList& starts,
+    UpdateFunction&& function,
+    const Checker& check
+  ) {
+    const int S = starts.size();
+    if(S == 0) {
+      throw std::logic_error("No starting simplices to minimize from");
+    }
+
+    std::vector<OptimizationReturnType> results(S);
+    bool anyInvalid = false;
+#pragma omp parallel for schedule(dynamic) reduction(||:anyInvalid)
+    for(int i = 0; i < S; ++i) {
+      Checker localCheck = check;
+      try {
+        results[i] = minimize(starts[i], function, localCheck);
+      } catch(std::logic_error& e) {
+        anyInvalid = true;
+      }
+    }
+
+    if(anyInvalid) {
+      throw std::logic_error(
+        "Initial simplex points do not lie within ball of radius pi/2"
+      );
+    }
+
+    const auto minimalIter = std::min_element(
+      std::begin(results),
+      std::end(results),
+      [](const OptimizationReturnType& a, const OptimizationReturnType& b) -> bool {
+        return a.value < b.value;
+      }
+    );
+    return {
+      static_cast<unsigned>(minimalIter - std::begin(results)),
+      *minimalIter
+    };
+  }
 };
 
 } // namespace Temple
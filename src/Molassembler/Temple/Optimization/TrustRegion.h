@@ -10,11 +10,12 @@
 
 #include "Molassembler/Temple/Stl17.h"
 #include "Molassembler/Temple/Optimization/Common.h"
-#include "Molassembler/Temple/Optimization/SylvestersCriterion.h"
 #include "boost/math/tools/roots.hpp"
+#include <Eigen/Cholesky>
 #include <Eigen/Eigenvalues>
 
 #include <iostream>
+#include <limits>
 
 namespace Scine {
 namespace Molassembler {
@@ -45,6 +46,9 @@ struct TROFloatingPointTolerances<float> {
 /**
  * @brief Trust region Newton-Raphson minimizer with 2D subspace minimization
  *
+ * Hessians that are not positive definite, e.g. of objective functions that
+ * are invariant to some motion of the parameters, are shifted until they are.
+ *
  * @tparam FloatType floating point type of the objective function
  */
 template<typename FloatType = double>
@@ -62,6 +66,18 @@ struct TrustRegionOptimizer {
     VectorType gradient;
   };
 
+  /**
+   * @brief Find parameters to minimize an objective function
+   *
+   * @tparam UpdateFunction Callable with (parameters, value, gradient,
+   *   hessian) setting the value, gradient and hessian of the objective
+   *   function
+   * @tparam Checker Type with member shouldContinue: (const unsigned
+   *   iterations, const StepValues& step) -> bool
+   * @param parameters Initial parameters, set to the final parameters
+   * @param function Objective function
+   * @param check Termination check
+   */
   template<
     typename UpdateFunction,
     typename Checker
@@ -95,11 +111,7 @@ struct TrustRegionOptimizer {
 
     for(
       ;
-      check.shouldContinue(
-        iterations,
-        Stl17::as_const(step.values.current),
-        Stl17::as_const(step.gradients.current)
-      );
+      check.shouldContinue(iterations, Stl17::as_const(step));
       ++iterations
     ) {
       modelAgreement = step.modelAgreement();
@@ -126,6 +138,8 @@ struct TrustRegionOptimizer {
       }
     }
 
+    parameters = step.parameters.current;
+
     return {
       iterations,
       step.values.current,
@@ -155,7 +169,7 @@ private:
       UpdateFunction&& function,
       const FloatType trustRadius
     ) {
-      parameters.current = std::move(initialParameters);
+      parameters.current = initialParameters;
       const unsigned P = parameters.current.size();
       parameters.proposed.resize(P);
       gradients.current.resize(P);
@@ -173,6 +187,7 @@ private:
      * @param trustRadius
      * @param g The gradient vector
      * @param B A positive definite matrix approximating the hessian
+     * @param BinverseG The solution of @math{Bx = g}
      *
      * Solves \f$\min_p m(p) = f + g^Tp + \frac{1}{2}p^TBp\f$
      * subject to \f$||p|| \le \Delta\f$ and \f$p \in \textrm{span}[g,B^{-1}g]\f$
@@ -183,15 +198,13 @@ private:
     VectorType subspaceMinimize(
       const FloatType trustRadius,
       const VectorType& g,
-      const MatrixType& B
+      const MatrixType& B,
+      const VectorType& BinverseG
     ) const {
       using Vector2Type = Eigen::Matrix<FloatType, 2, 1>;
       using Matrix2Type = Eigen::Matrix<FloatType, 2, 2>;
 
-      assert(positiveDefinite(B));
-      const MatrixType Binverse = B.inverse();
-
-      const Vector2Type gTilde {g.squaredNorm(), g.dot(Binverse * g)};
+      const Vector2Type gTilde {g.squaredNorm(), g.dot(BinverseG)};
       Matrix2Type BTilde;
       BTilde << g.dot(B * g), gTilde(0),
                 gTilde(0), gTilde(1);
@@ -200,25 +213,33 @@ private:
 
       Matrix2Type BBar;
       BBar << gTilde(0), gTilde(1),
-              gTilde(1), (Binverse * g).squaredNorm();
+              gTilde(1), BinverseG.squaredNorm();
       BBar *= 2;
 
       const FloatType J = FloatType {0.5} * uStar.transpose() * BBar * uStar;
       const FloatType trustRadiusSquare = trustRadius * trustRadius;
 
       if(J <= trustRadiusSquare) {
-        return uStar(0) * g + uStar(1) * Binverse * g;
+        return uStar(0) * g + uStar(1) * BinverseG;
       }
 
       // Now we have to find lambda
+      const auto excess = [&](const FloatType lambda) -> FloatType {
+        const Vector2Type intermediate = (BTilde + lambda * BBar).inverse() * gTilde;
+        return FloatType {0.5} * intermediate.transpose() * BBar * intermediate - trustRadiusSquare;
+      };
+
+      // The step length decreases with lambda. Large gradients need large lambda.
+      FloatType upperLambda = 100.0;
+      while(excess(upperLambda) > 0 && upperLambda < std::numeric_limits<FloatType>::max() / 4) {
+        upperLambda *= 4;
+      }
+
       boost::uintmax_t iterations = 1000;
       auto root_result = boost::math::tools::toms748_solve(
-        [&](const FloatType lambda) -> FloatType {
-          const Vector2Type intermediate = (BTilde + lambda * BBar).inverse() * gTilde;
-          return FloatType {0.5} * intermediate.transpose() * BBar * intermediate - trustRadiusSquare;
-        },
+        excess,
         std::nextafter(FloatType {0.0}, FloatType {1.0}),
-        FloatType {100.0},
+        upperLambda,
         boost::math::tools::eps_tolerance<FloatType> {
           Detail::TROFloatingPointTolerances<FloatType>::rootBitAccuracy
         },
@@ -233,63 +254,55 @@ private:
 
       // Calculate uMin and calculate p from it
       const Vector2Type uMin = -(BTilde + lambda * BBar).inverse() * gTilde;
-      return uMin(0) * g + uMin(1) * Binverse * g;
+      return uMin(0) * g + uMin(1) * BinverseG;
     }
 
     VectorType determineDirection(const FloatType trustRadius) const {
-      if(positiveDefinite(hessians.current)) {
-        return subspaceMinimize(trustRadius, gradients.current, hessians.current);
-      }
+      const MatrixType& B = hessians.current;
+      const VectorType& g = gradients.current;
 
-      /* Now there are several possible cases for what the hessian is currently
-       * like, but we'll need the eigenvalues to determine what to do.
-       *
-       * The hessian is a symmetric real matrix, so it is also self-adjoint,
-       * which we exploit for faster eigenvalue calculation:
+      /* The hessian is a symmetric real matrix, so it is also self-adjoint,
+       * which we exploit for faster eigenvalue calculation. Eigenvalues are
+       * ordered ascending.
        */
-      VectorType eigenvalues = hessians.current.template selfadjointView<Eigen::Lower>().eigenvalues();
+      const VectorType eigenvalues = B.template selfadjointView<Eigen::Lower>().eigenvalues();
+      const FloatType largestMagnitude = std::max(
+        std::fabs(eigenvalues(0)),
+        std::fabs(eigenvalues(eigenvalues.size() - 1))
+      );
 
-      /* First case: there are negative eigenvalues. In this case we adjust
-       * the hessian with a unitary matrix to become positive definite:
+      if(largestMagnitude == 0) {
+        // No curvature information at all: Steepest descent to the trust radius
+        return -(trustRadius / g.norm()) * g;
+      }
+
+      /* Eigenvalues below a small fraction of the largest curvature, e.g. of
+       * motions of the parameters to which the objective function is
+       * invariant, make for an ill-conditioned subspace minimization.
        */
-      if((eigenvalues.array() < FloatType {0.0}).any()) {
-        // Eigenvalues are ordered ascending
-        const FloatType mostNegativeEigenvalue = eigenvalues(0);
-        /* Nocedal & Wright say to choose alpha between (-λ,-2λ], so we
-         * go right in the middle because we don't know anything about the
-         * significance of the choice.
-         */
-        const FloatType alpha = FloatType {-1.5} * mostNegativeEigenvalue;
-        const unsigned P = parameters.current.size();
-        const Eigen::MatrixXd modifiedHessian = hessians.current + alpha * Eigen::MatrixXd::Identity(P, P);
-
-        /* Subspace minimize the modified hessian
-         *
-         * NOTE: Nocedal & Wright say to differentiate some things further
-         * here, but I think the subspace minimization procedure itself
-         * differentiates those cases.
-         */
-        return subspaceMinimize(trustRadius, gradients.current, modifiedHessian);
+      const FloatType lift = std::sqrt(std::numeric_limits<FloatType>::epsilon()) * largestMagnitude;
+      if(eigenvalues(0) > lift) {
+        return subspaceMinimize(trustRadius, g, B, B.llt().solve(g));
       }
 
-      /* Remaining case: There are no negative eigenvalues, but the hessian is
-       * not positive definite. There must be eigenvalues of value zero. In
-       * this case, we use the cauchy point to make progress:
+      /* Shift the hessian by a multiple of the identity to become positive
+       * definite. For negative eigenvalues λ, Nocedal & Wright say to choose
+       * alpha between (-λ,-2λ], so we go right in the middle because we don't
+       * know anything about the significance of the choice. Additionally
+       * shifting by the lift bounds the condition of the modified hessian.
+       *
+       * NOTE: Nocedal & Wright say to differentiate some things further
+       * here, but I think the subspace minimization procedure itself
+       * differentiates those cases.
        */
-      const FloatType gradientNorm = gradients.current.norm();
-      const FloatType tau = [&]() -> FloatType {
-        const FloatType cauchyIntermediate = gradients.current.transpose() * hessians.current * gradients.current;
-        if(cauchyIntermediate <= 0) {
-          return 1.0;
-        }
-
-        return std::min(
-          std::pow(gradientNorm, 3) / (trustRadius * cauchyIntermediate),
-          1.0
-        );
-      }();
-
-      return - (tau * trustRadius / gradientNorm) * gradients.current;
+      const FloatType alpha = lift - FloatType {1.5} * std::min(eigenvalues(0), FloatType {0});
+      const MatrixType modifiedHessian = B + alpha * MatrixType::Identity(B.rows(), B.cols());
+      return subspaceMinimize(
+        trustRadius,
+        g,
+        modifiedHessian,
+        modifiedHessian.llt().solve(g)
+      );
     }
 
     template<typename UpdateFunction>
@@ -38,7 +38,8 @@ namespace Temple {
  * // poset is now totally ordered: {12}, {10}, {6}, {4}, {11}, {5}
  * @endcode
  *
- * @note This class would probably benefit immensely from a pool allocator.
+ * Values are kept in a single contiguous buffer that subsets are ranges of,
+ * so ordering rearranges values in place instead of allocating per subset.
  */
 template<typename T>
 class Poset {
@@ -49,27 +50,24 @@ public:
   struct Subset {
     using const_iterator = typename std::vector<T>::const_iterator;
 
-    std::vector<T> values;
+    const_iterator first;
+    const_iterator last;
     bool ordered = false;
 
-    //! Single-value constructor
-    Subset(T value) {
-      values.push_back(std::move(value));
+    const_iterator begin() const {
+      return first;
     }
 
-    //! Vector constructor
-    Subset(std::vector<T> passValues) : values(std::move(passValues)) {}
-
-    //! Range constructor
-    template<typename Iter>
-    Subset(Iter begin, Iter end) : values(begin, end) {}
+    const_iterator end() const {
+      return last;
+    }
 
-    const_iterator begin() const {
-      return std::begin(values);
+    const T& front() const {
+      return *first;
     }
 
-    const_iterator end() const {
-      return std::end(values);
+    unsigned size() const {
+      return last - first;
     }
   };
 
@@ -99,6 +97,16 @@ public:
     );
   }
 
+  Poset(const Poset& other) : values_(other.values_) {
+    rebase_(other);
+  }
+
+  Poset& operator = (const Poset& other) {
+    values_ = other.values_;
+    rebase_(other);
+    return *this;
+  }
+
   /*! @brief Sets the values in the specified range as the only unordered Subset
    *
    * @complexity{@math{\Theta(N)}}
@@ -109,8 +117,12 @@ public:
    */
   template<typename Iter>
   void setUnorderedValues(Iter&& begin, Iter&& end) {
-    subsets.clear();
-    subsets.emplace_back(std::forward<Iter>(begin), std::forward<Iter>(end));
+    values_.assign(std::forward<Iter>(begin), std::forward<Iter>(end));
+    subsets_.clear();
+    subsets_.reserve(values_.size());
+    if(!values_.empty()) {
+      subsets_.push_back(Subset {values_.cbegin(), values_.cend(), false});
+    }
   }
 
   /*! @brief Adds order to unordered Subsets
@@ -126,68 +138,42 @@ public:
    */
   template<typename Comparator>
   void orderUnordered(Comparator&& comparator) {
-    auto lowerBoundComparator = [&comparator](const Subset& set, const T& t) -> bool {
-      return comparator(set.values.front(), t);
-    };
-
+    /* Subsets only ever split, so the list of subsets is rebuilt in a
+     * reserved scratch buffer
+     */
     std::vector<Subset> newSubsets;
-    newSubsets.reserve(subsets.size());
-    for(Subset& subset : subsets) {
-      // If the subset is already ordered, move it to the newSubsets
+    newSubsets.reserve(values_.size());
+    for(const Subset& subset : subsets_) {
+      // If the subset is already ordered, keep it
       if(subset.ordered) {
-        newSubsets.push_back(std::move(subset));
+        newSubsets.push_back(subset);
         continue;
       }
 
-      // Unordered Subsets may split into multiple Subsets
-      std::vector<Subset> splat;
-      for(auto& value : subset) {
-        // Find which Subset this element belongs to using binary search
-        auto findIter = std::lower_bound(
-          std::begin(splat),
-          std::end(splat),
-          value,
-          lowerBoundComparator
-        );
-
-        if(findIter == std::end(splat)) {
-          // This element does not belong to any existing Subset, so we create one
-          splat.emplace_back(std::move(value));
-          continue;
+      // Stable insertion sort of the subset's values
+      const auto first = mutableIterator_(subset.first);
+      const auto last = mutableIterator_(subset.last);
+      for(auto iter = first + 1; iter < last; ++iter) {
+        T value = std::move(*iter);
+        auto hole = iter;
+        for(/* */; hole != first && comparator(value, *(hole - 1)); --hole) {
+          *hole = std::move(*(hole - 1));
         }
-
-        if(!comparator(value, findIter->values.front())) {
-          // This element belongs to the set pointed to by findIter
-          findIter->values.push_back(std::move(value));
-          continue;
-        }
-
-        /* Last possibility: This element is part of a new set that should be
-         * inserted before the set pointed to by findIter
-         */
-        splat.emplace(
-          findIter,
-          std::move(value)
-        );
+        *hole = std::move(value);
       }
 
-      // Finalize single-element sets
-      for(auto& splatSet : splat) {
-        if(splatSet.values.size() == 1) {
-          splatSet.ordered = true;
+      // Split into runs of indistinguishable values
+      auto runStart = first;
+      for(auto iter = first + 1; iter <= last; ++iter) {
+        if(iter == last || comparator(*runStart, *iter)) {
+          // Finalize single-element sets
+          newSubsets.push_back(Subset {runStart, iter, iter - runStart == 1});
+          runStart = iter;
         }
       }
-
-      // Move the split up sets into the new subsets
-      std::move(
-        std::begin(splat),
-        std::end(splat),
-        std::back_inserter(newSubsets)
-      );
     }
 
-    // Overwrite subsets with the new ones
-    subsets = std::move(newSubsets);
+    subsets_ = std::move(newSubsets);
   }
 
   /*!
@@ -200,17 +186,17 @@ public:
    * @complexity{@math{\Theta(S)}}
    */
   void finalize() {
-    for(Subset& subset : subsets) {
+    for(Subset& subset : subsets_) {
       subset.ordered = true;
     }
   }
 
   const_iterator begin() const {
-    return std::begin(subsets);
+    return std::begin(subsets_);
   }
 
   const_iterator end() const {
-    return std::end(subsets);
+    return std::end(subsets_);
   }
 
   /*! @brief Convert the Poset to a string representation for debug purposes
@@ -219,7 +205,7 @@ public:
    */
   std::string toString() const {
     std::string str = "{";
-    for(const Subset& subset : subsets) {
+    for(const Subset& subset : subsets_) {
       auto it = std::begin(subset);
       while(true) {
         str += std::to_string(*it);
@@ -249,8 +235,8 @@ public:
    */
   const_iterator find(const T& a) const {
     return std::find_if(
-      std::begin(subsets),
-      std::end(subsets),
+      std::begin(subsets_),
+      std::end(subsets_),
       [&a](const Subset& subset) -> bool {
         return std::find(
           std::begin(subset),
@@ -277,7 +263,7 @@ public:
    *   - indeterminate if ordering is unknown
    */
   boost::tribool compare(const T& a, const T& b) const {
-    const auto subsetEnd = std::end(subsets);
+    const auto subsetEnd = std::end(subsets_);
     auto aIter = find(a);
 
     if(aIter == subsetEnd) {
@@ -304,7 +290,7 @@ public:
      * If the subset is ordered, then the elements are equal. Otherwise, the
      * order is indeterminate.
      */
-    if(aIter.first->ordered) {
+    if(aIter->ordered) {
       return false;
     }
 
@@ -318,21 +304,47 @@ public:
   std::vector<
     std::vector<T>
   > extract() {
-    const unsigned N = subsets.size();
+    const unsigned N = subsets_.size();
     std::vector<
       std::vector<T>
     > extracted(N);
 
     for(unsigned i = 0; i < N; ++i) {
-      extracted[i] = std::move(subsets[i].values);
+      extracted[i].assign(
+        std::make_move_iterator(mutableIterator_(subsets_[i].first)),
+        std::make_move_iterator(mutableIterator_(subsets_[i].last))
+      );
     }
 
-    subsets.clear();
+    subsets_.clear();
+    values_.clear();
     return extracted;
   }
 
 private:
-  std::vector<Subset> subsets;
+  //! Contiguous values, in order of their subsets
+  std::vector<T> values_;
+  //! Ranges of values_
+  std::vector<Subset> subsets_;
+
+  typename std::vector<T>::iterator mutableIterator_(typename Subset::const_iterator iter) {
+    return std::begin(values_) + (iter - values_.cbegin());
+  }
+
+  //! Copies subsets of another poset as ranges of this poset's values
+  void rebase_(const Poset& other) {
+    subsets_.clear();
+    subsets_.reserve(values_.size());
+    for(const Subset& subset : other.subsets_) {
+      subsets_.push_back(
+        Subset {
+          values_.cbegin() + (subset.first - other.values_.cbegin()),
+          values_.cbegin() + (subset.last - other.values_.cbegin()),
+          subset.ordered
+        }
+      );
+    }
+  }
 };
 
 } // namespace Temple
@@ -5,18 +5,33 @@
  * @brief Vector-adapting set-like objects for small collections
  *
  * Vector-based set-like objects for very small collections in order to reduce
- * space overhead and avoid `std::set`'s trees for better performance.
+ * space overhead and avoid `std::set`'s trees for better performance. Given an
+ * inline capacity, values are stored within the object until they outgrow it.
  */
 
 #ifndef INCLUDE_MOLASSEMBLER_TEMPLE_TINY_SETS_H
 #define INCLUDE_MOLASSEMBLER_TEMPLE_TINY_SETS_H
 
+#include "boost/container/small_vector.hpp"
+
 #include <vector>
 #include <algorithm>
+#include <type_traits>
 
 namespace Scine {
 namespace Molassembler {
 namespace Temple {
+namespace Detail {
+
+//! Linear memory container with optional inline capacity
+template<typename T, unsigned InlineCapacity>
+using TinySetContainer = std::conditional_t<
+  InlineCapacity == 0,
+  std::vector<T>,
+  boost::container::small_vector<T, InlineCapacity>
+>;
+
+} // namespace Detail
 
 /*!
  * @brief An adapter class for std::vector that acts like an unordered set
@@ -27,14 +42,16 @@ namespace Temple {
  * a value is at around N = 80 for numeric types, although I certainly do not
  * trust the benchmark much.
  *
- * @tparam The set value type
+ * @tparam T The set value type
+ * @tparam InlineCapacity Number of values stored without heap allocation. If
+ *   zero, values are stored in a std::vector.
  */
-template<typename T>
+template<typename T, unsigned InlineCapacity = 0>
 struct TinyUnorderedSet {
 //!@name Types
 //!@{
   //! The type of the underlying container with linear memory
-  using UnderlyingContainer = std::vector<T>;
+  using UnderlyingContainer = Detail::TinySetContainer<T, InlineCapacity>;
   //! What types this container stores
   using value_type = T;
   //! Reference to a value_type
@@ -42,9 +59,9 @@ struct TinyUnorderedSet {
   //! Const reference to a value type
   using const_reference = const T&;
   //! Iterator type
-  using iterator = typename std::vector<T>::iterator;
+  using iterator = typename UnderlyingContainer::iterator;
   //! Const iterator type
-  using const_iterator = typename std::vector<T>::const_iterator;
+  using const_iterator = typename UnderlyingContainer::const_iterator;
 //!@}
 
 //!@name State
@@ -85,7 +102,7 @@ struct TinyUnorderedSet {
    * @return Whether the element was already in the set
    */
   static bool checked_insert(std::vector<T>& set, T a) {
-    if(!contains(set, a)) {
+    if(!linear_search(set, a)) {
       set.push_back(std::move(a));
       return false;
     }
@@ -255,14 +272,16 @@ struct TinyUnorderedSet {
  * a value is at around N = 200 for numeric types, although I certainly do not
  * trust the benchmark much.
  *
- * @tparam The set value type
+ * @tparam T The set value type
+ * @tparam InlineCapacity Number of values stored without heap allocation. If
+ *   zero, values are stored in a std::vector.
  */
-template<typename T>
+template<typename T, unsigned InlineCapacity = 0>
 struct TinySet {
 //!@name Types
 //!@{
   //! The type of the underlying container with linear memory
-  using UnderlyingContainer = std::vector<T>;
+  using UnderlyingContainer = Detail::TinySetContainer<T, InlineCapacity>;
   //! What types this container stores
   using value_type = T;
   //! Reference to a value_type
@@ -270,9 +289,9 @@ struct TinySet {
   //! Const reference to a value type
   using const_reference = const T&;
   //! Iterator type
-  using iterator = typename std::vector<T>::iterator;
+  using iterator = typename UnderlyingContainer::iterator;
   //! Const iterator type
-  using const_iterator = typename std::vector<T>::const_iterator;
+  using const_iterator = typename UnderlyingContainer::const_iterator;
 //!@}
 
 //!@name State
@@ -303,7 +322,7 @@ struct TinySet {
 
 //!@name Static functions
 //!@{
-  static iterator find(std::vector<T>& set, const T& a) {
+  static typename std::vector<T>::iterator find(std::vector<T>& set, const T& a) {
     return std::lower_bound(
       std::begin(set),
       std::end(set),
@@ -311,7 +330,7 @@ struct TinySet {
     );
   }
 
-  static const_iterator find(const std::vector<T>& set, const T& a) {
+  static typename std::vector<T>::const_iterator find(const std::vector<T>& set, const T& a) {
     return std::lower_bound(
       std::begin(set),
       std::end(set),
@@ -320,7 +339,7 @@ struct TinySet {
   }
 
   static void checked_insert(std::vector<T>& set, T a) {
-    iterator findIter = find(set, a);
+    auto findIter = find(set, a);
 
     /* Condition lifted directly from std::binary_search. If the element equals
      * a, then the set already contains the element. In that case, do nothing.
@@ -352,10 +371,10 @@ struct TinySet {
     // In-place construct the element at the back of the set
     set.emplace_back(std::forward<Args>(args)...);
 
-    iterator lastElementIter = std::end(set) - 1;
+    auto lastElementIter = std::end(set) - 1;
 
     // Search the range before it for an identical element
-    iterator findIter = std::lower_bound(
+    auto findIter = std::lower_bound(
       std::begin(set),
       lastElementIter,
       set.back()
@@ -0,0 +1,132 @@
+/*!@file
+ * @copyright This code is licensed under the 3-clause BSD license.
+ *   Copyright ETH Zurich, Laboratory of Physical Chemistry, Reiher Group.
+ *   See LICENSE.txt for details.
+ * @brief Set of bounded indices with constant time clearing
+ *
+ * Graph traversals keep track of the vertices they have visited. For dense
+ * vertex indices, marking them in an array avoids the hashing and node
+ * allocations of `std::unordered_set`. Stamping marks with a generation makes
+ * clearing constant time, so that a single set can be reused across many
+ * traversals.
+ */
+
+#ifndef INCLUDE_MOLASSEMBLER_TEMPLE_VISITED_SET_H
+#define INCLUDE_MOLASSEMBLER_TEMPLE_VISITED_SET_H
+
+#include <algorithm>
+#include <cassert>
+#include <vector>
+
+namespace Scine {
+namespace Molassembler {
+namespace Temple {
+
+/**
+ * @brief Set of indices below a bound, cleared in constant time
+ *
+ * Each index has a stamp. An index is in the set if its stamp matches the
+ * current generation, so clearing the set only increments the generation.
+ *
+ * @code{.cpp}
+ * thread_local Temple::VisitedSet<AtomIndex> visited;
+ * visited.reset(graph.V());
+ * if(visited.insert(i)) {
+ *   // First visit of i
+ * }
+ * @endcode
+ *
+ * @tparam T Index type convertible to and from std::size_t
+ */
+template<typename T = unsigned>
+class VisitedSet {
+public:
+//!@name Constructors
+//!@{
+  //! Empty set without any capacity
+  VisitedSet() = default;
+
+  //! Empty set of indices below a bound
+  explicit VisitedSet(const std::size_t N) : stamps_(N, 0) {}
+//!@}
+
+//!@name Modification
+//!@{
+  /*! @brief Empties the set
+   *
+   * @complexity{@math{\Theta(1)} amortized}
+   */
+  void clear() {
+    ++generation_;
+    // On overflow, no stale stamp may match the restarted generation
+    if(generation_ == 0) {
+      std::fill(std::begin(stamps_), std::end(stamps_), 0);
+      generation_ = 1;
+    }
+  }
+
+  /*! @brief Empties the set and raises the index bound if necessary
+   *
+   * @complexity{@math{\Theta(1)} amortized if the bound is not raised}
+   */
+  void reset(const std::size_t N) {
+    clear();
+    if(stamps_.size() < N) {
+      stamps_.resize(N, 0);
+    }
+  }
+
+  /*! @brief Inserts an index
+   *
+   * @complexity{@math{\Theta(1)}}
+   * @return Whether the index was not yet in the set
+   */
+  bool insert(const T i) {
+    assert(static_cast<std::size_t>(i) < stamps_.size());
+    unsigned& stamp = stamps_[static_cast<std::size_t>(i)];
+    if(stamp == generation_) {
+      return false;
+    }
+
+    stamp = generation_;
+    return true;
+  }
+
+  /*! @brief Removes an index
+   *
+   * @complexity{@math{\Theta(1)}}
+   */
+  void erase(const T i) {
+    assert(static_cast<std::size_t>(i) < stamps_.size());
+    stamps_[static_cast<std::size_t>(i)] = 0;
+  }
+//!@}
+
+//!@name Information
+//!@{
+  /*! @brief Number of matching indices in the set, zero or one
+   *
+   * @complexity{@math{\Theta(1)}}
+   */
+  unsigned count(const T i) const {
+    assert(static_cast<std::size_t>(i) < stamps_.size());
+    return stamps_[static_cast<std::size_t>(i)] == generation_ ? 1 : 0;
+  }
+
+  //! Exclusive upper bound on insertable indices
+  std::size_t bound() const {
+    return stamps_.size();
+  }
+//!@}
+
+private:
+  std::vector<unsigned> stamps_;
+  //! Never zero, so that zeroed stamps are never in the set
+  unsigned generation_ = 1;
+};
+
+} // namespace Temple
+} // namespace Molassembler
+} // namespace Scine
+
+#endif
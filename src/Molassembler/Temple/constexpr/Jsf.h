@@ -123,6 +123,14 @@ public:
   }
 //!@}
 
+//!@name Information
+//!@{
+  //! Underlying state, from which the generator can be re-seeded exactly
+  constexpr std::array<UnsignedType, 4> state() const {
+    return {{a_, b_, c_, d_}};
+  }
+//!@}
+
 //!@name Operators
 //!@{
   /*! @brief Advance the state and return the current value
@@ -0,0 +1,228 @@
+/*!@file
+ * @copyright This code is licensed under the 3-clause BSD license.
+ *   Copyright ETH Zurich, Laboratory of Physical Chemistry, Reiher Group.
+ *   See LICENSE.txt for details.
+ */
+
+#include "Molassembler/Trace.h"
+
+#include "Molassembler/Detail/Trace.h"
+#include "nlohmann/json.hpp"
+
+#include <algorithm>
+#include <array>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace Scine {
+namespace Molassembler {
+namespace {
+
+using Clock = std::chrono::steady_clock;
+using Nanoseconds = std::chrono::nanoseconds;
+
+constexpr std::size_t maxThreadEvents = 1000000;
+constexpr unsigned histogramBuckets = 32;
+
+double seconds(const Nanoseconds duration) {
+  return std::chrono::duration<double>(duration).count();
+}
+
+double microseconds(const Nanoseconds duration) {
+  return std::chrono::duration<double, std::micro>(duration).count();
+}
+
+struct Event {
+  const char* name;
+  Clock::time_point begin;
+  Nanoseconds duration;
+};
+
+struct Aggregate {
+  //! Histogram bucket k counts durations in [2^k, 2^(k+1)) microseconds
+  static unsigned bucket(const Nanoseconds duration) {
+    auto micro = std::chrono::duration_cast<std::chrono::microseconds>(duration).count();
+    unsigned k = 0;
+    while(micro > 1 && k + 1 < histogramBuckets) {
+      micro >>= 1;
+      ++k;
+    }
+    return k;
+  }
+
+  void add(const Nanoseconds duration) {
+    ++count;
+    total += duration;
+    min = std::min(min, duration);
+    max = std::max(max, duration);
+    ++histogram.at(bucket(duration));
+  }
+
+  void merge(const Aggregate& other) {
+    count += other.count;
+    total += other.total;
+    min = std::min(min, other.min);
+    max = std::max(max, other.max);
+    for(unsigned k = 0; k < histogramBuckets; ++k) {
+      histogram[k] += other.histogram[k];
+    }
+  }
+
+  unsigned long count = 0;
+  Nanoseconds total {0};
+  Nanoseconds min = Nanoseconds::max();
+  Nanoseconds max {0};
+  std::array<unsigned long, histogramBuckets> histogram {};
+};
+
+//! Spans of a single thread
+struct ThreadTrace {
+  //! Recording is only ever contended by dumps
+  std::mutex mutex;
+  unsigned thread;
+  std::vector<Event> events;
+  //! Keyed by name literal address, merged by name in dumps
+  std::unordered_map<const char*, Aggregate> aggregates;
+};
+
+struct Registry {
+  std::mutex mutex;
+  std::vector<std::shared_ptr<ThreadTrace>> threads;
+};
+
+Registry& registry() {
+  // Pursuant to Construct-on-first-use idiom
+  static Registry registry;
+  return registry;
+}
+
+//! Kept alive by the registry past the end of its thread until cleared
+ThreadTrace& threadTrace() {
+  thread_local const std::shared_ptr<ThreadTrace> trace = []() {
+    auto created = std::make_shared<ThreadTrace>();
+    Registry& shared = registry();
+    std::lock_guard<std::mutex> lock(shared.mutex);
+    created->thread = shared.threads.size();
+    shared.threads.push_back(created);
+    return created;
+  }();
+  return *trace;
+}
+
+} // namespace
+
+namespace Detail {
+
+void recordTraceSpan(
+  const char* const name,
+  const Clock::time_point begin,
+  const Clock::time_point end
+) {
+  ThreadTrace& trace = threadTrace();
+  const auto duration = std::chrono::duration_cast<Nanoseconds>(end - begin);
+  std::lock_guard<std::mutex> lock(trace.mutex);
+  trace.aggregates[name].add(duration);
+  if(trace.events.size() < maxThreadEvents) {
+    trace.events.push_back(Event {name, begin, duration});
+  }
+}
+
+} // namespace Detail
+
+namespace Trace {
+
+bool enabled() {
+#ifdef MOLASSEMBLER_TRACE
+  return true;
+#else
+  return false;
+#endif
+}
+
+void clear() {
+  Registry& shared = registry();
+  std::lock_guard<std::mutex> lock(shared.mutex);
+  // Traces only the registry refers to belong to finished threads
+  shared.threads.erase(
+    std::remove_if(
+      std::begin(shared.threads),
+      std::end(shared.threads),
+      [](const std::shared_ptr<ThreadTrace>& trace) { return trace.use_count() == 1; }
+    ),
+    std::end(shared.threads)
+  );
+  for(const auto& trace : shared.threads) {
+    std::lock_guard<std::mutex> threadLock(trace->mutex);
+    trace->events.clear();
+    trace->aggregates.clear();
+  }
+}
+
+std::string statistics() {
+  std::map<std::string, Aggregate> merged;
+  {
+    Registry& shared = registry();
+    std::lock_guard<std::mutex> lock(shared.mutex);
+    for(const auto& trace : shared.threads) {
+      std::lock_guard<std::mutex> threadLock(trace->mutex);
+      for(const auto& nameAggregatePair : trace->aggregates) {
+        merged[nameAggregatePair.first].merge(nameAggregatePair.second);
+      }
+    }
+  }
+
+  nlohmann::json json = nlohmann::json::object();
+  for(const auto& nameAggregatePair : merged) {
+    const Aggregate& aggregate = nameAggregatePair.second;
+    // Trailing empty buckets are omitted
+    const auto histogramEnd = std::find_if(
+      aggregate.histogram.rbegin(),
+      aggregate.histogram.rend(),
+      [](const unsigned long count) { return count > 0; }
+    ).base();
+    json[nameAggregatePair.first] = {
+      {"count", aggregate.count},
+      {"seconds", seconds(aggregate.total)},
+      {"minSeconds", seconds(aggregate.min)},
+      {"maxSeconds", seconds(aggregate.max)},
+      {"histogram", std::vector<unsigned long>(aggregate.histogram.begin(), histogramEnd)}
+    };
+  }
+
+  return json.dump(2);
+}
+
+std::string chromeTrace() {
+  nlohmann::json events = nlohmann::json::array();
+  {
+    Registry& shared = registry();
+    std::lock_guard<std::mutex> lock(shared.mutex);
+    for(const auto& trace : shared.threads) {
+      std::lock_guard<std::mutex> threadLock(trace->mutex);
+      for(const Event& event : trace->events) {
+        events.push_back({
+          {"name", event.name},
+          {"cat", "molassembler"},
+          {"ph", "X"},
+          {"ts", microseconds(event.begin.time_since_epoch())},
+          {"dur", microseconds(event.duration)},
+          {"pid", 0},
+          {"tid", trace->thread}
+        });
+      }
+    }
+  }
+
+  const nlohmann::json json = {
+    {"traceEvents", std::move(events)},
+    {"displayTimeUnit", "ms"}
+  };
+  return json.dump();
+}
+
+} // namespace Trace
+} // namespace Molassembler
+} // namespace Scine
@@ -0,0 +1,63 @@
+/*!@file
+ * @copyright This code is licensed under the 3-clause BSD license.
+ *   Copyright ETH Zurich, Laboratory of Physical Chemistry, Reiher Group.
+ *   See LICENSE.txt for details.
+ * @brief Timings of conformer generation stages
+ */
+
+#ifndef INCLUDE_MOLASSEMBLER_TRACE_H
+#define INCLUDE_MOLASSEMBLER_TRACE_H
+
+#include "Molassembler/Export.h"
+
+#include <string>
+
+namespace Scine {
+namespace Molassembler {
+
+/**
+ * @brief Timings of conformer generation stages
+ *
+ * If the library is compiled with the MOLASSEMBLER_TRACE CMake option, each
+ * thread records a span for each stage of distance geometry conformer
+ * generation: model building, the bounds graph, metrization, embedding, each
+ * refinement stage and the final structure checks. Otherwise, no spans are
+ * recorded and the stages carry no overhead.
+ *
+ * @code{.cpp}
+ * Trace::clear();
+ * auto ensemble = generateRandomEnsemble(molecule, 100);
+ * std::ofstream("stages.json") << Trace::statistics();
+ * std::ofstream("stages.trace.json") << Trace::chromeTrace();
+ * @endcode
+ */
+namespace Trace {
+
+//! Whether spans are recorded, i.e. the library is compiled with tracing
+MASM_EXPORT bool enabled();
+
+//! Discards all spans recorded so far
+MASM_EXPORT void clear();
+
+/*! @brief Aggregate timings of spans by name as a JSON object
+ *
+ * Each span name maps to an object with the number of spans, their total,
+ * minimal and maximal duration in seconds, and a histogram of durations.
+ * Entry k of the histogram counts spans lasting less than @math{2^{k+1}}
+ * microseconds, and at least @math{2^k} microseconds if k is not zero.
+ */
+MASM_EXPORT std::string statistics();
+
+/*! @brief Recorded spans in Chrome's trace event format
+ *
+ * Load in chrome://tracing or Perfetto to view the spans of each thread on a
+ * timeline. Each thread keeps at most a million spans for the timeline, but
+ * spans beyond that are still part of the statistics.
+ */
+MASM_EXPORT std::string chromeTrace();
+
+} // namespace Trace
+} // namespace Molassembler
+} // namespace Scine
+
+#endif
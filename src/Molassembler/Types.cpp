@@ -55,5 +55,22 @@ std::size_t hash_value(const BondIndex& bond) {
   return seed;
 }
 
+bool Fingerprint::operator < (const Fingerprint& other) const {
+  return std::tie(high, low) < std::tie(other.high, other.low);
+}
+
+bool Fingerprint::operator == (const Fingerprint& other) const {
+  return high == other.high && low == other.low;
+}
+
+bool Fingerprint::operator != (const Fingerprint& other) const {
+  return !(*this == other);
+}
+
+std::size_t hash_value(const Fingerprint& fingerprint) {
+  // The bits are already well mixed
+  return static_cast<std::size_t>(fingerprint.low);
+}
+
 } // namespace Molassembler
 } // namespace Scine
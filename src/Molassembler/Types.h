@@ -10,6 +10,7 @@
 
 #include "Molassembler/Export.h"
 #include <cstddef>
+#include <cstdint>
 #include <type_traits>
 
 namespace Scine {
@@ -92,6 +93,30 @@ struct MASM_EXPORT BondIndex {
  */
 MASM_EXPORT std::size_t hash_value(const BondIndex& bond);
 
+/*! @brief Platform-independent 128-bit fingerprint
+ *
+ * @see Molecule::fingerprint
+ */
+struct MASM_EXPORT Fingerprint {
+  //! Most significant 64 bits
+  std::uint64_t high;
+  //! Least significant 64 bits
+  std::uint64_t low;
+
+  //! Lexicographic comparison
+  bool operator < (const Fingerprint& other) const;
+  //! Lexicographic comparison
+  bool operator == (const Fingerprint& other) const;
+  //! Inverts operator ==
+  bool operator != (const Fingerprint& other) const;
+};
+
+/*! @brief Hash for Fingerprint so it can be used as a key type in unordered containers
+ *
+ * @complexity{@math{\Theta(1)}}
+ */
+MASM_EXPORT std::size_t hash_value(const Fingerprint& fingerprint);
+
 /*!
  * @brief For bitmasks grouping components of immediate atom environments
  *
@@ -10,8 +10,11 @@
 #include "Molassembler/Conformers.h"
 #include "Molassembler/Graph.h"
 #include "Molassembler/IO.h"
+#include "Molassembler/IO/SmilesParser.h"
 #include "Molassembler/Molecule.h"
 #include "Molassembler/StereopermutatorList.h"
+#include "Molassembler/Stereopermutators/AbstractPermutations.h"
+#include "Molassembler/Stereopermutators/FeasiblePermutations.h"
 #include "Molassembler/Stereopermutators/ShapeVertexMaps.h"
 #include "Molassembler/Stereopermutation/Manipulation.h"
 #include "Molassembler/Shapes/Data.h"
@@ -23,6 +26,8 @@
 
 #include "Fixtures.h"
 
+#include <thread>
+
 using namespace Scine;
 using namespace Molassembler;
 
@@ -360,3 +365,130 @@ BOOST_FIXTURE_TEST_CASE(AtomStereopermutatorContinuity, LowTemperatureFixture) {
     testSymmetryPair(shapePair.first, shapePair.second);
   }
 }
+
+BOOST_AUTO_TEST_CASE(AbstractPermutationsCache, *boost::unit_test::label("Molassembler")) {
+  Stereopermutators::Abstract::clearCache();
+  BOOST_CHECK_EQUAL(Stereopermutators::Abstract::cacheSize(), 0);
+
+  // Centers with equal shape and ranking pattern share their stereopermutations
+  const auto a = IO::Experimental::parseSmilesSingleMolecule("FC(Cl)(Br)I");
+  const auto b = IO::Experimental::parseSmilesSingleMolecule("NC(O)(S)P");
+  const auto aPermutator = a.stereopermutators().option(1);
+  const auto bPermutator = b.stereopermutators().option(1);
+  BOOST_REQUIRE(aPermutator && bPermutator);
+  BOOST_CHECK(aPermutator->getAbstract().permutations == bPermutator->getAbstract().permutations);
+  BOOST_CHECK_EQUAL(aPermutator->getAbstract().permutations->list.size(), 2);
+  BOOST_CHECK_GT(Stereopermutators::Abstract::cacheSize(), 0);
+  BOOST_CHECK_LE(Stereopermutators::Abstract::cacheSize(), Stereopermutators::Abstract::cacheCapacity);
+
+  // Clearing the cache leaves existing sets intact
+  Stereopermutators::Abstract::clearCache();
+  BOOST_CHECK_EQUAL(Stereopermutators::Abstract::cacheSize(), 0);
+  BOOST_CHECK_EQUAL(aPermutator->getAbstract().permutations->list.size(), 2);
+}
+
+BOOST_AUTO_TEST_CASE(MemoizedVertexMaps, *boost::unit_test::label("Molassembler")) {
+  const auto mol = IO::Experimental::parseSmilesSingleMolecule("C1CC1");
+  const auto permutatorOption = mol.stereopermutators().option(0);
+  BOOST_REQUIRE(permutatorOption);
+
+  const auto& ranking = permutatorOption->getRanking();
+  const Stereopermutators::Abstract& abstract = permutatorOption->getAbstract();
+  BOOST_REQUIRE(abstract.vertexMaps);
+
+  // Abstract permutations regenerated for the same ranking share their maps
+  const Stereopermutators::Abstract regenerated {ranking, permutatorOption->getShape()};
+  BOOST_CHECK(regenerated.vertexMaps == abstract.vertexMaps);
+
+  // Memoized maps are identical to freshly generated maps
+  const unsigned P = abstract.permutations->list.size();
+  for(unsigned i = 0; i < P; ++i) {
+    const auto direct = siteToShapeVertexMap(
+      abstract.permutations->list.at(i),
+      abstract.canonicalSites,
+      ranking.links
+    );
+    BOOST_CHECK(abstract.siteToShapeVertexMap(i, ranking.links) == direct);
+    BOOST_CHECK(regenerated.siteToShapeVertexMap(i, ranking.links) == direct);
+  }
+  BOOST_CHECK_GE(abstract.vertexMaps->size(), 1);
+  BOOST_CHECK_LE(abstract.vertexMaps->size(), Stereopermutators::Abstract::VertexMaps::capacity);
+}
+
+BOOST_AUTO_TEST_CASE(LazyFeasibility, *boost::unit_test::label("Molassembler")) {
+  // Ring atoms of cyclopropane have a link between their ring neighbors
+  const auto mol = IO::Experimental::parseSmilesSingleMolecule("C1CC1");
+  const auto permutatorOption = mol.stereopermutators().option(0);
+  BOOST_REQUIRE(permutatorOption);
+  BOOST_REQUIRE(!permutatorOption->getRanking().links.empty());
+
+  const Stereopermutators::Feasible feasible {
+    permutatorOption->getAbstract(),
+    permutatorOption->getShape(),
+    permutatorOption->placement(),
+    permutatorOption->getRanking(),
+    mol.graph()
+  };
+  BOOST_CHECK(!feasible.evaluated());
+  BOOST_CHECK_EQUAL(
+    feasible.maximumCount(),
+    permutatorOption->getAbstract().permutations->list.size()
+  );
+
+  // Copies evaluate independently and identically
+  const Stereopermutators::Feasible copy = feasible;
+  const auto& indices = feasible.indices();
+  BOOST_CHECK(feasible.evaluated());
+  BOOST_CHECK(!copy.evaluated());
+  BOOST_CHECK(copy.indices() == indices);
+  BOOST_CHECK(permutatorOption->getFeasible().indices() == indices);
+  BOOST_CHECK_LE(indices.size(), feasible.maximumCount());
+
+  // Without links or haptic sites, nothing is deferred
+  const auto simple = IO::Experimental::parseSmilesSingleMolecule("FC(Cl)(Br)I");
+  const auto simplePermutator = simple.stereopermutators().option(1);
+  BOOST_REQUIRE(simplePermutator);
+  BOOST_CHECK(simplePermutator->getFeasible().evaluated());
+  BOOST_CHECK_EQUAL(simplePermutator->getFeasible().indices().size(), 2);
+}
+
+BOOST_AUTO_TEST_CASE(ThreadOptionOverrides, *boost::unit_test::label("Molassembler")) {
+  Options::Values values = Options::Values::global();
+  values.pyramidalInversion = !values.pyramidalInversion;
+  values.chiralStatePreservation = ChiralStatePreservation::RandomFromMultipleBest;
+  Random::Engine engine {1010};
+
+  Options::Values otherThreadValues;
+  bool otherThreadEngineIsGlobal = false;
+  {
+    Options::ThreadOverride scope {values, engine};
+    BOOST_CHECK(Options::current().pyramidalInversion == values.pyramidalInversion);
+    BOOST_CHECK(Options::current().chiralStatePreservation == ChiralStatePreservation::RandomFromMultipleBest);
+    BOOST_CHECK(&randomnessEngine() == &engine);
+
+    // Other threads are unaffected
+    std::thread other {
+      [&]() {
+        otherThreadValues = Options::current();
+        otherThreadEngineIsGlobal = (&randomnessEngine() != &engine);
+      }
+    };
+    other.join();
+
+    // Overrides nest
+    Options::Values inner = values;
+    inner.shapeTransition = ShapeTransition::PrioritizeInferenceFromGraph;
+    {
+      Options::ThreadOverride innerScope {inner};
+      BOOST_CHECK(Options::current().shapeTransition == ShapeTransition::PrioritizeInferenceFromGraph);
+      BOOST_CHECK(&randomnessEngine() == &engine);
+    }
+    BOOST_CHECK(Options::current().shapeTransition == values.shapeTransition);
+  }
+
+  BOOST_CHECK(otherThreadValues.pyramidalInversion == Options::Thermalization::pyramidalInversion);
+  BOOST_CHECK(otherThreadValues.chiralStatePreservation == Options::chiralStatePreservation);
+  BOOST_CHECK(otherThreadEngineIsGlobal);
+  BOOST_CHECK(Options::current().pyramidalInversion == Options::Thermalization::pyramidalInversion);
+  BOOST_CHECK(&randomnessEngine() != &engine);
+}
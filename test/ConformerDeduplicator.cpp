@@ -0,0 +1,61 @@
+/*!@file
+ * @copyright This code is licensed under the 3-clause BSD license.
+ *   Copyright ETH Zurich, Laboratory of Physical Chemistry, Reiher Group.
+ *   See LICENSE.txt for details.
+ */
+
+#include <boost/test/unit_test.hpp>
+
+#include "Molassembler/ConformerDeduplicator.h"
+#include "Molassembler/Conformers.h"
+#include "Molassembler/IO/SmilesParser.h"
+#include "Molassembler/Molecule.h"
+
+using namespace Scine;
+using namespace Molassembler;
+
+BOOST_AUTO_TEST_CASE(ConformerDeduplicatorRejectsDuplicates, *boost::unit_test::label("Molassembler")) {
+  const Molecule molecule = IO::Experimental::parseSmilesSingleMolecule("CCCCC");
+
+  BOOST_CHECK_THROW(ConformerDeduplicator(molecule, 0.0), std::invalid_argument);
+  BOOST_CHECK_THROW(ConformerDeduplicator(molecule, 0.1, -1.0), std::invalid_argument);
+
+  std::vector<Utils::PositionCollection> ensemble;
+  for(auto& result : generateEnsemble(molecule, 20, 1010)) {
+    if(result) {
+      ensemble.push_back(std::move(result.value()));
+    }
+  }
+  BOOST_REQUIRE(!ensemble.empty());
+
+  // A conformer is a duplicate of itself, by dihedrals and by RMSD
+  for(const double rmsdThreshold : {0.0, 0.1}) {
+    ConformerDeduplicator deduplicator {molecule, M_PI / 12, rmsdThreshold};
+    BOOST_CHECK(deduplicator.add(ensemble.front()));
+    BOOST_CHECK(!deduplicator.add(ensemble.front()));
+    BOOST_CHECK_EQUAL(deduplicator.size(), 1);
+  }
+
+  // Adding an ensemble at once keeps the same conformers as in sequence
+  for(const double rmsdThreshold : {0.0, 0.5}) {
+    ConformerDeduplicator sequential {molecule, M_PI / 6, rmsdThreshold};
+    std::vector<unsigned> sequentiallyKept;
+    for(unsigned i = 0; i < ensemble.size(); ++i) {
+      if(sequential.add(ensemble.at(i))) {
+        sequentiallyKept.push_back(i);
+      }
+    }
+
+    ConformerDeduplicator batch {molecule, M_PI / 6, rmsdThreshold};
+    const auto batchKept = batch.add(ensemble);
+    BOOST_CHECK(batchKept == sequentiallyKept);
+    BOOST_CHECK_EQUAL(batch.size(), batchKept.size());
+
+    // Added again, every conformer is a duplicate of a kept one
+    BOOST_CHECK(batch.add(ensemble).empty());
+  }
+
+  // Any conformer is within the largest possible dihedral difference
+  ConformerDeduplicator coarse {molecule, M_PI};
+  BOOST_CHECK_EQUAL(coarse.add(ensemble).size(), 1);
+}
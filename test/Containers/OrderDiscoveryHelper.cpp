@@ -151,3 +151,31 @@ BOOST_AUTO_TEST_CASE(OrderDiscoverTransfer, *boost::unit_test::label("Molassembl
     "Transferability edge from 10 -> 20 not found!"
   );
 }
+
+BOOST_AUTO_TEST_CASE(OrderDiscoveryManyValues, *boost::unit_test::label("Molassembler")) {
+  // Relationships span multiple words of the relationship matrix
+  const unsigned N = 100;
+  OrderDiscoveryHelper<unsigned> chain {Temple::iota<unsigned>(N)};
+  for(unsigned i = 0; i + 1 < N; ++i) {
+    chain.addLessThanRelationship(i + 1, i);
+  }
+  BOOST_CHECK(!chain.isTotallyOrdered());
+
+  chain.addTransferabilityEdges();
+  BOOST_CHECK(chain.isTotallyOrdered());
+  BOOST_CHECK(chain.isSmaller(N - 1, 0));
+  BOOST_CHECK(!chain.isSmaller(0, N - 1));
+
+  const auto sets = chain.getSets();
+  BOOST_REQUIRE_EQUAL(sets.size(), N);
+  for(unsigned i = 0; i < N; ++i) {
+    BOOST_CHECK(sets.at(i) == std::vector<unsigned> {i});
+  }
+
+  // Merging grows the matrix past a single word per row
+  OrderDiscoveryHelper<unsigned> merged {std::vector<unsigned> {0, 1}};
+  merged.addLessThanRelationship(1, 0);
+  merged.addAllFromOther(chain);
+  BOOST_CHECK(merged.isTotallyOrdered());
+  BOOST_CHECK(merged.getUndecidedSets().empty());
+}
@@ -0,0 +1,70 @@
+/*!@file
+ * @copyright This code is licensed under the 3-clause BSD license.
+ *   Copyright ETH Zurich, Laboratory of Physical Chemistry, Reiher Group.
+ *   See LICENSE.txt for details.
+ */
+
+#include <boost/test/unit_test.hpp>
+
+#include "Molassembler/CostModel.h"
+#include "Molassembler/Graph.h"
+#include "Molassembler/IO/SmilesParser.h"
+#include "Molassembler/Molecule.h"
+
+#include <cmath>
+
+using namespace Scine::Molassembler;
+
+BOOST_AUTO_TEST_CASE(CostModelFeatures, *boost::unit_test::label("Molassembler")) {
+  const Molecule molecule = IO::Experimental::parseSmilesSingleMolecule("CCCCC1CCCCC1");
+  const CostModel::Features features = CostModel::features(molecule);
+  BOOST_CHECK_EQUAL(features.atoms, molecule.graph().N());
+  BOOST_CHECK_GT(features.atomStereopermutators, 0);
+  BOOST_CHECK_EQUAL(features.cycleFamilies, 1);
+  BOOST_CHECK_GT(features.rotatableBonds, 0);
+  BOOST_CHECK_GT(features.idealEnsembleSize, 1);
+}
+
+BOOST_AUTO_TEST_CASE(CostModelCalibration, *boost::unit_test::label("Molassembler")) {
+  BOOST_CHECK_THROW(CostModel::calibrate({}), std::invalid_argument);
+  BOOST_CHECK_THROW(
+    (CostModel {Eigen::VectorXd::Zero(2), Eigen::VectorXd::Zero(2)}),
+    std::invalid_argument
+  );
+
+  // Quadratic scaling in the number of atoms, slowed by stereopermutators
+  const auto seconds = [](const CostModel::Features& features) {
+    return 1e-4 * std::pow(features.atoms, 2) * std::exp(0.1 * features.atomStereopermutators);
+  };
+
+  std::vector<CostModel::Observation> observations;
+  for(const unsigned atoms : {5, 10, 20, 40, 80}) {
+    for(const unsigned stereopermutators : {0, 2, 3}) {
+      CostModel::Features features;
+      features.atoms = atoms;
+      features.atomStereopermutators = stereopermutators;
+      observations.push_back({features, seconds(features), 0.1});
+    }
+  }
+
+  const CostModel model = CostModel::calibrate(observations);
+  // Regressors without variation in the observations do not contribute
+  BOOST_CHECK_EQUAL(model.timeCoefficients()(CostModel::coefficientCount - 1), 0.0);
+
+  CostModel::Features unseen;
+  unseen.atoms = 30;
+  unseen.atomStereopermutators = 1;
+  unseen.idealEnsembleSize = 9;
+  const CostModel::Estimate estimate = model.predict(unseen);
+  BOOST_CHECK_CLOSE(estimate.secondsPerConformer, seconds(unseen), 1e-6);
+  BOOST_CHECK_CLOSE(estimate.failureRate, 0.1, 1e-6);
+  BOOST_CHECK_CLOSE(
+    estimate.enumerationSeconds(),
+    9 * estimate.secondsPerConformer / 0.9,
+    1e-6
+  );
+
+  // Models round-trip through their coefficients
+  const CostModel copy {model.timeCoefficients(), model.failureCoefficients()};
+  BOOST_CHECK_EQUAL(copy.predict(unseen).secondsPerConformer, estimate.secondsPerConformer);
+}
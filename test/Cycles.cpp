@@ -14,6 +14,7 @@
 #include "Molassembler/Temple/constexpr/Numeric.h"
 
 #include "Molassembler/IO.h"
+#include "Molassembler/IO/SmilesParser.h"
 #include "Molassembler/Cycles.h"
 #include "Molassembler/Graph.h"
 #include "Molassembler/Molecule.h"
@@ -141,3 +142,27 @@ BOOST_AUTO_TEST_CASE(cycleIterators, *boost::unit_test::label("Molassembler")) {
     );
   }
 }
+
+BOOST_AUTO_TEST_CASE(AcyclicAtomQueries, *boost::unit_test::label("Molassembler")) {
+  // Butylcyclohexane: chain atoms 0-3, ring atoms 4-9
+  const auto mol = IO::Experimental::parseSmilesSingleMolecule("CCCCC1CCCCC1");
+  const Cycles& cycles = mol.graph().cycles();
+  BOOST_REQUIRE_EQUAL(cycles.numCycleFamilies(), 1);
+
+  for(AtomIndex i = 0; i < 4; ++i) {
+    BOOST_CHECK_EQUAL(cycles.numCycleFamilies(i), 0);
+    BOOST_CHECK_EQUAL(cycles.numRelevantCycles(i), 0);
+    const auto range = cycles.containing(i);
+    BOOST_CHECK(range.first == range.second);
+  }
+
+  for(AtomIndex i = 4; i < 10; ++i) {
+    BOOST_CHECK_EQUAL(cycles.numCycleFamilies(i), 1);
+    BOOST_CHECK_EQUAL(cycles.numRelevantCycles(i), 1);
+    const auto range = cycles.containing(i);
+    BOOST_CHECK_EQUAL(std::distance(range.first, range.second), 1);
+  }
+
+  BOOST_CHECK_EQUAL(cycles.numCycleFamilies(BondIndex {3, 4}), 0);
+  BOOST_CHECK_EQUAL(cycles.numCycleFamilies(BondIndex {4, 5}), 1);
+}
@@ -154,3 +154,28 @@ BOOST_AUTO_TEST_CASE(CentralAngleRootFinding, *boost::unit_test::label("Molassem
     }
   }
 }
+
+BOOST_AUTO_TEST_CASE(CachedCircumradius, *boost::unit_test::label("Molassembler")) {
+  const std::vector<double> pentagon {1.4, 1.35, 1.5, 1.42, 1.38};
+  const auto solved = CyclicPolygons::Detail::convexCircumradius(pentagon);
+  const auto cached = CyclicPolygons::Detail::cachedConvexCircumradius(pentagon);
+  BOOST_CHECK_CLOSE(cached.first, solved.first, 1e-4);
+  BOOST_CHECK_EQUAL(cached.second, solved.second);
+
+  // Circumradii do not depend on the order of edges
+  const std::vector<double> permuted {1.5, 1.4, 1.38, 1.35, 1.42};
+  const auto permutedCached = CyclicPolygons::Detail::cachedConvexCircumradius(permuted);
+  BOOST_CHECK_EQUAL(permutedCached.first, cached.first);
+
+  // Internal angles of the general case are unchanged by caching
+  const auto angles = CyclicPolygons::internalAngles(pentagon);
+  const auto solvedAngles = CyclicPolygons::Detail::generalizedInternalAngles(
+    pentagon,
+    solved.first,
+    solved.second
+  );
+  BOOST_REQUIRE_EQUAL(angles.size(), solvedAngles.size());
+  for(unsigned i = 0; i < angles.size(); ++i) {
+    BOOST_CHECK_CLOSE(angles.at(i), solvedAngles.at(i), 1e-4);
+  }
+}
@@ -27,6 +27,9 @@
 #include <fstream>
 #include <iomanip>
 #include <iostream>
+#include <map>
+#include <mutex>
+#include <set>
 
 using namespace std::string_literals;
 using namespace Scine;
@@ -153,6 +156,262 @@ BOOST_FIXTURE_TEST_CASE(DirectedConfGenHomomorphicSwap, LowTemperatureFixture, *
   }
 }
 
+BOOST_AUTO_TEST_CASE(DirConfGenEnumerateConcurrentCallback, *boost::unit_test::label("DG")) {
+  auto mol = IO::read("directed_conformer_generation/pentane.mol");
+  DirectedConformerGenerator generator {mol};
+  BOOST_REQUIRE_EQUAL(generator.idealEnsembleSize(), 9);
+
+  DirectedConformerGenerator::EnumerationSettings settings;
+  settings.concurrentCallback = true;
+
+  std::mutex mutex;
+  std::multiset<DirectedConformerGenerator::DecisionList> decisionLists;
+  generator.enumerate(
+    [&](const auto& decisionList, const auto& /* conformer */) {
+      std::lock_guard<std::mutex> lock(mutex);
+      decisionLists.insert(decisionList);
+    },
+    1010,
+    settings
+  );
+
+  for(const auto& decisionList : decisionLists) {
+    BOOST_CHECK_EQUAL(decisionLists.count(decisionList), 1);
+  }
+  BOOST_CHECK_GE(decisionLists.size(), 7);
+  BOOST_CHECK_EQUAL(generator.decisionListSetSize(), generator.idealEnsembleSize());
+}
+
+BOOST_AUTO_TEST_CASE(DirConfGenEnumerateOrderedCallback, *boost::unit_test::label("DG")) {
+  auto mol = IO::read("directed_conformer_generation/pentane.mol");
+  DirectedConformerGenerator generator {mol};
+
+  DirectedConformerGenerator::EnumerationSettings settings;
+  settings.orderedCallback = true;
+
+  using Enumerated = std::vector<
+    std::pair<DirectedConformerGenerator::DecisionList, Utils::PositionCollection>
+  >;
+  const auto enumerate = [&]() {
+    Enumerated enumerated;
+    generator.enumerate(
+      [&](const auto& decisionList, const auto& conformer) {
+        enumerated.emplace_back(decisionList, conformer);
+      },
+      1010,
+      settings
+    );
+    return enumerated;
+  };
+
+  const Enumerated first = enumerate();
+  const Enumerated second = enumerate();
+  BOOST_REQUIRE_EQUAL(first.size(), second.size());
+  for(unsigned i = 0; i < first.size(); ++i) {
+    BOOST_CHECK(first.at(i).first == second.at(i).first);
+    BOOST_CHECK((first.at(i).second.array() == second.at(i).second.array()).all());
+  }
+
+  // Decision lists are passed in a fixed order
+  std::vector<std::vector<unsigned>> reversedLists;
+  for(const auto& pair : first) {
+    reversedLists.emplace_back(pair.first.rbegin(), pair.first.rend());
+  }
+  BOOST_CHECK(std::is_sorted(std::begin(reversedLists), std::end(reversedLists)));
+}
+
+BOOST_AUTO_TEST_CASE(DirConfGenEnumerateCallbackException, *boost::unit_test::label("DG")) {
+  auto mol = IO::read("directed_conformer_generation/pentane.mol");
+  DirectedConformerGenerator generator {mol};
+
+  for(const bool ordered : {false, true}) {
+    DirectedConformerGenerator::EnumerationSettings settings;
+    settings.orderedCallback = ordered;
+
+    // The first exception thrown by the callback stops enumeration
+    unsigned calls = 0;
+    BOOST_CHECK_THROW(
+      generator.enumerate(
+        [&](const auto& /* decisionList */, const auto& /* conformer */) {
+          ++calls;
+          throw std::runtime_error("Stop");
+        },
+        1010,
+        settings
+      ),
+      std::runtime_error
+    );
+    BOOST_CHECK_EQUAL(calls, 1);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(DirConfGenDecisionCosts, *boost::unit_test::label("DG")) {
+  auto mol = IO::read("directed_conformer_generation/pentane.mol");
+  DirectedConformerGenerator generator {mol};
+  BOOST_REQUIRE_EQUAL(generator.bondList().size(), 2);
+  BOOST_REQUIRE_EQUAL(generator.idealEnsembleSize(), 9);
+
+  const std::vector<std::vector<double>> costs {{2.0, 0.0, 1.0}, {0.5, 3.0, 0.0}};
+  generator.setDecisionCosts(costs);
+
+  // Decision lists are generated without repetition by nondecreasing cost
+  const DirectedConformerGenerator::DecisionList preinserted {0, 0};
+  generator.insert(preinserted);
+  std::set<DirectedConformerGenerator::DecisionList> generated;
+  double previousCost = 0.0;
+  while(generator.decisionListSetSize() < generator.idealEnsembleSize()) {
+    const auto decisionList = generator.generateNewDecisionList();
+    BOOST_CHECK(decisionList != preinserted);
+    BOOST_CHECK(generated.insert(decisionList).second);
+    const double cost = costs.at(0).at(decisionList.at(0)) + costs.at(1).at(decisionList.at(1));
+    BOOST_CHECK_LE(previousCost, cost);
+    previousCost = cost;
+  }
+  BOOST_CHECK_EQUAL(generated.size(), 8);
+  BOOST_CHECK_THROW(generator.generateNewDecisionList(), std::logic_error);
+
+  // Cost callback variant yields the cheapest decision list first
+  DirectedConformerGenerator callbackGenerator {mol};
+  callbackGenerator.setDecisionCosts(
+    [&](const unsigned bond, const std::uint8_t assignment) {
+      return costs.at(bond).at(assignment);
+    }
+  );
+  const DirectedConformerGenerator::DecisionList cheapest {1, 2};
+  BOOST_CHECK(callbackGenerator.generateNewDecisionList() == cheapest);
+
+  BOOST_CHECK_THROW(generator.setDecisionCosts({{0.0, 1.0, 2.0}}), std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_CASE(DirConfGenCheckpoint, *boost::unit_test::label("DG")) {
+  auto mol = IO::read("directed_conformer_generation/pentane.mol");
+  const std::string checkpointFile = (
+    boost::filesystem::temp_directory_path()
+    / boost::filesystem::unique_path("%%%%-%%%%.dcg")
+  ).string();
+
+  DirectedConformerGenerator generator {mol};
+  Random::Engine engine {1010};
+  std::vector<DirectedConformerGenerator::DecisionList> generated;
+  for(unsigned i = 0; i < 4; ++i) {
+    generated.push_back(generator.generateNewDecisionList(engine));
+  }
+  generator.checkpoint(checkpointFile, engine);
+
+  // A fresh generator continues exactly where the checkpointed one left off
+  DirectedConformerGenerator resumed {mol};
+  Random::Engine resumedEngine {0};
+  resumed.resume(checkpointFile, resumedEngine);
+  BOOST_CHECK(resumedEngine == engine);
+  BOOST_CHECK_EQUAL(resumed.decisionListSetSize(), generated.size());
+  for(const auto& decisionList : generated) {
+    BOOST_CHECK(resumed.contains(decisionList));
+  }
+  BOOST_CHECK(resumed.generateNewDecisionList(resumedEngine) == generator.generateNewDecisionList(engine));
+
+  // Resumed enumeration skips decision lists that are already part of the set
+  DirectedConformerGenerator::EnumerationSettings settings;
+  settings.skipContained = true;
+  resumed.enumerate(
+    [&](const auto& decisionList, const auto& /* conformer */) {
+      BOOST_CHECK(std::find(std::begin(generated), std::end(generated), decisionList) == std::end(generated));
+    },
+    1010,
+    settings
+  );
+  BOOST_CHECK_EQUAL(resumed.decisionListSetSize(), resumed.idealEnsembleSize());
+
+  DirectedConformerGenerator mismatched {mol, BondStereopermutator::Alignment::Eclipsed};
+  BOOST_CHECK_THROW(mismatched.resume(checkpointFile), std::invalid_argument);
+
+  // In-memory checkpoints hold the same state as checkpoint files
+  DirectedConformerGenerator fromBytes {mol};
+  Random::Engine bytesEngine {0};
+  fromBytes.resumeFromBytes(generator.checkpointBytes(engine), bytesEngine);
+  BOOST_CHECK(bytesEngine == engine);
+  BOOST_CHECK_EQUAL(fromBytes.decisionListSetSize(), generator.decisionListSetSize());
+  BOOST_CHECK_THROW(mismatched.resumeFromBytes(generator.checkpointBytes()), std::invalid_argument);
+
+  boost::filesystem::remove(checkpointFile);
+}
+
+BOOST_AUTO_TEST_CASE(DirConfGenShards, *boost::unit_test::label("DG")) {
+  auto mol = IO::read("directed_conformer_generation/pentane.mol");
+  using Enumerated = std::map<DirectedConformerGenerator::DecisionList, Utils::PositionCollection>;
+  const auto enumerate = [&](DirectedConformerGenerator& generator, const unsigned count, const unsigned index) {
+    DirectedConformerGenerator::EnumerationSettings settings;
+    settings.shardCount = count;
+    settings.shardIndex = index;
+    Enumerated enumerated;
+    generator.enumerate(
+      [&](const auto& decisionList, const auto& conformer) {
+        enumerated.emplace(decisionList, conformer);
+      },
+      1010,
+      settings
+    );
+    return enumerated;
+  };
+
+  DirectedConformerGenerator reference {mol};
+  const Enumerated all = enumerate(reference, 1, 0);
+
+  // Shards partition the enumeration and their checkpoints merge into the full set
+  const unsigned K = 4;
+  DirectedConformerGenerator merged {mol};
+  unsigned shardSizes = 0;
+  for(unsigned k = 0; k < K; ++k) {
+    const auto range = merged.shardRange(K, k);
+    shardSizes += range.second - range.first;
+
+    DirectedConformerGenerator generator {mol};
+    const Enumerated shard = enumerate(generator, K, k);
+    BOOST_CHECK_EQUAL(generator.decisionListSetSize(), range.second - range.first);
+    for(const auto& pair : shard) {
+      BOOST_REQUIRE(all.count(pair.first) > 0);
+      BOOST_CHECK((all.at(pair.first).array() == pair.second.array()).all());
+    }
+
+    const std::string checkpointFile = (
+      boost::filesystem::temp_directory_path()
+      / boost::filesystem::unique_path("%%%%-%%%%.dcg")
+    ).string();
+    generator.checkpoint(checkpointFile);
+    BOOST_CHECK_EQUAL(merged.merge(checkpointFile), range.second - range.first);
+    boost::filesystem::remove(checkpointFile);
+  }
+  BOOST_CHECK_EQUAL(shardSizes, merged.idealEnsembleSize());
+  BOOST_CHECK_EQUAL(merged.decisionListSetSize(), merged.idealEnsembleSize());
+  BOOST_CHECK_THROW(merged.shardRange(K, K), std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_CASE(DirConfGenFromReference, *boost::unit_test::label("DG")) {
+  auto mol = IO::read("directed_conformer_generation/pentane.mol");
+  DirectedConformerGenerator generator {mol};
+  BOOST_REQUIRE_EQUAL(generator.bondList().size(), 2);
+
+  const DirectedConformerGenerator::DecisionList first {0, 0};
+  auto reference = generator.generateConformation(first, 1010);
+  BOOST_REQUIRE_MESSAGE(reference, "Could not generate reference conformer");
+
+  for(std::uint8_t a = 0; a < 3; ++a) {
+    for(std::uint8_t b = 0; b < 3; ++b) {
+      const DirectedConformerGenerator::DecisionList target {a, b};
+      auto conformer = generator.generateConformationFrom(reference.value(), target, 1010);
+      if(conformer) {
+        BOOST_CHECK(
+          generator.getDecisionList(conformer.value(), BondStereopermutator::FittingMode::Nearest) == target
+        );
+      }
+    }
+  }
+
+  BOOST_CHECK_THROW(
+    generator.generateConformationFrom(Utils::PositionCollection::Zero(1, 3), first, 1010),
+    std::invalid_argument
+  );
+}
+
 BOOST_AUTO_TEST_CASE(DirConfGenRelabelerBins, *boost::unit_test::label("DG")) {
   using Relabeler = DirectedConformerGenerator::Relabeler;
 
@@ -226,4 +485,61 @@ BOOST_AUTO_TEST_CASE(DirConfGenRelabeler, *boost::unit_test::label("DG")) {
   auto bins = relabeler.bins();
   auto binIndices = relabeler.binIndices(bins);
   auto midpoints = relabeler.binMidpointIntegers(binIndices, bins);
+
+  // Streaming relabeling yields the same bins and relabeling
+  auto streamingRelabeler = generator.relabeler();
+  for(const auto& pos : conformers) {
+    streamingRelabeler.accumulate(pos);
+  }
+  BOOST_CHECK(streamingRelabeler.observedDihedrals.front().empty());
+
+  const auto histogramBins = streamingRelabeler.histogramBins();
+  BOOST_CHECK(histogramBins == bins);
+
+  unsigned frame = 0;
+  const auto streamedIndices = streamingRelabeler.binIndices(
+    histogramBins,
+    [&](Utils::PositionCollection& positions) -> bool {
+      if(frame == conformers.size()) {
+        return false;
+      }
+      positions = conformers.at(frame);
+      ++frame;
+      return true;
+    },
+    3
+  );
+  BOOST_CHECK(streamedIndices == binIndices);
+
+  BOOST_CHECK_THROW(streamingRelabeler.histogramBins(1e-3), std::logic_error);
+
+  // Adding frames from a buffer matches adding them individually
+  const unsigned N = mol.graph().N();
+  Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> frames(conformers.size(), 3 * N);
+  for(unsigned f = 0; f < conformers.size(); ++f) {
+    for(unsigned i = 0; i < N; ++i) {
+      frames.block<1, 3>(f, 3 * i) = conformers.at(f).row(i);
+    }
+  }
+
+  auto bufferRelabeler = generator.relabeler();
+  bufferRelabeler.addFrames(frames);
+  BOOST_CHECK(bufferRelabeler.observedDihedrals == relabeler.observedDihedrals);
+
+  BOOST_CHECK_THROW(
+    bufferRelabeler.addFrames(Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>(2, 4)),
+    std::invalid_argument
+  );
+
+  // Decision lists of frames from a buffer match those fitted individually
+  const auto frameDecisionLists = generator.getDecisionLists(frames);
+  BOOST_REQUIRE_EQUAL(frameDecisionLists.size(), conformers.size());
+  for(unsigned f = 0; f < conformers.size(); ++f) {
+    BOOST_CHECK(frameDecisionLists.at(f) == generator.getDecisionList(conformers.at(f)));
+  }
+
+  BOOST_CHECK_THROW(
+    generator.getDecisionLists(Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>(2, 3)),
+    std::invalid_argument
+  );
 }
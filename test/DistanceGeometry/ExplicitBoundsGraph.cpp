@@ -10,9 +10,14 @@
 #include "boost/graph/graph_concepts.hpp"
 #include "boost/test/unit_test.hpp"
 
+#include "Molassembler/DistanceGeometry/ConformerGeneration.h"
+#include "Molassembler/DistanceGeometry/Error.h"
 #include "Molassembler/DistanceGeometry/ExplicitBoundsGraph.h"
 #include "Molassembler/DistanceGeometry/SpatialModel.h"
 #include "Molassembler/IO.h"
+#include "Molassembler/IO/SmilesParser.h"
+#include "Molassembler/Metrics.h"
+#include "Molassembler/Prng.h"
 #include "ShortestPathsGraphTests.h"
 
 #include <iostream>
@@ -107,3 +112,126 @@ BOOST_AUTO_TEST_CASE(ExplicitBoundsGraphStructure, *boost::unit_test::label("DG"
   }
 #endif
 }
+
+BOOST_AUTO_TEST_CASE(SparseBoundsMatchDense, *boost::unit_test::label("DG")) {
+  using namespace Scine::Molassembler;
+
+  for(
+    const boost::filesystem::path& currentFilePath :
+    boost::filesystem::recursive_directory_iterator("stereocenter_detection_molecules")
+  ) {
+    Molecule molecule = IO::read(
+      currentFilePath.string()
+    );
+
+    DistanceGeometry::SpatialModel spatialModel {molecule, DistanceGeometry::Configuration {}};
+    const auto dense = spatialModel.makePairwiseBounds();
+    const auto sparse = spatialModel.makeSparsePairwiseBounds();
+
+    const Eigen::MatrixXd expanded = sparse;
+    BOOST_CHECK_MESSAGE(
+      expanded == dense,
+      "Sparse pairwise bounds do not match dense bounds for "
+        << currentFilePath.stem().string()
+    );
+    BOOST_CHECK_LT(sparse.nonZeros(), dense.size());
+
+    auto denseBounds = DistanceGeometry::ExplicitBoundsGraph {
+      molecule.graph().inner(),
+      dense
+    }.makeDistanceBounds();
+    auto sparseBounds = DistanceGeometry::ExplicitBoundsGraph {
+      molecule.graph().inner(),
+      sparse
+    }.makeDistanceBounds();
+
+    BOOST_REQUIRE(denseBounds && sparseBounds);
+    BOOST_CHECK_MESSAGE(
+      denseBounds.value() == sparseBounds.value(),
+      "Smoothed bounds from sparse bounds differ for "
+        << currentFilePath.stem().string()
+    );
+  }
+}
+
+BOOST_AUTO_TEST_CASE(RestoredGraphDistanceMatrices, *boost::unit_test::label("DG")) {
+  using namespace Scine::Molassembler;
+
+  for(
+    const boost::filesystem::path& currentFilePath :
+    boost::filesystem::recursive_directory_iterator("stereocenter_detection_molecules")
+  ) {
+    Molecule molecule = IO::read(
+      currentFilePath.string()
+    );
+
+    DistanceGeometry::SpatialModel spatialModel {molecule, DistanceGeometry::Configuration {}};
+    const auto bounds = spatialModel.makePairwiseBounds();
+
+    DistanceGeometry::ExplicitBoundsGraph restored {
+      molecule.graph().inner(),
+      bounds
+    };
+
+    // A restored graph must yield the same distance matrices as a fresh one
+    for(int seed : {1, 2, 3}) {
+      DistanceGeometry::ExplicitBoundsGraph fresh {
+        molecule.graph().inner(),
+        bounds
+      };
+
+      Random::Engine freshEngine {seed};
+      Random::Engine restoredEngine {seed};
+      restored.restore();
+      auto freshResult = fresh.makeDistanceMatrix(freshEngine);
+      auto restoredResult = restored.makeDistanceMatrix(restoredEngine);
+
+      BOOST_REQUIRE(freshResult && restoredResult);
+      BOOST_CHECK_MESSAGE(
+        freshResult.value() == restoredResult.value(),
+        "Restored graph distance matrix differs for "
+          << currentFilePath.stem().string()
+      );
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(ExplicitBoundsGraphFeasibility, *boost::unit_test::label("DG")) {
+  using namespace Scine::Molassembler;
+
+  const Molecule molecule = IO::Experimental::parseSmilesSingleMolecule("[C@@H](F)(Cl)Br");
+  const auto data = DistanceGeometry::gatherDGInformation(
+    molecule,
+    DistanceGeometry::Configuration {}
+  );
+  BOOST_REQUIRE(!data.chiralConstraints.empty());
+
+  Metrics::reset();
+  BOOST_CHECK(DistanceGeometry::checkFeasibility(molecule, data));
+  BOOST_CHECK_EQUAL(Metrics::snapshot().infeasibleModels, 0);
+
+  // Two substituents cannot be further apart than both of their bonds
+  DistanceGeometry::SpatialModel::SparseBoundsMatrixHelper contradiction {data.bounds};
+  contradiction.bounds[{{1, 2}}] = DistanceGeometry::ValueBounds {10.0, 11.0};
+  const auto contradictionResult = DistanceGeometry::checkFeasibility(
+    molecule,
+    contradiction.matrix(),
+    data.chiralConstraints
+  );
+  BOOST_REQUIRE(!contradictionResult);
+  BOOST_CHECK(contradictionResult.error() == DgError::GraphImpossible);
+
+  // Volumes are limited by the distances between the sites of a constraint
+  auto chiralConstraints = data.chiralConstraints;
+  chiralConstraints.front().lower = 1000.0;
+  chiralConstraints.front().upper = 1001.0;
+  const auto chiralResult = DistanceGeometry::checkFeasibility(
+    molecule,
+    data.bounds,
+    chiralConstraints
+  );
+  BOOST_REQUIRE(!chiralResult);
+  BOOST_CHECK(chiralResult.error() == DgError::GraphImpossible);
+
+  BOOST_CHECK_EQUAL(Metrics::snapshot().infeasibleModels, 2);
+}
@@ -10,6 +10,7 @@
 #include "boost/test/unit_test.hpp"
 
 #include "Molassembler/Conformers.h"
+#include "Molassembler/DistanceGeometry/SpatialModel.h"
 #include "Molassembler/Molecule.h"
 #include "Molassembler/IO.h"
 
@@ -86,3 +87,57 @@ BOOST_AUTO_TEST_CASE(FixedPositionsWork, *boost::unit_test::label("DG")) {
     "The ring-like positions aren't fixed as required."
   );
 }
+
+BOOST_AUTO_TEST_CASE(FixedPositionEnsembles, *boost::unit_test::label("DG")) {
+  auto octadecane = IO::read("various/octadecane.mol");
+
+  // Chain ends at varying separations
+  std::vector<DistanceGeometry::Configuration::FixedPositions> fixedPositionSets;
+  for(const double halfSeparation : {3.0, 4.0, 5.0}) {
+    fixedPositionSets.push_back({
+      {16, Utils::Position {-halfSeparation, 0.0, 0.0}},
+      {17, Utils::Position {halfSeparation, 0.0, 0.0}}
+    });
+  }
+
+  // Replacing fixed positions yields the same model as modeling with them
+  DistanceGeometry::Configuration config;
+  config.fixedPositions = fixedPositionSets.front();
+  DistanceGeometry::SpatialModel replaced {octadecane, config};
+  replaced.replaceFixedPositions(fixedPositionSets.back());
+  config.fixedPositions = fixedPositionSets.back();
+  const DistanceGeometry::SpatialModel modeled {octadecane, config};
+  const Eigen::MatrixXd replacedBounds = replaced.makeSparsePairwiseBounds();
+  const Eigen::MatrixXd modeledBounds = modeled.makeSparsePairwiseBounds();
+  BOOST_CHECK(replacedBounds.isApprox(modeledBounds, 1e-10));
+
+  const unsigned numStructures = 2;
+  const auto ensembles = generateFixedPositionEnsembles(
+    octadecane,
+    fixedPositionSets,
+    numStructures,
+    1042
+  );
+  BOOST_REQUIRE_EQUAL(ensembles.size(), fixedPositionSets.size());
+  for(unsigned s = 0; s < ensembles.size(); ++s) {
+    BOOST_REQUIRE_EQUAL(ensembles.at(s).size(), numStructures);
+    for(const auto& result : ensembles.at(s)) {
+      BOOST_REQUIRE(result);
+      for(const auto& fixedPositionPair : fixedPositionSets.at(s)) {
+        BOOST_CHECK(
+          result.value().row(fixedPositionPair.first).isApprox(
+            fixedPositionPair.second,
+            1e-2
+          )
+        );
+      }
+    }
+  }
+
+  // Sets must fix the same atoms
+  fixedPositionSets.push_back({{13, Utils::Position::Zero()}});
+  BOOST_CHECK_THROW(
+    generateFixedPositionEnsembles(octadecane, fixedPositionSets, 1, 1042),
+    std::invalid_argument
+  );
+}
@@ -144,6 +144,29 @@ std::vector<double> Gor1IG (const DistanceGeometry::ImplicitBoundsGraph& graph,
   return distances;
 }
 
+// Use row-relaxing GOR1 implementation for ImplicitBoundsGraph
+std::vector<double> Gor1IGRows(const DistanceGeometry::ImplicitBoundsGraph& graph, unsigned sourceVertex) {
+  using Graph = DistanceGeometry::ImplicitBoundsGraph;
+  using Vertex = typename boost::graph_traits<Graph>::vertex_descriptor;
+
+  unsigned N = boost::num_vertices(graph);
+  std::vector<double> distances(N);
+  std::vector<Vertex> predecessors(N);
+
+  using ColorMapType = boost::two_bit_color_map<>;
+  ColorMapType color_map {N};
+
+  boost::gor1_ig_row_shortest_paths(
+    graph,
+    Vertex {sourceVertex},
+    predecessors,
+    color_map,
+    distances
+  );
+
+  return distances;
+}
+
 struct DBM_FW_Functor {
   const DistanceGeometry::DistanceBoundsMatrix& boundsRef;
 
@@ -412,6 +435,13 @@ bool shortestGraphsAlgorithmsResultsMatch(
       break;
     }
 
+    // Relaxing whole rows visits the same edges in the same order
+    if(Gor1IGRows(implicitGraph, 2 * outerVertex) != Gor_IG_distances) {
+      pass = false;
+      std::cout << "Row-relaxing and unspecialized Gor1 shortest-paths-distances on the ImplicitBoundsGraph differ!" << nl;
+      break;
+    }
+
     for(unsigned j = 0; j < Gor_IG_distances.size(); j += 2) {
       if(j / 2 == outerVertex) {
         continue;
@@ -264,3 +264,45 @@ BOOST_AUTO_TEST_CASE(ExplicitExampleFromLecture, *boost::unit_test::label("DG"))
     << expectedMetricMatrix << "\ngot " << metric.access() << " instead.\n"
   );
 }
+
+BOOST_AUTO_TEST_CASE(EmbeddingWorkspaceMatchesFullDiagonalization, *boost::unit_test::label("DG")) {
+  /* Embedded coordinates are only defined up to the signs of the
+   * eigenvectors, so compare the Gram matrices of the embeddings instead
+   */
+  auto gram = [](const Eigen::MatrixXd& positions) -> Eigen::MatrixXd {
+    return positions.transpose() * positions;
+  };
+
+  std::uniform_real_distribution<double> noise(0.95, 1.05);
+
+  EmbeddingWorkspace coldWorkspace;
+  EmbeddingWorkspace warmWorkspace;
+  warmWorkspace.warmStart = true;
+
+  for(const unsigned N : {30u, 90u}) {
+    const Eigen::MatrixXd points = 3 * Eigen::MatrixXd::Random(3, N);
+
+    for(unsigned repeat = 0; repeat < 5; ++repeat) {
+      // Perturb an exact distance matrix slightly so that it is not Euclidean
+      Eigen::MatrixXd distances = Eigen::MatrixXd::Zero(N, N);
+      for(unsigned i = 0; i < N; ++i) {
+        for(unsigned j = i + 1; j < N; ++j) {
+          distances(i, j) = (points.col(i) - points.col(j)).norm() * noise(randomnessEngine());
+        }
+      }
+
+      const MetricMatrix metric(distances);
+      const Eigen::MatrixXd expected = gram(metric.embedWithFullDiagonalization());
+
+      for(EmbeddingWorkspace* workspacePtr : {&coldWorkspace, &warmWorkspace}) {
+        const Eigen::MatrixXd embedded = gram(metric.embed(*workspacePtr));
+        BOOST_CHECK_MESSAGE(
+          embedded.isApprox(expected, 1e-4),
+          "Embedding with " << (workspacePtr->warmStart ? "warm" : "cold")
+          << " workspace does not match full diagonalization for N = " << N
+          << ", relative difference " << (embedded - expected).norm() / expected.norm()
+        );
+      }
+    }
+  }
+}
@@ -585,7 +585,9 @@ struct CompareImplementations {
 BOOST_AUTO_TEST_CASE(RefinementProblemEquivalence, *boost::unit_test::label("DG")) {
   using DoubleRefinementTypeVariations = std::tuple<
     EigenRefinementProblem<4, double, false>,
-    EigenRefinementProblem<4, double, true>
+    EigenRefinementProblem<4, double, true>,
+    EigenRefinementProblem<4, double, false, 32>,
+    EigenRefinementProblem<4, double, true, 32>
   >;
 
   auto doublePasses = Temple::Tuples::mapAllPairs<DoubleRefinementTypeVariations, CompareImplementations>();
@@ -597,7 +599,9 @@ BOOST_AUTO_TEST_CASE(RefinementProblemEquivalence, *boost::unit_test::label("DG"
 
   using FloatRefinementTypeVariations = std::tuple<
     EigenRefinementProblem<4, float, false>,
-    EigenRefinementProblem<4, float, true>
+    EigenRefinementProblem<4, float, true>,
+    EigenRefinementProblem<4, float, false, 32>,
+    EigenRefinementProblem<4, float, true, 32>
   >;
 
   auto floatPasses = Temple::Tuples::mapAllPairs<FloatRefinementTypeVariations, CompareImplementations>();
@@ -607,3 +611,241 @@ BOOST_AUTO_TEST_CASE(RefinementProblemEquivalence, *boost::unit_test::label("DG"
     "Not all refinement template argument of float variations match pair-wise!"
   );
 }
+
+BOOST_AUTO_TEST_CASE(RefinementProblemAtomCountDispatch, *boost::unit_test::label("DG")) {
+  const auto bucket = [](const unsigned N) {
+    return dispatchAtomCount(N, [](auto maxAtoms) -> int { return maxAtoms; });
+  };
+
+  BOOST_CHECK_EQUAL(bucket(2), 8);
+  BOOST_CHECK_EQUAL(bucket(8), 8);
+  BOOST_CHECK_EQUAL(bucket(9), 16);
+  BOOST_CHECK_EQUAL(bucket(32), 32);
+  BOOST_CHECK_EQUAL(bucket(33), Eigen::Dynamic);
+
+  using BoundedType = EigenRefinementProblem<4, double, false, 8>;
+  static_assert(BoundedType::maxPairs == 28, "Eight atoms have 28 pairs");
+  static_assert(
+    RefinementTraits<BoundedType>::MaxAtomsConstant::value == 8,
+    "Traits yield the atom count bound"
+  );
+}
+
+BOOST_AUTO_TEST_CASE(RefinementProblemSparseDistanceTerms, *boost::unit_test::label("DG")) {
+  using RefinementType = EigenRefinementProblem<4, double, false>;
+  using VectorType = typename RefinementType::VectorType;
+
+  for(
+    const boost::filesystem::path& currentFilePath :
+    boost::filesystem::recursive_directory_iterator("ez_stereocenters")
+  ) {
+    RefinementBaseData baseData {currentFilePath.string()};
+
+    const RefinementType denseFunctor {
+      baseData.squaredBounds(),
+      baseData.chiralConstraints,
+      baseData.dihedralConstraints
+    };
+
+    RefinementType sparseFunctor {
+      baseData.squaredBounds(),
+      baseData.chiralConstraints,
+      baseData.dihedralConstraints
+    };
+    sparseFunctor.distanceTermSkin = 0.5;
+
+    VectorType positions = baseData.linearizeEmbeddedPositions();
+
+    // Small steps reuse the neighbor list, larger steps force rebuilds
+    for(unsigned step = 0; step < 50; ++step) {
+      const double stepLength = (step % 10 == 0) ? 0.5 : 0.02;
+      positions += stepLength * VectorType::Random(positions.size());
+
+      double denseError = 0;
+      VectorType denseGradient = VectorType::Zero(positions.size());
+      denseFunctor.distanceContributions(positions, denseError, denseGradient);
+
+      double sparseError = 0;
+      VectorType sparseGradient = VectorType::Zero(positions.size());
+      sparseFunctor.distanceContributions(positions, sparseError, sparseGradient);
+
+      BOOST_REQUIRE_MESSAGE(
+        std::fabs(denseError - sparseError) <= 1e-10 * std::max(1.0, denseError),
+        "Sparse distance error " << sparseError << " differs from dense error "
+        << denseError << " for " << currentFilePath.string() << " at step " << step
+      );
+
+      BOOST_REQUIRE_MESSAGE(
+        denseGradient.isApprox(sparseGradient, 1e-10) || (denseGradient - sparseGradient).norm() < 1e-12,
+        "Sparse distance gradient differs from dense gradient for "
+        << currentFilePath.string() << " at step " << step
+      );
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(RefinementProblemBatchEvaluation, *boost::unit_test::label("DG")) {
+  using RefinementType = EigenRefinementProblem<4, double, false>;
+  using VectorType = typename RefinementType::VectorType;
+  using BatchMatrixType = typename RefinementType::BatchMatrixType;
+
+  const unsigned K = 5;
+
+  for(
+    const boost::filesystem::path& currentFilePath :
+    boost::filesystem::recursive_directory_iterator("ez_stereocenters")
+  ) {
+    RefinementBaseData baseData {currentFilePath.string()};
+
+    RefinementType functor {
+      baseData.squaredBounds(),
+      baseData.chiralConstraints,
+      baseData.dihedralConstraints
+    };
+    functor.compressFourthDimension = true;
+
+    const VectorType positions = baseData.linearizeEmbeddedPositions();
+    BatchMatrixType batch(positions.size(), K);
+    for(unsigned k = 0; k < K; ++k) {
+      batch.col(k) = positions + 0.2 * k * VectorType::Random(positions.size());
+    }
+
+    VectorType values(K);
+    BatchMatrixType gradients(positions.size(), K);
+    functor.evaluateBatch(batch, values, gradients);
+
+    for(unsigned k = 0; k < K; ++k) {
+      double value = 0;
+      VectorType gradient = VectorType::Zero(positions.size());
+      functor(batch.col(k), value, gradient);
+
+      BOOST_CHECK_MESSAGE(
+        std::fabs(value - values(k)) <= 1e-10 * std::max(1.0, value),
+        "Batch error " << values(k) << " of conformer " << k
+        << " differs from individual error " << value << " for "
+        << currentFilePath.string()
+      );
+
+      BOOST_CHECK_MESSAGE(
+        gradient.isApprox(gradients.col(k), 1e-10),
+        "Batch gradient of conformer " << k << " differs from individual gradient for "
+        << currentFilePath.string()
+      );
+
+      BOOST_CHECK_EQUAL(
+        functor.batchProportionsChiralConstraintsCorrectSign.at(k),
+        functor.proportionChiralConstraintsCorrectSign
+      );
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(RefinementProblemHessian, *boost::unit_test::label("DG")) {
+  using RefinementType = EigenRefinementProblem<4, double, false>;
+  using VectorType = typename RefinementType::VectorType;
+  using HessianType = typename RefinementType::HessianType;
+
+  for(
+    const boost::filesystem::path& currentFilePath :
+    boost::filesystem::recursive_directory_iterator("ez_stereocenters")
+  ) {
+    RefinementBaseData baseData {currentFilePath.string()};
+
+    RefinementType functor {
+      baseData.squaredBounds(),
+      baseData.chiralConstraints,
+      baseData.dihedralConstraints
+    };
+    functor.compressFourthDimension = true;
+    functor.dihedralTerms = true;
+
+    const VectorType positions = baseData.linearizeEmbeddedPositions() + 0.1 * VectorType::Random(baseData.embeddedPositions.size());
+    const unsigned P = positions.size();
+
+    double value = 0;
+    VectorType gradient(P);
+    HessianType hessian(P, P);
+    functor(positions, value, gradient, hessian);
+
+    // Central differences of the gradient
+    constexpr double h = 1e-6;
+    HessianType numericalHessian(P, P);
+    VectorType displaced = positions;
+    VectorType forwardGradient(P);
+    VectorType backwardGradient(P);
+    for(unsigned p = 0; p < P; ++p) {
+      displaced(p) = positions(p) + h;
+      functor(displaced, value, forwardGradient);
+      displaced(p) = positions(p) - h;
+      functor(displaced, value, backwardGradient);
+      displaced(p) = positions(p);
+      numericalHessian.col(p) = (forwardGradient - backwardGradient) / (2 * h);
+    }
+
+    BOOST_CHECK_MESSAGE(
+      (hessian - numericalHessian).norm() <= 1e-4 * std::max(1.0, numericalHessian.norm()),
+      "Hessian deviates from central differences of the gradient by "
+      << (hessian - numericalHessian).norm() << " for " << currentFilePath.string()
+    );
+
+    typename RefinementType::SparseHessianType sparseHessian;
+    functor.hessian(positions, sparseHessian);
+    BOOST_CHECK_MESSAGE(
+      HessianType(sparseHessian).isApprox(hessian, 1e-12),
+      "Sparse Hessian differs from dense Hessian for " << currentFilePath.string()
+    );
+  }
+}
+
+BOOST_AUTO_TEST_CASE(RefinementProblemChiralSignCensus, *boost::unit_test::label("DG")) {
+  using RefinementType = EigenRefinementProblem<4, double, true>;
+  using VectorType = typename RefinementType::VectorType;
+
+  const unsigned N = 8;
+  Eigen::MatrixXd squaredBounds = Eigen::MatrixXd::Zero(N, N);
+  squaredBounds.triangularView<Eigen::StrictlyUpper>().setConstant(100);
+
+  // Constraints with single-atom and averaged sites, one with zero target volume
+  std::vector<ChiralConstraint> constraints {
+    ChiralConstraint {{{{0}, {1}, {2}, {3}}}, 2.0, 3.0},
+    ChiralConstraint {{{{4, 5}, {1}, {6}, {7, 2, 3}}}, -3.0, -2.0},
+    ChiralConstraint {{{{0}, {5}, {6}, {7}}}, 0.0, 0.0}
+  };
+
+  RefinementType problem {squaredBounds, constraints, {}};
+
+  const auto volume = [](const VectorType& positions, const ChiralConstraint& constraint) {
+    const auto average = [&](const ChiralConstraint::AtomListType& atoms) -> Eigen::Vector3d {
+      Eigen::Vector3d sum = Eigen::Vector3d::Zero();
+      for(const AtomIndex i : atoms) {
+        sum += positions.segment<3>(4 * i);
+      }
+      return sum / atoms.size();
+    };
+
+    const Eigen::Vector3d delta = average(constraint.sites[3]);
+    return (average(constraint.sites[0]) - delta).dot(
+      (average(constraint.sites[1]) - delta).cross(average(constraint.sites[2]) - delta)
+    );
+  };
+
+  for(unsigned trial = 0; trial < 10; ++trial) {
+    const VectorType positions = Eigen::VectorXd::Random(4 * N);
+
+    unsigned correct = 0;
+    for(unsigned c = 0; c < 2; ++c) {
+      if(volume(positions, constraints.at(c)) * constraints.at(c).lower > 0) {
+        ++correct;
+      }
+    }
+    const double expected = correct / 2.0;
+
+    BOOST_CHECK_EQUAL(problem.calculateProportionChiralConstraintsCorrectSign(positions), expected);
+
+    // Chiral contributions yield the same census
+    double error = 0;
+    VectorType gradient = VectorType::Zero(4 * N);
+    problem.chiralContributions(positions, error, gradient);
+    BOOST_CHECK_EQUAL(problem.proportionChiralConstraintsCorrectSign, expected);
+  }
+}
@@ -4,16 +4,25 @@
  *   See LICENSE.txt for details.
  */
 
+#include "boost/filesystem.hpp"
 #include "boost/test/unit_test.hpp"
+#include "Utils/Constants.h"
 
 #include "Molassembler/Conformers.h"
+#include "Molassembler/DistanceGeometry/ConformerGeneration.h"
+#include "Molassembler/DistanceGeometry/Error.h"
 #include "Molassembler/IO.h"
+#include "Molassembler/IO/SmilesParser.h"
 #include "Molassembler/Molecule.h"
 #include "Molassembler/Options.h"
+#include "Molassembler/Parallel.h"
+#include "Molassembler/Prng.h"
 
 #include "Molassembler/Temple/Functional.h"
 #include "Molassembler/Temple/Stringify.h"
 
+#include <set>
+
 using namespace Scine::Molassembler;
 
 BOOST_AUTO_TEST_CASE(ReproducibleConformers, *boost::unit_test::label("DG")) {
@@ -123,3 +132,665 @@ BOOST_AUTO_TEST_CASE(ReproducibleEnsembles, *boost::unit_test::label("DG")) {
     "Not all conformers could be matched between two re-seeded ensemble generations"
   );
 }
+
+BOOST_AUTO_TEST_CASE(StreamedEnsembleMatchesVector, *boost::unit_test::label("DG")) {
+  const unsigned seed = 1042;
+  const unsigned ensembleSize = 6;
+
+  Molecule mol = IO::read("stereocenter_detection_molecules/RSs-halogenated-propane.mol");
+  const auto ensemble = generateEnsemble(mol, ensembleSize, seed);
+
+  std::vector<bool> visited(ensembleSize, false);
+  generateEnsemble(
+    mol,
+    ensembleSize,
+    seed,
+    [&](const unsigned i, unsigned /* conformerSeed */, outcome::result<Scine::Utils::PositionCollection> result) {
+      BOOST_REQUIRE_LT(i, ensembleSize);
+      BOOST_CHECK(!visited.at(i));
+      visited.at(i) = true;
+
+      const auto& expected = ensemble.at(i);
+      BOOST_REQUIRE(result.has_value() == expected.has_value());
+      if(result) {
+        BOOST_CHECK(result.value().isApprox(expected.value(), 1e-6));
+      }
+    }
+  );
+
+  BOOST_CHECK(Temple::all_of(visited));
+}
+
+BOOST_AUTO_TEST_CASE(SuccessfulEnsembleEarlyTermination, *boost::unit_test::label("DG")) {
+  const unsigned seed = 488;
+  const unsigned numSuccesses = 4;
+
+  Molecule mol = IO::read("stereocenter_detection_molecules/RSs-halogenated-propane.mol");
+  const auto a = generateSuccessfulEnsemble(mol, numSuccesses, 20, seed);
+  const auto b = generateSuccessfulEnsemble(mol, numSuccesses, 20, seed);
+  BOOST_REQUIRE(a && b);
+  BOOST_REQUIRE_EQUAL(a.value().size(), numSuccesses);
+  BOOST_REQUIRE_EQUAL(b.value().size(), numSuccesses);
+
+  for(unsigned i = 0; i < numSuccesses; ++i) {
+    BOOST_CHECK(a.value().at(i).isApprox(b.value().at(i), 1e-6));
+  }
+
+  // A zero attempt budget yields no conformers
+  const auto c = generateSuccessfulEnsemble(mol, numSuccesses, 0, seed);
+  BOOST_REQUIRE(c);
+  BOOST_CHECK(c.value().empty());
+}
+
+BOOST_AUTO_TEST_CASE(CancelledEnsemble, *boost::unit_test::label("DG")) {
+  const Molecule mol = IO::Experimental::parseSmilesSingleMolecule("CC(F)(Cl)CBr");
+
+  DistanceGeometry::Configuration configuration;
+  configuration.cancellation.cancel();
+  const auto cancelled = generateEnsemble(mol, 4, 1042, configuration);
+  BOOST_REQUIRE_EQUAL(cancelled.size(), 4);
+  BOOST_CHECK(
+    Temple::all_of(cancelled, [](const auto& result) {
+      return !result && result.error() == DgError::Cancelled;
+    })
+  );
+
+  // An elapsed deadline cancels likewise
+  configuration.cancellation = CancellationToken::after(0.0);
+  const auto expired = generateConformation(mol, 1042, configuration);
+  BOOST_REQUIRE(!expired);
+  BOOST_CHECK(expired.error() == DgError::Cancelled);
+
+  // Copies share their state
+  configuration.cancellation = CancellationToken {};
+  const CancellationToken copy = configuration.cancellation;
+  BOOST_CHECK(generateConformation(mol, 1042, configuration));
+  copy.cancel();
+  BOOST_CHECK(configuration.cancellation.cancelled());
+}
+
+BOOST_AUTO_TEST_CASE(PreparedModelMatchesMolecule, *boost::unit_test::label("DG")) {
+  const unsigned seed = 1042;
+  const unsigned ensembleSize = 4;
+
+  Molecule mol = IO::read("stereocenter_detection_molecules/RSs-halogenated-propane.mol");
+  const DistanceGeometry::PreparedModel model {mol};
+  const auto roundTripModel = DistanceGeometry::PreparedModel::deserialize(
+    model.serialize()
+  );
+
+  const auto a = generateEnsemble(mol, ensembleSize, seed);
+  const auto b = generateEnsemble(model, ensembleSize, seed);
+  const auto c = generateEnsemble(roundTripModel, ensembleSize, seed);
+
+  for(unsigned i = 0; i < ensembleSize; ++i) {
+    BOOST_REQUIRE(a.at(i).has_value() == b.at(i).has_value());
+    BOOST_REQUIRE(a.at(i).has_value() == c.at(i).has_value());
+    if(a.at(i)) {
+      BOOST_CHECK(a.at(i).value().isApprox(b.at(i).value(), 1e-6));
+      BOOST_CHECK(a.at(i).value().isApprox(c.at(i).value(), 1e-6));
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(PreparedModelCache, *boost::unit_test::label("DG")) {
+  const unsigned seed = 319;
+  const unsigned ensembleSize = 3;
+
+  Molecule mol = IO::read("stereocenter_detection_molecules/RSs-halogenated-propane.mol");
+  mol.canonicalize();
+
+  const boost::filesystem::path directory = (
+    boost::filesystem::temp_directory_path()
+    / boost::filesystem::unique_path("masm-cache-%%%%-%%%%")
+  );
+
+  const auto countEntries = [&]() -> unsigned {
+    return std::distance(
+      boost::filesystem::directory_iterator(directory),
+      boost::filesystem::directory_iterator()
+    );
+  };
+
+  // A miss prepares the model and writes a single entry
+  const auto prepared = DistanceGeometry::PreparedModel::cached(mol, {}, directory.string());
+  BOOST_REQUIRE_EQUAL(countEntries(), 1);
+
+  // A hit loads the entry and yields the same conformers
+  const auto loaded = DistanceGeometry::PreparedModel::cached(mol, {}, directory.string());
+  BOOST_CHECK_EQUAL(countEntries(), 1);
+
+  const auto a = generateEnsemble(prepared, ensembleSize, seed);
+  const auto b = generateEnsemble(loaded, ensembleSize, seed);
+  for(unsigned i = 0; i < ensembleSize; ++i) {
+    BOOST_REQUIRE(a.at(i).has_value() == b.at(i).has_value());
+    if(a.at(i)) {
+      BOOST_CHECK(a.at(i).value().isApprox(b.at(i).value(), 1e-6));
+    }
+  }
+
+  // Differing configurations are separate entries
+  DistanceGeometry::Configuration configuration;
+  configuration.spatialModelLoosening = 1.5;
+  const auto loosened = DistanceGeometry::PreparedModel::cached(mol, configuration, directory.string());
+  BOOST_CHECK_EQUAL(countEntries(), 2);
+  BOOST_CHECK_EQUAL(loosened.configuration().spatialModelLoosening, 1.5);
+
+  boost::filesystem::remove_all(directory);
+}
+
+BOOST_AUTO_TEST_CASE(PreparedModelCacheSharesLoadedModels, *boost::unit_test::label("DG")) {
+  Molecule mol = IO::read("stereocenter_detection_molecules/RSs-halogenated-propane.mol");
+  mol.canonicalize();
+
+  const boost::filesystem::path directory = (
+    boost::filesystem::temp_directory_path()
+    / boost::filesystem::unique_path("masm-cache-%%%%-%%%%")
+  );
+
+  // Models in use are shared instead of loaded again
+  auto prepared = DistanceGeometry::PreparedModel::cached(mol, {}, directory.string());
+  {
+    const auto shared = DistanceGeometry::PreparedModel::cached(mol, {}, directory.string());
+    BOOST_CHECK(&shared.impl() == &prepared.impl());
+  }
+
+  DistanceGeometry::Configuration configuration;
+  configuration.spatialModelLoosening = 1.5;
+  const auto loosened = DistanceGeometry::PreparedModel::cached(mol, configuration, directory.string());
+  BOOST_CHECK(&loosened.impl() != &prepared.impl());
+
+  // Once no longer in use, models are loaded from the cache directory again
+  const std::string serialization = prepared.serialize();
+  prepared = loosened;
+  const auto reloaded = DistanceGeometry::PreparedModel::cached(mol, {}, directory.string());
+  BOOST_CHECK_EQUAL(reloaded.serialize(), serialization);
+
+  boost::filesystem::remove_all(directory);
+}
+
+BOOST_AUTO_TEST_CASE(BatchedEnsembles, *boost::unit_test::label("DG")) {
+  const unsigned seed = 2020;
+
+  const std::vector<Molecule> molecules {
+    IO::read("stereocenter_detection_molecules/RSs-halogenated-propane.mol"),
+    IO::read("stereocenter_detection_molecules/2R-chlorobutane.mol")
+  };
+
+  const auto batch = generateEnsembles(molecules, {3, 2}, seed);
+  BOOST_REQUIRE_EQUAL(batch.size(), 2);
+  BOOST_REQUIRE_EQUAL(batch.front().size(), 3);
+  BOOST_REQUIRE_EQUAL(batch.back().size(), 2);
+
+  // Results of the first molecule do not depend on the rest of the batch
+  const auto single = generateEnsembles({molecules.front()}, {3}, seed);
+  BOOST_REQUIRE_EQUAL(single.size(), 1);
+  for(unsigned i = 0; i < 3; ++i) {
+    const auto& a = batch.front().at(i);
+    const auto& b = single.front().at(i);
+    BOOST_REQUIRE(a.has_value() == b.has_value());
+    if(a) {
+      BOOST_CHECK(a.value().isApprox(b.value(), 1e-6));
+    }
+  }
+
+  BOOST_CHECK_THROW(generateEnsembles(molecules, {1}, seed), std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_CASE(CounterBasedConformerSeeds, *boost::unit_test::label("DG")) {
+  // Stream seeds are a pure function of the seed and the stream index
+  std::set<int> seeds;
+  for(unsigned i = 0; i < 1000; ++i) {
+    const int streamSeed = Random::streamSeed(2020, i);
+    BOOST_CHECK_GE(streamSeed, 0);
+    BOOST_CHECK_EQUAL(streamSeed, Random::streamSeed(2020, i));
+    seeds.insert(streamSeed);
+  }
+  BOOST_CHECK_EQUAL(seeds.size(), 1000);
+  BOOST_CHECK_NE(Random::streamSeed(2020, 0), Random::streamSeed(2021, 0));
+
+  // Conformers depend only on the seed and their index
+  const Molecule mol = IO::read("stereocenter_detection_molecules/2R-chlorobutane.mol");
+  const auto shorter = generateEnsemble(mol, 2, 2020);
+  const auto longer = generateEnsemble(mol, 4, 2020);
+  for(unsigned i = 0; i < 2; ++i) {
+    BOOST_REQUIRE(shorter.at(i).has_value() == longer.at(i).has_value());
+    if(shorter.at(i)) {
+      BOOST_CHECK(shorter.at(i).value().isApprox(longer.at(i).value(), 1e-6));
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(ExecutorIndependentEnsembles, *boost::unit_test::label("DG")) {
+  const Molecule mol = IO::read("stereocenter_detection_molecules/2R-chlorobutane.mol");
+  const auto reference = generateEnsemble(mol, 6, 1337);
+
+  for(const auto& executor : {Parallel::serial(), Parallel::threads(3)}) {
+    Parallel::setExecutor(executor);
+    const auto ensemble = generateEnsemble(mol, 6, 1337);
+    for(unsigned i = 0; i < 6; ++i) {
+      BOOST_REQUIRE(ensemble.at(i).has_value() == reference.at(i).has_value());
+      if(ensemble.at(i)) {
+        BOOST_CHECK(ensemble.at(i).value().isApprox(reference.at(i).value(), 1e-6));
+      }
+    }
+  }
+
+  Parallel::setExecutor(Parallel::openMP());
+}
+
+BOOST_AUTO_TEST_CASE(RefinementPrecisions, *boost::unit_test::label("DG")) {
+  const unsigned seed = 733;
+  const unsigned ensembleSize = 4;
+
+  Molecule mol = IO::read("stereocenter_detection_molecules/RSs-halogenated-propane.mol");
+  for(const auto precision : {
+    DistanceGeometry::RefinementPrecision::Double,
+    DistanceGeometry::RefinementPrecision::Single,
+    DistanceGeometry::RefinementPrecision::Mixed
+  }) {
+    DistanceGeometry::Configuration configuration;
+    configuration.refinementPrecision = precision;
+
+    const auto a = generateEnsemble(mol, ensembleSize, seed, configuration);
+    const auto b = generateEnsemble(mol, ensembleSize, seed, configuration);
+    BOOST_CHECK_MESSAGE(
+      Temple::any_of(a, [](const auto& result) -> bool { return result.has_value(); }),
+      "No conformers generated with refinement precision " << static_cast<unsigned>(precision)
+    );
+
+    for(unsigned i = 0; i < ensembleSize; ++i) {
+      BOOST_REQUIRE(a.at(i).has_value() == b.at(i).has_value());
+      if(a.at(i)) {
+        BOOST_CHECK(a.at(i).value().isApprox(b.at(i).value(), 1e-6));
+      }
+    }
+
+    const DistanceGeometry::PreparedModel model {mol, configuration};
+    const auto roundTripModel = DistanceGeometry::PreparedModel::deserialize(
+      model.serialize()
+    );
+    BOOST_CHECK(roundTripModel.configuration().refinementPrecision == precision);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(RefinementHistory, *boost::unit_test::label("DG")) {
+  const unsigned seed = 905;
+  const unsigned ensembleSize = 4;
+
+  Molecule mol = IO::read("stereocenter_detection_molecules/RSs-halogenated-propane.mol");
+  for(const bool retain : {false, true}) {
+    DistanceGeometry::Configuration configuration;
+    configuration.refinementHistoryLength = 8;
+    configuration.retainRefinementHistory = retain;
+
+    const auto ensemble = generateEnsemble(mol, ensembleSize, seed, configuration);
+    BOOST_CHECK_MESSAGE(
+      Temple::any_of(ensemble, [](const auto& result) -> bool { return result.has_value(); }),
+      "No conformers generated with " << (retain ? "retained" : "discarded")
+      << " refinement history"
+    );
+  }
+}
+
+BOOST_AUTO_TEST_CASE(PreconditionedRefinement, *boost::unit_test::label("DG")) {
+  const unsigned seed = 905;
+  const unsigned ensembleSize = 4;
+
+  const Molecule mol = IO::Experimental::parseSmilesSingleMolecule("C1CCCCCCCCCCC1");
+  DistanceGeometry::Configuration configuration;
+  configuration.preconditionRefinement = true;
+  for(const unsigned batchSize : {1u, 2u}) {
+    configuration.refinementBatchSize = batchSize;
+    const auto ensemble = generateEnsemble(mol, ensembleSize, seed, configuration);
+    BOOST_CHECK_MESSAGE(
+      Temple::all_of(ensemble, [](const auto& result) -> bool { return result.has_value(); }),
+      "Preconditioned refinement fails with batch size " << batchSize
+    );
+  }
+
+  // Atoms are preconditioned uniformly across their coordinates
+  const Eigen::MatrixXd squaredBounds = (Eigen::MatrixXd(3, 3) <<
+    0, 1, 4,
+    1, 0, 4,
+    1, 1, 0
+  ).finished();
+  const Eigen::VectorXd preconditioner = DistanceGeometry::Detail::refinementPreconditioner(squaredBounds);
+  BOOST_REQUIRE_EQUAL(preconditioner.size(), 12);
+  BOOST_CHECK_CLOSE(preconditioner(0), 1 / 1.25, 1e-8);
+  BOOST_CHECK_CLOSE(preconditioner(7), 1 / 1.25, 1e-8);
+  BOOST_CHECK_CLOSE(preconditioner(11), 1 / 0.5, 1e-8);
+}
+
+BOOST_AUTO_TEST_CASE(TrustRegionRefinement, *boost::unit_test::label("DG")) {
+  const unsigned seed = 411;
+  const unsigned ensembleSize = 4;
+
+  Molecule mol = IO::read("stereocenter_detection_molecules/RSs-halogenated-propane.mol");
+  DistanceGeometry::Configuration configuration;
+  configuration.refinementOptimizer = DistanceGeometry::RefinementOptimizer::TrustRegion;
+
+  const auto a = generateEnsemble(mol, ensembleSize, seed, configuration);
+  const auto b = generateEnsemble(mol, ensembleSize, seed, configuration);
+  BOOST_CHECK_MESSAGE(
+    Temple::any_of(a, [](const auto& result) -> bool { return result.has_value(); }),
+    "No conformers generated with trust region refinement"
+  );
+
+  for(unsigned i = 0; i < ensembleSize; ++i) {
+    BOOST_REQUIRE(a.at(i).has_value() == b.at(i).has_value());
+    if(a.at(i)) {
+      BOOST_CHECK(a.at(i).value().isApprox(b.at(i).value(), 1e-6));
+    }
+  }
+
+  const DistanceGeometry::PreparedModel model {mol, configuration};
+  const auto roundTripModel = DistanceGeometry::PreparedModel::deserialize(
+    model.serialize()
+  );
+  BOOST_CHECK(roundTripModel.configuration().refinementOptimizer == configuration.refinementOptimizer);
+}
+
+BOOST_AUTO_TEST_CASE(BatchedRefinement, *boost::unit_test::label("DG")) {
+  const unsigned seed = 613;
+  const unsigned ensembleSize = 7;
+
+  Molecule mol = IO::read("stereocenter_detection_molecules/RSs-halogenated-propane.mol");
+  DistanceGeometry::Configuration configuration;
+  configuration.refinementBatchSize = 3;
+
+  const auto a = generateEnsemble(mol, ensembleSize, seed, configuration);
+  const auto b = generateEnsemble(mol, ensembleSize, seed, configuration);
+  BOOST_REQUIRE_EQUAL(a.size(), ensembleSize);
+  BOOST_CHECK_MESSAGE(
+    Temple::any_of(a, [](const auto& result) -> bool { return result.has_value(); }),
+    "No conformers generated with batched refinement"
+  );
+
+  for(unsigned i = 0; i < ensembleSize; ++i) {
+    BOOST_REQUIRE(a.at(i).has_value() == b.at(i).has_value());
+    if(a.at(i)) {
+      BOOST_CHECK(a.at(i).value().isApprox(b.at(i).value(), 1e-6));
+    }
+  }
+
+  // Prepared models refine in batches of their configuration's size, too
+  const DistanceGeometry::PreparedModel model {mol, configuration};
+  const auto c = generateEnsemble(model, ensembleSize, seed);
+  for(unsigned i = 0; i < ensembleSize; ++i) {
+    BOOST_REQUIRE(a.at(i).has_value() == c.at(i).has_value());
+    if(a.at(i)) {
+      BOOST_CHECK(a.at(i).value().isApprox(c.at(i).value(), 1e-6));
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(ChiralityScreening, *boost::unit_test::label("DG")) {
+  const unsigned seed = 1021;
+  const unsigned ensembleSize = 8;
+
+  Molecule mol = IO::read("stereocenter_detection_molecules/RSs-halogenated-propane.mol");
+  const auto unscreened = generateEnsemble(mol, ensembleSize, seed);
+
+  DistanceGeometry::Configuration screening;
+  screening.chiralityScreeningThreshold = 0.9;
+  screening.chiralityProbeIterations = 10;
+  screening.chiralityProbeThreshold = 0.75;
+
+  DistanceGeometry::Configuration rejectAll;
+  rejectAll.chiralityScreeningThreshold = 1.1;
+
+  // Screening only discards embeddings, it does not alter refinement
+  for(const auto& configuration : {screening, rejectAll}) {
+    const auto screened = generateEnsemble(mol, ensembleSize, seed, configuration);
+    BOOST_REQUIRE_EQUAL(screened.size(), ensembleSize);
+    for(unsigned i = 0; i < ensembleSize; ++i) {
+      if(screened.at(i)) {
+        BOOST_REQUIRE(unscreened.at(i));
+        BOOST_CHECK(screened.at(i).value().isApprox(unscreened.at(i).value(), 1e-6));
+      } else if(screened.at(i).error() != DgError::EmbeddingRejected) {
+        BOOST_CHECK(!unscreened.at(i));
+      }
+    }
+  }
+
+  const auto rejected = generateEnsemble(mol, ensembleSize, seed, rejectAll);
+  BOOST_CHECK_MESSAGE(
+    Temple::all_of(rejected, [](const auto& result) -> bool {
+      return !result && result.error() == DgError::EmbeddingRejected;
+    }),
+    "Not all embeddings rejected by a screening threshold above one"
+  );
+}
+
+BOOST_AUTO_TEST_CASE(RefinementStatisticsAlongsideConformers, *boost::unit_test::label("DG")) {
+  const unsigned seed = 4417;
+  const unsigned ensembleSize = 4;
+
+  Molecule mol = IO::read("stereocenter_detection_molecules/RSs-halogenated-propane.mol");
+  const auto plain = generateEnsemble(mol, ensembleSize, seed);
+  const auto withStatistics = generateEnsembleWithStatistics(mol, ensembleSize, seed);
+  BOOST_REQUIRE_EQUAL(withStatistics.size(), ensembleSize);
+
+  for(unsigned i = 0; i < ensembleSize; ++i) {
+    const auto& result = withStatistics.at(i).first;
+    const auto& statistics = withStatistics.at(i).second;
+    BOOST_REQUIRE(plain.at(i).has_value() == result.has_value());
+    if(!result) {
+      continue;
+    }
+
+    // Collecting statistics does not alter the results
+    BOOST_CHECK(plain.at(i).value().isApprox(result.value(), 1e-6));
+
+    // Successful conformers pass through the compression and dihedral stages
+    for(const auto& stage : {statistics.compression, statistics.dihedral}) {
+      BOOST_CHECK(stage.iterations > 0);
+      BOOST_CHECK(stage.evaluations > 0);
+      BOOST_CHECK(stage.seconds >= 0);
+    }
+    BOOST_CHECK(statistics.dihedral.gradientNorm >= 0);
+    BOOST_CHECK_EQUAL(statistics.polish.iterations, 0);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(RefinementTrajectoryRingBuffer, *boost::unit_test::label("DG")) {
+  DistanceGeometry::RefinementTrajectory trajectory {3};
+  for(unsigned i = 0; i < 5; ++i) {
+    DistanceGeometry::RefinementFrame frame;
+    frame.iteration = i;
+    trajectory.record(std::move(frame));
+  }
+
+  BOOST_CHECK_EQUAL(trajectory.recorded(), 5);
+  const auto frames = trajectory.frames();
+  BOOST_REQUIRE_EQUAL(frames.size(), 3);
+  for(unsigned i = 0; i < 3; ++i) {
+    BOOST_CHECK_EQUAL(frames.at(i).iteration, i + 2);
+  }
+
+  DistanceGeometry::RefinementTrajectory disabled;
+  disabled.record(DistanceGeometry::RefinementFrame {});
+  BOOST_CHECK(disabled.frames().empty());
+}
+
+BOOST_AUTO_TEST_CASE(RefinementTrajectoryAlongsideConformers, *boost::unit_test::label("DG")) {
+  const unsigned seed = 4417;
+  const unsigned ensembleSize = 4;
+
+  Molecule mol = IO::read("stereocenter_detection_molecules/RSs-halogenated-propane.mol");
+  const unsigned N = mol.graph().N();
+
+  DistanceGeometry::Configuration configuration;
+  configuration.trajectoryInterval = 5;
+  configuration.trajectoryCapacity = 8;
+  configuration.trajectoryPositions = true;
+
+  const auto plain = generateEnsemble(mol, ensembleSize, seed);
+  const auto withTrajectories = generateEnsembleWithStatistics(mol, ensembleSize, seed, configuration);
+  BOOST_REQUIRE_EQUAL(withTrajectories.size(), ensembleSize);
+
+  for(unsigned i = 0; i < ensembleSize; ++i) {
+    const auto& result = withTrajectories.at(i).first;
+    const auto& trajectory = withTrajectories.at(i).second.trajectory;
+    BOOST_REQUIRE(plain.at(i).has_value() == result.has_value());
+    if(!result) {
+      continue;
+    }
+
+    // Recording does not alter the results
+    BOOST_CHECK(plain.at(i).value().isApprox(result.value(), 1e-6));
+
+    BOOST_CHECK_EQUAL(trajectory.capacity(), configuration.trajectoryCapacity);
+    BOOST_CHECK_GT(trajectory.recorded(), 0);
+    const auto frames = trajectory.frames();
+    BOOST_CHECK_LE(frames.size(), configuration.trajectoryCapacity);
+    for(const auto& frame : frames) {
+      BOOST_CHECK_EQUAL(frame.iteration % configuration.trajectoryInterval, 0);
+      BOOST_CHECK(frame.gradientNorm >= 0);
+      BOOST_CHECK_GE(frame.positions.size(), 4 * N);
+    }
+    // The last frames belong to the final stage
+    BOOST_REQUIRE(!frames.empty());
+    BOOST_CHECK(frames.back().stage == DistanceGeometry::RefinementStage::Dihedral);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(SharedModelMatchesNarrowedModel, *boost::unit_test::label("DG")) {
+  // Both double bonds' stereopermutators are unassigned
+  const Molecule mol = IO::Experimental::parseSmilesSingleMolecule("CC=CC=CC");
+  BOOST_REQUIRE(DistanceGeometry::SharedModel::applicable(mol));
+
+  const DistanceGeometry::Configuration configuration {};
+  const DistanceGeometry::SharedModel sharedModel {mol, configuration};
+  BOOST_CHECK_EQUAL(sharedModel.deferredBonds.size(), 2);
+
+  Random::Engine engine;
+  for(unsigned seed = 0; seed < 8; ++seed) {
+    engine.seed(seed);
+    const Molecule narrowed = DistanceGeometry::Detail::narrow(mol, engine);
+    const auto overlaid = sharedModel.overlay(narrowed);
+    BOOST_REQUIRE(overlaid);
+
+    const auto full = DistanceGeometry::gatherDGInformation(narrowed, configuration);
+    const Eigen::MatrixXd overlaidBounds = overlaid->bounds;
+    const Eigen::MatrixXd fullBounds = full.bounds;
+    BOOST_CHECK(overlaidBounds.isApprox(fullBounds, 1e-12));
+    BOOST_CHECK_EQUAL(overlaid->chiralConstraints.size(), full.chiralConstraints.size());
+    BOOST_CHECK_EQUAL(overlaid->dihedralConstraints.size(), full.dihedralConstraints.size());
+  }
+
+  // Conformer generation through the shared model succeeds
+  const auto ensemble = generateEnsemble(mol, 4, 1042);
+  BOOST_CHECK(Temple::all_of(ensemble, [](const auto& result) { return static_cast<bool>(result); }));
+}
+
+BOOST_AUTO_TEST_CASE(DeferredHydrogens, *boost::unit_test::label("DG")) {
+  const Molecule mol = IO::Experimental::parseSmilesSingleMolecule("CC(C)C[C@H](N)C(=O)O");
+  DistanceGeometry::Configuration configuration;
+  configuration.deferHydrogens = true;
+
+  // The stereocenter's hydrogen is part of its chiral constraints
+  const auto data = DistanceGeometry::gatherDGInformation(mol, configuration);
+  const auto hydrogens = DistanceGeometry::Detail::deferrableHydrogens(mol.graph().inner(), data);
+  BOOST_CHECK(!hydrogens.empty());
+  for(const AtomIndex h : hydrogens) {
+    BOOST_CHECK(mol.graph().elementType(h) == Scine::Utils::ElementType::H);
+    BOOST_CHECK_EQUAL(mol.graph().degree(h), 1);
+    BOOST_CHECK(*mol.graph().adjacents(h).begin() != 4);
+  }
+
+  const auto ensemble = generateEnsemble(mol, 4, 1042, configuration);
+  for(const auto& result : ensemble) {
+    BOOST_REQUIRE_MESSAGE(result, "Conformer generation with deferred hydrogens failed");
+
+    // Placed hydrogens are refined to sensible bond lengths
+    for(const AtomIndex h : hydrogens) {
+      const AtomIndex anchor = *mol.graph().adjacents(h).begin();
+      const double bondLength = (
+        result.value().row(h) - result.value().row(anchor)
+      ).norm() * Scine::Utils::Constants::angstrom_per_bohr;
+      BOOST_CHECK_MESSAGE(
+        bondLength > 0.8 && bondLength < 1.3,
+        "Hydrogen " << h << " is " << bondLength << " angstrom from its anchor"
+      );
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(FragmentedEmbedding, *boost::unit_test::label("DG")) {
+  // Two rings joined by a chain
+  const Molecule mol = IO::Experimental::parseSmilesSingleMolecule("c1ccccc1CCCCCCc1ccccc1");
+  const unsigned N = mol.graph().N();
+  const unsigned fragmentSize = 12;
+
+  const auto fragments = DistanceGeometry::Detail::fragment(mol.graph().inner(), {}, fragmentSize);
+  BOOST_CHECK_GT(fragments.size(), 1);
+  std::vector<unsigned> fragmentCounts(N, 0);
+  for(const auto& fragment : fragments) {
+    BOOST_CHECK(std::is_sorted(std::begin(fragment), std::end(fragment)));
+    for(const AtomIndex i : fragment) {
+      ++fragmentCounts.at(i);
+    }
+  }
+  BOOST_CHECK(Temple::all_of(fragmentCounts, [](const unsigned count) { return count > 0; }));
+
+  // Rings are not split
+  const std::vector<AtomIndex> ring {0, 1, 2, 3, 4, 5};
+  BOOST_CHECK(
+    Temple::any_of(fragments, [&](const auto& fragment) {
+      return std::includes(
+        std::begin(fragment),
+        std::end(fragment),
+        std::begin(ring),
+        std::end(ring)
+      );
+    })
+  );
+
+  for(const bool deferHydrogens : {false, true}) {
+    DistanceGeometry::Configuration configuration;
+    configuration.fragmentSize = fragmentSize;
+    configuration.deferHydrogens = deferHydrogens;
+    const auto ensemble = generateEnsemble(mol, 4, 1042, configuration);
+    BOOST_CHECK_MESSAGE(
+      Temple::all_of(ensemble, [](const auto& result) { return static_cast<bool>(result); }),
+      "Fragmented embedding fails " << (deferHydrogens ? "with" : "without")
+      << " deferred hydrogens"
+    );
+  }
+}
+
+BOOST_AUTO_TEST_CASE(AdaptivePartiality, *boost::unit_test::label("DG")) {
+  using DistanceGeometry::Detail::AdaptivePartiality;
+  const unsigned N = 40;
+
+  // Loose bounds favor few smoothed atoms until they fail
+  AdaptivePartiality loose {DistanceGeometry::DistanceBoundsMatrix {N}};
+  BOOST_CHECK_EQUAL(loose.candidates().front(), 4);
+  BOOST_CHECK_EQUAL(loose.candidates().back(), N);
+  BOOST_CHECK_EQUAL(loose.choose(), 4);
+  for(unsigned i = 0; i < 20; ++i) {
+    loose.record(4, 1.0, false);
+  }
+  BOOST_CHECK_GT(loose.choose(), 4);
+
+  // Tight bounds favor smoothing all atoms
+  Eigen::MatrixXd tightMatrix = Eigen::MatrixXd::Zero(N, N);
+  for(unsigned i = 0; i < N; ++i) {
+    for(unsigned j = i + 1; j < N; ++j) {
+      tightMatrix(i, j) = 2.0;
+      tightMatrix(j, i) = 1.99;
+    }
+  }
+  AdaptivePartiality tight {DistanceGeometry::DistanceBoundsMatrix {tightMatrix}};
+  BOOST_CHECK_EQUAL(tight.choose(), N);
+
+  const Molecule mol = IO::Experimental::parseSmilesSingleMolecule("CC(C)(C)C1CCC(CC1)C(=O)N");
+  DistanceGeometry::Configuration configuration;
+  configuration.partiality = DistanceGeometry::Partiality::Adaptive;
+  const auto ensemble = generateEnsemble(mol, 10, 1042, configuration);
+  BOOST_CHECK(
+    Temple::all_of(ensemble, [](const auto& result) { return static_cast<bool>(result); })
+  );
+}
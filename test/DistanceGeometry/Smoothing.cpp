@@ -36,6 +36,84 @@ BOOST_AUTO_TEST_CASE(TriangleSmoothingFloydExplicit, *boost::unit_test::label("D
   );
 }
 
+BOOST_AUTO_TEST_CASE(TriangleSmoothingThroughAffectedAtoms, *boost::unit_test::label("DG")) {
+  // Chain of five atoms with 1-2 bounds only
+  const unsigned N = 5;
+  Eigen::MatrixXd bounds(N, N);
+  bounds.triangularView<Eigen::StrictlyLower>().setConstant(0.5);
+  bounds.triangularView<Eigen::StrictlyUpper>().setConstant(100.0);
+  bounds.diagonal().setZero();
+  for(unsigned i = 0; i < N - 1; ++i) {
+    bounds(i, i + 1) = 1.5;
+    bounds(i + 1, i) = 1.0;
+  }
+  DistanceBoundsMatrix::smooth(bounds);
+
+  // Tighten the bounds between atoms 0 and 3
+  bounds(0, 3) = 2.0;
+  bounds(3, 0) = 1.8;
+
+  Eigen::MatrixXd fullySmoothed = bounds;
+  DistanceBoundsMatrix::smooth(fullySmoothed);
+  DistanceBoundsMatrix::smooth(bounds, {0, 3});
+
+  BOOST_CHECK_MESSAGE(
+    bounds.isApprox(fullySmoothed, 1e-10),
+    "Smoothing through affected atoms does not match full smoothing: Expected\n"
+    << fullySmoothed << "\nGot:\n" << bounds << "\n"
+  );
+}
+
+BOOST_AUTO_TEST_CASE(TriangleSmoothingBlockedMatchesFloyd, *boost::unit_test::label("DG")) {
+  // Sparse bounds around distances of random points, spanning several tiles
+  const unsigned N = 150;
+  const Eigen::Matrix3Xd positions = 5 * Eigen::Matrix3Xd::Random(3, N);
+  Eigen::MatrixXd bounds(N, N);
+  bounds.diagonal().setZero();
+  for(unsigned i = 0; i < N - 1; ++i) {
+    for(unsigned j = i + 1; j < N; ++j) {
+      if((i + 2 * j) % 7 == 0) {
+        const double distance = (positions.col(i) - positions.col(j)).norm();
+        bounds(i, j) = 1.1 * distance;
+        bounds(j, i) = 0.9 * distance;
+      } else {
+        bounds(i, j) = 100.0;
+        bounds(j, i) = 0.5;
+      }
+    }
+  }
+
+  Eigen::MatrixXd floyd = bounds;
+  DistanceBoundsMatrix::smooth(floyd, DistanceBoundsMatrix::SmoothingAlgorithm::Floyd);
+  DistanceBoundsMatrix::smooth(bounds, DistanceBoundsMatrix::SmoothingAlgorithm::Blocked);
+
+  BOOST_CHECK_MESSAGE(
+    bounds.isApprox(floyd, 1e-10),
+    "Blocked smoothing does not match Floyd's algorithm, max deviation "
+    << (bounds - floyd).cwiseAbs().maxCoeff()
+  );
+
+  Eigen::Matrix4d input;
+  input <<   0.0,   1.0, 100.0,   1.0,
+             1.0,   0.0,   1.0, 100.0,
+             0.5,   1.0,   0.0,   1.0,
+             1.0,   0.5,   1.0,   0.0;
+
+  Eigen::Matrix4d expected;
+  expected << 0.0, 1.0, 2.0, 1.0,
+              1.0, 0.0, 1.0, 2.0,
+              0.5, 1.0, 0.0, 1.0,
+              1.0, 0.5, 1.0, 0.0;
+
+  Eigen::MatrixXd a = input;
+  DistanceBoundsMatrix::smooth(a, DistanceBoundsMatrix::SmoothingAlgorithm::Blocked);
+  BOOST_CHECK_MESSAGE(
+    a.isApprox(expected, 1e-10),
+    "Blocked smoothing of example matrix does not give triangle inequality limits: Expected\n"
+    << expected << "\nGot:\n" << a << "\n"
+  );
+}
+
 BOOST_AUTO_TEST_CASE(TetrangleSmoothingExplicit, *boost::unit_test::label("DG")) {
   Eigen::Matrix4d input;
   input <<   0.0,   1.0, 100.0,   1.0,
@@ -60,6 +138,35 @@ BOOST_AUTO_TEST_CASE(TetrangleSmoothingExplicit, *boost::unit_test::label("DG"))
   );
 }
 
+BOOST_AUTO_TEST_CASE(TetrangleSmoothingParallelExplicit, *boost::unit_test::label("DG")) {
+  Eigen::Matrix4d input;
+  input <<   0.0,   1.0, 100.0,   1.0,
+             1.0,   0.0,   1.0, 100.0,
+             0.5,   1.0,   0.0,   1.0,
+             1.0,   0.5,   1.0,   0.0;
+
+  Eigen::Matrix4d expected;
+  expected << 0.0, 1.0, 2.0, 1.0,
+              1.0, 0.0, 1.0, 2.0,
+              0.5, 1.0, 0.0, 1.0,
+              1.0, 0.5, 1.0, 0.0;
+
+  Eigen::MatrixXd a = input;
+  const unsigned sweeps = tetrangleSmoothParallel(a);
+
+  BOOST_CHECK_MESSAGE(
+    (a.array() <= expected.array()).all(),
+    "Parallel tetrangle smoothing (" << sweeps << " sweeps) of example matrix "
+    << "does not give values smaller than the inequality limits: Expected at most\n"
+    << expected << "\nGot:\n" << a << "\n"
+  );
+  BOOST_CHECK_MESSAGE(
+    (a.triangularView<Eigen::StrictlyLower>().toDenseMatrix().array()
+      <= a.transpose().triangularView<Eigen::StrictlyLower>().toDenseMatrix().array()).all(),
+    "Parallel tetrangle smoothing yields lower bounds exceeding upper bounds:\n" << a
+  );
+}
+
 BOOST_AUTO_TEST_CASE(TriangleSmoothingDetectsViolations, *boost::unit_test::label("DG")) {
   Eigen::Matrix3d impossibleBounds;
   impossibleBounds << 0.0, 1.0, 4.0,
@@ -67,6 +174,13 @@ BOOST_AUTO_TEST_CASE(TriangleSmoothingDetectsViolations, *boost::unit_test::labe
                       4.0, 2.0, 0.0;
 
   BOOST_CHECK_THROW(DistanceBoundsMatrix::smooth(impossibleBounds), std::runtime_error);
+  BOOST_CHECK_THROW(
+    DistanceBoundsMatrix::smooth(
+      impossibleBounds,
+      DistanceBoundsMatrix::SmoothingAlgorithm::Blocked
+    ),
+    std::runtime_error
+  );
 }
 
 BOOST_AUTO_TEST_CASE(TetrangleSmoothingDetectsViolations, *boost::unit_test::label("DG")) {
@@ -11,7 +11,11 @@
 #include "Molassembler/IO.h"
 #include "Molassembler/IO/SmilesParser.h"
 #include "Molassembler/Molecule.h"
+#include "Molassembler/ReactionTemplate.h"
 #include "Molassembler/Graph.h"
+#include "Molassembler/Shapes/Data.h"
+#include "Molassembler/StereopermutatorList.h"
+#include "Molassembler/AtomStereopermutator.h"
 #include "Molassembler/Subgraphs.h"
 
 /* SMILES for molecules imported here
@@ -204,6 +208,61 @@ BOOST_AUTO_TEST_CASE(EditingInsert, *boost::unit_test::label("Molassembler")) {
   );
 }
 
+BOOST_AUTO_TEST_CASE(EditingLocalReranking, *boost::unit_test::label("Molassembler")) {
+  /* Substitution products carry ranking depths, so that cleaving and
+   * inserting into them re-ranks only near the edited bonds. Molecules read
+   * from files do not and are re-ranked everywhere.
+   */
+  Molecule chlorobenzene = IO::read("cbor/chlorobenzene.cbor");
+  Molecule phenole = IO::read("cbor/phenole.cbor");
+  const auto chlorideBond = findEdge(
+    chlorobenzene,
+    makeBondElementsPredicate(chlorobenzene, Utils::ElementType::C, Utils::ElementType::Cl)
+  );
+  const auto hydroxylBond = findEdge(
+    phenole,
+    makeBondElementsPredicate(phenole, Utils::ElementType::C, Utils::ElementType::O)
+  );
+  BOOST_REQUIRE(chlorideBond && hydroxylBond);
+
+  const Molecule substituted = Editing::substitute(chlorobenzene, phenole, *chlorideBond, *hydroxylBond);
+  const Molecule biphenyl = IO::read("cbor/biphenyl.cbor");
+
+  auto findBridge = [](const Molecule& mol) {
+    return findEdge(
+      mol,
+      combineUnaryPredicates<BondIndex>(
+        makeIsBridgePredicate(mol),
+        makeBondElementsPredicate(mol, Utils::ElementType::C, Utils::ElementType::C)
+      )
+    );
+  };
+  const auto substitutedBridge = findBridge(substituted);
+  const auto biphenylBridge = findBridge(biphenyl);
+  BOOST_REQUIRE(substitutedBridge && biphenylBridge);
+
+  const auto localCleave = Editing::cleave(substituted, *substitutedBridge);
+  const auto fullCleave = Editing::cleave(biphenyl, *biphenylBridge);
+  BOOST_CHECK(localCleave.first == fullCleave.first);
+  BOOST_CHECK(localCleave.second == fullCleave.second);
+
+  // Insert the phenyl radicals at their unsaturated carbon
+  auto radical = [](const Molecule& phenyl) -> AtomIndex {
+    for(const AtomIndex i : phenyl.graph().atoms()) {
+      if(phenyl.graph().elementType(i) == Utils::ElementType::C && phenyl.graph().degree(i) == 2) {
+        return i;
+      }
+    }
+    throw std::logic_error("No phenyl radical carbon");
+  };
+  const AtomIndex localRadical = radical(localCleave.first);
+  const AtomIndex fullRadical = radical(fullCleave.first);
+  BOOST_CHECK(
+    Editing::insert(substituted, localCleave.first, *substitutedBridge, localRadical, localRadical)
+    == Editing::insert(biphenyl, fullCleave.first, *biphenylBridge, fullRadical, fullRadical)
+  );
+}
+
 BOOST_AUTO_TEST_CASE(EditingSuperpose, *boost::unit_test::label("Molassembler")) {
   Molecule pyridine = IO::read("cbor/pyridine.cbor");
   pyridine.canonicalize();
@@ -387,6 +446,47 @@ BOOST_AUTO_TEST_CASE(EditingAddMultidentateLigand, *boost::unit_test::label("Mol
   );
 }
 
+BOOST_AUTO_TEST_CASE(EditingAddLigands, *boost::unit_test::label("Molassembler")) {
+  Molecule ligand = IO::read("cbor/multidentate_ligand.cbor");
+  Molecule pyridine = IO::read("cbor/pyridine.cbor");
+  auto NOption = findSingle(ligand, Utils::ElementType::N);
+  auto Ps = findMultiple(ligand, Utils::ElementType::P);
+  auto pyridineNOption = findSingle(pyridine, Utils::ElementType::N);
+  BOOST_REQUIRE(NOption && Ps.size() == 2 && pyridineNOption);
+
+  std::vector<AtomIndex> ligandBindingAtoms = Ps;
+  ligandBindingAtoms.push_back(*NOption);
+
+  const Molecule hydride {
+    Utils::ElementType::Ru,
+    Utils::ElementType::H
+  };
+
+  // Octahedral complex from a tridentate and two monodentate ligands
+  const Molecule complex = Editing::addLigands(
+    hydride,
+    {ligand, pyridine, pyridine},
+    0,
+    {ligandBindingAtoms, {*pyridineNOption}, {*pyridineNOption}}
+  );
+
+  Molecule successive = Editing::addLigand(hydride, ligand, 0, ligandBindingAtoms);
+  successive = Editing::addLigand(successive, pyridine, 0, {*pyridineNOption});
+  successive = Editing::addLigand(successive, pyridine, 0, {*pyridineNOption});
+
+  BOOST_CHECK_EQUAL(complex.graph().N(), successive.graph().N());
+  BOOST_CHECK_EQUAL(complex.graph().B(), successive.graph().B());
+  BOOST_CHECK_EQUAL(complex.graph().degree(0), 6);
+  auto centerOption = complex.stereopermutators().option(0);
+  BOOST_REQUIRE(centerOption);
+  BOOST_CHECK_EQUAL(Shapes::size(centerOption->getShape()), 6);
+
+  BOOST_CHECK_THROW(
+    Editing::addLigands(hydride, {ligand, pyridine}, 0, {ligandBindingAtoms}),
+    std::invalid_argument
+  );
+}
+
 BOOST_AUTO_TEST_CASE(EditingAddHapticLigand, *boost::unit_test::label("Molassembler")) {
   auto ligand = IO::read("cbor/haptic_ligand.cbor");
 
@@ -413,3 +513,152 @@ BOOST_AUTO_TEST_CASE(EditingAddHapticLigand, *boost::unit_test::label("Molassemb
     complex = Editing::addLigand(mol, ligand, 0, ligandBindingAtoms)
   );
 }
+
+BOOST_AUTO_TEST_CASE(EditingBatch, *boost::unit_test::label("Molassembler")) {
+  Molecule chlorobenzene = IO::read("cbor/chlorobenzene.cbor");
+  Molecule phenole = IO::read("cbor/phenole.cbor");
+  const auto chlorideBond = findEdge(
+    chlorobenzene,
+    makeBondElementsPredicate(chlorobenzene, Utils::ElementType::C, Utils::ElementType::Cl)
+  );
+  const auto hydroxylBond = findEdge(
+    phenole,
+    makeBondElementsPredicate(phenole, Utils::ElementType::C, Utils::ElementType::O)
+  );
+  BOOST_REQUIRE(chlorideBond && hydroxylBond);
+
+  const std::vector<Molecule> fragments {phenole, chlorobenzene};
+  const std::vector<BondIndex> fragmentBonds {*hydroxylBond, *chlorideBond};
+  const auto products = Editing::substitute(chlorobenzene, *chlorideBond, fragments, fragmentBonds);
+  BOOST_REQUIRE_EQUAL(products.size(), fragments.size());
+  for(unsigned i = 0; i < fragments.size(); ++i) {
+    BOOST_CHECK(products.at(i) == Editing::substitute(chlorobenzene, fragments.at(i), *chlorideBond, fragmentBonds.at(i)));
+  }
+
+  // Both products are biphenyl
+  const auto constitution = AtomEnvironmentComponents::ElementTypes | AtomEnvironmentComponents::BondOrders;
+  const Molecule biphenyl = IO::read("cbor/biphenyl.cbor");
+  const auto fingerprints = Editing::substituteFingerprints(chlorobenzene, *chlorideBond, fragments, fragmentBonds);
+  BOOST_REQUIRE_EQUAL(fingerprints.size(), fragments.size());
+  for(const Fingerprint& fingerprint : fingerprints) {
+    BOOST_CHECK(fingerprint == biphenyl.invariantFingerprint(constitution));
+  }
+
+  Molecule pyridine = IO::read("cbor/pyridine.cbor");
+  const AtomIndex nitrogen = findSingle(pyridine, Utils::ElementType::N).value();
+  const std::vector<Molecule> pyridines {pyridine, pyridine};
+  const std::vector<AtomIndex> nitrogens {nitrogen, nitrogen};
+  const auto connected = Editing::connect(pyridine, nitrogen, pyridines, nitrogens, BondType::Single);
+  const auto connectedFingerprints = Editing::connectFingerprints(pyridine, nitrogen, pyridines, nitrogens, BondType::Single);
+  BOOST_REQUIRE_EQUAL(connected.size(), 2);
+  BOOST_REQUIRE_EQUAL(connectedFingerprints.size(), 2);
+  for(unsigned i = 0; i < 2; ++i) {
+    BOOST_CHECK(connected.at(i) == Editing::connect(pyridine, pyridine, nitrogen, nitrogen, BondType::Single));
+    BOOST_CHECK(connectedFingerprints.at(i) == connected.at(i).invariantFingerprint(constitution));
+  }
+
+  BOOST_CHECK_THROW(
+    Editing::connect(pyridine, nitrogen, pyridines, {nitrogen}, BondType::Single),
+    std::invalid_argument
+  );
+}
+
+BOOST_AUTO_TEST_CASE(EditingProducts, *boost::unit_test::label("Molassembler")) {
+  Molecule chlorobenzene = IO::read("cbor/chlorobenzene.cbor");
+  Molecule phenole = IO::read("cbor/phenole.cbor");
+  Molecule pyridine = IO::read("cbor/pyridine.cbor");
+  const auto chlorideBond = findEdge(
+    chlorobenzene,
+    makeBondElementsPredicate(chlorobenzene, Utils::ElementType::C, Utils::ElementType::Cl)
+  );
+  const auto hydroxylBond = findEdge(
+    phenole,
+    makeBondElementsPredicate(phenole, Utils::ElementType::C, Utils::ElementType::O)
+  );
+  const auto nitrogen = findSingle(pyridine, Utils::ElementType::N);
+  BOOST_REQUIRE(chlorideBond && hydroxylBond && nitrogen);
+
+  const std::vector<Molecule> cores {chlorobenzene, pyridine};
+  const std::vector<Molecule> fragments {phenole, chlorobenzene, pyridine};
+  using Product = Editing::Product;
+  const std::vector<Product> products {
+    Product::substitution(0, *chlorideBond, 0, *hydroxylBond),
+    Product::substitution(0, *chlorideBond, 1, *chlorideBond),
+    Product::connection(1, *nitrogen, 2, *nitrogen, BondType::Single)
+  };
+
+  const auto constitution = AtomEnvironmentComponents::ElementTypes | AtomEnvironmentComponents::BondOrders;
+  const auto fingerprints = Editing::fingerprints(products, cores, fragments);
+  const auto molecules = Editing::materialize(products, cores, fragments);
+  BOOST_REQUIRE_EQUAL(fingerprints.size(), products.size());
+  BOOST_REQUIRE_EQUAL(molecules.size(), products.size());
+  for(unsigned i = 0; i < products.size(); ++i) {
+    const Product& product = products.at(i);
+    BOOST_CHECK(fingerprints.at(i) == product.fingerprint(cores, fragments));
+    BOOST_CHECK(fingerprints.at(i) == molecules.at(i).invariantFingerprint(constitution));
+    BOOST_CHECK(molecules.at(i) == product.materialize(cores, fragments));
+    BOOST_CHECK_EQUAL(product.graph(cores, fragments).N(), molecules.at(i).graph().N());
+  }
+
+  // Both substitutions yield biphenyl
+  BOOST_CHECK(fingerprints.at(0) == fingerprints.at(1));
+  BOOST_CHECK(fingerprints.at(0) != fingerprints.at(2));
+
+  BOOST_CHECK_THROW(
+    Product::substitution(2, *chlorideBond, 0, *hydroxylBond).graph(cores, fragments),
+    std::out_of_range
+  );
+}
+
+BOOST_AUTO_TEST_CASE(EditingReactionTemplate, *boost::unit_test::label("Molassembler")) {
+  // Keto-enol tautomerism: C(0)=O(1), C(0)-C(2), C(2)-H(3)
+  Molecule pattern {Utils::ElementType::C, Utils::ElementType::O, BondType::Double};
+  const AtomIndex alpha = pattern.addAtom(Utils::ElementType::C, 0);
+  const AtomIndex hydrogen = pattern.addAtom(Utils::ElementType::H, alpha);
+
+  using Edit = ReactionTemplate::Edit;
+  const ReactionTemplate tautomerism {
+    pattern.graph(),
+    {
+      Edit::addBond(1, hydrogen, BondType::Single),
+      Edit::removeBond(alpha, hydrogen),
+      Edit::setBondType(0, 1, BondType::Single),
+      Edit::setBondType(0, alpha, BondType::Double)
+    }
+  };
+
+  auto hasHydroxyl = [](const Molecule& mol) {
+    for(const AtomIndex i : mol.graph().atoms()) {
+      if(mol.graph().elementType(i) == Utils::ElementType::O && mol.graph().degree(i) == 2) {
+        return true;
+      }
+    }
+    return false;
+  };
+
+  // Both methyl groups of acetone yield the same enol
+  const auto acetoneEnols = tautomerism.apply(IO::Experimental::parseSmilesSingleMolecule("CC(=O)C"));
+  BOOST_REQUIRE_EQUAL(acetoneEnols.size(), 1);
+  BOOST_CHECK(hasHydroxyl(acetoneEnols.front()));
+
+  const auto butanoneEnols = tautomerism.apply(IO::Experimental::parseSmilesSingleMolecule("CCC(=O)C"));
+  BOOST_REQUIRE_EQUAL(butanoneEnols.size(), 2);
+  BOOST_CHECK(!(butanoneEnols.front() == butanoneEnols.back()));
+  BOOST_CHECK(hasHydroxyl(butanoneEnols.front()) && hasHydroxyl(butanoneEnols.back()));
+
+  // Removing the hydrogen without a new bond to it disconnects it
+  const ReactionTemplate abstraction {
+    pattern.graph(),
+    {Edit::removeBond(alpha, hydrogen)}
+  };
+  BOOST_CHECK(abstraction.apply(IO::Experimental::parseSmilesSingleMolecule("CC(=O)C")).empty());
+
+  BOOST_CHECK_THROW(
+    ReactionTemplate(pattern.graph(), {Edit::addBond(0, 1, BondType::Single)}),
+    std::invalid_argument
+  );
+  BOOST_CHECK_THROW(
+    ReactionTemplate(pattern.graph(), {Edit::removeBond(1, hydrogen)}),
+    std::invalid_argument
+  );
+}
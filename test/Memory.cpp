@@ -0,0 +1,58 @@
+/*!@file
+ * @copyright This code is licensed under the 3-clause BSD license.
+ *   Copyright ETH Zurich, Laboratory of Physical Chemistry, Reiher Group.
+ *   See LICENSE.txt for details.
+ */
+
+#include <boost/test/unit_test.hpp>
+
+#include "Molassembler/Graph.h"
+#include "Molassembler/IO/SmilesParser.h"
+#include "Molassembler/Memory.h"
+#include "Molassembler/Molecule.h"
+
+using namespace Scine::Molassembler;
+
+BOOST_AUTO_TEST_CASE(MemoryMoleculeFootprint, *boost::unit_test::label("Molassembler")) {
+  const Molecule benzene = IO::Experimental::parseSmilesSingleMolecule("c1ccccc1");
+  // Generate cycle information if it has not been yet
+  benzene.graph().cycles();
+  const Memory::MoleculeFootprint footprint = Memory::footprint(benzene);
+  BOOST_CHECK_GT(footprint.graph, 0);
+  BOOST_CHECK_GT(footprint.cycles, 0);
+  BOOST_CHECK_GT(footprint.stereopermutators, 0);
+  BOOST_CHECK_GT(footprint.ranking, 0);
+  BOOST_CHECK_EQUAL(
+    footprint.total(),
+    footprint.graph + footprint.cycles + footprint.stereopermutators + footprint.ranking
+  );
+
+  const Molecule naphthalene = IO::Experimental::parseSmilesSingleMolecule("c1ccc2ccccc2c1");
+  naphthalene.graph().cycles();
+  BOOST_CHECK_GT(Memory::footprint(naphthalene).total(), footprint.total());
+}
+
+BOOST_AUTO_TEST_CASE(MemoryConformerJobFootprint, *boost::unit_test::label("Molassembler")) {
+  const Molecule small = IO::Experimental::parseSmilesSingleMolecule("CC(F)(Cl)Br");
+  const Molecule large = IO::Experimental::parseSmilesSingleMolecule("CCCCCCCCCCCCCCCCCCCC");
+
+  const Memory::ConformerJobFootprint smallJob = Memory::conformerJobFootprint(small, 10);
+  BOOST_CHECK_GT(smallJob.model, 0);
+  BOOST_CHECK_GT(smallJob.perThread, 0);
+  BOOST_CHECK_GE(smallJob.threads, 1);
+  BOOST_CHECK_LE(smallJob.threads, 10);
+  BOOST_CHECK_GT(smallJob.results, 0);
+  BOOST_CHECK_EQUAL(
+    smallJob.peak(),
+    smallJob.model + smallJob.threads * smallJob.perThread + smallJob.results
+  );
+
+  const Memory::ConformerJobFootprint largeJob = Memory::conformerJobFootprint(large, 10);
+  BOOST_CHECK_GT(largeJob.perThread, smallJob.perThread);
+  BOOST_CHECK_GT(largeJob.results, smallJob.results);
+
+  // Results scale with the number of conformers, per-thread memory does not
+  const Memory::ConformerJobFootprint moreConformers = Memory::conformerJobFootprint(small, 20);
+  BOOST_CHECK_EQUAL(moreConformers.results, 2 * smallJob.results);
+  BOOST_CHECK_EQUAL(moreConformers.perThread, smallJob.perThread);
+}
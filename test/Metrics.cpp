@@ -0,0 +1,70 @@
+/*!@file
+ * @copyright This code is licensed under the 3-clause BSD license.
+ *   Copyright ETH Zurich, Laboratory of Physical Chemistry, Reiher Group.
+ *   See LICENSE.txt for details.
+ */
+
+#include <boost/test/unit_test.hpp>
+
+#include "Molassembler/Conformers.h"
+#include "Molassembler/Graph.h"
+#include "Molassembler/IO/SmilesParser.h"
+#include "Molassembler/Metrics.h"
+#include "Molassembler/Molecule.h"
+
+using namespace Scine::Molassembler;
+
+BOOST_AUTO_TEST_CASE(MetricsTallyOperations, *boost::unit_test::label("Molassembler")) {
+  Metrics::reset();
+  const Metrics::Snapshot empty = Metrics::snapshot();
+  BOOST_CHECK_EQUAL(empty.rankings.count, 0);
+  BOOST_CHECK_EQUAL(empty.rankings.seconds, 0.0);
+  BOOST_CHECK_EQUAL(empty.maxRankingDepth, 0);
+  BOOST_CHECK_EQUAL(empty.sequenceRulesReached.front(), 0);
+  BOOST_CHECK_EQUAL(empty.shapeMeasures.count, 0);
+  BOOST_CHECK(empty.dgFailures.empty());
+
+  const Molecule molecule = IO::Experimental::parseSmilesSingleMolecule("CC(F)(Cl)Br");
+  BOOST_REQUIRE(generateRandomConformation(molecule));
+
+  const Metrics::Snapshot snapshot = Metrics::snapshot();
+  BOOST_CHECK_GT(snapshot.rankings.count, 0);
+  BOOST_CHECK_GT(snapshot.maxRankingDepth, 0);
+  BOOST_CHECK_GT(snapshot.sequenceRulesReached.front(), 0);
+  BOOST_CHECK_GT(snapshot.abstractPermutations.count, 0);
+  BOOST_CHECK_GT(snapshot.feasiblePermutations.count, 0);
+  BOOST_CHECK(snapshot.dgFailures.empty());
+
+  Metrics::reset();
+  BOOST_CHECK_EQUAL(Metrics::snapshot().rankings.count, 0);
+  BOOST_CHECK_EQUAL(Metrics::snapshot().maxRankingDepth, 0);
+}
+
+BOOST_AUTO_TEST_CASE(MetricsRankingWatchdog, *boost::unit_test::label("Molassembler")) {
+  Metrics::reset();
+  BOOST_CHECK_EQUAL(Metrics::rankingWatchdog().seconds, 0.0);
+
+  // Rankings are not reported while the watchdog is off
+  IO::Experimental::parseSmilesSingleMolecule("CC(F)(Cl)Br");
+  BOOST_CHECK(Metrics::snapshot().slowRankings.empty());
+
+  // Any ranking exceeds a nanosecond
+  Metrics::setRankingWatchdog({1e-9, true});
+  BOOST_CHECK(Metrics::rankingWatchdog().graphviz);
+  const Molecule molecule = IO::Experimental::parseSmilesSingleMolecule("CC(F)(Cl)Br");
+  Metrics::setRankingWatchdog({});
+
+  const Metrics::Snapshot snapshot = Metrics::snapshot();
+  BOOST_REQUIRE(!snapshot.slowRankings.empty());
+  BOOST_CHECK_LE(snapshot.slowRankings.size(), Metrics::slowRankingCapacity);
+  for(const Metrics::SlowRanking& report : snapshot.slowRankings) {
+    BOOST_CHECK_LT(report.atom, molecule.graph().N());
+    BOOST_CHECK_GT(report.seconds, 0.0);
+    BOOST_CHECK_GE(report.treeSize, 1);
+    BOOST_CHECK(1 <= report.sequenceRule && report.sequenceRule <= 5);
+    BOOST_CHECK(!report.graphviz.empty());
+  }
+
+  Metrics::reset();
+  BOOST_CHECK(Metrics::snapshot().slowRankings.empty());
+}
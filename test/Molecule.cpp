@@ -21,6 +21,7 @@
 #include "Molassembler/Temple/Stringify.h"
 #include "Molassembler/Temple/Optionals.h"
 
+#include "Molassembler/Descriptors.h"
 #include "Molassembler/Graph.h"
 #include "Molassembler/Graph/PrivateGraph.h"
 #include "Molassembler/IO.h"
@@ -29,18 +30,24 @@
 #include "Molassembler/Isomers.h"
 #include "Molassembler/Molecule.h"
 #include "Molassembler/Molecule/AtomEnvironmentHash.h"
+#include "Molassembler/Modeling/BondDistance.h"
 #include "Molassembler/Options.h"
+#include "Molassembler/PeriodicCell.h"
+#include "Molassembler/AngstromPositions.h"
 #include "Molassembler/AtomStereopermutator.h"
+#include "Molassembler/BondOrders.h"
 #include "Molassembler/BondStereopermutator.h"
 #include "Molassembler/StereopermutatorList.h"
 
 #include "Utils/Geometry/ElementInfo.h"
 #include "Utils/Geometry/AtomCollection.h"
+#include "Utils/Bonds/BondDetector.h"
 #include "Utils/Bonds/BondOrderCollection.h"
 #include "Utils/IO/ChemicalFileFormats/ChemicalFileHandler.h"
 
 #include "Molassembler/Temple/UnorderedSetAlgorithms.h"
 #include <iostream>
+#include <random>
 
 using namespace Scine;
 using namespace Molassembler;
@@ -247,6 +254,41 @@ BOOST_AUTO_TEST_CASE(AtomEnvironmentHashesDoNotCollide, *boost::unit_test::label
   }
 }
 
+// Packed atom environments hash identically to the variable-size arguments
+BOOST_AUTO_TEST_CASE(PackedAtomEnvironmentHashes, *boost::unit_test::label("Molassembler")) {
+  for(unsigned N = 0; N < 1e4; ++N) {
+    const auto arguments = randomArguments();
+
+    Hashes::AtomEnvironment environment;
+    environment.elementType = static_cast<unsigned>(std::get<0>(arguments));
+    environment.numBonds = 0;
+    for(const auto& bond : std::get<1>(arguments)) {
+      environment.bonds.at(environment.numBonds) = static_cast<unsigned>(bond.hash());
+      ++environment.numBonds;
+    }
+    environment.shape = 0;
+    environment.assignment = 0;
+    if(std::get<2>(arguments)) {
+      environment.shape = static_cast<unsigned>(std::get<2>(arguments).value()) + 1;
+      environment.assignment = Temple::Optionals::map(
+        std::get<3>(arguments),
+        [](const unsigned a) { return a + 2; }
+      ).value_or(1);
+    }
+
+    const auto expected = Temple::Detail::invokeHelper(
+      Hashes::hash,
+      std::tuple_cat(std::make_tuple(AtomEnvironmentComponents::All), arguments),
+      std::make_index_sequence<5> {}
+    );
+
+    BOOST_REQUIRE_MESSAGE(
+      environment.hash() == expected,
+      "Packed atom environment hash differs for " << repr(arguments)
+    );
+  }
+}
+
 /* Hashes, stereopermutator lists and graphs are identical across two molecules
  * generated by applying a random permutation to the intermediate data (atoms
  * and BOs) and applying the same permutation via .applyPermutation(perm)
@@ -284,6 +326,22 @@ BOOST_AUTO_TEST_CASE(MoleculeGraphPermutation, *boost::unit_test::label("Molasse
       "Stereopermutator lists for " << currentFilePath.string() << " permuted in two fashions do not match"
     );
 
+    // Permuted stereopermutators are addressable by their new placement
+    std::vector<AtomIndex> placements;
+    for(const auto& permutator : permuted.stereopermutators().atomStereopermutators()) {
+      placements.push_back(permutator.placement());
+      BOOST_CHECK(permuted.stereopermutators().option(permutator.placement()));
+    }
+    BOOST_CHECK(std::is_sorted(std::begin(placements), std::end(placements)));
+    BOOST_CHECK_EQUAL(placements.size(), permuted.stereopermutators().A());
+
+    std::vector<BondIndex> bondPlacements;
+    for(const auto& permutator : permuted.stereopermutators().bondStereopermutators()) {
+      bondPlacements.push_back(permutator.placement());
+      BOOST_CHECK(permuted.stereopermutators().option(permutator.placement()));
+    }
+    BOOST_CHECK(std::is_sorted(std::begin(bondPlacements), std::end(bondPlacements)));
+
     BOOST_CHECK_MESSAGE(
       b.graph().inner().identicalGraph(permuted.graph().inner()),
       "Graphs for " << currentFilePath.string() << " permuted in two fashions do not match"
@@ -392,6 +450,163 @@ BOOST_AUTO_TEST_CASE(MoleculeCanonicalization, *boost::unit_test::label("Molasse
   }
 }
 
+// Batch canonicalization yields the same results as individual calls
+BOOST_AUTO_TEST_CASE(MoleculeBatchCanonicalization, *boost::unit_test::label("Molassembler")) {
+  boost::filesystem::path directoryBase("isomorphisms");
+
+  std::vector<Molecule> molecules;
+  for(
+    const boost::filesystem::path& currentFilePath :
+    boost::filesystem::recursive_directory_iterator(directoryBase)
+  ) {
+    if(currentFilePath.extension() != ".mol") {
+      continue;
+    }
+
+    Molecule a;
+    Molecule b;
+    std::tie(a, b, std::ignore) = readIsomorphism(currentFilePath);
+    molecules.push_back(std::move(a));
+    molecules.push_back(std::move(b));
+  }
+
+  std::vector<Molecule> batch = molecules;
+  const auto batchPermutations = canonicalize(batch);
+  BOOST_REQUIRE_EQUAL(batchPermutations.size(), molecules.size());
+
+  for(unsigned i = 0; i < molecules.size(); ++i) {
+    const auto permutation = molecules.at(i).canonicalize();
+    BOOST_CHECK(permutation == batchPermutations.at(i));
+    BOOST_CHECK(molecules.at(i).graph().inner().identicalGraph(batch.at(i).graph().inner()));
+    BOOST_CHECK(batch.at(i).canonicalComponents() == AtomEnvironmentComponents::All);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(MoleculeFingerprints, *boost::unit_test::label("Molassembler")) {
+  boost::filesystem::path directoryBase("isomorphisms");
+
+  for(
+    const boost::filesystem::path& currentFilePath :
+    boost::filesystem::recursive_directory_iterator(directoryBase)
+  ) {
+    if(currentFilePath.extension() != ".mol") {
+      continue;
+    }
+
+    Molecule a;
+    Molecule b;
+    std::tie(a, b, std::ignore) = readIsomorphism(currentFilePath);
+
+    BOOST_CHECK_MESSAGE(
+      a.invariantFingerprint() == b.invariantFingerprint(),
+      "Invariant fingerprints of isomorphic instances of " << currentFilePath.stem() << " differ"
+    );
+    BOOST_CHECK_MESSAGE(
+      a.fingerprint() == b.fingerprint(),
+      "Fingerprints of isomorphic instances of " << currentFilePath.stem() << " differ"
+    );
+
+    // Fingerprints do not depend on whether the molecule is already canonical
+    const auto components = AtomEnvironmentComponents::ElementTypes | AtomEnvironmentComponents::BondOrders;
+    const Fingerprint acanonical = a.fingerprint(components);
+    a.canonicalize(components);
+    BOOST_CHECK(a.fingerprint(components) == acanonical);
+  }
+
+  // Constitutional isomers are distinguished
+  const Molecule ethanol = IO::Experimental::parseSmilesSingleMolecule("CCO");
+  const Molecule dimethylEther = IO::Experimental::parseSmilesSingleMolecule("COC");
+  BOOST_CHECK(ethanol.fingerprint() != dimethylEther.fingerprint());
+  BOOST_CHECK(ethanol.invariantFingerprint() != dimethylEther.invariantFingerprint());
+  BOOST_CHECK(ethanol.fingerprint() != ethanol.invariantFingerprint());
+}
+
+BOOST_AUTO_TEST_CASE(ConstitutionalFingerprints, *boost::unit_test::label("Molassembler")) {
+  // Fingerprints of edited molecules match those of freshly colored ones
+  auto checkFresh = [](const Molecule& molecule) {
+    const Molecule fresh {molecule.graph()};
+    BOOST_CHECK(molecule.constitutionalFingerprint() == fresh.constitutionalFingerprint());
+  };
+
+  Molecule mol = IO::Experimental::parseSmilesSingleMolecule("CCCCC(C)C1CCC(O)CC1");
+  const Fingerprint original = mol.constitutionalFingerprint();
+
+  const AtomIndex added = mol.addAtom(Utils::ElementType::Cl, 0);
+  checkFresh(mol);
+  mol.setElementType(added, Utils::ElementType::Br);
+  checkFresh(mol);
+  mol.addBond(0, 4);
+  checkFresh(mol);
+  mol.setBondType(0, 4, BondType::Double);
+  checkFresh(mol);
+  mol.removeBond(0, 4);
+  checkFresh(mol);
+  mol.removeAtom(added);
+  checkFresh(mol);
+  BOOST_CHECK(mol.constitutionalFingerprint() == original);
+
+  // Copies continue from the colors of their original
+  Molecule copy = mol;
+  copy.setElementType(copy.addAtom(Utils::ElementType::C, 3), Utils::ElementType::N);
+  checkFresh(copy);
+  BOOST_CHECK(copy.constitutionalFingerprint() != original);
+  BOOST_CHECK(mol.constitutionalFingerprint() == original);
+
+  // Atom order does not matter
+  mol.canonicalize();
+  BOOST_CHECK(mol.constitutionalFingerprint() == original);
+  checkFresh(mol);
+
+  const Molecule ethanol = IO::Experimental::parseSmilesSingleMolecule("CCO");
+  const Molecule dimethylEther = IO::Experimental::parseSmilesSingleMolecule("COC");
+  BOOST_CHECK(ethanol.constitutionalFingerprint() != dimethylEther.constitutionalFingerprint());
+}
+
+BOOST_AUTO_TEST_CASE(MoleculeSignatureIsomorphisms, *boost::unit_test::label("Molassembler")) {
+  boost::filesystem::path directoryBase("isomorphisms");
+
+  std::vector<Molecule> queries;
+  std::vector<Molecule> candidates;
+  for(
+    const boost::filesystem::path& currentFilePath :
+    boost::filesystem::recursive_directory_iterator(directoryBase)
+  ) {
+    if(currentFilePath.extension() != ".mol") {
+      continue;
+    }
+
+    Molecule a;
+    Molecule b;
+    std::tie(a, b, std::ignore) = readIsomorphism(currentFilePath);
+    queries.push_back(std::move(a));
+    candidates.push_back(std::move(b));
+  }
+
+  const unsigned C = candidates.size();
+  for(unsigned i = 0; i < C; ++i) {
+    const auto results = modularIsomorphisms(queries.at(i), candidates);
+    BOOST_REQUIRE_EQUAL(results.size(), C);
+    BOOST_CHECK(results.at(i));
+    for(unsigned j = 0; j < C; ++j) {
+      BOOST_CHECK_EQUAL(
+        static_cast<bool>(results.at(j)),
+        static_cast<bool>(queries.at(i).modularIsomorphism(candidates.at(j), AtomEnvironmentComponents::All))
+      );
+    }
+  }
+
+  // Signatures with different components are not comparable
+  const Molecule ethanol = IO::Experimental::parseSmilesSingleMolecule("CCO");
+  const Molecule dimethylEther = IO::Experimental::parseSmilesSingleMolecule("COC");
+  const InvariantSignature ethanolSignature {ethanol};
+  BOOST_CHECK(!ethanolSignature.compatible(InvariantSignature {dimethylEther}));
+  BOOST_CHECK(!modularIsomorphism(ethanol, ethanolSignature, dimethylEther, InvariantSignature {dimethylEther}));
+  BOOST_CHECK_THROW(
+    ethanolSignature.compatible(InvariantSignature {ethanol, AtomEnvironmentComponents::ElementTypes}),
+    std::logic_error
+  );
+}
+
 BOOST_AUTO_TEST_CASE(MoleculeHashes, *boost::unit_test::label("Molassembler")) {
   boost::filesystem::path directoryBase("isomorphisms");
 
@@ -678,6 +893,470 @@ BOOST_AUTO_TEST_CASE(MoleculeSplitRecognition, *boost::unit_test::label("Molasse
   BOOST_CHECK_MESSAGE(checkSplat(xyzSplat), "Molecule counts for interpret of multi_interpret.xyz failed");
 }
 
+BOOST_AUTO_TEST_CASE(InterpretComponentOrder, *boost::unit_test::label("Molassembler")) {
+  const auto readData = Utils::ChemicalFileHandler::read("multiple_molecules/multi_interpret.mol");
+  const auto& atomCollection = readData.first;
+  const auto result = Interpret::molecules(atomCollection, readData.second);
+
+  // Each component's molecule is at the index the component map assigns it
+  BOOST_REQUIRE_EQUAL(result.molecules.size(), 6);
+  for(unsigned i = 0; i < atomCollection.size(); ++i) {
+    const auto pair = result.componentMap.apply(i);
+    BOOST_REQUIRE_LT(pair.component, result.molecules.size());
+    const Molecule& molecule = result.molecules.at(pair.component);
+    BOOST_REQUIRE_LT(pair.atomIndex, molecule.graph().N());
+    BOOST_CHECK(molecule.graph().elementType(pair.atomIndex) == atomCollection.getElement(i));
+  }
+}
+
+BOOST_AUTO_TEST_CASE(UffBondListMatchesAllPairs, *boost::unit_test::label("Molassembler")) {
+  const auto readData = Utils::ChemicalFileHandler::read("multiple_molecules/multi_interpret.xyz");
+  const auto& atomCollection = readData.first;
+  const Utils::ElementTypeCollection& elements = atomCollection.getElements();
+  const AngstromPositions angstromPositions {atomCollection.getPositions()};
+  const unsigned N = elements.size();
+
+  std::vector<FractionalBond> expected;
+  for(unsigned i = 0; i < N; ++i) {
+    for(unsigned j = i + 1; j < N; ++j) {
+      const double order = Bond::calculateBondOrder(
+        elements.at(i),
+        elements.at(j),
+        (angstromPositions.positions.row(j) - angstromPositions.positions.row(i)).norm()
+      );
+      if(order >= uffMinimumBondOrder) {
+        expected.push_back(FractionalBond {i, j, order});
+      }
+    }
+  }
+
+  const auto bonds = uffBondList(elements, angstromPositions);
+  BOOST_REQUIRE_EQUAL(bonds.size(), expected.size());
+  for(unsigned k = 0; k < bonds.size(); ++k) {
+    BOOST_CHECK_EQUAL(bonds[k].first, expected[k].first);
+    BOOST_CHECK_EQUAL(bonds[k].second, expected[k].second);
+    BOOST_CHECK_CLOSE(bonds[k].order, expected[k].order, 1e-8);
+  }
+
+  BOOST_CHECK_THROW(uffBondList(elements, angstromPositions, 0.0), std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_CASE(CovalentBondDetectorMatchesUtils, *boost::unit_test::label("Molassembler")) {
+  const auto readData = Utils::ChemicalFileHandler::read("multiple_molecules/multi_interpret.xyz");
+  const auto& atomCollection = readData.first;
+  const unsigned N = atomCollection.size();
+  const auto expected = Utils::BondDetector::detectBonds(atomCollection);
+
+  CovalentBondDetector detector {atomCollection.getElements()};
+  AngstromPositions angstromPositions {atomCollection.getPositions()};
+  for(unsigned frame = 0; frame < 2; ++frame) {
+    const auto bonds = detector(angstromPositions);
+    for(unsigned i = 0; i < N; ++i) {
+      for(unsigned j = i + 1; j < N; ++j) {
+        BOOST_CHECK_EQUAL(bonds.getOrder(i, j), expected.getOrder(i, j));
+      }
+    }
+
+    // Translated frames reuse the detector state
+    angstromPositions.positions.rowwise() += Eigen::RowVector3d(1.5, -2.0, 0.5);
+  }
+
+  BOOST_CHECK_THROW(
+    detector(AngstromPositions {Utils::PositionCollection::Zero(N + 1, 3)}),
+    std::invalid_argument
+  );
+}
+
+BOOST_AUTO_TEST_CASE(PeriodicBondPerception, *boost::unit_test::label("Molassembler")) {
+  const auto readData = Utils::ChemicalFileHandler::read("multiple_molecules/multi_interpret.xyz");
+  const auto& atomCollection = readData.first;
+  const Utils::ElementTypeCollection& elements = atomCollection.getElements();
+  const AngstromPositions angstromPositions {atomCollection.getPositions()};
+  const unsigned N = elements.size();
+
+  // Skewed cell with ample vacuum, with the structure wrapped across its faces
+  const Eigen::RowVector3d extent = (
+    angstromPositions.positions.colwise().maxCoeff()
+    - angstromPositions.positions.colwise().minCoeff()
+  );
+  const double length = extent.maxCoeff() + 20.0;
+  Eigen::Matrix3d lattice;
+  lattice << length, 0.0, 0.0,
+    0.3 * length, length, 0.0,
+    0.0, -0.2 * length, length;
+  const PeriodicCell cell {lattice, LengthUnit::Angstrom};
+
+  AngstromPositions wrapped = angstromPositions;
+  for(unsigned i = 0; i < N; ++i) {
+    Eigen::Vector3d fractional = cell.fractional(
+      angstromPositions.positions.row(i).transpose() + Eigen::Vector3d(0.5 * length, 0.4 * length, 0.3 * length)
+    );
+    for(unsigned k = 0; k < 3; ++k) {
+      fractional(k) -= std::floor(fractional(k));
+    }
+    wrapped.positions.row(i) = (lattice.transpose() * fractional).transpose();
+  }
+
+  const auto expected = uffBondList(elements, angstromPositions);
+  const auto bonds = uffBondList(elements, wrapped, cell);
+  BOOST_REQUIRE_EQUAL(bonds.size(), expected.size());
+  for(unsigned k = 0; k < bonds.size(); ++k) {
+    BOOST_CHECK_EQUAL(bonds[k].first, expected[k].first);
+    BOOST_CHECK_EQUAL(bonds[k].second, expected[k].second);
+    BOOST_CHECK_CLOSE(bonds[k].order, expected[k].order, 1e-6);
+  }
+
+  const auto covalent = covalentRadiiBondOrders(elements, angstromPositions);
+  const auto periodicCovalent = covalentRadiiBondOrders(elements, wrapped, cell);
+  for(unsigned i = 0; i < N; ++i) {
+    for(unsigned j = i + 1; j < N; ++j) {
+      BOOST_CHECK_EQUAL(periodicCovalent.getOrder(i, j), covalent.getOrder(i, j));
+    }
+  }
+
+  // Components are assembled from wrapped positions
+  const auto plain = Interpret::molecules(elements, angstromPositions);
+  const auto periodic = Interpret::molecules(elements, wrapped, cell);
+  BOOST_CHECK(periodic.componentMap.map == plain.componentMap.map);
+  BOOST_REQUIRE_EQUAL(periodic.molecules.size(), plain.molecules.size());
+  for(unsigned i = 0; i < plain.molecules.size(); ++i) {
+    BOOST_CHECK(periodic.molecules.at(i) == plain.molecules.at(i));
+  }
+
+  // Minimum images of small cells are ambiguous
+  const PeriodicCell smallCell {Eigen::Matrix3d::Identity() * 2.0, LengthUnit::Angstrom};
+  BOOST_CHECK_THROW(uffBondList(elements, wrapped, smallCell), std::invalid_argument);
+  BOOST_CHECK_THROW(PeriodicCell {Eigen::Matrix3d::Zero()}, std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_CASE(EnsembleInterpretation, *boost::unit_test::label("Molassembler")) {
+  const auto readData = Utils::ChemicalFileHandler::read("multiple_molecules/multi_interpret.xyz");
+  const auto& atomCollection = readData.first;
+  const AngstromPositions angstromPositions {atomCollection.getPositions()};
+  const auto bondOrders = uffBondOrders(atomCollection.getElements(), angstromPositions);
+
+  // The mirror image changes stereodescriptors, but not the topology
+  AngstromPositions mirrored = angstromPositions;
+  mirrored.positions.col(0) *= -1;
+  const std::vector<AngstromPositions> frames {angstromPositions, mirrored};
+
+  const auto result = Interpret::ensemble(atomCollection, bondOrders, frames);
+  BOOST_REQUIRE_EQUAL(result.frames.size(), frames.size());
+  for(unsigned k = 0; k < frames.size(); ++k) {
+    const auto expected = Interpret::molecules(
+      atomCollection.getElements(),
+      frames.at(k),
+      bondOrders
+    );
+    BOOST_CHECK(result.componentMap.map == expected.componentMap.map);
+    BOOST_REQUIRE_EQUAL(result.frames.at(k).size(), expected.molecules.size());
+    for(unsigned i = 0; i < expected.molecules.size(); ++i) {
+      BOOST_CHECK(result.frames.at(k).at(i) == expected.molecules.at(i));
+    }
+  }
+
+  const std::vector<AngstromPositions> mismatched {AngstromPositions {1}};
+  BOOST_CHECK_THROW(Interpret::ensemble(atomCollection, bondOrders, mismatched), std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_CASE(ComponentMapIndex, *boost::unit_test::label("Molassembler")) {
+  const Interpret::ComponentMap componentMap {{0, 1, 1, 0, 2, 1, 0, 2}};
+  const auto index = componentMap.index();
+  BOOST_CHECK_EQUAL(index.components(), 3);
+
+  const auto inverse = componentMap.invert();
+  for(unsigned c = 0; c < inverse.size(); ++c) {
+    const auto atoms = index.atoms(c);
+    BOOST_CHECK(std::vector<unsigned>(atoms.begin(), atoms.end()) == inverse.at(c));
+  }
+
+  for(unsigned i = 0; i < componentMap.size(); ++i) {
+    const auto expected = componentMap.apply(i);
+    const auto pair = index.apply(i);
+    BOOST_CHECK_EQUAL(pair.component, expected.component);
+    BOOST_CHECK_EQUAL(pair.atomIndex, expected.atomIndex);
+    BOOST_CHECK_EQUAL(index.invert(pair), i);
+  }
+
+  BOOST_CHECK_THROW(index.invert({0, 3}), std::out_of_range);
+  BOOST_CHECK_THROW(index.atoms(3), std::out_of_range);
+}
+
+BOOST_AUTO_TEST_CASE(InterpretDeduplication, *boost::unit_test::label("Molassembler")) {
+  auto interpretBoth = [](const Utils::AtomCollection& atoms, const Utils::BondOrderCollection& bondOrders) {
+    const auto plain = Interpret::molecules(
+      atoms,
+      bondOrders,
+      Interpret::BondDiscretizationOption::Binary,
+      1.4,
+      Interpret::ComponentDeduplicationOption::Off
+    );
+    const auto deduplicated = Interpret::molecules(
+      atoms,
+      bondOrders,
+      Interpret::BondDiscretizationOption::Binary,
+      1.4,
+      Interpret::ComponentDeduplicationOption::Constitutional
+    );
+    BOOST_REQUIRE_EQUAL(plain.molecules.size(), deduplicated.molecules.size());
+    for(unsigned i = 0; i < plain.molecules.size(); ++i) {
+      BOOST_CHECK_MESSAGE(
+        plain.molecules.at(i) == deduplicated.molecules.at(i),
+        "Deduplicated interpretation of component " << i << " differs"
+      );
+    }
+    return deduplicated;
+  };
+
+  // Several waters
+  const auto multiData = Utils::ChemicalFileHandler::read("multiple_molecules/multi_interpret.mol");
+  interpretBoth(multiData.first, multiData.second);
+
+  // Two enantiomers and a copy of a stereogenic molecule in the same atom order
+  const auto chiralData = Utils::ChemicalFileHandler::read("stereocenter_detection_molecules/2R-chlorobutane.mol");
+  const unsigned N = chiralData.first.size();
+  Utils::AtomCollection atoms(3 * N);
+  Utils::BondOrderCollection bondOrders(3 * N);
+  for(unsigned copy = 0; copy < 3; ++copy) {
+    for(unsigned i = 0; i < N; ++i) {
+      const unsigned j = copy * N + i;
+      Utils::Position position = chiralData.first.getPosition(i);
+      if(copy == 1) {
+        position.x() *= -1;
+      }
+      position.y() += 20.0 * copy;
+      atoms.setElement(j, chiralData.first.getElement(i));
+      atoms.setPosition(j, position);
+      for(unsigned k = i + 1; k < N; ++k) {
+        bondOrders.setOrder(j, copy * N + k, chiralData.second.getOrder(i, k));
+      }
+    }
+  }
+
+  const auto chiralResult = interpretBoth(atoms, bondOrders);
+  BOOST_REQUIRE_EQUAL(chiralResult.molecules.size(), 3);
+  BOOST_CHECK(chiralResult.molecules.at(0) != chiralResult.molecules.at(1));
+  BOOST_CHECK(chiralResult.molecules.at(0) == chiralResult.molecules.at(2));
+}
+
+BOOST_AUTO_TEST_CASE(InterpretationTiers, *boost::unit_test::label("Molassembler")) {
+  const auto readData = Utils::ChemicalFileHandler::read("stereocenter_detection_molecules/2R-chlorobutane.mol");
+  auto interpretTier = [&](const Interpret::InterpretationTier tier) {
+    const auto result = Interpret::molecules(
+      readData.first,
+      readData.second,
+      Interpret::BondDiscretizationOption::Binary,
+      1.4,
+      Interpret::ComponentDeduplicationOption::Off,
+      tier
+    );
+    BOOST_REQUIRE_EQUAL(result.molecules.size(), 1);
+    return result.molecules.front();
+  };
+
+  const Molecule full = interpretTier(Interpret::InterpretationTier::Full);
+  const Molecule shapes = interpretTier(Interpret::InterpretationTier::Shapes);
+  const Molecule constitution = interpretTier(Interpret::InterpretationTier::Constitution);
+
+  BOOST_CHECK(constitution == Molecule {full.graph()});
+
+  BOOST_CHECK_EQUAL(shapes.stereopermutators().B(), 0);
+  BOOST_CHECK_EQUAL(shapes.stereopermutators().A(), full.stereopermutators().A());
+  for(const AtomStereopermutator& permutator : shapes.stereopermutators().atomStereopermutators()) {
+    BOOST_CHECK(permutator.assigned() == boost::none);
+    const auto fullOption = full.stereopermutators().option(permutator.placement());
+    BOOST_REQUIRE(fullOption);
+    BOOST_CHECK(permutator.getShape() == fullOption->getShape());
+  }
+
+  // Graph-only molecules of equal constitutions are shared
+  const auto waterData = Utils::ChemicalFileHandler::read("multiple_molecules/multi_interpret.mol");
+  const auto plain = Interpret::molecules(
+    waterData.first,
+    waterData.second,
+    Interpret::BondDiscretizationOption::Binary,
+    1.4,
+    Interpret::ComponentDeduplicationOption::Off,
+    Interpret::InterpretationTier::Constitution
+  );
+  const auto deduplicated = Interpret::molecules(
+    waterData.first,
+    waterData.second,
+    Interpret::BondDiscretizationOption::Binary,
+    1.4,
+    Interpret::ComponentDeduplicationOption::Constitutional,
+    Interpret::InterpretationTier::Constitution
+  );
+  BOOST_REQUIRE_EQUAL(plain.molecules.size(), deduplicated.molecules.size());
+  for(unsigned i = 0; i < plain.molecules.size(); ++i) {
+    BOOST_CHECK(plain.molecules.at(i) == deduplicated.molecules.at(i));
+  }
+}
+
+BOOST_AUTO_TEST_CASE(TrajectoryInterpretation, *boost::unit_test::label("Molassembler")) {
+  const auto readData = Utils::ChemicalFileHandler::read("multiple_molecules/multi_interpret.mol");
+  const Utils::ElementTypeCollection elements = readData.first.getElements();
+  AngstromPositions positions {readData.first.getPositions(), LengthUnit::Bohr};
+  Utils::BondOrderCollection bondOrders = readData.second;
+  const unsigned N = elements.size();
+
+  auto matchesFreshInterpretation = [&](const Interpret::MoleculesResult& result) {
+    const auto fresh = Interpret::molecules(elements, positions, bondOrders);
+    BOOST_REQUIRE_EQUAL(result.molecules.size(), fresh.molecules.size());
+    BOOST_CHECK(result.componentMap.map == fresh.componentMap.map);
+    for(unsigned i = 0; i < fresh.molecules.size(); ++i) {
+      BOOST_CHECK_MESSAGE(
+        result.molecules.at(i) == fresh.molecules.at(i),
+        "Trajectory interpretation of component " << i << " differs"
+      );
+    }
+  };
+
+  Interpret::TrajectoryInterpreter interpreter {elements};
+
+  // The first frame is interpreted from scratch
+  matchesFreshInterpretation(interpreter(positions, bondOrders));
+  BOOST_CHECK_EQUAL(interpreter.rebuiltComponents().size(), interpreter.result().molecules.size());
+  const unsigned M = interpreter.result().molecules.size();
+
+  // Identical frames keep all molecules
+  interpreter(positions, bondOrders);
+  BOOST_CHECK(interpreter.rebuiltComponents().empty());
+  BOOST_CHECK(interpreter.refittedComponents().empty());
+  BOOST_CHECK_EQUAL(interpreter.frames(), 2);
+
+  // Moving a component refits only that component
+  for(unsigned i = 0; i < N; ++i) {
+    if(interpreter.result().componentMap.map.at(i) == 0) {
+      positions.positions.row(i) += Eigen::RowVector3d(0.05, -0.02, 0.01);
+    }
+  }
+  matchesFreshInterpretation(interpreter(positions, bondOrders));
+  BOOST_CHECK(interpreter.rebuiltComponents().empty());
+  BOOST_CHECK(interpreter.refittedComponents() == std::vector<unsigned> {0});
+
+  // Weakening a bond within the hysteresis keeps its interpretation
+  unsigned a = 0;
+  unsigned b = 0;
+  for(unsigned i = 0; i < N && b == 0; ++i) {
+    for(unsigned j = i + 1; j < N; ++j) {
+      if(bondOrders.getOrder(i, j) > 0.5) {
+        a = i;
+        b = j;
+        break;
+      }
+    }
+  }
+  BOOST_REQUIRE_GT(b, a);
+  bondOrders.setOrder(a, b, 0.45);
+  interpreter(positions, bondOrders);
+  BOOST_CHECK(interpreter.rebuiltComponents().empty());
+  BOOST_CHECK_EQUAL(interpreter.result().molecules.size(), M);
+
+  // Breaking the bond rebuilds only the components of its atoms
+  bondOrders.setOrder(a, b, 0.3);
+  matchesFreshInterpretation(interpreter(positions, bondOrders));
+  BOOST_CHECK_EQUAL(interpreter.result().molecules.size(), M + 1);
+  BOOST_CHECK_EQUAL(interpreter.rebuiltComponents().size(), 2);
+  BOOST_CHECK(interpreter.refittedComponents().empty());
+
+  BOOST_CHECK_THROW(Interpret::TrajectoryInterpreter(elements, Interpret::BondDiscretizationOption::Binary, 1.4, 0.5), std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_CASE(FalsePositiveRemoval, *boost::unit_test::label("Molassembler")) {
+  // Reference: Re-run both detection schemes from scratch after each removal
+  auto removeOneByOne = [](const Utils::AtomCollection& atoms, Utils::BondOrderCollection bonds) {
+    auto haptics = Interpret::badHapticLigandBonds(atoms, bonds);
+    while(!haptics.empty()) {
+      Temple::sort(haptics);
+      bonds.setOrder(haptics.back().i, haptics.back().j, 0.0);
+      haptics = Interpret::badHapticLigandBonds(atoms, bonds);
+    }
+
+    auto uncertains = Interpret::uncertainBonds(atoms, bonds);
+    while(!uncertains.empty()) {
+      Temple::sort(uncertains);
+      bonds.setOrder(uncertains.back().i, uncertains.back().j, 0.0);
+      uncertains = Interpret::uncertainBonds(atoms, bonds);
+    }
+
+    return bonds;
+  };
+
+  for(const std::string directory : {"inorganics/haptic", "inorganics/agostic"}) {
+    for(
+      const boost::filesystem::path& currentFilePath :
+      boost::filesystem::recursive_directory_iterator(directory)
+    ) {
+      if(currentFilePath.extension() != ".xyz") {
+        continue;
+      }
+
+      const auto atoms = Utils::ChemicalFileHandler::read(currentFilePath.string()).first;
+      const auto bonds = uffBondOrders(
+        atoms.getElements(),
+        AngstromPositions {atoms.getPositions(), LengthUnit::Bohr}
+      );
+
+      const auto sequential = Interpret::removeFalsePositives(atoms, bonds);
+      BOOST_CHECK_MESSAGE(
+        sequential == removeOneByOne(atoms, bonds),
+        "Sequential false positive removal differs from reference for " << currentFilePath.string()
+      );
+
+      const auto batch = Interpret::removeFalsePositives(
+        atoms,
+        bonds,
+        Interpret::FalsePositiveRemovalOption::Batch
+      );
+      BOOST_CHECK_MESSAGE(
+        Interpret::uncertainBonds(atoms, batch).empty(),
+        "Batch false positive removal leaves uncertain bonds for " << currentFilePath.string()
+      );
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(InferStereopermutatorsFromFrames, *boost::unit_test::label("Molassembler")) {
+  std::mt19937 engine {1010};
+  std::normal_distribution<double> noise {0.0, 0.01};
+
+  // Without and with stereogenic atoms, the latter including a mirror image
+  for(const std::string filename : {"isomorphisms/neopentane.mol", "stereocenter_detection_molecules/2R-chlorobutane.mol"}) {
+    const auto readData = Utils::ChemicalFileHandler::read(filename);
+    const Molecule molecule = Interpret::molecules(
+      readData.first,
+      readData.second,
+      Interpret::BondDiscretizationOption::Binary
+    ).molecules.front();
+
+    std::vector<AngstromPositions> frames;
+    for(unsigned f = 0; f < 4; ++f) {
+      Utils::PositionCollection positions = readData.first.getPositions();
+      for(unsigned i = 0; i < positions.rows(); ++i) {
+        for(unsigned j = 0; j < 3; ++j) {
+          positions(i, j) += noise(engine);
+        }
+      }
+      if(f == 3) {
+        positions.col(0) *= -1;
+      }
+      frames.emplace_back(positions);
+    }
+
+    const auto lists = molecule.inferStereopermutatorsFromFrames(frames);
+    BOOST_REQUIRE_EQUAL(lists.size(), frames.size());
+    for(unsigned f = 0; f < frames.size(); ++f) {
+      BOOST_CHECK_MESSAGE(
+        lists.at(f) == molecule.inferStereopermutatorsFromPositions(frames.at(f)),
+        "Stereopermutators of frame " << f << " of " << filename << " differ"
+      );
+    }
+  }
+
+  BOOST_CHECK(Molecule {}.inferStereopermutatorsFromFrames({}).empty());
+}
+
 BOOST_AUTO_TEST_CASE(MoleculeGeometryChoices, *boost::unit_test::label("Molassembler")) {
   Molecule testMol(Utils::ElementType::Ru, Utils::ElementType::N, BondType::Single);
   testMol.addAtom(Utils::ElementType::H, 1U, BondType::Single);
@@ -768,6 +1447,104 @@ BOOST_AUTO_TEST_CASE(IsomerPredicateTests, *boost::unit_test::label("Molassemble
   );
 }
 
+BOOST_AUTO_TEST_CASE(StereoDescriptorPredicates, *boost::unit_test::label("Molassembler")) {
+  const std::vector<std::string> smiles {
+    "CN(C)CCC[C@]1(C2=C(CO1)C=C(C=C2)C#N)C3=CC=C(C=C3)F",
+    "CN(C)CCC[C@@]1(C2=C(CO1)C=C(C=C2)C#N)C3=CC=C(C=C3)F",
+    "CC[C@H](C)[C@@H](C(=O)O)N",
+    "CC[C@@H](C)[C@H](C(=O)O)N",
+    "CC[C@@H](C)[C@@H](C(=O)O)N",
+    "C([C@@H]1[C@H]([C@@H]([C@H]([C@@H](O1)O)O)O)O)O",
+    "C([C@@H]1[C@H]([C@@H]([C@@H]([C@@H](O1)O)O)O)O)O"
+  };
+
+  const auto molecules = Temple::map(smiles, [](const std::string& s) {
+    return IO::Experimental::parseSmilesSingleMolecule(s);
+  });
+  const auto descriptors = Temple::map(molecules, [](const Molecule& m) {
+    return StereoDescriptor {m};
+  });
+
+  // Descriptor predicates must agree with the molecule predicates
+  for(unsigned i = 0; i < molecules.size(); ++i) {
+    for(unsigned j = 0; j < molecules.size(); ++j) {
+      const Molecule& a = molecules.at(i);
+      const Molecule& b = molecules.at(j);
+      const StereoDescriptor& x = descriptors.at(i);
+      const StereoDescriptor& y = descriptors.at(j);
+
+      BOOST_CHECK_MESSAGE(
+        enantiomeric(x, y) == enantiomeric(a, b),
+        "Enantiomerism of descriptors differs for " << smiles.at(i) << " and " << smiles.at(j)
+      );
+      BOOST_CHECK_MESSAGE(
+        diastereomeric(x, y) == diastereomeric(a, b),
+        "Diastereomerism of descriptors differs for " << smiles.at(i) << " and " << smiles.at(j)
+      );
+      BOOST_CHECK_MESSAGE(
+        epimeric(x, y) == epimeric(a, b),
+        "Epimerism of descriptors differs for " << smiles.at(i) << " and " << smiles.at(j)
+      );
+    }
+  }
+
+  BOOST_CHECK(enantiomeric(descriptors.at(0), descriptors.at(1)));
+  BOOST_CHECK(enantiomeric(descriptors.at(2), descriptors.at(3)));
+  BOOST_CHECK(diastereomeric(descriptors.at(2), descriptors.at(4)));
+  BOOST_CHECK(epimeric(descriptors.at(2), descriptors.at(4)));
+  BOOST_CHECK(!enantiomeric(descriptors.at(0), descriptors.at(2)));
+  BOOST_CHECK(diastereomeric(descriptors.at(5), descriptors.at(6)));
+}
+
+BOOST_AUTO_TEST_CASE(StereoisomerEnumeration, *boost::unit_test::label("Molassembler")) {
+  auto countIsomers = [](StereoisomerEnumerator& enumerator) -> unsigned {
+    unsigned count = 0;
+    while(auto isomerOption = enumerator.next()) {
+      const auto& stereopermutators = isomerOption->stereopermutators();
+      BOOST_CHECK(
+        Temple::all_of(
+          stereopermutators.atomStereopermutators(),
+          [](const AtomStereopermutator& p) { return p.assigned() || p.numAssignments() <= 1; }
+        ) && Temple::all_of(
+          stereopermutators.bondStereopermutators(),
+          [](const BondStereopermutator& p) { return p.assigned() || p.numAssignments() <= 1; }
+        )
+      );
+      ++count;
+    }
+    return count;
+  };
+
+  // Stereocenters that are fixed by all automorphisms need no deduplication
+  const std::vector<std::pair<std::string, unsigned>> asymmetric {
+    {"CC(O)CC", 2u},
+    {"C/C=C/CC", 2u},
+    {"CC[C@H](C)[C@@H](C(=O)O)N", 4u}
+  };
+  for(const auto& pair : asymmetric) {
+    StereoisomerEnumerator enumerator {IO::Experimental::parseSmilesSingleMolecule(pair.first)};
+    BOOST_CHECK_MESSAGE(
+      !enumerator.symmetric(),
+      pair.first << " is falsely determined to be symmetric"
+    );
+    BOOST_CHECK_EQUAL(countIsomers(enumerator), pair.second);
+  }
+
+  // Meso forms and symmetric double bonds collapse distinct assignments
+  const std::vector<std::pair<std::string, unsigned>> symmetric {
+    {"C[C@H](O)[C@H](O)C", 3u},
+    {"C/C=C/C", 2u}
+  };
+  for(const auto& pair : symmetric) {
+    StereoisomerEnumerator enumerator {IO::Experimental::parseSmilesSingleMolecule(pair.first)};
+    BOOST_CHECK_MESSAGE(
+      enumerator.symmetric(),
+      pair.first << " is falsely determined not to be symmetric"
+    );
+    BOOST_CHECK_EQUAL(countIsomers(enumerator), pair.second);
+  }
+}
+
 BOOST_AUTO_TEST_CASE(EtaBondDynamism, *boost::unit_test::label("Molassembler")) {
   Molecule mol {Utils::ElementType::Fe, Utils::ElementType::C, BondType::Single};
 
@@ -788,6 +1565,165 @@ BOOST_AUTO_TEST_CASE(EtaBondDynamism, *boost::unit_test::label("Molassembler"))
   BOOST_CHECK(mol.graph().bondType(BondIndex {0, 1}) == BondType::Single);
 }
 
+BOOST_AUTO_TEST_CASE(LocalEditRankingPropagation, *boost::unit_test::label("Molassembler")) {
+  /* After local edits, only some atoms are re-ranked. All stereopermutator
+   * rankings must nonetheless match a fresh ranking.
+   */
+  auto rankingsConsistent = [](const Molecule& mol) -> bool {
+    for(const AtomStereopermutator& permutator : mol.stereopermutators().atomStereopermutators()) {
+      if(permutator.getRanking() != mol.rankPriority(permutator.placement())) {
+        return false;
+      }
+    }
+    return true;
+  };
+
+  // Two pentyl arms at the central carbon are only distinguished at depth five
+  auto mol = IO::Experimental::parseSmilesSingleMolecule("CCCCCC(CCCCC)CCCC");
+  const AtomIndex center = 5;
+  BOOST_REQUIRE(mol.stereopermutators().option(center));
+  const RankingInformation tiedRanking = mol.stereopermutators().option(center)->getRanking();
+  BOOST_CHECK(rankingsConsistent(mol));
+
+  // Distant element change breaks the tie between the arms
+  mol.setElementType(10, Utils::ElementType::Cl);
+  BOOST_CHECK(rankingsConsistent(mol));
+  BOOST_CHECK(mol.stereopermutators().option(center)->getRanking() != tiedRanking);
+
+  const AtomIndex added = mol.addAtom(Utils::ElementType::O, 0, BondType::Single);
+  BOOST_CHECK(rankingsConsistent(mol));
+
+  mol.removeAtom(added);
+  BOOST_CHECK(rankingsConsistent(mol));
+
+  mol.setElementType(10, Utils::ElementType::C);
+  BOOST_CHECK(rankingsConsistent(mol));
+  BOOST_CHECK(mol.stereopermutators().option(center)->getRanking() == tiedRanking);
+}
+
+BOOST_AUTO_TEST_CASE(BatchAtomRemoval, *boost::unit_test::label("Molassembler")) {
+  const auto ethanol = IO::Experimental::parseSmilesSingleMolecule("CCO");
+  auto hydrogensOf = [](const Molecule& mol) {
+    std::vector<AtomIndex> hydrogens;
+    for(const AtomIndex i : mol.graph().atoms()) {
+      if(mol.graph().elementType(i) == Utils::ElementType::H) {
+        hydrogens.push_back(i);
+      }
+    }
+    return hydrogens;
+  };
+
+  // Strip all hydrogen atoms at once, supplied in reverse order
+  auto stripped = ethanol;
+  auto hydrogens = hydrogensOf(stripped);
+  std::reverse(std::begin(hydrogens), std::end(hydrogens));
+  stripped.removeAtoms(hydrogens);
+  BOOST_CHECK_EQUAL(stripped.graph().N(), 3);
+  BOOST_CHECK_EQUAL(stripped.graph().B(), 2);
+  BOOST_CHECK(hydrogensOf(stripped).empty());
+
+  // A methyl group can be removed in one batch, but not atom by atom
+  auto mol = ethanol;
+  std::vector<AtomIndex> methyl {0};
+  for(const AtomIndex i : mol.graph().adjacents(0)) {
+    if(mol.graph().elementType(i) == Utils::ElementType::H) {
+      methyl.push_back(i);
+    }
+  }
+  BOOST_REQUIRE_EQUAL(methyl.size(), 4);
+  BOOST_CHECK(!mol.graph().canRemove(0));
+  mol.removeAtoms(methyl);
+  BOOST_CHECK_EQUAL(mol.graph().N(), ethanol.graph().N() - 4);
+  BOOST_CHECK(mol.graph().inner().connectedComponents() == 1);
+
+  // Invalid batches leave the molecule unchanged
+  auto unchanged = ethanol;
+  BOOST_CHECK_THROW(unchanged.removeAtoms({1}), std::logic_error);
+  BOOST_CHECK_THROW(unchanged.removeAtoms({0, ethanol.graph().N()}), std::out_of_range);
+  std::vector<AtomIndex> all;
+  for(const AtomIndex i : ethanol.graph().atoms()) {
+    all.push_back(i);
+  }
+  BOOST_CHECK_THROW(unchanged.removeAtoms(all), std::logic_error);
+  BOOST_CHECK(unchanged == ethanol);
+}
+
+BOOST_AUTO_TEST_CASE(BatchedEdits, *boost::unit_test::label("Molassembler")) {
+  auto rankingsConsistent = [](const Molecule& mol) -> bool {
+    for(const AtomStereopermutator& permutator : mol.stereopermutators().atomStereopermutators()) {
+      if(permutator.getRanking() != mol.rankPriority(permutator.placement())) {
+        return false;
+      }
+    }
+    return true;
+  };
+
+  // Edits that touch atom zero repeatedly and shift indices by removal
+  const AtomIndex center = 5;
+  auto edit = [&](Molecule& mol) {
+    mol.setElementType(10, Utils::ElementType::Cl);
+    const AtomIndex oxygen = mol.addAtom(Utils::ElementType::O, 0);
+    mol.addAtom(Utils::ElementType::N, 0);
+    mol.removeAtom(oxygen);
+    mol.addAtom(Utils::ElementType::F, center);
+  };
+
+  const auto original = IO::Experimental::parseSmilesSingleMolecule("CCCCCC(CCCCC)CCCC");
+
+  auto immediate = original;
+  edit(immediate);
+
+  auto batched = original;
+  batched.beginEdits();
+  edit(batched);
+  batched.commitEdits();
+
+  BOOST_CHECK(rankingsConsistent(batched));
+  BOOST_CHECK(batched == immediate);
+  BOOST_CHECK(batched.stereopermutators() == immediate.stereopermutators());
+
+  // Committing without a batched edit does nothing
+  batched.commitEdits();
+  BOOST_CHECK(batched.stereopermutators() == immediate.stereopermutators());
+}
+
+BOOST_AUTO_TEST_CASE(CopiesShareGraphUntilModified, *boost::unit_test::label("Molassembler")) {
+  const auto original = IO::Experimental::parseSmilesSingleMolecule("CCO");
+  auto copy = original;
+  BOOST_CHECK(copy.graph().sharesInner(original.graph()));
+  BOOST_CHECK(copy == original);
+
+  copy.setElementType(2, Utils::ElementType::S);
+  BOOST_CHECK(!copy.graph().sharesInner(original.graph()));
+  BOOST_CHECK(original.graph().elementType(2) == Utils::ElementType::O);
+  BOOST_CHECK(copy.graph().elementType(2) == Utils::ElementType::S);
+
+  Molecule assigned;
+  assigned = original;
+  BOOST_CHECK(assigned.graph().sharesInner(original.graph()));
+  assigned.addAtom(Utils::ElementType::Cl, 0);
+  BOOST_CHECK(!assigned.graph().sharesInner(original.graph()));
+  BOOST_CHECK_EQUAL(assigned.graph().N(), original.graph().N() + 1);
+}
+
+BOOST_AUTO_TEST_CASE(CopyOnWriteStereopermutators, *boost::unit_test::label("Molassembler")) {
+  const auto original = IO::Experimental::parseSmilesSingleMolecule("F[C@](Cl)(Br)I");
+  const AtomIndex center = 1;
+  BOOST_REQUIRE(original.stereopermutators().option(center));
+  const auto originalAssignment = original.stereopermutators().option(center)->assigned();
+  BOOST_REQUIRE(originalAssignment);
+
+  auto copy = original;
+  BOOST_CHECK(&copy.stereopermutators() == &original.stereopermutators());
+
+  const unsigned otherAssignment = 1 - originalAssignment.value();
+  copy.assignStereopermutator(center, otherAssignment);
+  BOOST_CHECK(&copy.stereopermutators() != &original.stereopermutators());
+  BOOST_CHECK(copy.stereopermutators().option(center)->assigned() == otherAssignment);
+  BOOST_CHECK(original.stereopermutators().option(center)->assigned() == originalAssignment);
+  BOOST_CHECK(copy != original);
+}
+
 void checkAtomStereopermutator(
   const Molecule& m,
   const AtomIndex i,
@@ -824,3 +1760,114 @@ BOOST_AUTO_TEST_CASE(ShapeClassification, *boost::unit_test::label("Molassembler
   auto trigbipy = IO::read("shape_classification/trig_bipy.mol");
   checkAtomStereopermutator(trigbipy, 0, Shapes::Shape::TrigonalBipyramid);
 }
+
+BOOST_AUTO_TEST_CASE(DescriptorColumnsBatch, *boost::unit_test::label("Molassembler")) {
+  std::vector<Molecule> molecules {
+    IO::Experimental::parseSmilesSingleMolecule("CCO"),
+    IO::Experimental::parseSmilesSingleMolecule("CCCC"),
+    IO::Experimental::parseSmilesSingleMolecule("C1CCCCC1")
+  };
+
+  const DescriptorColumns columns = descriptors(molecules);
+  BOOST_REQUIRE_EQUAL(columns.atoms.size(), 3);
+  BOOST_REQUIRE_EQUAL(columns.molecularWeights.size(), 3);
+  for(unsigned i = 0; i < molecules.size(); ++i) {
+    BOOST_CHECK_EQUAL(columns.atoms(i), molecules.at(i).graph().N());
+    BOOST_CHECK_EQUAL(columns.bonds(i), molecules.at(i).graph().B());
+    BOOST_CHECK_EQUAL(columns.rotatableBonds(i), numRotatableBonds(molecules.at(i)));
+  }
+
+  BOOST_CHECK_EQUAL(columns.heavyAtoms(0), 3);
+  BOOST_CHECK_CLOSE(columns.molecularWeights(0), 46.07, 0.1);
+  // Each C-C bond of butane has non-terminal carbons
+  BOOST_CHECK_EQUAL(columns.rotatableBonds(1), 3);
+  // Six ring bonds contribute (6 - 3) / 6 each
+  BOOST_CHECK_EQUAL(columns.rotatableBonds(2), 3);
+  BOOST_CHECK_EQUAL(columns.cycleFamilies(0), 0);
+  BOOST_CHECK_EQUAL(columns.cycleFamilies(2), 1);
+}
+
+BOOST_AUTO_TEST_CASE(BatchHashes, *boost::unit_test::label("Molassembler")) {
+  std::vector<Molecule> molecules {
+    IO::Experimental::parseSmilesSingleMolecule("CCO"),
+    IO::Experimental::parseSmilesSingleMolecule("OCC"),
+    IO::Experimental::parseSmilesSingleMolecule("CCN")
+  };
+  canonicalize(molecules);
+
+  const std::vector<std::size_t> batch = hashes(molecules);
+  BOOST_REQUIRE_EQUAL(batch.size(), molecules.size());
+  for(unsigned i = 0; i < molecules.size(); ++i) {
+    BOOST_CHECK_EQUAL(batch.at(i), molecules.at(i).hash());
+  }
+  BOOST_CHECK_EQUAL(batch.at(0), batch.at(1));
+}
+
+BOOST_AUTO_TEST_CASE(LazyGraphConstruction, *boost::unit_test::label("Molassembler")) {
+  const auto parsed = IO::Experimental::parseSmilesSingleMolecule("C/C=C/C[C@H](F)Cl");
+  const Molecule eager {parsed.graph()};
+  const auto constitution = AtomEnvironmentComponents::ElementTypes | AtomEnvironmentComponents::BondOrders;
+
+  // Constitution-only queries yield the same as for eager construction
+  auto lazy = Molecule::lazy(parsed.graph());
+  BOOST_CHECK(
+    lazy.invariantFingerprint(constitution)
+    == eager.invariantFingerprint(constitution)
+  );
+  BOOST_CHECK(lazy.modularIsomorphism(eager, constitution));
+
+  auto canonicalEager = eager;
+  const auto eagerPermutation = canonicalEager.canonicalize(constitution);
+  const auto lazyPermutation = lazy.canonicalize(constitution);
+  BOOST_CHECK(lazyPermutation == eagerPermutation);
+  BOOST_CHECK_EQUAL(lazy.hash(), canonicalEager.hash());
+
+  // Stereopermutators are instantiated on first access, also in copies
+  const auto copy = lazy;
+  BOOST_CHECK_EQUAL(copy.stereopermutators().size(), canonicalEager.stereopermutators().size());
+  BOOST_CHECK(&copy.stereopermutators() == &lazy.stereopermutators());
+  BOOST_CHECK(lazy == canonicalEager);
+  BOOST_CHECK(
+    lazy.fingerprint(AtomEnvironmentComponents::All)
+    == canonicalEager.fingerprint(AtomEnvironmentComponents::All)
+  );
+
+  // Modification instantiates stereopermutators before editing
+  auto edited = Molecule::lazy(parsed.graph());
+  auto editedEager = eager;
+  edited.setElementType(5, Utils::ElementType::Br);
+  editedEager.setElementType(5, Utils::ElementType::Br);
+  BOOST_CHECK(edited == editedEager);
+
+  BOOST_CHECK_THROW(
+    Molecule::lazy(Graph {}),
+    std::logic_error
+  );
+}
+
+BOOST_AUTO_TEST_CASE(EqualityCachesCanonicalForms, *boost::unit_test::label("Molassembler")) {
+  const Molecule a = IO::Experimental::parseSmilesSingleMolecule("C/C=C/C[C@H](F)Cl");
+  auto permutation = Temple::iota<AtomIndex>(a.graph().N());
+  Temple::Random::shuffle(permutation, randomnessEngine());
+  Molecule b = a;
+  b.applyPermutation(permutation);
+
+  // Repeated comparisons reuse cached canonical forms and yield the same
+  for(unsigned i = 0; i < 3; ++i) {
+    BOOST_CHECK(a == b);
+    BOOST_CHECK(b == a);
+  }
+
+  // Edits invalidate cached forms
+  Molecule edited = b;
+  BOOST_CHECK(edited == a);
+  edited.setElementType(0, Utils::ElementType::Br);
+  BOOST_CHECK(edited != a);
+  BOOST_CHECK(a == b);
+
+  // Fully canonical molecules are their own canonical form
+  Molecule canonical = b;
+  canonical.canonicalize();
+  BOOST_CHECK(canonical == a);
+  BOOST_CHECK(canonical == b);
+}
@@ -0,0 +1,125 @@
+/*!@file
+ * @copyright This code is licensed under the 3-clause BSD license.
+ *   Copyright ETH Zurich, Laboratory of Physical Chemistry, Reiher Group.
+ *   See LICENSE.txt for details.
+ */
+
+#include <boost/test/unit_test.hpp>
+
+#include "Molassembler/Cancellation.h"
+#include "Molassembler/Parallel.h"
+
+#include <atomic>
+#include <stdexcept>
+#include <vector>
+
+using namespace Scine::Molassembler;
+
+BOOST_AUTO_TEST_CASE(ExecutorsCoverLoops, *boost::unit_test::label("Molassembler")) {
+  const unsigned N = 100;
+  for(const auto& executor : {Parallel::serial(), Parallel::openMP(), Parallel::threads(4)}) {
+    std::vector<std::atomic<unsigned>> calls(N);
+    for(auto& count : calls) {
+      count = 0;
+    }
+
+    Parallel::forEach(*executor, N, [&](const unsigned i, const unsigned worker) {
+      BOOST_CHECK_LT(worker, executor->concurrency());
+      ++calls.at(i);
+    });
+
+    for(const auto& count : calls) {
+      BOOST_CHECK_EQUAL(count.load(), 1);
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(NestedLoopsRunSerially, *boost::unit_test::label("Molassembler")) {
+  Parallel::setExecutor(Parallel::threads(4));
+  BOOST_CHECK(!Parallel::nested());
+
+  std::atomic<unsigned> innerWorkers {0};
+  Parallel::forEach(8, [&](unsigned /* i */, unsigned /* worker */) {
+    BOOST_CHECK(Parallel::nested());
+    BOOST_CHECK_EQUAL(Parallel::executor()->concurrency(), 1);
+    Parallel::forEach(8, [&](unsigned /* j */, const unsigned worker) {
+      innerWorkers += worker;
+    });
+  });
+
+  BOOST_CHECK_EQUAL(innerWorkers.load(), 0);
+  BOOST_CHECK(!Parallel::nested());
+  Parallel::setExecutor(Parallel::openMP());
+}
+
+BOOST_AUTO_TEST_CASE(LoopExceptionsPropagate, *boost::unit_test::label("Molassembler")) {
+  std::atomic<unsigned> calls {0};
+  BOOST_CHECK_THROW(
+    Parallel::forEach(*Parallel::threads(3), 20, [&](const unsigned i, unsigned /* worker */) {
+      ++calls;
+      if(i == 7) {
+        throw std::runtime_error("Body failure");
+      }
+    }),
+    std::runtime_error
+  );
+  BOOST_CHECK_EQUAL(calls.load(), 20);
+  BOOST_CHECK(!Parallel::nested());
+  BOOST_CHECK_THROW(Parallel::setExecutor(nullptr), std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_CASE(LoopsPropagateCancellation, *boost::unit_test::label("Molassembler")) {
+  BOOST_CHECK(!CancellationToken::current().cancelled());
+
+  CancellationToken token;
+  CancellationToken::Scope scope {token};
+  {
+    // Scopes nest
+    CancellationToken inner;
+    inner.cancel();
+    CancellationToken::Scope innerScope {inner};
+    BOOST_CHECK(CancellationToken::current().cancelled());
+  }
+  BOOST_CHECK(!CancellationToken::current().cancelled());
+
+  token.cancel();
+  for(const auto& executor : {Parallel::serial(), Parallel::openMP(), Parallel::threads(4)}) {
+    std::atomic<unsigned> cancelled {0};
+    Parallel::forEach(*executor, 20, [&](unsigned /* i */, unsigned /* worker */) {
+      if(CancellationToken::current().cancelled()) {
+        ++cancelled;
+      }
+    });
+    BOOST_CHECK_EQUAL(cancelled, 20);
+
+    BOOST_CHECK_THROW(
+      Parallel::forEach(*executor, 20, [&](unsigned /* i */, unsigned /* worker */) {
+        CancellationToken::current().check();
+      }),
+      Cancelled
+    );
+  }
+}
+
+BOOST_AUTO_TEST_CASE(WorkerLocalStateIsMadeByWorkers, *boost::unit_test::label("Molassembler")) {
+  const unsigned N = 100;
+  const auto executor = Parallel::threads(4);
+  Parallel::WorkerLocal<std::vector<unsigned>> visited {*executor, std::vector<unsigned> {}};
+
+  std::vector<std::atomic<unsigned>> owners(N);
+  Parallel::forEach(*executor, N, [&](const unsigned i, const unsigned worker) {
+    // Each worker keeps the same state across its bodies
+    std::vector<unsigned>& workerVisited = visited[worker];
+    workerVisited.push_back(i);
+    owners.at(i) = worker;
+  });
+
+  unsigned total = 0;
+  for(unsigned worker = 0; worker < executor->concurrency(); ++worker) {
+    for(const unsigned i : visited[worker]) {
+      BOOST_CHECK_EQUAL(owners.at(i).load(), worker);
+      ++total;
+    }
+  }
+  BOOST_CHECK_EQUAL(total, N);
+}
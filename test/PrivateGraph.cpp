@@ -7,6 +7,9 @@
 #include <boost/test/unit_test.hpp>
 
 #include "Molassembler/Graph/PrivateGraph.h"
+#include "Molassembler/Graph/FrozenGraph.h"
+#include "Molassembler/Graph/GraphAlgorithms.h"
+#include "Molassembler/GraphDistanceMatrix.h"
 
 #include "Molassembler/Temple/Functional.h"
 
@@ -14,6 +17,8 @@
 #include "Molassembler/Molecule.h"
 #include "Molassembler/Graph.h"
 
+#include <thread>
+
 using namespace Scine;
 using namespace Molassembler;
 
@@ -79,3 +84,148 @@ BOOST_AUTO_TEST_CASE(BridgeEdges, *boost::unit_test::label("Molassembler")) {
   BOOST_CHECK(e.graph().adjacent(0, 1));
   BOOST_CHECK(!e.graph().canRemove(BondIndex {0, 1}));
 }
+
+BOOST_AUTO_TEST_CASE(CycleMembership, *boost::unit_test::label("Molassembler")) {
+  // Methylcyclopropane: Ring carbons only
+  auto mol = IO::Experimental::parseSmilesSingleMolecule("CC1CC1");
+  const auto& membership = mol.graph().inner().cycleMembership();
+  BOOST_REQUIRE_EQUAL(membership.size(), mol.graph().N());
+  for(AtomIndex i = 0; i < mol.graph().N(); ++i) {
+    const bool expected = (i == 1 || i == 2 || i == 3);
+    BOOST_CHECK_EQUAL(membership.at(i), expected);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(FrozenGraphSnapshot, *boost::unit_test::label("Molassembler")) {
+  auto mol = IO::Experimental::parseSmilesSingleMolecule("OC(=O)C1CC1C#N");
+  const PrivateGraph& inner = mol.graph().inner();
+  const FrozenGraph frozen = inner.freeze();
+
+  BOOST_REQUIRE_EQUAL(frozen.N(), inner.N());
+  BOOST_REQUIRE_EQUAL(frozen.B(), inner.B());
+  for(AtomIndex i = 0; i < inner.N(); ++i) {
+    BOOST_CHECK(frozen.elementType(i) == inner.elementType(i));
+    BOOST_CHECK_EQUAL(frozen.degree(i), inner.degree(i));
+
+    const auto adjacents = frozen.adjacents(i);
+    BOOST_CHECK(std::is_sorted(std::begin(adjacents), std::end(adjacents)));
+
+    for(AtomIndex j = 0; j < inner.N(); ++j) {
+      const auto edgeOption = inner.edgeOption(i, j);
+      const auto bondTypeOption = frozen.bondType(i, j);
+      BOOST_REQUIRE_EQUAL(static_cast<bool>(edgeOption), static_cast<bool>(bondTypeOption));
+      if(edgeOption) {
+        BOOST_CHECK(inner.bondType(*edgeOption) == *bondTypeOption);
+      }
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(AcyclicEditsKeepCycles, *boost::unit_test::label("Molassembler")) {
+  // Cyclopropane ring with a methyl substituent
+  PrivateGraph graph(4);
+  for(PrivateGraph::Vertex i = 0; i < 4; ++i) {
+    graph.elementType(i) = Utils::ElementType::C;
+  }
+  graph.addEdge(0, 1, BondType::Single);
+  graph.addEdge(1, 2, BondType::Single);
+  graph.addEdge(0, 2, BondType::Single);
+  graph.addEdge(2, 3, BondType::Single);
+
+  const Cycles cycles = graph.cycles();
+  BOOST_REQUIRE_EQUAL(cycles.numCycleFamilies(), 1);
+
+  // Adding a vertex and bonding it as a bridge closes no cycle
+  const auto newVertex = graph.addVertex(Utils::ElementType::C);
+  const auto bridge = graph.addEdge(3, newVertex, BondType::Single);
+  BOOST_CHECK(graph.cycles() == cycles);
+  BOOST_CHECK_EQUAL(graph.cycles().numCycleFamilies(newVertex), 0);
+  BOOST_CHECK(!graph.cycleMembership().at(newVertex));
+
+  // Removing the bridge again does not either
+  graph.removeEdge(bridge);
+  BOOST_CHECK(graph.cycles() == cycles);
+
+  // Element type changes do not affect cycles
+  graph.elementType(3) = Utils::ElementType::N;
+  BOOST_CHECK(graph.cycles() == cycles);
+
+  // Closing a ring recalculates
+  graph.addEdge(1, 3, BondType::Single);
+  BOOST_CHECK(graph.cycles() != cycles);
+  BOOST_CHECK_EQUAL(graph.cycles().numCycleFamilies(), 2);
+  BOOST_CHECK(graph.cycleMembership().at(3));
+}
+
+BOOST_AUTO_TEST_CASE(AllPairsGraphDistances, *boost::unit_test::label("Molassembler")) {
+  // Large enough to need several blocks of sources
+  const auto mol = IO::Experimental::parseSmilesSingleMolecule("C1CCCC(CCCCCCCCCCCCCCCCCCCC)CC1CCCCCCCCCCC");
+  const PrivateGraph& graph = mol.graph().inner();
+  BOOST_REQUIRE_GT(graph.N(), 128);
+
+  const GraphDistanceMatrix& distances = graph.distances();
+  BOOST_REQUIRE_EQUAL(distances.N(), graph.N());
+  for(PrivateGraph::Vertex i = 0; i < graph.N(); ++i) {
+    const auto bfsDistances = GraphAlgorithms::distance(i, graph);
+    for(PrivateGraph::Vertex j = 0; j < graph.N(); ++j) {
+      BOOST_CHECK_EQUAL(distances(i, j), bfsDistances.at(j));
+    }
+  }
+
+  // Truncation at a maximum depth
+  const GraphDistanceMatrix truncated {graph, 2};
+  for(PrivateGraph::Vertex i = 0; i < graph.N(); ++i) {
+    for(PrivateGraph::Vertex j = 0; j < graph.N(); ++j) {
+      if(distances(i, j) <= 2) {
+        BOOST_CHECK_EQUAL(truncated(i, j), distances(i, j));
+      } else {
+        BOOST_CHECK_EQUAL(truncated(i, j), GraphDistanceMatrix::unreachable);
+      }
+    }
+  }
+
+  // Separate components are unreachable
+  PrivateGraph pieces(3);
+  pieces.addEdge(0, 1, BondType::Single);
+  const GraphDistanceMatrix pieceDistances {pieces};
+  BOOST_CHECK_EQUAL(pieceDistances(0, 1), 1);
+  BOOST_CHECK(!pieceDistances.reachable(0, 2));
+  BOOST_CHECK_THROW(pieceDistances.at(0, 3), std::out_of_range);
+}
+
+BOOST_AUTO_TEST_CASE(ConcurrentPropertyGeneration, *boost::unit_test::label("Molassembler")) {
+  const auto mol = IO::Experimental::parseSmilesSingleMolecule("C1CC2CCC1CC2C(=O)NC3CCCCC3");
+  const Molecule copy = mol;
+  const PrivateGraph& graph = mol.graph().inner();
+
+  // No properties are populated beforehand, so the threads race to fill them
+  const unsigned T = 8;
+  std::vector<const void*> addresses(4 * T);
+  std::vector<unsigned> cycleFamilies(T);
+  std::vector<std::thread> threads;
+  for(unsigned t = 0; t < T; ++t) {
+    threads.emplace_back(
+      [&, t]() {
+        const PrivateGraph& inner = (t % 2 == 0 ? mol : copy).graph().inner();
+        addresses[4 * t] = &inner.cycles();
+        addresses[4 * t + 1] = &inner.removalSafetyData();
+        addresses[4 * t + 2] = &inner.distances();
+        addresses[4 * t + 3] = &inner.cycleMembership();
+        cycleFamilies[t] = inner.cycles().numCycleFamilies();
+      }
+    );
+  }
+  for(auto& thread : threads) {
+    thread.join();
+  }
+
+  // Copies share their graph, and each property is generated exactly once
+  for(unsigned t = 1; t < T; ++t) {
+    for(unsigned p = 0; p < 4; ++p) {
+      BOOST_CHECK_EQUAL(addresses[4 * t + p], addresses[p]);
+    }
+    BOOST_CHECK_EQUAL(cycleFamilies[t], cycleFamilies.front());
+  }
+  BOOST_CHECK_EQUAL(addresses.front(), &graph.cycles());
+  BOOST_CHECK_GT(graph.cycles().numCycleFamilies(), 1);
+}
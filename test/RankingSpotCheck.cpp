@@ -28,6 +28,7 @@
 #include "Molassembler/Graph.h"
 #include "Molassembler/Graph/GraphAlgorithms.h"
 #include "Molassembler/IO.h"
+#include "Molassembler/IO/SmilesParser.h"
 #include "Molassembler/Molecule/RankingTree.h"
 #include "Molassembler/StereopermutatorList.h"
 
@@ -453,3 +454,27 @@ BOOST_AUTO_TEST_CASE(SequenceRuleFive, *boost::unit_test::label("Molassembler"))
     "The central stereopermutator in 1s-1-(1R,2R-1,2-dichloropropyl-1S,2R-1,2-dichloropropylamino)1-(1R,2S-1,2-dichloropropyl-1S,2S-1,2-dichloropropylamino)methan-1-ol isn't recognized as S"
   );
 }
+
+BOOST_AUTO_TEST_CASE(StereodescriptorRulesCutoff, *boost::unit_test::label("Molassembler")) {
+  // Isopropanol's methyl groups cannot be distinguished by any sequence rule
+  const Molecule isopropanol = IO::Experimental::parseSmilesSingleMolecule("CC(C)O");
+
+  RankingTree::resetStatistics();
+  const RankingTree centralCarbon {
+    isopropanol.graph(),
+    isopropanol.stereopermutators(),
+    isopropanol.dumpGraphviz(),
+    1
+  };
+
+  const auto ranked = centralCarbon.getRanked();
+  BOOST_REQUIRE_EQUAL(ranked.size(), 3);
+  BOOST_CHECK_EQUAL(ranked.at(1).size(), 2);
+
+  // Without any stereopermutators, sequence rules three to five are skipped
+  const auto statistics = RankingTree::statistics();
+  BOOST_CHECK_EQUAL(statistics.reached.at(0), 1);
+  BOOST_CHECK_EQUAL(statistics.reached.at(1), 1);
+  BOOST_CHECK_EQUAL(statistics.stereodescriptorRulesSkipped, 1);
+  BOOST_CHECK_EQUAL(statistics.reached.at(3), 0);
+}
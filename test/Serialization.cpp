@@ -11,13 +11,17 @@
 #include "Molassembler/Temple/Random.h"
 #include "Molassembler/Temple/Stringify.h"
 
+#include "Molassembler/Graph.h"
 #include "Molassembler/IO.h"
 #include "Molassembler/IO/Base64.h"
+#include "Molassembler/IO/SmilesParser.h"
 #include "Molassembler/Interpret.h"
 #include "Molassembler/Molecule.h"
 #include "Molassembler/Options.h"
 #include "Molassembler/Serialization.h"
+#include "Molassembler/StereopermutatorList.h"
 
+#include "Utils/Constants.h"
 #include "Utils/Geometry/AtomCollection.h"
 #include "Utils/Bonds/BondOrderCollection.h"
 #include "Utils/IO/ChemicalFileFormats/ChemicalFileHandler.h"
@@ -52,6 +56,32 @@ BOOST_AUTO_TEST_CASE(Base64Reversibility, *boost::unit_test::label("Molassembler
   }
 }
 
+BOOST_AUTO_TEST_CASE(Base64Buffers, *boost::unit_test::label("Molassembler")) {
+  // Lengths spanning vectorized blocks and every remainder
+  for(unsigned length = 0; length < 64; ++length) {
+    auto sample = Temple::Random::getN<std::uint8_t>(
+      std::numeric_limits<std::uint8_t>::min(),
+      std::numeric_limits<std::uint8_t>::max(),
+      length,
+      randomnessEngine()
+    );
+
+    std::string encoded(base64::encodedSize(length), '\0');
+    base64::encode(sample.data(), sample.size(), &encoded[0]);
+    BOOST_CHECK_EQUAL(encoded, base64::encode(sample));
+
+    std::vector<std::uint8_t> decoded(base64::decodedSize(encoded.data(), encoded.size()));
+    BOOST_CHECK_EQUAL(decoded.size(), length);
+    BOOST_CHECK_EQUAL(base64::decode(encoded.data(), encoded.size(), decoded.data()), length);
+    BOOST_CHECK(decoded == sample);
+  }
+
+  BOOST_CHECK_EQUAL(base64::encode(std::vector<std::uint8_t> {'M', 'a', 'n'}), "TWFu");
+  BOOST_CHECK_THROW(base64::decode("TWF"), std::runtime_error);
+  BOOST_CHECK_THROW(base64::decode("=WFu"), std::runtime_error);
+  BOOST_CHECK_THROW(base64::decode(std::string(20, 'A') + "!" + std::string(7, 'A')), std::runtime_error);
+}
+
 BOOST_AUTO_TEST_CASE(MoleculeSerializationReversibility, *boost::unit_test::label("Molassembler")) {
   for(
     const boost::filesystem::path& currentFilePath :
@@ -72,6 +102,198 @@ BOOST_AUTO_TEST_CASE(MoleculeSerializationReversibility, *boost::unit_test::labe
   }
 }
 
+BOOST_AUTO_TEST_CASE(CompactSerializationReversibility, *boost::unit_test::label("Molassembler")) {
+  for(
+    const boost::filesystem::path& currentFilePath :
+    boost::filesystem::recursive_directory_iterator("ranking_tree_molecules")
+  ) {
+    auto molecule = IO::read(currentFilePath.string());
+    const auto binary = CompactSerialization::serialize(molecule);
+    const Molecule decoded = CompactSerialization::deserialize(binary);
+
+    BOOST_CHECK_MESSAGE(
+      decoded == molecule,
+      "Compact serialization / deserialization failed for " << currentFilePath.string()
+    );
+
+    // Truncated data must be rejected instead of yielding a molecule
+    const CompactSerialization::BinaryType truncated(
+      std::begin(binary),
+      std::end(binary) - 1
+    );
+    BOOST_CHECK_THROW(CompactSerialization::deserialize(truncated), std::runtime_error);
+  }
+
+  // Canonicalization state is retained, also when read from a file
+  Molecule canonical = IO::Experimental::parseSmilesSingleMolecule("C[C@H](O)CC");
+  canonical.canonicalize();
+  const std::string filename = "compact_serialization_test.masm";
+  IO::write(filename, canonical);
+  const Molecule read = IO::read(filename);
+  boost::filesystem::remove(filename);
+  BOOST_CHECK(read.canonicalComponents() == AtomEnvironmentComponents::All);
+  BOOST_CHECK(read == canonical);
+}
+
+BOOST_AUTO_TEST_CASE(CompactSerializationTrusted, *boost::unit_test::label("Molassembler")) {
+  const auto validation = CompactSerialization::Validation::Checksum;
+  for(const std::string smiles : {"C/C=C/C=C\\C", "C[C@H](O)/C=C/C", "C1CC/C=C/CCC1"}) {
+    const Molecule molecule = IO::Experimental::parseSmilesSingleMolecule(smiles);
+    const auto binary = CompactSerialization::serialize(molecule);
+    const Molecule trusted = CompactSerialization::deserialize(binary, validation);
+    BOOST_CHECK_MESSAGE(
+      trusted == molecule,
+      "Trusted compact deserialization failed for " << smiles
+    );
+    BOOST_CHECK(trusted.stereopermutators().B() == molecule.stereopermutators().B());
+
+    // Any corruption of the payload is caught by the checksum
+    auto corrupted = binary;
+    corrupted.back() ^= 0x1;
+    BOOST_CHECK_THROW(
+      CompactSerialization::deserialize(corrupted, validation),
+      std::runtime_error
+    );
+  }
+}
+
+BOOST_AUTO_TEST_CASE(CompactArchiveRandomAccess, *boost::unit_test::label("Molassembler")) {
+  std::vector<Molecule> molecules;
+  for(
+    const boost::filesystem::path& currentFilePath :
+    boost::filesystem::recursive_directory_iterator("ranking_tree_molecules")
+  ) {
+    molecules.push_back(IO::read(currentFilePath.string()));
+  }
+
+  const std::string filename = "compact_archive_test.masmarc";
+  {
+    CompactArchiveWriter writer {filename};
+    for(unsigned i = 0; i < molecules.size(); ++i) {
+      BOOST_CHECK_EQUAL(writer.add(molecules.at(i)), i);
+    }
+  }
+
+  {
+    const CompactArchive archive {filename};
+    BOOST_REQUIRE_EQUAL(archive.size(), molecules.size());
+
+    // Random access in reverse order
+    for(unsigned i = molecules.size(); i-- > 0;) {
+      BOOST_CHECK(archive.at(i) == molecules.at(i));
+    }
+    BOOST_CHECK_THROW(archive.at(molecules.size()), std::out_of_range);
+
+    // Streaming access
+    unsigned i = 0;
+    for(const Molecule& molecule : archive) {
+      BOOST_CHECK(molecule == molecules.at(i));
+      ++i;
+    }
+    BOOST_CHECK_EQUAL(i, molecules.size());
+  }
+
+  // Truncated archives are rejected
+  {
+    std::ofstream truncated(filename, std::ios::binary | std::ios::trunc);
+    truncated << "MASMARC";
+  }
+  BOOST_CHECK_THROW(CompactArchive {filename}, std::runtime_error);
+
+  boost::filesystem::remove(filename);
+}
+
+BOOST_AUTO_TEST_CASE(ConformerArchivePrecisions, *boost::unit_test::label("Molassembler")) {
+  const Molecule molecule = IO::Experimental::parseSmilesSingleMolecule("C[C@H](O)CC");
+  const unsigned N = molecule.graph().N();
+
+  std::vector<Utils::PositionCollection> conformers;
+  for(unsigned k = 0; k < 5; ++k) {
+    conformers.push_back(5.0 * Utils::PositionCollection::Random(N, 3));
+  }
+
+  const std::string filename = "conformer_archive_test.masmcnf";
+  using Precision = ConformerArchive::Precision;
+  for(const Precision precision : {Precision::Double, Precision::Single, Precision::Quantized}) {
+    ConformerArchive::write(filename, molecule, conformers, precision);
+    const ConformerArchive archive {filename};
+    BOOST_CHECK(archive.molecule() == molecule);
+    BOOST_CHECK(archive.precision() == precision);
+    BOOST_REQUIRE_EQUAL(archive.size(), conformers.size());
+
+    double tolerance = 0.0;
+    switch(precision) {
+      case Precision::Double: tolerance = 0.0; break;
+      case Precision::Single: tolerance = 1e-5; break;
+      case Precision::Quantized: tolerance = archive.quantization().second; break;
+    }
+
+    for(unsigned k = 0; k < conformers.size(); ++k) {
+      const double deviation = (archive.at(k) - conformers.at(k)).cwiseAbs().maxCoeff();
+      BOOST_CHECK_MESSAGE(
+        deviation <= tolerance,
+        "Conformer " << k << " deviates by " << deviation << " at precision "
+          << static_cast<unsigned>(precision)
+      );
+    }
+    BOOST_CHECK_THROW(archive.at(conformers.size()), std::out_of_range);
+
+    if(precision == Precision::Double) {
+      const auto* data = static_cast<const double*>(archive.positionData());
+      BOOST_CHECK_EQUAL(data[3 * N], conformers.at(1)(0, 0));
+    }
+  }
+
+  conformers.emplace_back(Utils::PositionCollection::Zero(N + 1, 3));
+  BOOST_CHECK_THROW(
+    ConformerArchive::write(filename, molecule, conformers),
+    std::invalid_argument
+  );
+
+  boost::filesystem::remove(filename);
+}
+
+BOOST_AUTO_TEST_CASE(BatchSerialization, *boost::unit_test::label("Molassembler")) {
+  std::vector<Molecule> molecules;
+  for(
+    const boost::filesystem::path& currentFilePath :
+    boost::filesystem::recursive_directory_iterator("ranking_tree_molecules")
+  ) {
+    molecules.push_back(IO::read(currentFilePath.string()));
+  }
+  const unsigned M = molecules.size();
+
+  // Batch results must be ordered like their inputs
+  const auto jsonStrings = JsonSerialization::serializeMany(molecules);
+  BOOST_REQUIRE_EQUAL(jsonStrings.size(), M);
+  const auto fromJson = JsonSerialization::deserializeMany(jsonStrings);
+  BOOST_REQUIRE_EQUAL(fromJson.size(), M);
+
+  const auto format = JsonSerialization::BinaryFormat::CBOR;
+  const auto fromCbor = JsonSerialization::deserializeMany(
+    JsonSerialization::serializeMany(molecules, format),
+    format
+  );
+  BOOST_REQUIRE_EQUAL(fromCbor.size(), M);
+
+  const auto compactBinaries = CompactSerialization::serializeMany(molecules);
+  const auto fromCompact = CompactSerialization::deserializeMany(compactBinaries);
+  BOOST_REQUIRE_EQUAL(fromCompact.size(), M);
+
+  for(unsigned i = 0; i < M; ++i) {
+    BOOST_CHECK(jsonStrings.at(i) == std::string(JsonSerialization(molecules.at(i))));
+    BOOST_CHECK(compactBinaries.at(i) == CompactSerialization::serialize(molecules.at(i)));
+    BOOST_CHECK(fromJson.at(i) == molecules.at(i));
+    BOOST_CHECK(fromCbor.at(i) == molecules.at(i));
+    BOOST_CHECK(fromCompact.at(i) == molecules.at(i));
+  }
+
+  // Failures in any conversion propagate
+  auto corrupted = compactBinaries;
+  corrupted.back().pop_back();
+  BOOST_CHECK_THROW(CompactSerialization::deserializeMany(corrupted), std::runtime_error);
+}
+
 // After canonicalization, serializations of identical molecules must be identical
 BOOST_AUTO_TEST_CASE(MoleculeCanonicalSerialization, *boost::unit_test::label("Molassembler")) {
   boost::filesystem::path directoryBase("isomorphisms");
@@ -126,3 +348,133 @@ BOOST_AUTO_TEST_CASE(MoleculeCanonicalSerialization, *boost::unit_test::label("M
     );
   }
 }
+
+// Canonical compact serializations of identical molecules are byte-identical
+BOOST_AUTO_TEST_CASE(CompactCanonicalSerialization, *boost::unit_test::label("Molassembler")) {
+  for(
+    const boost::filesystem::path& currentFilePath :
+    boost::filesystem::recursive_directory_iterator("isomorphisms")
+  ) {
+    if(currentFilePath.extension() != ".mol") {
+      continue;
+    }
+
+    auto readData = Utils::ChemicalFileHandler::read(currentFilePath.string());
+    auto permutedData = IO::shuffle(readData.first, readData.second);
+
+    const Molecule a = Interpret::molecules(
+      readData.first,
+      readData.second,
+      Interpret::BondDiscretizationOption::RoundToNearest
+    ).molecules.front();
+    const Molecule b = Interpret::molecules(
+      std::get<0>(permutedData),
+      std::get<1>(permutedData),
+      Interpret::BondDiscretizationOption::RoundToNearest
+    ).molecules.front();
+
+    const auto aBinary = CompactSerialization::canonicalSerialize(a);
+    const auto bBinary = CompactSerialization::canonicalSerialize(b);
+    BOOST_CHECK_MESSAGE(
+      aBinary == bBinary,
+      "Canonical compact serializations of " << currentFilePath << " are not identical"
+    );
+    BOOST_CHECK(CompactSerialization::digest(aBinary) == CompactSerialization::digest(bBinary));
+
+    // Canonical serializations are read like any other
+    const Molecule decoded = CompactSerialization::deserialize(aBinary);
+    BOOST_CHECK_MESSAGE(
+      decoded == a,
+      "Canonical compact serialization / deserialization failed for " << currentFilePath
+    );
+    BOOST_CHECK(decoded.canonicalComponents() == AtomEnvironmentComponents::All);
+    BOOST_CHECK(CompactSerialization::canonicalSerialize(decoded) == aBinary);
+  }
+
+  // Distinct stereoisomers have distinct digests
+  const auto digest = [](const std::string& smiles) {
+    return CompactSerialization::digest(
+      CompactSerialization::canonicalSerialize(
+        IO::Experimental::parseSmilesSingleMolecule(smiles)
+      )
+    );
+  };
+  BOOST_CHECK(digest("C[C@H](O)CC") == digest("CC[C@@H](O)C"));
+  BOOST_CHECK(digest("C[C@H](O)CC") != digest("C[C@@H](O)CC"));
+
+  const CompactSerialization::BinaryType garbage(32, 0);
+  BOOST_CHECK_THROW(CompactSerialization::digest(garbage), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(XyzTrajectoryReading, *boost::unit_test::label("Molassembler")) {
+  const std::string filename = "xyz_trajectory_test.xyz";
+  {
+    std::ofstream file(filename);
+    file << "2\nfirst frame\nC 0.0 0.0 0.0\nO 1.2 0.0 0.0\n"
+      << "\n"
+      << "2\r\nsecond frame\r\nC 0.0 0.0 0.0\r\nO 0.0 -1.3 0.0\r\n"
+      << "3\ntruncated\nH 0.0 0.0 0.0\n";
+  }
+
+  IO::XyzTrajectoryReader reader {filename};
+  BOOST_REQUIRE(reader.next());
+  BOOST_CHECK_EQUAL(reader.comment(), "first frame");
+  BOOST_CHECK(reader.elements() == (Utils::ElementTypeCollection {Utils::ElementType::C, Utils::ElementType::O}));
+  BOOST_CHECK_CLOSE(reader.positions()(1, 0), 1.2 * Utils::Constants::bohr_per_angstrom, 1e-8);
+
+  // Frames can also be read into external buffers
+  Utils::PositionCollection positions;
+  BOOST_REQUIRE(reader(positions));
+  BOOST_CHECK_EQUAL(reader.comment(), "second frame");
+  BOOST_CHECK_CLOSE(positions(1, 1), -1.3 * Utils::Constants::bohr_per_angstrom, 1e-8);
+  BOOST_CHECK_EQUAL(reader.frames(), 2);
+
+  BOOST_CHECK_THROW(reader.next(), std::runtime_error);
+  boost::filesystem::remove(filename);
+}
+
+BOOST_AUTO_TEST_CASE(AsyncConformerWriting, *boost::unit_test::label("Molassembler")) {
+  const Molecule molecule = IO::Experimental::parseSmilesSingleMolecule("C[C@H](O)CC");
+  const unsigned N = molecule.graph().N();
+
+  std::vector<Utils::PositionCollection> conformers;
+  for(unsigned k = 0; k < 20; ++k) {
+    conformers.push_back(5.0 * Utils::PositionCollection::Random(N, 3));
+  }
+
+  // A small capacity exercises blocking on a full queue
+  const std::string archiveName = "async_conformer_test.masmcnf";
+  const std::string xyzName = "async_conformer_test.xyz";
+  {
+    IO::AsyncConformerWriter archiveWriter {archiveName, molecule, IO::AsyncConformerWriter::Format::Archive, 2};
+    IO::AsyncConformerWriter xyzWriter {xyzName, molecule, IO::AsyncConformerWriter::Format::Xyz, 2};
+    for(unsigned k = 0; k < conformers.size(); ++k) {
+      archiveWriter.add(conformers.at(k));
+      xyzWriter.add(conformers.at(k), "Conformer " + std::to_string(k));
+    }
+    BOOST_CHECK_THROW(archiveWriter.add(Utils::PositionCollection::Zero(N + 1, 3)), std::invalid_argument);
+    archiveWriter.close();
+    BOOST_CHECK_THROW(archiveWriter.add(conformers.front()), std::logic_error);
+    // xyzWriter is closed on destruction
+  }
+
+  const ConformerArchive archive {archiveName};
+  BOOST_REQUIRE_EQUAL(archive.size(), conformers.size());
+  for(unsigned k = 0; k < conformers.size(); ++k) {
+    BOOST_CHECK(archive.at(k) == conformers.at(k));
+  }
+
+  IO::XyzTrajectoryReader reader {xyzName};
+  unsigned k = 0;
+  while(reader.next()) {
+    BOOST_REQUIRE_LT(k, conformers.size());
+    BOOST_CHECK_EQUAL(reader.comment(), "Conformer " + std::to_string(k));
+    BOOST_CHECK(reader.elements() == molecule.graph().elementCollection());
+    BOOST_CHECK((reader.positions() - conformers.at(k)).cwiseAbs().maxCoeff() < 1e-8);
+    ++k;
+  }
+  BOOST_CHECK_EQUAL(k, conformers.size());
+
+  boost::filesystem::remove(archiveName);
+  boost::filesystem::remove(xyzName);
+}
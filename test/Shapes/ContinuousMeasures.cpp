@@ -15,7 +15,9 @@
 #include "Molassembler/Temple/Functional.h"
 #include "Molassembler/Temple/Adaptors/Iota.h"
 
+#include <algorithm>
 #include <iostream>
+#include <limits>
 #include "Molassembler/Temple/Stringify.h"
 
 using namespace Scine::Molassembler;
@@ -265,6 +267,44 @@ BOOST_AUTO_TEST_CASE(SquareC4D4PointGroups, *boost::unit_test::label("Shapes"))
   );
 }
 
+BOOST_AUTO_TEST_CASE(PointGroupEvaluatorReuse, *boost::unit_test::label("Shapes")) {
+  /* A trajectory of a slightly distorted square progressively rotating away
+   * from its standard orientation
+   */
+  const Continuous::PositionCollection square = Continuous::normalize(coordinates(Shape::Square));
+  const Eigen::Vector3d axis = Eigen::Vector3d(1, 2, 3).normalized();
+  std::vector<Continuous::PositionCollection> frames;
+  for(unsigned i = 0; i < 12; ++i) {
+    Continuous::PositionCollection frame = Eigen::AngleAxisd(0.1 * i, axis).toRotationMatrix() * square;
+    distort(frame, 0.005);
+    frames.push_back(Continuous::normalize(frame));
+  }
+
+  // Without warm starting, evaluators match the free function
+  Continuous::PointGroupEvaluator cold {PointGroup::D4, false};
+  const std::vector<double> coldValues = cold(frames);
+  BOOST_REQUIRE_EQUAL(coldValues.size(), frames.size());
+  for(unsigned i = 0; i < frames.size(); ++i) {
+    BOOST_CHECK_EQUAL(coldValues.at(i), Continuous::pointGroup(frames.at(i), PointGroup::D4));
+  }
+
+  // Warm started evaluations follow the rotating square
+  Continuous::PointGroupEvaluator warm {PointGroup::D4};
+  for(const auto& frame : frames) {
+    const double value = warm(frame);
+    BOOST_CHECK_MESSAGE(
+      value < 0.01,
+      "Expected warm started D4 CSM of a slightly distorted square below 0.01, got " << value
+    );
+  }
+  BOOST_CHECK(!warm.orientation().isIdentity());
+  for(const double value : warm(frames)) {
+    BOOST_CHECK_LT(value, 0.01);
+  }
+  warm.reset();
+  BOOST_CHECK(warm.orientation().isIdentity());
+}
+
 BOOST_AUTO_TEST_CASE(FixedCnAxis, *boost::unit_test::label("Shapes")) {
   const std::vector<std::pair<Shape, unsigned>> highestOrderAxis {
     {Shape::Bent, 2},
@@ -547,6 +587,189 @@ BOOST_AUTO_TEST_CASE(ShapeMeasuresAlternateAlgorithm, *boost::unit_test::label("
   }
 }
 
+BOOST_AUTO_TEST_CASE(ShapeMeasuresAlternateLargeShapes, *boost::unit_test::label("Shapes")) {
+#ifdef NDEBUG
+  constexpr unsigned testingShapeSizeLimit = 12;
+#else
+  constexpr unsigned testingShapeSizeLimit = 8;
+#endif
+
+  for(const Shape shape : allShapes) {
+    // Cannot use heuristics on fewer than five vertices
+    if(size(shape) < 5 || size(shape) > testingShapeSizeLimit) {
+      continue;
+    }
+
+    auto shapeCoordinates = Continuous::normalize(
+      addOrigin(coordinates(shape))
+    );
+    randomlyRotate(shapeCoordinates);
+    const double rotated = Continuous::shapeAlternateImplementation(shapeCoordinates, shape).measure;
+    BOOST_CHECK_MESSAGE(
+      rotated < 1e-6,
+      "Expected CShM < 1e-6 for rotated coordinates of " << name(shape) << ", but got " << rotated
+    );
+
+    for(unsigned i = 1; i < 5; ++i) {
+      auto distorted = shapeCoordinates;
+      distort(distorted, 0.1 * i);
+      distorted = Continuous::normalize(distorted);
+
+      // The exact minimum over all index mappings cannot exceed the heuristics
+      const double alternate = Continuous::shapeAlternateImplementation(distorted, shape).measure;
+      const double heuristic = Continuous::shapeHeuristics(distorted, shape).measure;
+      BOOST_CHECK_MESSAGE(
+        alternate <= heuristic + 1e-8,
+        "Expected alternate CShM " << alternate << " <= heuristic CShM "
+        << heuristic << " for shape " << name(shape)
+      );
+
+      const double centroidLast = Continuous::shapeAlternateImplementationCentroidLast(distorted, shape).measure;
+      BOOST_CHECK_MESSAGE(
+        alternate <= centroidLast + 1e-8,
+        "Expected alternate CShM " << alternate << " <= centroid-last CShM "
+        << centroidLast << " for shape " << name(shape)
+      );
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(ShapeMeasuresBatch, *boost::unit_test::label("Shapes")) {
+  constexpr unsigned shapeSize = 6;
+  constexpr unsigned positionSets = 8;
+
+  std::vector<Shape> shapes;
+  for(const Shape shape : allShapes) {
+    if(size(shape) == shapeSize) {
+      shapes.push_back(shape);
+    }
+  }
+
+  std::vector<Continuous::PositionCollection> positionsList;
+  for(unsigned i = 0; i < positionSets; ++i) {
+    auto positions = addOrigin(coordinates(shapes.at(i % shapes.size())));
+    distort(positions, 0.1 * (i % 4));
+    positions.col(shapeSize) = Eigen::Vector3d::Zero();
+    positionsList.push_back(Continuous::normalize(positions));
+  }
+
+  const auto batch = Continuous::shapeCentroidLast(positionsList, shapes);
+  BOOST_REQUIRE_EQUAL(batch.size(), positionSets);
+  for(unsigned i = 0; i < positionSets; ++i) {
+    BOOST_REQUIRE_EQUAL(batch.at(i).size(), shapes.size());
+    for(unsigned j = 0; j < shapes.size(); ++j) {
+      const auto single = Continuous::shapeCentroidLast(positionsList.at(i), shapes.at(j));
+      BOOST_CHECK_CLOSE(batch.at(i).at(j).measure, single.measure, 1e-6);
+      BOOST_CHECK(batch.at(i).at(j).mapping == single.mapping);
+    }
+  }
+
+  BOOST_CHECK_THROW(
+    Continuous::shapeCentroidLast(positionsList, {Shape::Octahedron, Shape::Square}),
+    std::logic_error
+  );
+}
+
+template<unsigned S>
+void checkFixedShapeMeasures() {
+  for(const Shape shape : allShapes) {
+    if(size(shape) != S) {
+      continue;
+    }
+
+    auto positions = addOrigin(coordinates(shape));
+    distort(positions, 0.1);
+    positions.col(S) = Eigen::Vector3d::Zero();
+    const Continuous::FixedPositionCollection<S> fixedPositions = positions;
+    const auto normalized = Continuous::normalize(positions);
+    const auto fixedNormalized = Continuous::normalize<S>(fixedPositions);
+    BOOST_CHECK(fixedNormalized.isApprox(normalized));
+
+    for(const Shape target : allShapes) {
+      if(size(target) != S) {
+        continue;
+      }
+
+      const auto dynamic = Continuous::shapeCentroidLast(normalized, target);
+      const auto fixed = Continuous::shapeCentroidLast<S>(fixedNormalized, target);
+      BOOST_CHECK_CLOSE(fixed.measure, dynamic.measure, 1e-6);
+      // Mappings of equal measure may be tied differently
+      BOOST_CHECK(fixed.mapping.back() == Vertex(S));
+      BOOST_CHECK(std::is_permutation(std::begin(fixed.mapping), std::end(fixed.mapping), std::begin(dynamic.mapping)));
+    }
+
+    const auto classification = Continuous::classifyCentroidLast<S>(fixedNormalized);
+    BOOST_CHECK_MESSAGE(
+      classification.first == shape,
+      "Distorted " << name(shape) << " is classified as " << name(classification.first)
+    );
+  }
+
+  BOOST_CHECK_THROW(
+    Continuous::shapeCentroidLast<S>(Continuous::FixedPositionCollection<S>::Zero(), Shape::Line),
+    std::logic_error
+  );
+}
+
+BOOST_AUTO_TEST_CASE(ShapeMeasuresFixedSize, *boost::unit_test::label("Shapes")) {
+  checkFixedShapeMeasures<4>();
+  checkFixedShapeMeasures<6>();
+}
+
+BOOST_AUTO_TEST_CASE(ShapeMeasuresApproximateClassification, *boost::unit_test::label("Shapes")) {
+  for(const Shape shape : allShapes) {
+    const auto positions = addOrigin(coordinates(shape));
+    BOOST_CHECK_SMALL(Continuous::fingerprintDistance(positions, shape), 1e-6);
+  }
+
+  for(const unsigned shapeSize : {4u, 6u}) {
+    std::vector<Shape> shapes;
+    for(const Shape shape : allShapes) {
+      if(size(shape) == shapeSize) {
+        shapes.push_back(shape);
+      }
+    }
+
+    for(const Shape shape : shapes) {
+      auto positions = addOrigin(coordinates(shape));
+      distort(positions, 0.05);
+      positions.col(shapeSize) = Eigen::Vector3d::Zero();
+      const auto normalized = Continuous::normalize(positions);
+
+      const auto candidates = Continuous::shapeCandidates(normalized, shapes, 2, 0.0);
+      BOOST_CHECK_EQUAL(candidates.size(), std::min<std::size_t>(2, shapes.size()));
+
+      const auto approximate = Continuous::classifyApproximate(normalized, shapes);
+      BOOST_CHECK_MESSAGE(
+        approximate.first == shape,
+        "Approximate classification of distorted " << name(shape)
+        << " yields " << name(approximate.first)
+      );
+
+      // An infinite margin forces the exact path over all shapes
+      const auto exact = Continuous::classifyApproximate(
+        normalized,
+        shapes,
+        1,
+        std::numeric_limits<double>::infinity()
+      );
+      const auto exactMeasures = Continuous::shapeCentroidLast({normalized}, shapes).front();
+      const auto minimalIter = std::min_element(
+        std::begin(exactMeasures),
+        std::end(exactMeasures),
+        [](const auto& a, const auto& b) { return a.measure < b.measure; }
+      );
+      BOOST_CHECK(exact.first == shapes.at(minimalIter - std::begin(exactMeasures)));
+      BOOST_CHECK_CLOSE(exact.second.measure, minimalIter->measure, 1e-6);
+    }
+  }
+
+  BOOST_CHECK_THROW(
+    Continuous::classifyApproximate(addOrigin(coordinates(Shape::Octahedron)), {}),
+    std::logic_error
+  );
+}
+
 BOOST_AUTO_TEST_CASE(ShapeMeasuresHeuristics, *boost::unit_test::label("Shapes")) {
 #ifdef NDEBUG
   constexpr unsigned testingShapeSizeLimit = 7;
@@ -681,4 +904,9 @@ BOOST_AUTO_TEST_CASE(MinimumDistortionConstants, *boost::unit_test::label("Shape
   };
 
   Temple::forEach(minimumDistortionConstants, testF);
+
+  // Cached angles are identical to the first calculation
+  const double first = Continuous::minimumDistortionAngle(Shape::Octahedron, Shape::TrigonalPrism);
+  BOOST_CHECK_EQUAL(Continuous::minimumDistortionAngle(Shape::Octahedron, Shape::TrigonalPrism), first);
+  BOOST_CHECK_EQUAL(Continuous::minimumDistortionAngle(Shape::Octahedron, Shape::Octahedron), 0);
 }
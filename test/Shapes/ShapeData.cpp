@@ -5,6 +5,7 @@
  */
 
 #include <boost/test/unit_test.hpp>
+#include <boost/filesystem.hpp>
 #include <Eigen/Geometry>
 
 #include "Molassembler/Temple/Adaptors/AllPairs.h"
@@ -21,6 +22,7 @@
 #include "Molassembler/Shapes/PropertyCaching.h"
 #include "Molassembler/Shapes/Data.h"
 
+#include <fstream>
 #include <set>
 #include <numeric>
 #include <iostream>
@@ -768,3 +770,103 @@ BOOST_AUTO_TEST_CASE(DimensionalityProperty, *boost::unit_test::label("Shapes"))
   BOOST_CHECK(!threeDimensional(Shape::Hexagon));
   BOOST_CHECK(threeDimensional(Shape::Icosahedron));
 }
+
+BOOST_AUTO_TEST_CASE(RotationGroupOrders, *boost::unit_test::label("Shapes")) {
+  BOOST_CHECK_EQUAL(rotationGroup(Shape::Line).size(), 2);
+  BOOST_CHECK_EQUAL(rotationGroup(Shape::Tetrahedron).size(), 12);
+  BOOST_CHECK_EQUAL(rotationGroup(Shape::Square).size(), 8);
+  BOOST_CHECK_EQUAL(rotationGroup(Shape::Octahedron).size(), 24);
+  BOOST_CHECK_EQUAL(rotationGroup(Shape::Cube).size(), 24);
+  BOOST_CHECK_EQUAL(rotationGroup(Shape::Icosahedron).size(), 60);
+
+  // Each group contains the identity and is closed under composition
+  for(const Shape shape : allShapes) {
+    const auto& group = rotationGroup(shape);
+    const std::set<std::vector<Vertex>> elements(std::begin(group), std::end(group));
+    BOOST_CHECK_EQUAL(elements.size(), group.size());
+    BOOST_CHECK(elements.count(Temple::iota<Vertex>(size(shape))) == 1);
+
+    for(const auto& a : group) {
+      for(const auto& b : group) {
+        const auto composed = Temple::map(b, [&](const Vertex v) { return a.at(v); });
+        BOOST_CHECK_MESSAGE(
+          elements.count(composed) == 1,
+          "Rotation group of " << name(shape) << " is not closed"
+        );
+      }
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(ConcurrentMappingsAccess, *boost::unit_test::label("Shapes")) {
+  constexpr unsigned repeats = 32;
+  std::vector<const Properties::ShapeTransitionGroup*> addresses(repeats, nullptr);
+
+  // Concurrent first uses all yield the same kept transition
+#pragma omp parallel for
+  for(unsigned i = 0; i < repeats; ++i) {
+    const auto mapping = getMapping(Shape::SquarePyramid, Shape::Octahedron);
+    if(mapping) {
+      addresses[i] = &mapping.value();
+    }
+  }
+
+  BOOST_REQUIRE(addresses.front() != nullptr);
+  BOOST_CHECK(
+    Temple::all_of(
+      addresses,
+      [&](const auto* address) { return address == addresses.front(); }
+    )
+  );
+
+  BOOST_CHECK_THROW(
+    getMapping(Shape::Octahedron, Shape::SquarePyramid, Vertex(6)),
+    std::out_of_range
+  );
+}
+
+BOOST_AUTO_TEST_CASE(MappingsFileRoundtrip, *boost::unit_test::label("Shapes")) {
+  precomputeMappings(5);
+  const auto expected = getMapping(Shape::Tetrahedron, Shape::TrigonalBipyramid);
+  BOOST_REQUIRE(expected);
+
+  const boost::filesystem::path path = (
+    boost::filesystem::temp_directory_path()
+    / boost::filesystem::unique_path("%%%%-%%%%.masm-transitions")
+  );
+  writeMappings(path.string());
+
+  // All written transitions are already cached, so none are added
+  BOOST_CHECK_EQUAL(loadMappings(path.string()), 0);
+  const auto loaded = getMapping(Shape::Tetrahedron, Shape::TrigonalBipyramid);
+  BOOST_REQUIRE(loaded);
+  BOOST_CHECK(loaded->indexMappings == expected->indexMappings);
+
+  // Malformed files are rejected
+  {
+    std::ofstream file(path.string(), std::ios::binary | std::ios::trunc);
+    file << "not a transitions file";
+  }
+  BOOST_CHECK_THROW(loadMappings(path.string()), std::runtime_error);
+
+  // In-memory data is read like files
+  const std::string truncated = "MASMSTG1";
+  BOOST_CHECK_THROW(loadMappings(truncated.data(), truncated.size()), std::runtime_error);
+
+  boost::filesystem::remove(path);
+}
+
+BOOST_AUTO_TEST_CASE(ShapesOfSizeLookup, *boost::unit_test::label("Shapes")) {
+  unsigned total = 0;
+  for(unsigned shapeSize = 0; shapeSize <= 12; ++shapeSize) {
+    const auto& shapes = shapesOfSize(shapeSize);
+    total += shapes.size();
+    for(const Shape shape : shapes) {
+      BOOST_CHECK_EQUAL(size(shape), shapeSize);
+    }
+    // Order of allShapes is preserved
+    BOOST_CHECK(std::is_sorted(std::begin(shapes), std::end(shapes)));
+  }
+  BOOST_CHECK_EQUAL(total, allShapes.size());
+  BOOST_CHECK(shapesOfSize(100).empty());
+}
@@ -8,6 +8,7 @@
 
 #include "Molassembler/Molecule.h"
 #include "Molassembler/Graph.h"
+#include "Molassembler/IO/SmilesEmitter.h"
 #include "Molassembler/IO/SmilesParser.h"
 
 #include "Molassembler/Temple/Functional.h"
@@ -15,6 +16,8 @@
 
 #include "Fixtures.h"
 
+#include <cstdio>
+#include <fstream>
 #include <iostream>
 
 /* TODO
@@ -256,3 +259,139 @@ BOOST_AUTO_TEST_CASE(SmilesWithMultipleMolecules, *boost::unit_test::label("Mola
     );
   }
 }
+
+BOOST_FIXTURE_TEST_CASE(CanonicalSmiles, LowTemperatureFixture) {
+  // Pairs of smiles for identical molecules emit the same canonical smiles
+  const std::vector<std::pair<std::string, std::string>> identicalPairs {
+    {"C-C-O", "OCC"},
+    {"C1CCCCC1", "C1CCCCC1"},
+    {"C=1CCCCC1", "C1=CCCCC1"},
+    {"[13CH4]", "[13C]([H])([H])([H])[H]"},
+    {"N[C@](Br)(O)C", "Br[C@](O)(N)C"},
+    {"N[C@H](O)C", "[H][C@](N)(O)C"},
+    {"F/C=C/F", R"y(C(\F)=C/F)y"},
+    {R"y(F\C=C/F)y", R"y(C(/F)=C/F)y"},
+    {"S[As@TB1](F)(Cl)(Br)N", "S[As@TB2](Br)(Cl)(F)N"},
+    {"C[Co@](F)(Cl)(Br)(I)S", "F[Co@@](S)(I)(C)(Cl)Br"},
+    {"S[Co@OH5](F)(I)(Cl)(C)Br", "Br[Co@OH9](C)(S)(Cl)(F)I"},
+  };
+
+  for(const auto& pair : identicalPairs) {
+    const Molecule a = IO::Experimental::parseSmilesSingleMolecule(pair.first);
+    const Molecule b = IO::Experimental::parseSmilesSingleMolecule(pair.second);
+    const std::string smiles = IO::Experimental::emitCanonicalSmiles(a);
+    BOOST_CHECK_MESSAGE(
+      smiles == IO::Experimental::emitCanonicalSmiles(b),
+      "Smiles pair " << pair.first << ", " << pair.second << " did not emit the same canonical smiles"
+    );
+
+    // Emitted smiles parse back into the same molecule
+    Molecule roundTrip;
+    BOOST_REQUIRE_NO_THROW(roundTrip = IO::Experimental::parseSmilesSingleMolecule(smiles));
+    BOOST_CHECK_MESSAGE(
+      roundTrip == a,
+      "Emitted smiles " << smiles << " of " << pair.first << " does not parse into the same molecule"
+    );
+    BOOST_CHECK_EQUAL(IO::Experimental::emitCanonicalSmiles(roundTrip), smiles);
+  }
+
+  // Pairs of smiles for different molecules emit different canonical smiles
+  const std::vector<std::pair<std::string, std::string>> differentPairs {
+    {"CCO", "COC"},
+    {"F/C=C/F", R"y(F\C=C/F)y"},
+    {"N[C@](Br)(O)C", "N[C@@](Br)(O)C"},
+  };
+
+  for(const auto& pair : differentPairs) {
+    BOOST_CHECK_MESSAGE(
+      IO::Experimental::emitCanonicalSmiles(IO::Experimental::parseSmilesSingleMolecule(pair.first))
+      != IO::Experimental::emitCanonicalSmiles(IO::Experimental::parseSmilesSingleMolecule(pair.second)),
+      "Smiles pair " << pair.first << ", " << pair.second << " emitted the same canonical smiles"
+    );
+  }
+}
+
+BOOST_AUTO_TEST_CASE(SmilesFileParsing, *boost::unit_test::label("Molassembler")) {
+  const std::string filename = "smiles_file_test.smi";
+  {
+    std::ofstream file(filename);
+    file << "CCO ethanol\n"
+      << "\n"
+      << "C1CC nonsense\r\n"
+      << "C.[NH4+]\tmixture with tabs\n"
+      << "  N[C@@H](C)C(=O)O alanine";
+  }
+
+  std::vector<IO::Experimental::SmilesFileLine> lines;
+  // A chunk size smaller than the number of lines checks ordering across chunks
+  IO::Experimental::parseSmilesFile(
+    filename,
+    [&](IO::Experimental::SmilesFileLine line) {
+      lines.push_back(std::move(line));
+    },
+    2
+  );
+  std::remove(filename.c_str());
+
+  BOOST_REQUIRE_EQUAL(lines.size(), 4);
+  BOOST_CHECK(
+    Temple::map(lines, [](const auto& l) { return l.lineNumber; })
+    == (std::vector<unsigned> {1, 3, 4, 5})
+  );
+
+  BOOST_CHECK_EQUAL(lines[0].title, "ethanol");
+  BOOST_CHECK(lines[0].error.empty());
+  BOOST_REQUIRE_EQUAL(lines[0].molecules.size(), 1);
+  BOOST_CHECK(lines[0].molecules.front() == IO::Experimental::parseSmilesSingleMolecule("OCC"));
+
+  BOOST_CHECK_EQUAL(lines[1].title, "nonsense");
+  BOOST_CHECK(lines[1].molecules.empty());
+  BOOST_CHECK(!lines[1].error.empty());
+
+  BOOST_CHECK_EQUAL(lines[2].title, "mixture with tabs");
+  BOOST_CHECK_EQUAL(lines[2].molecules.size(), 2);
+
+  BOOST_CHECK_EQUAL(lines[3].title, "alanine");
+  BOOST_CHECK_EQUAL(lines[3].molecules.size(), 1);
+
+  BOOST_CHECK_THROW(
+    IO::Experimental::parseSmilesFile("nonexistent.smi", [](IO::Experimental::SmilesFileLine) {}),
+    std::runtime_error
+  );
+}
+
+BOOST_AUTO_TEST_CASE(SmilesConstitutionParsing, *boost::unit_test::label("Molassembler")) {
+  for(const std::string smiles : {"CCO", "C1CC1.[NH4+]", "N[C@@H](C)C(=O)O", "F/C=C/F", "c1ccccc1"}) {
+    const auto molecules = IO::Experimental::parseSmiles(smiles);
+    const auto graphs = IO::Experimental::parseSmilesConstitution(smiles);
+    BOOST_REQUIRE_EQUAL(graphs.size(), molecules.size());
+    for(unsigned i = 0; i < graphs.size(); ++i) {
+      BOOST_CHECK_MESSAGE(
+        graphs.at(i) == molecules.at(i).graph(),
+        "Constitution of " << smiles << " differs from its parsed molecule"
+      );
+    }
+
+    // Failed parses do not leave state behind in the reused parser
+    BOOST_CHECK_THROW(IO::Experimental::parseSmiles("C1CC"), std::runtime_error);
+    BOOST_CHECK(IO::Experimental::parseSmiles(smiles) == molecules);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(SmilesBatchParsing, *boost::unit_test::label("Molassembler")) {
+  const std::vector<std::string> smiles {"CCO", "N[C@@H](C)C(=O)O", "F/C=C/F", "c1ccccc1"};
+  const auto molecules = IO::Experimental::parseSmilesSingleMolecules(smiles);
+  BOOST_REQUIRE_EQUAL(molecules.size(), smiles.size());
+  for(unsigned i = 0; i < smiles.size(); ++i) {
+    BOOST_CHECK(molecules.at(i) == IO::Experimental::parseSmilesSingleMolecule(smiles.at(i)));
+  }
+
+  BOOST_CHECK_THROW(
+    IO::Experimental::parseSmilesSingleMolecules({"CC", "C1CC", "C"}),
+    std::runtime_error
+  );
+  BOOST_CHECK_THROW(
+    IO::Experimental::parseSmilesSingleMolecules({"CC", "C.N"}),
+    std::logic_error
+  );
+}
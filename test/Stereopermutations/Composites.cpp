@@ -601,3 +601,42 @@ BOOST_AUTO_TEST_CASE(CompositeCombinedAlignments, *boost::unit_test::label("Ster
   };
   BOOST_CHECK_EQUAL(bothTriangleTetrahedron.allPermutations().size(), 6);
 }
+
+BOOST_AUTO_TEST_CASE(CompositePermutationsCache, *boost::unit_test::label("Stereopermutations")) {
+  Composite::clearCache();
+  BOOST_CHECK_EQUAL(Composite::cacheSize(), 0);
+
+  const Composite a {
+    Composite::OrientationState {Shapes::Shape::EquilateralTriangle, 0_v, {'A', 'B', 'C'}, 0},
+    Composite::OrientationState {Shapes::Shape::Tetrahedron, 0_v, {'A', 'B', 'C', 'D'}, 1}
+  };
+  BOOST_CHECK_EQUAL(Composite::cacheSize(), 1);
+
+  // Identifiers do not affect permutations and are kept per instance
+  Composite b {
+    Composite::OrientationState {Shapes::Shape::EquilateralTriangle, 0_v, {'A', 'B', 'C'}, 4},
+    Composite::OrientationState {Shapes::Shape::Tetrahedron, 0_v, {'A', 'B', 'C', 'D'}, 7}
+  };
+  BOOST_CHECK_EQUAL(Composite::cacheSize(), 1);
+  BOOST_CHECK(&a.allPermutations() == &b.allPermutations());
+
+  b.applyIdentifierPermutation({0, 1, 2, 3, 9, 5, 6, 8});
+  BOOST_CHECK_EQUAL(b.orientations().first.identifier, 9);
+  BOOST_CHECK_EQUAL(b.orientations().second.identifier, 8);
+  BOOST_CHECK_EQUAL(a.orientations().first.identifier, 0);
+
+  // Differing alignments are cached separately
+  const Composite c {
+    Composite::OrientationState {Shapes::Shape::EquilateralTriangle, 0_v, {'A', 'B', 'C'}, 0},
+    Composite::OrientationState {Shapes::Shape::Tetrahedron, 0_v, {'A', 'B', 'C', 'D'}, 1},
+    Composite::Alignment::Staggered
+  };
+  BOOST_CHECK_EQUAL(Composite::cacheSize(), 2);
+  BOOST_CHECK(&a.allPermutations() != &c.allPermutations());
+
+  // Clearing the cache leaves existing lists intact
+  const unsigned P = a.allPermutations().size();
+  Composite::clearCache();
+  BOOST_CHECK_EQUAL(Composite::cacheSize(), 0);
+  BOOST_CHECK_EQUAL(a.allPermutations().size(), P);
+}
@@ -5,8 +5,10 @@
  */
 
 #include <boost/test/unit_test.hpp>
+#include <boost/filesystem.hpp>
 
 #include <algorithm>
+#include <fstream>
 #include <vector>
 #include <cassert>
 #include <functional>
@@ -451,3 +453,47 @@ BOOST_AUTO_TEST_CASE(numUnlinkedStereopermutationsTest, *boost::unit_test::label
     }
   }
 }
+
+BOOST_AUTO_TEST_CASE(PrecomputedUniques, *boost::unit_test::label("Stereopermutations")) {
+  const auto shape = Shapes::Shape::Octahedron;
+  const Stereopermutation unlinked {{'A', 'A', 'B', 'B', 'C', 'D'}};
+  const Stereopermutation linked {
+    {'A', 'A', 'B', 'B', 'C', 'D'},
+    {{0_v, 1_v}}
+  };
+  const Uniques expectedUnlinked = uniques(unlinked, shape);
+  const Uniques expectedLinked = uniques(linked, shape);
+
+  precomputeUniques(6);
+
+  // Precomputed results are identical to enumerated ones
+  const Uniques precomputed = uniques(unlinked, shape);
+  BOOST_CHECK(precomputed.list == expectedUnlinked.list);
+  BOOST_CHECK(precomputed.weights == expectedUnlinked.weights);
+  const Uniques enumerated = uniques(linked, shape);
+  BOOST_CHECK(enumerated.list == expectedLinked.list);
+  BOOST_CHECK(enumerated.weights == expectedLinked.weights);
+
+  const boost::filesystem::path path = (
+    boost::filesystem::temp_directory_path()
+    / boost::filesystem::unique_path("%%%%-%%%%.masm-uniques")
+  );
+  writeUniques(path.string());
+
+  // All written entries are already precomputed, so none are added
+  BOOST_CHECK_EQUAL(loadUniques(path.string()), 0);
+  const Uniques loaded = uniques(unlinked, shape);
+  BOOST_CHECK(loaded.list == expectedUnlinked.list);
+
+  // Malformed files are rejected
+  {
+    std::ofstream file(path.string(), std::ios::binary | std::ios::trunc);
+    file << "not a stereopermutations file";
+  }
+  BOOST_CHECK_THROW(loadUniques(path.string()), std::runtime_error);
+
+  const std::string truncated = "MASMSTU1";
+  BOOST_CHECK_THROW(loadUniques(truncated.data(), truncated.size()), std::runtime_error);
+
+  boost::filesystem::remove(path);
+}
@@ -8,6 +8,8 @@
 
 #include "Molassembler/Subgraphs.h"
 #include "Molassembler/Molecule.h"
+#include "Molassembler/Graph.h"
+#include "Molassembler/Graph/PrivateGraph.h"
 #include "Molassembler/IO.h"
 #include "Molassembler/IO/SmilesParser.h"
 
@@ -50,3 +52,145 @@ BOOST_AUTO_TEST_CASE(SubgraphOligopeptide, *boost::unit_test::label("Molassemble
   // Arguments are not symmetric!
   BOOST_CHECK_EQUAL(Subgraphs::complete(tetrapeptide, bondPattern).size(), 0);
 }
+
+BOOST_AUTO_TEST_CASE(SubgraphQueries, *boost::unit_test::label("Molassembler")) {
+  auto parse = [](const std::string& smiles) {
+    return IO::Experimental::parseSmilesSingleMolecule(smiles);
+  };
+
+  const std::vector<Graph> haystacks {
+    parse("CC(C)(C)C").graph(),
+    parse("CCCCCC").graph(),
+    parse("C1CCCCC1").graph(),
+    parse("CC(C)C(N)C(=O)NCC(=O)NC(CO)C(=O)NC(C)C(=O)O").graph()
+  };
+  const std::vector<Subgraphs::Query> queries {
+    Subgraphs::Query {parse("[CH3]").graph()},
+    Subgraphs::Query {parse("C1CCCCC1").graph()},
+    Subgraphs::Query {parse("CC=O").graph(), Subgraphs::VertexStrictness::ElementType, Subgraphs::EdgeStrictness::BondType}
+  };
+
+  // Cycles of the needle cannot map onto acyclic haystacks
+  BOOST_CHECK(!queries.at(1).mayMatch(haystacks.at(1)));
+  BOOST_CHECK(queries.at(1).mayMatch(haystacks.at(2)));
+  BOOST_CHECK_EQUAL(queries.at(0)(haystacks.at(0)).size(), 4);
+
+  for(unsigned q = 0; q < queries.size(); ++q) {
+    const auto perHaystack = Subgraphs::complete(queries.at(q), haystacks);
+    BOOST_REQUIRE_EQUAL(perHaystack.size(), haystacks.size());
+    for(unsigned h = 0; h < haystacks.size(); ++h) {
+      BOOST_CHECK_EQUAL(perHaystack.at(h).size(), queries.at(q)(haystacks.at(h)).size());
+    }
+  }
+
+  for(unsigned h = 0; h < haystacks.size(); ++h) {
+    const auto perQuery = Subgraphs::complete(queries, haystacks.at(h));
+    BOOST_REQUIRE_EQUAL(perQuery.size(), queries.size());
+    for(unsigned q = 0; q < queries.size(); ++q) {
+      BOOST_CHECK_EQUAL(perQuery.at(q).size(), queries.at(q)(haystacks.at(h)).size());
+    }
+  }
+
+  BOOST_CHECK(Subgraphs::complete(queries.at(1).needle(), haystacks.at(1)).empty());
+  BOOST_CHECK(!Subgraphs::complete(queries.at(1).needle(), haystacks.at(2)).empty());
+  BOOST_CHECK(!queries.at(2)(haystacks.at(3)).empty());
+  BOOST_CHECK(queries.at(2)(haystacks.at(0)).empty());
+
+  BOOST_CHECK_THROW(
+    Subgraphs::Query(haystacks.at(0), Subgraphs::VertexStrictness::SubsumeShape),
+    std::logic_error
+  );
+}
+
+BOOST_AUTO_TEST_CASE(SubgraphPathFingerprints, *boost::unit_test::label("Molassembler")) {
+  auto fingerprint = [](const std::string& smiles) {
+    const Molecule molecule = IO::Experimental::parseSmilesSingleMolecule(smiles);
+    return molecule.graph().inner().pathFingerprint();
+  };
+
+  const auto hexane = fingerprint("CCCCCC");
+  const auto ethene = fingerprint("C=C");
+  const auto ethane = fingerprint("CC");
+  const auto ethanol = fingerprint("CCO");
+
+  // Fingerprints of subgraphs are subsets
+  BOOST_CHECK(hexane.contains(ethane, true));
+  BOOST_CHECK(ethanol.contains(ethane, true));
+  BOOST_CHECK(hexane.contains(hexane, true));
+
+  // Missing elements and bond types are caught
+  BOOST_CHECK(!hexane.contains(ethanol, false));
+  BOOST_CHECK(ethane.contains(ethene, false));
+  BOOST_CHECK(!ethane.contains(ethene, true));
+
+  // Queries screen with the fingerprint before matching
+  const Subgraphs::Query ethanolQuery {IO::Experimental::parseSmilesSingleMolecule("CCO").graph()};
+  BOOST_CHECK(!ethanolQuery.mayMatch(IO::Experimental::parseSmilesSingleMolecule("CCCCCC").graph()));
+  BOOST_CHECK(ethanolQuery(IO::Experimental::parseSmilesSingleMolecule("CCCCCC")).empty());
+}
+
+BOOST_AUTO_TEST_CASE(SubgraphQueryModes, *boost::unit_test::label("Molassembler")) {
+  const Molecule cyclohexane = IO::Experimental::parseSmilesSingleMolecule("C1CCCCC1");
+  const Subgraphs::Query query {cyclohexane.graph()};
+
+  // Twelve ring automorphisms, each with two hydrogen arrangements per carbon
+  const auto mappings = query(cyclohexane);
+  BOOST_CHECK_EQUAL(mappings.size(), 12);
+  BOOST_CHECK_EQUAL(query.count(cyclohexane.graph()), mappings.size());
+  BOOST_CHECK_EQUAL(query.count(cyclohexane.graph(), Subgraphs::Uniqueness::All), 12 * 64);
+  BOOST_CHECK_EQUAL(query(cyclohexane.graph(), Subgraphs::Uniqueness::AtomSet).size(), 1);
+  BOOST_CHECK_EQUAL(query.count(cyclohexane.graph(), Subgraphs::Uniqueness::AtomSet), 1);
+  BOOST_CHECK(query.exists(cyclohexane.graph()));
+
+  // Enumeration stops when the callback asks to
+  unsigned calls = 0;
+  const bool completed = query.forEach(
+    cyclohexane.graph(),
+    [&](const std::vector<AtomIndex>& image) {
+      BOOST_CHECK_EQUAL(image.size(), query.needle().N());
+      ++calls;
+      return calls < 3;
+    }
+  );
+  BOOST_CHECK(!completed);
+  BOOST_CHECK_EQUAL(calls, 3);
+
+  const Subgraphs::Query nitrogen {IO::Experimental::parseSmilesSingleMolecule("N").graph()};
+  BOOST_CHECK(!nitrogen.exists(cyclohexane.graph()));
+  BOOST_CHECK_EQUAL(nitrogen.count(cyclohexane.graph()), 0);
+}
+
+BOOST_AUTO_TEST_CASE(SubgraphMaximumConfiguration, *boost::unit_test::label("Molassembler")) {
+  const Molecule cyclohexane = IO::Experimental::parseSmilesSingleMolecule("C1CCCCC1");
+
+  // Twelve ring automorphisms, hydrogen permutations are omitted
+  BOOST_CHECK_EQUAL(Subgraphs::maximum(cyclohexane, cyclohexane).size(), 12);
+
+  Subgraphs::MaximumConfiguration single;
+  single.allMaxima = false;
+  const auto singleMappings = Subgraphs::maximum(cyclohexane, cyclohexane, Subgraphs::VertexStrictness::ElementType, Subgraphs::EdgeStrictness::Topographic, single);
+  BOOST_REQUIRE_EQUAL(singleMappings.size(), 1);
+  BOOST_CHECK_EQUAL(singleMappings.front().size(), cyclohexane.graph().N());
+
+  // Methanol's carbon maps onto ethanol's methylene with two of its hydrogens
+  const Molecule ethanol = IO::Experimental::parseSmilesSingleMolecule("CCO");
+  const Molecule methanol = IO::Experimental::parseSmilesSingleMolecule("CO");
+  const auto mappings = Subgraphs::maximum(methanol, ethanol);
+  BOOST_REQUIRE(!mappings.empty());
+  for(const auto& mapping : mappings) {
+    BOOST_CHECK_EQUAL(mapping.size(), 5);
+  }
+
+  // Limited searches return the best mappings found so far
+  Subgraphs::MaximumConfiguration limited;
+  limited.nodeLimit = 4;
+  for(const auto& mapping : Subgraphs::maximum(methanol, ethanol, Subgraphs::VertexStrictness::ElementType, Subgraphs::EdgeStrictness::Topographic, limited)) {
+    BOOST_CHECK_LE(mapping.size(), 5);
+  }
+
+  Subgraphs::MaximumConfiguration target;
+  target.sizeTarget = 3;
+  const auto targetMappings = Subgraphs::maximum(methanol, ethanol, Subgraphs::VertexStrictness::ElementType, Subgraphs::EdgeStrictness::Topographic, target);
+  BOOST_REQUIRE_EQUAL(targetMappings.size(), 1);
+  BOOST_CHECK_EQUAL(targetMappings.front().size(), 3);
+}
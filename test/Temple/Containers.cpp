@@ -7,10 +7,13 @@
 #include <boost/test/unit_test.hpp>
 
 #include "Molassembler/Temple/BoundedNodeTrie.h"
+#include "Molassembler/Temple/CompactBoundedNodeTrie.h"
 #include "Molassembler/Temple/OrderedPair.h"
 #include "Molassembler/Temple/Poset.h"
 #include "Molassembler/Temple/Random.h"
 #include "Molassembler/Temple/Stringify.h"
+#include "Molassembler/Temple/TinySet.h"
+#include "Molassembler/Temple/VisitedSet.h"
 #include "Molassembler/Temple/constexpr/Jsf.h"
 
 #include <algorithm>
@@ -53,13 +56,82 @@ BOOST_AUTO_TEST_CASE(PosetTests, *boost::unit_test::label("Temple")) {
         std::end(f),
         [](const auto& a, const auto& b) -> bool {
           return std::less<>()(
-            a.values.front(),
-            b.values.front()
+            a.front(),
+            b.front()
           );
         }
       )
     );
   }
+
+  Temple::Poset<unsigned> poset {std::vector<unsigned> {13, 4, 21, 7, 25}};
+  poset.orderUnordered(compareFirstDigit);
+  BOOST_CHECK(static_cast<bool>(poset.compare(4, 13)));
+  BOOST_CHECK(static_cast<bool>(!poset.compare(25, 13)));
+  BOOST_CHECK(boost::indeterminate(poset.compare(4, 7)));
+
+  // Copies order independently
+  Temple::Poset<unsigned> copy = poset;
+  copy.orderUnordered(std::less<>());
+  BOOST_CHECK(static_cast<bool>(copy.compare(4, 7)));
+  BOOST_CHECK(boost::indeterminate(poset.compare(4, 7)));
+
+  const auto extracted = copy.extract();
+  const std::vector<std::vector<unsigned>> expected {{4}, {7}, {13}, {21}, {25}};
+  BOOST_CHECK(extracted == expected);
+}
+
+BOOST_AUTO_TEST_CASE(TinySetInlineCapacity, *boost::unit_test::label("Temple")) {
+  const std::vector<unsigned> values {5, 3, 9, 3, 1, 7, 11, 2};
+
+  // Sets spill from inline storage to the heap transparently
+  Temple::TinySet<unsigned> heapSet;
+  Temple::TinySet<unsigned, 4> inlineSet;
+  Temple::TinyUnorderedSet<unsigned, 4> unorderedSet;
+  for(const unsigned value : values) {
+    if(heapSet.count(value) == 0) {
+      heapSet.insert(value);
+    }
+    if(inlineSet.count(value) == 0) {
+      inlineSet.insert(value);
+    }
+  }
+  unorderedSet.insert(std::begin(values), std::end(values));
+
+  BOOST_CHECK_EQUAL(inlineSet.size(), 7);
+  BOOST_CHECK(std::equal(std::begin(heapSet), std::end(heapSet), std::begin(inlineSet)));
+  BOOST_CHECK_EQUAL(unorderedSet.size(), 7);
+  for(const unsigned value : values) {
+    BOOST_CHECK_EQUAL(unorderedSet.count(value), 1);
+  }
+
+  inlineSet.erase(inlineSet.find(7));
+  BOOST_CHECK_EQUAL(inlineSet.count(7), 0);
+  const Temple::TinySet<unsigned, 4> copy = inlineSet;
+  BOOST_CHECK(copy == inlineSet);
+}
+
+BOOST_AUTO_TEST_CASE(VisitedSetGenerations, *boost::unit_test::label("Temple")) {
+  Temple::VisitedSet<std::size_t> visited {8};
+  BOOST_CHECK(visited.insert(3));
+  BOOST_CHECK(!visited.insert(3));
+  BOOST_CHECK_EQUAL(visited.count(3), 1);
+  BOOST_CHECK_EQUAL(visited.count(4), 0);
+
+  visited.erase(3);
+  BOOST_CHECK_EQUAL(visited.count(3), 0);
+
+  // Clearing forgets all indices, raising the bound keeps them forgotten
+  visited.insert(5);
+  visited.clear();
+  BOOST_CHECK_EQUAL(visited.count(5), 0);
+  visited.insert(7);
+  visited.reset(16);
+  BOOST_CHECK_EQUAL(visited.bound(), 16);
+  for(std::size_t i = 0; i < visited.bound(); ++i) {
+    BOOST_CHECK_EQUAL(visited.count(i), 0);
+  }
+  BOOST_CHECK(visited.insert(15));
 }
 
 template<
@@ -239,3 +311,61 @@ BOOST_AUTO_TEST_CASE(TrieTests, *boost::unit_test::label("Temple")) {
     }
   }
 }
+
+BOOST_AUTO_TEST_CASE(CompactTrieMatchesTrie, *boost::unit_test::label("Temple")) {
+  using TrieType = Temple::BoundedNodeTrie<std::uint8_t>;
+  using CompactTrieType = Temple::CompactBoundedNodeTrie<std::uint8_t>;
+
+  for(const TrieType::ChoiceList& boundaries : std::vector<TrieType::ChoiceList> {{4}, {4, 2, 3}, {3, 3, 3, 3, 3}}) {
+    TrieType trie {boundaries};
+    CompactTrieType compactTrie {boundaries};
+    BOOST_CHECK_EQUAL(trie.capacity(), compactTrie.capacity());
+
+    // Insert some lists, then fill both tries up with generated lists
+    auto chooseFunctor = make_ChooseFunctor(trie, generator);
+    for(unsigned i = 0; i < trie.capacity() / 3; ++i) {
+      const auto list = Temple::map(boundaries, [](const std::uint8_t U) -> std::uint8_t {
+        return Temple::Random::getSingle<unsigned>(0, U - 1, generator.engine);
+      });
+      BOOST_CHECK_EQUAL(trie.insert(list), compactTrie.insert(list));
+      BOOST_CHECK(compactTrie.contains(list));
+      BOOST_CHECK_EQUAL(trie.size(), compactTrie.size());
+    }
+
+    /* Record the choices made for the reference trie and replay them for the
+     * compact trie, checking that the arguments match
+     */
+    using Arguments = std::pair<std::vector<std::uint8_t>, boost::dynamic_bitset<>>;
+    std::vector<std::pair<Arguments, std::uint8_t>> choices;
+    while(trie.size() != trie.capacity()) {
+      choices.clear();
+      const auto list = trie.generateNewEntry(
+        [&](const std::vector<std::uint8_t>& viable, const boost::dynamic_bitset<>& existing) {
+          const std::uint8_t choice = chooseFunctor(viable, existing);
+          choices.emplace_back(Arguments {viable, existing}, choice);
+          return choice;
+        }
+      );
+
+      unsigned i = 0;
+      const auto compactList = compactTrie.generateNewEntry(
+        [&](const std::vector<std::uint8_t>& viable, const boost::dynamic_bitset<>& existing) {
+          BOOST_REQUIRE_LT(i, choices.size());
+          BOOST_CHECK(choices.at(i).first.first == viable);
+          BOOST_CHECK(choices.at(i).first.second == existing);
+          return choices.at(i++).second;
+        }
+      );
+      BOOST_CHECK(list == compactList);
+      BOOST_CHECK(compactTrie.contains(list));
+    }
+
+    BOOST_CHECK_EQUAL(compactTrie.size(), compactTrie.capacity());
+    BOOST_CHECK_THROW(compactTrie.generateNewEntry(chooseFunctor), std::logic_error);
+    BOOST_CHECK_GT(compactTrie.memoryUsage(), 0);
+
+    compactTrie.clear();
+    BOOST_CHECK_EQUAL(compactTrie.size(), 0);
+    BOOST_CHECK(!compactTrie.contains(TrieType::ChoiceList(boundaries.size(), 0)));
+  }
+}
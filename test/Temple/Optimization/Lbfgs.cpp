@@ -199,3 +199,160 @@ BOOST_AUTO_TEST_CASE(LBFGSBoxedMinimization, *boost::unit_test::label("Temple"))
     "Expected y_min = y_box_min (0), but is " << positions[1] << " instead"
   );
 }
+
+BOOST_AUTO_TEST_CASE(LBFGSRuntimeHistory, *boost::unit_test::label("Temple")) {
+  // Ill-conditioned quadratic f(x) = sum_i (i + 1)² (x_i - 1)²
+  const unsigned P = 12;
+  const auto quadratic = [](const Eigen::VectorXd& parameters, double& value, Eigen::Ref<Eigen::VectorXd> gradients) {
+    value = 0;
+    for(unsigned i = 0; i < parameters.size(); ++i) {
+      const double weight = (i + 1) * (i + 1);
+      value += weight * std::pow(parameters[i] - 1, 2);
+      gradients[i] = 2 * weight * (parameters[i] - 1);
+    }
+  };
+
+  Temple::Lbfgs<double, 16> optimizer;
+  GradientBasedChecker<double> gradientChecker;
+  gradientChecker.iterLimit = 1000;
+
+  for(const unsigned historyLength : {1u, 3u, 16u, 24u}) {
+    optimizer.historyLength = historyLength;
+    Eigen::VectorXd positions = Eigen::VectorXd::Zero(P);
+    const auto result = optimizer.minimize(positions, quadratic, gradientChecker);
+    BOOST_CHECK_MESSAGE(
+      result.iterations < gradientChecker.iterLimit,
+      "Expected convergence with history length " << historyLength
+    );
+    BOOST_CHECK_MESSAGE(
+      (positions.array() - 1).abs().maxCoeff() < 1e-3,
+      "Minimum not found with history length " << historyLength
+    );
+  }
+
+  // Retained curvature history carries over to a subsequent minimization
+  optimizer.historyLength = 16;
+  optimizer.retainHistory = true;
+  Eigen::VectorXd positions = Eigen::VectorXd::Constant(P, -1.0);
+  const auto result = optimizer.minimize(positions, quadratic, gradientChecker);
+  BOOST_CHECK(result.iterations < gradientChecker.iterLimit);
+  BOOST_CHECK((positions.array() - 1).abs().maxCoeff() < 1e-3);
+
+  // Differing parameter counts discard the history
+  Eigen::VectorXd fewerPositions = Eigen::VectorXd::Zero(P / 2);
+  optimizer.minimize(fewerPositions, quadratic, gradientChecker);
+  BOOST_CHECK((fewerPositions.array() - 1).abs().maxCoeff() < 1e-3);
+}
+
+BOOST_AUTO_TEST_CASE(LBFGSBatchMatchesSingle, *boost::unit_test::label("Temple")) {
+  // Branin-like function as in LBFGSBraninMinimization
+  const auto branin = [](const Eigen::VectorXd& parameters, double& value, Eigen::Ref<Eigen::VectorXd> gradients) {
+    const double& x = parameters[0];
+    const double& y = parameters[1];
+
+    constexpr double alpha = -1.275 / (M_PI * M_PI);
+    constexpr double beta = 4 / M_PI;
+    constexpr double cosinePrefactor = (10 - 5 / (4 * M_PI));
+
+    const double polynomialBracket = (alpha * x * x + beta * x + y - 6);
+
+    value = (
+      std::pow(polynomialBracket, 2)
+      + cosinePrefactor * std::cos(x)
+      + 10
+    );
+
+    gradients[0] = 2 * polynomialBracket * (2 * alpha * x + beta) - cosinePrefactor * std::sin(x);
+    gradients[1] = 2 * polynomialBracket;
+  };
+
+  const auto batchBranin = [&](const Eigen::MatrixXd& parameters, Eigen::Ref<Eigen::VectorXd> values, Eigen::Ref<Eigen::MatrixXd> gradients) {
+    for(unsigned k = 0; k < parameters.cols(); ++k) {
+      Eigen::Ref<Eigen::VectorXd> gradient = gradients.col(k);
+      branin(parameters.col(k), values(k), gradient);
+    }
+  };
+
+  // Starting points converging in differing numbers of iterations
+  const unsigned K = 6;
+  Eigen::MatrixXd batchPositions(2, K);
+  batchPositions << M_PI - 0.1, 0.5, -2.0, 3.0, 9.0, M_PI,
+                    M_PI - 0.1, 4.0, 12.0, 2.2, 3.0, 2.275;
+
+  using OptimizerType = Temple::Lbfgs<double, 16>;
+  OptimizerType optimizer;
+  std::vector<GradientBasedChecker<double>> checkers(K);
+  Eigen::MatrixXd startingPositions = batchPositions;
+  const auto batchResults = optimizer.minimizeBatch(batchPositions, batchBranin, checkers);
+  BOOST_REQUIRE_EQUAL(batchResults.size(), K);
+
+  for(unsigned k = 0; k < K; ++k) {
+    // Each batch column starts with the initial step length
+    optimizer.stepLength = 1.0;
+    GradientBasedChecker<double> gradientChecker;
+    Eigen::VectorXd positions = startingPositions.col(k);
+    const auto result = optimizer.minimize(positions, branin, gradientChecker);
+
+    BOOST_CHECK(!batchResults[k].lineSearchFailed);
+    BOOST_CHECK_EQUAL(batchResults[k].iterations, result.iterations);
+    BOOST_CHECK_MESSAGE(
+      positions.isApprox(batchPositions.col(k), 1e-12),
+      "Batch minimization of column " << k << " yields "
+      << batchPositions.col(k).transpose() << " instead of " << positions.transpose()
+    );
+  }
+}
+
+BOOST_AUTO_TEST_CASE(LBFGSPreconditioned, *boost::unit_test::label("Temple")) {
+  // Badly scaled quadratic f(x) = sum_i 10^(i / 2) (x_i - 1)²
+  const unsigned P = 12;
+  Eigen::VectorXd weights(P);
+  for(unsigned i = 0; i < P; ++i) {
+    weights[i] = std::pow(10.0, i / 2.0);
+  }
+  const auto quadratic = [&](const Eigen::VectorXd& parameters, double& value, Eigen::Ref<Eigen::VectorXd> gradients) {
+    value = (weights.array() * (parameters.array() - 1).square()).sum();
+    gradients = 2 * weights.cwiseProduct(parameters - Eigen::VectorXd::Ones(P));
+  };
+
+  Temple::Lbfgs<double, 16> optimizer;
+  optimizer.historyLength = 4;
+  GradientBasedChecker<double> gradientChecker;
+  gradientChecker.iterLimit = 1000;
+
+  Eigen::VectorXd plainPositions = Eigen::VectorXd::Zero(P);
+  const auto plain = optimizer.minimize(plainPositions, quadratic, gradientChecker);
+
+  // The inverse Hessian diagonal is exact for this function
+  optimizer.preconditioner = weights.cwiseInverse();
+  Eigen::VectorXd positions = Eigen::VectorXd::Zero(P);
+  optimizer.stepLength = 1.0;
+  const auto preconditioned = optimizer.minimize(positions, quadratic, gradientChecker);
+  BOOST_CHECK((positions.array() - 1).abs().maxCoeff() < 1e-3);
+  BOOST_CHECK_MESSAGE(
+    preconditioned.iterations < plain.iterations,
+    "Preconditioning takes " << preconditioned.iterations
+    << " iterations instead of " << plain.iterations
+  );
+
+  // Batch minimization uses the preconditioner likewise
+  const auto batchQuadratic = [&](const Eigen::MatrixXd& parameters, Eigen::Ref<Eigen::VectorXd> values, Eigen::Ref<Eigen::MatrixXd> gradients) {
+    for(unsigned k = 0; k < parameters.cols(); ++k) {
+      Eigen::Ref<Eigen::VectorXd> gradient = gradients.col(k);
+      quadratic(parameters.col(k), values(k), gradient);
+    }
+  };
+  Eigen::MatrixXd batchPositions = Eigen::MatrixXd::Zero(P, 1);
+  std::vector<GradientBasedChecker<double>> checkers(1, gradientChecker);
+  optimizer.stepLength = 1.0;
+  const auto batchResults = optimizer.minimizeBatch(batchPositions, batchQuadratic, checkers);
+  BOOST_CHECK_EQUAL(batchResults.front().iterations, preconditioned.iterations);
+  BOOST_CHECK(batchPositions.col(0).isApprox(positions, 1e-12));
+
+  // Mismatched sizes are ignored
+  optimizer.preconditioner = Eigen::VectorXd::Ones(P / 2);
+  optimizer.stepLength = 1.0;
+  Eigen::VectorXd ignoredPositions = Eigen::VectorXd::Zero(P);
+  const auto ignored = optimizer.minimize(ignoredPositions, quadratic, gradientChecker);
+  BOOST_CHECK_EQUAL(ignored.iterations, plain.iterations);
+}
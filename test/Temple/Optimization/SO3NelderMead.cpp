@@ -99,4 +99,41 @@ BOOST_AUTO_TEST_CASE(SO3NelderMead, *boost::unit_test::label("Temple")) {
     << result.value << " after " << result.iterations
     << " iterations."
   );
+
+  { /* Multi-start minimization */
+    auto starts = OptimizerType::multistartParameters(8);
+    BOOST_REQUIRE_EQUAL(starts.size(), 8u);
+    BOOST_CHECK(starts.front().matrix.isApprox(OptimizerType::axisParameters().matrix));
+    for(const auto& start : starts) {
+      for(unsigned i = 0; i < 4; ++i) {
+        BOOST_CHECK(OptimizerType::Manifold::contains(start.at(i)));
+      }
+    }
+
+    const auto multistart = OptimizerType::minimizeMultistart(
+      starts,
+      EigenValueDecomposition {},
+      NelderMeadChecker {}
+    );
+    BOOST_CHECK_LT(multistart.start, starts.size());
+    BOOST_CHECK_MESSAGE(
+      std::fabs(multistart.result.value) < 1e-2,
+      "Multi-start SO(3) Nelder-Mead does not minimize EigenValueDecomposition problem, value is "
+      << multistart.result.value
+    );
+
+    // No start is better than the best start
+    auto single = OptimizerType::multistartParameters(8);
+    for(auto& start : single) {
+      NelderMeadChecker check;
+      const auto startResult = OptimizerType::minimize(start, EigenValueDecomposition {}, check);
+      BOOST_CHECK_GE(startResult.value, multistart.result.value);
+    }
+
+    OptimizerType::ParametersList none;
+    BOOST_CHECK_THROW(
+      OptimizerType::minimizeMultistart(none, EigenValueDecomposition {}, NelderMeadChecker {}),
+      std::logic_error
+    );
+  }
 }
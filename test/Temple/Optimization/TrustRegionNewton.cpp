@@ -49,14 +49,11 @@ struct Himmelblau {
     hessian(1, 0) = hessian(0, 1);
   }
 
-  bool shouldContinue(
-    const unsigned iteration,
-    const double /* value */,
-    const Eigen::VectorXd& gradient
-  ) {
+  template<typename StepValues>
+  bool shouldContinue(const unsigned iteration, const StepValues& step) {
     return (
       iteration <= 1000
-      && gradient.squaredNorm() > 1e-3
+      && step.gradients.current.squaredNorm() > 1e-3
     );
   }
 };
@@ -77,4 +74,7 @@ BOOST_AUTO_TEST_CASE(TrustRegionNewton, *boost::unit_test::label("Temple")) {
     << optimizationResult.value << " after " << optimizationResult.iterations
     << " iterations at " << parameters.transpose() << ". Gradient norm is " << optimizationResult.gradient.norm()
   );
+
+  // Final parameters are written back
+  BOOST_CHECK_CLOSE(Himmelblau {}(parameters), optimizationResult.value, 1e-8);
 }
@@ -0,0 +1,41 @@
+/*!@file
+ * @copyright This code is licensed under the 3-clause BSD license.
+ *   Copyright ETH Zurich, Laboratory of Physical Chemistry, Reiher Group.
+ *   See LICENSE.txt for details.
+ */
+
+#include <boost/test/unit_test.hpp>
+
+#include "Molassembler/Conformers.h"
+#include "Molassembler/IO/SmilesParser.h"
+#include "Molassembler/Molecule.h"
+#include "Molassembler/Trace.h"
+
+using namespace Scine::Molassembler;
+
+BOOST_AUTO_TEST_CASE(TraceConformerGenerationStages, *boost::unit_test::label("Molassembler")) {
+  Trace::clear();
+  BOOST_CHECK_EQUAL(Trace::statistics(), "{}");
+
+  const Molecule molecule = IO::Experimental::parseSmilesSingleMolecule("CC(F)(Cl)Br");
+  BOOST_REQUIRE(generateRandomConformation(molecule));
+
+  const std::string statistics = Trace::statistics();
+  const std::string chromeTrace = Trace::chromeTrace();
+  BOOST_CHECK(chromeTrace.find("\"traceEvents\"") != std::string::npos);
+
+  if(Trace::enabled()) {
+    for(const std::string stage : {"DG model", "DG bounds graph", "DG metrization", "DG embedding", "DG refinement"}) {
+      BOOST_CHECK_MESSAGE(
+        statistics.find("\"" + stage + "\"") != std::string::npos,
+        "No statistics for stage " << stage
+      );
+      BOOST_CHECK(chromeTrace.find("\"" + stage + "\"") != std::string::npos);
+    }
+  } else {
+    BOOST_CHECK_EQUAL(statistics, "{}");
+  }
+
+  Trace::clear();
+  BOOST_CHECK_EQUAL(Trace::statistics(), "{}");
+}
@@ -8,6 +8,9 @@
 
 #include "Molassembler/Modeling/ShapeInference.h"
 #include "Molassembler/Shapes/Data.h"
+#include "Molassembler/Graph.h"
+#include "Molassembler/IO/SmilesParser.h"
+#include "Molassembler/Molecule.h"
 
 #include "boost/optional.hpp"
 
@@ -526,3 +529,39 @@ BOOST_AUTO_TEST_CASE(VseprTests, *boost::unit_test::label("Molassembler")) {
     }
   );
 }
+
+BOOST_AUTO_TEST_CASE(InferShapeMatchesVsepr, *boost::unit_test::label("Molassembler")) {
+  // Inference must match VSEPR on the reduced site information
+  const std::vector<std::string> smiles {
+    "CC(=O)[O-]",
+    "C#N",
+    "O=S(=O)(F)F",
+    "F[Xe](F)(F)F",
+    "[NH4+]",
+    "ClF",
+    "C[Fe](C)(C)(C)(C)C",
+    "FI(F)(F)(F)(F)(F)F"
+  };
+
+  for(const auto& smilesString : smiles) {
+    const Molecule molecule = IO::Experimental::parseSmilesSingleMolecule(smilesString);
+    const Graph& graph = molecule.graph();
+    for(AtomIndex i = 0; i < graph.N(); ++i) {
+      if(graph.degree(i) < 2) {
+        continue;
+      }
+
+      const RankingInformation ranking = molecule.rankPriority(i);
+      const auto inferred = inferShape(graph, i, ranking);
+      const auto expected = vsepr(
+        graph.elementType(i),
+        reduceToSiteInformation(graph, i, ranking),
+        formalCharge(graph, i)
+      );
+      BOOST_CHECK_MESSAGE(
+        inferred == expected,
+        "Shape inference differs from VSEPR on atom " << i << " of " << smilesString
+      );
+    }
+  }
+}